@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtTest>
+// KWin
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+// Wayland
+#include <wayland-client.h>
+// system
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+// Count every heap allocation made by the compositor thread. The client runs in its own
+// thread, so its allocations don't skew the numbers.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static thread_local bool s_countAllocations = false;
+static quint64 s_allocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    if (s_countAllocations) {
+        s_allocations++;
+    }
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if (s_countAllocations) {
+        s_allocations++;
+    }
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    if (s_countAllocations) {
+        s_allocations++;
+    }
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+static const QString s_socketName = QStringLiteral("kwin-bench-clientbuffer-0");
+static const int s_commitCount = 100000;
+static const int s_commitsPerRoundtrip = 100;
+static const int s_bufferSize = 64;
+
+/**
+ * Creates a new shm wl_buffer for every commit and destroys it right after the commit,
+ * so every commit resolves a buffer resource that the compositor hasn't seen before.
+ */
+class BufferClient : public QThread
+{
+    Q_OBJECT
+public:
+    bool succeeded = false;
+
+protected:
+    void run() override;
+
+private:
+    static void registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void registryGlobalRemove(void *data, wl_registry *registry, uint32_t name);
+
+    wl_compositor *m_compositor = nullptr;
+    wl_shm *m_shm = nullptr;
+};
+
+void BufferClient::registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    Q_UNUSED(version)
+    auto client = static_cast<BufferClient *>(data);
+    if (qstrcmp(interface, wl_compositor_interface.name) == 0) {
+        client->m_compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+    } else if (qstrcmp(interface, wl_shm_interface.name) == 0) {
+        client->m_shm = static_cast<wl_shm *>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+    }
+}
+
+void BufferClient::registryGlobalRemove(void *data, wl_registry *registry, uint32_t name)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(registry)
+    Q_UNUSED(name)
+}
+
+void BufferClient::run()
+{
+    static const wl_registry_listener registryListener = {
+        registryGlobal,
+        registryGlobalRemove,
+    };
+
+    wl_display *display = wl_display_connect(s_socketName.toUtf8().constData());
+    if (!display) {
+        return;
+    }
+    wl_registry *registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registryListener, this);
+    wl_display_roundtrip(display);
+
+    const int stride = s_bufferSize * 4;
+    const int fd = memfd_create("bench-clientbuffer", MFD_CLOEXEC);
+    if (m_compositor && m_shm && fd != -1 && ftruncate(fd, stride * s_bufferSize) == 0) {
+        wl_shm_pool *pool = wl_shm_create_pool(m_shm, fd, stride * s_bufferSize);
+        wl_surface *surface = wl_compositor_create_surface(m_compositor);
+
+        for (int i = 0; i < s_commitCount; ++i) {
+            wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, s_bufferSize, s_bufferSize, stride, WL_SHM_FORMAT_ARGB8888);
+            wl_surface_attach(surface, buffer, 0, 0);
+            wl_surface_damage_buffer(surface, 0, 0, s_bufferSize, s_bufferSize);
+            wl_surface_commit(surface);
+            wl_buffer_destroy(buffer);
+            if ((i + 1) % s_commitsPerRoundtrip == 0 && wl_display_roundtrip(display) < 0) {
+                break;
+            }
+        }
+        succeeded = wl_display_roundtrip(display) >= 0;
+
+        wl_surface_destroy(surface);
+        wl_shm_pool_destroy(pool);
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+    if (m_shm) {
+        wl_shm_destroy(m_shm);
+    }
+    if (m_compositor) {
+        wl_compositor_destroy(m_compositor);
+    }
+    wl_registry_destroy(registry);
+    wl_display_disconnect(display);
+}
+
+class BenchClientBuffer : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchAttachCommit();
+};
+
+void BenchClientBuffer::benchAttachCommit()
+{
+    using namespace KWaylandServer;
+    Display display;
+    display.addSocketName(s_socketName);
+    display.start();
+    QVERIFY(display.isRunning());
+    display.createShm();
+    CompositorInterface compositor(&display);
+
+    int commitCount = 0;
+    connect(&compositor, &CompositorInterface::surfaceCreated, this, [&commitCount](SurfaceInterface *surface) {
+        connect(surface, &SurfaceInterface::committed, surface, [&commitCount]() {
+            commitCount++;
+        });
+    });
+
+    BufferClient client;
+    QSignalSpy finishedSpy(&client, &QThread::finished);
+
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+#ifdef __GLIBC__
+        s_allocations = 0;
+        s_countAllocations = true;
+#endif
+        timer.start();
+        client.start();
+        QVERIFY(finishedSpy.wait(600000));
+#ifdef __GLIBC__
+        s_countAllocations = false;
+#endif
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    QVERIFY(client.succeeded);
+    QCOMPARE(commitCount, s_commitCount);
+
+    qInfo("%d commits in %.1f ms, %.0f commits per second", commitCount, elapsed / 1e6, commitCount * 1e9 / elapsed);
+#ifdef __GLIBC__
+    qInfo("%.2f allocations per commit", double(s_allocations) / commitCount);
+#else
+    qInfo("allocation counting is only supported with glibc");
+#endif
+}
+
+QTEST_GUILESS_MAIN(BenchClientBuffer)
+#include "bench_clientbuffer.moc"
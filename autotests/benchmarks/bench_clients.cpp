@@ -0,0 +1,333 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/keyboard.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/seat.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/clientconnection.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+// std
+#include <functional>
+#include <memory>
+#include <vector>
+
+static const QString s_socketName = QStringLiteral("kwin-bench-clients-0");
+
+// the members are destroyed bottom up, the proxies before their connection
+struct StressClient {
+    std::unique_ptr<KWayland::Client::ConnectionThread> connection;
+    std::unique_ptr<KWayland::Client::EventQueue> queue;
+    std::unique_ptr<KWayland::Client::Registry> registry;
+    std::unique_ptr<KWayland::Client::Compositor> compositor;
+    std::unique_ptr<KWayland::Client::Seat> seat;
+    std::unique_ptr<KWayland::Client::Output> output;
+    std::unique_ptr<KWayland::Client::Surface> surface;
+    std::unique_ptr<KWayland::Client::Keyboard> keyboard;
+    bool connected = false;
+    bool announced = false;
+    int framesRendered = 0;
+};
+
+static qint64 residentMemory()
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+        }
+    }
+    return 0;
+}
+
+/**
+ * A stress test for a Display with hundreds of clients. Every client binds the compositor,
+ * the seat and an output, creates a surface with a frame callback and a keyboard. The
+ * clients live in the thread of the Display, so 500 of them don't need 500 threads.
+ */
+class BenchClients : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchBindBurst_data();
+    void benchBindBurst();
+    void benchFrameCallbackFanout_data();
+    void benchFrameCallbackFanout();
+    void benchKeyboardFocus_data();
+    void benchKeyboardFocus();
+
+private:
+    bool connectClients(int count);
+    void waitFor(const std::function<bool()> &condition);
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWaylandServer::SeatInterface *m_seatInterface = nullptr;
+    std::vector<std::unique_ptr<StressClient>> m_clients;
+    QVector<KWaylandServer::SurfaceInterface *> m_serverSurfaces;
+    int m_keyboardEnters = 0;
+};
+
+void BenchClients::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_seatInterface = new SeatInterface(m_display, m_display);
+    m_seatInterface->setHasKeyboard(true);
+    auto output = new OutputInterface(m_display, m_display);
+    output->setMode(QSize(1920, 1080));
+    output->done();
+
+    connect(m_compositorInterface, &CompositorInterface::surfaceCreated, this, [this](SurfaceInterface *surface) {
+        m_serverSurfaces.append(surface);
+    });
+}
+
+void BenchClients::cleanup()
+{
+    m_clients.clear();
+    m_serverSurfaces.clear();
+    m_keyboardEnters = 0;
+    delete m_display;
+    m_display = nullptr;
+    m_compositorInterface = nullptr;
+    m_seatInterface = nullptr;
+}
+
+void BenchClients::waitFor(const std::function<bool()> &condition)
+{
+    while (!condition()) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+}
+
+bool BenchClients::connectClients(int count)
+{
+    using namespace KWayland::Client;
+    const int firstClient = m_clients.size();
+    const int surfaceTarget = m_serverSurfaces.count() + count;
+    for (int i = 0; i < count; ++i) {
+        auto client = std::make_unique<StressClient>();
+        client->connection = std::make_unique<ConnectionThread>();
+        client->connection->setSocketName(s_socketName);
+        StressClient *stressClient = client.get();
+        connect(client->connection.get(), &ConnectionThread::connected, this, [stressClient]() {
+            stressClient->connected = true;
+        });
+        client->connection->initConnection();
+        m_clients.push_back(std::move(client));
+    }
+    waitFor([this, firstClient]() {
+        for (int i = firstClient; i < int(m_clients.size()); ++i) {
+            if (!m_clients[i]->connected) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    for (int i = firstClient; i < int(m_clients.size()); ++i) {
+        StressClient *client = m_clients[i].get();
+        client->queue = std::make_unique<EventQueue>();
+        client->queue->setup(client->connection.get());
+        client->registry = std::make_unique<Registry>();
+        client->registry->setEventQueue(client->queue.get());
+        connect(client->registry.get(), &Registry::interfacesAnnounced, this, [client]() {
+            client->announced = true;
+        });
+        client->registry->create(client->connection.get());
+        client->registry->setup();
+        client->connection->flush();
+    }
+    waitFor([this, firstClient]() {
+        for (int i = firstClient; i < int(m_clients.size()); ++i) {
+            if (!m_clients[i]->announced) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    for (int i = firstClient; i < int(m_clients.size()); ++i) {
+        StressClient *client = m_clients[i].get();
+        Registry *registry = client->registry.get();
+        const auto compositor = registry->interface(Registry::Interface::Compositor);
+        client->compositor.reset(registry->createCompositor(compositor.name, compositor.version));
+        const auto seat = registry->interface(Registry::Interface::Seat);
+        client->seat.reset(registry->createSeat(seat.name, seat.version));
+        const auto output = registry->interface(Registry::Interface::Output);
+        client->output.reset(registry->createOutput(output.name, output.version));
+        if (!client->compositor->isValid() || !client->seat->isValid() || !client->output->isValid()) {
+            return false;
+        }
+
+        client->surface.reset(client->compositor->createSurface());
+        connect(client->surface.get(), &Surface::frameRendered, this, [client]() {
+            client->framesRendered++;
+        });
+        client->keyboard.reset(client->seat->createKeyboard());
+        connect(client->keyboard.get(), &Keyboard::entered, this, [this]() {
+            m_keyboardEnters++;
+        });
+        client->surface->commit(Surface::CommitFlag::None);
+        client->connection->flush();
+    }
+    waitFor([this, surfaceTarget]() {
+        return m_serverSurfaces.count() == surfaceTarget;
+    });
+    return m_display->connections().count() >= count;
+}
+
+void BenchClients::benchBindBurst_data()
+{
+    QTest::addColumn<int>("clients");
+
+    QTest::newRow("100 clients") << 100;
+    QTest::newRow("500 clients") << 500;
+}
+
+void BenchClients::benchBindBurst()
+{
+    // measures a session start, when all clients connect and bind their globals at once,
+    // and the memory every connected client costs. The memory includes the client side
+    // objects, they live in the same process
+    QFETCH(int, clients);
+
+    const qint64 memoryBefore = residentMemory();
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        QVERIFY(connectClients(clients));
+    }
+    const qint64 nanoseconds = timer.nsecsElapsed();
+    const qint64 memoryAfter = residentMemory();
+
+    qInfo("%s: %.1f us per client to connect and bind, %.1f KiB per client", QTest::currentDataTag(), nanoseconds / 1e3 / clients, (memoryAfter - memoryBefore) / 1024.0 / clients);
+}
+
+void BenchClients::benchFrameCallbackFanout_data()
+{
+    benchBindBurst_data();
+}
+
+void BenchClients::benchFrameCallbackFanout()
+{
+    // measures one repaint cycle in which every client submits a frame and gets its frame
+    // callback, e.g. hundreds of remote desktops animating at the same time
+    QFETCH(int, clients);
+    QVERIFY(connectClients(clients));
+
+    int commits = 0;
+    for (KWaylandServer::SurfaceInterface *surface : qAsConst(m_serverSurfaces)) {
+        connect(surface, &KWaylandServer::SurfaceInterface::committed, this, [&commits]() {
+            commits++;
+        });
+    }
+
+    quint32 msec = 0;
+    int frames = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int commitTarget = commits + clients;
+        for (const auto &client : m_clients) {
+            client->surface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+            client->connection->flush();
+        }
+        waitFor([&commits, commitTarget]() {
+            return commits == commitTarget;
+        });
+
+        frames++;
+        msec += 16;
+        for (KWaylandServer::SurfaceInterface *surface : qAsConst(m_serverSurfaces)) {
+            surface->frameRendered(msec);
+        }
+        m_display->flush();
+        waitFor([this, frames]() {
+            for (const auto &client : m_clients) {
+                if (client->framesRendered < frames) {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+        totalNanoseconds += timer.nsecsElapsed();
+    }
+
+    if (frames > 0) {
+        qInfo("%s: %.1f us per repaint cycle", QTest::currentDataTag(), totalNanoseconds / 1e3 / frames);
+    }
+}
+
+void BenchClients::benchKeyboardFocus_data()
+{
+    benchBindBurst_data();
+}
+
+void BenchClients::benchKeyboardFocus()
+{
+    // measures moving the keyboard focus through all clients, each change looks up the
+    // connection and the resources of the newly focused client. Every focus change is
+    // delivered before the next one, the surfaces are not in the order of the clients
+    // as the requests of different clients are dispatched in any order
+    QFETCH(int, clients);
+    QVERIFY(connectClients(clients));
+
+    int changes = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        for (KWaylandServer::SurfaceInterface *surface : qAsConst(m_serverSurfaces)) {
+            const int target = m_keyboardEnters + 1;
+            m_seatInterface->setFocusedKeyboardSurface(surface);
+            m_display->flush();
+            waitFor([this, target]() {
+                return m_keyboardEnters == target;
+            });
+        }
+
+        totalNanoseconds += timer.nsecsElapsed();
+        changes += clients;
+    }
+
+    if (changes > 0) {
+        qInfo("%s: %.1f us per focus change", QTest::currentDataTag(), totalNanoseconds / 1e3 / changes);
+    }
+    m_seatInterface->setFocusedKeyboardSurface(nullptr);
+}
+
+QTEST_GUILESS_MAIN(BenchClients)
+#include "bench_clients.moc"
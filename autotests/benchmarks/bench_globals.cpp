@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/pointerconstraints_v1_interface.h"
+#include "../../src/server/pointergestures_v1_interface.h"
+#include "../../src/server/relativepointer_v1_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/subcompositor_interface.h"
+#include "../../src/server/tablet_v2_interface.h"
+#include "../../src/server/textinput_v2_interface.h"
+#include "../../src/server/textinput_v3_interface.h"
+#include "../../src/server/viewporter_interface.h"
+#include "../../src/server/xdgshell_interface.h"
+
+using namespace KWaylandServer;
+
+class BenchGlobals : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchStartup();
+};
+
+void BenchGlobals::benchStartup()
+{
+    // the globals a compositor creates at startup, most of them are never bound by a client
+    QBENCHMARK {
+        Display display;
+        display.createShm();
+        new CompositorInterface(&display, &display);
+        new SubCompositorInterface(&display, &display);
+        new SeatInterface(&display, &display);
+        new XdgShellInterface(&display, &display);
+        new ViewporterInterface(&display, &display);
+        new TabletManagerV2Interface(&display, &display);
+        new TextInputManagerV2Interface(&display, &display);
+        new TextInputManagerV3Interface(&display, &display);
+        new PointerGesturesV1Interface(&display, &display);
+        new RelativePointerManagerV1Interface(&display, &display);
+        new PointerConstraintsV1Interface(&display, &display);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchGlobals)
+#include "bench_globals.moc"
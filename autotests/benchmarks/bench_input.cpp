@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/keyboard.h"
+#include "../../src/client/pointer.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/seat.h"
+#include "../../src/client/surface.h"
+#include "../../src/client/touch.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/seat_interface.h"
+// system
+#include <linux/input.h>
+// std
+#include <memory>
+
+static const QString s_socketName = QStringLiteral("kwin-bench-input-0");
+static const int s_eventsPerIteration = 100;
+
+class BenchInput : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchDelivery_data();
+    void benchDelivery();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWaylandServer::SeatInterface *m_seatInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Seat *m_seat = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchInput::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_seatInterface = new SeatInterface(m_display, m_display);
+    m_seatInterface->setHasPointer(true);
+    m_seatInterface->setHasKeyboard(true);
+    m_seatInterface->setHasTouch(true);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = registry.interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry.createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto seat = registry.interface(KWayland::Client::Registry::Interface::Seat);
+    m_seat = registry.createSeat(seat.name, seat.version, this);
+    QVERIFY(m_seat->isValid());
+    QSignalSpy hasTouchSpy(m_seat, &KWayland::Client::Seat::hasTouchChanged);
+    QVERIFY(hasTouchSpy.wait());
+}
+
+void BenchInput::cleanup()
+{
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_seat;
+    m_seat = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_compositorInterface = nullptr;
+    m_seatInterface = nullptr;
+}
+
+void BenchInput::benchDelivery_data()
+{
+    QTest::addColumn<QString>("device");
+
+    QTest::newRow("pointer motion") << QStringLiteral("motion");
+    QTest::newRow("pointer button") << QStringLiteral("button");
+    QTest::newRow("pointer axis") << QStringLiteral("axis");
+    QTest::newRow("keyboard key") << QStringLiteral("key");
+    QTest::newRow("touch motion") << QStringLiteral("touch");
+}
+
+void BenchInput::benchDelivery()
+{
+    // measures the latency of a single event, from the compositor notifying the seat until
+    // the client dispatched it, so every event is delivered before the next one is sent
+    QFETCH(QString, device);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    std::unique_ptr<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    std::unique_ptr<KWayland::Client::Pointer> pointer(m_seat->createPointer());
+    std::unique_ptr<KWayland::Client::Keyboard> keyboard(m_seat->createKeyboard());
+    std::unique_ptr<KWayland::Client::Touch> touch(m_seat->createTouch());
+    QVERIFY(pointer->isValid());
+    QVERIFY(keyboard->isValid());
+    QVERIFY(touch->isValid());
+
+    int received = 0;
+    auto count = [&received]() {
+        received++;
+    };
+    connect(pointer.get(), &KWayland::Client::Pointer::motion, this, count);
+    connect(pointer.get(), &KWayland::Client::Pointer::buttonStateChanged, this, count);
+    connect(pointer.get(), &KWayland::Client::Pointer::axisChanged, this, count);
+    connect(keyboard.get(), &KWayland::Client::Keyboard::keyChanged, this, count);
+    connect(touch.get(), &KWayland::Client::Touch::frameEnded, this, count);
+
+    QSignalSpy pointerEnteredSpy(pointer.get(), &KWayland::Client::Pointer::entered);
+    QSignalSpy keyboardEnteredSpy(keyboard.get(), &KWayland::Client::Keyboard::entered);
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface);
+    m_seatInterface->setFocusedTouchSurface(serverSurface);
+    QVERIFY(pointerEnteredSpy.wait());
+    if (keyboardEnteredSpy.isEmpty()) {
+        QVERIFY(keyboardEnteredSpy.wait());
+    }
+
+    if (device == QLatin1String("touch")) {
+        m_seatInterface->notifyTouchDown(0, QPointF(0, 0));
+        m_seatInterface->notifyTouchFrame();
+    }
+    m_display->flush();
+
+    quint32 timestamp = 0;
+    auto sendEvent = [&](int i) {
+        m_seatInterface->setTimestamp(++timestamp);
+        if (device == QLatin1String("motion")) {
+            m_seatInterface->notifyPointerMotion(QPointF(i % 100, i % 50));
+            m_seatInterface->notifyPointerFrame();
+        } else if (device == QLatin1String("button")) {
+            m_seatInterface->notifyPointerButton(Qt::LeftButton, i % 2 ? KWaylandServer::PointerButtonState::Released : KWaylandServer::PointerButtonState::Pressed);
+            m_seatInterface->notifyPointerFrame();
+        } else if (device == QLatin1String("axis")) {
+            m_seatInterface->notifyPointerAxis(Qt::Vertical, 15, 1, KWaylandServer::PointerAxisSource::Wheel);
+            m_seatInterface->notifyPointerFrame();
+        } else if (device == QLatin1String("key")) {
+            m_seatInterface->notifyKeyboardKey(KEY_A, i % 2 ? KWaylandServer::KeyboardKeyState::Released : KWaylandServer::KeyboardKeyState::Pressed);
+        } else {
+            m_seatInterface->notifyTouchMotion(0, QPointF(i % 100, i % 50));
+            m_seatInterface->notifyTouchFrame();
+        }
+        m_display->flush();
+    };
+
+    // let the events of the focus changes settle
+    QTest::qWait(10);
+    received = 0;
+
+    qint64 totalEvents = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0; i < s_eventsPerIteration; ++i) {
+            const int target = received + 1;
+            sendEvent(i);
+            while (received < target) {
+                QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+            }
+        }
+
+        totalNanoseconds += timer.nsecsElapsed();
+        totalEvents += s_eventsPerIteration;
+    }
+
+    if (totalEvents > 0) {
+        qInfo("%s: %.1f us per event", QTest::currentDataTag(), totalNanoseconds / 1e3 / totalEvents);
+    }
+
+    if (device == QLatin1String("touch")) {
+        m_seatInterface->notifyTouchUp(0);
+        m_seatInterface->notifyTouchFrame();
+    }
+    m_seatInterface->setFocusedPointerSurface(nullptr);
+    m_seatInterface->setFocusedKeyboardSurface(nullptr);
+    m_seatInterface->setFocusedTouchSurface(nullptr);
+}
+
+QTEST_GUILESS_MAIN(BenchInput)
+#include "bench_input.moc"
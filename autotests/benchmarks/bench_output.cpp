@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+// std
+#include <memory>
+#include <vector>
+
+static const QString s_socketName = QStringLiteral("kwin-bench-output-0");
+
+class BenchOutput : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchHotplug_data();
+    void benchHotplug();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchOutput::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new KWayland::Client::Registry(this);
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &KWayland::Client::Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection);
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+}
+
+void BenchOutput::cleanup()
+{
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+}
+
+void BenchOutput::benchHotplug_data()
+{
+    QTest::addColumn<int>("connectedOutputs");
+
+    QTest::newRow("1 output") << 1;
+    QTest::newRow("4 outputs") << 4;
+}
+
+void BenchOutput::benchHotplug()
+{
+    // measures plugging a monitor in and out, from the compositor creating the output
+    // until the client bound it and received its initial state, and back until the
+    // client saw the global go away
+    QFETCH(int, connectedOutputs);
+
+    std::vector<std::unique_ptr<KWaylandServer::OutputInterface>> outputs;
+    for (int i = 0; i < connectedOutputs; ++i) {
+        outputs.emplace_back(new KWaylandServer::OutputInterface(m_display));
+        outputs.back()->setMode(QSize(1920, 1080));
+        outputs.back()->setGlobalPosition(QPoint(1920 * i, 0));
+        outputs.back()->done();
+    }
+
+    std::unique_ptr<KWayland::Client::Output> output;
+    int outputsChanged = 0;
+    int outputsRemoved = 0;
+    connect(m_registry, &KWayland::Client::Registry::outputAnnounced, this, [this, &output, &outputsChanged](quint32 name, quint32 version) {
+        output.reset(m_registry->createOutput(name, version));
+        connect(output.get(), &KWayland::Client::Output::changed, this, [&outputsChanged]() {
+            outputsChanged++;
+        });
+    });
+    connect(m_registry, &KWayland::Client::Registry::outputRemoved, this, [&output, &outputsRemoved]() {
+        output.reset();
+        outputsRemoved++;
+    });
+    m_display->flush();
+    while (outputsChanged < connectedOutputs) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    output.reset();
+
+    qint64 totalHotplugs = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int changedTarget = outputsChanged + 1;
+        const int removedTarget = outputsRemoved + 1;
+
+        std::unique_ptr<KWaylandServer::OutputInterface> hotplugged(new KWaylandServer::OutputInterface(m_display));
+        hotplugged->setMode(QSize(2560, 1440));
+        hotplugged->setGlobalPosition(QPoint(1920 * connectedOutputs, 0));
+        hotplugged->done();
+        m_display->flush();
+        while (outputsChanged < changedTarget) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+
+        hotplugged->remove();
+        m_display->flush();
+        while (outputsRemoved < removedTarget) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+
+        totalNanoseconds += timer.nsecsElapsed();
+        totalHotplugs++;
+    }
+
+    if (totalHotplugs > 0) {
+        qInfo("%s: %.1f us per hotplug", QTest::currentDataTag(), totalNanoseconds / 1e3 / totalHotplugs);
+    }
+
+    disconnect(m_registry, nullptr, this, nullptr);
+}
+
+QTEST_GUILESS_MAIN(BenchOutput)
+#include "bench_output.moc"
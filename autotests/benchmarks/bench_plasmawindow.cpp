@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QUuid>
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/plasmawindowmanagement.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/display.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+// std
+#include <memory>
+#include <vector>
+
+static const QString s_socketName = QStringLiteral("kwin-bench-plasma-window-0");
+
+class BenchPlasmaWindow : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchTitleUpdates_data();
+    void benchTitleUpdates();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::PlasmaWindowManagementInterface *m_windowManagementInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::PlasmaWindowManagement *m_windowManagement = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchPlasmaWindow::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_windowManagementInterface = new PlasmaWindowManagementInterface(m_display, m_display);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto windowManagement = registry.interface(KWayland::Client::Registry::Interface::PlasmaWindowManagement);
+    m_windowManagement = registry.createPlasmaWindowManagement(windowManagement.name, windowManagement.version, this);
+    QVERIFY(m_windowManagement->isValid());
+}
+
+void BenchPlasmaWindow::cleanup()
+{
+    delete m_windowManagement;
+    m_windowManagement = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_windowManagementInterface = nullptr;
+}
+
+void BenchPlasmaWindow::benchTitleUpdates_data()
+{
+    QTest::addColumn<int>("windows");
+
+    QTest::newRow("10 windows") << 10;
+    QTest::newRow("100 windows") << 100;
+    QTest::newRow("500 windows") << 500;
+}
+
+void BenchPlasmaWindow::benchTitleUpdates()
+{
+    // measures a task manager following the titles of all windows, e.g. terminals
+    // printing the current directory, from the compositor update until the client saw it
+    QFETCH(int, windows);
+
+    QSignalSpy windowCreatedSpy(m_windowManagement, &KWayland::Client::PlasmaWindowManagement::windowCreated);
+    std::vector<std::unique_ptr<KWaylandServer::PlasmaWindowInterface>> serverWindows;
+    for (int i = 0; i < windows; ++i) {
+        serverWindows.emplace_back(m_windowManagementInterface->createWindow(nullptr, QUuid::createUuid()));
+    }
+    m_display->flush();
+    while (windowCreatedSpy.count() < windows) {
+        QVERIFY(windowCreatedSpy.wait());
+    }
+
+    int titleChanges = 0;
+    const QList<KWayland::Client::PlasmaWindow *> clientWindows = m_windowManagement->windows();
+    for (KWayland::Client::PlasmaWindow *window : clientWindows) {
+        connect(window, &KWayland::Client::PlasmaWindow::titleChanged, this, [&titleChanges]() {
+            titleChanges++;
+        });
+    }
+
+    int round = 0;
+    qint64 totalUpdates = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int target = titleChanges + windows;
+        const QString title = QStringLiteral("~/src/kwayland-server %1").arg(round++);
+        for (const auto &window : serverWindows) {
+            window->setTitle(title);
+        }
+        m_display->flush();
+
+        while (titleChanges < target) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+
+        totalNanoseconds += timer.nsecsElapsed();
+        totalUpdates += windows;
+    }
+
+    if (totalNanoseconds > 0) {
+        qInfo("%s: %.0f updates per second", QTest::currentDataTag(), totalUpdates * 1e9 / totalNanoseconds);
+    }
+
+    QSignalSpy unmappedSpy(clientWindows.last(), &KWayland::Client::PlasmaWindow::unmapped);
+    for (const auto &window : serverWindows) {
+        window->unmap();
+    }
+    m_display->flush();
+    QVERIFY(unmappedSpy.wait());
+}
+
+QTEST_GUILESS_MAIN(BenchPlasmaWindow)
+#include "bench_plasmawindow.moc"
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/seat_interface.h"
+
+static const QString s_socketName = QStringLiteral("kwin-bench-registry-0");
+
+class BenchRegistry : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchAnnounce_data();
+    void benchAnnounce();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchRegistry::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    new CompositorInterface(m_display, m_display);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+}
+
+void BenchRegistry::cleanup()
+{
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+}
+
+void BenchRegistry::benchAnnounce_data()
+{
+    QTest::addColumn<int>("outputs");
+    QTest::addColumn<int>("seats");
+
+    QTest::newRow("1 output") << 1 << 1;
+    QTest::newRow("8 outputs, 4 seats") << 8 << 4;
+    QTest::newRow("32 outputs, 16 seats") << 32 << 16;
+}
+
+void BenchRegistry::benchAnnounce()
+{
+    // measures the time a client needs to receive and resolve all announced globals
+    QFETCH(int, outputs);
+    QFETCH(int, seats);
+    for (int i = 0; i < outputs; ++i) {
+        new KWaylandServer::OutputInterface(m_display, m_display);
+    }
+    for (int i = 0; i < seats; ++i) {
+        auto seat = new KWaylandServer::SeatInterface(m_display, m_display);
+        seat->setName(QStringLiteral("seat%1").arg(i));
+    }
+
+    QBENCHMARK {
+        KWayland::Client::Registry registry;
+        registry.setEventQueue(m_queue);
+        QSignalSpy allAnnounced(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+        registry.create(m_connection);
+        registry.setup();
+        QVERIFY(allAnnounced.wait());
+        QCOMPARE(registry.interfaces(KWayland::Client::Registry::Interface::Output).count(), outputs);
+        QCOMPARE(registry.interfaces(KWayland::Client::Registry::Interface::Seat).count(), seats);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchRegistry)
+#include "bench_registry.moc"
@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QImage>
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "inprocessfixture.h"
+
+static const int s_commitsPerIteration = 100;
+
+class BenchRoundtrip : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchSync();
+    void benchCommit_data();
+    void benchCommit();
+
+private:
+    InProcessFixture *m_fixture = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+};
+
+void BenchRoundtrip::init()
+{
+    m_fixture = new InProcessFixture(this);
+    QVERIFY(m_fixture->setUp());
+    m_fixture->display()->createShm();
+    new KWaylandServer::CompositorInterface(m_fixture->display(), m_fixture->display());
+    QVERIFY(m_fixture->announce());
+
+    KWayland::Client::Registry *registry = m_fixture->registry();
+    const auto compositor = registry->interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto shm = registry->interface(KWayland::Client::Registry::Interface::Shm);
+    m_shm = registry->createShmPool(shm.name, shm.version, this);
+    QVERIFY(m_shm->isValid());
+    QVERIFY(m_fixture->roundtrip());
+}
+
+void BenchRoundtrip::cleanup()
+{
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_fixture;
+    m_fixture = nullptr;
+}
+
+void BenchRoundtrip::benchSync()
+{
+    // the bare cost of a wl_display.sync through the client and the server
+    QBENCHMARK {
+        QVERIFY(m_fixture->roundtrip());
+    }
+}
+
+void BenchRoundtrip::benchCommit_data()
+{
+    QTest::addColumn<bool>("attachBuffer");
+
+    QTest::newRow("empty") << false;
+    QTest::newRow("damage+attach") << true;
+}
+
+void BenchRoundtrip::benchCommit()
+{
+    // unlike benchSurfaceCommit nothing waits for the event loop, every iteration does the same work
+    QFETCH(bool, attachBuffer);
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QImage image(QSize(256, 256), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    const KWayland::Client::Buffer::Ptr buffer = m_shm->createBuffer(image);
+    QVERIFY(m_fixture->roundtrip());
+
+    QBENCHMARK {
+        for (int i = 0; i < s_commitsPerIteration; ++i) {
+            if (attachBuffer) {
+                surface->attachBuffer(buffer);
+                surface->damage(QRect(i % 128, i % 128, 64, 64));
+            }
+            surface->commit(KWayland::Client::Surface::CommitFlag::None);
+        }
+        QVERIFY(m_fixture->roundtrip());
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchRoundtrip)
+#include "bench_roundtrip.moc"
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/datadevice.h"
+#include "../../src/client/datadevicemanager.h"
+#include "../../src/client/dataoffer.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/seat.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/abstract_data_source.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/datadevicemanager_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/seat_interface.h"
+// system
+#include <unistd.h>
+// std
+#include <memory>
+#include <vector>
+
+static const QString s_socketName = QStringLiteral("kwin-bench-selection-0");
+
+// a compositor side source, e.g. what Xwayland offers
+class BenchDataSource : public KWaylandServer::AbstractDataSource
+{
+    Q_OBJECT
+public:
+    explicit BenchDataSource(int mimeTypeCount, QObject *parent = nullptr)
+        : AbstractDataSource(parent)
+    {
+        for (int i = 0; i < mimeTypeCount; ++i) {
+            m_mimeTypes << QStringLiteral("application/x-bench-selection-type-%1").arg(i);
+        }
+    }
+    ~BenchDataSource() override
+    {
+        Q_EMIT aboutToBeDestroyed();
+    }
+
+    void requestData(const QString &mimeType, qint32 fd) override
+    {
+        Q_UNUSED(mimeType)
+        close(fd);
+    }
+    void cancel() override
+    {
+    }
+    QStringList mimeTypes() const override
+    {
+        return m_mimeTypes;
+    }
+
+private:
+    QStringList m_mimeTypes;
+};
+
+class BenchSelection : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchSetSelection_data();
+    void benchSetSelection();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWaylandServer::SeatInterface *m_seatInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Seat *m_seat = nullptr;
+    KWayland::Client::DataDeviceManager *m_dataDeviceManager = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchSelection::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_seatInterface = new SeatInterface(m_display, m_display);
+    m_seatInterface->setHasKeyboard(true);
+    new DataDeviceManagerInterface(m_display, m_display);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    const auto compositor = registry.interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry.createCompositor(compositor.name, compositor.version, this);
+    const auto seat = registry.interface(KWayland::Client::Registry::Interface::Seat);
+    m_seat = registry.createSeat(seat.name, seat.version, this);
+    const auto dataDeviceManager = registry.interface(KWayland::Client::Registry::Interface::DataDeviceManager);
+    m_dataDeviceManager = registry.createDataDeviceManager(dataDeviceManager.name, dataDeviceManager.version, this);
+    QVERIFY(m_compositor->isValid());
+    QVERIFY(m_seat->isValid());
+    QVERIFY(m_dataDeviceManager->isValid());
+}
+
+void BenchSelection::cleanup()
+{
+    delete m_dataDeviceManager;
+    m_dataDeviceManager = nullptr;
+    delete m_seat;
+    m_seat = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+}
+
+void BenchSelection::benchSetSelection_data()
+{
+    QTest::addColumn<int>("mimeTypes");
+    QTest::addColumn<int>("listeners");
+
+    QTest::newRow("1 type, 1 listener") << 1 << 1;
+    QTest::newRow("50 types, 1 listener") << 50 << 1;
+    QTest::newRow("50 types, 20 listeners") << 50 << 20;
+}
+
+void BenchSelection::benchSetSelection()
+{
+    // measures the compositor side of a selection change, i.e. creating the offers and
+    // sending the mime types to every data device of the focused client
+    QFETCH(int, mimeTypes);
+    QFETCH(int, listeners);
+
+    std::vector<std::unique_ptr<KWayland::Client::DataDevice>> dataDevices;
+    for (int i = 0; i < listeners; ++i) {
+        dataDevices.emplace_back(m_dataDeviceManager->getDataDevice(m_seat));
+        QVERIFY(dataDevices.back()->isValid());
+    }
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>());
+
+    BenchDataSource first(mimeTypes);
+    BenchDataSource second(mimeTypes);
+    QBENCHMARK {
+        m_seatInterface->setSelection(&first);
+        m_seatInterface->setSelection(&second);
+        m_display->flush();
+    }
+
+    // every listener sees the selection
+    QSignalSpy selectionOfferedSpy(dataDevices.back().get(), &KWayland::Client::DataDevice::selectionOffered);
+    m_seatInterface->setSelection(&first);
+    m_display->flush();
+    QVERIFY(selectionOfferedSpy.wait());
+    QVERIFY(dataDevices.back()->offeredSelection());
+    m_seatInterface->setSelection(nullptr);
+}
+
+QTEST_GUILESS_MAIN(BenchSelection)
+#include "bench_selection.moc"
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/server/display.h"
+
+static const QString s_socketName = QStringLiteral("kwin-bench-shm-pool-0");
+static const int s_resizesPerIteration = 100;
+
+class BenchShmPool : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchResizeChurn();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::ShmPool *m_shmPool = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchShmPool::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    KWayland::Client::Registry registry;
+    QSignalSpy shmSpy(&registry, &KWayland::Client::Registry::shmAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(shmSpy.wait());
+    m_shmPool = registry.createShmPool(shmSpy.first().first().value<quint32>(), shmSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shmPool->isValid());
+}
+
+void BenchShmPool::cleanup()
+{
+    delete m_shmPool;
+    m_shmPool = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+}
+
+void BenchShmPool::benchResizeChurn()
+{
+    // Simulates an interactive resize: the window grows and shrinks and every size is
+    // used by a double buffered client, the server releases the previous buffer.
+    QSharedPointer<KWayland::Client::Buffer> previous;
+    int step = 0;
+    int32_t maximumPoolSize = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < s_resizesPerIteration; ++i, ++step) {
+            const int extent = 200 + qAbs((step % 400) - 200);
+            const QSize size(extent * 2, extent);
+            auto buffer = m_shmPool->getBuffer(size, size.width() * 4).toStrongRef();
+            QVERIFY(buffer);
+            if (previous) {
+                previous->setReleased(true);
+            }
+            previous = buffer;
+            maximumPoolSize = qMax(maximumPoolSize, m_shmPool->poolSize());
+        }
+        // let the server process the buffer requests, so the connection doesn't clog up
+        m_connection->flush();
+        QCoreApplication::processEvents();
+    }
+
+    // the biggest buffers are 800x400, two of them are in flight at a time
+    qInfo("pool size after %d resizes: %d bytes, largest: %d bytes, two largest buffers: %d bytes",
+          step,
+          m_shmPool->poolSize(),
+          maximumPoolSize,
+          2 * 800 * 400 * 4);
+}
+
+QTEST_GUILESS_MAIN(BenchShmPool)
+#include "bench_shm_pool.moc"
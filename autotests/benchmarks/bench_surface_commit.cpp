@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QImage>
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/region.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/client/subcompositor.h"
+#include "../../src/client/subsurface.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/subcompositor_interface.h"
+#include "../../src/server/surface_interface.h"
+// Wayland
+#include <wayland-client-protocol.h>
+// std
+#include <memory>
+#include <vector>
+
+static const QString s_socketName = QStringLiteral("kwin-bench-surface-commit-0");
+static const int s_commitsPerIteration = 1000;
+
+class BenchSurfaceCommit : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchCommit_data();
+    void benchCommit();
+
+    void benchSubSurfaceCommit_data();
+    void benchSubSurfaceCommit();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::SubCompositor *m_subCompositor = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void BenchSurfaceCommit::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    new SubCompositorInterface(m_display, m_display);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy allAnnounced(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+
+    const auto compositor = registry.interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry.createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto subCompositor = registry.interface(KWayland::Client::Registry::Interface::SubCompositor);
+    m_subCompositor = registry.createSubCompositor(subCompositor.name, subCompositor.version, this);
+    QVERIFY(m_subCompositor->isValid());
+    const auto shm = registry.interface(KWayland::Client::Registry::Interface::Shm);
+    m_shm = registry.createShmPool(shm.name, shm.version, this);
+    QVERIFY(m_shm->isValid());
+}
+
+void BenchSurfaceCommit::cleanup()
+{
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_subCompositor;
+    m_subCompositor = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_compositorInterface = nullptr;
+}
+
+void BenchSurfaceCommit::benchCommit_data()
+{
+    QTest::addColumn<bool>("attachBuffer");
+    QTest::addColumn<bool>("setRegions");
+
+    QTest::newRow("empty") << false << false;
+    QTest::newRow("damage+attach") << true << false;
+    QTest::newRow("damage+attach+regions") << true << true;
+}
+
+void BenchSurfaceCommit::benchCommit()
+{
+    QFETCH(bool, attachBuffer);
+    QFETCH(bool, setRegions);
+
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    auto serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    int commitCount = 0;
+    connect(serverSurface, &KWaylandServer::SurfaceInterface::committed, this, [&commitCount]() {
+        commitCount++;
+    });
+
+    QImage image(QSize(256, 256), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    const KWayland::Client::Buffer::Ptr buffer = m_shm->createBuffer(image);
+    const std::unique_ptr<KWayland::Client::Region> region = m_compositor->createRegion(QRegion(0, 0, 128, 128));
+
+    qint64 totalCommits = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int target = commitCount + s_commitsPerIteration;
+        for (int i = 0; i < s_commitsPerIteration; ++i) {
+            if (attachBuffer) {
+                surface->attachBuffer(buffer);
+                surface->damage(QRect(i % 128, i % 128, 64, 64));
+            }
+            if (setRegions) {
+                surface->setOpaqueRegion(region.get());
+                surface->setInputRegion(region.get());
+            }
+            surface->commit(KWayland::Client::Surface::CommitFlag::None);
+        }
+        m_connection->flush();
+
+        while (commitCount < target) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+
+        totalNanoseconds += timer.nsecsElapsed();
+        totalCommits += s_commitsPerIteration;
+    }
+
+    if (totalNanoseconds > 0) {
+        qInfo("%s: %.0f commits per second", QTest::currentDataTag(), totalCommits * 1e9 / totalNanoseconds);
+    }
+}
+
+void BenchSurfaceCommit::benchSubSurfaceCommit_data()
+{
+    QTest::addColumn<int>("subSurfaces");
+    QTest::addColumn<bool>("synchronized");
+
+    QTest::newRow("4 synchronized") << 4 << true;
+    QTest::newRow("4 desynchronized") << 4 << false;
+    QTest::newRow("16 synchronized") << 16 << true;
+}
+
+void BenchSurfaceCommit::benchSubSurfaceCommit()
+{
+    // a window with decorations or video overlays, every frame updates all sub-surfaces
+    // and then commits the parent, which applies the cached state of synchronized children
+    QFETCH(int, subSurfaces);
+    QFETCH(bool, synchronized);
+
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> parent(m_compositor->createSurface());
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> children;
+    std::vector<std::unique_ptr<KWayland::Client::SubSurface>> childSubSurfaces;
+    for (int i = 0; i < subSurfaces; ++i) {
+        children.emplace_back(m_compositor->createSurface());
+        childSubSurfaces.emplace_back(m_subCompositor->createSubSurface(children.back().get(), parent.data()));
+        childSubSurfaces.back()->setMode(synchronized ? KWayland::Client::SubSurface::Mode::Synchronized : KWayland::Client::SubSurface::Mode::Desynchronized);
+        childSubSurfaces.back()->setPosition(QPoint(i * 8, i * 8));
+    }
+    while (serverSurfaceCreated.count() < subSurfaces + 1) {
+        QVERIFY(serverSurfaceCreated.wait());
+    }
+    auto serverParent = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverParent);
+
+    int commitCount = 0;
+    connect(serverParent, &KWaylandServer::SurfaceInterface::committed, this, [&commitCount]() {
+        commitCount++;
+    });
+
+    QImage image(QSize(64, 64), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    const KWayland::Client::Buffer::Ptr buffer = m_shm->createBuffer(image);
+
+    qint64 totalFrames = 0;
+    qint64 totalNanoseconds = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int frames = s_commitsPerIteration / (subSurfaces + 1);
+        const int target = commitCount + frames;
+        for (int i = 0; i < frames; ++i) {
+            for (const auto &child : children) {
+                child->attachBuffer(buffer);
+                child->damage(QRect(0, 0, 64, 64));
+                child->commit(KWayland::Client::Surface::CommitFlag::None);
+            }
+            parent->attachBuffer(buffer);
+            parent->damage(QRect(i % 32, i % 32, 32, 32));
+            parent->commit(KWayland::Client::Surface::CommitFlag::None);
+        }
+        m_connection->flush();
+
+        while (commitCount < target) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+
+        totalNanoseconds += timer.nsecsElapsed();
+        totalFrames += frames;
+    }
+
+    if (totalNanoseconds > 0) {
+        qInfo("%s: %.0f frames per second", QTest::currentDataTag(), totalFrames * 1e9 / totalNanoseconds);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchSurfaceCommit)
+#include "bench_surface_commit.moc"
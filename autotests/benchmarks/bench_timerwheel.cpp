@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QTimer>
+#include <QtTest>
+// KWin
+#include "../../src/server/timerwheel.h"
+// std
+#include <memory>
+#include <vector>
+
+using namespace KWaylandServer;
+
+// the number of clients that get pinged, each ping has its own timeout
+static const int s_clientCount = 1000;
+static const std::chrono::milliseconds s_pingTimeout(1000);
+
+class TimerWheelBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkWheelArmCancel();
+    void benchmarkQTimerArmCancel();
+    void benchmarkWheelRearm();
+    void benchmarkQTimerRearm();
+    void testWheelExpiry();
+};
+
+void TimerWheelBenchmark::benchmarkWheelArmCancel()
+{
+    // every ping arms a timer which is cancelled again by the pong
+    TimerWheel wheel;
+    std::vector<std::unique_ptr<TimerWheel::Timer>> timers;
+    QBENCHMARK {
+        for (int i = 0; i < s_clientCount; ++i) {
+            auto timer = std::make_unique<TimerWheel::Timer>();
+            timer->setCallback([]() {});
+            timer->start(&wheel, s_pingTimeout);
+            timers.push_back(std::move(timer));
+        }
+        timers.clear();
+    }
+}
+
+void TimerWheelBenchmark::benchmarkQTimerArmCancel()
+{
+    std::vector<std::unique_ptr<QTimer>> timers;
+    QBENCHMARK {
+        for (int i = 0; i < s_clientCount; ++i) {
+            auto timer = std::make_unique<QTimer>();
+            timer->setSingleShot(true);
+            QObject::connect(timer.get(), &QTimer::timeout, []() {});
+            timer->start(s_pingTimeout);
+            timers.push_back(std::move(timer));
+        }
+        timers.clear();
+    }
+}
+
+void TimerWheelBenchmark::benchmarkWheelRearm()
+{
+    // idle timeouts get restarted on every input event
+    TimerWheel wheel;
+    std::vector<TimerWheel::Timer> timers(s_clientCount);
+    QBENCHMARK {
+        for (TimerWheel::Timer &timer : timers) {
+            timer.start(&wheel, s_pingTimeout);
+        }
+    }
+}
+
+void TimerWheelBenchmark::benchmarkQTimerRearm()
+{
+    std::vector<std::unique_ptr<QTimer>> timers;
+    for (int i = 0; i < s_clientCount; ++i) {
+        timers.push_back(std::make_unique<QTimer>());
+        timers.back()->setSingleShot(true);
+    }
+    QBENCHMARK {
+        for (auto &timer : timers) {
+            timer->start(s_pingTimeout);
+        }
+    }
+}
+
+void TimerWheelBenchmark::testWheelExpiry()
+{
+    // not a benchmark, but the numbers above are worthless if the timers don't fire
+    TimerWheel wheel;
+    std::vector<TimerWheel::Timer> timers(s_clientCount);
+    int expired = 0;
+    for (int i = 0; i < s_clientCount; ++i) {
+        timers[i].setCallback([&expired]() {
+            expired++;
+        });
+        timers[i].start(&wheel, std::chrono::milliseconds(50 + i % 100));
+    }
+    timers[0].stop();
+    QTRY_COMPARE_WITH_TIMEOUT(expired, s_clientCount - 1, 1000);
+    for (const TimerWheel::Timer &timer : timers) {
+        QVERIFY(!timer.isActive());
+    }
+}
+
+QTEST_GUILESS_MAIN(TimerWheelBenchmark)
+#include "bench_timerwheel.moc"
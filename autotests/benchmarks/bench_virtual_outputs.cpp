@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+#include "inprocessfixture.h"
+#include "virtualoutputs.h"
+// std
+#include <memory>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+class BenchVirtualOutputs : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchScaleChange_data();
+    void benchScaleChange();
+    void benchHotplugStorm_data();
+    void benchHotplugStorm();
+    void benchFrameCallbacks_data();
+    void benchFrameCallbacks();
+
+private:
+    void bindOutputs();
+
+    InProcessFixture *m_fixture = nullptr;
+    VirtualOutputs *m_outputs = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    // the client binds every output that is announced, like a toolkit does
+    std::vector<std::unique_ptr<KWayland::Client::Output>> m_clientOutputs;
+};
+
+void BenchVirtualOutputs::init()
+{
+    m_fixture = new InProcessFixture(this);
+    QVERIFY(m_fixture->setUp());
+    m_compositorInterface = new KWaylandServer::CompositorInterface(m_fixture->display(), m_fixture->display());
+    m_outputs = new VirtualOutputs(m_fixture->display());
+    QVERIFY(m_fixture->announce());
+
+    KWayland::Client::Registry *registry = m_fixture->registry();
+    const auto compositor = registry->interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry->createCompositor(compositor.name, compositor.version, this);
+    connect(registry, &KWayland::Client::Registry::outputAnnounced, this, [this, registry](quint32 name, quint32 version) {
+        m_clientOutputs.emplace_back(registry->createOutput(name, version));
+    });
+    QVERIFY(m_fixture->roundtrip());
+}
+
+void BenchVirtualOutputs::cleanup()
+{
+    m_clientOutputs.clear();
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_outputs;
+    m_outputs = nullptr;
+    delete m_fixture;
+    m_fixture = nullptr;
+    m_compositorInterface = nullptr;
+}
+
+void BenchVirtualOutputs::benchScaleChange_data()
+{
+    QTest::addColumn<int>("outputs");
+
+    QTest::newRow("1 output") << 1;
+    QTest::newRow("4 outputs") << 4;
+    QTest::newRow("16 outputs") << 16;
+}
+
+void BenchVirtualOutputs::benchScaleChange()
+{
+    // measures the fan-out of a scale change to all outputs until the client applied it
+    QFETCH(int, outputs);
+    for (int i = 0; i < outputs; ++i) {
+        m_outputs->add();
+    }
+    QVERIFY(m_fixture->roundtrip());
+    QVERIFY(m_fixture->roundtrip());
+    QCOMPARE(int(m_clientOutputs.size()), outputs);
+
+    int scale = 1;
+    QBENCHMARK {
+        scale = scale == 1 ? 2 : 1;
+        m_outputs->setScale(scale);
+        QVERIFY(m_fixture->roundtrip());
+    }
+    QCOMPARE(m_clientOutputs.back()->scale(), scale);
+}
+
+void BenchVirtualOutputs::benchHotplugStorm_data()
+{
+    QTest::addColumn<int>("cycles");
+
+    QTest::newRow("1 cycle") << 1;
+    QTest::newRow("10 cycles") << 10;
+}
+
+void BenchVirtualOutputs::benchHotplugStorm()
+{
+    // measures a flapping monitor cable, with one other monitor connected
+    QFETCH(int, cycles);
+    m_outputs->add(QSize(2560, 1440), 144000);
+    m_outputs->add();
+    QVERIFY(m_fixture->roundtrip());
+
+    QBENCHMARK {
+        m_outputs->hotplugStorm(cycles);
+        QVERIFY(m_fixture->roundtrip());
+        QVERIFY(m_fixture->roundtrip());
+        m_outputs->purge();
+    }
+}
+
+void BenchVirtualOutputs::benchFrameCallbacks_data()
+{
+    QTest::addColumn<int>("surfaces");
+    QTest::addColumn<int>("refreshRate");
+
+    QTest::newRow("1 surface 60 Hz") << 1 << 60000;
+    QTest::newRow("16 surfaces 60 Hz") << 16 << 60000;
+    QTest::newRow("16 surfaces 144 Hz") << 16 << 144000;
+}
+
+void BenchVirtualOutputs::benchFrameCallbacks()
+{
+    // measures one second of frame callbacks of surfaces which render on every callback
+    QFETCH(int, surfaces);
+    QFETCH(int, refreshRate);
+    VirtualOutputs::Output *output = m_outputs->add(QSize(1920, 1080), refreshRate);
+
+    QVector<KWaylandServer::SurfaceInterface *> serverSurfaces;
+    connect(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated, this, [&serverSurfaces](KWaylandServer::SurfaceInterface *surface) {
+        serverSurfaces << surface;
+    });
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> clientSurfaces;
+    int frames = 0;
+    for (int i = 0; i < surfaces; ++i) {
+        clientSurfaces.emplace_back(m_compositor->createSurface());
+        KWayland::Client::Surface *surface = clientSurfaces.back().get();
+        connect(surface, &KWayland::Client::Surface::frameRendered, this, [surface, &frames]() {
+            frames++;
+            surface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+        });
+        surface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+    }
+    QVERIFY(m_fixture->roundtrip());
+    QCOMPARE(serverSurfaces.count(), surfaces);
+    for (KWaylandServer::SurfaceInterface *surface : qAsConst(serverSurfaces)) {
+        surface->setOutputs({output->output});
+    }
+
+    const std::chrono::nanoseconds period(qint64(1e12 / refreshRate));
+    QBENCHMARK {
+        for (std::chrono::nanoseconds elapsed = 0ns; elapsed < 1s; elapsed += period) {
+            m_outputs->advance(period, serverSurfaces);
+            QVERIFY(m_fixture->roundtrip());
+        }
+    }
+    QVERIFY(frames > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchVirtualOutputs)
+#include "bench_virtual_outputs.moc"
@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "dispatchclient.h"
+#include "qwayland-server-wayland.h"
+// system
+#include <sys/socket.h>
+// std
+#include <memory>
+
+// the requests sent per iteration, they have to fit into the buffer of the client connection
+static const int s_batchSize = 100;
+
+class Surface : public QtWaylandServer::wl_surface
+{
+public:
+    Surface(struct ::wl_client *client, int id, int version)
+        : QtWaylandServer::wl_surface(client, id, version)
+    {
+    }
+
+    int damageCount = 0;
+    int commitCount = 0;
+
+protected:
+    void surface_destroy_resource(Resource *resource) override
+    {
+        Q_UNUSED(resource)
+        delete this;
+    }
+    void surface_destroy(Resource *resource) override
+    {
+        wl_resource_destroy(resource->handle);
+    }
+    void surface_damage_buffer(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height) override
+    {
+        Q_UNUSED(resource)
+        Q_UNUSED(x)
+        Q_UNUSED(y)
+        Q_UNUSED(width)
+        Q_UNUSED(height)
+        ++damageCount;
+    }
+    void surface_commit(Resource *resource) override
+    {
+        Q_UNUSED(resource)
+        ++commitCount;
+    }
+};
+
+class Compositor : public QtWaylandServer::wl_compositor
+{
+public:
+    explicit Compositor(struct ::wl_display *display)
+        : QtWaylandServer::wl_compositor(display, 4)
+    {
+    }
+
+    Surface *surface = nullptr;
+
+protected:
+    void compositor_create_surface(Resource *resource, uint32_t id) override
+    {
+        surface = new Surface(resource->client(), id, resource->version());
+    }
+};
+
+class Pointer : public QtWaylandServer::wl_pointer
+{
+public:
+    Pointer(struct ::wl_client *client, int id, int version)
+        : QtWaylandServer::wl_pointer(client, id, version)
+    {
+    }
+
+    int setCursorCount = 0;
+
+protected:
+    void pointer_destroy_resource(Resource *resource) override
+    {
+        Q_UNUSED(resource)
+        delete this;
+    }
+    void pointer_release(Resource *resource) override
+    {
+        wl_resource_destroy(resource->handle);
+    }
+    void pointer_set_cursor(Resource *resource, uint32_t serial, struct ::wl_resource *surface, int32_t hotspot_x, int32_t hotspot_y) override
+    {
+        Q_UNUSED(resource)
+        Q_UNUSED(serial)
+        Q_UNUSED(surface)
+        Q_UNUSED(hotspot_x)
+        Q_UNUSED(hotspot_y)
+        ++setCursorCount;
+    }
+};
+
+class Seat : public QtWaylandServer::wl_seat
+{
+public:
+    explicit Seat(struct ::wl_display *display)
+        : QtWaylandServer::wl_seat(display, 5)
+    {
+    }
+
+    Pointer *pointer = nullptr;
+
+protected:
+    void seat_get_pointer(Resource *resource, uint32_t id) override
+    {
+        pointer = new Pointer(resource->client(), id, resource->version());
+    }
+};
+
+/**
+ * The benchmark is built twice, once with the server classes generated for dispatching
+ * through libffi and once with --static-dispatch. Compare the results of benchDispatch and
+ * benchDispatchStatic.
+ */
+class DispatchBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void benchSurfaceRequests();
+    void benchPointerRequests();
+
+private:
+    void pump();
+
+    struct ::wl_display *m_display = nullptr;
+    std::unique_ptr<Compositor> m_compositor;
+    std::unique_ptr<Seat> m_seat;
+    std::unique_ptr<DispatchClient> m_client;
+};
+
+void DispatchBenchmark::init()
+{
+    m_display = wl_display_create();
+    QVERIFY(m_display);
+    m_compositor = std::make_unique<Compositor>(m_display);
+    m_seat = std::make_unique<Seat>(m_display);
+
+    int fds[2];
+    QCOMPARE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+    QVERIFY(wl_client_create(m_display, fds[0]));
+    m_client = std::make_unique<DispatchClient>(fds[1], [this]() {
+        pump();
+    });
+    QVERIFY(m_client->setup());
+    QVERIFY(m_compositor->surface);
+    QVERIFY(m_seat->pointer);
+}
+
+void DispatchBenchmark::cleanup()
+{
+    m_client.reset();
+    m_seat.reset();
+    m_compositor.reset();
+    if (m_display) {
+        wl_display_destroy_clients(m_display);
+        wl_display_destroy(m_display);
+        m_display = nullptr;
+    }
+}
+
+void DispatchBenchmark::pump()
+{
+    wl_event_loop_dispatch(wl_display_get_event_loop(m_display), 0);
+    wl_display_flush_clients(m_display);
+}
+
+void DispatchBenchmark::benchSurfaceRequests()
+{
+    // the damage and commit traffic of a client rendering frames
+    Surface *surface = m_compositor->surface;
+    int expected = surface->commitCount;
+    QBENCHMARK {
+        m_client->damageSurface(s_batchSize);
+        m_client->flush();
+        expected += s_batchSize;
+        while (surface->commitCount < expected) {
+            pump();
+        }
+    }
+    QCOMPARE(surface->damageCount, surface->commitCount);
+}
+
+void DispatchBenchmark::benchPointerRequests()
+{
+    Pointer *pointer = m_seat->pointer;
+    int expected = pointer->setCursorCount;
+    QBENCHMARK {
+        m_client->setCursor(s_batchSize);
+        m_client->flush();
+        expected += s_batchSize;
+        while (pointer->setCursorCount < expected) {
+            pump();
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(DispatchBenchmark)
+#include "bench_dispatch.moc"
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "dispatchclient.h"
+
+#include <wayland-client.h>
+
+#include <algorithm>
+#include <cstring>
+
+struct Globals {
+    wl_compositor *compositor = nullptr;
+    wl_seat *seat = nullptr;
+};
+
+static void handleGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    auto globals = static_cast<Globals *>(data);
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        globals->compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, std::min(version, 4u)));
+    } else if (strcmp(interface, wl_seat_interface.name) == 0) {
+        globals->seat = static_cast<wl_seat *>(wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, 5u)));
+    }
+}
+
+static void handleGlobalRemove(void *, wl_registry *, uint32_t)
+{
+}
+
+static const wl_registry_listener s_registryListener = {
+    handleGlobal,
+    handleGlobalRemove,
+};
+
+DispatchClient::DispatchClient(int fd, Pump pump)
+    : m_pump(std::move(pump))
+    , m_display(wl_display_connect_to_fd(fd))
+{
+}
+
+DispatchClient::~DispatchClient()
+{
+    if (m_pointer) {
+        wl_pointer_release(m_pointer);
+    }
+    if (m_surface) {
+        wl_surface_destroy(m_surface);
+    }
+    if (m_seat) {
+        wl_seat_destroy(m_seat);
+    }
+    if (m_compositor) {
+        wl_compositor_destroy(m_compositor);
+    }
+    if (m_registry) {
+        wl_registry_destroy(m_registry);
+    }
+    if (m_display) {
+        wl_display_flush(m_display);
+        m_pump();
+        wl_display_disconnect(m_display);
+    }
+}
+
+bool DispatchClient::setup()
+{
+    if (!m_display) {
+        return false;
+    }
+
+    Globals globals;
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &s_registryListener, &globals);
+    roundtrip();
+    wl_registry_destroy(m_registry);
+    m_registry = nullptr;
+
+    m_compositor = globals.compositor;
+    m_seat = globals.seat;
+    if (!m_compositor || !m_seat) {
+        return false;
+    }
+
+    m_surface = wl_compositor_create_surface(m_compositor);
+    m_pointer = wl_seat_get_pointer(m_seat);
+    roundtrip();
+    return wl_display_get_error(m_display) == 0;
+}
+
+void DispatchClient::roundtrip()
+{
+    // the server runs in this thread, wl_display_roundtrip() would wait for it forever
+    wl_callback *callback = wl_display_sync(m_display);
+    wl_display_flush(m_display);
+    m_pump();
+    wl_display_dispatch(m_display);
+    wl_callback_destroy(callback);
+}
+
+void DispatchClient::damageSurface(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        wl_surface_damage_buffer(m_surface, i, i, 1, 1);
+        wl_surface_commit(m_surface);
+    }
+}
+
+void DispatchClient::setCursor(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        wl_pointer_set_cursor(m_pointer, i, nullptr, 0, 0);
+    }
+}
+
+void DispatchClient::flush()
+{
+    wl_display_flush(m_display);
+}
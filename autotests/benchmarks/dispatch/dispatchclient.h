@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <functional>
+
+struct wl_compositor;
+struct wl_display;
+struct wl_pointer;
+struct wl_registry;
+struct wl_seat;
+struct wl_surface;
+
+/**
+ * A bare libwayland client for the dispatch benchmark.
+ *
+ * It lives in its own translation unit, the client and the server protocol headers don't
+ * mix. The client runs in the thread of the server, so every exchange goes through a pump
+ * function that dispatches and flushes the server side.
+ */
+class DispatchClient
+{
+public:
+    using Pump = std::function<void()>;
+
+    DispatchClient(int fd, Pump pump);
+    ~DispatchClient();
+
+    /**
+     * Binds the compositor and the seat, and creates a surface and a pointer.
+     */
+    bool setup();
+
+    void damageSurface(int count);
+    void setCursor(int count);
+    void flush();
+
+private:
+    void roundtrip();
+
+    Pump m_pump;
+    wl_display *m_display = nullptr;
+    wl_registry *m_registry = nullptr;
+    wl_compositor *m_compositor = nullptr;
+    wl_seat *m_seat = nullptr;
+    wl_surface *m_surface = nullptr;
+    wl_pointer *m_pointer = nullptr;
+};
@@ -0,0 +1,373 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/buffer.h"
+#include "../../src/client/clientmanagement.h"
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/clientmanagement_interface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+
+using namespace KWayland::Client;
+
+Q_DECLARE_METATYPE(KWayland::Client::Buffer::Format)
+
+class TestClientManagement : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TestClientManagement(QObject *parent = nullptr);
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testThumbnailFormat_data();
+    void testThumbnailFormat();
+    void testThumbnailCache();
+    void testCapture();
+    void testCaptureDamage();
+    void testManyWindowStates();
+    void testUnchangedWindowStates();
+
+private:
+    // attaches a buffer filled with pixel, the whole buffer is damaged if damage is empty
+    void attachBuffer(const QSize &size, quint32 pixel, Buffer::Format format, const QRegion &damage = QRegion());
+    // captures the surface into the buffer, returns whether the compositor succeeded
+    bool capture(Buffer *buffer);
+    // requests a thumbnail of the surface and returns its top left pixel
+    quint32 thumbnail(const QSize &size, Buffer::Format format = Buffer::Format::ARGB32);
+
+    KWaylandServer::Display *m_display;
+    KWaylandServer::CompositorInterface *m_compositorInterface;
+    KWaylandServer::ClientManagementInterface *m_clientManagementInterface;
+    KWaylandServer::SurfaceInterface *m_serverSurface;
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::Compositor *m_compositor;
+    KWayland::Client::ShmPool *m_shm;
+    KWayland::Client::ClientManagement *m_clientManagement;
+    KWayland::Client::Surface *m_surface;
+    KWayland::Client::EventQueue *m_queue;
+    QThread *m_thread;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-client-management-0");
+
+TestClientManagement::TestClientManagement(QObject *parent)
+    : QObject(parent)
+    , m_display(nullptr)
+    , m_compositorInterface(nullptr)
+    , m_clientManagementInterface(nullptr)
+    , m_serverSurface(nullptr)
+    , m_connection(nullptr)
+    , m_compositor(nullptr)
+    , m_shm(nullptr)
+    , m_clientManagement(nullptr)
+    , m_surface(nullptr)
+    , m_queue(nullptr)
+    , m_thread(nullptr)
+{
+}
+
+void TestClientManagement::init()
+{
+    using namespace KWaylandServer;
+    delete m_display;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    Registry registry;
+    QSignalSpy compositorSpy(&registry, &Registry::compositorAnnounced);
+    QSignalSpy shmSpy(&registry, &Registry::shmAnnounced);
+    QSignalSpy clientManagementSpy(&registry, &Registry::clientManagementAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    QVERIFY(compositorSpy.wait());
+    m_compositor = registry.createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+
+    QVERIFY(shmSpy.count() || shmSpy.wait());
+    m_shm = registry.createShmPool(shmSpy.first().first().value<quint32>(), shmSpy.first().last().value<quint32>(), this);
+
+    m_clientManagementInterface = new ClientManagementInterface(m_display, m_display);
+    QVERIFY(clientManagementSpy.wait());
+    m_clientManagement =
+        registry.createClientManagement(clientManagementSpy.first().first().value<quint32>(), clientManagementSpy.first().last().value<quint32>(), this);
+
+    connect(m_clientManagementInterface,
+            &ClientManagementInterface::captureWindowImageRequest,
+            m_clientManagementInterface,
+            [this](int windowId, wl_resource *buffer) {
+                m_clientManagementInterface->sendWindowCaption(windowId, buffer, m_serverSurface);
+            });
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+void TestClientManagement::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_surface)
+    CLEANUP(m_clientManagement)
+    CLEANUP(m_shm)
+    CLEANUP(m_compositor)
+    CLEANUP(m_queue)
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    // these are the children of the display
+    m_compositorInterface = nullptr;
+    m_clientManagementInterface = nullptr;
+    m_serverSurface = nullptr;
+}
+
+void TestClientManagement::attachBuffer(const QSize &size, quint32 pixel, Buffer::Format format, const QRegion &damage)
+{
+    const QVector<quint32> pixels(size.width() * size.height(), pixel);
+    QSignalSpy committedSpy(m_serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    m_surface->attachBuffer(m_shm->createBuffer(size, size.width() * 4, pixels.constData(), format));
+    m_surface->damage(damage.isEmpty() ? QRegion(QRect(QPoint(0, 0), size)) : damage);
+    m_surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+}
+
+quint32 TestClientManagement::thumbnail(const QSize &size, Buffer::Format format)
+{
+    QSharedPointer<Buffer> buffer = m_shm->getBuffer(size, size.width() * 4, format).toStrongRef();
+    if (!buffer) {
+        return 0;
+    }
+    buffer->setUsed(true);
+    if (!capture(buffer.data())) {
+        buffer->setUsed(false);
+        return 0;
+    }
+    const quint32 pixel = *reinterpret_cast<const quint32 *>(buffer->address());
+    buffer->setUsed(false);
+    return pixel;
+}
+
+bool TestClientManagement::capture(Buffer *buffer)
+{
+    QSignalSpy captionSpy(m_clientManagement, &ClientManagement::captionWindowDone);
+    m_clientManagement->getWindowCaption(1, *buffer);
+    return captionSpy.wait() && captionSpy.first().last().toBool();
+}
+
+void TestClientManagement::testThumbnailFormat_data()
+{
+    QTest::addColumn<Buffer::Format>("surfaceFormat");
+    QTest::addColumn<quint32>("surfacePixel");
+    QTest::addColumn<Buffer::Format>("thumbnailFormat");
+    QTest::addColumn<quint32>("thumbnailPixel");
+
+    // the padding byte of XRGB isn't an alpha channel, the thumbnail has to be opaque
+    QTest::newRow("xrgb to argb") << Buffer::Format::RGB32 << 0x00ff0000u << Buffer::Format::ARGB32 << 0xffff0000u;
+    QTest::newRow("argb to argb") << Buffer::Format::ARGB32 << 0xff00ff00u << Buffer::Format::ARGB32 << 0xff00ff00u;
+    QTest::newRow("argb to xrgb") << Buffer::Format::ARGB32 << 0xff0000ffu << Buffer::Format::RGB32 << 0xff0000ffu;
+}
+
+void TestClientManagement::testThumbnailFormat()
+{
+    QFETCH(Buffer::Format, surfaceFormat);
+    QFETCH(quint32, surfacePixel);
+    QFETCH(Buffer::Format, thumbnailFormat);
+
+    attachBuffer(QSize(20, 20), surfacePixel, surfaceFormat);
+    QTEST(thumbnail(QSize(10, 10), thumbnailFormat), "thumbnailPixel");
+}
+
+void TestClientManagement::testThumbnailCache()
+{
+    // nothing gets scaled again because of damage within the test
+    m_clientManagementInterface->setThumbnailRefreshInterval(std::chrono::hours(1));
+
+    const quint32 red = 0xffff0000;
+    const quint32 green = 0xff00ff00;
+    attachBuffer(QSize(20, 20), red, Buffer::Format::ARGB32);
+    QCOMPARE(thumbnail(QSize(10, 10)), red);
+    QCOMPARE(thumbnail(QSize(11, 11)), red);
+    QCOMPARE(thumbnail(QSize(12, 12)), red);
+    QCOMPARE(thumbnail(QSize(13, 13)), red);
+
+    // the cached thumbnails are used while the refresh interval lasts
+    attachBuffer(QSize(20, 20), green, Buffer::Format::ARGB32);
+    QCOMPARE(thumbnail(QSize(10, 10)), red);
+
+    // a new size drops the least recently used one, 11x11 rather than the just used 10x10
+    QCOMPARE(thumbnail(QSize(14, 14)), green);
+    QCOMPARE(thumbnail(QSize(10, 10)), red);
+    QCOMPARE(thumbnail(QSize(11, 11)), green);
+}
+
+void TestClientManagement::testCapture()
+{
+    const quint32 red = 0xffff0000;
+    attachBuffer(QSize(20, 20), red, Buffer::Format::ARGB32);
+
+    // a buffer of the size of the surface gets a copy of the whole surface
+    QSharedPointer<Buffer> buffer = m_shm->getBuffer(QSize(20, 20), 20 * 4).toStrongRef();
+    QVERIFY(buffer);
+    buffer->setUsed(true);
+    QVERIFY(capture(buffer.data()));
+    const quint32 *pixels = reinterpret_cast<const quint32 *>(buffer->address());
+    QVERIFY(std::all_of(pixels, pixels + 20 * 20, [red](quint32 pixel) {
+        return pixel == red;
+    }));
+    buffer->setUsed(false);
+}
+
+void TestClientManagement::testCaptureDamage()
+{
+    const quint32 red = 0xffff0000;
+    const quint32 green = 0xff00ff00;
+    const quint32 blue = 0xff0000ff;
+    attachBuffer(QSize(20, 20), red, Buffer::Format::ARGB32);
+
+    QSharedPointer<Buffer> buffer = m_shm->getBuffer(QSize(20, 20), 20 * 4).toStrongRef();
+    QVERIFY(buffer);
+    buffer->setUsed(true);
+    QVERIFY(capture(buffer.data()));
+    quint32 *pixels = reinterpret_cast<quint32 *>(buffer->address());
+    QCOMPARE(pixels[0], red);
+    QCOMPARE(pixels[20 * 20 - 1], red);
+
+    // the buffer still holds the last capture, only the damaged part is copied into it again,
+    // which the pixels the capture doesn't touch show
+    std::fill(pixels, pixels + 20 * 20, blue);
+    attachBuffer(QSize(20, 20), green, Buffer::Format::ARGB32, QRect(0, 0, 5, 5));
+    QVERIFY(capture(buffer.data()));
+    QCOMPARE(pixels[0], green);
+    QCOMPARE(pixels[4 * 20 + 4], green);
+    QCOMPARE(pixels[4 * 20 + 5], blue);
+    QCOMPARE(pixels[5 * 20 + 4], blue);
+    QCOMPARE(pixels[20 * 20 - 1], blue);
+
+    // without new damage nothing is copied
+    std::fill(pixels, pixels + 20 * 20, blue);
+    QVERIFY(capture(buffer.data()));
+    QCOMPARE(pixels[0], blue);
+
+    // another buffer gets the whole surface
+    QSharedPointer<Buffer> other = m_shm->getBuffer(QSize(20, 20), 20 * 4).toStrongRef();
+    QVERIFY(other);
+    other->setUsed(true);
+    QVERIFY(capture(other.data()));
+    const quint32 *otherPixels = reinterpret_cast<const quint32 *>(other->address());
+    QVERIFY(std::all_of(otherPixels, otherPixels + 20 * 20, [green](quint32 pixel) {
+        return pixel == green;
+    }));
+    other->setUsed(false);
+    buffer->setUsed(false);
+}
+
+void TestClientManagement::testManyWindowStates()
+{
+    using KWaylandServer::ClientManagementInterface;
+    QVector<ClientManagementInterface::WindowState> states(150);
+    QList<ClientManagementInterface::WindowState *> stateList;
+    for (int i = 0; i < states.count(); ++i) {
+        states[i] = {};
+        states[i].windowId = i + 1;
+        qsnprintf(states[i].resourceName, sizeof(states[i].resourceName), "window %d", i + 1);
+        stateList << &states[i];
+    }
+
+    // the states which don't fit into a single message are dropped instead of failing to send all
+    QSignalSpy windowStatesSpy(m_clientManagement, &ClientManagement::windowStatesChanged);
+    QSignalSpy errorSpy(m_connection, &ConnectionThread::errorOccurred);
+    m_clientManagementInterface->setWindowStates(stateList);
+    QVERIFY(windowStatesSpy.wait());
+    QVERIFY(errorSpy.isEmpty());
+    const QVector<ClientManagement::WindowState> windowStates = m_clientManagement->getWindowStates();
+    QVERIFY(windowStates.count() > 100);
+    QVERIFY(windowStates.count() < states.count());
+    QCOMPARE(windowStates.first().windowId, 1);
+    QCOMPARE(windowStates.last().windowId, windowStates.count());
+    QCOMPARE(QByteArray(windowStates.last().resourceName), QByteArrayLiteral("window ") + QByteArray::number(windowStates.count()));
+}
+
+void TestClientManagement::testUnchangedWindowStates()
+{
+    using KWaylandServer::ClientManagementInterface;
+    ClientManagementInterface::WindowState state;
+    memset(&state, 0, sizeof(state));
+    state.windowId = 1;
+    qstrcpy(state.uuid, "uuid");
+    QList<ClientManagementInterface::WindowState *> stateList{&state};
+
+    QSignalSpy changedSpy(m_clientManagementInterface, &ClientManagementInterface::windowStatesChanged);
+    m_clientManagementInterface->setWindowStates(stateList);
+    QCOMPARE(changedSpy.count(), 1);
+
+    // the bytes after the terminators of the strings aren't part of the state
+    ClientManagementInterface::WindowState other;
+    memset(&other, 0xff, sizeof(other));
+    other.pid = state.pid;
+    other.windowId = state.windowId;
+    qstrcpy(other.resourceName, state.resourceName);
+    other.geometry = state.geometry;
+    other.isMinimized = state.isMinimized;
+    other.isFullScreen = state.isFullScreen;
+    other.isActive = state.isActive;
+    other.splitable = state.splitable;
+    qstrcpy(other.uuid, state.uuid);
+    stateList = {&other};
+    m_clientManagementInterface->setWindowStates(stateList);
+    QCOMPARE(changedSpy.count(), 1);
+
+    other.isActive = true;
+    m_clientManagementInterface->setWindowStates(stateList);
+    QCOMPARE(changedSpy.count(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestClientManagement)
+#include "test_client_management.moc"
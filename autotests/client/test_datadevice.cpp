@@ -18,6 +18,7 @@
 #include "../../src/client/datadevice.h"
 #include "../../src/client/datadevicemanager.h"
 #include "../../src/client/datasource.h"
+#include "../../src/client/datatransfer.h"
 #include "../../src/client/event_queue.h"
 #include "../../src/client/keyboard.h"
 #include "../../src/client/pointer.h"
@@ -44,6 +45,7 @@ private Q_SLOTS:
     void testSetSelection();
     void testSendSelectionOnSeat();
     void testReplaceSource();
+    void testTransfer();
 
 private:
     KWaylandServer::Display *m_display = nullptr;
@@ -589,5 +591,78 @@ void TestDataDevice::testReplaceSource()
     close(pipeFds[0]);
 }
 
+
+void TestDataDevice::testTransfer()
+{
+    // this test verifies that the data of a selection gets through DataSender and DataReceiver
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy dataDeviceCreatedSpy(m_dataDeviceManagerInterface, &KWaylandServer::DataDeviceManagerInterface::dataDeviceCreated);
+    QVERIFY(dataDeviceCreatedSpy.isValid());
+    QScopedPointer<DataDevice> dataDevice(m_dataDeviceManager->getDataDevice(m_seat));
+    QVERIFY(dataDevice->isValid());
+    QVERIFY(dataDeviceCreatedSpy.wait());
+    auto deviceInterface = dataDeviceCreatedSpy.first().first().value<DataDeviceInterface *>();
+    QVERIFY(deviceInterface);
+
+    // more than fits into a pipe at once
+    const QByteArray content(1024 * 1024, 'x');
+    QScopedPointer<DataSource> dataSource(m_dataDeviceManager->createDataSource());
+    QVERIFY(dataSource->isValid());
+    dataSource->offer(QStringLiteral("text/plain"));
+    DataSender sender;
+    QSignalSpy sentSpy(&sender, &DataSender::finished);
+    QVERIFY(sentSpy.isValid());
+    connect(dataSource.data(), &DataSource::sendDataRequested, &sender, [&sender, content](const QString &mimeType, qint32 fd) {
+        QCOMPARE(mimeType, QStringLiteral("text/plain"));
+        QVERIFY(sender.send(fd, content));
+    });
+
+    QSignalSpy selectionChangedSpy(deviceInterface, &KWaylandServer::DataDeviceInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+    dataDevice->setSelection(1, dataSource.data());
+    QVERIFY(selectionChangedSpy.wait());
+
+    QSignalSpy selectionOfferedSpy(dataDevice.data(), &KWayland::Client::DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedSpy.isValid());
+    deviceInterface->sendSelection(deviceInterface->selection());
+    QVERIFY(selectionOfferedSpy.wait());
+    auto dataOffer = selectionOfferedSpy.first().first().value<DataOffer *>();
+    QVERIFY(dataOffer);
+
+    DataReceiver receiver;
+    QSignalSpy receivedSpy(&receiver, &DataReceiver::finished);
+    QVERIFY(receivedSpy.isValid());
+    QSignalSpy failedSpy(&receiver, &DataReceiver::failed);
+    QVERIFY(failedSpy.isValid());
+    QVERIFY(receiver.receive(dataOffer, QStringLiteral("text/plain")));
+    QVERIFY(receiver.isActive());
+    // only one transfer at a time
+    QVERIFY(!receiver.receive(dataOffer, QStringLiteral("text/plain")));
+    m_connection->flush();
+
+    QVERIFY(receivedSpy.wait());
+    QVERIFY(failedSpy.isEmpty());
+    QVERIFY(!receiver.isActive());
+    QCOMPARE(receiver.bytesReceived(), qint64(content.size()));
+    QCOMPARE(receiver.data(), content);
+    QCOMPARE(sentSpy.count(), 1);
+    QCOMPARE(sender.bytesSent(), qint64(content.size()));
+    QVERIFY(!sender.isActive());
+
+    // the data can also go straight into a file
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    receiver.setTarget(file.handle());
+    QVERIFY(receiver.receive(dataOffer, QStringLiteral("text/plain")));
+    m_connection->flush();
+    QVERIFY(receivedSpy.wait());
+    QVERIFY(receiver.data().isEmpty());
+    QCOMPARE(receiver.bytesReceived(), qint64(content.size()));
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.readAll(), content);
+}
+
 QTEST_GUILESS_MAIN(TestDataDevice)
 #include "test_datadevice.moc"
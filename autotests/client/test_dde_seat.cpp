@@ -0,0 +1,350 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/ddekeyboard.h"
+#include "../../src/client/ddeseat.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/clientconnection.h"
+#include "../../src/server/ddeseat_interface.h"
+#include "../../src/server/ddeseat_interface_p.h"
+#include "../../src/server/display.h"
+#include "../../src/server/seat_interface.h"
+
+#include <linux/input.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+
+Q_DECLARE_METATYPE(KWayland::Client::DDEPointer::Axis)
+
+class TestDDESeat : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testThrottledMotion();
+    void testRegionsMotion();
+    void testSubscriptionRemovedWithClient();
+    void testSeatMirroring();
+    void testPointerMotionInterval();
+    void testTouchMotionInterval();
+    void testKeymapFromDescriptor();
+
+private:
+    KWaylandServer::ClientConnection *clientConnection() const;
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::DDESeatInterface *m_ddeSeatInterface = nullptr;
+    KWaylandServer::DDEPointerInterface *m_ddePointerInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::DDESeat *m_ddeSeat = nullptr;
+    KWayland::Client::DDEPointer *m_ddePointer = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-dde-seat-0");
+
+void TestDDESeat::init()
+{
+    using namespace KWaylandServer;
+    qRegisterMetaType<DDEPointer::ButtonState>();
+    qRegisterMetaType<DDEPointer::Axis>();
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_ddeSeatInterface = new DDESeatInterface(m_display, m_display);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    QSignalSpy allAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    const auto ddeSeat = m_registry->interface(Registry::Interface::DDESeat);
+    QVERIFY(ddeSeat.name != 0);
+    m_ddeSeat = m_registry->createDDESeat(ddeSeat.name, ddeSeat.version, this);
+    QVERIFY(m_ddeSeat->isValid());
+
+    QSignalSpy pointerCreatedSpy(m_ddeSeatInterface, &DDESeatInterface::ddePointerCreated);
+    m_ddePointer = m_ddeSeat->createDDePointer(this);
+    QVERIFY(pointerCreatedSpy.wait());
+    m_ddePointerInterface = pointerCreatedSpy.first().first().value<DDEPointerInterface *>();
+    QVERIFY(m_ddePointerInterface);
+}
+
+void TestDDESeat::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_ddePointer)
+    CLEANUP(m_ddeSeat)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    // these are the children of the display
+    m_ddeSeatInterface = nullptr;
+    m_ddePointerInterface = nullptr;
+}
+
+KWaylandServer::ClientConnection *TestDDESeat::clientConnection() const
+{
+    const auto connections = m_display->connections();
+    return connections.isEmpty() ? nullptr : connections.first();
+}
+
+void TestDDESeat::testThrottledMotion()
+{
+    using namespace KWaylandServer;
+    m_ddePointerInterface->setThrottleInterval(100);
+    m_ddePointerInterface->setMotionMode(clientConnection(), DDEPointerInterface::MotionMode::Throttled);
+    QCOMPARE(m_ddePointerInterface->motionMode(clientConnection()), DDEPointerInterface::MotionMode::Throttled);
+
+    QSignalSpy motionSpy(m_ddePointer, &DDEPointer::motion);
+    m_ddeSeatInterface->setPointerPos(QPointF(1, 1));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(1, 1));
+
+    // within the interval only the latest position goes out, once the interval passed
+    m_ddeSeatInterface->setPointerPos(QPointF(2, 2));
+    m_ddeSeatInterface->setPointerPos(QPointF(3, 3));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(3, 3));
+
+    // a button doesn't wait for the interval, and the client can still query the position
+    QSignalSpy buttonSpy(m_ddePointer, &DDEPointer::buttonStateChanged);
+    m_ddeSeatInterface->setPointerPos(QPointF(4, 4));
+    m_ddeSeatInterface->pointerButtonPressed(BTN_LEFT);
+    QVERIFY(buttonSpy.wait());
+    QCOMPARE(buttonSpy.first().first().toPointF(), QPointF(4, 4));
+    QCOMPARE(motionSpy.count(), 2);
+}
+
+void TestDDESeat::testRegionsMotion()
+{
+    using namespace KWaylandServer;
+    // the pointer starts at 0/0 within the hot region
+    m_ddePointerInterface->setHotRegion(clientConnection(), QRegion(0, 0, 10, 10));
+    m_ddePointerInterface->setMotionMode(clientConnection(), DDEPointerInterface::MotionMode::Regions);
+    QCOMPARE(m_ddePointerInterface->hotRegion(clientConnection()), QRegion(0, 0, 10, 10));
+
+    // the events are in order, so only the crossings got sent if the last one is the first
+    QSignalSpy motionSpy(m_ddePointer, &DDEPointer::motion);
+    m_ddeSeatInterface->setPointerPos(QPointF(5, 5));
+    m_ddeSeatInterface->setPointerPos(QPointF(20, 20));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 1);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(20, 20));
+
+    m_ddeSeatInterface->setPointerPos(QPointF(30, 30));
+    m_ddeSeatInterface->setPointerPos(QPointF(1, 1));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(1, 1));
+
+    // back to every position
+    m_ddePointerInterface->setMotionMode(clientConnection(), DDEPointerInterface::MotionMode::Full);
+    m_ddeSeatInterface->setPointerPos(QPointF(2, 2));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(2, 2));
+}
+
+void TestDDESeat::testSubscriptionRemovedWithClient()
+{
+    using namespace KWaylandServer;
+    auto pointerPrivate = DDEPointerInterfacePrivate::get(m_ddePointerInterface);
+    QVERIFY(pointerPrivate->subscriptions.isEmpty());
+
+    // a client which never binds a dde pointer
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    ClientConnection *client = m_display->createClient(sv[0]);
+    QVERIFY(client);
+    m_ddePointerInterface->setMotionMode(client, DDEPointerInterface::MotionMode::Throttled);
+    m_ddePointerInterface->setHotRegion(clientConnection(), QRegion(0, 0, 10, 10));
+    QCOMPARE(pointerPrivate->subscriptions.count(), 2);
+
+    QSignalSpy disconnectedSpy(client, &ClientConnection::disconnected);
+    client->destroy();
+    QCOMPARE(disconnectedSpy.count(), 1);
+    QCOMPARE(pointerPrivate->subscriptions.count(), 1);
+    QVERIFY(pointerPrivate->subscriptions.contains(clientConnection()->client()));
+    close(sv[1]);
+}
+
+void TestDDESeat::testSeatMirroring()
+{
+    using namespace KWaylandServer;
+    // the input reaches the dde seat even though the seat has no pointer
+    SeatInterface seat(m_display);
+    seat.setDDESeat(m_ddeSeatInterface);
+    QCOMPARE(seat.ddeSeat(), m_ddeSeatInterface);
+
+    QSignalSpy motionSpy(m_ddePointer, &DDEPointer::motion);
+    QSignalSpy buttonSpy(m_ddePointer, &DDEPointer::buttonStateChanged);
+    QSignalSpy axisSpy(m_ddePointer, &DDEPointer::axisChanged);
+    seat.setTimestamp(1);
+    seat.notifyPointerMotion(QPointF(10, 20));
+    seat.notifyPointerButton(BTN_LEFT, PointerButtonState::Pressed);
+    seat.notifyPointerButton(BTN_LEFT, PointerButtonState::Released);
+    seat.notifyPointerAxis(Qt::Vertical, 5, 1, PointerAxisSource::Wheel);
+    QVERIFY(axisSpy.wait());
+    QCOMPARE(m_ddeSeatInterface->pointerPos(), QPointF(10, 20));
+    QCOMPARE(motionSpy.count(), 1);
+    QCOMPARE(motionSpy.first().first().toPointF(), QPointF(10, 20));
+    QCOMPARE(buttonSpy.count(), 2);
+    QCOMPARE(buttonSpy.at(0).at(1).value<quint32>(), quint32(BTN_LEFT));
+    QCOMPARE(buttonSpy.at(0).at(2).value<DDEPointer::ButtonState>(), DDEPointer::ButtonState::Pressed);
+    QCOMPARE(buttonSpy.at(1).at(2).value<DDEPointer::ButtonState>(), DDEPointer::ButtonState::Released);
+    QCOMPARE(axisSpy.first().at(1).value<DDEPointer::Axis>(), DDEPointer::Axis::Vertical);
+    QCOMPARE(axisSpy.first().at(2).toReal(), 5.0);
+
+    // no longer mirrored
+    seat.setDDESeat(nullptr);
+    seat.notifyPointerMotion(QPointF(30, 40));
+    QCOMPARE(m_ddeSeatInterface->pointerPos(), QPointF(10, 20));
+}
+
+void TestDDESeat::testPointerMotionInterval()
+{
+    using namespace KWaylandServer;
+    m_ddeSeatInterface->setMotionInterval(100);
+    QCOMPARE(m_ddeSeatInterface->motionInterval(), 100);
+
+    QSignalSpy motionSpy(m_ddePointer, &DDEPointer::motion);
+    m_ddeSeatInterface->setPointerPos(QPointF(1, 1));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(1, 1));
+
+    // the motion within the interval is dropped, except for the position at its end
+    m_ddeSeatInterface->setPointerPos(QPointF(2, 2));
+    m_ddeSeatInterface->setPointerPos(QPointF(3, 3));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(3, 3));
+
+    // a button must not overtake the motion held back before it
+    QSignalSpy buttonSpy(m_ddePointer, &DDEPointer::buttonStateChanged);
+    m_ddeSeatInterface->setPointerPos(QPointF(4, 4));
+    m_ddeSeatInterface->pointerButtonPressed(BTN_LEFT);
+    QVERIFY(buttonSpy.wait());
+    QCOMPARE(motionSpy.count(), 3);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(4, 4));
+
+    // disabling the interval sends the held back motion right away
+    m_ddeSeatInterface->setPointerPos(QPointF(5, 5));
+    m_ddeSeatInterface->setMotionInterval(0);
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 4);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(5, 5));
+}
+
+void TestDDESeat::testTouchMotionInterval()
+{
+    using namespace KWaylandServer;
+    QSignalSpy touchCreatedSpy(m_ddeSeatInterface, &DDESeatInterface::ddeTouchCreated);
+    QScopedPointer<DDETouch> touch(m_ddeSeat->createDDETouch());
+    QVERIFY(touchCreatedSpy.wait());
+    m_ddeSeatInterface->setMotionInterval(100);
+
+    QSignalSpy motionSpy(touch.data(), &DDETouch::touchMotion);
+    QSignalSpy upSpy(touch.data(), &DDETouch::touchUp);
+    m_ddeSeatInterface->touchDown(0, QPointF(1, 1));
+    m_ddeSeatInterface->touchDown(1, QPointF(10, 10));
+    m_ddeSeatInterface->touchMotion(0, QPointF(2, 2));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 1);
+
+    // every touch point is limited on its own
+    m_ddeSeatInterface->touchMotion(1, QPointF(11, 11));
+    m_ddeSeatInterface->touchMotion(0, QPointF(3, 3));
+    m_ddeSeatInterface->touchMotion(0, QPointF(4, 4));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.first().at(0).toInt(), 0);
+    QCOMPARE(motionSpy.at(1).at(0).toInt(), 1);
+    QCOMPARE(motionSpy.at(1).at(1).toPointF(), QPointF(11, 11));
+
+    QVERIFY(motionSpy.count() == 3 || motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 3);
+    QCOMPARE(motionSpy.last().at(0).toInt(), 0);
+    QCOMPARE(motionSpy.last().at(1).toPointF(), QPointF(4, 4));
+
+    // the last position of a touch point goes out before it is lifted
+    m_ddeSeatInterface->touchMotion(0, QPointF(5, 5));
+    m_ddeSeatInterface->touchUp(0);
+    QVERIFY(upSpy.wait());
+    QCOMPARE(motionSpy.count(), 4);
+    QCOMPARE(motionSpy.last().at(1).toPointF(), QPointF(5, 5));
+}
+
+void TestDDESeat::testKeymapFromDescriptor()
+{
+    using namespace KWaylandServer;
+    const QByteArray keymap = QByteArrayLiteral("xkb_keymap { };");
+    const int fd = memfd_create("keymap", MFD_CLOEXEC);
+    QVERIFY(fd != -1);
+    QCOMPARE(write(fd, keymap.constData(), keymap.size() + 1), ssize_t(keymap.size() + 1));
+    m_ddeSeatInterface->setKeymap(fd, keymap.size() + 1);
+    // the seat doesn't hold on to the descriptor of the caller
+    close(fd);
+
+    // a keyboard bound afterwards still gets the keymap
+    QScopedPointer<DDEKeyboard> keyboard(m_ddeSeat->createDDEKeyboard());
+    QSignalSpy keymapSpy(keyboard.data(), &DDEKeyboard::keymapChanged);
+    QVERIFY(keymapSpy.wait());
+    const int keymapFd = keymapSpy.first().at(0).toInt();
+    const quint32 size = keymapSpy.first().at(1).value<quint32>();
+    QCOMPARE(size, quint32(keymap.size() + 1));
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, keymapFd, 0);
+    QVERIFY(data != MAP_FAILED);
+    QCOMPARE(QByteArray(static_cast<const char *>(data)), keymap);
+    munmap(data, size);
+    close(keymapFd);
+}
+
+QTEST_GUILESS_MAIN(TestDDESeat)
+#include "test_dde_seat.moc"
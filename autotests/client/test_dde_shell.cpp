@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/ddeshell.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/ddeshell_interface.h"
+#include "../../src/server/display.h"
+
+using namespace KWayland::Client;
+
+Q_DECLARE_METATYPE(KWayland::Client::DDEShellSurface::States)
+
+class TestDDEShell : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testStateChanged();
+    void testUpdate();
+    void testNestedUpdate();
+    void testRevertedUpdate();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWaylandServer::DDEShellInterface *m_ddeShellInterface = nullptr;
+    KWaylandServer::DDEShellSurfaceInterface *m_serverShellSurface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::DDEShell *m_ddeShell = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    KWayland::Client::DDEShellSurface *m_shellSurface = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-dde-shell-0");
+
+void TestDDEShell::init()
+{
+    using namespace KWaylandServer;
+    qRegisterMetaType<DDEShellSurface::States>();
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_ddeShellInterface = new DDEShellInterface(m_display, m_display);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    QSignalSpy allAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto ddeShell = m_registry->interface(Registry::Interface::DDEShell);
+    QVERIFY(ddeShell.name != 0);
+    m_ddeShell = m_registry->createDDEShell(ddeShell.name, ddeShell.version, this);
+    QVERIFY(m_ddeShell->isValid());
+
+    QSignalSpy shellSurfaceCreatedSpy(m_ddeShellInterface, &DDEShellInterface::shellSurfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    m_shellSurface = m_ddeShell->createShellSurface(m_surface, this);
+    QVERIFY(shellSurfaceCreatedSpy.wait());
+    m_serverShellSurface = shellSurfaceCreatedSpy.first().first().value<DDEShellSurfaceInterface *>();
+    QVERIFY(m_serverShellSurface);
+}
+
+void TestDDEShell::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_shellSurface)
+    CLEANUP(m_surface)
+    CLEANUP(m_ddeShell)
+    CLEANUP(m_compositor)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    // these are the children of the display
+    m_compositorInterface = nullptr;
+    m_ddeShellInterface = nullptr;
+    m_serverShellSurface = nullptr;
+}
+
+void TestDDEShell::testStateChanged()
+{
+    QSignalSpy maximizedSpy(m_shellSurface, &DDEShellSurface::maximizedChanged);
+    QSignalSpy stateChangedSpy(m_shellSurface, &DDEShellSurface::stateChanged);
+    // the combined signal comes after the individual ones
+    connect(m_shellSurface, &DDEShellSurface::stateChanged, this, [&maximizedSpy]() {
+        QCOMPARE(maximizedSpy.count(), 1);
+    });
+
+    m_serverShellSurface->setMaximized(true);
+    QVERIFY(stateChangedSpy.wait());
+    QCOMPARE(stateChangedSpy.count(), 1);
+    QCOMPARE(stateChangedSpy.first().first().value<DDEShellSurface::States>(), DDEShellSurface::States(DDEShellSurface::State::Maximized));
+    QVERIFY(m_shellSurface->isMaximized());
+    QCOMPARE(m_shellSurface->states(), DDEShellSurface::States(DDEShellSurface::State::Maximized));
+
+    // without an update every setter sends its own event
+    m_serverShellSurface->setActive(true);
+    m_serverShellSurface->setMaximized(false);
+    QVERIFY(stateChangedSpy.wait());
+    QVERIFY(stateChangedSpy.count() == 3 || stateChangedSpy.wait());
+    QCOMPARE(stateChangedSpy.at(1).first().value<DDEShellSurface::States>(), DDEShellSurface::States(DDEShellSurface::State::Active));
+    QCOMPARE(stateChangedSpy.at(2).first().value<DDEShellSurface::States>(), DDEShellSurface::States(DDEShellSurface::State::Maximized));
+    QCOMPARE(m_shellSurface->states(), DDEShellSurface::States(DDEShellSurface::State::Active));
+}
+
+void TestDDEShell::testUpdate()
+{
+    QSignalSpy stateChangedSpy(m_shellSurface, &DDEShellSurface::stateChanged);
+    QSignalSpy geometrySpy(m_shellSurface, &DDEShellSurface::geometryChanged);
+
+    m_serverShellSurface->beginUpdate();
+    m_serverShellSurface->setMaximized(true);
+    m_serverShellSurface->setActive(true);
+    m_serverShellSurface->sendGeometry(QRect(0, 0, 100, 100));
+    m_serverShellSurface->sendGeometry(QRect(10, 20, 100, 100));
+    m_serverShellSurface->endUpdate();
+
+    // the geometry is sent after the state
+    QVERIFY(geometrySpy.wait());
+    QCOMPARE(geometrySpy.count(), 1);
+    QCOMPARE(geometrySpy.first().first().toRect(), QRect(10, 20, 100, 100));
+    QCOMPARE(stateChangedSpy.count(), 1);
+    QCOMPARE(stateChangedSpy.first().first().value<DDEShellSurface::States>(), DDEShellSurface::States(DDEShellSurface::State::Maximized | DDEShellSurface::State::Active));
+}
+
+void TestDDEShell::testNestedUpdate()
+{
+    QSignalSpy stateChangedSpy(m_shellSurface, &DDEShellSurface::stateChanged);
+
+    // nothing is sent before the outermost update ends
+    m_serverShellSurface->beginUpdate();
+    m_serverShellSurface->beginUpdate();
+    m_serverShellSurface->setMinimized(true);
+    m_serverShellSurface->endUpdate();
+    m_serverShellSurface->setKeepAbove(true);
+    m_serverShellSurface->endUpdate();
+
+    QVERIFY(stateChangedSpy.wait());
+    QCOMPARE(stateChangedSpy.count(), 1);
+    QCOMPARE(stateChangedSpy.first().first().value<DDEShellSurface::States>(), DDEShellSurface::States(DDEShellSurface::State::Minimized | DDEShellSurface::State::KeepAbove));
+}
+
+void TestDDEShell::testRevertedUpdate()
+{
+    QSignalSpy stateChangedSpy(m_shellSurface, &DDEShellSurface::stateChanged);
+
+    // a state that got toggled back and forth within an update isn't sent at all
+    m_serverShellSurface->beginUpdate();
+    m_serverShellSurface->setKeepAbove(true);
+    m_serverShellSurface->setKeepAbove(false);
+    m_serverShellSurface->endUpdate();
+    m_serverShellSurface->setModal(true);
+
+    QVERIFY(stateChangedSpy.wait());
+    QCOMPARE(stateChangedSpy.count(), 1);
+    QCOMPARE(stateChangedSpy.first().first().value<DDEShellSurface::States>(), DDEShellSurface::States(DDEShellSurface::State::Modal));
+}
+
+QTEST_GUILESS_MAIN(TestDDEShell)
+#include "test_dde_shell.moc"
@@ -0,0 +1,481 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/dmabuf_feedback.h"
+#include "../../src/client/dmabuf_pool.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/linuxdmabufv1clientbuffer.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/surface_interface.h"
+// system
+#include <sys/sysmacros.h>
+
+using namespace KWayland::Client;
+
+// the DRM fourcc codes, see drm_fourcc.h
+static const uint32_t s_argb8888 = 0x34325241;
+static const uint32_t s_xrgb8888 = 0x34325258;
+static const uint32_t s_abgr8888 = 0x34324241;
+static const uint64_t s_invalidModifier = 0x00ffffffffffffffULL;
+
+class TestDmaBufPool : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testFeedback();
+    void testLegacyFormats();
+    void testSurfaceFeedback();
+    void testOutputDevice();
+    void testScanoutFeedback_data();
+    void testScanoutFeedback();
+    void testScanoutFailed();
+
+private:
+    DmaBufPool *createPool(quint32 version);
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWaylandServer::LinuxDmaBufV1ClientBufferIntegration *m_dmabuf = nullptr;
+    dev_t m_mainDevice = 0;
+    ConnectionThread *m_connection = nullptr;
+    EventQueue *m_queue = nullptr;
+    Registry *m_registry = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-dmabuf-pool-0");
+
+void TestDmaBufPool::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+
+    // a device that doesn't exist, the pool can't allocate but gets the formats
+    m_mainDevice = makedev(226, 250);
+    const dev_t mainDevice = m_mainDevice;
+    m_dmabuf = new LinuxDmaBufV1ClientBufferIntegration(m_display);
+    LinuxDmaBufV1Feedback::Tranche first;
+    first.device = mainDevice;
+    first.formatTable = {{s_argb8888, {1, 2}}};
+    LinuxDmaBufV1Feedback::Tranche second;
+    second.device = mainDevice;
+    second.formatTable = {{s_argb8888, {3}}, {s_xrgb8888, {s_invalidModifier}}};
+    LinuxDmaBufV1Feedback::Tranche otherDevice;
+    otherDevice.device = makedev(226, 251);
+    otherDevice.flags = LinuxDmaBufV1Feedback::TrancheFlag::Scanout;
+    otherDevice.formatTable = {{s_abgr8888, {4}}};
+    m_dmabuf->setSupportedFormatsWithModifiers({first, second, otherDevice});
+
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    m_registry->setEventQueue(m_queue);
+    QSignalSpy allAnnounced(m_registry, &Registry::interfacesAnnounced);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnounced.wait());
+}
+
+void TestDmaBufPool::cleanup()
+{
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_dmabuf = nullptr;
+    m_compositorInterface = nullptr;
+}
+
+DmaBufPool *TestDmaBufPool::createPool(quint32 version)
+{
+    const auto dmabuf = m_registry->interface(Registry::Interface::LinuxDmabufV1);
+    if (dmabuf.name == 0 || dmabuf.version < version) {
+        return nullptr;
+    }
+    return m_registry->createDmaBufPool(dmabuf.name, version, this);
+}
+
+static QSet<uint64_t> toSet(const QVector<uint64_t> &modifiers)
+{
+    return QSet<uint64_t>(modifiers.begin(), modifiers.end());
+}
+
+void TestDmaBufPool::testFeedback()
+{
+    QScopedPointer<DmaBufPool> pool(createPool(4));
+    QVERIFY(pool);
+    QVERIFY(pool->isValid());
+    QVERIFY(pool->formats().isEmpty());
+    QSignalSpy formatsChangedSpy(pool.data(), &DmaBufPool::formatsChanged);
+    QVERIFY(formatsChangedSpy.wait());
+
+    // the modifiers of the first tranche win, the tranche of the other device is left out
+    const QHash<uint32_t, QVector<uint64_t>> formats = pool->formats();
+    QCOMPARE(formats.count(), 2);
+    QCOMPARE(toSet(formats.value(s_argb8888)), (QSet<uint64_t>{1, 2}));
+    QCOMPARE(toSet(formats.value(s_xrgb8888)), (QSet<uint64_t>{s_invalidModifier}));
+    QVERIFY(pool->supportsFormat(Buffer::Format::ARGB32));
+    QVERIFY(pool->supportsFormat(Buffer::Format::RGB32));
+
+    // the main device doesn't exist, so nothing can be allocated
+    QVERIFY(!pool->device());
+    QVERIFY(!pool->getBuffer(QSize(24, 24)));
+}
+
+void TestDmaBufPool::testLegacyFormats()
+{
+    QScopedPointer<DmaBufPool> pool(createPool(3));
+    QVERIFY(pool);
+    QSignalSpy formatsChangedSpy(pool.data(), &DmaBufPool::formatsChanged);
+    QVERIFY(formatsChangedSpy.wait());
+
+    // without feedback all formats of all tranches are announced
+    const QHash<uint32_t, QVector<uint64_t>> formats = pool->formats();
+    QCOMPARE(formats.count(), 3);
+    QCOMPARE(toSet(formats.value(s_argb8888)), (QSet<uint64_t>{1, 2, 3}));
+    QCOMPARE(toSet(formats.value(s_xrgb8888)), (QSet<uint64_t>{s_invalidModifier}));
+    QCOMPARE(toSet(formats.value(s_abgr8888)), (QSet<uint64_t>{4}));
+}
+
+void TestDmaBufPool::testSurfaceFeedback()
+{
+    using namespace KWaylandServer;
+    // leave out the scanout tranche of the other device, the default feedback is only rendered
+    LinuxDmaBufV1Feedback::Tranche render;
+    render.device = m_mainDevice;
+    render.formatTable = {{s_argb8888, {1, 2}}, {s_xrgb8888, {s_invalidModifier}}};
+    m_dmabuf->setSupportedFormatsWithModifiers({render});
+
+    const auto compositorInterface = m_registry->interface(Registry::Interface::Compositor);
+    QScopedPointer<Compositor> compositor(m_registry->createCompositor(compositorInterface.name, compositorInterface.version));
+    QScopedPointer<DmaBufPool> pool(createPool(4));
+    QVERIFY(pool);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<DmaBufFeedback> feedback(pool->createSurfaceFeedback(surface.data()));
+    QVERIFY(feedback->isValid());
+    QSignalSpy changedSpy(feedback.data(), &DmaBufFeedback::changed);
+    QSignalSpy scanoutChangedSpy(feedback.data(), &DmaBufFeedback::scanoutChanged);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->mainDevice(), m_mainDevice);
+    QCOMPARE(feedback->tranches().count(), 1);
+    QVERIFY(!feedback->hasScanoutTranche());
+    QVERIFY(scanoutChangedSpy.isEmpty());
+
+    // the surface can be put on a plane, the scanout tranche comes before the default tranches
+    LinuxDmaBufV1Feedback::Tranche scanout;
+    scanout.device = m_mainDevice;
+    scanout.flags = LinuxDmaBufV1Feedback::TrancheFlag::Scanout;
+    scanout.formatTable = {{s_argb8888, {2}}};
+    serverSurface->dmabufFeedbackV1()->setTranches({scanout});
+    QVERIFY(scanoutChangedSpy.wait());
+    QCOMPARE(changedSpy.count(), 2);
+    QVERIFY(feedback->hasScanoutTranche());
+    const QVector<DmaBufFeedback::Tranche> tranches = feedback->tranches();
+    QCOMPARE(tranches.count(), 2);
+    QCOMPARE(tranches.first().device, m_mainDevice);
+    QVERIFY(tranches.first().flags.testFlag(DmaBufFeedback::TrancheFlag::Scanout));
+    const QHash<uint32_t, QVector<uint64_t>> scanoutFormats = feedback->formats(tranches.first());
+    QCOMPARE(scanoutFormats.count(), 1);
+    QCOMPARE(scanoutFormats.value(s_argb8888), QVector<uint64_t>{2});
+    QVERIFY(!tranches.last().flags.testFlag(DmaBufFeedback::TrancheFlag::Scanout));
+    QCOMPARE(feedback->formats(tranches.last()).count(), 2);
+
+    // the surface went back to composition
+    serverSurface->dmabufFeedbackV1()->setTranches({});
+    QVERIFY(scanoutChangedSpy.wait());
+    QCOMPARE(changedSpy.count(), 3);
+    QVERIFY(!feedback->hasScanoutTranche());
+    QCOMPARE(feedback->tranches().count(), 1);
+
+    // the default tranches are the fallback of the surface feedback, it follows their changes
+    render.formatTable = {{s_argb8888, {1, 2}}};
+    m_dmabuf->setSupportedFormatsWithModifiers({render});
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(changedSpy.count(), 4);
+    QCOMPARE(feedback->tranches().count(), 1);
+    QCOMPARE(feedback->formats(feedback->tranches().first()).count(), 1);
+}
+
+void TestDmaBufPool::testOutputDevice()
+{
+    using namespace KWaylandServer;
+    LinuxDmaBufV1Feedback::Tranche render;
+    render.device = m_mainDevice;
+    render.formatTable = {{s_argb8888, {1, 2}}, {s_xrgb8888, {s_invalidModifier}}};
+    m_dmabuf->setSupportedFormatsWithModifiers({render});
+    QScopedPointer<OutputInterface> output(new OutputInterface(m_display));
+
+    const auto compositorInterface = m_registry->interface(Registry::Interface::Compositor);
+    QScopedPointer<Compositor> compositor(m_registry->createCompositor(compositorInterface.name, compositorInterface.version));
+    QScopedPointer<DmaBufPool> pool(createPool(4));
+    QVERIFY(pool);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QScopedPointer<DmaBufFeedback> feedback(pool->createSurfaceFeedback(surface.data()));
+    QSignalSpy changedSpy(feedback.data(), &DmaBufFeedback::changed);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 1);
+
+    // the output is driven by a secondary GPU, only the surfaces on it are told
+    const dev_t secondaryDevice = makedev(226, 251);
+    m_dmabuf->setOutputDevice(output.data(), secondaryDevice, {{s_argb8888, {1}}});
+    serverSurface->setOutputs({output.data()});
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(changedSpy.count(), 2);
+    QVector<DmaBufFeedback::Tranche> tranches = feedback->tranches();
+    QCOMPARE(tranches.count(), 2);
+    QCOMPARE(tranches.first().device, secondaryDevice);
+    QVERIFY(!tranches.first().flags.testFlag(DmaBufFeedback::TrancheFlag::Scanout));
+    QCOMPARE(feedback->formats(tranches.first()).count(), 1);
+    QCOMPARE(tranches.last().device, m_mainDevice);
+
+    // the main device is already the fallback
+    m_dmabuf->setOutputDevice(output.data(), m_mainDevice, {{s_argb8888, {1}}});
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 1);
+
+    // a device whose buffers get copied isn't advertised until it can be imported directly
+    m_dmabuf->setImportCost(secondaryDevice, LinuxDmaBufV1ClientBufferIntegration::ImportCost::Copy);
+    m_dmabuf->setOutputDevice(output.data(), secondaryDevice, {{s_argb8888, {1}}});
+    QVERIFY(!changedSpy.wait(100));
+    QCOMPARE(feedback->tranches().count(), 1);
+    m_dmabuf->setImportCost(secondaryDevice, LinuxDmaBufV1ClientBufferIntegration::ImportCost::Direct);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 2);
+    m_dmabuf->setImportCost(secondaryDevice, LinuxDmaBufV1ClientBufferIntegration::ImportCost::Copy);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 1);
+    m_dmabuf->setImportCost(secondaryDevice, LinuxDmaBufV1ClientBufferIntegration::ImportCost::Direct);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 2);
+
+    // leaving the output drops the tranche as well
+    serverSurface->setOutputs({});
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 1);
+
+    // a removed and added again device works as before
+    m_dmabuf->setOutputDevice(output.data(), 0, {});
+    m_dmabuf->setOutputDevice(output.data(), secondaryDevice, {{s_argb8888, {1}}});
+    serverSurface->setOutputs({output.data()});
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(feedback->tranches().count(), 2);
+}
+
+void TestDmaBufPool::testScanoutFeedback_data()
+{
+    QTest::addColumn<int>("hysteresis");
+
+    QTest::newRow("default") << 0;
+    QTest::newRow("1") << 1;
+    QTest::newRow("5") << 5;
+}
+
+void TestDmaBufPool::testScanoutFeedback()
+{
+    using namespace KWaylandServer;
+    LinuxDmaBufV1Feedback::Tranche render;
+    render.device = m_mainDevice;
+    render.formatTable = {{s_argb8888, {1, 2}}, {s_xrgb8888, {s_invalidModifier}}};
+    m_dmabuf->setSupportedFormatsWithModifiers({render});
+
+    const auto compositorInterface = m_registry->interface(Registry::Interface::Compositor);
+    QScopedPointer<Compositor> compositor(m_registry->createCompositor(compositorInterface.name, compositorInterface.version));
+    QScopedPointer<DmaBufPool> pool(createPool(4));
+    QVERIFY(pool);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QScopedPointer<Surface> otherSurface(compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto otherServerSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+
+    QScopedPointer<DmaBufFeedback> feedback(pool->createSurfaceFeedback(surface.data()));
+    QVERIFY(feedback->isValid());
+    QSignalSpy changedSpy(feedback.data(), &DmaBufFeedback::changed);
+    QSignalSpy scanoutChangedSpy(feedback.data(), &DmaBufFeedback::scanoutChanged);
+    QVERIFY(changedSpy.wait());
+    QVERIFY(!feedback->hasScanoutTranche());
+
+    LinuxDmaBufV1ScanoutFeedback scanoutFeedback;
+    QCOMPARE(scanoutFeedback.hysteresis(), 3);
+    QFETCH(int, hysteresis);
+    if (hysteresis) {
+        scanoutFeedback.setHysteresis(hysteresis);
+        QCOMPARE(scanoutFeedback.hysteresis(), hysteresis);
+    } else {
+        hysteresis = scanoutFeedback.hysteresis();
+    }
+    scanoutFeedback.setScanoutFormats(m_mainDevice, {{s_argb8888, {2}}});
+    QVERIFY(!scanoutFeedback.scanoutSurface());
+
+    // a candidate interrupted by a frame which is composited starts over
+    for (int i = 1; i < hysteresis; ++i) {
+        scanoutFeedback.setScanoutCandidate(serverSurface);
+    }
+    scanoutFeedback.setScanoutCandidate(nullptr);
+    for (int i = 1; i < hysteresis; ++i) {
+        scanoutFeedback.setScanoutCandidate(serverSurface);
+        QVERIFY(!scanoutFeedback.scanoutSurface());
+    }
+    // so does switching to another candidate
+    if (hysteresis > 1) {
+        scanoutFeedback.setScanoutCandidate(otherServerSurface);
+        QVERIFY(!scanoutFeedback.scanoutSurface());
+    }
+    for (int i = 1; i < hysteresis; ++i) {
+        scanoutFeedback.setScanoutCandidate(serverSurface);
+        QVERIFY(!scanoutFeedback.scanoutSurface());
+    }
+    QVERIFY(!changedSpy.wait(100));
+
+    // the surface enters the scanout tranche once it was the candidate for enough frames
+    scanoutFeedback.setScanoutCandidate(serverSurface);
+    QCOMPARE(scanoutFeedback.scanoutSurface(), serverSurface);
+    QVERIFY(scanoutChangedSpy.wait());
+    QCOMPARE(changedSpy.count(), 2);
+    QVERIFY(feedback->hasScanoutTranche());
+    const QVector<DmaBufFeedback::Tranche> tranches = feedback->tranches();
+    QCOMPARE(tranches.count(), 2);
+    QVERIFY(tranches.first().flags.testFlag(DmaBufFeedback::TrancheFlag::Scanout));
+    QCOMPARE(feedback->formats(tranches.first()).value(s_argb8888), QVector<uint64_t>{2});
+
+    // it keeps the tranche while it misses fewer frames
+    for (int i = 1; i < hysteresis; ++i) {
+        scanoutFeedback.setScanoutCandidate(nullptr);
+        QCOMPARE(scanoutFeedback.scanoutSurface(), serverSurface);
+    }
+    scanoutFeedback.setScanoutCandidate(serverSurface);
+    for (int i = 1; i < hysteresis; ++i) {
+        scanoutFeedback.setScanoutCandidate(otherServerSurface);
+        QCOMPARE(scanoutFeedback.scanoutSurface(), serverSurface);
+    }
+    scanoutFeedback.setScanoutCandidate(serverSurface);
+    QVERIFY(!changedSpy.wait(100));
+    QCOMPARE(changedSpy.count(), 2);
+
+    // and leaves it once it missed enough frames
+    for (int i = 1; i < hysteresis; ++i) {
+        scanoutFeedback.setScanoutCandidate(nullptr);
+    }
+    QCOMPARE(scanoutFeedback.scanoutSurface(), serverSurface);
+    scanoutFeedback.setScanoutCandidate(nullptr);
+    QVERIFY(!scanoutFeedback.scanoutSurface());
+    QVERIFY(scanoutChangedSpy.wait());
+    QCOMPARE(changedSpy.count(), 3);
+    QVERIFY(!feedback->hasScanoutTranche());
+    QCOMPARE(feedback->tranches().count(), 1);
+}
+
+void TestDmaBufPool::testScanoutFailed()
+{
+    using namespace KWaylandServer;
+    LinuxDmaBufV1Feedback::Tranche render;
+    render.device = m_mainDevice;
+    render.formatTable = {{s_argb8888, {1, 2}}, {s_xrgb8888, {s_invalidModifier}}};
+    m_dmabuf->setSupportedFormatsWithModifiers({render});
+
+    const auto compositorInterface = m_registry->interface(Registry::Interface::Compositor);
+    QScopedPointer<Compositor> compositor(m_registry->createCompositor(compositorInterface.name, compositorInterface.version));
+    QScopedPointer<DmaBufPool> pool(createPool(4));
+    QVERIFY(pool);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+
+    QScopedPointer<DmaBufFeedback> feedback(pool->createSurfaceFeedback(surface.data()));
+    QVERIFY(feedback->isValid());
+    QSignalSpy changedSpy(feedback.data(), &DmaBufFeedback::changed);
+    QSignalSpy scanoutChangedSpy(feedback.data(), &DmaBufFeedback::scanoutChanged);
+    QVERIFY(changedSpy.wait());
+
+    LinuxDmaBufV1ScanoutFeedback scanoutFeedback;
+    scanoutFeedback.setHysteresis(1);
+    scanoutFeedback.setScanoutFormats(m_mainDevice, {{s_argb8888, {1, 2}}});
+    scanoutFeedback.setScanoutCandidate(serverSurface);
+    QVERIFY(scanoutChangedSpy.wait());
+    QCOMPARE(feedback->formats(feedback->tranches().first()).value(s_argb8888).count(), 2);
+
+    // the format the planes rejected is left out of the scanout tranche
+    scanoutFeedback.scanoutFailed(serverSurface, s_argb8888, 2);
+    QVERIFY(changedSpy.wait());
+    QVERIFY(feedback->hasScanoutTranche());
+    QCOMPARE(feedback->formats(feedback->tranches().first()).value(s_argb8888), QVector<uint64_t>{1});
+
+    // a failure reported again or for another surface changes nothing
+    scanoutFeedback.scanoutFailed(serverSurface, s_argb8888, 2);
+    scanoutFeedback.scanoutFailed(nullptr, s_argb8888, 1);
+    QVERIFY(!changedSpy.wait(100));
+
+    // without any format left the surface gets no scanout tranche, but it stays the scanout surface
+    scanoutFeedback.scanoutFailed(serverSurface, s_argb8888, 1);
+    QVERIFY(scanoutChangedSpy.wait());
+    QVERIFY(!feedback->hasScanoutTranche());
+    QCOMPARE(scanoutFeedback.scanoutSurface(), serverSurface);
+
+    // the rejected formats are forgotten once the surface leaves the scanout
+    scanoutFeedback.setScanoutCandidate(nullptr);
+    QVERIFY(!scanoutFeedback.scanoutSurface());
+    scanoutFeedback.setScanoutCandidate(serverSurface);
+    QVERIFY(scanoutChangedSpy.wait());
+    QCOMPARE(feedback->formats(feedback->tranches().first()).value(s_argb8888).count(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestDmaBufPool)
+#include "test_dmabuf_pool.moc"
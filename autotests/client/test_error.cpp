@@ -32,6 +32,8 @@ private Q_SLOTS:
     void cleanup();
 
     void testMultiplePlasmaShellSurfacesForSurface();
+    void testServerRestart();
+    void testProtocolErrorDoesNotReconnect();
 
 private:
     Display *m_display = nullptr;
@@ -135,5 +137,64 @@ void ErrorTest::testMultiplePlasmaShellSurfacesForSurface()
     wl_surface_destroy(surface);
 }
 
+void ErrorTest::testServerRestart()
+{
+    // the server hanging up is reported as the connection dying, once the server is back it reconnects
+    QSignalSpy errorSpy(m_connection, &ConnectionThread::errorOccurred);
+    QVERIFY(errorSpy.isValid());
+    QSignalSpy connectionDiedSpy(m_connection, &ConnectionThread::connectionDied);
+    QVERIFY(connectionDiedSpy.isValid());
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+
+    delete m_display;
+    m_display = nullptr;
+    m_psi = nullptr;
+    m_ci = nullptr;
+    QVERIFY(connectionDiedSpy.wait());
+    QCOMPARE(errorSpy.count(), 1);
+    QVERIFY(m_connection->hasError());
+    QVERIFY(!m_connection->display());
+    QVERIFY(connectedSpy.isEmpty());
+    m_plasmaShell->destroy();
+    m_compositor->destroy();
+    m_queue->destroy();
+
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    QVERIFY(connectedSpy.wait());
+    QCOMPARE(connectionDiedSpy.count(), 1);
+    QVERIFY(!m_connection->hasError());
+    QVERIFY(m_connection->display());
+
+    // the new connection is usable
+    m_queue->setup(m_connection);
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+}
+
+void ErrorTest::testProtocolErrorDoesNotReconnect()
+{
+    // a protocol error is not a server restart, there is nothing to reconnect to
+    QSignalSpy connectionDiedSpy(m_connection, &ConnectionThread::connectionDied);
+    QVERIFY(connectionDiedSpy.isValid());
+    QSignalSpy errorSpy(m_connection, &ConnectionThread::errorOccurred);
+    QVERIFY(errorSpy.isValid());
+    auto surface = wl_compositor_create_surface(*m_compositor);
+    QScopedPointer<PlasmaShellSurface> shellSurface1(m_plasmaShell->createSurface(surface));
+    QScopedPointer<PlasmaShellSurface> shellSurface2(m_plasmaShell->createSurface(surface));
+    QVERIFY(errorSpy.wait());
+    QCOMPARE(m_connection->errorCode(), EPROTO);
+    QVERIFY(!connectionDiedSpy.wait(100));
+    wl_surface_destroy(surface);
+}
+
 QTEST_GUILESS_MAIN(ErrorTest)
 #include "test_error.moc"
@@ -40,6 +40,7 @@ private Q_SLOTS:
     void testTouch();
     void testKeyboardKeyLinux_data();
     void testKeyboardKeyLinux();
+    void testEvents();
 
 private:
     Display *m_display = nullptr;
@@ -463,5 +464,51 @@ void FakeInputTest::testKeyboardKeyLinux()
     QTEST(releasedSpy.last().first().value<quint32>(), "linuxKey");
 }
 
+void FakeInputTest::testEvents()
+{
+    // this test verifies that a batch of events reaches the server in order
+    QVERIFY(!m_device->isAuthenticated());
+    QSignalSpy motionSpy(m_device, &FakeInputDevice::pointerMotionAbsoluteRequested);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy pressedSpy(m_device, &FakeInputDevice::pointerButtonPressRequested);
+    QVERIFY(pressedSpy.isValid());
+    QSignalSpy releasedSpy(m_device, &FakeInputDevice::pointerButtonReleaseRequested);
+    QVERIFY(releasedSpy.isValid());
+    QSignalSpy keyPressedSpy(m_device, &FakeInputDevice::keyboardKeyPressRequested);
+    QVERIFY(keyPressedSpy.isValid());
+    QSignalSpy touchUpSpy(m_device, &FakeInputDevice::touchUpRequested);
+    QVERIFY(touchUpSpy.isValid());
+
+    using Type = FakeInput::Event::Type;
+    const QVector<FakeInput::Event> events = {
+        {Type::PointerMoveAbsolute, 0, QPointF(10, 20)},
+        {Type::PointerButtonPress, BTN_LEFT, QPointF()},
+        {Type::PointerMoveAbsolute, 0, QPointF(30, 40)},
+        {Type::PointerButtonRelease, BTN_LEFT, QPointF()},
+        {Type::KeyboardKeyPress, KEY_A, QPointF()},
+        {Type::TouchDown, 0, QPointF(1, 2)},
+        {Type::TouchUp, 0, QPointF()},
+    };
+
+    // without an authentication we shouldn't get the signals
+    m_fakeInput->requestEvents(events);
+    QVERIFY(!touchUpSpy.wait(100));
+    QVERIFY(motionSpy.isEmpty());
+    QVERIFY(pressedSpy.isEmpty());
+
+    m_device->setAuthentication(true);
+    m_fakeInput->requestEvents(events);
+    QVERIFY(touchUpSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.first().first().toPointF(), QPointF(10, 20));
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(30, 40));
+    QCOMPARE(pressedSpy.count(), 1);
+    QCOMPARE(pressedSpy.first().first().value<quint32>(), quint32(BTN_LEFT));
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(keyPressedSpy.count(), 1);
+    QCOMPARE(keyPressedSpy.first().first().value<quint32>(), quint32(KEY_A));
+    QCOMPARE(touchUpSpy.count(), 1);
+}
+
 QTEST_GUILESS_MAIN(FakeInputTest)
 #include "test_fake_input.moc"
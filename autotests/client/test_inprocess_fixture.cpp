@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/clientconnection.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputdevice_v2_interface.h"
+#include "../../src/server/surface_interface.h"
+#include "inprocessfixture.h"
+#include "virtualoutputs.h"
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+class TestInProcessFixture : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testAnnounce();
+    void testRoundtrip();
+    void testSteps();
+    void testVirtualOutputs();
+    void testEdid();
+};
+
+void TestInProcessFixture::testAnnounce()
+{
+    InProcessFixture fixture;
+    QVERIFY(fixture.setUp());
+    QVERIFY(fixture.clientConnection());
+    new CompositorInterface(fixture.display(), fixture.display());
+    QVERIFY(fixture.announce());
+    QVERIFY(fixture.registry()->hasInterface(Registry::Interface::Compositor));
+    QCOMPARE(fixture.display()->connections().count(), 1);
+}
+
+void TestInProcessFixture::testRoundtrip()
+{
+    // this test verifies that a roundtrip finishes once the server handled the requests
+    InProcessFixture fixture;
+    QVERIFY(fixture.setUp());
+    auto compositorInterface = new CompositorInterface(fixture.display(), fixture.display());
+    QVERIFY(fixture.announce());
+
+    const auto interface = fixture.registry()->interface(Registry::Interface::Compositor);
+    QScopedPointer<Compositor> compositor(fixture.registry()->createCompositor(interface.name, interface.version));
+    QVERIFY(compositor->isValid());
+
+    SurfaceInterface *serverSurface = nullptr;
+    connect(compositorInterface, &CompositorInterface::surfaceCreated, this, [&serverSurface](SurfaceInterface *surface) {
+        serverSurface = surface;
+    });
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    QVERIFY(fixture.roundtrip());
+    QVERIFY(serverSurface);
+
+    int commits = 0;
+    connect(serverSurface, &SurfaceInterface::committed, this, [&commits]() {
+        commits++;
+    });
+    for (int i = 0; i < 10; ++i) {
+        surface->commit(Surface::CommitFlag::None);
+    }
+    QVERIFY(fixture.roundtrip());
+    QCOMPARE(commits, 10);
+}
+
+void TestInProcessFixture::testSteps()
+{
+    // this test verifies that nothing happens until the test takes the next step
+    InProcessFixture fixture;
+    QVERIFY(fixture.setUp());
+    auto compositorInterface = new CompositorInterface(fixture.display(), fixture.display());
+    QVERIFY(fixture.announce());
+    const auto interface = fixture.registry()->interface(Registry::Interface::Compositor);
+    QScopedPointer<Compositor> compositor(fixture.registry()->createCompositor(interface.name, interface.version));
+
+    int surfaces = 0;
+    connect(compositorInterface, &CompositorInterface::surfaceCreated, this, [&surfaces]() {
+        surfaces++;
+    });
+    QScopedPointer<Surface> surface(compositor->createSurface());
+    fixture.dispatchServer();
+    QCOMPARE(surfaces, 0);
+    fixture.flushClient();
+    QCOMPARE(surfaces, 0);
+    fixture.dispatchServer();
+    QCOMPARE(surfaces, 1);
+}
+
+void TestInProcessFixture::testVirtualOutputs()
+{
+    InProcessFixture fixture;
+    QVERIFY(fixture.setUp());
+    VirtualOutputs outputs(fixture.display());
+    VirtualOutputs::Output *first = outputs.add(QSize(2560, 1440), 144000);
+    VirtualOutputs::Output *second = outputs.add();
+    QVERIFY(fixture.announce());
+    QCOMPARE(fixture.registry()->interfaces(Registry::Interface::Output).count(), 2);
+    QCOMPARE(first->output->globalPosition(), QPoint(0, 0));
+    QCOMPARE(second->output->globalPosition(), QPoint(2560, 0));
+    QCOMPARE(first->device->modes().first()->size(), QSize(2560, 1440));
+    QCOMPARE(first->device->refreshRate(), 144000);
+
+    // the scale moves the outputs closer together in the logical space
+    outputs.setScale(2);
+    QCOMPARE(first->output->scale(), 2);
+    QCOMPARE(second->output->globalPosition(), QPoint(1280, 0));
+
+    // the outputs get a new global on every hotplug
+    outputs.hotplugStorm(3);
+    QCOMPARE(outputs.outputs().count(), 2);
+    QVERIFY(fixture.roundtrip());
+    QCOMPARE(fixture.registry()->interfaces(Registry::Interface::Output).count(), 2);
+    outputs.purge();
+
+    // 144 vblanks of the first and 60 of the second output in a second
+    QCOMPARE(outputs.advance(std::chrono::seconds(1), {}), 204);
+}
+
+void TestInProcessFixture::testEdid()
+{
+    const QByteArray edid = VirtualOutputs::edid(QSize(3840, 2160), 60000, 1);
+    QCOMPARE(edid.size(), 128);
+    QCOMPARE(edid.left(8), QByteArray::fromHex("00ffffffffffff00"));
+    uchar sum = 0;
+    for (char byte : edid) {
+        sum += uchar(byte);
+    }
+    QCOMPARE(sum, uchar(0));
+    QCOMPARE(VirtualOutputs::modeSizes(QSize(1920, 1080)).first(), QSize(1920, 1080));
+    QVERIFY(!VirtualOutputs::modeSizes(QSize(1920, 1080)).contains(QSize(2560, 1440)));
+}
+
+QTEST_GUILESS_MAIN(TestInProcessFixture)
+#include "test_inprocess_fixture.moc"
@@ -0,0 +1,248 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/display.h"
+#include "../../src/server/linuxdmabufv1clientbuffer.h"
+
+#include "qwayland-linux-dmabuf-unstable-v1.h"
+
+#include <atomic>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+
+// the DRM fourcc code of ARGB8888 and DRM_FORMAT_MOD_INVALID, see drm_fourcc.h
+static const uint32_t s_argb8888 = 0x34325241;
+static const uint64_t s_invalidModifier = 0x00ffffffffffffffULL;
+
+class FakeRenderer : public KWaylandServer::LinuxDmaBufV1ClientBufferIntegration::RendererInterface
+{
+public:
+    KWaylandServer::LinuxDmaBufV1ClientBuffer *
+    importBuffer(const QVector<KWaylandServer::LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        importThread = QThread::currentThread();
+        if (fail) {
+            return nullptr;
+        }
+        buffer = new KWaylandServer::LinuxDmaBufV1ClientBuffer(size, format, flags, planes);
+        return buffer;
+    }
+
+    std::atomic<QThread *> importThread{nullptr};
+    std::atomic<KWaylandServer::LinuxDmaBufV1ClientBuffer *> buffer{nullptr};
+    bool fail = false;
+};
+
+class DmaBuf : public QtWayland::zwp_linux_dmabuf_v1
+{
+};
+
+class BufferParams : public QtWayland::zwp_linux_buffer_params_v1
+{
+public:
+    using QtWayland::zwp_linux_buffer_params_v1::zwp_linux_buffer_params_v1;
+
+    ~BufferParams() override
+    {
+        destroy();
+        if (buffer) {
+            wl_buffer_destroy(buffer);
+        }
+    }
+
+    wl_buffer *buffer = nullptr;
+    bool failed = false;
+
+protected:
+    void zwp_linux_buffer_params_v1_created(struct ::wl_buffer *buffer) override
+    {
+        this->buffer = buffer;
+    }
+
+    void zwp_linux_buffer_params_v1_failed() override
+    {
+        failed = true;
+    }
+};
+
+class TestLinuxDmaBuf : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testImport_data();
+    void testImport();
+    void testImportFailed_data();
+    void testImportFailed();
+
+private:
+    BufferParams *createParams();
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::LinuxDmaBufV1ClientBufferIntegration *m_dmabufInterface = nullptr;
+    FakeRenderer m_renderer;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    DmaBuf *m_dmabuf = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-linux-dmabuf-0");
+
+void TestLinuxDmaBuf::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_renderer.importThread = nullptr;
+    m_renderer.buffer = nullptr;
+    m_renderer.fail = false;
+    m_dmabufInterface = new LinuxDmaBufV1ClientBufferIntegration(m_display);
+    m_dmabufInterface->setRendererInterface(&m_renderer);
+    LinuxDmaBufV1Feedback::Tranche tranche;
+    tranche.formatTable = {{s_argb8888, {s_invalidModifier}}};
+    m_dmabufInterface->setSupportedFormatsWithModifiers({tranche});
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    connect(m_registry, &Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("zwp_linux_dmabuf_v1")) {
+            m_dmabuf = new DmaBuf();
+            m_dmabuf->init(*m_registry, id, qMin(version, 3u));
+        }
+    });
+    QSignalSpy allAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_dmabuf);
+}
+
+void TestLinuxDmaBuf::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_dmabuf)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    // these are the children of the display
+    m_dmabufInterface = nullptr;
+}
+
+BufferParams *TestLinuxDmaBuf::createParams()
+{
+    // any file will do, the fake renderer never touches the content
+    const int fd = memfd_create("dmabuf", MFD_CLOEXEC);
+    if (fd == -1 || ftruncate(fd, 4 * 4 * 4) != 0) {
+        return nullptr;
+    }
+    auto params = new BufferParams(m_dmabuf->create_params());
+    params->add(fd, 0, 0, 4 * 4, s_invalidModifier >> 32, s_invalidModifier & 0xffffffff);
+    close(fd);
+    return params;
+}
+
+void TestLinuxDmaBuf::testImport_data()
+{
+    QTest::addColumn<bool>("asynchronous");
+
+    QTest::newRow("synchronous") << false;
+    QTest::newRow("asynchronous") << true;
+}
+
+void TestLinuxDmaBuf::testImport()
+{
+    QFETCH(bool, asynchronous);
+    QVERIFY(!m_dmabufInterface->asynchronousImport());
+    m_dmabufInterface->setAsynchronousImport(asynchronous);
+    QCOMPARE(m_dmabufInterface->asynchronousImport(), asynchronous);
+
+    QScopedPointer<BufferParams> params(createParams());
+    QVERIFY(params);
+    params->create(4, 4, s_argb8888, 0);
+    m_connection->flush();
+    QTRY_VERIFY(params->buffer);
+    QVERIFY(!params->failed);
+
+    // only the asynchronous import leaves the thread of the integration
+    QThread *importThread = m_renderer.importThread;
+    QCOMPARE(importThread != QThread::currentThread(), asynchronous);
+    KWaylandServer::LinuxDmaBufV1ClientBuffer *buffer = m_renderer.buffer;
+    QVERIFY(buffer);
+    QCOMPARE(buffer->thread(), m_dmabufInterface->thread());
+    QCOMPARE(buffer->size(), QSize(4, 4));
+    QCOMPARE(buffer->format(), s_argb8888);
+}
+
+void TestLinuxDmaBuf::testImportFailed_data()
+{
+    QTest::addColumn<bool>("asynchronous");
+
+    QTest::newRow("synchronous") << false;
+    QTest::newRow("asynchronous") << true;
+}
+
+void TestLinuxDmaBuf::testImportFailed()
+{
+    QFETCH(bool, asynchronous);
+    m_dmabufInterface->setAsynchronousImport(asynchronous);
+    m_renderer.fail = true;
+
+    QScopedPointer<BufferParams> params(createParams());
+    QVERIFY(params);
+    params->create(4, 4, s_argb8888, 0);
+    m_connection->flush();
+    QTRY_VERIFY(params->failed);
+    QVERIFY(!params->buffer);
+    QVERIFY(m_renderer.importThread);
+    QVERIFY(!m_connection->hasError());
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDmaBuf)
+#include "test_linux_dmabuf.moc"
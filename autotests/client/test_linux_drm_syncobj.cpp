@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/linuxdrmsyncobj.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/linuxdmabufv1clientbuffer.h"
+#include "../../src/server/linuxdrmsyncobj_v1_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "qwayland-linux-dmabuf-unstable-v1.h"
+
+#include <wayland-client-protocol.h>
+
+#include <cerrno>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+
+// the DRM fourcc code of ARGB8888 and DRM_FORMAT_MOD_INVALID, see drm_fourcc.h
+static const uint32_t s_argb8888 = 0x34325241;
+static const uint64_t s_invalidModifier = 0x00ffffffffffffffULL;
+
+class FakeTimeline : public KWaylandServer::LinuxDrmSyncObjTimelineV1
+{
+public:
+    ~FakeTimeline() override
+    {
+        for (int fd : qAsConst(waiters)) {
+            close(fd);
+        }
+    }
+
+    int createEventFd(quint64 point) override
+    {
+        const int fd = eventfd(0, EFD_CLOEXEC);
+        if (fd == -1) {
+            return -1;
+        }
+        waiters.insert(point, fd);
+        return dup(fd);
+    }
+
+    void signal(quint64 point) override
+    {
+        Q_UNUSED(point)
+    }
+
+    void reach(quint64 point)
+    {
+        const int fd = waiters.take(point);
+        const quint64 value = 1;
+        QCOMPARE(write(fd, &value, sizeof(value)), ssize_t(sizeof(value)));
+        close(fd);
+    }
+
+    QHash<quint64, int> waiters;
+};
+
+class FakeRenderer : public KWaylandServer::LinuxDrmSyncObjV1Interface::RendererInterface,
+                     public KWaylandServer::LinuxDmaBufV1ClientBufferIntegration::RendererInterface
+{
+public:
+    KWaylandServer::LinuxDrmSyncObjTimelineV1 *importTimeline(int fd) override
+    {
+        close(fd);
+        auto timeline = new FakeTimeline;
+        timelines.append(timeline);
+        return timeline;
+    }
+
+    KWaylandServer::LinuxDmaBufV1ClientBuffer *
+    importBuffer(const QVector<KWaylandServer::LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        return new KWaylandServer::LinuxDmaBufV1ClientBuffer(size, format, flags, planes);
+    }
+
+    // owned by the LinuxDrmSyncObjV1Interface
+    QVector<FakeTimeline *> timelines;
+};
+
+class DmaBuf : public QtWayland::zwp_linux_dmabuf_v1
+{
+};
+
+class TestLinuxDrmSyncObj : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testImportTimeline();
+    void testPoints();
+    void testSurfaceExists();
+
+private:
+    wl_buffer *createBuffer();
+    LinuxDrmSyncObjTimeline *importTimeline();
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    FakeRenderer m_renderer;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::LinuxDrmSyncObjManager *m_syncObjManager = nullptr;
+    DmaBuf *m_dmabuf = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-linux-drm-syncobj-0");
+
+void TestLinuxDrmSyncObj::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_renderer.timelines.clear();
+    auto syncObjInterface = new LinuxDrmSyncObjV1Interface(m_display, m_display);
+    syncObjInterface->setRendererInterface(&m_renderer);
+    auto dmabufInterface = new LinuxDmaBufV1ClientBufferIntegration(m_display);
+    dmabufInterface->setRendererInterface(&m_renderer);
+    LinuxDmaBufV1Feedback::Tranche tranche;
+    tranche.formatTable = {{s_argb8888, {s_invalidModifier}}};
+    dmabufInterface->setSupportedFormatsWithModifiers({tranche});
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    connect(m_registry, &Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("zwp_linux_dmabuf_v1")) {
+            m_dmabuf = new DmaBuf();
+            m_dmabuf->init(*m_registry, id, qMin(version, 3u));
+        }
+    });
+    QSignalSpy allAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_dmabuf);
+
+    const auto compositor = m_registry->interface(Registry::Interface::Compositor);
+    m_compositor = m_registry->createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+
+    const auto syncObj = m_registry->interface(Registry::Interface::LinuxDrmSyncObjV1);
+    QVERIFY(syncObj.name != 0);
+    m_syncObjManager = m_registry->createLinuxDrmSyncObjManager(syncObj.name, syncObj.version, this);
+    QVERIFY(m_syncObjManager->isValid());
+    QCOMPARE(m_syncObjManager->eventQueue(), m_queue);
+}
+
+void TestLinuxDrmSyncObj::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_syncObjManager)
+    CLEANUP(m_dmabuf)
+    CLEANUP(m_compositor)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    // these are the children of the display
+    m_compositorInterface = nullptr;
+}
+
+wl_buffer *TestLinuxDrmSyncObj::createBuffer()
+{
+    // any file will do, the fake renderer never touches the content
+    const int fd = memfd_create("dmabuf", MFD_CLOEXEC);
+    if (fd == -1 || ftruncate(fd, 4 * 4 * 4) != 0) {
+        return nullptr;
+    }
+    QtWayland::zwp_linux_buffer_params_v1 params(m_dmabuf->create_params());
+    params.add(fd, 0, 0, 4 * 4, s_invalidModifier >> 32, s_invalidModifier & 0xffffffff);
+    close(fd);
+    wl_buffer *buffer = params.create_immed(4, 4, s_argb8888, 0);
+    params.destroy();
+    return buffer;
+}
+
+LinuxDrmSyncObjTimeline *TestLinuxDrmSyncObj::importTimeline()
+{
+    // the manager doesn't take over the descriptor
+    const int fd = eventfd(0, EFD_CLOEXEC);
+    LinuxDrmSyncObjTimeline *timeline = m_syncObjManager->importTimeline(fd, this);
+    close(fd);
+    return timeline;
+}
+
+void TestLinuxDrmSyncObj::testImportTimeline()
+{
+    QScopedPointer<LinuxDrmSyncObjTimeline> timeline(importTimeline());
+    QVERIFY(timeline->isValid());
+    m_connection->flush();
+    QTRY_COMPARE(m_renderer.timelines.count(), 1);
+}
+
+void TestLinuxDrmSyncObj::testPoints()
+{
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+
+    QScopedPointer<LinuxDrmSyncObjSurface> syncObjSurface(m_syncObjManager->getSurface(surface.data()));
+    QVERIFY(syncObjSurface->isValid());
+    QScopedPointer<LinuxDrmSyncObjTimeline> timeline(importTimeline());
+    QTRY_COMPARE(m_renderer.timelines.count(), 1);
+    FakeTimeline *serverTimeline = m_renderer.timelines.first();
+
+    // the points are split into their high and low 32 bits
+    const quint64 acquirePoint = (quint64(1) << 32) | 2;
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    wl_buffer *buffer = createBuffer();
+    QVERIFY(buffer);
+    surface->attachBuffer(buffer);
+    syncObjSurface->setAcquirePoint(timeline.data(), acquirePoint);
+    syncObjSurface->setReleasePoint(timeline.data(), acquirePoint + 1);
+    surface->commit(Surface::CommitFlag::None);
+    QTRY_COMPARE(serverTimeline->waiters.count(), 1);
+    QVERIFY(serverTimeline->waiters.contains(acquirePoint));
+    QVERIFY(committedSpy.isEmpty());
+
+    serverTimeline->reach(acquirePoint);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->buffer());
+}
+
+void TestLinuxDrmSyncObj::testSurfaceExists()
+{
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QScopedPointer<LinuxDrmSyncObjSurface> syncObjSurface(m_syncObjManager->getSurface(surface.data()));
+    QVERIFY(syncObjSurface->isValid());
+
+    // a surface has one synchronization object at most
+    QSignalSpy errorSpy(m_connection, &ConnectionThread::errorOccurred);
+    QScopedPointer<LinuxDrmSyncObjSurface> second(m_syncObjManager->getSurface(surface.data()));
+    QVERIFY(errorSpy.wait());
+    QVERIFY(m_connection->hasError());
+    QCOMPARE(m_connection->errorCode(), EPROTO);
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDrmSyncObj)
+#include "test_linux_drm_syncobj.moc"
@@ -32,12 +32,15 @@ private Q_SLOTS:
 
     void testCreate();
     void testSetRows();
+    void testUpdate();
+    void testSaveRestoreState();
     void testConnectNewClient();
     void testDestroy();
     void testActivate();
 
     void testEnterLeaveDesktop();
     void testAllDesktops();
+    void testSetDesktops();
     void testCreateRequested();
     void testRemoveRequested();
 
@@ -257,6 +260,84 @@ void TestVirtualDesktop::testSetRows()
     QCOMPARE(m_plasmaVirtualDesktopManagement->rows(), 3);
 }
 
+void TestVirtualDesktop::testUpdate()
+{
+    testCreate();
+
+    QSignalSpy desktopCreatedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::desktopCreated);
+    QSignalSpy desktopRemovedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::desktopRemoved);
+    QSignalSpy rowsChangedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::rowsChanged);
+    QSignalSpy managementDoneSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::done);
+
+    // only the final layout reaches the client
+    m_plasmaVirtualDesktopManagementInterface->beginUpdate();
+    m_plasmaVirtualDesktopManagementInterface->createDesktop(QStringLiteral("0-4"));
+    m_plasmaVirtualDesktopManagementInterface->createDesktop(QStringLiteral("temporary"), 0);
+    m_plasmaVirtualDesktopManagementInterface->setRows(2);
+    m_plasmaVirtualDesktopManagementInterface->sendDone();
+    m_plasmaVirtualDesktopManagementInterface->removeDesktop(QStringLiteral("temporary"));
+    m_plasmaVirtualDesktopManagementInterface->setRows(4);
+    m_plasmaVirtualDesktopManagementInterface->sendDone();
+    m_plasmaVirtualDesktopManagementInterface->endUpdate();
+
+    QVERIFY(managementDoneSpy.wait());
+    QCOMPARE(managementDoneSpy.count(), 1);
+    QCOMPARE(desktopCreatedSpy.count(), 1);
+    QCOMPARE(desktopCreatedSpy.first().at(0).toString(), QStringLiteral("0-4"));
+    QCOMPARE(desktopCreatedSpy.first().at(1).toUInt(), 3u);
+    QVERIFY(desktopRemovedSpy.isEmpty());
+    QCOMPARE(rowsChangedSpy.count(), 1);
+    QCOMPARE(m_plasmaVirtualDesktopManagement->rows(), 4);
+    QCOMPARE(m_plasmaVirtualDesktopManagement->desktops().length(), 4);
+    for (int i = 0; i < m_plasmaVirtualDesktopManagement->desktops().length(); ++i) {
+        QCOMPARE(m_plasmaVirtualDesktopManagementInterface->desktops().at(i)->id(), m_plasmaVirtualDesktopManagement->desktops().at(i)->id());
+    }
+}
+
+void TestVirtualDesktop::testSaveRestoreState()
+{
+    using namespace KWaylandServer;
+    // rebuild some desktops
+    testCreate();
+    m_plasmaVirtualDesktopManagementInterface->setRows(2);
+    m_plasmaVirtualDesktopManagementInterface->desktop(QStringLiteral("0-1"))->setActive(false);
+    m_plasmaVirtualDesktopManagementInterface->desktop(QStringLiteral("0-2"))->setActive(true);
+    const QByteArray state = m_plasmaVirtualDesktopManagementInterface->saveState();
+
+    // a new instance gets the same layout
+    PlasmaVirtualDesktopManagementInterface restored(m_display);
+    QVERIFY(!restored.restoreState(QByteArrayLiteral("no state")));
+    QVERIFY(restored.desktops().isEmpty());
+    QVERIFY(restored.restoreState(state));
+    QCOMPARE(restored.desktops().count(), 3);
+    for (int i = 0; i < 3; ++i) {
+        const PlasmaVirtualDesktopInterface *original = m_plasmaVirtualDesktopManagementInterface->desktops().at(i);
+        const PlasmaVirtualDesktopInterface *desktop = restored.desktops().at(i);
+        QCOMPARE(desktop->id(), original->id());
+        QCOMPARE(desktop->name(), original->name());
+        QCOMPARE(desktop->isActive(), original->isActive());
+    }
+    QCOMPARE(restored.saveState(), state);
+
+    // restoring changes only what differs, the clients get it as one update
+    m_plasmaVirtualDesktopManagementInterface->removeDesktop(QStringLiteral("0-3"));
+    m_plasmaVirtualDesktopManagementInterface->createDesktop(QStringLiteral("0-4"));
+    m_plasmaVirtualDesktopManagementInterface->sendDone();
+    QSignalSpy managementDoneSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::done);
+    QVERIFY(managementDoneSpy.wait());
+    QSignalSpy desktopCreatedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::desktopCreated);
+    QSignalSpy desktopRemovedSpy(m_plasmaVirtualDesktopManagement, &PlasmaVirtualDesktopManagement::desktopRemoved);
+    QVERIFY(m_plasmaVirtualDesktopManagementInterface->restoreState(state));
+    QVERIFY(managementDoneSpy.wait());
+    QCOMPARE(desktopRemovedSpy.count(), 1);
+    QCOMPARE(desktopRemovedSpy.first().first().toString(), QStringLiteral("0-4"));
+    QCOMPARE(desktopCreatedSpy.count(), 1);
+    QCOMPARE(desktopCreatedSpy.first().first().toString(), QStringLiteral("0-3"));
+    QCOMPARE(desktopCreatedSpy.first().at(1).toUInt(), 2u);
+    QCOMPARE(m_plasmaVirtualDesktopManagement->desktops().count(), 3);
+    QCOMPARE(m_plasmaVirtualDesktopManagementInterface->saveState(), state);
+}
+
 void TestVirtualDesktop::testConnectNewClient()
 {
     // rebuild some desktops
@@ -469,6 +550,39 @@ void TestVirtualDesktop::testAllDesktops()
     QVERIFY(!m_window->isOnAllDesktops());
 }
 
+void TestVirtualDesktop::testSetDesktops()
+{
+    testCreate();
+
+    QSignalSpy virtualDesktopEnteredSpy(m_window, &KWayland::Client::PlasmaWindow::plasmaVirtualDesktopEntered);
+    QSignalSpy virtualDesktopLeftSpy(m_window, &KWayland::Client::PlasmaWindow::plasmaVirtualDesktopLeft);
+
+    m_windowInterface->setPlasmaVirtualDesktops({QStringLiteral("0-1"), QStringLiteral("0-3")});
+    QCOMPARE(m_windowInterface->plasmaVirtualDesktops(), QStringList({QStringLiteral("0-1"), QStringLiteral("0-3")}));
+    QVERIFY(virtualDesktopEnteredSpy.wait());
+    QTRY_COMPARE(virtualDesktopEnteredSpy.count(), 2);
+    QCOMPARE(m_window->plasmaVirtualDesktops().length(), 2);
+
+    // only the difference is sent
+    virtualDesktopEnteredSpy.clear();
+    m_windowInterface->setPlasmaVirtualDesktops({QStringLiteral("0-3"), QStringLiteral("0-2")});
+    QVERIFY(virtualDesktopLeftSpy.wait());
+    QTRY_COMPARE(virtualDesktopEnteredSpy.count(), 1);
+    QCOMPARE(virtualDesktopEnteredSpy.first().at(0).toString(), QStringLiteral("0-2"));
+    QCOMPARE(virtualDesktopLeftSpy.count(), 1);
+    QCOMPARE(virtualDesktopLeftSpy.first().at(0).toString(), QStringLiteral("0-1"));
+    QCOMPARE(m_window->plasmaVirtualDesktops().length(), 2);
+    QVERIFY(!m_window->isOnAllDesktops());
+
+    // no desktops means all of them
+    virtualDesktopLeftSpy.clear();
+    m_windowInterface->setPlasmaVirtualDesktops({});
+    QVERIFY(virtualDesktopLeftSpy.wait());
+    QTRY_COMPARE(virtualDesktopLeftSpy.count(), 2);
+    QVERIFY(m_windowInterface->plasmaVirtualDesktops().isEmpty());
+    QTRY_VERIFY(m_window->isOnAllDesktops());
+}
+
 void TestVirtualDesktop::testCreateRequested()
 {
     // rebuild some desktops
@@ -34,6 +34,7 @@ private Q_SLOTS:
     void testPanelBehavior_data();
     void testPanelBehavior();
     void testAutoHidePanel();
+    void testChangedOnCommit();
     void testPanelTakesFocus();
     void testDisconnect();
     void testWhileDestroying();
@@ -412,6 +413,45 @@ void TestPlasmaShell::testAutoHidePanel()
     QVERIFY(errorSpy.wait());
 }
 
+void TestPlasmaShell::testChangedOnCommit()
+{
+    qRegisterMetaType<PlasmaShellSurfaceInterface::Changes>();
+    // this test verifies that the properties a panel sets together are applied at once
+    QSignalSpy plasmaSurfaceCreatedSpy(m_plasmaShellInterface, &PlasmaShellInterface::surfaceCreated);
+    QVERIFY(plasmaSurfaceCreatedSpy.isValid());
+
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QScopedPointer<PlasmaShellSurface> ps(m_plasmaShell->createSurface(s.data()));
+    QVERIFY(plasmaSurfaceCreatedSpy.wait());
+    auto sps = plasmaSurfaceCreatedSpy.first().first().value<PlasmaShellSurfaceInterface *>();
+    QVERIFY(sps);
+
+    QSignalSpy changedSpy(sps, &PlasmaShellSurfaceInterface::changed);
+    QVERIFY(changedSpy.isValid());
+    QSignalSpy roleChangedSpy(sps, &PlasmaShellSurfaceInterface::roleChanged);
+    QVERIFY(roleChangedSpy.isValid());
+    ps->setRole(PlasmaShellSurface::Role::Panel);
+    ps->setPosition(QPoint(10, 20));
+    ps->setPanelBehavior(PlasmaShellSurface::PanelBehavior::AutoHide);
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.first().first().value<PlasmaShellSurfaceInterface::Changes>(),
+             PlasmaShellSurfaceInterface::Change::Position | PlasmaShellSurfaceInterface::Change::Role | PlasmaShellSurfaceInterface::Change::PanelBehavior);
+    QCOMPARE(roleChangedSpy.count(), 1);
+    QCOMPARE(sps->role(), PlasmaShellSurfaceInterface::Role::Panel);
+    QCOMPARE(sps->position(), QPoint(10, 20));
+    QCOMPARE(sps->panelBehavior(), PlasmaShellSurfaceInterface::PanelBehavior::AutoHide);
+
+    // setting the current values again doesn't change anything
+    ps->setPosition(QPoint(10, 20));
+    ps->setPanelBehavior(PlasmaShellSurface::PanelBehavior::WindowsCanCover);
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(changedSpy.last().first().value<PlasmaShellSurfaceInterface::Changes>(), PlasmaShellSurfaceInterface::Change::PanelBehavior);
+}
+
 void TestPlasmaShell::testPanelTakesFocus()
 {
     // this test verifies that whether a panel wants to take focus is passed through correctly
@@ -11,8 +11,10 @@
 #include "../../src/client/event_queue.h"
 #include "../../src/client/pointer.h"
 #include "../../src/client/pointerconstraints.h"
+#include "../../src/client/region.h"
 #include "../../src/client/registry.h"
 #include "../../src/client/seat.h"
+#include "../../src/client/shm_pool.h"
 #include "../../src/client/surface.h"
 // server
 #include "../../src/server/compositor_interface.h"
@@ -40,6 +42,7 @@ private Q_SLOTS:
 
     void testConfinePointer_data();
     void testConfinePointer();
+    void testConstrainPosition();
     void testAlreadyConstrained_data();
     void testAlreadyConstrained();
 
@@ -52,6 +55,7 @@ private:
     QThread *m_thread = nullptr;
     EventQueue *m_queue = nullptr;
     Compositor *m_compositor = nullptr;
+    ShmPool *m_shm = nullptr;
     Seat *m_seat = nullptr;
     Pointer *m_pointer = nullptr;
     PointerConstraints *m_pointerConstraints = nullptr;
@@ -104,6 +108,9 @@ void TestPointerConstraints::init()
     QVERIFY(m_compositor);
     QVERIFY(m_compositor->isValid());
 
+    m_shm = registry.createShmPool(registry.interface(Registry::Interface::Shm).name, registry.interface(Registry::Interface::Shm).version, this);
+    QVERIFY(m_shm->isValid());
+
     m_pointerConstraints = registry.createPointerConstraints(registry.interface(Registry::Interface::PointerConstraintsUnstableV1).name,
                                                              registry.interface(Registry::Interface::PointerConstraintsUnstableV1).version,
                                                              this);
@@ -128,6 +135,7 @@ void TestPointerConstraints::cleanup()
         variable = nullptr;                                                                                                                                    \
     }
     CLEANUP(m_compositor)
+    CLEANUP(m_shm)
     CLEANUP(m_pointerConstraints)
     CLEANUP(m_pointer)
     CLEANUP(m_seat)
@@ -362,6 +370,65 @@ void TestPointerConstraints::testConfinePointer()
     QCOMPARE(pointerConstraintsChangedSpy.count(), 2);
 }
 
+void TestPointerConstraints::testConstrainPosition()
+{
+    // this test verifies that the server clamps positions to the effective confinement region
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surface->isValid());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(image.rect());
+
+    QSignalSpy pointerConstraintsChangedSpy(serverSurface, &SurfaceInterface::pointerConstraintsChanged);
+    QVERIFY(pointerConstraintsChangedSpy.isValid());
+    QScopedPointer<ConfinedPointer> confinedPointer(
+        m_pointerConstraints->confinePointer(surface.data(), m_pointer, nullptr, PointerConstraints::LifeTime::Persistent));
+    QVERIFY(pointerConstraintsChangedSpy.wait());
+    auto serverConfinedPointer = serverSurface->confinedPointer();
+    QVERIFY(serverConfinedPointer);
+
+    QSignalSpy regionChangedSpy(serverConfinedPointer, &ConfinedPointerV1Interface::regionChanged);
+    QVERIFY(regionChangedSpy.isValid());
+    confinedPointer->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 10).united(QRect(50, 50, 20, 20)), m_compositor));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(regionChangedSpy.wait());
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), QRegion(0, 0, 10, 10).united(QRect(50, 50, 20, 20)));
+
+    // positions inside of the region are not changed
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(5, 5)), QPointF(5, 5));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(55.5, 60.25)), QPointF(55.5, 60.25));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(9.5, 9.5)), QPointF(9.5, 9.5));
+    // others are moved to the closest rectangle
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(30, 5)), QPointF(9, 5));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(-5, -5)), QPointF(0, 0));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(200, 60)), QPointF(69, 60));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(40, 45)), QPointF(50, 50));
+
+    // the input region of the surface limits the effective region
+    QSignalSpy inputChangedSpy(serverSurface, &SurfaceInterface::inputChanged);
+    QVERIFY(inputChangedSpy.isValid());
+    surface->setInputRegion(m_compositor->createRegion(QRegion(0, 0, 5, 5)).get());
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(inputChangedSpy.wait());
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), QRegion(0, 0, 5, 5));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(8, 8)), QPointF(4, 4));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(60, 60)), QPointF(4, 4));
+
+    // without a region the input region is used
+    confinedPointer->setRegion(nullptr);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(regionChangedSpy.wait());
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), QRegion(0, 0, 5, 5));
+    QCOMPARE(serverConfinedPointer->constrainPosition(QPointF(2, 10)), QPointF(2, 4));
+}
+
 enum class Constraint {
     Lock,
     Confine,
@@ -0,0 +1,303 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/frame_scheduler.h"
+#include "../../src/client/output.h"
+#include "../../src/client/presentationtime.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/presentationtime_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include <time.h>
+
+using namespace std::chrono_literals;
+
+class TestPresentationTime : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testClockId();
+    void testPresented();
+    void testDiscardedWhenSuperseded();
+    void testDiscardPresentation();
+    void testFrameScheduler();
+    void testFrameSchedulerOutput();
+
+private:
+    KWaylandServer::SurfaceInterface *createSurface();
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWaylandServer::OutputInterface *m_outputInterface = nullptr;
+    KWaylandServer::PresentationTimeInterface *m_presentationTimeInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Output *m_output = nullptr;
+    KWayland::Client::PresentationTime *m_presentationTime = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-presentation-time-0");
+
+void TestPresentationTime::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_outputInterface = new OutputInterface(m_display, m_display);
+    m_outputInterface->setMode(QSize(1024, 768), 60000);
+    m_presentationTimeInterface = new PresentationTimeInterface(m_display, m_display);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy allAnnounced(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+
+    const auto compositor = registry.interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry.createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+
+    const auto output = registry.interface(KWayland::Client::Registry::Interface::Output);
+    m_output = registry.createOutput(output.name, output.version, this);
+    QVERIFY(m_output->isValid());
+    QSignalSpy outputChangedSpy(m_output, &KWayland::Client::Output::changed);
+    QVERIFY(outputChangedSpy.wait());
+
+    const auto presentationTime = registry.interface(KWayland::Client::Registry::Interface::PresentationTime);
+    QVERIFY(presentationTime.name != 0);
+    m_presentationTime = registry.createPresentationTime(presentationTime.name, presentationTime.version, this);
+    QVERIFY(m_presentationTime->isValid());
+}
+
+void TestPresentationTime::cleanup()
+{
+    delete m_surface;
+    m_surface = nullptr;
+    delete m_presentationTime;
+    m_presentationTime = nullptr;
+    delete m_output;
+    m_output = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_compositorInterface = nullptr;
+    m_outputInterface = nullptr;
+    m_presentationTimeInterface = nullptr;
+}
+
+KWaylandServer::SurfaceInterface *TestPresentationTime::createSurface()
+{
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    if (!serverSurfaceCreated.wait()) {
+        return nullptr;
+    }
+    return serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+}
+
+void TestPresentationTime::testClockId()
+{
+    if (m_presentationTime->clockId() == -1) {
+        QSignalSpy clockIdChangedSpy(m_presentationTime, &KWayland::Client::PresentationTime::clockIdChanged);
+        QVERIFY(clockIdChangedSpy.wait());
+    }
+    QCOMPARE(m_presentationTime->clockId(), qint32(CLOCK_MONOTONIC));
+}
+
+void TestPresentationTime::testPresented()
+{
+    using namespace KWaylandServer;
+    SurfaceInterface *serverSurface = createSurface();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<KWayland::Client::PresentationFeedback> feedback(m_presentationTime->createFeedback(m_surface));
+    QVERIFY(feedback->isValid());
+    QSignalSpy presentedSpy(feedback.data(), &KWayland::Client::PresentationFeedback::presented);
+    QSignalSpy discardedSpy(feedback.data(), &KWayland::Client::PresentationFeedback::discarded);
+    QVERIFY(!serverSurface->hasPresentationFeedback());
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->hasPresentationFeedback());
+
+    const quint64 sequence = (quint64(3) << 32) | 7;
+    serverSurface->presented(m_outputInterface,
+                             std::chrono::seconds((qint64(1) << 32) + 5) + 1234ns,
+                             16666667ns,
+                             sequence,
+                             PresentationTimeInterface::Kind::Vsync | PresentationTimeInterface::Kind::HwCompletion);
+    QVERIFY(!serverSurface->hasPresentationFeedback());
+    QVERIFY(presentedSpy.wait());
+    QVERIFY(discardedSpy.isEmpty());
+    QVERIFY(!feedback->isValid());
+
+    QCOMPARE(feedback->timestamp(), std::chrono::seconds((qint64(1) << 32) + 5) + 1234ns);
+    QCOMPARE(feedback->refresh(), 16666667ns);
+    QCOMPARE(feedback->sequence(), sequence);
+    QCOMPARE(feedback->kinds(), KWayland::Client::PresentationFeedback::Kind::Vsync | KWayland::Client::PresentationFeedback::Kind::HwCompletion);
+    QCOMPARE(feedback->syncOutput(), m_output);
+}
+
+void TestPresentationTime::testDiscardedWhenSuperseded()
+{
+    using namespace KWaylandServer;
+    SurfaceInterface *serverSurface = createSurface();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<KWayland::Client::PresentationFeedback> first(m_presentationTime->createFeedback(m_surface));
+    QSignalSpy firstDiscardedSpy(first.data(), &KWayland::Client::PresentationFeedback::discarded);
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    QScopedPointer<KWayland::Client::PresentationFeedback> second(m_presentationTime->createFeedback(m_surface));
+    QSignalSpy secondPresentedSpy(second.data(), &KWayland::Client::PresentationFeedback::presented);
+    QSignalSpy secondDiscardedSpy(second.data(), &KWayland::Client::PresentationFeedback::discarded);
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    // the first content update never got presented
+    QVERIFY(firstDiscardedSpy.wait());
+    QVERIFY(!first->isValid());
+    if (committedSpy.count() < 2) {
+        QVERIFY(committedSpy.wait());
+    }
+    QVERIFY(serverSurface->hasPresentationFeedback());
+
+    serverSurface->presented(m_outputInterface, 1s, 0ns, 0, PresentationTimeInterface::Kinds());
+    QVERIFY(secondPresentedSpy.wait());
+    QVERIFY(secondDiscardedSpy.isEmpty());
+    QCOMPARE(second->timestamp(), std::chrono::nanoseconds(1s));
+    QCOMPARE(second->refresh(), 0ns);
+}
+
+void TestPresentationTime::testDiscardPresentation()
+{
+    using namespace KWaylandServer;
+    SurfaceInterface *serverSurface = createSurface();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<KWayland::Client::PresentationFeedback> feedback(m_presentationTime->createFeedback(m_surface));
+    QSignalSpy presentedSpy(feedback.data(), &KWayland::Client::PresentationFeedback::presented);
+    QSignalSpy discardedSpy(feedback.data(), &KWayland::Client::PresentationFeedback::discarded);
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->hasPresentationFeedback());
+
+    serverSurface->discardPresentation();
+    QVERIFY(!serverSurface->hasPresentationFeedback());
+    QVERIFY(discardedSpy.wait());
+    QVERIFY(presentedSpy.isEmpty());
+    QVERIFY(!feedback->isValid());
+}
+
+void TestPresentationTime::testFrameScheduler()
+{
+    KWayland::Client::FrameScheduler scheduler;
+    QSignalSpy refreshIntervalChangedSpy(&scheduler, &KWayland::Client::FrameScheduler::refreshIntervalChanged);
+    QCOMPARE(scheduler.refreshRate(), 60000);
+
+    scheduler.setRefreshRate(50000);
+    QCOMPARE(refreshIntervalChangedSpy.count(), 1);
+    QCOMPARE(scheduler.refreshInterval(), std::chrono::nanoseconds(20ms));
+    // without a presentation the next frame is a refresh cycle away
+    QCOMPARE(scheduler.lastPresentation(), 0ns);
+    QCOMPARE(scheduler.nextPresentation(5ms), std::chrono::nanoseconds(25ms));
+
+    scheduler.presented(100ms);
+    QCOMPARE(scheduler.lastPresentation(), std::chrono::nanoseconds(100ms));
+    QCOMPARE(scheduler.nextPresentation(105ms), std::chrono::nanoseconds(120ms));
+    QCOMPARE(scheduler.nextPresentation(120ms), std::chrono::nanoseconds(140ms));
+    // missed refresh cycles are skipped
+    QCOMPARE(scheduler.nextPresentation(181ms), std::chrono::nanoseconds(200ms));
+
+    // the interval reported by the compositor takes precedence
+    scheduler.presented(200ms, 8ms);
+    QCOMPARE(refreshIntervalChangedSpy.count(), 2);
+    QCOMPARE(scheduler.refreshInterval(), std::chrono::nanoseconds(8ms));
+    QCOMPARE(scheduler.nextPresentation(203ms), std::chrono::nanoseconds(208ms));
+
+    scheduler.reset();
+    QCOMPARE(scheduler.lastPresentation(), 0ns);
+    QCOMPARE(scheduler.nextPresentation(203ms), std::chrono::nanoseconds(211ms));
+}
+
+void TestPresentationTime::testFrameSchedulerOutput()
+{
+    KWayland::Client::FrameScheduler scheduler;
+    scheduler.setRefreshRate(50000);
+    QSignalSpy refreshIntervalChangedSpy(&scheduler, &KWayland::Client::FrameScheduler::refreshIntervalChanged);
+
+    scheduler.setOutput(m_output);
+    QCOMPARE(scheduler.refreshRate(), 60000);
+    QCOMPARE(refreshIntervalChangedSpy.count(), 1);
+    QCOMPARE(scheduler.refreshInterval(), std::chrono::nanoseconds(16666666));
+
+    // a mode change of the output is followed
+    m_outputInterface->setMode(QSize(1024, 768), 90000);
+    m_outputInterface->done();
+    QVERIFY(refreshIntervalChangedSpy.wait());
+    QCOMPARE(scheduler.refreshRate(), 90000);
+    QCOMPARE(scheduler.refreshInterval(), std::chrono::nanoseconds(11111111));
+
+    // and no longer once the output is unset
+    scheduler.setOutput(nullptr);
+    m_outputInterface->setMode(QSize(1024, 768), 60000);
+    m_outputInterface->done();
+    QSignalSpy outputChangedSpy(m_output, &KWayland::Client::Output::changed);
+    QVERIFY(outputChangedSpy.wait());
+    QCOMPARE(scheduler.refreshRate(), 90000);
+}
+
+QTEST_GUILESS_MAIN(TestPresentationTime)
+#include "test_presentation_time.moc"
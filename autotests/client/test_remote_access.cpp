@@ -0,0 +1,275 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/remote_access.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/remote_access_interface.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+Q_DECLARE_METATYPE(const BufferHandle *)
+
+class TestRemoteAccess : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testSendReleased();
+    void testNotBound();
+    void testHeldBufferLimit();
+    void testSendHeldFd();
+    void testReleaseOnDestroy();
+
+private:
+    BufferHandle *createBuffer();
+    void trackRemoteBuffers();
+
+    // the buffers announced to the client
+    QVector<const RemoteBuffer *> m_remoteBuffers;
+    QVector<const void *> m_remoteOutputs;
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::OutputInterface *m_outputInterface = nullptr;
+    KWaylandServer::RemoteAccessManagerInterface *m_remoteAccessInterface = nullptr;
+    QVector<BufferHandle *> m_buffers;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::Output *m_output = nullptr;
+    KWayland::Client::RemoteAccessManager *m_remoteAccess = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-remote-access-0");
+
+void TestRemoteAccess::init()
+{
+    qRegisterMetaType<const BufferHandle *>();
+    m_display = new KWaylandServer::Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_outputInterface = new OutputInterface(m_display, m_display);
+    m_outputInterface->setMode(QSize(1024, 768), 60000);
+    m_remoteAccessInterface = new RemoteAccessManagerInterface(m_display);
+    QVERIFY(!m_remoteAccessInterface->isBound());
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    QSignalSpy allAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    const auto output = m_registry->interface(Registry::Interface::Output);
+    m_output = m_registry->createOutput(output.name, output.version, this);
+    QVERIFY(m_output->isValid());
+    QSignalSpy outputChangedSpy(m_output, &Output::changed);
+    QVERIFY(outputChangedSpy.wait());
+
+    const auto remoteAccess = m_registry->interface(Registry::Interface::RemoteAccessManager);
+    QVERIFY(remoteAccess.name != 0);
+    m_remoteAccess = m_registry->createRemoteAccessManager(remoteAccess.name, remoteAccess.version, this);
+    QVERIFY(m_remoteAccess->isValid());
+    QTRY_VERIFY(m_remoteAccessInterface->isBound());
+}
+
+void TestRemoteAccess::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_remoteAccess)
+    CLEANUP(m_output)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_remoteAccessInterface)
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    for (BufferHandle *buffer : qAsConst(m_buffers)) {
+        close(buffer->fd());
+        delete buffer;
+    }
+    m_buffers.clear();
+    m_remoteBuffers.clear();
+    m_remoteOutputs.clear();
+
+    // these are the children of the display
+    m_outputInterface = nullptr;
+}
+
+BufferHandle *TestRemoteAccess::createBuffer()
+{
+    // the fd is the id of the buffer, so every buffer needs a file of its own
+    auto buffer = new BufferHandle;
+    buffer->setFd(memfd_create("remote-buffer", MFD_CLOEXEC));
+    buffer->setSize(1024, 768);
+    buffer->setStride(1024 * 4);
+    buffer->setFormat(0x34325241);
+    m_buffers << buffer;
+    return buffer;
+}
+
+void TestRemoteAccess::trackRemoteBuffers()
+{
+    connect(m_remoteAccess, &RemoteAccessManager::bufferReady, this, [this](const void *output, const RemoteBuffer *remoteBuffer) {
+        m_remoteOutputs << output;
+        m_remoteBuffers << remoteBuffer;
+    });
+}
+
+void TestRemoteAccess::testSendReleased()
+{
+    trackRemoteBuffers();
+    QSignalSpy releasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    const BufferHandle *buffer = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, buffer);
+    QTRY_COMPARE(m_remoteBuffers.count(), 1);
+    QCOMPARE(m_remoteOutputs.first(), static_cast<const void *>(static_cast<wl_output *>(*m_output)));
+
+    const RemoteBuffer *remoteBuffer = m_remoteBuffers.first();
+    // the client requests the parameters right away
+    QTRY_COMPARE(remoteBuffer->width(), 1024u);
+    QCOMPARE(remoteBuffer->height(), 768u);
+    QCOMPARE(remoteBuffer->stride(), 1024u * 4);
+    QCOMPARE(remoteBuffer->format(), 0x34325241u);
+    close(remoteBuffer->fd());
+    QVERIFY(releasedSpy.isEmpty());
+
+    // the buffer is released once the client returned it
+    delete remoteBuffer;
+    QVERIFY(releasedSpy.wait());
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(releasedSpy.first().first().value<const BufferHandle *>(), buffer);
+}
+
+void TestRemoteAccess::testNotBound()
+{
+    // a client which didn't bind the output doesn't get its buffers, so it's released right away
+    QSignalSpy releasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    QScopedPointer<OutputInterface> otherOutput(new OutputInterface(m_display));
+    const BufferHandle *buffer = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(otherOutput.data(), buffer);
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(releasedSpy.first().first().value<const BufferHandle *>(), buffer);
+}
+
+void TestRemoteAccess::testHeldBufferLimit()
+{
+    trackRemoteBuffers();
+    QSignalSpy releasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    const BufferHandle *first = createBuffer();
+    const BufferHandle *second = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, first);
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, second);
+    QTRY_COMPARE(m_remoteBuffers.count(), 2);
+    QVERIFY(releasedSpy.isEmpty());
+
+    // the client holds two buffers already, it skips the third frame
+    const BufferHandle *third = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, third);
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(releasedSpy.first().first().value<const BufferHandle *>(), third);
+
+    // once it returned the first buffer it gets the next frame
+    delete m_remoteBuffers.first();
+    QVERIFY(releasedSpy.wait());
+    QCOMPARE(releasedSpy.count(), 2);
+    QCOMPARE(releasedSpy.last().first().value<const BufferHandle *>(), first);
+
+    const BufferHandle *fourth = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, fourth);
+    QTRY_COMPARE(m_remoteBuffers.count(), 3);
+    QCOMPARE(releasedSpy.count(), 2);
+}
+
+void TestRemoteAccess::testSendHeldFd()
+{
+    trackRemoteBuffers();
+    QSignalSpy releasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    const BufferHandle *buffer = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, buffer);
+    QTRY_COMPARE(m_remoteBuffers.count(), 1);
+
+    // another handle for the held fd isn't sent, but it's handed back to the compositor
+    auto duplicate = new BufferHandle;
+    duplicate->setFd(buffer->fd());
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, duplicate);
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(releasedSpy.first().first().value<const BufferHandle *>(), duplicate);
+    delete duplicate;
+
+    // sending the held handle again doesn't release it before the client returned it
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, buffer);
+    QCOMPARE(releasedSpy.count(), 1);
+    QVERIFY(!QTest::qWaitFor([this] {
+        return m_remoteBuffers.count() > 1;
+    }, 100));
+
+    delete m_remoteBuffers.first();
+    QVERIFY(releasedSpy.wait());
+    QCOMPARE(releasedSpy.count(), 2);
+    QCOMPARE(releasedSpy.last().first().value<const BufferHandle *>(), buffer);
+}
+
+void TestRemoteAccess::testReleaseOnDestroy()
+{
+    trackRemoteBuffers();
+    QSignalSpy releasedSpy(m_remoteAccessInterface, &RemoteAccessManagerInterface::bufferReleased);
+    const BufferHandle *buffer = createBuffer();
+    m_remoteAccessInterface->sendBufferReady(m_outputInterface, buffer);
+    QTRY_COMPARE(m_remoteBuffers.count(), 1);
+
+    // the buffers the client holds are returned with the manager
+    delete m_remoteAccess;
+    m_remoteAccess = nullptr;
+    QVERIFY(releasedSpy.wait());
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(releasedSpy.first().first().value<const BufferHandle *>(), buffer);
+}
+
+QTEST_GUILESS_MAIN(TestRemoteAccess)
+#include "test_remote_access.moc"
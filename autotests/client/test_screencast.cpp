@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/screencast.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/screencast_v1_interface.h"
+
+class TestScreencast : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testStreamOutput();
+    void testStreamWindow();
+    void testClose();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::OutputInterface *m_outputInterface = nullptr;
+    KWaylandServer::ScreencastV1Interface *m_screencastInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Output *m_output = nullptr;
+    KWayland::Client::ScreencastV1 *m_screencast = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-screencast-0");
+
+void TestScreencast::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_outputInterface = new OutputInterface(m_display, m_display);
+    m_outputInterface->setMode(QSize(1024, 768), 60000);
+    m_screencastInterface = new ScreencastV1Interface(m_display, m_display);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy allAnnounced(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+
+    const auto output = registry.interface(KWayland::Client::Registry::Interface::Output);
+    m_output = registry.createOutput(output.name, output.version, this);
+    QVERIFY(m_output->isValid());
+    QSignalSpy outputChangedSpy(m_output, &KWayland::Client::Output::changed);
+    QVERIFY(outputChangedSpy.wait());
+
+    const auto screencast = registry.interface(KWayland::Client::Registry::Interface::ScreencastV1);
+    QVERIFY(screencast.name != 0);
+    m_screencast = registry.createScreencastV1(screencast.name, screencast.version, this);
+    QVERIFY(m_screencast->isValid());
+}
+
+void TestScreencast::cleanup()
+{
+    delete m_screencast;
+    m_screencast = nullptr;
+    delete m_output;
+    m_output = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_outputInterface = nullptr;
+    m_screencastInterface = nullptr;
+}
+
+void TestScreencast::testStreamOutput()
+{
+    using namespace KWaylandServer;
+    ScreencastStreamV1Interface *serverStream = nullptr;
+    OutputInterface *serverOutput = nullptr;
+    ScreencastV1Interface::CursorMode serverMode = ScreencastV1Interface::Hidden;
+    QSignalSpy requestedSpy(m_screencastInterface, &ScreencastV1Interface::outputScreencastRequested);
+    connect(m_screencastInterface,
+            &ScreencastV1Interface::outputScreencastRequested,
+            this,
+            [&](ScreencastStreamV1Interface *stream, OutputInterface *output, ScreencastV1Interface::CursorMode mode) {
+                serverStream = stream;
+                serverOutput = output;
+                serverMode = mode;
+            });
+
+    auto stream = m_screencast->streamOutput(m_output, KWayland::Client::ScreencastV1::CursorMode::Embedded, this);
+    QVERIFY(stream->isValid());
+    QCOMPARE(stream->nodeId(), 0u);
+    QVERIFY(requestedSpy.wait());
+    QVERIFY(serverStream);
+    QCOMPARE(serverOutput, m_outputInterface);
+    QCOMPARE(serverMode, ScreencastV1Interface::Embedded);
+
+    QSignalSpy createdSpy(stream, &KWayland::Client::ScreencastStreamV1::created);
+    serverStream->sendCreated(42);
+    QVERIFY(createdSpy.wait());
+    QCOMPARE(createdSpy.first().first().value<quint32>(), 42u);
+    QCOMPARE(stream->nodeId(), 42u);
+
+    // the compositor ends the stream
+    QSignalSpy closedSpy(stream, &KWayland::Client::ScreencastStreamV1::closed);
+    serverStream->sendClosed();
+    QVERIFY(closedSpy.wait());
+    delete stream;
+}
+
+void TestScreencast::testStreamWindow()
+{
+    using namespace KWaylandServer;
+    ScreencastStreamV1Interface *serverStream = nullptr;
+    QString serverWindow;
+    QSignalSpy requestedSpy(m_screencastInterface, &ScreencastV1Interface::windowScreencastRequested);
+    connect(m_screencastInterface,
+            &ScreencastV1Interface::windowScreencastRequested,
+            this,
+            [&](ScreencastStreamV1Interface *stream, const QString &winid, ScreencastV1Interface::CursorMode mode) {
+                Q_UNUSED(mode)
+                serverStream = stream;
+                serverWindow = winid;
+            });
+
+    auto stream = m_screencast->streamWindow(QByteArrayLiteral("{0b5b2bd5-fd1b-4a31-a3f5-9b0f8e4e2a5c}"),
+                                             KWayland::Client::ScreencastV1::CursorMode::Hidden,
+                                             this);
+    QVERIFY(requestedSpy.wait());
+    QVERIFY(serverStream);
+    QCOMPARE(serverWindow, QStringLiteral("{0b5b2bd5-fd1b-4a31-a3f5-9b0f8e4e2a5c}"));
+
+    QSignalSpy failedSpy(stream, &KWayland::Client::ScreencastStreamV1::failed);
+    serverStream->sendFailed(QStringLiteral("no such window"));
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(failedSpy.first().first().toString(), QStringLiteral("no such window"));
+    QCOMPARE(stream->nodeId(), 0u);
+    delete stream;
+}
+
+void TestScreencast::testClose()
+{
+    using namespace KWaylandServer;
+    ScreencastStreamV1Interface *serverStream = nullptr;
+    QSignalSpy requestedSpy(m_screencastInterface, &ScreencastV1Interface::outputScreencastRequested);
+    connect(m_screencastInterface, &ScreencastV1Interface::outputScreencastRequested, this, [&](ScreencastStreamV1Interface *stream) {
+        serverStream = stream;
+    });
+
+    auto stream = m_screencast->streamOutput(m_output, KWayland::Client::ScreencastV1::CursorMode::Metadata, this);
+    QVERIFY(requestedSpy.wait());
+    QVERIFY(serverStream);
+
+    // releasing the stream closes it in the compositor
+    QSignalSpy finishedSpy(serverStream, &ScreencastStreamV1Interface::finished);
+    stream->release();
+    QVERIFY(!stream->isValid());
+    QVERIFY(finishedSpy.wait());
+    delete stream;
+}
+
+QTEST_GUILESS_MAIN(TestScreencast)
+#include "test_screencast.moc"
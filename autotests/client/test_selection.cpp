@@ -10,6 +10,7 @@
 #include "../../src/client/connection_thread.h"
 #include "../../src/client/datadevice.h"
 #include "../../src/client/datadevicemanager.h"
+#include "../../src/client/dataoffer.h"
 #include "../../src/client/datasource.h"
 #include "../../src/client/event_queue.h"
 #include "../../src/client/keyboard.h"
@@ -21,6 +22,9 @@
 #include "../../src/server/datadevicemanager_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/seat_interface.h"
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace KWayland::Client;
 using namespace KWaylandServer;
@@ -32,6 +36,7 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testClearOnEnter();
+    void testClipboardCache();
 
 private:
     Display *m_display = nullptr;
@@ -248,5 +253,98 @@ void SelectionTest::testClearOnEnter()
     QVERIFY(selectionClearedClient1Spy.wait());
 }
 
+static QByteArray receive(DataOffer *offer, ConnectionThread *connection)
+{
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return QByteArray();
+    }
+    offer->receive(QStringLiteral("text/plain"), pipeFds[1]);
+    close(pipeFds[1]);
+    connection->flush();
+
+    // the compositor runs in this thread, so don't block on the pipe
+    QByteArray data;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 5000) {
+        char buffer[4096];
+        const ssize_t bytesRead = read(pipeFds[0], buffer, sizeof(buffer));
+        if (bytesRead == 0) {
+            break;
+        }
+        if (bytesRead > 0) {
+            data.append(buffer, bytesRead);
+        } else {
+            QTest::qWait(1);
+        }
+    }
+    close(pipeFds[0]);
+    return data;
+}
+
+void SelectionTest::testClipboardCache()
+{
+    // this test verifies that the clipboard cache reads the selection only once and keeps it
+    // after the source went away
+    m_seatInterface->setClipboardCacheEnabled(true);
+    QVERIFY(m_seatInterface->isClipboardCacheEnabled());
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    // small enough for the pipe buffer, the source writes from the compositor thread
+    const QByteArray content(4000, 'x');
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    dataSource->offer(QStringLiteral("text/plain"));
+    int requests = 0;
+    connect(dataSource.data(), &DataSource::sendDataRequested, this, [&requests, &content](const QString &mimeType, qint32 fd) {
+        QCOMPARE(mimeType, QStringLiteral("text/plain"));
+        requests++;
+        QFile file;
+        file.open(fd, QFile::WriteOnly, QFileDevice::AutoCloseHandle);
+        file.write(content);
+    });
+    QSignalSpy selectionChangedSpy(m_seatInterface, &SeatInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+    QVERIFY(selectionChangedSpy.wait());
+    // the cache reads the data right away
+    QTRY_COMPARE(requests, 1);
+
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface *>());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+
+    // pasting twice doesn't ask the source again
+    QCOMPARE(receive(m_client2.dataDevice->offeredSelection(), m_client2.connection), content);
+    QCOMPARE(receive(m_client2.dataDevice->offeredSelection(), m_client2.connection), content);
+    QCOMPARE(requests, 1);
+
+    // the selection survives the source
+    QSignalSpy selectionClearedClient2Spy(m_client2.dataDevice, &DataDevice::selectionCleared);
+    QVERIFY(selectionClearedClient2Spy.isValid());
+    dataSource.reset();
+    m_client1.connection->flush();
+    QVERIFY(!selectionClearedClient2Spy.wait(100));
+    QVERIFY(m_seatInterface->selection());
+    QCOMPARE(m_seatInterface->selection()->mimeTypes(), QStringList{QStringLiteral("text/plain")});
+    QCOMPARE(receive(m_client2.dataDevice->offeredSelection(), m_client2.connection), content);
+
+    // clearing the selection drops the cache
+    m_seatInterface->setSelection(nullptr);
+    QVERIFY(selectionClearedClient2Spy.wait());
+}
+
 QTEST_GUILESS_MAIN(SelectionTest)
 #include "test_selection.moc"
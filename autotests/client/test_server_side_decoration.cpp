@@ -191,6 +191,7 @@ void TestServerSideDecoration::testCreate()
     QVERIFY(destroyedSpy.isValid());
     serverSideDecoration.reset();
     QVERIFY(destroyedSpy.wait());
+    QVERIFY(!ServerSideDecorationInterface::get(serverSurface));
 }
 
 void TestServerSideDecoration::testRequest_data()
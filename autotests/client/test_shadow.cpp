@@ -31,6 +31,7 @@ private Q_SLOTS:
 
     void testCreateShadow();
     void testShadowElements();
+    void testSharedTiles();
     void testSurfaceDestroy();
 
 private:
@@ -237,6 +238,60 @@ void ShadowTest::testShadowElements()
     QCOMPARE(bufferToImage(serverShadow->left()), leftImage);
 }
 
+void ShadowTest::testSharedTiles()
+{
+    // this test verifies that identical tiles of different shadows share one image
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface1(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+    QScopedPointer<Surface> surface2(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface2 = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+    QSignalSpy shadowChangedSpy1(serverSurface1, &SurfaceInterface::shadowChanged);
+    QSignalSpy shadowChangedSpy2(serverSurface2, &SurfaceInterface::shadowChanged);
+
+    QImage leftImage(QSize(10, 20), QImage::Format_ARGB32_Premultiplied);
+    leftImage.fill(QColor(0, 0, 0, 128));
+    QImage topImage(QSize(20, 10), QImage::Format_ARGB32_Premultiplied);
+    topImage.fill(QColor(0, 0, 0, 64));
+    QImage otherTopImage(QSize(20, 10), QImage::Format_ARGB32_Premultiplied);
+    otherTopImage.fill(QColor(0, 0, 0, 32));
+
+    QScopedPointer<Shadow> shadow1(m_shadow->createShadow(surface1.data()));
+    shadow1->attachLeft(m_shm->createBuffer(leftImage));
+    shadow1->attachTop(m_shm->createBuffer(topImage));
+    shadow1->commit();
+    surface1->commit(Surface::CommitFlag::None);
+    QVERIFY(shadowChangedSpy1.wait());
+
+    QScopedPointer<Shadow> shadow2(m_shadow->createShadow(surface2.data()));
+    shadow2->attachLeft(m_shm->createBuffer(leftImage));
+    shadow2->attachTop(m_shm->createBuffer(otherTopImage));
+    shadow2->commit();
+    surface2->commit(Surface::CommitFlag::None);
+    QVERIFY(shadowChangedSpy2.wait());
+
+    auto serverShadow1 = serverSurface1->shadow();
+    auto serverShadow2 = serverSurface2->shadow();
+    QVERIFY(serverShadow1);
+    QVERIFY(serverShadow2);
+    const QImage left1 = serverShadow1->tileImage(ShadowInterface::Tile::Left);
+    const QImage left2 = serverShadow2->tileImage(ShadowInterface::Tile::Left);
+    QCOMPARE(left1, leftImage);
+    QCOMPARE(left1.cacheKey(), left2.cacheKey());
+    QCOMPARE(serverShadow1->tileImage(ShadowInterface::Tile::Top), topImage);
+    QCOMPARE(serverShadow2->tileImage(ShadowInterface::Tile::Top), otherTopImage);
+    QVERIFY(serverShadow1->tileImage(ShadowInterface::Tile::Top).cacheKey() != serverShadow2->tileImage(ShadowInterface::Tile::Top).cacheKey());
+    QVERIFY(serverShadow1->tileImage(ShadowInterface::Tile::Bottom).isNull());
+
+    // the tile stays shared while any shadow uses it
+    QSignalSpy shadowDestroyedSpy(serverShadow1.data(), &QObject::destroyed);
+    shadow1.reset();
+    QVERIFY(shadowDestroyedSpy.wait());
+    QCOMPARE(serverShadow2->tileImage(ShadowInterface::Tile::Left).cacheKey(), left2.cacheKey());
+}
+
 void ShadowTest::testSurfaceDestroy()
 {
     using namespace KWayland::Client;
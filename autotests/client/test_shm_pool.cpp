@@ -5,6 +5,7 @@
 */
 // Qt
 #include <QImage>
+#include <QPainter>
 #include <QtTest>
 // KWin
 #include "../../src/server/compositor_interface.h"
@@ -30,8 +31,12 @@ private Q_SLOTS:
     void testCreateBufferInvalidSize();
     void testCreateBufferFromImage();
     void testCreateBufferFromImageWithAlpha();
+    void testCreateBufferFromImageConversion();
+    void testBufferImage();
     void testCreateBufferFromData();
     void testReuseBuffer();
+    void testReuseMemory();
+    void testTrim();
 
 private:
     KWaylandServer::Display *m_display;
@@ -160,6 +165,48 @@ void TestShmPool::testCreateBufferFromImageWithAlpha()
     QCOMPARE(img2, img);
 }
 
+void TestShmPool::testCreateBufferFromImageConversion()
+{
+    QVERIFY(m_shmPool->isValid());
+    QImage img(23, 24, QImage::Format_ARGB32);
+    img.fill(QColor(255, 0, 0, 100));
+    img.setPixelColor(5, 5, QColor(0, 255, 0, 50));
+    auto buffer = m_shmPool->createBuffer(img).toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->size(), img.size());
+    QCOMPARE(buffer->format(), KWayland::Client::Buffer::Format::ARGB32);
+    QCOMPARE(buffer->image(), img.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+
+    // formats with a different depth get a tightly packed 32-bit Buffer
+    QImage rgb(23, 24, QImage::Format_RGB888);
+    rgb.fill(Qt::blue);
+    buffer = m_shmPool->createBuffer(rgb).toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->stride(), 23 * 4);
+    QCOMPARE(buffer->image(), rgb.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+}
+
+void TestShmPool::testBufferImage()
+{
+    QVERIFY(m_shmPool->isValid());
+    const QSize size(24, 24);
+    auto buffer = m_shmPool->getBuffer(size, size.width() * 4, KWayland::Client::Buffer::Format::RGB32).toStrongRef();
+    QVERIFY(buffer);
+    QImage image = buffer->image();
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(image.size(), size);
+    QCOMPARE(image.constBits(), buffer->address());
+
+    QPainter painter(&image);
+    painter.fillRect(image.rect(), Qt::red);
+    painter.end();
+    QCOMPARE(QImage(buffer->address(), size.width(), size.height(), QImage::Format_RGB32).pixelColor(10, 10), QColor(Qt::red));
+
+    buffer = m_shmPool->getBuffer(size, size.width() * 4, KWayland::Client::Buffer::Format::ARGB32).toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->image().format(), QImage::Format_ARGB32_Premultiplied);
+}
+
 void TestShmPool::testCreateBufferFromData()
 {
     QVERIFY(m_shmPool->isValid());
@@ -204,5 +251,54 @@ void TestShmPool::testReuseBuffer()
     QVERIFY(buffer4 != buffer3);
 }
 
+void TestShmPool::testReuseMemory()
+{
+    // this test verifies that the memory of idle buffers is reused for buffers of other sizes
+    QVERIFY(m_shmPool->isValid());
+    auto buffer = m_shmPool->getBuffer(QSize(100, 100), 400).toStrongRef();
+    QVERIFY(buffer);
+    const int32_t poolSize = m_shmPool->poolSize();
+    QVERIFY(poolSize >= 100 * 400);
+    buffer->setReleased(true);
+    buffer.clear();
+
+    // shrinking the buffer step by step must not grow the pool
+    for (int i = 0; i < 20; ++i) {
+        const QSize size(100 - i, 100 - i);
+        auto resized = m_shmPool->getBuffer(size, size.width() * 4).toStrongRef();
+        QVERIFY(resized);
+        QCOMPARE(resized->size(), size);
+        resized->setReleased(true);
+    }
+    QCOMPARE(m_shmPool->poolSize(), poolSize);
+
+    // a buffer which is still referenced keeps its memory
+    auto held = m_shmPool->getBuffer(QSize(100, 100), 400).toStrongRef();
+    QVERIFY(held);
+    held->setReleased(true);
+    auto other = m_shmPool->getBuffer(QSize(50, 50), 200).toStrongRef();
+    QVERIFY(other);
+    QVERIFY(other->address() + 50 * 200 <= held->address() || held->address() + 100 * 400 <= other->address());
+}
+
+void TestShmPool::testTrim()
+{
+    QVERIFY(m_shmPool->isValid());
+    KWayland::Client::Buffer::Ptr weak = m_shmPool->getBuffer(QSize(64, 64), 256);
+    auto buffer = weak.toStrongRef();
+    QVERIFY(buffer);
+    buffer->setReleased(true);
+    buffer.clear();
+    QVERIFY(!weak.isNull());
+
+    m_shmPool->trim();
+    QVERIFY(weak.isNull());
+
+    // the freed memory is used for the next buffer
+    const int32_t poolSize = m_shmPool->poolSize();
+    QVERIFY(!m_shmPool->getBuffer(QSize(32, 32), 128).isNull());
+    QCOMPARE(m_shmPool->poolSize(), poolSize);
+}
+
 QTEST_GUILESS_MAIN(TestShmPool)
 #include "test_shm_pool.moc"
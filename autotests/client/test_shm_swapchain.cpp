@@ -0,0 +1,217 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QImage>
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/client/shm_swapchain.h"
+#include "../../src/client/surface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+
+class TestShmSwapchain : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testConfiguration();
+    void testReleaseTracking();
+    void testFramePacing();
+
+private:
+    KWaylandServer::SurfaceInterface *createSurface();
+
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::CompositorInterface *m_compositorInterface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-shm-swapchain-0");
+
+void TestShmSwapchain::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    KWayland::Client::Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy allAnnounced(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+
+    const auto compositor = registry.interface(KWayland::Client::Registry::Interface::Compositor);
+    m_compositor = registry.createCompositor(compositor.name, compositor.version, this);
+    QVERIFY(m_compositor->isValid());
+    const auto shm = registry.interface(KWayland::Client::Registry::Interface::Shm);
+    m_shm = registry.createShmPool(shm.name, shm.version, this);
+    QVERIFY(m_shm->isValid());
+}
+
+void TestShmSwapchain::cleanup()
+{
+    delete m_surface;
+    m_surface = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_compositorInterface = nullptr;
+}
+
+KWaylandServer::SurfaceInterface *TestShmSwapchain::createSurface()
+{
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    if (!serverSurfaceCreated.wait()) {
+        return nullptr;
+    }
+    return serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+}
+
+void TestShmSwapchain::testConfiguration()
+{
+    QVERIFY(createSurface());
+    KWayland::Client::ShmSwapchain swapchain(m_shm, m_surface);
+    QCOMPARE(swapchain.bufferCount(), 2);
+    QCOMPARE(swapchain.format(), KWayland::Client::Buffer::Format::ARGB32);
+    QVERIFY(swapchain.framePacing());
+    // without a size there is nothing to render into
+    QVERIFY(!swapchain.isReady());
+    QVERIFY(!swapchain.acquire());
+
+    swapchain.setSize(QSize(24, 24));
+    swapchain.setFormat(KWayland::Client::Buffer::Format::RGB32);
+    QVERIFY(swapchain.isReady());
+    auto buffer = swapchain.acquire().toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->size(), QSize(24, 24));
+    QCOMPARE(buffer->format(), KWayland::Client::Buffer::Format::RGB32);
+    QVERIFY(buffer->isUsed());
+    QCOMPARE(swapchain.bufferAge(), 0);
+    // acquiring again provides the same buffer
+    QCOMPARE(swapchain.acquire().toStrongRef(), buffer);
+
+    // changing the size hands the buffers back to the pool
+    swapchain.setSize(QSize(32, 32));
+    QVERIFY(!buffer->isUsed());
+    buffer = swapchain.acquire().toStrongRef();
+    QVERIFY(buffer);
+    QCOMPARE(buffer->size(), QSize(32, 32));
+}
+
+void TestShmSwapchain::testReleaseTracking()
+{
+    KWaylandServer::SurfaceInterface *serverSurface = createSurface();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+
+    KWayland::Client::ShmSwapchain swapchain(m_shm, m_surface);
+    swapchain.setSize(QSize(24, 24));
+    swapchain.setFramePacing(false);
+    QSignalSpy readySpy(&swapchain, &KWayland::Client::ShmSwapchain::ready);
+
+    auto first = swapchain.acquire().toStrongRef();
+    QVERIFY(first);
+    first->image().fill(Qt::red);
+    swapchain.present(QRegion(0, 0, 24, 24));
+    QVERIFY(committedSpy.wait());
+
+    // the first buffer is held by the server, thus a second one gets created
+    auto second = swapchain.acquire().toStrongRef();
+    QVERIFY(second);
+    QVERIFY(second != first);
+    QCOMPARE(swapchain.bufferAge(), 0);
+    second->image().fill(Qt::blue);
+    swapchain.present(QRegion(0, 0, 24, 24));
+
+    // no third buffer is allocated, unless the server released the first one
+    if (!first->isReleased()) {
+        QVERIFY(!swapchain.acquire());
+        QVERIFY(readySpy.wait());
+    }
+    QCOMPARE(swapchain.acquire().toStrongRef(), first);
+    QCOMPARE(swapchain.bufferAge(), 2);
+    QCOMPARE(first->image().pixelColor(0, 0), QColor(Qt::red));
+    swapchain.present(QRegion(0, 0, 8, 8));
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->bufferDamage(), QRegion(0, 0, 8, 8));
+}
+
+void TestShmSwapchain::testFramePacing()
+{
+    KWaylandServer::SurfaceInterface *serverSurface = createSurface();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+
+    KWayland::Client::ShmSwapchain swapchain(m_shm, m_surface);
+    swapchain.setSize(QSize(24, 24));
+    swapchain.setBufferCount(3);
+    QSignalSpy readySpy(&swapchain, &KWayland::Client::ShmSwapchain::ready);
+
+    QVERIFY(swapchain.acquire());
+    swapchain.present(QRegion(0, 0, 24, 24));
+    QVERIFY(committedSpy.wait());
+
+    // free buffers are left, but the frame callback has to be awaited
+    QVERIFY(!swapchain.isReady());
+    QVERIFY(!swapchain.acquire());
+    serverSurface->frameRendered(1);
+    QVERIFY(readySpy.wait());
+    QVERIFY(swapchain.isReady());
+    QVERIFY(swapchain.acquire());
+}
+
+QTEST_GUILESS_MAIN(TestShmSwapchain)
+#include "test_shm_swapchain.moc"
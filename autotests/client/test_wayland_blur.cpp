@@ -30,6 +30,7 @@ private Q_SLOTS:
 
     void testCreate();
     void testSurfaceDestroy();
+    void testSameRegion();
 
 private:
     KWaylandServer::Display *m_display;
@@ -192,5 +193,65 @@ void TestBlur::testSurfaceDestroy()
     QVERIFY(blurDestroyedSpy.wait());
 }
 
+void TestBlur::testSameRegion()
+{
+    // this test verifies that setting an identical blur doesn't emit blurChanged
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+
+    auto serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QSignalSpy blurChanged(serverSurface, &KWaylandServer::SurfaceInterface::blurChanged);
+    QVERIFY(blurChanged.isValid());
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QScopedPointer<KWayland::Client::Blur> blur(m_blurManager->createBlur(surface.data()));
+    blur->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 20), nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QCOMPARE(serverSurface->blurDamage(), QRegion(0, 0, 10, 20));
+    const quint64 effectsGeneration = serverSurface->generation(KWaylandServer::SurfaceInterface::StateCategory::Effects);
+    QVERIFY(effectsGeneration > 0);
+
+    // a new blur object with the same region
+    blur.reset(m_blurManager->createBlur(surface.data()));
+    blur->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 20), nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(blurChanged.count(), 1);
+    QCOMPARE(serverSurface->blur()->region(), QRegion(0, 0, 10, 20));
+
+    // and once more, still without a change
+    blur.reset(m_blurManager->createBlur(surface.data()));
+    blur->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 20), nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(blurChanged.count(), 1);
+    QCOMPARE(serverSurface->generation(KWaylandServer::SurfaceInterface::StateCategory::Effects), effectsGeneration);
+
+    // only the added and the removed parts are damaged
+    blur.reset(m_blurManager->createBlur(surface.data()));
+    blur->setRegion(m_compositor->createRegion(QRegion(0, 10, 10, 20), nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QCOMPARE(blurChanged.count(), 2);
+    QCOMPARE(serverSurface->generation(KWaylandServer::SurfaceInterface::StateCategory::Effects), effectsGeneration + 1);
+    QCOMPARE(serverSurface->blurDamage(), QRegion(0, 0, 10, 10) + QRegion(0, 20, 10, 10));
+
+    // unsetting the blur damages the whole old region
+    m_blurManager->removeBlur(surface.data());
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QVERIFY(!serverSurface->blur());
+    QCOMPARE(serverSurface->blurDamage(), QRegion(0, 10, 10, 20));
+}
+
 QTEST_GUILESS_MAIN(TestBlur)
 #include "test_wayland_blur.moc"
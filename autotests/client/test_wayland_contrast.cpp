@@ -33,6 +33,7 @@ private Q_SLOTS:
 
     void testCreate();
     void testSurfaceDestroy();
+    void testSameContrast();
 
 private:
     KWaylandServer::Display *m_display;
@@ -203,5 +204,57 @@ void TestContrast::testSurfaceDestroy()
     QVERIFY(contrastDestroyedSpy.wait());
 }
 
+void TestContrast::testSameContrast()
+{
+    // this test verifies that committing an unchanged contrast doesn't emit contrastChanged
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+
+    auto serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QSignalSpy contrastChanged(serverSurface, &KWaylandServer::SurfaceInterface::contrastChanged);
+    QVERIFY(contrastChanged.isValid());
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    auto createContrast = [this, &surface](qreal saturation) {
+        auto contrast = m_contrastManager->createContrast(surface.data());
+        contrast->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 20), nullptr));
+        contrast->setContrast(0.2);
+        contrast->setIntensity(2.0);
+        contrast->setSaturation(saturation);
+        contrast->commit();
+        return contrast;
+    };
+
+    QScopedPointer<KWayland::Client::Contrast> contrast(createContrast(1.7));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(contrastChanged.wait());
+    QCOMPARE(serverSurface->contrastDamage(), QRegion(0, 0, 10, 20));
+
+    // the same contrast twice
+    contrast.reset(createContrast(1.7));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    contrast.reset(createContrast(1.7));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(contrastChanged.count(), 1);
+
+    // a commit without any contrast request
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(contrastChanged.count(), 1);
+
+    // other parameters change the whole region
+    contrast.reset(createContrast(1.2));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(contrastChanged.wait());
+    QCOMPARE(contrastChanged.count(), 2);
+    QCOMPARE(serverSurface->contrastDamage(), QRegion(0, 0, 10, 20));
+}
+
 QTEST_GUILESS_MAIN(TestContrast)
 #include "test_wayland_contrast.moc"
@@ -34,6 +34,7 @@ private Q_SLOTS:
     void cleanup();
     void testFilter_data();
     void testFilter();
+    void testFilterCache();
 
 private:
     TestDisplay *m_display;
@@ -51,6 +52,7 @@ public:
     TestDisplay(QObject *parent);
     bool allowInterface(KWaylandServer::ClientConnection *client, const QByteArray &interfaceName) override;
     QList<wl_client *> m_allowedClients;
+    int m_allowInterfaceCalls = 0;
 };
 
 TestDisplay::TestDisplay(QObject *parent)
@@ -60,6 +62,7 @@ TestDisplay::TestDisplay(QObject *parent)
 
 bool TestDisplay::allowInterface(KWaylandServer::ClientConnection *client, const QByteArray &interfaceName)
 {
+    ++m_allowInterfaceCalls;
     if (interfaceName == "org_kde_kwin_blur_manager") {
         return m_allowedClients.contains(*client);
     }
@@ -145,5 +148,54 @@ void TestFilter::testFilter()
     thread->wait();
 }
 
+void TestFilter::testFilterCache()
+{
+    // this test verifies that the decisions are only made once per client and interface
+    QScopedPointer<KWayland::Client::ConnectionThread> connection(new KWayland::Client::ConnectionThread());
+    QSignalSpy connectedSpy(connection.data(), &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    connection->setSocketName(s_socketName);
+
+    QScopedPointer<QThread> thread(new QThread(this));
+    connection->moveToThread(thread.data());
+    thread->start();
+
+    connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    KWayland::Client::EventQueue queue;
+    queue.setup(connection.data());
+
+    auto announce = [&queue, &connection]() {
+        Registry registry;
+        QSignalSpy registryDoneSpy(&registry, &Registry::interfacesAnnounced);
+        registry.setEventQueue(&queue);
+        registry.create(connection->display());
+        registry.setup();
+        return registryDoneSpy.wait();
+    };
+
+    QVERIFY(announce());
+    const int calls = m_display->m_allowInterfaceCalls;
+    QVERIFY(calls > 0);
+
+    // a second registry uses the cached decisions
+    QVERIFY(announce());
+    QCOMPARE(m_display->m_allowInterfaceCalls, calls);
+
+    // until they are invalidated
+    QCOMPARE(m_display->connections().count(), 1);
+    m_display->invalidateInterfaceFilter(m_display->connections().first());
+    QVERIFY(announce());
+    QCOMPARE(m_display->m_allowInterfaceCalls, 2 * calls);
+
+    m_display->invalidateInterfaceFilter();
+    QVERIFY(announce());
+    QCOMPARE(m_display->m_allowInterfaceCalls, 3 * calls);
+
+    thread->quit();
+    thread->wait();
+}
+
 QTEST_GUILESS_MAIN(TestFilter)
 #include "test_wayland_filter.moc"
@@ -6,6 +6,7 @@
 // Qt
 #include <QtTest>
 // KWin
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/display.h"
 #include "../../src/server/dpms_interface.h"
 #include "../../src/server/output_interface.h"
@@ -29,6 +30,7 @@ private Q_SLOTS:
     void testRegistry();
     void testModeChange();
     void testScaleChange();
+    void testAtomicChange();
 
     void testSubPixel_data();
     void testSubPixel();
@@ -185,6 +187,13 @@ void TestWaylandOutput::testRegistry()
     QCOMPARE(output.subPixel(), KWayland::Client::Output::SubPixel::Unknown);
     // for xwayland transform is normal
     QCOMPARE(output.transform(), KWayland::Client::Output::Transform::Normal);
+
+    // the server finds the bound output of the client
+    QCOMPARE(m_display->connections().count(), 1);
+    KWaylandServer::ClientConnection *client = m_display->connections().first();
+    const QVector<wl_resource *> resources = m_serverOutput->clientResources(client);
+    QCOMPARE(resources.count(), 1);
+    QCOMPARE(m_serverOutput->clientResource(client), resources.first());
 }
 
 void TestWaylandOutput::testModeChange()
@@ -271,6 +280,51 @@ void TestWaylandOutput::testScaleChange()
     QCOMPARE(output.scale(), 4);
 }
 
+void TestWaylandOutput::testAtomicChange()
+{
+    qRegisterMetaType<KWayland::Client::Output::Changes>();
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, &KWayland::Client::Registry::outputAnnounced);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(announced.wait());
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, &KWayland::Client::Output::changed);
+    QVERIFY(outputChanged.isValid());
+    QSignalSpy propertiesChanged(&output, &KWayland::Client::Output::propertiesChanged);
+    QVERIFY(propertiesChanged.isValid());
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(propertiesChanged.count(), 1);
+
+    // the values only become visible together on done
+    QPoint position;
+    int scale = 0;
+    connect(&output, &KWayland::Client::Output::propertiesChanged, this, [&] {
+        position = output.globalPosition();
+        scale = output.scale();
+    });
+    m_serverOutput->setGlobalPosition(QPoint(100, 200));
+    m_serverOutput->setScale(3);
+    m_serverOutput->done();
+    QVERIFY(propertiesChanged.wait());
+    QCOMPARE(propertiesChanged.count(), 2);
+    QCOMPARE(propertiesChanged.last().first().value<KWayland::Client::Output::Changes>(),
+             KWayland::Client::Output::Changes(KWayland::Client::Output::Change::GlobalPosition | KWayland::Client::Output::Change::Scale));
+    QCOMPARE(position, QPoint(100, 200));
+    QCOMPARE(scale, 3);
+
+    // a done without any change only emits changed
+    outputChanged.clear();
+    m_serverOutput->done();
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(propertiesChanged.count(), 2);
+}
+
 void TestWaylandOutput::testSubPixel_data()
 {
     using namespace KWayland::Client;
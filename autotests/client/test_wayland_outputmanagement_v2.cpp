@@ -0,0 +1,361 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/outputconfiguration_v2.h"
+#include "../../src/client/outputdevice_v2.h"
+#include "../../src/client/outputdevicemode_v2.h"
+#include "../../src/client/outputmanagement_v2.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/display.h"
+#include "../../src/server/outputchangeset_v2.h"
+#include "../../src/server/outputconfiguration_v2_interface.h"
+#include "../../src/server/outputdevice_v2_interface.h"
+#include "../../src/server/outputmanagement_v2_interface.h"
+
+#include "wayland-kde-output-management-v2-client-protocol.h"
+
+using namespace KWayland::Client;
+using namespace KWaylandServer;
+
+class TestWaylandOutputManagementV2 : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testApplied();
+    void testFailed();
+    void testUnknownDevice();
+    void testUnknownMode();
+    void testModeOfOtherDevice();
+    void testEmptySize();
+    void testZeroScale();
+
+private:
+    QList<OutputDeviceModeV2Interface *> createModes(const QVector<QSize> &sizes, int current);
+    OutputDeviceV2 *createOutput(const Registry::AnnouncedInterface &announced);
+    int modeIndex(OutputDeviceV2 *output, const QSize &size) const;
+    void applyChanges(OutputConfigurationV2Interface *configuration);
+
+    KWaylandServer::Display *m_display = nullptr;
+    OutputManagementV2Interface *m_outputManagementInterface = nullptr;
+    OutputDeviceV2Interface *m_serverOutput = nullptr;
+    OutputDeviceV2Interface *m_otherServerOutput = nullptr;
+
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    OutputManagementV2 *m_outputManagement = nullptr;
+    OutputDeviceV2 *m_output = nullptr;
+    OutputDeviceV2 *m_otherOutput = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-output-management-v2-0");
+
+QList<OutputDeviceModeV2Interface *> TestWaylandOutputManagementV2::createModes(const QVector<QSize> &sizes, int current)
+{
+    QList<OutputDeviceModeV2Interface *> modes;
+    for (int i = 0; i < sizes.count(); ++i) {
+        OutputDeviceModeV2Interface::ModeFlags flags;
+        if (i == current) {
+            flags |= OutputDeviceModeV2Interface::ModeFlag::Current;
+        }
+        modes << new OutputDeviceModeV2Interface(sizes.at(i), 60000, flags);
+    }
+    return modes;
+}
+
+void TestWaylandOutputManagementV2::init()
+{
+    m_display = new KWaylandServer::Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_outputManagementInterface = new OutputManagementV2Interface(m_display, m_display);
+    m_serverOutput = new OutputDeviceV2Interface(m_display, m_display);
+    m_serverOutput->setModes(createModes({QSize(800, 600), QSize(1024, 768), QSize(1920, 1080)}, 1));
+    m_otherServerOutput = new OutputDeviceV2Interface(m_display, m_display);
+    m_otherServerOutput->setModes(createModes({QSize(1280, 1024), QSize(1600, 1200)}, 0));
+    m_otherServerOutput->setGlobalPosition(QPoint(1024, 0));
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new Registry(this);
+    QSignalSpy allAnnouncedSpy(m_registry, &Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    const auto management = m_registry->interface(Registry::Interface::OutputManagementV2);
+    m_outputManagement = m_registry->createOutputManagementV2(management.name, management.version, this);
+    QVERIFY(m_outputManagement->isValid());
+
+    // the globals are announced in the order they were created
+    const auto devices = m_registry->interfaces(Registry::Interface::OutputDeviceV2);
+    QCOMPARE(devices.count(), 2);
+    m_output = createOutput(devices.at(0));
+    QVERIFY(m_output);
+    QCOMPARE(m_output->pixelSize(), QSize(1024, 768));
+    m_otherOutput = createOutput(devices.at(1));
+    QVERIFY(m_otherOutput);
+    QCOMPARE(m_otherOutput->pixelSize(), QSize(1280, 1024));
+}
+
+void TestWaylandOutputManagementV2::cleanup()
+{
+#define CLEANUP(variable)                                                                                                                                      \
+    if (variable) {                                                                                                                                            \
+        delete variable;                                                                                                                                       \
+        variable = nullptr;                                                                                                                                    \
+    }
+    CLEANUP(m_output)
+    CLEANUP(m_otherOutput)
+    CLEANUP(m_outputManagement)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    CLEANUP(m_connection)
+    CLEANUP(m_display)
+#undef CLEANUP
+
+    // these are the children of the display
+    m_outputManagementInterface = nullptr;
+    m_serverOutput = nullptr;
+    m_otherServerOutput = nullptr;
+}
+
+OutputDeviceV2 *TestWaylandOutputManagementV2::createOutput(const Registry::AnnouncedInterface &announced)
+{
+    OutputDeviceV2 *output = m_registry->createOutputDeviceV2(announced.name, announced.version, this);
+    QSignalSpy doneSpy(output, &OutputDeviceV2::done);
+    if (!doneSpy.wait()) {
+        delete output;
+        return nullptr;
+    }
+    return output;
+}
+
+int TestWaylandOutputManagementV2::modeIndex(OutputDeviceV2 *output, const QSize &size) const
+{
+    const auto modes = output->modes();
+    for (int i = 0; i < modes.count(); ++i) {
+        if (modes.at(i)->size() == size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TestWaylandOutputManagementV2::applyChanges(OutputConfigurationV2Interface *configuration)
+{
+    const auto changes = configuration->changes();
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        OutputDeviceV2Interface *device = it.key();
+        const OutputChangeSetV2 *change = it.value();
+        if (change->sizeChanged() || change->refreshRateChanged()) {
+            QVERIFY(device->setCurrentMode(change->size(), change->refreshRate()));
+        }
+        if (change->positionChanged()) {
+            device->setGlobalPosition(change->position());
+        }
+        if (change->scaleChanged()) {
+            device->setScale(change->scale());
+        }
+    }
+}
+
+void TestWaylandOutputManagementV2::testApplied()
+{
+    // the compositor updates every property on its own, but each output gets a single done
+    OutputConfigurationV2Interface *configuration = nullptr;
+    connect(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested, this, [&configuration](OutputConfigurationV2Interface *c) {
+        configuration = c;
+    });
+    QSignalSpy outputChangedSpy(m_output, &OutputDeviceV2::changed);
+    QSignalSpy otherOutputChangedSpy(m_otherOutput, &OutputDeviceV2::changed);
+
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy appliedSpy(config, &OutputConfigurationV2::applied);
+    config->setMode(m_output, modeIndex(m_output, QSize(1920, 1080)));
+    config->setScaleF(m_output, 2);
+    config->setPosition(m_otherOutput, QPoint(960, 0));
+    config->setScaleF(m_otherOutput, 1.5);
+    config->apply();
+
+    QTRY_VERIFY(configuration);
+    QVERIFY(configuration->isValid());
+    QCOMPARE(configuration->changes().count(), 2);
+    applyChanges(configuration);
+    QCOMPARE(m_serverOutput->pixelSize(), QSize(1920, 1080));
+    QCOMPARE(m_otherServerOutput->globalPosition(), QPoint(960, 0));
+
+    // the done events are held back until the compositor answers
+    QVERIFY(!outputChangedSpy.wait(100));
+    QCOMPARE(otherOutputChangedSpy.count(), 0);
+
+    configuration->setApplied();
+    QVERIFY(appliedSpy.wait());
+    // the done events are sent before applied
+    QCOMPARE(outputChangedSpy.count(), 1);
+    QCOMPARE(otherOutputChangedSpy.count(), 1);
+    QCOMPARE(m_output->pixelSize(), QSize(1920, 1080));
+    QCOMPARE(m_output->scaleF(), 2.0);
+    QCOMPARE(m_otherOutput->globalPosition(), QPoint(960, 0));
+    QCOMPARE(m_otherOutput->scaleF(), 1.5);
+
+    // later changes are no longer batched
+    m_serverOutput->setGlobalPosition(QPoint(0, 100));
+    QVERIFY(outputChangedSpy.wait());
+    QCOMPARE(outputChangedSpy.count(), 2);
+    delete config;
+}
+
+void TestWaylandOutputManagementV2::testFailed()
+{
+    // a configuration the compositor rejects after applying parts of it ends the update as well
+    connect(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested, this, [this](OutputConfigurationV2Interface *c) {
+        applyChanges(c);
+        c->setFailed();
+    });
+    QSignalSpy outputChangedSpy(m_output, &OutputDeviceV2::changed);
+
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy failedSpy(config, &OutputConfigurationV2::failed);
+    config->setMode(m_output, modeIndex(m_output, QSize(800, 600)));
+    config->setPosition(m_output, QPoint(0, 100));
+    config->apply();
+
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(outputChangedSpy.count(), 1);
+    QCOMPARE(m_output->pixelSize(), QSize(800, 600));
+    QCOMPARE(m_output->globalPosition(), QPoint(0, 100));
+    delete config;
+}
+
+void TestWaylandOutputManagementV2::testUnknownDevice()
+{
+    QSignalSpy configurationChangeRequestedSpy(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested);
+
+    // the client has not seen the removal yet when it configures the output
+    delete m_otherServerOutput;
+    m_otherServerOutput = nullptr;
+
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy failedSpy(config, &OutputConfigurationV2::failed);
+    config->setMode(m_output, modeIndex(m_output, QSize(1920, 1080)));
+    config->setMode(m_otherOutput, modeIndex(m_otherOutput, QSize(1600, 1200)));
+    config->apply();
+
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(configurationChangeRequestedSpy.count(), 0);
+    QCOMPARE(m_serverOutput->pixelSize(), QSize(1024, 768));
+    delete config;
+}
+
+void TestWaylandOutputManagementV2::testUnknownMode()
+{
+    QSignalSpy configurationChangeRequestedSpy(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested);
+
+    // the client has not seen the new modes yet when it picks one of the old ones
+    const int index = modeIndex(m_output, QSize(1920, 1080));
+    m_serverOutput->setModes(createModes({QSize(800, 600), QSize(1024, 768), QSize(1920, 1080)}, 1));
+
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy failedSpy(config, &OutputConfigurationV2::failed);
+    config->setMode(m_output, index);
+    config->apply();
+
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(configurationChangeRequestedSpy.count(), 0);
+    QCOMPARE(m_serverOutput->pixelSize(), QSize(1024, 768));
+    delete config;
+}
+
+void TestWaylandOutputManagementV2::testModeOfOtherDevice()
+{
+    QSignalSpy configurationChangeRequestedSpy(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested);
+
+    // OutputConfigurationV2 only picks modes of the configured device, so send the request directly
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy failedSpy(config, &OutputConfigurationV2::failed);
+    DeviceModeV2 *otherMode = m_otherOutput->deviceModeFromId(modeIndex(m_otherOutput, QSize(1600, 1200)));
+    kde_output_configuration_v2_mode(*config, *m_output, *otherMode);
+    config->apply();
+
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(configurationChangeRequestedSpy.count(), 0);
+    QCOMPARE(m_serverOutput->pixelSize(), QSize(1024, 768));
+    delete config;
+}
+
+void TestWaylandOutputManagementV2::testEmptySize()
+{
+    // an output without any mode can't be enabled
+    QSignalSpy outputAnnouncedSpy(m_registry, &Registry::outputDeviceV2Announced);
+    auto serverOutput = new OutputDeviceV2Interface(m_display, m_display);
+    serverOutput->setEnabled(false);
+    QVERIFY(outputAnnouncedSpy.wait());
+    QScopedPointer<OutputDeviceV2> output(createOutput({outputAnnouncedSpy.first().at(0).value<quint32>(), outputAnnouncedSpy.first().at(1).value<quint32>()}));
+    QVERIFY(output);
+    QCOMPARE(output->enabled(), OutputDeviceV2::Enablement::Disabled);
+
+    QSignalSpy configurationChangeRequestedSpy(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested);
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy failedSpy(config, &OutputConfigurationV2::failed);
+    config->setEnabled(output.data(), OutputDeviceV2::Enablement::Enabled);
+    config->apply();
+
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(configurationChangeRequestedSpy.count(), 0);
+    QVERIFY(!serverOutput->enabled());
+    delete config;
+}
+
+void TestWaylandOutputManagementV2::testZeroScale()
+{
+    // the whole configuration is rejected, not just the scale
+    QSignalSpy configurationChangeRequestedSpy(m_outputManagementInterface, &OutputManagementV2Interface::configurationChangeRequested);
+    OutputConfigurationV2 *config = m_outputManagement->createConfiguration(this);
+    QSignalSpy failedSpy(config, &OutputConfigurationV2::failed);
+    config->setPosition(m_output, QPoint(0, 100));
+    config->setScaleF(m_output, 0);
+    config->apply();
+
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(configurationChangeRequestedSpy.count(), 0);
+    QCOMPARE(m_serverOutput->globalPosition(), QPoint(0, 0));
+    delete config;
+}
+
+QTEST_GUILESS_MAIN(TestWaylandOutputManagementV2)
+#include "test_wayland_outputmanagement_v2.moc"
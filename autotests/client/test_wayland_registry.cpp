@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// KWin
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/seat.h"
+#include "../../src/client/shm_pool.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/seat_interface.h"
+// Wayland
+#include <wayland-client-protocol.h>
+
+class TestWaylandRegistry : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testRequestedInterfaces();
+    void testRequestedVersion();
+    void testPendingEvents();
+    void testReadyContinuation();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::SeatInterface *m_seat = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-wayland-registry-0");
+
+void TestWaylandRegistry::init()
+{
+    using namespace KWaylandServer;
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_display->createShm();
+    new CompositorInterface(m_display, m_display);
+    m_seat = new SeatInterface(m_display, m_display);
+    m_seat->setHasPointer(true);
+
+    // setup connection
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+}
+
+void TestWaylandRegistry::cleanup()
+{
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_seat = nullptr;
+}
+
+void TestWaylandRegistry::testRequestedInterfaces()
+{
+    // this test verifies that requested interfaces are created while the globals get announced
+    using namespace KWayland::Client;
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    registry.requestInterface(Registry::Interface::Compositor);
+    registry.requestInterface(Registry::Interface::Seat);
+    registry.requestInterface(Registry::Interface::Shm);
+    // not announced by the server
+    registry.requestInterface(Registry::Interface::PlasmaShell);
+    QSignalSpy announcedSpy(&registry, &Registry::interfacesAnnounced);
+    QSignalSpy readySpy(&registry, &Registry::requestedInterfacesReady);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(announcedSpy.wait());
+
+    // the objects exist as soon as the interfaces got announced
+    auto compositor = qobject_cast<Compositor *>(registry.requestedInterface(Registry::Interface::Compositor));
+    QVERIFY(compositor);
+    QVERIFY(compositor->isValid());
+    QCOMPARE(compositor->parent(), &registry);
+    auto shm = qobject_cast<ShmPool *>(registry.requestedInterface(Registry::Interface::Shm));
+    QVERIFY(shm);
+    QVERIFY(shm->isValid());
+    auto seat = qobject_cast<Seat *>(registry.requestedInterface(Registry::Interface::Seat));
+    QVERIFY(seat);
+    QVERIFY(!registry.requestedInterface(Registry::Interface::PlasmaShell));
+    // interfaces which were not requested are not created
+    QVERIFY(!registry.requestedInterface(Registry::Interface::Output));
+
+    // once ready the initial events of the seat are received
+    if (readySpy.isEmpty()) {
+        QVERIFY(readySpy.wait());
+    }
+    QCOMPARE(readySpy.count(), 1);
+    QVERIFY(seat->hasPointer());
+}
+
+void TestWaylandRegistry::testRequestedVersion()
+{
+    // this test verifies that a requested interface is bound with the requested version
+    using namespace KWayland::Client;
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    registry.requestInterface(Registry::Interface::Seat, 1);
+    QSignalSpy readySpy(&registry, &Registry::requestedInterfacesReady);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(readySpy.wait());
+
+    auto seat = qobject_cast<Seat *>(registry.requestedInterface(Registry::Interface::Seat));
+    QVERIFY(seat);
+    QCOMPARE(wl_proxy_get_version(reinterpret_cast<wl_proxy *>(static_cast<wl_seat *>(*seat))), 1u);
+}
+
+void TestWaylandRegistry::testPendingEvents()
+{
+    // this test verifies that an event queue knows whether events wait for it
+    using namespace KWayland::Client;
+    // not set up for the connection, so nothing dispatches it on its own
+    EventQueue queue;
+    queue.setup(m_connection->display());
+    QVERIFY(!queue.hasPendingEvents());
+    QVERIFY(!m_queue->hasPendingEvents());
+
+    Registry registry;
+    registry.setEventQueue(&queue);
+    QSignalSpy announcedSpy(&registry, &Registry::interfaceAnnounced);
+    registry.create(m_connection);
+    registry.setup();
+    m_connection->flush();
+    QTRY_VERIFY(queue.hasPendingEvents());
+    QVERIFY(announcedSpy.isEmpty());
+    // the events of the other queue don't concern this one
+    QVERIFY(!m_queue->hasPendingEvents());
+
+    queue.dispatch();
+    QVERIFY(!announcedSpy.isEmpty());
+    QVERIFY(!queue.hasPendingEvents());
+}
+
+void TestWaylandRegistry::testReadyContinuation()
+{
+    // this test verifies that the startup continuation runs once the requested interfaces are ready
+    using namespace KWayland::Client;
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    registry.requestInterface(Registry::Interface::Seat);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(!registry.requestedInterfacesAreReady());
+
+    int called = 0;
+    bool hasPointer = false;
+    registry.whenRequestedInterfacesReady(this, [&] {
+        ++called;
+        auto seat = qobject_cast<Seat *>(registry.requestedInterface(Registry::Interface::Seat));
+        hasPointer = seat && seat->hasPointer();
+    });
+    QTRY_COMPARE(called, 1);
+    QVERIFY(hasPointer);
+    QVERIFY(registry.requestedInterfacesAreReady());
+
+    // once ready the continuation is invoked right away
+    registry.whenRequestedInterfacesReady(this, [&] {
+        ++called;
+    });
+    QCOMPARE(called, 2);
+
+    // without requested interfaces it's ready with the announcements
+    Registry other;
+    other.setEventQueue(m_queue);
+    QSignalSpy announcedSpy(&other, &Registry::interfacesAnnounced);
+    QSignalSpy readySpy(&other, &Registry::requestedInterfacesReady);
+    other.create(m_connection);
+    other.setup();
+    QVERIFY(readySpy.wait());
+    QCOMPARE(announcedSpy.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestWaylandRegistry)
+#include "test_wayland_registry.moc"
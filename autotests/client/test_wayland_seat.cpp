@@ -5,12 +5,17 @@
 */
 // Qt
 #include <QtTest>
+#include <QScopeGuard>
+#include <QSemaphore>
 // KWin
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/compositor_interface.h"
+#include "../../src/server/cursorshape_v1_interface.h"
 #include "../../src/server/datadevicemanager_interface.h"
 #include "../../src/server/datasource_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/keyboard_interface.h"
+#include "../../src/server/keyboard_interface_p.h"
 #include "../../src/server/pointer_interface.h"
 #include "../../src/server/pointergestures_v1_interface.h"
 #include "../../src/server/relativepointer_v1_interface.h"
@@ -20,6 +25,7 @@
 #include "../../src/server/surface_interface.h"
 #include "../../src/client/compositor.h"
 #include "../../src/client/connection_thread.h"
+#include "../../src/client/cursorshape.h"
 #include "../../src/client/datadevice.h"
 #include "../../src/client/datadevicemanager.h"
 #include "../../src/client/datasource.h"
@@ -42,6 +48,7 @@
 #include <linux/input.h>
 // System
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 class TestWaylandSeat : public QObject
@@ -57,24 +64,33 @@ private Q_SLOTS:
     void testCapabilities_data();
     void testCapabilities();
     void testPointer();
+    void testPointerMotionCoalescing();
+    void testPointerMotionCongestion();
+    void testRelativePointerAccumulation();
     void testPointerTransformation_data();
     void testPointerTransformation();
     void testPointerButton_data();
     void testPointerButton();
+    void testImplicitPointerGrab();
     void testPointerSubSurfaceTree();
     void testPointerSwipeGesture_data();
     void testPointerSwipeGesture();
     void testPointerPinchGesture_data();
     void testPointerPinchGesture();
+    void testPointerGestureCoalescing();
     void testPointerHoldGesture_data();
     void testPointerHoldGesture();
     void testPointerAxis();
+    void testPointerFrameAggregation();
     void testCursor();
     void testCursorDamage();
+    void testCursorShape();
     void testKeyboard();
+    void testKeyboardPressedKeys();
     void testSelection();
     void testDataDeviceForKeyboardSurface();
     void testTouch();
+    void testTouchMotionCoalescing();
     void testKeymap();
 
 private:
@@ -516,6 +532,261 @@ void TestWaylandSeat::testPointer()
     QCOMPARE(relativeMotionSpy.last().at(2).value<quint64>(), quint64(1));
 }
 
+void TestWaylandSeat::testPointerMotionCoalescing()
+{
+    // this test verifies that with motion coalescing only the last position and the sum of the
+    // relative motion is sent to the client on flush, with a single frame event
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &KWayland::Client::Seat::hasPointerChanged);
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(image.rect());
+    s->commit(Surface::CommitFlag::None);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.wait());
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QScopedPointer<RelativePointer> relativePointer(m_relativePointerManager->createRelativePointer(p.data()));
+    QVERIFY(relativePointer->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy frameSpy(p.data(), &Pointer::frame);
+    QVERIFY(frameSpy.isValid());
+    QSignalSpy motionSpy(p.data(), &Pointer::motion);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy relativeMotionSpy(relativePointer.data(), &RelativePointer::relativeMotion);
+    QVERIFY(relativeMotionSpy.isValid());
+
+    m_seatInterface->notifyPointerMotion(QPoint(10, 15));
+    m_seatInterface->setFocusedPointerSurface(serverSurface, QPoint(0, 0));
+    QVERIFY(enteredSpy.wait());
+    frameSpy.clear();
+
+    QVERIFY(!m_seatInterface->pointerMotionCoalescing());
+    m_seatInterface->setPointerMotionCoalescing(true);
+    QVERIFY(m_seatInterface->pointerMotionCoalescing());
+
+    QSignalSpy pointerPosChangedSpy(m_seatInterface, &SeatInterface::pointerPosChanged);
+    QVERIFY(pointerPosChangedSpy.isValid());
+    for (int i = 1; i <= 5; ++i) {
+        m_seatInterface->setTimestamp(i);
+        m_seatInterface->notifyPointerMotion(QPoint(10 + i, 15 + i));
+        m_seatInterface->relativePointerMotion(QSizeF(1, 2), QSizeF(3, 4), quint64(i));
+        m_seatInterface->notifyPointerFrame();
+    }
+    // the compositor still sees every position change
+    QCOMPARE(pointerPosChangedSpy.count(), 5);
+    QCOMPARE(m_seatInterface->pointerPos(), QPointF(15, 20));
+
+    m_display->flush();
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 1);
+    QCOMPARE(motionSpy.first().first().toPoint(), QPoint(15, 20));
+    QCOMPARE(motionSpy.first().last().value<quint32>(), quint32(5));
+    QTRY_COMPARE(relativeMotionSpy.count(), 1);
+    QCOMPARE(relativeMotionSpy.first().at(0).toSizeF(), QSizeF(5, 10));
+    QCOMPARE(relativeMotionSpy.first().at(1).toSizeF(), QSizeF(15, 20));
+    QCOMPARE(relativeMotionSpy.first().at(2).value<quint64>(), quint64(5));
+    QTRY_COMPARE(frameSpy.count(), 1);
+
+    // a button event flushes the pending motion before the button is sent
+    QSignalSpy buttonSpy(p.data(), &Pointer::buttonStateChanged);
+    QVERIFY(buttonSpy.isValid());
+    m_seatInterface->notifyPointerMotion(QPoint(30, 30));
+    m_seatInterface->notifyPointerButton(BTN_LEFT, PointerButtonState::Pressed);
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(buttonSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPoint(), QPoint(30, 30));
+    QTRY_COMPARE(frameSpy.count(), 2);
+
+    m_seatInterface->setPointerMotionCoalescing(false);
+}
+
+void TestWaylandSeat::testPointerMotionCongestion()
+{
+    // this test verifies that the motion for a client which doesn't read its events is coalesced
+    // until the client caught up
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &KWayland::Client::Seat::hasPointerChanged);
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(image.rect());
+    s->commit(Surface::CommitFlag::None);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.wait());
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QScopedPointer<RelativePointer> relativePointer(m_relativePointerManager->createRelativePointer(p.data()));
+    QVERIFY(relativePointer->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy motionSpy(p.data(), &Pointer::motion);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy relativeMotionSpy(relativePointer.data(), &RelativePointer::relativeMotion);
+    QVERIFY(relativeMotionSpy.isValid());
+
+    m_seatInterface->notifyPointerMotion(QPoint(10, 15));
+    m_seatInterface->setFocusedPointerSurface(serverSurface, QPoint(0, 0));
+    QVERIFY(enteredSpy.wait());
+
+    ClientConnection *client = serverSurface->client();
+    QSignalSpy congestedSpy(client, &ClientConnection::congested);
+    QVERIFY(congestedSpy.isValid());
+    QSignalSpy relievedSpy(client, &ClientConnection::congestionRelieved);
+    QVERIFY(relievedSpy.isValid());
+
+    // the connection thread stops reading the socket
+    QSemaphore blocked;
+    QSemaphore unblock;
+    auto unblockGuard = qScopeGuard([&unblock] {
+        unblock.release();
+    });
+    QMetaObject::invokeMethod(
+        m_connection,
+        [&blocked, &unblock] {
+            blocked.release();
+            unblock.acquire();
+        },
+        Qt::QueuedConnection);
+    blocked.acquire();
+
+    // any unread event makes the client congested
+    m_display->setClientCongestionThreshold(1);
+    m_seatInterface->notifyPointerMotion(QPoint(11, 16));
+    m_display->flush();
+    QVERIFY(client->isCongested());
+    QCOMPARE(congestedSpy.count(), 1);
+
+    for (int i = 2; i <= 5; ++i) {
+        m_seatInterface->setTimestamp(i);
+        m_seatInterface->notifyPointerMotion(QPoint(10 + i, 15 + i));
+        m_seatInterface->relativePointerMotion(QSizeF(1, 2), QSizeF(3, 4), quint64(i));
+        m_seatInterface->notifyPointerFrame();
+    }
+    // flushing keeps the motion back while the client is congested
+    m_seatInterface->flushPointerMotion();
+    m_display->flush();
+
+    unblockGuard.dismiss();
+    unblock.release();
+    QVERIFY(relievedSpy.wait());
+    QVERIFY(!client->isCongested());
+    QTRY_COMPARE(motionSpy.count(), 1);
+    QCOMPARE(motionSpy.first().first().toPoint(), QPoint(11, 16));
+    QCOMPARE(relativeMotionSpy.count(), 0);
+
+    // the latest position and the sum of the relative motion go out with the next flush
+    m_seatInterface->flushPointerMotion();
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPoint(), QPoint(15, 20));
+    QTRY_COMPARE(relativeMotionSpy.count(), 1);
+    QCOMPARE(relativeMotionSpy.first().at(0).toSizeF(), QSizeF(4, 8));
+    QCOMPARE(relativeMotionSpy.first().at(1).toSizeF(), QSizeF(12, 16));
+
+    m_display->setClientCongestionThreshold(0);
+}
+
+void TestWaylandSeat::testRelativePointerAccumulation()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(image.rect());
+    s->commit(Surface::CommitFlag::None);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.wait());
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QScopedPointer<RelativePointer> relativePointer(m_relativePointerManager->createRelativePointer(p.data()));
+    QVERIFY(relativePointer->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy frameSpy(p.data(), &Pointer::frame);
+    QVERIFY(frameSpy.isValid());
+    QSignalSpy relativeMotionSpy(relativePointer.data(), &RelativePointer::relativeMotion);
+    QVERIFY(relativeMotionSpy.isValid());
+
+    m_seatInterface->notifyPointerMotion(QPoint(10, 15));
+    m_seatInterface->setFocusedPointerSurface(serverSurface, QPoint(0, 0));
+    QVERIFY(enteredSpy.wait());
+    frameSpy.clear();
+
+    QVERIFY(!relativePointer->isAccumulating());
+    relativePointer->setAccumulating(true);
+    QVERIFY(relativePointer->isAccumulating());
+    QCOMPARE(relativePointer->takeAccumulatedMotion().eventCount, 0);
+
+    // fractions of a pixel as sent by high resolution mice
+    for (int i = 1; i <= 8; ++i) {
+        m_seatInterface->relativePointerMotion(QSizeF(0.125, -0.25), QSizeF(0.0625, 0.5), quint64(1000 + i));
+    }
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(relativeMotionSpy.count(), 0);
+
+    RelativePointer::AccumulatedMotion motion = relativePointer->takeAccumulatedMotion();
+    QCOMPARE(motion.eventCount, 8);
+    QCOMPARE(motion.delta, QSizeF(1, -2));
+    QCOMPARE(motion.deltaNonAccelerated, QSizeF(0.5, 4));
+    QCOMPARE(motion.timestamp, quint64(1008));
+    QCOMPARE(relativePointer->takeAccumulatedMotion().eventCount, 0);
+
+    // without accumulation every event is emitted again
+    relativePointer->setAccumulating(false);
+    m_seatInterface->relativePointerMotion(QSizeF(1, 2), QSizeF(3, 4), quint64(2000));
+    QVERIFY(relativeMotionSpy.wait());
+    QCOMPARE(relativeMotionSpy.first().at(0).toSizeF(), QSizeF(1, 2));
+    QCOMPARE(relativePointer->takeAccumulatedMotion().eventCount, 0);
+}
+
 void TestWaylandSeat::testPointerTransformation_data()
 {
     QTest::addColumn<QMatrix4x4>("enterTransformation");
@@ -728,6 +999,37 @@ void TestWaylandSeat::testPointerButton()
     QCOMPARE(buttonChangedSpy.last().at(3).value<KWayland::Client::Pointer::ButtonState>(), Pointer::ButtonState::Released);
 }
 
+void TestWaylandSeat::testImplicitPointerGrab()
+{
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &KWayland::Client::Seat::hasPointerChanged);
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    const quint32 left = 0x110;
+    const quint32 right = 0x111;
+    m_seatInterface->notifyPointerButton(left, PointerButtonState::Pressed);
+    const quint32 leftSerial = m_seatInterface->pointerButtonSerial(left);
+    QVERIFY(m_seatInterface->hasImplicitPointerGrab(leftSerial));
+    QVERIFY(!m_seatInterface->hasImplicitPointerGrab(leftSerial + 1));
+
+    // the serial of the right button takes the slot of the left one in the serial history
+    for (int i = 0; i < 255; ++i) {
+        m_display->nextSerial();
+    }
+    m_seatInterface->notifyPointerButton(right, PointerButtonState::Pressed);
+    const quint32 rightSerial = m_seatInterface->pointerButtonSerial(right);
+    QCOMPARE(rightSerial, leftSerial + 256);
+    QVERIFY(m_seatInterface->hasImplicitPointerGrab(leftSerial));
+    QVERIFY(m_seatInterface->hasImplicitPointerGrab(rightSerial));
+
+    m_seatInterface->notifyPointerButton(left, PointerButtonState::Released);
+    QVERIFY(!m_seatInterface->hasImplicitPointerGrab(leftSerial));
+    m_seatInterface->notifyPointerButton(right, PointerButtonState::Released);
+    QVERIFY(!m_seatInterface->hasImplicitPointerGrab(rightSerial));
+}
+
 void TestWaylandSeat::testPointerSubSurfaceTree()
 {
     // this test verifies that pointer motion on a surface with sub-surfaces sends motion enter/leave to the sub-surface
@@ -1082,6 +1384,76 @@ void TestWaylandSeat::testPointerPinchGesture()
     QVERIFY(spy->wait());
 }
 
+void TestWaylandSeat::testPointerGestureCoalescing()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy hasPointerChangedSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(hasPointerChangedSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(hasPointerChangedSpy.wait());
+    QScopedPointer<Pointer> pointer(m_seat->createPointer());
+    QScopedPointer<PointerPinchGesture> gesture(m_pointerGestures->createPinchGesture(pointer.data()));
+    QVERIFY(gesture->isValid());
+
+    QSignalSpy startSpy(gesture.data(), &PointerPinchGesture::started);
+    QVERIFY(startSpy.isValid());
+    QSignalSpy updateSpy(gesture.data(), &PointerPinchGesture::updated);
+    QVERIFY(updateSpy.isValid());
+    QSignalSpy endSpy(gesture.data(), &PointerPinchGesture::ended);
+    QVERIFY(endSpy.isValid());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(image.rect());
+    surface->commit(Surface::CommitFlag::None);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.wait());
+
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    QVERIFY(!m_seatInterface->pointerGestureCoalescing());
+    m_seatInterface->setPointerGestureCoalescing(true);
+    QVERIFY(m_seatInterface->pointerGestureCoalescing());
+
+    m_seatInterface->setTimestamp(1);
+    m_seatInterface->startPointerPinchGesture(2);
+    QVERIFY(startSpy.wait());
+
+    // the deltas and rotations are summed up, the latest scale is sent
+    for (int i = 1; i <= 4; ++i) {
+        m_seatInterface->setTimestamp(1 + i);
+        m_seatInterface->updatePointerPinchGesture(QSizeF(1, 2), 1.0 + i * 0.25, 10);
+    }
+    m_display->flush();
+    QVERIFY(updateSpy.wait());
+    QCOMPARE(updateSpy.count(), 1);
+    QCOMPARE(updateSpy.first().at(0).toSizeF(), QSizeF(4, 8));
+    QCOMPARE(updateSpy.first().at(1).toReal(), 2.0);
+    QCOMPARE(updateSpy.first().at(2).toReal(), 40.0);
+    QCOMPARE(updateSpy.first().at(3).value<quint32>(), 5u);
+
+    // ending the gesture sends the pending update first
+    m_seatInterface->setTimestamp(10);
+    m_seatInterface->updatePointerPinchGesture(QSizeF(3, 3), 3, 5);
+    m_seatInterface->endPointerPinchGesture();
+    QVERIFY(endSpy.wait());
+    QCOMPARE(updateSpy.count(), 2);
+    QCOMPARE(updateSpy.last().at(0).toSizeF(), QSizeF(3, 3));
+    QCOMPARE(updateSpy.last().at(1).toReal(), 3.0);
+    QCOMPARE(updateSpy.last().at(2).toReal(), 5.0);
+
+    m_seatInterface->setPointerGestureCoalescing(false);
+}
+
 void TestWaylandSeat::testPointerHoldGesture_data()
 {
     QTest::addColumn<bool>("cancel");
@@ -1317,6 +1689,85 @@ void TestWaylandSeat::testPointerAxis()
     QCOMPARE(axisStoppedSpy.count(), 1);
 }
 
+void TestWaylandSeat::testPointerFrameAggregation()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy hasPointerChangedSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(hasPointerChangedSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(hasPointerChangedSpy.wait());
+    QScopedPointer<Pointer> pointer(m_seat->createPointer());
+    QVERIFY(pointer);
+    pointer->setFrameAggregation(true);
+    QVERIFY(pointer->frameAggregation());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(image.rect());
+    surface->commit(Surface::CommitFlag::None);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.wait());
+
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    QSignalSpy frameSpy(pointer.data(), &Pointer::frame);
+    QVERIFY(frameSpy.isValid());
+    QVERIFY(frameSpy.wait());
+
+    QSignalSpy aggregatedFrameSpy(pointer.data(), &Pointer::aggregatedFrame);
+    QVERIFY(aggregatedFrameSpy.isValid());
+    QSignalSpy motionSpy(pointer.data(), &Pointer::motion);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy buttonSpy(pointer.data(), &Pointer::buttonStateChanged);
+    QVERIFY(buttonSpy.isValid());
+    QSignalSpy axisSpy(pointer.data(), &Pointer::axisChanged);
+    QVERIFY(axisSpy.isValid());
+
+    // the motion, the press and the scroll arrive as one frame
+    m_seatInterface->setTimestamp(1);
+    m_seatInterface->notifyPointerMotion(QPoint(10, 16));
+    m_seatInterface->notifyPointerButton(1, PointerButtonState::Pressed);
+    m_seatInterface->notifyPointerAxis(Qt::Vertical, 10, 1, PointerAxisSource::Wheel);
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(aggregatedFrameSpy.count(), 1);
+    QVERIFY(motionSpy.isEmpty());
+    QVERIFY(buttonSpy.isEmpty());
+    QVERIFY(axisSpy.isEmpty());
+
+    const Pointer::Frame frame = aggregatedFrameSpy.first().first().value<Pointer::Frame>();
+    QVERIFY(frame.hasMotion);
+    QCOMPARE(frame.position, QPointF(10, 16));
+    QCOMPARE(frame.motionTime, 1u);
+    QCOMPARE(frame.buttons.count(), 1);
+    QCOMPARE(frame.buttons.first().button, 1u);
+    QCOMPARE(frame.buttons.first().state, Pointer::ButtonState::Pressed);
+    QVERIFY(frame.hasAxisSource);
+    QCOMPARE(frame.axisSource, Pointer::AxisSource::Wheel);
+    QVERIFY(frame.vertical.changed);
+    QCOMPARE(frame.vertical.delta, 10.0);
+    QCOMPARE(frame.vertical.discreteDelta, 1);
+    QVERIFY(!frame.horizontal.changed);
+
+    // without aggregation the events are emitted individually again
+    pointer->setFrameAggregation(false);
+    m_seatInterface->setTimestamp(2);
+    m_seatInterface->notifyPointerButton(1, PointerButtonState::Released);
+    m_seatInterface->notifyPointerFrame();
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(aggregatedFrameSpy.count(), 1);
+    QCOMPARE(buttonSpy.count(), 1);
+}
+
 void TestWaylandSeat::testCursor()
 {
     using namespace KWayland::Client;
@@ -1496,6 +1947,79 @@ void TestWaylandSeat::testCursorDamage()
     QCOMPARE(qobject_cast<ShmClientBuffer *>(pointer->cursor()->surface()->buffer())->data(), blue);
 }
 
+void TestWaylandSeat::testCursorShape()
+{
+    // this test verifies that a cursor shape replaces the cursor surface and is only accepted from the focused client
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    new CursorShapeManagerV1Interface(m_display, m_display);
+    Registry registry;
+    QSignalSpy cursorShapeAnnouncedSpy(&registry, &Registry::cursorShapeManagerV1Announced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(cursorShapeAnnouncedSpy.wait());
+    QScopedPointer<CursorShapeManager> cursorShapeManager(
+        registry.createCursorShapeManager(cursorShapeAnnouncedSpy.first().first().value<quint32>(), cursorShapeAnnouncedSpy.first().last().value<quint32>()));
+    QVERIFY(cursorShapeManager->isValid());
+
+    QSignalSpy pointerSpy(m_seat, &Seat::hasPointerChanged);
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QScopedPointer<CursorShapeDevice> device(cursorShapeManager->createDevice(p.data()));
+    QVERIFY(device->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(image.rect());
+    surface->commit(Surface::CommitFlag::None);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.wait());
+
+    // without the pointer focus the shape is ignored
+    QSignalSpy cursorChangedSpy(m_seatInterface->pointer(), &PointerInterface::cursorChanged);
+    device->setShape(0, CursorShapeDevice::Shape::Text);
+    wl_display_flush(m_connection->display());
+    QVERIFY(!cursorChangedSpy.wait(100));
+    QVERIFY(!m_seatInterface->pointer()->cursor());
+
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    QVERIFY(enteredSpy.wait());
+    const quint32 serial = enteredSpy.first().first().value<quint32>();
+
+    device->setShape(serial, CursorShapeDevice::Shape::Text);
+    QVERIFY(cursorChangedSpy.wait());
+    Cursor *cursor = m_seatInterface->pointer()->cursor();
+    QVERIFY(cursor);
+    QCOMPARE(cursor->shape(), QByteArrayLiteral("text"));
+    QVERIFY(!cursor->surface());
+    QCOMPARE(cursor->enteredSerial(), serial);
+
+    // a cursor surface replaces the shape, and the other way round
+    QSignalSpy shapeChangedSpy(cursor, &Cursor::shapeChanged);
+    QScopedPointer<Surface> cursorSurface(m_compositor->createSurface());
+    p->setCursor(cursorSurface.data(), QPoint(1, 2));
+    QVERIFY(shapeChangedSpy.wait());
+    QVERIFY(cursor->shape().isEmpty());
+    QVERIFY(cursor->surface());
+
+    device->setShape(serial, CursorShapeDevice::Shape::NWSEResize);
+    QVERIFY(shapeChangedSpy.wait());
+    QCOMPARE(cursor->shape(), QByteArrayLiteral("nwse-resize"));
+    QVERIFY(!cursor->surface());
+    QCOMPARE(cursor->hotspot(), QPoint());
+}
+
 void TestWaylandSeat::testKeyboard()
 {
     using namespace KWayland::Client;
@@ -1674,6 +2198,50 @@ void TestWaylandSeat::testKeyboard()
     QCOMPARE(m_seatInterface->keyboard(), serverKeyboard);
 }
 
+void TestWaylandSeat::testKeyboardPressedKeys()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy keyboardSpy(m_seat, &KWayland::Client::Seat::hasKeyboardChanged);
+    m_seatInterface->setHasKeyboard(true);
+    QVERIFY(keyboardSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+
+    QScopedPointer<Keyboard> keyboard(m_seat->createKeyboard());
+    QSignalSpy enteredSpy(keyboard.data(), &KWayland::Client::Keyboard::entered);
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface);
+    QVERIFY(enteredSpy.wait());
+    auto serverKeyboard = KeyboardInterfacePrivate::get(m_seatInterface->keyboard());
+
+    // a key that has never been pressed isn't released, not even the first time
+    QSignalSpy keyChangedSpy(keyboard.data(), &KWayland::Client::Keyboard::keyChanged);
+    m_seatInterface->notifyKeyboardKey(KEY_A, KeyboardKeyState::Released);
+    QVERIFY(!keyChangedSpy.wait(200));
+
+    // only the pressed keys are kept, sorted, which is what wl_keyboard.enter sends
+    m_seatInterface->notifyKeyboardKey(KEY_K, KeyboardKeyState::Pressed);
+    m_seatInterface->notifyKeyboardKey(KEY_D, KeyboardKeyState::Pressed);
+    m_seatInterface->notifyKeyboardKey(KEY_E, KeyboardKeyState::Pressed);
+    QTRY_COMPARE(keyChangedSpy.count(), 3);
+    const quint32 pressed[] = {KEY_E, KEY_D, KEY_K};
+    QCOMPARE(serverKeyboard->pressedKeysData(), QByteArray(reinterpret_cast<const char *>(pressed), sizeof(pressed)));
+
+    m_seatInterface->notifyKeyboardKey(KEY_E, KeyboardKeyState::Released);
+    QVERIFY(keyChangedSpy.wait());
+    const quint32 stillPressed[] = {KEY_D, KEY_K};
+    QCOMPARE(serverKeyboard->pressedKeysData(), QByteArray(reinterpret_cast<const char *>(stillPressed), sizeof(stillPressed)));
+
+    m_seatInterface->notifyKeyboardKey(KEY_D, KeyboardKeyState::Released);
+    m_seatInterface->notifyKeyboardKey(KEY_K, KeyboardKeyState::Released);
+    QTRY_COMPARE(keyChangedSpy.count(), 6);
+    QVERIFY(serverKeyboard->pressedKeysData().isEmpty());
+}
+
 void TestWaylandSeat::testSelection()
 {
     using namespace KWayland::Client;
@@ -2065,6 +2633,79 @@ void TestWaylandSeat::testTouch()
     QCOMPARE(touch->sequence().first()->position(), QPointF(0, 0));
 }
 
+void TestWaylandSeat::testTouchMotionCoalescing()
+{
+    // this test verifies that with motion coalescing every touch point that moved is sent to the
+    // client once per frame, with its last position
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy touchSpy(m_seat, &KWayland::Client::Seat::hasTouchChanged);
+    QVERIFY(touchSpy.isValid());
+    m_seatInterface->setHasTouch(true);
+    QVERIFY(touchSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<Touch> touch(m_seat->createTouch());
+    QVERIFY(touch->isValid());
+    wl_display_flush(m_connection->display());
+    QCoreApplication::processEvents();
+    m_seatInterface->setFocusedTouchSurface(serverSurface);
+
+    QSignalSpy frameEndedSpy(touch.data(), &KWayland::Client::Touch::frameEnded);
+    QVERIFY(frameEndedSpy.isValid());
+    QSignalSpy pointMovedSpy(touch.data(), &KWayland::Client::Touch::pointMoved);
+    QVERIFY(pointMovedSpy.isValid());
+
+    QVERIFY(!m_seatInterface->touchMotionCoalescing());
+    m_seatInterface->setTouchMotionCoalescing(true);
+    QVERIFY(m_seatInterface->touchMotionCoalescing());
+
+    m_seatInterface->notifyTouchDown(0, QPointF(10, 10));
+    m_seatInterface->notifyTouchDown(1, QPointF(20, 20));
+    m_seatInterface->notifyTouchFrame();
+    QVERIFY(frameEndedSpy.wait());
+    QCOMPARE(touch->sequence().count(), 2);
+
+    QSignalSpy touchMovedSpy(m_seatInterface, &SeatInterface::touchMoved);
+    QVERIFY(touchMovedSpy.isValid());
+    for (int i = 1; i <= 5; ++i) {
+        m_seatInterface->notifyTouchMotion(0, QPointF(10 + i, 10));
+        m_seatInterface->notifyTouchMotion(1, QPointF(20, 20 + i));
+    }
+    // nothing goes out before the frame
+    QCOMPARE(touchMovedSpy.count(), 0);
+    QCOMPARE(m_seatInterface->firstTouchPointPosition(), QPointF(15, 10));
+
+    m_seatInterface->notifyTouchFrame();
+    QVERIFY(frameEndedSpy.wait());
+    QCOMPARE(frameEndedSpy.count(), 2);
+    QCOMPARE(pointMovedSpy.count(), 2);
+    QCOMPARE(touchMovedSpy.count(), 2);
+    QCOMPARE(touch->sequence().at(0)->position(), QPointF(15, 10));
+    QCOMPARE(touch->sequence().at(1)->position(), QPointF(20, 25));
+
+    // an up event sends the pending motion first
+    m_seatInterface->notifyTouchMotion(1, QPointF(30, 30));
+    m_seatInterface->notifyTouchUp(1);
+    m_seatInterface->notifyTouchUp(0);
+    m_seatInterface->notifyTouchFrame();
+    QVERIFY(frameEndedSpy.wait());
+    QCOMPARE(pointMovedSpy.count(), 3);
+    QCOMPARE(touch->sequence().at(1)->position(), QPointF(30, 30));
+    QVERIFY(!m_seatInterface->isTouchSequence());
+
+    m_seatInterface->setTouchMotionCoalescing(false);
+    m_seatInterface->setHasTouch(false);
+    QVERIFY(touchSpy.wait());
+}
+
 void TestWaylandSeat::testKeymap()
 {
     using namespace KWayland::Client;
@@ -2094,7 +2735,8 @@ void TestWaylandSeat::testKeymap()
     QVERIFY(keymapChangedSpy.wait());
     int fd = keymapChangedSpy.first().first().toInt();
     QVERIFY(fd != -1);
-    QCOMPARE(keymapChangedSpy.first().last().value<quint32>(), 3u);
+    // the size includes the terminating null byte
+    QCOMPARE(keymapChangedSpy.first().last().value<quint32>(), 4u);
     QFile file;
     QVERIFY(file.open(fd, QIODevice::ReadOnly));
     const char *address = reinterpret_cast<char *>(file.map(0, keymapChangedSpy.first().last().value<quint32>()));
@@ -2108,11 +2750,33 @@ void TestWaylandSeat::testKeymap()
     QVERIFY(keymapChangedSpy.wait());
     fd = keymapChangedSpy.first().first().toInt();
     QVERIFY(fd != -1);
-    QCOMPARE(keymapChangedSpy.first().last().value<quint32>(), 3u);
+    QCOMPARE(keymapChangedSpy.first().last().value<quint32>(), 4u);
+    // before version 7 a client may map the keymap writable and shared, so it gets a copy of its own
     QVERIFY(file.open(fd, QIODevice::ReadWrite));
     address = reinterpret_cast<char *>(file.map(0, keymapChangedSpy.first().last().value<quint32>()));
     QVERIFY(address);
     QCOMPARE(qstrcmp(address, "bar"), 0);
+    file.close();
+
+    // a keyboard created later gets another copy
+    keymapChangedSpy.clear();
+    QScopedPointer<Keyboard> keyboard2(m_seat->createKeyboard());
+    QSignalSpy keymapChangedSpy2(keyboard2.data(), &Keyboard::keymapChanged);
+    QVERIFY(keymapChangedSpy2.wait());
+    const int fd2 = keymapChangedSpy2.first().first().toInt();
+    QVERIFY(fd2 != -1);
+    QCOMPARE(keymapChangedSpy2.first().last().value<quint32>(), 4u);
+    struct stat st1;
+    struct stat st2;
+    QCOMPARE(fstat(fd, &st1), 0);
+    QCOMPARE(fstat(fd2, &st2), 0);
+    QVERIFY(st1.st_dev != st2.st_dev || st1.st_ino != st2.st_ino);
+    QVERIFY(keymapChangedSpy.isEmpty());
+
+    // and both keyboards share the content of the keymap
+    QCOMPARE(keyboard->keymap(), QByteArrayLiteral("bar"));
+    QCOMPARE(keyboard2->keymap(), QByteArrayLiteral("bar"));
+    QCOMPARE(keyboard2->keymap().constData(), keyboard->keymap().constData());
 }
 
 QTEST_GUILESS_MAIN(TestWaylandSeat)
@@ -47,6 +47,8 @@ private Q_SLOTS:
     void testSurfaceAt();
     void testDestroyAttachedBuffer();
     void testDestroyParentSurface();
+    void testTreeDamage();
+    void testRenderList();
 
 private:
     KWaylandServer::Display *m_display;
@@ -423,6 +425,7 @@ void TestSubSurface::testPlaceAbove()
     QCOMPARE(serverSubSurface1->parentSurface()->above().at(2), serverSubSurface1);
 
     // try placing 1 above 3 - shouldn't change
+    QSignalSpy childrenChangedSpy(serverSubSurface1->parentSurface(), &SurfaceInterface::childSubSurfacesChanged);
     subSurface1->placeAbove(QPointer<SubSurface>(subSurface3.data()));
     parent->commit(Surface::CommitFlag::None);
     wl_display_flush(m_connection->display());
@@ -431,6 +434,8 @@ void TestSubSurface::testPlaceAbove()
     QCOMPARE(serverSubSurface1->parentSurface()->above().at(0), serverSubSurface2);
     QCOMPARE(serverSubSurface1->parentSurface()->above().at(1), serverSubSurface3);
     QCOMPARE(serverSubSurface1->parentSurface()->above().at(2), serverSubSurface1);
+    // a request that keeps the order doesn't restack
+    QCOMPARE(childrenChangedSpy.count(), 0);
 
     // and 2 above 3 - > 3, 2, 1
     subSurface2->placeAbove(QPointer<SubSurface>(subSurface3.data()));
@@ -1066,5 +1071,163 @@ void TestSubSurface::testDestroyParentSurface()
     QVERIFY(destroySpy.wait());
 }
 
+void TestSubSurface::testTreeDamage()
+{
+    // this test verifies that the damage of the sub-surface tree is accumulated in the parent
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QScopedPointer<Surface> parent(m_compositor->createSurface());
+    QScopedPointer<Surface> child(m_compositor->createSurface());
+
+    QSignalSpy subSurfaceCreatedSpy(m_subcompositorInterface, &SubCompositorInterface::subSurfaceCreated);
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(QPointer<Surface>(child.data()), QPointer<Surface>(parent.data())));
+    QVERIFY(subSurfaceCreatedSpy.wait());
+    SubSurfaceInterface *serverSubSurface = subSurfaceCreatedSpy.first().first().value<SubSurfaceInterface *>();
+    SurfaceInterface *serverParent = serverSubSurface->parentSurface();
+    QVERIFY(!serverParent->treeDamageTracking());
+    serverParent->setTreeDamageTracking(true);
+    QVERIFY(serverParent->treeDamageTracking());
+    QVERIFY(serverParent->treeDamage().isEmpty());
+
+    QSignalSpy parentCommittedSpy(serverParent, &SurfaceInterface::committed);
+    QSignalSpy treeDamagedSpy(serverParent, &SurfaceInterface::treeDamaged);
+
+    // mapping the parent damages all of it
+    QImage parentImage(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    parentImage.fill(Qt::red);
+    parent->attachBuffer(m_shm->createBuffer(parentImage));
+    parent->damage(QRect(0, 0, 100, 100));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QVERIFY(!treeDamagedSpy.isEmpty());
+    QCOMPARE(serverParent->takeTreeDamage(), QRegion(0, 0, 100, 100));
+    QVERIFY(serverParent->treeDamage().isEmpty());
+
+    // the damage of the child is mapped by its position
+    QImage childImage(QSize(20, 20), QImage::Format_ARGB32_Premultiplied);
+    childImage.fill(Qt::blue);
+    subSurface->setPosition(QPoint(10, 10));
+    child->attachBuffer(m_shm->createBuffer(childImage));
+    child->damage(QRect(0, 0, 20, 20));
+    child->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(serverParent->takeTreeDamage(), QRegion(10, 10, 20, 20));
+
+    // moving the child damages the old and the new area
+    subSurface->setPosition(QPoint(50, 60));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(serverParent->takeTreeDamage(), QRegion(10, 10, 20, 20).united(QRect(50, 60, 20, 20)));
+
+    // and so does removing it
+    subSurface.reset();
+    child.reset();
+    QVERIFY(treeDamagedSpy.wait());
+    QCOMPARE(serverParent->takeTreeDamage(), QRegion(50, 60, 20, 20));
+
+    serverParent->setTreeDamageTracking(false);
+    parent->attachBuffer(m_shm->createBuffer(parentImage));
+    parent->damage(QRect(0, 0, 100, 100));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QVERIFY(serverParent->treeDamage().isEmpty());
+}
+
+void TestSubSurface::testRenderList()
+{
+    // this test verifies that the render list of a surface tree follows commits, moves and restacking
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QScopedPointer<Surface> parent(m_compositor->createSurface());
+    QScopedPointer<Surface> child(m_compositor->createSurface());
+
+    QSignalSpy subSurfaceCreatedSpy(m_subcompositorInterface, &SubCompositorInterface::subSurfaceCreated);
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(QPointer<Surface>(child.data()), QPointer<Surface>(parent.data())));
+    QVERIFY(subSurfaceCreatedSpy.wait());
+    SubSurfaceInterface *serverSubSurface = subSurfaceCreatedSpy.first().first().value<SubSurfaceInterface *>();
+    SurfaceInterface *serverParent = serverSubSurface->parentSurface();
+    SurfaceInterface *serverChild = serverSubSurface->surface();
+    QVERIFY(serverParent->renderList().isEmpty());
+
+    QSignalSpy parentCommittedSpy(serverParent, &SurfaceInterface::committed);
+
+    QImage parentImage(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    parentImage.fill(Qt::red);
+    parent->attachBuffer(m_shm->createBuffer(parentImage));
+    parent->damage(QRect(0, 0, 100, 100));
+    parent->setOpaqueRegion(QRegion(0, 0, 100, 100));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QVector<SurfaceInterface::RenderItem> renderList = serverParent->renderList();
+    QCOMPARE(renderList.count(), 1);
+    QCOMPARE(renderList[0].surface, serverParent);
+    QCOMPARE(renderList[0].buffer, serverParent->buffer());
+    QCOMPARE(renderList[0].geometry, QRect(0, 0, 100, 100));
+    QCOMPARE(renderList[0].flags, SurfaceInterface::RenderItem::Flags(SurfaceInterface::RenderItem::Opaque));
+
+    // the child is mapped above its parent
+    QImage childImage(QSize(20, 20), QImage::Format_ARGB32_Premultiplied);
+    childImage.fill(Qt::blue);
+    subSurface->setPosition(QPoint(10, 10));
+    child->attachBuffer(m_shm->createBuffer(childImage));
+    child->damage(QRect(0, 0, 20, 20));
+    child->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    quint64 version = serverParent->renderListVersion();
+    renderList = serverParent->renderList();
+    QCOMPARE(renderList.count(), 2);
+    QCOMPARE(renderList[0].surface, serverParent);
+    QCOMPARE(renderList[1].surface, serverChild);
+    QCOMPARE(renderList[1].geometry, QRect(10, 10, 20, 20));
+    QCOMPARE(renderList[1].flags, SurfaceInterface::RenderItem::Flags());
+    QCOMPARE(serverParent->renderListVersion(), version);
+
+    // a new buffer of the child updates its item in place
+    QImage biggerChildImage(QSize(40, 30), QImage::Format_ARGB32_Premultiplied);
+    biggerChildImage.fill(Qt::green);
+    child->attachBuffer(m_shm->createBuffer(biggerChildImage));
+    child->damage(QRect(0, 0, 40, 30));
+    child->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QVERIFY(serverParent->renderListVersion() > version);
+    version = serverParent->renderListVersion();
+    renderList = serverParent->renderList();
+    QCOMPARE(renderList.count(), 2);
+    QCOMPARE(renderList[1].buffer, serverChild->buffer());
+    QCOMPARE(renderList[1].geometry, QRect(10, 10, 40, 30));
+    QCOMPARE(serverParent->renderListVersion(), version);
+
+    // moving the child moves its item
+    subSurface->setPosition(QPoint(50, 60));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QVERIFY(serverParent->renderListVersion() > version);
+    renderList = serverParent->renderList();
+    QCOMPARE(renderList[1].geometry, QRect(50, 60, 40, 30));
+
+    // restacking the child below the parent reorders the list
+    subSurface->placeBelow(QPointer<Surface>(parent.data()));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    renderList = serverParent->renderList();
+    QCOMPARE(renderList.count(), 2);
+    QCOMPARE(renderList[0].surface, serverChild);
+    QCOMPARE(renderList[1].surface, serverParent);
+
+    // and unmapping the child removes it
+    version = serverParent->renderListVersion();
+    child->attachBuffer(static_cast<wl_buffer *>(nullptr));
+    child->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QVERIFY(serverParent->renderListVersion() > version);
+    renderList = serverParent->renderList();
+    QCOMPARE(renderList.count(), 1);
+    QCOMPARE(renderList[0].surface, serverParent);
+}
+
 QTEST_GUILESS_MAIN(TestSubSurface)
 #include "test_wayland_subsurface.moc"
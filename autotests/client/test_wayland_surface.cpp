@@ -5,13 +5,21 @@
 */
 // Qt
 #include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QPainter>
 #include <QtTest>
 // KWin
 #include "../../src/server/clientbuffer.h"
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
+#include "../../src/server/idle_interface.h"
 #include "../../src/server/idleinhibit_v1_interface.h"
+#include "../../src/server/occlusiontracker.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputframeclock.h"
+#include "../../src/server/scanoutevaluator.h"
 #include "../../src/server/shmclientbuffer.h"
 #include "../../src/server/surface_interface.h"
 #include "../../src/client/compositor.h"
@@ -26,8 +34,12 @@
 // Wayland
 #include <wayland-client-protocol.h>
 
+#include <unistd.h>
+
 using KWayland::Client::Registry;
 
+Q_DECLARE_METATYPE(std::chrono::nanoseconds)
+
 class TestWaylandSurface : public QObject
 {
     Q_OBJECT
@@ -39,19 +51,38 @@ private Q_SLOTS:
 
     void testStaticAccessor();
     void testDamage();
+    void testFlushCounters();
     void testFrameCallback();
+    void testFrameCallbackThrottling();
+    void testFrameCallbackPolicy();
+    void testFrameClock();
+    void testCommitTrace();
+    void testSnapshot();
     void testAttachBuffer();
+    void testReleaseAfterUpload();
+    void testReleaseAfterUploadWhileHeld();
     void testMultipleSurfaces();
     void testOpaque();
+    void testCachedRegion();
+    void testOcclusionTracker();
+    void testScanoutEvaluator();
+    void testConvertShmDamage_data();
+    void testConvertShmDamage();
     void testInput();
     void testScale();
+    void testDamageBufferTransform_data();
+    void testDamageBufferTransform();
+    void testBufferDamage();
     void testUnmapOfNotMappedSurface();
     void testSurfaceAt();
     void testDestroyAttachedBuffer();
+    void testDestroyAccessedBuffer();
     void testDestroyWithPendingCallback();
     void testOutput();
+    void testOutputBoundLater();
     void testDisconnect();
     void testInhibit();
+    void testInhibitAggregate();
 
 private:
     KWaylandServer::Display *m_display;
@@ -227,7 +258,9 @@ void TestWaylandSurface::testStaticAccessor()
     const quint32 surfaceId2 = serverSurface2->id();
 
     // delete s2 again
+    wl_surface *native2 = *s2;
     delete s2;
+    QVERIFY(!KWayland::Client::Surface::get(native2));
     QCOMPARE(KWayland::Client::Surface::all().count(), 1);
     QCOMPARE(KWayland::Client::Surface::all().first(), s1);
     QCOMPARE(KWayland::Client::Surface::get(*s1), s1);
@@ -333,6 +366,31 @@ void TestWaylandSurface::testDamage()
     QVERIFY(serverSurface->isMapped());
 }
 
+void TestWaylandSurface::testFlushCounters()
+{
+    // this test verifies that the bytes written by flushing the connection are accounted for
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    m_connection->flush();
+    const quint64 bytes = m_connection->flushedBytes();
+    const quint64 flushes = m_connection->flushCount();
+
+    // the requests are queued up until the connection gets flushed
+    for (int i = 0; i < 100; ++i) {
+        s->damage(QRect(i, i, 1, 1));
+    }
+    m_connection->flush();
+    // each wl_surface.damage request takes an 8 byte header and four 32-bit arguments
+    QVERIFY(m_connection->flushedBytes() >= bytes + 100 * 24);
+    QVERIFY(m_connection->flushCount() > flushes);
+
+    // flushing without pending requests doesn't write anything
+    const quint64 flushedBytes = m_connection->flushedBytes();
+    const quint64 flushCount = m_connection->flushCount();
+    m_connection->flush();
+    QCOMPARE(m_connection->flushedBytes(), flushedBytes);
+    QCOMPARE(m_connection->flushCount(), flushCount);
+}
+
 void TestWaylandSurface::testFrameCallback()
 {
     QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
@@ -360,6 +418,307 @@ void TestWaylandSurface::testFrameCallback()
     QVERIFY(!frameRenderedSpy.isEmpty());
 }
 
+void TestWaylandSurface::testFrameCallbackThrottling()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<OutputInterface> first(new OutputInterface(m_display));
+    QScopedPointer<OutputInterface> second(new OutputInterface(m_display));
+    // a surface which isn't on any output is not paced
+    QVERIFY(!serverSurface->frameOutput());
+    QVERIFY(serverSurface->isFrameThrottled());
+    serverSurface->setOutputs({first.data(), second.data()});
+    QCOMPARE(serverSurface->frameOutput(), first.data());
+    QVERIFY(!serverSurface->isFrameThrottled());
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QSignalSpy frameRenderedSpy(s.data(), &KWayland::Client::Surface::frameRendered);
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->hasFrameCallbacks());
+
+    // only the vblanks of the frame output deliver the callbacks
+    serverSurface->frameRendered(second.data(), std::chrono::milliseconds(10));
+    QVERIFY(serverSurface->hasFrameCallbacks());
+
+    // occluded surfaces keep their callbacks
+    serverSurface->setOccluded(true);
+    QVERIFY(serverSurface->isOccluded());
+    QVERIFY(serverSurface->isFrameThrottled());
+    serverSurface->frameRendered(first.data(), std::chrono::milliseconds(20));
+    QVERIFY(serverSurface->hasFrameCallbacks());
+    serverSurface->setOccluded(false);
+
+    // the next powered on output takes over when the frame output is turned off
+    first->setDpmsMode(OutputInterface::DpmsMode::Off);
+    QCOMPARE(serverSurface->frameOutput(), second.data());
+    serverSurface->frameRendered(first.data(), std::chrono::milliseconds(30));
+    QVERIFY(serverSurface->hasFrameCallbacks());
+    serverSurface->frameRendered(second.data(), std::chrono::milliseconds(40));
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QVERIFY(frameRenderedSpy.wait());
+
+    // without any powered on output the surface is throttled
+    second->setDpmsMode(OutputInterface::DpmsMode::Standby);
+    QVERIFY(!serverSurface->frameOutput());
+    QVERIFY(serverSurface->isFrameThrottled());
+
+    // and doesn't get callbacks which aren't paced by an output either
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    serverSurface->frameRendered(50);
+    QVERIFY(serverSurface->hasFrameCallbacks());
+    second->setDpmsMode(OutputInterface::DpmsMode::On);
+    serverSurface->frameRendered(60);
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QVERIFY(frameRenderedSpy.wait());
+}
+
+void TestWaylandSurface::testFrameCallbackPolicy()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->frameCallbackPolicy(), SurfaceInterface::FrameCallbackPolicy::FullRate);
+    QCOMPARE(serverSurface->reducedFrameCallbackInterval(), std::chrono::milliseconds(1000));
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QSignalSpy frameRenderedSpy(s.data(), &KWayland::Client::Surface::frameRendered);
+    QImage img(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit();
+    QVERIFY(committedSpy.wait());
+
+    // a paused surface keeps its callbacks
+    serverSurface->setFrameCallbackPolicy(SurfaceInterface::FrameCallbackPolicy::Paused);
+    QVERIFY(serverSurface->isFrameThrottled());
+    serverSurface->frameRendered(10);
+    QVERIFY(serverSurface->hasFrameCallbacks());
+
+    // the first vblank with the reduced rate sends them right away
+    serverSurface->setFrameCallbackPolicy(SurfaceInterface::FrameCallbackPolicy::ReducedRate);
+    serverSurface->frameRendered(20);
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QVERIFY(frameRenderedSpy.wait());
+
+    // afterwards they are held for the interval
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    serverSurface->frameRendered(520);
+    QVERIFY(serverSurface->hasFrameCallbacks());
+    serverSurface->frameRendered(1020);
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QVERIFY(frameRenderedSpy.wait());
+
+    // the full rate resumes immediately
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    serverSurface->frameRendered(1030);
+    QVERIFY(serverSurface->hasFrameCallbacks());
+    serverSurface->setFrameCallbackPolicy(SurfaceInterface::FrameCallbackPolicy::FullRate);
+    serverSurface->frameRendered(1040);
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(frameRenderedSpy.count(), 3);
+}
+
+void TestWaylandSurface::testFrameClock()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<OutputInterface> output(new OutputInterface(m_display));
+    output->setMode(QSize(1920, 1080), 50000);
+    QScopedPointer<OutputInterface> other(new OutputInterface(m_display));
+    OutputFrameClock *clock = output->frameClock();
+    QCOMPARE(clock->output(), output.data());
+    QCOMPARE(clock->sequence(), quint64(0));
+    QCOMPARE(clock->nextPresentation(), std::chrono::nanoseconds::zero());
+    QCOMPARE(clock->refreshInterval(), std::chrono::nanoseconds(std::chrono::milliseconds(20)));
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QSignalSpy frameRenderedSpy(s.data(), &KWayland::Client::Surface::frameRendered);
+    qRegisterMetaType<std::chrono::nanoseconds>();
+    QSignalSpy presentedSpy(clock, &OutputFrameClock::presented);
+    s->commit();
+    QVERIFY(committedSpy.wait());
+
+    // the clock of another output doesn't pace the surface
+    serverSurface->setOutputs({output.data()});
+    other->frameClock()->tick(std::chrono::milliseconds(10));
+    QVERIFY(serverSurface->hasFrameCallbacks());
+
+    clock->tick(std::chrono::milliseconds(20));
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(presentedSpy.count(), 1);
+    QCOMPARE(presentedSpy.first().at(1).value<quint64>(), quint64(1));
+    QCOMPARE(clock->sequence(), quint64(1));
+    QCOMPARE(clock->lastPresentation(), std::chrono::nanoseconds(std::chrono::milliseconds(20)));
+    QCOMPARE(clock->nextPresentation(), std::chrono::nanoseconds(std::chrono::milliseconds(40)));
+
+    // surfaces which left the output are not paced anymore
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    serverSurface->setOutputs({});
+    clock->tick(std::chrono::milliseconds(40));
+    QVERIFY(serverSurface->hasFrameCallbacks());
+    QCOMPARE(presentedSpy.count(), 2);
+}
+
+void TestWaylandSurface::testCommitTrace()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    // nothing is recorded while the tracing is disabled
+    QVERIFY(!m_display->commitTracingEnabled());
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->commitTrace().isEmpty());
+
+    m_display->setCommitTracingEnabled(true);
+    QImage img(QSize(10, 20), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    s->attachBuffer(static_cast<wl_buffer *>(nullptr));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    QVector<SurfaceInterface::CommitRecord> trace = serverSurface->commitTrace();
+    QCOMPARE(trace.count(), 2);
+    QCOMPARE(trace[0].bufferType, SurfaceInterface::CommitRecord::BufferType::Shm);
+    QCOMPARE(trace[0].bufferSize, QSize(10, 20));
+    QCOMPARE(trace[0].damageArea, qint64(100));
+    QVERIFY(!trace[0].synchronized);
+    QVERIFY(trace[0].frameCallbacks);
+    QCOMPARE(trace[0].frameCallbacksSent, std::chrono::nanoseconds::zero());
+    QCOMPARE(trace[1].bufferType, SurfaceInterface::CommitRecord::BufferType::Detached);
+    QVERIFY(!trace[1].frameCallbacks);
+    QVERIFY(trace[0].timestamp <= trace[1].timestamp);
+
+    // the commit lasts until its frame callbacks are sent
+    serverSurface->frameRendered(10);
+    trace = serverSurface->commitTrace();
+    QVERIFY(trace[0].frameCallbacksSent >= trace[1].timestamp);
+    QCOMPARE(trace[1].frameCallbacksSent, std::chrono::nanoseconds::zero());
+
+    const QJsonObject json = QJsonDocument::fromJson(m_display->exportCommitTrace()).object();
+    int commits = 0;
+    for (const QJsonValue &event : json.value(QStringLiteral("traceEvents")).toArray()) {
+        if (event[QStringLiteral("name")].toString() != QLatin1String("commit")) {
+            continue;
+        }
+        QCOMPARE(event[QStringLiteral("tid")].toInt(), int(serverSurface->id()));
+        QCOMPARE(event[QStringLiteral("pid")].toInt(), int(getpid()));
+        QCOMPARE(event[QStringLiteral("ph")].toString(), commits == 0 ? QStringLiteral("X") : QStringLiteral("i"));
+        ++commits;
+    }
+    QCOMPARE(commits, 2);
+
+    // the trace goes away with the surface
+    s.reset();
+    QVERIFY(QSignalSpy(serverSurface, &QObject::destroyed).wait());
+    QVERIFY(QJsonDocument::fromJson(m_display->exportCommitTrace()).object().value(QStringLiteral("traceEvents")).toArray().isEmpty());
+    m_display->setCommitTracingEnabled(false);
+}
+
+void TestWaylandSurface::testSnapshot()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    // nothing is published while the snapshots are disabled
+    QVERIFY(!m_display->surfaceSnapshotsEnabled());
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(!serverSurface->snapshot());
+
+    m_display->setSurfaceSnapshotsEnabled(true);
+    QImage img(QSize(10, 20), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->setOpaqueRegion(QRegion(0, 0, 10, 20));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    std::shared_ptr<const SurfaceInterface::Snapshot> first = serverSurface->snapshot();
+    QVERIFY(first);
+    ClientBuffer *firstBuffer = serverSurface->buffer();
+    QVERIFY(firstBuffer);
+    QCOMPARE(first->buffer, firstBuffer);
+    QCOMPARE(first->bufferSize, QSize(10, 20));
+    QCOMPARE(first->size, QSize(10, 20));
+    QCOMPARE(first->damage, QRegion(0, 0, 10, 10));
+    QCOMPARE(first->opaque, QRegion(0, 0, 10, 20));
+    QCOMPARE(first->input, QRegion(0, 0, 10, 20));
+    QVERIFY(!first->blurred);
+    QVERIFY(!first->shadowed);
+    QCOMPARE(first->serial, quint64(1));
+
+    // any thread can take the latest snapshot
+    std::shared_ptr<const SurfaceInterface::Snapshot> fromThread;
+    QScopedPointer<QThread> thread(QThread::create([serverSurface, &fromThread]() {
+        fromThread = serverSurface->snapshot();
+    }));
+    thread->start();
+    QVERIFY(thread->wait());
+    QVERIFY(fromThread == first);
+    fromThread.reset();
+
+    // a new commit doesn't touch the published snapshot, which keeps its buffer referenced
+    QImage otherImg(QSize(30, 40), QImage::Format_ARGB32_Premultiplied);
+    otherImg.fill(Qt::white);
+    s->attachBuffer(m_shm->createBuffer(otherImg));
+    s->damage(QRect(0, 0, 30, 40));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    std::shared_ptr<const SurfaceInterface::Snapshot> second = serverSurface->snapshot();
+    QVERIFY(second);
+    QVERIFY(second != first);
+    QCOMPARE(second->buffer, serverSurface->buffer());
+    QCOMPARE(second->size, QSize(30, 40));
+    QCOMPARE(second->serial, quint64(2));
+    QCOMPARE(first->buffer, firstBuffer);
+    QCOMPARE(first->size, QSize(10, 20));
+    QVERIFY(firstBuffer->isReferenced());
+    first.reset();
+    QVERIFY(!firstBuffer->isReferenced());
+
+    // disabling the snapshots drops them with the next commit
+    m_display->setSurfaceSnapshotsEnabled(false);
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(!serverSurface->snapshot());
+}
+
 void TestWaylandSurface::testAttachBuffer()
 {
     // create the surface
@@ -508,6 +867,117 @@ void TestWaylandSurface::testAttachBuffer()
     buffer->unref();
 }
 
+void TestWaylandSurface::testReleaseAfterUpload()
+{
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    KWaylandServer::SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QImage image(24, 24, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QSharedPointer<KWayland::Client::Buffer> buffer = m_shm->createBuffer(image).toStrongRef();
+    QVERIFY(buffer);
+    s->attachBuffer(buffer.data());
+    s->damage(QRect(0, 0, 24, 24));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    KWaylandServer::ClientBuffer *serverBuffer = serverSurface->buffer();
+    QVERIFY(serverBuffer);
+    QCOMPARE(serverBuffer->releasePolicy(), KWaylandServer::ClientBuffer::ReleasePolicy::ReleaseAfterUpload);
+    QVERIFY(!serverBuffer->isReleased());
+    QCOMPARE(serverBuffer->releaseTime(), std::chrono::nanoseconds::zero());
+
+    // the buffer stays attached, but the client gets it back right away
+    const auto before = std::chrono::steady_clock::now().time_since_epoch();
+    serverBuffer->markAsUploaded();
+    QVERIFY(serverBuffer->isReleased());
+    QVERIFY(serverBuffer->isReferenced());
+    QTRY_VERIFY(buffer->isReleased());
+    QVERIFY(serverBuffer->releaseTime() >= before);
+    QCOMPARE(serverSurface->buffer(), serverBuffer);
+
+    // attaching the buffer again makes it busy until the next upload
+    const auto firstReleaseTime = serverBuffer->releaseTime();
+    buffer->setReleased(false);
+    s->attachBuffer(buffer.data());
+    s->damage(QRect(0, 0, 24, 24));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->buffer(), serverBuffer);
+    QVERIFY(!serverBuffer->isReleased());
+
+    // without another upload, the buffer is released when it is replaced
+    s->attachBuffer((wl_buffer *)nullptr);
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QTRY_VERIFY(buffer->isReleased());
+    QVERIFY(serverBuffer->releaseTime() > firstReleaseTime);
+}
+
+void TestWaylandSurface::testReleaseAfterUploadWhileHeld()
+{
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    KWaylandServer::SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+
+    QImage image(24, 24, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QSharedPointer<KWayland::Client::Buffer> first = m_shm->createBuffer(image).toStrongRef();
+    QSharedPointer<KWayland::Client::Buffer> second = m_shm->createBuffer(image).toStrongRef();
+    s->attachBuffer(first.data());
+    s->damage(QRect(0, 0, 24, 24));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    KWaylandServer::ClientBuffer *serverBuffer = serverSurface->buffer();
+
+    // the compositor keeps the uploaded buffer, e.g. as a pixmap, while the surface moves on
+    serverBuffer->ref();
+    serverBuffer->markAsUploaded();
+    QTRY_VERIFY(first->isReleased());
+    second->setUsed(true);
+    s->attachBuffer(second.data());
+    s->damage(QRect(0, 0, 24, 24));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    // the client attaches the first buffer again, it's busy although it never lost its reference
+    first->setReleased(false);
+    s->attachBuffer(first.data());
+    s->damage(QRect(0, 0, 24, 24));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->buffer(), serverBuffer);
+    QVERIFY(!serverBuffer->isReleased());
+
+    // and it's released again once the new contents have been uploaded
+    serverBuffer->markAsUploaded();
+    QTRY_VERIFY(first->isReleased());
+
+    // or once the last reference goes away if they never are
+    first->setReleased(false);
+    s->attachBuffer(second.data());
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    s->attachBuffer(first.data());
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(!serverBuffer->isReleased());
+    s->attachBuffer((wl_buffer *)nullptr);
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(!first->isReleased());
+    serverBuffer->unref();
+    QTRY_VERIFY(first->isReleased());
+}
+
 void TestWaylandSurface::testMultipleSurfaces()
 {
     using namespace KWayland::Client;
@@ -598,6 +1068,19 @@ void TestWaylandSurface::testMultipleSurfaces()
     buffer1Data = qobject_cast<ShmClientBuffer *>(buffer1)->data();
     QVERIFY(!buffer1Data.isNull());
     QCOMPARE(buffer1Data, black);
+    buffer1Data = QImage();
+
+    // another thread can access buffer1 while buffer2 is accessed
+    buffer2Data = qobject_cast<ShmClientBuffer *>(buffer2)->data();
+    QVERIFY(!buffer2Data.isNull());
+    QImage threadData;
+    QScopedPointer<QThread> thread(QThread::create([buffer1, &threadData]() {
+        threadData = qobject_cast<ShmClientBuffer *>(buffer1)->data().copy();
+    }));
+    thread->start();
+    QVERIFY(thread->wait());
+    QCOMPARE(threadData, black);
+    QCOMPARE(buffer2Data, red);
 }
 
 void TestWaylandSurface::testOpaque()
@@ -630,6 +1113,8 @@ void TestWaylandSurface::testOpaque()
     QCOMPARE(opaqueRegionChangedSpy.count(), 1);
     QCOMPARE(opaqueRegionChangedSpy.last().first().value<QRegion>(), QRegion(0, 10, 20, 30));
     QCOMPARE(serverSurface->opaque(), QRegion(0, 10, 20, 30));
+    QCOMPARE(serverSurface->generation(SurfaceInterface::StateCategory::Regions), 1u);
+    QCOMPARE(serverSurface->generation(SurfaceInterface::StateCategory::Buffer), 0u);
 
     // committing without setting a new region shouldn't change
     s->commit(Surface::CommitFlag::None);
@@ -637,6 +1122,7 @@ void TestWaylandSurface::testOpaque()
     QCoreApplication::processEvents();
     QCOMPARE(opaqueRegionChangedSpy.count(), 1);
     QCOMPARE(serverSurface->opaque(), QRegion(0, 10, 20, 30));
+    QCOMPARE(serverSurface->generation(SurfaceInterface::StateCategory::Regions), 1u);
 
     // let's change the opaque region
     s->setOpaqueRegion(m_compositor->createRegion(QRegion(10, 20, 30, 40)).get());
@@ -655,6 +1141,217 @@ void TestWaylandSurface::testOpaque()
     QCOMPARE(serverSurface->opaque(), QRegion());
 }
 
+void TestWaylandSurface::testCachedRegion()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy opaqueRegionChangedSpy(serverSurface, &KWaylandServer::SurfaceInterface::opaqueChanged);
+    QVERIFY(opaqueRegionChangedSpy.isValid());
+    QSignalSpy inputRegionChangedSpy(serverSurface, &KWaylandServer::SurfaceInterface::inputChanged);
+    QVERIFY(inputRegionChangedSpy.isValid());
+
+    // identical regions share the Region
+    const Region *region = m_compositor->cachedRegion(QRegion(0, 10, 20, 30));
+    QVERIFY(region);
+    QCOMPARE(region->region(), QRegion(0, 10, 20, 30));
+    QCOMPARE(m_compositor->cachedRegion(QRegion(0, 10, 20, 30)), region);
+    QVERIFY(m_compositor->cachedRegion(QRegion(0, 0, 5, 5)) != region);
+
+    s->setOpaqueRegion(QRegion(0, 10, 20, 30));
+    s->setInputRegion(QRegion(0, 10, 20, 30));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(opaqueRegionChangedSpy.wait());
+    QCOMPARE(serverSurface->opaque(), QRegion(0, 10, 20, 30));
+    QCOMPARE(serverSurface->input(), QRegion(0, 10, 20, 30));
+    QCOMPARE(inputRegionChangedSpy.count(), 1);
+    const quint64 generation = serverSurface->generation(SurfaceInterface::StateCategory::Regions);
+
+    // setting the same regions again isn't sent to the compositor
+    s->setOpaqueRegion(QRegion(0, 10, 20, 30));
+    s->setInputRegion(QRegion(0, 10, 20, 30));
+    s->commit(Surface::CommitFlag::None);
+    wl_display_flush(m_connection->display());
+    QCoreApplication::processEvents();
+    QCOMPARE(opaqueRegionChangedSpy.count(), 1);
+    QCOMPARE(serverSurface->generation(SurfaceInterface::StateCategory::Regions), generation);
+
+    // an empty opaque region resets it
+    s->setOpaqueRegion(QRegion());
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(opaqueRegionChangedSpy.wait());
+    QCOMPARE(serverSurface->opaque(), QRegion());
+}
+
+void TestWaylandSurface::testOcclusionTracker()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> bottom(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverBottom = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+    QScopedPointer<Surface> top(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverTop = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QSignalSpy bottomCommittedSpy(serverBottom, &SurfaceInterface::committed);
+    bottom->attachBuffer(m_shm->createBuffer(image));
+    bottom->damage(QRect(0, 0, 100, 100));
+    bottom->commit(Surface::CommitFlag::None);
+    QVERIFY(bottomCommittedSpy.wait());
+    QSignalSpy topCommittedSpy(serverTop, &SurfaceInterface::committed);
+    top->attachBuffer(m_shm->createBuffer(image));
+    top->damage(QRect(0, 0, 100, 100));
+    top->setOpaqueRegion(m_compositor->createRegion(QRegion(0, 0, 100, 100)).get());
+    top->commit(Surface::CommitFlag::None);
+    QVERIFY(topCommittedSpy.wait());
+
+    // the top surface covers the bottom one completely
+    OcclusionTracker tracker;
+    QSignalSpy visibleRegionsChangedSpy(&tracker, &OcclusionTracker::visibleRegionsChanged);
+    tracker.setStackingOrder({serverBottom, serverTop});
+    QVERIFY(visibleRegionsChangedSpy.wait());
+    QCOMPARE(tracker.visibleRegion(serverTop), QRegion(0, 0, 100, 100));
+    QCOMPARE(tracker.visibleRegion(serverBottom), QRegion());
+    QVERIFY(tracker.isOccluded(serverBottom));
+    QVERIFY(!tracker.isOccluded(serverTop));
+    QVERIFY(serverBottom->isOccluded());
+    QVERIFY(!serverTop->isOccluded());
+
+    // moving the top surface exposes a part of the bottom one
+    tracker.setPosition(serverTop, QPoint(50, 0));
+    QCOMPARE(tracker.position(serverTop), QPoint(50, 0));
+    tracker.update();
+    QCOMPARE(visibleRegionsChangedSpy.count(), 2);
+    QCOMPARE(tracker.visibleRegion(serverBottom), QRegion(0, 0, 50, 100));
+    QVERIFY(!tracker.isOccluded(serverBottom));
+    QVERIFY(!serverBottom->isOccluded());
+
+    // a pass without changes doesn't emit the signal
+    tracker.update();
+    QCOMPARE(visibleRegionsChangedSpy.count(), 2);
+
+    // a translucent surface doesn't cover anything
+    tracker.setPosition(serverTop, QPoint());
+    tracker.update();
+    QVERIFY(serverBottom->isOccluded());
+    top->setOpaqueRegion(nullptr);
+    top->commit(Surface::CommitFlag::None);
+    QVERIFY(visibleRegionsChangedSpy.wait());
+    QCOMPARE(tracker.visibleRegion(serverBottom), QRegion(0, 0, 100, 100));
+    QVERIFY(!serverBottom->isOccluded());
+
+    // raising the bottom surface covers nothing either, but swaps the visible regions
+    top->setOpaqueRegion(m_compositor->createRegion(QRegion(0, 0, 100, 100)).get());
+    top->commit(Surface::CommitFlag::None);
+    QVERIFY(visibleRegionsChangedSpy.wait());
+    QVERIFY(serverBottom->isOccluded());
+    tracker.setStackingOrder({serverTop, serverBottom});
+    tracker.update();
+    QVERIFY(!serverBottom->isOccluded());
+    QVERIFY(!serverTop->isOccluded());
+    QCOMPARE(tracker.visibleRegion(serverTop), QRegion(0, 0, 100, 100));
+
+    // without frame throttling the surfaces are not marked
+    tracker.setStackingOrder({serverBottom, serverTop});
+    tracker.update();
+    QVERIFY(serverBottom->isOccluded());
+    tracker.setFrameThrottling(false);
+    QVERIFY(!serverBottom->isOccluded());
+    QVERIFY(tracker.isOccluded(serverBottom));
+    tracker.setFrameThrottling(true);
+    QVERIFY(serverBottom->isOccluded());
+
+    // destroyed surfaces leave the stacking order and expose what they covered
+    QSignalSpy destroyedSpy(serverTop, &QObject::destroyed);
+    top.reset();
+    QVERIFY(destroyedSpy.wait());
+    QCOMPARE(tracker.stackingOrder(), QList<SurfaceInterface *>{serverBottom});
+    tracker.update();
+    QVERIFY(!serverBottom->isOccluded());
+    QCOMPARE(tracker.visibleRegion(serverBottom), QRegion(0, 0, 100, 100));
+}
+
+void TestWaylandSurface::testScanoutEvaluator()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QScopedPointer<OutputInterface> output(new OutputInterface(m_display));
+    output->setMode(QSize(100, 100));
+    ScanoutEvaluator evaluator(output.data());
+
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface *>();
+    QCOMPARE(evaluator.evaluate(serverSurface), ScanoutEvaluator::Result::NoBuffer);
+
+    // a fullscreen shm buffer can't be scanned out directly
+    QImage image(QSize(100, 100), QImage::Format_RGB32);
+    image.fill(Qt::black);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(QRect(0, 0, 100, 100));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(evaluator.evaluate(serverSurface), ScanoutEvaluator::Result::NotDmaBuf);
+
+    // the cached result survives a mode change, the buffer is still not importable
+    output->setMode(QSize(200, 200));
+    QCOMPARE(evaluator.evaluate(serverSurface), ScanoutEvaluator::Result::NotDmaBuf);
+}
+
+void TestWaylandSurface::testConvertShmDamage_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("argb8888") << int(QImage::Format_ARGB32_Premultiplied);
+    QTest::newRow("xrgb8888") << int(QImage::Format_RGB32);
+    QTest::newRow("abgr8888") << int(QImage::Format_RGBA8888_Premultiplied);
+    QTest::newRow("xbgr8888") << int(QImage::Format_RGBX8888);
+    QTest::newRow("rgb565") << int(QImage::Format_RGB16);
+    QTest::newRow("rgb888") << int(QImage::Format_BGR888);
+    QTest::newRow("bgr888") << int(QImage::Format_RGB888);
+    QTest::newRow("xrgb1555") << int(QImage::Format_RGB555);
+}
+
+void TestWaylandSurface::testConvertShmDamage()
+{
+    using namespace KWaylandServer;
+    QFETCH(int, format);
+
+    // odd sizes to cover the scalar tails of the vectorized conversions
+    QImage reference(QSize(37, 11), QImage::Format_RGB32);
+    for (int y = 0; y < reference.height(); ++y) {
+        for (int x = 0; x < reference.width(); ++x) {
+            reference.setPixel(x, y, qRgb(x * 7, y * 23, x * y));
+        }
+    }
+    const QImage image = reference.convertToFormat(QImage::Format(format));
+    const QImage expected = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    QImage target(image.size(), QImage::Format_ARGB32_Premultiplied);
+    target.fill(Qt::transparent);
+    QVERIFY(ShmClientBuffer::convertDamage(image, QRegion(3, 2, 21, 5), &target));
+    QCOMPARE(target.copy(3, 2, 21, 5), expected.copy(3, 2, 21, 5));
+    QCOMPARE(target.pixel(0, 0), 0u);
+    QCOMPARE(target.pixel(36, 10), 0u);
+
+    QVERIFY(ShmClientBuffer::convertDamage(image, image.rect(), &target));
+    QCOMPARE(target, expected);
+
+    QImage wrongSize(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    QVERIFY(!ShmClientBuffer::convertDamage(image, image.rect(), &wrongSize));
+}
+
 void TestWaylandSurface::testInput()
 {
     using namespace KWayland::Client;
@@ -814,6 +1511,102 @@ void TestWaylandSurface::testScale()
     QCOMPARE(serverSurface->size(), QSize(25, 25));
 }
 
+void TestWaylandSurface::testDamageBufferTransform_data()
+{
+    QTest::addColumn<KWaylandServer::OutputInterface::Transform>("transform");
+
+    QTest::newRow("normal") << KWaylandServer::OutputInterface::Transform::Normal;
+    QTest::newRow("rotate-90") << KWaylandServer::OutputInterface::Transform::Rotated90;
+    QTest::newRow("rotate-180") << KWaylandServer::OutputInterface::Transform::Rotated180;
+    QTest::newRow("rotate-270") << KWaylandServer::OutputInterface::Transform::Rotated270;
+    QTest::newRow("flip-0") << KWaylandServer::OutputInterface::Transform::Flipped;
+    QTest::newRow("flip-90") << KWaylandServer::OutputInterface::Transform::Flipped90;
+    QTest::newRow("flip-180") << KWaylandServer::OutputInterface::Transform::Flipped180;
+    QTest::newRow("flip-270") << KWaylandServer::OutputInterface::Transform::Flipped270;
+}
+
+void TestWaylandSurface::testDamageBufferTransform()
+{
+    // this test verifies that buffer damage is mapped to the same surface damage as the
+    // surface-to-buffer matrix would map it, for every buffer transform
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QFETCH(OutputInterface::Transform, transform);
+
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QSignalSpy damageSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damageSpy.isValid());
+
+    QImage image(QSize(100, 60), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    s->setScale(2);
+    wl_surface_set_buffer_transform(*s, int(transform));
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damageBuffer(QRect(10, 20, 30, 8));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+    QCOMPARE(serverSurface->bufferTransform(), transform);
+
+    const QRegion expected = serverSurface->surfaceToBufferMatrix().inverted().mapRect(QRect(10, 20, 30, 8));
+    QCOMPARE(serverSurface->damage(), expected);
+    QCOMPARE(serverSurface->mapFromBuffer(QRegion(10, 20, 30, 8)), expected);
+}
+
+void TestWaylandSurface::testBufferDamage()
+{
+    // this test verifies that surface and buffer damage are combined in buffer coordinates
+    // and that the damaged rects point into the shm buffer
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QVERIFY(serverSurface->bufferDamage().isEmpty());
+
+    QSignalSpy damageSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damageSpy.isValid());
+
+    QImage image(QSize(24, 24), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    s->setScale(2);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(QRect(1, 2, 3, 4));
+    s->damageBuffer(QRect(20, 20, 10, 10));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+
+    const QRegion expected = QRegion(2, 4, 6, 8) + QRegion(20, 20, 4, 4);
+    QCOMPARE(serverSurface->bufferDamage(), expected);
+
+    auto buffer = qobject_cast<ShmClientBuffer *>(serverSurface->buffer());
+    QVERIFY(buffer);
+    const QImage data = buffer->data();
+    QVERIFY(!data.isNull());
+    const QVector<ShmClientBuffer::DamagedRect> rects = buffer->damagedRects(data, serverSurface->bufferDamage());
+    QCOMPARE(rects.count(), expected.rectCount());
+    for (const ShmClientBuffer::DamagedRect &rect : rects) {
+        QVERIFY(expected.contains(rect.rect));
+        QCOMPARE(rect.bits, data.constScanLine(rect.rect.y()) + rect.rect.x() * 4);
+        QCOMPARE(rect.stride, int(data.bytesPerLine()));
+    }
+
+    // a commit without a new buffer keeps the damage
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->bufferDamage(), expected);
+}
+
 void TestWaylandSurface::testUnmapOfNotMappedSurface()
 {
     // this test verifies that a surface which doesn't have a buffer attached doesn't trigger the unmapped signal
@@ -906,6 +1699,53 @@ void TestWaylandSurface::testDestroyAttachedBuffer()
     delete m_shm;
     m_shm = nullptr;
     QTRY_VERIFY(serverSurface->buffer()->isDestroyed());
+
+    // the contents of the buffer still in use are copied out of the released pool
+    const QImage data = qobject_cast<ShmClientBuffer *>(serverSurface->buffer())->data();
+    QCOMPARE(data.size(), QSize(100, 100));
+    QCOMPARE(data.pixel(0, 0), qRgb(255, 0, 0));
+    QCOMPARE(m_display->retainedShmBytes(), qint64(100 * 100 * 4));
+}
+
+void TestWaylandSurface::testDestroyAccessedBuffer()
+{
+    // this test verifies that an image of the buffer data stays valid if the buffer is destroyed
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface *>();
+
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(QRect(0, 0, 100, 100));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+    auto buffer = qobject_cast<ShmClientBuffer *>(serverSurface->buffer());
+    QVERIFY(buffer);
+
+    // the compositor is still reading the buffer when it gets destroyed
+    QImage accessed = buffer->data();
+    QVERIFY(!accessed.isNull());
+    image.fill(Qt::blue);
+    s->attachBuffer(m_shm->createBuffer(image));
+    m_connection->flush();
+    delete m_shm;
+    m_shm = nullptr;
+    QTRY_VERIFY(buffer->isDestroyed());
+
+    // the pool is kept rather than copied, the image still points at its mapping
+    QCOMPARE(m_display->retainedShmBytes(), qint64(0));
+    QCOMPARE(accessed.pixel(0, 0), qRgb(255, 0, 0));
+    QCOMPARE(accessed.pixel(99, 99), qRgb(255, 0, 0));
+
+    accessed = QImage();
+    const QImage data = buffer->data();
+    QCOMPARE(data.size(), QSize(100, 100));
+    QCOMPARE(data.pixel(0, 0), qRgb(255, 0, 0));
 }
 
 void TestWaylandSurface::testDestroyWithPendingCallback()
@@ -1061,6 +1901,54 @@ void TestWaylandSurface::testOutput()
     QCOMPARE(serverSurface->outputs(), QVector<OutputInterface *>());
 }
 
+void TestWaylandSurface::testOutputBoundLater()
+{
+    // This test verifies that a surface enters an output the client binds after the surface entered it
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    qRegisterMetaType<KWayland::Client::Output *>();
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QSignalSpy enteredSpy(s.data(), &Surface::outputEntered);
+    QSignalSpy leftSpy(s.data(), &Surface::outputLeft);
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    auto serverOutput = new OutputInterface(m_display, m_display);
+    auto otherOutput = new OutputInterface(m_display, m_display);
+    serverSurface->setOutputs(QVector<OutputInterface *>{serverOutput, otherOutput});
+
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy allAnnounced(&registry, &Registry::interfacesAnnounced);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+    const auto outputs = registry.interfaces(Registry::Interface::Output);
+    QCOMPARE(outputs.count(), 2);
+    QScopedPointer<Output> clientOutput(registry.createOutput(outputs.first().name, outputs.first().version));
+    QVERIFY(enteredSpy.wait());
+    QCOMPARE(enteredSpy.count(), 1);
+    QCOMPARE(enteredSpy.first().first().value<Output *>(), clientOutput.data());
+
+    // the order of the outputs doesn't matter
+    serverSurface->setOutputs(QVector<OutputInterface *>{otherOutput, serverOutput});
+    QVERIFY(!leftSpy.wait(100));
+    QCOMPARE(enteredSpy.count(), 1);
+
+    // leaving the other output doesn't concern the bound one
+    serverSurface->setOutputs(QVector<OutputInterface *>{serverOutput});
+    QVERIFY(!leftSpy.wait(100));
+    serverSurface->setOutputs(QVector<OutputInterface *>{otherOutput});
+    QVERIFY(leftSpy.wait());
+    QCOMPARE(leftSpy.first().first().value<Output *>(), clientOutput.data());
+
+    delete otherOutput;
+    QCOMPARE(serverSurface->outputs(), QVector<OutputInterface *>());
+    delete serverOutput;
+}
+
 void TestWaylandSurface::testInhibit()
 {
     using namespace KWayland::Client;
@@ -1109,5 +1997,58 @@ void TestWaylandSurface::testInhibit()
     QCOMPARE(inhibitsChangedSpy.count(), 4);
 }
 
+void TestWaylandSurface::testInhibitAggregate()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    IdleInterface idle(m_display);
+    m_idleInhibitInterface->setIdleInterface(&idle);
+    QSignalSpy inhibitingChangedSpy(m_idleInhibitInterface, &IdleInhibitManagerV1Interface::inhibitingChanged);
+
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QSignalSpy inhibitsChangedSpy(serverSurface, &SurfaceInterface::inhibitsIdleChanged);
+
+    // an unmapped surface doesn't inhibit idle
+    QScopedPointer<IdleInhibitor> inhibitor(m_idleInhibitManager->createInhibitor(s.data()));
+    QVERIFY(inhibitsChangedSpy.wait());
+    QVERIFY(serverSurface->inhibitsIdle());
+    QVERIFY(!m_idleInhibitInterface->isInhibiting());
+    QVERIFY(!idle.isInhibited());
+
+    // mapping it does
+    QSignalSpy mappedSpy(serverSurface, &SurfaceInterface::mapped);
+    QImage img(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(mappedSpy.wait());
+    QVERIFY(m_idleInhibitInterface->isInhibiting());
+    QVERIFY(idle.isInhibited());
+    QCOMPARE(inhibitingChangedSpy.count(), 1);
+
+    // occluded surfaces only count while visibility isn't required
+    serverSurface->setOccluded(true);
+    QVERIFY(m_idleInhibitInterface->isInhibiting());
+    m_idleInhibitInterface->setVisibilityRequired(true);
+    QVERIFY(!m_idleInhibitInterface->isInhibiting());
+    QVERIFY(!idle.isInhibited());
+    serverSurface->setOccluded(false);
+    QVERIFY(idle.isInhibited());
+    m_idleInhibitInterface->setVisibilityRequired(false);
+
+    // destroying the inhibitor ends the inhibition
+    inhibitor.reset();
+    QVERIFY(inhibitsChangedSpy.wait());
+    QVERIFY(!m_idleInhibitInterface->isInhibiting());
+    QVERIFY(!idle.isInhibited());
+    QCOMPARE(inhibitingChangedSpy.count(), 4);
+
+    m_idleInhibitInterface->setIdleInterface(nullptr);
+}
+
 QTEST_GUILESS_MAIN(TestWaylandSurface)
 #include "test_wayland_surface.moc"
@@ -5,7 +5,10 @@
 */
 // Qt
 #include <QtTest>
+#include <QScopeGuard>
+#include <QSemaphore>
 // KWin
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/plasmawindowmanagement_interface.h"
@@ -14,6 +17,7 @@
 #include "../../src/client/connection_thread.h"
 #include "../../src/client/event_queue.h"
 #include "../../src/client/plasmawindowmanagement.h"
+#include "../../src/client/plasmawindowmodel.h"
 #include "../../src/client/region.h"
 #include "../../src/client/registry.h"
 #include "../../src/client/surface.h"
@@ -40,6 +44,7 @@ private Q_SLOTS:
     void testServerDelete();
     void testActiveWindowOnUnmapped();
     void testDeleteActiveWindow();
+    void testWindowByUuid();
     void testCreateAfterUnmap();
     void testRequests_data();
     void testRequests();
@@ -53,8 +58,17 @@ private Q_SLOTS:
     void testParentWindow();
     void testGeometry();
     void testIcon();
+    void testIdenticalIcon();
+    void testLazyIcon();
     void testPid();
     void testApplicationMenu();
+    void testBatchedUpdate();
+    void testModelActivityFilter();
+    void testModelStackingOrder();
+    void testWindowsCreatedBatch();
+    void testSubscribedProperties();
+    void testRateLimit();
+    void testCongestedClient();
 
     void cleanup();
 
@@ -305,6 +319,20 @@ void TestWindowManagement::testDeleteActiveWindow()
     QVERIFY(!m_windowManagement->activeWindow());
 }
 
+void TestWindowManagement::testWindowByUuid()
+{
+    // this test verifies that windows can be looked up by their uuid
+    QVERIFY(!m_window->uuid().isEmpty());
+    QCOMPARE(m_windowManagement->windowByUuid(m_window->uuid()), m_window);
+    QVERIFY(!m_windowManagement->windowByUuid(QByteArrayLiteral("does-not-exist")));
+
+    // deleting the window removes it from the lookup
+    const QByteArray uuid = m_window->uuid();
+    delete m_window;
+    m_window = nullptr;
+    QVERIFY(!m_windowManagement->windowByUuid(uuid));
+}
+
 void TestWindowManagement::testCreateAfterUnmap()
 {
     // this test verifies that we don't get a protocol error on client side when creating an already unmapped window.
@@ -590,6 +618,64 @@ void TestWindowManagement::testIcon()
     QCOMPARE(m_window->icon().name(), QStringLiteral("wayland"));
 }
 
+void TestWindowManagement::testIdenticalIcon()
+{
+    // this test verifies that setting an icon with the same content doesn't change it on the client
+    using namespace KWayland::Client;
+
+    QSignalSpy iconChangedSpy(m_window, &PlasmaWindow::iconChanged);
+    QVERIFY(iconChangedSpy.isValid());
+
+    QImage p(32, 32, QImage::Format_ARGB32_Premultiplied);
+    p.fill(Qt::red);
+    m_windowInterface->setIcon(QIcon(QPixmap::fromImage(p)));
+    QVERIFY(iconChangedSpy.wait());
+    QCOMPARE(iconChangedSpy.count(), 1);
+    QCOMPARE(m_window->icon().pixmap(32, 32).toImage(), p);
+
+    // a different QIcon with identical content
+    m_windowInterface->setIcon(QIcon(QPixmap::fromImage(p)));
+    QVERIFY(!iconChangedSpy.wait(500));
+
+    // while a new content gets through
+    p.fill(Qt::blue);
+    m_windowInterface->setIcon(QIcon(QPixmap::fromImage(p)));
+    QVERIFY(iconChangedSpy.wait());
+    QCOMPARE(iconChangedSpy.count(), 2);
+    QCOMPARE(m_window->icon().pixmap(32, 32).toImage(), p);
+}
+
+void TestWindowManagement::testLazyIcon()
+{
+    // this test verifies that the icon is only transferred once it is needed
+    using namespace KWayland::Client;
+    m_windowManagement->setLazyIconFetching(true);
+    QVERIFY(m_windowManagement->lazyIconFetching());
+
+    QSignalSpy iconChangedSpy(m_window, &PlasmaWindow::iconChanged);
+    QVERIFY(iconChangedSpy.isValid());
+
+    QImage p(32, 32, QImage::Format_ARGB32_Premultiplied);
+    p.fill(Qt::red);
+    m_windowInterface->setIcon(QIcon(QPixmap::fromImage(p)));
+    QVERIFY(iconChangedSpy.wait());
+    QCOMPARE(iconChangedSpy.count(), 1);
+    QVERIFY(!iconChangedSpy.wait(100));
+
+    // asking for the icon fetches it
+    QVERIFY(m_window->icon().isNull());
+    QVERIFY(iconChangedSpy.wait());
+    QCOMPARE(iconChangedSpy.count(), 2);
+    QCOMPARE(m_window->icon().pixmap(32, 32).toImage(), p);
+
+    // from now on changes are fetched right away
+    p.fill(Qt::blue);
+    m_windowInterface->setIcon(QIcon(QPixmap::fromImage(p)));
+    QVERIFY(iconChangedSpy.wait());
+    QCOMPARE(iconChangedSpy.count(), 3);
+    QCOMPARE(m_window->icon().pixmap(32, 32).toImage(), p);
+}
+
 void TestWindowManagement::testPid()
 {
     using namespace KWayland::Client;
@@ -622,5 +708,276 @@ void TestWindowManagement::testApplicationMenu()
     QCOMPARE(m_window->applicationMenuObjectPath(), objectPath);
 }
 
+void TestWindowManagement::testBatchedUpdate()
+{
+    using namespace KWayland::Client;
+    qRegisterMetaType<QVector<int>>();
+    QScopedPointer<PlasmaWindowModel> model(m_windowManagement->createWindowModel());
+    QCOMPARE(model->rowCount(), 1);
+
+    QSignalSpy titleChangedSpy(m_window, &PlasmaWindow::titleChanged);
+    QSignalSpy maximizedChangedSpy(m_window, &PlasmaWindow::maximizedChanged);
+    QSignalSpy minimizedChangedSpy(m_window, &PlasmaWindow::minimizedChanged);
+    QSignalSpy geometryChangedSpy(m_window, &PlasmaWindow::geometryChanged);
+    QSignalSpy dataChangedSpy(model.data(), &QAbstractItemModel::dataChanged);
+
+    m_windowInterface->beginUpdate();
+    m_windowInterface->setTitle(QStringLiteral("first"));
+    m_windowInterface->setTitle(QStringLiteral("second"));
+    m_windowInterface->setMaximized(true);
+    m_windowInterface->setGeometry(QRect(0, 0, 100, 50));
+    // a nested update doesn't send anything either and changes which cancel out are dropped
+    m_windowInterface->beginUpdate();
+    m_windowInterface->setMinimized(true);
+    m_windowInterface->setMinimized(false);
+    m_windowInterface->endUpdate();
+    QVERIFY(!titleChangedSpy.wait(100));
+
+    // all changes arrive together, with their final values
+    m_windowInterface->endUpdate();
+    QVERIFY(dataChangedSpy.wait());
+    QCOMPARE(titleChangedSpy.count(), 1);
+    QCOMPARE(m_window->title(), QStringLiteral("second"));
+    QCOMPARE(maximizedChangedSpy.count(), 1);
+    QVERIFY(m_window->isMaximized());
+    QVERIFY(minimizedChangedSpy.isEmpty());
+    QCOMPARE(geometryChangedSpy.count(), 1);
+    QCOMPARE(m_window->geometry(), QRect(0, 0, 100, 50));
+
+    // which the model reports with a single dataChanged
+    QCOMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.first().at(0).toModelIndex(), model->index(0));
+    const QVector<int> roles = dataChangedSpy.first().at(2).value<QVector<int>>();
+    QCOMPARE(roles.count(), 3);
+    QVERIFY(roles.contains(Qt::DisplayRole));
+    QVERIFY(roles.contains(PlasmaWindowModel::IsMaximized));
+    QVERIFY(roles.contains(PlasmaWindowModel::Geometry));
+}
+
+void TestWindowManagement::testModelActivityFilter()
+{
+    using namespace KWayland::Client;
+    QScopedPointer<PlasmaWindowModel> model(m_windowManagement->createWindowModel());
+    QCOMPARE(model->rowCount(), 1);
+
+    // a window on no activity is on all of them
+    model->setActivityFilter(QStringLiteral("first"));
+    QCOMPARE(model->activityFilter(), QStringLiteral("first"));
+    QCOMPARE(model->rowCount(), 1);
+
+    QSignalSpy rowsRemovedSpy(model.data(), &QAbstractItemModel::rowsRemoved);
+    QVERIFY(rowsRemovedSpy.isValid());
+    QSignalSpy rowsInsertedSpy(model.data(), &QAbstractItemModel::rowsInserted);
+    QVERIFY(rowsInsertedSpy.isValid());
+    m_windowInterface->addPlasmaActivity(QStringLiteral("second"));
+    QVERIFY(rowsRemovedSpy.wait());
+    QCOMPARE(model->rowCount(), 0);
+
+    m_windowInterface->addPlasmaActivity(QStringLiteral("first"));
+    QVERIFY(rowsInsertedSpy.wait());
+    QCOMPARE(model->rowCount(), 1);
+    QCOMPARE(model->data(model->index(0), PlasmaWindowModel::Activities).toStringList(), QStringList({QStringLiteral("second"), QStringLiteral("first")}));
+
+    // dropping the filter shows everything again
+    m_windowInterface->removePlasmaActivity(QStringLiteral("first"));
+    QVERIFY(rowsRemovedSpy.wait());
+    QCOMPARE(model->rowCount(), 0);
+    model->setActivityFilter(QString());
+    QCOMPARE(model->rowCount(), 1);
+}
+
+void TestWindowManagement::testModelStackingOrder()
+{
+    using namespace KWayland::Client;
+    QSignalSpy windowCreatedSpy(m_windowManagement, &PlasmaWindowManagement::windowCreated);
+    QVERIFY(windowCreatedSpy.isValid());
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> second(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    QVERIFY(windowCreatedSpy.wait());
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> third(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    QVERIFY(windowCreatedSpy.wait());
+
+    QScopedPointer<PlasmaWindowModel> model(m_windowManagement->createWindowModel());
+    QCOMPARE(model->rowCount(), 3);
+    QVERIFY(!model->isSortedByStackingOrder());
+
+    auto uuidAt = [&model](int row) {
+        return model->data(model->index(row), PlasmaWindowModel::Uuid).toByteArray();
+    };
+
+    QSignalSpy stackingOrderChangedSpy(m_windowManagement, &PlasmaWindowManagement::stackingOrderUuidsChanged);
+    QVERIFY(stackingOrderChangedSpy.isValid());
+    m_windowManagementInterface->setStackingOrderUuids({third->uuid(), m_windowInterface->uuid(), second->uuid()});
+    QVERIFY(stackingOrderChangedSpy.wait());
+
+    model->setSortedByStackingOrder(true);
+    QCOMPARE(uuidAt(0), third->uuid().toUtf8());
+    QCOMPARE(uuidAt(1), m_windowInterface->uuid().toUtf8());
+    QCOMPARE(uuidAt(2), second->uuid().toUtf8());
+
+    // raising the bottom most window is a single move
+    QSignalSpy rowsMovedSpy(model.data(), &QAbstractItemModel::rowsMoved);
+    QVERIFY(rowsMovedSpy.isValid());
+    m_windowManagementInterface->setStackingOrderUuids({m_windowInterface->uuid(), second->uuid(), third->uuid()});
+    QVERIFY(stackingOrderChangedSpy.wait());
+    QCOMPARE(rowsMovedSpy.count(), 1);
+    QCOMPARE(uuidAt(0), m_windowInterface->uuid().toUtf8());
+    QCOMPARE(uuidAt(1), second->uuid().toUtf8());
+    QCOMPARE(uuidAt(2), third->uuid().toUtf8());
+}
+
+void TestWindowManagement::testWindowsCreatedBatch()
+{
+    // this test verifies that windows announced together are reported together
+    using namespace KWayland::Client;
+    QSignalSpy windowCreatedSpy(m_windowManagement, &PlasmaWindowManagement::windowCreated);
+    QVERIFY(windowCreatedSpy.isValid());
+    QSignalSpy windowsCreatedSpy(m_windowManagement, &PlasmaWindowManagement::windowsCreated);
+    QVERIFY(windowsCreatedSpy.isValid());
+
+    QVector<KWaylandServer::PlasmaWindowInterface *> serverWindows;
+    for (int i = 0; i < 5; ++i) {
+        serverWindows << m_windowManagementInterface->createWindow(this, QUuid::createUuid());
+    }
+    QVERIFY(windowsCreatedSpy.wait());
+
+    // the events may come in with several reads, every window is in exactly one batch
+    QList<PlasmaWindow *> batched;
+    QTRY_COMPARE_WITH_TIMEOUT(
+        [&windowsCreatedSpy, &batched] {
+            batched.clear();
+            for (const QList<QVariant> &arguments : qAsConst(windowsCreatedSpy)) {
+                batched << arguments.first().value<QList<PlasmaWindow *>>();
+            }
+            return batched.count();
+        }(),
+        5,
+        5000);
+    QVERIFY(windowsCreatedSpy.count() <= windowCreatedSpy.count());
+    QCOMPARE(windowCreatedSpy.count(), 5);
+    for (const QList<QVariant> &arguments : qAsConst(windowCreatedSpy)) {
+        QVERIFY(batched.contains(arguments.first().value<PlasmaWindow *>()));
+    }
+    qDeleteAll(serverWindows);
+}
+
+void TestWindowManagement::testSubscribedProperties()
+{
+    // this test verifies that a client only gets the window properties it subscribed to
+    using namespace KWayland::Client;
+    using Property = KWaylandServer::PlasmaWindowManagementInterface::WindowProperty;
+    QCOMPARE(m_display->connections().count(), 1);
+    KWaylandServer::ClientConnection *client = m_display->connections().first();
+    QCOMPARE(m_windowManagementInterface->subscribedWindowProperties(client), KWaylandServer::PlasmaWindowManagementInterface::WindowProperties(Property::All));
+    m_windowManagementInterface->setSubscribedWindowProperties(client, Property::Geometry | Property::State);
+    QCOMPARE(m_windowManagementInterface->subscribedWindowProperties(client), Property::Geometry | Property::State);
+
+    QSignalSpy windowCreatedSpy(m_windowManagement, &PlasmaWindowManagement::windowCreated);
+    QVERIFY(windowCreatedSpy.isValid());
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> serverWindow(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    serverWindow->setTitle(QStringLiteral("title"));
+    serverWindow->setAppId(QStringLiteral("appid"));
+    serverWindow->setGeometry(QRect(0, 1, 100, 200));
+    serverWindow->setMaximized(true);
+    QVERIFY(windowCreatedSpy.wait());
+    auto window = windowCreatedSpy.first().first().value<PlasmaWindow *>();
+    QVERIFY(window->title().isEmpty());
+    QVERIFY(window->appId().isEmpty());
+    QCOMPARE(window->geometry(), QRect(0, 1, 100, 200));
+    QVERIFY(window->isMaximized());
+
+    // nor does it get changes of the other properties
+    QSignalSpy titleChangedSpy(window, &PlasmaWindow::titleChanged);
+    QVERIFY(titleChangedSpy.isValid());
+    QSignalSpy geometryChangedSpy(window, &PlasmaWindow::geometryChanged);
+    QVERIFY(geometryChangedSpy.isValid());
+    serverWindow->setTitle(QStringLiteral("new title"));
+    serverWindow->setGeometry(QRect(10, 10, 100, 200));
+    QVERIFY(geometryChangedSpy.wait());
+    QVERIFY(titleChangedSpy.isEmpty());
+    QVERIFY(window->title().isEmpty());
+}
+
+void TestWindowManagement::testRateLimit()
+{
+    // this test verifies that title changes within the rate limit are merged, but the last one is sent
+    using namespace KWayland::Client;
+    using Property = KWaylandServer::PlasmaWindowManagementInterface::WindowProperty;
+    QCOMPARE(m_windowManagementInterface->rateLimit(Property::Title), std::chrono::milliseconds::zero());
+    m_windowManagementInterface->setRateLimit(Property::Title, std::chrono::milliseconds(100));
+    QCOMPARE(m_windowManagementInterface->rateLimit(Property::Title), std::chrono::milliseconds(100));
+    QCOMPARE(m_windowManagementInterface->rateLimit(Property::Geometry), std::chrono::milliseconds::zero());
+
+    QSignalSpy titleChangedSpy(m_window, &PlasmaWindow::titleChanged);
+    QVERIFY(titleChangedSpy.isValid());
+    m_windowInterface->setTitle(QStringLiteral("1"));
+    QVERIFY(titleChangedSpy.wait());
+    QCOMPARE(m_window->title(), QStringLiteral("1"));
+
+    // the following changes are held back until the interval passed
+    QSignalSpy geometryChangedSpy(m_window, &PlasmaWindow::geometryChanged);
+    QVERIFY(geometryChangedSpy.isValid());
+    m_windowInterface->setTitle(QStringLiteral("2"));
+    m_windowInterface->setTitle(QStringLiteral("3"));
+    m_windowInterface->setGeometry(QRect(0, 0, 100, 200));
+    QVERIFY(geometryChangedSpy.wait());
+    QCOMPARE(titleChangedSpy.count(), 1);
+    QVERIFY(titleChangedSpy.wait());
+    QCOMPARE(titleChangedSpy.count(), 2);
+    QCOMPARE(m_window->title(), QStringLiteral("3"));
+}
+
+void TestWindowManagement::testCongestedClient()
+{
+    // this test verifies that the property changes for a client which doesn't read its events are
+    // held back, and that only the latest state is sent once the client caught up
+    using namespace KWayland::Client;
+    KWaylandServer::ClientConnection *client = m_display->connections().first();
+    QSignalSpy congestedSpy(client, &KWaylandServer::ClientConnection::congested);
+    QVERIFY(congestedSpy.isValid());
+    QSignalSpy relievedSpy(client, &KWaylandServer::ClientConnection::congestionRelieved);
+    QVERIFY(relievedSpy.isValid());
+    QSignalSpy titleChangedSpy(m_window, &PlasmaWindow::titleChanged);
+    QVERIFY(titleChangedSpy.isValid());
+    QSignalSpy geometryChangedSpy(m_window, &PlasmaWindow::geometryChanged);
+    QVERIFY(geometryChangedSpy.isValid());
+
+    // the connection thread stops reading the socket
+    QSemaphore blocked;
+    QSemaphore unblock;
+    auto unblockGuard = qScopeGuard([&unblock] {
+        unblock.release();
+    });
+    QMetaObject::invokeMethod(
+        m_connection,
+        [&blocked, &unblock] {
+            blocked.release();
+            unblock.acquire();
+        },
+        Qt::QueuedConnection);
+    blocked.acquire();
+
+    // any unread event makes the client congested
+    m_display->setClientCongestionThreshold(1);
+    m_windowInterface->setTitle(QStringLiteral("1"));
+    m_display->flush();
+    QVERIFY(client->isCongested());
+    QCOMPARE(congestedSpy.count(), 1);
+
+    m_windowInterface->setTitle(QStringLiteral("2"));
+    m_windowInterface->setGeometry(QRect(0, 0, 100, 200));
+    m_windowInterface->setTitle(QStringLiteral("3"));
+    m_display->flush();
+
+    unblockGuard.dismiss();
+    unblock.release();
+    QVERIFY(relievedSpy.wait());
+    QTRY_COMPARE(m_window->title(), QStringLiteral("3"));
+    QCOMPARE(titleChangedSpy.count(), 2);
+    QTRY_COMPARE(geometryChangedSpy.count(), 1);
+    QCOMPARE(m_window->geometry(), QRect(0, 0, 100, 200));
+
+    m_display->setClientCongestionThreshold(0);
+}
+
 QTEST_MAIN(TestWindowManagement)
 #include "test_wayland_windowmanagement.moc"
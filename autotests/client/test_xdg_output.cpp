@@ -9,6 +9,7 @@
 #include "../../src/server/display.h"
 #include "../../src/server/dpms_interface.h"
 #include "../../src/server/output_interface.h"
+#include "../../src/server/outputtransaction.h"
 #include "../../src/server/xdgoutput_v1_interface.h"
 #include "../../src/client/connection_thread.h"
 #include "../../src/client/dpms.h"
@@ -28,6 +29,7 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testChanges();
+    void testTransaction();
 
 private:
     KWaylandServer::Display *m_display;
@@ -161,6 +163,71 @@ void TestXdgOutput::testChanges()
     QCOMPARE(xdgOutputChanged.count(), 1);
     QCOMPARE(xdgOutput->logicalPosition(), QPoint(1000, 2000));
     QCOMPARE(xdgOutput->logicalSize(), QSize(100, 200));
+
+    // an update of a single property keeps the others
+    xdgOutputChanged.clear();
+    m_serverXdgOutput->setLogicalPosition(QPoint(500, 600));
+    m_serverXdgOutput->done();
+    m_serverOutput->done();
+    QVERIFY(xdgOutputChanged.wait());
+    QCOMPARE(xdgOutput->logicalPosition(), QPoint(500, 600));
+    QCOMPARE(xdgOutput->logicalSize(), QSize(100, 200));
+    QCOMPARE(xdgOutput->name(), "testName");
+}
+
+void TestXdgOutput::testTransaction()
+{
+    // changes to wl_output and xdg-output in one transaction should result in one done each
+    using namespace KWaylandServer;
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, &KWayland::Client::Registry::outputAnnounced);
+    QSignalSpy xdgOutputAnnounced(&registry, &KWayland::Client::Registry::xdgOutputAnnounced);
+
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(announced.wait());
+    if (xdgOutputAnnounced.count() != 1) {
+        QVERIFY(xdgOutputAnnounced.wait());
+    }
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, &KWayland::Client::Output::changed);
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    QVERIFY(outputChanged.wait());
+
+    QScopedPointer<KWayland::Client::XdgOutputManager> xdgOutputManager(
+        registry.createXdgOutputManager(xdgOutputAnnounced.first().first().value<quint32>(), xdgOutputAnnounced.first().last().value<quint32>(), this));
+    QScopedPointer<KWayland::Client::XdgOutput> xdgOutput(xdgOutputManager->getXdgOutput(&output, this));
+    QSignalSpy xdgOutputChanged(xdgOutput.data(), &KWayland::Client::XdgOutput::changed);
+    QVERIFY(xdgOutputChanged.wait());
+    outputChanged.clear();
+    xdgOutputChanged.clear();
+
+    {
+        OutputTransaction transaction(m_serverOutput, m_serverXdgOutput);
+        m_serverOutput->setScale(2);
+        m_serverOutput->done();
+        m_serverXdgOutput->setLogicalSize(QSize(960, 540));
+        m_serverXdgOutput->done();
+        m_serverOutput->setGlobalPosition(QPoint(1920, 0));
+        m_serverOutput->done();
+        m_serverXdgOutput->setLogicalPosition(QPoint(1920, 0));
+        m_serverXdgOutput->done();
+    }
+
+    QVERIFY(xdgOutputChanged.wait());
+    if (outputChanged.isEmpty()) {
+        QVERIFY(outputChanged.wait());
+    }
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+    QCOMPARE(xdgOutputChanged.count(), 1);
+    QCOMPARE(output.scale(), 2);
+    QCOMPARE(output.globalPosition(), QPoint(1920, 0));
+    QCOMPARE(xdgOutput->logicalSize(), QSize(960, 540));
+    QCOMPARE(xdgOutput->logicalPosition(), QPoint(1920, 0));
 }
 
 QTEST_GUILESS_MAIN(TestXdgOutput)
@@ -29,6 +29,7 @@ using namespace KWayland::Client;
 using namespace KWaylandServer;
 
 Q_DECLARE_METATYPE(Qt::MouseButton)
+Q_DECLARE_METATYPE(std::chrono::microseconds)
 
 static const QString s_socketName = QStringLiteral("kwayland-test-xdg_shell-0");
 
@@ -56,6 +57,10 @@ private Q_SLOTS:
     void testConfigureStates_data();
     void testConfigureStates();
     void testConfigureMultipleAcks();
+    void testConfigureCoalescing();
+    void testInteractiveResize();
+    void testAutoAckConfigure();
+    void testPopupPlacement();
 
 private:
     XdgShellInterface *m_xdgShellInterface = nullptr;
@@ -462,8 +467,10 @@ void XdgShellTest::testPing()
     QCOMPARE(pingSpy.takeFirst().at(0).value<quint32>(), serial);
 
     // test of a ping failure
-    // disconnecting the connection thread to the queue will break the connection and pings will do a timeout
-    disconnect(m_connection, &ConnectionThread::eventsRead, m_queue, &EventQueue::dispatch);
+    // disabling the wakeup of the queue by the connection thread will break the connection and pings will do a timeout
+    QSocketNotifier *wakeupNotifier = m_queue->findChild<QSocketNotifier *>();
+    QVERIFY(wakeupNotifier);
+    wakeupNotifier->setEnabled(false);
     m_xdgShellInterface->ping(serverXdgToplevel->xdgSurface());
     QSignalSpy pingDelayedSpy(m_xdgShellInterface, &XdgShellInterface::pingDelayed);
     QVERIFY(pingDelayedSpy.wait());
@@ -607,5 +614,157 @@ void XdgShellTest::testConfigureMultipleAcks()
     QCOMPARE(xdgSurface->size(), QSize(30, 40));
 }
 
+void XdgShellTest::testConfigureCoalescing()
+{
+    qRegisterMetaType<XdgShellSurface::States>();
+    qRegisterMetaType<std::chrono::microseconds>();
+    // this test verifies that only one configure is outstanding and the rest is coalesced
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QVERIFY(configureSpy.isValid());
+    QSignalSpy latencySpy(serverXdgToplevel, &XdgToplevelInterface::configureLatencyReported);
+    QVERIFY(latencySpy.isValid());
+
+    serverXdgToplevel->setConfigureCoalescing(true);
+    QVERIFY(serverXdgToplevel->coalescesConfigures());
+    const quint32 serial1 = serverXdgToplevel->sendConfigure(QSize(10, 20), XdgToplevelInterface::States());
+    const quint32 serial2 = serverXdgToplevel->sendConfigure(QSize(20, 30), XdgToplevelInterface::States());
+    const quint32 serial3 = serverXdgToplevel->sendConfigure(QSize(30, 40), XdgToplevelInterface::State::Resizing);
+    QVERIFY(serial1 != serial2);
+    QVERIFY(serial2 != serial3);
+
+    QVERIFY(configureSpy.wait());
+    QVERIFY(!configureSpy.wait(100));
+    QCOMPARE(configureSpy.count(), 1);
+    QCOMPARE(configureSpy.first().at(0).toSize(), QSize(10, 20));
+    QCOMPARE(configureSpy.first().at(2).value<quint32>(), serial1);
+
+    // acknowledging the outstanding configure sends the latest state
+    xdgSurface->ackConfigure(serial1);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.count(), 2);
+    QCOMPARE(configureSpy.last().at(0).toSize(), QSize(30, 40));
+    QCOMPARE(configureSpy.last().at(1).value<XdgShellSurface::States>(), XdgShellSurface::States(XdgShellSurface::State::Resizing));
+    QCOMPARE(configureSpy.last().at(2).value<quint32>(), serial3);
+    QCOMPARE(latencySpy.count(), 1);
+    QCOMPARE(latencySpy.first().first().value<quint32>(), serial1);
+
+    xdgSurface->ackConfigure(serial3);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(latencySpy.wait());
+    QCOMPARE(latencySpy.last().first().value<quint32>(), serial3);
+    QCOMPARE(latencySpy.last().last().value<std::chrono::microseconds>(), serverXdgToplevel->lastConfigureLatency());
+}
+
+void XdgShellTest::testInteractiveResize()
+{
+    qRegisterMetaType<XdgShellSurface::States>();
+    // this test verifies that the acknowledged configure state tells whether a resize is interactive
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QVERIFY(configureSpy.isValid());
+    QSignalSpy resizingSpy(serverXdgToplevel, &XdgToplevelInterface::resizingChanged);
+    QVERIFY(resizingSpy.isValid());
+    QCOMPARE(serverXdgToplevel->acknowledgedConfigure(), 0u);
+    QVERIFY(!serverXdgToplevel->isResizing());
+
+    const quint32 serial1 = serverXdgToplevel->sendConfigure(QSize(10, 20), XdgToplevelInterface::State::Resizing);
+    const quint32 serial2 = serverXdgToplevel->sendConfigure(QSize(20, 30), XdgToplevelInterface::State::Resizing);
+    QVERIFY(serverXdgToplevel->isConfigurePending());
+    QCOMPARE(serverXdgToplevel->pendingSize(), QSize(20, 30));
+    QVERIFY(!serverXdgToplevel->isResizing());
+
+    QVERIFY(configureSpy.wait());
+    xdgSurface->ackConfigure(serial1);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(resizingSpy.wait());
+    QCOMPARE(resizingSpy.first().first().toBool(), true);
+    QVERIFY(serverXdgToplevel->isResizing());
+    QCOMPARE(serverXdgToplevel->acknowledgedConfigure(), serial1);
+    QCOMPARE(serverXdgToplevel->acknowledgedSize(), QSize(10, 20));
+    QVERIFY(serverXdgToplevel->isConfigurePending());
+
+    // the final configure ends the resize
+    const quint32 serial3 = serverXdgToplevel->sendConfigure(QSize(30, 40), XdgToplevelInterface::States());
+    QVERIFY(serial2 != serial3);
+    xdgSurface->ackConfigure(serial3);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(resizingSpy.wait());
+    QCOMPARE(resizingSpy.count(), 2);
+    QCOMPARE(resizingSpy.last().first().toBool(), false);
+    QCOMPARE(serverXdgToplevel->acknowledgedConfigure(), serial3);
+    QCOMPARE(serverXdgToplevel->acknowledgedStates(), XdgToplevelInterface::States());
+    QVERIFY(!serverXdgToplevel->isConfigurePending());
+    QCOMPARE(serverXdgToplevel->pendingSize(), QSize(30, 40));
+}
+
+void XdgShellTest::testAutoAckConfigure()
+{
+    qRegisterMetaType<XdgShellSurface::States>();
+    // this test verifies that the last configure is acked on the next commit
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QVERIFY(configureSpy.isValid());
+    QSignalSpy ackSpy(serverXdgToplevel->xdgSurface(), &XdgSurfaceInterface::configureAcknowledged);
+    QVERIFY(ackSpy.isValid());
+    QVERIFY(!xdgSurface->autoAckConfigure());
+    xdgSurface->setAutoAckConfigure(true);
+    QVERIFY(xdgSurface->autoAckConfigure());
+
+    serverXdgToplevel->sendConfigure(QSize(10, 20), XdgToplevelInterface::States());
+    const quint32 serial = serverXdgToplevel->sendConfigure(QSize(20, 30), XdgToplevelInterface::State::Activated);
+    QVERIFY(configureSpy.wait());
+    QTRY_COMPARE(configureSpy.count(), 2);
+
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(ackSpy.wait());
+    QCOMPARE(ackSpy.count(), 1);
+    QCOMPARE(ackSpy.first().first().value<quint32>(), serial);
+
+    // nothing is acked twice
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(!ackSpy.wait(100));
+
+    // without auto ack the client acks itself again
+    xdgSurface->setAutoAckConfigure(false);
+    serverXdgToplevel->sendConfigure(QSize(30, 40), XdgToplevelInterface::States());
+    QVERIFY(configureSpy.wait());
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(!ackSpy.wait(100));
+}
+
+void XdgShellTest::testPopupPlacement()
+{
+    // this test verifies the placement of a popup with the constraint adjustments of its positioner
+    SURFACE
+
+    KWayland::Client::XdgPositioner positioner(QSize(100, 50), QRect(90, 10, 10, 10));
+    positioner.setAnchorEdge(Qt::BottomEdge | Qt::RightEdge);
+    positioner.setGravity(Qt::BottomEdge | Qt::RightEdge);
+    positioner.setConstraints(KWayland::Client::XdgPositioner::Constraint::FlipX | KWayland::Client::XdgPositioner::Constraint::SlideY);
+
+    QSignalSpy popupCreatedSpy(m_xdgShellInterface, &XdgShellInterface::popupCreated);
+    QVERIFY(popupCreatedSpy.isValid());
+    QScopedPointer<Surface> popupSurface(m_compositor->createSurface());
+    QScopedPointer<XdgShellPopup> popup(m_xdgShell->createPopup(popupSurface.data(), xdgSurface.data(), positioner));
+    QVERIFY(popupCreatedSpy.wait());
+    auto serverPopup = popupCreatedSpy.first().first().value<XdgPopupInterface *>();
+    QVERIFY(serverPopup);
+    const KWaylandServer::XdgPositioner serverPositioner = serverPopup->positioner();
+
+    // without bounds the popup is placed at the bottom right of the anchor rect
+    QCOMPARE(serverPositioner.placement(QRect()), QRect(100, 20, 100, 50));
+    // it's flipped to the left of the anchor rect and slid up to fit
+    const QRect bounds(-200, 0, 350, 60);
+    QCOMPARE(serverPositioner.placement(bounds), QRect(-10, 10, 100, 50));
+    QCOMPARE(serverPositioner.placement(bounds), QRect(-10, 10, 100, 50));
+    // a flip that does not fit either is not applied
+    QCOMPARE(serverPositioner.placement(QRect(0, 0, 150, 100)), QRect(100, 20, 100, 50));
+}
+
 QTEST_GUILESS_MAIN(XdgShellTest)
 #include "test_xdg_shell.moc"
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "inprocessfixture.h"
+// KWin
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/server/clientconnection.h"
+#include "../../src/server/display.h"
+// Wayland
+#include <wayland-client-protocol.h>
+// system
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// more than any request of the client needs, the server answers within the first exchange
+static const int s_maxRoundtripExchanges = 16;
+
+InProcessFixture::InProcessFixture(QObject *parent)
+    : QObject(parent)
+{
+}
+
+InProcessFixture::~InProcessFixture()
+{
+    delete m_registry;
+    delete m_queue;
+    delete m_connection;
+    delete m_display;
+}
+
+bool InProcessFixture::setUp()
+{
+    m_display = new KWaylandServer::Display(this);
+    if (!m_display->start(KWaylandServer::Display::EventLoopIntegration::External)) {
+        return false;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+        return false;
+    }
+    m_clientConnection = m_display->createClient(fds[0]);
+    if (!m_clientConnection) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    // connect right away instead of through the queued initConnection
+    m_connection = new KWayland::Client::ConnectionThread;
+    m_connection->setSocketFd(fds[1]);
+    QMetaObject::invokeMethod(m_connection, "doInitConnection", Qt::DirectConnection);
+    if (!m_connection->display()) {
+        return false;
+    }
+
+    m_queue = new KWayland::Client::EventQueue;
+    m_queue->setup(m_connection->display());
+    return m_queue->isValid();
+}
+
+bool InProcessFixture::announce()
+{
+    m_registry = new KWayland::Client::Registry;
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    m_registry->setup();
+    // the globals, then the initial events of the interfaces the registry bound
+    return roundtrip() && roundtrip();
+}
+
+KWaylandServer::Display *InProcessFixture::display() const
+{
+    return m_display;
+}
+
+KWaylandServer::ClientConnection *InProcessFixture::clientConnection() const
+{
+    return m_clientConnection;
+}
+
+KWayland::Client::ConnectionThread *InProcessFixture::connection() const
+{
+    return m_connection;
+}
+
+KWayland::Client::EventQueue *InProcessFixture::queue() const
+{
+    return m_queue;
+}
+
+KWayland::Client::Registry *InProcessFixture::registry() const
+{
+    return m_registry;
+}
+
+void InProcessFixture::flushClient()
+{
+    wl_display_flush(m_connection->display());
+}
+
+void InProcessFixture::dispatchServer()
+{
+    m_display->dispatchEvents(0);
+    m_display->flush();
+}
+
+void InProcessFixture::dispatchClient()
+{
+    wl_display *display = m_connection->display();
+    while (wl_display_prepare_read(display) != 0) {
+        wl_display_dispatch_pending(display);
+    }
+    pollfd pfd = {wl_display_get_fd(display), POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0) {
+        wl_display_read_events(display);
+    } else {
+        wl_display_cancel_read(display);
+    }
+    wl_display_dispatch_pending(display);
+    m_queue->dispatch();
+}
+
+void InProcessFixture::pump()
+{
+    flushClient();
+    dispatchServer();
+    dispatchClient();
+}
+
+bool InProcessFixture::roundtrip()
+{
+    static const wl_callback_listener listener = {
+        [](void *data, wl_callback *callback, uint32_t) {
+            *static_cast<bool *>(data) = true;
+            wl_callback_destroy(callback);
+        },
+    };
+    bool done = false;
+    wl_callback *callback = wl_display_sync(m_connection->display());
+    wl_callback_add_listener(callback, &listener, &done);
+    for (int i = 0; i < s_maxRoundtripExchanges && !done; ++i) {
+        pump();
+    }
+    if (!done) {
+        // the listener must not write to done once it is gone
+        wl_callback_destroy(callback);
+    }
+    return done;
+}
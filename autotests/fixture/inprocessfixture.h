@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class ClientConnection;
+class Display;
+}
+
+namespace KWayland
+{
+namespace Client
+{
+class ConnectionThread;
+class EventQueue;
+class Registry;
+}
+}
+
+/**
+ * A Display and a client connection in the same thread, connected through a socketpair.
+ *
+ * Nothing is driven by the Qt event loop: the test moves messages between the client and the
+ * server with explicit steps, so it doesn't need QSignalSpy::wait and its timeouts. Every step
+ * processes what is available on the socket and returns, which makes the fixture deterministic
+ * and suitable for benchmarks of protocol paths.
+ *
+ * @code
+ * InProcessFixture fixture;
+ * QVERIFY(fixture.setUp());
+ * new CompositorInterface(fixture.display(), fixture.display());
+ * QVERIFY(fixture.announce());
+ * auto compositor = fixture.registry()->createCompositor(...);
+ * auto surface = compositor->createSurface();
+ * QVERIFY(fixture.roundtrip());
+ * @endcode
+ */
+class InProcessFixture : public QObject
+{
+    Q_OBJECT
+public:
+    explicit InProcessFixture(QObject *parent = nullptr);
+    ~InProcessFixture() override;
+
+    /**
+     * Starts the Display and connects the client to it. The globals can be created on the
+     * display() afterwards and are announced to the client with announce().
+     */
+    bool setUp();
+    /**
+     * Creates the registry() and finishes once the client got all globals and their initial
+     * events.
+     */
+    bool announce();
+
+    KWaylandServer::Display *display() const;
+    KWaylandServer::ClientConnection *clientConnection() const;
+    KWayland::Client::ConnectionThread *connection() const;
+    KWayland::Client::EventQueue *queue() const;
+    KWayland::Client::Registry *registry() const;
+
+    /**
+     * Sends the requests of the client to the server.
+     */
+    void flushClient();
+    /**
+     * Dispatches the requests the server received and sends its events to the client.
+     */
+    void dispatchServer();
+    /**
+     * Reads the events the client received and dispatches them on the queue().
+     */
+    void dispatchClient();
+    /**
+     * One exchange in both directions, flushClient, dispatchServer and dispatchClient.
+     */
+    void pump();
+    /**
+     * Pumps until the server processed all requests the client sent before and the client
+     * dispatched all events the server sent in reply. Fails if it doesn't finish within a
+     * few exchanges, e.g. because the server stopped reading the client.
+     */
+    bool roundtrip();
+
+private:
+    KWaylandServer::Display *m_display = nullptr;
+    KWaylandServer::ClientConnection *m_clientConnection = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+};
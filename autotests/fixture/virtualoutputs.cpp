@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "virtualoutputs.h"
+// KWin
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputdevice_v2_interface.h"
+#include "../../src/server/surface_interface.h"
+#include "../../src/server/xdgoutput_v1_interface.h"
+// Qt
+#include <QUuid>
+// std
+#include <algorithm>
+#include <cmath>
+
+using namespace KWaylandServer;
+
+// the resolution of the physical size the monitors report
+static const qreal s_dpi = 96;
+
+static const QSize s_commonModes[] = {
+    QSize(3840, 2160),
+    QSize(2560, 1440),
+    QSize(1920, 1200),
+    QSize(1920, 1080),
+    QSize(1680, 1050),
+    QSize(1600, 900),
+    QSize(1280, 1024),
+    QSize(1280, 720),
+    QSize(1024, 768),
+    QSize(800, 600),
+    QSize(640, 480),
+};
+
+static std::chrono::nanoseconds refreshPeriod(int refreshRate)
+{
+    return std::chrono::nanoseconds(qint64(1e12 / refreshRate));
+}
+
+static QSize physicalSize(const QSize &size)
+{
+    return QSize(std::round(size.width() * 25.4 / s_dpi), std::round(size.height() * 25.4 / s_dpi));
+}
+
+VirtualOutputs::VirtualOutputs(Display *display, QObject *parent)
+    : QObject(parent)
+    , m_display(display)
+    , m_xdgOutputManager(new XdgOutputManagerV1Interface(display, this))
+{
+}
+
+VirtualOutputs::~VirtualOutputs()
+{
+    const QVector<Output *> outputs = m_outputs;
+    for (Output *output : outputs) {
+        remove(output);
+    }
+    purge();
+}
+
+VirtualOutputs::Output *VirtualOutputs::add(const QSize &size, int refreshRate)
+{
+    const quint32 serial = ++m_serial;
+    const QString name = QStringLiteral("Virtual-%1").arg(serial);
+
+    auto output = new Output;
+    output->nextVblank = m_now + refreshPeriod(refreshRate);
+
+    output->output = new OutputInterface(m_display);
+    output->output->beginUpdate();
+    output->output->setManufacturer(QStringLiteral("DWL"));
+    output->output->setModel(name);
+    output->output->setPhysicalSize(physicalSize(size));
+    output->output->setMode(size, refreshRate);
+    output->output->setScale(std::ceil(m_scale));
+    output->output->endUpdate();
+
+    output->xdgOutput = m_xdgOutputManager->createXdgOutput(output->output, output->output);
+    output->xdgOutput->beginUpdate();
+    output->xdgOutput->setName(name);
+    output->xdgOutput->setDescription(QStringLiteral("DWL %1").arg(name));
+    output->xdgOutput->setLogicalSize(size / m_scale);
+    output->xdgOutput->endUpdate();
+
+    output->device = new OutputDeviceV2Interface(m_display);
+    output->device->beginUpdate();
+    output->device->setManufacturer(QStringLiteral("DWL"));
+    output->device->setModel(name);
+    output->device->setName(name);
+    output->device->setSerialNumber(QString::number(serial));
+    output->device->setEisaId(QStringLiteral("DWL"));
+    output->device->setUuid(QUuid::createUuid());
+    output->device->setPhysicalSize(physicalSize(size));
+    output->device->setEdid(edid(size, refreshRate, serial));
+    output->device->setScale(m_scale);
+    QList<OutputDeviceModeV2Interface *> modes;
+    OutputDeviceModeV2Interface *current = nullptr;
+    for (const QSize &modeSize : modeSizes(size)) {
+        if (modeSize == size) {
+            current = new OutputDeviceModeV2Interface(modeSize,
+                                                      refreshRate,
+                                                      OutputDeviceModeV2Interface::ModeFlag::Current | OutputDeviceModeV2Interface::ModeFlag::Preferred,
+                                                      output->device);
+            modes << current;
+            if (refreshRate == 60000) {
+                continue;
+            }
+        }
+        modes << new OutputDeviceModeV2Interface(modeSize, 60000, {}, output->device);
+    }
+    output->device->setModes(modes);
+    output->device->setCurrentMode(current);
+    output->device->setEnabled(true);
+    output->device->endUpdate();
+
+    m_outputs << output;
+    place();
+    return output;
+}
+
+void VirtualOutputs::remove(Output *output)
+{
+    if (!m_outputs.removeOne(output)) {
+        return;
+    }
+    output->device->remove();
+    output->output->remove();
+    m_removed << output;
+    place();
+}
+
+void VirtualOutputs::hotplugStorm(int cycles)
+{
+    if (m_outputs.isEmpty()) {
+        return;
+    }
+    const QSize size = m_outputs.last()->output->pixelSize();
+    const int refreshRate = m_outputs.last()->output->refreshRate();
+    for (int i = 0; i < cycles; ++i) {
+        remove(m_outputs.last());
+        add(size, refreshRate);
+    }
+}
+
+void VirtualOutputs::setScale(qreal scale)
+{
+    m_scale = scale;
+    for (Output *output : qAsConst(m_outputs)) {
+        output->output->setScale(std::ceil(scale));
+        output->device->setScale(scale);
+        output->xdgOutput->setLogicalSize(output->output->pixelSize() / scale);
+    }
+    place();
+}
+
+void VirtualOutputs::purge()
+{
+    for (Output *output : qAsConst(m_removed)) {
+        delete output->device;
+        // the xdg-output is a child of the output
+        delete output->output;
+        delete output;
+    }
+    m_removed.clear();
+}
+
+void VirtualOutputs::place()
+{
+    int x = 0;
+    for (Output *output : qAsConst(m_outputs)) {
+        const QPoint position(x, 0);
+        output->output->beginUpdate();
+        output->output->setGlobalPosition(position);
+        output->output->endUpdate();
+        output->device->beginUpdate();
+        output->device->setGlobalPosition(position);
+        output->device->endUpdate();
+        output->xdgOutput->beginUpdate();
+        output->xdgOutput->setLogicalPosition(position);
+        output->xdgOutput->endUpdate();
+        x += std::ceil(output->output->pixelSize().width() / m_scale);
+    }
+}
+
+QVector<VirtualOutputs::Output *> VirtualOutputs::outputs() const
+{
+    return m_outputs;
+}
+
+XdgOutputManagerV1Interface *VirtualOutputs::xdgOutputManager() const
+{
+    return m_xdgOutputManager;
+}
+
+int VirtualOutputs::advance(std::chrono::nanoseconds duration, const QVector<SurfaceInterface *> &surfaces)
+{
+    const std::chrono::nanoseconds end = m_now + duration;
+    int vblanks = 0;
+    while (true) {
+        // the vblanks of all outputs in the order they happen
+        Output *next = nullptr;
+        for (Output *output : qAsConst(m_outputs)) {
+            if (output->nextVblank <= end && (!next || output->nextVblank < next->nextVblank)) {
+                next = output;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        for (SurfaceInterface *surface : surfaces) {
+            surface->frameRendered(next->output, next->nextVblank);
+        }
+        next->nextVblank += refreshPeriod(next->output->refreshRate());
+        vblanks++;
+    }
+    m_now = end;
+    return vblanks;
+}
+
+std::chrono::nanoseconds VirtualOutputs::now() const
+{
+    return m_now;
+}
+
+QVector<QSize> VirtualOutputs::modeSizes(const QSize &size)
+{
+    QVector<QSize> sizes{size};
+    for (const QSize &mode : s_commonModes) {
+        if (mode != size && mode.width() <= size.width() && mode.height() <= size.height()) {
+            sizes << mode;
+        }
+    }
+    return sizes;
+}
+
+QByteArray VirtualOutputs::edid(const QSize &size, int refreshRate, quint32 serial)
+{
+    QByteArray edid(128, 0);
+    auto data = reinterpret_cast<uchar *>(edid.data());
+
+    // header
+    data[1] = data[2] = data[3] = data[4] = data[5] = data[6] = 0xff;
+    // the manufacturer "DWL" in compressed ASCII, product code and serial number
+    const quint16 manufacturer = (('D' - '@') << 10) | (('W' - '@') << 5) | ('L' - '@');
+    data[8] = manufacturer >> 8;
+    data[9] = manufacturer & 0xff;
+    data[10] = 0x01;
+    data[12] = serial & 0xff;
+    data[13] = (serial >> 8) & 0xff;
+    data[14] = (serial >> 16) & 0xff;
+    data[15] = (serial >> 24) & 0xff;
+    // week and year of manufacture, 2023
+    data[16] = 1;
+    data[17] = 2023 - 1990;
+    // EDID 1.4, digital input with 8 bits per color and DisplayPort
+    data[18] = 1;
+    data[19] = 4;
+    data[20] = 0xa5;
+    const QSize millimeters = physicalSize(size);
+    data[21] = std::round(millimeters.width() / 10.0);
+    data[22] = std::round(millimeters.height() / 10.0);
+    // gamma 2.2, RGB 4:4:4 with a preferred timing mode
+    data[23] = 120;
+    data[24] = 0x06;
+    // no standard timings
+    for (int i = 38; i < 54; ++i) {
+        data[i] = 0x01;
+    }
+
+    // the detailed timing of the native mode, with reduced blanking
+    uchar *timing = data + 54;
+    const int hblank = 160;
+    const int vblank = std::max(8, int(std::ceil(460e-6 * refreshRate / 1000 * size.height())));
+    // in 10 kHz, modes above 655 MHz need an extension block, which isn't worth it here
+    const quint64 pixelClock = std::min<quint64>(quint64(size.width() + hblank) * (size.height() + vblank) * refreshRate / 1000 / 10000, 0xffff);
+    timing[0] = pixelClock & 0xff;
+    timing[1] = (pixelClock >> 8) & 0xff;
+    timing[2] = size.width() & 0xff;
+    timing[3] = hblank & 0xff;
+    timing[4] = ((size.width() >> 8) << 4) | (hblank >> 8);
+    timing[5] = size.height() & 0xff;
+    timing[6] = vblank & 0xff;
+    timing[7] = ((size.height() >> 8) << 4) | (vblank >> 8);
+    // sync offsets and widths
+    timing[8] = 48;
+    timing[9] = 32;
+    timing[10] = (3 << 4) | 5;
+    timing[12] = millimeters.width() & 0xff;
+    timing[13] = millimeters.height() & 0xff;
+    timing[14] = ((millimeters.width() >> 8) << 4) | (millimeters.height() >> 8);
+    // digital separate sync, positive horizontal sync
+    timing[17] = 0x1a;
+
+    // the monitor name
+    uchar *name = data + 72;
+    name[3] = 0xfc;
+    const QByteArray model = QByteArrayLiteral("DWL Virtual");
+    for (int i = 0; i < 13; ++i) {
+        name[5 + i] = i < model.size() ? model.at(i) : (i == model.size() ? 0x0a : 0x20);
+    }
+    // the remaining descriptors are dummies
+    data[90 + 3] = 0x10;
+    data[108 + 3] = 0x10;
+
+    uchar checksum = 0;
+    for (int i = 0; i < 127; ++i) {
+        checksum += data[i];
+    }
+    data[127] = -checksum;
+    return edid;
+}
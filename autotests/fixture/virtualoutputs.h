@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QObject>
+#include <QSize>
+#include <QVector>
+
+#include <chrono>
+
+namespace KWaylandServer
+{
+class Display;
+class OutputDeviceV2Interface;
+class OutputInterface;
+class SurfaceInterface;
+class XdgOutputManagerV1Interface;
+class XdgOutputV1Interface;
+}
+
+/**
+ * Fake monitors for the tests and benchmarks of output heavy paths.
+ *
+ * Every virtual output is announced through wl_output, xdg-output and the output device, with
+ * the mode list and the EDID of a real monitor. The outputs are placed next to each other.
+ * Hotplugs, scale changes and vblanks are driven by the test, the vblanks on a virtual clock,
+ * so a benchmark doesn't wait for real refresh cycles.
+ */
+class VirtualOutputs : public QObject
+{
+    Q_OBJECT
+public:
+    struct Output {
+        KWaylandServer::OutputInterface *output = nullptr;
+        KWaylandServer::OutputDeviceV2Interface *device = nullptr;
+        KWaylandServer::XdgOutputV1Interface *xdgOutput = nullptr;
+        // the time of the next vblank on the virtual clock
+        std::chrono::nanoseconds nextVblank = std::chrono::nanoseconds::zero();
+    };
+
+    /**
+     * Must be destroyed before the @p display.
+     */
+    explicit VirtualOutputs(KWaylandServer::Display *display, QObject *parent = nullptr);
+    ~VirtualOutputs() override;
+
+    /**
+     * Plugs in a monitor with the native @p size and @p refreshRate in mHz, right of the others.
+     */
+    Output *add(const QSize &size = QSize(1920, 1080), int refreshRate = 60000);
+    /**
+     * Unplugs @p output. Its interfaces stay around until purge, clients may still bind the
+     * removed globals in the meantime.
+     */
+    void remove(Output *output);
+    /**
+     * Unplugs and plugs in the last output @p cycles times, without anything in between.
+     */
+    void hotplugStorm(int cycles);
+    /**
+     * Changes the scale of all outputs, each output sends its changes at once.
+     */
+    void setScale(qreal scale);
+    /**
+     * Destroys the interfaces of the removed outputs.
+     */
+    void purge();
+
+    QVector<Output *> outputs() const;
+    KWaylandServer::XdgOutputManagerV1Interface *xdgOutputManager() const;
+
+    /**
+     * Advances the virtual clock by @p duration. Delivers the frame callbacks of @p surfaces
+     * for every vblank of every output within that time, like a compositor presenting them on
+     * all outputs.
+     * @returns the number of vblanks
+     */
+    int advance(std::chrono::nanoseconds duration, const QVector<KWaylandServer::SurfaceInterface *> &surfaces);
+    std::chrono::nanoseconds now() const;
+
+    /**
+     * @returns the modes a monitor with the native @p size offers, the native one first
+     */
+    static QVector<QSize> modeSizes(const QSize &size);
+    /**
+     * @returns a valid EDID 1.4 base block for a monitor with the native @p size and
+     * @p refreshRate and the serial number @p serial
+     */
+    static QByteArray edid(const QSize &size, int refreshRate, quint32 serial);
+
+private:
+    void place();
+
+    KWaylandServer::Display *m_display;
+    KWaylandServer::XdgOutputManagerV1Interface *m_xdgOutputManager;
+    QVector<Output *> m_outputs;
+    QVector<Output *> m_removed;
+    quint32 m_serial = 0;
+    qreal m_scale = 1;
+    std::chrono::nanoseconds m_now = std::chrono::nanoseconds::zero();
+};
@@ -0,0 +1,219 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/frogcolormanagement_v1_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+
+#include "qwayland-frog-color-management-v1.h"
+
+using namespace KWaylandServer;
+
+class FrogColorManagementFactory : public QtWayland::frog_color_management_factory_v1
+{
+};
+
+class FrogColorManagedSurface : public QtWayland::frog_color_managed_surface
+{
+public:
+    using QtWayland::frog_color_managed_surface::frog_color_managed_surface;
+
+    uint32_t preferredTransferFunction = 0;
+    uint32_t preferredRedX = 0;
+    uint32_t preferredMaxLuminance = 0;
+    int preferredCount = 0;
+
+protected:
+    void frog_color_managed_surface_preferred_metadata(uint32_t transfer_function,
+                                                       uint32_t output_display_primary_red_x,
+                                                       uint32_t output_display_primary_red_y,
+                                                       uint32_t output_display_primary_green_x,
+                                                       uint32_t output_display_primary_green_y,
+                                                       uint32_t output_display_primary_blue_x,
+                                                       uint32_t output_display_primary_blue_y,
+                                                       uint32_t output_white_point_x,
+                                                       uint32_t output_white_point_y,
+                                                       uint32_t max_luminance,
+                                                       uint32_t min_luminance,
+                                                       uint32_t max_full_frame_luminance) override
+    {
+        Q_UNUSED(output_display_primary_red_y)
+        Q_UNUSED(output_display_primary_green_x)
+        Q_UNUSED(output_display_primary_green_y)
+        Q_UNUSED(output_display_primary_blue_x)
+        Q_UNUSED(output_display_primary_blue_y)
+        Q_UNUSED(output_white_point_x)
+        Q_UNUSED(output_white_point_y)
+        Q_UNUSED(min_luminance)
+        Q_UNUSED(max_full_frame_luminance)
+        preferredTransferFunction = transfer_function;
+        preferredRedX = output_display_primary_red_x;
+        preferredMaxLuminance = max_luminance;
+        preferredCount++;
+    }
+};
+
+class TestColorManagement : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestColorManagement() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testColorManagement();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    FrogColorManagementFactory *m_frogColorManagement = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-color-management-test-0");
+
+void TestColorManagement::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new FrogColorManagementV1Interface(&m_display);
+
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+    QVERIFY(!m_connection->connections().isEmpty());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("frog_color_management_factory_v1")) {
+            m_frogColorManagement = new FrogColorManagementFactory();
+            m_frogColorManagement->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+    QVERIFY(m_frogColorManagement);
+}
+
+TestColorManagement::~TestColorManagement()
+{
+    if (m_frogColorManagement) {
+        delete m_frogColorManagement;
+        m_frogColorManagement = nullptr;
+    }
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestColorManagement::testColorManagement()
+{
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->colorDescription(), ColorDescription());
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QSignalSpy colorDescriptionChangedSpy(serverSurface, &SurfaceInterface::colorDescriptionChanged);
+
+    // the preferred color space is announced right away, sRGB by default
+    FrogColorManagedSurface colorSurface(m_frogColorManagement->get_color_managed_surface(*clientSurface));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QTRY_COMPARE(colorSurface.preferredCount, 1);
+    QCOMPARE(colorSurface.preferredTransferFunction, uint32_t(QtWayland::frog_color_managed_surface::transfer_function_srgb));
+    QCOMPARE(colorSurface.preferredRedX, 32000u);
+    QCOMPARE(colorSurface.preferredMaxLuminance, 80u);
+
+    // the description is double-buffered
+    colorSurface.set_known_transfer_function(QtWayland::frog_color_managed_surface::transfer_function_st2084_pq);
+    colorSurface.set_known_container_color_volume(QtWayland::frog_color_managed_surface::primaries_rec2020);
+    colorSurface.set_hdr_metadata(35400, 14600, 8500, 39850, 6550, 2300, 15635, 16450, 1000, 50, 800, 400);
+    clientSurface->damage(QRect(0, 0, 10, 10));
+    QVERIFY(!committedSpy.wait(100));
+    QCOMPARE(serverSurface->colorDescription(), ColorDescription());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(colorDescriptionChangedSpy.count(), 1);
+    const ColorDescription description = serverSurface->colorDescription();
+    QCOMPARE(description.transferFunction, ColorDescription::TransferFunction::PerceptualQuantizer);
+    QCOMPARE(description.primaries, ColorDescription::Primaries::Rec2020);
+    QVERIFY(description.hdrMetadata);
+    QCOMPARE(description.hdrMetadata->mastering.red, QPointF(0.708, 0.292));
+    QCOMPARE(description.hdrMetadata->maxMasteringLuminance, 1000.0);
+    QCOMPARE(description.hdrMetadata->minMasteringLuminance, 0.005);
+    QCOMPARE(description.hdrMetadata->maxContentLightLevel, 800.0);
+
+    // a new preferred color space is sent once
+    ColorDescription hdrOutput{ColorDescription::TransferFunction::PerceptualQuantizer, ColorDescription::Primaries::Rec2020, HdrMetadata()};
+    hdrOutput.hdrMetadata->mastering = ColorDescription::chromaticities(ColorDescription::Primaries::Rec2020);
+    hdrOutput.hdrMetadata->maxMasteringLuminance = 600;
+    serverSurface->setPreferredColorDescription(hdrOutput);
+    serverSurface->setPreferredColorDescription(hdrOutput);
+    QTRY_COMPARE(colorSurface.preferredCount, 2);
+    QCOMPARE(colorSurface.preferredTransferFunction, uint32_t(QtWayland::frog_color_managed_surface::transfer_function_st2084_pq));
+    QCOMPARE(colorSurface.preferredRedX, 35400u);
+    QCOMPARE(colorSurface.preferredMaxLuminance, 600u);
+
+    // destroying the object resets the description on the next commit
+    colorSurface.destroy();
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->colorDescription(), ColorDescription());
+    QCOMPARE(colorDescriptionChangedSpy.count(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestColorManagement)
+
+#include "test_colormanagement.moc"
@@ -0,0 +1,184 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/contenttype_v1_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+#include "../../src/server/tearingcontrol_v1_interface.h"
+
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+
+#include "qwayland-content-type-v1.h"
+#include "qwayland-tearing-control-v1.h"
+
+using namespace KWaylandServer;
+
+class ContentTypeManager : public QtWayland::wp_content_type_manager_v1
+{
+};
+
+class TearingControlManager : public QtWayland::wp_tearing_control_manager_v1
+{
+};
+
+class TestContentType : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestContentType() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testContentTypeAndTearing();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    ContentTypeManager *m_contentTypeManager = nullptr;
+    TearingControlManager *m_tearingControlManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-content-type-test-0");
+
+void TestContentType::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new ContentTypeManagerV1Interface(&m_display);
+    new TearingControlManagerV1Interface(&m_display);
+
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+    QVERIFY(!m_connection->connections().isEmpty());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_content_type_manager_v1")) {
+            m_contentTypeManager = new ContentTypeManager();
+            m_contentTypeManager->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("wp_tearing_control_manager_v1")) {
+            m_tearingControlManager = new TearingControlManager();
+            m_tearingControlManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+    QVERIFY(m_contentTypeManager);
+    QVERIFY(m_tearingControlManager);
+}
+
+TestContentType::~TestContentType()
+{
+    if (m_contentTypeManager) {
+        delete m_contentTypeManager;
+        m_contentTypeManager = nullptr;
+    }
+    if (m_tearingControlManager) {
+        delete m_tearingControlManager;
+        m_tearingControlManager = nullptr;
+    }
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestContentType::testContentTypeAndTearing()
+{
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->contentType(), SurfaceInterface::ContentType::None);
+    QCOMPARE(serverSurface->presentationHint(), SurfaceInterface::PresentationHint::VSync);
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QSignalSpy contentTypeChangedSpy(serverSurface, &SurfaceInterface::contentTypeChanged);
+    QSignalSpy presentationHintChangedSpy(serverSurface, &SurfaceInterface::presentationHintChanged);
+
+    QtWayland::wp_content_type_v1 contentType(m_contentTypeManager->get_surface_content_type(*clientSurface));
+    QtWayland::wp_tearing_control_v1 tearingControl(m_tearingControlManager->get_tearing_control(*clientSurface));
+
+    // both are double-buffered
+    contentType.set_content_type(QtWayland::wp_content_type_v1::type_game);
+    tearingControl.set_presentation_hint(QtWayland::wp_tearing_control_v1::presentation_hint_async);
+    clientSurface->damage(QRect(0, 0, 10, 10));
+    QVERIFY(!committedSpy.wait(100));
+    QCOMPARE(serverSurface->contentType(), SurfaceInterface::ContentType::None);
+    QCOMPARE(serverSurface->presentationHint(), SurfaceInterface::PresentationHint::VSync);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->contentType(), SurfaceInterface::ContentType::Game);
+    QCOMPARE(serverSurface->presentationHint(), SurfaceInterface::PresentationHint::Async);
+    QCOMPARE(contentTypeChangedSpy.count(), 1);
+    QCOMPARE(presentationHintChangedSpy.count(), 1);
+
+    // setting the same values again doesn't emit anything
+    contentType.set_content_type(QtWayland::wp_content_type_v1::type_game);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(contentTypeChangedSpy.count(), 1);
+
+    // destroying the objects resets the state on the next commit
+    contentType.destroy();
+    tearingControl.destroy();
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->contentType(), SurfaceInterface::ContentType::None);
+    QCOMPARE(serverSurface->presentationHint(), SurfaceInterface::PresentationHint::VSync);
+    QCOMPARE(contentTypeChangedSpy.count(), 2);
+    QCOMPARE(presentationHintChangedSpy.count(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestContentType)
+
+#include "test_contenttype.moc"
@@ -9,6 +9,9 @@
 #include <QHash>
 #include <QThread>
 #include <QtTest>
+// std
+#include <memory>
+#include <vector>
 
 // WaylandServer
 #include "../../src/server/compositor_interface.h"
@@ -143,6 +146,7 @@ private Q_SLOTS:
     void testCopyFromControl();
     void testCopyFromControlPrimarySelection();
     void testKlipperCase();
+    void testPrimarySelectionDebounce();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -381,6 +385,37 @@ void DataControlInterfaceTest::testKlipperCase()
     QCOMPARE(m_seat->selection(), testSelection2.data());
 }
 
+void DataControlInterfaceTest::testPrimarySelectionDebounce()
+{
+    // this test verifies that rapid primary selection changes of one client are debounced,
+    // while the seat itself always knows the latest selection
+    using namespace std::chrono_literals;
+    m_seat->setPrimarySelectionDebounceInterval(100ms);
+    QCOMPARE(m_seat->primarySelectionDebounceInterval(), 100ms);
+
+    QScopedPointer<DataControlDevice> dataControlDevice(new DataControlDevice);
+    dataControlDevice->init(m_dataControlDeviceManager->get_data_device(*m_clientSeat));
+    QSignalSpy primarySelectionSpy(dataControlDevice.data(), &DataControlDevice::primary_selection);
+    QSignalSpy serverSelectionChangedSpy(m_seat, &SeatInterface::primarySelectionChanged);
+
+    // a drag-select produces one selection after the other
+    std::vector<std::unique_ptr<DataControlSource>> sources;
+    for (int i = 0; i < 5; ++i) {
+        sources.emplace_back(new DataControlSource);
+        sources.back()->init(m_dataControlDeviceManager->create_data_source());
+        sources.back()->offer(QStringLiteral("text/selection%1").arg(i));
+        dataControlDevice->set_primary_selection(sources.back()->object());
+    }
+    wl_display_flush(m_connection->display());
+    QTRY_COMPARE(serverSelectionChangedSpy.count(), 5);
+    QCOMPARE(m_seat->primarySelection()->mimeTypes(), QStringList{QStringLiteral("text/selection4")});
+
+    // the first change is sent right away, the last one once the changes settle
+    QTRY_COMPARE(primarySelectionSpy.count(), 1);
+    QTRY_COMPARE(primarySelectionSpy.count(), 2);
+    QVERIFY(!primarySelectionSpy.wait(200));
+}
+
 QTEST_GUILESS_MAIN(DataControlInterfaceTest)
 
 #include "test_datacontrol_interface.moc"
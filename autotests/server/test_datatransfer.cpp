@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/datatransfer.h"
+// system
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class TestDataTransfer : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testData();
+    void testProducer();
+    void testFile();
+    void testReceiverClosed();
+    void testCancel();
+};
+
+// reads from the non-blocking @p fd until the writer closes it, without blocking the event loop
+static QByteArray readAll(int fd)
+{
+    QByteArray data;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 5000) {
+        char buffer[4096];
+        const ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        if (bytesRead == 0) {
+            break;
+        }
+        if (bytesRead > 0) {
+            data.append(buffer, bytesRead);
+        } else {
+            QCoreApplication::processEvents();
+        }
+    }
+    close(fd);
+    return data;
+}
+
+void TestDataTransfer::testData()
+{
+    // more than the pipe buffer, so the transfer has to wait for the reader
+    QByteArray data(1024 * 1024, 0);
+    for (int i = 0; i < data.size(); ++i) {
+        data[i] = char(i % 251);
+    }
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    auto transfer = new DataTransfer(data, pipeFds[1]);
+    QCOMPARE(transfer->size(), qint64(data.size()));
+    QSignalSpy progressSpy(transfer, &DataTransfer::progress);
+    QSignalSpy finishedSpy(transfer, &DataTransfer::finished);
+    QSignalSpy destroyedSpy(transfer, &QObject::destroyed);
+
+    QCOMPARE(readAll(pipeFds[0]), data);
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(progressSpy.count() > 1);
+    QCOMPARE(progressSpy.last().first().value<qint64>(), qint64(data.size()));
+    QTRY_COMPARE(destroyedSpy.count(), 1);
+}
+
+void TestDataTransfer::testProducer()
+{
+    int chunks = 0;
+    auto producer = [&chunks]() {
+        if (chunks == 3) {
+            return QByteArray();
+        }
+        return QByteArray::number(chunks++);
+    };
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    auto transfer = new DataTransfer(producer, pipeFds[1]);
+    QCOMPARE(transfer->size(), qint64(-1));
+    QSignalSpy finishedSpy(transfer, &DataTransfer::finished);
+
+    QCOMPARE(readAll(pipeFds[0]), QByteArrayLiteral("012"));
+    QCOMPARE(finishedSpy.count(), 1);
+}
+
+void TestDataTransfer::testFile()
+{
+    const QByteArray data(200 * 1024, 'f');
+    const int file = memfd_create("test-datatransfer", MFD_CLOEXEC);
+    QVERIFY(file != -1);
+    QCOMPARE(write(file, data.constData(), data.size()), ssize_t(data.size()));
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    // only the first half is transferred, the file can be closed right away
+    auto transfer = new DataTransfer(file, data.size() / 2, pipeFds[1]);
+    close(file);
+    QSignalSpy finishedSpy(transfer, &DataTransfer::finished);
+
+    QCOMPARE(readAll(pipeFds[0]), data.left(data.size() / 2));
+    QCOMPARE(finishedSpy.count(), 1);
+}
+
+void TestDataTransfer::testReceiverClosed()
+{
+    // a client which closes its end early cancels the transfer instead of blocking it
+    signal(SIGPIPE, SIG_IGN);
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+    close(pipeFds[0]);
+
+    auto transfer = new DataTransfer(QByteArray(1024, 'c'), pipeFds[1]);
+    QSignalSpy finishedSpy(transfer, &DataTransfer::finished);
+    QSignalSpy cancelledSpy(transfer, &DataTransfer::cancelled);
+    QVERIFY(cancelledSpy.wait());
+    QVERIFY(finishedSpy.isEmpty());
+}
+
+void TestDataTransfer::testCancel()
+{
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+
+    auto transfer = new DataTransfer(QByteArray(1024 * 1024, 'c'), pipeFds[1]);
+    QSignalSpy cancelledSpy(transfer, &DataTransfer::cancelled);
+    QSignalSpy destroyedSpy(transfer, &QObject::destroyed);
+    // let the pipe buffer fill up
+    QTest::qWait(10);
+    QVERIFY(transfer->bytesWritten() > 0);
+    QVERIFY(transfer->bytesWritten() < 1024 * 1024);
+    transfer->cancel();
+    QCOMPARE(cancelledSpy.count(), 1);
+
+    // the reader gets what has been written and then the end of the data
+    const QByteArray data = readAll(pipeFds[0]);
+    QVERIFY(!data.isEmpty());
+    QVERIFY(data.size() < 1024 * 1024);
+    QTRY_COMPARE(destroyedSpy.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestDataTransfer)
+#include "test_datatransfer.moc"
@@ -9,13 +9,20 @@
 #include "../../src/server/clientconnection.h"
 #include "../../src/server/display.h"
 #include "../../src/server/output_interface.h"
+#include "../../src/server/outputdevice_v2_interface.h"
 #include "../../src/server/outputmanagement_v2_interface.h"
 // Wayland
 #include <wayland-server.h>
 // system
+#include <poll.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
+// std
+#include <algorithm>
+#include <numeric>
 
 using namespace KWaylandServer;
 
@@ -26,10 +33,21 @@ private Q_SLOTS:
     void testSocketName();
     void testStartStop();
     void testAddRemoveOutput();
+    void testOutputsIntersecting();
     void testClientConnection();
+    void testClientDispatchBudget();
+    void testExternalEventLoop_data();
+    void testExternalEventLoop();
+    void testFlushDisconnectedClient();
+    void testProtocolThread();
+    void testProtocolStatistics();
+    void testResourceAccounting();
+    void testClientCongestion();
     void testConnectNoSocket();
     void testOutputManagement();
+    void testOutputDeviceState();
     void testAutoSocketName();
+    void testActivatedSockets();
 };
 
 void TestWaylandServerDisplay::testSocketName()
@@ -85,6 +103,36 @@ void TestWaylandServerDisplay::testAddRemoveOutput()
     QVERIFY(display.outputs().isEmpty());
 }
 
+void TestWaylandServerDisplay::testOutputsIntersecting()
+{
+    Display display;
+    OutputInterface left(&display);
+    left.setMode(QSize(1920, 1080));
+    OutputInterface right(&display);
+    right.setMode(QSize(3840, 2160));
+    right.setScale(2);
+    right.setGlobalPosition(QPoint(1920, 0));
+
+    QCOMPARE(display.outputsIntersecting(QRect(100, 100, 10, 10)), QVector<OutputInterface *>{&left});
+    QCOMPARE(display.outputsIntersecting(QRect(1900, 100, 40, 10)), (QVector<OutputInterface *>{&left, &right}));
+    QVERIFY(display.outputsIntersecting(QRect(3840, 0, 10, 10)).isEmpty());
+
+    const quint64 leftMask = display.outputMaskIntersecting(QRect(100, 100, 10, 10));
+    const quint64 rightMask = display.outputMaskIntersecting(QRect(2000, 100, 10, 10));
+    QVERIFY(leftMask);
+    QVERIFY(rightMask);
+    QVERIFY(!(leftMask & rightMask));
+    QCOMPARE(display.outputMaskIntersecting(QRect(1900, 100, 40, 10)), leftMask | rightMask);
+    QCOMPARE(display.outputMaskIntersecting(QRect(3840, 0, 10, 10)), quint64(0));
+
+    // the cached areas follow the scale and the position
+    right.setScale(1);
+    QCOMPARE(display.outputsIntersecting(QRect(3840, 0, 10, 10)), QVector<OutputInterface *>{&right});
+    left.setGlobalPosition(QPoint(0, 2160));
+    QVERIFY(display.outputsIntersecting(QRect(100, 100, 10, 10)).isEmpty());
+    QCOMPARE(display.outputMaskIntersecting(QRect(100, 2200, 10, 10)), leftMask);
+}
+
 void TestWaylandServerDisplay::testClientConnection()
 {
     Display display;
@@ -98,11 +146,11 @@ void TestWaylandServerDisplay::testClientConnection()
     int sv[2];
     QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
 
+    // the connection is set up as soon as the client gets created
     auto client = wl_client_create(display, sv[0]);
     QVERIFY(client);
-
-    QVERIFY(connectedSpy.isEmpty());
-    QVERIFY(display.connections().isEmpty());
+    QCOMPARE(connectedSpy.count(), 1);
+    QCOMPARE(display.connections().count(), 1);
     ClientConnection *connection = display.getConnection(client);
     QVERIFY(connection);
     QCOMPARE(connection->client(), client);
@@ -149,6 +197,9 @@ void TestWaylandServerDisplay::testClientConnection()
     QVERIFY(disconnectedSpy.isEmpty());
     wl_client_destroy(client);
     QCOMPARE(disconnectedSpy.count(), 1);
+    // the remaining connection is still found and no new one gets created
+    QCOMPARE(display.getConnection(client2->client()), client2);
+    QCOMPARE(connectedSpy.count(), 2);
     QSignalSpy clientDestroyedSpy(client2, &QObject::destroyed);
     QVERIFY(clientDestroyedSpy.isValid());
     client2->destroy();
@@ -161,6 +212,328 @@ void TestWaylandServerDisplay::testClientConnection()
     QVERIFY(display.connections().isEmpty());
 }
 
+static void sendSyncRequests(int fd, quint32 firstId, int count)
+{
+    // wl_display.sync, written in the wire format as there is no client library in this test
+    QVector<quint32> messages;
+    for (int i = 0; i < count; ++i) {
+        messages << 1 << ((12 << 16) | 0) << firstId + i;
+    }
+    QCOMPARE(write(fd, messages.constData(), messages.size() * sizeof(quint32)), ssize_t(messages.size() * sizeof(quint32)));
+}
+
+void TestWaylandServerDisplay::testClientDispatchBudget()
+{
+    Display display;
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *connection = display.createClient(sv[0]);
+    QVERIFY(connection);
+    QSignalSpy budgetExceededSpy(connection, &ClientConnection::dispatchBudgetExceeded);
+    QVERIFY(budgetExceededSpy.isValid());
+
+    // without a budget nothing is accounted
+    QCOMPARE(display.clientDispatchBudget(), std::chrono::microseconds::zero());
+    sendSyncRequests(sv[1], 2, 10);
+    display.dispatchEvents();
+    QCOMPARE(connection->dispatchedRequests(), quint64(0));
+    QCOMPARE(connection->dispatchTime(), std::chrono::nanoseconds::zero());
+
+    display.setClientDispatchBudget(std::chrono::microseconds(1));
+    QCOMPARE(display.clientDispatchBudget(), std::chrono::microseconds(1));
+    sendSyncRequests(sv[1], 12, 100);
+    display.dispatchEvents();
+    QCOMPARE(connection->dispatchedRequests(), quint64(100));
+    QVERIFY(connection->dispatchTime() > std::chrono::nanoseconds::zero());
+    QCOMPARE(budgetExceededSpy.count(), 1);
+
+    // a generous budget is not exceeded
+    const std::chrono::nanoseconds dispatchTime = connection->dispatchTime();
+    display.setClientDispatchBudget(std::chrono::seconds(10));
+    sendSyncRequests(sv[1], 112, 1);
+    display.dispatchEvents();
+    QCOMPARE(connection->dispatchedRequests(), quint64(101));
+    QVERIFY(connection->dispatchTime() > dispatchTime);
+    QCOMPARE(budgetExceededSpy.count(), 1);
+
+    display.setClientDispatchBudget(std::chrono::microseconds::zero());
+    wl_client_destroy(connection->client());
+    close(sv[0]);
+    close(sv[1]);
+}
+
+void TestWaylandServerDisplay::testExternalEventLoop_data()
+{
+    QTest::addColumn<bool>("dirtyOnly");
+
+    QTest::newRow("all") << false;
+    QTest::newRow("dirty") << true;
+}
+
+void TestWaylandServerDisplay::testExternalEventLoop()
+{
+    Display display;
+    QVERIFY(display.start(Display::EventLoopIntegration::External));
+    QVERIFY(display.isRunning());
+    QVERIFY(display.eventLoopFileDescriptor() != -1);
+    QFETCH(bool, dirtyOnly);
+    display.setFlushDirtyClientsOnly(dirtyOnly);
+    QCOMPARE(display.flushDirtyClientsOnly(), dirtyOnly);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    int idleSv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, idleSv) >= 0);
+    ClientConnection *connection = display.createClient(sv[0]);
+    QVERIFY(connection);
+    QVERIFY(display.createClient(idleSv[0]));
+
+    sendSyncRequests(sv[1], 2, 1);
+    display.dispatchEvents(1000);
+    QVERIFY(display.dispatchTime() > std::chrono::nanoseconds::zero());
+
+    // the events are only sent with the flush
+    char buffer[64];
+    QCOMPARE(recv(sv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(-1));
+    display.flush();
+    QVERIFY(display.flushTime() > std::chrono::nanoseconds::zero());
+    // wl_callback.done and wl_display.delete_id
+    QCOMPARE(recv(sv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(24));
+    QCOMPARE(recv(idleSv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(-1));
+
+    display.setFlushDirtyClientsOnly(false);
+    wl_client_destroy(connection->client());
+    close(sv[0]);
+    close(sv[1]);
+    close(idleSv[0]);
+    close(idleSv[1]);
+}
+
+void TestWaylandServerDisplay::testFlushDisconnectedClient()
+{
+    Display display;
+    QVERIFY(display.start(Display::EventLoopIntegration::External));
+    display.setFlushDirtyClientsOnly(true);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *connection = display.createClient(sv[0]);
+    QVERIFY(connection);
+    QSignalSpy disconnectedSpy(connection, &ClientConnection::disconnected);
+
+    // the client goes away after its requests have been dispatched, before the events are flushed
+    sendSyncRequests(sv[1], 2, 1);
+    display.dispatchEvents(1000);
+    close(sv[1]);
+    display.flush();
+    QCOMPARE(disconnectedSpy.count(), 1);
+    QVERIFY(display.connections().isEmpty());
+}
+
+void TestWaylandServerDisplay::testProtocolThread()
+{
+    // this test verifies that a display can run in its own thread
+    QThread thread;
+    thread.start();
+    auto display = new Display;
+    display->moveToThread(&thread);
+    bool started = false;
+    QMetaObject::invokeMethod(
+        display,
+        [display, &started]() {
+            started = display->start();
+        },
+        Qt::BlockingQueuedConnection);
+    QVERIFY(started);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *connection = nullptr;
+    QMetaObject::invokeMethod(
+        display,
+        [display, &connection, &sv]() {
+            connection = display->createClient(sv[0]);
+        },
+        Qt::BlockingQueuedConnection);
+    QVERIFY(connection);
+
+    // the main thread doesn't run an event loop, the protocol thread dispatches and flushes
+    sendSyncRequests(sv[1], 2, 1);
+    pollfd pfd = {sv[1], POLLIN, 0};
+    QCOMPARE(poll(&pfd, 1, 5000), 1);
+    char buffer[64];
+    QCOMPARE(recv(sv[1], buffer, sizeof(buffer), MSG_DONTWAIT), ssize_t(24));
+
+    QMetaObject::invokeMethod(
+        display,
+        [display]() {
+            delete display;
+        },
+        Qt::BlockingQueuedConnection);
+    thread.quit();
+    QVERIFY(thread.wait());
+    close(sv[0]);
+    close(sv[1]);
+}
+
+static quint64 messageCount(const QVector<ProtocolStatistics::Message> &messages, const QByteArray &interface, const QByteArray &name)
+{
+    for (const ProtocolStatistics::Message &message : messages) {
+        if (message.interface == interface && message.name == name) {
+            return message.count;
+        }
+    }
+    return 0;
+}
+
+void TestWaylandServerDisplay::testProtocolStatistics()
+{
+    Display display;
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *connection = display.createClient(sv[0]);
+    QVERIFY(connection);
+
+    QVERIFY(!display.protocolStatisticsEnabled());
+    display.setProtocolStatisticsEnabled(true);
+    QVERIFY(display.protocolStatisticsEnabled());
+
+    sendSyncRequests(sv[1], 2, 3);
+    display.dispatchEvents();
+
+    ProtocolStatistics statistics = display.protocolStatistics();
+    QCOMPARE(messageCount(statistics.requests, "wl_display", "sync"), quint64(3));
+    QCOMPARE(messageCount(statistics.events, "wl_callback", "done"), quint64(3));
+    QCOMPARE(messageCount(statistics.events, "wl_display", "delete_id"), quint64(3));
+    QCOMPARE(messageCount(statistics.events, "wl_display", "sync"), quint64(0));
+    // every event consists of the header and a single uint
+    QCOMPARE(connection->bytesSent(), quint64(6 * 12));
+    QCOMPARE(std::accumulate(statistics.dispatchTimeHistogram.cbegin(), statistics.dispatchTimeHistogram.cend(), quint64(0)), quint64(1));
+    // the handler of wl_display.sync allocates the wl_callback
+    auto sync = std::find_if(statistics.requests.cbegin(), statistics.requests.cend(), [](const ProtocolStatistics::Message &message) {
+        return message.interface == "wl_display" && message.name == "sync";
+    });
+    QVERIFY(sync != statistics.requests.cend());
+    QCOMPARE(sync->allocations >= 3, statistics.allocationsTracked);
+    QCOMPARE(sync->allocatedBytes > 0, statistics.allocationsTracked);
+
+    display.resetProtocolStatistics();
+    statistics = display.protocolStatistics();
+    QVERIFY(statistics.requests.isEmpty());
+    QVERIFY(statistics.events.isEmpty());
+    QVERIFY(statistics.dispatchTimeHistogram.isEmpty());
+    QCOMPARE(connection->bytesSent(), quint64(0));
+
+    display.setProtocolStatisticsEnabled(false);
+    wl_client_destroy(connection->client());
+    close(sv[0]);
+    close(sv[1]);
+}
+
+static void sendGetRegistryRequests(int fd, quint32 firstId, int count)
+{
+    // wl_display.get_registry, the registries stay alive until the client disconnects
+    QVector<quint32> messages;
+    for (int i = 0; i < count; ++i) {
+        messages << 1 << ((12 << 16) | 1) << firstId + i;
+    }
+    QCOMPARE(write(fd, messages.constData(), messages.size() * sizeof(quint32)), ssize_t(messages.size() * sizeof(quint32)));
+}
+
+void TestWaylandServerDisplay::testResourceAccounting()
+{
+    Display display;
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *connection = display.createClient(sv[0]);
+    QVERIFY(connection);
+    QSignalSpy limitExceededSpy(connection, &ClientConnection::resourceLimitExceeded);
+    QSignalSpy disconnectedSpy(connection, &ClientConnection::disconnected);
+
+    // without the accounting nothing is counted
+    QVERIFY(!display.resourceAccountingEnabled());
+    QCOMPARE(connection->resourceCount(), 0u);
+
+    // the resources which exist already are counted as well
+    display.setResourceAccountingEnabled(true);
+    QVERIFY(display.resourceAccountingEnabled());
+    QCOMPARE(connection->resourceCount(), 1u);
+    QCOMPARE(connection->resourceCounts().value("wl_display"), 1u);
+
+    ClientResourceLimits limits;
+    limits.softResourceCount = 3;
+    limits.hardResourceCount = 5;
+    display.setClientResourceLimits(limits);
+    QCOMPARE(display.clientResourceLimits().hardResourceCount, 5u);
+
+    sendGetRegistryRequests(sv[1], 2, 2);
+    display.dispatchEvents();
+    QCOMPARE(connection->resourceCount(), 3u);
+    QCOMPARE(connection->resourceCounts().value("wl_registry"), 2u);
+    QCOMPARE(connection->shmPoolBytes(), quint64(0));
+    QCOMPARE(connection->dmaBufCount(), 0u);
+    QVERIFY(limitExceededSpy.isEmpty());
+
+    sendGetRegistryRequests(sv[1], 4, 1);
+    display.dispatchEvents();
+    QCOMPARE(connection->resourceCount(), 4u);
+    QCOMPARE(limitExceededSpy.count(), 1);
+
+    // a client above the hard limit gets disconnected
+    sendGetRegistryRequests(sv[1], 5, 2);
+    display.dispatchEvents();
+    QCOMPARE(disconnectedSpy.count(), 1);
+    QCOMPARE(limitExceededSpy.count(), 1);
+
+    display.setResourceAccountingEnabled(false);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+void TestWaylandServerDisplay::testClientCongestion()
+{
+    Display display;
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *connection = display.createClient(sv[0]);
+    QVERIFY(connection);
+    QSignalSpy congestedSpy(connection, &ClientConnection::congested);
+    QSignalSpy relievedSpy(connection, &ClientConnection::congestionRelieved);
+
+    QCOMPARE(display.clientCongestionThreshold(), 0u);
+    display.setClientCongestionThreshold(4096);
+    QCOMPARE(display.clientCongestionThreshold(), 4096u);
+
+    // the client does not read the events queued on its socket
+    wl_resource *displayResource = connection->getResource(1);
+    QVERIFY(displayResource);
+    const int eventCount = 1000;
+    for (int i = 0; i < eventCount; ++i) {
+        wl_resource_post_event(displayResource, WL_DISPLAY_DELETE_ID, 1);
+    }
+    display.flush();
+    QVERIFY(connection->isCongested());
+    QVERIFY(connection->queuedBytes() > 4096);
+    QCOMPARE(congestedSpy.count(), 1);
+
+    // every delete_id event is 12 bytes on the wire
+    QByteArray buffer(eventCount * 12, Qt::Uninitialized);
+    int received = 0;
+    while (received < buffer.size()) {
+        const ssize_t size = recv(sv[1], buffer.data() + received, buffer.size() - received, 0);
+        QVERIFY(size > 0);
+        received += size;
+    }
+    display.flush();
+    QVERIFY(!connection->isCongested());
+    QCOMPARE(connection->queuedBytes(), 0u);
+    QCOMPARE(relievedSpy.count(), 1);
+    QCOMPARE(congestedSpy.count(), 1);
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
 void TestWaylandServerDisplay::testConnectNoSocket()
 {
     Display display;
@@ -186,6 +559,63 @@ void TestWaylandServerDisplay::testOutputManagement()
     new OutputManagementV2Interface(&display, this);
 }
 
+void TestWaylandServerDisplay::testOutputDeviceState()
+{
+    Display display;
+    OutputDeviceV2Interface device(&display);
+    device.setName(QStringLiteral("DP-1"));
+    device.setManufacturer(QStringLiteral("Acme"));
+    device.setModel(QStringLiteral("Monitor 27"));
+    device.setSerialNumber(QStringLiteral("1234"));
+    device.setEisaId(QStringLiteral("ACM"));
+    device.setUuid(QUuid::createUuid());
+    device.setEdid(QByteArrayLiteral("edid"));
+    device.setPhysicalSize(QSize(600, 340));
+    device.setGlobalPosition(QPoint(1920, 0));
+    device.setScale(1.5);
+    device.setTransform(OutputDeviceV2Interface::Transform::Rotated90);
+    device.setSubPixel(OutputDeviceV2Interface::SubPixel::HorizontalRGB);
+    device.setCapabilities(OutputDeviceV2Interface::Capability::Overscan | OutputDeviceV2Interface::Capability::Vrr);
+    device.setOverscan(5);
+    device.setVrrPolicy(OutputDeviceV2Interface::VrrPolicy::Always);
+    device.setRgbRange(OutputDeviceV2Interface::RgbRange::Full);
+    device.setEnabled(false);
+    device.setModes({
+        new OutputDeviceModeV2Interface(QSize(2560, 1440), 60000, OutputDeviceModeV2Interface::ModeFlag::Preferred),
+        new OutputDeviceModeV2Interface(QSize(1920, 1080), 144000, OutputDeviceModeV2Interface::ModeFlag::Current),
+    });
+    const QByteArray state = device.saveState();
+
+    OutputDeviceV2Interface restored(&display);
+    QVERIFY(!restored.restoreState(QByteArrayLiteral("no state")));
+    QVERIFY(!restored.restoreState(state.left(state.size() - 1)));
+    QCOMPARE(restored.name(), QString());
+    QVERIFY(restored.restoreState(state));
+    QCOMPARE(restored.name(), device.name());
+    QCOMPARE(restored.manufacturer(), device.manufacturer());
+    QCOMPARE(restored.model(), device.model());
+    QCOMPARE(restored.serialNumber(), device.serialNumber());
+    QCOMPARE(restored.eisaId(), device.eisaId());
+    QCOMPARE(restored.uuid(), device.uuid());
+    QCOMPARE(restored.edid(), device.edid());
+    QCOMPARE(restored.physicalSize(), device.physicalSize());
+    QCOMPARE(restored.globalPosition(), device.globalPosition());
+    QCOMPARE(restored.scale(), device.scale());
+    QCOMPARE(restored.transform(), device.transform());
+    QCOMPARE(restored.subPixel(), device.subPixel());
+    QCOMPARE(restored.capabilities(), device.capabilities());
+    QCOMPARE(restored.overscan(), device.overscan());
+    QCOMPARE(restored.vrrPolicy(), device.vrrPolicy());
+    QCOMPARE(restored.rgbRange(), device.rgbRange());
+    QCOMPARE(restored.enabled(), device.enabled());
+    QCOMPARE(restored.modes().count(), 2);
+    QCOMPARE(restored.modes().at(0)->size(), QSize(2560, 1440));
+    QCOMPARE(restored.modes().at(0)->flags(), OutputDeviceModeV2Interface::ModeFlags(OutputDeviceModeV2Interface::ModeFlag::Preferred));
+    QCOMPARE(restored.pixelSize(), QSize(1920, 1080));
+    QCOMPARE(restored.refreshRate(), 144000);
+    QCOMPARE(restored.saveState(), state);
+}
+
 void TestWaylandServerDisplay::testAutoSocketName()
 {
     QTemporaryDir runtimeDir;
@@ -209,5 +639,61 @@ void TestWaylandServerDisplay::testAutoSocketName()
     QCOMPARE(socketNameChangedSpy1.count(), 1);
 }
 
+void TestWaylandServerDisplay::testActivatedSockets()
+{
+    // the service manager passes the sockets starting at file descriptor 3
+    const int firstFileDescriptor = 3;
+    QTemporaryDir socketDir;
+    QVERIFY(socketDir.isValid());
+    const QByteArray socketPath = QFile::encodeName(socketDir.filePath(QStringLiteral("wayland-activated")));
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    qstrncpy(address.sun_path, socketPath.constData(), sizeof(address.sun_path));
+    const int listening = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    QVERIFY(listening != -1);
+    QCOMPARE(bind(listening, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+    QCOMPARE(listen(listening, 16), 0);
+
+    // a client connecting before the compositor took over the socket waits in the backlog
+    const int early = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    QCOMPARE(::connect(early, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    const int saved = fcntl(firstFileDescriptor, F_GETFD) != -1 ? fcntl(firstFileDescriptor, F_DUPFD_CLOEXEC, 10) : -1;
+    QCOMPARE(dup2(listening, firstFileDescriptor), firstFileDescriptor);
+    close(listening);
+
+    {
+        Display display;
+        QSignalSpy connectedSpy(&display, &Display::clientConnected);
+
+        // the sockets are meant for another process
+        qputenv("LISTEN_PID", QByteArray::number(getpid() + 1));
+        qputenv("LISTEN_FDS", "1");
+        qputenv("LISTEN_FDNAMES", "wayland-activated");
+        QCOMPARE(display.addActivatedSockets(), 0);
+
+        qputenv("LISTEN_PID", QByteArray::number(getpid()));
+        QCOMPARE(display.addActivatedSockets(), 1);
+        QCOMPARE(display.socketNames(), QStringList{QStringLiteral("wayland-activated")});
+        QVERIFY(!qEnvironmentVariableIsSet("LISTEN_PID"));
+        QVERIFY(!qEnvironmentVariableIsSet("LISTEN_FDS"));
+        QVERIFY(!qEnvironmentVariableIsSet("LISTEN_FDNAMES"));
+        display.start();
+        QVERIFY(display.isRunning());
+
+        // the waiting client is accepted, and gets its connection before sending any request
+        QVERIFY(connectedSpy.wait());
+        QCOMPARE(display.connections().count(), 1);
+        QVERIFY(display.connections().first()->processId() != 0);
+    }
+    // the display closed the socket it took over
+    QCOMPARE(fcntl(firstFileDescriptor, F_GETFD), -1);
+    if (saved != -1) {
+        dup2(saved, firstFileDescriptor);
+        close(saved);
+    }
+    close(early);
+}
+
 QTEST_GUILESS_MAIN(TestWaylandServerDisplay)
 #include "test_display.moc"
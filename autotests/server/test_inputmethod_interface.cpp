@@ -12,6 +12,7 @@
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/inputmethod_v1_interface.h"
+#include "../../src/server/keyboard_interface.h"
 #include "../../src/server/seat_interface.h"
 
 #include "../../src/client/compositor.h"
@@ -160,6 +161,7 @@ private Q_SLOTS:
     void testContentPurpose_data();
     void testContentPurpose();
     void testKeyboardGrab();
+    void testKeyboardGrabForwarding();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -635,5 +637,62 @@ void TestInputMethodInterface::testKeyboardGrab()
     m_inputMethodIface->sendDeactivate();
 }
 
+void TestInputMethodInterface::testKeyboardGrabForwarding()
+{
+    QVERIFY(m_inputMethodIface);
+    m_seat->setHasKeyboard(true);
+    m_seat->keyboard()->setKeymap(QByteArrayLiteral("foo"));
+    QSignalSpy inputMethodActivateSpy(m_inputMethod, &InputMethodV1::activated);
+
+    m_inputMethodIface->sendActivate();
+    QVERIFY(inputMethodActivateSpy.wait());
+
+    InputMethodContextV1Interface *serverContext = m_inputMethodIface->context();
+    serverContext->setKeyboardGrabForwarding(m_seat);
+    QCOMPARE(serverContext->keyboardGrabForwarding(), m_seat);
+
+    // grabbing the keyboard passes on the keymap of the seat
+    QSignalSpy keyboardGrabSpy(serverContext, &InputMethodContextV1Interface::keyboardGrabRequested);
+    InputMethodV1Context *imContext = m_inputMethod->context();
+    QVERIFY(imContext);
+    KWayland::Client::Keyboard *keyboard = new KWayland::Client::Keyboard(this);
+    QSignalSpy keymapSpy(keyboard, &KWayland::Client::Keyboard::keymapChanged);
+    keyboard->setup(imContext->grab_keyboard());
+    QVERIFY(keyboard->isValid());
+    QVERIFY(keyboardGrabSpy.count() || keyboardGrabSpy.wait());
+    QVERIFY(keymapSpy.count() || keymapSpy.wait());
+    // the grab is a version 1 keyboard and gets a writable copy rather than the sealed seat keymap
+    QFile keymapFile;
+    QVERIFY(keymapFile.open(keymapSpy.last().first().toInt(), QIODevice::ReadWrite));
+    const quint32 keymapSize = keymapSpy.last().last().value<quint32>();
+    const char *keymap = reinterpret_cast<char *>(keymapFile.map(0, keymapSize));
+    QVERIFY(keymap);
+    QCOMPARE(QByteArray(keymap, 3), QByteArrayLiteral("foo"));
+    keymapFile.close();
+
+    // the keys of the seat go to the input method without the compositor relaying them
+    QSignalSpy keyboardSpy(keyboard, &KWayland::Client::Keyboard::keyChanged);
+    m_seat->notifyKeyboardKey(KEY_F1, KeyboardKeyState::Pressed);
+    m_seat->notifyKeyboardKey(KEY_F1, KeyboardKeyState::Released);
+    QVERIFY(keyboardSpy.wait());
+    if (keyboardSpy.count() < 2) {
+        QVERIFY(keyboardSpy.wait());
+    }
+    QCOMPARE(keyboardSpy.count(), 2);
+
+    // and the keys passed back don't need to be relayed either
+    QSignalSpy keySpy(serverContext, &InputMethodContextV1Interface::key);
+    QSignalSpy commitStringSpy(serverContext, &InputMethodContextV1Interface::commitString);
+    imContext->key(1, 0, KEY_F1, WL_KEYBOARD_KEY_STATE_PRESSED);
+    imContext->key(1, 0, KEY_F1, WL_KEYBOARD_KEY_STATE_RELEASED);
+    imContext->commit_string(1, "hello");
+    QVERIFY(commitStringSpy.wait());
+    QCOMPARE(keySpy.count(), 0);
+
+    delete keyboard;
+    m_inputMethodIface->sendDeactivate();
+    m_seat->setHasKeyboard(false);
+}
+
 QTEST_GUILESS_MAIN(TestInputMethodInterface)
 #include "test_inputmethod_interface.moc"
@@ -70,6 +70,7 @@ public:
 
 private Q_SLOTS:
     void initTestCase();
+    void testFocusedInhibitor();
     void testKeyboardShortcuts();
 
 private:
@@ -98,6 +99,7 @@ void TestKeyboardShortcutsInhibitorInterface::initTestCase()
     QVERIFY(m_display.isRunning());
 
     m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasKeyboard(true);
     m_serverCompositor = new CompositorInterface(&m_display, this);
     m_manager = new KeyboardShortcutsInhibitManagerV1Interface(&m_display, this);
 
@@ -169,6 +171,36 @@ TestKeyboardShortcutsInhibitorInterface::~TestKeyboardShortcutsInhibitorInterfac
     m_connection = nullptr;
 }
 
+void TestKeyboardShortcutsInhibitorInterface::testFocusedInhibitor()
+{
+    // the seat keeps the inhibitor of the focused surface at hand
+    m_seat->setFocusedKeyboardSurface(m_surfaces[2]);
+    QVERIFY(!m_seat->focusedKeyboardShortcutsInhibitor());
+
+    // creating the inhibitor for the focused surface
+    QSignalSpy inhibitorCreatedSpy(m_manager, &KeyboardShortcutsInhibitManagerV1Interface::inhibitorCreated);
+    auto inhibitorClient = new KeyboardShortcutsInhibitor(m_inhibitManagerClient->inhibit_shortcuts(m_clientSurfaces[2], m_clientSeat->operator wl_seat *()));
+    QVERIFY(inhibitorCreatedSpy.wait());
+    auto inhibitorServer = m_manager->findInhibitor(m_surfaces[2], m_seat);
+    QVERIFY(inhibitorServer);
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), inhibitorServer);
+
+    // it follows the keyboard focus
+    m_seat->setFocusedKeyboardSurface(m_surfaces[0]);
+    QVERIFY(!m_seat->focusedKeyboardShortcutsInhibitor());
+    m_seat->setFocusedKeyboardSurface(m_surfaces[2]);
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), inhibitorServer);
+
+    // and goes away with the inhibitor
+    QSignalSpy inhibitorDestroyedSpy(inhibitorServer, &QObject::destroyed);
+    inhibitorClient->destroy();
+    QVERIFY(inhibitorDestroyedSpy.wait());
+    QVERIFY(!m_seat->focusedKeyboardShortcutsInhibitor());
+    QVERIFY(!m_manager->findInhibitor(m_surfaces[2], m_seat));
+    delete inhibitorClient;
+    m_seat->setFocusedKeyboardSurface(nullptr);
+}
+
 void TestKeyboardShortcutsInhibitorInterface::testKeyboardShortcuts()
 {
     auto clientSurface = m_clientSurfaces[0];
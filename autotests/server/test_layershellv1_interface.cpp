@@ -9,7 +9,10 @@
 
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
+#include "../../src/server/layershell_v1_arrangement.h"
 #include "../../src/server/layershell_v1_interface.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/strut_interface.h"
 #include "../../src/server/surface_interface.h"
 #include "../../src/server/xdgshell_interface.h"
 
@@ -101,6 +104,7 @@ private Q_SLOTS:
     void testLayer_data();
     void testLayer();
     void testPopup();
+    void testArrangement();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -521,6 +525,55 @@ void TestLayerShellV1Interface::testPopup()
     QCOMPARE(serverPopupShellSurface->parentSurface(), serverPanelSurface);
 }
 
+void TestLayerShellV1Interface::testArrangement()
+{
+    OutputInterface output(&m_display);
+    output.setMode(QSize(1000, 800));
+    LayerShellV1Arrangement arrangement(&output);
+    arrangement.arrange();
+    QCOMPARE(arrangement.workArea(), QRect(0, 0, 1000, 800));
+
+    // Create a test wl_surface object.
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreatedSpy.isValid());
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+
+    // Create a panel at the top edge of the output.
+    QScopedPointer<LayerSurfaceV1> clientShellSurface(new LayerSurfaceV1);
+    clientShellSurface->init(m_clientLayerShell->get_layer_surface(*clientSurface, nullptr, LayerShellV1::layer_top, QStringLiteral("panel")));
+    QSignalSpy layerSurfaceCreatedSpy(m_serverLayerShell, &LayerShellV1Interface::surfaceCreated);
+    QVERIFY(layerSurfaceCreatedSpy.isValid());
+    QVERIFY(layerSurfaceCreatedSpy.wait());
+    auto serverShellSurface = layerSurfaceCreatedSpy.last().first().value<LayerSurfaceV1Interface *>();
+    QVERIFY(serverShellSurface);
+    arrangement.addSurface(serverShellSurface);
+
+    QSignalSpy workAreaChangedSpy(&arrangement, &LayerShellV1Arrangement::workAreaChanged);
+    QVERIFY(workAreaChangedSpy.isValid());
+    clientShellSurface->set_anchor(LayerSurfaceV1::anchor_top | LayerSurfaceV1::anchor_left | LayerSurfaceV1::anchor_right);
+    clientShellSurface->set_size(0, 30);
+    clientShellSurface->set_exclusive_zone(30);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(workAreaChangedSpy.wait());
+    QCOMPARE(arrangement.geometry(serverShellSurface), QRect(0, 0, 1000, 30));
+    QCOMPARE(arrangement.workArea(), QRect(0, 30, 1000, 770));
+
+    // A strut at the left edge shrinks the work area as well.
+    SurfaceInterface *dockSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    deepinKwinStrut strut;
+    strut.left = 50;
+    arrangement.setStrut(dockSurface, strut);
+    QVERIFY(workAreaChangedSpy.wait());
+    QCOMPARE(arrangement.workArea(), QRect(50, 30, 950, 770));
+
+    // Unrelated changes do not trigger another pass.
+    QSignalSpy arrangedSpy(&arrangement, &LayerShellV1Arrangement::arranged);
+    QVERIFY(arrangedSpy.isValid());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(!arrangedSpy.wait(100));
+}
+
 QTEST_GUILESS_MAIN(TestLayerShellV1Interface)
 
 #include "test_layershellv1_interface.moc"
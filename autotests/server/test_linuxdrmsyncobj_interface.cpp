@@ -0,0 +1,460 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/linuxdmabufv1clientbuffer.h"
+#include "../../src/server/linuxdrmsyncobj_v1_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+
+#include "qwayland-linux-dmabuf-unstable-v1.h"
+#include "qwayland-linux-drm-syncobj-v1.h"
+
+#include <wayland-client-protocol.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+// the DRM fourcc code of ARGB8888 and DRM_FORMAT_MOD_INVALID, see drm_fourcc.h
+static const uint32_t s_argb8888 = 0x34325241;
+static const uint64_t s_invalidModifier = 0x00ffffffffffffffULL;
+
+class FakeTimeline : public LinuxDrmSyncObjTimelineV1
+{
+public:
+    ~FakeTimeline() override
+    {
+        for (int fd : qAsConst(waiters)) {
+            close(fd);
+        }
+    }
+
+    int createEventFd(quint64 point) override
+    {
+        const int fd = eventfd(0, EFD_CLOEXEC);
+        if (fd == -1) {
+            return -1;
+        }
+        waiters.insert(point, fd);
+        return dup(fd);
+    }
+
+    void signal(quint64 point) override
+    {
+        signalledPoints.append(point);
+    }
+
+    // signals all waited for points up to @p point, as the client's GPU would
+    void reach(quint64 point)
+    {
+        for (auto it = waiters.begin(); it != waiters.end() && it.key() <= point;) {
+            const quint64 value = 1;
+            QCOMPARE(write(it.value(), &value, sizeof(value)), ssize_t(sizeof(value)));
+            close(it.value());
+            it = waiters.erase(it);
+        }
+    }
+
+    QMultiMap<quint64, int> waiters;
+    QVector<quint64> signalledPoints;
+};
+
+class FakeRenderer : public LinuxDrmSyncObjV1Interface::RendererInterface, public LinuxDmaBufV1ClientBufferIntegration::RendererInterface
+{
+public:
+    LinuxDrmSyncObjTimelineV1 *importTimeline(int fd) override
+    {
+        close(fd);
+        if (failImport) {
+            return nullptr;
+        }
+        auto timeline = new FakeTimeline;
+        timelines.append(timeline);
+        return timeline;
+    }
+
+    LinuxDmaBufV1ClientBuffer *importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) override
+    {
+        return new LinuxDmaBufV1ClientBuffer(size, format, flags, planes);
+    }
+
+    bool failImport = false;
+    // owned by the LinuxDrmSyncObjV1Interface
+    QVector<FakeTimeline *> timelines;
+};
+
+static void frameDone(void *data, wl_callback *callback, uint32_t time)
+{
+    Q_UNUSED(time)
+    ++*static_cast<int *>(data);
+    wl_callback_destroy(callback);
+}
+
+static const wl_callback_listener s_frameListener = {frameDone};
+
+class SyncObjManager : public QtWayland::wp_linux_drm_syncobj_manager_v1
+{
+};
+
+class SyncObjSurface : public QtWayland::wp_linux_drm_syncobj_surface_v1
+{
+public:
+    SyncObjSurface(::wp_linux_drm_syncobj_surface_v1 *surface)
+        : wp_linux_drm_syncobj_surface_v1(surface)
+    {
+    }
+};
+
+class DmaBuf : public QtWayland::zwp_linux_dmabuf_v1
+{
+};
+
+class TestLinuxDrmSyncObjInterface : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testImportTimeline();
+    void testImportTimelineFailure();
+    void testSurfaceExists();
+    void testPointErrors_data();
+    void testPointErrors();
+    void testDeferredCommit();
+    void testCommitQueue();
+
+private:
+    wl_buffer *createBuffer();
+    SurfaceInterface *createSurface(QScopedPointer<KWayland::Client::Surface> &surface);
+    ::wp_linux_drm_syncobj_timeline_v1 *importTimeline();
+    quint32 protocolError() const;
+
+    Display *m_display = nullptr;
+    CompositorInterface *m_compositorInterface = nullptr;
+    LinuxDrmSyncObjV1Interface *m_syncObjInterface = nullptr;
+    FakeRenderer m_renderer;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    SyncObjManager *m_syncObjManager = nullptr;
+    DmaBuf *m_dmabuf = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-test-linux-drm-syncobj-0");
+
+void TestLinuxDrmSyncObjInterface::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_compositorInterface = new CompositorInterface(m_display, m_display);
+    m_renderer.failImport = false;
+    m_renderer.timelines.clear();
+    m_syncObjInterface = new LinuxDrmSyncObjV1Interface(m_display, m_display);
+    m_syncObjInterface->setRendererInterface(&m_renderer);
+    auto dmabufInterface = new LinuxDmaBufV1ClientBufferIntegration(m_display);
+    dmabufInterface->setRendererInterface(&m_renderer);
+    LinuxDmaBufV1Feedback::Tranche tranche;
+    tranche.formatTable = {{s_argb8888, {s_invalidModifier}}};
+    dmabufInterface->setSupportedFormatsWithModifiers({tranche});
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new KWayland::Client::Registry(this);
+    connect(m_registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_linux_drm_syncobj_manager_v1")) {
+            m_syncObjManager = new SyncObjManager();
+            m_syncObjManager->init(*m_registry, id, version);
+        } else if (interface == QByteArrayLiteral("zwp_linux_dmabuf_v1")) {
+            m_dmabuf = new DmaBuf();
+            m_dmabuf->init(*m_registry, id, qMin(version, 3u));
+        }
+    });
+    QSignalSpy allAnnouncedSpy(m_registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(m_registry, &KWayland::Client::Registry::compositorAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_syncObjManager);
+    QVERIFY(m_dmabuf);
+
+    m_compositor = m_registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_compositor->isValid());
+}
+
+void TestLinuxDrmSyncObjInterface::cleanup()
+{
+    delete m_syncObjManager;
+    m_syncObjManager = nullptr;
+    delete m_dmabuf;
+    m_dmabuf = nullptr;
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_connection;
+    m_connection = nullptr;
+
+    delete m_display;
+    m_display = nullptr;
+    m_compositorInterface = nullptr;
+    m_syncObjInterface = nullptr;
+}
+
+wl_buffer *TestLinuxDrmSyncObjInterface::createBuffer()
+{
+    // any file will do, the fake renderer never touches the content
+    const int fd = memfd_create("dmabuf", MFD_CLOEXEC);
+    if (fd == -1 || ftruncate(fd, 4 * 4 * 4) != 0) {
+        return nullptr;
+    }
+    QtWayland::zwp_linux_buffer_params_v1 params(m_dmabuf->create_params());
+    params.add(fd, 0, 0, 4 * 4, s_invalidModifier >> 32, s_invalidModifier & 0xffffffff);
+    close(fd);
+    wl_buffer *buffer = params.create_immed(4, 4, s_argb8888, 0);
+    params.destroy();
+    return buffer;
+}
+
+SurfaceInterface *TestLinuxDrmSyncObjInterface::createSurface(QScopedPointer<KWayland::Client::Surface> &surface)
+{
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    surface.reset(m_compositor->createSurface());
+    if (!surfaceCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+::wp_linux_drm_syncobj_timeline_v1 *TestLinuxDrmSyncObjInterface::importTimeline()
+{
+    const int fd = eventfd(0, EFD_CLOEXEC);
+    ::wp_linux_drm_syncobj_timeline_v1 *timeline = m_syncObjManager->import_timeline(fd);
+    close(fd);
+    return timeline;
+}
+
+quint32 TestLinuxDrmSyncObjInterface::protocolError() const
+{
+    const wl_interface *interface = nullptr;
+    quint32 id = 0;
+    return wl_display_get_protocol_error(m_connection->display(), &interface, &id);
+}
+
+void TestLinuxDrmSyncObjInterface::testImportTimeline()
+{
+    ::wp_linux_drm_syncobj_timeline_v1 *timeline = importTimeline();
+    QVERIFY(timeline);
+    m_connection->flush();
+    QTRY_COMPARE(m_renderer.timelines.count(), 1);
+    wp_linux_drm_syncobj_timeline_v1_destroy(timeline);
+}
+
+void TestLinuxDrmSyncObjInterface::testImportTimelineFailure()
+{
+    // a timeline the compositor can't import is a protocol error
+    m_renderer.failImport = true;
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QVERIFY(importTimeline());
+    m_connection->flush();
+    QVERIFY(errorSpy.wait());
+    QCOMPARE(protocolError(), quint32(WP_LINUX_DRM_SYNCOBJ_MANAGER_V1_ERROR_INVALID_TIMELINE));
+    QVERIFY(m_renderer.timelines.isEmpty());
+}
+
+void TestLinuxDrmSyncObjInterface::testSurfaceExists()
+{
+    QScopedPointer<KWayland::Client::Surface> surface;
+    QVERIFY(createSurface(surface));
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    SyncObjSurface first(m_syncObjManager->get_surface(*surface));
+    SyncObjSurface second(m_syncObjManager->get_surface(*surface));
+    m_connection->flush();
+    QVERIFY(errorSpy.wait());
+    QCOMPARE(protocolError(), quint32(WP_LINUX_DRM_SYNCOBJ_MANAGER_V1_ERROR_SURFACE_EXISTS));
+}
+
+void TestLinuxDrmSyncObjInterface::testPointErrors_data()
+{
+    QTest::addColumn<bool>("attach");
+    QTest::addColumn<quint64>("acquirePoint");
+    QTest::addColumn<quint64>("releasePoint");
+    QTest::addColumn<quint32>("error");
+
+    // a point of 0 is left unset
+    QTest::newRow("no buffer") << false << quint64(1) << quint64(2) << quint32(WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_BUFFER);
+    QTest::newRow("no acquire point") << true << quint64(0) << quint64(2) << quint32(WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_ACQUIRE_POINT);
+    QTest::newRow("no release point") << true << quint64(1) << quint64(0) << quint32(WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_RELEASE_POINT);
+    QTest::newRow("conflicting points") << true << quint64(2) << quint64(2) << quint32(WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_CONFLICTING_POINTS);
+}
+
+void TestLinuxDrmSyncObjInterface::testPointErrors()
+{
+    QFETCH(bool, attach);
+    QFETCH(quint64, acquirePoint);
+    QFETCH(quint64, releasePoint);
+
+    QScopedPointer<KWayland::Client::Surface> surface;
+    SurfaceInterface *serverSurface = createSurface(surface);
+    QVERIFY(serverSurface);
+    SyncObjSurface syncObjSurface(m_syncObjManager->get_surface(*surface));
+    ::wp_linux_drm_syncobj_timeline_v1 *timeline = importTimeline();
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    if (attach) {
+        wl_buffer *buffer = createBuffer();
+        QVERIFY(buffer);
+        surface->attachBuffer(buffer);
+    }
+    if (acquirePoint) {
+        syncObjSurface.set_acquire_point(timeline, acquirePoint >> 32, acquirePoint & 0xffffffff);
+    }
+    if (releasePoint) {
+        syncObjSurface.set_release_point(timeline, releasePoint >> 32, releasePoint & 0xffffffff);
+    }
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(errorSpy.wait());
+    QTEST(protocolError(), "error");
+    QVERIFY(committedSpy.isEmpty());
+}
+
+void TestLinuxDrmSyncObjInterface::testDeferredCommit()
+{
+    QScopedPointer<KWayland::Client::Surface> surface;
+    SurfaceInterface *serverSurface = createSurface(surface);
+    QVERIFY(serverSurface);
+    SyncObjSurface syncObjSurface(m_syncObjManager->get_surface(*surface));
+    ::wp_linux_drm_syncobj_timeline_v1 *timeline = importTimeline();
+    QTRY_COMPARE(m_renderer.timelines.count(), 1);
+    FakeTimeline *serverTimeline = m_renderer.timelines.first();
+
+    // the commit is held back until the client finished rendering into the buffer
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    wl_buffer *buffer = createBuffer();
+    QVERIFY(buffer);
+    surface->attachBuffer(buffer);
+    surface->damage(QRect(0, 0, 4, 4));
+    syncObjSurface.set_acquire_point(timeline, 0, 1);
+    syncObjSurface.set_release_point(timeline, 0, 2);
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QTRY_COMPARE(serverTimeline->waiters.count(), 1);
+    QVERIFY(committedSpy.isEmpty());
+    QVERIFY(!serverSurface->buffer());
+
+    serverTimeline->reach(1);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface->buffer());
+    QCOMPARE(serverSurface->damage(), QRegion(0, 0, 4, 4));
+}
+
+void TestLinuxDrmSyncObjInterface::testCommitQueue()
+{
+    QScopedPointer<KWayland::Client::Surface> surface;
+    SurfaceInterface *serverSurface = createSurface(surface);
+    QVERIFY(serverSurface);
+    SyncObjSurface syncObjSurface(m_syncObjManager->get_surface(*surface));
+    ::wp_linux_drm_syncobj_timeline_v1 *timeline = importTimeline();
+    QTRY_COMPARE(m_renderer.timelines.count(), 1);
+    FakeTimeline *serverTimeline = m_renderer.timelines.first();
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    int firstFrames = 0;
+    int secondFrames = 0;
+
+    // every commit waits for its own acquire point and keeps its own damage and frame callback
+    wl_buffer *first = createBuffer();
+    QVERIFY(first);
+    surface->attachBuffer(first);
+    surface->damage(QRect(0, 0, 1, 1));
+    syncObjSurface.set_acquire_point(timeline, 0, 1);
+    syncObjSurface.set_release_point(timeline, 0, 2);
+    wl_callback_add_listener(wl_surface_frame(*surface), &s_frameListener, &firstFrames);
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    wl_buffer *second = createBuffer();
+    QVERIFY(second);
+    surface->attachBuffer(second);
+    surface->damage(QRect(2, 2, 1, 1));
+    syncObjSurface.set_acquire_point(timeline, 0, 3);
+    syncObjSurface.set_release_point(timeline, 0, 4);
+    wl_callback_add_listener(wl_surface_frame(*surface), &s_frameListener, &secondFrames);
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    // a commit without a buffer waits behind them
+    surface->damage(QRect(3, 3, 1, 1));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    // the second buffer doesn't restart the wait for the first one
+    QTRY_COMPARE(serverTimeline->waiters.count(), 1);
+    QCOMPARE(serverTimeline->waiters.firstKey(), quint64(1));
+    serverTimeline->reach(1);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(committedSpy.count(), 1);
+    QCOMPARE(serverSurface->damage(), QRegion(0, 0, 1, 1));
+    ClientBuffer *firstBuffer = serverSurface->buffer();
+    QVERIFY(firstBuffer);
+
+    // only the frame callback of the applied commit is done
+    serverSurface->frameRendered(1);
+    QTRY_COMPARE(firstFrames, 1);
+    QCOMPARE(secondFrames, 0);
+
+    QTRY_COMPARE(serverTimeline->waiters.count(), 1);
+    QCOMPARE(serverTimeline->waiters.firstKey(), quint64(3));
+    serverTimeline->reach(3);
+    QVERIFY(committedSpy.wait());
+    // the commit without a buffer follows right away
+    QTRY_COMPARE(committedSpy.count(), 3);
+    QVERIFY(serverSurface->buffer() != firstBuffer);
+    QCOMPARE(serverSurface->damage(), QRegion(3, 3, 1, 1));
+    serverSurface->frameRendered(2);
+    QTRY_COMPARE(secondFrames, 1);
+    QCOMPARE(firstFrames, 1);
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDrmSyncObjInterface)
+#include "test_linuxdrmsyncobj_interface.moc"
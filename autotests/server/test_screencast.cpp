@@ -75,6 +75,7 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void testCreate();
+    void testFramePacing();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -181,6 +182,45 @@ void TestScreencastV1Interface::testCreate()
     QVERIFY(spyStop.count() || spyStop.wait());
 }
 
+void TestScreencastV1Interface::testFramePacing()
+{
+    using namespace std::chrono_literals;
+    auto stream = m_screencast->createWindowStream("4");
+    QVERIFY(stream);
+
+    QSignalSpy spyWorking(stream, &ScreencastStreamV1::created);
+    QVERIFY(spyWorking.count() || spyWorking.wait());
+    QVERIFY(m_triggered);
+
+    m_triggered->setMaximumFramerate(30);
+    QCOMPARE(m_triggered->minimumFrameInterval(), std::chrono::nanoseconds(33333333));
+
+    // a pending frame holds back the next ones
+    QVERIFY(m_triggered->startFrame(0ms));
+    QVERIFY(m_triggered->isFramePending());
+    QVERIFY(!m_triggered->startFrame(40ms));
+    m_triggered->frameReleased(45ms);
+    QVERIFY(!m_triggered->isFramePending());
+
+    // a 60 Hz compositor only delivers every second frame
+    QVERIFY(!m_triggered->startFrame(16ms));
+    QVERIFY(m_triggered->startFrame(33ms));
+    m_triggered->frameReleased(38ms);
+    QVERIFY(!m_triggered->startFrame(50ms));
+    QVERIFY(m_triggered->startFrame(66ms));
+    m_triggered->frameReleased(71ms);
+
+    const auto statistics = m_triggered->frameStatistics();
+    QCOMPARE(statistics.producedFrames, quint64(3));
+    QCOMPARE(statistics.droppedFrames, quint64(3));
+    QCOMPARE(statistics.lastLatency, std::chrono::nanoseconds(5ms));
+    QCOMPARE(statistics.averageLatency, std::chrono::nanoseconds(std::chrono::nanoseconds(45ms + 5ms + 5ms) / 3));
+
+    QSignalSpy spyStop(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(spyStop.count() || spyStop.wait());
+}
+
 QTEST_GUILESS_MAIN(TestScreencastV1Interface)
 
 #include "test_screencast.moc"
@@ -0,0 +1,248 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QThread>
+#include <QtTest>
+
+#include <wayland-client-protocol.h>
+
+#include "../../src/server/clientbuffer.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/screencopy_v1_interface.h"
+
+#include "../../src/client/buffer.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/output.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/shm_pool.h"
+
+#include "qwayland-wlr-screencopy-unstable-v1.h"
+
+using namespace KWaylandServer;
+
+class ScreencopyFrame : public QObject, public QtWayland::zwlr_screencopy_frame_v1
+{
+    Q_OBJECT
+
+public:
+    ScreencopyFrame(::zwlr_screencopy_frame_v1 *frame)
+        : zwlr_screencopy_frame_v1(frame)
+    {
+    }
+
+    ~ScreencopyFrame() override
+    {
+        destroy();
+    }
+
+    QSize shmSize;
+    quint32 shmStride = 0;
+    QRegion damage;
+    std::chrono::nanoseconds timestamp = std::chrono::nanoseconds::zero();
+
+Q_SIGNALS:
+    void bufferDone();
+    void ready();
+    void failed();
+
+protected:
+    void zwlr_screencopy_frame_v1_buffer(uint32_t format, uint32_t width, uint32_t height, uint32_t stride) override
+    {
+        Q_UNUSED(format)
+        shmSize = QSize(width, height);
+        shmStride = stride;
+    }
+    void zwlr_screencopy_frame_v1_buffer_done() override
+    {
+        Q_EMIT bufferDone();
+    }
+    void zwlr_screencopy_frame_v1_damage(uint32_t x, uint32_t y, uint32_t width, uint32_t height) override
+    {
+        damage += QRect(x, y, width, height);
+    }
+    void zwlr_screencopy_frame_v1_ready(uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec) override
+    {
+        timestamp = std::chrono::seconds((quint64(tv_sec_hi) << 32) | tv_sec_lo) + std::chrono::nanoseconds(tv_nsec);
+        Q_EMIT ready();
+    }
+    void zwlr_screencopy_frame_v1_failed() override
+    {
+        Q_EMIT failed();
+    }
+};
+
+class ScreencopyManager : public QtWayland::zwlr_screencopy_manager_v1
+{
+};
+
+class TestScreencopyV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestScreencopyV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testCopyWithDamage();
+    void testRegion();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::ShmPool *m_shm;
+    KWayland::Client::Output *m_clientOutput;
+    ScreencopyManager *m_screencopy = nullptr;
+
+    QThread *m_thread;
+    Display m_display;
+    OutputInterface *m_output;
+    ScreencopyManagerV1Interface *m_screencopyInterface;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-screencopy-test-0");
+
+void TestScreencopyV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_display.createShm();
+    m_output = new OutputInterface(&m_display, this);
+    m_output->setMode(QSize(100, 100));
+    m_screencopyInterface = new ScreencopyManagerV1Interface(&m_display, this);
+    connect(m_screencopyInterface, &ScreencopyManagerV1Interface::frameCreated, this, [](ScreencopyFrameV1Interface *frame) {
+        frame->sendShmBuffer(WL_SHM_FORMAT_ARGB8888, frame->region().size(), frame->region().width() * 4);
+        frame->sendBufferDone();
+    });
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("zwlr_screencopy_manager_v1")) {
+            m_screencopy = new ScreencopyManager();
+            m_screencopy->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy outputSpy(registry, &KWayland::Client::Registry::outputAnnounced);
+    QSignalSpy shmSpy(registry, &KWayland::Client::Registry::shmAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_screencopy);
+
+    m_shm = registry->createShmPool(shmSpy.first().first().value<quint32>(), shmSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shm->isValid());
+    m_clientOutput = registry->createOutput(outputSpy.first().first().value<quint32>(), outputSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientOutput->isValid());
+}
+
+TestScreencopyV1Interface::~TestScreencopyV1Interface()
+{
+    delete m_screencopy;
+    m_screencopy = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_clientOutput;
+    m_clientOutput = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestScreencopyV1Interface::testCopyWithDamage()
+{
+    QSignalSpy frameCreatedSpy(m_screencopyInterface, &ScreencopyManagerV1Interface::frameCreated);
+
+    // the first copy of an output is damaged entirely
+    QScopedPointer<ScreencopyFrame> frame(new ScreencopyFrame(m_screencopy->capture_output(0, *m_clientOutput)));
+    QSignalSpy bufferDoneSpy(frame.data(), &ScreencopyFrame::bufferDone);
+    QVERIFY(bufferDoneSpy.wait());
+    QCOMPARE(frame->shmSize, QSize(100, 100));
+    QCOMPARE(frame->shmStride, 400u);
+    QCOMPARE(frameCreatedSpy.count(), 1);
+    ScreencopyFrameV1Interface *serverFrame = frameCreatedSpy.last().first().value<ScreencopyFrameV1Interface *>();
+    QCOMPARE(serverFrame->output(), m_output);
+    QCOMPARE(serverFrame->region(), QRect(0, 0, 100, 100));
+
+    QSignalSpy copyRequestedSpy(serverFrame, &ScreencopyFrameV1Interface::copyRequested);
+    auto buffer = m_shm->getBuffer(QSize(100, 100), 400).toStrongRef();
+    frame->copy_with_damage(*buffer);
+    QVERIFY(copyRequestedSpy.wait());
+    QCOMPARE(serverFrame->damage(), QRegion(0, 0, 100, 100));
+
+    QSignalSpy readySpy(frame.data(), &ScreencopyFrame::ready);
+    serverFrame->sendReady(std::chrono::seconds(5) + std::chrono::nanoseconds(10));
+    QVERIFY(readySpy.wait());
+    QCOMPARE(frame->damage, QRegion(0, 0, 100, 100));
+    QCOMPARE(frame->timestamp, std::chrono::seconds(5) + std::chrono::nanoseconds(10));
+
+    // the next copy waits for the compositor to repaint something
+    frame.reset(new ScreencopyFrame(m_screencopy->capture_output(0, *m_clientOutput)));
+    QSignalSpy bufferDoneSpy2(frame.data(), &ScreencopyFrame::bufferDone);
+    QVERIFY(bufferDoneSpy2.wait());
+    serverFrame = frameCreatedSpy.last().first().value<ScreencopyFrameV1Interface *>();
+    QSignalSpy copyRequestedSpy2(serverFrame, &ScreencopyFrameV1Interface::copyRequested);
+    frame->copy_with_damage(*buffer);
+    QVERIFY(!copyRequestedSpy2.wait(100));
+
+    m_screencopyInterface->addDamage(m_output, QRegion(10, 10, 20, 20));
+    QCOMPARE(copyRequestedSpy2.count(), 1);
+    QCOMPARE(serverFrame->damage(), QRegion(10, 10, 20, 20));
+    QSignalSpy readySpy2(frame.data(), &ScreencopyFrame::ready);
+    serverFrame->sendReady(std::chrono::seconds(6));
+    QVERIFY(readySpy2.wait());
+    QCOMPARE(frame->damage, QRegion(10, 10, 20, 20));
+}
+
+void TestScreencopyV1Interface::testRegion()
+{
+    QSignalSpy frameCreatedSpy(m_screencopyInterface, &ScreencopyManagerV1Interface::frameCreated);
+
+    // the region is clipped to the output
+    QScopedPointer<ScreencopyFrame> frame(new ScreencopyFrame(m_screencopy->capture_output_region(1, *m_clientOutput, 50, 50, 100, 100)));
+    QSignalSpy bufferDoneSpy(frame.data(), &ScreencopyFrame::bufferDone);
+    QVERIFY(bufferDoneSpy.wait());
+    QCOMPARE(frame->shmSize, QSize(50, 50));
+    ScreencopyFrameV1Interface *serverFrame = frameCreatedSpy.last().first().value<ScreencopyFrameV1Interface *>();
+    QCOMPARE(serverFrame->region(), QRect(50, 50, 50, 50));
+    QVERIFY(serverFrame->overlayCursor());
+
+    // a region outside of the output can't be copied
+    QScopedPointer<ScreencopyFrame> outside(new ScreencopyFrame(m_screencopy->capture_output_region(0, *m_clientOutput, 200, 200, 10, 10)));
+    QSignalSpy failedSpy(outside.data(), &ScreencopyFrame::failed);
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(frameCreatedSpy.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestScreencopyV1Interface)
+
+#include "test_screencopy.moc"
@@ -6,10 +6,19 @@
 // Qt
 #include <QtTest>
 // WaylandServer
+#include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/keyboard_interface.h"
 #include "../../src/server/pointer_interface.h"
 #include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+// Wayland
+#include <wayland-client.h>
+// system
+#include <linux/input.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using namespace KWaylandServer;
 
@@ -23,6 +32,9 @@ private Q_SLOTS:
     void testPointerPos();
     void testRepeatInfo();
     void testMultiple();
+
+    void benchKeyboardKey();
+    void benchPointerMotion();
 };
 
 static const QString s_socketName = QStringLiteral("kwin-wayland-server-seat-test-0");
@@ -207,5 +219,291 @@ void TestWaylandServerSeat::testMultiple()
     QCOMPARE(display.seats().count(), 0);
 }
 
+namespace
+{
+/**
+ * A minimal wayland client talking to the server over a socketpair. Both ends are driven
+ * from the test thread, so the benchmarks measure the time it takes an input event to get
+ * from the seat to the client without any thread hops in between.
+ */
+struct BenchClient {
+    ~BenchClient()
+    {
+        if (keyboard) {
+            wl_keyboard_destroy(keyboard);
+        }
+        if (pointer) {
+            wl_pointer_destroy(pointer);
+        }
+        if (surface) {
+            wl_surface_destroy(surface);
+        }
+        if (seat) {
+            wl_seat_destroy(seat);
+        }
+        if (compositor) {
+            wl_compositor_destroy(compositor);
+        }
+        if (registry) {
+            wl_registry_destroy(registry);
+        }
+        if (display) {
+            wl_display_disconnect(display);
+        }
+    }
+
+    bool connect(Display *server);
+    void dispatch();
+    bool roundtrip();
+
+    Display *server = nullptr;
+    wl_display *display = nullptr;
+    wl_registry *registry = nullptr;
+    wl_compositor *compositor = nullptr;
+    wl_seat *seat = nullptr;
+    wl_keyboard *keyboard = nullptr;
+    wl_pointer *pointer = nullptr;
+    wl_surface *surface = nullptr;
+    int keys = 0;
+    int motions = 0;
+};
+
+void registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    auto client = static_cast<BenchClient *>(data);
+    if (qstrcmp(interface, wl_compositor_interface.name) == 0) {
+        client->compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, 1));
+    } else if (qstrcmp(interface, wl_seat_interface.name) == 0) {
+        client->seat = static_cast<wl_seat *>(wl_registry_bind(registry, name, &wl_seat_interface, qMin(version, 5u)));
+    }
+}
+
+void registryGlobalRemove(void *, wl_registry *, uint32_t)
+{
+}
+
+const wl_registry_listener s_registryListener = {
+    registryGlobal,
+    registryGlobalRemove,
+};
+
+void keyboardKeymap(void *, wl_keyboard *, uint32_t, int32_t fd, uint32_t)
+{
+    close(fd);
+}
+
+void keyboardEnter(void *, wl_keyboard *, uint32_t, wl_surface *, wl_array *)
+{
+}
+
+void keyboardLeave(void *, wl_keyboard *, uint32_t, wl_surface *)
+{
+}
+
+void keyboardKey(void *data, wl_keyboard *, uint32_t, uint32_t, uint32_t, uint32_t)
+{
+    static_cast<BenchClient *>(data)->keys++;
+}
+
+void keyboardModifiers(void *, wl_keyboard *, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
+{
+}
+
+void keyboardRepeatInfo(void *, wl_keyboard *, int32_t, int32_t)
+{
+}
+
+const wl_keyboard_listener s_keyboardListener = {
+    keyboardKeymap,
+    keyboardEnter,
+    keyboardLeave,
+    keyboardKey,
+    keyboardModifiers,
+    keyboardRepeatInfo,
+};
+
+void pointerEnter(void *, wl_pointer *, uint32_t, wl_surface *, wl_fixed_t, wl_fixed_t)
+{
+}
+
+void pointerLeave(void *, wl_pointer *, uint32_t, wl_surface *)
+{
+}
+
+void pointerMotion(void *data, wl_pointer *, uint32_t, wl_fixed_t, wl_fixed_t)
+{
+    static_cast<BenchClient *>(data)->motions++;
+}
+
+void pointerButton(void *, wl_pointer *, uint32_t, uint32_t, uint32_t, uint32_t)
+{
+}
+
+void pointerAxis(void *, wl_pointer *, uint32_t, uint32_t, wl_fixed_t)
+{
+}
+
+void pointerFrame(void *, wl_pointer *)
+{
+}
+
+void pointerAxisSource(void *, wl_pointer *, uint32_t)
+{
+}
+
+void pointerAxisStop(void *, wl_pointer *, uint32_t, uint32_t)
+{
+}
+
+void pointerAxisDiscrete(void *, wl_pointer *, uint32_t, int32_t)
+{
+}
+
+const wl_pointer_listener s_pointerListener = {
+    pointerEnter,
+    pointerLeave,
+    pointerMotion,
+    pointerButton,
+    pointerAxis,
+    pointerFrame,
+    pointerAxisSource,
+    pointerAxisStop,
+    pointerAxisDiscrete,
+};
+
+void syncDone(void *data, wl_callback *callback, uint32_t)
+{
+    *static_cast<bool *>(data) = true;
+    wl_callback_destroy(callback);
+}
+
+const wl_callback_listener s_syncListener = {
+    syncDone,
+};
+
+bool BenchClient::connect(Display *display)
+{
+    server = display;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        return false;
+    }
+    if (!server->createClient(sv[0])) {
+        close(sv[1]);
+        return false;
+    }
+    this->display = wl_display_connect_to_fd(sv[1]);
+    if (!this->display) {
+        close(sv[1]);
+        return false;
+    }
+    registry = wl_display_get_registry(this->display);
+    wl_registry_add_listener(registry, &s_registryListener, this);
+    if (!roundtrip() || !compositor || !seat) {
+        return false;
+    }
+    keyboard = wl_seat_get_keyboard(seat);
+    wl_keyboard_add_listener(keyboard, &s_keyboardListener, this);
+    pointer = wl_seat_get_pointer(seat);
+    wl_pointer_add_listener(pointer, &s_pointerListener, this);
+    surface = wl_compositor_create_surface(compositor);
+    return roundtrip();
+}
+
+void BenchClient::dispatch()
+{
+    wl_display_flush(display);
+    server->dispatchEvents();
+    server->flush();
+
+    while (wl_display_prepare_read(display) != 0) {
+        wl_display_dispatch_pending(display);
+    }
+    pollfd pfd = {wl_display_get_fd(display), POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0) {
+        wl_display_read_events(display);
+    } else {
+        wl_display_cancel_read(display);
+    }
+    wl_display_dispatch_pending(display);
+}
+
+bool BenchClient::roundtrip()
+{
+    bool done = false;
+    wl_callback *callback = wl_display_sync(display);
+    wl_callback_add_listener(callback, &s_syncListener, &done);
+    for (int i = 0; i < 100 && !done; ++i) {
+        dispatch();
+    }
+    return done;
+}
+}
+
+void TestWaylandServerSeat::benchKeyboardKey()
+{
+    Display display;
+    display.addSocketName(s_socketName);
+    display.start();
+    CompositorInterface compositor(&display);
+    SeatInterface *seat = new SeatInterface(&display);
+    seat->setHasKeyboard(true);
+    QSignalSpy surfaceCreatedSpy(&compositor, &CompositorInterface::surfaceCreated);
+
+    BenchClient client;
+    QVERIFY(client.connect(&display));
+    QCOMPARE(surfaceCreatedSpy.count(), 1);
+    auto surface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(surface);
+    seat->setFocusedKeyboardSurface(surface);
+    QCOMPARE(seat->focusedKeyboardSurface(), surface);
+    QVERIFY(client.roundtrip());
+
+    quint32 timestamp = 0;
+    QBENCHMARK {
+        seat->setTimestamp(++timestamp);
+        seat->notifyKeyboardKey(KEY_A, KeyboardKeyState::Pressed);
+        seat->setTimestamp(++timestamp);
+        seat->notifyKeyboardKey(KEY_A, KeyboardKeyState::Released);
+        client.dispatch();
+    }
+    QVERIFY(client.roundtrip());
+    QCOMPARE(client.keys, int(timestamp));
+}
+
+void TestWaylandServerSeat::benchPointerMotion()
+{
+    Display display;
+    display.addSocketName(s_socketName);
+    display.start();
+    CompositorInterface compositor(&display);
+    SeatInterface *seat = new SeatInterface(&display);
+    seat->setHasPointer(true);
+    QSignalSpy surfaceCreatedSpy(&compositor, &CompositorInterface::surfaceCreated);
+
+    BenchClient client;
+    QVERIFY(client.connect(&display));
+    QCOMPARE(surfaceCreatedSpy.count(), 1);
+    auto surface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(surface);
+    seat->notifyPointerMotion(QPointF(0, 0));
+    seat->setFocusedPointerSurface(surface);
+    seat->notifyPointerFrame();
+    QCOMPARE(seat->focusedPointerSurface(), surface);
+    QVERIFY(client.roundtrip());
+
+    int motions = 0;
+    quint32 timestamp = 0;
+    QBENCHMARK {
+        seat->setTimestamp(++timestamp);
+        seat->notifyPointerMotion(QPointF(motions % 2 ? 10 : 20, 15));
+        seat->notifyPointerFrame();
+        client.dispatch();
+        motions++;
+    }
+    QVERIFY(client.roundtrip());
+    QCOMPARE(client.motions, motions);
+}
+
 QTEST_GUILESS_MAIN(TestWaylandServerSeat)
 #include "test_seat.moc"
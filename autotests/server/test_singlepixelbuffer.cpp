@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/singlepixelbufferv1clientbuffer.h"
+#include "../../src/server/surface_interface.h"
+
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/surface.h"
+
+#include "qwayland-single-pixel-buffer-v1.h"
+
+using namespace KWaylandServer;
+
+class SinglePixelBufferManager : public QtWayland::wp_single_pixel_buffer_manager_v1
+{
+};
+
+class TestSinglePixelBuffer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestSinglePixelBuffer() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testAttach_data();
+    void testAttach();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    SinglePixelBufferManager *m_singlePixelBufferManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-single-pixel-buffer-test-0");
+
+void TestSinglePixelBuffer::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new SinglePixelBufferV1ClientBufferIntegration(&m_display);
+
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+    QVERIFY(!m_connection->connections().isEmpty());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_single_pixel_buffer_manager_v1")) {
+            m_singlePixelBufferManager = new SinglePixelBufferManager();
+            m_singlePixelBufferManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+    QVERIFY(m_singlePixelBufferManager);
+}
+
+TestSinglePixelBuffer::~TestSinglePixelBuffer()
+{
+    if (m_singlePixelBufferManager) {
+        delete m_singlePixelBufferManager;
+        m_singlePixelBufferManager = nullptr;
+    }
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestSinglePixelBuffer::testAttach_data()
+{
+    QTest::addColumn<quint32>("red");
+    QTest::addColumn<quint32>("alpha");
+    QTest::addColumn<bool>("hasAlphaChannel");
+    QTest::addColumn<QColor>("color");
+
+    QTest::newRow("opaque") << quint32(0xffffffff) << quint32(0xffffffff) << false << QColor::fromRgba64(0xffff, 0, 0, 0xffff);
+    QTest::newRow("half transparent") << quint32(0x7fffffff) << quint32(0x7fffffff) << true << QColor::fromRgba64(0x7fff, 0, 0, 0x7fff);
+}
+
+void TestSinglePixelBuffer::testAttach()
+{
+    QFETCH(quint32, red);
+    QFETCH(quint32, alpha);
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    QSignalSpy serverSurfaceMappedSpy(serverSurface, &SurfaceInterface::mapped);
+    wl_buffer *clientBuffer = m_singlePixelBufferManager->create_u32_rgba_buffer(red, 0, 0, alpha);
+    clientSurface->attachBuffer(clientBuffer);
+    clientSurface->damage(QRect(0, 0, 1, 1));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(serverSurfaceMappedSpy.wait());
+
+    auto serverBuffer = qobject_cast<SinglePixelBufferV1ClientBuffer *>(serverSurface->buffer());
+    QVERIFY(serverBuffer);
+    QCOMPARE(serverBuffer->size(), QSize(1, 1));
+    QTEST(serverBuffer->hasAlphaChannel(), "hasAlphaChannel");
+    QTEST(serverBuffer->color(), "color");
+    QCOMPARE(serverSurface->bufferSize(), QSize(1, 1));
+    QCOMPARE(serverSurface->size(), QSize(1, 1));
+
+    wl_buffer_destroy(clientBuffer);
+}
+
+QTEST_GUILESS_MAIN(TestSinglePixelBuffer)
+
+#include "test_singlepixelbuffer.moc"
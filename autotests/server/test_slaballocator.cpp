@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/slaballocator_p.h"
+// std
+#include <vector>
+
+using namespace KWaylandServer;
+
+struct PooledObject : SlabAllocated<PooledObject> {
+    virtual ~PooledObject() = default;
+    int value = 0;
+};
+
+struct BiggerObject : PooledObject {
+    double payload[8] = {};
+};
+
+class TestSlabAllocator : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testReuse();
+    void testGrow();
+    void testSubclass();
+    void testThreads();
+};
+
+void TestSlabAllocator::testReuse()
+{
+    auto &allocator = SlabAllocator<PooledObject>::instance();
+    const int blocks = allocator.blockCount();
+
+    auto first = new PooledObject;
+    QCOMPARE(allocator.liveCount(), 1);
+    delete first;
+    QCOMPARE(allocator.liveCount(), 0);
+
+    // the slot of a destroyed object is handed out next
+    auto second = new PooledObject;
+    QCOMPARE(static_cast<void *>(second), static_cast<void *>(first));
+    delete second;
+    QCOMPARE(allocator.blockCount(), std::max(blocks, 1));
+}
+
+void TestSlabAllocator::testGrow()
+{
+    auto &allocator = SlabAllocator<PooledObject>::instance();
+    std::vector<PooledObject *> objects;
+    for (int i = 0; i < 100; ++i) {
+        objects.push_back(new PooledObject);
+        objects.back()->value = i;
+    }
+    QCOMPARE(allocator.liveCount(), 100);
+    QCOMPARE(allocator.blockCount(), 2);
+    for (int i = 0; i < 100; ++i) {
+        QCOMPARE(objects[i]->value, i);
+        delete objects[i];
+    }
+    QCOMPARE(allocator.liveCount(), 0);
+
+    // all objects fit into the existing blocks again
+    for (int i = 0; i < 100; ++i) {
+        objects[i] = new PooledObject;
+    }
+    QCOMPARE(allocator.blockCount(), 2);
+    for (PooledObject *object : objects) {
+        delete object;
+    }
+}
+
+void TestSlabAllocator::testSubclass()
+{
+    auto &allocator = SlabAllocator<PooledObject>::instance();
+    PooledObject *object = new BiggerObject;
+    QCOMPARE(allocator.liveCount(), 0);
+    delete object;
+    QCOMPARE(allocator.liveCount(), 0);
+}
+
+void TestSlabAllocator::testThreads()
+{
+    auto &allocator = SlabAllocator<PooledObject>::instance();
+    const int blocks = allocator.blockCount();
+
+    // a thread allocates from blocks of its own
+    int threadLiveCount = -1;
+    int threadBlockCount = -1;
+    QScopedPointer<QThread> thread(QThread::create([&threadLiveCount, &threadBlockCount]() {
+        auto &threadAllocator = SlabAllocator<PooledObject>::instance();
+        auto object = new PooledObject;
+        threadLiveCount = threadAllocator.liveCount();
+        threadBlockCount = threadAllocator.blockCount();
+        delete object;
+    }));
+    thread->start();
+    QVERIFY(thread->wait());
+    QCOMPARE(threadLiveCount, 1);
+    QCOMPARE(threadBlockCount, 1);
+    QCOMPARE(allocator.liveCount(), 0);
+    QCOMPARE(allocator.blockCount(), blocks);
+}
+
+QTEST_GUILESS_MAIN(TestSlabAllocator)
+#include "test_slaballocator.moc"
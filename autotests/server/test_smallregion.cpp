@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/smallregion_p.h"
+
+using namespace KWaylandServer;
+
+class TestSmallRegion : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testUnite();
+    void testIntersected();
+    void testMapped();
+    void testManyRects();
+    void testSimplify();
+};
+
+void TestSmallRegion::testUnite()
+{
+    SmallRegion region;
+    QVERIFY(region.isEmpty());
+    region.unite(QRect());
+    QVERIFY(region.isEmpty());
+
+    region.unite(QRect(0, 0, 10, 10));
+    // contained rects are dropped
+    region.unite(QRect(2, 2, 5, 5));
+    QCOMPARE(region.rectCount(), 1);
+    // and so are rects covered by a new one
+    region.unite(QRect(-5, -5, 20, 20));
+    QCOMPARE(region.rectCount(), 1);
+    region.unite(QRect(100, 100, 10, 10));
+    QCOMPARE(region.rectCount(), 2);
+    QCOMPARE(region.boundingRect(), QRect(-5, -5, 115, 115));
+    QCOMPARE(region.toRegion(), QRegion(-5, -5, 20, 20) + QRegion(100, 100, 10, 10));
+
+    region.clear();
+    QVERIFY(region.isEmpty());
+    QCOMPARE(region.toRegion(), QRegion());
+}
+
+void TestSmallRegion::testIntersected()
+{
+    SmallRegion region(QRect(0, 0, 10, 10));
+    region.unite(QRect(5, 5, 10, 10));
+    region.unite(QRect(50, 50, 10, 10));
+
+    const SmallRegion clipped = region.intersected(QRect(0, 0, 12, 12));
+    QCOMPARE(clipped.rectCount(), 2);
+    QCOMPARE(clipped.toRegion(), region.toRegion() & QRect(0, 0, 12, 12));
+}
+
+void TestSmallRegion::testMapped()
+{
+    SmallRegion region(QRect(0, 0, 10, 10));
+    region.unite(QRect(20, 0, 10, 10));
+    const SmallRegion scaled = region.mapped([](const QRect &rect) {
+        return QRect(rect.topLeft() * 2, rect.size() * 2);
+    });
+    QCOMPARE(scaled.toRegion(), QRegion(0, 0, 20, 20) + QRegion(40, 0, 20, 20));
+}
+
+void TestSmallRegion::testManyRects()
+{
+    // more rects than fit inline still make up the correct region
+    SmallRegion region;
+    QRegion expected;
+    for (int i = 0; i < 10; ++i) {
+        region.unite(QRect(i * 20, i * 3, 10, 10));
+        expected += QRect(i * 20, i * 3, 10, 10);
+    }
+    QCOMPARE(region.rectCount(), 10);
+    QCOMPARE(region.toRegion(), expected);
+}
+
+void TestSmallRegion::testSimplify()
+{
+    // two lines of a terminal, each damaged glyph by glyph
+    SmallRegion region;
+    for (int i = 0; i < 40; ++i) {
+        region.unite(QRect(i * 8, 0, 8, 16));
+        region.unite(QRect(i * 8, 100, 8, 16));
+    }
+    QCOMPARE(region.rectCount(), 80);
+    const QRegion original = region.toRegion();
+
+    // within the budget nothing changes
+    region.simplify(80);
+    QCOMPARE(region.rectCount(), 80);
+
+    // the glyphs collapse into one rect per line
+    region.simplify(4);
+    QCOMPARE(region.rectCount(), 2);
+    QCOMPARE(region.toRegion(), QRegion(0, 0, 320, 16) + QRegion(0, 100, 320, 16));
+    QVERIFY(original.subtracted(region.toRegion()).isEmpty());
+
+    // too many lines become the bounding rect
+    region.simplify(1);
+    QCOMPARE(region.rectCount(), 1);
+    QCOMPARE(region.boundingRect(), QRect(0, 0, 320, 116));
+}
+
+QTEST_GUILESS_MAIN(TestSmallRegion)
+#include "test_smallregion.moc"
@@ -87,12 +87,26 @@ public:
         surfaceApproximated[surface]++;
     }
 
+    void zwp_tablet_tool_v2_pressure(uint32_t pressure) override
+    {
+        pressures << pressure;
+    }
+
+    void zwp_tablet_tool_v2_wheel(int32_t degrees, int32_t clicks) override
+    {
+        wheelDegrees << degrees;
+        wheelClicks << clicks;
+    }
+
     void zwp_tablet_tool_v2_frame(uint32_t time) override
     {
         Q_EMIT frame(time);
     }
 
     QHash<struct ::wl_surface *, int> surfaceApproximated;
+    QVector<quint32> pressures;
+    QVector<qint32> wheelDegrees;
+    QVector<qint32> wheelClicks;
 Q_SIGNALS:
     void frame(quint32 time);
 };
@@ -148,6 +162,8 @@ private Q_SLOTS:
     void testAddPad();
     void testInteractSimple();
     void testInteractSurfaceChange();
+    void testFrameAggregation();
+    void testToolLookup();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -355,5 +371,59 @@ void TestTabletInterface::testInteractSurfaceChange()
     QCOMPARE(m_tabletSeatClient->m_tools[0]->surfaceApproximated.count(), 2);
 }
 
+void TestTabletInterface::testFrameAggregation()
+{
+    Tool *tool = m_tabletSeatClient->m_tools[0];
+    tool->pressures.clear();
+    QSignalSpy frameSpy(tool, &Tool::frame);
+    const uint firstFrame = s_serial;
+    m_tool->setCurrentSurface(m_surfaces[0]);
+    QVERIFY(m_tool->isClientSupported());
+    m_tool->sendProximityIn(m_tablet);
+    m_tool->sendPressure(10);
+    m_tool->sendPressure(20);
+    m_tool->sendWheel(15, 1);
+    m_tool->sendWheel(15, 1);
+    m_tool->sendFrame(s_serial++);
+    // nothing changed, neither the pressure nor the frame get sent
+    m_tool->sendPressure(20);
+    m_tool->sendFrame(s_serial++);
+    m_tool->sendPressure(30);
+    m_tool->sendFrame(s_serial++);
+    m_tool->sendProximityOut();
+    m_tool->sendFrame(s_serial++);
+
+    QTRY_VERIFY(!frameSpy.isEmpty() && frameSpy.last().first().toUInt() == s_serial - 1);
+    QVector<uint> frames;
+    for (const QList<QVariant> &arguments : qAsConst(frameSpy)) {
+        if (arguments.first().toUInt() >= firstFrame) {
+            frames << arguments.first().toUInt();
+        }
+    }
+    QCOMPARE(frames, QVector<uint>({firstFrame, firstFrame + 2, firstFrame + 3}));
+    QCOMPARE(tool->pressures, QVector<quint32>({20, 30}));
+    QCOMPARE(tool->wheelDegrees, QVector<qint32>({30}));
+    QCOMPARE(tool->wheelClicks, QVector<qint32>({2}));
+}
+
+void TestTabletInterface::testToolLookup()
+{
+    TabletSeatV2Interface *seatInterface = m_tabletManager->seat(m_seat);
+    QCOMPARE(seatInterface->toolByHardwareId(0), m_tool);
+    QCOMPARE(seatInterface->toolByHardwareSerial(0, TabletToolV2Interface::Pen), m_tool);
+    QVERIFY(!seatInterface->toolByHardwareSerial(0, TabletToolV2Interface::Eraser));
+
+    TabletToolV2Interface *eraser = seatInterface->addTool(TabletToolV2Interface::Eraser, 0x100000002, 0x300000004, {});
+    QCOMPARE(seatInterface->toolByHardwareId(0x300000004), eraser);
+    QCOMPARE(seatInterface->toolByHardwareSerial(0x100000002, TabletToolV2Interface::Eraser), eraser);
+    QVERIFY(!seatInterface->toolByHardwareSerial(0x100000002, TabletToolV2Interface::Pen));
+    QCOMPARE(seatInterface->toolByHardwareId(0), m_tool);
+
+    delete eraser;
+    QVERIFY(!seatInterface->toolByHardwareId(0x300000004));
+    QVERIFY(!seatInterface->toolByHardwareSerial(0x100000002, TabletToolV2Interface::Eraser));
+    QCOMPARE(seatInterface->toolByHardwareId(0), m_tool);
+}
+
 QTEST_GUILESS_MAIN(TestTabletInterface)
 #include "test_tablet_interface.moc"
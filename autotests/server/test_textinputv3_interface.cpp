@@ -54,14 +54,17 @@ public:
     void zwp_text_input_v3_commit_string(const QString &text) override
     {
         commitText = text;
+        events << QStringLiteral("commit:") + text;
     }
     void zwp_text_input_v3_delete_surrounding_text(uint32_t before_length, uint32_t after_length) override
     {
         before = before_length;
         after = after_length;
+        events << QStringLiteral("delete:%1,%2").arg(before_length).arg(after_length);
     }
     void zwp_text_input_v3_done(uint32_t serial) override
     {
+        events << QStringLiteral("done:%1").arg(serial);
         Q_EMIT commit_string(commitText);
         Q_EMIT preedit_string(preeditText, cursorBegin, cursorEnd);
         Q_EMIT delete_surrounding_text(before, after);
@@ -72,8 +75,12 @@ public:
         preeditText = text;
         cursorBegin = cursor_begin;
         cursorEnd = cursor_end;
+        events << QStringLiteral("preedit:") + text;
     }
 
+    // the events in the order they were received
+    QStringList events;
+
 private:
     QString preeditText;
     QString commitText;
@@ -101,6 +108,7 @@ private Q_SLOTS:
     void initTestCase();
     void testEnableDisable();
     void testEvents();
+    void testDoneCoalescing();
     void testContentPurpose_data();
     void testContentPurpose();
     void testContentHints_data();
@@ -342,6 +350,85 @@ void TestTextInputV3Interface::testEvents()
     QVERIFY(textInputEnabledSpy.wait());
 }
 
+void TestTextInputV3Interface::testDoneCoalescing()
+{
+    // create a surface
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreatedSpy.isValid());
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+
+    m_serverTextInputV3 = m_seat->textInputV3();
+    QVERIFY(m_serverTextInputV3);
+    QVERIFY(!m_serverTextInputV3->doneCoalescing());
+
+    QSignalSpy textInputEnabledSpy(m_serverTextInputV3, &TextInputV3Interface::enabledChanged);
+    m_seat->setFocusedTextInputSurface(serverSurface);
+    m_clientTextInputV3->enable();
+    m_clientTextInputV3->commit();
+    m_totalCommits++;
+    QVERIFY(textInputEnabledSpy.wait());
+
+    QSignalSpy doneSpy(m_clientTextInputV3, &TextInputV3::done);
+    const QString done = QStringLiteral("done:%1").arg(m_totalCommits);
+    m_clientTextInputV3->events.clear();
+
+    // the events within one batch are merged, nothing goes out before the flush
+    m_serverTextInputV3->setDoneCoalescing(true);
+    QVERIFY(m_serverTextInputV3->doneCoalescing());
+    m_serverTextInputV3->sendPreEditString(QStringLiteral("n"), 1, 1);
+    m_serverTextInputV3->sendPreEditString(QStringLiteral("ni"), 2, 2);
+    m_serverTextInputV3->commitString(QStringLiteral("你"));
+    m_serverTextInputV3->commitString(QStringLiteral("好"));
+    m_serverTextInputV3->deleteSurroundingText(1, 0);
+    m_serverTextInputV3->done();
+    // the second batch has no pre-edit string, so it clears the one of the first batch
+    m_serverTextInputV3->commitString(QStringLiteral("吗"));
+    m_serverTextInputV3->done();
+    // and the third one deletes again, which must not be merged with the first deletion
+    m_serverTextInputV3->deleteSurroundingText(2, 0);
+    m_serverTextInputV3->sendPreEditString(QStringLiteral("a"), 1, 1);
+    m_serverTextInputV3->done();
+    QVERIFY(!doneSpy.wait(100));
+
+    m_serverTextInputV3->flushDone();
+    while (doneSpy.count() < 3) {
+        QVERIFY(doneSpy.wait());
+    }
+    QCOMPARE(m_clientTextInputV3->events,
+             QStringList({QStringLiteral("preedit:ni"),
+                          QStringLiteral("commit:你好"),
+                          QStringLiteral("delete:1,0"),
+                          done,
+                          QStringLiteral("commit:吗"),
+                          done,
+                          QStringLiteral("preedit:a"),
+                          QStringLiteral("delete:2,0"),
+                          done}));
+
+    // a flush without new batches sends nothing
+    m_serverTextInputV3->flushDone();
+    QVERIFY(!doneSpy.wait(100));
+    QCOMPARE(doneSpy.count(), 3);
+
+    // disabling the coalescing sends the queued batches
+    m_clientTextInputV3->events.clear();
+    m_serverTextInputV3->commitString(QStringLiteral("吗"));
+    m_serverTextInputV3->done();
+    m_serverTextInputV3->setDoneCoalescing(false);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(doneSpy.count(), 4);
+    QCOMPARE(m_clientTextInputV3->events, QStringList({QStringLiteral("commit:吗"), done}));
+
+    // Now disable the textInput
+    m_clientTextInputV3->disable();
+    m_clientTextInputV3->commit();
+    m_totalCommits++;
+    QVERIFY(textInputEnabledSpy.wait());
+}
+
 void TestTextInputV3Interface::testContentPurpose_data()
 {
     QTest::addColumn<QtWayland::zwp_text_input_v3::content_purpose>("clientPurpose");
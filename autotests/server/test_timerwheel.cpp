@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+// Qt
+#include <QElapsedTimer>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/timerwheel.h"
+// std
+#include <memory>
+
+using namespace KWaylandServer;
+using namespace std::chrono_literals;
+
+class TestTimerWheel : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testExpiry_data();
+    void testExpiry();
+    void testOrder();
+    void testStop();
+    void testRestartFromCallback();
+    void testDestroyFromCallback();
+    void testIdleWakeUp();
+};
+
+void TestTimerWheel::testExpiry_data()
+{
+    QTest::addColumn<int>("interval");
+
+    // the timers of the lowest level and of the next one, which get cascaded once
+    QTest::newRow("level 0") << 50;
+    QTest::newRow("level 1") << 900;
+}
+
+void TestTimerWheel::testExpiry()
+{
+    QFETCH(int, interval);
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    int fired = 0;
+    qint64 elapsed = 0;
+    QElapsedTimer clock;
+    timer.setCallback([&]() {
+        ++fired;
+        elapsed = clock.elapsed();
+    });
+
+    clock.start();
+    timer.start(&wheel, std::chrono::milliseconds(interval));
+    QVERIFY(timer.isActive());
+    QTRY_COMPARE_WITH_TIMEOUT(fired, 1, interval + 1000);
+    QVERIFY(!timer.isActive());
+    // deadlines are rounded up to the tick, but never come early
+    QVERIFY(elapsed >= interval);
+    QCOMPARE(wheel.remainingTime(), -1);
+}
+
+void TestTimerWheel::testOrder()
+{
+    TimerWheel wheel;
+    QVector<int> fired;
+    TimerWheel::Timer first;
+    TimerWheel::Timer second;
+    TimerWheel::Timer third;
+    first.setCallback([&]() {
+        fired << 1;
+    });
+    second.setCallback([&]() {
+        fired << 2;
+    });
+    third.setCallback([&]() {
+        fired << 3;
+    });
+
+    third.start(&wheel, 700ms);
+    first.start(&wheel, 30ms);
+    second.start(&wheel, 200ms);
+    QTRY_COMPARE(fired.count(), 3);
+    QCOMPARE(fired, (QVector<int>{1, 2, 3}));
+}
+
+void TestTimerWheel::testStop()
+{
+    TimerWheel wheel;
+    TimerWheel::Timer stopped;
+    TimerWheel::Timer running;
+    bool stoppedFired = false;
+    bool runningFired = false;
+    stopped.setCallback([&]() {
+        stoppedFired = true;
+    });
+    running.setCallback([&]() {
+        runningFired = true;
+    });
+
+    stopped.start(&wheel, 20ms);
+    running.start(&wheel, 60ms);
+    stopped.stop();
+    QVERIFY(!stopped.isActive());
+    QTRY_VERIFY(runningFired);
+    QVERIFY(!stoppedFired);
+
+    // nothing is left, the wheel doesn't wake up anymore
+    QCOMPARE(wheel.remainingTime(), -1);
+}
+
+void TestTimerWheel::testRestartFromCallback()
+{
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    int fired = 0;
+    timer.setCallback([&]() {
+        if (++fired < 3) {
+            timer.start(&wheel, 20ms);
+        }
+    });
+
+    timer.start(&wheel, 20ms);
+    QTRY_COMPARE(fired, 3);
+    QVERIFY(!timer.isActive());
+}
+
+void TestTimerWheel::testDestroyFromCallback()
+{
+    TimerWheel wheel;
+    auto timer = std::make_unique<TimerWheel::Timer>();
+    TimerWheel::Timer other;
+    bool otherFired = false;
+    timer->setCallback([&]() {
+        timer.reset();
+    });
+    other.setCallback([&]() {
+        otherFired = true;
+    });
+
+    // both expire on the same tick
+    timer->start(&wheel, 20ms);
+    other.start(&wheel, 20ms);
+    QTRY_VERIFY(!timer);
+    QTRY_VERIFY(otherFired);
+}
+
+void TestTimerWheel::testIdleWakeUp()
+{
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    timer.setCallback([]() {});
+
+    // an idle timeout of a minute is pending on a higher level, the wheel only wakes up to
+    // cascade it rather than every time the lowest level wraps
+    timer.start(&wheel, 60s);
+    QVERIFY(wheel.remainingTime() > 10000);
+
+    // a timer on the lowest level still wakes it up in time
+    TimerWheel::Timer soon;
+    bool soonFired = false;
+    soon.setCallback([&]() {
+        soonFired = true;
+    });
+    soon.start(&wheel, 30ms);
+    QVERIFY(wheel.remainingTime() <= 40);
+    QTRY_VERIFY(soonFired);
+    QVERIFY(wheel.remainingTime() > 10000);
+    QVERIFY(timer.isActive());
+}
+
+QTEST_GUILESS_MAIN(TestTimerWheel)
+#include "test_timerwheel.moc"
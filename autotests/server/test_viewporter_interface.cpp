@@ -9,6 +9,7 @@
 
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
+#include "../../src/server/fractionalscale_v1_interface.h"
 #include "../../src/server/surface_interface.h"
 #include "../../src/server/viewporter_interface.h"
 
@@ -19,6 +20,7 @@
 #include "../../src/client/shm_pool.h"
 #include "../../src/client/surface.h"
 
+#include "qwayland-fractional-scale-v1.h"
 #include "qwayland-viewporter.h"
 
 using namespace KWaylandServer;
@@ -31,6 +33,22 @@ class Viewport : public QtWayland::wp_viewport
 {
 };
 
+class FractionalScaleManager : public QtWayland::wp_fractional_scale_manager_v1
+{
+};
+
+class FractionalScale : public QtWayland::wp_fractional_scale_v1
+{
+public:
+    QVector<uint32_t> scales;
+
+protected:
+    void wp_fractional_scale_v1_preferred_scale(uint32_t scale) override
+    {
+        scales.append(scale);
+    }
+};
+
 class TestViewporterInterface : public QObject
 {
     Q_OBJECT
@@ -41,6 +59,7 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void testCropScale();
+    void testFractionalScale();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -52,6 +71,7 @@ private:
     Display m_display;
     CompositorInterface *m_serverCompositor;
     Viewporter *m_viewporter;
+    FractionalScaleManager *m_fractionalScaleManager = nullptr;
 };
 
 static const QString s_socketName = QStringLiteral("kwin-wayland-server-viewporter-test-0");
@@ -64,6 +84,7 @@ void TestViewporterInterface::initTestCase()
 
     m_display.createShm();
     new ViewporterInterface(&m_display);
+    new FractionalScaleManagerV1Interface(&m_display);
 
     m_serverCompositor = new CompositorInterface(&m_display, this);
 
@@ -89,6 +110,9 @@ void TestViewporterInterface::initTestCase()
         if (interface == QByteArrayLiteral("wp_viewporter")) {
             m_viewporter = new Viewporter();
             m_viewporter->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("wp_fractional_scale_manager_v1")) {
+            m_fractionalScaleManager = new FractionalScaleManager();
+            m_fractionalScaleManager->init(*registry, id, version);
         }
     });
     QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
@@ -113,6 +137,10 @@ TestViewporterInterface::~TestViewporterInterface()
         delete m_viewporter;
         m_viewporter = nullptr;
     }
+    if (m_fractionalScaleManager) {
+        delete m_fractionalScaleManager;
+        m_fractionalScaleManager = nullptr;
+    }
     if (m_shm) {
         delete m_shm;
         m_shm = nullptr;
@@ -190,6 +218,55 @@ void TestViewporterInterface::testCropScale()
     QCOMPARE(serverSurface->mapToBuffer(QPointF(0, 0)), QPointF(0, 0));
 }
 
+void TestViewporterInterface::testFractionalScale()
+{
+    QVERIFY(m_fractionalScaleManager);
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->preferredScale(), 1.0);
+
+    // the current scale is sent right away, in 120ths
+    QScopedPointer<FractionalScale> fractionalScale(new FractionalScale);
+    fractionalScale->init(m_fractionalScaleManager->get_fractional_scale(*clientSurface));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QTRY_COMPARE(fractionalScale->scales, QVector<uint32_t>{120});
+    serverSurface->setPreferredScale(1.5);
+    QTRY_COMPARE(fractionalScale->scales, (QVector<uint32_t>{120, 180}));
+
+    // a buffer at 1.5 times the size, scaled down with a viewport
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QSignalSpy sizeChangedSpy(serverSurface, &SurfaceInterface::sizeChanged);
+    QSignalSpy surfaceToBufferMatrixChangedSpy(serverSurface, &SurfaceInterface::surfaceToBufferMatrixChanged);
+    QScopedPointer<Viewport> clientViewport(new Viewport);
+    clientViewport->init(m_viewporter->get_viewport(*clientSurface));
+    clientViewport->set_destination(100, 50);
+    QImage image(QSize(150, 75), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    clientSurface->attachBuffer(m_shm->createBuffer(image));
+    clientSurface->damage(image.rect());
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->size(), QSize(100, 50));
+    QCOMPARE(serverSurface->bufferSize(), QSize(150, 75));
+    QCOMPARE(sizeChangedSpy.count(), 1);
+    QCOMPARE(surfaceToBufferMatrixChangedSpy.count(), 1);
+
+    // the next frames only change the content
+    for (int i = 0; i < 3; ++i) {
+        clientSurface->attachBuffer(m_shm->createBuffer(image));
+        clientSurface->damage(image.rect());
+        clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+        QVERIFY(committedSpy.wait());
+    }
+    QCOMPARE(serverSurface->size(), QSize(100, 50));
+    QCOMPARE(serverSurface->mapToBuffer(QPointF(100, 50)), QPointF(150, 75));
+    QCOMPARE(sizeChangedSpy.count(), 1);
+    QCOMPARE(surfaceToBufferMatrixChangedSpy.count(), 1);
+}
+
 QTEST_GUILESS_MAIN(TestViewporterInterface)
 
 #include "test_viewporter_interface.moc"
@@ -0,0 +1,340 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QTemporaryFile>
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/keyboard_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+#include "../../src/server/virtualkeyboard_v1_interface.h"
+
+#include "../../src/client/compositor.h"
+#include "../../src/client/connection_thread.h"
+#include "../../src/client/event_queue.h"
+#include "../../src/client/keyboard.h"
+#include "../../src/client/registry.h"
+#include "../../src/client/seat.h"
+#include "../../src/client/surface.h"
+
+#include "qwayland-virtual-keyboard-unstable-v1.h"
+
+#include <linux/input-event-codes.h>
+
+using namespace KWaylandServer;
+
+class VirtualKeyboardManager : public QtWayland::zwp_virtual_keyboard_manager_v1
+{
+};
+
+class VirtualKeyboard : public QtWayland::zwp_virtual_keyboard_v1
+{
+public:
+    VirtualKeyboard(::zwp_virtual_keyboard_v1 *keyboard)
+        : zwp_virtual_keyboard_v1(keyboard)
+    {
+    }
+    ~VirtualKeyboard()
+    {
+        destroy();
+    }
+
+    bool setKeymap(const QByteArray &content, quint32 extraSize = 0)
+    {
+        QTemporaryFile file;
+        if (!file.open() || file.write(content.constData(), content.size() + 1) != content.size() + 1 || !file.flush()) {
+            return false;
+        }
+        keymap(WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, file.handle(), content.size() + 1 + extraSize);
+        return true;
+    }
+};
+
+class TestVirtualKeyboardV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestVirtualKeyboardV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testKeys();
+    void testSharedKeymap();
+    void testReleaseOnDestroy();
+    void testRestoreSeatKeyboard();
+    // posts a protocol error, so it has to be the last test
+    void testKeymapTooSmall();
+
+private:
+    VirtualKeyboardV1Interface *createVirtualKeyboard(QScopedPointer<VirtualKeyboard> &keyboard, const QByteArray &keymap);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+    KWayland::Client::Seat *m_clientSeat = nullptr;
+    KWayland::Client::Keyboard *m_clientKeyboard = nullptr;
+    KWayland::Client::Surface *m_clientSurface = nullptr;
+    VirtualKeyboardManager *m_virtualKeyboardManager = nullptr;
+
+    QThread *m_thread;
+    Display m_display;
+    SeatInterface *m_seat;
+    CompositorInterface *m_serverCompositor;
+    VirtualKeyboardManagerV1Interface *m_virtualKeyboardManagerInterface;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-virtual-keyboard-test-0");
+
+void TestVirtualKeyboardV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasKeyboard(true);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+    m_virtualKeyboardManagerInterface = new VirtualKeyboardManagerV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("zwp_virtual_keyboard_manager_v1")) {
+            m_virtualKeyboardManager = new VirtualKeyboardManager();
+            m_virtualKeyboardManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy seatSpy(registry, &KWayland::Client::Registry::seatAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_virtualKeyboardManager);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+    m_clientSeat = registry->createSeat(seatSpy.first().first().value<quint32>(), seatSpy.first().last().value<quint32>(), this);
+    QSignalSpy hasKeyboardSpy(m_clientSeat, &KWayland::Client::Seat::hasKeyboardChanged);
+    QVERIFY(hasKeyboardSpy.wait());
+    m_clientKeyboard = m_clientSeat->createKeyboard(this);
+    QVERIFY(m_clientKeyboard->isValid());
+
+    // the keys go to the focused surface
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    m_clientSurface = m_clientCompositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    QSignalSpy enteredSpy(m_clientKeyboard, &KWayland::Client::Keyboard::entered);
+    m_seat->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<SurfaceInterface *>());
+    QVERIFY(enteredSpy.wait());
+}
+
+TestVirtualKeyboardV1Interface::~TestVirtualKeyboardV1Interface()
+{
+    delete m_virtualKeyboardManager;
+    m_virtualKeyboardManager = nullptr;
+    delete m_clientSurface;
+    m_clientSurface = nullptr;
+    delete m_clientKeyboard;
+    m_clientKeyboard = nullptr;
+    delete m_clientSeat;
+    m_clientSeat = nullptr;
+    delete m_clientCompositor;
+    m_clientCompositor = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+VirtualKeyboardV1Interface *TestVirtualKeyboardV1Interface::createVirtualKeyboard(QScopedPointer<VirtualKeyboard> &keyboard, const QByteArray &keymap)
+{
+    QSignalSpy createdSpy(m_virtualKeyboardManagerInterface, &VirtualKeyboardManagerV1Interface::virtualKeyboardCreated);
+    keyboard.reset(new VirtualKeyboard(m_virtualKeyboardManager->create_virtual_keyboard(*m_clientSeat)));
+    if (!createdSpy.wait()) {
+        return nullptr;
+    }
+    auto serverKeyboard = createdSpy.first().first().value<VirtualKeyboardV1Interface *>();
+    QSignalSpy keymapChangedSpy(serverKeyboard, &VirtualKeyboardV1Interface::keymapChanged);
+    if (!keyboard->setKeymap(keymap) || !keymapChangedSpy.wait()) {
+        return nullptr;
+    }
+    return serverKeyboard;
+}
+
+void TestVirtualKeyboardV1Interface::testKeys()
+{
+    QSignalSpy physicalKeymapSpy(m_clientKeyboard, &KWayland::Client::Keyboard::keymapContentChanged);
+    m_seat->keyboard()->setKeymap(QByteArrayLiteral("physical"));
+    QVERIFY(physicalKeymapSpy.wait());
+
+    QScopedPointer<VirtualKeyboard> keyboard;
+    VirtualKeyboardV1Interface *serverKeyboard = createVirtualKeyboard(keyboard, QByteArrayLiteral("osk"));
+    QVERIFY(serverKeyboard);
+    QCOMPARE(serverKeyboard->seat(), m_seat);
+    QCOMPARE(serverKeyboard->keymap(), QByteArrayLiteral("osk"));
+
+    // the first key switches the seat to the keymap of the virtual keyboard
+    QSignalSpy keymapSpy(m_clientKeyboard, &KWayland::Client::Keyboard::keymapContentChanged);
+    QSignalSpy keySpy(m_clientKeyboard, &KWayland::Client::Keyboard::keyChanged);
+    QSignalSpy modifiersSpy(m_clientKeyboard, &KWayland::Client::Keyboard::modifiersChanged);
+    keyboard->key(1, KEY_A, WL_KEYBOARD_KEY_STATE_PRESSED);
+    keyboard->key(2, KEY_A, WL_KEYBOARD_KEY_STATE_RELEASED);
+    keyboard->modifiers(1, 0, 2, 0);
+    QVERIFY(modifiersSpy.wait());
+    QCOMPARE(keymapSpy.count(), 1);
+    QCOMPARE(keymapSpy.first().first().toByteArray(), QByteArrayLiteral("osk"));
+    QCOMPARE(keySpy.count(), 2);
+    QCOMPARE(keySpy[0][0].value<quint32>(), quint32(KEY_A));
+    QCOMPARE(keySpy[0][1].value<KWayland::Client::Keyboard::KeyState>(), KWayland::Client::Keyboard::KeyState::Pressed);
+    QCOMPARE(keySpy[1][1].value<KWayland::Client::Keyboard::KeyState>(), KWayland::Client::Keyboard::KeyState::Released);
+    QCOMPARE(modifiersSpy.first()[0].value<quint32>(), 1u);
+    QCOMPARE(modifiersSpy.first()[2].value<quint32>(), 2u);
+
+    // later keys don't send the keymap again
+    keyboard->key(3, KEY_B, WL_KEYBOARD_KEY_STATE_PRESSED);
+    keyboard->key(4, KEY_B, WL_KEYBOARD_KEY_STATE_RELEASED);
+    QVERIFY(keySpy.wait());
+    if (keySpy.count() < 4) {
+        QVERIFY(keySpy.wait());
+    }
+    QCOMPARE(keymapSpy.count(), 1);
+}
+
+void TestVirtualKeyboardV1Interface::testSharedKeymap()
+{
+    QSignalSpy physicalKeymapSpy(m_clientKeyboard, &KWayland::Client::Keyboard::keymapContentChanged);
+    m_seat->keyboard()->setKeymap(QByteArrayLiteral("physical"));
+    QVERIFY(physicalKeymapSpy.wait());
+
+    // the keyboards use the same layout, switching between them doesn't change the keymap
+    QScopedPointer<VirtualKeyboard> first;
+    QVERIFY(createVirtualKeyboard(first, QByteArrayLiteral("shared")));
+    QScopedPointer<VirtualKeyboard> second;
+    QVERIFY(createVirtualKeyboard(second, QByteArrayLiteral("shared")));
+
+    QSignalSpy keymapSpy(m_clientKeyboard, &KWayland::Client::Keyboard::keymapContentChanged);
+    QSignalSpy keySpy(m_clientKeyboard, &KWayland::Client::Keyboard::keyChanged);
+    first->key(1, KEY_A, WL_KEYBOARD_KEY_STATE_PRESSED);
+    first->key(2, KEY_A, WL_KEYBOARD_KEY_STATE_RELEASED);
+    second->key(3, KEY_B, WL_KEYBOARD_KEY_STATE_PRESSED);
+    second->key(4, KEY_B, WL_KEYBOARD_KEY_STATE_RELEASED);
+    while (keySpy.count() < 4) {
+        QVERIFY(keySpy.wait());
+    }
+    QCOMPARE(keymapSpy.count(), 1);
+    QCOMPARE(keymapSpy.first().first().toByteArray(), QByteArrayLiteral("shared"));
+}
+
+void TestVirtualKeyboardV1Interface::testReleaseOnDestroy()
+{
+    QScopedPointer<VirtualKeyboard> keyboard;
+    VirtualKeyboardV1Interface *serverKeyboard = createVirtualKeyboard(keyboard, QByteArrayLiteral("osk"));
+    QVERIFY(serverKeyboard);
+
+    QSignalSpy keySpy(m_clientKeyboard, &KWayland::Client::Keyboard::keyChanged);
+    keyboard->key(1, KEY_LEFTSHIFT, WL_KEYBOARD_KEY_STATE_PRESSED);
+    QVERIFY(keySpy.wait());
+
+    // the keys still held by a destroyed virtual keyboard get released
+    QSignalSpy destroyedSpy(serverKeyboard, &QObject::destroyed);
+    keyboard.reset();
+    QVERIFY(destroyedSpy.wait());
+    QVERIFY(keySpy.count() == 2 || keySpy.wait());
+    QCOMPARE(keySpy.last()[0].value<quint32>(), quint32(KEY_LEFTSHIFT));
+    QCOMPARE(keySpy.last()[1].value<KWayland::Client::Keyboard::KeyState>(), KWayland::Client::Keyboard::KeyState::Released);
+}
+
+void TestVirtualKeyboardV1Interface::testRestoreSeatKeyboard()
+{
+    QSignalSpy keymapSpy(m_clientKeyboard, &KWayland::Client::Keyboard::keymapContentChanged);
+    QSignalSpy modifiersSpy(m_clientKeyboard, &KWayland::Client::Keyboard::modifiersChanged);
+    m_seat->keyboard()->setKeymap(QByteArrayLiteral("physical"));
+    m_seat->notifyKeyboardModifiers(0, 0, 16, 0);
+    QVERIFY(modifiersSpy.wait());
+    QCOMPARE(keymapSpy.last().first().toByteArray(), QByteArrayLiteral("physical"));
+
+    QScopedPointer<VirtualKeyboard> keyboard;
+    QVERIFY(createVirtualKeyboard(keyboard, QByteArrayLiteral("osk")));
+    keymapSpy.clear();
+    modifiersSpy.clear();
+    QSignalSpy keySpy(m_clientKeyboard, &KWayland::Client::Keyboard::keyChanged);
+    keyboard->modifiers(1, 0, 2, 0);
+    keyboard->key(1, KEY_A, WL_KEYBOARD_KEY_STATE_PRESSED);
+    keyboard->key(2, KEY_A, WL_KEYBOARD_KEY_STATE_RELEASED);
+    while (keySpy.count() < 2) {
+        QVERIFY(keySpy.wait());
+    }
+    QCOMPARE(keymapSpy.count(), 1);
+    QCOMPARE(keymapSpy.last().first().toByteArray(), QByteArrayLiteral("osk"));
+    QCOMPARE(modifiersSpy.count(), 1);
+    QCOMPARE(modifiersSpy.last()[0].value<quint32>(), 1u);
+
+    // the next key of the seat is interpreted with its own keymap and modifiers again
+    m_seat->notifyKeyboardKey(KEY_C, KeyboardKeyState::Pressed);
+    m_seat->notifyKeyboardKey(KEY_C, KeyboardKeyState::Released);
+    while (keySpy.count() < 4) {
+        QVERIFY(keySpy.wait());
+    }
+    QCOMPARE(keymapSpy.count(), 2);
+    QCOMPARE(keymapSpy.last().first().toByteArray(), QByteArrayLiteral("physical"));
+    QCOMPARE(modifiersSpy.count(), 2);
+    QCOMPARE(modifiersSpy.last()[0].value<quint32>(), 0u);
+    QCOMPARE(modifiersSpy.last()[2].value<quint32>(), 16u);
+    QCOMPARE(keySpy.last()[0].value<quint32>(), quint32(KEY_C));
+
+    // and further keys of the seat don't resend anything
+    m_seat->notifyKeyboardKey(KEY_D, KeyboardKeyState::Pressed);
+    m_seat->notifyKeyboardKey(KEY_D, KeyboardKeyState::Released);
+    while (keySpy.count() < 6) {
+        QVERIFY(keySpy.wait());
+    }
+    QCOMPARE(keymapSpy.count(), 2);
+    QCOMPARE(modifiersSpy.count(), 2);
+}
+
+void TestVirtualKeyboardV1Interface::testKeymapTooSmall()
+{
+    QSignalSpy createdSpy(m_virtualKeyboardManagerInterface, &VirtualKeyboardManagerV1Interface::virtualKeyboardCreated);
+    QScopedPointer<VirtualKeyboard> keyboard(new VirtualKeyboard(m_virtualKeyboardManager->create_virtual_keyboard(*m_clientSeat)));
+    QVERIFY(createdSpy.wait());
+    auto serverKeyboard = createdSpy.first().first().value<VirtualKeyboardV1Interface *>();
+    QSignalSpy keymapChangedSpy(serverKeyboard, &VirtualKeyboardV1Interface::keymapChanged);
+
+    // a size beyond the end of the file is refused instead of being mapped
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    QVERIFY(keyboard->setKeymap(QByteArrayLiteral("osk"), 4096));
+    QVERIFY(errorSpy.wait());
+    QVERIFY(keymapChangedSpy.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestVirtualKeyboardV1Interface)
+#include "test_virtualkeyboard.moc"
@@ -5,7 +5,10 @@
 */
 #include "buffer.h"
 #include "buffer_p.h"
+#include "dmabuf_pool.h"
 #include "shm_pool.h"
+// Qt
+#include <QImage>
 // system
 #include <string.h>
 // wayland
@@ -33,6 +36,21 @@ Buffer::Private::Private(Buffer *q, ShmPool *parent, wl_buffer *nativeBuffer, co
     wl_buffer_add_listener(nativeBuffer, &s_listener, this);
 }
 
+Buffer::Private::Private(Buffer *q, DmaBufPool *parent, wl_buffer *nativeBuffer, gbm_bo *bo, const QSize &size, int32_t stride, Format format)
+    : dmaBufPool(parent)
+    , bo(bo)
+    , nativeBuffer(nativeBuffer)
+    , released(false)
+    , size(size)
+    , stride(stride)
+    , offset(0)
+    , used(false)
+    , format(format)
+    , q(q)
+{
+    wl_buffer_add_listener(nativeBuffer, &s_listener, this);
+}
+
 Buffer::Private::~Private()
 {
     nativeBuffer.release();
@@ -48,6 +66,11 @@ void Buffer::Private::releasedCallback(void *data, wl_buffer *buffer)
     auto b = reinterpret_cast<Buffer::Private *>(data);
     Q_ASSERT(b->nativeBuffer == buffer);
     b->q->setReleased(true);
+    if (b->shm) {
+        Q_EMIT b->shm->bufferReleased(b->q);
+    } else {
+        Q_EMIT b->dmaBufPool->bufferReleased(b->q);
+    }
 }
 
 Buffer::Buffer(ShmPool *parent, wl_buffer *buffer, const QSize &size, int32_t stride, size_t offset, Format format)
@@ -55,18 +78,42 @@ Buffer::Buffer(ShmPool *parent, wl_buffer *buffer, const QSize &size, int32_t st
 {
 }
 
+Buffer::Buffer(DmaBufPool *parent, wl_buffer *buffer, gbm_bo *bo, const QSize &size, int32_t stride, Format format)
+    : d(new Private(this, parent, buffer, bo, size, stride, format))
+{
+}
+
 Buffer::~Buffer() = default;
 
 void Buffer::copy(const void *src)
 {
-    memcpy(address(), src, d->size.height() * d->stride);
+    if (uchar *target = address()) {
+        memcpy(target, src, d->size.height() * d->stride);
+    }
 }
 
 uchar *Buffer::address()
 {
+    if (!d->shm) {
+        return nullptr;
+    }
     return reinterpret_cast<uchar *>(d->shm->poolAddress()) + d->offset;
 }
 
+QImage Buffer::image()
+{
+    if (!d->shm) {
+        return QImage();
+    }
+    const QImage::Format imageFormat = d->format == Format::RGB32 ? QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied;
+    return QImage(address(), d->size.width(), d->size.height(), d->stride, imageFormat);
+}
+
+gbm_bo *Buffer::bo() const
+{
+    return d->bo;
+}
+
 wl_buffer *Buffer::buffer() const
 {
     return d->nativeBuffer;
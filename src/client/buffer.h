@@ -12,20 +12,24 @@
 
 #include <DWayland/Client/kwaylandclient_export.h>
 
+struct gbm_bo;
 struct wl_buffer;
+class QImage;
 
 namespace KWayland
 {
 namespace Client
 {
+class DmaBufPool;
 class ShmPool;
 
 /**
  * @short Wrapper class for wl_buffer interface.
  *
- * The Buffer is provided by ShmPool and is owned by ShmPool.
+ * The Buffer is provided by ShmPool or DmaBufPool and is owned by it.
  *
  * @see ShmPool
+ * @see DmaBufPool
  **/
 class KWAYLANDCLIENT_EXPORT Buffer
 {
@@ -82,9 +86,25 @@ public:
      **/
     bool isUsed() const;
     /**
-     * @returns the memory address of this Buffer.
+     * @returns the memory address of this Buffer, @c null if it was provided by a DmaBufPool.
      **/
     uchar *address();
+    /**
+     * @returns A QImage sharing the memory of this Buffer, so that it can be painted into directly
+     * without an intermediate copy. The QImage format is QImage::Format_ARGB32_Premultiplied for
+     * Format::ARGB32 and QImage::Format_RGB32 for Format::RGB32.
+     *
+     * The returned QImage is only valid as long as the pool doesn't get resized, see
+     * ShmPool::poolResized. The Buffer should be marked as used while the QImage is alive.
+     * A Buffer provided by a DmaBufPool returns a null QImage.
+     * @see setUsed
+     **/
+    QImage image();
+    /**
+     * @returns The GBM buffer object of a Buffer provided by a DmaBufPool, to be imported into
+     * the graphics API the client renders with, or @c null for a shared memory Buffer.
+     **/
+    gbm_bo *bo() const;
     /**
      * @returns The image format used by this Buffer.
      **/
@@ -103,7 +123,9 @@ public:
 
 private:
     friend class ShmPool;
+    friend class DmaBufPool;
     explicit Buffer(ShmPool *parent, wl_buffer *buffer, const QSize &size, int32_t stride, size_t offset, Format format);
+    explicit Buffer(DmaBufPool *parent, wl_buffer *buffer, gbm_bo *bo, const QSize &size, int32_t stride, Format format);
     class Private;
     QScopedPointer<Private> d;
 };
@@ -18,10 +18,14 @@ class Q_DECL_HIDDEN Buffer::Private
 {
 public:
     Private(Buffer *q, ShmPool *parent, wl_buffer *nativeBuffer, const QSize &size, int32_t stride, size_t offset, Format format);
+    Private(Buffer *q, DmaBufPool *parent, wl_buffer *nativeBuffer, gbm_bo *bo, const QSize &size, int32_t stride, Format format);
     ~Private();
     void destroy();
 
-    ShmPool *shm;
+    ShmPool *shm = nullptr;
+    DmaBufPool *dmaBufPool = nullptr;
+    // owned by the DmaBufPool, which destroys it along with the Buffer
+    gbm_bo *bo = nullptr;
     WaylandPointer<wl_buffer, wl_buffer_destroy> nativeBuffer;
     bool released;
     QSize size;
@@ -24,10 +24,28 @@ class Q_DECL_HIDDEN Compositor::Private
 public:
     Private() = default;
 
+    void clearRegionCache(bool destroy);
+
     WaylandPointer<wl_compositor, wl_compositor_destroy> compositor;
     EventQueue *queue = nullptr;
+    // the most recently used first
+    QVector<Region *> regionCache;
 };
 
+// enough for a few surfaces with alternating opaque and input regions
+static const int s_regionCacheSize = 8;
+
+void Compositor::Private::clearRegionCache(bool destroy)
+{
+    for (Region *region : qAsConst(regionCache)) {
+        if (destroy) {
+            region->destroy();
+        }
+        delete region;
+    }
+    regionCache.clear();
+}
+
 Compositor::Compositor(QObject *parent)
     : QObject(parent)
     , d(new Private)
@@ -63,11 +81,13 @@ void Compositor::setup(wl_compositor *compositor)
 
 void Compositor::release()
 {
+    d->clearRegionCache(false);
     d->compositor.release();
 }
 
 void Compositor::destroy()
 {
+    d->clearRegionCache(true);
     d->compositor.destroy();
 }
 
@@ -90,6 +110,7 @@ Surface *Compositor::createSurface(QObject *parent)
         d->queue->addProxy(w);
     }
     s->setup(w);
+    s->setCompositor(this);
     return s;
 }
 
@@ -115,6 +136,23 @@ std::unique_ptr<Region> Compositor::createRegion(const QRegion &region)
     return std::unique_ptr<Region>(createRegion(region, nullptr));
 }
 
+const Region *Compositor::cachedRegion(const QRegion &region)
+{
+    for (int i = 0; i < d->regionCache.count(); ++i) {
+        Region *cached = d->regionCache.at(i);
+        if (cached->region() == region) {
+            d->regionCache.move(i, 0);
+            return cached;
+        }
+    }
+    if (d->regionCache.count() == s_regionCacheSize) {
+        delete d->regionCache.takeLast();
+    }
+    Region *created = createRegion(region, nullptr);
+    d->regionCache.prepend(created);
+    return created;
+}
+
 Compositor::operator wl_compositor *()
 {
     return d->compositor;
@@ -154,6 +154,17 @@ public:
      * @returns The new created Region
      **/
     std::unique_ptr<Region> createRegion(const QRegion &region);
+    /**
+     * Returns a Region with @p region installed, which is owned by the Compositor.
+     *
+     * The Compositor keeps the Regions of the most recently used regions, an identical
+     * @p region reuses the existing Region instead of creating a new one. The returned
+     * Region must not be modified and is only valid until the next call.
+     *
+     * @see Surface::setInputRegion
+     * @see Surface::setOpaqueRegion
+     **/
+    const Region *cachedRegion(const QRegion &region);
 
     operator wl_compositor *();
     operator wl_compositor *() const;
@@ -4,49 +4,35 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "connection_thread.h"
+#include "connection_thread_p.h"
 #include "logging.h"
 // Qt
 #include <QAbstractEventDispatcher>
 #include <QDebug>
 #include <QDir>
-#include <QFileSystemWatcher>
+#include <QFileInfo>
 #include <QGuiApplication>
-#include <QMutex>
 #include <QMutexLocker>
+#include <QPointer>
 #include <QSocketNotifier>
+#include <QTimer>
 #include <qpa/qplatformnativeinterface.h>
 // Wayland
 #include <wayland-client-protocol.h>
+// system
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
 namespace KWayland
 {
 namespace Client
 {
-class Q_DECL_HIDDEN ConnectionThread::Private
-{
-public:
-    Private(ConnectionThread *q);
-    ~Private();
-    void doInitConnection();
-    void setupSocketNotifier();
-    void setupSocketFileWatcher();
-
-    wl_display *display = nullptr;
-    int fd = -1;
-    QString socketName;
-    QDir runtimeDir;
-    QScopedPointer<QSocketNotifier> socketNotifier;
-    QScopedPointer<QFileSystemWatcher> socketWatcher;
-    bool serverDied = false;
-    bool foreign = false;
-    QMetaObject::Connection eventDispatcherConnection;
-    int error = 0;
-    static QVector<ConnectionThread *> connections;
-    static QRecursiveMutex mutex;
-
-private:
-    ConnectionThread *q;
-};
+// the socket file is created before the server listens on it, a reconnect can come too early
+static const int s_reconnectAttempts = 10;
+static const int s_reconnectInterval = 20;
 
 QVector<ConnectionThread *> ConnectionThread::Private::connections = QVector<ConnectionThread *>{};
 QRecursiveMutex ConnectionThread::Private::mutex;
@@ -71,6 +57,10 @@ ConnectionThread::Private::~Private()
         QMutexLocker lock(&mutex);
         connections.removeOne(q);
     }
+    socketCreatedNotifier.reset();
+    if (inotifyFd != -1) {
+        close(inotifyFd);
+    }
     if (display && !foreign) {
         wl_display_flush(display);
         wl_display_disconnect(display);
@@ -79,12 +69,7 @@ ConnectionThread::Private::~Private()
 
 void ConnectionThread::Private::doInitConnection()
 {
-    if (fd != -1) {
-        display = wl_display_connect_to_fd(fd);
-    } else {
-        display = wl_display_connect(socketName.toUtf8().constData());
-    }
-    if (!display) {
+    if (!connectToServer()) {
         qCWarning(KWAYLAND_CLIENT) << "Failed connecting to Wayland display";
         Q_EMIT q->failed();
         return;
@@ -97,85 +82,288 @@ void ConnectionThread::Private::doInitConnection()
 
     // setup socket notifier
     setupSocketNotifier();
-    setupSocketFileWatcher();
     Q_EMIT q->connected();
 }
 
+bool ConnectionThread::Private::connectToServer()
+{
+    if (fd != -1) {
+        display = wl_display_connect_to_fd(fd);
+        return display;
+    }
+    if (socketPath.isEmpty()) {
+        // the same lookup as wl_display_connect, done once so that a reconnect neither
+        // depends on the environment nor searches for the socket again
+        if (QDir::isAbsolutePath(socketName)) {
+            socketPath = socketName;
+        } else if (runtimeDir.exists()) {
+            socketPath = runtimeDir.absoluteFilePath(socketName);
+        }
+    }
+    display = wl_display_connect(socketPath.isEmpty() ? socketName.toUtf8().constData() : QFile::encodeName(socketPath).constData());
+    return display;
+}
+
 void ConnectionThread::Private::setupSocketNotifier()
 {
-    const int fd = wl_display_get_fd(display);
-    socketNotifier.reset(new QSocketNotifier(fd, QSocketNotifier::Read));
+    const int displayFd = wl_display_get_fd(display);
+    writeBlocked.storeRelease(0);
+    writeNotifier.reset(new QSocketNotifier(displayFd, QSocketNotifier::Write));
+    writeNotifier->setEnabled(false);
+    QObject::connect(writeNotifier.data(), &QSocketNotifier::activated, q, [this]() {
+        retryFlush();
+    });
+    socketNotifier.reset(new QSocketNotifier(displayFd, QSocketNotifier::Read));
     QObject::connect(socketNotifier.data(), &QSocketNotifier::activated, q, [this]() {
         if (!display) {
             return;
         }
-        if (wl_display_dispatch(display) == -1) {
+        if (!readEvents()) {
             error = wl_display_get_error(display);
             if (error != 0) {
                 if (display) {
                     free(display);
                     display = nullptr;
                 }
+                // a hangup of the socket reports the server going away, no matter what
+                // happens to the socket file. Connections over a passed file descriptor can't reconnect
+                const bool hungUp = this->fd == -1 && (error == EPIPE || error == ECONNRESET);
+                QPointer<ConnectionThread> guard(q);
                 Q_EMIT q->errorOccurred();
+                if (guard && hungUp) {
+                    serverGone();
+                }
                 return;
             }
         }
+        wakeUpQueues();
         Q_EMIT q->eventsRead();
     });
 }
 
-void ConnectionThread::Private::setupSocketFileWatcher()
+bool ConnectionThread::Private::readEvents()
 {
-    if (!runtimeDir.exists() || fd != -1) {
+    // events which are already queued have to be dispatched before a read can be prepared
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) == -1) {
+            return false;
+        }
+    }
+    flush();
+    // the socket notifier reported the socket as readable, so unlike wl_display_dispatch
+    // there is no need to poll before reading. The read events get distributed to their
+    // queues, the default queue is dispatched right away
+    if (wl_display_read_events(display) == -1) {
+        return false;
+    }
+    return wl_display_dispatch_pending(display) != -1;
+}
+
+void ConnectionThread::Private::flush()
+{
+    if (!display || writeBlocked.loadAcquire()) {
         return;
     }
-    socketWatcher.reset(new QFileSystemWatcher);
-    socketWatcher->addPath(runtimeDir.absoluteFilePath(socketName));
-    QObject::connect(socketWatcher.data(), &QFileSystemWatcher::fileChanged, q, [this](const QString &file) {
-        if (QFile::exists(file) || serverDied) {
-            return;
+    const int bytes = wl_display_flush(display);
+    if (bytes > 0) {
+        flushedBytes.fetchAndAddRelaxed(bytes);
+        flushCount.fetchAndAddRelaxed(1);
+        return;
+    }
+    if (bytes == -1 && errno == EAGAIN && writeNotifier && writeBlocked.testAndSetOrdered(0, 1)) {
+        // the socket buffer is full, wait for the server to catch up instead of trying again
+        // on every iteration of the event loop
+        QMetaObject::invokeMethod(
+            q,
+            [this] {
+                if (writeNotifier) {
+                    writeNotifier->setEnabled(true);
+                }
+            },
+            Qt::AutoConnection);
+    }
+}
+
+void ConnectionThread::Private::retryFlush()
+{
+    writeNotifier->setEnabled(false);
+    writeBlocked.storeRelease(0);
+    flush();
+}
+
+void ConnectionThread::Private::flushOnAboutToBlock(QAbstractEventDispatcher *dispatcher)
+{
+    if (!dispatcher) {
+        return;
+    }
+    QMutexLocker lock(&flushHooksMutex);
+    if (flushHooks.contains(dispatcher)) {
+        return;
+    }
+    flushHooks.insert(dispatcher, QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, q, [this] {
+        flush();
+    }, Qt::DirectConnection));
+    QObject::connect(dispatcher, &QObject::destroyed, q, [this, dispatcher] {
+        QMutexLocker lock(&flushHooksMutex);
+        flushHooks.remove(dispatcher);
+    }, Qt::DirectConnection);
+}
+
+void ConnectionThread::Private::wakeUpQueues()
+{
+    // an eventfd accumulates the writes, a queue which is still busy gets woken up only once
+    const quint64 value = 1;
+    QMutexLocker lock(&wakeupMutex);
+    for (const QueueWakeup &wakeup : qAsConst(queueWakeups)) {
+        if (!hasPendingEvents(display, wakeup.queue)) {
+            continue;
         }
-        qCWarning(KWAYLAND_CLIENT) << "Connection to server went away";
-        serverDied = true;
-        if (display) {
-            free(display);
-            display = nullptr;
+        if (write(wakeup.fd, &value, sizeof(value)) != sizeof(value) && errno != EAGAIN) {
+            qCWarning(KWAYLAND_CLIENT) << "Failed to wake up event queue:" << strerror(errno);
         }
-        socketNotifier.reset();
+    }
+}
 
-        // need a new filesystem watcher
-        socketWatcher.reset(new QFileSystemWatcher);
-        socketWatcher->addPath(runtimeDir.absolutePath());
-        QObject::connect(socketWatcher.data(), &QFileSystemWatcher::directoryChanged, q, [this]() {
-            if (!serverDied) {
-                return;
-            }
-            if (runtimeDir.exists(socketName)) {
-                qCDebug(KWAYLAND_CLIENT) << "Socket reappeared";
-                socketWatcher.reset();
-                serverDied = false;
-                error = 0;
-                q->initConnection();
-            }
-        });
-        Q_EMIT q->connectionDied();
+bool ConnectionThread::Private::hasPendingEvents(wl_display *display, wl_event_queue *queue)
+{
+    // preparing a read only succeeds for a queue without events, the read is not needed
+    if (wl_display_prepare_read_queue(display, queue) == 0) {
+        wl_display_cancel_read(display);
+        return false;
+    }
+    return true;
+}
+
+void ConnectionThread::Private::addQueueWakeup(int fd, wl_event_queue *queue)
+{
+    QMutexLocker lock(&wakeupMutex);
+    queueWakeups.append({fd, queue});
+}
+
+void ConnectionThread::Private::removeQueueWakeup(int fd)
+{
+    QMutexLocker lock(&wakeupMutex);
+    queueWakeups.erase(std::remove_if(queueWakeups.begin(),
+                                      queueWakeups.end(),
+                                      [fd](const QueueWakeup &wakeup) {
+                                          return wakeup.fd == fd;
+                                      }),
+                       queueWakeups.end());
+}
+
+void ConnectionThread::Private::serverGone()
+{
+    qCWarning(KWAYLAND_CLIENT) << "Connection to server went away";
+    serverDied = true;
+    // called from the socket notifier, it can't be deleted right away
+    socketNotifier->setEnabled(false);
+    socketNotifier.take()->deleteLater();
+    writeNotifier.reset();
+    writeBlocked.storeRelease(0);
+    watchForSocket();
+    Q_EMIT q->connectionDied();
+}
+
+void ConnectionThread::Private::watchForSocket()
+{
+    if (socketPath.isEmpty()) {
+        return;
+    }
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd == -1) {
+        qCWarning(KWAYLAND_CLIENT) << "Failed to watch for the Wayland socket:" << strerror(errno);
+        return;
+    }
+    // only the directory can be watched for a file to be created, the events are filtered
+    // by the name of the socket and only arrive while the server is gone
+    const QByteArray directory = QFile::encodeName(QFileInfo(socketPath).absolutePath());
+    if (inotify_add_watch(inotifyFd, directory.constData(), IN_CREATE | IN_MOVED_TO | IN_ONLYDIR) == -1) {
+        qCWarning(KWAYLAND_CLIENT) << "Failed to watch for the Wayland socket:" << strerror(errno);
+        close(inotifyFd);
+        inotifyFd = -1;
+        return;
+    }
+    socketCreatedNotifier.reset(new QSocketNotifier(inotifyFd, QSocketNotifier::Read));
+    QObject::connect(socketCreatedNotifier.data(), &QSocketNotifier::activated, q, [this]() {
+        if (readSocketCreated()) {
+            qCDebug(KWAYLAND_CLIENT) << "Socket reappeared";
+            reconnectAttempts = 0;
+            reconnect();
+        }
     });
+    if (QFileInfo::exists(socketPath)) {
+        // the server got restarted before the watch was added
+        QMetaObject::invokeMethod(
+            q,
+            [this] {
+                if (serverDied && !display) {
+                    reconnect();
+                }
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void ConnectionThread::Private::stopWatchingForSocket()
+{
+    if (socketCreatedNotifier) {
+        socketCreatedNotifier->setEnabled(false);
+        socketCreatedNotifier.take()->deleteLater();
+    }
+    if (inotifyFd != -1) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+}
+
+bool ConnectionThread::Private::readSocketCreated()
+{
+    const QByteArray name = QFile::encodeName(QFileInfo(socketPath).fileName());
+    alignas(inotify_event) char buffer[4096];
+    bool created = false;
+    ssize_t size;
+    while ((size = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char *it = buffer; it < buffer + size;) {
+            const auto event = reinterpret_cast<const inotify_event *>(it);
+            if (event->len > 0 && name == event->name) {
+                created = true;
+            }
+            it += sizeof(inotify_event) + event->len;
+        }
+    }
+    return created;
+}
+
+void ConnectionThread::Private::reconnect()
+{
+    if (!connectToServer()) {
+        if (++reconnectAttempts < s_reconnectAttempts) {
+            QTimer::singleShot(s_reconnectInterval, q, [this] {
+                if (serverDied && !display) {
+                    reconnect();
+                }
+            });
+            return;
+        }
+        qCWarning(KWAYLAND_CLIENT) << "Failed reconnecting to Wayland display";
+        stopWatchingForSocket();
+        serverDied = false;
+        Q_EMIT q->failed();
+        return;
+    }
+    qCDebug(KWAYLAND_CLIENT) << "Reconnected to Wayland server at:" << socketPath;
+    stopWatchingForSocket();
+    serverDied = false;
+    error = 0;
+    setupSocketNotifier();
+    Q_EMIT q->connected();
 }
 
 ConnectionThread::ConnectionThread(QObject *parent)
     : QObject(parent)
     , d(new Private(this))
 {
-    d->eventDispatcherConnection = connect(
-        QCoreApplication::eventDispatcher(),
-        &QAbstractEventDispatcher::aboutToBlock,
-        this,
-        [this] {
-            if (d->display) {
-                wl_display_flush(d->display);
-            }
-        },
-        Qt::DirectConnection);
+    d->flushOnAboutToBlock(QCoreApplication::eventDispatcher());
 }
 
 ConnectionThread::ConnectionThread(wl_display *display, QObject *parent)
@@ -188,7 +376,10 @@ ConnectionThread::ConnectionThread(wl_display *display, QObject *parent)
 
 ConnectionThread::~ConnectionThread()
 {
-    disconnect(d->eventDispatcherConnection);
+    QMutexLocker lock(&d->flushHooksMutex);
+    for (const QMetaObject::Connection &connection : qAsConst(d->flushHooks)) {
+        disconnect(connection);
+    }
 }
 
 ConnectionThread *ConnectionThread::fromApplication(QObject *parent)
@@ -223,6 +414,7 @@ void ConnectionThread::setSocketName(const QString &socketName)
         return;
     }
     d->socketName = socketName;
+    d->socketPath.clear();
 }
 
 void ConnectionThread::setSocketFd(int fd)
@@ -246,10 +438,17 @@ QString ConnectionThread::socketName() const
 
 void ConnectionThread::flush()
 {
-    if (!d->display) {
-        return;
-    }
-    wl_display_flush(d->display);
+    d->flush();
+}
+
+quint64 ConnectionThread::flushedBytes() const
+{
+    return d->flushedBytes.loadRelaxed();
+}
+
+quint64 ConnectionThread::flushCount() const
+{
+    return d->flushCount.loadRelaxed();
 }
 
 void ConnectionThread::roundtrip()
@@ -73,10 +73,12 @@ namespace Client
  *
  * This class is also responsible for dispatching events. Whenever new data is available on
  * the Wayland socket, it will be dispatched and the signal @link ::eventsRead @endlink is emitted.
- * This allows further event queues in other threads to also dispatch their events.
+ * This allows further event queues in other threads to also dispatch their events. An EventQueue
+ * set up for the ConnectionThread gets woken up directly through an eventfd in its own thread.
  *
  * Furthermore this class flushes the Wayland connection whenever the QAbstractEventDispatcher
- * is about to block.
+ * is about to block. That is also done for the threads of all EventQueues set up for it, so
+ * there is one flush per event loop iteration.
  *
  * To disconnect the connection to the Wayland server one should delete the instance of this
  * class and quit the dedicated thread:
@@ -203,9 +205,21 @@ public Q_SLOTS:
 
     /**
      * Explicitly flush the Wayland display.
+     * If the socket buffer of the connection is full the flush is completed once the
+     * socket becomes writable again.
      * @since 5.3
      **/
     void flush();
+    /**
+     * @returns The number of bytes written to the Wayland socket by flushing so far.
+     * @see flushCount
+     **/
+    quint64 flushedBytes() const;
+    /**
+     * @returns The number of flushes which wrote data to the Wayland socket so far.
+     * @see flushedBytes
+     **/
+    quint64 flushCount() const;
 
 Q_SIGNALS:
     /**
@@ -223,8 +237,11 @@ Q_SIGNALS:
      **/
     void eventsRead();
     /**
-     * Emitted if the Wayland server connection dies.
-     * If the socket reappears, it is tried to reconnect.
+     * Emitted if the Wayland server connection dies, i.e. the server hung up on the socket.
+     * If the socket reappears, it is tried to reconnect and connected gets emitted again.
+     * The interfaces have to be bound again on the new connection, with
+     * Registry::requestInterface and Registry::whenRequestedInterfacesReady this doesn't
+     * need a blocking roundtrip.
      **/
     void connectionDied();
     /**
@@ -0,0 +1,114 @@
+/*
+    SPDX-FileCopyrightText: 2014 Martin Gräßlin <mgraesslin@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef WAYLAND_CONNECTION_THREAD_P_H
+#define WAYLAND_CONNECTION_THREAD_P_H
+#include "connection_thread.h"
+// Qt
+#include <QAtomicInteger>
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QSocketNotifier>
+
+class QAbstractEventDispatcher;
+
+struct wl_display;
+struct wl_event_queue;
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN ConnectionThread::Private
+{
+public:
+    Private(ConnectionThread *q);
+    ~Private();
+    void doInitConnection();
+    /**
+     * Connects to the server, either over the file descriptor or at the socket path which is
+     * resolved on the first connect.
+     **/
+    bool connectToServer();
+    void setupSocketNotifier();
+    /**
+     * Called once the server hung up on the connection. Waits for the socket to reappear in
+     * order to reconnect.
+     **/
+    void serverGone();
+    void watchForSocket();
+    void stopWatchingForSocket();
+    /**
+     * Reads the pending inotify events, @returns whether one of them is about the socket.
+     **/
+    bool readSocketCreated();
+    void reconnect();
+    bool readEvents();
+    void wakeUpQueues();
+    /**
+     * Flushes the display. If the socket buffer is full the flush is retried once the socket
+     * becomes writable again, until then further flushes are skipped. Thread-safe.
+     **/
+    void flush();
+    void retryFlush();
+    /**
+     * Flushes the display whenever @p dispatcher is about to block. Every dispatcher gets
+     * hooked only once, so this can be called for each dispatch. Thread-safe.
+     **/
+    void flushOnAboutToBlock(QAbstractEventDispatcher *dispatcher);
+
+    /**
+     * Registers the eventfd @p fd of the EventQueue for @p queue. Whenever events for
+     * @p queue got read from the Wayland socket @p fd gets signalled, so that the thread of
+     * the EventQueue can dispatch them. Queues without events are not woken up.
+     **/
+    void addQueueWakeup(int fd, wl_event_queue *queue);
+    void removeQueueWakeup(int fd);
+    /**
+     * @returns whether events got queued on @p queue which are not dispatched yet. Thread-safe.
+     **/
+    static bool hasPendingEvents(wl_display *display, wl_event_queue *queue);
+
+    static Private *get(ConnectionThread *connection)
+    {
+        return connection->d.data();
+    }
+
+    wl_display *display = nullptr;
+    int fd = -1;
+    QString socketName;
+    QString socketPath;
+    QDir runtimeDir;
+    QScopedPointer<QSocketNotifier> socketNotifier;
+    QScopedPointer<QSocketNotifier> writeNotifier;
+    int inotifyFd = -1;
+    QScopedPointer<QSocketNotifier> socketCreatedNotifier;
+    int reconnectAttempts = 0;
+    bool serverDied = false;
+    bool foreign = false;
+    QMutex flushHooksMutex;
+    QHash<QAbstractEventDispatcher *, QMetaObject::Connection> flushHooks;
+    QAtomicInt writeBlocked = 0;
+    QAtomicInteger<quint64> flushedBytes = 0;
+    QAtomicInteger<quint64> flushCount = 0;
+    int error = 0;
+    static QVector<ConnectionThread *> connections;
+    static QRecursiveMutex mutex;
+    struct QueueWakeup {
+        int fd;
+        wl_event_queue *queue;
+    };
+    QMutex wakeupMutex;
+    QVector<QueueWakeup> queueWakeups;
+
+private:
+    ConnectionThread *q;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "cursorshape.h"
+#include "event_queue.h"
+#include "pointer.h"
+#include "wayland_pointer_p.h"
+
+#include <wayland-cursor-shape-v1-client-protocol.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN CursorShapeManager::Private
+{
+public:
+    WaylandPointer<wp_cursor_shape_manager_v1, wp_cursor_shape_manager_v1_destroy> manager;
+    EventQueue *queue = nullptr;
+};
+
+CursorShapeManager::CursorShapeManager(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+CursorShapeManager::~CursorShapeManager()
+{
+    release();
+}
+
+void CursorShapeManager::setup(wp_cursor_shape_manager_v1 *manager)
+{
+    Q_ASSERT(manager);
+    Q_ASSERT(!d->manager);
+    d->manager.setup(manager);
+}
+
+void CursorShapeManager::release()
+{
+    d->manager.release();
+}
+
+void CursorShapeManager::destroy()
+{
+    d->manager.destroy();
+}
+
+CursorShapeManager::operator wp_cursor_shape_manager_v1 *()
+{
+    return d->manager;
+}
+
+CursorShapeManager::operator wp_cursor_shape_manager_v1 *() const
+{
+    return d->manager;
+}
+
+bool CursorShapeManager::isValid() const
+{
+    return d->manager.isValid();
+}
+
+void CursorShapeManager::setEventQueue(EventQueue *queue)
+{
+    d->queue = queue;
+}
+
+EventQueue *CursorShapeManager::eventQueue()
+{
+    return d->queue;
+}
+
+CursorShapeDevice *CursorShapeManager::createDevice(Pointer *pointer, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    auto p = new CursorShapeDevice(parent);
+    auto w = wp_cursor_shape_manager_v1_get_pointer(d->manager, *pointer);
+    if (d->queue) {
+        d->queue->addProxy(w);
+    }
+    p->setup(w);
+    return p;
+}
+
+class Q_DECL_HIDDEN CursorShapeDevice::Private
+{
+public:
+    WaylandPointer<wp_cursor_shape_device_v1, wp_cursor_shape_device_v1_destroy> device;
+};
+
+CursorShapeDevice::CursorShapeDevice(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+CursorShapeDevice::~CursorShapeDevice()
+{
+    release();
+}
+
+void CursorShapeDevice::setup(wp_cursor_shape_device_v1 *device)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(!d->device);
+    d->device.setup(device);
+}
+
+void CursorShapeDevice::release()
+{
+    d->device.release();
+}
+
+void CursorShapeDevice::destroy()
+{
+    d->device.destroy();
+}
+
+bool CursorShapeDevice::isValid() const
+{
+    return d->device.isValid();
+}
+
+void CursorShapeDevice::setShape(quint32 serial, Shape shape)
+{
+    Q_ASSERT(isValid());
+    wp_cursor_shape_device_v1_set_shape(d->device, serial, static_cast<uint32_t>(shape));
+}
+
+CursorShapeDevice::operator wp_cursor_shape_device_v1 *()
+{
+    return d->device;
+}
+
+CursorShapeDevice::operator wp_cursor_shape_device_v1 *() const
+{
+    return d->device;
+}
+
+}
+}
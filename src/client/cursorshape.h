@@ -0,0 +1,197 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_CURSORSHAPE_H
+#define WAYLAND_CURSORSHAPE_H
+
+#include <QObject>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+struct wp_cursor_shape_manager_v1;
+struct wp_cursor_shape_device_v1;
+
+namespace KWayland
+{
+namespace Client
+{
+class CursorShapeDevice;
+class EventQueue;
+class Pointer;
+
+/**
+ * @short Wrapper for the wp_cursor_shape_manager_v1 interface.
+ *
+ * The CursorShapeManager creates CursorShapeDevices, which set the cursor of a Pointer to a
+ * shape from the compositor's cursor theme instead of a cursor Surface. No cursor image has
+ * to be loaded, attached and committed by the client.
+ *
+ * To use this class one needs to interact with the Registry:
+ * @code
+ * CursorShapeManager *m = registry->createCursorShapeManager(name, version);
+ * @endcode
+ *
+ * @see Registry
+ **/
+class KWAYLANDCLIENT_EXPORT CursorShapeManager : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Creates a new CursorShapeManager.
+     * Note: after constructing the CursorShapeManager it is not yet valid and one needs
+     * to call setup. In order to get a ready to use CursorShapeManager prefer using
+     * Registry::createCursorShapeManager.
+     **/
+    explicit CursorShapeManager(QObject *parent = nullptr);
+    ~CursorShapeManager() override;
+
+    /**
+     * Setup this CursorShapeManager to manage the @p manager.
+     * When using Registry::createCursorShapeManager there is no need to call this
+     * method.
+     **/
+    void setup(wp_cursor_shape_manager_v1 *manager);
+    /**
+     * @returns @c true if managing a wp_cursor_shape_manager_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_cursor_shape_manager_v1 interface.
+     * After the interface has been released the CursorShapeManager instance is no
+     * longer valid and can be setup with another wp_cursor_shape_manager_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this CursorShapeManager.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. Once the connection becomes invalid, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail.
+     **/
+    void destroy();
+
+    /**
+     * Sets the @p queue to use for creating objects with this CursorShapeManager.
+     **/
+    void setEventQueue(EventQueue *queue);
+    /**
+     * @returns The event queue to use for creating objects with this CursorShapeManager.
+     **/
+    EventQueue *eventQueue();
+
+    /**
+     * Creates a CursorShapeDevice for the given @p pointer.
+     **/
+    CursorShapeDevice *createDevice(Pointer *pointer, QObject *parent = nullptr);
+
+    operator wp_cursor_shape_manager_v1 *();
+    operator wp_cursor_shape_manager_v1 *() const;
+
+Q_SIGNALS:
+    /**
+     * The corresponding global for this interface on the Registry got removed.
+     *
+     * This signal gets only emitted if the CursorShapeManager got created by
+     * Registry::createCursorShapeManager
+     **/
+    void removed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Wrapper for the wp_cursor_shape_device_v1 interface.
+ *
+ * @see CursorShapeManager
+ **/
+class KWAYLANDCLIENT_EXPORT CursorShapeDevice : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * The cursor shapes, named after the CSS cursor names.
+     **/
+    enum class Shape {
+        Default = 1,
+        ContextMenu,
+        Help,
+        Pointer,
+        Progress,
+        Wait,
+        Cell,
+        Crosshair,
+        Text,
+        VerticalText,
+        Alias,
+        Copy,
+        Move,
+        NoDrop,
+        NotAllowed,
+        Grab,
+        Grabbing,
+        EResize,
+        NResize,
+        NEResize,
+        NWResize,
+        SResize,
+        SEResize,
+        SWResize,
+        WResize,
+        EWResize,
+        NSResize,
+        NESWResize,
+        NWSEResize,
+        ColResize,
+        RowResize,
+        AllScroll,
+        ZoomIn,
+        ZoomOut,
+    };
+    Q_ENUM(Shape)
+
+    ~CursorShapeDevice() override;
+
+    /**
+     * Setup this CursorShapeDevice to manage the @p device.
+     * When using CursorShapeManager::createDevice there is no need to call this
+     * method.
+     **/
+    void setup(wp_cursor_shape_device_v1 *device);
+    /**
+     * @returns @c true if managing a wp_cursor_shape_device_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_cursor_shape_device_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this CursorShapeDevice.
+     **/
+    void destroy();
+
+    /**
+     * Sets the cursor to @p shape. The @p serial is the serial of the Pointer::entered signal;
+     * like with Pointer::setCursor, the cursor only changes while the pointer is on one of the
+     * client's surfaces.
+     **/
+    void setShape(quint32 serial, Shape shape);
+
+    operator wp_cursor_shape_device_v1 *();
+    operator wp_cursor_shape_device_v1 *() const;
+
+private:
+    friend class CursorShapeManager;
+    explicit CursorShapeDevice(QObject *parent = nullptr);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
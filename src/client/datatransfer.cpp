@@ -0,0 +1,372 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "datatransfer.h"
+#include "datacontroloffer.h"
+#include "dataoffer.h"
+// Qt
+#include <QFile>
+#include <QSocketNotifier>
+// system
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KWayland
+{
+namespace Client
+{
+// the most data moved in one go, so that the event loop gets back control
+static const size_t s_chunkSize = 64 * 1024;
+
+class Q_DECL_HIDDEN DataReceiver::Private
+{
+public:
+    Private(DataReceiver *q);
+    ~Private();
+
+    int start();
+    void readAvailable();
+    void stop();
+
+    qint32 target = -1;
+    bool canSplice = true;
+    int pipeFd = -1;
+    QScopedPointer<QSocketNotifier> notifier;
+    QByteArray data;
+    qint64 bytesReceived = 0;
+
+private:
+    bool writeToTarget(const char *data, qint64 size);
+
+    DataReceiver *q;
+};
+
+DataReceiver::Private::Private(DataReceiver *q)
+    : q(q)
+{
+}
+
+DataReceiver::Private::~Private()
+{
+    stop();
+}
+
+int DataReceiver::Private::start()
+{
+    if (pipeFd != -1) {
+        return -1;
+    }
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return -1;
+    }
+    pipeFd = pipeFds[0];
+    data.clear();
+    bytesReceived = 0;
+    canSplice = true;
+    notifier.reset(new QSocketNotifier(pipeFd, QSocketNotifier::Read));
+    QObject::connect(notifier.data(), &QSocketNotifier::activated, q, [this] {
+        readAvailable();
+    });
+    return pipeFds[1];
+}
+
+void DataReceiver::Private::stop()
+{
+    notifier.reset();
+    if (pipeFd != -1) {
+        close(pipeFd);
+        pipeFd = -1;
+    }
+}
+
+bool DataReceiver::Private::writeToTarget(const char *data, qint64 size)
+{
+    while (size > 0) {
+        const ssize_t written = write(target, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+void DataReceiver::Private::readAvailable()
+{
+    const qint64 oldBytesReceived = bytesReceived;
+    // read what is there right now, more arrives with the next activation
+    for (qint64 transferred = 0; transferred < qint64(s_chunkSize);) {
+        ssize_t n;
+        if (target != -1 && canSplice) {
+            n = splice(pipeFd, nullptr, target, nullptr, s_chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n < 0 && errno == EINVAL) {
+                // the target doesn't support splicing, e.g. it's opened with O_APPEND
+                canSplice = false;
+                continue;
+            }
+        } else {
+            char buffer[4096];
+            n = read(pipeFd, buffer, sizeof(buffer));
+            if (n > 0) {
+                if (target == -1) {
+                    data.append(buffer, n);
+                } else if (!writeToTarget(buffer, n)) {
+                    stop();
+                    Q_EMIT q->failed();
+                    return;
+                }
+            }
+        }
+
+        if (n > 0) {
+            transferred += n;
+            bytesReceived += n;
+            continue;
+        }
+        if (n == 0) {
+            stop();
+            if (bytesReceived != oldBytesReceived) {
+                Q_EMIT q->progress(bytesReceived);
+            }
+            Q_EMIT q->finished();
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN) {
+            break;
+        }
+        stop();
+        Q_EMIT q->failed();
+        return;
+    }
+    if (bytesReceived != oldBytesReceived) {
+        Q_EMIT q->progress(bytesReceived);
+    }
+}
+
+DataReceiver::DataReceiver(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+DataReceiver::~DataReceiver() = default;
+
+void DataReceiver::setTarget(qint32 fd)
+{
+    d->target = fd;
+}
+
+qint32 DataReceiver::target() const
+{
+    return d->target;
+}
+
+bool DataReceiver::receive(DataOffer *offer, const QString &mimeType)
+{
+    if (!offer || !offer->isValid()) {
+        return false;
+    }
+    const int fd = d->start();
+    if (fd == -1) {
+        return false;
+    }
+    // the descriptor gets duplicated when the request is sent
+    offer->receive(mimeType, fd);
+    close(fd);
+    return true;
+}
+
+bool DataReceiver::receive(DataControlOfferV1 *offer, const QString &mimeType)
+{
+    if (!offer || !offer->isValid()) {
+        return false;
+    }
+    const int fd = d->start();
+    if (fd == -1) {
+        return false;
+    }
+    offer->receive(mimeType, fd);
+    close(fd);
+    return true;
+}
+
+void DataReceiver::abort()
+{
+    d->stop();
+}
+
+bool DataReceiver::isActive() const
+{
+    return d->pipeFd != -1;
+}
+
+QByteArray DataReceiver::data() const
+{
+    return d->data;
+}
+
+qint64 DataReceiver::bytesReceived() const
+{
+    return d->bytesReceived;
+}
+
+class Q_DECL_HIDDEN DataSender::Private
+{
+public:
+    Private(DataSender *q);
+    ~Private();
+
+    bool start(qint32 fd);
+    void writeAvailable();
+    void stop();
+
+    int fd = -1;
+    // either the data or the file is sent
+    QByteArray data;
+    int fileFd = -1;
+    qint64 fileSize = 0;
+    qint64 bytesSent = 0;
+    QScopedPointer<QSocketNotifier> notifier;
+
+private:
+    DataSender *q;
+};
+
+DataSender::Private::Private(DataSender *q)
+    : q(q)
+{
+}
+
+DataSender::Private::~Private()
+{
+    stop();
+}
+
+bool DataSender::Private::start(qint32 fd)
+{
+    if (this->fd != -1 || fd < 0) {
+        return false;
+    }
+    this->fd = fd;
+    bytesSent = 0;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    notifier.reset(new QSocketNotifier(fd, QSocketNotifier::Write));
+    QObject::connect(notifier.data(), &QSocketNotifier::activated, q, [this] {
+        writeAvailable();
+    });
+    return true;
+}
+
+void DataSender::Private::stop()
+{
+    notifier.reset();
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    if (fileFd != -1) {
+        close(fileFd);
+        fileFd = -1;
+    }
+    data.clear();
+}
+
+void DataSender::Private::writeAvailable()
+{
+    const qint64 size = fileFd != -1 ? fileSize : data.size();
+    for (qint64 transferred = 0; transferred < qint64(s_chunkSize) && bytesSent < size;) {
+        const size_t count = qMin<qint64>(size - bytesSent, s_chunkSize);
+        ssize_t n;
+        if (fileFd != -1) {
+            off_t offset = bytesSent;
+            n = sendfile(fd, fileFd, &offset, count);
+        } else {
+            n = write(fd, data.constData() + bytesSent, count);
+        }
+        if (n > 0) {
+            transferred += n;
+            bytesSent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return;
+        }
+        // the file got truncated or the receiving client closed its end
+        stop();
+        Q_EMIT q->failed();
+        return;
+    }
+    if (bytesSent >= size) {
+        stop();
+        Q_EMIT q->finished();
+    }
+}
+
+DataSender::DataSender(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+DataSender::~DataSender() = default;
+
+bool DataSender::send(qint32 fd, const QByteArray &data)
+{
+    if (!d->start(fd)) {
+        return false;
+    }
+    d->data = data;
+    return true;
+}
+
+bool DataSender::send(qint32 fd, const QString &fileName)
+{
+    if (d->fd != -1) {
+        return false;
+    }
+    const int fileFd = open(QFile::encodeName(fileName).constData(), O_RDONLY | O_CLOEXEC);
+    if (fileFd == -1) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fileFd, &info) != 0 || !d->start(fd)) {
+        close(fileFd);
+        return false;
+    }
+    d->fileFd = fileFd;
+    d->fileSize = info.st_size;
+    return true;
+}
+
+void DataSender::abort()
+{
+    d->stop();
+}
+
+bool DataSender::isActive() const
+{
+    return d->fd != -1;
+}
+
+qint64 DataSender::bytesSent() const
+{
+    return d->bytesSent;
+}
+
+}
+}
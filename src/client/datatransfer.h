@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_DATA_TRANSFER_H
+#define WAYLAND_DATA_TRANSFER_H
+
+#include <QObject>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class DataControlOfferV1;
+class DataOffer;
+
+/**
+ * @short Receives the data of a DataOffer without blocking.
+ *
+ * The DataReceiver creates the pipe for DataOffer::receive or DataControlOfferV1::receive and
+ * reads it whenever data is available, so a large paste doesn't freeze the event loop:
+ * @code
+ * auto receiver = new DataReceiver(this);
+ * connect(receiver, &DataReceiver::finished, this, [receiver] {
+ *     paste(receiver->data());
+ *     receiver->deleteLater();
+ * });
+ * receiver->receive(offer, QStringLiteral("text/plain"));
+ * connection->flush();
+ * @endcode
+ *
+ * The request only reaches the source client once the connection got flushed.
+ *
+ * If a target file descriptor is set, the data is moved into it with splice() instead of
+ * being collected in data(), without copying it through user space.
+ **/
+class KWAYLANDCLIENT_EXPORT DataReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DataReceiver(QObject *parent = nullptr);
+    ~DataReceiver() override;
+
+    /**
+     * Sets the file descriptor the data is written to instead of data(), e.g. a file that
+     * is pasted into. It has to be a regular file or a blocking file descriptor, the
+     * DataReceiver does not take ownership of it. Pass @c -1 to collect the data again.
+     * This has to be set before the transfer starts.
+     **/
+    void setTarget(qint32 fd);
+    /**
+     * @returns The file descriptor the data is written to, or @c -1 if it's collected.
+     **/
+    qint32 target() const;
+
+    /**
+     * Requests the data of @p offer in the format @p mimeType and starts reading it.
+     * @returns @c false if the pipe could not be created or a transfer is already running.
+     **/
+    bool receive(DataOffer *offer, const QString &mimeType);
+    /**
+     * Requests the data of @p offer in the format @p mimeType and starts reading it.
+     * @returns @c false if the pipe could not be created or a transfer is already running.
+     **/
+    bool receive(DataControlOfferV1 *offer, const QString &mimeType);
+    /**
+     * Stops reading the data. Neither finished nor failed are emitted afterwards.
+     **/
+    void abort();
+
+    /**
+     * @returns Whether the transfer is running.
+     **/
+    bool isActive() const;
+    /**
+     * @returns The data received so far, empty if there is a target.
+     **/
+    QByteArray data() const;
+    /**
+     * @returns The number of bytes received so far.
+     **/
+    qint64 bytesReceived() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted whenever a batch of data has been received.
+     **/
+    void progress(qint64 bytesReceived);
+    /**
+     * Emitted when the source client has sent all data and closed its end of the pipe.
+     **/
+    void finished();
+    /**
+     * Emitted when reading the data or writing it to the target failed.
+     **/
+    void failed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Sends data to the file descriptor of a data request without blocking.
+ *
+ * Connect DataSource::sendDataRequested or DataControlSourceV1::sendDataRequested to a
+ * DataSender, which writes the data whenever the receiving client is able to take more and
+ * closes the file descriptor afterwards:
+ * @code
+ * connect(source, &DataSource::sendDataRequested, this, [this](const QString &mimeType, qint32 fd) {
+ *     auto sender = new DataSender(this);
+ *     connect(sender, &DataSender::finished, sender, &QObject::deleteLater);
+ *     connect(sender, &DataSender::failed, sender, &QObject::deleteLater);
+ *     sender->send(fd, m_data.value(mimeType));
+ * });
+ * @endcode
+ *
+ * Files are sent with sendfile(), without copying them through user space. As the receiving
+ * client may close its end at any time, the application should ignore SIGPIPE.
+ **/
+class KWAYLANDCLIENT_EXPORT DataSender : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DataSender(QObject *parent = nullptr);
+    ~DataSender() override;
+
+    /**
+     * Starts writing @p data to @p fd. The DataSender takes ownership of @p fd.
+     * @returns @c false if a transfer is already running.
+     **/
+    bool send(qint32 fd, const QByteArray &data);
+    /**
+     * Starts writing the content of the file @p fileName to @p fd. The DataSender takes
+     * ownership of @p fd.
+     * @returns @c false if the file could not be opened or a transfer is already running.
+     **/
+    bool send(qint32 fd, const QString &fileName);
+    /**
+     * Stops writing and closes the file descriptor. Neither finished nor failed are emitted
+     * afterwards.
+     **/
+    void abort();
+
+    /**
+     * @returns Whether the transfer is running.
+     **/
+    bool isActive() const;
+    /**
+     * @returns The number of bytes sent so far.
+     **/
+    qint64 bytesSent() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when all data has been written and the file descriptor got closed.
+     **/
+    void finished();
+    /**
+     * Emitted when writing failed, e.g. because the receiving client closed its end.
+     **/
+    void failed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "logging.h"
 #include "surface.h"
 #include "wayland_pointer_p.h"
+#include "wrapperindex_p.h"
 // Qt
 #include <QDebug>
 #include <QVector>
@@ -40,6 +41,7 @@ public:
     Private(DDEShellSurface *q);
     ~Private();
     void setup(dde_shell_surface *ddeShellSurface);
+    void setParentSurface(Surface *surface);
 
     WaylandPointer<dde_shell_surface, dde_shell_surface_destroy> ddeShellSurface;
     QPointer<Surface> parentSurface;
@@ -61,6 +63,8 @@ public:
     bool onAllDesktops = false;
     int splitable = 0;
 
+    DDEShellSurface::States states() const;
+
     static DDEShellSurface *get(wl_surface *surface);
     static DDEShellSurface *get(Surface *surface);
 
@@ -88,11 +92,11 @@ private:
     }
 
     DDEShellSurface *q;
-    static QVector<Private*> s_ddeShellSurfaces;
+    static WrapperIndex<Surface *, Private> s_index;
     static const dde_shell_surface_listener s_listener;
 };
 
-QVector<DDEShellSurface::Private*> DDEShellSurface::Private::s_ddeShellSurfaces;
+WrapperIndex<Surface *, DDEShellSurface::Private> DDEShellSurface::Private::s_index;
 
 DDEShell::Private::Private(DDEShell *q)
     : q(q)
@@ -185,7 +189,7 @@ DDEShellSurface *DDEShell::createShellSurface(wl_surface *surface, QObject *pare
         d->queue->addProxy(w);
     }
     s->setup(w);
-    s->d->parentSurface = QPointer<Surface>(kwS);
+    s->d->setParentSurface(kwS);
     return s;
 }
 
@@ -198,12 +202,17 @@ DDEShellSurface *DDEShell::createShellSurface(Surface *surface, QObject *parent)
 DDEShellSurface::Private::Private(DDEShellSurface *q)
     : q(q)
 {
-    s_ddeShellSurfaces << this;
 }
 
 DDEShellSurface::Private::~Private()
 {
-    s_ddeShellSurfaces.removeAll(this);
+    s_index.remove(this);
+}
+
+void DDEShellSurface::Private::setParentSurface(Surface *surface)
+{
+    parentSurface = QPointer<Surface>(surface);
+    s_index.insert(surface, this);
 }
 
 DDEShellSurface *DDEShellSurface::Private::get(wl_surface *surface)
@@ -211,12 +220,7 @@ DDEShellSurface *DDEShellSurface::Private::get(wl_surface *surface)
     if (!surface) {
         return nullptr;
     }
-    for (auto it = s_ddeShellSurfaces.constBegin(); it != s_ddeShellSurfaces.constEnd(); ++it) {
-        if ((*it)->parentSurface == Surface::get(surface)) {
-            return (*it)->q;
-        }
-    }
-    return nullptr;
+    return get(Surface::get(surface));
 }
 
 DDEShellSurface *DDEShellSurface::Private::get(Surface *surface)
@@ -224,10 +228,10 @@ DDEShellSurface *DDEShellSurface::Private::get(Surface *surface)
     if (!surface) {
         return nullptr;
     }
-    for (auto it = s_ddeShellSurfaces.constBegin(); it != s_ddeShellSurfaces.constEnd(); ++it) {
-        if ((*it)->parentSurface == surface) {
-            return (*it)->q;
-        }
+    // a destroyed Surface may have left its address to the new one
+    Private *p = s_index.value(surface);
+    if (p && p->parentSurface == surface) {
+        return p->q;
     }
     return nullptr;
 }
@@ -244,6 +248,7 @@ void DDEShellSurface::Private::stateChangedCallback(void *data, dde_shell_surfac
 {
     auto p = cast(data);
     Q_UNUSED(dde_shell_surface);
+    const DDEShellSurface::States previousStates = p->states();
     p->setActive(state & DDE_SHELL_STATE_ACTIVE);
     p->setMinimized(state & DDE_SHELL_STATE_MINIMIZED);
     p->setMaximized(state & DDE_SHELL_STATE_MAXIMIZED);
@@ -257,7 +262,7 @@ void DDEShellSurface::Private::stateChangedCallback(void *data, dde_shell_surfac
     p->setMinimizeable(state & DDE_SHELL_STATE_MINIMIZABLE);
     p->setMovable(state & DDE_SHELL_STATE_MOVABLE);
     p->setResizable(state & DDE_SHELL_STATE_RESIZABLE);
-    p->setAcceptFocus(state * DDE_SHELL_STATE_ACCEPT_FOCUS);
+    p->setAcceptFocus(state & DDE_SHELL_STATE_ACCEPT_FOCUS);
     p->setModal(state & DDE_SHELL_STATE_MODALITY);
     if (state & DDE_SHELL_STATE_TWO_SPLIT) {
         p->splitable = 1;
@@ -268,6 +273,31 @@ void DDEShellSurface::Private::stateChangedCallback(void *data, dde_shell_surfac
     if (state & DDE_SHELL_STATE_NO_SPLIT) {
         p->splitable = 0;
     }
+    const DDEShellSurface::States changedStates = previousStates ^ p->states();
+    if (changedStates) {
+        Q_EMIT p->q->stateChanged(changedStates);
+    }
+}
+
+DDEShellSurface::States DDEShellSurface::Private::states() const
+{
+    DDEShellSurface::States states;
+    states.setFlag(DDEShellSurface::State::Active, active);
+    states.setFlag(DDEShellSurface::State::Minimized, minimized);
+    states.setFlag(DDEShellSurface::State::Maximized, maximized);
+    states.setFlag(DDEShellSurface::State::Fullscreen, fullscreen);
+    states.setFlag(DDEShellSurface::State::KeepAbove, keepAbove);
+    states.setFlag(DDEShellSurface::State::KeepBelow, keepBelow);
+    states.setFlag(DDEShellSurface::State::OnAllDesktops, onAllDesktops);
+    states.setFlag(DDEShellSurface::State::Closeable, closeable);
+    states.setFlag(DDEShellSurface::State::Minimizeable, minimizeable);
+    states.setFlag(DDEShellSurface::State::Maximizeable, maximizeable);
+    states.setFlag(DDEShellSurface::State::Fullscreenable, fullscreenable);
+    states.setFlag(DDEShellSurface::State::Movable, movable);
+    states.setFlag(DDEShellSurface::State::Resizable, resizable);
+    states.setFlag(DDEShellSurface::State::AcceptFocus, acceptFocus);
+    states.setFlag(DDEShellSurface::State::Modal, modality);
+    return states;
 }
 
 void DDEShellSurface::Private::geometryCallback(void *data, dde_shell_surface *ddeShellSurface, int32_t x, int32_t y, uint32_t width, uint32_t height)
@@ -712,6 +742,11 @@ int DDEShellSurface::getSplitable() const
     return d->splitable;
 }
 
+DDEShellSurface::States DDEShellSurface::states() const
+{
+    return d->states();
+}
+
 void DDEShellSurface::requestNoTitleBarProperty(qint32 value)
 {
     struct wl_array arr;
@@ -158,6 +158,28 @@ class KWAYLANDCLIENT_EXPORT DDEShellSurface : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * The states of the window, stateChanged() reports which of them changed.
+     **/
+    enum class State {
+        Active = 1 << 0,
+        Minimized = 1 << 1,
+        Maximized = 1 << 2,
+        Fullscreen = 1 << 3,
+        KeepAbove = 1 << 4,
+        KeepBelow = 1 << 5,
+        OnAllDesktops = 1 << 6,
+        Closeable = 1 << 7,
+        Minimizeable = 1 << 8,
+        Maximizeable = 1 << 9,
+        Fullscreenable = 1 << 10,
+        Movable = 1 << 11,
+        Resizable = 1 << 12,
+        AcceptFocus = 1 << 13,
+        Modal = 1 << 14,
+    };
+    Q_DECLARE_FLAGS(States, State)
+    Q_FLAG(States)
 
     explicit DDEShellSurface(QObject *parent = nullptr);
     virtual ~DDEShellSurface();
@@ -191,6 +213,10 @@ public:
     bool isOnAllDesktops() const;
     bool isSplitable() const;
     int getSplitable() const;
+    /**
+     * @returns all states which are set
+     **/
+    States states() const;
 
     void requestActivate();
     void requestKeepAbove(bool set);
@@ -246,6 +272,13 @@ Q_SIGNALS:
     void acceptFocusChanged();
     void modalityChanged();
     void onAllDesktopsChanged();
+    /**
+     * Emitted once for every state update of the compositor, after the signals of the
+     * individual states, with @p changed containing all states that changed. A client which
+     * updates its appearance from several states, e.g. when a window gets maximized and
+     * activated at once, should use it rather than the individual signals to react only once.
+     **/
+    void stateChanged(KWayland::Client::DDEShellSurface::States changed);
 
 private:
     friend class DDEShell;
@@ -253,6 +286,8 @@ private:
     QScopedPointer<Private> d;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(DDEShellSurface::States)
+
 }
 }
 
@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "dmabuf_feedback.h"
+#include "logging.h"
+#include "wayland_pointer_p.h"
+// Qt
+#include <QDebug>
+// system
+#include <sys/mman.h>
+#include <unistd.h>
+// std
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <utility>
+// wayland
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
+
+namespace KWayland
+{
+namespace Client
+{
+namespace
+{
+struct FormatTableEntry {
+    uint32_t format;
+    uint32_t padding;
+    uint64_t modifier;
+};
+
+/**
+ * The format table shared by the compositor, it stays mapped as long as tranches refer to it.
+ */
+class FormatTable
+{
+public:
+    FormatTable() = default;
+    FormatTable(const FormatTable &) = delete;
+    FormatTable &operator=(const FormatTable &) = delete;
+
+    ~FormatTable()
+    {
+        unmap();
+    }
+
+    bool map(int fd, uint32_t size)
+    {
+        unmap();
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        m_data = data;
+        m_size = size;
+        return true;
+    }
+
+    void unmap()
+    {
+        if (m_data) {
+            munmap(m_data, m_size);
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+
+    void swap(FormatTable &other)
+    {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+
+    bool isMapped() const
+    {
+        return m_data != nullptr;
+    }
+
+    int count() const
+    {
+        return m_size / sizeof(FormatTableEntry);
+    }
+
+    const FormatTableEntry *at(uint16_t index) const
+    {
+        if (index >= count()) {
+            return nullptr;
+        }
+        return static_cast<const FormatTableEntry *>(m_data) + index;
+    }
+
+private:
+    void *m_data = nullptr;
+    size_t m_size = 0;
+};
+}
+
+class Q_DECL_HIDDEN DmaBufFeedback::Private
+{
+public:
+    Private(DmaBufFeedback *q);
+
+    WaylandPointer<zwp_linux_dmabuf_feedback_v1, zwp_linux_dmabuf_feedback_v1_destroy> feedback;
+    FormatTable table;
+    dev_t mainDevice = 0;
+    QVector<Tranche> tranches;
+
+    // the parameters until the done event
+    FormatTable pendingTable;
+    dev_t pendingMainDevice = 0;
+    QVector<Tranche> pendingTranches;
+    Tranche pendingTranche;
+
+    static const zwp_linux_dmabuf_feedback_v1_listener s_listener;
+
+private:
+    static void doneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback);
+    static void formatTableCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, int32_t fd, uint32_t size);
+    static void mainDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device);
+    static void trancheDoneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback);
+    static void trancheTargetDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device);
+    static void trancheFormatsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *indices);
+    static void trancheFlagsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, uint32_t flags);
+
+    DmaBufFeedback *q;
+};
+
+#ifndef K_DOXYGEN
+const zwp_linux_dmabuf_feedback_v1_listener DmaBufFeedback::Private::s_listener = {
+    doneCallback,
+    formatTableCallback,
+    mainDeviceCallback,
+    trancheDoneCallback,
+    trancheTargetDeviceCallback,
+    trancheFormatsCallback,
+    trancheFlagsCallback,
+};
+#endif
+
+DmaBufFeedback::Private::Private(DmaBufFeedback *q)
+    : q(q)
+{
+}
+
+void DmaBufFeedback::Private::formatTableCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, int32_t fd, uint32_t size)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    if (!p->pendingTable.map(fd, size)) {
+        qCDebug(KWAYLAND_CLIENT) << "Could not map the dma-buf format table";
+    }
+    close(fd);
+}
+
+void DmaBufFeedback::Private::mainDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    if (device->size == sizeof(dev_t)) {
+        memcpy(&p->pendingMainDevice, device->data, sizeof(dev_t));
+    }
+}
+
+void DmaBufFeedback::Private::trancheTargetDeviceCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *device)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    if (device->size == sizeof(dev_t)) {
+        memcpy(&p->pendingTranche.device, device->data, sizeof(dev_t));
+    }
+}
+
+void DmaBufFeedback::Private::trancheFormatsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, wl_array *indices)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    const uint16_t *begin = static_cast<const uint16_t *>(indices->data);
+    const uint16_t *end = begin + indices->size / sizeof(uint16_t);
+    p->pendingTranche.indices.reserve(p->pendingTranche.indices.size() + (end - begin));
+    std::copy(begin, end, std::back_inserter(p->pendingTranche.indices));
+}
+
+void DmaBufFeedback::Private::trancheFlagsCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback, uint32_t flags)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    p->pendingTranche.flags = TrancheFlags(flags);
+}
+
+void DmaBufFeedback::Private::trancheDoneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    p->pendingTranches.append(std::exchange(p->pendingTranche, Tranche()));
+}
+
+void DmaBufFeedback::Private::doneCallback(void *data, zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+    auto p = reinterpret_cast<DmaBufFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    const bool hadScanoutTranche = p->q->hasScanoutTranche();
+
+    // the compositor only sends the format table again when it changed
+    if (p->pendingTable.isMapped()) {
+        p->table.swap(p->pendingTable);
+        p->pendingTable.unmap();
+    }
+    p->mainDevice = p->pendingMainDevice;
+    p->tranches = std::exchange(p->pendingTranches, {});
+
+    Q_EMIT p->q->changed();
+    if (hadScanoutTranche != p->q->hasScanoutTranche()) {
+        Q_EMIT p->q->scanoutChanged();
+    }
+}
+
+DmaBufFeedback::DmaBufFeedback(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+DmaBufFeedback::~DmaBufFeedback()
+{
+    release();
+}
+
+void DmaBufFeedback::setup(zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+    Q_ASSERT(feedback);
+    Q_ASSERT(!d->feedback);
+    d->feedback.setup(feedback);
+    zwp_linux_dmabuf_feedback_v1_add_listener(d->feedback, &Private::s_listener, d.data());
+}
+
+void DmaBufFeedback::release()
+{
+    d->feedback.release();
+}
+
+void DmaBufFeedback::destroy()
+{
+    d->feedback.destroy();
+}
+
+bool DmaBufFeedback::isValid() const
+{
+    return d->feedback.isValid();
+}
+
+dev_t DmaBufFeedback::mainDevice() const
+{
+    return d->mainDevice;
+}
+
+QVector<DmaBufFeedback::Tranche> DmaBufFeedback::tranches() const
+{
+    return d->tranches;
+}
+
+QHash<uint32_t, QVector<uint64_t>> DmaBufFeedback::formats(const Tranche &tranche) const
+{
+    QHash<uint32_t, QVector<uint64_t>> formats;
+    for (uint16_t index : tranche.indices) {
+        if (const FormatTableEntry *entry = d->table.at(index)) {
+            formats[entry->format].append(entry->modifier);
+        }
+    }
+    return formats;
+}
+
+bool DmaBufFeedback::hasScanoutTranche() const
+{
+    return std::any_of(d->tranches.cbegin(), d->tranches.cend(), [](const Tranche &tranche) {
+        return tranche.flags.testFlag(TrancheFlag::Scanout);
+    });
+}
+
+DmaBufFeedback::operator zwp_linux_dmabuf_feedback_v1 *()
+{
+    return d->feedback;
+}
+
+DmaBufFeedback::operator zwp_linux_dmabuf_feedback_v1 *() const
+{
+    return d->feedback;
+}
+
+}
+}
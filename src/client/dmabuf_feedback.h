@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_DMABUF_FEEDBACK_H
+#define WAYLAND_DMABUF_FEEDBACK_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+#include <sys/types.h>
+
+struct zwp_linux_dmabuf_feedback_v1;
+
+namespace KWayland
+{
+namespace Client
+{
+/**
+ * @short Wrapper for the zwp_linux_dmabuf_feedback_v1 interface.
+ *
+ * The feedback tells which formats and modifiers the compositor prefers for the dma-bufs of a
+ * client, grouped in tranches of decreasing preference. The feedback of a Surface changes
+ * e.g. when it goes fullscreen and the compositor could put it on a plane of the output: it
+ * gains a tranche with the Scanout flag, a client which reallocates its buffers with the
+ * modifiers of that tranche saves the compositor a copy of every frame.
+ *
+ * A DmaBufFeedback is created with DmaBufPool::createSurfaceFeedback:
+ * @code
+ * DmaBufFeedback *feedback = pool->createSurfaceFeedback(surface, this);
+ * connect(feedback, &DmaBufFeedback::changed, this, [this, feedback] {
+ *     for (const DmaBufFeedback::Tranche &tranche : feedback->tranches()) {
+ *         if (tranche.flags & DmaBufFeedback::TrancheFlag::Scanout) {
+ *             reallocate(feedback->formats(tranche));
+ *             return;
+ *         }
+ *     }
+ * });
+ * @endcode
+ *
+ * The format table stays memory mapped, the tranches only hold indices into it.
+ *
+ * @see DmaBufPool
+ **/
+class KWAYLANDCLIENT_EXPORT DmaBufFeedback : public QObject
+{
+    Q_OBJECT
+public:
+    enum class TrancheFlag : uint32_t {
+        Scanout = 1, ///< the tranche's formats can be scanned out by the target device
+    };
+    Q_DECLARE_FLAGS(TrancheFlags, TrancheFlag)
+
+    struct Tranche {
+        /**
+         * The device that will use the buffers, e.g. the one driving the output for a
+         * scanout tranche.
+         **/
+        dev_t device = 0;
+        TrancheFlags flags;
+        /**
+         * Indices into the format table of the feedback.
+         * @see formats
+         **/
+        QVector<uint16_t> indices;
+    };
+
+    explicit DmaBufFeedback(QObject *parent = nullptr);
+    ~DmaBufFeedback() override;
+
+    /**
+     * @returns @c true if managing a zwp_linux_dmabuf_feedback_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Setup this DmaBufFeedback to manage the @p feedback.
+     * When using DmaBufPool::createSurfaceFeedback there is no need to call this
+     * method.
+     **/
+    void setup(zwp_linux_dmabuf_feedback_v1 *feedback);
+    /**
+     * Releases the zwp_linux_dmabuf_feedback_v1 interface.
+     * After the interface has been released the DmaBufFeedback instance is no
+     * longer valid and can be setup with another zwp_linux_dmabuf_feedback_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this DmaBufFeedback.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. Once the connection becomes invalid, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail.
+     **/
+    void destroy();
+
+    /**
+     * @returns The device the compositor allocates and renders with. Buffers which are not
+     * meant for a particular tranche should be allocated on it.
+     **/
+    dev_t mainDevice() const;
+    /**
+     * @returns The tranches in the order of preference of the compositor.
+     **/
+    QVector<Tranche> tranches() const;
+    /**
+     * @returns The formats of @p tranche with their modifiers, looked up in the format table.
+     **/
+    QHash<uint32_t, QVector<uint64_t>> formats(const Tranche &tranche) const;
+    /**
+     * @returns @c true if one of the tranches has the TrancheFlag::Scanout.
+     **/
+    bool hasScanoutTranche() const;
+
+    operator zwp_linux_dmabuf_feedback_v1 *();
+    operator zwp_linux_dmabuf_feedback_v1 *() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the compositor sent new feedback, all of its parameters are updated
+     * at once.
+     **/
+    void changed();
+    /**
+     * Emitted after changed if a tranche with the TrancheFlag::Scanout appeared or went away.
+     * @see hasScanoutTranche
+     **/
+    void scanoutChanged();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWayland::Client::DmaBufFeedback::TrancheFlags)
+
+#endif
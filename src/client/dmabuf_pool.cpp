@@ -0,0 +1,482 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "dmabuf_pool.h"
+#include "buffer_p.h"
+#include "dmabuf_feedback.h"
+#include "event_queue.h"
+#include "logging.h"
+#include "surface.h"
+#include "wayland_pointer_p.h"
+// Qt
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSharedPointer>
+#include <QSize>
+// system
+#include <fcntl.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+// std
+#include <algorithm>
+#include <utility>
+// gbm
+#include <gbm.h>
+// wayland
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
+
+namespace KWayland
+{
+namespace Client
+{
+namespace
+{
+// DRM_FORMAT_MOD_INVALID, the buffer has an implicit modifier
+static const uint64_t s_invalidModifier = 0x00ffffffffffffffULL;
+
+static uint32_t toDrmFormat(Buffer::Format format)
+{
+    switch (format) {
+    case Buffer::Format::RGB32:
+        return GBM_FORMAT_XRGB8888;
+    case Buffer::Format::ARGB32:
+    default:
+        return GBM_FORMAT_ARGB8888;
+    }
+}
+
+/**
+ * The buffer objects have to be destroyed before the device they were allocated on, a Buffer
+ * can outlive its pool though. Hence every Buffer keeps a reference to the device.
+ */
+struct GbmDevice {
+    ~GbmDevice()
+    {
+        gbm_device_destroy(device);
+        close(fd);
+    }
+
+    int fd = -1;
+    gbm_device *device = nullptr;
+};
+
+static QSharedPointer<GbmDevice> openDevice(const QString &path)
+{
+    const int fd = open(QFile::encodeName(path).constData(), O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        qCDebug(KWAYLAND_CLIENT) << "Could not open" << path;
+        return QSharedPointer<GbmDevice>();
+    }
+    gbm_device *device = gbm_create_device(fd);
+    if (!device) {
+        qCDebug(KWAYLAND_CLIENT) << "Could not create a GBM device on" << path;
+        close(fd);
+        return QSharedPointer<GbmDevice>();
+    }
+    QSharedPointer<GbmDevice> gbmDevice(new GbmDevice);
+    gbmDevice->fd = fd;
+    gbmDevice->device = device;
+    return gbmDevice;
+}
+
+static QString renderNode(dev_t device)
+{
+    // The compositor announces the primary or the render node of its GPU, the render node is
+    // listed next to the primary node in sysfs.
+    const QDir dir(QStringLiteral("/sys/dev/char/%1:%2/device/drm").arg(major(device)).arg(minor(device)));
+    const QStringList nodes = dir.entryList({QStringLiteral("renderD*")}, QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    if (nodes.isEmpty()) {
+        return QString();
+    }
+    return QStringLiteral("/dev/dri/") + nodes.first();
+}
+
+static QString firstRenderNode()
+{
+    const QStringList nodes = QDir(QStringLiteral("/dev/dri")).entryList({QStringLiteral("renderD*")}, QDir::System, QDir::Name);
+    if (nodes.isEmpty()) {
+        return QString();
+    }
+    return QStringLiteral("/dev/dri/") + nodes.first();
+}
+
+struct BufferShape {
+    QSize size;
+    Buffer::Format format;
+    // the modifiers requested by the client, empty for those of the formats
+    QVector<uint64_t> modifiers;
+};
+
+bool operator==(const BufferShape &a, const BufferShape &b)
+{
+    return a.size == b.size && a.format == b.format && a.modifiers == b.modifiers;
+}
+
+uint qHash(const BufferShape &shape, uint seed = 0)
+{
+    return qHash(qMakePair(qMakePair(shape.size.width(), shape.size.height()), qMakePair(int(shape.format), shape.modifiers)), seed);
+}
+}
+
+class Q_DECL_HIDDEN DmaBufPool::Private
+{
+public:
+    Private(DmaBufPool *q);
+
+    void setDevice(const QString &path);
+    void updateFormats();
+    void scheduleFormatsChanged();
+    QSharedPointer<Buffer> getBuffer(const QSize &size, Buffer::Format format, const QVector<uint64_t> &modifiers);
+    void reclaimIdleBuffers();
+    void reset();
+
+    WaylandPointer<zwp_linux_dmabuf_v1, zwp_linux_dmabuf_v1_destroy> dmabuf;
+    // the default feedback, from version 4 on
+    QScopedPointer<DmaBufFeedback> feedback;
+    QHash<uint32_t, QVector<uint64_t>> formats;
+    QString devicePath;
+    QSharedPointer<GbmDevice> device;
+    QHash<BufferShape, QList<QSharedPointer<Buffer>>> buffers;
+    EventQueue *queue = nullptr;
+    bool formatsChangedPending = false;
+
+    static const zwp_linux_dmabuf_v1_listener s_listener;
+
+private:
+    static void formatCallback(void *data, zwp_linux_dmabuf_v1 *dmabuf, uint32_t format);
+    static void modifierCallback(void *data, zwp_linux_dmabuf_v1 *dmabuf, uint32_t format, uint32_t modifierHi, uint32_t modifierLo);
+
+    DmaBufPool *q;
+};
+
+#ifndef K_DOXYGEN
+const zwp_linux_dmabuf_v1_listener DmaBufPool::Private::s_listener = {
+    formatCallback,
+    modifierCallback,
+};
+#endif
+
+DmaBufPool::Private::Private(DmaBufPool *q)
+    : q(q)
+{
+}
+
+void DmaBufPool::Private::formatCallback(void *data, zwp_linux_dmabuf_v1 *dmabuf, uint32_t format)
+{
+    // from version 3 on the modifier event replaces the format event
+    if (zwp_linux_dmabuf_v1_get_version(dmabuf) >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
+        return;
+    }
+    auto p = reinterpret_cast<DmaBufPool::Private *>(data);
+    p->formats[format] = {s_invalidModifier};
+    p->scheduleFormatsChanged();
+}
+
+void DmaBufPool::Private::modifierCallback(void *data, zwp_linux_dmabuf_v1 *dmabuf, uint32_t format, uint32_t modifierHi, uint32_t modifierLo)
+{
+    Q_UNUSED(dmabuf)
+    auto p = reinterpret_cast<DmaBufPool::Private *>(data);
+    const uint64_t modifier = uint64_t(modifierHi) << 32 | modifierLo;
+    QVector<uint64_t> &modifiers = p->formats[format];
+    if (!modifiers.contains(modifier)) {
+        modifiers.append(modifier);
+    }
+    p->scheduleFormatsChanged();
+}
+
+void DmaBufPool::Private::updateFormats()
+{
+    // Buffers are allocated on the main device, tranches for other devices, e.g. the scanout
+    // tranche of an output driven by another GPU, are of no use. A format keeps the modifiers
+    // of the first, most preferred, tranche it shows up in.
+    formats.clear();
+    const auto tranches = feedback->tranches();
+    for (const DmaBufFeedback::Tranche &tranche : tranches) {
+        if (tranche.device != feedback->mainDevice()) {
+            continue;
+        }
+        const auto trancheFormats = feedback->formats(tranche);
+        for (auto it = trancheFormats.constBegin(); it != trancheFormats.constEnd(); ++it) {
+            if (!formats.contains(it.key())) {
+                formats.insert(it.key(), it.value());
+            }
+        }
+    }
+    const QString path = renderNode(feedback->mainDevice());
+    if (path.isEmpty()) {
+        qCDebug(KWAYLAND_CLIENT) << "Could not find the render node of the compositor's main device";
+    }
+    setDevice(path);
+    Q_EMIT q->formatsChanged();
+}
+
+void DmaBufPool::Private::scheduleFormatsChanged()
+{
+    // there is no done event before version 4, the formats are announced in one burst
+    if (formatsChangedPending) {
+        return;
+    }
+    formatsChangedPending = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this] {
+            formatsChangedPending = false;
+            Q_EMIT q->formatsChanged();
+        },
+        Qt::QueuedConnection);
+}
+
+void DmaBufPool::Private::setDevice(const QString &path)
+{
+    if (devicePath == path && device) {
+        return;
+    }
+    // the Buffers of the old device can't be reused on the new one
+    buffers.clear();
+    devicePath = path;
+    device = path.isEmpty() ? QSharedPointer<GbmDevice>() : openDevice(path);
+}
+
+void DmaBufPool::Private::reset()
+{
+    buffers.clear();
+    formats.clear();
+    device.reset();
+    devicePath.clear();
+}
+
+void DmaBufPool::Private::reclaimIdleBuffers()
+{
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        QList<QSharedPointer<Buffer>> &shapeBuffers = *it;
+        shapeBuffers.erase(std::remove_if(shapeBuffers.begin(),
+                                          shapeBuffers.end(),
+                                          [](const QSharedPointer<Buffer> &buffer) {
+                                              return buffer->isReleased() && !buffer->isUsed();
+                                          }),
+                           shapeBuffers.end());
+        if (shapeBuffers.isEmpty()) {
+            it = buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QSharedPointer<Buffer> DmaBufPool::Private::getBuffer(const QSize &size, Buffer::Format format, const QVector<uint64_t> &requestedModifiers)
+{
+    if (!device) {
+        return QSharedPointer<Buffer>();
+    }
+    const BufferShape shape{size, format, requestedModifiers};
+    auto shapeIt = buffers.find(shape);
+    if (shapeIt != buffers.end()) {
+        for (const auto &buffer : qAsConst(*shapeIt)) {
+            if (buffer->isReleased() && !buffer->isUsed()) {
+                buffer->setReleased(false);
+                return buffer;
+            }
+        }
+    }
+
+    const uint32_t drmFormat = toDrmFormat(format);
+    const QVector<uint64_t> modifiers = requestedModifiers.isEmpty() ? formats.value(drmFormat) : requestedModifiers;
+    if (modifiers.isEmpty()) {
+        qCDebug(KWAYLAND_CLIENT) << "The compositor doesn't support dma-bufs with format" << int(format);
+        return QSharedPointer<Buffer>();
+    }
+    QVector<uint64_t> explicitModifiers = modifiers;
+    explicitModifiers.removeAll(s_invalidModifier);
+
+    gbm_bo *bo = nullptr;
+    uint64_t modifier = s_invalidModifier;
+    if (!explicitModifiers.isEmpty()) {
+        bo = gbm_bo_create_with_modifiers(device->device, size.width(), size.height(), drmFormat, explicitModifiers.constData(), explicitModifiers.count());
+        if (bo) {
+            modifier = gbm_bo_get_modifier(bo);
+        }
+    }
+    if (!bo && modifiers.contains(s_invalidModifier)) {
+        bo = gbm_bo_create(device->device, size.width(), size.height(), drmFormat, GBM_BO_USE_RENDERING);
+    }
+    if (!bo) {
+        qCDebug(KWAYLAND_CLIENT) << "Allocating a dma-buf of size" << size << "failed";
+        return QSharedPointer<Buffer>();
+    }
+
+    zwp_linux_buffer_params_v1 *params = zwp_linux_dmabuf_v1_create_params(dmabuf);
+    const int planeCount = gbm_bo_get_plane_count(bo);
+    for (int plane = 0; plane < planeCount; ++plane) {
+        const int fd = gbm_bo_get_fd_for_plane(bo, plane);
+        if (fd == -1) {
+            qCDebug(KWAYLAND_CLIENT) << "Could not export plane" << plane << "of a dma-buf";
+            zwp_linux_buffer_params_v1_destroy(params);
+            gbm_bo_destroy(bo);
+            return QSharedPointer<Buffer>();
+        }
+        zwp_linux_buffer_params_v1_add(params,
+                                       fd,
+                                       plane,
+                                       gbm_bo_get_offset(bo, plane),
+                                       gbm_bo_get_stride_for_plane(bo, plane),
+                                       modifier >> 32,
+                                       modifier & 0xffffffff);
+        // libwayland duplicates the file descriptor when the request is sent
+        close(fd);
+    }
+    wl_buffer *native = zwp_linux_buffer_params_v1_create_immed(params, size.width(), size.height(), drmFormat, 0);
+    zwp_linux_buffer_params_v1_destroy(params);
+    if (!native) {
+        gbm_bo_destroy(bo);
+        return QSharedPointer<Buffer>();
+    }
+    if (queue) {
+        queue->addProxy(native);
+    }
+
+    const QSharedPointer<GbmDevice> bufferDevice = device;
+    QSharedPointer<Buffer> buffer(new Buffer(q, native, bo, size, gbm_bo_get_stride(bo), format), [bufferDevice](Buffer *buffer) {
+        gbm_bo *bo = buffer->bo();
+        delete buffer;
+        gbm_bo_destroy(bo);
+    });
+    buffers[shape].append(buffer);
+    return buffer;
+}
+
+DmaBufPool::DmaBufPool(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+DmaBufPool::~DmaBufPool()
+{
+    release();
+}
+
+void DmaBufPool::release()
+{
+    d->reset();
+    if (d->feedback) {
+        d->feedback->release();
+    }
+    d->dmabuf.release();
+}
+
+void DmaBufPool::destroy()
+{
+    for (const auto &shapeBuffers : qAsConst(d->buffers)) {
+        for (const auto &b : shapeBuffers) {
+            b->d->destroy();
+        }
+    }
+    d->reset();
+    if (d->feedback) {
+        d->feedback->destroy();
+    }
+    d->dmabuf.destroy();
+}
+
+void DmaBufPool::setup(zwp_linux_dmabuf_v1 *dmabuf)
+{
+    Q_ASSERT(dmabuf);
+    Q_ASSERT(!d->dmabuf);
+    d->dmabuf.setup(dmabuf);
+    zwp_linux_dmabuf_v1_add_listener(d->dmabuf, &Private::s_listener, d.data());
+    if (zwp_linux_dmabuf_v1_get_version(d->dmabuf) >= ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
+        d->feedback.reset(new DmaBufFeedback);
+        connect(d->feedback.data(), &DmaBufFeedback::changed, this, [this] {
+            d->updateFormats();
+        });
+        d->feedback->setup(zwp_linux_dmabuf_v1_get_default_feedback(d->dmabuf));
+    } else {
+        const QString path = firstRenderNode();
+        if (path.isEmpty()) {
+            qCDebug(KWAYLAND_CLIENT) << "There is no render node to allocate dma-bufs on";
+        }
+        d->setDevice(path);
+    }
+}
+
+bool DmaBufPool::isValid() const
+{
+    return d->dmabuf.isValid();
+}
+
+void DmaBufPool::setEventQueue(EventQueue *queue)
+{
+    d->queue = queue;
+}
+
+EventQueue *DmaBufPool::eventQueue()
+{
+    return d->queue;
+}
+
+QHash<uint32_t, QVector<uint64_t>> DmaBufPool::formats() const
+{
+    return d->formats;
+}
+
+bool DmaBufPool::supportsFormat(Buffer::Format format) const
+{
+    return d->formats.contains(toDrmFormat(format));
+}
+
+gbm_device *DmaBufPool::device() const
+{
+    return d->device ? d->device->device : nullptr;
+}
+
+Buffer::Ptr DmaBufPool::getBuffer(const QSize &size, Buffer::Format format)
+{
+    if (size.isEmpty() || !isValid()) {
+        return QWeakPointer<Buffer>();
+    }
+    return d->getBuffer(size, format, QVector<uint64_t>());
+}
+
+Buffer::Ptr DmaBufPool::getBuffer(const QSize &size, Buffer::Format format, const QVector<uint64_t> &modifiers)
+{
+    if (size.isEmpty() || !isValid()) {
+        return QWeakPointer<Buffer>();
+    }
+    return d->getBuffer(size, format, modifiers);
+}
+
+DmaBufFeedback *DmaBufPool::createSurfaceFeedback(Surface *surface, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    auto feedback = new DmaBufFeedback(parent);
+    if (zwp_linux_dmabuf_v1_get_version(d->dmabuf) < ZWP_LINUX_DMABUF_V1_GET_SURFACE_FEEDBACK_SINCE_VERSION) {
+        qCDebug(KWAYLAND_CLIENT) << "The compositor doesn't provide dma-buf feedback for surfaces";
+        return feedback;
+    }
+    auto native = zwp_linux_dmabuf_v1_get_surface_feedback(d->dmabuf, *surface);
+    if (d->queue) {
+        d->queue->addProxy(native);
+    }
+    feedback->setup(native);
+    return feedback;
+}
+
+void DmaBufPool::trim()
+{
+    d->reclaimIdleBuffers();
+}
+
+DmaBufPool::operator zwp_linux_dmabuf_v1 *()
+{
+    return d->dmabuf;
+}
+
+DmaBufPool::operator zwp_linux_dmabuf_v1 *() const
+{
+    return d->dmabuf;
+}
+
+}
+}
@@ -0,0 +1,190 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_DMABUF_POOL_H
+#define WAYLAND_DMABUF_POOL_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include "buffer.h"
+#include <DWayland/Client/kwaylandclient_export.h>
+
+class QSize;
+
+struct gbm_device;
+struct zwp_linux_dmabuf_v1;
+
+namespace KWayland
+{
+namespace Client
+{
+class DmaBufFeedback;
+class EventQueue;
+class Surface;
+
+/**
+ * @short Wrapper class for the zwp_linux_dmabuf_v1 interface which allocates GPU Buffers.
+ *
+ * The DmaBufPool is the counterpart of the ShmPool for clients which render with the GPU.
+ * It allocates its Buffers with GBM on the device the compositor renders with and hands them
+ * to the compositor as dma-bufs, so the frames are presented without a copy.
+ *
+ * To use this class one needs to interact with the Registry:
+ * @code
+ * DmaBufPool *pool = registry->createDmaBufPool(name, version);
+ * connect(pool, &DmaBufPool::formatsChanged, this, [pool] {
+ *     auto buffer = pool->getBuffer(QSize(256, 256)).toStrongRef();
+ *     // import buffer->bo() into EGL, e.g. with EGL_KHR_image_base, and render into it
+ * });
+ * @endcode
+ *
+ * The formats and modifiers are taken from the default feedback of the compositor with
+ * version 4 of the interface, the GBM device is opened on the render node of its main device.
+ * With older versions the advertised formats are used on the first render node of the system.
+ * Buffers are allocated with the modifiers of the first tranche that supports the format.
+ *
+ * Like with the ShmPool the Buffers are owned by the DmaBufPool and handed out as QWeakPointer.
+ * A Buffer is reused once it is released by the server and not marked as used. A ShmSwapchain
+ * can render into the Buffers of a DmaBufPool as well.
+ *
+ * @see ShmPool
+ * @see ShmSwapchain
+ **/
+class KWAYLANDCLIENT_EXPORT DmaBufPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DmaBufPool(QObject *parent = nullptr);
+    ~DmaBufPool() override;
+
+    /**
+     * @returns @c true if the DmaBufPool references a zwp_linux_dmabuf_v1 interface.
+     **/
+    bool isValid() const;
+    /**
+     * Setup this DmaBufPool to manage the @p dmabuf.
+     * When using Registry::createDmaBufPool there is no need to call this
+     * method.
+     **/
+    void setup(zwp_linux_dmabuf_v1 *dmabuf);
+    /**
+     * Releases the zwp_linux_dmabuf_v1 interface.
+     * After the interface has been released the DmaBufPool instance is no
+     * longer valid and can be setup with another zwp_linux_dmabuf_v1 interface.
+     *
+     * All Buffers are destroyed.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this DmaBufPool.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. If the connection is not valid anymore, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail. This method cleans up the data, so
+     * that the instance can be deleted or set up to a new zwp_linux_dmabuf_v1 interface
+     * once there is a new connection available.
+     *
+     * All Buffers are destroyed!
+     *
+     * This method is automatically invoked when the Registry which created this
+     * DmaBufPool gets destroyed.
+     *
+     * @see release
+     **/
+    void destroy();
+
+    /**
+     * Sets the @p queue to use for creating a Buffer.
+     **/
+    void setEventQueue(EventQueue *queue);
+    /**
+     * @returns The event queue to use for creating a Buffer.
+     **/
+    EventQueue *eventQueue();
+
+    /**
+     * @returns The DRM formats supported by the compositor with their modifiers. The modifiers
+     * of a format are those of the compositor's most preferred tranche which contains it,
+     * @c DRM_FORMAT_MOD_INVALID stands for an implicit modifier.
+     **/
+    QHash<uint32_t, QVector<uint64_t>> formats() const;
+    /**
+     * @returns @c true if the compositor supports Buffers with @p format.
+     **/
+    bool supportsFormat(Buffer::Format format) const;
+
+    /**
+     * @returns The GBM device the Buffers are allocated on, or @c null if no render node
+     * could be opened. It can be used to create an EGLDisplay with EGL_PLATFORM_GBM_KHR.
+     **/
+    gbm_device *device() const;
+
+    /**
+     * Provides a Buffer with @p size and @p format for rendering.
+     *
+     * If the DmaBufPool fails to provide such a Buffer, e.g. because the compositor doesn't
+     * support the format or no formats were announced yet, a @c null Buffer::Ptr is returned.
+     * A Buffer which was released by the server and is not used anymore is reused.
+     *
+     * @see Buffer::bo
+     **/
+    Buffer::Ptr getBuffer(const QSize &size, Buffer::Format format = Buffer::Format::ARGB32);
+    /**
+     * Provides a Buffer with @p size and @p format allocated with one of the @p modifiers
+     * instead of those of formats, e.g. the modifiers of the scanout tranche of a
+     * DmaBufFeedback.
+     *
+     * @see DmaBufFeedback::formats
+     **/
+    Buffer::Ptr getBuffer(const QSize &size, Buffer::Format format, const QVector<uint64_t> &modifiers);
+    /**
+     * Destroys all Buffers which are neither used nor held by the server.
+     **/
+    void trim();
+
+    /**
+     * Creates the feedback of the compositor for the dma-bufs attached to @p surface.
+     * It is only provided with version 4 of the interface, otherwise the returned
+     * DmaBufFeedback is not valid.
+     *
+     * @param surface The Surface the feedback is for
+     * @param parent The parent to pass to the DmaBufFeedback
+     * @returns The new created DmaBufFeedback
+     **/
+    DmaBufFeedback *createSurfaceFeedback(Surface *surface, QObject *parent = nullptr);
+
+    operator zwp_linux_dmabuf_v1 *();
+    operator zwp_linux_dmabuf_v1 *() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the compositor announced the supported formats or changed them. Buffers
+     * allocated before may not be optimal anymore, so clients should allocate new ones.
+     **/
+    void formatsChanged();
+    /**
+     * This signal is emitted whenever the Wayland server released @p buffer.
+     * @see Buffer::isReleased
+     **/
+    void bufferReleased(KWayland::Client::Buffer *buffer);
+
+    /**
+     * The corresponding global for this interface on the Registry got removed.
+     *
+     * This signal gets only emitted if the DmaBufPool got created by
+     * Registry::createDmaBufPool
+     **/
+    void removed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
@@ -5,7 +5,15 @@
 */
 #include "event_queue.h"
 #include "connection_thread.h"
+#include "connection_thread_p.h"
 #include "wayland_pointer_p.h"
+// Qt
+#include <QAbstractEventDispatcher>
+#include <QPointer>
+#include <QSocketNotifier>
+// system
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #include <wayland-client.h>
 
@@ -16,10 +24,64 @@ namespace Client
 class Q_DECL_HIDDEN EventQueue::Private
 {
 public:
+    void setupWakeup(EventQueue *q, ConnectionThread *connection);
+    void destroyWakeup();
+
     wl_display *display = nullptr;
     WaylandPointer<wl_event_queue, wl_event_queue_destroy> queue;
+    QPointer<ConnectionThread> connection;
+    int wakeupFd = -1;
+    QSocketNotifier *wakeupNotifier = nullptr;
+    QAbstractEventDispatcher *flushDispatcher = nullptr;
 };
 
+void EventQueue::Private::setupWakeup(EventQueue *q, ConnectionThread *connection)
+{
+    wakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeupFd == -1) {
+        // fall back to a queued invocation for each read
+        QObject::connect(
+            connection,
+            &ConnectionThread::eventsRead,
+            q,
+            [q] {
+                if (q->hasPendingEvents()) {
+                    q->dispatch();
+                }
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+    this->connection = connection;
+    wakeupNotifier = new QSocketNotifier(wakeupFd, QSocketNotifier::Read, q);
+    QObject::connect(wakeupNotifier, &QSocketNotifier::activated, q, [this, q] {
+        quint64 count;
+        if (read(wakeupFd, &count, sizeof(count)) != sizeof(count)) {
+            return;
+        }
+        // the events may have been dispatched manually in the meantime
+        if (q->hasPendingEvents()) {
+            q->dispatch();
+        }
+    });
+    ConnectionThread::Private::get(connection)->addQueueWakeup(wakeupFd, queue);
+}
+
+void EventQueue::Private::destroyWakeup()
+{
+    if (wakeupFd == -1) {
+        return;
+    }
+    if (connection) {
+        ConnectionThread::Private::get(connection)->removeQueueWakeup(wakeupFd);
+    }
+    connection.clear();
+    delete wakeupNotifier;
+    wakeupNotifier = nullptr;
+    close(wakeupFd);
+    wakeupFd = -1;
+}
+
 EventQueue::EventQueue(QObject *parent)
     : QObject(parent)
     , d(new Private)
@@ -33,12 +95,14 @@ EventQueue::~EventQueue()
 
 void EventQueue::release()
 {
+    d->destroyWakeup();
     d->queue.release();
     d->display = nullptr;
 }
 
 void EventQueue::destroy()
 {
+    d->destroyWakeup();
     d->queue.destroy();
     d->display = nullptr;
 }
@@ -60,7 +124,7 @@ void EventQueue::setup(wl_display *display)
 void EventQueue::setup(ConnectionThread *connection)
 {
     setup(connection->display());
-    connect(connection, &ConnectionThread::eventsRead, this, &EventQueue::dispatch, Qt::QueuedConnection);
+    d->setupWakeup(this, connection);
 }
 
 void EventQueue::dispatch()
@@ -69,7 +133,25 @@ void EventQueue::dispatch()
         return;
     }
     wl_display_dispatch_queue_pending(d->display, d->queue);
-    wl_display_flush(d->display);
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+    if (!d->connection || !dispatcher) {
+        wl_display_flush(d->display);
+        return;
+    }
+    // requests sent while dispatching get flushed once the event loop of this thread is about
+    // to block, together with everything else sent in this iteration
+    if (dispatcher != d->flushDispatcher) {
+        d->flushDispatcher = dispatcher;
+        ConnectionThread::Private::get(d->connection)->flushOnAboutToBlock(dispatcher);
+    }
+}
+
+bool EventQueue::hasPendingEvents() const
+{
+    if (!d->display || !d->queue) {
+        return false;
+    }
+    return ConnectionThread::Private::hasPendingEvents(d->display, d->queue);
 }
 
 void EventQueue::addProxy(wl_proxy *proxy)
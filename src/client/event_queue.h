@@ -70,9 +70,10 @@ public:
     /**
      * Creates the event queue for the @p connection.
      *
-     * This method also connects the eventsRead signal of the ConnectionThread
-     * to the dispatch method. Events will be automatically dispatched without
-     * the need to call dispatch manually.
+     * This method also sets up an eventfd which the ConnectionThread signals
+     * whenever it read events, dispatch gets invoked from the thread of this
+     * EventQueue as soon as it is signalled. Events will be automatically
+     * dispatched without the need to call dispatch manually.
      * @see dispatch
      **/
     void setup(ConnectionThread *connection);
@@ -115,6 +116,13 @@ public:
     template<typename wl_interface, typename T>
     void addProxy(T *proxy);
 
+    /**
+     * @returns Whether events got read for this EventQueue which are not dispatched yet.
+     * This is cheap and can be called from any thread, e.g. to skip the dispatch of an idle
+     * queue.
+     **/
+    bool hasPendingEvents() const;
+
     operator wl_event_queue *();
     operator wl_event_queue *() const;
 
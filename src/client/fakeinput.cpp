@@ -234,6 +234,66 @@ void FakeInput::requestKeyboardKeyRelease(quint32 linuxKey)
     org_kde_kwin_fake_input_keyboard_key(d->manager, linuxKey, WL_KEYBOARD_KEY_STATE_RELEASED);
 }
 
+void FakeInput::requestEvents(const QVector<Event> &events)
+{
+    Q_ASSERT(d->manager.isValid());
+    org_kde_kwin_fake_input *manager = d->manager;
+    const quint32 version = wl_proxy_get_version(d->manager);
+    const bool absoluteMotion = version >= ORG_KDE_KWIN_FAKE_INPUT_POINTER_MOTION_ABSOLUTE_SINCE_VERSION;
+    const bool keyboardKeys = version >= ORG_KDE_KWIN_FAKE_INPUT_KEYBOARD_KEY_SINCE_VERSION;
+
+    for (const Event &event : events) {
+        const wl_fixed_t x = wl_fixed_from_double(event.value.x());
+        const wl_fixed_t y = wl_fixed_from_double(event.value.y());
+        switch (event.type) {
+        case Event::Type::PointerMove:
+            org_kde_kwin_fake_input_pointer_motion(manager, x, y);
+            break;
+        case Event::Type::PointerMoveAbsolute:
+            if (absoluteMotion) {
+                org_kde_kwin_fake_input_pointer_motion_absolute(manager, x, y);
+            }
+            break;
+        case Event::Type::PointerButtonPress:
+            org_kde_kwin_fake_input_button(manager, event.code, WL_POINTER_BUTTON_STATE_PRESSED);
+            break;
+        case Event::Type::PointerButtonRelease:
+            org_kde_kwin_fake_input_button(manager, event.code, WL_POINTER_BUTTON_STATE_RELEASED);
+            break;
+        case Event::Type::PointerAxis:
+            org_kde_kwin_fake_input_axis(manager,
+                                         event.code == Qt::Horizontal ? WL_POINTER_AXIS_HORIZONTAL_SCROLL : WL_POINTER_AXIS_VERTICAL_SCROLL,
+                                         x);
+            break;
+        case Event::Type::TouchDown:
+            org_kde_kwin_fake_input_touch_down(manager, event.code, x, y);
+            break;
+        case Event::Type::TouchMotion:
+            org_kde_kwin_fake_input_touch_motion(manager, event.code, x, y);
+            break;
+        case Event::Type::TouchUp:
+            org_kde_kwin_fake_input_touch_up(manager, event.code);
+            break;
+        case Event::Type::TouchCancel:
+            org_kde_kwin_fake_input_touch_cancel(manager);
+            break;
+        case Event::Type::TouchFrame:
+            org_kde_kwin_fake_input_touch_frame(manager);
+            break;
+        case Event::Type::KeyboardKeyPress:
+            if (keyboardKeys) {
+                org_kde_kwin_fake_input_keyboard_key(manager, event.code, WL_KEYBOARD_KEY_STATE_PRESSED);
+            }
+            break;
+        case Event::Type::KeyboardKeyRelease:
+            if (keyboardKeys) {
+                org_kde_kwin_fake_input_keyboard_key(manager, event.code, WL_KEYBOARD_KEY_STATE_RELEASED);
+            }
+            break;
+        }
+    }
+}
+
 FakeInput::operator org_kde_kwin_fake_input *() const
 {
     return d->manager;
@@ -7,6 +7,8 @@
 #define KWAYLAND_FAKEINPUT_H
 
 #include <QObject>
+#include <QPointF>
+#include <QVector>
 
 #include <DWayland/Client/kwaylandclient_export.h>
 
@@ -48,6 +50,28 @@ class KWAYLANDCLIENT_EXPORT FakeInput : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * A packed input event for requestEvents.
+     **/
+    struct Event {
+        enum class Type : quint8 {
+            PointerMove, ///< relative motion by @c value
+            PointerMoveAbsolute, ///< absolute motion to @c value
+            PointerButtonPress, ///< press of the linux button @c code
+            PointerButtonRelease, ///< release of the linux button @c code
+            PointerAxis, ///< scrolling by @c value.x(), @c code is the Qt::Orientation
+            TouchDown, ///< touch point @c code goes down at @c value
+            TouchMotion, ///< touch point @c code moves to @c value
+            TouchUp, ///< touch point @c code goes up
+            TouchCancel,
+            TouchFrame,
+            KeyboardKeyPress, ///< press of the linux key @c code
+            KeyboardKeyRelease, ///< release of the linux key @c code
+        };
+        Type type;
+        quint32 code = 0;
+        QPointF value;
+    };
     /**
      * Creates a new FakeInput.
      * Note: after constructing the FakeInput it is not yet valid and one needs
@@ -212,6 +236,16 @@ public:
      **/
     void requestKeyboardKeyRelease(quint32 linuxKey);
 
+    /**
+     * Requests all @p events in one go, e.g. to replay a recorded input session.
+     *
+     * The requests are written into the connection without any per event overhead and reach
+     * the server together with the next flush. Events the server doesn't support, based on the
+     * version of the interface, are skipped. The protocol doesn't carry timestamps, a caller
+     * replaying a recording with its original timing has to split it into batches.
+     **/
+    void requestEvents(const QVector<Event> &events);
+
     operator org_kde_kwin_fake_input *();
     operator org_kde_kwin_fake_input *() const;
 
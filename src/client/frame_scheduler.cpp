@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "frame_scheduler.h"
+#include "output.h"
+#include "outputdevice_v2.h"
+#include "presentationtime.h"
+// Qt
+#include <QPointer>
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN FrameScheduler::Private
+{
+public:
+    Private(FrameScheduler *q);
+
+    void updateRefreshRate(int rate);
+    void updateRefresh(std::chrono::nanoseconds interval);
+    void disconnectOutput();
+
+    int refreshRate = 60000;
+    // the interval reported by the compositor, preferred over the refresh rate
+    std::chrono::nanoseconds refresh = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds lastPresentation = std::chrono::nanoseconds::zero();
+    QMetaObject::Connection outputConnection;
+
+private:
+    FrameScheduler *q;
+};
+
+FrameScheduler::Private::Private(FrameScheduler *q)
+    : q(q)
+{
+}
+
+void FrameScheduler::Private::updateRefreshRate(int rate)
+{
+    if (rate <= 0 || refreshRate == rate) {
+        return;
+    }
+    const auto oldInterval = q->refreshInterval();
+    refreshRate = rate;
+    // a new mode invalidates what the compositor reported for the previous one
+    refresh = std::chrono::nanoseconds::zero();
+    if (q->refreshInterval() != oldInterval) {
+        Q_EMIT q->refreshIntervalChanged();
+    }
+}
+
+void FrameScheduler::Private::updateRefresh(std::chrono::nanoseconds interval)
+{
+    if (interval <= std::chrono::nanoseconds::zero() || refresh == interval) {
+        return;
+    }
+    const auto oldInterval = q->refreshInterval();
+    refresh = interval;
+    if (q->refreshInterval() != oldInterval) {
+        Q_EMIT q->refreshIntervalChanged();
+    }
+}
+
+void FrameScheduler::Private::disconnectOutput()
+{
+    QObject::disconnect(outputConnection);
+    outputConnection = QMetaObject::Connection();
+}
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+FrameScheduler::~FrameScheduler() = default;
+
+void FrameScheduler::setRefreshRate(int refreshRate)
+{
+    d->updateRefreshRate(refreshRate);
+}
+
+int FrameScheduler::refreshRate() const
+{
+    return d->refreshRate;
+}
+
+void FrameScheduler::setOutput(Output *output)
+{
+    d->disconnectOutput();
+    if (!output) {
+        return;
+    }
+    d->outputConnection = connect(output, &Output::changed, this, [this, output] {
+        d->updateRefreshRate(output->refreshRate());
+    });
+    d->updateRefreshRate(output->refreshRate());
+}
+
+void FrameScheduler::setOutputDevice(OutputDeviceV2 *outputDevice)
+{
+    d->disconnectOutput();
+    if (!outputDevice) {
+        return;
+    }
+    d->outputConnection = connect(outputDevice, &OutputDeviceV2::changed, this, [this, outputDevice] {
+        d->updateRefreshRate(outputDevice->refreshRate());
+    });
+    d->updateRefreshRate(outputDevice->refreshRate());
+}
+
+std::chrono::nanoseconds FrameScheduler::refreshInterval() const
+{
+    if (d->refresh > std::chrono::nanoseconds::zero()) {
+        return d->refresh;
+    }
+    return std::chrono::nanoseconds(1000000000000ll / d->refreshRate);
+}
+
+void FrameScheduler::presented(std::chrono::nanoseconds timestamp, std::chrono::nanoseconds refresh)
+{
+    d->lastPresentation = timestamp;
+    d->updateRefresh(refresh);
+}
+
+void FrameScheduler::presented(const PresentationFeedback *feedback)
+{
+    presented(feedback->timestamp(), feedback->refresh());
+}
+
+void FrameScheduler::reset()
+{
+    d->lastPresentation = std::chrono::nanoseconds::zero();
+}
+
+std::chrono::nanoseconds FrameScheduler::lastPresentation() const
+{
+    return d->lastPresentation;
+}
+
+std::chrono::nanoseconds FrameScheduler::nextPresentation(std::chrono::nanoseconds now) const
+{
+    const std::chrono::nanoseconds interval = refreshInterval();
+    if (d->lastPresentation == std::chrono::nanoseconds::zero()) {
+        return now + interval;
+    }
+    if (now < d->lastPresentation) {
+        return d->lastPresentation + interval;
+    }
+    // the next vblank strictly after now, missed ones are skipped
+    const auto elapsed = (now - d->lastPresentation) / interval;
+    return d->lastPresentation + (elapsed + 1) * interval;
+}
+
+}
+}
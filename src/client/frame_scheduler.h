@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_FRAME_SCHEDULER_H
+#define WAYLAND_FRAME_SCHEDULER_H
+
+#include <QObject>
+// std
+#include <chrono>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class Output;
+class OutputDeviceV2;
+class PresentationFeedback;
+
+/**
+ * @short Predicts when the next frame of a Surface turns visible.
+ *
+ * The FrameScheduler combines the refresh rate of the Output a Surface is shown on with the
+ * timestamps reported through PresentationFeedback. Animation clients can use the predicted
+ * presentation time to advance their animations to the moment the frame is actually going
+ * to be seen instead of the moment it got rendered:
+ * @code
+ * FrameScheduler scheduler;
+ * scheduler.setOutput(output);
+ *
+ * auto feedback = presentationTime->createFeedback(surface);
+ * connect(feedback, &PresentationFeedback::presented, this, [feedback, &scheduler] {
+ *     scheduler.presented(feedback);
+ *     feedback->deleteLater();
+ * });
+ * surface->commit();
+ *
+ * // when rendering the next frame
+ * animation.advanceTo(scheduler.nextPresentation(now));
+ * @endcode
+ *
+ * All timestamps have to be taken from the clock announced by PresentationTime::clockId.
+ *
+ * @see PresentationTime
+ * @see PresentationFeedback
+ **/
+class KWAYLANDCLIENT_EXPORT FrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameScheduler(QObject *parent = nullptr);
+    ~FrameScheduler() override;
+
+    /**
+     * Sets the refresh rate in mHz used when no presentation feedback provided the
+     * refresh interval yet, by default 60000.
+     **/
+    void setRefreshRate(int refreshRate);
+    /**
+     * @returns The refresh rate in mHz.
+     **/
+    int refreshRate() const;
+    /**
+     * Follows the refresh rate of @p output. Pass @c null to stop following it.
+     **/
+    void setOutput(Output *output);
+    /**
+     * Follows the refresh rate of @p outputDevice. Pass @c null to stop following it.
+     **/
+    void setOutputDevice(OutputDeviceV2 *outputDevice);
+
+    /**
+     * @returns The time between two frames. The refresh interval last reported through
+     * presented takes precedence over the refresh rate.
+     **/
+    std::chrono::nanoseconds refreshInterval() const;
+
+    /**
+     * Records that a frame turned visible at @p timestamp. A non zero @p refresh is the
+     * interval until the next possible presentation as reported by the compositor.
+     **/
+    void presented(std::chrono::nanoseconds timestamp, std::chrono::nanoseconds refresh = std::chrono::nanoseconds::zero());
+    /**
+     * Records the timing information of the presented @p feedback.
+     * @overload
+     **/
+    void presented(const PresentationFeedback *feedback);
+    /**
+     * Forgets the last presentation, e.g. after the Surface got hidden.
+     **/
+    void reset();
+
+    /**
+     * @returns The time of the last presentation or @c 0 if there was none.
+     **/
+    std::chrono::nanoseconds lastPresentation() const;
+    /**
+     * @returns The earliest presentation time after @p now, predicted from the last
+     * presentation and the refresh interval. Without a previous presentation the
+     * prediction is one refresh interval after @p now.
+     **/
+    std::chrono::nanoseconds nextPresentation(std::chrono::nanoseconds now) const;
+
+Q_SIGNALS:
+    /**
+     * Emitted whenever the refreshInterval changed.
+     **/
+    void refreshIntervalChanged();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
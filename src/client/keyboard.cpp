@@ -6,9 +6,16 @@
 #include "keyboard.h"
 #include "surface.h"
 #include "wayland_pointer_p.h"
+#include <QMutex>
 #include <QPointer>
+#include <QVector>
 // wayland
 #include <wayland-client-protocol.h>
+// system
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace KWayland
 {
@@ -27,6 +34,7 @@ public:
         qint32 charactersPerSecond = 0;
         qint32 delay = 0;
     } repeatInfo;
+    QByteArray keymap;
 
 private:
     void enter(uint32_t serial, wl_surface *surface, wl_array *keys);
@@ -126,6 +134,102 @@ void Keyboard::Private::keyCallback(void *data, wl_keyboard *keyboard, uint32_t
     Q_EMIT k->q->keyChanged(key, toState(), time);
 }
 
+namespace
+{
+/**
+ * The recently received keymaps, shared by all Keyboards of the process.
+ *
+ * A compositor usually sends the same keymap to every keyboard, often as one sealed file.
+ * A keymap read from the same sealed file is recognized without mapping it again, any other
+ * keymap is compared with the cached ones, so identical keymaps share their data.
+ */
+class KeymapCache
+{
+public:
+    QByteArray keymap(int fd, quint32 size);
+
+private:
+    static QByteArray read(int fd, quint32 size);
+
+    struct Entry {
+        dev_t device;
+        ino_t inode;
+        bool sealed;
+        quint32 size;
+        QByteArray keymap;
+    };
+    // a few entries cover the keymaps of all seats and a layout switch
+    static constexpr int s_size = 4;
+    QMutex m_mutex;
+    QVector<Entry> m_entries;
+};
+
+QByteArray KeymapCache::keymap(int fd, quint32 size)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return QByteArray();
+    }
+    bool sealed = false;
+#ifdef F_GET_SEALS
+    const int seals = fcntl(fd, F_GET_SEALS);
+    sealed = seals != -1 && (seals & F_SEAL_WRITE) && (seals & F_SEAL_SHRINK);
+#endif
+
+    QMutexLocker locker(&m_mutex);
+    if (sealed) {
+        for (int i = 0; i < m_entries.count(); ++i) {
+            const Entry &entry = m_entries.at(i);
+            if (entry.sealed && entry.device == st.st_dev && entry.inode == st.st_ino && entry.size == size) {
+                // the content of a sealed file can't have changed
+                m_entries.move(i, 0);
+                return m_entries.first().keymap;
+            }
+        }
+    }
+
+    const QByteArray keymap = read(fd, size);
+    if (keymap.isEmpty()) {
+        return keymap;
+    }
+    for (int i = 0; i < m_entries.count(); ++i) {
+        if (m_entries.at(i).keymap == keymap) {
+            Entry entry = m_entries.takeAt(i);
+            entry.device = st.st_dev;
+            entry.inode = st.st_ino;
+            entry.sealed = sealed;
+            entry.size = size;
+            m_entries.prepend(entry);
+            return entry.keymap;
+        }
+    }
+    m_entries.prepend(Entry{st.st_dev, st.st_ino, sealed, size, keymap});
+    if (m_entries.count() > s_size) {
+        m_entries.removeLast();
+    }
+    return keymap;
+}
+
+QByteArray KeymapCache::read(int fd, quint32 size)
+{
+    if (size == 0) {
+        return QByteArray();
+    }
+    // the keymap has to be mapped privately, it might be shared with other clients
+    void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        return QByteArray();
+    }
+    // the size includes the terminating null byte
+    const char *data = static_cast<const char *>(address);
+    const QByteArray keymap(data, strnlen(data, size));
+    munmap(address, size);
+    return keymap;
+}
+
+Q_GLOBAL_STATIC(KeymapCache, s_keymapCache)
+}
+
 void Keyboard::Private::keymapCallback(void *data, wl_keyboard *keyboard, uint32_t format, int fd, uint32_t size)
 {
     auto k = reinterpret_cast<Keyboard::Private *>(data);
@@ -133,7 +237,14 @@ void Keyboard::Private::keymapCallback(void *data, wl_keyboard *keyboard, uint32
     if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
         return;
     }
+    // read before the signal, the receiver owns the file descriptor
+    const QByteArray keymap = s_keymapCache->keymap(fd, size);
+    const bool contentChanged = keymap != k->keymap;
+    k->keymap = keymap;
     Q_EMIT k->q->keymapChanged(fd, size);
+    if (contentChanged) {
+        Q_EMIT k->q->keymapContentChanged(keymap);
+    }
 }
 
 void Keyboard::Private::modifiersCallback(void *data,
@@ -184,6 +295,11 @@ qint32 Keyboard::keyRepeatDelay() const
     return d->repeatInfo.delay;
 }
 
+QByteArray Keyboard::keymap() const
+{
+    return d->keymap;
+}
+
 qint32 Keyboard::keyRepeatRate() const
 {
     return d->repeatInfo.charactersPerSecond;
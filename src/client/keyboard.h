@@ -6,6 +6,7 @@
 #ifndef WAYLAND_KEYBOARD_H
 #define WAYLAND_KEYBOARD_H
 
+#include <QByteArray>
 #include <QObject>
 
 #include <DWayland/Client/kwaylandclient_export.h>
@@ -107,6 +108,18 @@ public:
      **/
     qint32 keyRepeatDelay() const;
 
+    /**
+     * @returns The content of the current keymap in the libxkbcommon text format, or an empty
+     * QByteArray if no keymap has been received yet.
+     *
+     * The keymap is read once when it is received. Keyboards with identical keymaps, e.g. of
+     * several seats or after the keyboard got bound again, share the data of the QByteArray,
+     * so a client can reuse a compiled xkb_keymap for the same constData().
+     *
+     * @see keymapContentChanged
+     **/
+    QByteArray keymap() const;
+
     operator wl_keyboard *();
     operator wl_keyboard *() const;
 
@@ -135,6 +148,13 @@ Q_SIGNALS:
      * @param size The size of the keymap
      **/
     void keymapChanged(int fd, quint32 size);
+    /**
+     * Emitted after keymapChanged if the content of the keymap changed.
+     *
+     * @param keymap The new keymap
+     * @see keymap
+     **/
+    void keymapContentChanged(const QByteArray &keymap);
     /**
      * A key was pressed or released.
      * The time argument is a timestamp with millisecond granularity, with an undefined base.
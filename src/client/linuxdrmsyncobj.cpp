@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "linuxdrmsyncobj.h"
+#include "event_queue.h"
+#include "surface.h"
+#include "wayland_pointer_p.h"
+
+#include <wayland-linux-drm-syncobj-v1-client-protocol.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN LinuxDrmSyncObjManager::Private
+{
+public:
+    WaylandPointer<wp_linux_drm_syncobj_manager_v1, wp_linux_drm_syncobj_manager_v1_destroy> manager;
+    EventQueue *queue = nullptr;
+};
+
+LinuxDrmSyncObjManager::LinuxDrmSyncObjManager(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+LinuxDrmSyncObjManager::~LinuxDrmSyncObjManager()
+{
+    release();
+}
+
+void LinuxDrmSyncObjManager::setup(wp_linux_drm_syncobj_manager_v1 *manager)
+{
+    Q_ASSERT(manager);
+    Q_ASSERT(!d->manager);
+    d->manager.setup(manager);
+}
+
+void LinuxDrmSyncObjManager::release()
+{
+    d->manager.release();
+}
+
+void LinuxDrmSyncObjManager::destroy()
+{
+    d->manager.destroy();
+}
+
+LinuxDrmSyncObjManager::operator wp_linux_drm_syncobj_manager_v1 *()
+{
+    return d->manager;
+}
+
+LinuxDrmSyncObjManager::operator wp_linux_drm_syncobj_manager_v1 *() const
+{
+    return d->manager;
+}
+
+bool LinuxDrmSyncObjManager::isValid() const
+{
+    return d->manager.isValid();
+}
+
+void LinuxDrmSyncObjManager::setEventQueue(EventQueue *queue)
+{
+    d->queue = queue;
+}
+
+EventQueue *LinuxDrmSyncObjManager::eventQueue()
+{
+    return d->queue;
+}
+
+LinuxDrmSyncObjTimeline *LinuxDrmSyncObjManager::importTimeline(int fd, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    auto t = new LinuxDrmSyncObjTimeline(parent);
+    auto w = wp_linux_drm_syncobj_manager_v1_import_timeline(d->manager, fd);
+    if (d->queue) {
+        d->queue->addProxy(w);
+    }
+    t->setup(w);
+    return t;
+}
+
+LinuxDrmSyncObjSurface *LinuxDrmSyncObjManager::getSurface(Surface *surface, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    auto s = new LinuxDrmSyncObjSurface(parent);
+    auto w = wp_linux_drm_syncobj_manager_v1_get_surface(d->manager, *surface);
+    if (d->queue) {
+        d->queue->addProxy(w);
+    }
+    s->setup(w);
+    return s;
+}
+
+class Q_DECL_HIDDEN LinuxDrmSyncObjTimeline::Private
+{
+public:
+    WaylandPointer<wp_linux_drm_syncobj_timeline_v1, wp_linux_drm_syncobj_timeline_v1_destroy> timeline;
+};
+
+LinuxDrmSyncObjTimeline::LinuxDrmSyncObjTimeline(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+LinuxDrmSyncObjTimeline::~LinuxDrmSyncObjTimeline()
+{
+    release();
+}
+
+void LinuxDrmSyncObjTimeline::setup(wp_linux_drm_syncobj_timeline_v1 *timeline)
+{
+    Q_ASSERT(timeline);
+    Q_ASSERT(!d->timeline);
+    d->timeline.setup(timeline);
+}
+
+void LinuxDrmSyncObjTimeline::release()
+{
+    d->timeline.release();
+}
+
+void LinuxDrmSyncObjTimeline::destroy()
+{
+    d->timeline.destroy();
+}
+
+bool LinuxDrmSyncObjTimeline::isValid() const
+{
+    return d->timeline.isValid();
+}
+
+LinuxDrmSyncObjTimeline::operator wp_linux_drm_syncobj_timeline_v1 *()
+{
+    return d->timeline;
+}
+
+LinuxDrmSyncObjTimeline::operator wp_linux_drm_syncobj_timeline_v1 *() const
+{
+    return d->timeline;
+}
+
+class Q_DECL_HIDDEN LinuxDrmSyncObjSurface::Private
+{
+public:
+    WaylandPointer<wp_linux_drm_syncobj_surface_v1, wp_linux_drm_syncobj_surface_v1_destroy> surface;
+};
+
+LinuxDrmSyncObjSurface::LinuxDrmSyncObjSurface(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+LinuxDrmSyncObjSurface::~LinuxDrmSyncObjSurface()
+{
+    release();
+}
+
+void LinuxDrmSyncObjSurface::setup(wp_linux_drm_syncobj_surface_v1 *surface)
+{
+    Q_ASSERT(surface);
+    Q_ASSERT(!d->surface);
+    d->surface.setup(surface);
+}
+
+void LinuxDrmSyncObjSurface::release()
+{
+    d->surface.release();
+}
+
+void LinuxDrmSyncObjSurface::destroy()
+{
+    d->surface.destroy();
+}
+
+bool LinuxDrmSyncObjSurface::isValid() const
+{
+    return d->surface.isValid();
+}
+
+void LinuxDrmSyncObjSurface::setAcquirePoint(LinuxDrmSyncObjTimeline *timeline, quint64 point)
+{
+    Q_ASSERT(isValid());
+    wp_linux_drm_syncobj_surface_v1_set_acquire_point(d->surface, *timeline, point >> 32, point & 0xffffffff);
+}
+
+void LinuxDrmSyncObjSurface::setReleasePoint(LinuxDrmSyncObjTimeline *timeline, quint64 point)
+{
+    Q_ASSERT(isValid());
+    wp_linux_drm_syncobj_surface_v1_set_release_point(d->surface, *timeline, point >> 32, point & 0xffffffff);
+}
+
+LinuxDrmSyncObjSurface::operator wp_linux_drm_syncobj_surface_v1 *()
+{
+    return d->surface;
+}
+
+LinuxDrmSyncObjSurface::operator wp_linux_drm_syncobj_surface_v1 *() const
+{
+    return d->surface;
+}
+
+}
+}
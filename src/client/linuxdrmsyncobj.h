@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_LINUXDRMSYNCOBJ_H
+#define WAYLAND_LINUXDRMSYNCOBJ_H
+
+#include <QObject>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+struct wp_linux_drm_syncobj_manager_v1;
+struct wp_linux_drm_syncobj_timeline_v1;
+struct wp_linux_drm_syncobj_surface_v1;
+
+namespace KWayland
+{
+namespace Client
+{
+class EventQueue;
+class LinuxDrmSyncObjSurface;
+class LinuxDrmSyncObjTimeline;
+class Surface;
+
+/**
+ * @short Wrapper for the wp_linux_drm_syncobj_manager_v1 interface.
+ *
+ * Explicit synchronization lets a client hand its dma-buf Buffers to the compositor before the
+ * GPU finished rendering into them. The compositor waits for an acquire point on a DRM
+ * synchronization object timeline before it uses the Buffer, and signals a release point once
+ * the client may reuse it, instead of relying on implicit fences.
+ *
+ * To use this class one needs to interact with the Registry:
+ * @code
+ * LinuxDrmSyncObjManager *m = registry->createLinuxDrmSyncObjManager(name, version);
+ * LinuxDrmSyncObjTimeline *timeline = m->importTimeline(syncObjFd);
+ * LinuxDrmSyncObjSurface *s = m->getSurface(surface);
+ * surface->attachBuffer(buffer);
+ * s->setAcquirePoint(timeline, 1);
+ * s->setReleasePoint(timeline, 2);
+ * surface->commit();
+ * @endcode
+ *
+ * @see Registry
+ **/
+class KWAYLANDCLIENT_EXPORT LinuxDrmSyncObjManager : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Creates a new LinuxDrmSyncObjManager.
+     * Note: after constructing the LinuxDrmSyncObjManager it is not yet valid and one needs
+     * to call setup. In order to get a ready to use LinuxDrmSyncObjManager prefer using
+     * Registry::createLinuxDrmSyncObjManager.
+     **/
+    explicit LinuxDrmSyncObjManager(QObject *parent = nullptr);
+    ~LinuxDrmSyncObjManager() override;
+
+    /**
+     * Setup this LinuxDrmSyncObjManager to manage the @p manager.
+     * When using Registry::createLinuxDrmSyncObjManager there is no need to call this
+     * method.
+     **/
+    void setup(wp_linux_drm_syncobj_manager_v1 *manager);
+    /**
+     * @returns @c true if managing a wp_linux_drm_syncobj_manager_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_linux_drm_syncobj_manager_v1 interface.
+     * After the interface has been released the LinuxDrmSyncObjManager instance is no
+     * longer valid and can be setup with another wp_linux_drm_syncobj_manager_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this LinuxDrmSyncObjManager.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. Once the connection becomes invalid, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail.
+     **/
+    void destroy();
+
+    /**
+     * Sets the @p queue to use for creating objects with this LinuxDrmSyncObjManager.
+     **/
+    void setEventQueue(EventQueue *queue);
+    /**
+     * @returns The event queue to use for creating objects with this LinuxDrmSyncObjManager.
+     **/
+    EventQueue *eventQueue();
+
+    /**
+     * Imports the DRM synchronization object timeline @p fd, e.g. exported with
+     * drmSyncobjHandleToFD. The file descriptor is not taken over, the caller still has to
+     * close it.
+     **/
+    LinuxDrmSyncObjTimeline *importTimeline(int fd, QObject *parent = nullptr);
+    /**
+     * Creates the explicit synchronization object of @p surface. A Surface can only have one
+     * at a time.
+     **/
+    LinuxDrmSyncObjSurface *getSurface(Surface *surface, QObject *parent = nullptr);
+
+    operator wp_linux_drm_syncobj_manager_v1 *();
+    operator wp_linux_drm_syncobj_manager_v1 *() const;
+
+Q_SIGNALS:
+    /**
+     * The corresponding global for this interface on the Registry got removed.
+     *
+     * This signal gets only emitted if the LinuxDrmSyncObjManager got created by
+     * Registry::createLinuxDrmSyncObjManager
+     **/
+    void removed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Wrapper for the wp_linux_drm_syncobj_timeline_v1 interface.
+ *
+ * @see LinuxDrmSyncObjManager
+ **/
+class KWAYLANDCLIENT_EXPORT LinuxDrmSyncObjTimeline : public QObject
+{
+    Q_OBJECT
+public:
+    ~LinuxDrmSyncObjTimeline() override;
+
+    /**
+     * Setup this LinuxDrmSyncObjTimeline to manage the @p timeline.
+     * When using LinuxDrmSyncObjManager::importTimeline there is no need to call this
+     * method.
+     **/
+    void setup(wp_linux_drm_syncobj_timeline_v1 *timeline);
+    /**
+     * @returns @c true if managing a wp_linux_drm_syncobj_timeline_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_linux_drm_syncobj_timeline_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this LinuxDrmSyncObjTimeline.
+     **/
+    void destroy();
+
+    operator wp_linux_drm_syncobj_timeline_v1 *();
+    operator wp_linux_drm_syncobj_timeline_v1 *() const;
+
+private:
+    friend class LinuxDrmSyncObjManager;
+    explicit LinuxDrmSyncObjTimeline(QObject *parent = nullptr);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Wrapper for the wp_linux_drm_syncobj_surface_v1 interface.
+ *
+ * The points are double buffered state of the Surface, they apply to the Buffer attached with
+ * the next commit. Every commit attaching a Buffer needs both points, and they must not be the
+ * same point of the same timeline.
+ *
+ * @see LinuxDrmSyncObjManager
+ **/
+class KWAYLANDCLIENT_EXPORT LinuxDrmSyncObjSurface : public QObject
+{
+    Q_OBJECT
+public:
+    ~LinuxDrmSyncObjSurface() override;
+
+    /**
+     * Setup this LinuxDrmSyncObjSurface to manage the @p surface.
+     * When using LinuxDrmSyncObjManager::getSurface there is no need to call this
+     * method.
+     **/
+    void setup(wp_linux_drm_syncobj_surface_v1 *surface);
+    /**
+     * @returns @c true if managing a wp_linux_drm_syncobj_surface_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_linux_drm_syncobj_surface_v1 interface. The Surface goes back to
+     * implicit synchronization with its next commit.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this LinuxDrmSyncObjSurface.
+     **/
+    void destroy();
+
+    /**
+     * The compositor waits for @p point of @p timeline to be signalled before it uses the
+     * Buffer attached with the next commit.
+     **/
+    void setAcquirePoint(LinuxDrmSyncObjTimeline *timeline, quint64 point);
+    /**
+     * The compositor signals @p point of @p timeline once it no longer uses the Buffer attached
+     * with the next commit.
+     **/
+    void setReleasePoint(LinuxDrmSyncObjTimeline *timeline, quint64 point);
+
+    operator wp_linux_drm_syncobj_surface_v1 *();
+    operator wp_linux_drm_syncobj_surface_v1 *() const;
+
+private:
+    friend class LinuxDrmSyncObjManager;
+    explicit LinuxDrmSyncObjSurface(QObject *parent = nullptr);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
@@ -9,6 +9,8 @@
 #include <QPoint>
 #include <QRect>
 #include <QVector>
+// std
+#include <utility>
 // wayland
 #include <wayland-client-protocol.h>
 
@@ -30,15 +32,29 @@ public:
 
     WaylandPointer<wl_output, wl_output_release> output;
     EventQueue *queue = nullptr;
-    QSize physicalSize;
-    QPoint globalPosition;
-    QString manufacturer;
-    QString model;
-    int scale = 1;
-    SubPixel subPixel = SubPixel::Unknown;
-    Transform transform = Transform::Normal;
-    Modes modes;
-    Modes::iterator currentMode = modes.end();
+
+    struct State {
+        QSize physicalSize;
+        QPoint globalPosition;
+        QString manufacturer;
+        QString model;
+        int scale = 1;
+        SubPixel subPixel = SubPixel::Unknown;
+        Transform transform = Transform::Normal;
+        Modes modes;
+        // index in modes, -1 if there is no current mode
+        int currentMode = -1;
+
+        const Mode *current() const
+        {
+            return currentMode == -1 ? nullptr : &modes.at(currentMode);
+        }
+    };
+    // the events are collected in pending and applied together on done
+    State current;
+    State pending;
+    // the mode signals of pending, with whether the mode got added
+    QVector<QPair<Mode, bool>> pendingModeSignals;
 
     static Output *get(wl_output *o);
 
@@ -56,14 +72,9 @@ private:
     static void modeCallback(void *data, wl_output *output, uint32_t flags, int32_t width, int32_t height, int32_t refresh);
     static void doneCallback(void *data, wl_output *output);
     static void scaleCallback(void *data, wl_output *output, int32_t scale);
-    void setPhysicalSize(const QSize &size);
-    void setGlobalPosition(const QPoint &pos);
-    void setManufacturer(const QString &manufacturer);
-    void setModel(const QString &model);
-    void setScale(int scale);
-    void setSubPixel(SubPixel subPixel);
-    void setTransform(Transform transform);
     void addMode(uint32_t flags, int32_t width, int32_t height, int32_t refresh);
+    void applyPending();
+    void applyIfUnbuffered();
 
     Output *q;
     static struct wl_output_listener s_outputListener;
@@ -136,10 +147,10 @@ void Output::Private::geometryCallback(void *data,
     Q_UNUSED(transform)
     auto o = reinterpret_cast<Output::Private *>(data);
     Q_ASSERT(o->output == output);
-    o->setGlobalPosition(QPoint(x, y));
-    o->setManufacturer(make);
-    o->setModel(model);
-    o->setPhysicalSize(QSize(physicalWidth, physicalHeight));
+    o->pending.globalPosition = QPoint(x, y);
+    o->pending.manufacturer = QString::fromUtf8(make);
+    o->pending.model = QString::fromUtf8(model);
+    o->pending.physicalSize = QSize(physicalWidth, physicalHeight);
     auto toSubPixel = [subPixel]() {
         switch (subPixel) {
         case WL_OUTPUT_SUBPIXEL_NONE:
@@ -157,7 +168,7 @@ void Output::Private::geometryCallback(void *data,
             return SubPixel::Unknown;
         }
     };
-    o->setSubPixel(toSubPixel());
+    o->pending.subPixel = toSubPixel();
     auto toTransform = [transform]() {
         switch (transform) {
         case WL_OUTPUT_TRANSFORM_90:
@@ -179,7 +190,8 @@ void Output::Private::geometryCallback(void *data,
             return Transform::Normal;
         }
     };
-    o->setTransform(toTransform());
+    o->pending.transform = toTransform();
+    o->applyIfUnbuffered();
 }
 
 void Output::Private::modeCallback(void *data, wl_output *output, uint32_t flags, int32_t width, int32_t height, int32_t refresh)
@@ -187,6 +199,7 @@ void Output::Private::modeCallback(void *data, wl_output *output, uint32_t flags
     auto o = reinterpret_cast<Output::Private *>(data);
     Q_ASSERT(o->output == output);
     o->addMode(flags, width, height, refresh);
+    o->applyIfUnbuffered();
 }
 
 void Output::Private::addMode(uint32_t flags, int32_t width, int32_t height, int32_t refresh)
@@ -201,6 +214,7 @@ void Output::Private::addMode(uint32_t flags, int32_t width, int32_t height, int
     if (flags & WL_OUTPUT_MODE_PREFERRED) {
         mode.flags |= Mode::Flag::Preferred;
     }
+    Modes &modes = pending.modes;
     auto currentIt = modes.insert(modes.end(), mode);
     bool existing = false;
     if (flags & WL_OUTPUT_MODE_CURRENT) {
@@ -209,7 +223,7 @@ void Output::Private::addMode(uint32_t flags, int32_t width, int32_t height, int
             auto &m = (*it);
             if (m.flags.testFlag(Mode::Flag::Current)) {
                 m.flags &= ~Mode::Flags(Mode::Flag::Current);
-                Q_EMIT q->modeChanged(m);
+                pendingModeSignals.append(qMakePair(m, false));
             }
             if (m.refreshRate == mode.refreshRate && m.size == mode.size) {
                 it = modes.erase(it);
@@ -218,100 +232,121 @@ void Output::Private::addMode(uint32_t flags, int32_t width, int32_t height, int
                 it++;
             }
         }
-        currentMode = currentIt;
-    }
-    if (existing) {
-        Q_EMIT q->modeChanged(mode);
-    } else {
-        Q_EMIT q->modeAdded(mode);
+        // the new mode is the last one
+        pending.currentMode = modes.count() - 1;
     }
+    pendingModeSignals.append(qMakePair(mode, !existing));
 }
 
 void Output::Private::scaleCallback(void *data, wl_output *output, int32_t scale)
 {
     auto o = reinterpret_cast<Output::Private *>(data);
     Q_ASSERT(o->output == output);
-    o->setScale(scale);
+    o->pending.scale = scale;
+    o->applyIfUnbuffered();
 }
 
 void Output::Private::doneCallback(void *data, wl_output *output)
 {
     auto o = reinterpret_cast<Output::Private *>(data);
     Q_ASSERT(o->output == output);
+    o->applyPending();
     Q_EMIT o->q->changed();
 }
 
-void Output::setup(wl_output *output)
-{
-    d->setup(output);
-}
-
-EventQueue *Output::eventQueue() const
+void Output::Private::applyIfUnbuffered()
 {
-    return d->queue;
-}
-
-void Output::setEventQueue(EventQueue *queue)
-{
-    d->queue = queue;
+    // before version 2 there is no done event, each event stands on its own
+    if (wl_output_get_version(output) < WL_OUTPUT_DONE_SINCE_VERSION) {
+        applyPending();
+        Q_EMIT q->changed();
+    }
 }
 
-void Output::Private::setGlobalPosition(const QPoint &pos)
+void Output::Private::applyPending()
 {
-    globalPosition = pos;
-}
+    Changes changes;
+    if (current.globalPosition != pending.globalPosition) {
+        changes |= Change::GlobalPosition;
+    }
+    if (current.physicalSize != pending.physicalSize) {
+        changes |= Change::PhysicalSize;
+    }
+    if (current.manufacturer != pending.manufacturer) {
+        changes |= Change::Manufacturer;
+    }
+    if (current.model != pending.model) {
+        changes |= Change::Model;
+    }
+    if (current.subPixel != pending.subPixel) {
+        changes |= Change::SubPixel;
+    }
+    if (current.transform != pending.transform) {
+        changes |= Change::Transform;
+    }
+    if (current.scale != pending.scale) {
+        changes |= Change::Scale;
+    }
+    if (!pendingModeSignals.isEmpty()) {
+        changes |= Change::Modes;
+    }
+    const Mode *previousMode = current.current();
+    const Mode *pendingMode = pending.current();
+    if (bool(previousMode) != bool(pendingMode)
+        || (previousMode && (previousMode->size != pendingMode->size || previousMode->refreshRate != pendingMode->refreshRate))) {
+        changes |= Change::CurrentMode;
+    }
 
-void Output::Private::setManufacturer(const QString &m)
-{
-    manufacturer = m;
+    current = pending;
+    const auto modeSignals = std::exchange(pendingModeSignals, {});
+    for (const auto &modeSignal : modeSignals) {
+        if (modeSignal.second) {
+            Q_EMIT q->modeAdded(modeSignal.first);
+        } else {
+            Q_EMIT q->modeChanged(modeSignal.first);
+        }
+    }
+    if (changes) {
+        Q_EMIT q->propertiesChanged(changes);
+    }
 }
 
-void Output::Private::setModel(const QString &m)
+void Output::setup(wl_output *output)
 {
-    model = m;
+    d->setup(output);
 }
 
-void Output::Private::setPhysicalSize(const QSize &size)
+EventQueue *Output::eventQueue() const
 {
-    physicalSize = size;
+    return d->queue;
 }
 
-void Output::Private::setScale(int s)
+void Output::setEventQueue(EventQueue *queue)
 {
-    scale = s;
+    d->queue = queue;
 }
 
 QRect Output::geometry() const
 {
-    if (d->currentMode == d->modes.end()) {
+    if (d->current.currentMode == -1) {
         return QRect();
     }
-    return QRect(d->globalPosition, pixelSize());
-}
-
-void Output::Private::setSubPixel(Output::SubPixel s)
-{
-    subPixel = s;
-}
-
-void Output::Private::setTransform(Output::Transform t)
-{
-    transform = t;
+    return QRect(d->current.globalPosition, pixelSize());
 }
 
 QPoint Output::globalPosition() const
 {
-    return d->globalPosition;
+    return d->current.globalPosition;
 }
 
 QString Output::manufacturer() const
 {
-    return d->manufacturer;
+    return d->current.manufacturer;
 }
 
 QString Output::model() const
 {
-    return d->model;
+    return d->current.model;
 }
 
 wl_output *Output::output()
@@ -321,28 +356,24 @@ wl_output *Output::output()
 
 QSize Output::physicalSize() const
 {
-    return d->physicalSize;
+    return d->current.physicalSize;
 }
 
 QSize Output::pixelSize() const
 {
-    if (d->currentMode == d->modes.end()) {
-        return QSize();
-    }
-    return (*d->currentMode).size;
+    const Mode *mode = d->current.current();
+    return mode ? mode->size : QSize();
 }
 
 int Output::refreshRate() const
 {
-    if (d->currentMode == d->modes.end()) {
-        return 0;
-    }
-    return (*d->currentMode).refreshRate;
+    const Mode *mode = d->current.current();
+    return mode ? mode->refreshRate : 0;
 }
 
 int Output::scale() const
 {
-    return d->scale;
+    return d->current.scale;
 }
 
 bool Output::isValid() const
@@ -352,17 +383,17 @@ bool Output::isValid() const
 
 Output::SubPixel Output::subPixel() const
 {
-    return d->subPixel;
+    return d->current.subPixel;
 }
 
 Output::Transform Output::transform() const
 {
-    return d->transform;
+    return d->current.transform;
 }
 
 QList<Output::Mode> Output::modes() const
 {
-    return d->modes;
+    return d->current.modes;
 }
 
 Output::operator wl_output *()
@@ -73,6 +73,28 @@ public:
         Flipped180,
         Flipped270,
     };
+    /**
+     * The properties which changed between two done events.
+     * @see propertiesChanged
+     **/
+    enum class Change {
+        GlobalPosition = 1 << 0,
+        PhysicalSize = 1 << 1,
+        Manufacturer = 1 << 2,
+        Model = 1 << 3,
+        SubPixel = 1 << 4,
+        Transform = 1 << 5,
+        Scale = 1 << 6,
+        /**
+         * A Mode got added or changed.
+         **/
+        Modes = 1 << 7,
+        /**
+         * The size or the refresh rate of the current Mode changed.
+         **/
+        CurrentMode = 1 << 8,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
     struct Mode {
         enum class Flag {
             None = 0,
@@ -207,6 +229,12 @@ Q_SIGNALS:
      * Emitted whenever at least one of the data changed.
      **/
     void changed();
+    /**
+     * Emitted right before changed when the compositor sent new values for the properties
+     * in @p changes. All values of one update are applied at once, so the getters never
+     * return a mix of the old and the new state.
+     **/
+    void propertiesChanged(KWayland::Client::Output::Changes changes);
     /**
      * Emitted whenever a new Mode is added.
      * This normally only happens during the initial promoting of modes.
@@ -237,6 +265,7 @@ private:
     QScopedPointer<Private> d;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Output::Changes)
 Q_DECLARE_OPERATORS_FOR_FLAGS(Output::Mode::Flags)
 
 }
@@ -246,5 +275,6 @@ Q_DECLARE_METATYPE(KWayland::Client::Output *)
 Q_DECLARE_METATYPE(KWayland::Client::Output::SubPixel)
 Q_DECLARE_METATYPE(KWayland::Client::Output::Transform)
 Q_DECLARE_METATYPE(KWayland::Client::Output::Mode)
+Q_DECLARE_METATYPE(KWayland::Client::Output::Changes)
 
 #endif
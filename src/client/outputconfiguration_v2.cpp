@@ -11,6 +11,10 @@
 #include "wayland-kde-output-device-v2-client-protocol.h"
 #include "wayland-kde-output-management-v2-client-protocol.h"
 
+#include <QPointer>
+
+#include <optional>
+
 namespace KWayland
 {
 namespace Client
@@ -28,11 +32,117 @@ public:
 
     OutputConfigurationV2 *q;
 
+    // the settings are collected until apply, only the last value of each is sent and only if
+    // it differs from what the output device already uses
+    struct Changes {
+        QPointer<OutputDeviceV2> device;
+        std::optional<OutputDeviceV2::Enablement> enabled;
+        QPointer<DeviceModeV2> mode;
+        std::optional<int> brightness;
+        std::optional<OutputDeviceV2::Transform> transform;
+        std::optional<QPoint> position;
+        std::optional<qreal> scale;
+        std::optional<uint32_t> overscan;
+        std::optional<OutputDeviceV2::VrrPolicy> vrrPolicy;
+        std::optional<uint32_t> rgbRange;
+    };
+    QVector<Changes> changes;
+    std::optional<QPointer<OutputDeviceV2>> primaryOutput;
+
+    Changes &changesFor(OutputDeviceV2 *outputdevice);
+    void sendChanges();
+
 private:
     static void appliedCallback(void *data, kde_output_configuration_v2 *config);
     static void failedCallback(void *data, kde_output_configuration_v2 *config);
 };
 
+OutputConfigurationV2::Private::Changes &OutputConfigurationV2::Private::changesFor(OutputDeviceV2 *outputdevice)
+{
+    for (Changes &deviceChanges : changes) {
+        if (deviceChanges.device == outputdevice) {
+            return deviceChanges;
+        }
+    }
+    changes.append(Changes());
+    changes.last().device = outputdevice;
+    return changes.last();
+}
+
+static wl_output_transform toWaylandTransform(OutputDeviceV2::Transform transform)
+{
+    switch (transform) {
+    case OutputDeviceV2::Transform::Normal:
+        return WL_OUTPUT_TRANSFORM_NORMAL;
+    case OutputDeviceV2::Transform::Rotated90:
+        return WL_OUTPUT_TRANSFORM_90;
+    case OutputDeviceV2::Transform::Rotated180:
+        return WL_OUTPUT_TRANSFORM_180;
+    case OutputDeviceV2::Transform::Rotated270:
+        return WL_OUTPUT_TRANSFORM_270;
+    case OutputDeviceV2::Transform::Flipped:
+        return WL_OUTPUT_TRANSFORM_FLIPPED;
+    case OutputDeviceV2::Transform::Flipped90:
+        return WL_OUTPUT_TRANSFORM_FLIPPED_90;
+    case OutputDeviceV2::Transform::Flipped180:
+        return WL_OUTPUT_TRANSFORM_FLIPPED_180;
+    case OutputDeviceV2::Transform::Flipped270:
+        return WL_OUTPUT_TRANSFORM_FLIPPED_270;
+    }
+    abort();
+}
+
+void OutputConfigurationV2::Private::sendChanges()
+{
+    const quint32 version = wl_proxy_get_version(outputconfiguration);
+    const QVector<Changes> allChanges = std::exchange(changes, {});
+    for (const Changes &deviceChanges : allChanges) {
+        OutputDeviceV2 *device = deviceChanges.device;
+        if (!device || !device->isValid()) {
+            continue;
+        }
+        kde_output_device_v2 *od = device->output();
+        if (deviceChanges.enabled && *deviceChanges.enabled != device->enabled()) {
+            kde_output_configuration_v2_enable(outputconfiguration, od, *deviceChanges.enabled == OutputDeviceV2::Enablement::Enabled ? 1 : 0);
+        }
+        if (deviceChanges.mode && deviceChanges.mode != device->currentMode()) {
+            kde_output_configuration_v2_mode(outputconfiguration, od, *deviceChanges.mode);
+        }
+        if (deviceChanges.brightness) {
+            // the output device doesn't report its brightness
+            kde_output_configuration_v2_brightness(outputconfiguration, od, *deviceChanges.brightness);
+        }
+        if (deviceChanges.transform && *deviceChanges.transform != device->transform()) {
+            kde_output_configuration_v2_transform(outputconfiguration, od, toWaylandTransform(*deviceChanges.transform));
+        }
+        if (deviceChanges.position && *deviceChanges.position != device->globalPosition()) {
+            kde_output_configuration_v2_position(outputconfiguration, od, deviceChanges.position->x(), deviceChanges.position->y());
+        }
+        if (deviceChanges.scale && !qFuzzyCompare(*deviceChanges.scale, device->scaleF())) {
+            kde_output_configuration_v2_scale(outputconfiguration, od, wl_fixed_from_double(*deviceChanges.scale));
+        }
+        if (deviceChanges.overscan && *deviceChanges.overscan != device->overscan()
+            && version >= KDE_OUTPUT_CONFIGURATION_V2_OVERSCAN_SINCE_VERSION) {
+            kde_output_configuration_v2_overscan(outputconfiguration, od, *deviceChanges.overscan);
+        }
+        if (deviceChanges.vrrPolicy && *deviceChanges.vrrPolicy != device->vrrPolicy()
+            && version >= KDE_OUTPUT_CONFIGURATION_V2_SET_VRR_POLICY_SINCE_VERSION) {
+            kde_output_configuration_v2_set_vrr_policy(outputconfiguration, od, static_cast<uint32_t>(*deviceChanges.vrrPolicy));
+        }
+        if (deviceChanges.rgbRange && *deviceChanges.rgbRange != device->rgbRange()
+            && version >= KDE_OUTPUT_CONFIGURATION_V2_SET_RGB_RANGE_SINCE_VERSION) {
+            kde_output_configuration_v2_set_rgb_range(outputconfiguration, od, *deviceChanges.rgbRange);
+        }
+    }
+    if (primaryOutput) {
+        OutputDeviceV2 *device = *primaryOutput;
+        if (device && device->isValid() && version >= KDE_OUTPUT_CONFIGURATION_V2_SET_PRIMARY_OUTPUT_SINCE_VERSION) {
+            kde_output_configuration_v2_set_primary_output(outputconfiguration, device->output());
+        }
+        primaryOutput.reset();
+    }
+}
+
 OutputConfigurationV2::OutputConfigurationV2(QObject *parent)
     : QObject(parent)
     , d(new Private)
@@ -97,59 +207,27 @@ bool OutputConfigurationV2::isValid() const
 
 void OutputConfigurationV2::setEnabled(OutputDeviceV2 *outputdevice, OutputDeviceV2::Enablement enable)
 {
-    qint32 _enable = 0;
-    if (enable == OutputDeviceV2::Enablement::Enabled) {
-        _enable = 1;
-    }
-    kde_output_device_v2 *od = outputdevice->output();
-    kde_output_configuration_v2_enable(d->outputconfiguration, od, _enable);
+    d->changesFor(outputdevice).enabled = enable;
 }
 
 void OutputConfigurationV2::setMode(OutputDeviceV2 *outputdevice, const int modeId)
 {
-    kde_output_device_v2 *od = outputdevice->output();
-    kde_output_configuration_v2_mode(d->outputconfiguration, od, *outputdevice->deviceModeFromId(modeId));
+    d->changesFor(outputdevice).mode = outputdevice->deviceModeFromId(modeId);
 }
 
 void OutputConfigurationV2::setBrightness(OutputDeviceV2 *outputdevice, const int brightness)
 {
-    kde_output_device_v2 *od = outputdevice->output();
-    kde_output_configuration_v2_brightness(d->outputconfiguration, od,
-                                          brightness);
+    d->changesFor(outputdevice).brightness = brightness;
 }
 
 void OutputConfigurationV2::setTransform(OutputDeviceV2 *outputdevice, KWayland::Client::OutputDeviceV2::Transform transform)
 {
-    auto toTransform = [transform]() {
-        switch (transform) {
-            using KWayland::Client::OutputDeviceV2;
-        case KWayland::Client::OutputDeviceV2::Transform::Normal:
-            return WL_OUTPUT_TRANSFORM_NORMAL;
-        case KWayland::Client::OutputDeviceV2::Transform::Rotated90:
-            return WL_OUTPUT_TRANSFORM_90;
-        case KWayland::Client::OutputDeviceV2::Transform::Rotated180:
-            return WL_OUTPUT_TRANSFORM_180;
-        case KWayland::Client::OutputDeviceV2::Transform::Rotated270:
-            return WL_OUTPUT_TRANSFORM_270;
-        case KWayland::Client::OutputDeviceV2::Transform::Flipped:
-            return WL_OUTPUT_TRANSFORM_FLIPPED;
-        case KWayland::Client::OutputDeviceV2::Transform::Flipped90:
-            return WL_OUTPUT_TRANSFORM_FLIPPED_90;
-        case KWayland::Client::OutputDeviceV2::Transform::Flipped180:
-            return WL_OUTPUT_TRANSFORM_FLIPPED_180;
-        case KWayland::Client::OutputDeviceV2::Transform::Flipped270:
-            return WL_OUTPUT_TRANSFORM_FLIPPED_270;
-        }
-        abort();
-    };
-    kde_output_device_v2 *od = outputdevice->output();
-    kde_output_configuration_v2_transform(d->outputconfiguration, od, toTransform());
+    d->changesFor(outputdevice).transform = transform;
 }
 
 void OutputConfigurationV2::setPosition(OutputDeviceV2 *outputdevice, const QPoint &pos)
 {
-    kde_output_device_v2 *od = outputdevice->output();
-    kde_output_configuration_v2_position(d->outputconfiguration, od, pos.x(), pos.y());
+    d->changesFor(outputdevice).position = pos;
 }
 
 void OutputConfigurationV2::setScale(OutputDeviceV2 *outputdevice, qint32 scale)
@@ -159,8 +237,7 @@ void OutputConfigurationV2::setScale(OutputDeviceV2 *outputdevice, qint32 scale)
 
 void OutputConfigurationV2::setScaleF(OutputDeviceV2 *outputdevice, qreal scale)
 {
-    kde_output_device_v2 *od = outputdevice->output();
-    kde_output_configuration_v2_scale(d->outputconfiguration, od, wl_fixed_from_double(scale));
+    d->changesFor(outputdevice).scale = scale;
 }
 
 void OutputConfigurationV2::setColorCurves(OutputDeviceV2 *outputdevice, QVector<quint16> red, QVector<quint16> green, QVector<quint16> blue)
@@ -190,36 +267,27 @@ void OutputConfigurationV2::setColorCurves(OutputDeviceV2 *outputdevice, QVector
 
 void OutputConfigurationV2::setOverscan(OutputDeviceV2 *outputdevice, uint32_t overscan)
 {
-    kde_output_device_v2 *od = outputdevice->output();
-    if (wl_proxy_get_version(d->outputconfiguration) >= KDE_OUTPUT_CONFIGURATION_V2_OVERSCAN_SINCE_VERSION) {
-        kde_output_configuration_v2_overscan(d->outputconfiguration, od, overscan);
-    }
+    d->changesFor(outputdevice).overscan = overscan;
 }
 
 void OutputConfigurationV2::setVrrPolicy(OutputDeviceV2 *outputdevice, OutputDeviceV2::VrrPolicy policy)
 {
-    if (wl_proxy_get_version(d->outputconfiguration) >= KDE_OUTPUT_CONFIGURATION_V2_SET_VRR_POLICY_SINCE_VERSION) {
-        kde_output_device_v2 *od = outputdevice->output();
-        kde_output_configuration_v2_set_vrr_policy(d->outputconfiguration, od, static_cast<uint32_t>(policy));
-    }
+    d->changesFor(outputdevice).vrrPolicy = policy;
 }
 
 void OutputConfigurationV2::setRgbRange(OutputDeviceV2 *outputdevice, uint32_t rgbRange)
 {
-    if (wl_proxy_get_version(d->outputconfiguration) >= KDE_OUTPUT_CONFIGURATION_V2_SET_RGB_RANGE_SINCE_VERSION) {
-        kde_output_configuration_v2_set_rgb_range(d->outputconfiguration, outputdevice->output(), rgbRange);
-    }
+    d->changesFor(outputdevice).rgbRange = rgbRange;
 }
 
 void OutputConfigurationV2::setPrimaryOutput(OutputDeviceV2 *outputdevice)
 {
-    if (wl_proxy_get_version(d->outputconfiguration) >= KDE_OUTPUT_CONFIGURATION_V2_SET_PRIMARY_OUTPUT_SINCE_VERSION) {
-        kde_output_configuration_v2_set_primary_output(d->outputconfiguration, outputdevice->output());
-    }
+    d->primaryOutput = QPointer<OutputDeviceV2>(outputdevice);
 }
 
 void OutputConfigurationV2::apply()
 {
+    d->sendChanges();
     kde_output_configuration_v2_apply(d->outputconfiguration);
 }
 
@@ -48,6 +48,10 @@ class EventQueue;
  * hardware changes can be tested in their new combination, they done in parallel.and rolled back
  * as a whole.
  *
+ * The set* calls are collected until @c apply(). Setting a property several times only sends
+ * the last value, and values the OutputDeviceV2 already uses are not sent at all, so a
+ * configuration tool may set up the complete layout and the compositor only gets the delta.
+ *
  * \verbatim
     // We're just picking the first of our outputdevices
     KWayland::Client::OutputDeviceV2 *output = m_clientOutputs.first();
@@ -249,6 +253,8 @@ public:
      * while, so the interval between calling apply() and receiving the applied()
      * signal may be considerable, depending on the hardware.
      *
+     * Only the changes which differ from the current state of the output devices are sent.
+     *
      * @see applied()
      * @see failed()
      */
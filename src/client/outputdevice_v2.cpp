@@ -10,6 +10,8 @@
 #include <QDebug>
 #include <QPoint>
 #include <QRect>
+// std
+#include <utility>
 // wayland
 #include <wayland-kde-output-device-v2-client-protocol.h>
 #include <wayland-client-protocol.h>
@@ -27,30 +29,39 @@ public:
 
     WaylandPointer<kde_output_device_v2, kde_output_device_v2_destroy> output;
     EventQueue *queue = nullptr;
-    QSize physicalSize;
-    QPoint globalPosition;
-    QString manufacturer;
-    QString model;
-    qreal scale = 1.0;
-    QString serialNumber;
-    QString eisaId;
-    SubPixel subPixel = SubPixel::Unknown;
-    Transform transform = Transform::Normal;
-
-    QByteArray edid;
-    OutputDeviceV2::Enablement enabled = OutputDeviceV2::Enablement::Enabled;
-    QByteArray uuid;
-
-    Capabilities capabilities;
-    uint32_t overscan = 0;
-    VrrPolicy vrrPolicy = VrrPolicy::Automatic;
-
-    uint32_t rgbRange;
-    QString outputName;
-
-    bool done = false;
-
-    DeviceModeV2 *m_mode;
+
+    struct State {
+        QSize physicalSize;
+        QPoint globalPosition;
+        QString manufacturer;
+        QString model;
+        qreal scale = 1.0;
+        QString serialNumber;
+        QString eisaId;
+        SubPixel subPixel = SubPixel::Unknown;
+        Transform transform = Transform::Normal;
+
+        // base64 encoded as sent, it's only decoded when asked for
+        QByteArray edid;
+        OutputDeviceV2::Enablement enabled = OutputDeviceV2::Enablement::Enabled;
+        QByteArray uuid;
+
+        Capabilities capabilities;
+        uint32_t overscan = 0;
+        VrrPolicy vrrPolicy = VrrPolicy::Automatic;
+
+        uint32_t rgbRange = 0;
+        QString outputName;
+
+        DeviceModeV2 *currentMode = nullptr;
+    };
+    // the events are collected in pending and applied together on done
+    State current;
+    State pending;
+
+    mutable QByteArray decodedEdid;
+    mutable bool edidDecoded = false;
+
     QList<DeviceModeV2 *> m_modes;
 
 private:
@@ -83,17 +94,9 @@ private:
     static void colorRgbRangeCallback(void *data, kde_output_device_v2 *output, uint32_t rgb_range);
     static void nameCallback(void *data, kde_output_device_v2 *output, const char *name);
 
-    void setPhysicalSize(const QSize &size);
-    void setGlobalPosition(const QPoint &pos);
-    void setManufacturer(const QString &manufacturer);
-    void setModel(const QString &model);
-    void setScale(qreal scale);
-    void setSerialNumber(const QString &serialNumber);
-    void setEisaId(const QString &eisaId);
-    void setSubPixel(SubPixel subPixel);
-    void setTransform(Transform transform);
     void handleCurrentMode(kde_output_device_mode_v2 *mode);
     void addMode(kde_output_device_mode_v2 *mode);
+    void applyPending();
 
     OutputDeviceV2 *q;
     static struct kde_output_device_v2_listener s_outputListener;
@@ -155,10 +158,10 @@ void OutputDeviceV2::Private::geometryCallback(void *data,
     Q_UNUSED(transform)
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_ASSERT(o->output == output);
-    o->setGlobalPosition(QPoint(x, y));
-    o->setManufacturer(make);
-    o->setModel(model);
-    o->setPhysicalSize(QSize(physicalWidth, physicalHeight));
+    o->pending.globalPosition = QPoint(x, y);
+    o->pending.manufacturer = QString::fromUtf8(make);
+    o->pending.model = QString::fromUtf8(model);
+    o->pending.physicalSize = QSize(physicalWidth, physicalHeight);
     auto toSubPixel = [subPixel]() {
         switch (subPixel) {
         case WL_OUTPUT_SUBPIXEL_NONE:
@@ -176,7 +179,7 @@ void OutputDeviceV2::Private::geometryCallback(void *data,
             return SubPixel::Unknown;
         }
     };
-    o->setSubPixel(toSubPixel());
+    o->pending.subPixel = toSubPixel();
     auto toTransform = [transform]() {
         switch (transform) {
         case WL_OUTPUT_TRANSFORM_90:
@@ -198,7 +201,7 @@ void OutputDeviceV2::Private::geometryCallback(void *data,
             return Transform::Normal;
         }
     };
-    o->setTransform(toTransform());
+    o->pending.transform = toTransform();
 }
 
 void OutputDeviceV2::Private::currentModeCallback(void *data, kde_output_device_v2 *output, kde_output_device_mode_v2 *mode)
@@ -212,13 +215,11 @@ void OutputDeviceV2::Private::handleCurrentMode(kde_output_device_mode_v2 *mode)
 {
     auto m = DeviceModeV2::get(mode);
 
-    if (*m == *m_mode) {
+    if (pending.currentMode && *m == *pending.currentMode) {
         // unchanged
         return;
     }
-    m_mode = m;
-
-    Q_EMIT q->currentModeChanged(m);
+    pending.currentMode = m;
 }
 
 void OutputDeviceV2::Private::modeCallback(void *data, kde_output_device_v2 *output, kde_output_device_mode_v2 *mode)
@@ -232,14 +233,17 @@ void OutputDeviceV2::Private::addMode(kde_output_device_mode_v2 *mode)
 {
     DeviceModeV2 *m = new DeviceModeV2(this, mode);
     // last mode sent is the current one
-    m_mode = m;
+    pending.currentMode = m;
     m_modes.append(m);
 
     connect(m, &DeviceModeV2::removed, this, [this, m]() {
         m_modes.removeOne(m);
-        if (m_mode == m) {
+        for (State *state : {&current, &pending}) {
+            if (state->currentMode != m) {
+                continue;
+            }
             if (!m_modes.isEmpty()) {
-                m_mode = m_modes.first();
+                state->currentMode = m_modes.first();
             } else {
                 // was last mode
                 qFatal("KWaylandBackend: no output modes available anymore, this seems like a compositor bug");
@@ -253,30 +257,101 @@ void OutputDeviceV2::Private::addMode(kde_output_device_mode_v2 *mode)
 
 DeviceModeV2* OutputDeviceV2::currentMode() const
 {
-    return d->m_mode;
+    return d->current.currentMode;
 }
 
 void OutputDeviceV2::Private::scaleCallback(void *data, kde_output_device_v2 *output, int32_t scale)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_ASSERT(o->output == output);
-    o->setScale(scale);
+    o->pending.scale = scale;
 }
 
 void OutputDeviceV2::Private::doneCallback(void *data, kde_output_device_v2 *output)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_ASSERT(o->output == output);
-    o->done = true;
+    o->applyPending();
     Q_EMIT o->q->changed();
     Q_EMIT o->q->done();
 }
 
+void OutputDeviceV2::Private::applyPending()
+{
+    const State previous = std::exchange(current, pending);
+    Changes changes;
+    if (previous.globalPosition != current.globalPosition) {
+        changes |= Change::GlobalPosition;
+    }
+    if (previous.physicalSize != current.physicalSize) {
+        changes |= Change::PhysicalSize;
+    }
+    if (previous.manufacturer != current.manufacturer) {
+        changes |= Change::Manufacturer;
+    }
+    if (previous.model != current.model) {
+        changes |= Change::Model;
+    }
+    if (previous.subPixel != current.subPixel) {
+        changes |= Change::SubPixel;
+    }
+    if (previous.transform != current.transform) {
+        changes |= Change::Transform;
+    }
+    if (previous.scale != current.scale) {
+        changes |= Change::Scale;
+    }
+    if (previous.serialNumber != current.serialNumber) {
+        changes |= Change::SerialNumber;
+    }
+    if (previous.eisaId != current.eisaId) {
+        changes |= Change::EisaId;
+    }
+    if (previous.edid != current.edid) {
+        changes |= Change::Edid;
+        edidDecoded = false;
+        decodedEdid.clear();
+    }
+    if (previous.rgbRange != current.rgbRange) {
+        changes |= Change::RgbRange;
+    }
+    if (previous.outputName != current.outputName) {
+        changes |= Change::Name;
+    }
+    if (previous.enabled != current.enabled) {
+        changes |= Change::Enabled;
+        Q_EMIT q->enabledChanged(current.enabled);
+    }
+    if (previous.uuid != current.uuid) {
+        changes |= Change::Uuid;
+        Q_EMIT q->uuidChanged(current.uuid);
+    }
+    if (previous.currentMode != current.currentMode) {
+        changes |= Change::CurrentMode;
+        Q_EMIT q->currentModeChanged(current.currentMode);
+    }
+    if (previous.capabilities != current.capabilities) {
+        changes |= Change::Capabilities;
+        Q_EMIT q->capabilitiesChanged(current.capabilities);
+    }
+    if (previous.overscan != current.overscan) {
+        changes |= Change::Overscan;
+        Q_EMIT q->overscanChanged(current.overscan);
+    }
+    if (previous.vrrPolicy != current.vrrPolicy) {
+        changes |= Change::VrrPolicy;
+        Q_EMIT q->vrrPolicyChanged(current.vrrPolicy);
+    }
+    if (changes) {
+        Q_EMIT q->propertiesChanged(changes);
+    }
+}
+
 void OutputDeviceV2::Private::edidCallback(void *data, kde_output_device_v2 *output, const char *raw)
 {
     Q_UNUSED(output);
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
-    o->edid = QByteArray::fromBase64(raw);
+    o->pending.edid = QByteArray(raw);
 }
 
 void OutputDeviceV2::Private::enabledCallback(void *data, kde_output_device_v2 *output, int32_t enabled)
@@ -288,95 +363,63 @@ void OutputDeviceV2::Private::enabledCallback(void *data, kde_output_device_v2 *
     if (enabled) {
         _enabled = OutputDeviceV2::Enablement::Enabled;
     }
-    if (o->enabled != _enabled) {
-        o->enabled = _enabled;
-        Q_EMIT o->q->enabledChanged(o->enabled);
-        if (o->done) {
-            Q_EMIT o->q->changed();
-        }
-    }
+    o->pending.enabled = _enabled;
 }
 
 void OutputDeviceV2::Private::uuidCallback(void *data, kde_output_device_v2 *output, const char *uuid)
 {
     Q_UNUSED(output);
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
-    if (o->uuid != uuid) {
-        o->uuid = uuid;
-        Q_EMIT o->q->uuidChanged(o->uuid);
-        if (o->done) {
-            Q_EMIT o->q->changed();
-        }
-    }
+    o->pending.uuid = uuid;
 }
 
 void OutputDeviceV2::Private::serialNumberCallback(void *data, kde_output_device_v2 *output, const char *raw)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_UNUSED(output);
-    o->setSerialNumber(raw);
+    o->pending.serialNumber = QString::fromUtf8(raw);
 }
 
 void OutputDeviceV2::Private::eisaIdCallback(void *data, kde_output_device_v2 *output, const char *raw)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_UNUSED(output);
-    o->setEisaId(raw);
+    o->pending.eisaId = QString::fromUtf8(raw);
 }
 
 void OutputDeviceV2::Private::capabilitiesCallback(void *data, kde_output_device_v2 *output, uint32_t capabilities)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_UNUSED(output);
-    auto caps = static_cast<Capabilities>(capabilities);
-    if (o->capabilities != caps) {
-        o->capabilities = caps;
-        Q_EMIT o->q->capabilitiesChanged(caps);
-        if (o->done) {
-            Q_EMIT o->q->changed();
-        }
-    }
+    o->pending.capabilities = static_cast<Capabilities>(capabilities);
 }
 
 void OutputDeviceV2::Private::overscanCallback(void *data, kde_output_device_v2 *output, uint32_t overscan)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_UNUSED(output);
-    if (o->overscan != overscan) {
-        o->overscan = overscan;
-        Q_EMIT o->q->overscanChanged(overscan);
-        if (o->done) {
-            Q_EMIT o->q->changed();
-        }
-    }
+    o->pending.overscan = overscan;
 }
 
 void OutputDeviceV2::Private::vrrPolicyCallback(void *data, kde_output_device_v2 *output, uint32_t vrr_policy)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private*>(data);
     Q_UNUSED(output);
-    auto vrrPolicy = static_cast<VrrPolicy>(vrr_policy);
-    if (o->vrrPolicy != vrrPolicy) {
-        o->vrrPolicy = vrrPolicy;
-        Q_EMIT o->q->vrrPolicyChanged(vrrPolicy);
-        if (o->done) {
-            Q_EMIT o->q->changed();
-        }
-    }
+    o->pending.vrrPolicy = static_cast<VrrPolicy>(vrr_policy);
 }
 
 void OutputDeviceV2::Private::colorRgbRangeCallback(void *data, kde_output_device_v2 *output, uint32_t rgb_range)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_UNUSED(output);
-    o->rgbRange = rgb_range;
+    o->pending.rgbRange = rgb_range;
 }
 
 void OutputDeviceV2::Private::nameCallback(void *data, kde_output_device_v2 *output, const char *name)
 {
     auto o = reinterpret_cast<OutputDeviceV2::Private *>(data);
     Q_UNUSED(output);
-    o->outputName = name;
+    o->pending.outputName = QString::fromUtf8(name);
 }
 
 void OutputDeviceV2::setup(kde_output_device_v2 *output)
@@ -394,82 +437,37 @@ void OutputDeviceV2::setEventQueue(EventQueue *queue)
     d->queue = queue;
 }
 
-void OutputDeviceV2::Private::setGlobalPosition(const QPoint &pos)
-{
-    globalPosition = pos;
-}
-
-void OutputDeviceV2::Private::setManufacturer(const QString &m)
-{
-    manufacturer = m;
-}
-
-void OutputDeviceV2::Private::setModel(const QString &m)
-{
-    model = m;
-}
-
-void OutputDeviceV2::Private::setSerialNumber(const QString &sn)
-{
-    serialNumber = sn;
-}
-
-void OutputDeviceV2::Private::setEisaId(const QString &e)
-{
-    eisaId = e;
-}
-
-void OutputDeviceV2::Private::setPhysicalSize(const QSize &size)
-{
-    physicalSize = size;
-}
-
-void OutputDeviceV2::Private::setScale(qreal s)
-{
-    scale = s;
-}
-
 QRect OutputDeviceV2::geometry() const
 {
     if (!currentMode()) {
         return QRect();
     }
-    return QRect(d->globalPosition, currentMode()->size());
-}
-
-void OutputDeviceV2::Private::setSubPixel(OutputDeviceV2::SubPixel s)
-{
-    subPixel = s;
-}
-
-void OutputDeviceV2::Private::setTransform(OutputDeviceV2::Transform t)
-{
-    transform = t;
+    return QRect(d->current.globalPosition, currentMode()->size());
 }
 
 QPoint OutputDeviceV2::globalPosition() const
 {
-    return d->globalPosition;
+    return d->current.globalPosition;
 }
 
 QString OutputDeviceV2::manufacturer() const
 {
-    return d->manufacturer;
+    return d->current.manufacturer;
 }
 
 QString OutputDeviceV2::model() const
 {
-    return d->model;
+    return d->current.model;
 }
 
 QString OutputDeviceV2::serialNumber() const
 {
-    return d->serialNumber;
+    return d->current.serialNumber;
 }
 
 QString OutputDeviceV2::eisaId() const
 {
-    return d->eisaId;
+    return d->current.eisaId;
 }
 
 kde_output_device_v2 *OutputDeviceV2::output()
@@ -479,7 +477,7 @@ kde_output_device_v2 *OutputDeviceV2::output()
 
 QSize OutputDeviceV2::physicalSize() const
 {
-    return d->physicalSize;
+    return d->current.physicalSize;
 }
 
 QSize OutputDeviceV2::pixelSize() const
@@ -494,12 +492,12 @@ int OutputDeviceV2::refreshRate() const
 
 int OutputDeviceV2::scale() const
 {
-    return qRound(d->scale);
+    return qRound(d->current.scale);
 }
 
 qreal OutputDeviceV2::scaleF() const
 {
-    return d->scale;
+    return d->current.scale;
 }
 
 bool OutputDeviceV2::isValid() const
@@ -509,12 +507,12 @@ bool OutputDeviceV2::isValid() const
 
 OutputDeviceV2::SubPixel OutputDeviceV2::subPixel() const
 {
-    return d->subPixel;
+    return d->current.subPixel;
 }
 
 OutputDeviceV2::Transform OutputDeviceV2::transform() const
 {
-    return d->transform;
+    return d->current.transform;
 }
 
 QList<DeviceModeV2*> OutputDeviceV2::modes() const
@@ -534,42 +532,46 @@ OutputDeviceV2::operator kde_output_device_v2 *() const
 
 QByteArray OutputDeviceV2::edid() const
 {
-    return d->edid;
+    if (!d->edidDecoded) {
+        d->decodedEdid = QByteArray::fromBase64(d->current.edid);
+        d->edidDecoded = true;
+    }
+    return d->decodedEdid;
 }
 
 OutputDeviceV2::Enablement OutputDeviceV2::enabled() const
 {
-    return d->enabled;
+    return d->current.enabled;
 }
 
 QByteArray OutputDeviceV2::uuid() const
 {
-    return d->uuid;
+    return d->current.uuid;
 }
 
 OutputDeviceV2::Capabilities OutputDeviceV2::capabilities() const
 {
-    return d->capabilities;
+    return d->current.capabilities;
 }
 
 uint32_t OutputDeviceV2::overscan() const
 {
-    return d->overscan;
+    return d->current.overscan;
 }
 
 OutputDeviceV2::VrrPolicy OutputDeviceV2::vrrPolicy() const
 {
-    return d->vrrPolicy;
+    return d->current.vrrPolicy;
 }
 
 uint32_t OutputDeviceV2::rgbRange() const
 {
-    return d->rgbRange;
+    return d->current.rgbRange;
 }
 
 QString OutputDeviceV2::outputName() const
 {
-    return d->outputName;
+    return d->current.outputName;
 }
 
 void OutputDeviceV2::destroy()
@@ -94,6 +94,31 @@ public:
         Always = 1,
         Automatic = 2
     };
+    /**
+     * The properties which changed between two done events.
+     * @see propertiesChanged
+     **/
+    enum class Change {
+        GlobalPosition = 1 << 0,
+        PhysicalSize = 1 << 1,
+        Manufacturer = 1 << 2,
+        Model = 1 << 3,
+        SubPixel = 1 << 4,
+        Transform = 1 << 5,
+        Scale = 1 << 6,
+        SerialNumber = 1 << 7,
+        EisaId = 1 << 8,
+        Edid = 1 << 9,
+        Enabled = 1 << 10,
+        Uuid = 1 << 11,
+        Capabilities = 1 << 12,
+        Overscan = 1 << 13,
+        VrrPolicy = 1 << 14,
+        RgbRange = 1 << 15,
+        Name = 1 << 16,
+        CurrentMode = 1 << 17,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
 
     explicit OutputDeviceV2(QObject *parent = nullptr);
     ~OutputDeviceV2() override;
@@ -263,6 +288,12 @@ Q_SIGNALS:
      * Emitted whenever at least one of the data changed.
      **/
     void changed();
+    /**
+     * Emitted right before changed when the compositor sent new values for the properties
+     * in @p changes. All values of one update are applied at once on the done event, the
+     * signals of the single properties are emitted right before this one.
+     **/
+    void propertiesChanged(KWayland::Client::OutputDeviceV2::Changes changes);
     /**
      * Emitted whenever the enabled property changes.
      **/
@@ -326,11 +357,14 @@ private:
     QScopedPointer<Private> d;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(OutputDeviceV2::Changes)
+
 }
 }
 
 Q_DECLARE_METATYPE(KWayland::Client::OutputDeviceV2::SubPixel)
 Q_DECLARE_METATYPE(KWayland::Client::OutputDeviceV2::Transform)
 Q_DECLARE_METATYPE(KWayland::Client::OutputDeviceV2::Enablement)
+Q_DECLARE_METATYPE(KWayland::Client::OutputDeviceV2::Changes)
 
 #endif
@@ -8,6 +8,7 @@
 #include "output.h"
 #include "surface.h"
 #include "wayland_pointer_p.h"
+#include "wrapperindex_p.h"
 // Wayland
 #include <wayland-plasma-shell-client-protocol.h>
 
@@ -28,6 +29,7 @@ public:
     Private(PlasmaShellSurface *q);
     ~Private();
     void setup(org_kde_plasma_surface *surface);
+    void setParentSurface(Surface *surface);
 
     WaylandPointer<org_kde_plasma_surface, org_kde_plasma_surface_destroy> surface;
     QSize size;
@@ -41,11 +43,11 @@ private:
     static void autoHidingPanelShownCallback(void *data, org_kde_plasma_surface *org_kde_plasma_surface);
 
     PlasmaShellSurface *q;
-    static QVector<Private *> s_surfaces;
+    static WrapperIndex<Surface *, Private> s_index;
     static const org_kde_plasma_surface_listener s_listener;
 };
 
-QVector<PlasmaShellSurface::Private *> PlasmaShellSurface::Private::s_surfaces;
+WrapperIndex<Surface *, PlasmaShellSurface::Private> PlasmaShellSurface::Private::s_index;
 
 PlasmaShell::PlasmaShell(QObject *parent)
     : QObject(parent)
@@ -110,7 +112,7 @@ PlasmaShellSurface *PlasmaShell::createSurface(wl_surface *surface, QObject *par
         d->queue->addProxy(w);
     }
     s->setup(w);
-    s->d->parentSurface = QPointer<Surface>(kwS);
+    s->d->setParentSurface(kwS);
     return s;
 }
 
@@ -138,12 +140,17 @@ PlasmaShellSurface::Private::Private(PlasmaShellSurface *q)
     : role(PlasmaShellSurface::Role::Normal)
     , q(q)
 {
-    s_surfaces << this;
 }
 
 PlasmaShellSurface::Private::~Private()
 {
-    s_surfaces.removeAll(this);
+    s_index.remove(this);
+}
+
+void PlasmaShellSurface::Private::setParentSurface(Surface *surface)
+{
+    parentSurface = QPointer<Surface>(surface);
+    s_index.insert(surface, this);
 }
 
 PlasmaShellSurface *PlasmaShellSurface::Private::get(Surface *surface)
@@ -151,10 +158,10 @@ PlasmaShellSurface *PlasmaShellSurface::Private::get(Surface *surface)
     if (!surface) {
         return nullptr;
     }
-    for (auto it = s_surfaces.constBegin(); it != s_surfaces.constEnd(); ++it) {
-        if ((*it)->parentSurface == surface) {
-            return (*it)->q;
-        }
+    // a destroyed Surface may have left its address to the new one
+    Private *p = s_index.value(surface);
+    if (p && p->parentSurface == surface) {
+        return p->q;
     }
     return nullptr;
 }
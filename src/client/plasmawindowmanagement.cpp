@@ -13,12 +13,19 @@
 // Wayland
 #include <wayland-plasma-window-management-client-protocol.h>
 
+#include <QCache>
+#include <QCryptographicHash>
 #include <QFutureWatcher>
-#include <QTimer>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
 #include <QtConcurrentRun>
 #include <qplatformdefs.h>
 
 #include <cerrno>
+#include <functional>
+#include <poll.h>
+#include <utility>
 
 namespace KWayland
 {
@@ -32,9 +39,24 @@ public:
     EventQueue *queue = nullptr;
     bool showingDesktop = false;
     QList<PlasmaWindow *> windows;
+    // index into windows, the window list can get long with many clients
+    QHash<QByteArray, PlasmaWindow *> windowsByUuid;
     PlasmaWindow *activeWindow = nullptr;
     QVector<quint32> stackingOrder;
     QVector<QByteArray> stackingOrderUuids;
+    // the last uuid stacking order as sent, to skip parsing a repeated one
+    QByteArray rawStackingOrderUuids;
+    bool lazyIconFetching = false;
+    struct AnnouncedWindow {
+        quint32 id;
+        // null for the windows announced without an uuid
+        QByteArray uuid;
+    };
+    // the windows announced while dispatching, their objects get created together afterwards
+    QVector<AnnouncedWindow> announcedWindows;
+    // the windows created together, windowsCreated is emitted once all have their initial state
+    QList<QPointer<PlasmaWindow>> createdBatch;
+    QSet<PlasmaWindow *> awaitingInitialState;
 
     void setup(org_kde_plasma_window_management *wm);
 
@@ -46,6 +68,9 @@ private:
     static void stackingOrderUuidsCallback(void *data, org_kde_plasma_window_management *org_kde_plasma_window_management, const char *uuids);
     void setShowDesktop(bool set);
     void windowCreated(org_kde_plasma_window *id, quint32 internalId, const char *uuid);
+    void announceWindow(quint32 id, const QByteArray &uuid);
+    void createAnnouncedWindows();
+    void windowInitialized(PlasmaWindow *window);
     void setStackingOrder(const QVector<quint32> &ids);
     void setStackingOrder(const QVector<QByteArray> &uuids);
 
@@ -83,7 +108,16 @@ public:
     bool resizable = false;
     bool virtualDesktopChangeable = false;
     QIcon icon;
+    // the content hash of icon if it got transferred, empty for themed icons
+    QByteArray iconHash;
+    // whether icon() got called, icons are only fetched from then on if that's lazy
+    bool iconRequested = false;
+    // whether the compositor announced an icon that has not been fetched yet
+    bool iconPending = false;
+    void fetchIcon();
     PlasmaWindowManagement *wm = nullptr;
+    // tells the PlasmaWindowManagement about the initial state
+    std::function<void(PlasmaWindow *)> initialized;
     bool unmapped = false;
     QPointer<PlasmaWindow> parentWindow;
     QMetaObject::Connection parentWindowUnmappedConnection;
@@ -196,39 +230,60 @@ void PlasmaWindowManagement::Private::windowCallback(void *data, org_kde_plasma_
 {
     auto wm = reinterpret_cast<PlasmaWindowManagement::Private *>(data);
     Q_ASSERT(wm->wm == interface);
-    QTimer *timer = new QTimer();
-    timer->setSingleShot(true);
-    timer->setInterval(0);
-    QObject::connect(
-        timer,
-        &QTimer::timeout,
-        wm->q,
-        [timer, wm, id] {
-            wm->windowCreated(org_kde_plasma_window_management_get_window(wm->wm, id), id, "unavailable");
-            timer->deleteLater();
-        },
-        Qt::QueuedConnection);
-    timer->start();
+    wm->announceWindow(id, QByteArray());
 }
 
 void PlasmaWindowManagement::Private::windowWithUuidCallback(void *data, org_kde_plasma_window_management *interface, uint32_t id, const char *_uuid)
 {
-    QByteArray uuid(_uuid);
     auto wm = reinterpret_cast<PlasmaWindowManagement::Private *>(data);
     Q_ASSERT(wm->wm == interface);
-    QTimer *timer = new QTimer();
-    timer->setSingleShot(true);
-    timer->setInterval(0);
-    QObject::connect(
-        timer,
-        &QTimer::timeout,
-        wm->q,
-        [timer, wm, id, uuid] {
-            wm->windowCreated(org_kde_plasma_window_management_get_window_by_uuid(wm->wm, uuid), id, uuid);
-            timer->deleteLater();
-        },
-        Qt::QueuedConnection);
-    timer->start();
+    wm->announceWindow(id, QByteArray(_uuid));
+}
+
+void PlasmaWindowManagement::Private::announceWindow(quint32 id, const QByteArray &uuid)
+{
+    if (announcedWindows.isEmpty()) {
+        // the objects are created after the dispatch, all windows of a burst at once
+        QMetaObject::invokeMethod(
+            q,
+            [this] {
+                createAnnouncedWindows();
+            },
+            Qt::QueuedConnection);
+    }
+    announcedWindows.append({id, uuid});
+}
+
+void PlasmaWindowManagement::Private::createAnnouncedWindows()
+{
+    const QVector<AnnouncedWindow> announced = std::exchange(announcedWindows, {});
+    if (!wm.isValid()) {
+        return;
+    }
+    for (const AnnouncedWindow &window : announced) {
+        if (window.uuid.isNull()) {
+            windowCreated(org_kde_plasma_window_management_get_window(wm, window.id), window.id, "unavailable");
+        } else {
+            windowCreated(org_kde_plasma_window_management_get_window_by_uuid(wm, window.uuid.constData()), window.id, window.uuid.constData());
+        }
+    }
+}
+
+void PlasmaWindowManagement::Private::windowInitialized(PlasmaWindow *window)
+{
+    if (!awaitingInitialState.remove(window) || !awaitingInitialState.isEmpty()) {
+        return;
+    }
+    QList<PlasmaWindow *> created;
+    for (const QPointer<PlasmaWindow> &candidate : qAsConst(createdBatch)) {
+        if (candidate && !candidate->d->unmapped) {
+            created << candidate.data();
+        }
+    }
+    createdBatch.clear();
+    if (!created.isEmpty()) {
+        Q_EMIT q->windowsCreated(created);
+    }
 }
 
 void PlasmaWindowManagement::Private::windowCreated(org_kde_plasma_window *id, quint32 internalId, const char *uuid)
@@ -238,9 +293,22 @@ void PlasmaWindowManagement::Private::windowCreated(org_kde_plasma_window *id, q
     }
     PlasmaWindow *window = new PlasmaWindow(q, id, internalId, uuid);
     window->d->wm = q;
+    window->d->initialized = [this](PlasmaWindow *window) {
+        windowInitialized(window);
+    };
     windows << window;
-    QObject::connect(window, &QObject::destroyed, q, [this, window] {
-        windows.removeAll(window);
+    createdBatch << QPointer<PlasmaWindow>(window);
+    awaitingInitialState.insert(window);
+    const QByteArray windowUuid = window->uuid();
+    windowsByUuid.insert(windowUuid, window);
+    // the private of the window is already gone once destroyed is emitted
+    QObject::connect(window, &QObject::destroyed, q, [this, window, windowUuid] {
+        windows.removeOne(window);
+        // don't wait for the initial state of a window which is gone
+        windowInitialized(window);
+        if (windowsByUuid.value(windowUuid) == window) {
+            windowsByUuid.remove(windowUuid);
+        }
         if (activeWindow == window) {
             activeWindow = nullptr;
             Q_EMIT q->activeWindowChanged();
@@ -272,6 +340,10 @@ void PlasmaWindowManagement::Private::stackingOrderCallback(void *data, org_kde_
 {
     auto wm = reinterpret_cast<PlasmaWindowManagement::Private *>(data);
     Q_ASSERT(wm->wm == interface);
+    const size_t size = wm->stackingOrder.size() * sizeof(quint32);
+    if (ids->size == size && (size == 0 || memcmp(ids->data, wm->stackingOrder.constData(), size) == 0)) {
+        return;
+    }
     QVector<quint32> destination;
     destination.resize(ids->size / sizeof(uint32_t));
     memcpy(destination.data(), ids->data, ids->size);
@@ -282,7 +354,22 @@ void PlasmaWindowManagement::Private::stackingOrderUuidsCallback(void *data, org
 {
     auto wm = reinterpret_cast<PlasmaWindowManagement::Private *>(data);
     Q_ASSERT(wm->wm == interface);
-    wm->setStackingOrder(QByteArray(uuids).split(';').toVector());
+    if (wm->rawStackingOrderUuids == uuids) {
+        return;
+    }
+    wm->rawStackingOrderUuids = uuids;
+
+    // decoded in one pass into a vector of the final size, rather than through a QList
+    const QByteArray &raw = wm->rawStackingOrderUuids;
+    QVector<QByteArray> decoded;
+    decoded.reserve(raw.count(';') + 1);
+    int start = 0;
+    for (int end = raw.indexOf(';'); end != -1; end = raw.indexOf(';', start)) {
+        decoded.append(raw.mid(start, end - start));
+        start = end + 1;
+    }
+    decoded.append(raw.mid(start));
+    wm->setStackingOrder(decoded);
 }
 
 void PlasmaWindowManagement::Private::setStackingOrder(const QVector<quint32> &ids)
@@ -394,6 +481,11 @@ PlasmaWindow *PlasmaWindowManagement::activeWindow() const
     return d->activeWindow;
 }
 
+PlasmaWindow *PlasmaWindowManagement::windowByUuid(const QByteArray &uuid) const
+{
+    return d->windowsByUuid.value(uuid);
+}
+
 PlasmaWindowModel *PlasmaWindowManagement::createWindowModel()
 {
     return new PlasmaWindowModel(this);
@@ -409,6 +501,16 @@ QVector<QByteArray> PlasmaWindowManagement::stackingOrderUuids() const
     return d->stackingOrderUuids;
 }
 
+void PlasmaWindowManagement::setLazyIconFetching(bool lazy)
+{
+    d->lazyIconFetching = lazy;
+}
+
+bool PlasmaWindowManagement::lazyIconFetching() const
+{
+    return d->lazyIconFetching;
+}
+
 org_kde_plasma_window_listener PlasmaWindow::Private::s_listener = {
     titleChangedCallback,
     appIdChangedCallback,
@@ -445,11 +547,15 @@ void PlasmaWindow::Private::parentWindowCallback(void *data, org_kde_plasma_wind
 {
     Q_UNUSED(window)
     Private *p = cast(data);
-    const auto windows = p->wm->windows();
-    auto it = std::find_if(windows.constBegin(), windows.constEnd(), [parent](const PlasmaWindow *w) {
-        return *w == parent;
-    });
-    p->setParentWindow(it != windows.constEnd() ? *it : nullptr);
+    PlasmaWindow *parentWindow = nullptr;
+    // every window proxy carries its Private as listener data, no need to search for it
+    if (parent && wl_proxy_get_listener(reinterpret_cast<wl_proxy *>(parent)) == &s_listener) {
+        Private *parentPrivate = cast(wl_proxy_get_user_data(reinterpret_cast<wl_proxy *>(parent)));
+        if (parentPrivate->wm == p->wm) {
+            parentWindow = parentPrivate->q;
+        }
+    }
+    p->setParentWindow(parentWindow);
 }
 
 void PlasmaWindow::Private::windowGeometryCallback(void *data, org_kde_plasma_window *window, int32_t x, int32_t y, uint32_t width, uint32_t height)
@@ -489,6 +595,9 @@ void PlasmaWindow::Private::initialStateCallback(void *data, org_kde_plasma_wind
     if (!p->unmapped) {
         Q_EMIT p->wm->windowCreated(p->q);
     }
+    if (p->initialized) {
+        p->initialized(p->q);
+    }
 }
 
 void PlasmaWindow::Private::titleChangedCallback(void *data, org_kde_plasma_window *window, const char *title)
@@ -625,70 +734,132 @@ void PlasmaWindow::Private::themedIconNameChangedCallback(void *data, org_kde_pl
     Q_UNUSED(window);
     const QString themedName = QString::fromUtf8(name);
     if (!themedName.isEmpty()) {
-        QIcon icon = QIcon::fromTheme(themedName);
-        p->icon = icon;
+        // themed icons are shared by many windows, e.g. all terminals
+        static QHash<QString, QIcon> themedIcons;
+        auto it = themedIcons.find(themedName);
+        if (it == themedIcons.end()) {
+            it = themedIcons.insert(themedName, QIcon::fromTheme(themedName));
+        }
+        p->icon = *it;
     } else {
         p->icon = QIcon();
     }
+    p->iconHash.clear();
+    p->iconPending = false;
     Q_EMIT p->q->iconChanged();
 }
 
-static int readData(int fd, QByteArray &data)
+struct TransferredIcon {
+    QByteArray hash;
+    QIcon icon;
+};
+
+// icons read from the compositor, shared by all windows with identical icons
+using IconCache = QCache<QByteArray, QIcon>;
+static const int s_iconCacheSize = 100;
+Q_GLOBAL_STATIC_WITH_ARGS(IconCache, s_iconCache, (s_iconCacheSize))
+static QMutex s_iconCacheMutex;
+
+// a single thread reads and decodes the icons one after another, in the order they were
+// requested, instead of a task for every window in the global thread pool
+class IconThreadPool : public QThreadPool
+{
+public:
+    IconThreadPool()
+    {
+        setMaxThreadCount(1);
+    }
+};
+Q_GLOBAL_STATIC(IconThreadPool, s_iconThreadPool)
+
+static bool readData(int fd, QByteArray &data, QCryptographicHash &hash)
 {
     // implementation based on QtWayland file qwaylanddataoffer.cpp
     char buf[4096];
-    int retryCount = 0;
-    int n;
     while (true) {
-        n = QT_READ(fd, buf, sizeof buf);
-        if (n == -1 && (errno == EAGAIN) && ++retryCount < 1000) {
-            usleep(1000);
-        } else {
-            break;
+        const int n = QT_READ(fd, buf, sizeof buf);
+        if (n > 0) {
+            // the hash is computed while the data trickles in
+            hash.addData(buf, n);
+            data.append(buf, n);
+        } else if (n == 0) {
+            return true;
+        } else if (errno == EAGAIN) {
+            pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, 1000) <= 0) {
+                return false;
+            }
+        } else if (errno != EINTR) {
+            return false;
         }
     }
-    if (n > 0) {
-        data.append(buf, n);
-        n = readData(fd, data);
-    }
-    return n;
 }
 
 void PlasmaWindow::Private::iconChangedCallback(void *data, org_kde_plasma_window *window)
 {
     auto p = cast(data);
     Q_UNUSED(window);
+    if (p->wm && p->wm->lazyIconFetching() && !p->iconRequested) {
+        p->iconPending = true;
+        Q_EMIT p->q->iconChanged();
+        return;
+    }
+    p->fetchIcon();
+}
+
+void PlasmaWindow::Private::fetchIcon()
+{
+    iconPending = false;
+    if (!window.isValid()) {
+        return;
+    }
     int pipeFds[2];
     if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
         return;
     }
-    org_kde_plasma_window_get_icon(p->window, pipeFds[1]);
+    org_kde_plasma_window_get_icon(window, pipeFds[1]);
     close(pipeFds[1]);
     const int pipeFd = pipeFds[0];
-    auto readIcon = [pipeFd]() -> QIcon {
+    auto readIcon = [pipeFd]() -> TransferredIcon {
         QByteArray content;
-        if (readData(pipeFd, content) != 0) {
-            close(pipeFd);
-            return QIcon();
-        }
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        const bool complete = readData(pipeFd, content, hash);
         close(pipeFd);
+        if (!complete) {
+            return TransferredIcon();
+        }
+        TransferredIcon transferred;
+        transferred.hash = hash.result();
+        {
+            QMutexLocker locker(&s_iconCacheMutex);
+            if (const QIcon *icon = s_iconCache->object(transferred.hash)) {
+                transferred.icon = *icon;
+                return transferred;
+            }
+        }
         QDataStream ds(content);
-        QIcon icon;
-        ds >> icon;
-        return icon;
+        ds >> transferred.icon;
+        QMutexLocker locker(&s_iconCacheMutex);
+        s_iconCache->insert(transferred.hash, new QIcon(transferred.icon));
+        return transferred;
     };
-    QFutureWatcher<QIcon> *watcher = new QFutureWatcher<QIcon>(p->q);
-    QObject::connect(watcher, &QFutureWatcher<QIcon>::finished, p->q, [p, watcher] {
+    QFutureWatcher<TransferredIcon> *watcher = new QFutureWatcher<TransferredIcon>(q);
+    QObject::connect(watcher, &QFutureWatcher<TransferredIcon>::finished, q, [p = this, watcher] {
         watcher->deleteLater();
-        QIcon icon = watcher->result();
-        if (!icon.isNull()) {
-            p->icon = icon;
+        const TransferredIcon transferred = watcher->result();
+        if (!transferred.hash.isEmpty() && transferred.hash == p->iconHash) {
+            // the compositor sent the icon we already have
+            return;
+        }
+        p->iconHash = transferred.hash;
+        if (!transferred.icon.isNull()) {
+            p->icon = transferred.icon;
         } else {
             p->icon = QIcon::fromTheme(QStringLiteral("wayland"));
         }
         Q_EMIT p->q->iconChanged();
     });
-    watcher->setFuture(QtConcurrent::run(readIcon));
+    watcher->setFuture(QtConcurrent::run(static_cast<QThreadPool *>(s_iconThreadPool()), readIcon));
 }
 
 void PlasmaWindow::Private::setActive(bool set)
@@ -1010,6 +1181,10 @@ bool PlasmaWindow::skipSwitcher() const
 
 QIcon PlasmaWindow::icon() const
 {
+    d->iconRequested = true;
+    if (d->iconPending) {
+        d->fetchIcon();
+    }
     return d->icon;
 }
 
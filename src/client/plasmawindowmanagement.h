@@ -153,6 +153,12 @@ public:
      * there is no active window.
      **/
     PlasmaWindow *activeWindow() const;
+    /**
+     * @returns The PlasmaWindow with the given @p uuid or @c nullptr if there is none.
+     * The lookup does not need to go through all windows.
+     * @see PlasmaWindow::uuid
+     **/
+    PlasmaWindow *windowByUuid(const QByteArray &uuid) const;
     /**
      * Factory method to create a PlasmaWindowModel.
      * @returns a new created PlasmaWindowModel
@@ -176,6 +182,23 @@ public:
      */
     QVector<QByteArray> stackingOrderUuids() const;
 
+    /**
+     * Sets whether the icons of the windows are only transferred once they are needed. If enabled,
+     * the icon of a window is read from the compositor when PlasmaWindow::icon() is called for the
+     * first time, PlasmaWindow::iconChanged is emitted again once it has arrived. Until then, a
+     * changed icon only emits PlasmaWindow::iconChanged. Clients that don't show the icons of all
+     * windows, e.g. a taskbar that only shows a few of them, save reading and decoding the rest.
+     *
+     * It is disabled by default, every icon is transferred as soon as it changes.
+     * @see lazyIconFetching
+     **/
+    void setLazyIconFetching(bool lazy);
+    /**
+     * @returns Whether the icons of the windows are only transferred once they are needed.
+     * @see setLazyIconFetching
+     **/
+    bool lazyIconFetching() const;
+
 Q_SIGNALS:
     /**
      * This signal is emitted right before the interface is released.
@@ -196,6 +219,13 @@ Q_SIGNALS:
      * @see windows
      **/
     void windowCreated(KWayland::Client::PlasmaWindow *window);
+    /**
+     * The @p windows announced together, e.g. all windows at startup, got created and
+     * received their initial state. Emitted after windowCreated for each of them, so a
+     * consumer can update its view once per burst instead of once per window.
+     * @see windowCreated
+     **/
+    void windowsCreated(const QList<KWayland::Client::PlasmaWindow *> &windows);
     /**
      * The active window changed.
      * @see activeWindow
@@ -385,7 +415,10 @@ public:
     bool skipSwitcher() const;
     /**
      * @returns The icon of the window.
+     * If the PlasmaWindowManagement fetches icons lazily, the first call requests the icon from
+     * the compositor and returns the one known so far.
      * @see iconChanged
+     * @see PlasmaWindowManagement::setLazyIconFetching
      **/
     QIcon icon() const;
     /**
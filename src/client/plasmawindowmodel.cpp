@@ -4,174 +4,352 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "plasmawindowmodel.h"
+#include "output.h"
 #include "plasmawindowmanagement.h"
 
+#include <QHash>
 #include <QMetaEnum>
+#include <QMetaMethod>
+#include <QPointer>
+#include <QSet>
+// std
+#include <algorithm>
+#include <limits>
+#include <utility>
 
 namespace KWayland
 {
 namespace Client
 {
-class Q_DECL_HIDDEN PlasmaWindowModel::Private
+class Q_DECL_HIDDEN PlasmaWindowModel::Private : public QObject
 {
+    Q_OBJECT
 public:
-    Private(PlasmaWindowModel *q);
+    Private(PlasmaWindowModel *q, PlasmaWindowManagement *wm);
+    // the windows shown as rows
     QList<PlasmaWindow *> windows;
+    // all windows, including the filtered out ones, in the order they got created
+    QList<PlasmaWindow *> allWindows;
     PlasmaWindow *window = nullptr;
 
     void addWindow(PlasmaWindow *window);
+    void removeWindow(PlasmaWindow *window);
     void dataChanged(PlasmaWindow *window, int role);
+    void flushDataChanged();
+
+    bool acceptsWindow(const PlasmaWindow *window) const;
+    void updateWindow(PlasmaWindow *window);
+    void updateFilter();
+    void updateStackingOrder();
+    int stackingPosition(const PlasmaWindow *window) const;
+    int insertionRow(const PlasmaWindow *window) const;
+    void sort();
+
+    // the roles changed since the last flush, a window usually changes several properties at once
+    QHash<PlasmaWindow *, QVector<int>> changedRoles;
+    bool flushScheduled = false;
+
+    QString virtualDesktopFilter;
+    QString activityFilter;
+    QPointer<Output> outputFilter;
+    QMetaObject::Connection outputFilterConnection;
+    bool sortedByStackingOrder = false;
+    QHash<QByteArray, int> stackingPositions;
+
+public Q_SLOTS:
+    /**
+     * Receives all property change signals of all windows, the role is looked up by the signal.
+     **/
+    void windowChanged();
 
 private:
     PlasmaWindowModel *q;
+    PlasmaWindowManagement *wm;
 };
 
-PlasmaWindowModel::Private::Private(PlasmaWindowModel *q)
+/**
+ * The roles affected by the change signals of PlasmaWindow, keyed by the signal index.
+ **/
+static const QHash<int, int> &signalRoles()
+{
+    static const QHash<int, int> roles = {
+        {QMetaMethod::fromSignal(&PlasmaWindow::titleChanged).methodIndex(), Qt::DisplayRole},
+        {QMetaMethod::fromSignal(&PlasmaWindow::iconChanged).methodIndex(), Qt::DecorationRole},
+        {QMetaMethod::fromSignal(&PlasmaWindow::appIdChanged).methodIndex(), PlasmaWindowModel::AppId},
+        {QMetaMethod::fromSignal(&PlasmaWindow::activeChanged).methodIndex(), PlasmaWindowModel::IsActive},
+        {QMetaMethod::fromSignal(&PlasmaWindow::fullscreenableChanged).methodIndex(), PlasmaWindowModel::IsFullscreenable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::fullscreenChanged).methodIndex(), PlasmaWindowModel::IsFullscreen},
+        {QMetaMethod::fromSignal(&PlasmaWindow::maximizeableChanged).methodIndex(), PlasmaWindowModel::IsMaximizable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::maximizedChanged).methodIndex(), PlasmaWindowModel::IsMaximized},
+        {QMetaMethod::fromSignal(&PlasmaWindow::minimizeableChanged).methodIndex(), PlasmaWindowModel::IsMinimizable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::minimizedChanged).methodIndex(), PlasmaWindowModel::IsMinimized},
+        {QMetaMethod::fromSignal(&PlasmaWindow::keepAboveChanged).methodIndex(), PlasmaWindowModel::IsKeepAbove},
+        {QMetaMethod::fromSignal(&PlasmaWindow::keepBelowChanged).methodIndex(), PlasmaWindowModel::IsKeepBelow},
+#if KWAYLANDCLIENT_ENABLE_DEPRECATED_SINCE(5, 53)
+        {QMetaMethod::fromSignal(&PlasmaWindow::virtualDesktopChanged).methodIndex(), PlasmaWindowModel::VirtualDesktop},
+#endif
+        {QMetaMethod::fromSignal(&PlasmaWindow::onAllDesktopsChanged).methodIndex(), PlasmaWindowModel::IsOnAllDesktops},
+        {QMetaMethod::fromSignal(&PlasmaWindow::demandsAttentionChanged).methodIndex(), PlasmaWindowModel::IsDemandingAttention},
+        {QMetaMethod::fromSignal(&PlasmaWindow::skipTaskbarChanged).methodIndex(), PlasmaWindowModel::SkipTaskbar},
+        {QMetaMethod::fromSignal(&PlasmaWindow::skipSwitcherChanged).methodIndex(), PlasmaWindowModel::SkipSwitcher},
+        {QMetaMethod::fromSignal(&PlasmaWindow::shadeableChanged).methodIndex(), PlasmaWindowModel::IsShadeable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::shadedChanged).methodIndex(), PlasmaWindowModel::IsShaded},
+        {QMetaMethod::fromSignal(&PlasmaWindow::movableChanged).methodIndex(), PlasmaWindowModel::IsMovable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::resizableChanged).methodIndex(), PlasmaWindowModel::IsResizable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::virtualDesktopChangeableChanged).methodIndex(), PlasmaWindowModel::IsVirtualDesktopChangeable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::closeableChanged).methodIndex(), PlasmaWindowModel::IsCloseable},
+        {QMetaMethod::fromSignal(&PlasmaWindow::geometryChanged).methodIndex(), PlasmaWindowModel::Geometry},
+        {QMetaMethod::fromSignal(&PlasmaWindow::plasmaVirtualDesktopEntered).methodIndex(), PlasmaWindowModel::VirtualDesktops},
+        {QMetaMethod::fromSignal(&PlasmaWindow::plasmaVirtualDesktopLeft).methodIndex(), PlasmaWindowModel::VirtualDesktops},
+        {QMetaMethod::fromSignal(&PlasmaWindow::plasmaActivityEntered).methodIndex(), PlasmaWindowModel::Activities},
+        {QMetaMethod::fromSignal(&PlasmaWindow::plasmaActivityLeft).methodIndex(), PlasmaWindowModel::Activities},
+    };
+    return roles;
+}
+
+PlasmaWindowModel::Private::Private(PlasmaWindowModel *q, PlasmaWindowManagement *wm)
     : q(q)
+    , wm(wm)
 {
 }
 
 void PlasmaWindowModel::Private::addWindow(PlasmaWindow *window)
 {
-    if (windows.indexOf(window) != -1) {
+    if (allWindows.indexOf(window) != -1) {
         return;
     }
+    allWindows.append(window);
 
-    const int count = windows.count();
-    q->beginInsertRows(QModelIndex(), count, count);
-    windows.append(window);
-    q->endInsertRows();
+    if (acceptsWindow(window)) {
+        const int row = insertionRow(window);
+        q->beginInsertRows(QModelIndex(), row, row);
+        windows.insert(row, window);
+        q->endInsertRows();
+    }
 
     auto removeWindow = [window, this] {
-        const int row = windows.indexOf(window);
-        if (row != -1) {
-            q->beginRemoveRows(QModelIndex(), row, row);
-            windows.removeAt(row);
-            q->endRemoveRows();
-        }
+        this->removeWindow(window);
     };
 
     QObject::connect(window, &PlasmaWindow::unmapped, q, removeWindow);
     QObject::connect(window, &QObject::destroyed, q, removeWindow);
 
-    QObject::connect(window, &PlasmaWindow::titleChanged, q, [window, this] {
-        this->dataChanged(window, Qt::DisplayRole);
-    });
-
-    QObject::connect(window, &PlasmaWindow::iconChanged, q, [window, this] {
-        this->dataChanged(window, Qt::DecorationRole);
-    });
-
-    QObject::connect(window, &PlasmaWindow::appIdChanged, q, [window, this] {
-        this->dataChanged(window, PlasmaWindowModel::AppId);
-    });
-
-    QObject::connect(window, &PlasmaWindow::activeChanged, q, [window, this] {
-        this->dataChanged(window, IsActive);
-    });
-
-    QObject::connect(window, &PlasmaWindow::fullscreenableChanged, q, [window, this] {
-        this->dataChanged(window, IsFullscreenable);
-    });
-
-    QObject::connect(window, &PlasmaWindow::fullscreenChanged, q, [window, this] {
-        this->dataChanged(window, IsFullscreen);
-    });
-
-    QObject::connect(window, &PlasmaWindow::maximizeableChanged, q, [window, this] {
-        this->dataChanged(window, IsMaximizable);
-    });
-
-    QObject::connect(window, &PlasmaWindow::maximizedChanged, q, [window, this] {
-        this->dataChanged(window, IsMaximized);
-    });
-
-    QObject::connect(window, &PlasmaWindow::minimizeableChanged, q, [window, this] {
-        this->dataChanged(window, IsMinimizable);
-    });
-
-    QObject::connect(window, &PlasmaWindow::minimizedChanged, q, [window, this] {
-        this->dataChanged(window, IsMinimized);
-    });
-
-    QObject::connect(window, &PlasmaWindow::keepAboveChanged, q, [window, this] {
-        this->dataChanged(window, IsKeepAbove);
-    });
-
-    QObject::connect(window, &PlasmaWindow::keepBelowChanged, q, [window, this] {
-        this->dataChanged(window, IsKeepBelow);
-    });
-
-    QObject::connect(window, &PlasmaWindow::virtualDesktopChanged, q, [window, this] {
-        this->dataChanged(window, VirtualDesktop);
-    });
-
-    QObject::connect(window, &PlasmaWindow::onAllDesktopsChanged, q, [window, this] {
-        this->dataChanged(window, IsOnAllDesktops);
-    });
-
-    QObject::connect(window, &PlasmaWindow::demandsAttentionChanged, q, [window, this] {
-        this->dataChanged(window, IsDemandingAttention);
-    });
-
-    QObject::connect(window, &PlasmaWindow::skipTaskbarChanged, q, [window, this] {
-        this->dataChanged(window, SkipTaskbar);
-    });
+    static const QMetaMethod slot = staticMetaObject.method(staticMetaObject.indexOfSlot("windowChanged()"));
+    const auto &roles = signalRoles();
+    for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+        QObject::connect(window, PlasmaWindow::staticMetaObject.method(it.key()), this, slot);
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::skipSwitcherChanged, q, [window, this] {
-        this->dataChanged(window, SkipSwitcher);
-    });
+void PlasmaWindowModel::Private::removeWindow(PlasmaWindow *window)
+{
+    allWindows.removeOne(window);
+    changedRoles.remove(window);
+    // also called on destroyed, the window must not be accessed
+    const int row = windows.indexOf(window);
+    if (row != -1) {
+        q->beginRemoveRows(QModelIndex(), row, row);
+        windows.removeAt(row);
+        q->endRemoveRows();
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::shadeableChanged, q, [window, this] {
-        this->dataChanged(window, IsShadeable);
-    });
+void PlasmaWindowModel::Private::windowChanged()
+{
+    auto window = static_cast<PlasmaWindow *>(sender());
+    const int role = signalRoles().value(senderSignalIndex(), -1);
+    if (role == -1 || !allWindows.contains(window)) {
+        return;
+    }
+    switch (role) {
+    case VirtualDesktops:
+    case IsOnAllDesktops:
+    case Activities:
+    case Geometry:
+        updateWindow(window);
+        break;
+    default:
+        break;
+    }
+    dataChanged(window, role);
+}
 
-    QObject::connect(window, &PlasmaWindow::shadedChanged, q, [window, this] {
-        this->dataChanged(window, IsShaded);
-    });
+void PlasmaWindowModel::Private::dataChanged(PlasmaWindow *window, int role)
+{
+    QVector<int> &roles = changedRoles[window];
+    if (!roles.contains(role)) {
+        roles << role;
+    }
+    // all events of a burst from the compositor get dispatched before the flush
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QMetaObject::invokeMethod(
+            q,
+            [this] {
+                flushDataChanged();
+            },
+            Qt::QueuedConnection);
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::movableChanged, q, [window, this] {
-        this->dataChanged(window, IsMovable);
-    });
+void PlasmaWindowModel::Private::flushDataChanged()
+{
+    flushScheduled = false;
+    if (changedRoles.isEmpty()) {
+        return;
+    }
+    const auto changed = std::exchange(changedRoles, {});
+    for (int row = 0; row < windows.count(); ++row) {
+        auto it = changed.constFind(windows.at(row));
+        if (it == changed.constEnd()) {
+            continue;
+        }
+        const QModelIndex idx = q->index(row);
+        Q_EMIT q->dataChanged(idx, idx, it.value());
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::resizableChanged, q, [window, this] {
-        this->dataChanged(window, IsResizable);
-    });
+bool PlasmaWindowModel::Private::acceptsWindow(const PlasmaWindow *window) const
+{
+    if (!virtualDesktopFilter.isEmpty() && !window->isOnAllDesktops()) {
+        const QStringList desktops = window->plasmaVirtualDesktops();
+        if (!desktops.isEmpty() && !desktops.contains(virtualDesktopFilter)) {
+            return false;
+        }
+    }
+    if (!activityFilter.isEmpty()) {
+        const QStringList activities = window->plasmaActivities();
+        if (!activities.isEmpty() && !activities.contains(activityFilter)) {
+            return false;
+        }
+    }
+    if (outputFilter && !outputFilter->geometry().intersects(window->geometry())) {
+        return false;
+    }
+    return true;
+}
 
-    QObject::connect(window, &PlasmaWindow::virtualDesktopChangeableChanged, q, [window, this] {
-        this->dataChanged(window, IsVirtualDesktopChangeable);
-    });
+void PlasmaWindowModel::Private::updateWindow(PlasmaWindow *window)
+{
+    const int row = windows.indexOf(window);
+    const bool accepted = acceptsWindow(window);
+    if (accepted && row == -1) {
+        const int newRow = insertionRow(window);
+        q->beginInsertRows(QModelIndex(), newRow, newRow);
+        windows.insert(newRow, window);
+        q->endInsertRows();
+    } else if (!accepted && row != -1) {
+        q->beginRemoveRows(QModelIndex(), row, row);
+        windows.removeAt(row);
+        q->endRemoveRows();
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::closeableChanged, q, [window, this] {
-        this->dataChanged(window, IsCloseable);
-    });
+void PlasmaWindowModel::Private::updateFilter()
+{
+    for (PlasmaWindow *window : qAsConst(allWindows)) {
+        updateWindow(window);
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::geometryChanged, q, [window, this] {
-        this->dataChanged(window, Geometry);
-    });
+void PlasmaWindowModel::Private::updateStackingOrder()
+{
+    stackingPositions.clear();
+    const QVector<QByteArray> uuids = wm->stackingOrderUuids();
+    stackingPositions.reserve(uuids.count());
+    for (int i = 0; i < uuids.count(); ++i) {
+        stackingPositions.insert(uuids.at(i), i);
+    }
+    if (sortedByStackingOrder) {
+        sort();
+    }
+}
 
-    QObject::connect(window, &PlasmaWindow::plasmaVirtualDesktopEntered, q, [window, this] {
-        this->dataChanged(window, VirtualDesktops);
-    });
+int PlasmaWindowModel::Private::stackingPosition(const PlasmaWindow *window) const
+{
+    return stackingPositions.value(window->uuid(), std::numeric_limits<int>::max());
+}
 
-    QObject::connect(window, &PlasmaWindow::plasmaVirtualDesktopLeft, q, [window, this] {
-        this->dataChanged(window, VirtualDesktops);
+int PlasmaWindowModel::Private::insertionRow(const PlasmaWindow *window) const
+{
+    if (!sortedByStackingOrder) {
+        return windows.count();
+    }
+    const int position = stackingPosition(window);
+    auto it = std::upper_bound(windows.constBegin(), windows.constEnd(), position, [this](int value, const PlasmaWindow *other) {
+        return value < stackingPosition(other);
     });
+    return std::distance(windows.constBegin(), it);
 }
 
-void PlasmaWindowModel::Private::dataChanged(PlasmaWindow *window, int role)
+void PlasmaWindowModel::Private::sort()
 {
-    QModelIndex idx = q->index(windows.indexOf(window));
-    Q_EMIT q->dataChanged(idx, idx, QVector<int>() << role);
+    // the rows on the longest already sorted subsequence stay where they are and only the
+    // others get moved, raising a single window is a single row move
+    const int count = windows.count();
+    QVector<int> positions(count);
+    for (int row = 0; row < count; ++row) {
+        positions[row] = stackingPosition(windows.at(row));
+    }
+    QVector<int> tails;
+    QVector<int> previous(count, -1);
+    for (int row = 0; row < count; ++row) {
+        auto it = std::upper_bound(tails.begin(), tails.end(), positions.at(row), [&positions](int position, int tail) {
+            return position < positions.at(tail);
+        });
+        if (it != tails.begin()) {
+            previous[row] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.append(row);
+        } else {
+            *it = row;
+        }
+    }
+    QSet<PlasmaWindow *> sorted;
+    for (int row = tails.isEmpty() ? -1 : tails.last(); row != -1; row = previous.at(row)) {
+        sorted.insert(windows.at(row));
+    }
+    if (sorted.count() == count) {
+        return;
+    }
+
+    QList<PlasmaWindow *> unsorted;
+    for (PlasmaWindow *window : qAsConst(windows)) {
+        if (!sorted.contains(window)) {
+            unsorted << window;
+        }
+    }
+    for (PlasmaWindow *window : qAsConst(unsorted)) {
+        const int from = windows.indexOf(window);
+        const int position = stackingPosition(window);
+        // in front of the first sorted row stacked above, the unsorted rows don't matter yet
+        int to = windows.count();
+        for (int row = 0; row < windows.count(); ++row) {
+            if (sorted.contains(windows.at(row)) && stackingPosition(windows.at(row)) > position) {
+                to = row;
+                break;
+            }
+        }
+        sorted.insert(window);
+        if (to == from || to == from + 1) {
+            continue;
+        }
+        q->beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
+        windows.move(from, to > from ? to - 1 : to);
+        q->endMoveRows();
+    }
 }
 
 PlasmaWindowModel::PlasmaWindowModel(PlasmaWindowManagement *parent)
     : QAbstractListModel(parent)
-    , d(new Private(this))
+    , d(new Private(this, parent))
 {
     connect(parent, &PlasmaWindowManagement::interfaceAboutToBeReleased, this, [this] {
         beginResetModel();
         d->windows.clear();
+        d->allWindows.clear();
+        d->changedRoles.clear();
         endResetModel();
     });
 
@@ -179,6 +357,11 @@ PlasmaWindowModel::PlasmaWindowModel(PlasmaWindowManagement *parent)
         d->addWindow(window);
     });
 
+    connect(parent, &PlasmaWindowManagement::stackingOrderUuidsChanged, this, [this] {
+        d->updateStackingOrder();
+    });
+    d->updateStackingOrder();
+
     for (auto it = parent->windows().constBegin(); it != parent->windows().constEnd(); ++it) {
         d->addWindow(*it);
     }
@@ -266,6 +449,8 @@ QVariant PlasmaWindowModel::data(const QModelIndex &index, int role) const
         return window->plasmaVirtualDesktops();
     } else if (role == Uuid) {
         return window->uuid();
+    } else if (role == Activities) {
+        return window->plasmaActivities();
     }
 
     return QVariant();
@@ -358,5 +543,71 @@ Q_INVOKABLE void PlasmaWindowModel::requestToggleShaded(int row)
     }
 }
 
+void PlasmaWindowModel::setVirtualDesktopFilter(const QString &id)
+{
+    if (d->virtualDesktopFilter == id) {
+        return;
+    }
+    d->virtualDesktopFilter = id;
+    d->updateFilter();
+}
+
+QString PlasmaWindowModel::virtualDesktopFilter() const
+{
+    return d->virtualDesktopFilter;
+}
+
+void PlasmaWindowModel::setActivityFilter(const QString &id)
+{
+    if (d->activityFilter == id) {
+        return;
+    }
+    d->activityFilter = id;
+    d->updateFilter();
 }
+
+QString PlasmaWindowModel::activityFilter() const
+{
+    return d->activityFilter;
 }
+
+void PlasmaWindowModel::setOutputFilter(Output *output)
+{
+    if (d->outputFilter == output) {
+        return;
+    }
+    disconnect(d->outputFilterConnection);
+    d->outputFilter = output;
+    if (output) {
+        d->outputFilterConnection = connect(output, &Output::changed, this, [this] {
+            d->updateFilter();
+        });
+    }
+    d->updateFilter();
+}
+
+Output *PlasmaWindowModel::outputFilter() const
+{
+    return d->outputFilter;
+}
+
+void PlasmaWindowModel::setSortedByStackingOrder(bool sorted)
+{
+    if (d->sortedByStackingOrder == sorted) {
+        return;
+    }
+    d->sortedByStackingOrder = sorted;
+    if (sorted) {
+        d->sort();
+    }
+}
+
+bool PlasmaWindowModel::isSortedByStackingOrder() const
+{
+    return d->sortedByStackingOrder;
+}
+
+}
+}
+
+#include "plasmawindowmodel.moc"
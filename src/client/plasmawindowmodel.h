@@ -14,6 +14,7 @@ namespace KWayland
 {
 namespace Client
 {
+class Output;
 class PlasmaWindowManagement;
 class Surface;
 
@@ -29,6 +30,20 @@ class Surface;
  * The model resets when the PlasmaWindowManagement parent signals that its
  * interface is about to be destroyed.
  *
+ * Property changes of a window are not reported one by one. All changes which arrive
+ * together, e.g. the geometry, state and virtual desktop of a window getting maximized,
+ * are reported with a single dataChanged carrying all changed roles once control returns
+ * to the event loop.
+ *
+ * The model can restrict its rows to the windows on a virtual desktop, an activity or an
+ * Output and keep them sorted by the stacking order. This is cheaper than a QSortFilterProxyModel
+ * on top of it: a changed property only re-evaluates the window it belongs to and a raised
+ * window results in a single row move.
+ * @code
+ * model->setVirtualDesktopFilter(currentDesktopId);
+ * model->setSortedByStackingOrder(true);
+ * @endcode
+ *
  * To use this class you can create an instance yourself, or preferably use the
  * convenience method in PlasmaWindowManagement:
  * @code
@@ -110,6 +125,7 @@ public:
          * @since 5.73
          */
         Uuid,
+        Activities,
     };
     Q_ENUM(AdditionalRoles)
 
@@ -188,6 +204,51 @@ public:
      */
     Q_INVOKABLE void requestToggleShaded(int row);
 
+    /**
+     * Only shows the windows on the virtual desktop with @p id, windows on all desktops
+     * included. An empty @p id, the default, shows the windows of all virtual desktops.
+     * @see PlasmaWindow::plasmaVirtualDesktops
+     **/
+    void setVirtualDesktopFilter(const QString &id);
+    /**
+     * @returns The id of the virtual desktop the windows are filtered by.
+     **/
+    QString virtualDesktopFilter() const;
+
+    /**
+     * Only shows the windows on the activity with @p id, windows on all activities
+     * included. An empty @p id, the default, shows the windows of all activities.
+     * @see PlasmaWindow::plasmaActivities
+     **/
+    void setActivityFilter(const QString &id);
+    /**
+     * @returns The id of the activity the windows are filtered by.
+     **/
+    QString activityFilter() const;
+
+    /**
+     * Only shows the windows whose geometry intersects the one of @p output.
+     * Pass @c null, the default, to show the windows of all outputs.
+     * @see PlasmaWindow::geometry
+     **/
+    void setOutputFilter(Output *output);
+    /**
+     * @returns The Output the windows are filtered by.
+     **/
+    Output *outputFilter() const;
+
+    /**
+     * Whether the rows are kept sorted by the stacking order, from the bottom most to the top
+     * most window. Windows not part of the stacking order come last. By default the rows are
+     * in the order the windows got created.
+     * @see PlasmaWindowManagement::stackingOrderUuids
+     **/
+    void setSortedByStackingOrder(bool sorted);
+    /**
+     * @returns Whether the rows are sorted by the stacking order.
+     **/
+    bool isSortedByStackingOrder() const;
+
 private:
     class Private;
     QScopedPointer<Private> d;
@@ -9,6 +9,8 @@
 // Qt
 #include <QPointF>
 #include <QPointer>
+
+#include <utility>
 // wayland
 #include <wayland-client-protocol.h>
 
@@ -37,8 +39,17 @@ public:
     WaylandPointer<wl_pointer, wl_pointer_release> pointer;
     QPointer<Surface> enteredSurface;
     quint32 enteredSerial = 0;
+    bool aggregateFrames = false;
+    // wl_pointer.frame was only added with version 5
+    bool hasFrames = false;
+    bool framePending = false;
+    Pointer::Frame pendingFrame;
+
+    void emitPendingFrame();
 
 private:
+    Pointer::Frame::AxisEvent &pendingAxisEvent(uint32_t axis);
+    void aggregated();
     void enter(uint32_t serial, wl_surface *surface, const QPointF &relativeToSurface);
     void leave(uint32_t serial);
     static void enterCallback(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface, wl_fixed_t sx, wl_fixed_t sy);
@@ -65,9 +76,36 @@ void Pointer::Private::setup(wl_pointer *p)
     Q_ASSERT(p);
     Q_ASSERT(!pointer);
     pointer.setup(p);
+    hasFrames = wl_pointer_get_version(p) >= WL_POINTER_FRAME_SINCE_VERSION;
     wl_pointer_add_listener(pointer, &s_listener, this);
 }
 
+void Pointer::Private::emitPendingFrame()
+{
+    if (!framePending) {
+        return;
+    }
+    framePending = false;
+    const Pointer::Frame frame = std::exchange(pendingFrame, Pointer::Frame());
+    Q_EMIT q->aggregatedFrame(frame);
+}
+
+Pointer::Frame::AxisEvent &Pointer::Private::pendingAxisEvent(uint32_t axis)
+{
+    if (wlAxisToPointerAxis(axis) == Axis::Vertical) {
+        return pendingFrame.vertical;
+    }
+    return pendingFrame.horizontal;
+}
+
+void Pointer::Private::aggregated()
+{
+    framePending = true;
+    if (!hasFrames) {
+        emitPendingFrame();
+    }
+}
+
 const wl_pointer_listener Pointer::Private::s_listener =
     {enterCallback, leaveCallback, motionCallback, buttonCallback, axisCallback, frameCallback, axisSourceCallback, axisStopCallback, axisDiscreteCallback};
 
@@ -85,11 +123,15 @@ Pointer::~Pointer()
 void Pointer::release()
 {
     d->pointer.release();
+    d->framePending = false;
+    d->pendingFrame = Frame();
 }
 
 void Pointer::destroy()
 {
     d->pointer.destroy();
+    d->framePending = false;
+    d->pendingFrame = Frame();
 }
 
 void Pointer::setup(wl_pointer *pointer)
@@ -106,6 +148,7 @@ void Pointer::Private::enterCallback(void *data, wl_pointer *pointer, uint32_t s
 
 void Pointer::Private::enter(uint32_t serial, wl_surface *surface, const QPointF &relativeToSurface)
 {
+    emitPendingFrame();
     enteredSurface = QPointer<Surface>(Surface::get(surface));
     enteredSerial = serial;
     Q_EMIT q->entered(serial, relativeToSurface);
@@ -121,6 +164,7 @@ void Pointer::Private::leaveCallback(void *data, wl_pointer *pointer, uint32_t s
 
 void Pointer::Private::leave(uint32_t serial)
 {
+    emitPendingFrame();
     enteredSurface.clear();
     Q_EMIT q->left(serial);
 }
@@ -129,6 +173,13 @@ void Pointer::Private::motionCallback(void *data, wl_pointer *pointer, uint32_t
 {
     auto p = reinterpret_cast<Pointer::Private *>(data);
     Q_ASSERT(p->pointer == pointer);
+    if (p->aggregateFrames) {
+        p->pendingFrame.hasMotion = true;
+        p->pendingFrame.position = QPointF(wl_fixed_to_double(sx), wl_fixed_to_double(sy));
+        p->pendingFrame.motionTime = time;
+        p->aggregated();
+        return;
+    }
     Q_EMIT p->q->motion(QPointF(wl_fixed_to_double(sx), wl_fixed_to_double(sy)), time);
 }
 
@@ -143,6 +194,11 @@ void Pointer::Private::buttonCallback(void *data, wl_pointer *pointer, uint32_t
             return ButtonState::Pressed;
         }
     };
+    if (p->aggregateFrames) {
+        p->pendingFrame.buttons.append({serial, time, button, toState()});
+        p->aggregated();
+        return;
+    }
     Q_EMIT p->q->buttonStateChanged(serial, time, button, toState());
 }
 
@@ -150,6 +206,14 @@ void Pointer::Private::axisCallback(void *data, wl_pointer *pointer, uint32_t ti
 {
     auto p = reinterpret_cast<Pointer::Private *>(data);
     Q_ASSERT(p->pointer == pointer);
+    if (p->aggregateFrames) {
+        Frame::AxisEvent &event = p->pendingAxisEvent(axis);
+        event.changed = true;
+        event.time = time;
+        event.delta += wl_fixed_to_double(value);
+        p->aggregated();
+        return;
+    }
     Q_EMIT p->q->axisChanged(time, wlAxisToPointerAxis(axis), wl_fixed_to_double(value));
 }
 
@@ -157,6 +221,7 @@ void Pointer::Private::frameCallback(void *data, wl_pointer *pointer)
 {
     auto p = reinterpret_cast<Pointer::Private *>(data);
     Q_ASSERT(p->pointer == pointer);
+    p->emitPendingFrame();
     Q_EMIT p->q->frame();
 }
 
@@ -182,6 +247,12 @@ void Pointer::Private::axisSourceCallback(void *data, wl_pointer *pointer, uint3
         Q_UNREACHABLE();
         break;
     }
+    if (p->aggregateFrames) {
+        p->pendingFrame.hasAxisSource = true;
+        p->pendingFrame.axisSource = source;
+        p->aggregated();
+        return;
+    }
     Q_EMIT p->q->axisSourceChanged(source);
 }
 
@@ -189,6 +260,13 @@ void Pointer::Private::axisStopCallback(void *data, wl_pointer *pointer, uint32_
 {
     auto p = reinterpret_cast<Pointer::Private *>(data);
     Q_ASSERT(p->pointer == pointer);
+    if (p->aggregateFrames) {
+        Frame::AxisEvent &event = p->pendingAxisEvent(axis);
+        event.time = time;
+        event.stopped = true;
+        p->aggregated();
+        return;
+    }
     Q_EMIT p->q->axisStopped(time, wlAxisToPointerAxis(axis));
 }
 
@@ -196,6 +274,11 @@ void Pointer::Private::axisDiscreteCallback(void *data, wl_pointer *pointer, uin
 {
     auto p = reinterpret_cast<Pointer::Private *>(data);
     Q_ASSERT(p->pointer == pointer);
+    if (p->aggregateFrames) {
+        p->pendingAxisEvent(axis).discreteDelta += discrete;
+        p->aggregated();
+        return;
+    }
     Q_EMIT p->q->axisDiscreteChanged(wlAxisToPointerAxis(axis), discrete);
 }
 
@@ -224,6 +307,21 @@ Surface *Pointer::enteredSurface() const
     return d->enteredSurface.data();
 }
 
+void Pointer::setFrameAggregation(bool enabled)
+{
+    if (d->aggregateFrames == enabled) {
+        return;
+    }
+    // the events collected so far must not get lost
+    d->emitPendingFrame();
+    d->aggregateFrames = enabled;
+}
+
+bool Pointer::frameAggregation() const
+{
+    return d->aggregateFrames;
+}
+
 bool Pointer::isValid() const
 {
     return d->pointer.isValid();
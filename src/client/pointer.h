@@ -8,6 +8,7 @@
 
 #include <QObject>
 #include <QPoint>
+#include <QVector>
 
 #include <DWayland/Client/kwaylandclient_export.h>
 
@@ -46,6 +47,45 @@ public:
         Continuous,
         WheelTilt,
     };
+    /**
+     * The events of one logical pointer frame, see setFrameAggregation.
+     **/
+    struct Frame {
+        struct Button {
+            quint32 serial = 0;
+            quint32 time = 0;
+            quint32 button = 0;
+            ButtonState state = ButtonState::Released;
+        };
+        struct AxisEvent {
+            /**
+             * Whether an axis event was sent for the axis in this frame.
+             **/
+            bool changed = false;
+            quint32 time = 0;
+            /**
+             * The sum of all axis events of the frame.
+             **/
+            qreal delta = 0;
+            qint32 discreteDelta = 0;
+            bool stopped = false;
+        };
+        /**
+         * Whether the pointer moved, @c position is the last position relative to the entered
+         * Surface and @c motionTime the time of the last motion event.
+         **/
+        bool hasMotion = false;
+        QPointF position;
+        quint32 motionTime = 0;
+        /**
+         * The button events of the frame in the order they were sent.
+         **/
+        QVector<Button> buttons;
+        bool hasAxisSource = false;
+        AxisSource axisSource = AxisSource::Wheel;
+        AxisEvent vertical;
+        AxisEvent horizontal;
+    };
     explicit Pointer(QObject *parent = nullptr);
     ~Pointer() override;
 
@@ -111,6 +151,23 @@ public:
      **/
     Surface *enteredSurface();
 
+    /**
+     * Enables the aggregation of the events of a logical frame.
+     *
+     * While enabled, the motion, button and axis events are not emitted as individual
+     * signals, but collected until the wl_pointer.frame event and emitted together with
+     * aggregatedFrame, right before frame. A client can handle the frame at once, e.g. a
+     * motion together with the button press at the new position, rather than reacting to
+     * every event. If the compositor does not send frames, every event is a frame of its own.
+     *
+     * The entered and left signals are not aggregated, a pending frame is emitted before
+     * them.
+     *
+     * By default the aggregation is disabled.
+     **/
+    void setFrameAggregation(bool enabled);
+    bool frameAggregation() const;
+
     operator wl_pointer *();
     operator wl_pointer *() const;
 
@@ -186,6 +243,12 @@ Q_SIGNALS:
      * @since 5.45
      **/
     void frame();
+    /**
+     * Emitted with all events of a logical frame if the frame aggregation is enabled.
+     *
+     * @see setFrameAggregation
+     **/
+    void aggregatedFrame(const KWayland::Client::Pointer::Frame &frame);
 
 private:
     class Private;
@@ -198,5 +261,6 @@ private:
 Q_DECLARE_METATYPE(KWayland::Client::Pointer::ButtonState)
 Q_DECLARE_METATYPE(KWayland::Client::Pointer::Axis)
 Q_DECLARE_METATYPE(KWayland::Client::Pointer::AxisSource)
+Q_DECLARE_METATYPE(KWayland::Client::Pointer::Frame)
 
 #endif
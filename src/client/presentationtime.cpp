@@ -0,0 +1,283 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "presentationtime.h"
+#include "event_queue.h"
+#include "output.h"
+#include "surface.h"
+#include "wayland_pointer_p.h"
+// Qt
+#include <QPointer>
+
+#include <wayland-presentation-time-client-protocol.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN PresentationTime::Private
+{
+public:
+    Private(PresentationTime *q);
+
+    void setup(wp_presentation *arg);
+
+    WaylandPointer<wp_presentation, wp_presentation_destroy> presentation;
+    EventQueue *queue = nullptr;
+    qint32 clockId = -1;
+
+private:
+    static void clockIdCallback(void *data, wp_presentation *presentation, uint32_t clockId);
+    static const struct wp_presentation_listener s_listener;
+
+    PresentationTime *q;
+};
+
+const struct wp_presentation_listener PresentationTime::Private::s_listener = {clockIdCallback};
+
+PresentationTime::Private::Private(PresentationTime *q)
+    : q(q)
+{
+}
+
+void PresentationTime::Private::clockIdCallback(void *data, wp_presentation *presentation, uint32_t clockId)
+{
+    auto p = reinterpret_cast<PresentationTime::Private *>(data);
+    Q_ASSERT(p->presentation == presentation);
+    p->clockId = clockId;
+    Q_EMIT p->q->clockIdChanged();
+}
+
+void PresentationTime::Private::setup(wp_presentation *arg)
+{
+    Q_ASSERT(arg);
+    Q_ASSERT(!presentation);
+    presentation.setup(arg);
+    wp_presentation_add_listener(presentation, &s_listener, this);
+}
+
+PresentationTime::PresentationTime(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+PresentationTime::~PresentationTime()
+{
+    release();
+}
+
+void PresentationTime::setup(wp_presentation *presentation)
+{
+    d->setup(presentation);
+}
+
+void PresentationTime::release()
+{
+    d->presentation.release();
+}
+
+void PresentationTime::destroy()
+{
+    d->presentation.destroy();
+}
+
+PresentationTime::operator wp_presentation *()
+{
+    return d->presentation;
+}
+
+PresentationTime::operator wp_presentation *() const
+{
+    return d->presentation;
+}
+
+bool PresentationTime::isValid() const
+{
+    return d->presentation.isValid();
+}
+
+void PresentationTime::setEventQueue(EventQueue *queue)
+{
+    d->queue = queue;
+}
+
+EventQueue *PresentationTime::eventQueue()
+{
+    return d->queue;
+}
+
+qint32 PresentationTime::clockId() const
+{
+    return d->clockId;
+}
+
+PresentationFeedback *PresentationTime::createFeedback(Surface *surface, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    auto p = new PresentationFeedback(parent);
+    auto w = wp_presentation_feedback(d->presentation, *surface);
+    if (d->queue) {
+        d->queue->addProxy(w);
+    }
+    p->setup(w);
+    return p;
+}
+
+class Q_DECL_HIDDEN PresentationFeedback::Private
+{
+public:
+    Private(PresentationFeedback *q);
+
+    void setup(struct wp_presentation_feedback *arg);
+
+    WaylandPointer<struct wp_presentation_feedback, wp_presentation_feedback_destroy> feedback;
+    std::chrono::nanoseconds timestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds refresh = std::chrono::nanoseconds::zero();
+    quint64 sequence = 0;
+    Kinds kinds;
+    QPointer<Output> syncOutput;
+
+private:
+    static void syncOutputCallback(void *data, struct wp_presentation_feedback *feedback, wl_output *output);
+    static void presentedCallback(void *data,
+                                  struct wp_presentation_feedback *feedback,
+                                  uint32_t tv_sec_hi,
+                                  uint32_t tv_sec_lo,
+                                  uint32_t tv_nsec,
+                                  uint32_t refresh,
+                                  uint32_t seq_hi,
+                                  uint32_t seq_lo,
+                                  uint32_t flags);
+    static void discardedCallback(void *data, struct wp_presentation_feedback *feedback);
+    static const struct wp_presentation_feedback_listener s_listener;
+
+    PresentationFeedback *q;
+};
+
+const struct wp_presentation_feedback_listener PresentationFeedback::Private::s_listener = {
+    syncOutputCallback,
+    presentedCallback,
+    discardedCallback,
+};
+
+PresentationFeedback::Private::Private(PresentationFeedback *q)
+    : q(q)
+{
+}
+
+void PresentationFeedback::Private::syncOutputCallback(void *data, struct wp_presentation_feedback *feedback, wl_output *output)
+{
+    auto p = reinterpret_cast<PresentationFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    // the Output is only known if the client created a wrapper for the wl_output
+    p->syncOutput = Output::get(output);
+}
+
+void PresentationFeedback::Private::presentedCallback(void *data,
+                                                      struct wp_presentation_feedback *feedback,
+                                                      uint32_t tv_sec_hi,
+                                                      uint32_t tv_sec_lo,
+                                                      uint32_t tv_nsec,
+                                                      uint32_t refresh,
+                                                      uint32_t seq_hi,
+                                                      uint32_t seq_lo,
+                                                      uint32_t flags)
+{
+    auto p = reinterpret_cast<PresentationFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    const quint64 seconds = (quint64(tv_sec_hi) << 32) | tv_sec_lo;
+    p->timestamp = std::chrono::seconds(seconds) + std::chrono::nanoseconds(tv_nsec);
+    p->refresh = std::chrono::nanoseconds(refresh);
+    p->sequence = (quint64(seq_hi) << 32) | seq_lo;
+    p->kinds = Kinds(int(flags));
+    // the server destroys the object after sending this event, the proxy has to follow
+    p->feedback.release();
+    Q_EMIT p->q->presented();
+}
+
+void PresentationFeedback::Private::discardedCallback(void *data, struct wp_presentation_feedback *feedback)
+{
+    auto p = reinterpret_cast<PresentationFeedback::Private *>(data);
+    Q_ASSERT(p->feedback == feedback);
+    p->feedback.release();
+    Q_EMIT p->q->discarded();
+}
+
+void PresentationFeedback::Private::setup(struct wp_presentation_feedback *arg)
+{
+    Q_ASSERT(arg);
+    Q_ASSERT(!feedback);
+    feedback.setup(arg);
+    wp_presentation_feedback_add_listener(feedback, &s_listener, this);
+}
+
+PresentationFeedback::PresentationFeedback(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+PresentationFeedback::~PresentationFeedback()
+{
+    release();
+}
+
+void PresentationFeedback::setup(struct wp_presentation_feedback *feedback)
+{
+    d->setup(feedback);
+}
+
+void PresentationFeedback::release()
+{
+    d->feedback.release();
+}
+
+void PresentationFeedback::destroy()
+{
+    d->feedback.destroy();
+}
+
+PresentationFeedback::operator struct wp_presentation_feedback *()
+{
+    return d->feedback;
+}
+
+PresentationFeedback::operator struct wp_presentation_feedback *() const
+{
+    return d->feedback;
+}
+
+bool PresentationFeedback::isValid() const
+{
+    return d->feedback.isValid();
+}
+
+std::chrono::nanoseconds PresentationFeedback::timestamp() const
+{
+    return d->timestamp;
+}
+
+std::chrono::nanoseconds PresentationFeedback::refresh() const
+{
+    return d->refresh;
+}
+
+quint64 PresentationFeedback::sequence() const
+{
+    return d->sequence;
+}
+
+PresentationFeedback::Kinds PresentationFeedback::kinds() const
+{
+    return d->kinds;
+}
+
+Output *PresentationFeedback::syncOutput() const
+{
+    return d->syncOutput;
+}
+
+}
+}
@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_PRESENTATIONTIME_H
+#define WAYLAND_PRESENTATIONTIME_H
+
+#include <QObject>
+// std
+#include <chrono>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+struct wp_presentation;
+struct wp_presentation_feedback;
+
+namespace KWayland
+{
+namespace Client
+{
+class EventQueue;
+class Output;
+class PresentationFeedback;
+class Surface;
+
+/**
+ * @short Wrapper for the wp_presentation interface.
+ *
+ * This class provides a convenient wrapper for the wp_presentation interface.
+ *
+ * To use this class one needs to interact with the Registry. There are two
+ * possible ways to create the PresentationTime interface:
+ * @code
+ * PresentationTime *p = registry->createPresentationTime(name, version);
+ * @endcode
+ *
+ * This creates the PresentationTime and sets it up directly. As an alternative this
+ * can also be done in a more low level way:
+ * @code
+ * PresentationTime *p = new PresentationTime;
+ * p->setup(registry->bindPresentationTime(name, version));
+ * @endcode
+ *
+ * The PresentationTime can be used as a drop-in replacement for any wp_presentation
+ * pointer as it provides matching cast operators.
+ *
+ * @see Registry
+ * @see PresentationFeedback
+ **/
+class KWAYLANDCLIENT_EXPORT PresentationTime : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Creates a new PresentationTime.
+     * Note: after constructing the PresentationTime it is not yet valid and one needs
+     * to call setup. In order to get a ready to use PresentationTime prefer using
+     * Registry::createPresentationTime.
+     **/
+    explicit PresentationTime(QObject *parent = nullptr);
+    ~PresentationTime() override;
+
+    /**
+     * Setup this PresentationTime to manage the @p presentation.
+     * When using Registry::createPresentationTime there is no need to call this
+     * method.
+     **/
+    void setup(wp_presentation *presentation);
+    /**
+     * @returns @c true if managing a wp_presentation.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_presentation interface.
+     * After the interface has been released the PresentationTime instance is no
+     * longer valid and can be setup with another wp_presentation interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this PresentationTime.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. If the connection is not valid anymore, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail. This method cleans up the data, so
+     * that the instance can be deleted or set up to a new wp_presentation interface
+     * once there is a new connection available.
+     *
+     * It is suggested to connect this method to ConnectionThread::connectionDied:
+     * @code
+     * connect(connection, &ConnectionThread::connectionDied, presentationTime, &PresentationTime::destroy);
+     * @endcode
+     *
+     * @see release
+     **/
+    void destroy();
+
+    /**
+     * Sets the @p queue to use for creating objects with this PresentationTime.
+     **/
+    void setEventQueue(EventQueue *queue);
+    /**
+     * @returns The event queue to use for creating objects with this PresentationTime.
+     **/
+    EventQueue *eventQueue();
+
+    /**
+     * @returns The clock the presentation timestamps are taken from, e.g. @c CLOCK_MONOTONIC,
+     * or @c -1 if the server didn't announce it yet.
+     * @see clockIdChanged
+     **/
+    qint32 clockId() const;
+
+    /**
+     * Requests feedback for the next content update of @p surface. The feedback applies to
+     * the state which gets committed next, thus this has to be called before Surface::commit.
+     *
+     * The returned PresentationFeedback emits either presented or discarded exactly once.
+     * @param surface The Surface whose next commit should be reported
+     * @param parent The parent object for the PresentationFeedback
+     * @returns The created PresentationFeedback
+     **/
+    PresentationFeedback *createFeedback(Surface *surface, QObject *parent = nullptr);
+
+    operator wp_presentation *();
+    operator wp_presentation *() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the server announced the clock used for the presentation timestamps.
+     **/
+    void clockIdChanged();
+    /**
+     * The corresponding global for this interface on the Registry got removed.
+     *
+     * This signal gets only emitted if the PresentationTime got created by
+     * Registry::createPresentationTime
+     **/
+    void removed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Wrapper for the wp_presentation_feedback interface.
+ *
+ * A PresentationFeedback reports when the content update it was created for turned
+ * visible on an Output, or that it never did because it got superseded by a later
+ * commit or the Surface got unmapped.
+ *
+ * The timing information is available through the getters once presented got emitted.
+ * Afterwards the underlying wp_presentation_feedback is gone, the PresentationFeedback
+ * can be deleted at any time.
+ *
+ * @see PresentationTime
+ **/
+class KWAYLANDCLIENT_EXPORT PresentationFeedback : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Describes how the presentation timestamp was obtained.
+     **/
+    enum class Kind {
+        /**
+         * The presentation was synchronized to the vertical retrace of the Output
+         **/
+        Vsync = 1 << 0,
+        /**
+         * The timestamp was provided by the display hardware
+         **/
+        HwClock = 1 << 1,
+        /**
+         * The display hardware signalled the completion of the presentation
+         **/
+        HwCompletion = 1 << 2,
+        /**
+         * The client buffer was scanned out directly
+         **/
+        ZeroCopy = 1 << 3,
+    };
+    Q_DECLARE_FLAGS(Kinds, Kind)
+
+    ~PresentationFeedback() override;
+
+    /**
+     * Setup this PresentationFeedback to manage the @p feedback.
+     * When using PresentationTime::createFeedback there is no need to call this
+     * method.
+     **/
+    void setup(wp_presentation_feedback *feedback);
+    /**
+     * @returns @c true if managing a wp_presentation_feedback, i.e. neither presented
+     * nor discarded got emitted yet.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the wp_presentation_feedback interface. No signal is emitted afterwards.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this PresentationFeedback.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away.
+     * @see release
+     **/
+    void destroy();
+
+    /**
+     * @returns The time at which the content update turned visible, measured with the
+     * clock announced by PresentationTime::clockId.
+     **/
+    std::chrono::nanoseconds timestamp() const;
+    /**
+     * @returns The duration until the next possible presentation on the Output, or
+     * @c 0 if the Output has no constant refresh rate.
+     **/
+    std::chrono::nanoseconds refresh() const;
+    /**
+     * @returns The vertical retrace counter of the Output, only meaningful if kinds
+     * contains Kind::Vsync.
+     **/
+    quint64 sequence() const;
+    /**
+     * @returns How the presentation timestamp was obtained.
+     **/
+    Kinds kinds() const;
+    /**
+     * @returns The Output the content update got presented on, or @c null if it is not
+     * known to this client.
+     **/
+    Output *syncOutput() const;
+
+    operator wp_presentation_feedback *();
+    operator wp_presentation_feedback *() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the content update turned visible. The timing information is
+     * available through the getters.
+     **/
+    void presented();
+    /**
+     * Emitted when the content update never got presented.
+     **/
+    void discarded();
+
+private:
+    friend class PresentationTime;
+    explicit PresentationFeedback(QObject *parent = nullptr);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWayland::Client::PresentationFeedback::Kinds)
+
+#endif
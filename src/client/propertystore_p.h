@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_PROPERTY_STORE_P_H
+#define WAYLAND_PROPERTY_STORE_P_H
+
+#include <QtGlobal>
+
+#include <tuple>
+#include <utility>
+
+namespace KWayland
+{
+namespace Client
+{
+/**
+ * Double buffered properties of a client wrapper. The events of the compositor write the
+ * pending values, apply() makes all of them current at once, e.g. on the done event, and
+ * returns a mask of the properties which really changed, so the wrapper can emit a single
+ * signal for the whole batch instead of one per property.
+ *
+ * The properties are addressed by the enumerators of @p Id, the n-th enumerator refers to the
+ * n-th of @p Types:
+ * @code
+ * enum class Property { Name, Size };
+ * PropertyStore<Property, QString, QSize> properties;
+ * properties.setPending<Property::Name>(name);
+ * if (properties.apply() & properties.bit(Property::Name)) { ... }
+ * @endcode
+ */
+template<typename Id, typename... Types>
+class PropertyStore
+{
+    static_assert(sizeof...(Types) <= 32, "the dirty mask has room for 32 properties");
+
+public:
+    using Mask = quint32;
+    template<Id id>
+    using Type = std::tuple_element_t<std::size_t(id), std::tuple<Types...>>;
+
+    static constexpr Mask bit(Id id)
+    {
+        return Mask(1) << std::size_t(id);
+    }
+
+    /**
+     * The value which got applied last.
+     */
+    template<Id id>
+    const Type<id> &value() const
+    {
+        return std::get<std::size_t(id)>(m_current);
+    }
+
+    /**
+     * The value which becomes current with the next apply().
+     */
+    template<Id id>
+    const Type<id> &pendingValue() const
+    {
+        return std::get<std::size_t(id)>(m_pending);
+    }
+
+    template<Id id, typename T>
+    void setPending(T &&value)
+    {
+        auto &pending = std::get<std::size_t(id)>(m_pending);
+        pending = std::forward<T>(value);
+        // setting the current value again undoes an earlier change
+        if (pending == std::get<std::size_t(id)>(m_current)) {
+            m_dirty &= ~bit(id);
+        } else {
+            m_dirty |= bit(id);
+        }
+    }
+
+    bool isDirty(Id id) const
+    {
+        return m_dirty & bit(id);
+    }
+
+    /**
+     * The properties whose pending value differs from the current one.
+     */
+    Mask dirty() const
+    {
+        return m_dirty;
+    }
+
+    /**
+     * Makes the pending values current. Only the changed properties get copied.
+     * @returns the mask of the changed properties
+     */
+    Mask apply()
+    {
+        const Mask changed = m_dirty;
+        if (changed) {
+            applyDirty(std::index_sequence_for<Types...>());
+            m_dirty = 0;
+        }
+        return changed;
+    }
+
+    /**
+     * Drops all pending values.
+     */
+    void discard()
+    {
+        m_pending = m_current;
+        m_dirty = 0;
+    }
+
+private:
+    template<std::size_t... I>
+    void applyDirty(std::index_sequence<I...>)
+    {
+        ((m_dirty & (Mask(1) << I) ? void(std::get<I>(m_current) = std::get<I>(m_pending)) : void()), ...);
+    }
+
+    std::tuple<Types...> m_current;
+    std::tuple<Types...> m_pending;
+    Mask m_dirty = 0;
+};
+
+}
+}
+
+#endif
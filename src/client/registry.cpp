@@ -10,6 +10,8 @@
 #include "compositor.h"
 #include "connection_thread.h"
 #include "contrast.h"
+#include "cursorshape.h"
+#include "dmabuf_pool.h"
 #include "datacontroldevicemanager.h"
 #include "datadevicemanager.h"
 #include "dpms.h"
@@ -19,6 +21,7 @@
 #include "idle.h"
 #include "idleinhibit.h"
 #include "keystate.h"
+#include "linuxdrmsyncobj.h"
 #include "logging.h"
 #include "output.h"
 #include "outputconfiguration.h"
@@ -29,11 +32,13 @@
 #include "plasmashell.h"
 #include "plasmavirtualdesktop.h"
 #include "plasmawindowmanagement.h"
+#include "presentationtime.h"
 #include "pointerconstraints.h"
 #include "pointergestures.h"
 #include "primaryoutput_v1.h"
 #include "relativepointer.h"
 #include "remote_access.h"
+#include "screencast.h"
 #include "seat.h"
 #include "server_decoration.h"
 #include "server_decoration_palette.h"
@@ -56,18 +61,25 @@
 #include "globalproperty.h"
 // Qt
 #include <QDebug>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QVector>
 // wayland
 #include "../compat/wayland-xdg-shell-v5-client-protocol.h"
 #include <wayland-appmenu-client-protocol.h>
 #include <wayland-blur-client-protocol.h>
 #include <wayland-client-protocol.h>
 #include <wayland-contrast-client-protocol.h>
+#include <wayland-cursor-shape-v1-client-protocol.h>
 #include <wayland-dpms-client-protocol.h>
 #include <wayland-fake-input-client-protocol.h>
 #include <wayland-fullscreen-shell-client-protocol.h>
 #include <wayland-idle-client-protocol.h>
 #include <wayland-idle-inhibit-unstable-v1-client-protocol.h>
 #include <wayland-keystate-client-protocol.h>
+#include <wayland-linux-dmabuf-unstable-v1-client-protocol.h>
+#include <wayland-linux-drm-syncobj-v1-client-protocol.h>
 #include <wayland-org_kde_kwin_outputdevice-client-protocol.h>
 #include <wayland-kde-output-device-v2-client-protocol.h>
 #include <wayland-kde-primary-output-v1-client-protocol.h>
@@ -78,8 +90,10 @@
 #include <wayland-plasma-window-management-client-protocol.h>
 #include <wayland-pointer-constraints-unstable-v1-client-protocol.h>
 #include <wayland-pointer-gestures-unstable-v1-client-protocol.h>
+#include <wayland-presentation-time-client-protocol.h>
 #include <wayland-relativepointer-unstable-v1-client-protocol.h>
 #include <wayland-remote-access-client-protocol.h>
+#include <wayland-zkde-screencast-unstable-v1-client-protocol.h>
 #include <wayland-server-decoration-client-protocol.h>
 #include <wayland-server-decoration-palette-client-protocol.h>
 #include <wayland-shadow-client-protocol.h>
@@ -462,9 +476,55 @@ static const QMap<Registry::Interface, SuppertedInterfaceData> s_interfaces = {
         &Registry::dataControlDeviceManagerAnnounced,
         &Registry::dataControlDeviceManagerRemoved
     }},
+    {Registry::Interface::PresentationTime, {
+        1,
+        QByteArrayLiteral("wp_presentation"),
+        &wp_presentation_interface,
+        &Registry::presentationTimeAnnounced,
+        &Registry::presentationTimeRemoved
+    }},
+    {Registry::Interface::CursorShapeManagerV1, {
+        1,
+        QByteArrayLiteral("wp_cursor_shape_manager_v1"),
+        &wp_cursor_shape_manager_v1_interface,
+        &Registry::cursorShapeManagerV1Announced,
+        &Registry::cursorShapeManagerV1Removed
+    }},
+    {Registry::Interface::LinuxDmabufV1, {
+        4,
+        QByteArrayLiteral("zwp_linux_dmabuf_v1"),
+        &zwp_linux_dmabuf_v1_interface,
+        &Registry::linuxDmabufV1Announced,
+        &Registry::linuxDmabufV1Removed
+    }},
+    {Registry::Interface::ScreencastV1, {
+        2,
+        QByteArrayLiteral("zkde_screencast_unstable_v1"),
+        &zkde_screencast_unstable_v1_interface,
+        &Registry::screencastV1Announced,
+        &Registry::screencastV1Removed
+    }},
+    {Registry::Interface::LinuxDrmSyncObjV1, {
+        1,
+        QByteArrayLiteral("wp_linux_drm_syncobj_manager_v1"),
+        &wp_linux_drm_syncobj_manager_v1_interface,
+        &Registry::linuxDrmSyncObjV1Announced,
+        &Registry::linuxDrmSyncObjV1Removed
+    }},
 };
 // clang-format on
 
+// the announced interface names are resolved through a hash instead of comparing
+// against every known interface
+static const QHash<QByteArray, Registry::Interface> s_interfaceNames = [] {
+    QHash<QByteArray, Registry::Interface> names;
+    names.reserve(s_interfaces.size());
+    for (auto it = s_interfaces.constBegin(); it != s_interfaces.constEnd(); ++it) {
+        names.insert(it.value().name, it.key());
+    }
+    return names;
+}();
+
 static quint32 maxVersion(const Registry::Interface &interface)
 {
     auto it = s_interfaces.find(interface);
@@ -492,12 +552,21 @@ public:
     WaylandPointer<wl_registry, wl_registry_destroy> registry;
     static const struct wl_callback_listener s_callbackListener;
     WaylandPointer<wl_callback, wl_callback_destroy> callback;
+    WaylandPointer<wl_callback, wl_callback_destroy> readyCallback;
     EventQueue *queue = nullptr;
+    wl_display *display = nullptr;
+    QMap<Interface, quint32> requestedVersions;
+    QMap<Interface, QPointer<QObject>> requestedObjects;
+    bool requestedReady = false;
 
 private:
     void handleAnnounce(uint32_t name, const char *interface, uint32_t version);
     void handleRemove(uint32_t name);
     void handleGlobalSync();
+    void handleReadySync();
+    QObject *createInterface(Interface interface, quint32 name, quint32 version);
+    static void readySync(void *data, struct wl_callback *callback, uint32_t serial);
+    static const struct wl_callback_listener s_readyCallbackListener;
     static void globalAnnounce(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
     static void globalRemove(void *data, struct wl_registry *registry, uint32_t name);
     static void globalSync(void *data, struct wl_callback *callback, uint32_t serial);
@@ -508,7 +577,9 @@ private:
         uint32_t name;
         uint32_t version;
     };
-    QList<InterfaceData> m_interfaces;
+    // the announced globals per interface in the order of their announcement
+    QMap<Interface, QVector<InterfaceData>> m_interfaces;
+    QHash<uint32_t, Interface> m_names;
     static const struct wl_registry_listener s_registryListener;
 };
 
@@ -538,6 +609,7 @@ void Registry::release()
 {
     d->registry.release();
     d->callback.release();
+    d->readyCallback.release();
 }
 
 void Registry::destroy()
@@ -545,12 +617,15 @@ void Registry::destroy()
     Q_EMIT registryDestroyed();
     d->registry.destroy();
     d->callback.destroy();
+    d->readyCallback.destroy();
 }
 
 void Registry::create(wl_display *display)
 {
     Q_ASSERT(display);
     Q_ASSERT(!isValid());
+    d->display = display;
+    d->requestedReady = false;
     d->registry.setup(wl_display_get_registry(display));
     d->callback.setup(wl_display_sync(display));
     if (d->queue) {
@@ -569,6 +644,8 @@ void Registry::setup()
 {
     Q_ASSERT(isValid());
     d->setup();
+    // the announcements are the first round trip of every client, it starts right away
+    wl_display_flush(d->display);
 }
 
 void Registry::setEventQueue(EventQueue *queue)
@@ -594,6 +671,8 @@ EventQueue *Registry::eventQueue()
 const struct wl_registry_listener Registry::Private::s_registryListener = {globalAnnounce, globalRemove};
 
 const struct wl_callback_listener Registry::Private::s_callbackListener = {globalSync};
+
+const struct wl_callback_listener Registry::Private::s_readyCallbackListener = {readySync};
 #endif
 
 void Registry::Private::globalAnnounce(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
@@ -619,21 +698,46 @@ void Registry::Private::globalSync(void *data, wl_callback *callback, uint32_t s
     r->callback.release();
 }
 
+void Registry::Private::readySync(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(serial)
+    auto r = reinterpret_cast<Registry::Private *>(data);
+    Q_ASSERT(r->readyCallback == callback);
+    r->readyCallback.release();
+    r->handleReadySync();
+}
+
 void Registry::Private::handleGlobalSync()
 {
+    if (!requestedVersions.isEmpty() && display) {
+        // the requested interfaces got bound while dispatching the announcements, the server
+        // replies to this sync once it has sent their initial events
+        readyCallback.setup(wl_display_sync(display));
+        if (queue) {
+            queue->addProxy(readyCallback);
+        }
+        wl_callback_add_listener(readyCallback, &s_readyCallbackListener, this);
+        // don't wait for the end of the event loop iteration with the binds
+        wl_display_flush(display);
+        Q_EMIT q->interfacesAnnounced();
+        return;
+    }
     Q_EMIT q->interfacesAnnounced();
+    // nothing to wait for
+    handleReadySync();
+}
+
+void Registry::Private::handleReadySync()
+{
+    requestedReady = true;
+    Q_EMIT q->requestedInterfacesReady();
 }
 
 namespace
 {
 static Registry::Interface nameToInterface(const char *interface)
 {
-    for (auto it = s_interfaces.constBegin(); it != s_interfaces.constEnd(); ++it) {
-        if (qstrcmp(interface, it.value().name) == 0) {
-            return it.key();
-        }
-    }
-    return Registry::Interface::Unknown;
+    return s_interfaceNames.value(QByteArray::fromRawData(interface, qstrlen(interface)), Registry::Interface::Unknown);
 }
 }
 
@@ -646,7 +750,13 @@ void Registry::Private::handleAnnounce(uint32_t name, const char *interface, uin
         return;
     }
     qCDebug(KWAYLAND_CLIENT) << "Wayland Interface: " << interface << "/" << name << "/" << version;
-    m_interfaces.append({i, name, version});
+    m_interfaces[i].append({i, name, version});
+    m_names.insert(name, i);
+    auto requested = requestedVersions.constFind(i);
+    if (requested != requestedVersions.constEnd() && !requestedObjects.value(i)) {
+        const quint32 bindVersion = *requested == 0 ? version : qMin(*requested, version);
+        requestedObjects.insert(i, createInterface(i, name, bindVersion));
+    }
     auto it = s_interfaces.constFind(i);
     if (it != s_interfaces.end()) {
         Q_EMIT(q->*it.value().announcedSignal)(name, version);
@@ -655,15 +765,21 @@ void Registry::Private::handleAnnounce(uint32_t name, const char *interface, uin
 
 void Registry::Private::handleRemove(uint32_t name)
 {
-    auto it = std::find_if(m_interfaces.begin(), m_interfaces.end(), [name](const InterfaceData &data) {
-        return data.name == name;
-    });
-    if (it != m_interfaces.end()) {
-        InterfaceData data = *(it);
-        m_interfaces.erase(it);
-        auto sit = s_interfaces.find(data.interface);
+    const Interface interface = m_names.take(name);
+    if (interface != Interface::Unknown) {
+        QVector<InterfaceData> &announced = m_interfaces[interface];
+        auto it = std::find_if(announced.begin(), announced.end(), [name](const InterfaceData &data) {
+            return data.name == name;
+        });
+        if (it != announced.end()) {
+            announced.erase(it);
+        }
+        if (announced.isEmpty()) {
+            m_interfaces.remove(interface);
+        }
+        auto sit = s_interfaces.find(interface);
         if (sit != s_interfaces.end()) {
-            Q_EMIT(q->*sit.value().removedSignal)(data.name);
+            Q_EMIT(q->*sit.value().removedSignal)(name);
         }
     }
     Q_EMIT q->interfaceRemoved(name);
@@ -671,42 +787,118 @@ void Registry::Private::handleRemove(uint32_t name)
 
 bool Registry::Private::hasInterface(Registry::Interface interface) const
 {
-    auto it = std::find_if(m_interfaces.constBegin(), m_interfaces.constEnd(), [interface](const InterfaceData &data) {
-        return data.interface == interface;
-    });
-    return it != m_interfaces.constEnd();
+    return m_interfaces.contains(interface);
 }
 
 QVector<Registry::AnnouncedInterface> Registry::Private::interfaces(Interface interface) const
 {
     QVector<Registry::AnnouncedInterface> retVal;
-    for (auto it = m_interfaces.constBegin(); it != m_interfaces.constEnd(); ++it) {
-        const auto &data = *it;
-        if (data.interface == interface) {
-            retVal << AnnouncedInterface{data.name, data.version};
-        }
+    const QVector<InterfaceData> announced = m_interfaces.value(interface);
+    retVal.reserve(announced.count());
+    for (const InterfaceData &data : announced) {
+        retVal << AnnouncedInterface{data.name, data.version};
     }
     return retVal;
 }
 
 Registry::AnnouncedInterface Registry::Private::interface(Interface interface) const
 {
-    const auto all = interfaces(interface);
-    if (!all.isEmpty()) {
-        return all.last();
+    auto it = m_interfaces.constFind(interface);
+    if (it != m_interfaces.constEnd() && !it->isEmpty()) {
+        return AnnouncedInterface{it->last().name, it->last().version};
     }
     return AnnouncedInterface{0, 0};
 }
 
 Registry::Interface Registry::Private::interfaceForName(quint32 name) const
 {
-    auto it = std::find_if(m_interfaces.constBegin(), m_interfaces.constEnd(), [name](const InterfaceData &data) {
-        return data.name == name;
-    });
-    if (it == m_interfaces.constEnd()) {
-        return Interface::Unknown;
+    return m_names.value(name, Interface::Unknown);
+}
+
+QObject *Registry::Private::createInterface(Interface interface, quint32 name, quint32 version)
+{
+    switch (interface) {
+    // clang-format off
+#define CREATE_CASE(__INTERFACE__, __NAME__) \
+    case Interface::__INTERFACE__: \
+        return q->create##__NAME__(name, version, q);
+    CREATE_CASE(Compositor, Compositor)
+    CREATE_CASE(Shell, Shell)
+    CREATE_CASE(Seat, Seat)
+    CREATE_CASE(Shm, ShmPool)
+    CREATE_CASE(Output, Output)
+    CREATE_CASE(FullscreenShell, FullscreenShell)
+    CREATE_CASE(SubCompositor, SubCompositor)
+    CREATE_CASE(DataDeviceManager, DataDeviceManager)
+    CREATE_CASE(PlasmaShell, PlasmaShell)
+    CREATE_CASE(PlasmaWindowManagement, PlasmaWindowManagement)
+    CREATE_CASE(Idle, Idle)
+    CREATE_CASE(FakeInput, FakeInput)
+    CREATE_CASE(Shadow, ShadowManager)
+    CREATE_CASE(Blur, BlurManager)
+    CREATE_CASE(Contrast, ContrastManager)
+    CREATE_CASE(Slide, SlideManager)
+    CREATE_CASE(Dpms, DpmsManager)
+    CREATE_CASE(OutputManagement, OutputManagement)
+    CREATE_CASE(OutputManagementV2, OutputManagementV2)
+    CREATE_CASE(OutputDevice, OutputDevice)
+    CREATE_CASE(OutputDeviceV2, OutputDeviceV2)
+    CREATE_CASE(PrimaryOutputV1, PrimaryOutputV1)
+    CREATE_CASE(ServerSideDecorationManager, ServerSideDecorationManager)
+    CREATE_CASE(TextInputManagerUnstableV0, TextInputManager)
+    CREATE_CASE(TextInputManagerUnstableV2, TextInputManager)
+    CREATE_CASE(XdgShellUnstableV5, XdgShell)
+    CREATE_CASE(XdgShellUnstableV6, XdgShell)
+    CREATE_CASE(XdgShellStable, XdgShell)
+    CREATE_CASE(RelativePointerManagerUnstableV1, RelativePointerManager)
+    CREATE_CASE(PointerGesturesUnstableV1, PointerGestures)
+    CREATE_CASE(PointerConstraintsUnstableV1, PointerConstraints)
+    CREATE_CASE(XdgExporterUnstableV2, XdgExporter)
+    CREATE_CASE(XdgImporterUnstableV2, XdgImporter)
+    CREATE_CASE(IdleInhibitManagerUnstableV1, IdleInhibitManager)
+    CREATE_CASE(AppMenu, AppMenuManager)
+    CREATE_CASE(ServerSideDecorationPalette, ServerSideDecorationPaletteManager)
+    CREATE_CASE(RemoteAccessManager, RemoteAccessManager)
+    CREATE_CASE(PlasmaVirtualDesktopManagement, PlasmaVirtualDesktopManagement)
+    CREATE_CASE(XdgOutputUnstableV1, XdgOutputManager)
+    CREATE_CASE(XdgDecorationUnstableV1, XdgDecorationManager)
+    CREATE_CASE(Keystate, Keystate)
+    CREATE_CASE(PlasmaActivationFeedback, PlasmaActivationFeedback)
+    CREATE_CASE(ClientManagement, ClientManagement)
+    CREATE_CASE(DDESeat, DDESeat)
+    CREATE_CASE(DDEShell, DDEShell)
+    CREATE_CASE(Strut, Strut)
+    CREATE_CASE(GlobalProperty, GlobalProperty)
+    CREATE_CASE(DataControlDeviceManager, DataControlDeviceManager)
+    CREATE_CASE(PresentationTime, PresentationTime)
+    CREATE_CASE(CursorShapeManagerV1, CursorShapeManager)
+    CREATE_CASE(LinuxDmabufV1, DmaBufPool)
+    CREATE_CASE(ScreencastV1, ScreencastV1)
+    CREATE_CASE(LinuxDrmSyncObjV1, LinuxDrmSyncObjManager)
+#undef CREATE_CASE
+    // clang-format on
+    case Interface::Unknown:
+        break;
     }
-    return (*it).interface;
+    return nullptr;
+}
+
+void Registry::requestInterface(Interface interface, quint32 version)
+{
+    if (interface == Interface::Unknown) {
+        return;
+    }
+    d->requestedVersions.insert(interface, version);
+}
+
+bool Registry::requestedInterfacesAreReady() const
+{
+    return d->requestedReady;
+}
+
+QObject *Registry::requestedInterface(Interface interface) const
+{
+    return d->requestedObjects.value(interface);
 }
 
 bool Registry::hasInterface(Registry::Interface interface) const
@@ -782,6 +974,11 @@ BIND(DDEShell, dde_shell)
 BIND(Strut, com_deepin_kwin_strut)
 BIND(GlobalProperty, dde_globalproperty)
 BIND(DataControlDeviceManager, zwlr_data_control_manager_v1)
+BIND(PresentationTime, wp_presentation)
+BIND(CursorShapeManagerV1, wp_cursor_shape_manager_v1)
+BIND(LinuxDmabufV1, zwp_linux_dmabuf_v1)
+BIND(ScreencastV1, zkde_screencast_unstable_v1)
+BIND(LinuxDrmSyncObjV1, wp_linux_drm_syncobj_manager_v1)
 
 #undef BIND
 #undef BIND2
@@ -837,6 +1034,10 @@ CREATE(SlideManager)
 CREATE(DpmsManager)
 CREATE(ServerSideDecorationManager)
 CREATE2(ShmPool, Shm)
+CREATE2(CursorShapeManager, CursorShapeManagerV1)
+CREATE2(DmaBufPool, LinuxDmabufV1)
+CREATE2(LinuxDrmSyncObjManager, LinuxDrmSyncObjV1)
+CREATE(ScreencastV1)
 CREATE(AppMenuManager)
 CREATE(Keystate)
 CREATE(ServerSideDecorationPaletteManager)
@@ -845,6 +1046,7 @@ CREATE(DDESeat)
 CREATE(DDEShell)
 CREATE(Strut)
 CREATE(GlobalProperty)
+CREATE(PresentationTime)
 
 #undef CREATE
 #undef CREATE2
@@ -972,10 +1174,11 @@ static const wl_interface *wlInterface(Registry::Interface interface)
 template<typename T>
 T *Registry::Private::bind(Registry::Interface interface, uint32_t name, uint32_t version) const
 {
-    auto it = std::find_if(m_interfaces.constBegin(), m_interfaces.constEnd(), [=](const InterfaceData &data) {
-        return data.interface == interface && data.name == name && data.version >= version;
+    const QVector<InterfaceData> announced = m_interfaces.value(interface);
+    auto it = std::find_if(announced.constBegin(), announced.constEnd(), [=](const InterfaceData &data) {
+        return data.name == name && data.version >= version;
     });
-    if (it == m_interfaces.constEnd()) {
+    if (it == announced.constEnd()) {
         qCDebug(KWAYLAND_CLIENT) << "Don't have interface " << int(interface) << "with name " << name << "and minimum version" << version;
         return nullptr;
     }
@@ -10,6 +10,8 @@
 #include <QHash>
 #include <QObject>
 
+#include <memory>
+
 #include <DWayland/Client/kwaylandclient_export.h>
 
 struct wl_compositor;
@@ -62,6 +64,11 @@ struct dde_shell;
 struct com_deepin_kwin_strut;
 struct dde_globalproperty;
 struct zwlr_data_control_manager_v1;
+struct wp_presentation;
+struct wp_cursor_shape_manager_v1;
+struct zwp_linux_dmabuf_v1;
+struct zkde_screencast_unstable_v1;
+struct wp_linux_drm_syncobj_manager_v1;
 
 namespace KWayland
 {
@@ -118,6 +125,11 @@ class DDEShell;
 class Strut;
 class GlobalProperty;
 class DataControlDeviceManager;
+class PresentationTime;
+class CursorShapeManager;
+class DmaBufPool;
+class ScreencastV1;
+class LinuxDrmSyncObjManager;
 
 /**
  * @short Wrapper for the wl_registry interface.
@@ -203,6 +215,11 @@ public:
         Strut, ///< refers to com_deepin_kwin_strut interface
         GlobalProperty,
         DataControlDeviceManager, /// refers to zwlr_data_control_manager_v1
+        PresentationTime, ///< refers to wp_presentation
+        CursorShapeManagerV1, ///< refers to wp_cursor_shape_manager_v1
+        LinuxDmabufV1, ///< refers to zwp_linux_dmabuf_v1
+        ScreencastV1, ///< refers to zkde_screencast_unstable_v1
+        LinuxDrmSyncObjV1, ///< refers to wp_linux_drm_syncobj_manager_v1
     };
     explicit Registry(QObject *parent = nullptr);
     ~Registry() override;
@@ -261,6 +278,55 @@ public:
      **/
     EventQueue *eventQueue();
 
+    /**
+     * Requests the Registry to create the wrapper for @p interface as soon as the interface
+     * gets announced, in the same dispatch as the announcement. This saves the round trip of
+     * waiting for interfacesAnnounced before calling the create method.
+     *
+     * If the @p interface gets announced multiple times, only the first announcement is bound.
+     * Once all requested interfaces which got announced are bound and their initial events are
+     * received, requestedInterfacesReady is emitted.
+     *
+     * The interfaces have to be requested before the Registry gets setup.
+     *
+     * @param interface The interface to create
+     * @param version The version to bind, @c 0 binds the highest version supported by both sides
+     * @see requestedInterface
+     * @see requestedInterfacesReady
+     **/
+    void requestInterface(Interface interface, quint32 version = 0);
+    /**
+     * @returns The object created for the requested @p interface, @c null if the interface has
+     * not been announced (yet) or was not requested. The object is a child of the Registry and can
+     * be cast with qobject_cast to the type the create method for @p interface returns.
+     * @see requestInterface
+     **/
+    QObject *requestedInterface(Interface interface) const;
+    /**
+     * @returns @c true once requestedInterfacesReady got emitted for the current wl_registry.
+     **/
+    bool requestedInterfacesAreReady() const;
+    /**
+     * Invokes @p functor once the requested interfaces are ready, right away if they already
+     * are. It's invoked at most once and not at all if @p context gets destroyed before.
+     *
+     * Together with requestInterface the startup of a client needs no blocking roundtrip:
+     * @code
+     * registry->requestInterface(Registry::Interface::Compositor);
+     * registry->requestInterface(Registry::Interface::Seat);
+     * registry->create(connection);
+     * registry->setup();
+     * registry->whenRequestedInterfacesReady(this, [this] {
+     *     createWindow();
+     * });
+     * @endcode
+     * The announcements, the binds and the initial events of the bound interfaces take two
+     * round trips, the binds are sent while the announcements get dispatched.
+     * @see requestedInterfacesReady
+     **/
+    template<typename Functor>
+    void whenRequestedInterfacesReady(const QObject *context, Functor functor);
+
     /**
      * @returns @c true if managing a wl_registry.
      **/
@@ -776,6 +842,51 @@ public:
      * @since 5.54
      **/
     zwlr_data_control_manager_v1 *bindDataControlDeviceManager(uint32_t name, uint32_t version) const;
+    /**
+     * Binds the wp_presentation with @p name and @p version.
+     * If the @p name does not exist,
+     * @c null will be returned.
+     *
+     * Prefer using createPresentationTime instead.
+     * @see createPresentationTime
+     **/
+    wp_presentation *bindPresentationTime(uint32_t name, uint32_t version) const;
+    /**
+     * Binds the wp_cursor_shape_manager_v1 with @p name and @p version.
+     * If the @p name does not exist,
+     * @c null will be returned.
+     *
+     * Prefer using createCursorShapeManager instead.
+     * @see createCursorShapeManager
+     **/
+    wp_cursor_shape_manager_v1 *bindCursorShapeManagerV1(uint32_t name, uint32_t version) const;
+    /**
+     * Binds the zwp_linux_dmabuf_v1 with @p name and @p version.
+     * If the @p name does not exist,
+     * @c null will be returned.
+     *
+     * Prefer using createDmaBufPool instead.
+     * @see createDmaBufPool
+     **/
+    zwp_linux_dmabuf_v1 *bindLinuxDmabufV1(uint32_t name, uint32_t version) const;
+    /**
+     * Binds the wp_linux_drm_syncobj_manager_v1 with @p name and @p version.
+     * If the @p name does not exist,
+     * @c null will be returned.
+     *
+     * Prefer using createLinuxDrmSyncObjManager instead.
+     * @see createLinuxDrmSyncObjManager
+     **/
+    wp_linux_drm_syncobj_manager_v1 *bindLinuxDrmSyncObjV1(uint32_t name, uint32_t version) const;
+    /**
+     * Binds the zkde_screencast_unstable_v1 with @p name and @p version.
+     * If the @p name does not exist,
+     * @c null will be returned.
+     *
+     * Prefer using createScreencastV1 instead.
+     * @see createScreencastV1
+     **/
+    zkde_screencast_unstable_v1 *bindScreencastV1(uint32_t name, uint32_t version) const;
     ///@}
 
     /**
@@ -1473,6 +1584,81 @@ public:
      * @since 5.54
      **/
     DataControlDeviceManager *createDataControlDeviceManager(quint32 name, quint32 version, QObject *parent = nullptr);
+    /**
+     * Creates a PresentationTime and sets it up to manage the interface identified by
+     * @p name and @p version.
+     *
+     * Note: in case @p name is invalid or isn't for the wp_presentation interface,
+     * the returned PresentationTime will not be valid. Therefore it's recommended to call
+     * isValid on the created instance.
+     *
+     * @param name The name of the wp_presentation interface to bind
+     * @param version The version or the wp_presentation interface to use
+     * @param parent The parent for PresentationTime
+     *
+     * @returns The created PresentationTime.
+     **/
+    PresentationTime *createPresentationTime(quint32 name, quint32 version, QObject *parent = nullptr);
+    /**
+     * Creates a CursorShapeManager and sets it up to manage the interface identified by
+     * @p name and @p version.
+     *
+     * Note: in case @p name is invalid or isn't for the wp_cursor_shape_manager_v1 interface,
+     * the returned CursorShapeManager will not be valid. Therefore it's recommended to call
+     * isValid on the created instance.
+     *
+     * @param name The name of the wp_cursor_shape_manager_v1 interface to bind
+     * @param version The version or the wp_cursor_shape_manager_v1 interface to use
+     * @param parent The parent for CursorShapeManager
+     *
+     * @returns The created CursorShapeManager.
+     **/
+    CursorShapeManager *createCursorShapeManager(quint32 name, quint32 version, QObject *parent = nullptr);
+    /**
+     * Creates a DmaBufPool and sets it up to manage the interface identified by
+     * @p name and @p version.
+     *
+     * Note: in case @p name is invalid or isn't for the zwp_linux_dmabuf_v1 interface,
+     * the returned DmaBufPool will not be valid. Therefore it's recommended to call
+     * isValid on the created instance.
+     *
+     * @param name The name of the zwp_linux_dmabuf_v1 interface to bind
+     * @param version The version or the zwp_linux_dmabuf_v1 interface to use
+     * @param parent The parent for DmaBufPool
+     *
+     * @returns The created DmaBufPool.
+     **/
+    DmaBufPool *createDmaBufPool(quint32 name, quint32 version, QObject *parent = nullptr);
+    /**
+     * Creates a LinuxDrmSyncObjManager and sets it up to manage the interface identified by
+     * @p name and @p version.
+     *
+     * Note: in case @p name is invalid or isn't for the wp_linux_drm_syncobj_manager_v1 interface,
+     * the returned LinuxDrmSyncObjManager will not be valid. Therefore it's recommended to call
+     * isValid on the created instance.
+     *
+     * @param name The name of the wp_linux_drm_syncobj_manager_v1 interface to bind
+     * @param version The version or the wp_linux_drm_syncobj_manager_v1 interface to use
+     * @param parent The parent for LinuxDrmSyncObjManager
+     *
+     * @returns The created LinuxDrmSyncObjManager.
+     **/
+    LinuxDrmSyncObjManager *createLinuxDrmSyncObjManager(quint32 name, quint32 version, QObject *parent = nullptr);
+    /**
+     * Creates a ScreencastV1 and sets it up to manage the interface identified by
+     * @p name and @p version.
+     *
+     * Note: in case @p name is invalid or isn't for the zkde_screencast_unstable_v1 interface,
+     * the returned ScreencastV1 will not be valid. Therefore it's recommended to call
+     * isValid on the created instance.
+     *
+     * @param name The name of the zkde_screencast_unstable_v1 interface to bind
+     * @param version The version or the zkde_screencast_unstable_v1 interface to use
+     * @param parent The parent for ScreencastV1
+     *
+     * @returns The created ScreencastV1.
+     **/
+    ScreencastV1 *createScreencastV1(quint32 name, quint32 version, QObject *parent = nullptr);
     ///@}
 
     /**
@@ -1819,6 +2005,36 @@ Q_SIGNALS:
      * @since 5.54
      **/
     void dataControlDeviceManagerAnnounced(quint32 name, quint32 version);
+    /**
+     * Emitted whenever a wp_presentation interface gets announced.
+     * @param name The name for the announced interface
+     * @param version The maximum supported version of the announced interface
+     **/
+    void presentationTimeAnnounced(quint32 name, quint32 version);
+    /**
+     * Emitted whenever a wp_cursor_shape_manager_v1 interface gets announced.
+     * @param name The name for the announced interface
+     * @param version The maximum supported version of the announced interface
+     **/
+    void cursorShapeManagerV1Announced(quint32 name, quint32 version);
+    /**
+     * Emitted whenever a zwp_linux_dmabuf_v1 interface gets announced.
+     * @param name The name for the announced interface
+     * @param version The maximum supported version of the announced interface
+     **/
+    void linuxDmabufV1Announced(quint32 name, quint32 version);
+    /**
+     * Emitted whenever a zkde_screencast_unstable_v1 interface gets announced.
+     * @param name The name for the announced interface
+     * @param version The maximum supported version of the announced interface
+     **/
+    void screencastV1Announced(quint32 name, quint32 version);
+    /**
+     * Emitted whenever a wp_linux_drm_syncobj_manager_v1 interface gets announced.
+     * @param name The name for the announced interface
+     * @param version The maximum supported version of the announced interface
+     **/
+    void linuxDrmSyncObjV1Announced(quint32 name, quint32 version);
     ///@}
 
     /**
@@ -2099,6 +2315,31 @@ Q_SIGNALS:
      * @since 5.54
      **/
     void dataControlDeviceManagerRemoved(quint32 name);
+    /**
+     * Emitted whenever a wp_presentation interface gets removed.
+     * @param name The name of the removed interface
+     **/
+    void presentationTimeRemoved(quint32 name);
+    /**
+     * Emitted whenever a wp_cursor_shape_manager_v1 interface gets removed.
+     * @param name The name of the removed interface
+     **/
+    void cursorShapeManagerV1Removed(quint32 name);
+    /**
+     * Emitted whenever a zwp_linux_dmabuf_v1 interface gets removed.
+     * @param name The name of the removed interface
+     **/
+    void linuxDmabufV1Removed(quint32 name);
+    /**
+     * Emitted whenever a zkde_screencast_unstable_v1 interface gets removed.
+     * @param name The name of the removed interface
+     **/
+    void screencastV1Removed(quint32 name);
+    /**
+     * Emitted whenever a wp_linux_drm_syncobj_manager_v1 interface gets removed.
+     * @param name The name of the removed interface
+     **/
+    void linuxDrmSyncObjV1Removed(quint32 name);
     ///@}
     /**
      * Generic announced signal which gets emitted whenever an interface gets
@@ -2131,6 +2372,14 @@ Q_SIGNALS:
      * This signal is emitted from the wl_display_sync callback.
      **/
     void interfacesAnnounced();
+    /**
+     * Emitted once all interfaces requested through requestInterface which got announced
+     * are created and the events they initially receive are dispatched, e.g. the capabilities
+     * of a Seat or the modes of an Output. If no interface got requested, it's emitted right
+     * after interfacesAnnounced.
+     * @see requestInterface
+     **/
+    void requestedInterfacesReady();
 
 Q_SIGNALS:
     /*
@@ -2143,6 +2392,20 @@ private:
     QScopedPointer<Private> d;
 };
 
+template<typename Functor>
+inline void Registry::whenRequestedInterfacesReady(const QObject *context, Functor functor)
+{
+    if (requestedInterfacesAreReady()) {
+        functor();
+        return;
+    }
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(this, &Registry::requestedInterfacesReady, context, [connection, functor]() mutable {
+        QObject::disconnect(*connection);
+        functor();
+    });
+}
+
 }
 }
 
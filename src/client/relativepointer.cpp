@@ -10,6 +10,8 @@
 #include <QSizeF>
 #include <wayland-relativepointer-unstable-v1-client-protocol.h>
 
+#include <utility>
+
 namespace KWayland
 {
 namespace Client
@@ -109,6 +111,9 @@ private:
 
     RelativePointer *q;
 
+    bool accumulating = false;
+    RelativePointer::AccumulatedMotion accumulated;
+
     static const zwp_relative_pointer_v1_listener s_listener;
 };
 
@@ -133,6 +138,14 @@ void RelativePointer::Private::relativeMotionCallback(void *data,
     const QSizeF delta(wl_fixed_to_double(dx), wl_fixed_to_double(dy));
     const QSizeF deltaNonAccel(wl_fixed_to_double(dx_unaccel), wl_fixed_to_double(dy_unaccel));
     const quint64 timestamp = quint64(utime_lo) | (quint64(utime_hi) << 32);
+    if (p->accumulating) {
+        // multiples of 1/256 are summed up exactly by doubles
+        p->accumulated.delta += delta;
+        p->accumulated.deltaNonAccelerated += deltaNonAccel;
+        p->accumulated.timestamp = timestamp;
+        ++p->accumulated.eventCount;
+        return;
+    }
     Q_EMIT p->q->relativeMotion(delta, deltaNonAccel, timestamp);
 }
 
@@ -185,5 +198,20 @@ bool RelativePointer::isValid() const
     return d->relativepointerunstablev1.isValid();
 }
 
+void RelativePointer::setAccumulating(bool accumulate)
+{
+    d->accumulating = accumulate;
+}
+
+bool RelativePointer::isAccumulating() const
+{
+    return d->accumulating;
+}
+
+RelativePointer::AccumulatedMotion RelativePointer::takeAccumulatedMotion()
+{
+    return std::exchange(d->accumulated, AccumulatedMotion());
+}
+
 }
 }
@@ -7,6 +7,7 @@
 #define KWAYLAND_CLIENT_RELATIVEPOINTER_H
 
 #include <QObject>
+#include <QSizeF>
 
 #include <DWayland/Client/kwaylandclient_export.h>
 
@@ -136,6 +137,21 @@ class KWAYLANDCLIENT_EXPORT RelativePointer : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * The relative motion accumulated since the last takeAccumulatedMotion.
+     * @see setAccumulating
+     **/
+    struct AccumulatedMotion {
+        /// sum of the motion vectors
+        QSizeF delta;
+        /// sum of the non-accelerated motion vectors
+        QSizeF deltaNonAccelerated;
+        /// timestamp of the last accumulated event with microseconds granularity
+        quint64 timestamp = 0;
+        /// number of accumulated events, @c 0 if there was no motion
+        int eventCount = 0;
+    };
+
     ~RelativePointer() override;
 
     /**
@@ -173,6 +189,32 @@ public:
     operator zwp_relative_pointer_v1 *();
     operator zwp_relative_pointer_v1 *() const;
 
+    /**
+     * Enables or disables the accumulation of relative motion.
+     *
+     * If enabled, relativeMotion is no longer emitted. The deltas of the received events
+     * are summed up instead and can be read with takeAccumulatedMotion, e.g. once per
+     * rendered frame. This avoids a signal emission per event for high frequency devices.
+     * The sums are exact, no fraction of the received deltas gets lost.
+     *
+     * Disabling the accumulation keeps the motion accumulated so far until it is taken.
+     *
+     * Accumulation is disabled by default.
+     *
+     * @see takeAccumulatedMotion
+     **/
+    void setAccumulating(bool accumulate);
+    /**
+     * @returns whether relative motion is accumulated
+     * @see setAccumulating
+     **/
+    bool isAccumulating() const;
+    /**
+     * @returns the relative motion accumulated since the last call and resets it
+     * @see setAccumulating
+     **/
+    AccumulatedMotion takeAccumulatedMotion();
+
 Q_SIGNALS:
     /**
      * A relative motion event.
@@ -204,6 +246,7 @@ Q_SIGNALS:
      * @param delta Motion vector
      * @param deltaNonAccelerated non-accelerated motion vector
      * @param microseconds timestamp with microseconds granularity
+     * @see setAccumulating
      **/
     void relativeMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, quint64 timestamp);
 
@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "screencast.h"
+#include "dmabuf_feedback.h"
+#include "event_queue.h"
+#include "output.h"
+#include "wayland_pointer_p.h"
+
+#include <algorithm>
+
+#include <wayland-zkde-screencast-unstable-v1-client-protocol.h>
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN ScreencastV1::Private
+{
+public:
+    ScreencastStreamV1 *setupStream(zkde_screencast_stream_unstable_v1 *s, QObject *parent);
+
+    WaylandPointer<zkde_screencast_unstable_v1, zkde_screencast_unstable_v1_destroy> screencast;
+    EventQueue *queue = nullptr;
+};
+
+ScreencastStreamV1 *ScreencastV1::Private::setupStream(zkde_screencast_stream_unstable_v1 *s, QObject *parent)
+{
+    if (queue) {
+        queue->addProxy(s);
+    }
+    auto stream = new ScreencastStreamV1(parent);
+    stream->setup(s);
+    return stream;
+}
+
+ScreencastV1::ScreencastV1(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+ScreencastV1::~ScreencastV1()
+{
+    release();
+}
+
+void ScreencastV1::setup(zkde_screencast_unstable_v1 *screencast)
+{
+    Q_ASSERT(screencast);
+    Q_ASSERT(!d->screencast);
+    d->screencast.setup(screencast);
+}
+
+void ScreencastV1::release()
+{
+    d->screencast.release();
+}
+
+void ScreencastV1::destroy()
+{
+    d->screencast.destroy();
+}
+
+ScreencastV1::operator zkde_screencast_unstable_v1 *()
+{
+    return d->screencast;
+}
+
+ScreencastV1::operator zkde_screencast_unstable_v1 *() const
+{
+    return d->screencast;
+}
+
+bool ScreencastV1::isValid() const
+{
+    return d->screencast.isValid();
+}
+
+void ScreencastV1::setEventQueue(EventQueue *queue)
+{
+    d->queue = queue;
+}
+
+EventQueue *ScreencastV1::eventQueue()
+{
+    return d->queue;
+}
+
+ScreencastStreamV1 *ScreencastV1::streamOutput(Output *output, CursorMode mode, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    return d->setupStream(zkde_screencast_unstable_v1_stream_output(d->screencast, *output, uint32_t(mode)), parent);
+}
+
+ScreencastStreamV1 *ScreencastV1::streamWindow(const QByteArray &uuid, CursorMode mode, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    return d->setupStream(zkde_screencast_unstable_v1_stream_window(d->screencast, uuid.constData(), uint32_t(mode)), parent);
+}
+
+ScreencastStreamV1 *ScreencastV1::streamVirtualOutput(const QString &name, const QSize &size, qreal scale, CursorMode mode, QObject *parent)
+{
+    Q_ASSERT(isValid());
+    Q_ASSERT(zkde_screencast_unstable_v1_get_version(d->screencast) >= ZKDE_SCREENCAST_UNSTABLE_V1_STREAM_VIRTUAL_OUTPUT_SINCE_VERSION);
+    return d->setupStream(zkde_screencast_unstable_v1_stream_virtual_output(d->screencast,
+                                                                            name.toUtf8().constData(),
+                                                                            size.width(),
+                                                                            size.height(),
+                                                                            wl_fixed_from_double(scale),
+                                                                            uint32_t(mode)),
+                          parent);
+}
+
+QVector<ScreencastV1::DmaBufFormat> ScreencastV1::dmaBufFormats(const DmaBufFeedback &feedback)
+{
+    QVector<DmaBufFormat> formats;
+    const QVector<DmaBufFeedback::Tranche> tranches = feedback.tranches();
+    for (const DmaBufFeedback::Tranche &tranche : tranches) {
+        if (tranche.device != feedback.mainDevice()) {
+            continue;
+        }
+        const QHash<uint32_t, QVector<uint64_t>> trancheFormats = feedback.formats(tranche);
+        // the formats of a tranche are equally preferred, sorted they come out the same every time
+        QVector<uint32_t> codes = trancheFormats.keys().toVector();
+        std::sort(codes.begin(), codes.end());
+        for (uint32_t code : qAsConst(codes)) {
+            auto it = std::find_if(formats.begin(), formats.end(), [code](const DmaBufFormat &format) {
+                return format.format == code;
+            });
+            if (it == formats.end()) {
+                formats.append(DmaBufFormat{code, {}});
+                it = formats.end() - 1;
+            }
+            for (uint64_t modifier : trancheFormats.value(code)) {
+                if (!it->modifiers.contains(modifier)) {
+                    it->modifiers.append(modifier);
+                }
+            }
+        }
+    }
+    return formats;
+}
+
+class Q_DECL_HIDDEN ScreencastStreamV1::Private
+{
+public:
+    Private(ScreencastStreamV1 *q);
+
+    WaylandPointer<zkde_screencast_stream_unstable_v1, zkde_screencast_stream_unstable_v1_close> stream;
+    quint32 nodeId = 0;
+
+    static void closedCallback(void *data, zkde_screencast_stream_unstable_v1 *stream);
+    static void createdCallback(void *data, zkde_screencast_stream_unstable_v1 *stream, uint32_t node);
+    static void failedCallback(void *data, zkde_screencast_stream_unstable_v1 *stream, const char *error);
+
+    static const struct zkde_screencast_stream_unstable_v1_listener s_listener;
+
+    ScreencastStreamV1 *q;
+};
+
+const struct zkde_screencast_stream_unstable_v1_listener ScreencastStreamV1::Private::s_listener = {
+    closedCallback,
+    createdCallback,
+    failedCallback,
+};
+
+ScreencastStreamV1::Private::Private(ScreencastStreamV1 *q)
+    : q(q)
+{
+}
+
+void ScreencastStreamV1::Private::closedCallback(void *data, zkde_screencast_stream_unstable_v1 *stream)
+{
+    auto p = reinterpret_cast<ScreencastStreamV1::Private *>(data);
+    Q_ASSERT(p->stream == stream);
+    Q_EMIT p->q->closed();
+}
+
+void ScreencastStreamV1::Private::createdCallback(void *data, zkde_screencast_stream_unstable_v1 *stream, uint32_t node)
+{
+    auto p = reinterpret_cast<ScreencastStreamV1::Private *>(data);
+    Q_ASSERT(p->stream == stream);
+    p->nodeId = node;
+    Q_EMIT p->q->created(node);
+}
+
+void ScreencastStreamV1::Private::failedCallback(void *data, zkde_screencast_stream_unstable_v1 *stream, const char *error)
+{
+    auto p = reinterpret_cast<ScreencastStreamV1::Private *>(data);
+    Q_ASSERT(p->stream == stream);
+    Q_EMIT p->q->failed(QString::fromUtf8(error));
+}
+
+ScreencastStreamV1::ScreencastStreamV1(QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+}
+
+ScreencastStreamV1::~ScreencastStreamV1()
+{
+    release();
+}
+
+void ScreencastStreamV1::setup(zkde_screencast_stream_unstable_v1 *stream)
+{
+    Q_ASSERT(stream);
+    Q_ASSERT(!d->stream);
+    d->stream.setup(stream);
+    zkde_screencast_stream_unstable_v1_add_listener(d->stream, &Private::s_listener, d.data());
+}
+
+void ScreencastStreamV1::release()
+{
+    d->stream.release();
+}
+
+void ScreencastStreamV1::destroy()
+{
+    d->stream.destroy();
+}
+
+bool ScreencastStreamV1::isValid() const
+{
+    return d->stream.isValid();
+}
+
+quint32 ScreencastStreamV1::nodeId() const
+{
+    return d->nodeId;
+}
+
+ScreencastStreamV1::operator zkde_screencast_stream_unstable_v1 *()
+{
+    return d->stream;
+}
+
+ScreencastStreamV1::operator zkde_screencast_stream_unstable_v1 *() const
+{
+    return d->stream;
+}
+
+}
+}
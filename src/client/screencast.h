@@ -0,0 +1,209 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_SCREENCAST_H
+#define WAYLAND_SCREENCAST_H
+
+#include <QObject>
+#include <QSize>
+#include <QVector>
+
+#include <DWayland/Client/kwaylandclient_export.h>
+
+struct zkde_screencast_unstable_v1;
+struct zkde_screencast_stream_unstable_v1;
+
+namespace KWayland
+{
+namespace Client
+{
+class DmaBufFeedback;
+class EventQueue;
+class Output;
+class ScreencastStreamV1;
+
+/**
+ * @short Wrapper for the zkde_screencast_unstable_v1 interface.
+ *
+ * The ScreencastV1 asks the compositor to stream an output, a window or a virtual output
+ * into a PipeWire stream. Once the compositor created the stream, the ScreencastStreamV1
+ * provides the id of the PipeWire node to connect to.
+ *
+ * To use this class one needs to interact with the Registry:
+ * @code
+ * ScreencastV1 *s = registry->createScreencastV1(name, version);
+ * @endcode
+ *
+ * @see Registry
+ **/
+class KWAYLANDCLIENT_EXPORT ScreencastV1 : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * How the cursor is streamed.
+     **/
+    enum class CursorMode {
+        Hidden = 1, ///< the cursor is not part of the stream
+        Embedded = 2, ///< the cursor is rendered into the frames
+        Metadata = 4, ///< the cursor is sent as metadata of the frames
+    };
+    Q_ENUM(CursorMode)
+
+    /**
+     * A dmabuf format and the modifiers the compositor can render it with.
+     **/
+    struct DmaBufFormat {
+        uint32_t format = 0;
+        QVector<uint64_t> modifiers;
+    };
+
+    /**
+     * Creates a new ScreencastV1.
+     * Note: after constructing the ScreencastV1 it is not yet valid and one needs
+     * to call setup. In order to get a ready to use ScreencastV1 prefer using
+     * Registry::createScreencastV1.
+     **/
+    explicit ScreencastV1(QObject *parent = nullptr);
+    ~ScreencastV1() override;
+
+    /**
+     * Setup this ScreencastV1 to manage the @p screencast.
+     * When using Registry::createScreencastV1 there is no need to call this
+     * method.
+     **/
+    void setup(zkde_screencast_unstable_v1 *screencast);
+    /**
+     * @returns @c true if managing a zkde_screencast_unstable_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Releases the zkde_screencast_unstable_v1 interface.
+     * After the interface has been released the ScreencastV1 instance is no
+     * longer valid and can be setup with another zkde_screencast_unstable_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this ScreencastV1.
+     * This method is supposed to be used when the connection to the Wayland
+     * server goes away. Once the connection becomes invalid, it's not
+     * possible to call release anymore as that calls into the Wayland
+     * connection and the call would fail.
+     **/
+    void destroy();
+
+    /**
+     * Sets the @p queue to use for creating objects with this ScreencastV1.
+     **/
+    void setEventQueue(EventQueue *queue);
+    /**
+     * @returns The event queue to use for creating objects with this ScreencastV1.
+     **/
+    EventQueue *eventQueue();
+
+    /**
+     * Streams the contents of the @p output.
+     **/
+    ScreencastStreamV1 *streamOutput(Output *output, CursorMode mode, QObject *parent = nullptr);
+    /**
+     * Streams the contents of the window with the @p uuid, see PlasmaWindow::uuid.
+     **/
+    ScreencastStreamV1 *streamWindow(const QByteArray &uuid, CursorMode mode, QObject *parent = nullptr);
+    /**
+     * Streams a virtual output called @p name of @p size and @p scale, which the compositor
+     * creates for the stream. Requires version 2 of the interface.
+     **/
+    ScreencastStreamV1 *streamVirtualOutput(const QString &name, const QSize &size, qreal scale, CursorMode mode, QObject *parent = nullptr);
+
+    /**
+     * Returns the dmabuf formats and modifiers of the main device of the @p feedback in the
+     * order of the compositor's preference, e.g. to offer them when negotiating the buffers of
+     * the PipeWire stream. With buffers the compositor can render to directly, the frames stay
+     * on the GPU from the compositor to the encoder.
+     *
+     * The formats of tranches targeting other devices are left out, modifiers listed in
+     * several tranches are only listed once.
+     **/
+    static QVector<DmaBufFormat> dmaBufFormats(const DmaBufFeedback &feedback);
+
+    operator zkde_screencast_unstable_v1 *();
+    operator zkde_screencast_unstable_v1 *() const;
+
+Q_SIGNALS:
+    /**
+     * The corresponding global for this interface on the Registry got removed.
+     *
+     * This signal gets only emitted if the ScreencastV1 got created by
+     * Registry::createScreencastV1
+     **/
+    void removed();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+/**
+ * @short Wrapper for the zkde_screencast_stream_unstable_v1 interface.
+ *
+ * @see ScreencastV1
+ **/
+class KWAYLANDCLIENT_EXPORT ScreencastStreamV1 : public QObject
+{
+    Q_OBJECT
+public:
+    ~ScreencastStreamV1() override;
+
+    /**
+     * Setup this ScreencastStreamV1 to manage the @p stream.
+     * When using one of the stream methods of ScreencastV1 there is no need to call this
+     * method.
+     **/
+    void setup(zkde_screencast_stream_unstable_v1 *stream);
+    /**
+     * @returns @c true if managing a zkde_screencast_stream_unstable_v1.
+     **/
+    bool isValid() const;
+    /**
+     * Closes the stream and releases the zkde_screencast_stream_unstable_v1 interface.
+     **/
+    void release();
+    /**
+     * Destroys the data held by this ScreencastStreamV1.
+     **/
+    void destroy();
+
+    /**
+     * @returns the id of the PipeWire node of the stream, @c 0 until created is emitted
+     **/
+    quint32 nodeId() const;
+
+    operator zkde_screencast_stream_unstable_v1 *();
+    operator zkde_screencast_stream_unstable_v1 *() const;
+
+Q_SIGNALS:
+    /**
+     * The compositor created the PipeWire stream with the node @p nodeId.
+     **/
+    void created(quint32 nodeId);
+    /**
+     * The compositor could not create the stream because of @p error.
+     **/
+    void failed(const QString &error);
+    /**
+     * The compositor closed the stream, e.g. because the streamed window was closed.
+     **/
+    void closed();
+
+private:
+    friend class ScreencastV1;
+    explicit ScreencastStreamV1(QObject *parent = nullptr);
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include "seat.h"
 #include "surface.h"
 #include "wayland_pointer_p.h"
+#include "wrapperindex_p.h"
 // Qt
 #include <QGuiApplication>
 #include <QVector>
@@ -116,7 +117,7 @@ public:
 
     WaylandPointer<wl_shell_surface, wl_shell_surface_destroy> surface;
     QSize size;
-    static QVector<ShellSurface *> s_surfaces;
+    static WrapperIndex<wl_shell_surface *, ShellSurface> s_index;
 
 private:
     void ping(uint32_t serial);
@@ -128,7 +129,7 @@ private:
     static const struct wl_shell_surface_listener s_listener;
 };
 
-QVector<ShellSurface *> ShellSurface::Private::s_surfaces = QVector<ShellSurface *>();
+WrapperIndex<wl_shell_surface *, ShellSurface> ShellSurface::Private::s_index;
 
 ShellSurface::Private::Private(ShellSurface *q)
     : q(q)
@@ -140,6 +141,7 @@ void ShellSurface::Private::setup(wl_shell_surface *s)
     Q_ASSERT(s);
     Q_ASSERT(!surface);
     surface.setup(s);
+    s_index.insert(s, q);
     wl_shell_surface_add_listener(surface, &s_listener, this);
 }
 
@@ -162,6 +164,7 @@ ShellSurface *ShellSurface::fromWindow(QWindow *window)
     }
     ShellSurface *surface = new ShellSurface(window);
     surface->d->surface.setup(s, true);
+    Private::s_index.insert(s, surface);
     return surface;
 }
 
@@ -184,35 +187,30 @@ ShellSurface *ShellSurface::fromQtWinId(WId wid)
 
 ShellSurface *ShellSurface::get(wl_shell_surface *native)
 {
-    auto it = std::find_if(Private::s_surfaces.constBegin(), Private::s_surfaces.constEnd(), [native](ShellSurface *s) {
-        return s->d->surface == native;
-    });
-    if (it != Private::s_surfaces.constEnd()) {
-        return *(it);
-    }
-    return nullptr;
+    return Private::s_index.value(native);
 }
 
 ShellSurface::ShellSurface(QObject *parent)
     : QObject(parent)
     , d(new Private(this))
 {
-    Private::s_surfaces << this;
 }
 
 ShellSurface::~ShellSurface()
 {
-    Private::s_surfaces.removeOne(this);
+    Private::s_index.remove(this);
     release();
 }
 
 void ShellSurface::release()
 {
+    Private::s_index.remove(this);
     d->surface.release();
 }
 
 void ShellSurface::destroy()
 {
+    Private::s_index.remove(this);
     d->surface.destroy();
 }
 
@@ -11,10 +11,15 @@
 // Qt
 #include <QDebug>
 #include <QImage>
+#include <QPainter>
 #include <QTemporaryFile>
 // system
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
+// std
+#include <algorithm>
+#include <map>
 // wayland
 #include <wayland-client-protocol.h>
 
@@ -22,21 +27,146 @@ namespace KWayland
 {
 namespace Client
 {
+namespace
+{
+// Offsets and lengths of the sub allocations are aligned to a cache line.
+static const int32_t s_alignment = 64;
+
+static int32_t alignedLength(int32_t length)
+{
+    return (length + s_alignment - 1) & ~(s_alignment - 1);
+}
+
+/**
+ * Keeps track of the unused regions of the pool. Free regions are indexed both by offset,
+ * so that adjacent regions can be coalesced, and by length, so that the best fitting region
+ * can be found without scanning.
+ */
+class ShmPoolAllocator
+{
+public:
+    explicit ShmPoolAllocator(int32_t size)
+    {
+        insert(0, size);
+    }
+
+    int32_t allocate(int32_t length)
+    {
+        auto it = m_regionsByLength.lower_bound(length);
+        if (it == m_regionsByLength.end()) {
+            return -1;
+        }
+        const int32_t regionLength = it->first;
+        const int32_t offset = it->second;
+        m_regionsByLength.erase(it);
+        m_regions.erase(offset);
+        if (regionLength > length) {
+            insert(offset + length, regionLength - length);
+        }
+        return offset;
+    }
+
+    void free(int32_t offset, int32_t length)
+    {
+        auto next = m_regions.lower_bound(offset);
+        if (next != m_regions.end() && next->first == offset + length) {
+            length += next->second;
+            next = remove(next);
+        }
+        if (next != m_regions.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                offset = previous->first;
+                length += previous->second;
+                remove(previous);
+            }
+        }
+        insert(offset, length);
+    }
+
+    /**
+     * Returns the length of the free region that ends at @p size, i.e. at the end of the pool.
+     */
+    int32_t tailLength(int32_t size) const
+    {
+        if (m_regions.empty()) {
+            return 0;
+        }
+        const auto last = std::prev(m_regions.end());
+        return last->first + last->second == size ? last->second : 0;
+    }
+
+    const std::map<int32_t, int32_t> &regions() const
+    {
+        return m_regions;
+    }
+
+private:
+    void insert(int32_t offset, int32_t length)
+    {
+        m_regions.emplace(offset, length);
+        m_regionsByLength.emplace(length, offset);
+    }
+
+    std::map<int32_t, int32_t>::iterator remove(std::map<int32_t, int32_t>::iterator it)
+    {
+        auto range = m_regionsByLength.equal_range(it->second);
+        for (auto byLength = range.first; byLength != range.second; ++byLength) {
+            if (byLength->second == it->first) {
+                m_regionsByLength.erase(byLength);
+                break;
+            }
+        }
+        return m_regions.erase(it);
+    }
+
+    // offset -> length
+    std::map<int32_t, int32_t> m_regions;
+    // length -> offset
+    std::multimap<int32_t, int32_t> m_regionsByLength;
+};
+
+struct BufferShape {
+    QSize size;
+    int32_t stride;
+    Buffer::Format format;
+};
+
+bool operator==(const BufferShape &a, const BufferShape &b)
+{
+    return a.size == b.size && a.stride == b.stride && a.format == b.format;
+}
+
+uint qHash(const BufferShape &shape, uint seed = 0)
+{
+    return qHash(qMakePair(qMakePair(shape.size.width(), shape.size.height()), qMakePair(shape.stride, int(shape.format))), seed);
+}
+}
+
 class Q_DECL_HIDDEN ShmPool::Private
 {
 public:
     Private(ShmPool *q);
     bool createPool();
+    bool openFile();
+    void closeFile();
     bool resizePool(int32_t newSize);
-    QList<QSharedPointer<Buffer>>::iterator getBuffer(const QSize &size, int32_t stride, Buffer::Format format);
+    QSharedPointer<Buffer> getBuffer(const QSize &size, int32_t stride, Buffer::Format format);
+    int32_t allocate(int32_t length);
+    void reclaimIdleBuffers();
+    void reset();
     WaylandPointer<wl_shm, wl_shm_destroy> shm;
     WaylandPointer<wl_shm_pool, wl_shm_pool_destroy> pool;
     void *poolData = nullptr;
     int32_t size = 1024;
+    // The pool is backed by a memfd if possible, otherwise by an unlinked temporary file.
+    int fd = -1;
     QScopedPointer<QTemporaryFile> tmpFile;
     bool valid = false;
-    int offset = 0;
-    QList<QSharedPointer<Buffer>> buffers;
+    // Buffers hand their memory back to the allocator once the last reference to them is
+    // gone, which might be after the pool has been released. Hence the weak references.
+    QSharedPointer<ShmPoolAllocator> allocator;
+    QHash<BufferShape, QList<QSharedPointer<Buffer>>> buffers;
     EventQueue *queue = nullptr;
 
 private:
@@ -49,6 +179,16 @@ ShmPool::Private::Private(ShmPool *q)
 {
 }
 
+void ShmPool::Private::reset()
+{
+    buffers.clear();
+    allocator.reset();
+    if (poolData) {
+        munmap(poolData, size);
+        poolData = nullptr;
+    }
+}
+
 ShmPool::ShmPool(QObject *parent)
     : QObject(parent)
     , d(new Private(this))
@@ -62,33 +202,25 @@ ShmPool::~ShmPool()
 
 void ShmPool::release()
 {
-    d->buffers.clear();
-    if (d->poolData) {
-        munmap(d->poolData, d->size);
-        d->poolData = nullptr;
-    }
+    d->reset();
     d->pool.release();
     d->shm.release();
-    d->tmpFile->close();
+    d->closeFile();
     d->valid = false;
-    d->offset = 0;
 }
 
 void ShmPool::destroy()
 {
-    for (auto b : d->buffers) {
-        b->d->destroy();
-    }
-    d->buffers.clear();
-    if (d->poolData) {
-        munmap(d->poolData, d->size);
-        d->poolData = nullptr;
+    for (const auto &shapeBuffers : qAsConst(d->buffers)) {
+        for (const auto &b : shapeBuffers) {
+            b->d->destroy();
+        }
     }
+    d->reset();
     d->pool.destroy();
     d->shm.destroy();
-    d->tmpFile->close();
+    d->closeFile();
     d->valid = false;
-    d->offset = 0;
 }
 
 void ShmPool::setup(wl_shm *shm)
@@ -109,8 +241,17 @@ EventQueue *ShmPool::eventQueue()
     return d->queue;
 }
 
-bool ShmPool::Private::createPool()
+bool ShmPool::Private::openFile()
 {
+#if defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+    fd = memfd_create("kwayland-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd != -1) {
+        // The pool only ever grows, sealing it against shrinking guarantees the server
+        // that the memory it mapped stays valid.
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL);
+        return true;
+    }
+#endif
     if (!tmpFile->open()) {
         qCDebug(KWAYLAND_CLIENT) << "Could not open temporary file for Shm pool";
         return false;
@@ -118,34 +259,62 @@ bool ShmPool::Private::createPool()
     if (unlink(tmpFile->fileName().toUtf8().constData()) != 0) {
         qCDebug(KWAYLAND_CLIENT) << "Unlinking temporary file for Shm pool from file system failed";
     }
-    if (ftruncate(tmpFile->handle(), size) < 0) {
+    fd = tmpFile->handle();
+    return true;
+}
+
+void ShmPool::Private::closeFile()
+{
+    if (tmpFile->isOpen()) {
+        tmpFile->close();
+    } else if (fd != -1) {
+        close(fd);
+    }
+    fd = -1;
+}
+
+bool ShmPool::Private::createPool()
+{
+    if (!openFile()) {
+        return false;
+    }
+    if (ftruncate(fd, size) < 0) {
         qCDebug(KWAYLAND_CLIENT) << "Could not set size for Shm pool file";
         return false;
     }
-    poolData = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, tmpFile->handle(), 0);
-    pool.setup(wl_shm_create_pool(shm, tmpFile->handle(), size));
+    poolData = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    pool.setup(wl_shm_create_pool(shm, fd, size));
 
     if (poolData == MAP_FAILED || !pool) {
         qCDebug(KWAYLAND_CLIENT) << "Creating Shm pool failed";
+        if (poolData == MAP_FAILED) {
+            poolData = nullptr;
+        }
         return false;
     }
+    allocator.reset(new ShmPoolAllocator(size));
     return true;
 }
 
 bool ShmPool::Private::resizePool(int32_t newSize)
 {
-    if (ftruncate(tmpFile->handle(), newSize) < 0) {
+    if (ftruncate(fd, newSize) < 0) {
         qCDebug(KWAYLAND_CLIENT) << "Could not set new size for Shm pool file";
         return false;
     }
-    wl_shm_pool_resize(pool, newSize);
+#ifdef MREMAP_MAYMOVE
+    void *data = mremap(poolData, size, newSize, MREMAP_MAYMOVE);
+#else
     munmap(poolData, size);
-    poolData = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, tmpFile->handle(), 0);
-    size = newSize;
-    if (poolData == MAP_FAILED) {
+    void *data = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+    if (data == MAP_FAILED) {
         qCDebug(KWAYLAND_CLIENT) << "Resizing Shm pool failed";
         return false;
     }
+    wl_shm_pool_resize(pool, newSize);
+    poolData = data;
+    size = newSize;
     Q_EMIT q->poolResized();
     return true;
 }
@@ -175,17 +344,24 @@ Buffer::Ptr ShmPool::createBuffer(const QImage &image)
         return QWeakPointer<Buffer>();
     }
     auto format = toBufferFormat(image);
-    auto it = d->getBuffer(image.size(), image.bytesPerLine(), format);
-    if (it == d->buffers.end()) {
+    const bool needsConversion = image.format() != QImage::Format_ARGB32_Premultiplied && image.format() != QImage::Format_RGB32;
+    // a converted image is tightly packed 32-bit, the stride of the source doesn't apply
+    const int32_t stride = needsConversion ? image.width() * 4 : image.bytesPerLine();
+    auto buffer = d->getBuffer(image.size(), stride, format);
+    if (!buffer) {
         return QWeakPointer<Buffer>();
     }
-    if (format == Buffer::Format::ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
-        auto imageCopy = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        (*it)->copy(imageCopy.bits());
+    if (needsConversion) {
+        // convert straight into the shared memory instead of going through a temporary image,
+        // the raster engine uses its SIMD optimized conversion routines for this blit
+        QImage target = buffer->image();
+        QPainter painter(&target);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(0, 0, image);
     } else {
-        (*it)->copy(image.bits());
+        buffer->copy(image.bits());
     }
-    return QWeakPointer<Buffer>(*it);
+    return buffer;
 }
 
 Buffer::Ptr ShmPool::createBuffer(const QSize &size, int32_t stride, const void *src, Buffer::Format format)
@@ -193,12 +369,12 @@ Buffer::Ptr ShmPool::createBuffer(const QSize &size, int32_t stride, const void
     if (size.isEmpty() || !d->valid) {
         return QWeakPointer<Buffer>();
     }
-    auto it = d->getBuffer(size, stride, format);
-    if (it == d->buffers.end()) {
+    auto buffer = d->getBuffer(size, stride, format);
+    if (!buffer) {
         return QWeakPointer<Buffer>();
     }
-    (*it)->copy(src);
-    return QWeakPointer<Buffer>(*it);
+    buffer->copy(src);
+    return buffer;
 }
 
 namespace
@@ -217,44 +393,115 @@ static wl_shm_format toWaylandFormat(Buffer::Format format)
 
 Buffer::Ptr ShmPool::getBuffer(const QSize &size, int32_t stride, Buffer::Format format)
 {
-    auto it = d->getBuffer(size, stride, format);
-    if (it == d->buffers.end()) {
-        return QWeakPointer<Buffer>();
+    return d->getBuffer(size, stride, format);
+}
+
+int32_t ShmPool::Private::allocate(int32_t length)
+{
+    int32_t offset = allocator->allocate(length);
+    if (offset != -1) {
+        return offset;
     }
-    return QWeakPointer<Buffer>(*it);
+
+    // Buffers of other sizes which are not in use anymore are dropped before the pool grows,
+    // that's what keeps the pool from growing when the client keeps resizing.
+    reclaimIdleBuffers();
+    offset = allocator->allocate(length);
+    if (offset != -1) {
+        return offset;
+    }
+
+    // Grow geometrically, so that a growing window doesn't remap the pool on every resize,
+    // neither on the client nor on the server side.
+    const int32_t oldSize = size;
+    const int32_t requiredSize = oldSize + length - allocator->tailLength(oldSize);
+    if (!resizePool(qMax(requiredSize, oldSize + oldSize / 2))) {
+        return -1;
+    }
+    allocator->free(oldSize, size - oldSize);
+    return allocator->allocate(length);
 }
 
-QList<QSharedPointer<Buffer>>::iterator ShmPool::Private::getBuffer(const QSize &s, int32_t stride, Buffer::Format format)
+void ShmPool::Private::reclaimIdleBuffers()
 {
-    for (auto it = buffers.begin(); it != buffers.end(); ++it) {
-        auto buffer = *it;
-        if (!buffer->isReleased() || buffer->isUsed()) {
-            continue;
-        }
-        if (buffer->size() != s || buffer->stride() != stride || buffer->format() != format) {
-            continue;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        QList<QSharedPointer<Buffer>> &shapeBuffers = *it;
+        shapeBuffers.erase(std::remove_if(shapeBuffers.begin(),
+                                          shapeBuffers.end(),
+                                          [](const QSharedPointer<Buffer> &buffer) {
+                                              return buffer->isReleased() && !buffer->isUsed();
+                                          }),
+                           shapeBuffers.end());
+        if (shapeBuffers.isEmpty()) {
+            it = buffers.erase(it);
+        } else {
+            ++it;
         }
-        buffer->setReleased(false);
-        return it;
     }
-    const int32_t byteCount = s.height() * stride;
-    if (offset + byteCount > size) {
-        if (!resizePool(size + byteCount)) {
-            return buffers.end();
+}
+
+QSharedPointer<Buffer> ShmPool::Private::getBuffer(const QSize &s, int32_t stride, Buffer::Format format)
+{
+    if (!allocator) {
+        return QSharedPointer<Buffer>();
+    }
+    const BufferShape shape{s, stride, format};
+    auto shapeIt = buffers.find(shape);
+    if (shapeIt != buffers.end()) {
+        for (const auto &buffer : qAsConst(*shapeIt)) {
+            if (buffer->isReleased() && !buffer->isUsed()) {
+                buffer->setReleased(false);
+                return buffer;
+            }
         }
     }
+
     // we don't have a buffer which we could reuse - need to create a new one
+    const int32_t length = alignedLength(s.height() * stride);
+    const int32_t offset = allocate(length);
+    if (offset == -1) {
+        return QSharedPointer<Buffer>();
+    }
     wl_buffer *native = wl_shm_pool_create_buffer(pool, offset, s.width(), s.height(), stride, toWaylandFormat(format));
     if (!native) {
-        return buffers.end();
+        allocator->free(offset, length);
+        return QSharedPointer<Buffer>();
     }
     if (queue) {
         queue->addProxy(native);
     }
-    Buffer *buffer = new Buffer(q, native, s, stride, offset, format);
-    offset += byteCount;
-    auto it = buffers.insert(buffers.end(), QSharedPointer<Buffer>(buffer));
-    return it;
+    const QWeakPointer<ShmPoolAllocator> bufferAllocator = allocator;
+    QSharedPointer<Buffer> buffer(new Buffer(q, native, s, stride, offset, format), [bufferAllocator, offset, length](Buffer *buffer) {
+        delete buffer;
+        if (auto allocator = bufferAllocator.toStrongRef()) {
+            allocator->free(offset, length);
+        }
+    });
+    buffers[shape].append(buffer);
+    return buffer;
+}
+
+void ShmPool::trim()
+{
+    if (!d->valid) {
+        return;
+    }
+    d->reclaimIdleBuffers();
+
+    // The pool can't shrink, but the memory of the unused regions can be given back.
+    const int32_t pageSize = sysconf(_SC_PAGESIZE);
+    for (const auto &region : d->allocator->regions()) {
+        const int32_t start = (region.first + pageSize - 1) / pageSize * pageSize;
+        const int32_t end = (region.first + region.second) / pageSize * pageSize;
+        if (end > start) {
+            fallocate(d->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, start, end - start);
+        }
+    }
+}
+
+int32_t ShmPool::poolSize() const
+{
+    return d->size;
 }
 
 bool ShmPool::isValid() const
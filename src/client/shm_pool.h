@@ -88,6 +88,18 @@ class EventQueue;
  * image.fill(Qt::black);
  * @endcode
  *
+ * Buffer::image provides such a QImage directly, which allows to paint into the shared memory
+ * without any copy:
+ * @code
+ * auto b = s->getBuffer(size, size.width() * 4).toStrongRef();
+ * b->setUsed(true);
+ * QImage image = b->image();
+ * QPainter p(&image);
+ * p.fillRect(image.rect(), Qt::red);
+ * p.end();
+ * b->setUsed(false);
+ * @endcode
+ *
  * A Buffer can be attached to a Surface:
  * @code
  * Compositor *c = registry.createCompositor(name, version);
@@ -105,6 +117,11 @@ class EventQueue;
  * buffer.toStrongRef()->setUsed(true);
  * @endcode
  *
+ * The memory of Buffers which are neither used nor held by the server anymore is reused for
+ * Buffers of other sizes before the pool grows, so the pool doesn't keep growing when e.g.
+ * a window gets resized. Such Buffers are destroyed once nothing references them anymore.
+ * Call trim() to destroy all of them and give their memory back to the system.
+ *
  * This is also important for the case that the shared memory pool needs to be resized.
  * The ShmPool will automatically resize if it cannot provide a new Buffer. During the resize
  * all existing Buffers are unmapped and any shared objects must be recreated. The ShmPool emits
@@ -173,7 +190,9 @@ public:
      *
      * If the ShmPool fails to provide such a Buffer a @c null Buffer::Ptr is returned.
      * The content of the @p image is <b>copied</b> into the buffer. The @p image and
-     * returned Buffer do <b>not</b> share memory.
+     * returned Buffer do <b>not</b> share memory. Images in any other format than
+     * QImage::Format_ARGB32_Premultiplied or QImage::Format_RGB32 are converted into the
+     * Buffer while copying.
      *
      * @param image The image which should be copied into the Buffer
      * @return Buffer with copied content of @p image in success case, a @c null Buffer::Ptr otherwise
@@ -211,12 +230,26 @@ public:
      **/
     Buffer::Ptr getBuffer(const QSize &size, int32_t stride, Buffer::Format format = Buffer::Format::ARGB32);
     wl_shm *shm();
+    /**
+     * Destroys all Buffers which are neither used nor held by the server and gives the memory
+     * of the unused regions of the pool back to the system. The pool itself can't shrink.
+     **/
+    void trim();
+    /**
+     * @returns The size of the shared memory pool in bytes.
+     **/
+    int32_t poolSize() const;
 Q_SIGNALS:
     /**
      * This signal is emitted whenever the shared memory pool gets resized.
      * Any used Buffer must be remapped.
      **/
     void poolResized();
+    /**
+     * This signal is emitted whenever the Wayland server released @p buffer.
+     * @see Buffer::isReleased
+     **/
+    void bufferReleased(KWayland::Client::Buffer *buffer);
 
     /**
      * The corresponding global for this interface on the Registry got removed.
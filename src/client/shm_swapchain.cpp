@@ -0,0 +1,289 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "shm_swapchain.h"
+#include "dmabuf_pool.h"
+#include "shm_pool.h"
+#include "surface.h"
+// Qt
+#include <QPointer>
+#include <QRegion>
+#include <QVector>
+// std
+#include <algorithm>
+
+namespace KWayland
+{
+namespace Client
+{
+class Q_DECL_HIDDEN ShmSwapchain::Private
+{
+public:
+    Private(ShmSwapchain *q, Surface *surface);
+
+    struct Slot {
+        Buffer::Ptr buffer;
+        // whether the Buffer got attached and its release is still to be awaited
+        bool presented = false;
+        // the frame in which the Buffer got presented last, 0 if it never was
+        quint64 presentedFrame = 0;
+    };
+
+    bool hasPool() const;
+    Buffer::Ptr allocate() const;
+    bool isFree(const Slot &slot) const;
+    int findFree() const;
+    void checkReady();
+
+    // one of the pools provides the Buffers
+    QPointer<ShmPool> pool;
+    QPointer<DmaBufPool> dmaBufPool;
+    QPointer<Surface> surface;
+    QVector<Slot> buffers;
+    int bufferCount = 2;
+    QSize size;
+    Buffer::Format format = Buffer::Format::ARGB32;
+    bool framePacing = true;
+    bool framePending = false;
+    // whether acquire failed and ready has to be emitted
+    bool waiting = false;
+    int acquired = -1;
+    quint64 frameCounter = 0;
+
+private:
+    ShmSwapchain *q;
+};
+
+ShmSwapchain::Private::Private(ShmSwapchain *q, Surface *surface)
+    : surface(surface)
+    , q(q)
+{
+}
+
+bool ShmSwapchain::Private::hasPool() const
+{
+    return pool || dmaBufPool;
+}
+
+Buffer::Ptr ShmSwapchain::Private::allocate() const
+{
+    if (dmaBufPool) {
+        return dmaBufPool->getBuffer(size, format);
+    }
+    return pool->getBuffer(size, size.width() * 4, format);
+}
+
+bool ShmSwapchain::Private::isFree(const Slot &slot) const
+{
+    const auto buffer = slot.buffer.toStrongRef();
+    return buffer && (!slot.presented || buffer->isReleased());
+}
+
+int ShmSwapchain::Private::findFree() const
+{
+    // prefer the oldest free Buffer, it is the least likely one to be read by the server
+    int index = -1;
+    for (int i = 0; i < buffers.count(); ++i) {
+        if (isFree(buffers[i]) && (index == -1 || buffers[i].presentedFrame < buffers[index].presentedFrame)) {
+            index = i;
+        }
+    }
+    return index;
+}
+
+void ShmSwapchain::Private::checkReady()
+{
+    if (waiting && q->isReady()) {
+        waiting = false;
+        Q_EMIT q->ready();
+    }
+}
+
+ShmSwapchain::ShmSwapchain(ShmPool *pool, Surface *surface, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, surface))
+{
+    d->pool = pool;
+    connect(pool, &ShmPool::bufferReleased, this, [this] {
+        d->checkReady();
+    });
+    connect(surface, &Surface::frameRendered, this, [this] {
+        d->framePending = false;
+        d->checkReady();
+    });
+}
+
+ShmSwapchain::ShmSwapchain(DmaBufPool *pool, Surface *surface, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this, surface))
+{
+    d->dmaBufPool = pool;
+    connect(pool, &DmaBufPool::bufferReleased, this, [this] {
+        d->checkReady();
+    });
+    // the formats arrive after the pool got created, acquire fails until then
+    connect(pool, &DmaBufPool::formatsChanged, this, [this] {
+        d->checkReady();
+    });
+    connect(surface, &Surface::frameRendered, this, [this] {
+        d->framePending = false;
+        d->checkReady();
+    });
+}
+
+ShmSwapchain::~ShmSwapchain()
+{
+    reset();
+}
+
+void ShmSwapchain::setBufferCount(int count)
+{
+    count = qMax(1, count);
+    if (d->bufferCount == count) {
+        return;
+    }
+    reset();
+    d->bufferCount = count;
+}
+
+int ShmSwapchain::bufferCount() const
+{
+    return d->bufferCount;
+}
+
+void ShmSwapchain::setSize(const QSize &size)
+{
+    if (d->size == size) {
+        return;
+    }
+    reset();
+    d->size = size;
+}
+
+QSize ShmSwapchain::size() const
+{
+    return d->size;
+}
+
+void ShmSwapchain::setFormat(Buffer::Format format)
+{
+    if (d->format == format) {
+        return;
+    }
+    reset();
+    d->format = format;
+}
+
+Buffer::Format ShmSwapchain::format() const
+{
+    return d->format;
+}
+
+void ShmSwapchain::setFramePacing(bool enabled)
+{
+    d->framePacing = enabled;
+    if (!enabled) {
+        d->framePending = false;
+        d->checkReady();
+    }
+}
+
+bool ShmSwapchain::framePacing() const
+{
+    return d->framePacing;
+}
+
+bool ShmSwapchain::isReady() const
+{
+    if (d->acquired != -1) {
+        return true;
+    }
+    if (d->framePending || !d->hasPool() || d->size.isEmpty()) {
+        return false;
+    }
+    return d->buffers.count() < d->bufferCount || d->findFree() != -1;
+}
+
+Buffer::Ptr ShmSwapchain::acquire()
+{
+    if (d->acquired != -1) {
+        return d->buffers[d->acquired].buffer;
+    }
+    if (d->framePending || !d->hasPool() || d->size.isEmpty()) {
+        d->waiting = true;
+        return Buffer::Ptr();
+    }
+    // Buffers the pool dropped, e.g. because it got destroyed, can't be used anymore
+    d->buffers.erase(std::remove_if(d->buffers.begin(),
+                                    d->buffers.end(),
+                                    [](const Private::Slot &slot) {
+                                        return slot.buffer.isNull();
+                                    }),
+                     d->buffers.end());
+
+    int index = d->findFree();
+    if (index == -1 && d->buffers.count() < d->bufferCount) {
+        const Buffer::Ptr buffer = d->allocate();
+        if (auto b = buffer.toStrongRef()) {
+            b->setUsed(true);
+            Private::Slot slot;
+            slot.buffer = buffer;
+            d->buffers.append(slot);
+            index = d->buffers.count() - 1;
+        }
+    }
+    if (index == -1) {
+        d->waiting = true;
+        return Buffer::Ptr();
+    }
+    d->acquired = index;
+    return d->buffers[index].buffer;
+}
+
+int ShmSwapchain::bufferAge() const
+{
+    if (d->acquired == -1) {
+        return 0;
+    }
+    const Private::Slot &slot = d->buffers[d->acquired];
+    if (slot.presentedFrame == 0) {
+        return 0;
+    }
+    return d->frameCounter - slot.presentedFrame + 1;
+}
+
+void ShmSwapchain::present(const QRegion &damage)
+{
+    if (d->acquired == -1 || !d->surface) {
+        return;
+    }
+    Private::Slot &slot = d->buffers[d->acquired];
+    d->acquired = -1;
+    const auto buffer = slot.buffer.toStrongRef();
+    if (!buffer) {
+        return;
+    }
+    buffer->setReleased(false);
+    slot.presented = true;
+    slot.presentedFrame = ++d->frameCounter;
+
+    d->surface->attachBuffer(buffer.data());
+    d->surface->damageBuffer(damage);
+    d->framePending = d->framePacing;
+    d->surface->commit(d->framePacing ? Surface::CommitFlag::FrameCallback : Surface::CommitFlag::None);
+}
+
+void ShmSwapchain::reset()
+{
+    for (const Private::Slot &slot : qAsConst(d->buffers)) {
+        if (auto buffer = slot.buffer.toStrongRef()) {
+            buffer->setUsed(false);
+        }
+    }
+    d->buffers.clear();
+    d->acquired = -1;
+}
+
+}
+}
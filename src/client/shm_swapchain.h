@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_SHM_SWAPCHAIN_H
+#define WAYLAND_SHM_SWAPCHAIN_H
+
+#include <QObject>
+
+#include "buffer.h"
+#include <DWayland/Client/kwaylandclient_export.h>
+
+class QRegion;
+class QSize;
+
+namespace KWayland
+{
+namespace Client
+{
+class DmaBufPool;
+class ShmPool;
+class Surface;
+
+/**
+ * @short A fixed set of shared memory Buffers rendered into in turn and presented on a Surface.
+ *
+ * The ShmSwapchain keeps up to bufferCount Buffers of the configured size and format and keeps
+ * track of which of them are still held by the Wayland server. Instead of requesting a new Buffer
+ * from the ShmPool for every frame a client acquires the next free Buffer, renders into it and
+ * presents it:
+ * @code
+ * ShmSwapchain swapchain(shmPool, surface);
+ * swapchain.setSize(QSize(256, 256));
+ * connect(&swapchain, &ShmSwapchain::ready, this, &Client::render);
+ *
+ * void Client::render()
+ * {
+ *     auto buffer = swapchain.acquire().toStrongRef();
+ *     if (!buffer) {
+ *         // try again once ready is emitted
+ *         return;
+ *     }
+ *     QImage image = buffer->image();
+ *     // bufferAge tells which part of the image is still up to date
+ *     paint(&image, swapchain.bufferAge());
+ *     swapchain.present(damage);
+ * }
+ * @endcode
+ *
+ * With frame pacing enabled, which is the default, present requests a frame callback and no
+ * Buffer can be acquired until the server has signalled that the presented frame got rendered.
+ *
+ * The Buffers are marked as used for as long as they belong to the ShmSwapchain, thus the
+ * ShmPool doesn't hand them out to anyone else.
+ *
+ * A ShmSwapchain created with a DmaBufPool rotates GPU Buffers the same way. The client renders
+ * into the Buffer::bo of the acquired Buffer instead of its image then.
+ *
+ * @see ShmPool
+ * @see DmaBufPool
+ * @see Surface
+ **/
+class KWAYLANDCLIENT_EXPORT ShmSwapchain : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ShmSwapchain(ShmPool *pool, Surface *surface, QObject *parent = nullptr);
+    /**
+     * Creates a swapchain of Buffers allocated by the DmaBufPool @p pool.
+     **/
+    explicit ShmSwapchain(DmaBufPool *pool, Surface *surface, QObject *parent = nullptr);
+    ~ShmSwapchain() override;
+
+    /**
+     * Sets the maximum number of Buffers in this swapchain to @p count, by default 2.
+     * Changing the count drops all Buffers.
+     **/
+    void setBufferCount(int count);
+    /**
+     * @returns The maximum number of Buffers in this swapchain.
+     **/
+    int bufferCount() const;
+    /**
+     * Sets the @p size of the Buffers. Changing the size drops all Buffers.
+     **/
+    void setSize(const QSize &size);
+    /**
+     * @returns The size of the Buffers.
+     **/
+    QSize size() const;
+    /**
+     * Sets the @p format of the Buffers, by default Buffer::Format::ARGB32.
+     * Changing the format drops all Buffers.
+     **/
+    void setFormat(Buffer::Format format);
+    /**
+     * @returns The format of the Buffers.
+     **/
+    Buffer::Format format() const;
+    /**
+     * Sets whether present waits for the frame callback of the Surface before another
+     * Buffer can be acquired. Frame pacing is enabled by default.
+     **/
+    void setFramePacing(bool enabled);
+    /**
+     * @returns Whether frame pacing is enabled.
+     **/
+    bool framePacing() const;
+
+    /**
+     * @returns @c true if acquire would provide a Buffer.
+     **/
+    bool isReady() const;
+    /**
+     * Provides the Buffer to render the next frame into. Calling this method again before
+     * present returns the same Buffer.
+     *
+     * If all Buffers are still held by the server or a frame callback is pending a @c null
+     * Buffer::Ptr is returned and ready is emitted once a Buffer can be acquired.
+     **/
+    Buffer::Ptr acquire();
+    /**
+     * @returns The age of the acquired Buffer: @c 0 if its content is undefined, otherwise the
+     * number of frames since its content was presented, e.g. @c 1 if it holds the last
+     * presented frame.
+     **/
+    int bufferAge() const;
+    /**
+     * Attaches the acquired Buffer to the Surface, marks @p damage in buffer coordinates as
+     * damaged and commits the Surface.
+     **/
+    void present(const QRegion &damage);
+    /**
+     * Hands all Buffers back to the ShmPool. The next acquire starts with fresh Buffers.
+     **/
+    void reset();
+
+Q_SIGNALS:
+    /**
+     * Emitted when a Buffer can be acquired again after acquire failed.
+     **/
+    void ready();
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+}
+}
+
+#endif
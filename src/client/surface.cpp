@@ -4,11 +4,15 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "surface.h"
+#include "compositor.h"
+#include "logging.h"
 #include "output.h"
 #include "region.h"
 #include "wayland_pointer_p.h"
+#include "wrapperindex_p.h"
 
 #include <QGuiApplication>
+#include <QPointer>
 #include <QRegion>
 #include <QVector>
 #include <qpa/qplatformnativeinterface.h>
@@ -31,10 +35,18 @@ public:
     bool foreign = false;
     qint32 scale = 1;
     QVector<Output *> outputs;
+    std::function<void()> commitHook;
+    QPointer<Compositor> compositor;
+    // the regions set last through the QRegion overloads
+    QRegion inputRegion;
+    QRegion opaqueRegion;
+    bool inputRegionCached = false;
+    bool opaqueRegionCached = false;
 
     void setup(wl_surface *s);
 
     static QList<Surface *> s_surfaces;
+    static WrapperIndex<wl_surface *, Surface> s_index;
 
 private:
     void handleFrameCallback();
@@ -49,6 +61,7 @@ private:
 };
 
 QList<Surface *> Surface::Private::s_surfaces = QList<Surface *>();
+WrapperIndex<wl_surface *, Surface> Surface::Private::s_index;
 
 Surface::Private::Private(Surface *q)
     : q(q)
@@ -65,6 +78,7 @@ Surface::Surface(QObject *parent)
 Surface::~Surface()
 {
     Private::s_surfaces.removeAll(this);
+    Private::s_index.remove(this);
     release();
 }
 
@@ -87,6 +101,7 @@ Surface *Surface::fromWindow(QWindow *window)
     }
     Surface *surface = new Surface(window);
     surface->d->surface.setup(s, true);
+    Private::s_index.insert(s, surface);
     return surface;
 }
 
@@ -109,11 +124,13 @@ Surface *Surface::fromQtWinId(WId wid)
 
 void Surface::release()
 {
+    Private::s_index.remove(this);
     d->surface.release();
 }
 
 void Surface::destroy()
 {
+    Private::s_index.remove(this);
     d->surface.destroy();
 }
 
@@ -127,6 +144,7 @@ void Surface::Private::setup(wl_surface *s)
     Q_ASSERT(s);
     Q_ASSERT(!surface);
     surface.setup(s);
+    s_index.insert(s, q);
     wl_surface_add_listener(s, &s_surfaceListener, this);
 }
 
@@ -201,9 +219,17 @@ void Surface::commit(Surface::CommitFlag flag)
     if (flag == CommitFlag::FrameCallback) {
         setupFrameCallback();
     }
+    if (d->commitHook) {
+        d->commitHook();
+    }
     wl_surface_commit(d->surface);
 }
 
+void Surface::setCommitHook(std::function<void()> hook)
+{
+    d->commitHook = std::move(hook);
+}
+
 void Surface::damage(const QRegion &region)
 {
     for (const QRect &rect : region) {
@@ -246,9 +272,15 @@ void Surface::attachBuffer(Buffer::Ptr buffer, const QPoint &offset)
     attachBuffer(buffer.toStrongRef().data(), offset);
 }
 
+void Surface::setCompositor(Compositor *compositor)
+{
+    d->compositor = compositor;
+}
+
 void Surface::setInputRegion(const Region *region)
 {
     Q_ASSERT(isValid());
+    d->inputRegionCached = false;
     if (region) {
         wl_surface_set_input_region(d->surface, *region);
     } else {
@@ -259,6 +291,7 @@ void Surface::setInputRegion(const Region *region)
 void Surface::setOpaqueRegion(const Region *region)
 {
     Q_ASSERT(isValid());
+    d->opaqueRegionCached = false;
     if (region) {
         wl_surface_set_opaque_region(d->surface, *region);
     } else {
@@ -266,6 +299,39 @@ void Surface::setOpaqueRegion(const Region *region)
     }
 }
 
+void Surface::setInputRegion(const QRegion &region)
+{
+    Q_ASSERT(isValid());
+    if (d->inputRegionCached && d->inputRegion == region) {
+        return;
+    }
+    if (!d->compositor) {
+        qCWarning(KWAYLAND_CLIENT) << "Cannot set the input region of a Surface not created by a Compositor";
+        return;
+    }
+    wl_surface_set_input_region(d->surface, *d->compositor->cachedRegion(region));
+    d->inputRegion = region;
+    d->inputRegionCached = true;
+}
+
+void Surface::setOpaqueRegion(const QRegion &region)
+{
+    Q_ASSERT(isValid());
+    if (d->opaqueRegionCached && d->opaqueRegion == region) {
+        return;
+    }
+    if (region.isEmpty()) {
+        wl_surface_set_opaque_region(d->surface, nullptr);
+    } else if (d->compositor) {
+        wl_surface_set_opaque_region(d->surface, *d->compositor->cachedRegion(region));
+    } else {
+        qCWarning(KWAYLAND_CLIENT) << "Cannot set the opaque region of a Surface not created by a Compositor";
+        return;
+    }
+    d->opaqueRegion = region;
+    d->opaqueRegionCached = true;
+}
+
 void Surface::setSize(const QSize &size)
 {
     if (d->size == size) {
@@ -277,13 +343,7 @@ void Surface::setSize(const QSize &size)
 
 Surface *Surface::get(wl_surface *native)
 {
-    auto it = std::find_if(Private::s_surfaces.constBegin(), Private::s_surfaces.constEnd(), [native](Surface *s) {
-        return s->d->surface == native;
-    });
-    if (it != Private::s_surfaces.constEnd()) {
-        return *(it);
-    }
-    return nullptr;
+    return Private::s_index.value(native);
 }
 
 const QList<Surface *> &Surface::all()
@@ -13,6 +13,8 @@
 #include <QSize>
 #include <QWindow>
 
+#include <functional>
+
 #include <DWayland/Client/kwaylandclient_export.h>
 
 struct wl_buffer;
@@ -25,6 +27,7 @@ namespace KWayland
 namespace Client
 {
 class Output;
+class Compositor;
 class Region;
 
 /**
@@ -198,6 +201,28 @@ public:
      * @see commit
      **/
     void setOpaqueRegion(const Region *region = nullptr);
+    /**
+     * Sets the input region to @p region, an empty @p region means the Surface doesn't accept
+     * any input. Use the Region overload to reset it to an infinite input region.
+     *
+     * The Region is shared with other Surfaces through Compositor::cachedRegion. If @p region
+     * is the input region set last through this method, nothing is sent to the compositor.
+     *
+     * Requires the Surface to be created by a Compositor.
+     * @see Compositor::cachedRegion
+     **/
+    void setInputRegion(const QRegion &region);
+    /**
+     * Sets the opaque region to @p region, an empty @p region resets it.
+     *
+     * The Region is shared with other Surfaces through Compositor::cachedRegion. If @p region
+     * is the opaque region set last through this method, nothing is sent to the compositor,
+     * a Surface can call it for every frame.
+     *
+     * Requires the Surface to be created by a Compositor.
+     * @see Compositor::cachedRegion
+     **/
+    void setOpaqueRegion(const QRegion &region);
     void setSize(const QSize &size);
     QSize size() const;
 
@@ -287,6 +312,16 @@ Q_SIGNALS:
     void outputLeft(KWayland::Client::Output *o);
 
 private:
+    friend class Compositor;
+    void setCompositor(Compositor *compositor);
+
+    friend class XdgShellSurface;
+    /**
+     * Sets the @p hook invoked right before the Surface is committed, replacing a previous one.
+     * It is used by the shell surface of this Surface to ack its configure events on commit.
+     **/
+    void setCommitHook(std::function<void()> hook);
+
     class Private;
     QScopedPointer<Private> d;
 };
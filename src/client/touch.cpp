@@ -10,6 +10,8 @@
 #include <QPointF>
 #include <QPointer>
 #include <QVector>
+
+#include <utility>
 // wayland
 #include <wayland-client-protocol.h>
 
@@ -26,6 +28,11 @@ public:
     bool active = false;
     QVector<TouchPoint *> sequence;
     TouchPoint *getActivePoint(qint32 id) const;
+    bool aggregateFrames = false;
+    // the points that moved in the current frame, if the frames are aggregated
+    QVector<TouchPoint *> movedPoints;
+
+    void emitMovedPoints();
 
 private:
     static void downCallback(void *data, wl_touch *touch, uint32_t serial, uint32_t time, wl_surface *surface, int32_t id, wl_fixed_t x, wl_fixed_t y);
@@ -145,6 +152,8 @@ void Touch::Private::down(quint32 serial, quint32 time, qint32 id, const QPointF
         sequence << p;
         Q_EMIT q->pointAdded(p);
     } else {
+        // the points of the previous sequence are about to be deleted
+        emitMovedPoints();
         qDeleteAll(sequence);
         sequence.clear();
         sequence << p;
@@ -207,13 +216,29 @@ void Touch::Private::motion(quint32 time, qint32 id, const QPointF &position)
     }
     p->d->positions << position;
     p->d->timestamps << time;
+    if (aggregateFrames) {
+        if (!movedPoints.contains(p)) {
+            movedPoints.append(p);
+        }
+        return;
+    }
     Q_EMIT q->pointMoved(p);
 }
 
+void Touch::Private::emitMovedPoints()
+{
+    if (movedPoints.isEmpty()) {
+        return;
+    }
+    const QVector<TouchPoint *> points = std::exchange(movedPoints, {});
+    Q_EMIT q->pointsMoved(points);
+}
+
 void Touch::Private::frameCallback(void *data, wl_touch *touch)
 {
     auto t = reinterpret_cast<Touch::Private *>(data);
     Q_ASSERT(t->touch == touch);
+    t->emitMovedPoints();
     Q_EMIT t->q->frameEnded();
 }
 
@@ -222,6 +247,7 @@ void Touch::Private::cancelCallback(void *data, wl_touch *touch)
     auto t = reinterpret_cast<Touch::Private *>(data);
     Q_ASSERT(t->touch == touch);
     t->active = false;
+    t->emitMovedPoints();
     Q_EMIT t->q->sequenceCanceled();
 }
 
@@ -239,11 +265,13 @@ Touch::~Touch()
 void Touch::destroy()
 {
     d->touch.destroy();
+    d->movedPoints.clear();
 }
 
 void Touch::release()
 {
     d->touch.release();
+    d->movedPoints.clear();
 }
 
 void Touch::setup(wl_touch *touch)
@@ -251,6 +279,20 @@ void Touch::setup(wl_touch *touch)
     d->setup(touch);
 }
 
+void Touch::setFrameAggregation(bool enabled)
+{
+    if (d->aggregateFrames == enabled) {
+        return;
+    }
+    d->emitMovedPoints();
+    d->aggregateFrames = enabled;
+}
+
+bool Touch::frameAggregation() const
+{
+    return d->aggregateFrames;
+}
+
 bool Touch::isValid() const
 {
     return d->touch.isValid();
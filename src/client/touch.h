@@ -132,6 +132,22 @@ public:
      **/
     QVector<TouchPoint *> sequence() const;
 
+    /**
+     * Enables the aggregation of the motion of a logical frame.
+     *
+     * While enabled, pointMoved is not emitted for every motion event. Instead the moved
+     * TouchPoints are collected until the wl_touch.frame event and emitted together with
+     * pointsMoved, right before frameEnded, each of them once. The positions of all motion
+     * events are still recorded in the TouchPoints.
+     *
+     * Added and removed points are not aggregated, the moved points collected so far are
+     * emitted before a new sequence starts or the sequence gets canceled.
+     *
+     * By default the aggregation is disabled.
+     **/
+    void setFrameAggregation(bool enabled);
+    bool frameAggregation() const;
+
     operator wl_touch *();
     operator wl_touch *() const;
 
@@ -154,6 +170,12 @@ Q_SIGNALS:
      * Indicates the end of a contact point list.
      **/
     void frameEnded();
+    /**
+     * Emitted with the TouchPoints that moved in a frame if the frame aggregation is enabled.
+     *
+     * @see setFrameAggregation
+     **/
+    void pointsMoved(const QVector<KWayland::Client::TouchPoint *> &points);
     /**
      * TouchPoint @p point got added to the sequence.
      **/
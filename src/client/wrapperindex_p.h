@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#ifndef WAYLAND_WRAPPER_INDEX_P_H
+#define WAYLAND_WRAPPER_INDEX_P_H
+
+#include <QHash>
+
+namespace KWayland
+{
+namespace Client
+{
+/**
+ * Maps a key, e.g. the native proxy or the Surface a wrapper is created for, to the wrapper,
+ * so the static get() methods don't have to scan all wrappers. A wrapper has at most one key,
+ * inserting it again moves it to the new key. If several wrappers got inserted with the same
+ * key, the last one wins.
+ */
+template<typename Key, typename T>
+class WrapperIndex
+{
+public:
+    void insert(Key key, T *wrapper)
+    {
+        remove(wrapper);
+        if (!key) {
+            return;
+        }
+        m_wrappers.insert(key, wrapper);
+        m_keys.insert(wrapper, key);
+    }
+
+    void remove(T *wrapper)
+    {
+        auto it = m_keys.find(wrapper);
+        if (it == m_keys.end()) {
+            return;
+        }
+        auto wrapperIt = m_wrappers.find(*it);
+        if (wrapperIt != m_wrappers.end() && *wrapperIt == wrapper) {
+            m_wrappers.erase(wrapperIt);
+        }
+        m_keys.erase(it);
+    }
+
+    T *value(Key key) const
+    {
+        return m_wrappers.value(key);
+    }
+
+private:
+    QHash<Key, T *> m_wrappers;
+    QHash<T *, Key> m_keys;
+};
+
+}
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "xdgoutput.h"
 #include "event_queue.h"
 #include "output.h"
+#include "propertystore_p.h"
 #include "wayland_pointer_p.h"
 
 #include <wayland-client-protocol.h>
@@ -98,11 +99,11 @@ XdgOutput *XdgOutputManager::getXdgOutput(Output *output, QObject *parent)
     return p;
 }
 
-struct XdgOutputBuffer {
-    QPoint logicalPosition;
-    QSize logicalSize;
-    QString name;
-    QString description;
+enum class XdgOutputProperty {
+    LogicalPosition,
+    LogicalSize,
+    Name,
+    Description,
 };
 
 class XdgOutput::Private
@@ -114,8 +115,7 @@ public:
 
     WaylandPointer<zxdg_output_v1, zxdg_output_v1_destroy> xdgoutput;
 
-    XdgOutputBuffer current;
-    XdgOutputBuffer pending;
+    PropertyStore<XdgOutputProperty, QPoint, QSize, QString, QString> properties;
 
 private:
     XdgOutput *q;
@@ -140,37 +140,37 @@ void XdgOutput::Private::logical_positionCallback(void *data, zxdg_output_v1 *zx
 {
     auto p = reinterpret_cast<XdgOutput::Private *>(data);
     Q_ASSERT(p->xdgoutput == zxdg_output_v1);
-    p->pending.logicalPosition = QPoint(x, y);
+    p->properties.setPending<XdgOutputProperty::LogicalPosition>(QPoint(x, y));
 }
 
 void XdgOutput::Private::logical_sizeCallback(void *data, zxdg_output_v1 *zxdg_output_v1, int32_t width, int32_t height)
 {
     auto p = reinterpret_cast<XdgOutput::Private *>(data);
     Q_ASSERT(p->xdgoutput == zxdg_output_v1);
-    p->pending.logicalSize = QSize(width, height);
+    p->properties.setPending<XdgOutputProperty::LogicalSize>(QSize(width, height));
 }
 
 void XdgOutput::Private::nameCallback(void *data, zxdg_output_v1 *zxdg_output_v1, const char *name)
 {
     auto p = reinterpret_cast<XdgOutput::Private *>(data);
     Q_ASSERT(p->xdgoutput == zxdg_output_v1);
-    p->pending.name = name;
+    p->properties.setPending<XdgOutputProperty::Name>(QString::fromUtf8(name));
 }
 
 void XdgOutput::Private::descriptionCallback(void *data, zxdg_output_v1 *zxdg_output_v1, const char *description)
 {
     auto p = reinterpret_cast<XdgOutput::Private *>(data);
     Q_ASSERT(p->xdgoutput == zxdg_output_v1);
-    p->pending.description = description;
+    p->properties.setPending<XdgOutputProperty::Description>(QString::fromUtf8(description));
 }
 
 void XdgOutput::Private::doneCallback(void *data, zxdg_output_v1 *zxdg_output_v1)
 {
     auto p = reinterpret_cast<XdgOutput::Private *>(data);
     Q_ASSERT(p->xdgoutput == zxdg_output_v1);
-    std::swap(p->current, p->pending);
-
-    Q_EMIT p->q->changed();
+    if (p->properties.apply()) {
+        Q_EMIT p->q->changed();
+    }
 }
 
 XdgOutput::Private::Private(XdgOutput *qptr)
@@ -214,22 +214,22 @@ void XdgOutput::destroy()
 
 QSize XdgOutput::logicalSize() const
 {
-    return d->current.logicalSize;
+    return d->properties.value<XdgOutputProperty::LogicalSize>();
 }
 
 QPoint XdgOutput::logicalPosition() const
 {
-    return d->current.logicalPosition;
+    return d->properties.value<XdgOutputProperty::LogicalPosition>();
 }
 
 QString XdgOutput::name() const
 {
-    return d->current.name;
+    return d->properties.value<XdgOutputProperty::Name>();
 }
 
 QString XdgOutput::description() const
 {
-    return d->current.description;
+    return d->properties.value<XdgOutputProperty::Description>();
 }
 
 XdgOutput::operator zxdg_output_v1 *()
@@ -11,6 +11,8 @@
 #include "wayland_pointer_p.h"
 #include "xdgshell_p.h"
 
+#include <utility>
+
 namespace KWayland
 {
 namespace Client
@@ -100,7 +102,11 @@ bool XdgShell::isValid() const
 
 XdgShellSurface *XdgShell::createSurface(Surface *surface, QObject *parent)
 {
-    return d->getXdgSurface(surface, parent);
+    XdgShellSurface *s = d->getXdgSurface(surface, parent);
+    if (s) {
+        s->d->surface = surface;
+    }
+    return s;
 }
 
 XdgShellPopup *XdgShell::createPopup(Surface *surface, Surface *parentSurface, Seat *seat, quint32 serial, const QPoint &parentPos, QObject *parent)
@@ -125,6 +131,35 @@ XdgShellSurface::Private::Private(XdgShellSurface *q)
 
 XdgShellSurface::Private::~Private() = default;
 
+void XdgShellSurface::Private::setPendingConfigure(const QSize &size, States states)
+{
+    pendingSize = size;
+    pendingState = states;
+}
+
+void XdgShellSurface::Private::configure(quint32 serial)
+{
+    const QSize size = std::exchange(pendingSize, QSize());
+    const States states = std::exchange(pendingState, {});
+    if (autoAckConfigure) {
+        ackPending = true;
+        ackSerial = serial;
+    }
+    Q_EMIT q->configureRequested(size, states, serial);
+    if (!size.isNull()) {
+        q->setSize(size);
+    }
+}
+
+void XdgShellSurface::Private::ackPendingConfigure()
+{
+    if (!ackPending || !isValid()) {
+        return;
+    }
+    ackPending = false;
+    ackConfigure(ackSerial);
+}
+
 XdgShellSurface::XdgShellSurface(Private *p, QObject *parent)
     : QObject(parent)
     , d(p)
@@ -133,6 +168,9 @@ XdgShellSurface::XdgShellSurface(Private *p, QObject *parent)
 
 XdgShellSurface::~XdgShellSurface()
 {
+    if (d->autoAckConfigure && d->surface) {
+        d->surface->setCommitHook({});
+    }
     release();
 }
 
@@ -248,9 +286,36 @@ void XdgShellSurface::requestResize(Seat *seat, quint32 serial, Qt::Edges edges)
 
 void XdgShellSurface::ackConfigure(quint32 serial)
 {
+    if (d->ackPending && d->ackSerial == serial) {
+        d->ackPending = false;
+    }
     d->ackConfigure(serial);
 }
 
+void XdgShellSurface::setAutoAckConfigure(bool enable)
+{
+    if (d->autoAckConfigure == enable) {
+        return;
+    }
+    d->autoAckConfigure = enable;
+    d->ackPending = false;
+    if (!d->surface) {
+        return;
+    }
+    if (enable) {
+        d->surface->setCommitHook([this]() {
+            d->ackPendingConfigure();
+        });
+    } else {
+        d->surface->setCommitHook({});
+    }
+}
+
+bool XdgShellSurface::autoAckConfigure() const
+{
+    return d->autoAckConfigure;
+}
+
 void XdgShellSurface::setMaximized(bool set)
 {
     if (set) {
@@ -420,6 +420,21 @@ public:
      **/
     void ackConfigure(quint32 serial);
 
+    /**
+     * Acks the last configure event on the next commit of the Surface this XdgShellSurface was
+     * created for, instead of requiring a call to ackConfigure. Configure events which are
+     * superseded before a commit are not acked. Disabled by default.
+     *
+     * Only one XdgShellSurface may enable it for a Surface.
+     * @see ackConfigure
+     **/
+    void setAutoAckConfigure(bool enable);
+    /**
+     * @returns whether configure events are acked on commit.
+     * @see setAutoAckConfigure
+     **/
+    bool autoAckConfigure() const;
+
     /**
      * Request to set this XdgShellSurface to be maximized if @p set is @c true.
      * If @p set is @c false it requests to unset the maximized state - if set.
@@ -495,6 +510,7 @@ protected:
     explicit XdgShellSurface(Private *p, QObject *parent = nullptr);
 
 private:
+    friend class XdgShell;
     QScopedPointer<Private> d;
 };
 
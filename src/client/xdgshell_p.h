@@ -8,9 +8,12 @@
 #include "xdgshell.h"
 
 #include <QDebug>
+#include <QPointer>
 #include <QRect>
 #include <QSize>
 
+#include <wayland-util.h>
+
 namespace KWayland
 {
 namespace Client
@@ -168,12 +171,60 @@ private:
     class Private;
 };
 
+/**
+ * Decodes the states of a configure event of any xdg-shell version, the versions only differ in
+ * the values of the state enum. The states are read in place from the @p array.
+ **/
+template<uint32_t Maximized, uint32_t Fullscreen, uint32_t Resizing, uint32_t Activated>
+XdgShellSurface::States decodeXdgStates(const wl_array *array)
+{
+    XdgShellSurface::States states;
+    const uint32_t *state = static_cast<const uint32_t *>(array->data);
+    const size_t count = array->size / sizeof(uint32_t);
+    for (size_t i = 0; i < count; ++i) {
+        switch (state[i]) {
+        case Maximized:
+            states |= XdgShellSurface::State::Maximized;
+            break;
+        case Fullscreen:
+            states |= XdgShellSurface::State::Fullscreen;
+            break;
+        case Resizing:
+            states |= XdgShellSurface::State::Resizing;
+            break;
+        case Activated:
+            states |= XdgShellSurface::State::Activated;
+            break;
+        }
+    }
+    return states;
+}
+
 class Q_DECL_HIDDEN XdgShellSurface::Private
 {
 public:
     virtual ~Private();
     EventQueue *queue = nullptr;
     QSize size;
+    QPointer<Surface> surface;
+
+    /**
+     * Records the size and states of a toplevel configure event, the last one wins until the
+     * configure is completed.
+     **/
+    void setPendingConfigure(const QSize &size, States states);
+    /**
+     * Completes the configure with @p serial: emits configureRequested once with everything the
+     * compositor sent since the last one and remembers the serial to ack on the next commit.
+     **/
+    void configure(quint32 serial);
+    void ackPendingConfigure();
+
+    QSize pendingSize;
+    States pendingState;
+    bool autoAckConfigure = false;
+    bool ackPending = false;
+    quint32 ackSerial = 0;
 
     virtual void setupV5(xdg_surface *surface)
     {
@@ -274,9 +274,6 @@ public:
     void setWindowGeometry(const QRect &windowGeometry) override;
 
 private:
-    QSize pendingSize;
-    States pendingState;
-
     static void configureCallback(void *data, struct xdg_toplevel *xdg_toplevel, int32_t width, int32_t height, struct wl_array *state);
     static void closeCallback(void *data, xdg_toplevel *xdg_toplevel);
     static void surfaceConfigureCallback(void *data, xdg_surface *xdg_surface, uint32_t serial);
@@ -293,39 +290,15 @@ void XdgTopLevelStable::Private::surfaceConfigureCallback(void *data, struct xdg
 {
     Q_UNUSED(surface)
     auto s = static_cast<Private *>(data);
-    s->q->configureRequested(s->pendingSize, s->pendingState, serial);
-    if (!s->pendingSize.isNull()) {
-        s->q->setSize(s->pendingSize);
-        s->pendingSize = QSize();
-    }
-    s->pendingState = {};
+    s->configure(serial);
 }
 
 void XdgTopLevelStable::Private::configureCallback(void *data, struct xdg_toplevel *xdg_toplevel, int32_t width, int32_t height, struct wl_array *state)
 {
     Q_UNUSED(xdg_toplevel)
     auto s = static_cast<Private *>(data);
-    States states;
-
-    uint32_t *statePtr = static_cast<uint32_t *>(state->data);
-    for (size_t i = 0; i < state->size / sizeof(uint32_t); i++) {
-        switch (statePtr[i]) {
-        case XDG_TOPLEVEL_STATE_MAXIMIZED:
-            states = states | XdgShellSurface::State::Maximized;
-            break;
-        case XDG_TOPLEVEL_STATE_FULLSCREEN:
-            states = states | XdgShellSurface::State::Fullscreen;
-            break;
-        case XDG_TOPLEVEL_STATE_RESIZING:
-            states = states | XdgShellSurface::State::Resizing;
-            break;
-        case XDG_TOPLEVEL_STATE_ACTIVATED:
-            states = states | XdgShellSurface::State::Activated;
-            break;
-        }
-    }
-    s->pendingSize = QSize(width, height);
-    s->pendingState = states;
+    s->setPendingConfigure(QSize(width, height),
+                           decodeXdgStates<XDG_TOPLEVEL_STATE_MAXIMIZED, XDG_TOPLEVEL_STATE_FULLSCREEN, XDG_TOPLEVEL_STATE_RESIZING, XDG_TOPLEVEL_STATE_ACTIVATED>(state));
 }
 
 void XdgTopLevelStable::Private::closeCallback(void *data, xdg_toplevel *xdg_toplevel)
@@ -164,30 +164,11 @@ void XdgShellSurfaceUnstableV5::Private::configureCallback(void *data,
 {
     auto s = reinterpret_cast<XdgShellSurfaceUnstableV5::Private *>(data);
     Q_ASSERT(s->xdgsurfacev5 == xdg_surface);
-    uint32_t *state = reinterpret_cast<uint32_t *>(wlStates->data);
-    size_t numStates = wlStates->size / sizeof(uint32_t);
-    States states;
-    for (size_t i = 0; i < numStates; i++) {
-        switch (state[i]) {
-        case ZXDG_SURFACE_V5_STATE_MAXIMIZED:
-            states = states | XdgShellSurface::State::Maximized;
-            break;
-        case ZXDG_SURFACE_V5_STATE_FULLSCREEN:
-            states = states | XdgShellSurface::State::Fullscreen;
-            break;
-        case ZXDG_SURFACE_V5_STATE_RESIZING:
-            states = states | XdgShellSurface::State::Resizing;
-            break;
-        case ZXDG_SURFACE_V5_STATE_ACTIVATED:
-            states = states | XdgShellSurface::State::Activated;
-            break;
-        }
-    }
-    const QSize size = QSize(width, height);
-    Q_EMIT s->q->configureRequested(size, states, serial);
-    if (!size.isNull()) {
-        s->q->setSize(size);
-    }
+    // v5 has no separate surface configure, every configure is complete
+    s->setPendingConfigure(
+        QSize(width, height),
+        decodeXdgStates<ZXDG_SURFACE_V5_STATE_MAXIMIZED, ZXDG_SURFACE_V5_STATE_FULLSCREEN, ZXDG_SURFACE_V5_STATE_RESIZING, ZXDG_SURFACE_V5_STATE_ACTIVATED>(wlStates));
+    s->configure(serial);
 }
 
 void XdgShellSurfaceUnstableV5::Private::closeCallback(void *data, xdg_surface *xdg_surface)
@@ -259,8 +259,6 @@ public:
     void setMinSize(const QSize &size) override;
 
 private:
-    QSize pendingSize;
-    States pendingState;
 
     static void configureCallback(void *data, struct zxdg_toplevel_v6 *xdg_toplevel, int32_t width, int32_t height, struct wl_array *state);
     static void closeCallback(void *data, zxdg_toplevel_v6 *xdg_toplevel);
@@ -278,39 +276,16 @@ void XdgTopLevelUnstableV6::Private::surfaceConfigureCallback(void *data, struct
 {
     Q_UNUSED(surface)
     auto s = reinterpret_cast<Private *>(data);
-    s->q->configureRequested(s->pendingSize, s->pendingState, serial);
-    if (!s->pendingSize.isNull()) {
-        s->q->setSize(s->pendingSize);
-        s->pendingSize = QSize();
-    }
-    s->pendingState = {};
+    s->configure(serial);
 }
 
 void XdgTopLevelUnstableV6::Private::configureCallback(void *data, struct zxdg_toplevel_v6 *xdg_toplevel, int32_t width, int32_t height, struct wl_array *state)
 {
     Q_UNUSED(xdg_toplevel)
     auto s = reinterpret_cast<Private *>(data);
-    States states;
-
-    uint32_t *statePtr = reinterpret_cast<uint32_t *>(state->data);
-    for (size_t i = 0; i < state->size / sizeof(uint32_t); i++) {
-        switch (statePtr[i]) {
-        case ZXDG_TOPLEVEL_V6_STATE_MAXIMIZED:
-            states = states | XdgShellSurface::State::Maximized;
-            break;
-        case ZXDG_TOPLEVEL_V6_STATE_FULLSCREEN:
-            states = states | XdgShellSurface::State::Fullscreen;
-            break;
-        case ZXDG_TOPLEVEL_V6_STATE_RESIZING:
-            states = states | XdgShellSurface::State::Resizing;
-            break;
-        case ZXDG_TOPLEVEL_V6_STATE_ACTIVATED:
-            states = states | XdgShellSurface::State::Activated;
-            break;
-        }
-    }
-    s->pendingSize = QSize(width, height);
-    s->pendingState = states;
+    s->setPendingConfigure(
+        QSize(width, height),
+        decodeXdgStates<ZXDG_TOPLEVEL_V6_STATE_MAXIMIZED, ZXDG_TOPLEVEL_V6_STATE_FULLSCREEN, ZXDG_TOPLEVEL_V6_STATE_RESIZING, ZXDG_TOPLEVEL_V6_STATE_ACTIVATED>(state));
 }
 
 void XdgTopLevelUnstableV6::Private::closeCallback(void *data, zxdg_toplevel_v6 *xdg_toplevel)
@@ -8,7 +8,36 @@
 
 using namespace KWaylandServer;
 
+namespace KWaylandServer
+{
+class AbstractDataSourcePrivate
+{
+public:
+    // the list the encoded mime types were created from, compared to detect changes
+    QStringList mimeTypes;
+    QVector<QByteArray> encodedMimeTypes;
+};
+}
+
 AbstractDataSource::AbstractDataSource(QObject *parent)
     : QObject(parent)
+    , d(new AbstractDataSourcePrivate)
+{
+}
+
+AbstractDataSource::~AbstractDataSource() = default;
+
+QVector<QByteArray> AbstractDataSource::encodedMimeTypes() const
 {
+    // comparing implicitly shared lists that weren't modified only compares their data pointers
+    const QStringList mimeTypes = this->mimeTypes();
+    if (mimeTypes != d->mimeTypes) {
+        d->mimeTypes = mimeTypes;
+        d->encodedMimeTypes.clear();
+        d->encodedMimeTypes.reserve(mimeTypes.count());
+        for (const QString &mimeType : mimeTypes) {
+            d->encodedMimeTypes.append(mimeType.toUtf8());
+        }
+    }
+    return d->encodedMimeTypes;
 }
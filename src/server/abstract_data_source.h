@@ -11,10 +11,15 @@
 
 #include <DWayland/Server/kwaylandserver_export.h>
 
+#include <QScopedPointer>
+#include <QVector>
+
 struct wl_client;
 
 namespace KWaylandServer
 {
+class AbstractDataSourcePrivate;
+
 /**
  * @brief The AbstractDataSource class abstracts the data that
  * can be transferred to another client.
@@ -29,6 +34,8 @@ class KWAYLANDSERVER_EXPORT AbstractDataSource : public QObject
 {
     Q_OBJECT
 public:
+    ~AbstractDataSource() override;
+
     virtual bool isAccepted() const
     {
         return false;
@@ -43,6 +50,14 @@ public:
 
     virtual QStringList mimeTypes() const = 0;
 
+    /**
+     * Returns mimeTypes() encoded as UTF-8, as they are sent in offer events.
+     *
+     * The encoded list is computed once per change of the mime types and shared by all data
+     * offers created for this data source.
+     */
+    QVector<QByteArray> encodedMimeTypes() const;
+
     /**
      * @returns The Drag and Drop actions supported by this DataSourceInterface.
      */
@@ -87,6 +102,9 @@ Q_SIGNALS:
 
 protected:
     explicit AbstractDataSource(QObject *parent = nullptr);
+
+private:
+    QScopedPointer<AbstractDataSourcePrivate> d;
 };
 
 }
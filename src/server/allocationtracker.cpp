@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "allocationtracker.h"
+
+#include <cstddef>
+
+#ifdef DWAYLAND_ALLOCATION_TRACKING
+// the allocator of glibc, which the replacements forward to
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+}
+
+// the initial exec model does not allocate on the first access, unlike the dynamic model
+static thread_local __attribute__((tls_model("initial-exec"))) quint64 s_allocations = 0;
+static thread_local __attribute__((tls_model("initial-exec"))) quint64 s_allocatedBytes = 0;
+
+static inline void countAllocation(size_t size)
+{
+    ++s_allocations;
+    s_allocatedBytes += size;
+}
+
+extern "C" {
+Q_DECL_EXPORT void *malloc(size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+Q_DECL_EXPORT void *calloc(size_t count, size_t size) noexcept
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+Q_DECL_EXPORT void *realloc(void *pointer, size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+namespace KWaylandServer
+{
+namespace AllocationTracker
+{
+bool isAvailable()
+{
+#ifdef DWAYLAND_ALLOCATION_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+Counters counters()
+{
+    Counters counters;
+#ifdef DWAYLAND_ALLOCATION_TRACKING
+    counters.allocations = s_allocations;
+    counters.bytes = s_allocatedBytes;
+#endif
+    return counters;
+}
+
+} // namespace AllocationTracker
+} // namespace KWaylandServer
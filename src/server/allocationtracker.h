@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace KWaylandServer
+{
+/**
+ * Counts the heap allocations of each thread, if the server library is built with the
+ * DWAYLAND_ALLOCATION_TRACKING option.
+ *
+ * The tracking replaces malloc, calloc and realloc of the whole process, which forward to the
+ * allocator of glibc. Allocations with operator new are counted as well, as it is implemented
+ * with malloc. Without the option nothing is replaced and the counters stay at zero.
+ *
+ * The Display uses the counters to attribute the allocations to the dispatched requests, see
+ * ProtocolStatistics::Message::allocations.
+ */
+namespace AllocationTracker
+{
+struct Counters {
+    quint64 allocations = 0;
+    quint64 bytes = 0;
+};
+
+/**
+ * Returns whether the library has been built with the allocation tracking.
+ */
+bool isAvailable();
+/**
+ * Returns the allocations made by the calling thread so far.
+ */
+Counters counters();
+
+} // namespace AllocationTracker
+} // namespace KWaylandServer
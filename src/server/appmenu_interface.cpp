@@ -6,6 +6,8 @@
 #include "appmenu_interface.h"
 #include "display.h"
 #include "surface_interface.h"
+#include "surface_interface_p.h"
+#include "utils_p.h"
 
 #include <QtGlobal>
 
@@ -20,7 +22,8 @@ class AppMenuManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_appm
 public:
     AppMenuManagerInterfacePrivate(AppMenuManagerInterface *q, Display *d);
 
-    QVector<AppMenuInterface *> appmenus;
+    static wl_resource *resourceForAppMenu(AppMenuInterface *appMenu);
+
     AppMenuManagerInterface *q;
 
 protected:
@@ -40,11 +43,7 @@ void AppMenuManagerInterfacePrivate::org_kde_kwin_appmenu_manager_create(Resourc
         return;
     }
     auto appmenu = new AppMenuInterface(s, appmenu_resource);
-
-    appmenus.append(appmenu);
-    QObject::connect(appmenu, &QObject::destroyed, q, [=]() {
-        appmenus.removeOne(appmenu);
-    });
+    SurfaceInterfacePrivate::get(s)->appMenuExtension = appmenu;
     Q_EMIT q->appMenuCreated(appmenu);
 }
 
@@ -89,8 +88,8 @@ void AppMenuInterfacePrivate::org_kde_kwin_appmenu_set_address(Resource *resourc
         return;
     }
 
-    address.serviceName = service_name;
-    address.objectPath = object_path;
+    address.serviceName = StringPool::intern(service_name);
+    address.objectPath = StringPool::intern(object_path);
     Q_EMIT q->addressChanged(address);
 }
 
@@ -99,6 +98,16 @@ void AppMenuInterfacePrivate::org_kde_kwin_appmenu_release(QtWaylandServer::org_
     wl_resource_destroy(resource->handle);
 }
 
+wl_resource *AppMenuManagerInterfacePrivate::resourceForAppMenu(AppMenuInterface *appMenu)
+{
+    return appMenu->d->resource()->handle;
+}
+
+void addWeakHandleListener(AppMenuInterface *appMenu, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(AppMenuManagerInterfacePrivate::resourceForAppMenu(appMenu), listener);
+}
+
 AppMenuManagerInterface::AppMenuManagerInterface(Display *display, QObject *parent)
     : QObject(parent)
     , d(new AppMenuManagerInterfacePrivate(this, display))
@@ -111,12 +120,10 @@ AppMenuManagerInterface::~AppMenuManagerInterface()
 
 AppMenuInterface *AppMenuManagerInterface::appMenuForSurface(SurfaceInterface *surface)
 {
-    for (AppMenuInterface *menu : d->appmenus) {
-        if (menu->surface() == surface) {
-            return menu;
-        }
+    if (!surface) {
+        return nullptr;
     }
-    return nullptr;
+    return SurfaceInterfacePrivate::get(surface)->appMenuExtension;
 }
 
 AppMenuInterface::AppMenuInterface(SurfaceInterface *surface, wl_resource *resource)
@@ -21,6 +21,11 @@ class BlurManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_blur_ma
 public:
     BlurManagerInterfacePrivate(BlurManagerInterface *q, Display *d);
 
+    /**
+     * Returns the resource of @p blur, it is destroyed together with it.
+     */
+    static wl_resource *resourceForBlur(BlurInterface *blur);
+
     BlurManagerInterface *q;
 
 protected:
@@ -48,7 +53,7 @@ void BlurManagerInterfacePrivate::org_kde_kwin_blur_manager_unset(Resource *reso
         return;
     }
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->setBlur(QPointer<BlurInterface>());
+    surfacePrivate->setBlur(nullptr);
 }
 
 void BlurManagerInterfacePrivate::org_kde_kwin_blur_manager_create(Resource *resource, uint32_t id, wl_resource *surface)
@@ -133,6 +138,16 @@ BlurInterfacePrivate::BlurInterfacePrivate(BlurInterface *_q, wl_resource *resou
 {
 }
 
+wl_resource *BlurManagerInterfacePrivate::resourceForBlur(BlurInterface *blur)
+{
+    return blur->d->resource()->handle;
+}
+
+void addWeakHandleListener(BlurInterface *blur, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(BlurManagerInterfacePrivate::resourceForBlur(blur), listener);
+}
+
 BlurInterface::BlurInterface(wl_resource *resource)
     : QObject()
     , d(new BlurInterfacePrivate(this, resource))
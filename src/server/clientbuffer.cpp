@@ -6,11 +6,34 @@
 
 #include "clientbuffer.h"
 #include "clientbuffer_p.h"
+#include "display_p.h"
+#include "weakhandle.h"
 
 #include "qwayland-server-wayland.h"
 
 namespace KWaylandServer
 {
+void ClientBufferPrivate::sendRelease()
+{
+    releaseTime = std::chrono::steady_clock::now().time_since_epoch();
+    wl_buffer_send_release(resource);
+}
+
+static void scheduleRelease(ClientBuffer *buffer)
+{
+    ClientBufferPrivate *bufferPrivate = ClientBufferPrivate::get(buffer);
+    if (bufferPrivate->display) {
+        bufferPrivate->display->scheduleBufferRelease(buffer);
+    } else {
+        bufferPrivate->sendRelease();
+    }
+}
+
+void addWeakHandleListener(ClientBuffer *buffer, wl_listener *listener)
+{
+    wl_signal_add(&ClientBufferPrivate::get(buffer)->destroySignal, listener);
+}
+
 ClientBuffer::ClientBuffer(ClientBufferPrivate &dd)
     : d_ptr(&dd)
 {
@@ -50,6 +73,24 @@ bool ClientBuffer::isDestroyed() const
     return d->isDestroyed;
 }
 
+ClientBuffer::ReleasePolicy ClientBuffer::releasePolicy() const
+{
+    Q_D(const ClientBuffer);
+    return d->releasePolicy;
+}
+
+bool ClientBuffer::isReleased() const
+{
+    Q_D(const ClientBuffer);
+    return d->releasedEarly || !isReferenced();
+}
+
+std::chrono::nanoseconds ClientBuffer::releaseTime() const
+{
+    Q_D(const ClientBuffer);
+    return d->releaseTime;
+}
+
 void ClientBuffer::ref()
 {
     Q_D(ClientBuffer);
@@ -62,17 +103,31 @@ void ClientBuffer::unref()
     Q_ASSERT(d->refCount > 0);
     --d->refCount;
     if (!isReferenced()) {
+        d->signalReleasePoints();
         if (isDestroyed()) {
             delete this;
-        } else {
-            wl_buffer_send_release(d->resource);
+        } else if (!d->releasedEarly) {
+            scheduleRelease(this);
         }
     }
 }
 
+void ClientBuffer::markAsUploaded()
+{
+    Q_D(ClientBuffer);
+    if (d->releasePolicy != ReleasePolicy::ReleaseAfterUpload || !isReferenced() || d->releasedEarly || isDestroyed()) {
+        return;
+    }
+    d->releasedEarly = true;
+    scheduleRelease(this);
+}
+
 void ClientBuffer::markAsDestroyed()
 {
     Q_D(ClientBuffer);
+    if (d->releasePending) {
+        d->display->cancelBufferRelease(this);
+    }
     if (!isReferenced()) {
         delete this;
     } else {
@@ -81,4 +136,16 @@ void ClientBuffer::markAsDestroyed()
     }
 }
 
+void ClientBuffer::markAsAttached()
+{
+    Q_D(ClientBuffer);
+    // The client attached the buffer again. A release that hasn't been sent yet would tell it
+    // that the new contents have been consumed, so it's dropped, the buffer is released again
+    // once they have been uploaded.
+    if (d->releasePending) {
+        d->display->cancelBufferRelease(this);
+    }
+    d->releasedEarly = false;
+}
+
 } // namespace KWaylandServer
@@ -12,6 +12,8 @@
 
 #include <DWayland/Server/kwaylandserver_export.h>
 
+#include <chrono>
+
 struct wl_resource;
 
 namespace KWaylandServer
@@ -43,12 +45,57 @@ public:
         BottomLeft,
     };
 
+    /**
+     * This enum type is used to specify when the wl_buffer is released to the client.
+     */
+    enum class ReleasePolicy {
+        /**
+         * The buffer is released once it isn't referenced anymore, usually when the surface
+         * has a new buffer. The compositor can read the buffer until then.
+         */
+        HoldUntilUnreferenced,
+        /**
+         * The buffer is released as soon as markAsUploaded() is called, even though it is
+         * still referenced. Clients which draw into a single buffer don't have to wait for
+         * the next commit then and clients with a pool need fewer buffers.
+         */
+        ReleaseAfterUpload,
+    };
+
     bool isReferenced() const;
     bool isDestroyed() const;
 
     void ref();
     void unref();
 
+    /**
+     * Returns the release policy of the integration that created this buffer. Shared memory
+     * buffers are released after upload, others are held until they aren't referenced.
+     */
+    ReleasePolicy releasePolicy() const;
+
+    /**
+     * Tells that the compositor has copied the contents of the buffer, e.g. uploaded them to
+     * a texture, and doesn't need to read them again. With ReleasePolicy::ReleaseAfterUpload
+     * the wl_buffer is released on the next Display::flush(), otherwise nothing happens.
+     *
+     * @see isReleased
+     */
+    void markAsUploaded();
+
+    /**
+     * Returns @c true if the wl_buffer has been released or is about to be released, the client
+     * can draw into it again, so the contents must not be read anymore.
+     */
+    bool isReleased() const;
+
+    /**
+     * Returns the time on the steady clock when wl_buffer.release was sent the last time,
+     * or zero if the buffer has not been released yet. This is meant for diagnostics, e.g.
+     * to find out how long clients wait for their buffers.
+     */
+    std::chrono::nanoseconds releaseTime() const;
+
     /**
      * Returns the wl_resource for this ClientBuffer. If the buffer is destroyed, @c null
      * will be returned.
@@ -64,6 +111,7 @@ public:
     virtual Origin origin() const = 0;
 
     void markAsDestroyed(); ///< @internal
+    void markAsAttached(); ///< @internal
 
 protected:
     ClientBuffer(ClientBufferPrivate &dd);
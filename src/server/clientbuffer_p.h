@@ -7,19 +7,74 @@
 #pragma once
 
 #include "clientbuffer.h"
+#include "linuxdrmsyncobj_v1_interface_p.h"
+
+#include <QVector>
+
+#include <wayland-server-core.h>
 
 namespace KWaylandServer
 {
+class DisplayPrivate;
+
 class ClientBufferPrivate
 {
 public:
+    ClientBufferPrivate()
+    {
+        wl_list_init(&destroyListener.listener.link);
+        destroyListener.listener.notify = nullptr;
+        destroyListener.buffer = nullptr;
+        wl_signal_init(&destroySignal);
+    }
+
     virtual ~ClientBufferPrivate()
     {
+        signalReleasePoints();
+        wl_list_remove(&destroyListener.listener.link);
+        wl_signal_emit(&destroySignal, nullptr);
+    }
+
+    static ClientBufferPrivate *get(ClientBuffer *buffer)
+    {
+        return buffer->d_func();
+    }
+
+    void sendRelease();
+
+    void signalReleasePoints()
+    {
+        const QVector<LinuxDrmSyncObjPoint> points = std::exchange(releasePoints, {});
+        for (const LinuxDrmSyncObjPoint &point : points) {
+            point.timeline->signal(point.point);
+        }
     }
 
     int refCount = 0;
     wl_resource *resource = nullptr;
     bool isDestroyed = false;
+    // Set when the buffer is registered with a display, wl_buffer.release is then sent
+    // when the display is flushed rather than immediately.
+    DisplayPrivate *display = nullptr;
+    bool releasePending = false;
+    ClientBuffer::ReleasePolicy releasePolicy = ClientBuffer::ReleasePolicy::HoldUntilUnreferenced;
+    // Set when wl_buffer.release has been scheduled while the buffer is still referenced,
+    // the release must not be sent a second time when the last reference drops.
+    bool releasedEarly = false;
+    std::chrono::nanoseconds releaseTime = std::chrono::nanoseconds::zero();
+    // The explicit sync points of the commits that used the buffer, signalled once it is not
+    // referenced anymore.
+    QVector<LinuxDrmSyncObjPoint> releasePoints;
+
+    // Installed on the wl_buffer resource by the Display, the listener is used to find the
+    // buffer for the resource as well. It is kept in a standard layout struct, so that
+    // wl_container_of can be used on it.
+    struct DestroyListener {
+        wl_listener listener;
+        ClientBuffer *buffer;
+    } destroyListener;
+    // Emitted when the buffer gets destroyed, it resets the WeakHandles of the buffer.
+    wl_signal destroySignal;
 };
 
 } // namespace KWaylandServer
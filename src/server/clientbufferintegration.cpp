@@ -37,4 +37,9 @@ ClientBuffer *ClientBufferIntegration::createBuffer(wl_resource *resource)
     return nullptr;
 }
 
+ClientBuffer::ReleasePolicy ClientBufferIntegration::releasePolicy() const
+{
+    return ClientBuffer::ReleasePolicy::HoldUntilUnreferenced;
+}
+
 } // namespace KWaylandServer
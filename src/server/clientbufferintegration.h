@@ -26,6 +26,12 @@ public:
 
     virtual ClientBuffer *createBuffer(wl_resource *resource);
 
+    /**
+     * Returns when the buffers created by this integration are released to the clients. The
+     * default is ClientBuffer::ReleasePolicy::HoldUntilUnreferenced.
+     */
+    virtual ClientBuffer::ReleasePolicy releasePolicy() const;
+
 private:
     QPointer<Display> m_display;
 };
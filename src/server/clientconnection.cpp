@@ -4,71 +4,271 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "clientconnection.h"
+#include "clientconnection_p.h"
 #include "display.h"
+#include "display_p.h"
+#include "logging.h"
 #include "utils/executable_path.h"
 // Qt
 #include <QFileInfo>
-#include <QVector>
-// Wayland
-#include <wayland-server.h>
+// std
+#include <cstring>
+// system
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
 
 namespace KWaylandServer
 {
-class ClientConnectionPrivate
-{
-public:
-    ClientConnectionPrivate(wl_client *c, Display *display, ClientConnection *q);
-    ~ClientConnectionPrivate();
-
-    wl_client *client;
-    Display *display;
-    pid_t pid = 0;
-    uid_t user = 0;
-    gid_t group = 0;
-    QString executablePath;
-
-private:
-    static void destroyListenerCallback(wl_listener *listener, void *data);
-    ClientConnection *q;
-    wl_listener listener;
-    static QVector<ClientConnectionPrivate *> s_allClients;
-};
-
-QVector<ClientConnectionPrivate *> ClientConnectionPrivate::s_allClients;
-
 ClientConnectionPrivate::ClientConnectionPrivate(wl_client *c, Display *display, ClientConnection *q)
     : client(c)
     , display(display)
     , q(q)
 {
-    s_allClients << this;
-    listener.notify = destroyListenerCallback;
-    wl_client_add_destroy_listener(c, &listener);
+    destroyListener.listener.notify = destroyListenerCallback;
+    destroyListener.connection = this;
+    wl_client_add_destroy_listener(c, &destroyListener.listener);
     wl_client_get_credentials(client, &pid, &user, &group);
     executablePath = executablePathFromPid(pid);
+    resourceCreatedListener.listener.notify = resourceCreatedCallback;
+    resourceCreatedListener.connection = this;
+    wl_list_init(&resourceListeners);
+    if (DisplayPrivate::get(display)->resourceAccountingEnabled) {
+        startResourceAccounting();
+    }
 }
 
 ClientConnectionPrivate::~ClientConnectionPrivate()
 {
     if (client) {
-        wl_list_remove(&listener.link);
+        stopResourceAccounting();
+        wl_list_remove(&destroyListener.listener.link);
+    }
+}
+
+struct ClientConnectionPrivate::ResourceListener {
+    wl_listener listener;
+    wl_list link;
+    ClientConnectionPrivate *connection;
+    const char *interface;
+    qint32 shmPoolSize = 0;
+    bool dmaBuf = false;
+};
+
+void ClientConnectionPrivate::startResourceAccounting()
+{
+    if (resourceAccounting || !client) {
+        return;
+    }
+    resourceAccounting = true;
+    wl_client_add_resource_created_listener(client, &resourceCreatedListener.listener);
+    wl_client_for_each_resource(
+        client,
+        [](wl_resource *resource, void *data) {
+            static_cast<ClientConnectionPrivate *>(data)->accountResource(resource);
+            return WL_ITERATOR_CONTINUE;
+        },
+        this);
+}
+
+void ClientConnectionPrivate::stopResourceAccounting()
+{
+    if (!resourceAccounting) {
+        return;
     }
-    s_allClients.removeAt(s_allClients.indexOf(this));
+    resourceAccounting = false;
+    wl_list_remove(&resourceCreatedListener.listener.link);
+    ResourceListener *resourceListener;
+    ResourceListener *next;
+    wl_list_for_each_safe(resourceListener, next, &resourceListeners, link) {
+        wl_list_remove(&resourceListener->listener.link);
+        wl_list_remove(&resourceListener->link);
+        delete resourceListener;
+    }
+    resourceCounts.clear();
+    resourceCount = 0;
+    shmPoolBytes = 0;
+    dmaBufCount = 0;
+    pendingShmPoolSizes.clear();
+    resourceSoftLimitExceeded = false;
+    resourceHardLimitExceeded = false;
+}
+
+void ClientConnectionPrivate::resourceCreatedCallback(wl_listener *listener, void *data)
+{
+    ResourceCreatedListener *resourceCreatedListener = wl_container_of(listener, resourceCreatedListener, listener);
+    resourceCreatedListener->connection->accountResource(static_cast<wl_resource *>(data));
+}
+
+void ClientConnectionPrivate::resourceDestroyedCallback(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data)
+    ResourceListener *resourceListener = wl_container_of(listener, resourceListener, listener);
+    resourceListener->connection->unaccountResource(resourceListener);
+}
+
+void ClientConnectionPrivate::accountResource(wl_resource *resource)
+{
+    auto resourceListener = new ResourceListener;
+    resourceListener->listener.notify = resourceDestroyedCallback;
+    resourceListener->connection = this;
+    resourceListener->interface = wl_resource_get_class(resource);
+    wl_resource_add_destroy_listener(resource, &resourceListener->listener);
+    wl_list_insert(&resourceListeners, &resourceListener->link);
+
+    ++resourceCounts[resourceListener->interface];
+    ++resourceCount;
+    if (strcmp(resourceListener->interface, wl_shm_pool_interface.name) == 0) {
+        resourceListener->shmPoolSize = pendingShmPoolSizes.take(wl_resource_get_id(resource));
+        shmPoolBytes += resourceListener->shmPoolSize;
+    }
+    checkResourceLimits();
+}
+
+void ClientConnectionPrivate::unaccountResource(ResourceListener *resourceListener)
+{
+    wl_list_remove(&resourceListener->link);
+    auto it = resourceCounts.find(resourceListener->interface);
+    if (it != resourceCounts.end() && --(*it) == 0) {
+        resourceCounts.erase(it);
+    }
+    --resourceCount;
+    shmPoolBytes -= resourceListener->shmPoolSize;
+    if (resourceListener->dmaBuf) {
+        --dmaBufCount;
+    }
+    delete resourceListener;
+    checkResourceLimits();
+}
+
+void ClientConnectionPrivate::accountShmPoolRequest(const wl_protocol_logger_message *message)
+{
+    const char *interface = wl_resource_get_class(message->resource);
+    if (strcmp(interface, wl_shm_interface.name) == 0 && strcmp(message->message->name, "create_pool") == 0) {
+        pendingShmPoolSizes.insert(message->arguments[0].n, qMax(0, message->arguments[2].i));
+    } else if (strcmp(interface, wl_shm_pool_interface.name) == 0 && strcmp(message->message->name, "resize") == 0) {
+        wl_listener *listener = wl_resource_get_destroy_listener(message->resource, resourceDestroyedCallback);
+        if (!listener) {
+            return;
+        }
+        ResourceListener *resourceListener = wl_container_of(listener, resourceListener, listener);
+        // pools can only grow
+        const qint32 size = qMax(resourceListener->shmPoolSize, message->arguments[0].i);
+        shmPoolBytes += size - resourceListener->shmPoolSize;
+        resourceListener->shmPoolSize = size;
+        checkResourceLimits();
+    }
+}
+
+void ClientConnectionPrivate::accountDmaBuf(wl_resource *resource)
+{
+    wl_listener *listener = wl_resource_get_destroy_listener(resource, resourceDestroyedCallback);
+    if (!listener) {
+        return;
+    }
+    ResourceListener *resourceListener = wl_container_of(listener, resourceListener, listener);
+    if (!resourceListener->dmaBuf) {
+        resourceListener->dmaBuf = true;
+        ++dmaBufCount;
+    }
+}
+
+void ClientConnectionPrivate::checkResourceLimits()
+{
+    if (!client) {
+        // the resources are destroyed after the client
+        return;
+    }
+    const ClientResourceLimits &limits = DisplayPrivate::get(display)->clientResourceLimits;
+    const auto exceeds = [](quint64 value, quint64 limit) {
+        return limit != 0 && value > limit;
+    };
+    if (exceeds(resourceCount, limits.hardResourceCount) || exceeds(shmPoolBytes, limits.hardShmPoolBytes)) {
+        if (!resourceHardLimitExceeded) {
+            resourceHardLimitExceeded = true;
+            qCWarning(KWAYLAND_SERVER) << "Disconnecting" << executablePath << "for exceeding the resource limits with" << resourceCount
+                                       << "resources and" << shmPoolBytes << "bytes of shm pools";
+            wl_client_post_no_memory(client);
+        }
+        return;
+    }
+    const bool softLimitExceeded = exceeds(resourceCount, limits.softResourceCount) || exceeds(shmPoolBytes, limits.softShmPoolBytes);
+    if (softLimitExceeded && !resourceSoftLimitExceeded) {
+        resourceSoftLimitExceeded = true;
+        Q_EMIT q->resourceLimitExceeded();
+    } else if (!softLimitExceeded) {
+        resourceSoftLimitExceeded = false;
+    }
+}
+
+void ClientConnectionPrivate::updateCongestion(quint32 threshold)
+{
+    if (!client) {
+        return;
+    }
+    if (threshold == 0) {
+        queuedBytes = 0;
+        setCongested(false);
+        return;
+    }
+    int bytes = 0;
+    if (ioctl(wl_client_get_fd(client), SIOCOUTQ, &bytes) < 0) {
+        return;
+    }
+    queuedBytes = quint32(qMax(bytes, 0));
+    if (!congested && queuedBytes > threshold) {
+        qCDebug(KWAYLAND_SERVER) << executablePath << "is congested with" << queuedBytes << "queued bytes";
+        setCongested(true);
+    } else if (congested && queuedBytes <= threshold / 2) {
+        setCongested(false);
+    }
+}
+
+void ClientConnectionPrivate::setCongested(bool set)
+{
+    if (congested == set) {
+        return;
+    }
+    congested = set;
+    auto displayPrivate = DisplayPrivate::get(display);
+    if (set) {
+        displayPrivate->congestedClients.append(q);
+        Q_EMIT q->congested();
+    } else {
+        displayPrivate->congestedClients.removeOne(q);
+        Q_EMIT q->congestionRelieved();
+    }
+    displayPrivate->updateCongestionTimer();
+}
+
+ClientConnection *ClientConnectionPrivate::get(wl_client *client)
+{
+    wl_listener *listener = wl_client_get_destroy_listener(client, destroyListenerCallback);
+    if (!listener) {
+        return nullptr;
+    }
+    DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+    return destroyListener->connection->q;
+}
+
+ClientConnectionPrivate *ClientConnectionPrivate::get(ClientConnection *connection)
+{
+    return connection->d.data();
 }
 
 void ClientConnectionPrivate::destroyListenerCallback(wl_listener *listener, void *data)
 {
-    Q_UNUSED(listener)
-    wl_client *client = reinterpret_cast<wl_client *>(data);
-    auto it = std::find_if(s_allClients.constBegin(), s_allClients.constEnd(), [client](ClientConnectionPrivate *c) {
-        return c->client == client;
-    });
-    Q_ASSERT(it != s_allClients.constEnd());
-    auto p = (*it);
+    Q_UNUSED(data)
+    DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+    auto p = destroyListener->connection;
     auto q = p->q;
     Q_EMIT q->aboutToBeDestroyed();
+    if (p->congested) {
+        auto displayPrivate = DisplayPrivate::get(p->display);
+        displayPrivate->congestedClients.removeOne(q);
+        displayPrivate->updateCongestionTimer();
+    }
     p->client = nullptr;
-    wl_list_remove(&p->listener.link);
+    wl_list_remove(&p->destroyListener.listener.link);
     Q_EMIT q->disconnected(q);
     q->deleteLater();
 }
@@ -145,4 +345,54 @@ QString ClientConnection::executablePath() const
     return d->executablePath;
 }
 
+std::chrono::nanoseconds ClientConnection::dispatchTime() const
+{
+    return d->dispatchTime;
+}
+
+quint64 ClientConnection::dispatchedRequests() const
+{
+    return d->dispatchedRequests;
+}
+
+quint64 ClientConnection::bytesSent() const
+{
+    return d->bytesSent;
+}
+
+QHash<QByteArray, quint32> ClientConnection::resourceCounts() const
+{
+    QHash<QByteArray, quint32> counts;
+    counts.reserve(d->resourceCounts.count());
+    for (auto it = d->resourceCounts.constBegin(); it != d->resourceCounts.constEnd(); ++it) {
+        counts[QByteArray(it.key())] += it.value();
+    }
+    return counts;
+}
+
+quint32 ClientConnection::resourceCount() const
+{
+    return d->resourceCount;
+}
+
+quint64 ClientConnection::shmPoolBytes() const
+{
+    return d->shmPoolBytes;
+}
+
+quint32 ClientConnection::dmaBufCount() const
+{
+    return d->dmaBufCount;
+}
+
+bool ClientConnection::isCongested() const
+{
+    return d->congested;
+}
+
+quint32 ClientConnection::queuedBytes() const
+{
+    return d->queuedBytes;
+}
+
 }
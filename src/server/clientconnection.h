@@ -7,8 +7,11 @@
 
 #include <sys/types.h>
 
+#include <QHash>
 #include <QObject>
 
+#include <chrono>
+
 #include <DWayland/Server/kwaylandserver_export.h>
 
 struct wl_client;
@@ -92,6 +95,84 @@ public:
      */
     QString executablePath() const;
 
+    /**
+     * The time spent in the request handlers of this client.
+     *
+     * The time is only accounted while a dispatch budget is set on the Display. It is measured
+     * from one request to the next, so it also contains the time libwayland needs to read and
+     * demarshal the requests.
+     *
+     * @see Display::setClientDispatchBudget
+     * @see dispatchedRequests
+     */
+    std::chrono::nanoseconds dispatchTime() const;
+    /**
+     * The number of requests of this client that have been dispatched while a dispatch budget
+     * is set on the Display.
+     *
+     * @see Display::setClientDispatchBudget
+     * @see dispatchTime
+     */
+    quint64 dispatchedRequests() const;
+    /**
+     * The number of bytes of the events sent to this client while the protocol statistics
+     * of the Display are enabled. File descriptors passed along are not included.
+     *
+     * @see Display::setProtocolStatisticsEnabled
+     */
+    quint64 bytesSent() const;
+    /**
+     * The live resources of this client by the name of their interface, e.g. @c wl_region
+     * or @c wl_callback for the pending frame callbacks.
+     *
+     * The resources are only counted while the resource accounting of the Display is enabled.
+     *
+     * @see Display::setResourceAccountingEnabled
+     * @see resourceCount
+     */
+    QHash<QByteArray, quint32> resourceCounts() const;
+    /**
+     * The number of live resources of this client, of all interfaces.
+     *
+     * @see Display::setResourceAccountingEnabled
+     */
+    quint32 resourceCount() const;
+    /**
+     * The size in bytes of the wl_shm_pools of this client. A pool is counted until its
+     * resource is destroyed, libwayland may keep it mapped longer for the buffers created
+     * from it.
+     *
+     * @see Display::setResourceAccountingEnabled
+     */
+    quint64 shmPoolBytes() const;
+    /**
+     * The number of wl_buffers of this client created from dma-bufs.
+     *
+     * @see Display::setResourceAccountingEnabled
+     */
+    quint32 dmaBufCount() const;
+    /**
+     * Whether the client stopped reading its events. A client is congested once more events
+     * are queued on its socket than the congestion threshold of the Display allows, and is
+     * relieved once the queue went below half of the threshold.
+     *
+     * While a client is congested, events which only carry the latest state, e.g. pointer
+     * motion or the geometry of plasma windows, are held back and the latest state is sent
+     * once the client is relieved.
+     *
+     * @see Display::setClientCongestionThreshold
+     * @see queuedBytes
+     */
+    bool isCongested() const;
+    /**
+     * The number of bytes queued on the socket of this client that it did not read yet, as
+     * measured by the kernel when the Display was last flushed. It includes the overhead of
+     * the socket buffers and is only measured while a congestion threshold is set.
+     *
+     * @see Display::setClientCongestionThreshold
+     */
+    quint32 queuedBytes() const;
+
     /**
      * Cast operator the native wl_client this ClientConnection represents.
      */
@@ -118,9 +199,39 @@ Q_SIGNALS:
      * Signal emitted when the ClientConnection got disconnected from the server.
      */
     void disconnected(KWaylandServer::ClientConnection *);
+    /**
+     * Emitted after a dispatch of the event loop in which the requests of this client took
+     * longer than the dispatch budget of the Display.
+     *
+     * @see Display::setClientDispatchBudget
+     */
+    void dispatchBudgetExceeded();
+    /**
+     * Emitted when the resources of this client exceed one of the soft limits of the Display.
+     * It is emitted again once the client went below the limits and exceeds them again.
+     *
+     * The signal is emitted while a resource is created, so the client must not be destroyed
+     * from a directly connected slot.
+     *
+     * @see Display::setClientResourceLimits
+     */
+    void resourceLimitExceeded();
+    /**
+     * Emitted when the client became congested.
+     *
+     * @see isCongested
+     */
+    void congested();
+    /**
+     * Emitted when the client is no longer congested.
+     *
+     * @see isCongested
+     */
+    void congestionRelieved();
 
 private:
     friend class Display;
+    friend class ClientConnectionPrivate;
     explicit ClientConnection(wl_client *c, Display *parent);
     QScopedPointer<ClientConnectionPrivate> d;
 };
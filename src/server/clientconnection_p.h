@@ -0,0 +1,106 @@
+/*
+    SPDX-FileCopyrightText: 2014 Martin Gräßlin <mgraesslin@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include "clientconnection.h"
+// Qt
+#include <QHash>
+// Wayland
+#include <wayland-server.h>
+
+namespace KWaylandServer
+{
+class ClientConnectionPrivate
+{
+public:
+    ClientConnectionPrivate(wl_client *c, Display *display, ClientConnection *q);
+    ~ClientConnectionPrivate();
+
+    /**
+     * Returns the ClientConnection created for the @p client, or @c null if there is none.
+     * The connection is found through the destroy listener it installs on the client, so no
+     * list of connections has to be searched.
+     **/
+    static ClientConnection *get(wl_client *client);
+    static ClientConnectionPrivate *get(ClientConnection *connection);
+
+    wl_client *client;
+    Display *display;
+    pid_t pid = 0;
+    uid_t user = 0;
+    gid_t group = 0;
+    QString executablePath;
+
+    std::chrono::nanoseconds dispatchTime = std::chrono::nanoseconds::zero();
+    // the part of dispatchTime spent in the current dispatch of the event loop
+    std::chrono::nanoseconds cycleDispatchTime = std::chrono::nanoseconds::zero();
+    quint64 dispatchedRequests = 0;
+    // whether the client is in the dirty clients of the Display
+    bool flushPending = false;
+    quint64 bytesSent = 0;
+
+    /**
+     * Starts counting the resources of the client, the existing ones included.
+     * @see Display::setResourceAccountingEnabled
+     **/
+    void startResourceAccounting();
+    void stopResourceAccounting();
+    /**
+     * Picks up the sizes of the shm pools from wl_shm.create_pool and wl_shm_pool.resize,
+     * called by the protocol logger of the Display before the request is dispatched.
+     **/
+    void accountShmPoolRequest(const wl_protocol_logger_message *message);
+    /**
+     * Marks the wl_buffer @p resource as a dma-buf.
+     **/
+    void accountDmaBuf(wl_resource *resource);
+
+    bool resourceAccounting = false;
+    // the live resources by the name of their interface
+    QHash<const char *, quint32> resourceCounts;
+    quint32 resourceCount = 0;
+    quint64 shmPoolBytes = 0;
+    quint32 dmaBufCount = 0;
+    // the sizes of the pools that are about to be created, by their new id
+    QHash<quint32, qint32> pendingShmPoolSizes;
+    bool resourceSoftLimitExceeded = false;
+    bool resourceHardLimitExceeded = false;
+
+    /**
+     * Measures the bytes queued on the socket and updates the congestion state, @p threshold
+     * of @c 0 relieves the client.
+     * @see Display::setClientCongestionThreshold
+     **/
+    void updateCongestion(quint32 threshold);
+
+    quint32 queuedBytes = 0;
+    bool congested = false;
+
+private:
+    struct ResourceListener;
+    static void destroyListenerCallback(wl_listener *listener, void *data);
+    static void resourceCreatedCallback(wl_listener *listener, void *data);
+    static void resourceDestroyedCallback(wl_listener *listener, void *data);
+    void accountResource(wl_resource *resource);
+    void unaccountResource(ResourceListener *resourceListener);
+    void checkResourceLimits();
+    void setCongested(bool set);
+
+    ClientConnection *q;
+    // Kept in a standard layout struct, so wl_container_of can be used on the listener.
+    struct DestroyListener {
+        wl_listener listener;
+        ClientConnectionPrivate *connection;
+    } destroyListener;
+    struct ResourceCreatedListener {
+        wl_listener listener;
+        ClientConnectionPrivate *connection;
+    } resourceCreatedListener;
+    // the ResourceListeners of the accounted resources
+    wl_list resourceListeners;
+};
+
+} // namespace KWaylandServer
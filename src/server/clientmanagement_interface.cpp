@@ -13,12 +13,48 @@
 #include <qwayland-server-wayland.h>
 #include "qwayland-server-com-deepin-client-management.h"
 
-#define MAX_WINDOWS 100
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
 
 namespace KWaylandServer
 {
 
 static const quint32 s_version = 1;
+// the sizes of thumbnails kept per surface, e.g. a dock and a task switcher
+static const int s_maxThumbnailsPerSurface = 4;
+// the size of a wayland message is a 16 bit field, the message header, the count and the length
+// of the array take 16 bytes of it
+static const int s_maxWindowStates = (0xffff - 16) / sizeof(ClientManagementInterface::WindowState);
+
+// compares the fields, the padding and the bytes after the terminator of the strings don't matter
+static bool sameWindowState(const ClientManagementInterface::WindowState &a, const ClientManagementInterface::WindowState &b)
+{
+    return a.pid == b.pid && a.windowId == b.windowId && qstrncmp(a.resourceName, b.resourceName, sizeof(a.resourceName)) == 0
+        && a.geometry.x == b.geometry.x && a.geometry.y == b.geometry.y && a.geometry.width == b.geometry.width
+        && a.geometry.height == b.geometry.height && a.isMinimized == b.isMinimized && a.isFullScreen == b.isFullScreen
+        && a.isActive == b.isActive && a.splitable == b.splitable && qstrncmp(a.uuid, b.uuid, sizeof(a.uuid)) == 0;
+}
+
+// copies the fields into a zeroed state, so no uninitialized memory of the compositor goes on the wire
+static void copyWindowState(ClientManagementInterface::WindowState *to, const ClientManagementInterface::WindowState &from)
+{
+    memset(to, 0, sizeof(*to));
+    to->pid = from.pid;
+    to->windowId = from.windowId;
+    qstrncpy(to->resourceName, from.resourceName, sizeof(to->resourceName));
+    to->geometry = from.geometry;
+    to->isMinimized = from.isMinimized;
+    to->isFullScreen = from.isFullScreen;
+    to->isActive = from.isActive;
+    to->splitable = from.splitable;
+    qstrncpy(to->uuid, from.uuid, sizeof(to->uuid));
+}
 
 class ClientManagementInterfacePrivate: public QtWaylandServer::com_deepin_client_management
 {
@@ -26,19 +62,61 @@ public:
 
     ClientManagementInterfacePrivate(ClientManagementInterface *q, Display *d);
     ClientManagementInterface *q;
+    Display *display;
 
     void updateWindowStates();
     void getWindowStates();
     void captureWindowImage(int windowId, wl_resource *buffer);
+    void fillWindowStates(wl_array *data) const;
     void sendWindowStates(wl_resource *resource);
+    void sendPendingWindowStates();
     void sendWindowCaption(int windowId, bool succeed, wl_resource *buffer);
     void sendSplitChange(const QString& uuid, int splitable);
     void splitWindow(QString uuid, int splitType);
-
-    ClientManagementInterface::WindowState m_windowStates[MAX_WINDOWS];
-    uint32_t m_windowCount;
+    bool copyWindowImage(SurfaceInterface *surface, ShmClientBuffer *source, wl_resource *buffer);
+    const QImage *thumbnail(SurfaceInterface *surface, ShmClientBuffer *source, const QSize &size, QImage::Format format);
+    bool copyThumbnail(const QImage &thumbnail, wl_shm_buffer *buffer);
+
+    QVector<ClientManagementInterface::WindowState> m_windowStates;
+    // the resources which asked for the window states, they get them even if nothing changed
+    QSet<wl_resource *> m_pendingStateRequests;
+
+    /**
+     * The surface whose image a capture buffer of a client holds and the buffer damage of the
+     * surface since then. Capturing the same surface into the same buffer again only copies
+     * the damaged parts.
+     **/
+    struct Capture {
+        QPointer<SurfaceInterface> surface;
+        QSize size;
+        QRegion damage;
+        QMetaObject::Connection damageConnection;
+    };
+    QHash<ClientBuffer *, Capture> m_captures;
+
+    /**
+     * A scaled down image of a surface, shared by all captures with the same buffer size. It is
+     * marked dirty when the surface gets damaged and only scaled again once the refresh
+     * interval passed.
+     **/
+    struct Thumbnail {
+        QSize size;
+        QImage::Format format;
+        QImage image;
+        bool dirty = true;
+        std::chrono::steady_clock::time_point updated;
+    };
+    struct ThumbnailSource {
+        // the least recently used thumbnail comes first
+        QVector<Thumbnail> thumbnails;
+        QMetaObject::Connection damageConnection;
+        QMetaObject::Connection destroyConnection;
+    };
+    QHash<SurfaceInterface *, ThumbnailSource> m_thumbnails;
+    std::chrono::milliseconds m_thumbnailRefreshInterval = std::chrono::milliseconds(200);
 
 protected:
+    void com_deepin_client_management_destroy_resource(Resource *resource) override;
     void com_deepin_client_management_get_window_states(Resource *resource) override;
     void com_deepin_client_management_capture_window_image(Resource *resource,
         int32_t window_id, struct ::wl_resource *buffer) override;
@@ -52,13 +130,18 @@ private:
 ClientManagementInterfacePrivate::ClientManagementInterfacePrivate(ClientManagementInterface *q, Display *d)
     : QtWaylandServer::com_deepin_client_management(*d, s_version)
     , q(q)
+    , display(d)
 {
 }
 
-void ClientManagementInterfacePrivate::com_deepin_client_management_get_window_states(Resource *resource)
+void ClientManagementInterfacePrivate::com_deepin_client_management_destroy_resource(Resource *resource)
 {
-    Q_UNUSED(resource);
+    m_pendingStateRequests.remove(resource->handle);
+}
 
+void ClientManagementInterfacePrivate::com_deepin_client_management_get_window_states(Resource *resource)
+{
+    m_pendingStateRequests.insert(resource->handle);
     getWindowStates();
 }
 
@@ -92,26 +175,225 @@ void ClientManagementInterfacePrivate::splitWindow(QString uuid, int splitType)
     Q_EMIT q->splitWindowRequest(uuid, splitType);
 }
 
+void ClientManagementInterfacePrivate::fillWindowStates(wl_array *data) const
+{
+    // libwayland copies the array into the event, so it can point at the states directly
+    data->size = sizeof(struct ClientManagementInterface::WindowState) * m_windowStates.count();
+    data->alloc = data->size;
+    data->data = const_cast<ClientManagementInterface::WindowState *>(m_windowStates.constData());
+}
+
 void ClientManagementInterfacePrivate::sendWindowStates(wl_resource *resource)
 {
     struct wl_array data;
-    auto fillArray = [this](const ClientManagementInterface::WindowState *origin, wl_array *dest) {
-        wl_array_init(dest);
-        const size_t memLength = sizeof(struct ClientManagementInterface::WindowState) * m_windowCount;
-        void *s = wl_array_add(dest, memLength);
-        memcpy(s, origin, memLength);
-    };
-    fillArray(m_windowStates, &data);
-    com_deepin_client_management_send_window_states(resource, m_windowCount, &data);
-    wl_array_release(&data);
+    fillWindowStates(&data);
+    com_deepin_client_management_send_window_states(resource, m_windowStates.count(), &data);
+}
+
+void ClientManagementInterfacePrivate::sendPendingWindowStates()
+{
+    if (m_pendingStateRequests.isEmpty()) {
+        return;
+    }
+    struct wl_array data;
+    fillWindowStates(&data);
+    for (wl_resource *resource : qAsConst(m_pendingStateRequests)) {
+        com_deepin_client_management_send_window_states(resource, m_windowStates.count(), &data);
+    }
+    m_pendingStateRequests.clear();
 }
 
 void ClientManagementInterfacePrivate::updateWindowStates()
 {
+    m_pendingStateRequests.clear();
     const auto clientResources = resourceMap();
+    if (clientResources.isEmpty()) {
+        return;
+    }
+    struct wl_array data;
+    fillWindowStates(&data);
     for (Resource *resource : clientResources) {
-        sendWindowStates(resource->handle);
+        com_deepin_client_management_send_window_states(resource->handle, m_windowStates.count(), &data);
+    }
+}
+
+bool ClientManagementInterfacePrivate::copyWindowImage(SurfaceInterface *surface, ShmClientBuffer *source, wl_resource *buffer)
+{
+    wl_shm_buffer *shmBuffer = wl_shm_buffer_get(buffer);
+    if (!shmBuffer) {
+        return false;
+    }
+    const int stride = wl_shm_buffer_get_stride(shmBuffer);
+    const int height = wl_shm_buffer_get_height(shmBuffer);
+
+    // libwayland guards the access to one shm pool per thread, so the pixels to copy are taken
+    // out of the surface buffer before its access ends and the one of the target begins
+    struct Pixels {
+        QRect rect; // null for the whole image
+        QByteArray bits;
+    };
+    QVector<Pixels> pixels;
+    QSize size;
+    int bytesPerPixel = 0;
+    ClientBuffer *target = nullptr;
+    auto it = m_captures.end();
+    {
+        const QImage image = source->data();
+        if (image.isNull() || image.sizeInBytes() > qsizetype(stride) * height) {
+            return false;
+        }
+        size = image.size();
+        bytesPerPixel = image.depth() / 8;
+        const bool sameLayout = wl_shm_buffer_get_width(shmBuffer) == image.width() && height == image.height() && stride == image.bytesPerLine();
+        target = sameLayout ? display->clientBufferForResource(buffer) : nullptr;
+        it = target ? m_captures.find(target) : m_captures.end();
+        if (it != m_captures.end() && it->surface == surface && it->size == size) {
+            // the buffer still holds the last capture of the surface
+            const auto rects = source->damagedRects(image, it->damage);
+            pixels.reserve(rects.count());
+            for (const ShmClientBuffer::DamagedRect &rect : rects) {
+                const int length = rect.rect.width() * bytesPerPixel;
+                QByteArray bits(length * rect.rect.height(), Qt::Uninitialized);
+                for (int row = 0; row < rect.rect.height(); ++row) {
+                    memcpy(bits.data() + row * length, rect.bits + row * rect.stride, length);
+                }
+                pixels.append(Pixels{rect.rect, bits});
+            }
+        } else {
+            pixels.append(Pixels{QRect(), QByteArray(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes())});
+        }
+    }
+
+    // the client might truncate the pool of the buffer, which would raise SIGBUS while writing
+    wl_shm_buffer_begin_access(shmBuffer);
+    uchar *data = static_cast<uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    if (data) {
+        for (const Pixels &piece : qAsConst(pixels)) {
+            if (piece.rect.isNull()) {
+                memcpy(data, piece.bits.constData(), piece.bits.size());
+                continue;
+            }
+            const int length = piece.rect.width() * bytesPerPixel;
+            uchar *destination = data + piece.rect.y() * stride + piece.rect.x() * bytesPerPixel;
+            for (int row = 0; row < piece.rect.height(); ++row) {
+                memcpy(destination, piece.bits.constData() + row * length, length);
+                destination += stride;
+            }
+        }
+    }
+    wl_shm_buffer_end_access(shmBuffer);
+    if (!data) {
+        return false;
     }
+    if (!target) {
+        return true;
+    }
+
+    if (it == m_captures.end()) {
+        it = m_captures.insert(target, Capture());
+        QObject::connect(target, &QObject::destroyed, q, [this, target] {
+            auto capture = m_captures.find(target);
+            if (capture != m_captures.end()) {
+                QObject::disconnect(capture->damageConnection);
+                m_captures.erase(capture);
+            }
+        });
+    }
+    if (it->surface != surface) {
+        QObject::disconnect(it->damageConnection);
+        it->surface = surface;
+        it->damageConnection = QObject::connect(surface, &SurfaceInterface::damaged, q, [this, target, surface] {
+            auto capture = m_captures.find(target);
+            if (capture != m_captures.end()) {
+                capture->damage |= surface->bufferDamage();
+            }
+        });
+    }
+    it->size = size;
+    it->damage = QRegion();
+    return true;
+}
+
+const QImage *ClientManagementInterfacePrivate::thumbnail(SurfaceInterface *surface, ShmClientBuffer *source, const QSize &size, QImage::Format format)
+{
+    auto it = m_thumbnails.find(surface);
+    if (it == m_thumbnails.end()) {
+        it = m_thumbnails.insert(surface, ThumbnailSource());
+        it->damageConnection = QObject::connect(surface, &SurfaceInterface::damaged, q, [this, surface] {
+            auto source = m_thumbnails.find(surface);
+            if (source != m_thumbnails.end()) {
+                for (Thumbnail &thumbnail : source->thumbnails) {
+                    thumbnail.dirty = true;
+                }
+            }
+        });
+        it->destroyConnection = QObject::connect(surface, &QObject::destroyed, q, [this, surface] {
+            auto source = m_thumbnails.find(surface);
+            if (source != m_thumbnails.end()) {
+                QObject::disconnect(source->damageConnection);
+                QObject::disconnect(source->destroyConnection);
+                m_thumbnails.erase(source);
+            }
+        });
+    }
+
+    auto thumbnail = std::find_if(it->thumbnails.begin(), it->thumbnails.end(), [&size, format](const Thumbnail &thumbnail) {
+        return thumbnail.size == size && thumbnail.format == format;
+    });
+    if (thumbnail == it->thumbnails.end()) {
+        // clients asking for ever new sizes must not grow the cache without bounds
+        if (it->thumbnails.count() >= s_maxThumbnailsPerSurface) {
+            it->thumbnails.removeFirst();
+        }
+        Thumbnail created;
+        created.size = size;
+        created.format = format;
+        it->thumbnails.append(created);
+    } else if (thumbnail != it->thumbnails.end() - 1) {
+        std::rotate(thumbnail, thumbnail + 1, it->thumbnails.end());
+    }
+    thumbnail = it->thumbnails.end() - 1;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (thumbnail->image.isNull() || (thumbnail->dirty && now - thumbnail->updated >= m_thumbnailRefreshInterval)) {
+        const QImage image = source->data();
+        if (image.isNull()) {
+            return thumbnail->image.isNull() ? nullptr : &thumbnail->image;
+        }
+        // 32 bit images come in several layouts, the pixels are copied as they are into the buffer
+        thumbnail->image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation).convertToFormat(format);
+        thumbnail->dirty = false;
+        thumbnail->updated = now;
+    }
+    return &thumbnail->image;
+}
+
+bool ClientManagementInterfacePrivate::copyThumbnail(const QImage &thumbnail, wl_shm_buffer *buffer)
+{
+    const int width = wl_shm_buffer_get_width(buffer);
+    const int height = wl_shm_buffer_get_height(buffer);
+    const int stride = wl_shm_buffer_get_stride(buffer);
+    if (thumbnail.width() > width || thumbnail.height() > height) {
+        return false;
+    }
+
+    wl_shm_buffer_begin_access(buffer);
+    uchar *data = static_cast<uchar *>(wl_shm_buffer_get_data(buffer));
+    if (data) {
+        // the thumbnail keeps the aspect ratio, the rest of the buffer is left transparent
+        const int length = thumbnail.width() * 4;
+        for (int row = 0; row < height; ++row) {
+            uchar *line = data + row * stride;
+            if (row < thumbnail.height()) {
+                memcpy(line, thumbnail.constScanLine(row), length);
+                memset(line + length, 0, width * 4 - length);
+            } else {
+                memset(line, 0, width * 4);
+            }
+        }
+    }
+    wl_shm_buffer_end_access(buffer);
+    return data != nullptr;
 }
 
 void ClientManagementInterfacePrivate::sendWindowCaption(int windowId, bool succeed, wl_resource *buffer)
@@ -154,14 +436,27 @@ ClientManagementInterface *ClientManagementInterface::get(wl_resource* native)
 
 void ClientManagementInterface::setWindowStates(QList<WindowState*> &windowStates)
 {
-    int i = 0;
-    for (auto it = windowStates.begin();
-        it != windowStates.end() && i < MAX_WINDOWS;
-        ++it) {
-        memcpy(&d->m_windowStates[i++], *it, sizeof(WindowState));
-        d->m_windowCount = i;
+    // all states go out in a single event, the windows beyond what fits into it are dropped
+    const int count = qMin(windowStates.count(), s_maxWindowStates);
+    if (count < windowStates.count()) {
+        qCWarning(KWAYLAND_SERVER) << "Sending only" << count << "of" << windowStates.count() << "window states";
+    }
+    bool changed = count != d->m_windowStates.count();
+    d->m_windowStates.resize(count);
+    // only the entries which changed are copied, most updates touch a single window
+    WindowState *states = d->m_windowStates.data();
+    for (int i = 0; i < count; ++i) {
+        if (!sameWindowState(states[i], *windowStates.at(i))) {
+            copyWindowState(&states[i], *windowStates.at(i));
+            changed = true;
+        }
+    }
+    if (changed) {
+        Q_EMIT windowStatesChanged();
+    } else {
+        // nothing to tell the others, but the clients which asked still need an answer
+        d->sendPendingWindowStates();
     }
-    Q_EMIT windowStatesChanged();
 }
 
 void ClientManagementInterface::sendWindowCaptionImage(int windowId, wl_resource *buffer, QImage image)
@@ -193,20 +488,53 @@ void ClientManagementInterface::sendWindowCaption(int windowId, wl_resource *buf
         return;
     }
 
+    // a buffer too small for the whole window asks for a preview
+    if (wl_shm_buffer *target = wl_shm_buffer_get(buffer)) {
+        if (wl_shm_buffer_get_width(target) < shmClient->size().width() || wl_shm_buffer_get_height(target) < shmClient->size().height()) {
+            sendWindowThumbnail(windowId, buffer, surface);
+            return;
+        }
+    }
+
+    const bool succeed = d->copyWindowImage(surface, shmClient, buffer);
+    d->sendWindowCaption(windowId, succeed, buffer);
+}
+
+void ClientManagementInterface::sendWindowThumbnail(int windowId, wl_resource *buffer, SurfaceInterface *surface)
+{
     bool succeed = false;
-    wl_shm_buffer *shm_buffer = wl_shm_buffer_get(buffer);
-    if (shm_buffer) {
-        QImage image = shmClient->data();
-        void *data = wl_shm_buffer_get_data(shm_buffer);
-        if (!image.isNull())
-        {
-            memcpy(data, image.bits(), image.sizeInBytes());
-            succeed = true;
+    auto source = surface ? qobject_cast<ShmClientBuffer *>(surface->buffer()) : nullptr;
+    wl_shm_buffer *target = wl_shm_buffer_get(buffer);
+    if (source && target) {
+        const QSize size(wl_shm_buffer_get_width(target), wl_shm_buffer_get_height(target));
+        const QImage *thumbnail = nullptr;
+        switch (wl_shm_buffer_get_format(target)) {
+        case WL_SHM_FORMAT_ARGB8888:
+            thumbnail = d->thumbnail(surface, source, size, QImage::Format_ARGB32_Premultiplied);
+            break;
+        case WL_SHM_FORMAT_XRGB8888:
+            thumbnail = d->thumbnail(surface, source, size, QImage::Format_RGB32);
+            break;
+        default:
+            break;
+        }
+        if (thumbnail) {
+            succeed = d->copyThumbnail(*thumbnail, target);
         }
     }
     d->sendWindowCaption(windowId, succeed, buffer);
 }
 
+void ClientManagementInterface::setThumbnailRefreshInterval(std::chrono::milliseconds interval)
+{
+    d->m_thumbnailRefreshInterval = interval;
+}
+
+std::chrono::milliseconds ClientManagementInterface::thumbnailRefreshInterval() const
+{
+    return d->m_thumbnailRefreshInterval;
+}
+
 void ClientManagementInterface::sendSplitChange(const QString& uuid, int splitable)
 {
     d->sendSplitChange(uuid, splitable);
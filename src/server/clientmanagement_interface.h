@@ -12,6 +12,8 @@
 #include <QVector>
 #include <QImage>
 
+#include <chrono>
+
 #include "surface_interface.h"
 #include <DWayland/Server/kwaylandserver_export.h>
 
@@ -55,10 +57,35 @@ public:
     };
 
     static ClientManagementInterface *get(wl_resource *native);
+    /**
+     * Sets the states of the windows and sends them to the clients if they changed. All states
+     * go out in a single wayland message, which holds about 120 of them, the windows beyond
+     * that are dropped.
+     */
     void setWindowStates(QList<WindowState*> &windowStates);
 
     void sendWindowCaptionImage(int windowId, wl_resource *buffer, QImage image);
     void sendWindowCaption(int windowId, wl_resource *buffer, SurfaceInterface* surface);
+    /**
+     * Fills @p buffer with a thumbnail of @p surface, scaled down to fit the size of the shm
+     * @p buffer while keeping the aspect ratio, and sends the capture callback for @p windowId.
+     *
+     * The thumbnails are cached per surface and size and shared by all clients asking for the
+     * same size, e.g. several docks and task switchers. Only the few most recently asked for
+     * sizes of a surface are kept. A cached thumbnail is only scaled again if the surface got
+     * damaged since, and at most once per thumbnailRefreshInterval(), so asking for the previews
+     * of all windows at once doesn't read back every window again.
+     *
+     * sendWindowCaption() falls back to this if the buffer of the client is smaller than the
+     * surface.
+     */
+    void sendWindowThumbnail(int windowId, wl_resource *buffer, SurfaceInterface *surface);
+    /**
+     * Sets the minimum time between two updates of the thumbnail of a damaged surface, the
+     * default is 200 milliseconds.
+     */
+    void setThumbnailRefreshInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds thumbnailRefreshInterval() const;
     void sendSplitChange(const QString& uuid, int splitable);
 
 Q_SIGNALS:
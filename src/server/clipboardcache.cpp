@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "clipboardcache.h"
+#include "datatransfer.h"
+#include "logging.h"
+
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace KWaylandServer
+{
+static const qint64 s_chunkSize = 64 * 1024;
+
+static void disposeNotifier(QSocketNotifier *notifier)
+{
+    // this might be called from the activated signal of the notifier
+    notifier->setEnabled(false);
+    close(notifier->socket());
+    notifier->deleteLater();
+}
+
+class ClipboardCacheEntry
+{
+public:
+    enum class State {
+        Reading,
+        Complete,
+        Dropped,
+    };
+
+    ~ClipboardCacheEntry()
+    {
+        if (notifier) {
+            disposeNotifier(notifier);
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+        for (qint32 request : qAsConst(pendingRequests)) {
+            close(request);
+        }
+    }
+
+    QString mimeType;
+    State state = State::Reading;
+    // the memfd holding the data read so far
+    int fd = -1;
+    qint64 size = 0;
+    QSocketNotifier *notifier = nullptr;
+    // requests that arrived while the data was being read
+    QVector<qint32> pendingRequests;
+};
+
+static void serve(ClipboardCacheEntry *entry, qint32 fd)
+{
+    // the transfer has no parent, so a paste in progress outlives a selection change
+    new DataTransfer(entry->fd, entry->size, fd);
+}
+
+ClipboardCache::ClipboardCache(AbstractDataSource *source, qint64 sizeLimit, QObject *parent)
+    : AbstractDataSource(parent)
+    , m_source(source)
+    , m_mimeTypes(source->mimeTypes())
+    , m_sizeLimit(sizeLimit)
+{
+    connect(source, &AbstractDataSource::aboutToBeDestroyed, this, &ClipboardCache::handleSourceDestroyed);
+    connect(source, &AbstractDataSource::mimeTypeOffered, this, [this](const QString &mimeType) {
+        m_mimeTypes.append(mimeType);
+        startReading(mimeType);
+        Q_EMIT mimeTypeOffered(mimeType);
+    });
+
+    for (const QString &mimeType : qAsConst(m_mimeTypes)) {
+        startReading(mimeType);
+    }
+}
+
+ClipboardCache::~ClipboardCache()
+{
+    Q_EMIT aboutToBeDestroyed();
+    qDeleteAll(m_entries);
+}
+
+AbstractDataSource *ClipboardCache::source() const
+{
+    return m_source;
+}
+
+void ClipboardCache::requestData(const QString &mimeType, qint32 fd)
+{
+    ClipboardCacheEntry *entry = m_entries.value(mimeType);
+    if (entry && entry->state == ClipboardCacheEntry::State::Complete) {
+        serve(entry, fd);
+    } else if (entry && entry->state == ClipboardCacheEntry::State::Reading) {
+        entry->pendingRequests.append(fd);
+    } else if (m_source) {
+        m_source->requestData(mimeType, fd);
+    } else {
+        close(fd);
+    }
+}
+
+void ClipboardCache::cancel()
+{
+    if (m_source) {
+        disconnect(m_source, nullptr, this, nullptr);
+        m_source->cancel();
+    }
+    deleteLater();
+}
+
+QStringList ClipboardCache::mimeTypes() const
+{
+    if (m_source) {
+        return m_mimeTypes;
+    }
+    QStringList mimeTypes;
+    for (const QString &mimeType : m_mimeTypes) {
+        const ClipboardCacheEntry *entry = m_entries.value(mimeType);
+        if (entry && entry->state != ClipboardCacheEntry::State::Dropped) {
+            mimeTypes.append(mimeType);
+        }
+    }
+    return mimeTypes;
+}
+
+wl_client *ClipboardCache::client() const
+{
+    return m_source ? m_source->client() : nullptr;
+}
+
+void ClipboardCache::startReading(const QString &mimeType)
+{
+    if (!m_source || m_entries.contains(mimeType)) {
+        return;
+    }
+
+    auto entry = new ClipboardCacheEntry;
+    entry->mimeType = mimeType;
+    m_entries.insert(mimeType, entry);
+
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create a pipe for the clipboard cache:" << strerror(errno);
+        entry->state = ClipboardCacheEntry::State::Dropped;
+        return;
+    }
+    entry->fd = memfd_create("wayland-clipboard", MFD_CLOEXEC);
+    if (entry->fd == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create the clipboard cache memfd:" << strerror(errno);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        entry->state = ClipboardCacheEntry::State::Dropped;
+        return;
+    }
+
+    entry->notifier = new QSocketNotifier(pipeFds[0], QSocketNotifier::Read);
+    connect(entry->notifier, &QSocketNotifier::activated, this, [this, entry]() {
+        readEntry(entry);
+    });
+    // takes the ownership of the write end
+    m_source->requestData(mimeType, pipeFds[1]);
+}
+
+void ClipboardCache::readEntry(ClipboardCacheEntry *entry)
+{
+    const int pipe = entry->notifier->socket();
+    while (true) {
+        const qint64 budget = m_sizeLimit - m_size;
+        if (budget <= 0) {
+            qCDebug(KWAYLAND_SERVER) << "Not caching" << entry->mimeType << "it exceeds the clipboard cache limit";
+            finishEntry(entry, false);
+            return;
+        }
+
+        // the data goes from the pipe straight into the memfd, without passing user space
+        const ssize_t bytesRead = splice(pipe, nullptr, entry->fd, nullptr, std::min(budget, s_chunkSize), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (bytesRead == 0) {
+            finishEntry(entry, true);
+            return;
+        }
+        if (bytesRead == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                qCWarning(KWAYLAND_SERVER) << "Failed to read" << entry->mimeType << "into the clipboard cache:" << strerror(errno);
+                finishEntry(entry, false);
+            }
+            return;
+        }
+        entry->size += bytesRead;
+        m_size += bytesRead;
+    }
+}
+
+void ClipboardCache::finishEntry(ClipboardCacheEntry *entry, bool complete)
+{
+    disposeNotifier(entry->notifier);
+    entry->notifier = nullptr;
+
+    const QVector<qint32> requests = std::exchange(entry->pendingRequests, {});
+    if (complete) {
+        entry->state = ClipboardCacheEntry::State::Complete;
+        for (qint32 fd : requests) {
+            serve(entry, fd);
+        }
+    } else {
+        entry->state = ClipboardCacheEntry::State::Dropped;
+        m_size -= entry->size;
+        entry->size = 0;
+        close(entry->fd);
+        entry->fd = -1;
+        for (qint32 fd : requests) {
+            requestData(entry->mimeType, fd);
+        }
+    }
+    checkExpired();
+}
+
+void ClipboardCache::handleSourceDestroyed()
+{
+    m_source = nullptr;
+    checkExpired();
+}
+
+void ClipboardCache::checkExpired()
+{
+    if (m_source) {
+        return;
+    }
+    for (const ClipboardCacheEntry *entry : qAsConst(m_entries)) {
+        if (entry->state != ClipboardCacheEntry::State::Dropped) {
+            return;
+        }
+    }
+    deleteLater();
+}
+
+} // namespace KWaylandServer
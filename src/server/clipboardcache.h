@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "abstract_data_source.h"
+
+#include <QHash>
+#include <QPointer>
+
+namespace KWaylandServer
+{
+class ClipboardCacheEntry;
+
+/**
+ * A data source that keeps a copy of the clipboard selection of another data source.
+ *
+ * All mime types offered by the source are read into anonymous shared memory once, as soon
+ * as the cache gets created. Requests for a mime type that has been read are served from the
+ * memory with sendfile, requests that arrive while the mime type is still being read wait
+ * for it, so the source is asked for every mime type at most once. Mime types that don't fit
+ * into the size limit are not cached, requests for them are forwarded to the source.
+ *
+ * The cache stays valid after the source is destroyed and only offers the cached mime types
+ * from then on. If nothing could be cached, it destroys itself.
+ *
+ * Used by SeatInterface if the clipboard cache is enabled.
+ */
+class ClipboardCache : public AbstractDataSource
+{
+    Q_OBJECT
+
+public:
+    ClipboardCache(AbstractDataSource *source, qint64 sizeLimit, QObject *parent = nullptr);
+    ~ClipboardCache() override;
+
+    /**
+     * Returns the cached data source, or @c null if it has been destroyed.
+     */
+    AbstractDataSource *source() const;
+
+    void requestData(const QString &mimeType, qint32 fd) override;
+    void cancel() override;
+    QStringList mimeTypes() const override;
+    wl_client *client() const override;
+
+private:
+    void startReading(const QString &mimeType);
+    void readEntry(ClipboardCacheEntry *entry);
+    void finishEntry(ClipboardCacheEntry *entry, bool complete);
+    void handleSourceDestroyed();
+    void checkExpired();
+
+    QPointer<AbstractDataSource> m_source;
+    QStringList m_mimeTypes;
+    QHash<QString, ClipboardCacheEntry *> m_entries;
+    qint64 m_sizeLimit;
+    qint64 m_size = 0;
+};
+
+} // namespace KWaylandServer
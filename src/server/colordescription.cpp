@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "colordescription.h"
+
+namespace KWaylandServer
+{
+bool Chromaticities::operator==(const Chromaticities &other) const
+{
+    return red == other.red && green == other.green && blue == other.blue && white == other.white;
+}
+
+bool HdrMetadata::operator==(const HdrMetadata &other) const
+{
+    return mastering == other.mastering && qFuzzyCompare(1 + maxMasteringLuminance, 1 + other.maxMasteringLuminance)
+        && qFuzzyCompare(1 + minMasteringLuminance, 1 + other.minMasteringLuminance)
+        && qFuzzyCompare(1 + maxContentLightLevel, 1 + other.maxContentLightLevel)
+        && qFuzzyCompare(1 + maxFrameAverageLightLevel, 1 + other.maxFrameAverageLightLevel);
+}
+
+Chromaticities ColorDescription::chromaticities(Primaries primaries)
+{
+    switch (primaries) {
+    case Primaries::Rec2020:
+        return Chromaticities{QPointF(0.708, 0.292), QPointF(0.170, 0.797), QPointF(0.131, 0.046), QPointF(0.3127, 0.3290)};
+    case Primaries::Undefined:
+    case Primaries::Rec709:
+    default:
+        return Chromaticities{QPointF(0.64, 0.33), QPointF(0.30, 0.60), QPointF(0.15, 0.06), QPointF(0.3127, 0.3290)};
+    }
+}
+
+Chromaticities ColorDescription::chromaticities() const
+{
+    return hdrMetadata ? hdrMetadata->mastering : chromaticities(primaries);
+}
+
+bool ColorDescription::operator==(const ColorDescription &other) const
+{
+    return transferFunction == other.transferFunction && primaries == other.primaries && hdrMetadata == other.hdrMetadata;
+}
+
+}
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QPointF>
+// std
+#include <optional>
+
+namespace KWaylandServer
+{
+/**
+ * The CIE 1931 xy chromaticities of the primaries and the white point of a color space.
+ */
+struct KWAYLANDSERVER_EXPORT Chromaticities {
+    QPointF red;
+    QPointF green;
+    QPointF blue;
+    QPointF white;
+
+    bool operator==(const Chromaticities &other) const;
+    bool operator!=(const Chromaticities &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * The static HDR metadata of CTA-861.G, the luminances are in cd/m².
+ */
+struct KWAYLANDSERVER_EXPORT HdrMetadata {
+    Chromaticities mastering;
+    double maxMasteringLuminance = 0;
+    double minMasteringLuminance = 0;
+    double maxContentLightLevel = 0;
+    double maxFrameAverageLightLevel = 0;
+
+    bool operator==(const HdrMetadata &other) const;
+    bool operator!=(const HdrMetadata &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * The ColorDescription struct describes the color space of the contents of a surface or
+ * of what an output displays. Comparing the description of a surface with the one of the
+ * output it is shown on tells whether the contents have to be converted at all.
+ */
+struct KWAYLANDSERVER_EXPORT ColorDescription {
+    enum class TransferFunction {
+        Undefined,
+        Srgb,
+        Gamma22,
+        PerceptualQuantizer,
+        ScRgbLinear,
+    };
+    enum class Primaries {
+        Undefined,
+        Rec709,
+        Rec2020,
+    };
+
+    TransferFunction transferFunction = TransferFunction::Undefined;
+    Primaries primaries = Primaries::Undefined;
+    std::optional<HdrMetadata> hdrMetadata;
+
+    /**
+     * @returns The chromaticities of the mastering display if there is HDR metadata, otherwise
+     * the ones of the primaries, where undefined primaries are treated as Rec. 709.
+     */
+    Chromaticities chromaticities() const;
+    static Chromaticities chromaticities(Primaries primaries);
+
+    bool operator==(const ColorDescription &other) const;
+    bool operator!=(const ColorDescription &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+}
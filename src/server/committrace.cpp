@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "committrace_p.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+namespace KWaylandServer
+{
+CommitTrace::CommitTrace(pid_t processId, quint32 surfaceId)
+    : processId(processId)
+    , surfaceId(surfaceId)
+{
+}
+
+SurfaceInterface::CommitRecord &CommitTrace::append()
+{
+    SurfaceInterface::CommitRecord &record = m_records[m_count & (s_size - 1)];
+    record = SurfaceInterface::CommitRecord();
+    ++m_count;
+    return record;
+}
+
+void CommitTrace::frameCallbacksSent(std::chrono::nanoseconds timestamp)
+{
+    m_unsent = std::max(m_unsent, m_count > s_size ? m_count - s_size : 0);
+    for (; m_unsent < m_count; ++m_unsent) {
+        SurfaceInterface::CommitRecord &record = m_records[m_unsent & (s_size - 1)];
+        if (record.frameCallbacks && record.frameCallbacksSent == std::chrono::nanoseconds::zero()) {
+            record.frameCallbacksSent = timestamp;
+        }
+    }
+}
+
+QVector<SurfaceInterface::CommitRecord> CommitTrace::records() const
+{
+    QVector<SurfaceInterface::CommitRecord> records;
+    const quint64 first = m_count > s_size ? m_count - s_size : 0;
+    records.reserve(m_count - first);
+    for (quint64 i = first; i < m_count; ++i) {
+        records.append(m_records[i & (s_size - 1)]);
+    }
+    return records;
+}
+
+static QString bufferTypeName(SurfaceInterface::CommitRecord::BufferType type)
+{
+    switch (type) {
+    case SurfaceInterface::CommitRecord::BufferType::Unchanged:
+        return QStringLiteral("unchanged");
+    case SurfaceInterface::CommitRecord::BufferType::Detached:
+        return QStringLiteral("detached");
+    case SurfaceInterface::CommitRecord::BufferType::Shm:
+        return QStringLiteral("shm");
+    case SurfaceInterface::CommitRecord::BufferType::DmaBuf:
+        return QStringLiteral("dmabuf");
+    case SurfaceInterface::CommitRecord::BufferType::Drm:
+        return QStringLiteral("drm");
+    case SurfaceInterface::CommitRecord::BufferType::SinglePixel:
+        return QStringLiteral("single-pixel");
+    case SurfaceInterface::CommitRecord::BufferType::Other:
+        return QStringLiteral("other");
+    }
+    Q_UNREACHABLE();
+}
+
+static double toMicroseconds(std::chrono::nanoseconds timestamp)
+{
+    return std::chrono::duration<double, std::micro>(timestamp).count();
+}
+
+QByteArray CommitTrace::toChromeTrace(const QVector<QSharedPointer<CommitTrace>> &traces)
+{
+    QJsonArray events;
+    QVector<pid_t> processes;
+    for (const QSharedPointer<CommitTrace> &trace : traces) {
+        if (!processes.contains(trace->processId)) {
+            processes.append(trace->processId);
+            events.append(QJsonObject{
+                {QStringLiteral("ph"), QStringLiteral("M")},
+                {QStringLiteral("name"), QStringLiteral("process_name")},
+                {QStringLiteral("pid"), qint64(trace->processId)},
+                {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QStringLiteral("client %1").arg(trace->processId)}}},
+            });
+        }
+        events.append(QJsonObject{
+            {QStringLiteral("ph"), QStringLiteral("M")},
+            {QStringLiteral("name"), QStringLiteral("thread_name")},
+            {QStringLiteral("pid"), qint64(trace->processId)},
+            {QStringLiteral("tid"), qint64(trace->surfaceId)},
+            {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QStringLiteral("wl_surface@%1").arg(trace->surfaceId)}}},
+        });
+
+        const QVector<SurfaceInterface::CommitRecord> records = trace->records();
+        for (const SurfaceInterface::CommitRecord &record : records) {
+            QJsonObject event{
+                {QStringLiteral("name"), QStringLiteral("commit")},
+                {QStringLiteral("cat"), QStringLiteral("wl_surface")},
+                {QStringLiteral("pid"), qint64(trace->processId)},
+                {QStringLiteral("tid"), qint64(trace->surfaceId)},
+                {QStringLiteral("ts"), toMicroseconds(record.timestamp)},
+                {QStringLiteral("args"),
+                 QJsonObject{
+                     {QStringLiteral("buffer"), bufferTypeName(record.bufferType)},
+                     {QStringLiteral("width"), record.bufferSize.width()},
+                     {QStringLiteral("height"), record.bufferSize.height()},
+                     {QStringLiteral("damage"), double(record.damageArea)},
+                     {QStringLiteral("synchronized"), record.synchronized},
+                     {QStringLiteral("frameCallbacks"), record.frameCallbacks},
+                 }},
+            };
+            // a commit lasts until its frame callbacks are sent, otherwise it is an instant
+            if (record.frameCallbacksSent > record.timestamp) {
+                event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+                event.insert(QStringLiteral("dur"), toMicroseconds(record.frameCallbacksSent - record.timestamp));
+            } else {
+                event.insert(QStringLiteral("ph"), QStringLiteral("i"));
+                event.insert(QStringLiteral("s"), QStringLiteral("t"));
+            }
+            events.append(event);
+        }
+    }
+    return QJsonDocument(QJsonObject{{QStringLiteral("traceEvents"), events}}).toJson(QJsonDocument::Compact);
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "surface_interface.h"
+
+#include <QSharedPointer>
+#include <QVector>
+
+#include <array>
+#include <sys/types.h>
+
+namespace KWaylandServer
+{
+/**
+ * The recent commits of a surface, kept in a fixed ring so recording never allocates.
+ *
+ * A surface only allocates its trace on the first commit while the commit tracing of the Display
+ * is enabled. The trace is shared with the Display, which exports the traces of all surfaces in
+ * the Chrome trace event format, see Display::exportCommitTrace. Everything happens on the
+ * thread of the Display, so no locking is involved.
+ */
+class CommitTrace
+{
+public:
+    CommitTrace(pid_t processId, quint32 surfaceId);
+
+    /**
+     * Returns a new record, overwriting the oldest one once the ring is full.
+     */
+    SurfaceInterface::CommitRecord &append();
+    /**
+     * Marks the frame callbacks of the records which requested them and have not been sent yet
+     * as sent at @p timestamp.
+     */
+    void frameCallbacksSent(std::chrono::nanoseconds timestamp);
+    /**
+     * Returns the records, the oldest first.
+     */
+    QVector<SurfaceInterface::CommitRecord> records() const;
+
+    /**
+     * Serializes @p traces as a JSON object with the traceEvents of the Chrome trace event
+     * format, which chrome://tracing and Perfetto can open. Each surface becomes a thread of its
+     * client's process, each commit a complete event lasting until its frame callbacks got sent.
+     */
+    static QByteArray toChromeTrace(const QVector<QSharedPointer<CommitTrace>> &traces);
+
+    const pid_t processId;
+    const quint32 surfaceId;
+
+private:
+    static constexpr quint32 s_size = 256;
+    static_assert((s_size & (s_size - 1)) == 0, "the size of the trace has to be a power of two");
+
+    std::array<SurfaceInterface::CommitRecord, s_size> m_records;
+    quint64 m_count = 0;
+    // the oldest record whose frame callbacks may not have been sent yet
+    quint64 m_unsent = 0;
+};
+
+} // namespace KWaylandServer
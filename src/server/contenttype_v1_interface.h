@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class ContentTypeManagerV1InterfacePrivate;
+
+/**
+ * The ContentTypeManagerV1Interface lets clients describe the content of their surfaces, e.g.
+ * a video or a game. The content type is double-buffered surface state and can be queried
+ * with SurfaceInterface::contentType().
+ *
+ * ContentTypeManagerV1Interface corresponds to the Wayland interface @c wp_content_type_manager_v1.
+ */
+class KWAYLANDSERVER_EXPORT ContentTypeManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContentTypeManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~ContentTypeManagerV1Interface() override;
+
+private:
+    QScopedPointer<ContentTypeManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
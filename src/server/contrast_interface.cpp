@@ -20,6 +20,11 @@ class ContrastManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_con
 public:
     ContrastManagerInterfacePrivate(ContrastManagerInterface *q, Display *display);
 
+    /**
+     * Returns the resource of @p contrast, it is destroyed together with it.
+     */
+    static wl_resource *resourceForContrast(ContrastInterface *contrast);
+
     ContrastManagerInterface *q;
 
 protected:
@@ -65,7 +70,7 @@ void ContrastManagerInterfacePrivate::org_kde_kwin_contrast_manager_unset(Resour
         return;
     }
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->setContrast(QPointer<ContrastInterface>());
+    surfacePrivate->setContrast(nullptr);
 }
 
 ContrastManagerInterface::ContrastManagerInterface(Display *display, QObject *parent)
@@ -182,6 +187,16 @@ ContrastInterfacePrivate::ContrastInterfacePrivate(ContrastInterface *_q, wl_res
 {
 }
 
+wl_resource *ContrastManagerInterfacePrivate::resourceForContrast(ContrastInterface *contrast)
+{
+    return contrast->d->resource()->handle;
+}
+
+void addWeakHandleListener(ContrastInterface *contrast, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(ContrastManagerInterfacePrivate::resourceForContrast(contrast), listener);
+}
+
 ContrastInterface::ContrastInterface(wl_resource *resource)
     : QObject()
     , d(new ContrastInterfacePrivate(this, resource))
@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class CursorShapeManagerV1InterfacePrivate;
+
+/**
+ * The CursorShapeManagerV1Interface lets clients pick the cursor of a pointer or a tablet tool
+ * by a shape name instead of attaching a cursor surface.
+ *
+ * The shape is reported by Cursor::shape() and TabletCursorV2::shape(), and the usual change
+ * signals are emitted. The compositor is expected to render the shape from its own cursor
+ * theme, so clients do not need to upload the theme images themselves.
+ *
+ * CursorShapeManagerV1Interface corresponds to the Wayland interface
+ * @c wp_cursor_shape_manager_v1.
+ */
+class KWAYLANDSERVER_EXPORT CursorShapeManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CursorShapeManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~CursorShapeManagerV1Interface() override;
+
+private:
+    QScopedPointer<CursorShapeManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -73,8 +73,9 @@ DataControlOfferV1Interface::~DataControlOfferV1Interface() = default;
 void DataControlOfferV1Interface::sendAllOffers()
 {
     Q_ASSERT(d->source);
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    const QVector<QByteArray> mimeTypes = d->source->encodedMimeTypes();
+    for (const QByteArray &mimeType : mimeTypes) {
+        zwlr_data_control_offer_v1_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
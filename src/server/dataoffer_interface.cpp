@@ -168,8 +168,10 @@ DataOfferInterface::~DataOfferInterface() = default;
 
 void DataOfferInterface::sendAllOffers()
 {
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    // the encoded mime types are shared by all offers of the source
+    const QVector<QByteArray> mimeTypes = d->source->encodedMimeTypes();
+    for (const QByteArray &mimeType : mimeTypes) {
+        wl_data_offer_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
@@ -0,0 +1,239 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "datatransfer.h"
+#include "logging.h"
+
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+static const qint64 s_chunkSize = 64 * 1024;
+
+class DataTransferPrivate
+{
+public:
+    enum class Result {
+        Pending,
+        Finished,
+        Failed,
+    };
+
+    DataTransferPrivate(DataTransfer *q, qint32 fd);
+    ~DataTransferPrivate();
+
+    void write();
+    Result writeBuffer();
+    Result writeFile();
+    void finish(bool success);
+
+    DataTransfer *q;
+    QSocketNotifier *notifier;
+    bool done = false;
+    bool failed = false;
+    qint64 size = -1;
+    qint64 bytesWritten = 0;
+
+    QByteArray buffer;
+    qint64 bufferOffset = 0;
+    DataTransfer::Producer producer;
+
+    int file = -1;
+    off_t fileOffset = 0;
+    bool useSendfile = true;
+};
+
+DataTransferPrivate::DataTransferPrivate(DataTransfer *q, qint32 fd)
+    : q(q)
+    , notifier(new QSocketNotifier(fd, QSocketNotifier::Write, q))
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    // the notifier fires with the next event loop pass if the client can take data already
+    QObject::connect(notifier, &QSocketNotifier::activated, q, [this]() {
+        write();
+    });
+}
+
+DataTransferPrivate::~DataTransferPrivate()
+{
+    if (!done) {
+        close(notifier->socket());
+        if (file != -1) {
+            close(file);
+        }
+    }
+}
+
+void DataTransferPrivate::write()
+{
+    if (failed) {
+        finish(false);
+        return;
+    }
+
+    const qint64 previouslyWritten = bytesWritten;
+    const Result result = file != -1 ? writeFile() : writeBuffer();
+    if (bytesWritten != previouslyWritten) {
+        Q_EMIT q->progress(bytesWritten);
+    }
+
+    switch (result) {
+    case Result::Pending:
+        notifier->setEnabled(true);
+        break;
+    case Result::Finished:
+        finish(true);
+        break;
+    case Result::Failed:
+        finish(false);
+        break;
+    }
+}
+
+DataTransferPrivate::Result DataTransferPrivate::writeBuffer()
+{
+    const int fd = notifier->socket();
+    while (true) {
+        if (bufferOffset == buffer.size()) {
+            if (!producer) {
+                return Result::Finished;
+            }
+            buffer = producer();
+            bufferOffset = 0;
+            if (buffer.isEmpty()) {
+                producer = nullptr;
+                return Result::Finished;
+            }
+        }
+
+        const ssize_t written = ::write(fd, buffer.constData() + bufferOffset, buffer.size() - bufferOffset);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                return Result::Pending;
+            }
+            // most likely the receiving client closed its end
+            qCDebug(KWAYLAND_SERVER) << "Data transfer failed:" << strerror(errno);
+            return Result::Failed;
+        }
+        bufferOffset += written;
+        bytesWritten += written;
+    }
+}
+
+DataTransferPrivate::Result DataTransferPrivate::writeFile()
+{
+    const int fd = notifier->socket();
+    while (bytesWritten < size) {
+        ssize_t written;
+        if (useSendfile) {
+            written = sendfile(fd, file, &fileOffset, std::min<qint64>(size - bytesWritten, s_chunkSize));
+            if (written == -1 && (errno == EINVAL || errno == ENOSYS)) {
+                useSendfile = false;
+                continue;
+            }
+        } else {
+            char chunk[4096];
+            const ssize_t bytesRead = pread(file, chunk, std::min<qint64>(size - bytesWritten, sizeof(chunk)), fileOffset);
+            written = bytesRead <= 0 ? bytesRead : ::write(fd, chunk, bytesRead);
+            if (written > 0) {
+                fileOffset += written;
+            }
+        }
+
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                return Result::Pending;
+            }
+            qCDebug(KWAYLAND_SERVER) << "Data transfer failed:" << strerror(errno);
+            return Result::Failed;
+        }
+        if (written == 0) {
+            // the file is shorter than announced
+            return Result::Failed;
+        }
+        bytesWritten += written;
+    }
+    return Result::Finished;
+}
+
+void DataTransferPrivate::finish(bool success)
+{
+    // this might be called from the activated signal of the notifier
+    done = true;
+    notifier->setEnabled(false);
+    close(notifier->socket());
+    if (file != -1) {
+        close(file);
+        file = -1;
+    }
+
+    if (success) {
+        Q_EMIT q->finished();
+    } else {
+        Q_EMIT q->cancelled();
+    }
+    q->deleteLater();
+}
+
+DataTransfer::DataTransfer(const QByteArray &data, qint32 fd, QObject *parent)
+    : QObject(parent)
+    , d(new DataTransferPrivate(this, fd))
+{
+    d->buffer = data;
+    d->size = data.size();
+}
+
+DataTransfer::DataTransfer(Producer producer, qint32 fd, QObject *parent)
+    : QObject(parent)
+    , d(new DataTransferPrivate(this, fd))
+{
+    d->producer = std::move(producer);
+}
+
+DataTransfer::DataTransfer(int file, qint64 size, qint32 fd, QObject *parent)
+    : QObject(parent)
+    , d(new DataTransferPrivate(this, fd))
+{
+    d->size = size;
+    d->file = fcntl(file, F_DUPFD_CLOEXEC, 0);
+    if (d->file == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to duplicate the file of a data transfer:" << strerror(errno);
+        // report the failure from the event loop, the caller can't connect to it yet
+        d->failed = true;
+    }
+}
+
+DataTransfer::~DataTransfer() = default;
+
+qint64 DataTransfer::bytesWritten() const
+{
+    return d->bytesWritten;
+}
+
+qint64 DataTransfer::size() const
+{
+    return d->size;
+}
+
+void DataTransfer::cancel()
+{
+    if (!d->done) {
+        d->finish(false);
+    }
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+#include <functional>
+
+namespace KWaylandServer
+{
+class DataTransferPrivate;
+
+/**
+ * The DataTransfer class writes data into the file descriptor of a receive request without
+ * blocking the compositor.
+ *
+ * It is meant for compositor-internal AbstractDataSource implementations, which are passed
+ * the file descriptor of the receiving client in requestData(). Writing into it directly
+ * blocks the event loop until the client has read everything; a DataTransfer instead puts
+ * the descriptor into non-blocking mode and writes whenever the client has drained it.
+ *
+ * @code
+ * void MyDataSource::requestData(const QString &mimeType, qint32 fd)
+ * {
+ *     new DataTransfer(m_data.value(mimeType), fd, this);
+ * }
+ * @endcode
+ *
+ * The transfer takes the ownership of the receiving file descriptor. Writing starts with the
+ * next event loop pass, so the signals can be connected right after creating the transfer.
+ * The transfer deletes itself after it finished or got cancelled.
+ *
+ * Writing into a pipe whose reader went away raises SIGPIPE, the compositor should ignore it.
+ */
+class KWAYLANDSERVER_EXPORT DataTransfer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * A producer returns the next chunk of data each time the previous one has been written.
+     * An empty chunk ends the transfer.
+     */
+    using Producer = std::function<QByteArray()>;
+
+    /**
+     * Writes @p data into @p fd.
+     */
+    DataTransfer(const QByteArray &data, qint32 fd, QObject *parent = nullptr);
+    /**
+     * Writes the data returned by @p producer into @p fd.
+     */
+    DataTransfer(Producer producer, qint32 fd, QObject *parent = nullptr);
+    /**
+     * Writes the first @p size bytes of the file, or shared memory, @p file into @p fd. The
+     * data goes from one file into the other with sendfile, without passing user space.
+     * The transfer keeps a duplicate of @p file, it can be closed by the caller.
+     */
+    DataTransfer(int file, qint64 size, qint32 fd, QObject *parent = nullptr);
+    ~DataTransfer() override;
+
+    /**
+     * Returns the number of bytes written so far.
+     */
+    qint64 bytesWritten() const;
+    /**
+     * Returns the total number of bytes of the transfer, or -1 if the data comes from a
+     * producer.
+     */
+    qint64 size() const;
+
+    /**
+     * Stops the transfer and closes the file descriptor, the receiving client gets what has
+     * been written so far.
+     */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted each time the client has received more data.
+     */
+    void progress(qint64 bytesWritten);
+    /**
+     * This signal is emitted after all data has been written.
+     */
+    void finished();
+    /**
+     * This signal is emitted when the transfer has been cancelled, either with cancel() or
+     * because writing failed, e.g. when the client closed its end.
+     */
+    void cancelled();
+
+private:
+    QScopedPointer<DataTransferPrivate> d;
+};
+
+} // namespace KWaylandServer
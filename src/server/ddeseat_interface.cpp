@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 
 #include "ddeseat_interface.h"
+#include "clientconnection.h"
 #include "ddekeyboard_interface.h"
 #include "display.h"
 #include "logging.h"
@@ -11,6 +12,13 @@
 
 #include <QPointF>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include "ddeseat_interface_p.h"
 #include "ddekeyboard_interface_p.h"
 
@@ -21,6 +29,77 @@ static const int s_ddePointerVersion = 1;
 static const int s_ddeTouchVersion = 7;
 static const int s_ddeKeyboardVersion = 7;
 
+/*********************************
+ * MotionRateLimiter
+ *********************************/
+MotionRateLimiter::MotionRateLimiter(const std::function<void()> &flush)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    QObject::connect(&m_timer, &QTimer::timeout, flush);
+}
+
+int MotionRateLimiter::interval() const
+{
+    return m_interval;
+}
+
+void MotionRateLimiter::setInterval(int msec)
+{
+    m_interval = std::max(msec, 0);
+}
+
+bool MotionRateLimiter::pass(Stream &stream, const QPointF &position)
+{
+    const qint64 now = m_clock.elapsed();
+    if (m_interval > 0 && stream.lastMotionTime != -1 && now - stream.lastMotionTime < m_interval) {
+        // the listener gets the position it has at the end of the interval
+        stream.pending = true;
+        stream.pendingPosition = position;
+        schedule(m_interval - (now - stream.lastMotionTime));
+        return false;
+    }
+    stream.pending = false;
+    stream.lastMotionTime = now;
+    return true;
+}
+
+bool MotionRateLimiter::take(Stream &stream, QPointF *position)
+{
+    if (!stream.pending) {
+        return false;
+    }
+    stream.pending = false;
+    stream.lastMotionTime = m_clock.elapsed();
+    *position = stream.pendingPosition;
+    return true;
+}
+
+bool MotionRateLimiter::takeDue(Stream &stream, QPointF *position)
+{
+    if (!stream.pending) {
+        return false;
+    }
+    const qint64 remaining = m_interval - (m_clock.elapsed() - stream.lastMotionTime);
+    if (remaining > 0) {
+        schedule(remaining);
+        return false;
+    }
+    return take(stream, position);
+}
+
+void MotionRateLimiter::stop()
+{
+    m_timer.stop();
+}
+
+void MotionRateLimiter::schedule(qint64 msec)
+{
+    if (!m_timer.isActive() || m_timer.remainingTime() > msec) {
+        m_timer.start(msec);
+    }
+}
+
 /*********************************
  * DDESeatInterface
  *********************************/
@@ -28,6 +107,9 @@ DDESeatInterfacePrivate::DDESeatInterfacePrivate(DDESeatInterface *q, Display *d
     : QtWaylandServer::dde_seat(*d, s_version)
     , q(q)
     , display(d)
+    , motionLimiter([this]() {
+        flushMotion();
+    })
 {
 }
 
@@ -50,14 +132,32 @@ void DDESeatInterfacePrivate::dde_seat_get_dde_pointer(Resource *resource, uint3
 void DDESeatInterfacePrivate::dde_seat_get_dde_keyboard(Resource *resource, uint32_t id) {
     if (ddekeyboard) {
         DDEKeyboardInterfacePrivate *keyboardPrivate = DDEKeyboardInterfacePrivate::get(ddekeyboard.data());
-        keyboardPrivate->add(resource->client(), id, resource->version());
+        auto keyboardResource = keyboardPrivate->add(resource->client(), id, resource->version());
+        sendKeymap(keyboardPrivate, keyboardResource->handle);
     } else {
         wl_resource *keyboard_resource = wl_resource_create(resource->client(), &dde_keyboard_interface, s_ddeKeyboardVersion, id);
         ddekeyboard.reset(new DDEKeyboardInterface(q, keyboard_resource));
+        sendKeymap(DDEKeyboardInterfacePrivate::get(ddekeyboard.data()), keyboard_resource);
         Q_EMIT q->ddeKeyboardCreated(ddekeyboard.data());
     }
 }
 
+void DDESeatInterfacePrivate::sendKeymap(DDEKeyboardInterfacePrivate *keyboard, wl_resource *resource)
+{
+    if (!keys.keymapFile) {
+        return;
+    }
+    // like wl_keyboard before version 7, dde_keyboard doesn't require MAP_PRIVATE, so every
+    // client gets a writable copy of the sealed keymap file
+    const int fd = keys.keymapFile->createPrivateCopy();
+    if (fd != -1) {
+        keyboard->send_keymap(resource, QtWaylandServer::dde_keyboard::keymap_format_xkb_v1, fd, keys.keymap.size);
+        close(fd);
+        return;
+    }
+    keyboard->send_keymap(resource, QtWaylandServer::dde_keyboard::keymap_format_xkb_v1, keys.keymap.fd, keys.keymap.size);
+}
+
 void DDESeatInterfacePrivate::dde_seat_get_dde_touch(Resource *resource, uint32_t id) {
     if (ddetouch) {
         DDETouchInterfacePrivate *touchPrivate = DDETouchInterfacePrivate::get(ddetouch.data());
@@ -71,16 +171,52 @@ void DDESeatInterfacePrivate::dde_seat_get_dde_touch(Resource *resource, uint32_
 
 bool DDESeatInterfacePrivate::updateKey(quint32 key, Keyboard::State state)
 {
-    auto it = keys.states.find(key);
-    if (it == keys.states.end()) {
-        keys.states.insert(key, state);
-        return true;
+    if (state == Keyboard::State::Pressed) {
+        return keys.pressedKeys.insert(key);
     }
-    if (it.value() == state) {
-        return false;
+    return keys.pressedKeys.remove(key);
+}
+
+void DDESeatInterfacePrivate::sendKey(quint32 key, Keyboard::State state)
+{
+    keys.lastStateSerial = display->nextSerial();
+    if (state == Keyboard::State::Pressed) {
+        ddekeyboard->keyPressed(key, keys.lastStateSerial);
+    } else {
+        ddekeyboard->keyReleased(key, keys.lastStateSerial);
+    }
+}
+
+void DDESeatInterfacePrivate::flushMotion()
+{
+    QPointF pos;
+    if (ddepointer && motionLimiter.takeDue(pointerMotion, &pos)) {
+        ddepointer->sendMotion(pos);
+    }
+    for (const auto &touchMotion : touchMotions) {
+        // the map doesn't change while touch motion is sent
+        auto stream = touchMotions.find(touchMotion.first);
+        if (ddetouch && motionLimiter.takeDue(*stream, &pos)) {
+            ddetouch->touchMotion(touchMotion.first, pos);
+        }
+    }
+}
+
+void DDESeatInterfacePrivate::flushPointerMotion()
+{
+    QPointF pos;
+    if (motionLimiter.take(pointerMotion, &pos)) {
+        ddepointer->sendMotion(pos);
+    }
+}
+
+void DDESeatInterfacePrivate::flushTouchMotion(qint32 id)
+{
+    QPointF pos;
+    MotionRateLimiter::Stream *stream = touchMotions.find(id);
+    if (stream && motionLimiter.take(*stream, &pos)) {
+        ddetouch->touchMotion(id, pos);
     }
-    it.value() = state;
-    return true;
 }
 
 DDESeatInterface::DDESeatInterface(Display *display, QObject *parent)
@@ -113,7 +249,9 @@ void DDESeatInterface::setPointerPos(const QPointF &pos)
         return;
     }
     d->globalPos = pos;
-    d->ddepointer->sendMotion(pos);
+    if (d->motionLimiter.pass(d->pointerMotion, pos)) {
+        d->ddepointer->sendMotion(pos);
+    }
 }
 
 void DDESeatInterface::pointerButtonPressed(quint32 button)
@@ -121,6 +259,7 @@ void DDESeatInterface::pointerButtonPressed(quint32 button)
     if (!d->ddepointer) {
         return;
     }
+    d->flushPointerMotion();
     d->ddepointer->buttonPressed(button);
 }
 
@@ -129,6 +268,7 @@ void DDESeatInterface::pointerButtonReleased(quint32 button)
     if (!d->ddepointer) {
         return;
     }
+    d->flushPointerMotion();
     d->ddepointer->buttonReleased(button);
 }
 
@@ -137,9 +277,35 @@ void DDESeatInterface::pointerAxis(Qt::Orientation orientation, qint32 delta)
     if (!d->ddepointer) {
         return;
     }
+    d->flushPointerMotion();
     d->ddepointer->axis(orientation, delta);
 }
 
+void DDESeatInterface::setMotionInterval(int msec)
+{
+    msec = std::max(msec, 0);
+    if (d->motionLimiter.interval() == msec) {
+        return;
+    }
+    d->motionLimiter.setInterval(msec);
+    if (msec == 0) {
+        d->motionLimiter.stop();
+        if (d->ddepointer) {
+            d->flushPointerMotion();
+        }
+        if (d->ddetouch) {
+            for (const auto &touchMotion : d->touchMotions) {
+                d->flushTouchMotion(touchMotion.first);
+            }
+        }
+    }
+}
+
+int DDESeatInterface::motionInterval() const
+{
+    return d->motionLimiter.interval();
+}
+
 quint32 DDESeatInterface::timestamp() const
 {
     return d->timestamp;
@@ -168,14 +334,41 @@ void DDESeatInterface::setTouchTimestamp(quint32 time)
 
 void DDESeatInterface::setKeymap(int fd, quint32 size)
 {
-    if (!d->ddekeyboard) {
+    // The caller may close or reuse the descriptor, while the keyboards bound later still need
+    // the keymap, so it's copied into a file of the seat.
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to map the keymap:" << strerror(errno);
+        return;
+    }
+    const char *keymap = static_cast<const char *>(data);
+    const QByteArray content(keymap, qstrnlen(keymap, size));
+    munmap(data, size);
+    setKeymap(content);
+}
+
+void DDESeatInterface::setKeymap(const QByteArray &content)
+{
+    if (content.isNull()) {
         return;
     }
-    d->keys.keymap.xkbcommonCompatible = true;
-    d->keys.keymap.fd = fd;
-    d->keys.keymap.size = size;
 
-    d->ddekeyboard->setKeymap(fd, size);
+    QScopedPointer<KeymapFile> keymapFile(new KeymapFile(content));
+    if (!keymapFile->isValid()) {
+        return;
+    }
+    d->keys.keymapFile.swap(keymapFile);
+    d->keys.keymap.xkbcommonCompatible = true;
+    d->keys.keymap.fd = d->keys.keymapFile->fd();
+    d->keys.keymap.size = d->keys.keymapFile->size();
+
+    if (d->ddekeyboard) {
+        DDEKeyboardInterfacePrivate *keyboardPrivate = DDEKeyboardInterfacePrivate::get(d->ddekeyboard.data());
+        const auto resources = keyboardPrivate->resourceMap();
+        for (auto resource : resources) {
+            d->sendKeymap(keyboardPrivate, resource->handle);
+        }
+    }
 }
 
 void DDESeatInterface::keyPressed(quint32 key)
@@ -183,12 +376,10 @@ void DDESeatInterface::keyPressed(quint32 key)
     if (!d->ddekeyboard) {
         return;
     }
-    d->keys.lastStateSerial = d->display->nextSerial();
     if (!d->updateKey(key, DDESeatInterfacePrivate::Keyboard::State::Pressed)) {
         return;
     }
-
-    d->ddekeyboard->keyPressed(key, d->keys.lastStateSerial);
+    d->sendKey(key, DDESeatInterfacePrivate::Keyboard::State::Pressed);
 }
 
 void DDESeatInterface::keyReleased(quint32 key)
@@ -196,12 +387,10 @@ void DDESeatInterface::keyReleased(quint32 key)
     if (!d->ddekeyboard) {
         return;
     }
-    d->keys.lastStateSerial = d->display->nextSerial();
     if (!d->updateKey(key, DDESeatInterfacePrivate::Keyboard::State::Released)) {
         return;
     }
-
-    d->ddekeyboard->keyReleased(key, d->keys.lastStateSerial);
+    d->sendKey(key, DDESeatInterfacePrivate::Keyboard::State::Released);
 }
 
 void DDESeatInterface::touchDown(qint32 id, const QPointF &pos)
@@ -209,6 +398,7 @@ void DDESeatInterface::touchDown(qint32 id, const QPointF &pos)
     if (!d->ddetouch) {
         return;
     }
+    d->touchMotions.insert(id, MotionRateLimiter::Stream());
     d->ddetouch->touchDown(id, pos);
 }
 
@@ -217,7 +407,14 @@ void DDESeatInterface::touchMotion(qint32 id, const QPointF &pos)
     if (!d->ddetouch) {
         return;
     }
-    d->ddetouch->touchMotion(id, pos);
+    MotionRateLimiter::Stream *stream = d->touchMotions.find(id);
+    if (!stream) {
+        d->touchMotions.insert(id, MotionRateLimiter::Stream());
+        stream = d->touchMotions.find(id);
+    }
+    if (d->motionLimiter.pass(*stream, pos)) {
+        d->ddetouch->touchMotion(id, pos);
+    }
 }
 
 void DDESeatInterface::touchUp(qint32 id)
@@ -225,6 +422,9 @@ void DDESeatInterface::touchUp(qint32 id)
     if (!d->ddetouch) {
         return;
     }
+    // the last position of the touch point must not get lost
+    d->flushTouchMotion(id);
+    d->touchMotions.remove(id);
     d->ddetouch->touchUp(id);
 }
 
@@ -304,7 +504,11 @@ DDEPointerInterfacePrivate::DDEPointerInterfacePrivate(DDEPointerInterface *q, D
     : QtWaylandServer::dde_pointer(resource)
     , q(q)
     , ddeSeat(seat)
+    , throttle([this]() {
+        flushThrottledMotion();
+    })
 {
+    throttle.setInterval(16);
 }
 
 DDEPointerInterfacePrivate::~DDEPointerInterfacePrivate()
@@ -316,7 +520,81 @@ void DDEPointerInterfacePrivate::dde_pointer_get_motion(Resource *resource)
     Q_UNUSED(resource)
 
     const QPointF globalPos = ddeSeat->pointerPos();
-    send_motion(wl_fixed_from_double(globalPos.x()), wl_fixed_from_double(globalPos.y()));
+    send_motion(resource->handle, wl_fixed_from_double(globalPos.x()), wl_fixed_from_double(globalPos.y()));
+}
+
+DDEPointerInterfacePrivate::Subscription &DDEPointerInterfacePrivate::subscription(ClientConnection *client)
+{
+    auto it = subscriptions.find(client->client());
+    if (it == subscriptions.end()) {
+        // the client may never bind a dde pointer, so its resources can't tell when it is gone
+        QObject::connect(client, &ClientConnection::disconnected, q, [this](ClientConnection *client) {
+            subscriptions.remove(client->client());
+        });
+        it = subscriptions.insert(client->client(), Subscription());
+    }
+    return *it;
+}
+
+void DDEPointerInterfacePrivate::sendMotion(wl_client *client, const QPointF &position)
+{
+    const auto resources = resourceMap().values(client);
+    for (Resource *resource : resources) {
+        send_motion(resource->handle, wl_fixed_from_double(position.x()), wl_fixed_from_double(position.y()));
+    }
+}
+
+bool DDEPointerInterfacePrivate::shouldSendMotion(wl_client *client, const QPointF &position)
+{
+    auto subscription = subscriptions.find(client);
+    if (subscription == subscriptions.end()) {
+        return true;
+    }
+    switch (subscription->mode) {
+    case DDEPointerInterface::MotionMode::Full:
+        return true;
+    case DDEPointerInterface::MotionMode::Throttled:
+        return throttle.pass(subscription->motion, position);
+    case DDEPointerInterface::MotionMode::Regions: {
+        const bool inHotRegion = subscription->hotRegion.contains(position.toPoint());
+        if (inHotRegion == subscription->inHotRegion) {
+            return false;
+        }
+        subscription->inHotRegion = inHotRegion;
+        return true;
+    }
+    }
+    return true;
+}
+
+void DDEPointerInterfacePrivate::sendMotion(const QPointF &position)
+{
+    const wl_fixed_t x = wl_fixed_from_double(position.x());
+    const wl_fixed_t y = wl_fixed_from_double(position.y());
+
+    const auto resources = resourceMap();
+    wl_client *client = nullptr;
+    bool send = true;
+    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+        if (it.key() != client) {
+            // the resources of a client are next to each other and share its subscription
+            client = it.key();
+            send = subscriptions.isEmpty() || shouldSendMotion(client, position);
+        }
+        if (send) {
+            send_motion(it.value()->handle, x, y);
+        }
+    }
+}
+
+void DDEPointerInterfacePrivate::flushThrottledMotion()
+{
+    QPointF position;
+    for (auto it = subscriptions.begin(); it != subscriptions.end(); ++it) {
+        if (it->mode == DDEPointerInterface::MotionMode::Throttled && throttle.takeDue(it->motion, &position)) {
+            sendMotion(it.key(), position);
+        }
+    }
 }
 
 DDEPointerInterface::DDEPointerInterface(DDESeatInterface *seat, wl_resource *resource)
@@ -331,29 +609,77 @@ DDESeatInterface *DDEPointerInterface::ddeSeat() const
     return d->ddeSeat;
 }
 
+void DDEPointerInterface::setMotionMode(ClientConnection *client, MotionMode mode)
+{
+    DDEPointerInterfacePrivate::Subscription &subscription = d->subscription(client);
+    if (subscription.mode == mode) {
+        return;
+    }
+    subscription.mode = mode;
+    subscription.motion = MotionRateLimiter::Stream();
+    subscription.inHotRegion = subscription.hotRegion.contains(d->ddeSeat->pointerPos().toPoint());
+}
+
+DDEPointerInterface::MotionMode DDEPointerInterface::motionMode(ClientConnection *client) const
+{
+    return d->subscriptions.value(client->client()).mode;
+}
+
+void DDEPointerInterface::setHotRegion(ClientConnection *client, const QRegion &region)
+{
+    DDEPointerInterfacePrivate::Subscription &subscription = d->subscription(client);
+    subscription.hotRegion = region;
+    // the client learns about the new region from the next crossing
+    subscription.inHotRegion = region.contains(d->ddeSeat->pointerPos().toPoint());
+}
+
+QRegion DDEPointerInterface::hotRegion(ClientConnection *client) const
+{
+    return d->subscriptions.value(client->client()).hotRegion;
+}
+
+void DDEPointerInterface::setThrottleInterval(int msec)
+{
+    d->throttle.setInterval(std::max(msec, 1));
+}
+
+int DDEPointerInterface::throttleInterval() const
+{
+    return d->throttle.interval();
+}
+
 void DDEPointerInterface::buttonPressed(quint32 button)
 {
     const QPointF globalPos = d->ddeSeat->pointerPos();
-    d->send_button(wl_fixed_from_double(globalPos.x()), wl_fixed_from_double(globalPos.y()), button,
-            QtWaylandServer::dde_pointer::button_state::button_state_pressed);
+    const auto resources = d->resourceMap();
+    for (auto resource : resources) {
+        d->send_button(resource->handle, wl_fixed_from_double(globalPos.x()), wl_fixed_from_double(globalPos.y()), button,
+                QtWaylandServer::dde_pointer::button_state::button_state_pressed);
+    }
 }
 
 void DDEPointerInterface::buttonReleased(quint32 button)
 {
     const QPointF globalPos = d->ddeSeat->pointerPos();
-    d->send_button(wl_fixed_from_double(globalPos.x()), wl_fixed_from_double(globalPos.y()), button,
-            QtWaylandServer::dde_pointer::button_state::button_state_released);
+    const auto resources = d->resourceMap();
+    for (auto resource : resources) {
+        d->send_button(resource->handle, wl_fixed_from_double(globalPos.x()), wl_fixed_from_double(globalPos.y()), button,
+                QtWaylandServer::dde_pointer::button_state::button_state_released);
+    }
 }
 
 void DDEPointerInterface::axis(Qt::Orientation orientation, qint32 delta)
 {
-    d->send_axis(0, (orientation == Qt::Vertical) ? WL_POINTER_AXIS_VERTICAL_SCROLL : WL_POINTER_AXIS_HORIZONTAL_SCROLL,
-            wl_fixed_from_int(delta));
+    const auto resources = d->resourceMap();
+    for (auto resource : resources) {
+        d->send_axis(resource->handle, 0, (orientation == Qt::Vertical) ? WL_POINTER_AXIS_VERTICAL_SCROLL : WL_POINTER_AXIS_HORIZONTAL_SCROLL,
+                wl_fixed_from_int(delta));
+    }
 }
 
 void DDEPointerInterface::sendMotion(const QPointF &position)
 {
-    d->send_motion(wl_fixed_from_double(position.x()), wl_fixed_from_double(position.y()));
+    d->sendMotion(position);
 }
 
 /*********************************
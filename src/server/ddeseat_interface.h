@@ -14,6 +14,7 @@ struct wl_resource;
 
 namespace KWaylandServer
 {
+class ClientConnection;
 class Display;
 class DDEPointerInterface;
 class DDEKeyboardInterface;
@@ -46,12 +47,32 @@ public:
 
     void pointerAxis(Qt::Orientation orientation, qint32 delta);
 
+    /**
+     * Limits the motion events of the dde pointer and of every touch point of the dde touch
+     * to one per @p msec milliseconds. Motion within the interval is not sent right away,
+     * the listener gets the latest position once the interval has passed, or together with
+     * the next button, axis or touch up event. Clients following the global input don't
+     * need every motion event, this keeps them from waking up at the rate of the input device.
+     *
+     * The default of 0 sends every motion event.
+     **/
+    void setMotionInterval(int msec);
+    int motionInterval() const;
+
     void setTimestamp(quint32 time);
     void setTouchTimestamp(quint32 time);
     quint32 timestamp() const;
     quint32 touchtimestamp() const;
 
+    /**
+     * Copies the keymap of @p size bytes from @p fd, the descriptor isn't used afterwards.
+     * @see setKeymap(const QByteArray &)
+     **/
     void setKeymap(int fd, quint32 size);
+    /**
+     * Stores the keymap @p content in a read-only file that is shared by all dde keyboards.
+     **/
+    void setKeymap(const QByteArray &content);
     void keyPressed(quint32 key);
     void keyReleased(quint32 key);
     void updateKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group);
@@ -97,8 +118,56 @@ class KWAYLANDSERVER_EXPORT DDEPointerInterface : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * Selects which pointer positions a client gets as motion events.
+     **/
+    enum class MotionMode {
+        /**
+         * Every position is sent, this is the default.
+         **/
+        Full,
+        /**
+         * At most one motion event is sent per throttle interval, carrying the latest position.
+         **/
+        Throttled,
+        /**
+         * A motion event is only sent when the pointer enters or leaves the hot region of the
+         * client, e.g. for hot corners or to reveal an auto-hidden dock.
+         **/
+        Regions,
+    };
+    Q_ENUM(MotionMode)
+
     ~DDEPointerInterface() override;
 
+    /**
+     * Sets the motion @p mode of the dde pointers bound by @p client. Clients following the
+     * global pointer only for hot corners or similar don't need to wake up for every
+     * position the mouse reports.
+     *
+     * Button and axis events are always sent, and the client can query the current position
+     * at any time.
+     *
+     * @see setThrottleInterval
+     * @see setHotRegion
+     **/
+    void setMotionMode(ClientConnection *client, MotionMode mode);
+    MotionMode motionMode(ClientConnection *client) const;
+
+    /**
+     * Sets the hot @p region, in global coordinates, of @p client for MotionMode::Regions.
+     **/
+    void setHotRegion(ClientConnection *client, const QRegion &region);
+    QRegion hotRegion(ClientConnection *client) const;
+
+    /**
+     * Sets the interval in milliseconds between the motion events of clients in
+     * MotionMode::Throttled. The compositor usually passes the refresh interval of the output
+     * the pointer is on. The default is 16 milliseconds.
+     **/
+    void setThrottleInterval(int msec);
+    int throttleInterval() const;
+
     /**
      * @returns The DDESeatInterface which created this DDEPointerInterface.
      **/
@@ -8,16 +8,73 @@
 
 // KWayland
 #include "ddeseat_interface.h"
+#include "keymapfile.h"
+#include "utils_p.h"
 // Qt
+#include <QElapsedTimer>
 #include <QHash>
 #include <QMap>
 #include <QPointer>
 #include <QPointF>
+#include <QRegion>
+#include <QScopedPointer>
+#include <QTimer>
+
+#include <functional>
 
 #include "qwayland-server-dde-seat.h"
 
 namespace KWaylandServer
 {
+class DDEKeyboardInterfacePrivate;
+
+/**
+ * Limits motion streams, e.g. the dde pointer or a touch point, to one event per interval.
+ * A motion within the interval is held back, and the latest held back position of a stream
+ * is due once the interval since its last motion passed.
+ */
+class MotionRateLimiter
+{
+public:
+    struct Stream {
+        qint64 lastMotionTime = -1;
+        bool pending = false;
+        QPointF pendingPosition;
+    };
+
+    /**
+     * @p flush gets called when held back motion is due, it passes the due streams to takeDue().
+     */
+    explicit MotionRateLimiter(const std::function<void()> &flush);
+
+    int interval() const;
+    void setInterval(int msec);
+
+    /**
+     * Returns @c true if the motion to @p position of @p stream can be sent right away,
+     * otherwise it is held back.
+     */
+    bool pass(Stream &stream, const QPointF &position);
+    /**
+     * Takes the held back motion of @p stream regardless of the interval, e.g. before a button
+     * event which must not overtake it. Returns @c false if there is none.
+     */
+    bool take(Stream &stream, QPointF *position);
+    /**
+     * Like take(), but only once the held back motion is due, otherwise the flush is
+     * scheduled again.
+     */
+    bool takeDue(Stream &stream, QPointF *position);
+    void stop();
+
+private:
+    void schedule(qint64 msec);
+
+    int m_interval = 0;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
 class DDESeatInterfacePrivate : public QtWaylandServer::dde_seat
 {
 public:
@@ -42,13 +99,14 @@ public:
             Released,
             Pressed
         };
-        QHash<quint32, State> states;
+        SmallFlatSet<quint32, 16> pressedKeys;
         struct Keymap {
             int fd = -1;
             quint32 size = 0;
             bool xkbcommonCompatible = false;
         };
         Keymap keymap;
+        QScopedPointer<KeymapFile> keymapFile;
         struct Modifiers {
             quint32 depressed = 0;
             quint32 latched = 0;
@@ -65,6 +123,17 @@ public:
     };
     Keyboard keys;
     bool updateKey(quint32 key, Keyboard::State state);
+    void sendKeymap(DDEKeyboardInterfacePrivate *keyboard, wl_resource *resource);
+    void sendKey(quint32 key, Keyboard::State state);
+
+    // Motion rate limit, the dde pointer and every touch point of the dde touch are limited on their own
+    void flushMotion();
+    void flushPointerMotion();
+    void flushTouchMotion(qint32 id);
+
+    MotionRateLimiter motionLimiter;
+    MotionRateLimiter::Stream pointerMotion;
+    SmallFlatMap<qint32, MotionRateLimiter::Stream, 10> touchMotions;
 
 protected:
     // interface
@@ -81,9 +150,27 @@ public:
     DDEPointerInterfacePrivate(DDEPointerInterface *q, DDESeatInterface *seat, wl_resource *resource);
     ~DDEPointerInterfacePrivate() override;
 
+    struct Subscription;
+    Subscription &subscription(ClientConnection *client);
+    bool shouldSendMotion(wl_client *client, const QPointF &position);
+    void sendMotion(const QPointF &position);
+    void sendMotion(wl_client *client, const QPointF &position);
+    void flushThrottledMotion();
+
     DDEPointerInterface *q;
     DDESeatInterface *ddeSeat;
 
+    // clients the compositor didn't configure get every motion event and have no entry, the
+    // entry of a client goes away with its ClientConnection
+    struct Subscription {
+        DDEPointerInterface::MotionMode mode = DDEPointerInterface::MotionMode::Full;
+        QRegion hotRegion;
+        bool inHotRegion = false;
+        MotionRateLimiter::Stream motion;
+    };
+    QHash<wl_client *, Subscription> subscriptions;
+    MotionRateLimiter throttle;
+
 protected:
     void dde_pointer_get_motion(Resource *resource) override;
 };
@@ -40,10 +40,15 @@ public:
 
     void setState(dde_shell_state flag, bool set);
     void sendGeometry(const QRect &geom);
+    void sendChanges();
+
+    int updateDepth = 0;
 
 private:
     quint32 m_state = 0;
+    quint32 m_sentState = 0;
     QRect m_geometry;
+    QRect m_sentGeometry;
 
     void dde_shell_surface_destroy_resource(Resource *resource) override;
 
@@ -140,7 +145,9 @@ void DDEShellSurfaceInterfacePrivate::setState(dde_shell_state flag, bool set)
         return;
     }
     m_state = newState;
-    send_state_changed(m_state);
+    if (updateDepth == 0) {
+        sendChanges();
+    }
 }
 
 void DDEShellSurfaceInterfacePrivate::sendGeometry(const QRect &geometry)
@@ -149,10 +156,24 @@ void DDEShellSurfaceInterfacePrivate::sendGeometry(const QRect &geometry)
         return;
     }
     m_geometry = geometry;
-    if (!m_geometry.isValid()) {
-        return;
+    if (updateDepth == 0) {
+        sendChanges();
+    }
+}
+
+void DDEShellSurfaceInterfacePrivate::sendChanges()
+{
+    // states that got toggled back and forth during an update are not sent at all
+    if (m_sentState != m_state) {
+        m_sentState = m_state;
+        send_state_changed(m_state);
+    }
+    if (m_sentGeometry != m_geometry) {
+        m_sentGeometry = m_geometry;
+        if (m_geometry.isValid()) {
+            send_geometry(m_geometry.x(), m_geometry.y(), m_geometry.width(), m_geometry.height());
+        }
     }
-    send_geometry(m_geometry.x(), m_geometry.y(), m_geometry.width(), m_geometry.height());
 }
 
 DDEShellSurfaceInterfacePrivate::DDEShellSurfaceInterfacePrivate(DDEShellSurfaceInterface *_q, SurfaceInterface *_surface, wl_resource *resource)
@@ -324,8 +345,23 @@ void DDEShellSurfaceInterface::sendGeometry(const QRect &geom)
     d->sendGeometry(geom);
 }
 
+void DDEShellSurfaceInterface::beginUpdate()
+{
+    ++d->updateDepth;
+}
+
+void DDEShellSurfaceInterface::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth == 0) {
+        d->sendChanges();
+    }
+}
+
 void DDEShellSurfaceInterface::sendSplitable(int splitable)
 {
+    // the split flags are exclusive, the client has to get them in one event
+    beginUpdate();
     if (splitable == 0) {
         d->setState(DDE_SHELL_STATE_NO_SPLIT, true);
         d->setState(DDE_SHELL_STATE_TWO_SPLIT, false);
@@ -340,6 +376,7 @@ void DDEShellSurfaceInterface::sendSplitable(int splitable)
             d->setState(DDE_SHELL_STATE_FOUR_SPLIT, true);
         }
     }
+    endUpdate();
 }
 
 }
@@ -85,6 +85,23 @@ public:
     void setAcceptFocus(bool set);
     void setModal(bool set);
 
+    /**
+     * Starts an update of several states at once, e.g. a window that gets maximized and
+     * activated, or of its states and geometry.
+     *
+     * Until the matching endUpdate() the changes are not sent to the client. Afterwards the
+     * final state is sent in a single state_changed event and the geometry once, so the client
+     * reacts to all the changes together. Updates can be nested, the changes are sent when the
+     * outermost update ends.
+     *
+     * @see endUpdate
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate() and sends the changes.
+     */
+    void endUpdate();
+
 Q_SIGNALS:
     void activationRequested();
     void activeRequested(bool set);
@@ -5,17 +5,33 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "display.h"
+#include "clientbuffer_p.h"
 #include "clientbufferintegration.h"
+#include "clientconnection_p.h"
+#include "committrace_p.h"
 #include "display_p.h"
 #include "drmclientbuffer.h"
 #include "logging.h"
 #include "output_interface.h"
+#include "output_interface_p.h"
+#include "seat_interface.h"
 #include "shmclientbuffer.h"
+#include "textinput_v3_interface.h"
 
 #include <QAbstractEventDispatcher>
-#include <QCoreApplication>
 #include <QDebug>
 #include <QRect>
+#include <QThread>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <wayland-server-protocol.h>
 
 namespace KWaylandServer
 {
@@ -41,11 +57,18 @@ Display::Display(QObject *parent)
 {
     d->display = wl_display_create();
     d->loop = wl_display_get_event_loop(d->display);
+    // the ClientConnection is set up as soon as a client connects, not with its first request
+    d->clientCreatedListener.listener.notify = DisplayPrivate::clientCreatedCallback;
+    d->clientCreatedListener.display = d.data();
+    wl_display_add_client_created_listener(d->display, &d->clientCreatedListener.listener);
 }
 
 Display::~Display()
 {
     wl_display_destroy_clients(d->display);
+    if (d->protocolLogger) {
+        wl_protocol_logger_destroy(d->protocolLogger);
+    }
     wl_display_destroy(d->display);
 }
 
@@ -80,12 +103,52 @@ bool Display::addSocketName(const QString &name)
     return true;
 }
 
+int Display::addActivatedSockets()
+{
+    // the first file descriptor passed by the service manager, SD_LISTEN_FDS_START
+    constexpr int firstFileDescriptor = 3;
+
+    bool ok = false;
+    const int pid = qEnvironmentVariableIntValue("LISTEN_PID", &ok);
+    if (!ok || pid != getpid()) {
+        return 0;
+    }
+    const int count = qEnvironmentVariableIntValue("LISTEN_FDS", &ok);
+    const QStringList names = qEnvironmentVariable("LISTEN_FDNAMES").split(QLatin1Char(':'));
+    qunsetenv("LISTEN_PID");
+    qunsetenv("LISTEN_FDS");
+    qunsetenv("LISTEN_FDNAMES");
+    if (!ok) {
+        return 0;
+    }
+
+    int added = 0;
+    for (int i = 0; i < count; ++i) {
+        const int fileDescriptor = firstFileDescriptor + i;
+        fcntl(fileDescriptor, F_SETFD, FD_CLOEXEC);
+        QString name = names.value(i);
+        if (name == QLatin1String("unknown")) {
+            // the name systemd uses for sockets without a FileDescriptorName
+            name.clear();
+        }
+        if (addSocketFileDescriptor(fileDescriptor, name)) {
+            ++added;
+        }
+    }
+    return added;
+}
+
 QStringList Display::socketNames() const
 {
     return d->socketNames;
 }
 
 bool Display::start()
+{
+    return start(EventLoopIntegration::Qt);
+}
+
+bool Display::start(EventLoopIntegration integration)
 {
     if (d->running) {
         return true;
@@ -97,11 +160,20 @@ bool Display::start()
         return false;
     }
 
-    d->socketNotifier = new QSocketNotifier(fileDescriptor, QSocketNotifier::Read, this);
-    connect(d->socketNotifier, &QSocketNotifier::activated, this, &Display::dispatchEvents);
+    if (integration == EventLoopIntegration::Qt) {
+        // the display might live in a dedicated protocol thread
+        QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread());
+        if (!dispatcher) {
+            qCWarning(KWAYLAND_SERVER) << "The thread of the display has no event dispatcher";
+            return false;
+        }
 
-    QAbstractEventDispatcher *dispatcher = QCoreApplication::eventDispatcher();
-    connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &Display::flush);
+        d->socketNotifier = new QSocketNotifier(fileDescriptor, QSocketNotifier::Read, this);
+        connect(d->socketNotifier, &QSocketNotifier::activated, this, [this]() {
+            dispatchEvents();
+        });
+        connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &Display::flush);
+    }
 
     d->running = true;
     Q_EMIT runningChanged(true);
@@ -111,20 +183,515 @@ bool Display::start()
 
 void Display::dispatchEvents()
 {
-    if (wl_event_loop_dispatch(d->loop, 0) != 0) {
+    dispatchEvents(0);
+}
+
+void Display::dispatchEvents(int timeout)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    const auto start = std::chrono::steady_clock::now();
+    d->dispatching = d->clientDispatchBudget > std::chrono::microseconds::zero();
+    d->dispatchingEvents = true;
+    if (wl_event_loop_dispatch(d->loop, timeout) != 0) {
         qCWarning(KWAYLAND_SERVER) << "Error on dispatching Wayland event loop";
     }
+    d->dispatchingEvents = false;
+    d->runDispatchCallbacks();
+    if (d->dispatching) {
+        d->dispatching = false;
+        d->finishDispatchAccounting();
+    }
+    d->finishAllocationAccounting();
+    const std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - start;
+    d->dispatchTime += duration;
+    if (d->protocolStatisticsEnabled) {
+        d->countDispatch(duration);
+    }
 }
 
-void Display::flush()
+void DisplayPrivate::runAfterDispatch(QObject *context, std::function<void()> callback)
+{
+    if (!dispatchingEvents) {
+        callback();
+        return;
+    }
+    dispatchCallbacks.append({context, std::move(callback)});
+}
+
+void DisplayPrivate::runDispatchCallbacks()
+{
+    const auto callbacks = std::exchange(dispatchCallbacks, {});
+    for (const auto &[context, callback] : callbacks) {
+        if (context) {
+            callback();
+        }
+    }
+}
+
+int Display::eventLoopFileDescriptor() const
+{
+    return wl_event_loop_get_fd(d->loop);
+}
+
+void DisplayPrivate::logProtocol(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    auto d = static_cast<DisplayPrivate *>(data);
+    wl_client *client = wl_resource_get_client(message->resource);
+    const bool countAllocations = d->protocolStatisticsEnabled && type == WL_PROTOCOL_LOGGER_REQUEST && AllocationTracker::isAvailable();
+    if (countAllocations) {
+        // the request is logged right before its handler is invoked
+        d->finishAllocationAccounting();
+    }
+    if (d->protocolStatisticsEnabled) {
+        d->countMessage(type, message);
+    }
+    switch (type) {
+    case WL_PROTOCOL_LOGGER_REQUEST:
+        if (d->dispatching) {
+            d->accountRequest(client);
+        }
+        if (d->resourceAccountingEnabled) {
+            if (ClientConnection *connection = ClientConnectionPrivate::get(client)) {
+                ClientConnectionPrivate::get(connection)->accountShmPoolRequest(message);
+            }
+        }
+        break;
+    case WL_PROTOCOL_LOGGER_EVENT:
+        if (d->flushDirtyClientsOnly) {
+            d->markClientDirty(client);
+        }
+        break;
+    }
+    if (countAllocations) {
+        // the allocations of the logger itself are not counted
+        d->allocatingRequest = message->message;
+        d->allocationsSince = AllocationTracker::counters();
+    }
+}
+
+void DisplayPrivate::finishAllocationAccounting()
+{
+    if (!allocatingRequest) {
+        return;
+    }
+    const AllocationTracker::Counters counters = AllocationTracker::counters();
+    auto it = messageCounters.find(std::exchange(allocatingRequest, nullptr));
+    if (it != messageCounters.end()) {
+        it->allocations += counters.allocations - allocationsSince.allocations;
+        it->allocatedBytes += counters.bytes - allocationsSince.bytes;
+    }
+}
+
+void DisplayPrivate::updateProtocolLogger()
+{
+    const bool needed = clientDispatchBudget > std::chrono::microseconds::zero() || flushDirtyClientsOnly || protocolStatisticsEnabled || resourceAccountingEnabled;
+    if (needed && !protocolLogger) {
+        protocolLogger = wl_display_add_protocol_logger(display, logProtocol, this);
+    } else if (!needed && protocolLogger) {
+        wl_protocol_logger_destroy(protocolLogger);
+        protocolLogger = nullptr;
+    }
+}
+
+void DisplayPrivate::accountRequest(wl_client *client)
+{
+    // the request is logged right before its handler is invoked, so the previous request
+    // of the dispatch has been handled by now
+    const auto now = std::chrono::steady_clock::now();
+    if (dispatchingClient) {
+        ClientConnectionPrivate::get(dispatchingClient)->cycleDispatchTime += now - dispatchingSince;
+    }
+    ClientConnection *connection = q->getConnection(client);
+    auto connectionPrivate = ClientConnectionPrivate::get(connection);
+    if (connectionPrivate->cycleDispatchTime == std::chrono::nanoseconds::zero() && !dispatchedClients.contains(connection)) {
+        dispatchedClients.append(connection);
+    }
+    ++connectionPrivate->dispatchedRequests;
+    dispatchingClient = connection;
+    dispatchingSince = now;
+}
+
+void DisplayPrivate::finishDispatchAccounting()
+{
+    if (dispatchingClient) {
+        ClientConnectionPrivate::get(dispatchingClient)->cycleDispatchTime += std::chrono::steady_clock::now() - dispatchingSince;
+        dispatchingClient = nullptr;
+    }
+
+    const QVector<QPointer<ClientConnection>> clients = std::exchange(dispatchedClients, {});
+    for (const QPointer<ClientConnection> &connection : clients) {
+        if (!connection) {
+            continue;
+        }
+        auto connectionPrivate = ClientConnectionPrivate::get(connection);
+        const std::chrono::nanoseconds time = std::exchange(connectionPrivate->cycleDispatchTime, std::chrono::nanoseconds::zero());
+        connectionPrivate->dispatchTime += time;
+        if (time > clientDispatchBudget) {
+            Q_EMIT connection->dispatchBudgetExceeded();
+        }
+    }
+}
+
+void DisplayPrivate::markClientDirty(wl_client *client)
+{
+    ClientConnection *connection = ClientConnectionPrivate::get(client);
+    if (!connection) {
+        // don't create a connection from within libwayland, e.g. for a client being destroyed
+        flushAllClients = true;
+        return;
+    }
+    auto connectionPrivate = ClientConnectionPrivate::get(connection);
+    if (!connectionPrivate->flushPending) {
+        connectionPrivate->flushPending = true;
+        dirtyClients.append(connection);
+    }
+}
+
+void DisplayPrivate::flushClients()
+{
+    const bool flushedAllClients = !flushDirtyClientsOnly || flushAllClients;
+    if (flushedAllClients) {
+        wl_display_flush_clients(display);
+    }
+    flushAllClients = false;
+    const QVector<ClientConnection *> flushedClients = std::exchange(dirtyClients, {});
+    bool flushFailed = false;
+    for (ClientConnection *connection : flushedClients) {
+        ClientConnectionPrivate::get(connection)->flushPending = false;
+        if (flushedAllClients) {
+            continue;
+        }
+        // wl_client_flush doesn't return whether it failed, only sendmsg sets errno
+        errno = 0;
+        wl_client_flush(connection->client());
+        if (errno != 0) {
+            flushFailed = true;
+        }
+    }
+    if (flushFailed) {
+        // wl_display_flush_clients retries the failed clients, watches the ones whose socket
+        // is full (EAGAIN) until they can take the rest and destroys the disconnected ones
+        wl_display_flush_clients(display);
+    }
+    if (clientCongestionThreshold != 0) {
+        // only the clients that got events can have become congested
+        updateClientCongestion(flushedAllClients ? clients : flushedClients + congestedClients);
+    }
+}
+
+void DisplayPrivate::updateClientCongestion(QVector<ClientConnection *> connections)
+{
+    for (ClientConnection *connection : qAsConst(connections)) {
+        ClientConnectionPrivate::get(connection)->updateCongestion(clientCongestionThreshold);
+    }
+}
+
+void DisplayPrivate::updateCongestionTimer()
+{
+    if (congestedClients.isEmpty()) {
+        if (congestionTimer) {
+            congestionTimer->stop();
+        }
+        return;
+    }
+    if (!congestionTimer) {
+        congestionTimer = new QTimer(q);
+        congestionTimer->setInterval(100);
+        QObject::connect(congestionTimer, &QTimer::timeout, q, [this] {
+            updateClientCongestion(congestedClients);
+        });
+    }
+    if (!congestionTimer->isActive()) {
+        congestionTimer->start();
+    }
+}
+
+static quint32 paddedSize(quint32 size)
+{
+    return (size + 3) & ~3u;
+}
+
+/**
+ * The size of the @p message on the wire, as computed by libwayland's wl_closure_send.
+ */
+static quint32 wireSize(const wl_protocol_logger_message *message)
+{
+    quint32 size = 8;
+    int argument = 0;
+    for (const char *signature = message->message->signature; *signature; ++signature) {
+        switch (*signature) {
+        case 'i':
+        case 'u':
+        case 'f':
+        case 'o':
+        case 'n':
+            size += 4;
+            break;
+        case 's': {
+            const char *string = message->arguments[argument].s;
+            size += 4 + (string ? paddedSize(strlen(string) + 1) : 0);
+            break;
+        }
+        case 'a': {
+            const wl_array *array = message->arguments[argument].a;
+            size += 4 + (array ? paddedSize(array->size) : 0);
+            break;
+        }
+        case 'h':
+            // passed as ancillary data
+            break;
+        default:
+            // the version and nullability markers don't take an argument
+            continue;
+        }
+        ++argument;
+    }
+    return size;
+}
+
+void DisplayPrivate::countMessage(wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    MessageCounter &counter = messageCounters[message->message];
+    if (!counter.interface) {
+        counter.interface = wl_resource_get_class(message->resource);
+        counter.event = type == WL_PROTOCOL_LOGGER_EVENT;
+    }
+    ++counter.count;
+
+    if (type == WL_PROTOCOL_LOGGER_EVENT) {
+        if (ClientConnection *connection = ClientConnectionPrivate::get(wl_resource_get_client(message->resource))) {
+            ClientConnectionPrivate::get(connection)->bytesSent += wireSize(message);
+        }
+    }
+}
+
+void DisplayPrivate::countDispatch(std::chrono::nanoseconds duration)
+{
+    static const int s_bucketCount = 24;
+    if (dispatchTimeHistogram.isEmpty()) {
+        dispatchTimeHistogram.fill(0, s_bucketCount);
+    }
+    const qint64 microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    int bucket = 0;
+    while (bucket < s_bucketCount - 1 && (qint64(1) << bucket) <= microseconds) {
+        ++bucket;
+    }
+    ++dispatchTimeHistogram[bucket];
+}
+
+void Display::setProtocolStatisticsEnabled(bool enabled)
+{
+    d->protocolStatisticsEnabled = enabled;
+    d->updateProtocolLogger();
+}
+
+bool Display::protocolStatisticsEnabled() const
+{
+    return d->protocolStatisticsEnabled;
+}
+
+ProtocolStatistics Display::protocolStatistics() const
+{
+    ProtocolStatistics statistics;
+    for (auto it = d->messageCounters.constBegin(); it != d->messageCounters.constEnd(); ++it) {
+        ProtocolStatistics::Message message;
+        message.interface = QByteArray(it->interface);
+        message.name = QByteArray(it.key()->name);
+        message.count = it->count;
+        message.allocations = it->allocations;
+        message.allocatedBytes = it->allocatedBytes;
+        if (it->event) {
+            statistics.events.append(message);
+        } else {
+            statistics.requests.append(message);
+        }
+    }
+    statistics.dispatchTimeHistogram = d->dispatchTimeHistogram;
+    statistics.allocationsTracked = AllocationTracker::isAvailable();
+    return statistics;
+}
+
+void Display::resetProtocolStatistics()
+{
+    d->messageCounters.clear();
+    d->allocatingRequest = nullptr;
+    d->dispatchTimeHistogram.clear();
+    for (ClientConnection *connection : qAsConst(d->clients)) {
+        ClientConnectionPrivate::get(connection)->bytesSent = 0;
+    }
+}
+
+void Display::setCommitTracingEnabled(bool enabled)
+{
+    d->commitTracingEnabled = enabled;
+}
+
+bool Display::commitTracingEnabled() const
+{
+    return d->commitTracingEnabled;
+}
+
+QByteArray Display::exportCommitTrace() const
+{
+    QVector<QSharedPointer<CommitTrace>> traces;
+    traces.reserve(d->commitTraces.count());
+    for (const QWeakPointer<CommitTrace> &trace : qAsConst(d->commitTraces)) {
+        if (QSharedPointer<CommitTrace> strong = trace.toStrongRef()) {
+            traces.append(strong);
+        }
+    }
+    return CommitTrace::toChromeTrace(traces);
+}
+
+void Display::setSurfaceSnapshotsEnabled(bool enabled)
+{
+    d->surfaceSnapshotsEnabled = enabled;
+}
+
+bool Display::surfaceSnapshotsEnabled() const
+{
+    return d->surfaceSnapshotsEnabled;
+}
+
+void DisplayPrivate::clientCreatedCallback(wl_listener *listener, void *data)
+{
+    ClientCreatedListener *clientCreatedListener = wl_container_of(listener, clientCreatedListener, listener);
+    clientCreatedListener->display->q->getConnection(static_cast<wl_client *>(data));
+}
+
+void Display::setResourceAccountingEnabled(bool enabled)
+{
+    if (d->resourceAccountingEnabled == enabled) {
+        return;
+    }
+    d->resourceAccountingEnabled = enabled;
+    for (ClientConnection *connection : qAsConst(d->clients)) {
+        if (enabled) {
+            ClientConnectionPrivate::get(connection)->startResourceAccounting();
+        } else {
+            ClientConnectionPrivate::get(connection)->stopResourceAccounting();
+        }
+    }
+    d->updateProtocolLogger();
+}
+
+bool Display::resourceAccountingEnabled() const
+{
+    return d->resourceAccountingEnabled;
+}
+
+void Display::setClientResourceLimits(const ClientResourceLimits &limits)
+{
+    d->clientResourceLimits = limits;
+}
+
+ClientResourceLimits Display::clientResourceLimits() const
+{
+    return d->clientResourceLimits;
+}
+
+void Display::setClientCongestionThreshold(quint32 bytes)
+{
+    if (d->clientCongestionThreshold == bytes) {
+        return;
+    }
+    d->clientCongestionThreshold = bytes;
+    // relieves every client if the threshold got disabled
+    d->updateClientCongestion(d->clients);
+}
+
+quint32 Display::clientCongestionThreshold() const
+{
+    return d->clientCongestionThreshold;
+}
+
+void Display::setClientDispatchBudget(std::chrono::microseconds budget)
+{
+    d->clientDispatchBudget = budget;
+    d->updateProtocolLogger();
+}
+
+std::chrono::microseconds Display::clientDispatchBudget() const
+{
+    return d->clientDispatchBudget;
+}
+
+void Display::setDamageRectBudget(int budget)
+{
+    d->damageRectBudget = std::max(budget, 1);
+}
+
+int Display::damageRectBudget() const
 {
+    return d->damageRectBudget;
+}
+
+void Display::setShmRetentionBudget(qint64 bytes)
+{
+    d->shmRetentionBudget = std::max<qint64>(bytes, 0);
+}
+
+qint64 Display::shmRetentionBudget() const
+{
+    return d->shmRetentionBudget;
+}
+
+qint64 Display::retainedShmBytes() const
+{
+    return d->retainedShmBytes;
+}
+
+void Display::setFlushDirtyClientsOnly(bool dirtyOnly)
+{
+    if (d->flushDirtyClientsOnly == dirtyOnly) {
+        return;
+    }
+    // the events sent so far have not been tracked
     wl_display_flush_clients(d->display);
+    if (!dirtyOnly) {
+        for (ClientConnection *connection : qAsConst(d->dirtyClients)) {
+            ClientConnectionPrivate::get(connection)->flushPending = false;
+        }
+        d->dirtyClients.clear();
+    }
+    d->flushDirtyClientsOnly = dirtyOnly;
+    d->updateProtocolLogger();
+}
+
+bool Display::flushDirtyClientsOnly() const
+{
+    return d->flushDirtyClientsOnly;
+}
+
+std::chrono::nanoseconds Display::dispatchTime() const
+{
+    return d->dispatchTime;
+}
+
+std::chrono::nanoseconds Display::flushTime() const
+{
+    return d->flushTime;
+}
+
+void Display::flush()
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    const auto start = std::chrono::steady_clock::now();
+    for (SeatInterface *seat : qAsConst(d->seats)) {
+        seat->flushPointerMotion();
+        seat->flushPointerGestures();
+        seat->flushTouchMotion();
+        seat->textInputV3()->flushDone();
+    }
+    d->sendBufferReleases();
+    d->flushClients();
+    d->flushTime += std::chrono::steady_clock::now() - start;
 }
 
 void Display::createShm()
 {
     Q_ASSERT(d->display);
-    new ShmClientBufferIntegration(this);
+    d->shmBufferIntegration = new ShmClientBufferIntegration(this);
 }
 
 quint32 Display::nextSerial()
@@ -166,14 +733,25 @@ QVector<OutputInterface *> Display::outputsIntersecting(const QRect &rect) const
 {
     QVector<OutputInterface *> outputs;
     for (auto *output : qAsConst(d->outputs)) {
-        const QRect outputGeometry(output->globalPosition(), output->pixelSize() / output->scale());
-        if (rect.intersects(outputGeometry)) {
+        if (rect.intersects(OutputInterfacePrivate::get(output)->logicalGeometry)) {
             outputs << output;
         }
     }
     return outputs;
 }
 
+quint64 Display::outputMaskIntersecting(const QRect &rect) const
+{
+    quint64 mask = 0;
+    for (auto *output : qAsConst(d->outputs)) {
+        const OutputInterfacePrivate *outputPrivate = OutputInterfacePrivate::get(output);
+        if (outputPrivate->surfaceBit != -1 && rect.intersects(outputPrivate->logicalGeometry)) {
+            mask |= quint64(1) << outputPrivate->surfaceBit;
+        }
+    }
+    return mask;
+}
+
 QVector<SeatInterface *> Display::seats() const
 {
     return d->seats;
@@ -182,11 +760,8 @@ QVector<SeatInterface *> Display::seats() const
 ClientConnection *Display::getConnection(wl_client *client)
 {
     Q_ASSERT(client);
-    auto it = std::find_if(d->clients.constBegin(), d->clients.constEnd(), [client](ClientConnection *c) {
-        return c->client() == client;
-    });
-    if (it != d->clients.constEnd()) {
-        return *it;
+    if (ClientConnection *connection = ClientConnectionPrivate::get(client)) {
+        return connection;
     }
     // no ConnectionData yet, create it
     auto c = new ClientConnection(client, this);
@@ -196,6 +771,7 @@ ClientConnection *Display::getConnection(wl_client *client)
         Q_ASSERT(index != -1);
         d->clients.remove(index);
         Q_ASSERT(d->clients.indexOf(c) == -1);
+        d->dirtyClients.removeOne(c);
         Q_EMIT clientDisconnected(c);
     });
     Q_EMIT clientConnected(c);
@@ -233,68 +809,89 @@ void *Display::eglDisplay() const
     return d->eglDisplay;
 }
 
-struct ClientBufferDestroyListener : wl_listener {
-    ClientBufferDestroyListener(Display *display, ClientBuffer *buffer);
-    ~ClientBufferDestroyListener();
-
-    Display *display;
-};
-
-void bufferDestroyCallback(wl_listener *listener, void *data)
+static void bufferDestroyCallback(wl_listener *listener, void *data)
 {
-    ClientBufferDestroyListener *destroyListener = static_cast<ClientBufferDestroyListener *>(listener);
-    DisplayPrivate *displayPrivate = DisplayPrivate::get(destroyListener->display);
+    Q_UNUSED(data)
+    ClientBufferPrivate::DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+    ClientBuffer *buffer = destroyListener->buffer;
 
-    ClientBuffer *buffer = displayPrivate->q->clientBufferForResource(static_cast<wl_resource *>(data));
-    displayPrivate->unregisterClientBuffer(buffer);
+    wl_list_remove(&listener->link);
+    wl_list_init(&listener->link);
 
     buffer->markAsDestroyed();
 }
 
-ClientBufferDestroyListener::ClientBufferDestroyListener(Display *display, ClientBuffer *buffer)
-    : display(display)
-{
-    notify = bufferDestroyCallback;
-
-    link.prev = nullptr;
-    link.next = nullptr;
-
-    wl_resource_add_destroy_listener(buffer->resource(), this);
-}
-
-ClientBufferDestroyListener::~ClientBufferDestroyListener()
-{
-    wl_list_remove(&link);
-}
-
 ClientBuffer *Display::clientBufferForResource(wl_resource *resource) const
 {
-    ClientBuffer *buffer = d->resourceToBuffer.value(resource);
-    if (buffer) {
+    if (wl_listener *listener = wl_resource_get_destroy_listener(resource, bufferDestroyCallback)) {
+        ClientBufferPrivate::DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+        return destroyListener->buffer;
+    }
+
+    // Shm buffers are the most common ones and can be recognized without probing the
+    // other integrations.
+    if (d->shmBufferIntegration && wl_shm_buffer_get(resource)) {
+        ClientBuffer *buffer = d->shmBufferIntegration->createBuffer(resource);
+        if (buffer) {
+            d->registerClientBuffer(buffer, d->shmBufferIntegration);
+        }
         return buffer;
     }
 
     for (ClientBufferIntegration *integration : qAsConst(d->bufferIntegrations)) {
+        if (integration == d->shmBufferIntegration) {
+            continue;
+        }
         ClientBuffer *buffer = integration->createBuffer(resource);
         if (buffer) {
-            d->registerClientBuffer(buffer);
+            d->registerClientBuffer(buffer, integration);
             return buffer;
         }
     }
     return nullptr;
 }
 
-void DisplayPrivate::registerClientBuffer(ClientBuffer *buffer)
+quint32 DisplayPrivate::nextSerial(SerialHistory::Entry entry)
 {
-    resourceToBuffer.insert(buffer->resource(), buffer);
-    bufferToListener.insert(buffer, new ClientBufferDestroyListener(q, buffer));
+    entry.serial = wl_display_next_serial(display);
+    serialHistory.record(entry);
+    return entry.serial;
 }
 
-void DisplayPrivate::unregisterClientBuffer(ClientBuffer *buffer)
+void DisplayPrivate::registerClientBuffer(ClientBuffer *buffer, ClientBufferIntegration *integration)
 {
-    Q_ASSERT_X(buffer->resource(), "unregisterClientBuffer", "buffer must have valid resource");
-    resourceToBuffer.remove(buffer->resource());
-    delete bufferToListener.take(buffer);
+    ClientBufferPrivate *bufferPrivate = ClientBufferPrivate::get(buffer);
+    bufferPrivate->releasePolicy = integration->releasePolicy();
+    bufferPrivate->destroyListener.listener.notify = bufferDestroyCallback;
+    bufferPrivate->destroyListener.buffer = buffer;
+    bufferPrivate->display = this;
+    wl_resource_add_destroy_listener(buffer->resource(), &bufferPrivate->destroyListener.listener);
+}
+
+void DisplayPrivate::scheduleBufferRelease(ClientBuffer *buffer)
+{
+    ClientBufferPrivate *bufferPrivate = ClientBufferPrivate::get(buffer);
+    if (!bufferPrivate->releasePending) {
+        bufferPrivate->releasePending = true;
+        pendingBufferReleases.append(buffer);
+    }
+}
+
+void DisplayPrivate::cancelBufferRelease(ClientBuffer *buffer)
+{
+    ClientBufferPrivate::get(buffer)->releasePending = false;
+    pendingBufferReleases.removeOne(buffer);
+}
+
+void DisplayPrivate::sendBufferReleases()
+{
+    // Buffers that were referenced again or destroyed since are not in the list anymore.
+    const QVector<ClientBuffer *> buffers = std::exchange(pendingBufferReleases, {});
+    for (ClientBuffer *buffer : buffers) {
+        ClientBufferPrivate *bufferPrivate = ClientBufferPrivate::get(buffer);
+        bufferPrivate->releasePending = false;
+        bufferPrivate->sendRelease();
+    }
 }
 
 }
@@ -6,8 +6,12 @@
 */
 #pragma once
 
+#include <QByteArray>
 #include <QList>
 #include <QObject>
+#include <QVector>
+
+#include <chrono>
 
 #include <DWayland/Server/kwaylandserver_export.h>
 
@@ -39,9 +43,70 @@ class OutputInterface;
 class OutputDeviceV2Interface;
 class SeatInterface;
 
+/**
+ * A snapshot of the protocol statistics of a Display.
+ *
+ * @see Display::protocolStatistics
+ */
+struct KWAYLANDSERVER_EXPORT ProtocolStatistics {
+    struct Message {
+        /// the name of the interface, e.g. @c wl_surface
+        QByteArray interface;
+        /// the name of the request or event, e.g. @c commit
+        QByteArray name;
+        quint64 count = 0;
+        /**
+         * The heap allocations made while dispatching the requests, only counted if
+         * allocationsTracked is set. They include the allocations libwayland makes to read and
+         * demarshal the next request of the same dispatch. Always @c 0 for events.
+         */
+        quint64 allocations = 0;
+        /// the bytes requested by the allocations
+        quint64 allocatedBytes = 0;
+    };
+    /// the dispatched requests, one entry per interface and request that occurred
+    QVector<Message> requests;
+    /// the sent events, one entry per interface and event that occurred
+    QVector<Message> events;
+    /**
+     * The number of event loop dispatches by duration. Entry @c i counts the dispatches that
+     * took less than 2^i microseconds and, unless @c i is @c 0, at least 2^(i-1). The last
+     * entry also counts all longer dispatches.
+     */
+    QVector<quint64> dispatchTimeHistogram;
+    /**
+     * Whether the server library has been built with the DWAYLAND_ALLOCATION_TRACKING CMake
+     * option, which counts the allocations of the requests.
+     */
+    bool allocationsTracked = false;
+};
+
+/**
+ * The limits for the resources of every client of a Display. A limit of @c 0 means no limit.
+ *
+ * @see Display::setClientResourceLimits
+ */
+struct KWAYLANDSERVER_EXPORT ClientResourceLimits {
+    /// exceeding it emits ClientConnection::resourceLimitExceeded
+    quint32 softResourceCount = 0;
+    /// exceeding it posts @c no_memory to the client, which disconnects it
+    quint32 hardResourceCount = 0;
+    /// exceeding it emits ClientConnection::resourceLimitExceeded
+    quint64 softShmPoolBytes = 0;
+    /// exceeding it posts @c no_memory to the client, which disconnects it
+    quint64 hardShmPoolBytes = 0;
+};
+
 /**
  * @brief Class holding the Wayland server display loop.
  *
+ * The Display and every interface created for it belong to the thread the Display lives in
+ * when start is called. libwayland is not thread safe, so all requests are dispatched, all
+ * signals are emitted and all methods have to be called from that thread. The thread does
+ * not have to be the main thread: to keep protocol dispatch and input delivery independent
+ * of rendering stalls, the Display can live in its own QThread. The render thread then only
+ * talks to it through queued signals and QMetaObject::invokeMethod.
+ *
  * @todo Improve documentation
  */
 class KWAYLANDSERVER_EXPORT Display : public QObject
@@ -49,6 +114,26 @@ class KWAYLANDSERVER_EXPORT Display : public QObject
     Q_OBJECT
     Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
 public:
+    /**
+     * How the Wayland event loop is driven.
+     * @see start
+     */
+    enum class EventLoopIntegration {
+        /**
+         * The file descriptor of the event loop is watched with a QSocketNotifier and the
+         * clients are flushed whenever the Qt event loop is about to block.
+         */
+        Qt,
+        /**
+         * Nothing is hooked into the Qt event loop. The compositor has to call dispatchEvents
+         * when eventLoopFileDescriptor becomes readable, or run the Wayland event loop as its
+         * main loop by calling dispatchEvents with a timeout, and has to call flush before it
+         * goes to sleep.
+         */
+        External,
+    };
+    Q_ENUM(EventLoopIntegration)
+
     explicit Display(QObject *parent = nullptr);
     virtual ~Display();
 
@@ -74,6 +159,19 @@ public:
      * @see start()
      */
     bool addSocketName(const QString &name = QString());
+    /**
+     * Adds the listening sockets the compositor got passed by socket activation, e.g. from a
+     * systemd socket unit, see sd_listen_fds(3). The sockets are taken from the LISTEN_FDS and
+     * LISTEN_FDNAMES environment variables, which get unset so that child processes don't
+     * inherit them. Returns the number of sockets that have been added.
+     *
+     * The service manager keeps the sockets open, so clients that connect while the compositor
+     * is not running, e.g. during a restart, are queued and accepted once the sockets are added
+     * again.
+     *
+     * @see addSocketFileDescriptor()
+     */
+    int addActivatedSockets();
 
     /**
      * Returns the list of socket names that the display listens for client connections.
@@ -86,9 +184,240 @@ public:
     /**
      * Start accepting client connections. If the display has started successfully, this
      * function returns @c true; otherwise @c false is returned.
+     *
+     * The event loop is driven with EventLoopIntegration::Qt.
      */
     bool start();
+    /**
+     * Start accepting client connections. If the display has started successfully, this
+     * function returns @c true; otherwise @c false is returned.
+     *
+     * The @p integration decides how the Wayland event loop is driven. With
+     * EventLoopIntegration::Qt, the event dispatcher of the thread the Display lives in is
+     * used, so this has to be called once that thread runs its event loop.
+     */
+    bool start(EventLoopIntegration integration);
+    /**
+     * Dispatches the pending events of the Wayland event loop without waiting for new ones.
+     */
     void dispatchEvents();
+    /**
+     * Dispatches the pending events of the Wayland event loop. If there are none, it waits
+     * up to @p timeout milliseconds for them, @c -1 waits forever.
+     *
+     * @see EventLoopIntegration::External
+     */
+    void dispatchEvents(int timeout);
+    /**
+     * @returns the file descriptor of the Wayland event loop or @c -1 on failure; it becomes
+     * readable when there are events to dispatch
+     * @see EventLoopIntegration::External
+     */
+    int eventLoopFileDescriptor() const;
+
+    /**
+     * Sets whether flush only flushes the clients that got events since the last flush.
+     *
+     * Events are tracked with a protocol logger, which costs a bit for every sent event.
+     * It pays off with many mostly idle clients and frequent flushes. By default all clients
+     * are flushed.
+     *
+     * @see flush
+     */
+    void setFlushDirtyClientsOnly(bool dirtyOnly);
+    /**
+     * @returns whether flush only flushes the clients that got events since the last flush
+     * @see setFlushDirtyClientsOnly
+     */
+    bool flushDirtyClientsOnly() const;
+
+    /**
+     * @returns the total time spent in dispatchEvents
+     * @see flushTime
+     */
+    std::chrono::nanoseconds dispatchTime() const;
+    /**
+     * @returns the total time spent in flush
+     * @see dispatchTime
+     */
+    std::chrono::nanoseconds flushTime() const;
+
+    /**
+     * Sets the time the requests of a single client may take per dispatch of the event loop.
+     *
+     * libwayland dispatches all requests a client has sent at once, so an exceeded budget
+     * can't interrupt the client. Instead ClientConnection::dispatchBudgetExceeded is emitted
+     * after the dispatch, the compositor can then deprioritize or disconnect the client.
+     *
+     * While a budget is set, the dispatch time and the number of dispatched requests of every
+     * client is accounted, see ClientConnection::dispatchTime. This costs a clock read per
+     * request. A budget of zero, the default, disables the accounting.
+     *
+     * @see clientDispatchBudget
+     */
+    void setClientDispatchBudget(std::chrono::microseconds budget);
+    /**
+     * @returns the time the requests of a single client may take per dispatch of the event loop
+     * @see setClientDispatchBudget
+     */
+    std::chrono::microseconds clientDispatchBudget() const;
+
+    /**
+     * Sets the maximum number of damage rects a surface accumulates per commit.
+     *
+     * Some clients, e.g. terminals or toolkits repainting widget by widget, send hundreds of
+     * tiny damage rects per commit, which makes merging and mapping the damage quadratic. Once
+     * a surface exceeds the budget, its damage is merged into the bounding rects of horizontal
+     * bands, or into a single rect if there are too many bands. The damage never shrinks, it
+     * only gets coarser. The default is 32 rects.
+     */
+    void setDamageRectBudget(int budget);
+    /**
+     * @returns the maximum number of damage rects a surface accumulates per commit
+     * @see setDamageRectBudget
+     */
+    int damageRectBudget() const;
+
+    /**
+     * Sets the number of bytes the contents of destroyed shm buffers may take.
+     *
+     * When a client destroys a wl_buffer the compositor still uses, e.g. for a closing
+     * animation, the visible contents of the buffer are copied, so the client's shm pool can
+     * be released. Once the copies exceed the budget, the contents of further destroyed buffers
+     * are dropped and ShmClientBuffer::data returns a null image for them. The default is 64 MiB.
+     *
+     * @see retainedShmBytes
+     */
+    void setShmRetentionBudget(qint64 bytes);
+    /**
+     * @returns the number of bytes the contents of destroyed shm buffers may take
+     * @see setShmRetentionBudget
+     */
+    qint64 shmRetentionBudget() const;
+    /**
+     * @returns the number of bytes the contents of destroyed shm buffers take right now
+     * @see setShmRetentionBudget
+     */
+    qint64 retainedShmBytes() const;
+
+    /**
+     * Enables or disables the protocol statistics.
+     *
+     * While enabled, every request and event is counted per interface and message, the bytes
+     * sent to each client are summed up, see ClientConnection::bytesSent, and the durations
+     * of the event loop dispatches are collected in a histogram. This is meant to be cheap
+     * enough for production use, unlike WAYLAND_DEBUG. The statistics are disabled by default.
+     *
+     * @see protocolStatistics
+     */
+    void setProtocolStatisticsEnabled(bool enabled);
+    /**
+     * @returns whether the protocol statistics are enabled
+     * @see setProtocolStatisticsEnabled
+     */
+    bool protocolStatisticsEnabled() const;
+    /**
+     * @returns a snapshot of the protocol statistics collected so far
+     * @see setProtocolStatisticsEnabled
+     * @see resetProtocolStatistics
+     */
+    ProtocolStatistics protocolStatistics() const;
+    /**
+     * Discards the protocol statistics collected so far.
+     * @see protocolStatistics
+     */
+    void resetProtocolStatistics();
+
+    /**
+     * Enables or disables the recording of the surface commits.
+     *
+     * While enabled, every commit of a surface is recorded with its buffer type and size, the
+     * damaged area, the sub-surface synchronization and when its frame callbacks got sent, see
+     * SurfaceInterface::commitTrace. Each surface keeps its last 256 commits. Surfaces only
+     * allocate their trace once they commit while the recording is enabled, it is disabled by
+     * default.
+     *
+     * @see exportCommitTrace
+     */
+    void setCommitTracingEnabled(bool enabled);
+    /**
+     * @returns whether the surface commits are recorded
+     * @see setCommitTracingEnabled
+     */
+    bool commitTracingEnabled() const;
+    /**
+     * @returns the recorded commits of all surfaces in the JSON based Chrome trace event format,
+     * which can be loaded into chrome://tracing or Perfetto for offline analysis. Every client is
+     * a process and each of its surfaces a thread, a commit spans until its frame callbacks got
+     * sent. Only the commits of surfaces which still exist are exported.
+     * @see setCommitTracingEnabled
+     */
+    QByteArray exportCommitTrace() const;
+
+    /**
+     * Enables or disables the publishing of surface snapshots.
+     *
+     * While enabled, every commit of a surface publishes an immutable copy of its committed
+     * state for render threads, see SurfaceInterface::snapshot. This costs an allocation per
+     * commit, it is disabled by default. Disabling it drops the snapshots with the next commit
+     * of each surface.
+     */
+    void setSurfaceSnapshotsEnabled(bool enabled);
+    /**
+     * @returns whether the surfaces publish snapshots of their state
+     * @see setSurfaceSnapshotsEnabled
+     */
+    bool surfaceSnapshotsEnabled() const;
+
+    /**
+     * Enables or disables the accounting of the resources of every client.
+     *
+     * While enabled, the live resources of each client are counted by interface, as well as
+     * the size of its shm pools and the number of its dma-bufs, see
+     * ClientConnection::resourceCounts. This costs a small allocation per resource. A
+     * ClientConnection is created for every client as soon as it connects. The accounting is
+     * disabled by default.
+     *
+     * @see setClientResourceLimits
+     */
+    void setResourceAccountingEnabled(bool enabled);
+    /**
+     * @returns whether the resources of the clients are accounted
+     * @see setResourceAccountingEnabled
+     */
+    bool resourceAccountingEnabled() const;
+    /**
+     * Sets the @p limits for the resources of every client, they are only enforced while the
+     * resource accounting is enabled. By default there are no limits.
+     *
+     * @see setResourceAccountingEnabled
+     */
+    void setClientResourceLimits(const ClientResourceLimits &limits);
+    /**
+     * @returns the limits for the resources of every client
+     * @see setClientResourceLimits
+     */
+    ClientResourceLimits clientResourceLimits() const;
+    /**
+     * Sets the number of @p bytes queued on the socket of a client, above which the client is
+     * considered congested. The queue is measured whenever the client is flushed.
+     *
+     * A client that stops reading its events would otherwise make libwayland buffer them
+     * without bound, until it disconnects the client because its buffer is full. Events which
+     * only carry the latest state are held back for a congested client instead, and the
+     * compositor gets notified through ClientConnection::congested, e.g. to stop sending it
+     * further updates.
+     *
+     * A threshold of @c 0, the default, disables the congestion handling.
+     *
+     * @see ClientConnection::isCongested
+     */
+    void setClientCongestionThreshold(quint32 bytes);
+    /**
+     * @returns the number of queued bytes above which a client is considered congested
+     * @see setClientCongestionThreshold
+     */
+    quint32 clientCongestionThreshold() const;
 
     /**
      * Create a client for the given file descriptor.
@@ -114,7 +443,20 @@ public:
     QVector<SeatInterface*> seats() const;
     QList<OutputDeviceV2Interface *> outputDevices() const;
     QList<OutputInterface *> outputs() const;
+    /**
+     * @returns the outputs whose area in the global compositor space, the global position and
+     * the pixel size divided by the scale, intersects @p rect. The areas are cached, they are
+     * only computed again when the mode, the position or the scale of an output changes.
+     */
     QVector<OutputInterface *> outputsIntersecting(const QRect &rect) const;
+    /**
+     * @returns a mask of the outputs intersecting @p rect, with one bit per output that stays
+     * the same as long as the output exists. A window which moved without changing the mask
+     * doesn't need to update SurfaceInterface::setOutputs. Only the first 64 outputs get a
+     * bit, the mask is incomplete beyond that.
+     * @see outputsIntersecting
+     */
+    quint64 outputMaskIntersecting(const QRect &rect) const;
 
     /**
      * Gets the ClientConnection for the given @p client.
@@ -146,7 +488,15 @@ public:
      */
     ClientBuffer *clientBufferForResource(wl_resource *resource) const;
 
-private Q_SLOTS:
+public Q_SLOTS:
+    /**
+     * Sends out the coalesced input events and the pending buffer releases and flushes
+     * the clients.
+     *
+     * With EventLoopIntegration::Qt this is done whenever the Qt event loop is about to block.
+     *
+     * @see setFlushDirtyClientsOnly
+     */
     void flush();
 
 Q_SIGNALS:
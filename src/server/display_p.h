@@ -12,9 +12,20 @@
 #include <QHash>
 #include <QList>
 #include <QSocketNotifier>
+#include <QSharedPointer>
 #include <QString>
+#include <QTimer>
+#include <QPointer>
 #include <QVector>
 
+#include "allocationtracker.h"
+#include "display.h"
+#include "serialhistory.h"
+#include "timerwheel.h"
+
+#include <chrono>
+#include <functional>
+
 #include <EGL/egl.h>
 
 struct wl_resource;
@@ -28,7 +39,8 @@ class Display;
 class OutputInterface;
 class OutputDeviceV2Interface;
 class SeatInterface;
-struct ClientBufferDestroyListener;
+class ShmClientBufferIntegration;
+class CommitTrace;
 
 class DisplayPrivate
 {
@@ -38,8 +50,34 @@ public:
 
     void registerSocketName(const QString &socketName);
 
-    void registerClientBuffer(ClientBuffer *clientBuffer);
-    void unregisterClientBuffer(ClientBuffer *clientBuffer);
+    /**
+     * Returns the next serial and records it with the input event described by @p entry.
+     */
+    quint32 nextSerial(SerialHistory::Entry entry);
+    void registerClientBuffer(ClientBuffer *clientBuffer, ClientBufferIntegration *integration);
+    void scheduleBufferRelease(ClientBuffer *clientBuffer);
+    void cancelBufferRelease(ClientBuffer *clientBuffer);
+    void sendBufferReleases();
+
+    static void logProtocol(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    void updateProtocolLogger();
+    void accountRequest(wl_client *client);
+    void finishDispatchAccounting();
+    void markClientDirty(wl_client *client);
+    void flushClients();
+    // takes a copy, the congested clients change while they are updated
+    void updateClientCongestion(QVector<ClientConnection *> connections);
+    void updateCongestionTimer();
+    void countMessage(wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    void countDispatch(std::chrono::nanoseconds duration);
+    void finishAllocationAccounting();
+    /**
+     * Invokes @p callback once the current dispatch of the event loop is finished, or right
+     * away if the Display is not dispatching. Used to act once on several requests a client
+     * sent together. The callback is dropped if @p context gets destroyed before.
+     */
+    void runAfterDispatch(QObject *context, std::function<void()> callback);
+    void runDispatchCallbacks();
 
     Display *q;
     QSocketNotifier *socketNotifier = nullptr;
@@ -47,14 +85,79 @@ public:
     wl_event_loop *loop = nullptr;
     bool running = false;
     QList<OutputInterface *> outputs;
+    // the bits handed out to the outputs for the output masks of the surfaces
+    quint64 outputSurfaceBits = 0;
     QList<OutputDeviceV2Interface *> outputdevicesV2;
     QVector<SeatInterface *> seats;
     QVector<ClientConnection *> clients;
     QStringList socketNames;
     EGLDisplay eglDisplay = EGL_NO_DISPLAY;
-    QHash<::wl_resource *, ClientBuffer *> resourceToBuffer;
-    QHash<ClientBuffer *, ClientBufferDestroyListener *> bufferToListener;
     QList<ClientBufferIntegration *> bufferIntegrations;
+    ShmClientBufferIntegration *shmBufferIntegration = nullptr;
+    QVector<ClientBuffer *> pendingBufferReleases;
+    TimerWheel timerWheel;
+    SerialHistory serialHistory;
+
+    wl_protocol_logger *protocolLogger = nullptr;
+    std::chrono::microseconds clientDispatchBudget = std::chrono::microseconds::zero();
+    int damageRectBudget = 32;
+    // the bytes the contents of destroyed shm buffers may take and take now
+    qint64 shmRetentionBudget = 64 * 1024 * 1024;
+    qint64 retainedShmBytes = 0;
+    bool dispatching = false;
+    // the client whose request is being dispatched and since when
+    ClientConnection *dispatchingClient = nullptr;
+    std::chrono::steady_clock::time_point dispatchingSince;
+    // the clients that had requests dispatched in the current dispatch of the event loop
+    QVector<QPointer<ClientConnection>> dispatchedClients;
+
+    bool flushDirtyClientsOnly = false;
+    // the clients that got events since the last flush
+    QVector<ClientConnection *> dirtyClients;
+    // set if a client without a ClientConnection got events
+    bool flushAllClients = false;
+
+    struct MessageCounter {
+        const char *interface = nullptr;
+        bool event = false;
+        quint64 count = 0;
+        quint64 allocations = 0;
+        quint64 allocatedBytes = 0;
+    };
+    bool protocolStatisticsEnabled = false;
+    // keyed by the message description, which is unique per interface, opcode and direction
+    QHash<const wl_message *, MessageCounter> messageCounters;
+    QVector<quint64> dispatchTimeHistogram;
+    // the request whose allocations are being counted and the allocations when it started
+    const wl_message *allocatingRequest = nullptr;
+    AllocationTracker::Counters allocationsSince;
+
+    bool commitTracingEnabled = false;
+    // the traces of the surfaces, they are owned by the surfaces
+    QVector<QWeakPointer<CommitTrace>> commitTraces;
+
+    bool surfaceSnapshotsEnabled = false;
+
+    bool resourceAccountingEnabled = false;
+    ClientResourceLimits clientResourceLimits;
+    // creates the ClientConnection of every new client right away
+    static void clientCreatedCallback(wl_listener *listener, void *data);
+    struct ClientCreatedListener {
+        wl_listener listener;
+        DisplayPrivate *display;
+    } clientCreatedListener;
+
+    quint32 clientCongestionThreshold = 0;
+    QVector<ClientConnection *> congestedClients;
+    // polls the congested clients, nothing else may wake up the compositor once they read again
+    QTimer *congestionTimer = nullptr;
+
+    std::chrono::nanoseconds dispatchTime = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds flushTime = std::chrono::nanoseconds::zero();
+
+    // set while dispatchEvents dispatches the event loop, also without a client dispatch budget
+    bool dispatchingEvents = false;
+    QVector<std::pair<QPointer<QObject>, std::function<void()>>> dispatchCallbacks;
 };
 
 } // namespace KWaylandServer
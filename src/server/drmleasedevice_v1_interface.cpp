@@ -30,6 +30,7 @@ DrmLeaseDeviceV1Interface::~DrmLeaseDeviceV1Interface()
 
 void DrmLeaseDeviceV1Interface::setDrmMaster(bool hasDrmMaster)
 {
+    beginUpdate();
     if (hasDrmMaster && !d->hasDrmMaster) {
         // withdraw all connectors
         for (const auto &connector : qAsConst(d->connectors)) {
@@ -48,16 +49,27 @@ void DrmLeaseDeviceV1Interface::setDrmMaster(bool hasDrmMaster)
         }
         // offer all connectors again
         for (const auto &connector : qAsConst(d->connectors)) {
-            auto connectorPrivate = DrmLeaseConnectorV1InterfacePrivate::get(connector);
-            connectorPrivate->withdrawn = false;
-            for (const auto &resource : d->resourceMap()) {
-                auto connectorResource = connectorPrivate->add(resource->client(), 0, s_version);
-                d->send_connector(resource->handle, connectorResource->handle);
-                connectorPrivate->send(connectorResource->handle);
-            }
+            DrmLeaseConnectorV1InterfacePrivate::get(connector)->withdrawn = false;
+            d->offerConnector(connector);
         }
     }
     d->hasDrmMaster = hasDrmMaster;
+    endUpdate();
+}
+
+void DrmLeaseDeviceV1Interface::beginUpdate()
+{
+    ++d->updateDepth;
+}
+
+void DrmLeaseDeviceV1Interface::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0 || !d->donePending) {
+        return;
+    }
+    d->donePending = false;
+    d->sendDone();
 }
 
 
@@ -74,12 +86,14 @@ DrmLeaseDeviceV1InterfacePrivate::~DrmLeaseDeviceV1InterfacePrivate()
 
 void DrmLeaseDeviceV1InterfacePrivate::remove()
 {
+    q->beginUpdate();
     for (const auto &lease : qAsConst(leases)) {
         lease->deny();
     }
     for (const auto &connector : qAsConst(connectors)) {
         DrmLeaseConnectorV1InterfacePrivate::get(connector)->withdraw();
     }
+    q->endUpdate();
     for (const auto &request : qAsConst(leaseRequests)) {
         request->connectors.clear();
     }
@@ -96,12 +110,33 @@ void DrmLeaseDeviceV1InterfacePrivate::registerConnector(DrmLeaseConnectorV1Inte
     if (!hasDrmMaster) {
         return;
     }
-    for (const auto &resource : resourceMap()) {
-        auto connectorPrivate = DrmLeaseConnectorV1InterfacePrivate::get(connector);
+    offerConnector(connector);
+}
+
+void DrmLeaseDeviceV1InterfacePrivate::offerConnector(DrmLeaseConnectorV1Interface *connector)
+{
+    const auto resources = resourceMap();
+    if (resources.isEmpty()) {
+        return;
+    }
+    auto connectorPrivate = DrmLeaseConnectorV1InterfacePrivate::get(connector);
+    for (const auto &resource : resources) {
         auto connectorResource = connectorPrivate->add(resource->client(), 0, resource->version());
         send_connector(resource->handle, connectorResource->handle);
         connectorPrivate->send(connectorResource->handle);
     }
+    sendDone();
+}
+
+void DrmLeaseDeviceV1InterfacePrivate::sendDone()
+{
+    if (updateDepth > 0) {
+        donePending = true;
+        return;
+    }
+    for (const auto &resource : resourceMap()) {
+        send_done(resource->handle);
+    }
 }
 
 void DrmLeaseDeviceV1InterfacePrivate::unregisterConnector(DrmLeaseConnectorV1Interface *connector)
@@ -159,6 +194,7 @@ void DrmLeaseDeviceV1InterfacePrivate::wp_drm_lease_device_v1_bind_resource(Reso
             connectorPrivate->send(connectorResource->handle);
         }
     }
+    send_done(resource->handle);
 }
 
 void DrmLeaseDeviceV1InterfacePrivate::wp_drm_lease_device_v1_destroy_resource(Resource *resource)
@@ -224,12 +260,16 @@ void DrmLeaseConnectorV1InterfacePrivate::send(wl_resource *resource)
 
 void DrmLeaseConnectorV1InterfacePrivate::withdraw()
 {
-    if (!withdrawn) {
-        withdrawn = true;
-        for (const auto &resource : resourceMap()) {
-            send_withdrawn(resource->handle);
-            DrmLeaseDeviceV1InterfacePrivate::get(device)->send_done(resource->handle);
-        }
+    if (withdrawn) {
+        return;
+    }
+    withdrawn = true;
+    const auto resources = resourceMap();
+    for (const auto &resource : resources) {
+        send_withdrawn(resource->handle);
+    }
+    if (device && !resources.isEmpty()) {
+        DrmLeaseDeviceV1InterfacePrivate::get(device)->sendDone();
     }
 }
 
@@ -320,9 +360,11 @@ void DrmLeaseV1Interface::grant(int leaseFd, uint32_t lesseeId)
     d->send_lease_fd(leaseFd);
     close(leaseFd);
     d->lesseeId = lesseeId;
+    d->device->q->beginUpdate();
     for (const auto &connector : qAsConst(d->connectors)) {
         DrmLeaseConnectorV1InterfacePrivate::get(connector)->withdraw();
     }
+    d->device->q->endUpdate();
 }
 
 void DrmLeaseV1Interface::deny()
@@ -337,22 +379,12 @@ void DrmLeaseV1Interface::deny()
     Q_EMIT d->device->q->leaseRevoked(this);
     // check if we should offer connectors again
     if (d->device->hasDrmMaster) {
-        bool sent = false;
+        d->device->q->beginUpdate();
         for (const auto &connector : qAsConst(d->connectors)) {
-            auto connectorPrivate = DrmLeaseConnectorV1InterfacePrivate::get(connector);
-            connectorPrivate->withdrawn = false;
-            for (const auto &resource : d->device->resourceMap()) {
-                auto connectorResource = connectorPrivate->add(resource->client(), 0, s_version);
-                d->device->send_connector(resource->handle, connectorResource->handle);
-                connectorPrivate->send(connectorResource->handle);
-                sent = true;
-            }
-        }
-        if (sent) {
-            for (const auto &resource : d->device->resourceMap()) {
-                d->device->send_done(resource->handle);
-            }
+            DrmLeaseConnectorV1InterfacePrivate::get(connector)->withdrawn = false;
+            d->device->offerConnector(connector);
         }
+        d->device->q->endUpdate();
     }
     d->lesseeId = 0;
 }
@@ -43,10 +43,24 @@ public:
      */
     void setDrmMaster(bool hasDrmMaster);
 
+    /**
+     * Starts changing several connectors at once, e.g. when a multi-head device gets plugged in.
+     * Created and destroyed DrmLeaseConnectorV1Interfaces are still announced right away, but
+     * clients get a single done event with the matching endUpdate(). Updates can be nested.
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate() and sends the done event if any connector
+     * changed in the meantime.
+     */
+    void endUpdate();
+
 Q_SIGNALS:
     /**
      * Emitted when a lease is requested. The compositor needs to either
-     * grant or deny the lease when receiving this signal
+     * grant or deny the lease in response to this signal. It doesn't have to do so
+     * from the signal handler, the lease can be created later, e.g. on another thread,
+     * and handed out with DrmLeaseV1Interface::grant once it is ready
      */
     void leaseRequested(DrmLeaseV1Interface *leaseRequest);
 
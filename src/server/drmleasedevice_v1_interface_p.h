@@ -29,6 +29,11 @@ public:
 
     void registerConnector(DrmLeaseConnectorV1Interface *connector);
     void unregisterConnector(DrmLeaseConnectorV1Interface *connector);
+    void offerConnector(DrmLeaseConnectorV1Interface *connector);
+    /**
+     * Sends the done event to all clients, or at the end of the current update.
+     */
+    void sendDone();
 
     static DrmLeaseDeviceV1InterfacePrivate *get(DrmLeaseDeviceV1Interface *device);
 
@@ -40,6 +45,8 @@ public:
     std::function<int()> createNonMasterFd;
     bool hasDrmMaster = true;
     bool removed = false;
+    int updateDepth = 0;
+    bool donePending = false;
 protected:
     void wp_drm_lease_device_v1_create_lease_request(Resource *resource, uint32_t id) override;
     void wp_drm_lease_device_v1_release(Resource *resource) override;
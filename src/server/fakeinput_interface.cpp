@@ -5,7 +5,9 @@
 */
 #include "fakeinput_interface.h"
 #include "display.h"
+#include "utils_p.h"
 
+#include <QPointer>
 #include <QPointF>
 #include <QSizeF>
 
@@ -20,15 +22,20 @@ class FakeInputInterfacePrivate : public QtWaylandServer::org_kde_kwin_fake_inpu
 {
 public:
     FakeInputInterfacePrivate(FakeInputInterface *_q, Display *display);
-    QList<FakeInputDevice *> devices;
 
 private:
-    FakeInputDevice *device(wl_resource *r);
+    // the device of a resource, events are looked up without searching
+    struct DeviceResource : Resource {
+        QPointer<FakeInputDevice> device;
+    };
+    static FakeInputDevice *device(Resource *resource);
+    static FakeInputDevice *authenticatedDevice(Resource *resource);
 
     FakeInputInterface *q;
-    static QList<quint32> touchIds;
+    static SmallFlatSet<quint32> touchIds;
 
 protected:
+    Resource *org_kde_kwin_fake_input_allocate() override;
     void org_kde_kwin_fake_input_bind_resource(Resource *resource) override;
     void org_kde_kwin_fake_input_destroy_resource(Resource *resource) override;
     void org_kde_kwin_fake_input_authenticate(Resource *resource, const QString &application, const QString &reason) override;
@@ -45,7 +52,7 @@ protected:
     void org_kde_kwin_fake_input_keyboard_key(Resource *resource, uint32_t button, uint32_t state) override;
 };
 
-QList<quint32> FakeInputInterfacePrivate::touchIds = QList<quint32>();
+SmallFlatSet<quint32> FakeInputInterfacePrivate::touchIds;
 
 FakeInputInterfacePrivate::FakeInputInterfacePrivate(FakeInputInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_fake_input(*display, s_version)
@@ -61,37 +68,39 @@ FakeInputInterface::FakeInputInterface(Display *display, QObject *parent)
 
 FakeInputInterface::~FakeInputInterface() = default;
 
+FakeInputInterfacePrivate::Resource *FakeInputInterfacePrivate::org_kde_kwin_fake_input_allocate()
+{
+    return new DeviceResource;
+}
+
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_bind_resource(Resource *resource)
 {
     FakeInputDevice *device = new FakeInputDevice(q, resource->handle);
-    devices << device;
-    QObject::connect(device, &FakeInputDevice::destroyed, q, [device, this] {
-        devices.removeAll(device);
-    });
+    static_cast<DeviceResource *>(resource)->device = device;
     Q_EMIT q->deviceCreated(device);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_destroy_resource(Resource *resource)
 {
-    if (FakeInputDevice *d = device(resource->handle)) {
+    if (FakeInputDevice *d = device(resource)) {
         d->deleteLater();
     }
 }
 
-FakeInputDevice *FakeInputInterfacePrivate::device(wl_resource *r)
+FakeInputDevice *FakeInputInterfacePrivate::device(Resource *resource)
 {
-    auto it = std::find_if(devices.constBegin(), devices.constEnd(), [r](FakeInputDevice *device) {
-        return device->resource() == r;
-    });
-    if (it != devices.constEnd()) {
-        return *it;
-    }
-    return nullptr;
+    return static_cast<DeviceResource *>(resource)->device;
+}
+
+FakeInputDevice *FakeInputInterfacePrivate::authenticatedDevice(Resource *resource)
+{
+    FakeInputDevice *d = device(resource);
+    return d && d->isAuthenticated() ? d : nullptr;
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_authenticate(Resource *resource, const QString &application, const QString &reason)
 {
-    FakeInputDevice *d = device(resource->handle);
+    FakeInputDevice *d = device(resource);
     if (!d) {
         return;
     }
@@ -100,8 +109,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_authenticate(Resource *r
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_pointer_motion(Resource *resource, wl_fixed_t delta_x, wl_fixed_t delta_y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     Q_EMIT d->pointerMotionRequested(QSizeF(wl_fixed_to_double(delta_x), wl_fixed_to_double(delta_y)));
@@ -109,8 +118,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_pointer_motion(Resource
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_button(Resource *resource, uint32_t button, uint32_t state)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     switch (state) {
@@ -128,8 +137,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_button(Resource *resourc
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_axis(Resource *resource, uint32_t axis, wl_fixed_t value)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     Qt::Orientation orientation;
@@ -149,8 +158,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_axis(Resource *resource,
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_axis_for_capture(Resource *resource, uint32_t axis, wl_fixed_t value)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     Qt::Orientation orientation;
@@ -170,21 +179,20 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_axis_for_capture(Resourc
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_down(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
-    if (touchIds.contains(id)) {
+    if (!touchIds.insert(id)) {
         return;
     }
-    touchIds << id;
     Q_EMIT d->touchDownRequested(id, QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y)));
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_motion(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     if (!touchIds.contains(id)) {
@@ -195,21 +203,20 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_motion(Resource *r
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_up(Resource *resource, uint32_t id)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
-    if (!touchIds.contains(id)) {
+    if (!touchIds.remove(id)) {
         return;
     }
-    touchIds.removeOne(id);
     Q_EMIT d->touchUpRequested(id);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_cancel(Resource *resource)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     touchIds.clear();
@@ -218,8 +225,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_cancel(Resource *r
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_frame(Resource *resource)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     Q_EMIT d->touchFrameRequested();
@@ -227,8 +234,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_frame(Resource *re
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_pointer_motion_absolute(Resource *resource, wl_fixed_t x, wl_fixed_t y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     Q_EMIT d->pointerMotionAbsoluteRequested(QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y)));
@@ -236,8 +243,8 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_pointer_motion_absolute(
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_keyboard_key(Resource *resource, uint32_t button, uint32_t state)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevice *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     switch (state) {
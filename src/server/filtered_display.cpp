@@ -10,6 +10,7 @@
 #include <wayland-server.h>
 
 #include <QByteArray>
+#include <QHash>
 
 namespace KWaylandServer
 {
@@ -18,13 +19,24 @@ class FilteredDisplayPrivate
 public:
     FilteredDisplayPrivate(FilteredDisplay *_q);
     FilteredDisplay *q;
+    // the decisions per client, keyed by the interface description of libwayland. The
+    // descriptions are static data, so the pointer is a cheap interned interface name.
+    QHash<ClientConnection *, QHash<const wl_interface *, bool>> decisions;
+
     static bool globalFilterCallback(const wl_client *client, const wl_global *global, void *data)
     {
         auto t = static_cast<FilteredDisplayPrivate *>(data);
         auto clientConnection = t->q->getConnection(const_cast<wl_client *>(client));
         auto interface = wl_global_get_interface(global);
+        QHash<const wl_interface *, bool> &clientDecisions = t->decisions[clientConnection];
+        auto it = clientDecisions.constFind(interface);
+        if (it != clientDecisions.constEnd()) {
+            return *it;
+        }
         auto name = QByteArray::fromRawData(interface->name, strlen(interface->name));
-        return t->q->allowInterface(clientConnection, name);
+        const bool allowed = t->q->allowInterface(clientConnection, name);
+        clientDecisions.insert(interface, allowed);
+        return allowed;
     };
 };
 
@@ -43,10 +55,23 @@ FilteredDisplay::FilteredDisplay(QObject *parent)
         }
         wl_display_set_global_filter(*this, FilteredDisplayPrivate::globalFilterCallback, d.data());
     });
+    connect(this, &Display::clientDisconnected, this, [this](ClientConnection *client) {
+        d->decisions.remove(client);
+    });
 }
 
 FilteredDisplay::~FilteredDisplay()
 {
 }
 
+void FilteredDisplay::invalidateInterfaceFilter()
+{
+    d->decisions.clear();
+}
+
+void FilteredDisplay::invalidateInterfaceFilter(ClientConnection *client)
+{
+    d->decisions.remove(client);
+}
+
 }
@@ -32,10 +32,25 @@ public:
      * When false will not see these globals for a given interface in the registry,
      * and any manual attempts to bind will fail
      *
+     * The decision is cached per client and interface, so this is called only once for each of
+     * them. If the decision changes, the cache has to be invalidated with invalidateInterfaceFilter.
+     *
      * @return true if the client should be able to access the global with the following interfaceName
      */
     virtual bool allowInterface(ClientConnection *client, const QByteArray &interfaceName) = 0;
 
+    /**
+     * Discards the cached allowInterface decisions for all clients.
+     *
+     * Already announced globals are not announced again or removed, the new decisions only
+     * affect future registry announcements and binds.
+     */
+    void invalidateInterfaceFilter();
+    /**
+     * Discards the cached allowInterface decisions for the @p client.
+     */
+    void invalidateInterfaceFilter(ClientConnection *client);
+
 private:
     QScopedPointer<FilteredDisplayPrivate> d;
 };
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class FractionalScaleManagerV1InterfacePrivate;
+
+/**
+ * The FractionalScaleManagerV1Interface lets the compositor suggest fractional scales to clients.
+ *
+ * Clients render at the suggested scale into a buffer with the buffer scale 1, and scale the
+ * buffer down to the surface size with a viewport, so the global should be created together with
+ * a ViewporterInterface. The scale is set with SurfaceInterface::setPreferredScale().
+ *
+ * FractionalScaleManagerV1Interface corresponds to the Wayland interface
+ * @c wp_fractional_scale_manager_v1.
+ */
+class KWAYLANDSERVER_EXPORT FractionalScaleManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FractionalScaleManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~FractionalScaleManagerV1Interface() override;
+
+private:
+    QScopedPointer<FractionalScaleManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,222 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "frogcolormanagement_v1_interface.h"
+#include "display.h"
+#include "frogcolormanagement_v1_interface_p.h"
+#include "surface_interface_p.h"
+
+#include <cmath>
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+class FrogColorManagementV1InterfacePrivate : public QtWaylandServer::frog_color_management_factory_v1
+{
+protected:
+    void frog_color_management_factory_v1_destroy(Resource *resource) override;
+    void frog_color_management_factory_v1_get_color_managed_surface(Resource *resource, wl_resource *surface, uint32_t callback) override;
+};
+
+void FrogColorManagementV1InterfacePrivate::frog_color_management_factory_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void FrogColorManagementV1InterfacePrivate::frog_color_management_factory_v1_get_color_managed_surface(Resource *resource,
+                                                                                                        wl_resource *surface_resource,
+                                                                                                        uint32_t callback)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    // the protocol has no error for a second object, the newer one takes over
+    wl_resource *colorResource = wl_resource_create(resource->client(), &frog_color_managed_surface_interface, resource->version(), callback);
+    auto colorSurface = new FrogColorManagedSurfaceV1Interface(surface, colorResource);
+    colorSurface->setPreferredColorDescription(surface->preferredColorDescription());
+}
+
+// chromaticities are coded in units of 0.00002, minimum luminances in units of 0.0001 cd/m²
+static double decodeChromaticity(uint32_t value)
+{
+    return value * 0.00002;
+}
+
+static uint32_t encodeChromaticity(double value)
+{
+    return uint32_t(std::round(value * 50000));
+}
+
+static uint32_t transferFunctionToProtocol(ColorDescription::TransferFunction transferFunction)
+{
+    switch (transferFunction) {
+    case ColorDescription::TransferFunction::Srgb:
+        return FrogColorManagedSurfaceV1Interface::transfer_function_srgb;
+    case ColorDescription::TransferFunction::Gamma22:
+        return FrogColorManagedSurfaceV1Interface::transfer_function_gamma_22;
+    case ColorDescription::TransferFunction::PerceptualQuantizer:
+        return FrogColorManagedSurfaceV1Interface::transfer_function_st2084_pq;
+    case ColorDescription::TransferFunction::ScRgbLinear:
+        return FrogColorManagedSurfaceV1Interface::transfer_function_scrgb_linear;
+    case ColorDescription::TransferFunction::Undefined:
+    default:
+        return FrogColorManagedSurfaceV1Interface::transfer_function_undefined;
+    }
+}
+
+FrogColorManagedSurfaceV1Interface::FrogColorManagedSurfaceV1Interface(SurfaceInterface *surface, wl_resource *resource)
+    : QtWaylandServer::frog_color_managed_surface(resource)
+    , surface(surface)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    if (surfacePrivate->frogColorManagementExtension) {
+        surfacePrivate->frogColorManagementExtension->surface = nullptr;
+    }
+    surfacePrivate->frogColorManagementExtension = this;
+}
+
+FrogColorManagedSurfaceV1Interface::~FrogColorManagedSurfaceV1Interface()
+{
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->frogColorManagementExtension = nullptr;
+    }
+}
+
+FrogColorManagedSurfaceV1Interface *FrogColorManagedSurfaceV1Interface::get(SurfaceInterface *surface)
+{
+    return SurfaceInterfacePrivate::get(surface)->frogColorManagementExtension;
+}
+
+void FrogColorManagedSurfaceV1Interface::setPreferredColorDescription(const ColorDescription &description)
+{
+    const Chromaticities chromaticities = description.chromaticities();
+    // without HDR metadata the output is described as the sRGB reference display
+    const double maxLuminance = description.hdrMetadata ? description.hdrMetadata->maxMasteringLuminance : 80;
+    const double minLuminance = description.hdrMetadata ? description.hdrMetadata->minMasteringLuminance : 0.2;
+    const double maxFullFrameLuminance = description.hdrMetadata ? description.hdrMetadata->maxFrameAverageLightLevel : 80;
+
+    send_preferred_metadata(transferFunctionToProtocol(description.transferFunction),
+                            encodeChromaticity(chromaticities.red.x()),
+                            encodeChromaticity(chromaticities.red.y()),
+                            encodeChromaticity(chromaticities.green.x()),
+                            encodeChromaticity(chromaticities.green.y()),
+                            encodeChromaticity(chromaticities.blue.x()),
+                            encodeChromaticity(chromaticities.blue.y()),
+                            encodeChromaticity(chromaticities.white.x()),
+                            encodeChromaticity(chromaticities.white.y()),
+                            uint32_t(std::round(maxLuminance)),
+                            uint32_t(std::round(minLuminance * 10000)),
+                            uint32_t(std::round(maxFullFrameLuminance)));
+}
+
+void FrogColorManagedSurfaceV1Interface::applyDescription()
+{
+    if (!surface) {
+        return;
+    }
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->pending.colorDescription = description;
+    surfacePrivate->pending.markSet(SurfaceState::ColorDescriptionField);
+}
+
+void FrogColorManagedSurfaceV1Interface::frog_color_managed_surface_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void FrogColorManagedSurfaceV1Interface::frog_color_managed_surface_destroy(Resource *resource)
+{
+    // going back to an undefined color space is double-buffered as well
+    description = ColorDescription();
+    applyDescription();
+
+    wl_resource_destroy(resource->handle);
+}
+
+void FrogColorManagedSurfaceV1Interface::frog_color_managed_surface_set_known_transfer_function(Resource *resource, uint32_t transfer_function)
+{
+    Q_UNUSED(resource)
+    switch (transfer_function) {
+    case transfer_function_srgb:
+        description.transferFunction = ColorDescription::TransferFunction::Srgb;
+        break;
+    case transfer_function_gamma_22:
+        description.transferFunction = ColorDescription::TransferFunction::Gamma22;
+        break;
+    case transfer_function_st2084_pq:
+        description.transferFunction = ColorDescription::TransferFunction::PerceptualQuantizer;
+        break;
+    case transfer_function_scrgb_linear:
+        description.transferFunction = ColorDescription::TransferFunction::ScRgbLinear;
+        break;
+    default:
+        description.transferFunction = ColorDescription::TransferFunction::Undefined;
+        break;
+    }
+    applyDescription();
+}
+
+void FrogColorManagedSurfaceV1Interface::frog_color_managed_surface_set_known_container_color_volume(Resource *resource, uint32_t primaries)
+{
+    Q_UNUSED(resource)
+    switch (primaries) {
+    case primaries_rec709:
+        description.primaries = ColorDescription::Primaries::Rec709;
+        break;
+    case primaries_rec2020:
+        description.primaries = ColorDescription::Primaries::Rec2020;
+        break;
+    default:
+        description.primaries = ColorDescription::Primaries::Undefined;
+        break;
+    }
+    applyDescription();
+}
+
+void FrogColorManagedSurfaceV1Interface::frog_color_managed_surface_set_render_intent(Resource *resource, uint32_t render_intent)
+{
+    Q_UNUSED(resource)
+    // perceptual is the only render intent and what the compositor does anyway
+    Q_UNUSED(render_intent)
+}
+
+void FrogColorManagedSurfaceV1Interface::frog_color_managed_surface_set_hdr_metadata(Resource *resource,
+                                                                                      uint32_t mastering_display_primary_red_x,
+                                                                                      uint32_t mastering_display_primary_red_y,
+                                                                                      uint32_t mastering_display_primary_green_x,
+                                                                                      uint32_t mastering_display_primary_green_y,
+                                                                                      uint32_t mastering_display_primary_blue_x,
+                                                                                      uint32_t mastering_display_primary_blue_y,
+                                                                                      uint32_t mastering_white_point_x,
+                                                                                      uint32_t mastering_white_point_y,
+                                                                                      uint32_t max_display_mastering_luminance,
+                                                                                      uint32_t min_display_mastering_luminance,
+                                                                                      uint32_t max_cll,
+                                                                                      uint32_t max_fall)
+{
+    Q_UNUSED(resource)
+    HdrMetadata metadata;
+    metadata.mastering.red = QPointF(decodeChromaticity(mastering_display_primary_red_x), decodeChromaticity(mastering_display_primary_red_y));
+    metadata.mastering.green = QPointF(decodeChromaticity(mastering_display_primary_green_x), decodeChromaticity(mastering_display_primary_green_y));
+    metadata.mastering.blue = QPointF(decodeChromaticity(mastering_display_primary_blue_x), decodeChromaticity(mastering_display_primary_blue_y));
+    metadata.mastering.white = QPointF(decodeChromaticity(mastering_white_point_x), decodeChromaticity(mastering_white_point_y));
+    metadata.maxMasteringLuminance = max_display_mastering_luminance;
+    metadata.minMasteringLuminance = min_display_mastering_luminance * 0.0001;
+    metadata.maxContentLightLevel = max_cll;
+    metadata.maxFrameAverageLightLevel = max_fall;
+    description.hdrMetadata = metadata;
+    applyDescription();
+}
+
+FrogColorManagementV1Interface::FrogColorManagementV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new FrogColorManagementV1InterfacePrivate)
+{
+    d->init(*display, s_version);
+}
+
+FrogColorManagementV1Interface::~FrogColorManagementV1Interface() = default;
+
+} // namespace KWaylandServer
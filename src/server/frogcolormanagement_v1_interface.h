@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class FrogColorManagementV1InterfacePrivate;
+
+/**
+ * The FrogColorManagementV1Interface lets clients describe the color space and the HDR
+ * metadata of their surfaces. The description is double-buffered surface state and can be
+ * queried with SurfaceInterface::colorDescription(). The color space the compositor prefers
+ * for a surface is announced with SurfaceInterface::setPreferredColorDescription().
+ *
+ * FrogColorManagementV1Interface corresponds to the Wayland interface
+ * @c frog_color_management_factory_v1.
+ */
+class KWAYLANDSERVER_EXPORT FrogColorManagementV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrogColorManagementV1Interface(Display *display, QObject *parent = nullptr);
+    ~FrogColorManagementV1Interface() override;
+
+private:
+    QScopedPointer<FrogColorManagementV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "colordescription.h"
+
+#include "qwayland-server-frog-color-management-v1.h"
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+
+class FrogColorManagedSurfaceV1Interface : public QtWaylandServer::frog_color_managed_surface
+{
+public:
+    FrogColorManagedSurfaceV1Interface(SurfaceInterface *surface, wl_resource *resource);
+    ~FrogColorManagedSurfaceV1Interface() override;
+
+    static FrogColorManagedSurfaceV1Interface *get(SurfaceInterface *surface);
+
+    void setPreferredColorDescription(const ColorDescription &description);
+
+    QPointer<SurfaceInterface> surface;
+    // the description the client asked for so far, it is applied with the next commit
+    ColorDescription description;
+
+protected:
+    void frog_color_managed_surface_destroy_resource(Resource *resource) override;
+    void frog_color_managed_surface_destroy(Resource *resource) override;
+    void frog_color_managed_surface_set_known_transfer_function(Resource *resource, uint32_t transfer_function) override;
+    void frog_color_managed_surface_set_known_container_color_volume(Resource *resource, uint32_t primaries) override;
+    void frog_color_managed_surface_set_render_intent(Resource *resource, uint32_t render_intent) override;
+    void frog_color_managed_surface_set_hdr_metadata(Resource *resource,
+                                                     uint32_t mastering_display_primary_red_x,
+                                                     uint32_t mastering_display_primary_red_y,
+                                                     uint32_t mastering_display_primary_green_x,
+                                                     uint32_t mastering_display_primary_green_y,
+                                                     uint32_t mastering_display_primary_blue_x,
+                                                     uint32_t mastering_display_primary_blue_y,
+                                                     uint32_t mastering_white_point_x,
+                                                     uint32_t mastering_white_point_y,
+                                                     uint32_t max_display_mastering_luminance,
+                                                     uint32_t min_display_mastering_luminance,
+                                                     uint32_t max_cll,
+                                                     uint32_t max_fall) override;
+
+private:
+    void applyDescription();
+};
+
+} // namespace KWaylandServer
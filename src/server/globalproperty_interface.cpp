@@ -6,6 +6,7 @@
 #include "display.h"
 #include "surface_interface_p.h"
 
+#include <QHash>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonParseError>
@@ -21,6 +22,8 @@ public:
     GlobalPropertyInterfacePrivate(GlobalPropertyInterface *q, Display *display);
 
     GlobalPropertyInterface *q;
+    // the last known decoration properties of every surface, used to only report changes
+    QHash<SurfaceInterface *, QMap<QString, QVariant>> properties;
 
 private:
     void dde_globalproperty_set_property(Resource *resource, const QString &module, const QString &function, struct ::wl_resource *surface, int32_t type, const QString &data) override;
@@ -48,13 +51,29 @@ void GlobalPropertyInterfacePrivate::dde_globalproperty_set_property(Resource *r
         qDebug() << "Failed to parse data" << error.errorString();
         return;
     }
-    QMap<QString, QVariant> ret;
+    auto it = properties.find(si);
+    if (it == properties.end()) {
+        it = properties.insert(si, {});
+        QObject::connect(si, &SurfaceInterface::aboutToBeDestroyed, q, [this, si]() {
+            properties.remove(si);
+        });
+    }
+
+    QMap<QString, QVariant> changed;
     const QJsonObject rootObj = doc.object();
-    for (const auto &key : rootObj.keys()) {
-        const QVariant &value = rootObj[key].toVariant();
-        ret[key] = value;
+    for (auto jsonIt = rootObj.constBegin(); jsonIt != rootObj.constEnd(); ++jsonIt) {
+        const QVariant value = jsonIt.value().toVariant();
+        auto cached = it->find(jsonIt.key());
+        if (cached != it->end() && *cached == value) {
+            continue;
+        }
+        it->insert(jsonIt.key(), value);
+        changed.insert(jsonIt.key(), value);
+    }
+    if (changed.isEmpty()) {
+        return;
     }
-    emit q->windowDecoratePropertyChanged(si, ret);
+    emit q->windowDecoratePropertyChanged(si, changed);
 }
 
 void GlobalPropertyInterfacePrivate::dde_globalproperty_get_property(Resource *resource, const QString &data)
@@ -74,4 +93,9 @@ GlobalPropertyInterface::~GlobalPropertyInterface()
 
 }
 
+QMap<QString, QVariant> GlobalPropertyInterface::windowDecorateProperties(SurfaceInterface *surface) const
+{
+    return d->properties.value(surface);
+}
+
 }
@@ -34,7 +34,16 @@ public:
     explicit GlobalPropertyInterface(Display *display, QObject *parent = nullptr);
     virtual ~GlobalPropertyInterface();
 
+    /**
+     * @returns all decoration properties the client set on @p surface so far
+     */
+    QMap<QString, QVariant> windowDecorateProperties(SurfaceInterface *surface) const;
+
 Q_SIGNALS:
+    /**
+     * Emitted with the properties of @p surface whose value changed, properties which
+     * are set to the value they already have are not reported again.
+     */
     void windowDecoratePropertyChanged(SurfaceInterface *, QMap<QString, QVariant> &) const;
 
 private:
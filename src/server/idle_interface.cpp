@@ -4,17 +4,72 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "display.h"
+#include "display_p.h"
 #include "idle_interface_p.h"
 #include "seat_interface.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace KWaylandServer
 {
 static const quint32 s_version = 1;
 
 IdleInterfacePrivate::IdleInterfacePrivate(IdleInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_idle(*display, s_version)
+    , lastActivity(Clock::now())
+    , wheel(&DisplayPrivate::get(display)->timerWheel)
     , q(_q)
 {
+    timer.setCallback([this]() {
+        checkTimeouts();
+    });
+}
+
+void IdleInterfacePrivate::scheduleDeadline(Clock::time_point deadline)
+{
+    if (inhibitCount > 0) {
+        return;
+    }
+    if (timer.isActive() && timerDeadline <= deadline) {
+        return;
+    }
+    timerDeadline = deadline;
+    timer.start(wheel, std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()));
+}
+
+void IdleInterfacePrivate::checkTimeouts()
+{
+    timer.stop();
+    if (inhibitCount > 0) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    auto next = Clock::time_point::max();
+    for (IdleTimeoutInterface *idleTimeout : qAsConst(idleTimeouts)) {
+        if (!idleTimeout->isConfigured() || idleTimeout->isIdle()) {
+            continue;
+        }
+        const auto deadline = idleTimeout->deadline();
+        if (deadline <= now) {
+            idleTimeout->sendIdle();
+            idledTimeouts << idleTimeout;
+        } else {
+            next = std::min(next, deadline);
+        }
+    }
+    if (next != Clock::time_point::max()) {
+        scheduleDeadline(next);
+    }
+}
+
+void IdleInterfacePrivate::resumeIdleTimeouts()
+{
+    const QVector<IdleTimeoutInterface *> idled = std::exchange(idledTimeouts, {});
+    for (IdleTimeoutInterface *idleTimeout : idled) {
+        idleTimeout->sendResumed();
+    }
 }
 
 void IdleInterfacePrivate::org_kde_kwin_idle_get_idle_timeout(Resource *resource, uint32_t id, wl_resource *seat, uint32_t timeout)
@@ -28,11 +83,12 @@ void IdleInterfacePrivate::org_kde_kwin_idle_get_idle_timeout(Resource *resource
         return;
     }
 
-    IdleTimeoutInterface *idleTimeout = new IdleTimeoutInterface(s, q, idleTimoutResource);
+    IdleTimeoutInterface *idleTimeout = new IdleTimeoutInterface(s, this, idleTimoutResource);
     idleTimeouts << idleTimeout;
 
     QObject::connect(idleTimeout, &IdleTimeoutInterface::destroyed, q, [this, idleTimeout]() {
         idleTimeouts.removeOne(idleTimeout);
+        idledTimeouts.removeOne(idleTimeout);
     });
     idleTimeout->setup(timeout);
 }
@@ -49,6 +105,8 @@ void IdleInterface::inhibit()
 {
     d->inhibitCount++;
     if (d->inhibitCount == 1) {
+        d->timer.stop();
+        d->resumeIdleTimeouts();
         Q_EMIT inhibitedChanged();
     }
 }
@@ -57,6 +115,9 @@ void IdleInterface::uninhibit()
 {
     d->inhibitCount--;
     if (d->inhibitCount == 0) {
+        // the idle time restarts once no longer inhibited
+        d->lastActivity = IdleInterfacePrivate::Clock::now();
+        d->checkTimeouts();
         Q_EMIT inhibitedChanged();
     }
 }
@@ -68,31 +129,25 @@ bool IdleInterface::isInhibited() const
 
 void IdleInterface::simulateUserActivity()
 {
-    for (auto i : qAsConst(d->idleTimeouts)) {
-        i->simulateUserActivity();
+    if (isInhibited()) {
+        // ignored while inhibited
+        return;
+    }
+    // called for every input event, so only the timestamp is updated. The deadlines of the
+    // timeouts move with it and get checked once the shared timer expires
+    d->lastActivity = IdleInterfacePrivate::Clock::now();
+    if (!d->idledTimeouts.isEmpty()) {
+        d->resumeIdleTimeouts();
+        d->checkTimeouts();
     }
 }
 
-IdleTimeoutInterface::IdleTimeoutInterface(SeatInterface *seat, IdleInterface *manager, wl_resource *resource)
+IdleTimeoutInterface::IdleTimeoutInterface(SeatInterface *seat, IdleInterfacePrivate *manager, wl_resource *resource)
     : QObject()
     , QtWaylandServer::org_kde_kwin_idle_timeout(resource)
     , seat(seat)
     , manager(manager)
 {
-    connect(manager, &IdleInterface::inhibitedChanged, this, [this, manager] {
-        if (!timer) {
-            // not yet configured
-            return;
-        }
-        if (manager->isInhibited()) {
-            if (!timer->isActive()) {
-                send_resumed();
-            }
-            timer->stop();
-        } else {
-            timer->start();
-        }
-    });
 }
 
 IdleTimeoutInterface::~IdleTimeoutInterface() = default;
@@ -113,38 +168,60 @@ void IdleTimeoutInterface::org_kde_kwin_idle_timeout_simulate_user_activity(Reso
     Q_UNUSED(resource)
     simulateUserActivity();
 }
+
 void IdleTimeoutInterface::simulateUserActivity()
 {
-    if (!timer) {
-        // not yet configured
+    if (!configured) {
         return;
     }
-    if (manager->isInhibited()) {
+    if (manager->inhibitCount > 0) {
         // ignored while inhibited
         return;
     }
-    if (!timer->isActive()) {
-        send_resumed();
+    lastActivity = IdleInterfacePrivate::Clock::now();
+    if (idle) {
+        manager->idledTimeouts.removeOne(this);
+        sendResumed();
+        manager->scheduleDeadline(deadline());
     }
-    timer->start();
+}
+
+bool IdleTimeoutInterface::isConfigured() const
+{
+    return configured;
+}
+
+bool IdleTimeoutInterface::isIdle() const
+{
+    return idle;
+}
+
+IdleInterfacePrivate::Clock::time_point IdleTimeoutInterface::deadline() const
+{
+    return std::max(lastActivity, manager->lastActivity) + interval;
+}
+
+void IdleTimeoutInterface::sendIdle()
+{
+    idle = true;
+    send_idle();
+}
+
+void IdleTimeoutInterface::sendResumed()
+{
+    idle = false;
+    send_resumed();
 }
 
 void IdleTimeoutInterface::setup(quint32 timeout)
 {
-    if (timer) {
+    if (configured) {
         return;
     }
-    timer = new QTimer(this);
-    timer->setSingleShot(true);
+    configured = true;
     // less than 500 msec is not idle by definition
-    timer->setInterval(qMax(timeout, 500u));
-    QObject::connect(timer, &QTimer::timeout, this, [this] {
-        send_idle();
-    });
-    if (manager->isInhibited()) {
-        // don't start if inhibited
-        return;
-    }
-    timer->start();
+    interval = std::chrono::milliseconds(qMax(timeout, 500u));
+    lastActivity = IdleInterfacePrivate::Clock::now();
+    manager->scheduleDeadline(deadline());
 }
 }
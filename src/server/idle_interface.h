@@ -80,6 +80,9 @@ public:
      * This means the same action is performed as if the user interacted with
      * an input device on the SeatInterface.
      * Idle timeouts are resumed and the idle time gets restarted.
+     *
+     * This is cheap enough to be invoked for every input event: it only records the time
+     * of the activity, the idle timeouts compute their deadlines from it when needed.
      */
     void simulateUserActivity();
 
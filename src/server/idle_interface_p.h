@@ -7,24 +7,43 @@
 
 #include "idle_interface.h"
 
-#include <qwayland-server-idle.h>
+#include "timerwheel.h"
 
-#include <QTimer>
+#include <qwayland-server-idle.h>
 
 namespace KWaylandServer
 {
 class Display;
 class SeatInterface;
 class IdleTimeoutInterface;
-class IdleTimeoutInterface;
 
 class IdleInterfacePrivate : public QtWaylandServer::org_kde_kwin_idle
 {
 public:
+    using Clock = std::chrono::steady_clock;
+
     IdleInterfacePrivate(IdleInterface *_q, Display *display);
 
+    /**
+     * Arms the shared timer for @p deadline unless it already expires earlier.
+     */
+    void scheduleDeadline(Clock::time_point deadline);
+    /**
+     * Sends idle to every timeout whose deadline passed and arms the shared timer
+     * for the earliest remaining deadline.
+     */
+    void checkTimeouts();
+    void resumeIdleTimeouts();
+
     int inhibitCount = 0;
     QVector<IdleTimeoutInterface *> idleTimeouts;
+    // the timeouts which sent idle and wait for user activity
+    QVector<IdleTimeoutInterface *> idledTimeouts;
+    // user activity on any seat, the timeouts compute their deadlines from it lazily
+    Clock::time_point lastActivity;
+    TimerWheel *wheel;
+    TimerWheel::Timer timer;
+    Clock::time_point timerDeadline;
     IdleInterface *q;
 
 protected:
@@ -35,15 +54,25 @@ class IdleTimeoutInterface : public QObject, QtWaylandServer::org_kde_kwin_idle_
 {
     Q_OBJECT
 public:
-    explicit IdleTimeoutInterface(SeatInterface *seat, IdleInterface *parent, wl_resource *resource);
+    explicit IdleTimeoutInterface(SeatInterface *seat, IdleInterfacePrivate *manager, wl_resource *resource);
     ~IdleTimeoutInterface() override;
     void setup(quint32 timeout);
     void simulateUserActivity();
 
+    bool isConfigured() const;
+    bool isIdle() const;
+    IdleInterfacePrivate::Clock::time_point deadline() const;
+    void sendIdle();
+    void sendResumed();
+
 private:
     SeatInterface *seat;
-    IdleInterface *manager;
-    QTimer *timer = nullptr;
+    IdleInterfacePrivate *manager;
+    // activity simulated by the client for just this timeout
+    IdleInterfacePrivate::Clock::time_point lastActivity;
+    std::chrono::milliseconds interval = std::chrono::milliseconds::zero();
+    bool configured = false;
+    bool idle = false;
 
 protected:
     void org_kde_kwin_idle_timeout_destroy_resource(Resource *resource) override;
@@ -4,6 +4,7 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "display.h"
+#include "idle_interface.h"
 #include "idleinhibit_v1_interface_p.h"
 #include "surface_interface_p.h"
 
@@ -17,6 +18,36 @@ IdleInhibitManagerV1InterfacePrivate::IdleInhibitManagerV1InterfacePrivate(IdleI
 {
 }
 
+IdleInhibitManagerV1InterfacePrivate::~IdleInhibitManagerV1InterfacePrivate()
+{
+    for (SurfaceInterface *surface : qAsConst(surfaces)) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->idleInhibitManager = nullptr;
+        surfacePrivate->countedAsInhibitingIdle = false;
+    }
+    if (inhibitingSurfaces > 0 && idle) {
+        idle->uninhibit();
+    }
+}
+
+void IdleInhibitManagerV1InterfacePrivate::adjustInhibition(int delta)
+{
+    const bool wasInhibiting = inhibitingSurfaces > 0;
+    inhibitingSurfaces += delta;
+    const bool inhibiting = inhibitingSurfaces > 0;
+    if (wasInhibiting == inhibiting) {
+        return;
+    }
+    if (idle) {
+        if (inhibiting) {
+            idle->inhibit();
+        } else {
+            idle->uninhibit();
+        }
+    }
+    Q_EMIT q->inhibitingChanged();
+}
+
 void IdleInhibitManagerV1InterfacePrivate::zwp_idle_inhibit_manager_v1_destroy(Resource *resource)
 {
     wl_resource_destroy(resource->handle);
@@ -38,7 +69,7 @@ void IdleInhibitManagerV1InterfacePrivate::zwp_idle_inhibit_manager_v1_create_in
     auto inhibitor = new IdleInhibitorV1Interface(inhibitorResource);
 
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->installIdleInhibitor(inhibitor);
+    surfacePrivate->installIdleInhibitor(this, inhibitor);
 }
 
 IdleInhibitManagerV1Interface::IdleInhibitManagerV1Interface(Display *display, QObject *parent)
@@ -49,6 +80,48 @@ IdleInhibitManagerV1Interface::IdleInhibitManagerV1Interface(Display *display, Q
 
 IdleInhibitManagerV1Interface::~IdleInhibitManagerV1Interface() = default;
 
+void IdleInhibitManagerV1Interface::setIdleInterface(IdleInterface *idle)
+{
+    if (d->idle == idle) {
+        return;
+    }
+    if (isInhibiting()) {
+        if (d->idle) {
+            d->idle->uninhibit();
+        }
+        if (idle) {
+            idle->inhibit();
+        }
+    }
+    d->idle = idle;
+}
+
+IdleInterface *IdleInhibitManagerV1Interface::idleInterface() const
+{
+    return d->idle;
+}
+
+void IdleInhibitManagerV1Interface::setVisibilityRequired(bool required)
+{
+    if (d->visibilityRequired == required) {
+        return;
+    }
+    d->visibilityRequired = required;
+    for (SurfaceInterface *surface : qAsConst(d->surfaces)) {
+        SurfaceInterfacePrivate::get(surface)->updateIdleInhibition();
+    }
+}
+
+bool IdleInhibitManagerV1Interface::isVisibilityRequired() const
+{
+    return d->visibilityRequired;
+}
+
+bool IdleInhibitManagerV1Interface::isInhibiting() const
+{
+    return d->inhibitingSurfaces > 0;
+}
+
 IdleInhibitorV1Interface::IdleInhibitorV1Interface(wl_resource *resource)
     : QObject(nullptr)
     , QtWaylandServer::zwp_idle_inhibitor_v1(resource)
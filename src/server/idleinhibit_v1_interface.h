@@ -14,6 +14,7 @@ struct wl_resource;
 namespace KWaylandServer
 {
 class Display;
+class IdleInterface;
 class IdleInhibitManagerV1InterfacePrivate;
 
 /**
@@ -29,6 +30,34 @@ public:
     explicit IdleInhibitManagerV1Interface(Display *display, QObject *parent = nullptr);
     ~IdleInhibitManagerV1Interface() override;
 
+    /**
+     * Sets the IdleInterface which gets inhibited while isInhibiting() is @c true.
+     */
+    void setIdleInterface(IdleInterface *idle);
+    IdleInterface *idleInterface() const;
+
+    /**
+     * Sets whether surfaces only inhibit idle while they are not occluded, see
+     * SurfaceInterface::setOccluded. The default is @c false.
+     */
+    void setVisibilityRequired(bool required);
+    bool isVisibilityRequired() const;
+
+    /**
+     * @returns Whether any mapped SurfaceInterface inhibits idle.
+     *
+     * The state is tracked as inhibitors get created and destroyed and surfaces get mapped
+     * and unmapped, so there is no need to check SurfaceInterface::inhibitsIdle of every surface.
+     * @see inhibitingChanged
+     */
+    bool isInhibiting() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when isInhibiting() changes.
+     */
+    void inhibitingChanged();
+
 private:
     QScopedPointer<IdleInhibitManagerV1InterfacePrivate> d;
 };
@@ -7,16 +7,32 @@
 
 #include "idleinhibit_v1_interface.h"
 
+#include <QPointer>
+#include <QVector>
+
 #include <qwayland-server-idle-inhibit-unstable-v1.h>
 
 namespace KWaylandServer
 {
+class SurfaceInterface;
+
 class IdleInhibitManagerV1InterfacePrivate : public QtWaylandServer::zwp_idle_inhibit_manager_v1
 {
 public:
     IdleInhibitManagerV1InterfacePrivate(IdleInhibitManagerV1Interface *_q, Display *display);
+    ~IdleInhibitManagerV1InterfacePrivate() override;
+
+    /**
+     * Adds @p delta to the number of surfaces which inhibit idle.
+     */
+    void adjustInhibition(int delta);
 
     IdleInhibitManagerV1Interface *q;
+    QPointer<IdleInterface> idle;
+    // the surfaces which ever got an inhibitor of this manager
+    QVector<SurfaceInterface *> surfaces;
+    int inhibitingSurfaces = 0;
+    bool visibilityRequired = false;
 
 protected:
     void zwp_idle_inhibit_manager_v1_destroy(Resource *resource) override;
@@ -13,11 +13,17 @@
 #include "seat_interface.h"
 #include "surface_interface.h"
 #include "surfacerole_p.h"
+#include "textinput_v2_interface_p.h"
+#include "textinput_v3_interface_p.h"
 
 #include <QHash>
+#include <QPointer>
 #include <QTemporaryFile>
 
+#include <cstring>
+#include <optional>
 #include <unistd.h>
+#include <utility>
 
 #include "qwayland-server-input-method-unstable-v1.h"
 #include "qwayland-server-text-input-unstable-v1.h"
@@ -30,14 +36,71 @@ static int s_version = 1;
 class InputKeyboardV1InterfacePrivate : public QtWaylandServer::wl_keyboard
 {
 public:
-    InputKeyboardV1InterfacePrivate()
+    InputKeyboardV1InterfacePrivate(InputMethodGrabV1 *q)
+        : q(q)
     {
     }
+
+    ~InputKeyboardV1InterfacePrivate() override
+    {
+        setForwardingKeyboard(nullptr);
+    }
+
+    void setForwardingKeyboard(KeyboardInterface *keyboard);
+
+    InputMethodGrabV1 *const q;
+    QPointer<KeyboardInterface> forwardingKeyboard;
+
+protected:
+    void keyboard_release(Resource *resource) override
+    {
+        wl_resource_destroy(resource->handle);
+    }
+
+    void keyboard_destroy_resource(Resource *resource) override
+    {
+        Q_UNUSED(resource)
+        // the keys go to the focused surface again once the input method lets go of the keyboard
+        if (resourceMap().isEmpty()) {
+            setForwardingKeyboard(nullptr);
+        }
+    }
 };
 
+void InputKeyboardV1InterfacePrivate::setForwardingKeyboard(KeyboardInterface *keyboard)
+{
+    if (forwardingKeyboard) {
+        auto keyboardPrivate = KeyboardInterfacePrivate::get(forwardingKeyboard);
+        if (keyboardPrivate->inputMethodGrab == q) {
+            keyboardPrivate->inputMethodGrab = nullptr;
+        }
+    }
+
+    forwardingKeyboard = resourceMap().isEmpty() ? nullptr : keyboard;
+    if (!forwardingKeyboard) {
+        return;
+    }
+
+    auto keyboardPrivate = KeyboardInterfacePrivate::get(keyboard);
+    keyboardPrivate->inputMethodGrab = q;
+
+    // the input method interprets the keys with the keymap and modifiers of the seat. The grab is
+    // a version 1 wl_keyboard which may map the keymap writable, so it gets its own copy instead
+    // of the sealed file of the seat.
+    if (keyboardPrivate->keymap) {
+        q->sendKeymap(keyboardPrivate->keymapContent);
+    }
+    const auto &modifiers = keyboardPrivate->modifiers;
+    const quint32 serial = keyboardPrivate->seat->display()->nextSerial();
+    const auto resources = resourceMap();
+    for (auto r : resources) {
+        send_modifiers(r->handle, serial, modifiers.depressed, modifiers.latched, modifiers.locked, modifiers.group);
+    }
+}
+
 InputMethodGrabV1::InputMethodGrabV1(QObject *parent)
     : QObject(parent)
-    , d(new InputKeyboardV1InterfacePrivate)
+    , d(new InputKeyboardV1InterfacePrivate(this))
 {
 }
 
@@ -103,10 +166,54 @@ public:
     {
     }
 
+    TextInputV3InterfacePrivate *enabledTextInputV3() const
+    {
+        TextInputV3Interface *textInput = textInputSeat ? textInputSeat->textInputV3() : nullptr;
+        return textInput && textInput->isEnabled() ? TextInputV3InterfacePrivate::get(textInput) : nullptr;
+    }
+    TextInputV2InterfacePrivate *enabledTextInputV2() const
+    {
+        TextInputV2Interface *textInput = textInputSeat ? textInputSeat->textInputV2() : nullptr;
+        return textInput && textInput->isEnabled() ? TextInputV2InterfacePrivate::get(textInput) : nullptr;
+    }
+    KeyboardInterfacePrivate *grabbedKeyboard() const
+    {
+        if (!m_keyboardGrab || !m_keyboardGrab->d->forwardingKeyboard) {
+            return nullptr;
+        }
+        return KeyboardInterfacePrivate::get(m_keyboardGrab->d->forwardingKeyboard);
+    }
+
+    // the text input v2 sends the text right away, the v3 one keeps it until the done event
+    void zwp_input_method_context_v1_commit_string_utf8(Resource *resource, uint32_t serial, const char *text) override
+    {
+        if (auto textInput = enabledTextInputV3()) {
+            textInput->commitString(QByteArray(text));
+            textInput->done();
+        } else if (auto textInput = enabledTextInputV2()) {
+            textInput->commitString(QByteArray::fromRawData(text, strlen(text)));
+        } else {
+            zwp_input_method_context_v1::zwp_input_method_context_v1_commit_string_utf8(resource, serial, text);
+        }
+    }
     void zwp_input_method_context_v1_commit_string(Resource *, uint32_t serial, const QString &text) override
     {
         Q_EMIT q->commitString(serial, text);
     }
+    void zwp_input_method_context_v1_preedit_string_utf8(Resource *resource, uint32_t serial, const char *text, const char *commit) override
+    {
+        const std::optional<qint32> cursor = std::exchange(preEditCursor, std::nullopt);
+        if (auto textInput = enabledTextInputV3()) {
+            // without a pre-edit cursor request the cursor is at the end of the pre-edit string
+            const quint32 position = cursor.value_or(strlen(text));
+            textInput->sendPreEdit(QByteArray(text), position, position);
+            textInput->done();
+        } else if (auto textInput = enabledTextInputV2()) {
+            textInput->preEdit(QByteArray::fromRawData(text, strlen(text)), QByteArray::fromRawData(commit, strlen(commit)));
+        } else {
+            zwp_input_method_context_v1::zwp_input_method_context_v1_preedit_string_utf8(resource, serial, text, commit);
+        }
+    }
     void zwp_input_method_context_v1_preedit_string(Resource *, uint32_t serial, const QString &text, const QString &commit) override
     {
         Q_EMIT q->preeditString(serial, text, commit);
@@ -114,18 +221,51 @@ public:
 
     void zwp_input_method_context_v1_preedit_styling(Resource *, uint32_t index, uint32_t length, uint32_t style) override
     {
+        if (auto textInput = enabledTextInputV2()) {
+            textInput->preEditStyling(index, length, style);
+            return;
+        }
         Q_EMIT q->preeditStyling(index, length, style);
     }
     void zwp_input_method_context_v1_preedit_cursor(Resource *, int32_t index) override
     {
-        Q_EMIT q->preeditCursor(index);
+        if (enabledTextInputV3()) {
+            // it applies to the following pre-edit string
+            preEditCursor = index;
+        } else if (auto textInput = enabledTextInputV2()) {
+            textInput->setPreEditCursor(index);
+        } else {
+            Q_EMIT q->preeditCursor(index);
+        }
     }
     void zwp_input_method_context_v1_delete_surrounding_text(Resource *, int32_t index, uint32_t length) override
     {
-        Q_EMIT q->deleteSurroundingText(index, length);
+        auto textInputV3 = enabledTextInputV3();
+        auto textInputV2 = textInputV3 ? nullptr : enabledTextInputV2();
+        if (!textInputV3 && !textInputV2) {
+            Q_EMIT q->deleteSurroundingText(index, length);
+            return;
+        }
+        // the text inputs delete the text before and after the cursor, a range that doesn't
+        // contain the cursor can't be expressed
+        if (index > 0 || index + qint64(length) < 0) {
+            return;
+        }
+        const quint32 before = -index;
+        const quint32 after = index + length;
+        // applied together with the next commit string
+        if (textInputV3) {
+            textInputV3->deleteSurroundingText(before, after);
+        } else {
+            textInputV2->deleteSurroundingText(before, after);
+        }
     }
     void zwp_input_method_context_v1_cursor_position(Resource *, int32_t index, int32_t anchor) override
     {
+        if (auto textInput = enabledTextInputV2()) {
+            textInput->setCursorPosition(index, anchor);
+            return;
+        }
         Q_EMIT q->cursorPosition(index, anchor);
     }
     void zwp_input_method_context_v1_modifiers_map(Resource *, wl_array *map) override
@@ -136,16 +276,32 @@ public:
     }
     void zwp_input_method_context_v1_keysym(Resource *, uint32_t serial, uint32_t time, uint32_t sym, uint32_t state, uint32_t modifiers) override
     {
+        if (auto textInput = enabledTextInputV2()) {
+            if (state == WL_KEYBOARD_KEY_STATE_PRESSED) {
+                textInput->keysymPressed(sym, modifiers);
+            } else {
+                textInput->keysymReleased(sym, modifiers);
+            }
+            return;
+        }
         Q_EMIT q->keysym(serial, time, sym, state == WL_KEYBOARD_KEY_STATE_PRESSED, modifiers);
     }
     void zwp_input_method_context_v1_grab_keyboard(Resource *resource, uint32_t id) override
     {
         m_keyboardGrab.reset(new InputMethodGrabV1(q));
         m_keyboardGrab->d->add(resource->client(), id, 1);
+        if (keyboardSeat) {
+            m_keyboardGrab->d->setForwardingKeyboard(keyboardSeat->keyboard());
+        }
         Q_EMIT q->keyboardGrabRequested(m_keyboardGrab.data());
     }
     void zwp_input_method_context_v1_key(Resource *, uint32_t serial, uint32_t time, uint32_t key, uint32_t state) override
     {
+        // passed on without going through the grab again
+        if (auto keyboard = grabbedKeyboard()) {
+            keyboard->sendKey(key, KeyboardKeyState(state));
+            return;
+        }
         Q_EMIT q->key(serial, time, key, state == WL_KEYBOARD_KEY_STATE_PRESSED);
     }
     void zwp_input_method_context_v1_modifiers(Resource *,
@@ -155,6 +311,12 @@ public:
                                                uint32_t mods_locked,
                                                uint32_t group) override
     {
+        if (auto keyboard = grabbedKeyboard()) {
+            if (keyboard->focusedSurface) {
+                keyboard->sendModifiers(mods_depressed, mods_latched, mods_locked, group, keyboard->seat->display()->nextSerial());
+            }
+            return;
+        }
         Q_EMIT q->modifiers(serial, mods_depressed, mods_latched, mods_locked, group);
     }
     void zwp_input_method_context_v1_language(Resource *, uint32_t serial, const QString &language) override
@@ -188,6 +350,17 @@ public:
 
     InputMethodContextV1Interface *const q;
     QScopedPointer<InputMethodGrabV1> m_keyboardGrab;
+
+    QPointer<SeatInterface> textInputSeat;
+    QPointer<SeatInterface> keyboardSeat;
+    // the byte offset of the cursor in the next pre-edit string
+    std::optional<qint32> preEditCursor;
+
+    // the last surrounding text sent
+    QString m_surroundingText;
+    quint32 m_surroundingTextCursor = 0;
+    quint32 m_surroundingTextAnchor = 0;
+    bool m_surroundingTextSent = false;
 };
 
 InputMethodContextV1Interface::InputMethodContextV1Interface(InputMethodV1Interface *parent)
@@ -307,6 +480,8 @@ void InputMethodContextV1Interface::sendPreferredLanguage(const QString &languag
 
 void InputMethodContextV1Interface::sendReset()
 {
+    // the input method starts over, it needs the surrounding text again
+    d->m_surroundingTextSent = false;
     for (auto r : d->resourceMap()) {
         d->send_reset(r->handle);
     }
@@ -314,8 +489,18 @@ void InputMethodContextV1Interface::sendReset()
 
 void InputMethodContextV1Interface::sendSurroundingText(const QString &text, uint32_t cursor, uint32_t anchor)
 {
+    // a long surrounding text would otherwise be encoded and sent again for every key press
+    if (d->m_surroundingTextSent && d->m_surroundingTextCursor == cursor && d->m_surroundingTextAnchor == anchor && d->m_surroundingText == text) {
+        return;
+    }
+    d->m_surroundingText = text;
+    d->m_surroundingTextCursor = cursor;
+    d->m_surroundingTextAnchor = anchor;
+    d->m_surroundingTextSent = true;
+
+    const QByteArray encoded = text.toUtf8();
     for (auto r : d->resourceMap()) {
-        d->send_surrounding_text(r->handle, text, cursor, anchor);
+        zwp_input_method_context_v1_send_surrounding_text(r->handle, encoded.constData(), cursor, anchor);
     }
 }
 
@@ -324,6 +509,30 @@ InputMethodGrabV1 *InputMethodContextV1Interface::keyboardGrab() const
     return d->m_keyboardGrab.get();
 }
 
+void InputMethodContextV1Interface::setTextInputForwarding(SeatInterface *seat)
+{
+    d->textInputSeat = seat;
+    d->preEditCursor.reset();
+}
+
+SeatInterface *InputMethodContextV1Interface::textInputForwarding() const
+{
+    return d->textInputSeat;
+}
+
+void InputMethodContextV1Interface::setKeyboardGrabForwarding(SeatInterface *seat)
+{
+    d->keyboardSeat = seat;
+    if (d->m_keyboardGrab) {
+        d->m_keyboardGrab->d->setForwardingKeyboard(seat ? seat->keyboard() : nullptr);
+    }
+}
+
+SeatInterface *InputMethodContextV1Interface::keyboardGrabForwarding() const
+{
+    return d->keyboardSeat;
+}
+
 class InputPanelSurfaceV1InterfacePrivate : public QtWaylandServer::zwp_input_panel_surface_v1, public SurfaceRole
 {
     friend class InputPanelSurfaceV1Interface;
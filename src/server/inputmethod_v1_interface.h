@@ -19,6 +19,7 @@ class OutputInterface;
 class SurfaceInterface;
 class Display;
 class KeyboardInterface;
+class SeatInterface;
 class InputPanelSurfaceV1Interface;
 class InputMethodContextV1Interface;
 
@@ -80,6 +81,34 @@ public:
 
     InputMethodGrabV1 *keyboardGrab() const;
 
+    /**
+     * Passes the text of the input method straight on to the enabled text input of @p seat.
+     *
+     * The commit string, pre-edit string, pre-edit cursor, pre-edit styling, cursor position,
+     * delete surrounding text and keysym requests go to the TextInputV3Interface of the seat,
+     * or its TextInputV2Interface, without being converted from UTF-8. The corresponding
+     * signals are not emitted for them anymore. The done event of the text input v3 follows
+     * the commit and pre-edit strings. Requests no enabled text input can take, e.g. keysyms
+     * while a text input v3 is enabled, are still emitted as signals.
+     *
+     * Pass @c nullptr to only emit the signals again, which is the default.
+     */
+    void setTextInputForwarding(SeatInterface *seat);
+    SeatInterface *textInputForwarding() const;
+
+    /**
+     * Sends the keys and modifiers of the keyboard of @p seat to the keyboard grab of the input
+     * method, instead of the focused surface, as long as the input method grabs the keyboard.
+     *
+     * The keys and modifiers the input method passes on through the context go to the focused
+     * surface directly, the key and modifiers signals are not emitted anymore then.
+     *
+     * Pass @c nullptr to stop forwarding, which is the default. The compositor is expected to
+     * relay the keys through keyboardGrab() by itself in that case.
+     */
+    void setKeyboardGrabForwarding(SeatInterface *seat);
+    SeatInterface *keyboardGrabForwarding() const;
+
 Q_SIGNALS:
     void commitString(quint32 serial, const QString &text);
     void preeditString(quint32 serial, const QString &text, const QString &commit);
@@ -4,13 +4,13 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "display.h"
+#include "inputmethod_v1_interface.h"
 #include "keyboard_interface_p.h"
 #include "logging.h"
 #include "seat_interface.h"
 #include "seat_interface_p.h"
 #include "surface_interface.h"
 // Qt
-#include <QTemporaryFile>
 #include <QVector>
 
 #include <unistd.h>
@@ -29,18 +29,19 @@ void KeyboardInterfacePrivate::keyboard_release(Resource *resource)
 
 void KeyboardInterfacePrivate::keyboard_bind_resource(Resource *resource)
 {
+    clientResources.add(resource);
+
     const ClientConnection *focusedClient = focusedSurface ? focusedSurface->client() : nullptr;
 
     if (resource->version() >= WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
         send_repeat_info(resource->handle, keyRepeat.charactersPerSecond, keyRepeat.delay);
     }
-    if (!keymap.isNull()) {
+    if (keymap) {
         sendKeymap(resource);
     }
 
     if (focusedClient && focusedClient->client() == resource->client()) {
-        const QVector<quint32> keys = pressedKeys();
-        const QByteArray keysData = QByteArray::fromRawData(reinterpret_cast<const char *>(keys.data()), sizeof(quint32) * keys.count());
+        const QByteArray keysData = pressedKeysData();
         const quint32 serial = seat->display()->nextSerial();
 
         send_enter(resource->handle, serial, focusedSurface->resource(), keysData);
@@ -48,9 +49,14 @@ void KeyboardInterfacePrivate::keyboard_bind_resource(Resource *resource)
     }
 }
 
+void KeyboardInterfacePrivate::keyboard_destroy_resource(Resource *resource)
+{
+    clientResources.remove(resource);
+}
+
 QList<KeyboardInterfacePrivate::Resource *> KeyboardInterfacePrivate::keyboardsForClient(ClientConnection *client) const
 {
-    return resourceMap().values(client->client());
+    return clientResources.resources(client->client());
 }
 
 void KeyboardInterfacePrivate::sendLeave(SurfaceInterface *surface, quint32 serial)
@@ -63,8 +69,7 @@ void KeyboardInterfacePrivate::sendLeave(SurfaceInterface *surface, quint32 seri
 
 void KeyboardInterfacePrivate::sendEnter(SurfaceInterface *surface, quint32 serial)
 {
-    const auto states = pressedKeys();
-    QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(states.constData()), sizeof(quint32) * states.size());
+    const QByteArray data = pressedKeysData();
 
     const QList<Resource *> keyboards = keyboardsForClient(surface->client());
     for (Resource *keyboardResource : keyboards) {
@@ -74,41 +79,53 @@ void KeyboardInterfacePrivate::sendEnter(SurfaceInterface *surface, quint32 seri
 
 void KeyboardInterfacePrivate::sendKeymap(Resource *resource)
 {
-    QScopedPointer<QTemporaryFile> tmp(new QTemporaryFile());
-    if (!tmp->open()) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to create keymap file:" << tmp->errorString();
-        return;
+    // only since version 7 clients have to map the keymap with MAP_PRIVATE
+    if (resource->version() < 7) {
+        const int fd = keymap->createPrivateCopy();
+        if (fd != -1) {
+            send_keymap(resource->handle, keymap_format::keymap_format_xkb_v1, fd, keymap->size());
+            close(fd);
+            return;
+        }
     }
+    send_keymap(resource->handle, keymap_format::keymap_format_xkb_v1, keymap->fd(), keymap->size());
+}
 
-    unlink(tmp->fileName().toUtf8().constData());
-    if (!tmp->resize(keymap.size())) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to resize keymap file:" << tmp->errorString();
+void KeyboardInterface::setKeymap(const QByteArray &content)
+{
+    if (content.isNull()) {
         return;
     }
 
-    uchar *address = tmp->map(0, keymap.size());
-    if (!address) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to map keymap file:" << tmp->errorString();
+    // libwayland duplicates the descriptor when sending it, so the same file can be shared
+    // by every resource and the previous one can be closed right away.
+    QSharedPointer<KeymapFile> keymap = KeymapFile::shared(content);
+    if (!keymap) {
         return;
     }
-
-    qstrncpy(reinterpret_cast<char *>(address), keymap.constData(), keymap.size() + 1);
-    tmp->unmap(address);
-
-    send_keymap(resource->handle, keymap_format::keymap_format_xkb_v1, tmp->handle(), tmp->size());
+    d->seatKeymap = content;
+    d->seatKeymapFile = keymap;
+    d->setKeymap(content, keymap);
 }
 
-void KeyboardInterface::setKeymap(const QByteArray &content)
+void KeyboardInterfacePrivate::setKeymap(const QByteArray &content, const QSharedPointer<KeymapFile> &file)
 {
-    if (content.isNull()) {
-        return;
-    }
+    keymap = file;
+    keymapContent = content;
 
-    d->keymap = content;
+    const auto keyboardResources = resourceMap();
+    for (Resource *resource : keyboardResources) {
+        sendKeymap(resource);
+    }
+    if (inputMethodGrab) {
+        inputMethodGrab->sendKeymap(content);
+    }
+}
 
-    const auto keyboardResources = d->resourceMap();
-    for (KeyboardInterfacePrivate::Resource *resource : keyboardResources) {
-        d->sendKeymap(resource);
+void KeyboardInterfacePrivate::restoreSeatKeymap()
+{
+    if (seatKeymapFile && keymap != seatKeymapFile) {
+        setKeymap(seatKeymap, seatKeymapFile);
     }
 }
 
@@ -122,16 +139,10 @@ void KeyboardInterfacePrivate::sendModifiers(quint32 depressed, quint32 latched,
 
 bool KeyboardInterfacePrivate::updateKey(quint32 key, KeyboardKeyState state)
 {
-    auto it = states.find(key);
-    if (it == states.end()) {
-        states.insert(key, state);
-        return true;
-    }
-    if (it.value() == state) {
-        return false;
+    if (state == KeyboardKeyState::Pressed) {
+        return pressedKeys.insert(key);
     }
-    it.value() = state;
-    return true;
+    return pressedKeys.remove(key);
 }
 
 KeyboardInterface::KeyboardInterface(SeatInterface *seat)
@@ -170,15 +181,10 @@ void KeyboardInterface::setFocusedSurface(SurfaceInterface *surface, quint32 ser
     d->sendModifiers();
 }
 
-QVector<quint32> KeyboardInterfacePrivate::pressedKeys() const
+QByteArray KeyboardInterfacePrivate::pressedKeysData() const
 {
-    QVector<quint32> keys;
-    for (auto it = states.constBegin(); it != states.constEnd(); ++it) {
-        if (it.value() == KeyboardKeyState::Pressed) {
-            keys << it.key();
-        }
-    }
-    return keys;
+    // the keys array of the enter event, without copying the keys
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(pressedKeys.constData()), sizeof(quint32) * pressedKeys.count());
 }
 
 void KeyboardInterface::sendKey(quint32 key, KeyboardKeyState state)
@@ -186,15 +192,29 @@ void KeyboardInterface::sendKey(quint32 key, KeyboardKeyState state)
     if (!d->updateKey(key, state)) {
         return;
     }
+    d->processKey(key, state);
+}
 
-    if (!d->focusedSurface) {
+void KeyboardInterfacePrivate::processKey(quint32 key, KeyboardKeyState state)
+{
+    if (inputMethodGrab) {
+        // the input method passes the keys it doesn't consume on through its context
+        inputMethodGrab->sendKey(seat->display()->nextSerial(), seat->timestamp(), key, state);
+        return;
+    }
+    sendKey(key, state);
+}
+
+void KeyboardInterfacePrivate::sendKey(quint32 key, KeyboardKeyState state)
+{
+    if (!focusedSurface) {
         return;
     }
 
-    const QList<KeyboardInterfacePrivate::Resource *> keyboards = d->keyboardsForClient(d->focusedSurface->client());
-    const quint32 serial = d->seat->display()->nextSerial();
-    for (KeyboardInterfacePrivate::Resource *keyboardResource : keyboards) {
-        d->send_key(keyboardResource->handle, serial, d->seat->timestamp(), key, quint32(state));
+    const QList<Resource *> keyboards = keyboardsForClient(focusedSurface->client());
+    const quint32 serial = seat->display()->nextSerial();
+    for (Resource *keyboardResource : keyboards) {
+        send_key(keyboardResource->handle, serial, seat->timestamp(), key, quint32(state));
     }
 }
 
@@ -214,6 +234,10 @@ void KeyboardInterface::sendModifiers(quint32 depressed, quint32 latched, quint3
         return;
     }
 
+    if (d->inputMethodGrab) {
+        d->inputMethodGrab->sendModifiers(d->seat->display()->nextSerial(), depressed, latched, locked, group);
+        return;
+    }
     if (!d->focusedSurface) {
         return;
     }
@@ -6,15 +6,18 @@
 #pragma once
 
 #include "keyboard_interface.h"
+#include "keymapfile.h"
+#include "utils_p.h"
 
 #include <qwayland-server-wayland.h>
 
-#include <QHash>
 #include <QPointer>
+#include <QScopedPointer>
 
 namespace KWaylandServer
 {
 class ClientConnection;
+class InputMethodGrabV1;
 
 class KeyboardInterfacePrivate : public QtWaylandServer::wl_keyboard
 {
@@ -22,6 +25,12 @@ public:
     KeyboardInterfacePrivate(SeatInterface *s);
 
     void sendKeymap(Resource *resource);
+    void setKeymap(const QByteArray &content, const QSharedPointer<KeymapFile> &file);
+    // switches back to the keymap of the seat after a virtual keyboard has used its own
+    void restoreSeatKeymap();
+    void sendKey(quint32 key, KeyboardKeyState state);
+    // sends a key whose state has been updated already to the input method grab or the focused surface
+    void processKey(quint32 key, KeyboardKeyState state);
     void sendModifiers();
     void sendModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group, quint32 serial);
 
@@ -37,7 +46,13 @@ public:
     SeatInterface *seat;
     SurfaceInterface *focusedSurface = nullptr;
     QMetaObject::Connection destroyConnection;
-    QByteArray keymap;
+    QSharedPointer<KeymapFile> keymap;
+    QByteArray keymapContent;
+    // the keymap set through KeyboardInterface::setKeymap, a virtual keyboard can replace it for a while
+    QByteArray seatKeymap;
+    QSharedPointer<KeymapFile> seatKeymapFile;
+    // gets the keys instead of the focused surface, installed by the input method context
+    InputMethodGrabV1 *inputMethodGrab = nullptr;
 
     struct {
         qint32 charactersPerSecond = 0;
@@ -53,13 +68,15 @@ public:
     };
     Modifiers modifiers;
 
-    QHash<quint32, KeyboardKeyState> states;
+    ClientResources<Resource> clientResources;
+    SmallFlatSet<quint32, 16> pressedKeys;
     bool updateKey(quint32 key, KeyboardKeyState state);
-    QVector<quint32> pressedKeys() const;
+    QByteArray pressedKeysData() const;
 
 protected:
     void keyboard_release(Resource *resource) override;
     void keyboard_bind_resource(Resource *resource) override;
+    void keyboard_destroy_resource(Resource *resource) override;
 };
 
 }
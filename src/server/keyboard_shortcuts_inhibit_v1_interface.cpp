@@ -10,6 +10,7 @@
 
 #include "display.h"
 #include "seat_interface.h"
+#include "seat_interface_p.h"
 #include "surface_interface.h"
 
 static const int s_version = 1;
@@ -21,12 +22,10 @@ class KeyboardShortcutsInhibitorV1InterfacePrivate : public QtWaylandServer::zwp
 public:
     KeyboardShortcutsInhibitorV1InterfacePrivate(SurfaceInterface *surface,
                                                  SeatInterface *seat,
-                                                 KeyboardShortcutsInhibitManagerV1Interface *manager,
                                                  KeyboardShortcutsInhibitorV1Interface *q,
                                                  wl_resource *resource);
 
     KeyboardShortcutsInhibitorV1Interface *q;
-    QPointer<KeyboardShortcutsInhibitManagerV1Interface> m_manager;
     SurfaceInterface *const m_surface;
     SeatInterface *const m_seat;
     bool m_active;
@@ -49,11 +48,8 @@ public:
 
     KeyboardShortcutsInhibitorV1Interface *findInhibitor(SurfaceInterface *surface, SeatInterface *seat) const;
 
-    void removeInhibitor(SurfaceInterface *const surface, SeatInterface *const seat);
-
     KeyboardShortcutsInhibitManagerV1Interface *q;
     Display *const m_display;
-    QHash<QPair<SurfaceInterface *, SeatInterface *>, KeyboardShortcutsInhibitorV1Interface *> m_inhibitors;
 
 protected:
     void zwp_keyboard_shortcuts_inhibit_manager_v1_destroy(Resource *resource) override;
@@ -61,12 +57,10 @@ protected:
 
 KeyboardShortcutsInhibitorV1InterfacePrivate::KeyboardShortcutsInhibitorV1InterfacePrivate(SurfaceInterface *surface,
                                                                                            SeatInterface *seat,
-                                                                                           KeyboardShortcutsInhibitManagerV1Interface *manager,
                                                                                            KeyboardShortcutsInhibitorV1Interface *q,
                                                                                            wl_resource *resource)
     : zwp_keyboard_shortcuts_inhibitor_v1(resource)
     , q(q)
-    , m_manager(manager)
     , m_surface(surface)
     , m_seat(seat)
     , m_active(false)
@@ -81,19 +75,15 @@ void KeyboardShortcutsInhibitorV1InterfacePrivate::zwp_keyboard_shortcuts_inhibi
 void KeyboardShortcutsInhibitorV1InterfacePrivate::zwp_keyboard_shortcuts_inhibitor_v1_destroy_resource(Resource *resource)
 {
     Q_UNUSED(resource)
-    // Ensure manager don't track anymore this inhibitor
-    if (m_manager) {
-        m_manager->removeInhibitor(m_surface, m_seat);
-    }
+    // the seat stops tracking the inhibitor once it's destroyed
     delete q;
 }
 
 KeyboardShortcutsInhibitorV1Interface::KeyboardShortcutsInhibitorV1Interface(SurfaceInterface *surface,
                                                                              SeatInterface *seat,
-                                                                             KeyboardShortcutsInhibitManagerV1Interface *manager,
                                                                              wl_resource *resource)
     : QObject(nullptr)
-    , d(new KeyboardShortcutsInhibitorV1InterfacePrivate(surface, seat, manager, this, resource))
+    , d(new KeyboardShortcutsInhibitorV1InterfacePrivate(surface, seat, this, resource))
 {
 }
 
@@ -142,21 +132,21 @@ void KeyboardShortcutsInhibitManagerV1InterfacePrivate::zwp_keyboard_shortcuts_i
 {
     SeatInterface *seat = SeatInterface::get(seat_resource);
     SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
-    if (m_inhibitors.contains({surface, seat})) {
+    if (findInhibitor(surface, seat)) {
         wl_resource_post_error(resource->handle, error::error_already_inhibited, "the shortcuts are already inhibited for this surface and seat");
         return;
     }
 
     wl_resource *inhibitorResource = wl_resource_create(resource->client(), &zwp_keyboard_shortcuts_inhibitor_v1_interface, resource->version(), id);
-    auto inhibitor = new KeyboardShortcutsInhibitorV1Interface(surface, seat, q, inhibitorResource);
-    m_inhibitors[{surface, seat}] = inhibitor;
+    auto inhibitor = new KeyboardShortcutsInhibitorV1Interface(surface, seat, inhibitorResource);
+    SeatInterfacePrivate::get(seat)->registerShortcutsInhibitor(inhibitor);
     Q_EMIT q->inhibitorCreated(inhibitor);
     inhibitor->setActive(true);
 }
 
 KeyboardShortcutsInhibitorV1Interface *KeyboardShortcutsInhibitManagerV1InterfacePrivate::findInhibitor(SurfaceInterface *surface, SeatInterface *seat) const
 {
-    return m_inhibitors.value({surface, seat}, nullptr);
+    return SeatInterfacePrivate::get(seat)->shortcutsInhibitors.value(surface, nullptr);
 }
 
 void KeyboardShortcutsInhibitManagerV1InterfacePrivate::zwp_keyboard_shortcuts_inhibit_manager_v1_destroy(Resource *resource)
@@ -164,11 +154,6 @@ void KeyboardShortcutsInhibitManagerV1InterfacePrivate::zwp_keyboard_shortcuts_i
     wl_resource_destroy(resource->handle);
 }
 
-void KeyboardShortcutsInhibitManagerV1InterfacePrivate::removeInhibitor(SurfaceInterface *const surface, SeatInterface *const seat)
-{
-    m_inhibitors.remove({surface, seat});
-}
-
 KeyboardShortcutsInhibitManagerV1Interface::KeyboardShortcutsInhibitManagerV1Interface(Display *display, QObject *parent)
     : QObject(parent)
     , d(new KeyboardShortcutsInhibitManagerV1InterfacePrivate(display, this))
@@ -182,9 +167,4 @@ KeyboardShortcutsInhibitorV1Interface *KeyboardShortcutsInhibitManagerV1Interfac
     return d->findInhibitor(surface, seat);
 }
 
-void KeyboardShortcutsInhibitManagerV1Interface::removeInhibitor(SurfaceInterface *surface, SeatInterface *seat)
-{
-    d->removeInhibitor(surface, seat);
-}
-
 }
@@ -38,10 +38,7 @@ public:
 
 private:
     friend class KeyboardShortcutsInhibitManagerV1InterfacePrivate;
-    explicit KeyboardShortcutsInhibitorV1Interface(SurfaceInterface *surface,
-                                                   SeatInterface *seat,
-                                                   KeyboardShortcutsInhibitManagerV1Interface *manager,
-                                                   wl_resource *resource);
+    explicit KeyboardShortcutsInhibitorV1Interface(SurfaceInterface *surface, SeatInterface *seat, wl_resource *resource);
     QScopedPointer<KeyboardShortcutsInhibitorV1InterfacePrivate> d;
 };
 
@@ -60,6 +57,7 @@ public:
 
     /**
      * return shortucts inhibitor associated with surface and seat, if no shortcut are associated, return nullptr
+     * @see SeatInterface::focusedKeyboardShortcutsInhibitor
      */
     KeyboardShortcutsInhibitorV1Interface *findInhibitor(SurfaceInterface *surface, SeatInterface *seat) const;
 
@@ -70,8 +68,6 @@ Q_SIGNALS:
     void inhibitorCreated(KeyboardShortcutsInhibitorV1Interface *inhibitor);
 
 private:
-    friend class KeyboardShortcutsInhibitorV1InterfacePrivate;
-    void removeInhibitor(SurfaceInterface *const surface, SeatInterface *const seat);
     QScopedPointer<KeyboardShortcutsInhibitManagerV1InterfacePrivate> d;
 };
 
@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "keymapfile.h"
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QMutex>
+
+namespace KWaylandServer
+{
+KeymapFile::KeymapFile(const QByteArray &content)
+    // constData() is null terminated, the terminator is part of the keymap
+    : SealedFile(QByteArray::fromRawData(content.constData(), content.size() + 1), "wayland-keymap")
+{
+}
+
+QSharedPointer<KeymapFile> KeymapFile::shared(const QByteArray &content)
+{
+    // the displays may run on different threads
+    static QMutex mutex;
+    static QHash<QByteArray, QWeakPointer<KeymapFile>> files;
+
+    const QByteArray hash = QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+    QMutexLocker locker(&mutex);
+    if (QSharedPointer<KeymapFile> file = files.value(hash).toStrongRef()) {
+        return file;
+    }
+
+    for (auto it = files.begin(); it != files.end();) {
+        if (it->isNull()) {
+            it = files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    QSharedPointer<KeymapFile> file(new KeymapFile(content));
+    if (!file->isValid()) {
+        return QSharedPointer<KeymapFile>();
+    }
+    files.insert(hash, file);
+    return file;
+}
+
+} // namespace KWaylandServer
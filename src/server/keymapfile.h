@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "sealedfile.h"
+
+#include <QSharedPointer>
+
+namespace KWaylandServer
+{
+/**
+ * A read-only file holding a keymap, suitable to be passed to wl_keyboard.keymap.
+ *
+ * The size of the file includes the terminating null byte of the keymap. Clients of
+ * wl_keyboard before version 7 may map the keymap writable, they need a private copy.
+ */
+class KeymapFile : public SealedFile
+{
+public:
+    explicit KeymapFile(const QByteArray &content);
+
+    /**
+     * Returns the file holding @p content, shared by everyone who uses a keymap with the same
+     * content, e.g. the keyboard of the seat and the virtual keyboards, which tend to use the
+     * same few layouts. The files are looked up by a hash of their content, a new one is only
+     * created when nobody holds one with the @p content. Returns a null pointer if the file
+     * could not be created.
+     */
+    static QSharedPointer<KeymapFile> shared(const QByteArray &content);
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,405 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "layershell_v1_arrangement.h"
+#include "layershell_v1_interface.h"
+#include "output_interface.h"
+#include "strut_interface.h"
+#include "surface_interface.h"
+
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+
+#include <algorithm>
+#include <optional>
+
+namespace KWaylandServer
+{
+
+class LayerShellV1ArrangementPrivate
+{
+public:
+    struct Entry {
+        LayerSurfaceV1Interface *surface = nullptr;
+        QRect geometry;
+        QSize configuredSize;
+        bool configured = false;
+        QVector<QMetaObject::Connection> connections;
+    };
+
+    LayerShellV1ArrangementPrivate(LayerShellV1Arrangement *q, OutputInterface *output);
+
+    Entry *findEntry(LayerSurfaceV1Interface *surface);
+    void scheduleArrange();
+    void arrange();
+    QRect computeOutputGeometry() const;
+    QRect applyStruts(const QRect &outputRect) const;
+    bool place(Entry &entry, const QRect &bounds, QRect *workArea);
+
+    LayerShellV1Arrangement *q;
+    QPointer<OutputInterface> output;
+    std::optional<QRect> explicitGeometry;
+    // in the order the surfaces were added, it decides which exclusive zone comes first
+    QVector<Entry> entries;
+    QHash<SurfaceInterface *, deepinKwinStrut> struts;
+    QHash<SurfaceInterface *, QMetaObject::Connection> strutConnections;
+    QMetaObject::Connection strutInterfaceConnection;
+    QRect workArea;
+    bool arrangePending = false;
+};
+
+LayerShellV1ArrangementPrivate::LayerShellV1ArrangementPrivate(LayerShellV1Arrangement *q, OutputInterface *output)
+    : q(q)
+    , output(output)
+{
+}
+
+LayerShellV1ArrangementPrivate::Entry *LayerShellV1ArrangementPrivate::findEntry(LayerSurfaceV1Interface *surface)
+{
+    for (Entry &entry : entries) {
+        if (entry.surface == surface) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void LayerShellV1ArrangementPrivate::scheduleArrange()
+{
+    if (arrangePending) {
+        return;
+    }
+    arrangePending = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this]() {
+            if (arrangePending) {
+                arrange();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+QRect LayerShellV1ArrangementPrivate::computeOutputGeometry() const
+{
+    if (explicitGeometry) {
+        return *explicitGeometry;
+    }
+    if (!output) {
+        return QRect();
+    }
+    QSize size = output->pixelSize() / std::max(output->scale(), 1);
+    switch (output->transform()) {
+    case OutputInterface::Transform::Rotated90:
+    case OutputInterface::Transform::Rotated270:
+    case OutputInterface::Transform::Flipped90:
+    case OutputInterface::Transform::Flipped270:
+        size.transpose();
+        break;
+    default:
+        break;
+    }
+    return QRect(output->globalPosition(), size);
+}
+
+static bool strutRangeOverlaps(int start, int end, int min, int max)
+{
+    // a strut without range covers the whole edge
+    if (start == 0 && end == 0) {
+        return true;
+    }
+    return start <= max && end >= min;
+}
+
+QRect LayerShellV1ArrangementPrivate::applyStruts(const QRect &outputRect) const
+{
+    QRect area = outputRect;
+    for (const deepinKwinStrut &strut : struts) {
+        if (strut.left > 0 && strutRangeOverlaps(strut.left_start_y, strut.left_end_y, outputRect.top(), outputRect.bottom())) {
+            area.setLeft(std::max(area.left(), outputRect.left() + strut.left));
+        }
+        if (strut.right > 0 && strutRangeOverlaps(strut.right_start_y, strut.right_end_y, outputRect.top(), outputRect.bottom())) {
+            area.setRight(std::min(area.right(), outputRect.right() - strut.right));
+        }
+        if (strut.top > 0 && strutRangeOverlaps(strut.top_start_x, strut.top_end_x, outputRect.left(), outputRect.right())) {
+            area.setTop(std::max(area.top(), outputRect.top() + strut.top));
+        }
+        if (strut.bottom > 0 && strutRangeOverlaps(strut.bottom_start_x, strut.bottom_end_x, outputRect.left(), outputRect.right())) {
+            area.setBottom(std::min(area.bottom(), outputRect.bottom() - strut.bottom));
+        }
+    }
+    return area;
+}
+
+bool LayerShellV1ArrangementPrivate::place(Entry &entry, const QRect &bounds, QRect *workArea)
+{
+    LayerSurfaceV1Interface *surface = entry.surface;
+    const Qt::Edges anchor = surface->anchor();
+    const QMargins margins = surface->margins();
+
+    // a zero size is only allowed if the surface is anchored to both opposite edges
+    int width = surface->desiredSize().width();
+    if (width == 0) {
+        width = std::max(bounds.width() - margins.left() - margins.right(), 0);
+    }
+    int height = surface->desiredSize().height();
+    if (height == 0) {
+        height = std::max(bounds.height() - margins.top() - margins.bottom(), 0);
+    }
+
+    int x;
+    if ((anchor & Qt::LeftEdge) && (anchor & Qt::RightEdge)) {
+        x = bounds.x() + margins.left() + (bounds.width() - margins.left() - margins.right() - width) / 2;
+    } else if (anchor & Qt::LeftEdge) {
+        x = bounds.x() + margins.left();
+    } else if (anchor & Qt::RightEdge) {
+        x = bounds.x() + bounds.width() - margins.right() - width;
+    } else {
+        x = bounds.x() + (bounds.width() - width) / 2;
+    }
+
+    int y;
+    if ((anchor & Qt::TopEdge) && (anchor & Qt::BottomEdge)) {
+        y = bounds.y() + margins.top() + (bounds.height() - margins.top() - margins.bottom() - height) / 2;
+    } else if (anchor & Qt::TopEdge) {
+        y = bounds.y() + margins.top();
+    } else if (anchor & Qt::BottomEdge) {
+        y = bounds.y() + bounds.height() - margins.bottom() - height;
+    } else {
+        y = bounds.y() + (bounds.height() - height) / 2;
+    }
+
+    if (workArea) {
+        const int exclusiveZone = surface->exclusiveZone();
+        switch (surface->exclusiveEdge()) {
+        case Qt::LeftEdge:
+            workArea->setLeft(workArea->left() + exclusiveZone + margins.left());
+            break;
+        case Qt::RightEdge:
+            workArea->setRight(workArea->right() - exclusiveZone - margins.right());
+            break;
+        case Qt::TopEdge:
+            workArea->setTop(workArea->top() + exclusiveZone + margins.top());
+            break;
+        case Qt::BottomEdge:
+            workArea->setBottom(workArea->bottom() - exclusiveZone - margins.bottom());
+            break;
+        default:
+            break;
+        }
+    }
+
+    const QRect geometry(x, y, width, height);
+    if (!entry.configured || entry.configuredSize != geometry.size()) {
+        entry.configuredSize = geometry.size();
+        entry.configured = true;
+        surface->sendConfigure(geometry.size());
+    }
+    if (entry.geometry == geometry) {
+        return false;
+    }
+    entry.geometry = geometry;
+    return true;
+}
+
+void LayerShellV1ArrangementPrivate::arrange()
+{
+    arrangePending = false;
+
+    static const LayerSurfaceV1Interface::Layer layers[] = {
+        LayerSurfaceV1Interface::OverlayLayer,
+        LayerSurfaceV1Interface::TopLayer,
+        LayerSurfaceV1Interface::BottomLayer,
+        LayerSurfaceV1Interface::BackgroundLayer,
+    };
+
+    const QRect outputRect = computeOutputGeometry();
+    QRect area = applyStruts(outputRect);
+    bool changed = false;
+
+    for (Entry &entry : entries) {
+        if (!entry.surface->isCommitted()) {
+            // unmapped surfaces start over with the initial configure
+            changed |= entry.geometry.isValid();
+            entry.geometry = QRect();
+            entry.configured = false;
+        }
+    }
+
+    for (LayerSurfaceV1Interface::Layer layer : layers) {
+        for (Entry &entry : entries) {
+            if (entry.surface->isCommitted() && entry.surface->layer() == layer && entry.surface->exclusiveZone() > 0) {
+                changed |= place(entry, area, &area);
+            }
+        }
+    }
+    for (LayerSurfaceV1Interface::Layer layer : layers) {
+        for (Entry &entry : entries) {
+            if (entry.surface->isCommitted() && entry.surface->layer() == layer && entry.surface->exclusiveZone() <= 0) {
+                changed |= place(entry, entry.surface->exclusiveZone() < 0 ? outputRect : area, nullptr);
+            }
+        }
+    }
+
+    if (workArea != area) {
+        workArea = area;
+        Q_EMIT q->workAreaChanged(workArea);
+    }
+    if (changed) {
+        Q_EMIT q->arranged();
+    }
+}
+
+LayerShellV1Arrangement::LayerShellV1Arrangement(OutputInterface *output, QObject *parent)
+    : QObject(parent)
+    , d(new LayerShellV1ArrangementPrivate(this, output))
+{
+    if (output) {
+        auto schedule = [this]() {
+            if (!d->explicitGeometry) {
+                d->scheduleArrange();
+            }
+        };
+        connect(output, &OutputInterface::globalPositionChanged, this, schedule);
+        connect(output, &OutputInterface::modeChanged, this, schedule);
+        connect(output, &OutputInterface::scaleChanged, this, schedule);
+        connect(output, &OutputInterface::transformChanged, this, schedule);
+    }
+    d->scheduleArrange();
+}
+
+LayerShellV1Arrangement::~LayerShellV1Arrangement() = default;
+
+OutputInterface *LayerShellV1Arrangement::output() const
+{
+    return d->output;
+}
+
+void LayerShellV1Arrangement::setOutputGeometry(const QRect &geometry)
+{
+    if (d->explicitGeometry == geometry) {
+        return;
+    }
+    d->explicitGeometry = geometry;
+    d->scheduleArrange();
+}
+
+QRect LayerShellV1Arrangement::outputGeometry() const
+{
+    return d->computeOutputGeometry();
+}
+
+void LayerShellV1Arrangement::addSurface(LayerSurfaceV1Interface *surface)
+{
+    if (d->findEntry(surface)) {
+        return;
+    }
+
+    LayerShellV1ArrangementPrivate::Entry entry;
+    entry.surface = surface;
+
+    auto schedule = [this]() {
+        d->scheduleArrange();
+    };
+    entry.connections << connect(surface, &LayerSurfaceV1Interface::layerChanged, this, schedule);
+    entry.connections << connect(surface, &LayerSurfaceV1Interface::anchorChanged, this, schedule);
+    entry.connections << connect(surface, &LayerSurfaceV1Interface::desiredSizeChanged, this, schedule);
+    entry.connections << connect(surface, &LayerSurfaceV1Interface::exclusiveZoneChanged, this, schedule);
+    entry.connections << connect(surface, &LayerSurfaceV1Interface::marginsChanged, this, schedule);
+    entry.connections << connect(surface, &LayerSurfaceV1Interface::aboutToBeDestroyed, this, [this, surface]() {
+        removeSurface(surface);
+    });
+    // the initial commit does not have to change any property, neither does unmapping
+    entry.connections << connect(surface->surface(), &SurfaceInterface::committed, this, [this, surface]() {
+        const LayerShellV1ArrangementPrivate::Entry *entry = d->findEntry(surface);
+        if (entry && surface->isCommitted() != entry->configured) {
+            d->scheduleArrange();
+        }
+    });
+
+    d->entries.append(entry);
+    d->scheduleArrange();
+}
+
+void LayerShellV1Arrangement::removeSurface(LayerSurfaceV1Interface *surface)
+{
+    for (auto it = d->entries.begin(); it != d->entries.end(); ++it) {
+        if (it->surface == surface) {
+            for (const QMetaObject::Connection &connection : qAsConst(it->connections)) {
+                disconnect(connection);
+            }
+            d->entries.erase(it);
+            d->scheduleArrange();
+            return;
+        }
+    }
+}
+
+QList<LayerSurfaceV1Interface *> LayerShellV1Arrangement::surfaces() const
+{
+    QList<LayerSurfaceV1Interface *> surfaces;
+    surfaces.reserve(d->entries.count());
+    for (const LayerShellV1ArrangementPrivate::Entry &entry : qAsConst(d->entries)) {
+        surfaces.append(entry.surface);
+    }
+    return surfaces;
+}
+
+void LayerShellV1Arrangement::setStrutInterface(StrutInterface *strut)
+{
+    disconnect(d->strutInterfaceConnection);
+    d->strutInterfaceConnection = QMetaObject::Connection();
+    if (strut) {
+        d->strutInterfaceConnection = connect(strut, &StrutInterface::setStrut, this, [this](SurfaceInterface *surface, deepinKwinStrut &strut) {
+            setStrut(surface, strut);
+        });
+    }
+}
+
+void LayerShellV1Arrangement::setStrut(SurfaceInterface *surface, const deepinKwinStrut &strut)
+{
+    if (!surface) {
+        return;
+    }
+    auto it = d->struts.constFind(surface);
+    if (it != d->struts.constEnd() && *it == strut) {
+        return;
+    }
+    if (!d->strutConnections.contains(surface)) {
+        d->strutConnections.insert(surface, connect(surface, &QObject::destroyed, this, [this, surface]() {
+            removeStrut(surface);
+        }));
+    }
+    d->struts[surface] = strut;
+    d->scheduleArrange();
+}
+
+void LayerShellV1Arrangement::removeStrut(SurfaceInterface *surface)
+{
+    disconnect(d->strutConnections.take(surface));
+    if (d->struts.remove(surface)) {
+        d->scheduleArrange();
+    }
+}
+
+QRect LayerShellV1Arrangement::geometry(LayerSurfaceV1Interface *surface) const
+{
+    if (const LayerShellV1ArrangementPrivate::Entry *entry = d->findEntry(surface)) {
+        return entry->geometry;
+    }
+    return QRect();
+}
+
+QRect LayerShellV1Arrangement::workArea() const
+{
+    return d->workArea;
+}
+
+void LayerShellV1Arrangement::arrange()
+{
+    d->arrange();
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+#include <QRect>
+
+namespace KWaylandServer
+{
+class LayerShellV1ArrangementPrivate;
+class LayerSurfaceV1Interface;
+class OutputInterface;
+class StrutInterface;
+class SurfaceInterface;
+struct deepinKwinStrut;
+
+/**
+ * The LayerShellV1Arrangement class places the layer surfaces of one output and computes
+ * the work area that is left for regular windows.
+ *
+ * The compositor creates one arrangement per OutputInterface and adds the layer surfaces
+ * it puts on that output. The arrangement follows the double-buffered state of the layer
+ * surfaces, it only re-arranges when a property that affects the placement changes. All
+ * changes up to the next event loop pass are handled by a single arrangement pass, which
+ * sends a configure event only to the layer surfaces whose size changed.
+ *
+ * Surfaces with a positive exclusive zone are placed first, from the overlay down to the
+ * background layer, each one shrinking the work area at its exclusive edge. Afterwards the
+ * other surfaces are placed, inside the work area if their exclusive zone is 0 and inside
+ * the whole output if it is -1.
+ *
+ * Struts set through the StrutInterface reduce the work area before any layer surface gets
+ * placed. Their distances are measured from the edges of the output, the start and end
+ * coordinates are global; a strut only applies if its range overlaps the output.
+ */
+class KWAYLANDSERVER_EXPORT LayerShellV1Arrangement : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LayerShellV1Arrangement(OutputInterface *output, QObject *parent = nullptr);
+    ~LayerShellV1Arrangement() override;
+
+    /**
+     * Returns the output this arrangement belongs to.
+     */
+    OutputInterface *output() const;
+
+    /**
+     * Sets the geometry of the output in the global compositor space. If it is not set, the
+     * geometry is derived from the position, mode, scale and transform of the output.
+     */
+    void setOutputGeometry(const QRect &geometry);
+    QRect outputGeometry() const;
+
+    /**
+     * Adds @p surface to this output. The surface is removed again when it gets destroyed.
+     */
+    void addSurface(LayerSurfaceV1Interface *surface);
+    void removeSurface(LayerSurfaceV1Interface *surface);
+    QList<LayerSurfaceV1Interface *> surfaces() const;
+
+    /**
+     * Uses the struts announced through @p strut for the work area computation.
+     */
+    void setStrutInterface(StrutInterface *strut);
+    /**
+     * Sets the strut of @p surface, e.g. a dock that is not a layer surface.
+     */
+    void setStrut(SurfaceInterface *surface, const deepinKwinStrut &strut);
+    void removeStrut(SurfaceInterface *surface);
+
+    /**
+     * Returns the geometry of @p surface as of the last arrangement pass, in the global
+     * compositor space. An invalid rectangle is returned for surfaces that have not been
+     * placed yet.
+     */
+    QRect geometry(LayerSurfaceV1Interface *surface) const;
+
+    /**
+     * Returns the part of the output that is not covered by exclusive zones and struts.
+     */
+    QRect workArea() const;
+
+    /**
+     * Runs a pending arrangement pass right away, e.g. before the compositor repaints.
+     */
+    void arrange();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted after an arrangement pass has changed the geometry of at least
+     * one layer surface.
+     */
+    void arranged();
+    void workAreaChanged(const QRect &workArea);
+
+private:
+    QScopedPointer<LayerShellV1ArrangementPrivate> d;
+};
+
+} // namespace KWaylandServer
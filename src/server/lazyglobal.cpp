@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "lazyglobal.h"
+#include "display.h"
+
+namespace KWaylandServer
+{
+LazyGlobal::LazyGlobal(Display *display, const wl_interface *interface, int version, BindCallback bind, QObject *owner)
+    : QObject(owner)
+    , m_bind(std::move(bind))
+{
+    m_global = wl_global_create(*display, interface, version, this, bindCallback);
+    // the display may be destroyed before the interface owning this global
+    m_displayDestroyedListener.listener.notify = displayDestroyedCallback;
+    m_displayDestroyedListener.global = this;
+    wl_display_add_destroy_listener(*display, &m_displayDestroyedListener.listener);
+}
+
+LazyGlobal::~LazyGlobal()
+{
+    if (m_global) {
+        wl_global_destroy(m_global);
+        wl_list_remove(&m_displayDestroyedListener.listener.link);
+    }
+}
+
+void LazyGlobal::bindCallback(wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    auto global = static_cast<LazyGlobal *>(data);
+    global->m_bind(client, id, version);
+}
+
+void LazyGlobal::displayDestroyedCallback(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data)
+    DisplayDestroyedListener *displayDestroyedListener = wl_container_of(listener, displayDestroyedListener, listener);
+    LazyGlobal *global = displayDestroyedListener->global;
+    // libwayland destroys the remaining globals along with the display
+    global->m_global = nullptr;
+    wl_list_remove(&global->m_displayDestroyedListener.listener.link);
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QObject>
+#include <QScopedPointer>
+
+#include <functional>
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+class Display;
+
+/**
+ * A global which is advertised to the clients right away, but whose implementation is only
+ * created when the first client binds it.
+ *
+ * The compositor creates most globals at startup, yet many of them, e.g. the text input or
+ * pointer constraint managers, are never bound in a session. An interface uses a LazyGlobal
+ * instead of passing the display to its generated QtWaylandServer class, which then only gets
+ * to add the resources of the clients binding the global.
+ *
+ * The LazyGlobal is a child of the interface it is created for and destroyed with it.
+ */
+class LazyGlobal : public QObject
+{
+public:
+    using BindCallback = std::function<void(wl_client *client, uint32_t id, int version)>;
+
+    /**
+     * Creates the global for @p interface with @p version on @p display, @p bind is invoked for
+     * every client which binds it.
+     */
+    LazyGlobal(Display *display, const wl_interface *interface, int version, BindCallback bind, QObject *owner);
+    ~LazyGlobal() override;
+
+    /**
+     * Creates a LazyGlobal for the common case of an interface with a single private
+     * implementation: @p d is created with @p factory on the first bind and every client is
+     * added to it.
+     */
+    template<typename Private, typename Factory>
+    static LazyGlobal *create(Display *display, const wl_interface *interface, int version, QObject *owner, QScopedPointer<Private> &d, Factory factory)
+    {
+        return new LazyGlobal(
+            display,
+            interface,
+            version,
+            [&d, factory](wl_client *client, uint32_t id, int version) {
+                if (!d) {
+                    d.reset(factory());
+                }
+                d->add(client, id, version);
+            },
+            owner);
+    }
+
+private:
+    static void bindCallback(wl_client *client, void *data, uint32_t version, uint32_t id);
+    static void displayDestroyedCallback(wl_listener *listener, void *data);
+
+    wl_global *m_global = nullptr;
+    BindCallback m_bind;
+    // Kept in a standard layout struct, so wl_container_of can be used on the listener.
+    struct DisplayDestroyedListener {
+        wl_listener listener;
+        LazyGlobal *global;
+    } m_displayDestroyedListener;
+};
+
+} // namespace KWaylandServer
@@ -10,16 +10,26 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 
+#include "clientconnection_p.h"
 #include "linuxdmabufv1clientbuffer.h"
 #include "linuxdmabufv1clientbuffer_p.h"
 #include "logging.h"
+#include "output_interface.h"
 #include "surface_interface_p.h"
 
-#include <QTemporaryFile>
+#include <QPointer>
+#include <QThread>
+#include <QtConcurrentRun>
 #include <fcntl.h>
 #include <errno.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
 
+#if __has_include(<linux/dma-buf.h>)
+#include <linux/dma-buf.h>
+#include <linux/sync_file.h>
+#endif
+
 namespace KWaylandServer
 {
 static const int s_version = 4;
@@ -31,6 +41,14 @@ LinuxDmaBufV1ClientBufferIntegrationPrivate::LinuxDmaBufV1ClientBufferIntegratio
 {
 }
 
+LinuxDmaBufV1ClientBufferIntegrationPrivate::~LinuxDmaBufV1ClientBufferIntegrationPrivate()
+{
+    defaultFeedback.reset();
+    for (LinuxDmaBufV1FeedbackPrivate *feedback : qAsConst(surfaceFeedbacks)) {
+        feedback->m_bufferintegration = nullptr;
+    }
+}
+
 void LinuxDmaBufV1ClientBufferIntegrationPrivate::zwp_linux_dmabuf_v1_bind_resource(Resource *resource)
 {
     if (resource->version() < ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
@@ -68,11 +86,57 @@ void LinuxDmaBufV1ClientBufferIntegrationPrivate::zwp_linux_dmabuf_v1_get_surfac
     }
     auto surfacePrivate = SurfaceInterfacePrivate::get(surface);
     if (!surfacePrivate->dmabufFeedbackV1) {
+        // the feedback only references the default tranches, it has no tranches of its own
+        // until e.g. the scanout feedback picks the surface
         surfacePrivate->dmabufFeedbackV1.reset(new LinuxDmaBufV1Feedback(this));
+        LinuxDmaBufV1FeedbackPrivate *feedback = LinuxDmaBufV1FeedbackPrivate::get(surfacePrivate->dmabufFeedbackV1.data());
+        feedback->m_surface = surface;
+        updateDeviceOutput(feedback);
+        surfaceFeedbacks.insert(feedback);
     }
     LinuxDmaBufV1FeedbackPrivate::get(surfacePrivate->dmabufFeedbackV1.data())->add(resource->client(), id, resource->version());
 }
 
+bool LinuxDmaBufV1ClientBufferIntegrationPrivate::isAdvertised(const OutputDevice &outputDevice) const
+{
+    using ImportCost = LinuxDmaBufV1ClientBufferIntegration::ImportCost;
+    const dev_t device = outputDevice.tranche.device;
+    return device != mainDevice && importCosts.value(device, ImportCost::Direct) == ImportCost::Direct;
+}
+
+LinuxDmaBufV1TrancheSetPtr LinuxDmaBufV1ClientBufferIntegrationPrivate::outputDeviceSet(OutputInterface *output)
+{
+    auto it = outputDevices.find(output);
+    if (it == outputDevices.end() || !isAdvertised(*it)) {
+        return LinuxDmaBufV1TrancheSetPtr();
+    }
+    if (!it->set || it->set->tableSerial != tableSerial) {
+        it->set.reset(new LinuxDmaBufV1TrancheSet({it->tranche}, this));
+    }
+    return it->set;
+}
+
+bool LinuxDmaBufV1ClientBufferIntegrationPrivate::updateDeviceOutput(LinuxDmaBufV1FeedbackPrivate *feedback)
+{
+    OutputInterface *deviceOutput = nullptr;
+    if (feedback->m_surface && !outputDevices.isEmpty()) {
+        const QVector<OutputInterface *> outputs = feedback->m_surface->outputs();
+        for (OutputInterface *output : outputs) {
+            auto it = outputDevices.constFind(output);
+            if (it != outputDevices.constEnd() && isAdvertised(*it)) {
+                deviceOutput = output;
+                break;
+            }
+        }
+    }
+    if (feedback->m_deviceOutput == deviceOutput) {
+        return false;
+    }
+    feedback->m_deviceOutput = deviceOutput;
+    feedback->sendAll();
+    return true;
+}
+
 void LinuxDmaBufV1ClientBufferIntegrationPrivate::zwp_linux_dmabuf_v1_destroy(Resource *resource)
 {
     wl_resource_destroy(resource->handle);
@@ -97,6 +161,15 @@ LinuxDmaBufParamsV1::LinuxDmaBufParamsV1(LinuxDmaBufV1ClientBufferIntegration *i
 
 LinuxDmaBufParamsV1::~LinuxDmaBufParamsV1()
 {
+    if (m_importWatcher) {
+        // the client is gone or didn't wait, the buffer will never be handed out
+        QFutureWatcher<LinuxDmaBufV1ClientBuffer *> *watcher = m_importWatcher;
+        QObject::disconnect(watcher, nullptr, nullptr, nullptr);
+        QObject::connect(watcher, &QFutureWatcherBase::finished, watcher, [watcher] {
+            delete watcher->result();
+            watcher->deleteLater();
+        });
+    }
     for (const LinuxDmaBufV1Plane &plane : m_planes) {
         if (plane.fd != -1) {
             close(plane.fd);
@@ -165,6 +238,11 @@ void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_create(Resource *resource,
     m_isUsed = true;
     m_planes.resize(m_planeCount);
 
+    if (m_integration->asynchronousImport()) {
+        importAsynchronously(QSize(width, height), format, flags);
+        return;
+    }
+
     LinuxDmaBufV1ClientBuffer *clientBuffer = m_integration->rendererInterface()->importBuffer(m_planes, format, QSize(width, height), flags);
     if (!clientBuffer) {
         send_failed(resource->handle);
@@ -173,18 +251,69 @@ void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_create(Resource *resource,
 
     m_planes.clear(); // the ownership of file descriptors has been moved to the buffer
 
-    wl_resource *bufferResource = wl_resource_create(resource->client(), &wl_buffer_interface, 1, 0);
+    if (wl_resource *bufferResource = createBufferResource(resource, clientBuffer, 0)) {
+        send_created(resource->handle, bufferResource);
+    }
+}
+
+void LinuxDmaBufParamsV1::importAsynchronously(const QSize &size, uint32_t format, uint32_t flags)
+{
+    LinuxDmaBufV1ClientBufferIntegration::RendererInterface *rendererInterface = m_integration->rendererInterface();
+    QThread *thread = m_integration->thread();
+    // the task owns the file descriptors from now on
+    const QVector<LinuxDmaBufV1Plane> planes = std::exchange(m_planes, {});
+
+    m_importWatcher = new QFutureWatcher<LinuxDmaBufV1ClientBuffer *>();
+    QObject::connect(m_importWatcher, &QFutureWatcherBase::finished, m_integration, [this] {
+        finishImport();
+    });
+    m_importWatcher->setFuture(QtConcurrent::run([rendererInterface, thread, planes, size, format, flags] {
+        LinuxDmaBufV1ClientBuffer *clientBuffer = rendererInterface->importBuffer(planes, format, size, flags);
+        if (clientBuffer) {
+            clientBuffer->moveToThread(thread);
+        } else {
+            for (const LinuxDmaBufV1Plane &plane : planes) {
+                close(plane.fd);
+            }
+        }
+        return clientBuffer;
+    }));
+}
+
+void LinuxDmaBufParamsV1::finishImport()
+{
+    LinuxDmaBufV1ClientBuffer *clientBuffer = m_importWatcher->result();
+    m_importWatcher->deleteLater();
+    m_importWatcher = nullptr;
+
+    if (!clientBuffer) {
+        send_failed(resource()->handle);
+        return;
+    }
+    if (wl_resource *bufferResource = createBufferResource(resource(), clientBuffer, 0)) {
+        send_created(resource()->handle, bufferResource);
+    }
+}
+
+wl_resource *LinuxDmaBufParamsV1::createBufferResource(Resource *resource, LinuxDmaBufV1ClientBuffer *clientBuffer, uint32_t id)
+{
+    wl_resource *bufferResource = wl_resource_create(resource->client(), &wl_buffer_interface, 1, id);
     if (!bufferResource) {
         delete clientBuffer;
         wl_resource_post_no_memory(resource->handle);
-        return;
+        return nullptr;
     }
 
     clientBuffer->initialize(bufferResource);
-    send_created(resource->handle, bufferResource);
 
     DisplayPrivate *displayPrivate = DisplayPrivate::get(m_integration->display());
-    displayPrivate->registerClientBuffer(clientBuffer);
+    displayPrivate->registerClientBuffer(clientBuffer, m_integration);
+    if (displayPrivate->resourceAccountingEnabled) {
+        if (ClientConnection *connection = ClientConnectionPrivate::get(resource->client())) {
+            ClientConnectionPrivate::get(connection)->accountDmaBuf(bufferResource);
+        }
+    }
+    return bufferResource;
 }
 
 void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_create_immed(Resource *resource,
@@ -214,17 +343,7 @@ void LinuxDmaBufParamsV1::zwp_linux_buffer_params_v1_create_immed(Resource *reso
 
     m_planes.clear(); // the ownership of file descriptors has been moved to the buffer
 
-    wl_resource *bufferResource = wl_resource_create(resource->client(), &wl_buffer_interface, 1, buffer_id);
-    if (!bufferResource) {
-        delete clientBuffer;
-        wl_resource_post_no_memory(resource->handle);
-        return;
-    }
-
-    clientBuffer->initialize(bufferResource);
-
-    DisplayPrivate *displayPrivate = DisplayPrivate::get(m_integration->display());
-    displayPrivate->registerClientBuffer(clientBuffer);
+    createBufferResource(resource, clientBuffer, buffer_id);
 }
 
 bool LinuxDmaBufParamsV1::test(Resource *resource, uint32_t width, uint32_t height)
@@ -309,17 +428,87 @@ void LinuxDmaBufV1ClientBufferIntegration::setRendererInterface(RendererInterfac
     d->rendererInterface = rendererInterface;
 }
 
+bool LinuxDmaBufV1ClientBufferIntegration::asynchronousImport() const
+{
+    return d->asynchronousImport;
+}
+
+void LinuxDmaBufV1ClientBufferIntegration::setAsynchronousImport(bool enabled)
+{
+    d->asynchronousImport = enabled;
+}
+
 void LinuxDmaBufV1ClientBufferIntegration::setSupportedFormatsWithModifiers(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches)
 {
-    if (LinuxDmaBufV1FeedbackPrivate::get(d->defaultFeedback.data())->m_tranches != tranches) {
+    if (LinuxDmaBufV1FeedbackPrivate::get(d->defaultFeedback.data())->tranches() != tranches) {
         QHash<uint32_t, QSet<uint64_t>> set;
         for (const auto &tranche : tranches) {
             set.insert(tranche.formatTable);
         }
-        d->supportedModifiers = set;
         d->mainDevice = tranches.first().device;
-        d->table.reset(new LinuxDmaBufV1FormatTable(set));
+        // tranches which only got reordered or split differently keep the table
+        if (!d->table || d->supportedModifiers != set) {
+            d->supportedModifiers = set;
+            d->table.reset(new LinuxDmaBufV1FormatTable(set));
+            ++d->tableSerial;
+        }
         d->defaultFeedback->setTranches(tranches);
+        // the default tranches are the fallback of every surface feedback, and the main device
+        // may have become or stopped being the device of an output
+        for (LinuxDmaBufV1FeedbackPrivate *feedback : qAsConst(d->surfaceFeedbacks)) {
+            if (!d->updateDeviceOutput(feedback)) {
+                feedback->sendAll();
+            }
+        }
+    }
+}
+
+void LinuxDmaBufV1ClientBufferIntegration::setOutputDevice(OutputInterface *output, dev_t device, const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    // the device is kept even if it isn't advertised, its import cost or the main device may change
+    auto it = d->outputDevices.find(output);
+    if (formats.isEmpty()) {
+        if (it == d->outputDevices.end()) {
+            return;
+        }
+        disconnect(it->destroyConnection);
+        d->outputDevices.erase(it);
+    } else if (it == d->outputDevices.end()) {
+        LinuxDmaBufV1ClientBufferIntegrationPrivate::OutputDevice outputDevice;
+        outputDevice.tranche = {device, {}, formats};
+        outputDevice.destroyConnection = connect(output, &QObject::destroyed, this, [this, output] {
+            setOutputDevice(output, 0, {});
+        });
+        d->outputDevices.insert(output, outputDevice);
+    } else if (it->tranche.device != device || it->tranche.formatTable != formats) {
+        it->tranche = {device, {}, formats};
+        it->set.reset();
+    } else {
+        return;
+    }
+
+    for (LinuxDmaBufV1FeedbackPrivate *feedback : qAsConst(d->surfaceFeedbacks)) {
+        const OutputInterface *previous = feedback->m_deviceOutput;
+        d->updateDeviceOutput(feedback);
+        // the surface stays with the output, but the tranche of the output changed
+        if (previous == output && feedback->m_deviceOutput == output) {
+            feedback->sendAll();
+        }
+    }
+}
+
+void LinuxDmaBufV1ClientBufferIntegration::setImportCost(dev_t device, ImportCost cost)
+{
+    if (d->importCosts.value(device, ImportCost::Direct) == cost) {
+        return;
+    }
+    if (cost == ImportCost::Direct) {
+        d->importCosts.remove(device);
+    } else {
+        d->importCosts.insert(device, cost);
+    }
+    for (LinuxDmaBufV1FeedbackPrivate *feedback : qAsConst(d->surfaceFeedbacks)) {
+        d->updateDeviceOutput(feedback);
     }
 }
 
@@ -412,6 +601,50 @@ QVector<LinuxDmaBufV1Plane> LinuxDmaBufV1ClientBuffer::planes() const
     return d->planes;
 }
 
+int LinuxDmaBufV1ClientBuffer::exportSyncFile() const
+{
+#if defined(DMA_BUF_IOCTL_EXPORT_SYNC_FILE)
+    Q_D(const LinuxDmaBufV1ClientBuffer);
+    int syncFile = -1;
+    QVector<int> exported;
+    for (const LinuxDmaBufV1Plane &plane : d->planes) {
+        // planes commonly share the dmabuf
+        if (plane.fd == -1 || exported.contains(plane.fd)) {
+            continue;
+        }
+        exported.append(plane.fd);
+
+        dma_buf_export_sync_file request = {};
+        request.flags = DMA_BUF_SYNC_READ;
+        request.fd = -1;
+        if (ioctl(plane.fd, DMA_BUF_IOCTL_EXPORT_SYNC_FILE, &request) != 0) {
+            if (syncFile != -1) {
+                close(syncFile);
+            }
+            return -1;
+        }
+        if (syncFile == -1) {
+            syncFile = request.fd;
+            continue;
+        }
+
+        sync_merge_data merge = {};
+        qstrncpy(merge.name, "dmabuf", sizeof(merge.name));
+        merge.fd2 = request.fd;
+        const int result = ioctl(syncFile, SYNC_IOC_MERGE, &merge);
+        close(request.fd);
+        close(syncFile);
+        if (result != 0) {
+            return -1;
+        }
+        syncFile = merge.fence;
+    }
+    return syncFile;
+#else
+    return -1;
+#endif
+}
+
 QSize LinuxDmaBufV1ClientBuffer::size() const
 {
     Q_D(const LinuxDmaBufV1ClientBuffer);
@@ -443,12 +676,8 @@ LinuxDmaBufV1Feedback::~LinuxDmaBufV1Feedback() = default;
 
 void LinuxDmaBufV1Feedback::setTranches(const QVector<Tranche> &tranches)
 {
-    if (d->m_tranches != tranches) {
-        d->m_tranches = tranches;
-        const auto &map = d->resourceMap();
-        for (const auto &resource : map) {
-            d->send(resource);
-        }
+    if (d->tranches() != tranches) {
+        d->setTrancheSet(tranches.isEmpty() ? LinuxDmaBufV1TrancheSetPtr() : LinuxDmaBufV1TrancheSetPtr(new LinuxDmaBufV1TrancheSet(tranches, d->m_bufferintegration)));
     }
 }
 
@@ -462,6 +691,13 @@ LinuxDmaBufV1FeedbackPrivate::LinuxDmaBufV1FeedbackPrivate(LinuxDmaBufV1ClientBu
 {
 }
 
+LinuxDmaBufV1FeedbackPrivate::~LinuxDmaBufV1FeedbackPrivate()
+{
+    if (m_bufferintegration) {
+        m_bufferintegration->surfaceFeedbacks.remove(this);
+    }
+}
+
 bool operator==(const LinuxDmaBufV1Feedback::Tranche &t1, const LinuxDmaBufV1Feedback::Tranche &t2)
 {
     return t1.device == t2.device && t1.flags == t2.flags && t1.formatTable == t2.formatTable;
@@ -473,35 +709,116 @@ void LinuxDmaBufV1FeedbackPrivate::send(Resource *resource)
     QByteArray bytes;
     bytes.append(reinterpret_cast<const char *>(&m_bufferintegration->mainDevice), sizeof(dev_t));
     send_main_device(resource->handle, bytes);
-    const auto &sendTranche = [this, resource](const LinuxDmaBufV1Feedback::Tranche &tranche) {
+    const auto &sendTranche = [this, resource](const LinuxDmaBufV1Feedback::Tranche &tranche, const QByteArray &indices) {
         QByteArray targetDevice;
         targetDevice.append(reinterpret_cast<const char *>(&tranche.device), sizeof(dev_t));
-        QByteArray indices;
-        for (auto it = tranche.formatTable.begin(); it != tranche.formatTable.end(); it++) {
-            const uint32_t format = it.key();
-            for (const auto &mod : qAsConst(it.value())) {
-                uint16_t index = m_bufferintegration->table->indices[std::pair<uint32_t, uint64_t>(format, mod)];
-                indices.append(reinterpret_cast<const char *>(&index), 2);
-            }
-        }
         send_tranche_target_device(resource->handle, targetDevice);
         send_tranche_formats(resource->handle, indices);
         send_tranche_flags(resource->handle, static_cast<uint32_t>(tranche.flags));
         send_tranche_done(resource->handle);
     };
-    for (const auto &tranche : qAsConst(m_tranches)) {
-        sendTranche(tranche);
+    const LinuxDmaBufV1TrancheSetPtr set = trancheSet();
+    if (set) {
+        for (int i = 0; i < set->tranches.count(); ++i) {
+            sendTranche(set->tranches.at(i), set->indices.at(i));
+        }
+    }
+    // the device of the output the surface is on comes before the main device
+    const LinuxDmaBufV1TrancheSetPtr deviceSet = m_deviceOutput ? m_bufferintegration->outputDeviceSet(m_deviceOutput) : LinuxDmaBufV1TrancheSetPtr();
+    if (deviceSet) {
+        for (int i = 0; i < deviceSet->tranches.count(); ++i) {
+            if (set && set->contains(deviceSet->tranches.at(i), deviceSet->indices.at(i))) {
+                continue;
+            }
+            sendTranche(deviceSet->tranches.at(i), deviceSet->indices.at(i));
+        }
     }
     // send default hints as the last fallback tranche
     const auto defaultFeedbackPrivate = get(m_bufferintegration->defaultFeedback.data());
     if (this != defaultFeedbackPrivate) {
-        for (const auto &tranche : qAsConst(defaultFeedbackPrivate->m_tranches)) {
-            sendTranche(tranche);
+        if (const LinuxDmaBufV1TrancheSetPtr defaultSet = defaultFeedbackPrivate->trancheSet()) {
+            for (int i = 0; i < defaultSet->tranches.count(); ++i) {
+                // a tranche which was already sent would only be repeated with a lower priority
+                if (set && set->contains(defaultSet->tranches.at(i), defaultSet->indices.at(i))) {
+                    continue;
+                }
+                if (deviceSet && deviceSet->contains(defaultSet->tranches.at(i), defaultSet->indices.at(i))) {
+                    continue;
+                }
+                sendTranche(defaultSet->tranches.at(i), defaultSet->indices.at(i));
+            }
         }
     }
     send_done(resource->handle);
 }
 
+void LinuxDmaBufV1FeedbackPrivate::sendAll()
+{
+    const auto &map = resourceMap();
+    for (const auto &resource : map) {
+        send(resource);
+    }
+}
+
+QVector<LinuxDmaBufV1Feedback::Tranche> LinuxDmaBufV1FeedbackPrivate::tranches() const
+{
+    return m_trancheSet ? m_trancheSet->tranches : QVector<LinuxDmaBufV1Feedback::Tranche>();
+}
+
+LinuxDmaBufV1TrancheSetPtr LinuxDmaBufV1FeedbackPrivate::trancheSet()
+{
+    if (m_trancheSet && m_trancheSet->tableSerial != m_bufferintegration->tableSerial) {
+        // the format table got replaced, the indices have to be looked up again
+        m_trancheSet.reset(new LinuxDmaBufV1TrancheSet(m_trancheSet->tranches, m_bufferintegration));
+    }
+    return m_trancheSet;
+}
+
+void LinuxDmaBufV1FeedbackPrivate::setTrancheSet(const LinuxDmaBufV1TrancheSetPtr &set)
+{
+    if (m_trancheSet != set) {
+        m_trancheSet = set;
+        sendAll();
+    }
+}
+
+LinuxDmaBufV1TrancheSet::LinuxDmaBufV1TrancheSet(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches,
+                                                 LinuxDmaBufV1ClientBufferIntegrationPrivate *integration)
+    : tranches(tranches)
+    , tableSerial(integration->tableSerial)
+{
+    indices.reserve(tranches.count());
+    for (const auto &tranche : tranches) {
+        QByteArray trancheIndices;
+        // without a table there is nothing to reference yet, the serial makes the set get
+        // encoded again once the table is created
+        if (integration->table) {
+            const auto &tableIndices = integration->table->indices;
+            for (auto it = tranche.formatTable.begin(); it != tranche.formatTable.end(); it++) {
+                const uint32_t format = it.key();
+                for (const auto &mod : qAsConst(it.value())) {
+                    // formats outside of the table can't be referenced, e.g. scanout only formats
+                    const auto index = tableIndices.constFind(std::pair<uint32_t, uint64_t>(format, mod));
+                    if (index != tableIndices.constEnd()) {
+                        trancheIndices.append(reinterpret_cast<const char *>(&*index), 2);
+                    }
+                }
+            }
+        }
+        indices.append(trancheIndices);
+    }
+}
+
+bool LinuxDmaBufV1TrancheSet::contains(const LinuxDmaBufV1Feedback::Tranche &tranche, const QByteArray &trancheIndices) const
+{
+    for (int i = 0; i < tranches.count(); ++i) {
+        if (tranches.at(i).device == tranche.device && tranches.at(i).flags == tranche.flags && indices.at(i) == trancheIndices) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void LinuxDmaBufV1FeedbackPrivate::zwp_linux_dmabuf_feedback_v1_bind_resource(Resource *resource)
 {
     send(resource);
@@ -512,6 +829,139 @@ void LinuxDmaBufV1FeedbackPrivate::zwp_linux_dmabuf_feedback_v1_destroy(Resource
     wl_resource_destroy(resource->handle);
 }
 
+class LinuxDmaBufV1ScanoutFeedbackPrivate
+{
+public:
+    void apply();
+    void reset();
+
+    LinuxDmaBufV1Feedback::Tranche tranche{0, LinuxDmaBufV1Feedback::TrancheFlag::Scanout, {}};
+    // the formats the planes rejected for the scanout surface
+    QHash<uint32_t, QSet<uint64_t>> failedFormats;
+    // the scanout tranche without the failed formats, it is encoded once and shared by every
+    // surface that gets it
+    LinuxDmaBufV1TrancheSetPtr scanoutSet;
+    int hysteresis = 3;
+
+    QPointer<SurfaceInterface> candidate;
+    int candidateFrames = 0;
+    QPointer<SurfaceInterface> surface;
+    int missedFrames = 0;
+    bool applied = false;
+};
+
+void LinuxDmaBufV1ScanoutFeedbackPrivate::apply()
+{
+    LinuxDmaBufV1Feedback *feedback = surface ? surface->dmabufFeedbackV1() : nullptr;
+    if (!feedback) {
+        // the client might still ask for the feedback later on
+        return;
+    }
+    applied = true;
+    LinuxDmaBufV1FeedbackPrivate *feedbackPrivate = LinuxDmaBufV1FeedbackPrivate::get(feedback);
+    if (!scanoutSet || scanoutSet->tableSerial != feedbackPrivate->m_bufferintegration->tableSerial) {
+        LinuxDmaBufV1Feedback::Tranche scanoutTranche = tranche;
+        for (auto it = failedFormats.constBegin(); it != failedFormats.constEnd(); ++it) {
+            auto formatIt = scanoutTranche.formatTable.find(it.key());
+            if (formatIt == scanoutTranche.formatTable.end()) {
+                continue;
+            }
+            formatIt->subtract(it.value());
+            if (formatIt->isEmpty()) {
+                scanoutTranche.formatTable.erase(formatIt);
+            }
+        }
+        QVector<LinuxDmaBufV1Feedback::Tranche> tranches;
+        if (!scanoutTranche.formatTable.isEmpty()) {
+            tranches.append(scanoutTranche);
+        }
+        scanoutSet.reset(new LinuxDmaBufV1TrancheSet(tranches, feedbackPrivate->m_bufferintegration));
+    }
+    feedbackPrivate->setTrancheSet(scanoutSet);
+}
+
+void LinuxDmaBufV1ScanoutFeedbackPrivate::reset()
+{
+    if (surface && surface->dmabufFeedbackV1()) {
+        surface->dmabufFeedbackV1()->setTranches({});
+    }
+    surface.clear();
+    failedFormats.clear();
+    scanoutSet.reset();
+    applied = false;
+}
+
+LinuxDmaBufV1ScanoutFeedback::LinuxDmaBufV1ScanoutFeedback(QObject *parent)
+    : QObject(parent)
+    , d(new LinuxDmaBufV1ScanoutFeedbackPrivate)
+{
+}
+
+LinuxDmaBufV1ScanoutFeedback::~LinuxDmaBufV1ScanoutFeedback()
+{
+    d->reset();
+}
+
+void LinuxDmaBufV1ScanoutFeedback::setScanoutFormats(dev_t device, const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    d->tranche.device = device;
+    d->tranche.formatTable = formats;
+    d->scanoutSet.reset();
+    d->apply();
+}
+
+void LinuxDmaBufV1ScanoutFeedback::setHysteresis(int frames)
+{
+    d->hysteresis = std::max(frames, 1);
+}
+
+int LinuxDmaBufV1ScanoutFeedback::hysteresis() const
+{
+    return d->hysteresis;
+}
+
+void LinuxDmaBufV1ScanoutFeedback::setScanoutCandidate(SurfaceInterface *surface)
+{
+    if (surface && surface == d->surface) {
+        d->missedFrames = 0;
+        if (!d->applied) {
+            d->apply();
+        }
+        return;
+    }
+    if (d->surface && ++d->missedFrames >= d->hysteresis) {
+        d->reset();
+    }
+    if (surface != d->candidate) {
+        d->candidate = surface;
+        d->candidateFrames = 0;
+    }
+    if (surface && !d->surface && ++d->candidateFrames >= d->hysteresis) {
+        d->surface = surface;
+        d->missedFrames = 0;
+        d->apply();
+    }
+}
+
+void LinuxDmaBufV1ScanoutFeedback::scanoutFailed(SurfaceInterface *surface, uint32_t format, uint64_t modifier)
+{
+    if (!surface || surface != d->surface) {
+        return;
+    }
+    QSet<uint64_t> &modifiers = d->failedFormats[format];
+    if (modifiers.contains(modifier)) {
+        return;
+    }
+    modifiers.insert(modifier);
+    d->scanoutSet.reset();
+    d->apply();
+}
+
+SurfaceInterface *LinuxDmaBufV1ScanoutFeedback::scanoutSurface() const
+{
+    return d->surface;
+}
+
 struct linux_dmabuf_feedback_v1_table_entry {
     uint32_t format;
     uint32_t pad; // unused
@@ -529,34 +979,14 @@ LinuxDmaBufV1FormatTable::LinuxDmaBufV1FormatTable(const QHash<uint32_t, QSet<ui
         }
     }
     size = data.size() * sizeof(linux_dmabuf_feedback_v1_table_entry);
-    QScopedPointer<QTemporaryFile> tmp(new QTemporaryFile());
-    if (!tmp->open()) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to create keymap file:" << tmp->errorString();
-        return;
-    }
-    fd = open(tmp->fileName().toUtf8().constData(), O_RDONLY | O_CLOEXEC);
-    if (fd < 0) {
-        qCWarning(KWAYLAND_SERVER) << "Could not create readonly shm fd!" << strerror(errno);
-        return;
-    }
-    unlink(tmp->fileName().toUtf8().constData());
-    if (!tmp->resize(size)) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to resize keymap file:" << tmp->errorString();
+    m_file.reset(new SealedFile(QByteArray(reinterpret_cast<const char *>(data.constData()), size), "wayland-dmabuf-feedback-format-table"));
+    if (!m_file->isValid()) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create the dmabuf format table file";
         return;
     }
-    uchar *address = tmp->map(0, size);
-    if (!address) {
-        qCWarning(KWAYLAND_SERVER) << "Failed to map keymap file:" << tmp->errorString();
-        return;
-    }
-    memcpy(address, data.data(), size);
+    fd = m_file->fd();
 }
 
-LinuxDmaBufV1FormatTable::~LinuxDmaBufV1FormatTable()
-{
-    if (fd != -1) {
-        close(fd);
-    }
-}
+LinuxDmaBufV1FormatTable::~LinuxDmaBufV1FormatTable() = default;
 
 } // namespace KWaylandServer
@@ -20,6 +20,9 @@ namespace KWaylandServer
 class LinuxDmaBufV1ClientBufferPrivate;
 class LinuxDmaBufV1ClientBufferIntegrationPrivate;
 class LinuxDmaBufV1FeedbackPrivate;
+class LinuxDmaBufV1ScanoutFeedbackPrivate;
+class OutputInterface;
+class SurfaceInterface;
 
 /**
  * The LinuxDmaBufV1Plane type represents a plane in a client buffer.
@@ -50,6 +53,15 @@ public:
     quint32 flags() const;
     QVector<LinuxDmaBufV1Plane> planes() const;
 
+    /**
+     * Returns a sync file that signals once the pending GPU writes into the buffer completed,
+     * exported from the implicit fences of the planes. The caller takes ownership of the
+     * file descriptor.
+     *
+     * Returns @c -1 if the kernel can't export the fences.
+     */
+    int exportSyncFile() const;
+
     QSize size() const override;
     bool hasAlphaChannel() const override;
     Origin origin() const override;
@@ -89,6 +101,61 @@ private:
     QScopedPointer<LinuxDmaBufV1FeedbackPrivate> d;
 };
 
+/**
+ * The LinuxDmaBufV1ScanoutFeedback class decides which surface on an output gets dmabuf
+ * feedback with a scanout tranche.
+ *
+ * The compositor creates one for every output, sets the formats the planes of the output can
+ * scan out and reports once per frame the surface that could be put on a plane, e.g. a
+ * fullscreen video or game, or @c null if the output has to be composited. A surface has to be
+ * the candidate for hysteresis() consecutive frames before it gets the scanout tranche, and it
+ * keeps the tranche until it was not the candidate for as many frames, so short lived popups
+ * or notifications do not make the feedback flap. All other surfaces are left with the render
+ * tranches of the default feedback.
+ */
+class KWAYLANDSERVER_EXPORT LinuxDmaBufV1ScanoutFeedback : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinuxDmaBufV1ScanoutFeedback(QObject *parent = nullptr);
+    ~LinuxDmaBufV1ScanoutFeedback() override;
+
+    /**
+     * Sets the @p formats the primary and overlay planes of the output, driven by @p device,
+     * can scan out. Formats that are not part of the supported formats of the
+     * LinuxDmaBufV1ClientBufferIntegration are not sent to the clients.
+     */
+    void setScanoutFormats(dev_t device, const QHash<uint32_t, QSet<uint64_t>> &formats);
+
+    /**
+     * Sets the number of frames after which a change of the candidate changes the feedback,
+     * by default @c 3.
+     */
+    void setHysteresis(int frames);
+    int hysteresis() const;
+
+    /**
+     * Reports that @p surface could be scanned out in the current frame. Pass @c null when the
+     * output needs to be composited.
+     */
+    void setScanoutCandidate(SurfaceInterface *surface);
+
+    /**
+     * Reports that the buffer of @p surface with @p format and @p modifier could not be scanned
+     * out. The combination is removed from the scanout tranche of the surface, so the client
+     * can reallocate its buffers with a format that fits the planes.
+     */
+    void scanoutFailed(SurfaceInterface *surface, uint32_t format, uint64_t modifier);
+
+    /**
+     * @returns The surface which got the scanout tranche, or @c null.
+     */
+    SurfaceInterface *scanoutSurface() const;
+
+private:
+    QScopedPointer<LinuxDmaBufV1ScanoutFeedbackPrivate> d;
+};
+
 /**
  * The LinuxDmaBufV1ClientBufferIntegration class provides support for linux dma-buf buffers.
  */
@@ -123,6 +190,21 @@ public:
          * @return The imported buffer on success, and nullptr otherwise.
          */
         virtual LinuxDmaBufV1ClientBuffer *importBuffer(const QVector<LinuxDmaBufV1Plane> &planes, quint32 format, const QSize &size, quint32 flags) = 0;
+
+    };
+
+    /**
+     * How using a buffer allocated on a device affects the compositor.
+     */
+    enum class ImportCost {
+        /**
+         * The buffer is imported as is, e.g. because the compositor renders with the device.
+         */
+        Direct,
+        /**
+         * The buffer has to be copied to the render device for every frame.
+         */
+        Copy,
     };
 
     RendererInterface *rendererInterface() const;
@@ -134,7 +216,41 @@ public:
      */
     void setRendererInterface(RendererInterface *rendererInterface);
 
+    bool asynchronousImport() const;
+    /**
+     * Sets whether RendererInterface::importBuffer() may be called from a worker thread, e.g.
+     * because the renderer uses an EGL context of its own there. Buffers requested through
+     * zwp_linux_buffer_params_v1.create are imported asynchronously then, so a slow driver
+     * import doesn't stall the other clients. The imported buffers are moved to the thread of
+     * the LinuxDmaBufV1ClientBufferIntegration before they are handed to the client.
+     *
+     * Buffers created with create_immed are always imported synchronously.
+     *
+     * Imports are synchronous unless set otherwise.
+     */
+    void setAsynchronousImport(bool enabled);
+
     void setSupportedFormatsWithModifiers(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches);
+    /**
+     * Sets the @p device driving @p output and the @p formats it can import.
+     *
+     * With hybrid graphics the outputs can be driven by different GPUs. The surface feedback of
+     * a surface on @p output gets a tranche for @p device ahead of the default tranches, so the
+     * client allocates on the GPU of the display instead of the main device. The first output
+     * of SurfaceInterface::outputs() with a device decides. Nothing is advertised if @p device
+     * is the main device or buffers of @p device need a copy, see setImportCost().
+     *
+     * Pass empty @p formats to remove the device of @p output.
+     */
+    void setOutputDevice(OutputInterface *output, dev_t device, const QHash<uint32_t, QSet<uint64_t>> &formats);
+    /**
+     * Sets the @p cost of using buffers allocated on @p device, e.g. the secondary GPU of a
+     * hybrid graphics laptop. Only devices which are imported directly are advertised for the
+     * outputs they drive, see setOutputDevice().
+     *
+     * Devices are imported directly unless set otherwise.
+     */
+    void setImportCost(dev_t device, ImportCost cost);
 
 private:
     friend class LinuxDmaBufV1ClientBufferIntegrationPrivate;
@@ -19,25 +19,61 @@
 #include "qwayland-server-linux-dmabuf-unstable-v1.h"
 #include "qwayland-server-wayland.h"
 
+#include "sealedfile.h"
+
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QSet>
+#include <QSharedPointer>
 #include <QVector>
 
 namespace KWaylandServer
 {
 
+class LinuxDmaBufV1FeedbackPrivate;
 class LinuxDmaBufV1FormatTable;
+struct LinuxDmaBufV1TrancheSet;
+
+using LinuxDmaBufV1TrancheSetPtr = QSharedPointer<const LinuxDmaBufV1TrancheSet>;
 
 class LinuxDmaBufV1ClientBufferIntegrationPrivate : public QtWaylandServer::zwp_linux_dmabuf_v1
 {
 public:
     LinuxDmaBufV1ClientBufferIntegrationPrivate(LinuxDmaBufV1ClientBufferIntegration *q, Display *display);
+    ~LinuxDmaBufV1ClientBufferIntegrationPrivate() override;
 
     LinuxDmaBufV1ClientBufferIntegration *q;
     LinuxDmaBufV1ClientBufferIntegration::RendererInterface *rendererInterface = nullptr;
     QScopedPointer<LinuxDmaBufV1Feedback> defaultFeedback;
     QScopedPointer<LinuxDmaBufV1FormatTable> table;
+    // bumped whenever the table gets replaced, the feedback objects cache indices into it
+    quint64 tableSerial = 0;
     dev_t mainDevice;
     QHash<uint32_t, QSet<uint64_t>> supportedModifiers;
+    // the feedback objects created with get_surface_feedback, they send the default tranches
+    // as the last fallback and have to be updated along with the default feedback
+    QSet<LinuxDmaBufV1FeedbackPrivate *> surfaceFeedbacks;
+
+    // the devices of the outputs, see setOutputDevice()
+    struct OutputDevice {
+        LinuxDmaBufV1Feedback::Tranche tranche;
+        // encoded on demand, shared by the feedbacks of all surfaces on the output
+        LinuxDmaBufV1TrancheSetPtr set;
+        QMetaObject::Connection destroyConnection;
+    };
+    QHash<OutputInterface *, OutputDevice> outputDevices;
+    QHash<dev_t, LinuxDmaBufV1ClientBufferIntegration::ImportCost> importCosts;
+    bool asynchronousImport = false;
+    // whether the device of an output gets a tranche, neither the main device nor devices whose
+    // buffers get copied do
+    bool isAdvertised(const OutputDevice &outputDevice) const;
+    LinuxDmaBufV1TrancheSetPtr outputDeviceSet(OutputInterface *output);
+    /**
+     * Picks the output whose device tranche the surface feedback @p feedback sends. Returns
+     * @c true if that changed and the feedback got sent again.
+     */
+    bool updateDeviceOutput(LinuxDmaBufV1FeedbackPrivate *feedback);
 
 protected:
     void zwp_linux_dmabuf_v1_bind_resource(Resource *resource) override;
@@ -82,13 +118,21 @@ protected:
 
 private:
     bool test(Resource *resource, uint32_t width, uint32_t height);
+    void importAsynchronously(const QSize &size, uint32_t format, uint32_t flags);
+    void finishImport();
+    wl_resource *createBufferResource(Resource *resource, LinuxDmaBufV1ClientBuffer *clientBuffer, uint32_t id);
 
     LinuxDmaBufV1ClientBufferIntegration *m_integration;
+    QFutureWatcher<LinuxDmaBufV1ClientBuffer *> *m_importWatcher = nullptr;
     QVector<LinuxDmaBufV1Plane> m_planes;
     int m_planeCount = 0;
     bool m_isUsed = false;
 };
 
+/**
+ * The table of all supported format and modifier pairs. There is a single table shared by the
+ * default and all surface feedback objects of every client, backed by one read-only file.
+ */
 class LinuxDmaBufV1FormatTable
 {
 public:
@@ -98,18 +142,58 @@ public:
     int fd = -1;
     int size;
     QMap<std::pair<uint32_t, uint64_t>, uint16_t> indices;
+
+private:
+    QScopedPointer<SealedFile> m_file;
+};
+
+/**
+ * An immutable list of tranches along with their indices into the format table. The sets are
+ * shared rather than copied into every feedback object, e.g. the scanout tranche of an output
+ * is encoded once and handed to each surface that gets it.
+ */
+struct LinuxDmaBufV1TrancheSet {
+    LinuxDmaBufV1TrancheSet(const QVector<LinuxDmaBufV1Feedback::Tranche> &tranches, LinuxDmaBufV1ClientBufferIntegrationPrivate *integration);
+
+    /**
+     * Returns whether a tranche with the same device, flags and @p indices is in the set.
+     */
+    bool contains(const LinuxDmaBufV1Feedback::Tranche &tranche, const QByteArray &indices) const;
+
+    QVector<LinuxDmaBufV1Feedback::Tranche> tranches;
+    // the format table indices of every tranche, the same for all resources
+    QVector<QByteArray> indices;
+    // the serial of the format table the indices refer to
+    quint64 tableSerial;
 };
 
 class LinuxDmaBufV1FeedbackPrivate : public QtWaylandServer::zwp_linux_dmabuf_feedback_v1
 {
 public:
     LinuxDmaBufV1FeedbackPrivate(LinuxDmaBufV1ClientBufferIntegrationPrivate *bufferintegration);
+    ~LinuxDmaBufV1FeedbackPrivate() override;
 
     static LinuxDmaBufV1FeedbackPrivate *get(LinuxDmaBufV1Feedback *q);
     void send(Resource *resource);
-
-    QVector<LinuxDmaBufV1Feedback::Tranche> m_tranches;
+    void sendAll();
+    QVector<LinuxDmaBufV1Feedback::Tranche> tranches() const;
+    /**
+     * Returns the tranches of the feedback, encoded for the current format table, or @c null
+     * if the feedback has none of its own.
+     */
+    LinuxDmaBufV1TrancheSetPtr trancheSet();
+    /**
+     * Replaces the tranches of the feedback with @p set and sends them to all resources.
+     * Nothing is sent if the feedback already uses @p set.
+     */
+    void setTrancheSet(const LinuxDmaBufV1TrancheSetPtr &set);
+
+    LinuxDmaBufV1TrancheSetPtr m_trancheSet;
     LinuxDmaBufV1ClientBufferIntegrationPrivate *m_bufferintegration;
+    // the surface of a surface feedback and the output whose device tranche it sends, the
+    // output is only used as a key
+    QPointer<SurfaceInterface> m_surface;
+    OutputInterface *m_deviceOutput = nullptr;
 
 protected:
     void zwp_linux_dmabuf_feedback_v1_bind_resource(Resource *resource) override;
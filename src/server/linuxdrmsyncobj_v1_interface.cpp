@@ -0,0 +1,203 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "linuxdrmsyncobj_v1_interface.h"
+#include "display.h"
+#include "linuxdmabufv1clientbuffer.h"
+#include "linuxdrmsyncobj_v1_interface_p.h"
+#include "surface_interface_p.h"
+#include "utils.h"
+
+#include <unistd.h>
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+class LinuxDrmSyncObjV1InterfacePrivate : public QtWaylandServer::wp_linux_drm_syncobj_manager_v1
+{
+public:
+    LinuxDrmSyncObjV1Interface::RendererInterface *rendererInterface = nullptr;
+
+protected:
+    void wp_linux_drm_syncobj_manager_v1_destroy(Resource *resource) override;
+    void wp_linux_drm_syncobj_manager_v1_get_surface(Resource *resource, uint32_t id, wl_resource *surface) override;
+    void wp_linux_drm_syncobj_manager_v1_import_timeline(Resource *resource, uint32_t id, int32_t fd) override;
+};
+
+void LinuxDrmSyncObjV1InterfacePrivate::wp_linux_drm_syncobj_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxDrmSyncObjV1InterfacePrivate::wp_linux_drm_syncobj_manager_v1_get_surface(Resource *resource, uint32_t id, wl_resource *surfaceResource)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surfaceResource);
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    if (surfacePrivate->syncObjSurface) {
+        wl_resource_post_error(resource->handle, error_surface_exists, "the surface already has a synchronization object");
+        return;
+    }
+
+    wl_resource *syncObjResource = wl_resource_create(resource->client(), &wp_linux_drm_syncobj_surface_v1_interface, resource->version(), id);
+    if (!syncObjResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new LinuxDrmSyncObjSurfaceV1Interface(surface, syncObjResource);
+}
+
+void LinuxDrmSyncObjV1InterfacePrivate::wp_linux_drm_syncobj_manager_v1_import_timeline(Resource *resource, uint32_t id, int32_t fd)
+{
+    LinuxDrmSyncObjTimelineV1 *timeline = nullptr;
+    if (rendererInterface) {
+        timeline = rendererInterface->importTimeline(fd);
+    } else {
+        close(fd);
+    }
+    if (!timeline) {
+        wl_resource_post_error(resource->handle, error_invalid_timeline, "the timeline could not be imported");
+        return;
+    }
+
+    wl_resource *timelineResource = wl_resource_create(resource->client(), &wp_linux_drm_syncobj_timeline_v1_interface, resource->version(), id);
+    if (!timelineResource) {
+        delete timeline;
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new LinuxDrmSyncObjTimelineV1Interface(timeline, timelineResource);
+}
+
+LinuxDrmSyncObjTimelineV1Interface::LinuxDrmSyncObjTimelineV1Interface(LinuxDrmSyncObjTimelineV1 *timeline, wl_resource *resource)
+    : QtWaylandServer::wp_linux_drm_syncobj_timeline_v1(resource)
+    , timeline(timeline)
+{
+}
+
+LinuxDrmSyncObjTimelineV1Interface *LinuxDrmSyncObjTimelineV1Interface::get(wl_resource *resource)
+{
+    return resource_cast<LinuxDrmSyncObjTimelineV1Interface *>(resource);
+}
+
+void LinuxDrmSyncObjTimelineV1Interface::wp_linux_drm_syncobj_timeline_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void LinuxDrmSyncObjTimelineV1Interface::wp_linux_drm_syncobj_timeline_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+LinuxDrmSyncObjSurfaceV1Interface::LinuxDrmSyncObjSurfaceV1Interface(SurfaceInterface *surface, wl_resource *resource)
+    : QtWaylandServer::wp_linux_drm_syncobj_surface_v1(resource)
+    , surface(surface)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->syncObjSurface = this;
+}
+
+LinuxDrmSyncObjSurfaceV1Interface::~LinuxDrmSyncObjSurfaceV1Interface()
+{
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->syncObjSurface = nullptr;
+    }
+}
+
+bool LinuxDrmSyncObjSurfaceV1Interface::validatePendingState()
+{
+    const SurfaceState &pending = SurfaceInterfacePrivate::get(surface)->pending;
+    if (!pending.isSet(SurfaceState::BufferField) || !pending.buffer) {
+        if (pending.acquirePoint.isValid() || pending.releasePoint.isValid()) {
+            wl_resource_post_error(resource()->handle, error_no_buffer, "timeline points were set without a buffer");
+            return false;
+        }
+        return true;
+    }
+    if (!pending.acquirePoint.isValid()) {
+        wl_resource_post_error(resource()->handle, error_no_acquire_point, "the buffer has no acquire point");
+        return false;
+    }
+    if (!pending.releasePoint.isValid()) {
+        wl_resource_post_error(resource()->handle, error_no_release_point, "the buffer has no release point");
+        return false;
+    }
+    if (!qobject_cast<LinuxDmaBufV1ClientBuffer *>(pending.buffer)) {
+        wl_resource_post_error(resource()->handle, error_unsupported_buffer, "only dmabufs support explicit synchronization");
+        return false;
+    }
+    if (pending.acquirePoint.timeline == pending.releasePoint.timeline && pending.acquirePoint.point >= pending.releasePoint.point) {
+        wl_resource_post_error(resource()->handle, error_conflicting_points, "the release point has to come after the acquire point");
+        return false;
+    }
+    return true;
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_destroy(Resource *resource)
+{
+    if (surface) {
+        // the points set since the last commit are discarded
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->pending.acquirePoint = LinuxDrmSyncObjPoint();
+        surfacePrivate->pending.releasePoint = LinuxDrmSyncObjPoint();
+    }
+
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_set_acquire_point(Resource *resource, wl_resource *timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    if (!surface) {
+        wl_resource_post_error(resource->handle, error_no_surface, "the wl_surface for this synchronization object no longer exists");
+        return;
+    }
+
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->pending.acquirePoint.timeline = LinuxDrmSyncObjTimelineV1Interface::get(timeline)->timeline;
+    surfacePrivate->pending.acquirePoint.point = (quint64(point_hi) << 32) | point_lo;
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_set_release_point(Resource *resource, wl_resource *timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    if (!surface) {
+        wl_resource_post_error(resource->handle, error_no_surface, "the wl_surface for this synchronization object no longer exists");
+        return;
+    }
+
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->pending.releasePoint.timeline = LinuxDrmSyncObjTimelineV1Interface::get(timeline)->timeline;
+    surfacePrivate->pending.releasePoint.point = (quint64(point_hi) << 32) | point_lo;
+}
+
+LinuxDrmSyncObjV1Interface::LinuxDrmSyncObjV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new LinuxDrmSyncObjV1InterfacePrivate)
+{
+    d->init(*display, s_version);
+}
+
+LinuxDrmSyncObjV1Interface::~LinuxDrmSyncObjV1Interface()
+{
+}
+
+LinuxDrmSyncObjV1Interface::RendererInterface *LinuxDrmSyncObjV1Interface::rendererInterface() const
+{
+    return d->rendererInterface;
+}
+
+void LinuxDrmSyncObjV1Interface::setRendererInterface(RendererInterface *rendererInterface)
+{
+    d->rendererInterface = rendererInterface;
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class LinuxDrmSyncObjV1InterfacePrivate;
+
+/**
+ * A drm syncobj timeline a client imported, implemented by the compositor on top of its drm device.
+ */
+class KWAYLANDSERVER_EXPORT LinuxDrmSyncObjTimelineV1
+{
+public:
+    virtual ~LinuxDrmSyncObjTimelineV1() = default;
+
+    /**
+     * Returns an eventfd that becomes readable once @p point has been signalled, e.g. created
+     * with drmSyncobjEventfd(). The caller takes ownership of the file descriptor.
+     *
+     * Returns @c -1 if the point can't be waited for, the buffer is used right away then.
+     */
+    virtual int createEventFd(quint64 point) = 0;
+
+    /**
+     * Signals @p point, e.g. with drmSyncobjTimelineSignal().
+     */
+    virtual void signal(quint64 point) = 0;
+};
+
+/**
+ * The LinuxDrmSyncObjV1Interface provides explicit synchronization of client buffers.
+ *
+ * A client passes an acquire point with every dmabuf it commits, the commit is only applied once
+ * the point got signalled, i.e. once the client finished rendering into the buffer. That happens
+ * without blocking the event loop, later commits of the surface wait for it too. The release
+ * point of the buffer is signalled as soon as the compositor doesn't reference the buffer anymore,
+ * so the compositor has to keep its reference until the GPU finished reading from it.
+ *
+ * The global should only be created if the compositor can import drm syncobj timelines.
+ *
+ * LinuxDrmSyncObjV1Interface corresponds to the Wayland interface @c wp_linux_drm_syncobj_manager_v1.
+ */
+class KWAYLANDSERVER_EXPORT LinuxDrmSyncObjV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The RendererInterface class provides an interface from the LinuxDrmSyncObjV1Interface
+     * into the compositor.
+     */
+    class RendererInterface
+    {
+    public:
+        virtual ~RendererInterface() = default;
+
+        /**
+         * Imports the drm syncobj timeline @p fd. The ownership of the file descriptor is
+         * transferred by this call.
+         *
+         * @return The imported timeline on success, and nullptr otherwise.
+         */
+        virtual LinuxDrmSyncObjTimelineV1 *importTimeline(int fd) = 0;
+    };
+
+    explicit LinuxDrmSyncObjV1Interface(Display *display, QObject *parent = nullptr);
+    ~LinuxDrmSyncObjV1Interface() override;
+
+    RendererInterface *rendererInterface() const;
+    /**
+     * Sets the compositor implementation importing the timelines.
+     *
+     * The ownership is not transferred by this call.
+     */
+    void setRendererInterface(RendererInterface *rendererInterface);
+
+private:
+    QScopedPointer<LinuxDrmSyncObjV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
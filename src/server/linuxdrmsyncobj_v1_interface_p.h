@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "linuxdrmsyncobj_v1_interface.h"
+
+#include "qwayland-server-linux-drm-syncobj-v1.h"
+
+#include <QPointer>
+
+#include <memory>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+
+/**
+ * A point on a timeline imported by a client.
+ */
+struct LinuxDrmSyncObjPoint {
+    bool isValid() const
+    {
+        return bool(timeline);
+    }
+
+    std::shared_ptr<LinuxDrmSyncObjTimelineV1> timeline;
+    quint64 point = 0;
+};
+
+class LinuxDrmSyncObjTimelineV1Interface : public QtWaylandServer::wp_linux_drm_syncobj_timeline_v1
+{
+public:
+    LinuxDrmSyncObjTimelineV1Interface(LinuxDrmSyncObjTimelineV1 *timeline, wl_resource *resource);
+
+    static LinuxDrmSyncObjTimelineV1Interface *get(wl_resource *resource);
+
+    // points keep the timeline alive after the client destroyed it
+    std::shared_ptr<LinuxDrmSyncObjTimelineV1> timeline;
+
+protected:
+    void wp_linux_drm_syncobj_timeline_v1_destroy_resource(Resource *resource) override;
+    void wp_linux_drm_syncobj_timeline_v1_destroy(Resource *resource) override;
+};
+
+class LinuxDrmSyncObjSurfaceV1Interface : public QtWaylandServer::wp_linux_drm_syncobj_surface_v1
+{
+public:
+    LinuxDrmSyncObjSurfaceV1Interface(SurfaceInterface *surface, wl_resource *resource);
+    ~LinuxDrmSyncObjSurfaceV1Interface() override;
+
+    /**
+     * Checks the points of the pending state of the surface, returns @c false if a protocol
+     * error has been posted.
+     */
+    bool validatePendingState();
+
+    QPointer<SurfaceInterface> surface;
+
+protected:
+    void wp_linux_drm_syncobj_surface_v1_destroy_resource(Resource *resource) override;
+    void wp_linux_drm_syncobj_surface_v1_destroy(Resource *resource) override;
+    void wp_linux_drm_syncobj_surface_v1_set_acquire_point(Resource *resource, wl_resource *timeline, uint32_t point_hi, uint32_t point_lo) override;
+    void wp_linux_drm_syncobj_surface_v1_set_release_point(Resource *resource, wl_resource *timeline, uint32_t point_hi, uint32_t point_lo) override;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,277 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "occlusiontracker.h"
+#include "subcompositor_interface.h"
+#include "surface_interface.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+class OcclusionTrackerPrivate
+{
+public:
+    struct Entry {
+        QRegion visibleRegion;
+        bool occluded = false;
+        QVector<QMetaObject::Connection> connections;
+    };
+
+    struct Result {
+        QRegion visibleRegion;
+        bool occluded = false;
+    };
+
+    OcclusionTrackerPrivate(OcclusionTracker *q);
+
+    Entry &ensureEntry(SurfaceInterface *surface);
+    void forget(SurfaceInterface *surface);
+    void scheduleUpdate();
+    void update();
+    bool collect(SurfaceInterface *surface, const QPoint &position, QRegion *covered, QHash<SurfaceInterface *, Result> *results) const;
+
+    OcclusionTracker *q;
+    QList<SurfaceInterface *> stackingOrder;
+    QHash<SurfaceInterface *, QPoint> positions;
+    // every surface of the tracked trees, the toplevels included
+    QHash<SurfaceInterface *, Entry> entries;
+    bool frameThrottling = true;
+    bool updatePending = false;
+};
+
+OcclusionTrackerPrivate::OcclusionTrackerPrivate(OcclusionTracker *q)
+    : q(q)
+{
+}
+
+OcclusionTrackerPrivate::Entry &OcclusionTrackerPrivate::ensureEntry(SurfaceInterface *surface)
+{
+    auto it = entries.find(surface);
+    if (it != entries.end()) {
+        return *it;
+    }
+
+    Entry &entry = entries[surface];
+    auto schedule = [this]() {
+        scheduleUpdate();
+    };
+    entry.connections << QObject::connect(surface, &SurfaceInterface::opaqueChanged, q, schedule);
+    entry.connections << QObject::connect(surface, &SurfaceInterface::sizeChanged, q, schedule);
+    entry.connections << QObject::connect(surface, &SurfaceInterface::mapped, q, schedule);
+    entry.connections << QObject::connect(surface, &SurfaceInterface::unmapped, q, schedule);
+    entry.connections << QObject::connect(surface, &SurfaceInterface::childSubSurfacesChanged, q, schedule);
+    entry.connections << QObject::connect(surface, &SurfaceInterface::aboutToBeDestroyed, q, [this, surface]() {
+        forget(surface);
+    });
+    if (SubSurfaceInterface *subSurface = surface->subSurface()) {
+        entry.connections << QObject::connect(subSurface, &SubSurfaceInterface::positionChanged, q, schedule);
+    }
+    return entry;
+}
+
+void OcclusionTrackerPrivate::forget(SurfaceInterface *surface)
+{
+    const Entry entry = entries.take(surface);
+    for (const QMetaObject::Connection &connection : entry.connections) {
+        QObject::disconnect(connection);
+    }
+    stackingOrder.removeAll(surface);
+    positions.remove(surface);
+    scheduleUpdate();
+}
+
+void OcclusionTrackerPrivate::scheduleUpdate()
+{
+    if (updatePending) {
+        return;
+    }
+    updatePending = true;
+    QMetaObject::invokeMethod(
+        q,
+        [this]() {
+            if (updatePending) {
+                update();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+bool OcclusionTrackerPrivate::collect(SurfaceInterface *surface, const QPoint &position, QRegion *covered, QHash<SurfaceInterface *, Result> *results) const
+{
+    // the children of an unmapped surface are not mapped either
+    if (!surface->isMapped()) {
+        results->insert(surface, Result());
+        return false;
+    }
+
+    bool visible = false;
+    // from the top-most to the bottom-most surface
+    const QList<SubSurfaceInterface *> above = surface->above();
+    for (auto it = above.crbegin(); it != above.crend(); ++it) {
+        if (SurfaceInterface *child = (*it)->surface()) {
+            visible |= collect(child, position + (*it)->position(), covered, results);
+        }
+    }
+
+    const QRect rect(QPoint(), surface->size());
+    Result result;
+    result.visibleRegion = QRegion(rect.translated(position)).subtracted(*covered);
+    *covered += surface->opaque().intersected(rect).translated(position);
+    visible |= !result.visibleRegion.isEmpty();
+
+    const QList<SubSurfaceInterface *> below = surface->below();
+    for (auto it = below.crbegin(); it != below.crend(); ++it) {
+        if (SurfaceInterface *child = (*it)->surface()) {
+            visible |= collect(child, position + (*it)->position(), covered, results);
+        }
+    }
+
+    result.occluded = !visible;
+    results->insert(surface, result);
+    return visible;
+}
+
+void OcclusionTrackerPrivate::update()
+{
+    updatePending = false;
+
+    QHash<SurfaceInterface *, Result> results;
+    QRegion covered;
+    for (auto it = stackingOrder.crbegin(); it != stackingOrder.crend(); ++it) {
+        collect(*it, positions.value(*it), &covered, &results);
+    }
+
+    bool changed = false;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (results.contains(it.key())) {
+            ++it;
+            continue;
+        }
+        // the surface left the tracked trees, e.g. a removed sub-surface
+        for (const QMetaObject::Connection &connection : qAsConst(it->connections)) {
+            QObject::disconnect(connection);
+        }
+        if (frameThrottling && it->occluded) {
+            it.key()->setOccluded(false);
+        }
+        changed |= !it->visibleRegion.isEmpty();
+        it = entries.erase(it);
+    }
+
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        Entry &entry = ensureEntry(it.key());
+        if (entry.visibleRegion != it->visibleRegion) {
+            entry.visibleRegion = it->visibleRegion;
+            changed = true;
+        }
+        if (entry.occluded != it->occluded) {
+            entry.occluded = it->occluded;
+            if (frameThrottling) {
+                it.key()->setOccluded(entry.occluded);
+            }
+        }
+    }
+
+    if (changed) {
+        Q_EMIT q->visibleRegionsChanged();
+    }
+}
+
+OcclusionTracker::OcclusionTracker(QObject *parent)
+    : QObject(parent)
+    , d(new OcclusionTrackerPrivate(this))
+{
+}
+
+OcclusionTracker::~OcclusionTracker()
+{
+    setFrameThrottling(false);
+}
+
+void OcclusionTracker::setStackingOrder(const QList<SurfaceInterface *> &surfaces)
+{
+    if (d->stackingOrder == surfaces) {
+        return;
+    }
+    for (auto it = d->positions.begin(); it != d->positions.end();) {
+        if (surfaces.contains(it.key())) {
+            ++it;
+        } else {
+            it = d->positions.erase(it);
+        }
+    }
+    // the toplevels are watched right away, they may be destroyed before the next pass
+    for (SurfaceInterface *surface : surfaces) {
+        d->ensureEntry(surface);
+    }
+    d->stackingOrder = surfaces;
+    d->scheduleUpdate();
+}
+
+QList<SurfaceInterface *> OcclusionTracker::stackingOrder() const
+{
+    return d->stackingOrder;
+}
+
+void OcclusionTracker::setPosition(SurfaceInterface *surface, const QPoint &position)
+{
+    if (!d->stackingOrder.contains(surface)) {
+        return;
+    }
+    auto it = d->positions.find(surface);
+    if (it == d->positions.end()) {
+        if (position.isNull()) {
+            return;
+        }
+        d->positions.insert(surface, position);
+    } else if (*it != position) {
+        *it = position;
+    } else {
+        return;
+    }
+    d->scheduleUpdate();
+}
+
+QPoint OcclusionTracker::position(SurfaceInterface *surface) const
+{
+    return d->positions.value(surface);
+}
+
+void OcclusionTracker::setFrameThrottling(bool enabled)
+{
+    if (d->frameThrottling == enabled) {
+        return;
+    }
+    d->frameThrottling = enabled;
+    for (auto it = d->entries.constBegin(); it != d->entries.constEnd(); ++it) {
+        if (it->occluded) {
+            it.key()->setOccluded(enabled);
+        }
+    }
+}
+
+bool OcclusionTracker::frameThrottling() const
+{
+    return d->frameThrottling;
+}
+
+QRegion OcclusionTracker::visibleRegion(SurfaceInterface *surface) const
+{
+    return d->entries.value(surface).visibleRegion;
+}
+
+bool OcclusionTracker::isOccluded(SurfaceInterface *surface) const
+{
+    return d->entries.value(surface).occluded;
+}
+
+void OcclusionTracker::update()
+{
+    d->update();
+}
+
+} // namespace KWaylandServer
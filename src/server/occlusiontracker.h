@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+#include <QPoint>
+#include <QRegion>
+
+namespace KWaylandServer
+{
+class OcclusionTrackerPrivate;
+class SurfaceInterface;
+
+/**
+ * The OcclusionTracker class computes which parts of a stack of toplevel surfaces are visible.
+ *
+ * The compositor sets the stacking order of the toplevel surfaces and their positions in the
+ * global compositor space. The tracker walks the sub-surface trees of the toplevels and keeps
+ * the visible region of every surface in the trees, i.e. the part of the surface that is not
+ * covered by the opaque region of a surface above it. It only recomputes the visible regions
+ * when the stacking order, a position, an opaque region, a size or a sub-surface tree changes.
+ * All changes up to the next event loop pass are handled by a single pass.
+ *
+ * A surface is occluded if neither it nor any of its sub-surfaces is visible. The tracker marks
+ * occluded surfaces with SurfaceInterface::setOccluded(), so they don't get frame callbacks,
+ * unless frame throttling is disabled.
+ */
+class KWAYLANDSERVER_EXPORT OcclusionTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OcclusionTracker(QObject *parent = nullptr);
+    ~OcclusionTracker() override;
+
+    /**
+     * Sets the toplevel surfaces, from the bottom-most to the top-most one. A surface is removed
+     * again when it gets destroyed.
+     */
+    void setStackingOrder(const QList<SurfaceInterface *> &surfaces);
+    QList<SurfaceInterface *> stackingOrder() const;
+
+    /**
+     * Sets the position of the toplevel @p surface in the global compositor space. The surface
+     * must be in the stacking order, its position is forgotten when it leaves the stacking order.
+     */
+    void setPosition(SurfaceInterface *surface, const QPoint &position);
+    QPoint position(SurfaceInterface *surface) const;
+
+    /**
+     * Sets whether the tracker marks occluded surfaces with SurfaceInterface::setOccluded(). It is
+     * enabled by default. Surfaces that leave the tracker are unmarked again.
+     */
+    void setFrameThrottling(bool enabled);
+    bool frameThrottling() const;
+
+    /**
+     * Returns the visible region of @p surface as of the last pass, in the global compositor
+     * space. An empty region is returned for surfaces that are not in any tracked sub-surface
+     * tree, not mapped or completely covered.
+     */
+    QRegion visibleRegion(SurfaceInterface *surface) const;
+    /**
+     * Returns @c true if neither @p surface nor any of its sub-surfaces is visible, as of the
+     * last pass. Surfaces that are not tracked or not mapped are not occluded.
+     */
+    bool isOccluded(SurfaceInterface *surface) const;
+
+    /**
+     * Runs a pending pass right away, e.g. before the compositor repaints.
+     */
+    void update();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted after a pass has changed the visible region of at least one surface.
+     */
+    void visibleRegionsChanged();
+
+private:
+    QScopedPointer<OcclusionTrackerPrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -5,52 +5,22 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "output_interface.h"
+#include "clientconnection.h"
 #include "display.h"
 #include "display_p.h"
+#include "output_interface_p.h"
+#include "outputframeclock.h"
+#include "surface_interface_p.h"
 #include "utils.h"
 
-#include "qwayland-server-wayland.h"
-
-#include <QPointer>
 #include <QVector>
 
+#include <algorithm>
+
 namespace KWaylandServer
 {
 static const int s_version = 3;
 
-class OutputInterfacePrivate : public QtWaylandServer::wl_output
-{
-public:
-    explicit OutputInterfacePrivate(Display *display, OutputInterface *q);
-
-    void sendScale(Resource *resource);
-    void sendGeometry(Resource *resource);
-    void sendMode(Resource *resource);
-    void sendDone(Resource *resource);
-
-    void broadcastGeometry();
-
-    OutputInterface *q;
-    QPointer<Display> display;
-    QSize physicalSize;
-    QPoint globalPosition;
-    QString manufacturer = QStringLiteral("org.kde.kwin");
-    QString model = QStringLiteral("none");
-    int scale = 1;
-    OutputInterface::SubPixel subPixel = OutputInterface::SubPixel::Unknown;
-    OutputInterface::Transform transform = OutputInterface::Transform::Normal;
-    OutputInterface::Mode mode;
-    struct {
-        OutputInterface::DpmsMode mode = OutputInterface::DpmsMode::Off;
-        bool supported = false;
-    } dpms;
-
-private:
-    void output_destroy_global() override;
-    void output_bind_resource(Resource *resource) override;
-    void output_release(Resource *resource) override;
-};
-
 OutputInterfacePrivate::OutputInterfacePrivate(Display *display, OutputInterface *q)
     : QtWaylandServer::wl_output(*display, s_version)
     , q(q)
@@ -58,6 +28,11 @@ OutputInterfacePrivate::OutputInterfacePrivate(Display *display, OutputInterface
 {
 }
 
+OutputInterfacePrivate *OutputInterfacePrivate::get(OutputInterface *output)
+{
+    return output->d.data();
+}
+
 void OutputInterfacePrivate::sendMode(Resource *resource)
 {
     send_mode(resource->handle, mode_current, mode.size.width(), mode.size.height(), mode.refreshRate);
@@ -116,15 +91,15 @@ static quint32 kwaylandServerSubPixelToWaylandSubPixel(OutputInterface::SubPixel
 
 void OutputInterfacePrivate::sendGeometry(Resource *resource)
 {
-    send_geometry(resource->handle,
-                  globalPosition.x(),
-                  globalPosition.y(),
-                  physicalSize.width(),
-                  physicalSize.height(),
-                  kwaylandServerSubPixelToWaylandSubPixel(subPixel),
-                  manufacturer,
-                  model,
-                  kwaylandServerTransformToWaylandTransform(transform));
+    wl_output_send_geometry(resource->handle,
+                            globalPosition.x(),
+                            globalPosition.y(),
+                            physicalSize.width(),
+                            physicalSize.height(),
+                            kwaylandServerSubPixelToWaylandSubPixel(subPixel),
+                            encodedManufacturer.constData(),
+                            encodedModel.constData(),
+                            kwaylandServerTransformToWaylandTransform(transform));
 }
 
 void OutputInterfacePrivate::sendDone(Resource *resource)
@@ -152,8 +127,14 @@ void OutputInterfacePrivate::output_release(Resource *resource)
     wl_resource_destroy(resource->handle);
 }
 
+void OutputInterfacePrivate::output_destroy_resource(Resource *resource)
+{
+    clientResources.remove(resource);
+}
+
 void OutputInterfacePrivate::output_bind_resource(Resource *resource)
 {
+    clientResources.add(resource);
     if (isGlobalRemoved()) {
         return; // We are waiting for the wl_output global to be destroyed.
     }
@@ -163,6 +144,13 @@ void OutputInterfacePrivate::output_bind_resource(Resource *resource)
     sendGeometry(resource);
     sendDone(resource);
 
+    // the surfaces of the client on this output enter the new wl_output as well
+    for (SurfaceInterface *surface : qAsConst(surfaces)) {
+        if (surface->client()->client() == resource->client()) {
+            SurfaceInterfacePrivate::get(surface)->send_enter(resource->handle);
+        }
+    }
+
     Q_EMIT q->bound(display->getConnection(resource->client()), resource->handle);
 }
 
@@ -172,6 +160,11 @@ OutputInterface::OutputInterface(Display *display, QObject *parent)
 {
     DisplayPrivate *displayPrivate = DisplayPrivate::get(display);
     displayPrivate->outputs.append(this);
+    if (~displayPrivate->outputSurfaceBits) {
+        d->surfaceBit = qCountTrailingZeroBits(~displayPrivate->outputSurfaceBits);
+        displayPrivate->outputSurfaceBits |= quint64(1) << d->surfaceBit;
+    }
+    d->frameClock.reset(new OutputFrameClock(this));
 }
 
 OutputInterface::~OutputInterface()
@@ -185,9 +178,22 @@ void OutputInterface::remove()
         return;
     }
 
+    // setOutputs() updates the surfaces, so iterate over a copy
+    const QSet<SurfaceInterface *> surfaces = d->surfaces;
+    for (SurfaceInterface *surface : surfaces) {
+        QVector<OutputInterface *> outputs = surface->outputs();
+        if (outputs.removeAll(this)) {
+            surface->setOutputs(outputs);
+        }
+    }
+
     if (d->display) {
         DisplayPrivate *displayPrivate = DisplayPrivate::get(d->display);
         displayPrivate->outputs.removeOne(this);
+        if (d->surfaceBit != -1) {
+            displayPrivate->outputSurfaceBits &= ~(quint64(1) << d->surfaceBit);
+            d->surfaceBit = -1;
+        }
     }
 
     Q_EMIT removed();
@@ -222,6 +228,8 @@ void OutputInterface::setMode(const Mode &mode)
         d->sendMode(resource);
     }
 
+    d->updateLogicalGeometry();
+
     Q_EMIT modeChanged();
     Q_EMIT refreshRateChanged(mode.refreshRate);
     Q_EMIT pixelSizeChanged(mode.size);
@@ -258,6 +266,7 @@ void OutputInterface::setGlobalPosition(const QPoint &globalPos)
         return;
     }
     d->globalPosition = globalPos;
+    d->updateLogicalGeometry();
     Q_EMIT globalPositionChanged(d->globalPosition);
 }
 
@@ -272,6 +281,7 @@ void OutputInterface::setManufacturer(const QString &manufacturer)
         return;
     }
     d->manufacturer = manufacturer;
+    d->encodedManufacturer = manufacturer.toUtf8();
     d->broadcastGeometry();
     Q_EMIT manufacturerChanged(d->manufacturer);
 }
@@ -287,6 +297,7 @@ void OutputInterface::setModel(const QString &model)
         return;
     }
     d->model = model;
+    d->encodedModel = model.toUtf8();
     d->broadcastGeometry();
     Q_EMIT modelChanged(d->model);
 }
@@ -302,6 +313,7 @@ void OutputInterface::setScale(int scale)
         return;
     }
     d->scale = scale;
+    d->updateLogicalGeometry();
 
     const auto outputResources = d->resourceMap();
     for (OutputInterfacePrivate::Resource *resource : outputResources) {
@@ -371,7 +383,7 @@ bool OutputInterface::isDpmsSupported() const
 
 QVector<wl_resource *> OutputInterface::clientResources(ClientConnection *client) const
 {
-    const auto outputResources = d->resourceMap().values(client->client());
+    const QList<OutputInterfacePrivate::Resource *> outputResources = d->clientResources.resources(client->client());
     QVector<wl_resource *> ret;
     ret.reserve(outputResources.count());
 
@@ -392,6 +404,10 @@ bool OutputInterface::isEnabled() const
 
 void OutputInterface::done()
 {
+    if (d->updateDepth > 0) {
+        d->donePending = true;
+        return;
+    }
     const auto outputResources = d->resourceMap();
     for (OutputInterfacePrivate::Resource *resource : outputResources) {
         d->sendDone(resource);
@@ -400,7 +416,46 @@ void OutputInterface::done()
 
 void OutputInterface::done(wl_client *client)
 {
-    d->sendDone(d->resourceMap().value(client));
+    if (d->updateDepth > 0) {
+        // the done event at the end of the update covers this client as well
+        d->donePending = true;
+        return;
+    }
+    const auto outputResources = d->resourceMap().values(client);
+    for (OutputInterfacePrivate::Resource *resource : outputResources) {
+        d->sendDone(resource);
+    }
+}
+
+void OutputInterface::beginUpdate()
+{
+    ++d->updateDepth;
+}
+
+void OutputInterface::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0 || !d->donePending) {
+        return;
+    }
+    d->donePending = false;
+    done();
+}
+
+void OutputInterfacePrivate::updateLogicalGeometry()
+{
+    logicalGeometry = QRect(globalPosition, mode.size / std::max(scale, 1));
+}
+
+wl_resource *OutputInterface::clientResource(ClientConnection *client) const
+{
+    const QList<OutputInterfacePrivate::Resource *> outputResources = d->clientResources.resources(client->client());
+    return outputResources.isEmpty() ? nullptr : outputResources.first()->handle;
+}
+
+OutputFrameClock *OutputInterface::frameClock() const
+{
+    return d->frameClock.data();
 }
 
 OutputInterface *OutputInterface::get(wl_resource *native)
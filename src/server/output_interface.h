@@ -19,6 +19,7 @@ namespace KWaylandServer
 {
 class ClientConnection;
 class Display;
+class OutputFrameClock;
 class OutputInterfacePrivate;
 
 /**
@@ -108,6 +109,12 @@ public:
      * @returns all wl_resources bound for the @p client
      */
     QVector<wl_resource *> clientResources(ClientConnection *client) const;
+    /**
+     * @returns the first wl_resource bound for the @p client, or @c null if the client didn't
+     * bind the output. Unlike clientResources() this doesn't allocate, most clients bind each
+     * output only once.
+     */
+    wl_resource *clientResource(ClientConnection *client) const;
 
     /**
      * Returns @c true if the output is on; otherwise returns false.
@@ -124,6 +131,26 @@ public:
      */
     void done(wl_client *client);
 
+    /**
+     * Starts changing several properties at once. The properties are still sent right away,
+     * but done() only marks the changes as complete, a single done event goes out with the
+     * matching endUpdate(). Updates can be nested.
+     *
+     * @see OutputTransaction
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate() and sends the done event if done() was called
+     * in the meantime.
+     */
+    void endUpdate();
+
+    /**
+     * Returns the clock the compositor ticks on every presentation of this output, it drives
+     * the frame callbacks of the surfaces on the output.
+     */
+    OutputFrameClock *frameClock() const;
+
     static OutputInterface *get(wl_resource *native);
 
 Q_SIGNALS:
@@ -155,6 +182,7 @@ Q_SIGNALS:
 
 private:
     QScopedPointer<OutputInterfacePrivate> d;
+    friend class OutputInterfacePrivate;
 };
 
 } // namespace KWaylandServer
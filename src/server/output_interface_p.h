@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "output_interface.h"
+#include "outputframeclock.h"
+#include "utils_p.h"
+
+#include <QPointer>
+#include <QRect>
+#include <QScopedPointer>
+#include <QSet>
+
+#include "qwayland-server-wayland.h"
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+
+class OutputInterfacePrivate : public QtWaylandServer::wl_output
+{
+public:
+    explicit OutputInterfacePrivate(Display *display, OutputInterface *q);
+
+    static OutputInterfacePrivate *get(OutputInterface *output);
+
+    void sendScale(Resource *resource);
+    void sendGeometry(Resource *resource);
+    void sendMode(Resource *resource);
+    void sendDone(Resource *resource);
+
+    void broadcastGeometry();
+
+    OutputInterface *q;
+    QPointer<Display> display;
+    QSize physicalSize;
+    QPoint globalPosition;
+    QString manufacturer = QStringLiteral("org.kde.kwin");
+    QString model = QStringLiteral("none");
+    // the strings of the initial state are encoded once for all the clients binding the output
+    QByteArray encodedManufacturer = QByteArrayLiteral("org.kde.kwin");
+    QByteArray encodedModel = QByteArrayLiteral("none");
+    int scale = 1;
+    OutputInterface::SubPixel subPixel = OutputInterface::SubPixel::Unknown;
+    OutputInterface::Transform transform = OutputInterface::Transform::Normal;
+    OutputInterface::Mode mode;
+    int updateDepth = 0;
+    bool donePending = false;
+    struct {
+        OutputInterface::DpmsMode mode = OutputInterface::DpmsMode::Off;
+        bool supported = false;
+    } dpms;
+    // The surfaces that entered this output, and the bit of the output in their output masks,
+    // or -1 if the display has more than 64 outputs. See SurfaceInterface::setOutputs().
+    QSet<SurfaceInterface *> surfaces;
+    int surfaceBit = -1;
+    ClientResources<Resource> clientResources;
+    QScopedPointer<OutputFrameClock> frameClock;
+    // the area of the output in the global compositor space, see Display::outputsIntersecting()
+    QRect logicalGeometry;
+    void updateLogicalGeometry();
+
+private:
+    void output_destroy_global() override;
+    void output_bind_resource(Resource *resource) override;
+    void output_destroy_resource(Resource *resource) override;
+    void output_release(Resource *resource) override;
+};
+
+} // namespace KWaylandServer
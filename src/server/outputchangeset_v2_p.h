@@ -7,6 +7,8 @@
 
 #include "outputchangeset_v2.h"
 
+#include <QPointer>
+
 namespace KWaylandServer
 {
 
@@ -16,7 +18,7 @@ public:
     OutputChangeSetV2Private(OutputDeviceV2Interface *outputdevice, OutputChangeSetV2 *parent);
 
     OutputChangeSetV2 *q;
-    OutputDeviceV2Interface *outputDevice;
+    QPointer<OutputDeviceV2Interface> outputDevice;
 
     bool enabled;
     QSize size;
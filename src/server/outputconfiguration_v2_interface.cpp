@@ -14,7 +14,11 @@
 #include "qwayland-server-kde-output-management-v2.h"
 #include "qwayland-server-kde-output-device-v2.h"
 
+#include <QPointer>
+
+#include <algorithm>
 #include <optional>
+#include <utility>
 
 namespace KWaylandServer
 {
@@ -27,6 +31,9 @@ public:
     void sendFailed();
     void emitConfigurationChangeRequested() const;
     void clearPendingChanges();
+    bool validate() const;
+    void beginDeviceUpdates();
+    void endDeviceUpdates();
 
     bool hasPendingChanges(OutputDeviceV2Interface *outputdevice) const;
     OutputChangeSetV2 *pendingChanges(OutputDeviceV2Interface *outputdevice);
@@ -34,6 +41,10 @@ public:
     OutputManagementV2Interface *outputManagement;
     QHash<OutputDeviceV2Interface *, OutputChangeSetV2 *> changes;
     std::optional<OutputDeviceV2Interface *> primaryOutput;
+    // the output devices kept in an update until the compositor answered
+    QVector<QPointer<OutputDeviceV2Interface>> updatingDevices;
+    // set when a request referenced an unknown output device or mode, or an invalid scale
+    bool invalid = false;
     OutputConfigurationV2Interface *q;
 
 protected:
@@ -69,8 +80,9 @@ void OutputConfigurationV2InterfacePrivate::kde_output_configuration_v2_mode(Res
     Q_UNUSED(resource)
     OutputDeviceV2Interface *output = OutputDeviceV2Interface::get(outputdevice);
     OutputDeviceModeV2Interface *mode = OutputDeviceModeV2Interface::get(modeResource);
-    if (!output) {
-        qDebug() << "outputdevice is nullptr";
+    if (!output || !mode) {
+        qCWarning(KWAYLAND_SERVER) << "Rejecting output configuration with an unknown output device or mode";
+        invalid = true;
         return;
     }
 
@@ -130,6 +142,7 @@ void OutputConfigurationV2InterfacePrivate::kde_output_configuration_v2_scale(Re
 
     if (doubleScale <= 0) {
         qCWarning(KWAYLAND_SERVER) << "Requested to scale output device to" << doubleScale << ", but I can't do that.";
+        invalid = true;
         return;
     }
     OutputDeviceV2Interface *output = OutputDeviceV2Interface::get(outputdevice);
@@ -144,6 +157,16 @@ void OutputConfigurationV2InterfacePrivate::kde_output_configuration_v2_scale(Re
 void OutputConfigurationV2InterfacePrivate::kde_output_configuration_v2_apply(Resource *resource)
 {
     Q_UNUSED(resource)
+    if (!updatingDevices.isEmpty()) {
+        qCWarning(KWAYLAND_SERVER) << "Output configuration applied again before the compositor answered";
+        return;
+    }
+    if (!q->isValid()) {
+        qCWarning(KWAYLAND_SERVER) << "Rejecting invalid output configuration";
+        q->setFailed();
+        return;
+    }
+    beginDeviceUpdates();
     emitConfigurationChangeRequested();
 }
 
@@ -248,9 +271,42 @@ OutputDeviceV2Interface *OutputConfigurationV2Interface::primary() const
     return *d->primaryOutput;
 }
 
+bool OutputConfigurationV2InterfacePrivate::validate() const
+{
+    if (invalid) {
+        return false;
+    }
+    for (const OutputChangeSetV2 *change : changes) {
+        // the hash keys are not tracked, the change set knows whether its device is gone
+        OutputDeviceV2Interface *device = change->d->outputDevice;
+        if (!device) {
+            return false;
+        }
+        if (change->sizeChanged() || change->refreshRateChanged()) {
+            const auto modes = device->modes();
+            const bool known = std::any_of(modes.constBegin(), modes.constEnd(), [change](OutputDeviceModeV2Interface *mode) {
+                return mode->size() == change->size() && mode->refreshRate() == change->refreshRate();
+            });
+            if (!known) {
+                return false;
+            }
+        }
+        if (change->enabled() && (change->size().isEmpty() || change->scale() <= 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OutputConfigurationV2Interface::isValid() const
+{
+    return d->validate();
+}
+
 void OutputConfigurationV2Interface::setApplied()
 {
     d->clearPendingChanges();
+    d->endDeviceUpdates();
     d->sendApplied();
 }
 
@@ -262,6 +318,7 @@ void OutputConfigurationV2InterfacePrivate::sendApplied()
 void OutputConfigurationV2Interface::setFailed()
 {
     d->clearPendingChanges();
+    d->endDeviceUpdates();
     d->sendFailed();
 }
 
@@ -295,6 +352,24 @@ bool OutputConfigurationV2InterfacePrivate::hasPendingChanges(OutputDeviceV2Inte
     c->brightnessChanged();
 }
 
+void OutputConfigurationV2InterfacePrivate::beginDeviceUpdates()
+{
+    for (const OutputChangeSetV2 *change : qAsConst(changes)) {
+        change->d->outputDevice->beginUpdate();
+        updatingDevices.append(change->d->outputDevice);
+    }
+}
+
+void OutputConfigurationV2InterfacePrivate::endDeviceUpdates()
+{
+    const auto devices = std::exchange(updatingDevices, {});
+    for (const auto &device : devices) {
+        if (device) {
+            device->endUpdate();
+        }
+    }
+}
+
 void OutputConfigurationV2InterfacePrivate::clearPendingChanges()
 {
     qDeleteAll(changes.begin(), changes.end());
@@ -310,6 +385,7 @@ OutputConfigurationV2Interface::OutputConfigurationV2Interface(OutputManagementV
 OutputConfigurationV2Interface::~OutputConfigurationV2Interface()
 {
     d->clearPendingChanges();
+    d->endDeviceUpdates();
 }
 
 }
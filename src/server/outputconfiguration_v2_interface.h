@@ -63,11 +63,29 @@ public:
     bool primaryChanged() const;
     OutputDeviceV2Interface *primary() const;
 
+    /**
+     * Checks the whole configuration without applying anything: every changed output device
+     * must still exist, requested modes must be among the modes of their output device and
+     * no enabled output may end up with an empty geometry.
+     *
+     * A configuration that fails this check is rejected before
+     * OutputManagementV2Interface::configurationChangeRequested is emitted, so the compositor
+     * only gets configurations that passed. It can call this again after adding its own
+     * checks.
+     *
+     * @returns @c true if the configuration can be applied
+     */
+    bool isValid() const;
+
 public Q_SLOTS:
     /**
      * Called by the compositor once the changes have successfully been applied.
      * The compositor is responsible for updating the OutputDevices. After having
      * done so, calling this function sends applied() through the client.
+     *
+     * From the apply request until this call or setFailed() the changed OutputDevices are
+     * in an update, see OutputDeviceV2Interface::beginUpdate(). Clients get a single done
+     * event per output with the whole new configuration, no intermediate states.
      * @see setFailed
      * @see OutputConfiguration::applied
      */
@@ -11,6 +11,7 @@
 #include "logging.h"
 #include "utils.h"
 
+#include <QDataStream>
 #include <QDebug>
 #include <QString>
 #include <QPointer>
@@ -20,6 +21,9 @@
 namespace KWaylandServer
 {
 static const quint32 s_version = 2;
+// identifies a blob written by OutputDeviceV2Interface::saveState and the version of its layout
+static const quint32 s_stateMagic = 0x4f444532;
+static const quint32 s_stateVersion = 1;
 
 class OutputDeviceV2InterfacePrivate : public QtWaylandServer::kde_output_device_v2
 {
@@ -28,6 +32,7 @@ public:
     ~OutputDeviceV2InterfacePrivate() override;
 
     void updateGeometry();
+    void scheduleDone();
 
     void sendGeometry(Resource *resource);
     wl_resource *sendNewMode(Resource *resource, OutputDeviceModeV2Interface *mode);
@@ -54,6 +59,12 @@ public:
     QString serialNumber;
     QString eisaId;
     QString name;
+    // the strings sent to every client are only encoded once
+    QByteArray encodedManufacturer = QByteArrayLiteral("org.kde.kwin");
+    QByteArray encodedModel = QByteArrayLiteral("none");
+    QByteArray encodedSerialNumber;
+    QByteArray encodedEisaId;
+    QByteArray encodedName;
     OutputDeviceV2Interface::SubPixel subPixel = OutputDeviceV2Interface::SubPixel::Unknown;
     OutputDeviceV2Interface::Transform transform = OutputDeviceV2Interface::Transform::Normal;
 
@@ -61,12 +72,18 @@ public:
     OutputDeviceModeV2Interface *currentMode = nullptr;
 
     QByteArray edid;
+    QByteArray encodedEdid;
     bool enabled = true;
     QUuid uuid;
+    QByteArray encodedUuid = QUuid().toByteArray(QUuid::WithoutBraces);
     OutputDeviceV2Interface::Capabilities capabilities;
     uint32_t overscan = 0;
     OutputDeviceV2Interface::VrrPolicy vrrPolicy = OutputDeviceV2Interface::VrrPolicy::Automatic;
     OutputDeviceV2Interface::RgbRange rgbRange = OutputDeviceV2Interface::RgbRange::Automatic;
+    ColorDescription colorDescription{ColorDescription::TransferFunction::Srgb, ColorDescription::Primaries::Rec709, std::nullopt};
+
+    int updateDepth = 0;
+    bool donePending = false;
 
     QPointer<Display> display;
     OutputDeviceV2Interface *q;
@@ -178,13 +195,14 @@ void OutputDeviceV2Interface::setCurrentMode(OutputDeviceModeV2Interface *mode)
     mode->setFlags(mode->flags() | OutputDeviceModeV2Interface::ModeFlag::Current);
     d->currentMode = mode;
 
+    beginUpdate();
     const auto clientResources = d->resourceMap();
     for (auto it = clientResources.begin(); it != clientResources.end(); ++it) {
-        auto resource = *it;
-        d->sendCurrentMode(resource, d->currentMode);
-        d->sendDone(resource);
+        d->sendCurrentMode(*it, d->currentMode);
     }
+    d->scheduleDone();
     d->updateGeometry();
+    endUpdate();
 }
 
 bool OutputDeviceV2Interface::setCurrentMode(const QSize &size, int refreshRate)
@@ -305,15 +323,15 @@ void OutputDeviceV2InterfacePrivate::sendCurrentMode(Resource *outputResource, O
 
 void OutputDeviceV2InterfacePrivate::sendGeometry(Resource *resource)
 {
-    send_geometry(resource->handle,
-                    globalPosition.x(),
-                    globalPosition.y(),
-                    physicalSize.width(),
-                    physicalSize.height(),
-                    toSubPixel(),
-                    manufacturer,
-                    model,
-                    toTransform());
+    kde_output_device_v2_send_geometry(resource->handle,
+                                       globalPosition.x(),
+                                       globalPosition.y(),
+                                       physicalSize.width(),
+                                       physicalSize.height(),
+                                       toSubPixel(),
+                                       encodedManufacturer.constData(),
+                                       encodedModel.constData(),
+                                       toTransform());
 }
 
 void OutputDeviceV2InterfacePrivate::sendScale(Resource *resource)
@@ -323,18 +341,18 @@ void OutputDeviceV2InterfacePrivate::sendScale(Resource *resource)
 
 void OutputDeviceV2InterfacePrivate::sendSerialNumber(Resource *resource)
 {
-    send_serial_number(resource->handle, serialNumber);
+    kde_output_device_v2_send_serial_number(resource->handle, encodedSerialNumber.constData());
 }
 
 void OutputDeviceV2InterfacePrivate::sendEisaId(Resource *resource)
 {
-    send_eisa_id(resource->handle, eisaId);
+    kde_output_device_v2_send_eisa_id(resource->handle, encodedEisaId.constData());
 }
 
 void OutputDeviceV2InterfacePrivate::sendName(Resource *resource)
 {
     if (resource->version() >= KDE_OUTPUT_DEVICE_V2_NAME_SINCE_VERSION) {
-        send_name(resource->handle, name);
+        kde_output_device_v2_send_name(resource->handle, encodedName.constData());
     }
 }
 
@@ -343,13 +361,133 @@ void OutputDeviceV2InterfacePrivate::sendDone(Resource *resource)
     send_done(resource->handle);
 }
 
+void OutputDeviceV2InterfacePrivate::scheduleDone()
+{
+    if (updateDepth > 0) {
+        donePending = true;
+        return;
+    }
+    broadcast_done();
+}
+
 void OutputDeviceV2InterfacePrivate::updateGeometry()
 {
     const auto clientResources = resourceMap();
-    for (const auto &resource : clientResources) {
+    for (Resource *resource : clientResources) {
         sendGeometry(resource);
-        sendDone(resource);
     }
+    scheduleDone();
+}
+
+void OutputDeviceV2Interface::beginUpdate()
+{
+    ++d->updateDepth;
+}
+
+void OutputDeviceV2Interface::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0 || !d->donePending) {
+        return;
+    }
+    d->donePending = false;
+    d->scheduleDone();
+}
+
+QByteArray OutputDeviceV2Interface::saveState() const
+{
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << s_stateMagic << s_stateVersion;
+    stream << d->physicalSize << d->globalPosition << d->manufacturer << d->model << d->serialNumber << d->eisaId << d->name;
+    stream << d->scale << qint32(d->subPixel) << qint32(d->transform);
+    stream << d->edid << d->enabled << d->uuid;
+    stream << qint32(d->capabilities) << d->overscan << qint32(d->vrrPolicy) << qint32(d->rgbRange);
+    stream << quint32(d->modes.count());
+    for (const OutputDeviceModeV2Interface *mode : qAsConst(d->modes)) {
+        stream << mode->size() << qint32(mode->refreshRate()) << qint32(mode->flags());
+    }
+    return state;
+}
+
+bool OutputDeviceV2Interface::restoreState(const QByteArray &state)
+{
+    QDataStream stream(state);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != s_stateMagic || version != s_stateVersion) {
+        return false;
+    }
+
+    QSize physicalSize;
+    QPoint globalPosition;
+    QString manufacturer;
+    QString model;
+    QString serialNumber;
+    QString eisaId;
+    QString name;
+    qreal scale = 1;
+    qint32 subPixel = 0;
+    qint32 transform = 0;
+    QByteArray edid;
+    bool enabled = true;
+    QUuid uuid;
+    qint32 capabilities = 0;
+    uint32_t overscan = 0;
+    qint32 vrrPolicy = 0;
+    qint32 rgbRange = 0;
+    quint32 modeCount = 0;
+    stream >> physicalSize >> globalPosition >> manufacturer >> model >> serialNumber >> eisaId >> name;
+    stream >> scale >> subPixel >> transform;
+    stream >> edid >> enabled >> uuid;
+    stream >> capabilities >> overscan >> vrrPolicy >> rgbRange;
+    stream >> modeCount;
+    if (stream.status() != QDataStream::Ok || modeCount == 0) {
+        return false;
+    }
+    struct Mode {
+        QSize size;
+        qint32 refreshRate = 0;
+        qint32 flags = 0;
+    };
+    QVector<Mode> modes;
+    for (quint32 i = 0; i < modeCount; ++i) {
+        Mode mode;
+        stream >> mode.size >> mode.refreshRate >> mode.flags;
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+        modes.append(mode);
+    }
+
+    beginUpdate();
+    setPhysicalSize(physicalSize);
+    setGlobalPosition(globalPosition);
+    setManufacturer(manufacturer);
+    setModel(model);
+    setSerialNumber(serialNumber);
+    setEisaId(eisaId);
+    setName(name);
+    setScale(scale);
+    setSubPixel(SubPixel(subPixel));
+    setTransform(Transform(transform));
+    setEdid(edid);
+    setEnabled(enabled);
+    setUuid(uuid);
+    setCapabilities(Capabilities(QFlag(capabilities)));
+    setOverscan(overscan);
+    setVrrPolicy(VrrPolicy(vrrPolicy));
+    setRgbRange(RgbRange(rgbRange));
+    QList<OutputDeviceModeV2Interface *> deviceModes;
+    for (const Mode &mode : qAsConst(modes)) {
+        deviceModes.append(new OutputDeviceModeV2Interface(mode.size, mode.refreshRate, OutputDeviceModeV2Interface::ModeFlags(QFlag(mode.flags))));
+    }
+    setModes(deviceModes);
+    endUpdate();
+    return true;
 }
 
 void OutputDeviceV2Interface::setPhysicalSize(const QSize &arg)
@@ -375,6 +513,7 @@ void OutputDeviceV2Interface::setManufacturer(const QString &arg)
         return;
     }
     d->manufacturer = arg;
+    d->encodedManufacturer = arg.toUtf8();
 }
 
 void OutputDeviceV2Interface::setModel(const QString &arg)
@@ -383,6 +522,7 @@ void OutputDeviceV2Interface::setModel(const QString &arg)
         return;
     }
     d->model = arg;
+    d->encodedModel = arg.toUtf8();
 }
 
 void OutputDeviceV2Interface::setSerialNumber(const QString &arg)
@@ -391,6 +531,7 @@ void OutputDeviceV2Interface::setSerialNumber(const QString &arg)
         return;
     }
     d->serialNumber = arg;
+    d->encodedSerialNumber = arg.toUtf8();
 }
 
 void OutputDeviceV2Interface::setEisaId(const QString &arg)
@@ -399,6 +540,7 @@ void OutputDeviceV2Interface::setEisaId(const QString &arg)
         return;
     }
     d->eisaId = arg;
+    d->encodedEisaId = arg.toUtf8();
 }
 
 void OutputDeviceV2Interface::setName(const QString &arg)
@@ -407,6 +549,7 @@ void OutputDeviceV2Interface::setName(const QString &arg)
         return;
     }
     d->name = arg;
+    d->encodedName = arg.toUtf8();
 }
 
 void OutputDeviceV2Interface::setSubPixel(SubPixel arg)
@@ -436,8 +579,8 @@ void OutputDeviceV2Interface::setScale(qreal scale)
     const auto clientResources = d->resourceMap();
     for (const auto &resource : clientResources) {
         d->sendScale(resource);
-        d->sendDone(resource);
     }
+    d->scheduleDone();
 }
 
 QSize OutputDeviceV2Interface::physicalSize() const
@@ -495,6 +638,11 @@ int OutputDeviceV2Interface::brightness() const
     return d->brightness;
 }
 
+QList<OutputDeviceModeV2Interface *> OutputDeviceV2Interface::modes() const
+{
+    return d->modes;
+}
+
 void OutputDeviceV2Interface::setModes(const QList<OutputDeviceModeV2Interface *> &modes)
 {
     if (modes.isEmpty()) {
@@ -532,19 +680,21 @@ void OutputDeviceV2Interface::setModes(const QList<OutputDeviceModeV2Interface *
 
     qDeleteAll(oldModes.crbegin(), oldModes.crend());
 
-    for (auto resource : clientResources) {
-        d->sendDone(resource);
-    }
+    d->scheduleDone();
 }
 
 void OutputDeviceV2Interface::setEdid(const QByteArray &edid)
 {
+    if (d->edid == edid) {
+        return;
+    }
     d->edid = edid;
+    d->encodedEdid = edid.toBase64();
     const auto clientResources = d->resourceMap();
     for (const auto &resource : clientResources) {
         d->sendEdid(resource);
-        d->sendDone(resource);
     }
+    d->scheduleDone();
 }
 
 QByteArray OutputDeviceV2Interface::edid() const
@@ -559,8 +709,8 @@ void OutputDeviceV2Interface::setEnabled(bool enabled)
         const auto clientResources = d->resourceMap();
         for (const auto &resource : clientResources) {
             d->sendEnabled(resource);
-            d->sendDone(resource);
         }
+        d->scheduleDone();
     }
 }
 
@@ -573,11 +723,12 @@ void OutputDeviceV2Interface::setUuid(const QUuid &uuid)
 {
     if (d->uuid != uuid) {
         d->uuid = uuid;
+        d->encodedUuid = uuid.toByteArray(QUuid::WithoutBraces);
         const auto clientResources = d->resourceMap();
         for (const auto &resource : clientResources) {
             d->sendUuid(resource);
-            d->sendDone(resource);
         }
+        d->scheduleDone();
     }
 }
 
@@ -588,7 +739,7 @@ QUuid OutputDeviceV2Interface::uuid() const
 
 void OutputDeviceV2InterfacePrivate::sendEdid(Resource *resource)
 {
-    send_edid(resource->handle, QString::fromStdString(edid.toBase64().toStdString()));
+    kde_output_device_v2_send_edid(resource->handle, encodedEdid.constData());
 }
 
 void OutputDeviceV2InterfacePrivate::sendEnabled(Resource *resource)
@@ -598,7 +749,7 @@ void OutputDeviceV2InterfacePrivate::sendEnabled(Resource *resource)
 
 void OutputDeviceV2InterfacePrivate::sendUuid(Resource *resource)
 {
-    send_uuid(resource->handle, uuid.toString(QUuid::WithoutBraces));
+    kde_output_device_v2_send_uuid(resource->handle, encodedUuid.constData());
 }
 
 uint32_t OutputDeviceV2Interface::overscan() const
@@ -618,8 +769,8 @@ void OutputDeviceV2Interface::setCapabilities(Capabilities cap)
         const auto clientResources = d->resourceMap();
         for (const auto &resource : clientResources) {
             d->sendCapabilities(resource);
-            d->sendDone(resource);
         }
+        d->scheduleDone();
     }
 }
 
@@ -635,8 +786,8 @@ void OutputDeviceV2Interface::setOverscan(uint32_t overscan)
         const auto clientResources = d->resourceMap();
         for (const auto &resource : clientResources) {
             d->sendOverscan(resource);
-            d->sendDone(resource);
         }
+        d->scheduleDone();
     }
 }
 
@@ -662,8 +813,8 @@ void OutputDeviceV2Interface::setVrrPolicy(VrrPolicy policy)
         const auto clientResources = d->resourceMap();
         for (const auto &resource : clientResources) {
             d->sendVrrPolicy(resource);
-            d->sendDone(resource);
         }
+        d->scheduleDone();
     }
 }
 
@@ -679,11 +830,21 @@ void OutputDeviceV2Interface::setRgbRange(RgbRange rgbRange)
         const auto clientResources = d->resourceMap();
         for (const auto &resource : clientResources) {
             d->sendRgbRange(resource);
-            d->sendDone(resource);
         }
+        d->scheduleDone();
     }
 }
 
+ColorDescription OutputDeviceV2Interface::colorDescription() const
+{
+    return d->colorDescription;
+}
+
+void OutputDeviceV2Interface::setColorDescription(const ColorDescription &description)
+{
+    d->colorDescription = description;
+}
+
 void OutputDeviceV2InterfacePrivate::sendRgbRange(Resource *resource)
 {
     send_rgb_range(resource->handle, static_cast<uint32_t>(rgbRange));
@@ -6,6 +6,8 @@
 */
 #pragma once
 
+#include "colordescription.h"
+
 #include <DWayland/Server/kwaylandserver_export.h>
 
 #include <QObject>
@@ -60,6 +62,8 @@ public:
         Overscan = 0x1,
         Vrr = 0x2,
         RgbRange = 0x4,
+        HighDynamicRange = 0x8,
+        WideColorGamut = 0x10,
     };
     Q_ENUM(Capability)
     Q_DECLARE_FLAGS(Capabilities, Capability)
@@ -104,6 +108,11 @@ public:
     uint32_t overscan() const;
     VrrPolicy vrrPolicy() const;
     RgbRange rgbRange() const;
+    /**
+     * Returns the color space the output displays, including the luminance range it can
+     * show as HDR metadata.
+     */
+    ColorDescription colorDescription() const;
 
     void setPhysicalSize(const QSize &size);
     void setGlobalPosition(const QPoint &pos);
@@ -118,6 +127,7 @@ public:
     void setTransform(Transform transform);
 
     void setModes(const QList<KWaylandServer::OutputDeviceModeV2Interface *> &modes);
+    QList<KWaylandServer::OutputDeviceModeV2Interface *> modes() const;
     void setCurrentMode(KWaylandServer::OutputDeviceModeV2Interface *mode);
 
     /**
@@ -134,6 +144,48 @@ public:
     void setOverscan(uint32_t overscan);
     void setVrrPolicy(VrrPolicy policy);
     void setRgbRange(RgbRange rgbRange);
+    /**
+     * Sets the color space the output displays. The compositor compares it with the color
+     * description of the surfaces on the output to find the ones that don't need any conversion,
+     * and usually makes it the preferred color description of those surfaces.
+     *
+     * Whether the output can show HDR or wide gamut content at all is advertised to clients
+     * with the HighDynamicRange and WideColorGamut capabilities.
+     *
+     * @see SurfaceInterface::setPreferredColorDescription
+     */
+    void setColorDescription(const ColorDescription &description);
+
+    /**
+     * Starts changing several properties at once, e.g. the mode, position and scale of an
+     * output that gets reconfigured. Every setter still sends its event right away, but the
+     * done event is held back until the matching endUpdate() so clients apply all changes
+     * atomically. Updates can be nested.
+     *
+     * @see endUpdate
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate() and sends a single done event, if anything changed.
+     */
+    void endUpdate();
+
+    /**
+     * Returns the properties and the modes of the output device serialized into a compact blob,
+     * e.g. to write a checkpoint the compositor restores its output devices from after a restart,
+     * so that clients find them complete right when they bind. The brightness and the color
+     * description are not part of the state.
+     *
+     * @see restoreState
+     */
+    QByteArray saveState() const;
+    /**
+     * Restores a @p state returned by saveState(), replacing the properties and the modes of the
+     * output device. Bound clients get the changes as a single update.
+     *
+     * Returns @c false and leaves the output device untouched if the @p state is not valid.
+     */
+    bool restoreState(const QByteArray &state);
 
     wl_resource *resource() const;
     static OutputDeviceV2Interface *get(wl_resource *native);
@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "outputframeclock.h"
+#include "output_interface.h"
+#include "output_interface_p.h"
+#include "surface_interface.h"
+
+namespace KWaylandServer
+{
+class OutputFrameClockPrivate
+{
+public:
+    OutputInterface *output;
+    std::chrono::nanoseconds lastPresentation = std::chrono::nanoseconds::zero();
+    quint64 sequence = 0;
+};
+
+OutputFrameClock::OutputFrameClock(OutputInterface *output)
+    : d(new OutputFrameClockPrivate)
+{
+    d->output = output;
+}
+
+OutputFrameClock::~OutputFrameClock() = default;
+
+OutputInterface *OutputFrameClock::output() const
+{
+    return d->output;
+}
+
+void OutputFrameClock::tick(std::chrono::nanoseconds timestamp)
+{
+    d->lastPresentation = timestamp;
+    ++d->sequence;
+
+    // sub-surfaces get their callbacks along with their parents
+    const QSet<SurfaceInterface *> surfaces = OutputInterfacePrivate::get(d->output)->surfaces;
+    for (SurfaceInterface *surface : surfaces) {
+        if (!surface->subSurface()) {
+            surface->frameRendered(d->output, timestamp);
+        }
+    }
+
+    Q_EMIT presented(timestamp, d->sequence);
+}
+
+std::chrono::nanoseconds OutputFrameClock::lastPresentation() const
+{
+    return d->lastPresentation;
+}
+
+std::chrono::nanoseconds OutputFrameClock::refreshInterval() const
+{
+    // the refresh rate is in mHz
+    const int refreshRate = d->output->refreshRate();
+    if (refreshRate <= 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::chrono::nanoseconds(1'000'000'000'000 / refreshRate);
+}
+
+std::chrono::nanoseconds OutputFrameClock::nextPresentation() const
+{
+    if (!d->sequence) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return d->lastPresentation + refreshInterval();
+}
+
+quint64 OutputFrameClock::sequence() const
+{
+    return d->sequence;
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+#include <chrono>
+
+namespace KWaylandServer
+{
+class OutputInterface;
+class OutputFrameClockPrivate;
+
+/**
+ * The OutputFrameClock class is the single source of the presentation timing of an output.
+ *
+ * The compositor calls tick() whenever a frame got presented on the output, usually once per
+ * vblank. The clock sends the frame callbacks of the surfaces shown on the output, see
+ * SurfaceInterface::frameRendered(OutputInterface *, std::chrono::nanoseconds), and emits
+ * presented() for everything else that is paced by the output, e.g. screencast streams, remote
+ * access or idle throttling, so none of them needs a timer of its own.
+ *
+ * Every OutputInterface has a clock, see OutputInterface::frameClock().
+ */
+class KWAYLANDSERVER_EXPORT OutputFrameClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~OutputFrameClock() override;
+
+    /**
+     * Returns the output which is paced by this clock.
+     */
+    OutputInterface *output() const;
+
+    /**
+     * Reports that the output presented a frame at @p timestamp in the CLOCK_MONOTONIC domain.
+     *
+     * The surfaces on the output get their frame callbacks, then presented() is emitted.
+     */
+    void tick(std::chrono::nanoseconds timestamp);
+
+    /**
+     * Returns the time of the last tick(), or zero if the clock never ticked.
+     */
+    std::chrono::nanoseconds lastPresentation() const;
+    /**
+     * Returns the duration of a refresh cycle of the current mode of the output.
+     */
+    std::chrono::nanoseconds refreshInterval() const;
+    /**
+     * Returns when the next frame is expected to be presented, one refresh cycle after the
+     * last one, or zero if the clock never ticked.
+     */
+    std::chrono::nanoseconds nextPresentation() const;
+    /**
+     * Returns the number of ticks so far.
+     */
+    quint64 sequence() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted by tick() after the frame callbacks of the surfaces on the output got sent.
+     *
+     * @param timestamp When the frame got presented
+     * @param sequence The number of ticks so far, including this one
+     */
+    void presented(std::chrono::nanoseconds timestamp, quint64 sequence);
+
+private:
+    explicit OutputFrameClock(OutputInterface *output);
+    friend class OutputInterface;
+
+    QScopedPointer<OutputFrameClockPrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -42,6 +42,10 @@ Q_SIGNALS:
      * notified when the new configuration is set up, and it should be applied to the
      * Wayland server's OutputInterfaces.
      *
+     * The configuration already passed OutputConfigurationV2Interface::isValid(). The changed
+     * OutputDeviceV2Interfaces hold back their done events until the compositor answers with
+     * setApplied() or setFailed(), so it can update them one by one.
+     *
      * @param config The OutputConfigurationInterface corresponding to the client that
      * called apply().
      * @see OutputConfiguration::apply
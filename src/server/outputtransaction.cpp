@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "outputtransaction.h"
+#include "output_interface.h"
+#include "outputdevice_v2_interface.h"
+#include "xdgoutput_v1_interface.h"
+
+namespace KWaylandServer
+{
+
+OutputTransaction::OutputTransaction(OutputInterface *output, XdgOutputV1Interface *xdgOutput, OutputDeviceV2Interface *outputDevice)
+    : m_output(output)
+    , m_xdgOutput(xdgOutput)
+    , m_outputDevice(outputDevice)
+{
+    if (m_output) {
+        m_output->beginUpdate();
+    }
+    if (m_xdgOutput) {
+        m_xdgOutput->beginUpdate();
+    }
+    if (m_outputDevice) {
+        m_outputDevice->beginUpdate();
+    }
+}
+
+OutputTransaction::~OutputTransaction()
+{
+    commit();
+}
+
+void OutputTransaction::commit()
+{
+    if (m_committed) {
+        return;
+    }
+    m_committed = true;
+
+    if (m_outputDevice) {
+        m_outputDevice->endUpdate();
+    }
+    // the xdg-output goes first, its version 3 clients wait for the wl_output done event
+    if (m_xdgOutput) {
+        m_xdgOutput->endUpdate();
+    }
+    if (m_output) {
+        m_output->endUpdate();
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+class OutputDeviceV2Interface;
+class OutputInterface;
+class XdgOutputV1Interface;
+
+/**
+ * The OutputTransaction class groups the changes of one logical output change, e.g. a new
+ * scale, across the wl_output, xdg-output and output device objects of the output.
+ *
+ * While the transaction is alive all objects are in an update, changed properties are sent
+ * but the done events are held back. When the transaction ends every resource gets exactly
+ * one done event, so clients relayout once per change instead of once per property.
+ *
+ * @code
+ * {
+ *     OutputTransaction transaction(output, xdgOutput, outputDevice);
+ *     output->setScale(2);
+ *     output->done();
+ *     xdgOutput->setLogicalSize(size / 2);
+ *     xdgOutput->done();
+ *     outputDevice->setScale(2);
+ * }
+ * @endcode
+ *
+ * The objects may be destroyed while the transaction is alive.
+ */
+class KWAYLANDSERVER_EXPORT OutputTransaction
+{
+public:
+    explicit OutputTransaction(OutputInterface *output, XdgOutputV1Interface *xdgOutput = nullptr, OutputDeviceV2Interface *outputDevice = nullptr);
+    ~OutputTransaction();
+
+    /**
+     * Ends the transaction before the object goes out of scope and sends the done events.
+     */
+    void commit();
+
+private:
+    Q_DISABLE_COPY(OutputTransaction)
+
+    QPointer<OutputInterface> m_output;
+    QPointer<XdgOutputV1Interface> m_xdgOutput;
+    QPointer<OutputDeviceV2Interface> m_outputDevice;
+    bool m_committed = false;
+};
+
+}
@@ -5,7 +5,9 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "plasmashell_interface.h"
+#include "clientconnection.h"
 #include "display.h"
+#include "display_p.h"
 #include "surface_interface.h"
 #include "utils.h"
 
@@ -37,12 +39,22 @@ class PlasmaShellSurfaceInterfacePrivate : public QtWaylandServer::org_kde_plasm
 public:
     PlasmaShellSurfaceInterfacePrivate(PlasmaShellSurfaceInterface *q, SurfaceInterface *surface, wl_resource *resource);
 
+    void schedulePending();
+    void applyPending();
+
     QPointer<SurfaceInterface> surface;
     PlasmaShellSurfaceInterface *q;
     QPoint m_globalPos;
     PlasmaShellSurfaceInterface::Role m_role = PlasmaShellSurfaceInterface::Role::Normal;
     PlasmaShellSurfaceInterface::PanelBehavior m_panelBehavior = PlasmaShellSurfaceInterface::PanelBehavior::AlwaysVisible;
     bool m_positionSet = false;
+    // double buffered, applied on the commit of the surface or at the latest once the requests
+    // the client sent together are dispatched
+    QPoint m_pendingPos;
+    PlasmaShellSurfaceInterface::Role m_pendingRole = PlasmaShellSurfaceInterface::Role::Normal;
+    PlasmaShellSurfaceInterface::PanelBehavior m_pendingPanelBehavior = PlasmaShellSurfaceInterface::PanelBehavior::AlwaysVisible;
+    PlasmaShellSurfaceInterface::Changes m_pendingChanges;
+    bool m_applyScheduled = false;
     bool m_skipTaskbar = false;
     bool m_skipSwitcher = false;
     bool m_panelTakesFocus = false;
@@ -106,9 +118,57 @@ PlasmaShellSurfaceInterfacePrivate::PlasmaShellSurfaceInterfacePrivate(PlasmaShe
 {
 }
 
+void PlasmaShellSurfaceInterfacePrivate::schedulePending()
+{
+    if (m_applyScheduled) {
+        return;
+    }
+    if (!surface) {
+        applyPending();
+        return;
+    }
+    m_applyScheduled = true;
+    DisplayPrivate::get(surface->client()->display())->runAfterDispatch(q, [this]() {
+        applyPending();
+    });
+}
+
+void PlasmaShellSurfaceInterfacePrivate::applyPending()
+{
+    m_applyScheduled = false;
+    const PlasmaShellSurfaceInterface::Changes changes = std::exchange(m_pendingChanges, {});
+    if (!changes) {
+        return;
+    }
+    if (changes.testFlag(PlasmaShellSurfaceInterface::Change::Position)) {
+        m_positionSet = true;
+        m_globalPos = m_pendingPos;
+    }
+    if (changes.testFlag(PlasmaShellSurfaceInterface::Change::Role)) {
+        m_role = m_pendingRole;
+    }
+    if (changes.testFlag(PlasmaShellSurfaceInterface::Change::PanelBehavior)) {
+        m_panelBehavior = m_pendingPanelBehavior;
+    }
+
+    if (changes.testFlag(PlasmaShellSurfaceInterface::Change::Position)) {
+        Q_EMIT q->positionChanged();
+    }
+    if (changes.testFlag(PlasmaShellSurfaceInterface::Change::Role)) {
+        Q_EMIT q->roleChanged();
+    }
+    if (changes.testFlag(PlasmaShellSurfaceInterface::Change::PanelBehavior)) {
+        Q_EMIT q->panelBehaviorChanged();
+    }
+    Q_EMIT q->changed(changes);
+}
+
 PlasmaShellSurfaceInterface::PlasmaShellSurfaceInterface(SurfaceInterface *surface, wl_resource *resource)
     : d(new PlasmaShellSurfaceInterfacePrivate(this, surface, resource))
 {
+    connect(surface, &SurfaceInterface::committed, this, [this]() {
+        d->applyPending();
+    });
 }
 
 PlasmaShellSurfaceInterface::~PlasmaShellSurfaceInterface() = default;
@@ -141,11 +201,12 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_position(Res
     Q_UNUSED(resource);
     QPoint globalPos(x, y);
     if (m_globalPos == globalPos && m_positionSet) {
+        m_pendingChanges &= ~PlasmaShellSurfaceInterface::Changes(PlasmaShellSurfaceInterface::Change::Position);
         return;
     }
-    m_positionSet = true;
-    m_globalPos = globalPos;
-    Q_EMIT q->positionChanged();
+    m_pendingPos = globalPos;
+    m_pendingChanges |= PlasmaShellSurfaceInterface::Change::Position;
+    schedulePending();
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_role(Resource *resource, uint32_t role)
@@ -187,10 +248,12 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_role(Resourc
         break;
     }
     if (r == m_role) {
+        m_pendingChanges &= ~PlasmaShellSurfaceInterface::Changes(PlasmaShellSurfaceInterface::Change::Role);
         return;
     }
-    m_role = r;
-    Q_EMIT q->roleChanged();
+    m_pendingRole = r;
+    m_pendingChanges |= PlasmaShellSurfaceInterface::Change::Role;
+    schedulePending();
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_panel_behavior(Resource *resource, uint32_t flag)
@@ -213,10 +276,12 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_panel_behavi
         break;
     }
     if (m_panelBehavior == newBehavior) {
+        m_pendingChanges &= ~PlasmaShellSurfaceInterface::Changes(PlasmaShellSurfaceInterface::Change::PanelBehavior);
         return;
     }
-    m_panelBehavior = newBehavior;
-    Q_EMIT q->panelBehaviorChanged();
+    m_pendingPanelBehavior = newBehavior;
+    m_pendingChanges |= PlasmaShellSurfaceInterface::Change::PanelBehavior;
+    schedulePending();
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_skip_taskbar(Resource *resource, uint32_t skip)
@@ -237,6 +302,8 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_skip_switche
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_panel_auto_hide_hide(Resource *resource)
 {
+    // the role and behavior may have been requested together with this request
+    applyPending();
     if (m_role != PlasmaShellSurfaceInterface::Role::Panel
         || (m_panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::AutoHide
             && m_panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::WindowsCanCover)) {
@@ -248,6 +315,7 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_panel_auto_hide_
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_panel_auto_hide_show(Resource *resource)
 {
+    applyPending();
     if (m_role != PlasmaShellSurfaceInterface::Role::Panel || m_panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::AutoHide) {
         wl_resource_post_error(resource->handle, error_panel_not_auto_hide, "Not an auto hide panel");
         return;
@@ -159,6 +159,17 @@ public:
 
     void resetPositionSet();
 
+    /**
+     * The properties which are double buffered and applied together.
+     * @see changed
+     */
+    enum class Change {
+        Position = 1 << 0,
+        Role = 1 << 1,
+        PanelBehavior = 1 << 2,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
 Q_SIGNALS:
     /**
      * A change of global position has been requested.
@@ -172,6 +183,14 @@ Q_SIGNALS:
      * A change of the panel behavior has been requested.
      */
     void panelBehaviorChanged();
+    /**
+     * Emitted once the position, role and panel behavior a client requested together got
+     * applied, after the individual change signals. The requests are applied on the commit
+     * of the surface, or once they are dispatched if the client doesn't commit.
+     *
+     * Panels set all of them at once, the compositor can evaluate their placement once here.
+     */
+    void changed(KWaylandServer::PlasmaShellSurfaceInterface::Changes changes);
     /**
      * A change in the skip taskbar property has been requested
      */
@@ -222,5 +241,8 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::PlasmaShellSurfaceInterface::Changes)
+
 Q_DECLARE_METATYPE(KWaylandServer::PlasmaShellSurfaceInterface::Role)
 Q_DECLARE_METATYPE(KWaylandServer::PlasmaShellSurfaceInterface::PanelBehavior)
+Q_DECLARE_METATYPE(KWaylandServer::PlasmaShellSurfaceInterface::Changes)
@@ -6,15 +6,21 @@
 #include "plasmavirtualdesktop_interface.h"
 #include "display.h"
 
+#include <QDataStream>
 #include <QDebug>
 #include <QTimer>
 
 #include <qwayland-server-org-kde-plasma-virtual-desktop.h>
 #include <wayland-server.h>
 
+#include <algorithm>
+
 namespace KWaylandServer
 {
 static const quint32 s_version = 2;
+// identifies a blob written by PlasmaVirtualDesktopManagementInterface::saveState and the version of its layout
+static const quint32 s_stateMagic = 0x50564432;
+static const quint32 s_stateVersion = 1;
 
 class PlasmaVirtualDesktopInterfacePrivate : public QtWaylandServer::org_kde_plasma_virtual_desktop
 {
@@ -44,6 +50,15 @@ public:
     quint32 columns = 0;
     PlasmaVirtualDesktopManagementInterface *q;
 
+    int updateDepth = 0;
+    // the desktops and rows the clients know about while an update is running
+    QStringList sentDesktops;
+    quint32 sentRows = 0;
+    bool donePending = false;
+
+    QStringList desktopIds() const;
+    void sendRows(Resource *resource, quint32 rows);
+
     inline QList<PlasmaVirtualDesktopInterface *>::const_iterator constFindDesktop(const QString &id);
     inline QList<PlasmaVirtualDesktopInterface *>::iterator findDesktop(const QString &id);
 
@@ -68,6 +83,23 @@ inline QList<PlasmaVirtualDesktopInterface *>::iterator PlasmaVirtualDesktopMana
     });
 }
 
+QStringList PlasmaVirtualDesktopManagementInterfacePrivate::desktopIds() const
+{
+    QStringList ids;
+    ids.reserve(desktops.count());
+    for (const PlasmaVirtualDesktopInterface *desktop : desktops) {
+        ids << desktop->id();
+    }
+    return ids;
+}
+
+void PlasmaVirtualDesktopManagementInterfacePrivate::sendRows(Resource *resource, quint32 rows)
+{
+    if (resource->version() >= ORG_KDE_PLASMA_VIRTUAL_DESKTOP_MANAGEMENT_ROWS_SINCE_VERSION) {
+        send_rows(resource->handle, rows);
+    }
+}
+
 void PlasmaVirtualDesktopManagementInterfacePrivate::org_kde_plasma_virtual_desktop_management_get_virtual_desktop(Resource *resource,
                                                                                                                    uint32_t id,
                                                                                                                    const QString &desktop_id)
@@ -103,14 +135,13 @@ PlasmaVirtualDesktopManagementInterfacePrivate::PlasmaVirtualDesktopManagementIn
 
 void PlasmaVirtualDesktopManagementInterfacePrivate::org_kde_plasma_virtual_desktop_management_bind_resource(Resource *resource)
 {
-    quint32 i = 0;
-    for (auto it = desktops.constBegin(); it != desktops.constEnd(); ++it) {
-        send_desktop_created(resource->handle, (*it)->id(), i++);
+    // during an update a new client starts from what the others know, it gets the rest with them
+    const QStringList ids = updateDepth > 0 ? sentDesktops : desktopIds();
+    for (int i = 0; i < ids.count(); ++i) {
+        send_desktop_created(resource->handle, ids[i], i);
     }
 
-    if (resource->version() >= ORG_KDE_PLASMA_VIRTUAL_DESKTOP_MANAGEMENT_ROWS_SINCE_VERSION) {
-        send_rows(resource->handle, rows);
-    }
+    sendRows(resource, updateDepth > 0 ? sentRows : rows);
 
     send_done(resource->handle);
 }
@@ -133,13 +164,13 @@ void PlasmaVirtualDesktopManagementInterface::setRows(quint32 rows)
     }
 
     d->rows = rows;
+    if (d->updateDepth > 0) {
+        return;
+    }
 
     const auto clientResources = d->resourceMap();
     for (auto resource : clientResources) {
-        if (resource->version() < ORG_KDE_PLASMA_VIRTUAL_DESKTOP_MANAGEMENT_ROWS_SINCE_VERSION) {
-            continue;
-        }
-        d->send_rows(resource->handle, rows);
+        d->sendRows(resource, rows);
     }
 }
 
@@ -175,6 +206,9 @@ PlasmaVirtualDesktopInterface *PlasmaVirtualDesktopManagementInterface::createDe
     }
 
     d->desktops.insert(actualPosition, desktop);
+    if (d->updateDepth > 0) {
+        return desktop;
+    }
 
     const auto clientResources = d->resourceMap();
     for (auto resource : clientResources) {
@@ -196,9 +230,12 @@ void PlasmaVirtualDesktopManagementInterface::removeDesktop(const QString &id)
         (*deskIt)->d->send_removed(resource->handle);
     }
 
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        d->send_desktop_removed(resource->handle, id);
+    // a desktop created within the running update is not known to the clients yet
+    if (d->updateDepth == 0 || d->sentDesktops.removeOne(id)) {
+        const auto clientResources = d->resourceMap();
+        for (auto resource : clientResources) {
+            d->send_desktop_removed(resource->handle, id);
+        }
     }
 
     (*deskIt)->deleteLater();
@@ -212,12 +249,122 @@ QList<PlasmaVirtualDesktopInterface *> PlasmaVirtualDesktopManagementInterface::
 
 void PlasmaVirtualDesktopManagementInterface::sendDone()
 {
+    if (d->updateDepth > 0) {
+        d->donePending = true;
+        return;
+    }
     const auto clientResources = d->resourceMap();
     for (auto resource : clientResources) {
         d->send_done(resource->handle);
     }
 }
 
+void PlasmaVirtualDesktopManagementInterface::beginUpdate()
+{
+    if (d->updateDepth++ == 0) {
+        d->sentDesktops = d->desktopIds();
+        d->sentRows = d->rows;
+    }
+}
+
+void PlasmaVirtualDesktopManagementInterface::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0) {
+        return;
+    }
+
+    const auto clientResources = d->resourceMap();
+    // the removed desktops are already gone, so the positions refer to the final layout
+    const QStringList ids = d->desktopIds();
+    for (int i = 0; i < ids.count(); ++i) {
+        if (d->sentDesktops.contains(ids[i])) {
+            continue;
+        }
+        for (auto resource : clientResources) {
+            d->send_desktop_created(resource->handle, ids[i], i);
+        }
+    }
+    if (d->rows != d->sentRows) {
+        for (auto resource : clientResources) {
+            d->sendRows(resource, d->rows);
+        }
+    }
+    if (d->donePending) {
+        for (auto resource : clientResources) {
+            d->send_done(resource->handle);
+        }
+    }
+
+    d->sentDesktops.clear();
+    d->donePending = false;
+}
+
+QByteArray PlasmaVirtualDesktopManagementInterface::saveState() const
+{
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << s_stateMagic << s_stateVersion << d->rows << quint32(d->desktops.count());
+    for (const PlasmaVirtualDesktopInterface *desktop : qAsConst(d->desktops)) {
+        stream << desktop->d->id << desktop->d->name << desktop->d->active;
+    }
+    return state;
+}
+
+bool PlasmaVirtualDesktopManagementInterface::restoreState(const QByteArray &state)
+{
+    QDataStream stream(state);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 rows = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> rows >> count;
+    if (magic != s_stateMagic || version != s_stateVersion || stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    struct Desktop {
+        QString id;
+        QString name;
+        bool active = false;
+    };
+    QVector<Desktop> desktops;
+    for (quint32 i = 0; i < count; ++i) {
+        Desktop desktop;
+        stream >> desktop.id >> desktop.name >> desktop.active;
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+        desktops.append(desktop);
+    }
+
+    beginUpdate();
+    const QStringList ids = d->desktopIds();
+    for (const QString &id : ids) {
+        const bool restored = std::any_of(desktops.cbegin(), desktops.cend(), [&id](const Desktop &desktop) {
+            return desktop.id == id;
+        });
+        if (!restored) {
+            removeDesktop(id);
+        }
+    }
+    for (int i = 0; i < desktops.count(); ++i) {
+        PlasmaVirtualDesktopInterface *desktop = createDesktop(desktops[i].id, i);
+        desktop->setName(desktops[i].name);
+    }
+    // activate after all desktops exist, creating the first one activates it
+    for (const Desktop &desktop : qAsConst(desktops)) {
+        PlasmaVirtualDesktopInterface *restored = this->desktop(desktop.id);
+        restored->setActive(desktop.active);
+        restored->sendDone();
+    }
+    setRows(rows);
+    sendDone();
+    endUpdate();
+    return true;
+}
+
 //// PlasmaVirtualDesktopInterface
 
 void PlasmaVirtualDesktopInterfacePrivate::org_kde_plasma_virtual_desktop_request_activate(Resource *resource)
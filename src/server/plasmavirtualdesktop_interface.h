@@ -67,6 +67,41 @@ public:
      */
     void sendDone();
 
+    /**
+     * Starts changing the desktop layout, e.g. when several desktops are added or the rows
+     * change together with the desktops.
+     *
+     * Until the matching endUpdate() only the difference to the layout the clients know is
+     * collected: a desktop which is created and removed again is never announced, the rows
+     * are sent once with their final value and sendDone() results in a single done event.
+     * Removing a desktop the clients know about is still sent right away. Updates can be
+     * nested, the changes are sent when the outermost update ends.
+     *
+     * @see endUpdate
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate() and sends the changed layout.
+     */
+    void endUpdate();
+
+    /**
+     * Returns the rows and the desktops with their names and which one is active, serialized
+     * into a compact blob, e.g. to write a checkpoint the compositor restores the desktops from
+     * after a restart.
+     *
+     * @see restoreState
+     */
+    QByteArray saveState() const;
+    /**
+     * Restores a @p state returned by saveState(). Desktops that are not part of the @p state get
+     * removed, the missing ones get created, desktops that exist already keep their position.
+     * The changes are sent as a single update, followed by a done event.
+     *
+     * Returns @c false and leaves the desktops untouched if the @p state is not valid.
+     */
+    bool restoreState(const QByteArray &state);
+
 Q_SIGNALS:
     /**
      * A desktop has been activated
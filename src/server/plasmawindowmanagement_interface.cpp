@@ -4,12 +4,19 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "plasmawindowmanagement_interface.h"
+#include "clientconnection.h"
+#include "clientconnection_p.h"
 #include "display.h"
+#include "display_p.h"
 #include "logging.h"
 #include "plasmavirtualdesktop_interface.h"
 #include "surface_interface.h"
+#include "timerwheel.h"
+#include "utils_p.h"
 
+#include <QCache>
 #include <QFile>
+#include <QFutureWatcher>
 #include <QHash>
 #include <QIcon>
 #include <QList>
@@ -20,11 +27,48 @@
 
 #include <qwayland-server-plasma-window-management.h>
 
+#include <chrono>
+
 namespace KWaylandServer
 {
 static const quint32 s_version = 14;
 static const quint32 s_activationVersion = 1;
 
+/**
+ * Serialized icons shared by all windows, keyed by iconCacheKey(). An icon is serialized once
+ * and not for every request of every client, windows of the same application with the same
+ * icon share one entry. The cost of an entry is its size in bytes.
+ **/
+using IconCache = QCache<QByteArray, QByteArray>;
+static const int s_iconCacheBudget = 8 * 1024 * 1024;
+Q_GLOBAL_STATIC_WITH_ARGS(IconCache, s_iconCache, (s_iconCacheBudget))
+
+/**
+ * The get_icon requests waiting for an icon that is being serialized, keyed like the icon cache,
+ * so that windows asking for the same icon at once don't serialize it each.
+ **/
+using PendingIcons = QHash<QByteArray, QVector<int>>;
+Q_GLOBAL_STATIC(PendingIcons, s_pendingIcons)
+
+static QByteArray iconCacheKey(const QIcon &icon)
+{
+    // themed icons are created anew for every window, but all of them share the name
+    if (!icon.name().isEmpty()) {
+        return QByteArrayLiteral("theme:") + icon.name().toUtf8();
+    }
+    return QByteArrayLiteral("icon:") + QByteArray::number(icon.cacheKey());
+}
+
+static void writeIcon(int fd, const QByteArray &data)
+{
+    QtConcurrent::run([fd, data] {
+        QFile file;
+        file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle);
+        file.write(data);
+        file.close();
+    });
+}
+
 class PlasmaWindowManagementInterfacePrivate : public QtWaylandServer::org_kde_plasma_window_management
 {
 public:
@@ -35,14 +79,32 @@ public:
     void sendStackingOrderChanged(wl_resource *resource);
     void sendStackingOrderUuidsChanged();
     void sendStackingOrderUuidsChanged(wl_resource *resource);
+    void encodeStackingOrderUuids();
+    PlasmaWindowManagementInterface::WindowProperties windowProperties(wl_client *client) const;
+
+    static PlasmaWindowManagementInterfacePrivate *get(PlasmaWindowManagementInterface *wm)
+    {
+        return wm->d.data();
+    }
 
     PlasmaWindowManagementInterface::ShowingDesktopState state = PlasmaWindowManagementInterface::ShowingDesktopState::Disabled;
     QList<PlasmaWindowInterface *> windows;
+    // indices into windows for the lookups of get_window and get_window_by_uuid
+    QHash<quint32, PlasmaWindowInterface *> windowsById;
+    QHash<QString, PlasmaWindowInterface *> windowsByUuid;
     QPointer<PlasmaVirtualDesktopManagementInterface> plasmaVirtualDesktopManagementInterface = nullptr;
     quint32 windowIdCounter = 0;
     QVector<quint32> stackingOrder;
     QVector<QString> stackingOrderUuids;
+    // the stacking order uuids as sent to the clients, encoded once per change
+    QByteArray encodedStackingOrderUuids;
+    // the window properties of the clients which don't want all of them
+    QHash<wl_client *, PlasmaWindowManagementInterface::WindowProperties> subscriptions;
     PlasmaWindowManagementInterface *q;
+    TimerWheel *timerWheel;
+    // the minimum time between two broadcasts of a title or a geometry change of a window
+    std::chrono::milliseconds titleRateLimit = std::chrono::milliseconds::zero();
+    std::chrono::milliseconds geometryRateLimit = std::chrono::milliseconds::zero();
 
 protected:
     void org_kde_plasma_window_management_bind_resource(Resource *resource) override;
@@ -57,11 +119,41 @@ public:
     PlasmaWindowInterfacePrivate(PlasmaWindowManagementInterface *wm, PlasmaWindowInterface *q);
     ~PlasmaWindowInterfacePrivate();
 
+    /**
+     * The properties which changed within an update, they are sent once the update ends.
+     **/
+    enum Change : quint32 {
+        TitleChange = 1 << 0,
+        AppIdChange = 1 << 1,
+        PidChange = 1 << 2,
+        ThemedIconNameChange = 1 << 3,
+        IconChange = 1 << 4,
+        StateChange = 1 << 5,
+        ParentWindowChange = 1 << 6,
+        GeometryChange = 1 << 7,
+        ApplicationMenuChange = 1 << 8,
+        VirtualDesktopsChange = 1 << 9,
+        ActivitiesChange = 1 << 10,
+    };
+
+    void beginUpdate();
+    void endUpdate();
+    void markChanged(Change change);
+    void sendChanges(quint32 allChanges);
+    quint32 rateLimit(quint32 changes);
+    void sendResourceChanges(const QHash<Resource *, quint32> &resourceChanges);
+    void sendDeferredChanges(wl_client *client);
+    void sendVirtualDesktopEntered(const QString &id);
+    void sendVirtualDesktopLeft(const QString &id);
+    void sendActivityEntered(const QString &id);
+    void sendActivityLeft(const QString &id);
+
     void setTitle(const QString &title);
     void setAppId(const QString &appId);
     void setPid(quint32 pid);
     void setThemedIconName(const QString &iconName);
     void setIcon(const QIcon &icon);
+    void serializeIcon();
     void unmap();
     void setState(org_kde_plasma_window_management_state flag, bool set);
     void setParentWindow(PlasmaWindowInterface *parent);
@@ -69,6 +161,7 @@ public:
     void setApplicationMenuPaths(const QString &service, const QString &object);
     void setWindowId(quint32 winid);
     wl_resource *resourceForParent(PlasmaWindowInterface *parent, Resource *child) const;
+    PlasmaWindowManagementInterface::WindowProperties subscribedProperties(Resource *resource) const;
 
     quint32 windowId = 0;
     QHash<SurfaceInterface *, QRect> minimizedGeometries;
@@ -88,11 +181,34 @@ public:
     QString m_appServiceName;
     QString m_appObjectPath;
     QIcon m_icon;
+    // the key of m_icon in the icon cache
+    QByteArray m_iconKey = iconCacheKey(QIcon());
     quint32 m_state = 0;
     QString uuid;
 
+    int updateDepth = 0;
+    quint32 pendingChanges = 0;
+    // the desktops and activities the clients know about while an update is running
+    QStringList sentVirtualDesktops;
+    QStringList sentActivities;
+    // the changes held back from the resources of congested clients
+    QHash<Resource *, quint32> deferredChanges;
+    QHash<wl_client *, QMetaObject::Connection> congestionReliefConnections;
+
+    /**
+     * A change which is broadcast at most once per interval. Changes within the interval are
+     * dropped, the timer sends the latest value once it passed.
+     **/
+    struct RateLimit {
+        TimerWheel::Timer timer;
+        std::chrono::steady_clock::time_point lastSent;
+    };
+    RateLimit titleRateLimit;
+    RateLimit geometryRateLimit;
+
 protected:
     void org_kde_plasma_window_bind_resource(Resource *resource) override;
+    void org_kde_plasma_window_destroy_resource(Resource *resource) override;
     void org_kde_plasma_window_set_state(Resource *resource, uint32_t flags, uint32_t state) override;
     void org_kde_plasma_window_set_virtual_desktop(Resource *resource, uint32_t number) override;
     void org_kde_plasma_window_set_minimized_geometry(Resource *resource, wl_resource *panel, uint32_t x, uint32_t y, uint32_t width, uint32_t height) override;
@@ -113,9 +229,15 @@ protected:
 PlasmaWindowManagementInterfacePrivate::PlasmaWindowManagementInterfacePrivate(PlasmaWindowManagementInterface *_q, Display *display)
     : QtWaylandServer::org_kde_plasma_window_management(*display, s_version)
     , q(_q)
+    , timerWheel(&DisplayPrivate::get(display)->timerWheel)
 {
 }
 
+PlasmaWindowManagementInterface::WindowProperties PlasmaWindowManagementInterfacePrivate::windowProperties(wl_client *client) const
+{
+    return subscriptions.value(client, PlasmaWindowManagementInterface::WindowProperty::All);
+}
+
 void PlasmaWindowManagementInterfacePrivate::sendShowingDesktopState()
 {
     const auto clientResources = resourceMap();
@@ -172,16 +294,23 @@ void PlasmaWindowManagementInterfacePrivate::sendStackingOrderUuidsChanged(wl_re
         return;
     }
 
-    QString uuids;
-    for (const auto &uuid : qAsConst(stackingOrderUuids)) {
-        uuids += uuid;
-        uuids += QLatin1Char(';');
+    org_kde_plasma_window_management_send_stacking_order_uuid_changed(r, encodedStackingOrderUuids.constData());
+}
+
+void PlasmaWindowManagementInterfacePrivate::encodeStackingOrderUuids()
+{
+    encodedStackingOrderUuids.clear();
+    if (stackingOrderUuids.isEmpty()) {
+        return;
     }
-    // Remove the trailing ';', on the receiving side this is interpreted as an empty uuid.
-    if (stackingOrderUuids.size() > 0) {
-        uuids.remove(uuids.length() - 1, 1);
+    // the uuids are separated by a ';', a trailing one would be interpreted as an empty uuid
+    encodedStackingOrderUuids.reserve(stackingOrderUuids.size() * (stackingOrderUuids.first().size() + 1));
+    for (const QString &uuid : qAsConst(stackingOrderUuids)) {
+        if (!encodedStackingOrderUuids.isEmpty()) {
+            encodedStackingOrderUuids += ';';
+        }
+        encodedStackingOrderUuids += uuid.toUtf8();
     }
-    send_stacking_order_uuid_changed(r, uuids);
 }
 
 void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_bind_resource(Resource *resource)
@@ -215,11 +344,9 @@ void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_sh
 
 void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_get_window(Resource *resource, uint32_t id, uint32_t internal_window_id)
 {
-    for (auto window : windows) {
-        if (window->d->windowId == internal_window_id) {
-            window->d->add(resource->client(), id, resource->version());
-            return;
-        }
+    if (PlasmaWindowInterface *window = windowsById.value(internal_window_id)) {
+        window->d->add(resource->client(), id, resource->version());
+        return;
     }
     // create a temp window just for the resource, bind then immediately delete it, sending an unmap event
     PlasmaWindowInterface window(q, q);
@@ -230,17 +357,15 @@ void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_ge
                                                                                                  uint32_t id,
                                                                                                  const QString &internal_window_uuid)
 {
-    auto it = std::find_if(windows.constBegin(), windows.constEnd(), [internal_window_uuid](PlasmaWindowInterface *window) {
-        return window->d->uuid == internal_window_uuid;
-    });
-    if (it == windows.constEnd()) {
+    PlasmaWindowInterface *window = windowsByUuid.value(internal_window_uuid);
+    if (!window) {
         qCWarning(KWAYLAND_SERVER) << "Could not find window with uuid" << internal_window_uuid;
         // create a temp window just for the resource, bind then immediately delete it, sending an unmap event
-        PlasmaWindowInterface window(q, q);
-        window.d->add(resource->client(), id, resource->version());
+        PlasmaWindowInterface temporaryWindow(q, q);
+        temporaryWindow.d->add(resource->client(), id, resource->version());
         return;
     }
-    (*it)->d->add(resource->client(), id, resource->version());
+    window->d->add(resource->client(), id, resource->version());
 }
 
 PlasmaWindowManagementInterface::PlasmaWindowManagementInterface(Display *display, QObject *parent)
@@ -276,8 +401,15 @@ PlasmaWindowInterface *PlasmaWindowManagementInterface::createWindow(QObject *pa
         }
     }
     d->windows << window;
-    connect(window, &QObject::destroyed, this, [this, window] {
-        d->windows.removeAll(window);
+    d->windowsById.insert(window->d->windowId, window);
+    d->windowsByUuid.insert(window->d->uuid, window);
+    // the private is already gone once destroyed is emitted
+    connect(window, &QObject::destroyed, this, [this, window, windowId = window->d->windowId, uuid = window->d->uuid] {
+        d->windows.removeOne(window);
+        d->windowsById.remove(windowId);
+        if (d->windowsByUuid.value(uuid) == window) {
+            d->windowsByUuid.remove(uuid);
+        }
     });
     return window;
 }
@@ -302,9 +434,53 @@ void PlasmaWindowManagementInterface::setStackingOrderUuids(const QVector<QStrin
         return;
     }
     d->stackingOrderUuids = stackingOrderUuids;
+    d->encodeStackingOrderUuids();
     d->sendStackingOrderUuidsChanged();
 }
 
+void PlasmaWindowManagementInterface::setSubscribedWindowProperties(ClientConnection *client, WindowProperties properties)
+{
+    wl_client *c = client->client();
+    if (!d->subscriptions.contains(c)) {
+        connect(client, &ClientConnection::disconnected, this, [this, c] {
+            d->subscriptions.remove(c);
+        });
+    }
+    d->subscriptions.insert(c, properties);
+}
+
+void PlasmaWindowManagementInterface::setRateLimit(WindowProperty property, std::chrono::milliseconds interval)
+{
+    switch (property) {
+    case WindowProperty::Title:
+        d->titleRateLimit = interval;
+        break;
+    case WindowProperty::Geometry:
+        d->geometryRateLimit = interval;
+        break;
+    default:
+        qCWarning(KWAYLAND_SERVER) << "Only the title and the geometry of windows can be rate limited";
+        break;
+    }
+}
+
+std::chrono::milliseconds PlasmaWindowManagementInterface::rateLimit(WindowProperty property) const
+{
+    switch (property) {
+    case WindowProperty::Title:
+        return d->titleRateLimit;
+    case WindowProperty::Geometry:
+        return d->geometryRateLimit;
+    default:
+        return std::chrono::milliseconds::zero();
+    }
+}
+
+PlasmaWindowManagementInterface::WindowProperties PlasmaWindowManagementInterface::subscribedWindowProperties(ClientConnection *client) const
+{
+    return d->windowProperties(client->client());
+}
+
 void PlasmaWindowManagementInterface::setPlasmaVirtualDesktopManagementInterface(PlasmaVirtualDesktopManagementInterface *manager)
 {
     if (d->plasmaVirtualDesktopManagementInterface == manager) {
@@ -336,40 +512,71 @@ void PlasmaWindowInterfacePrivate::org_kde_plasma_window_destroy(Resource *resou
     wl_resource_destroy(resource->handle);
 }
 
+void PlasmaWindowInterfacePrivate::org_kde_plasma_window_destroy_resource(Resource *resource)
+{
+    if (!deferredChanges.remove(resource)) {
+        return;
+    }
+    wl_client *client = resource->client();
+    for (auto it = deferredChanges.cbegin(); it != deferredChanges.cend(); ++it) {
+        if (it.key()->client() == client) {
+            return;
+        }
+    }
+    QObject::disconnect(congestionReliefConnections.take(client));
+}
+
+PlasmaWindowManagementInterface::WindowProperties PlasmaWindowInterfacePrivate::subscribedProperties(Resource *resource) const
+{
+    return PlasmaWindowManagementInterfacePrivate::get(wm)->windowProperties(resource->client());
+}
+
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_bind_resource(Resource *resource)
 {
-    for (const auto &desk : plasmaVirtualDesktops) {
-        send_virtual_desktop_entered(resource->handle, desk);
+    using Property = PlasmaWindowManagementInterface::WindowProperty;
+    const auto properties = subscribedProperties(resource);
+    if (properties & Property::VirtualDesktops) {
+        for (const auto &desk : plasmaVirtualDesktops) {
+            send_virtual_desktop_entered(resource->handle, desk);
+        }
     }
-    for (const auto &activity : plasmaActivities) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ACTIVITY_ENTERED_SINCE_VERSION) {
-            send_activity_entered(resource->handle, activity);
+    if (properties & Property::Activities) {
+        for (const auto &activity : plasmaActivities) {
+            if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ACTIVITY_ENTERED_SINCE_VERSION) {
+                send_activity_entered(resource->handle, activity);
+            }
         }
     }
-    if (!m_appId.isEmpty()) {
+    if (!m_appId.isEmpty() && (properties & Property::AppId)) {
         send_app_id_changed(resource->handle, m_appId);
     }
-    if (m_pid != 0) {
+    if (m_pid != 0 && (properties & Property::Pid)) {
         send_pid_changed(resource->handle, m_pid);
     }
-    if (!m_title.isEmpty()) {
+    if (!m_title.isEmpty() && (properties & Property::Title)) {
         send_title_changed(resource->handle, m_title);
     }
-    if (!m_appObjectPath.isEmpty() || !m_appServiceName.isEmpty()) {
+    if ((!m_appObjectPath.isEmpty() || !m_appServiceName.isEmpty()) && (properties & Property::ApplicationMenu)) {
         send_application_menu(resource->handle, m_appServiceName, m_appObjectPath);
     }
-    send_state_changed(resource->handle, m_state);
-    if (!m_themedIconName.isEmpty()) {
-        send_themed_icon_name_changed(resource->handle, m_themedIconName);
-    } else if (!m_icon.isNull()) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ICON_CHANGED_SINCE_VERSION) {
-            send_icon_changed(resource->handle);
+    if (properties & Property::State) {
+        send_state_changed(resource->handle, m_state);
+    }
+    if (properties & Property::Icon) {
+        if (!m_themedIconName.isEmpty()) {
+            send_themed_icon_name_changed(resource->handle, m_themedIconName);
+        } else if (!m_icon.isNull()) {
+            if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ICON_CHANGED_SINCE_VERSION) {
+                send_icon_changed(resource->handle);
+            }
         }
     }
 
-    send_parent_window(resource->handle, resourceForParent(parentWindow, resource));
+    if (properties & Property::ParentWindow) {
+        send_parent_window(resource->handle, resourceForParent(parentWindow, resource));
+    }
 
-    if (geometry.isValid() && resource->version() >= ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
+    if (geometry.isValid() && (properties & Property::Geometry) && resource->version() >= ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
         send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
     }
 
@@ -384,12 +591,8 @@ void PlasmaWindowInterfacePrivate::setAppId(const QString &appId)
         return;
     }
 
-    m_appId = appId;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_app_id_changed(resource->handle, m_appId);
-    }
+    m_appId = StringPool::intern(appId);
+    markChanged(AppIdChange);
 }
 
 void PlasmaWindowInterfacePrivate::setPid(quint32 pid)
@@ -398,20 +601,12 @@ void PlasmaWindowInterfacePrivate::setPid(quint32 pid)
         return;
     }
     m_pid = pid;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_pid_changed(resource->handle, pid);
-    }
+    markChanged(PidChange);
 }
 
 void PlasmaWindowInterfacePrivate::setWindowId(quint32 winid)
 {
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_window_id(resource->handle, winid);
-    }
+    broadcast_window_id(winid);
 }
 
 void PlasmaWindowInterfacePrivate::setThemedIconName(const QString &iconName)
@@ -419,39 +614,57 @@ void PlasmaWindowInterfacePrivate::setThemedIconName(const QString &iconName)
     if (m_themedIconName == iconName) {
         return;
     }
-    m_themedIconName = iconName;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_themed_icon_name_changed(resource->handle, m_themedIconName);
-    }
+    m_themedIconName = StringPool::intern(iconName);
+    markChanged(ThemedIconNameChange);
 }
 
 void PlasmaWindowInterfacePrivate::setIcon(const QIcon &icon)
 {
     m_icon = icon;
+    // requests made from now on are for the new icon, those in flight still get the old one
+    m_iconKey = iconCacheKey(m_icon);
     setThemedIconName(m_icon.name());
-
-    const auto clientResources = resourceMap();
-    for (auto resource : clientResources) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ICON_CHANGED_SINCE_VERSION) {
-            send_icon_changed(resource->handle);
-        }
-    }
+    markChanged(IconChange);
 }
 
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_get_icon(Resource *resource, int32_t fd)
 {
     Q_UNUSED(resource)
-    QtConcurrent::run(
-        [fd](const QIcon &icon) {
-            QFile file;
-            file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle);
-            QDataStream ds(&file);
+    if (const QByteArray *data = s_iconCache->object(m_iconKey)) {
+        writeIcon(fd, *data);
+        return;
+    }
+    auto pending = s_pendingIcons->find(m_iconKey);
+    if (pending != s_pendingIcons->end()) {
+        // the icon is already being serialized
+        pending->append(fd);
+        return;
+    }
+    s_pendingIcons->insert(m_iconKey, QVector<int>{fd});
+    serializeIcon();
+}
+
+void PlasmaWindowInterfacePrivate::serializeIcon()
+{
+    // not parented to the window, the pending requests have to be answered even if it goes away
+    auto watcher = new QFutureWatcher<QByteArray>();
+    QObject::connect(watcher, &QFutureWatcherBase::finished, [watcher, key = m_iconKey] {
+        watcher->deleteLater();
+        const QByteArray data = watcher->result();
+        s_iconCache->insert(key, new QByteArray(data), data.size());
+        const QVector<int> fds = s_pendingIcons->take(key);
+        for (int fd : fds) {
+            writeIcon(fd, data);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(
+        [](const QIcon &icon) {
+            QByteArray data;
+            QDataStream ds(&data, QIODevice::WriteOnly);
             ds << icon;
-            file.close();
+            return data;
         },
-        m_icon);
+        m_icon));
 }
 
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_request_enter_virtual_desktop(Resource *resource, const QString &id)
@@ -496,11 +709,7 @@ void PlasmaWindowInterfacePrivate::setTitle(const QString &title)
         return;
     }
     m_title = title;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_title_changed(resource->handle, m_title);
-    }
+    markChanged(TitleChange);
 }
 
 void PlasmaWindowInterfacePrivate::unmap()
@@ -509,11 +718,11 @@ void PlasmaWindowInterfacePrivate::unmap()
         return;
     }
     unmapped = true;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_unmapped(resource->handle);
-    }
+    // nothing of a pending update matters to the clients anymore
+    pendingChanges = 0;
+    titleRateLimit.timer.stop();
+    geometryRateLimit.timer.stop();
+    broadcast_unmapped();
 }
 
 void PlasmaWindowInterfacePrivate::setState(org_kde_plasma_window_management_state flag, bool set)
@@ -528,11 +737,7 @@ void PlasmaWindowInterfacePrivate::setState(org_kde_plasma_window_management_sta
         return;
     }
     m_state = newState;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_state_changed(resource->handle, m_state);
-    }
+    markChanged(StateChange);
 }
 
 wl_resource *PlasmaWindowInterfacePrivate::resourceForParent(PlasmaWindowInterface *parent, Resource *child) const
@@ -563,16 +768,10 @@ void PlasmaWindowInterfacePrivate::setParentWindow(PlasmaWindowInterface *window
         parentWindowDestroyConnection = QObject::connect(window, &QObject::destroyed, q, [this] {
             parentWindow = nullptr;
             parentWindowDestroyConnection = QMetaObject::Connection();
-            const auto clientResources = resourceMap();
-            for (auto resource : clientResources) {
-                send_parent_window(resource->handle, nullptr);
-            }
+            markChanged(ParentWindowChange);
         });
     }
-    const auto clientResources = resourceMap();
-    for (auto resource : clientResources) {
-        send_parent_window(resource->handle, resourceForParent(window, resource));
-    }
+    markChanged(ParentWindowChange);
 }
 
 void PlasmaWindowInterfacePrivate::setGeometry(const QRect &geo)
@@ -584,29 +783,297 @@ void PlasmaWindowInterfacePrivate::setGeometry(const QRect &geo)
     if (!geometry.isValid()) {
         return;
     }
+    markChanged(GeometryChange);
+}
+
+void PlasmaWindowInterfacePrivate::setApplicationMenuPaths(const QString &service, const QString &object)
+{
+    if (m_appServiceName == service && m_appObjectPath == object) {
+        return;
+    }
+    m_appServiceName = StringPool::intern(service);
+    m_appObjectPath = StringPool::intern(object);
+    markChanged(ApplicationMenuChange);
+}
+
+void PlasmaWindowInterfacePrivate::beginUpdate()
+{
+    if (updateDepth++ == 0) {
+        sentVirtualDesktops = plasmaVirtualDesktops;
+        sentActivities = plasmaActivities;
+    }
+}
 
+void PlasmaWindowInterfacePrivate::endUpdate()
+{
+    Q_ASSERT(updateDepth > 0);
+    if (--updateDepth > 0) {
+        return;
+    }
+    const quint32 changes = pendingChanges;
+    pendingChanges = 0;
+    if (changes) {
+        sendChanges(changes);
+    }
+    sentVirtualDesktops.clear();
+    sentActivities.clear();
+}
+
+void PlasmaWindowInterfacePrivate::markChanged(Change change)
+{
+    if (updateDepth > 0) {
+        pendingChanges |= change;
+        return;
+    }
+    sendChanges(change);
+}
+
+quint32 PlasmaWindowInterfacePrivate::rateLimit(quint32 changes)
+{
+    PlasmaWindowManagementInterfacePrivate *wmPrivate = PlasmaWindowManagementInterfacePrivate::get(wm);
+    const auto now = std::chrono::steady_clock::now();
+    const auto limit = [this, wmPrivate, now, &changes](Change change, RateLimit &rateLimit, std::chrono::milliseconds interval) {
+        if (!(changes & change) || interval <= std::chrono::milliseconds::zero()) {
+            return;
+        }
+        if (!rateLimit.timer.isActive()) {
+            const auto elapsed = now - rateLimit.lastSent;
+            if (elapsed >= interval) {
+                rateLimit.lastSent = now;
+                return;
+            }
+            rateLimit.timer.setCallback([this, change, &rateLimit] {
+                rateLimit.lastSent = std::chrono::steady_clock::time_point();
+                markChanged(change);
+            });
+            rateLimit.timer.start(wmPrivate->timerWheel, std::chrono::ceil<std::chrono::milliseconds>(interval - elapsed));
+        }
+        changes &= ~change;
+    };
+    limit(TitleChange, titleRateLimit, wmPrivate->titleRateLimit);
+    limit(GeometryChange, geometryRateLimit, wmPrivate->geometryRateLimit);
+    return changes;
+}
+
+void PlasmaWindowInterfacePrivate::sendChanges(quint32 allChanges)
+{
+    allChanges = rateLimit(allChanges);
+    if (!allChanges) {
+        return;
+    }
+
+    // the changes each of the properties subscribed to by a client stands for
+    using Property = PlasmaWindowManagementInterface::WindowProperty;
+    static const QVector<QPair<Property, quint32>> propertyChanges = {
+        {Property::Title, TitleChange},
+        {Property::AppId, AppIdChange},
+        {Property::Pid, PidChange},
+        {Property::Icon, ThemedIconNameChange | IconChange},
+        {Property::State, StateChange},
+        {Property::ParentWindow, ParentWindowChange},
+        {Property::Geometry, GeometryChange},
+        {Property::ApplicationMenu, ApplicationMenuChange},
+        {Property::VirtualDesktops, VirtualDesktopsChange},
+        {Property::Activities, ActivitiesChange},
+    };
+    // entering and leaving desktops and activities are no state that can be sent later on
+    static const quint32 deferrableChanges = ~quint32(VirtualDesktopsChange | ActivitiesChange);
+
+    // the changes of interest to each resource
+    QHash<Resource *, quint32> resourceChanges;
     const auto clientResources = resourceMap();
     for (auto resource : clientResources) {
-        if (resource->version() < ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
-            continue;
+        const auto properties = subscribedProperties(resource);
+        quint32 changes = allChanges;
+        if (!properties.testFlag(Property::All)) {
+            for (const auto &propertyChange : propertyChanges) {
+                if (!(properties & propertyChange.first)) {
+                    changes &= ~propertyChange.second;
+                }
+            }
         }
-        send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
+        ClientConnection *connection = ClientConnectionPrivate::get(resource->client());
+        if ((changes & deferrableChanges) && connection && connection->isCongested()) {
+            // only the latest state is sent once the client reads its events again
+            deferredChanges[resource] |= changes & deferrableChanges;
+            changes &= ~deferrableChanges;
+            wl_client *client = resource->client();
+            if (!congestionReliefConnections.contains(client)) {
+                congestionReliefConnections.insert(client, QObject::connect(connection, &ClientConnection::congestionRelieved, q, [this, client] {
+                    sendDeferredChanges(client);
+                }));
+            }
+        }
+        if (changes) {
+            resourceChanges.insert(resource, changes);
+        }
+    }
+    if (!resourceChanges.isEmpty()) {
+        sendResourceChanges(resourceChanges);
     }
 }
 
-void PlasmaWindowInterfacePrivate::setApplicationMenuPaths(const QString &service, const QString &object)
+void PlasmaWindowInterfacePrivate::sendDeferredChanges(wl_client *client)
 {
-    if (m_appServiceName == service && m_appObjectPath == object) {
+    QObject::disconnect(congestionReliefConnections.take(client));
+    QHash<Resource *, quint32> resourceChanges;
+    for (auto it = deferredChanges.begin(); it != deferredChanges.end();) {
+        if (it.key()->client() == client) {
+            resourceChanges.insert(it.key(), it.value());
+            it = deferredChanges.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!resourceChanges.isEmpty()) {
+        sendResourceChanges(resourceChanges);
+    }
+}
+
+void PlasmaWindowInterfacePrivate::sendResourceChanges(const QHash<Resource *, quint32> &resourceChanges)
+{
+    quint32 allChanges = 0;
+    for (quint32 changes : resourceChanges) {
+        allChanges |= changes;
+    }
+
+    // desktops and activities are only batched within an update, otherwise they are sent directly
+    QStringList leftDesktops;
+    QStringList enteredDesktops;
+    if (allChanges & VirtualDesktopsChange) {
+        for (const QString &id : qAsConst(sentVirtualDesktops)) {
+            if (!plasmaVirtualDesktops.contains(id)) {
+                leftDesktops << id;
+            }
+        }
+        for (const QString &id : qAsConst(plasmaVirtualDesktops)) {
+            if (!sentVirtualDesktops.contains(id)) {
+                enteredDesktops << id;
+            }
+        }
+    }
+    QStringList leftActivities;
+    QStringList enteredActivities;
+    if (allChanges & ActivitiesChange) {
+        for (const QString &id : qAsConst(sentActivities)) {
+            if (!plasmaActivities.contains(id)) {
+                leftActivities << id;
+            }
+        }
+        for (const QString &id : qAsConst(plasmaActivities)) {
+            if (!sentActivities.contains(id)) {
+                enteredActivities << id;
+            }
+        }
+    }
+
+    // every string is encoded once for all the resources interested in it
+    const auto subscribed = [&resourceChanges](quint32 change) {
+        return [&resourceChanges, change](Resource *resource) {
+            return (resourceChanges.value(resource) & change) != 0;
+        };
+    };
+    for (const QString &id : qAsConst(leftDesktops)) {
+        broadcast_virtual_desktop_left(subscribed(VirtualDesktopsChange), id);
+    }
+    for (const QString &id : qAsConst(enteredDesktops)) {
+        broadcast_virtual_desktop_entered(subscribed(VirtualDesktopsChange), id);
+    }
+    for (const QString &id : qAsConst(leftActivities)) {
+        broadcast_activity_left(subscribed(ActivitiesChange), id);
+    }
+    for (const QString &id : qAsConst(enteredActivities)) {
+        broadcast_activity_entered(subscribed(ActivitiesChange), id);
+    }
+    if (allChanges & AppIdChange) {
+        broadcast_app_id_changed(subscribed(AppIdChange), m_appId);
+    }
+    if (allChanges & PidChange) {
+        broadcast_pid_changed(subscribed(PidChange), m_pid);
+    }
+    if (allChanges & TitleChange) {
+        broadcast_title_changed(subscribed(TitleChange), m_title);
+    }
+    if (allChanges & ApplicationMenuChange) {
+        broadcast_application_menu(subscribed(ApplicationMenuChange), m_appServiceName, m_appObjectPath);
+    }
+    if (allChanges & StateChange) {
+        broadcast_state_changed(subscribed(StateChange), m_state);
+    }
+    if (allChanges & ThemedIconNameChange) {
+        broadcast_themed_icon_name_changed(subscribed(ThemedIconNameChange), m_themedIconName);
+    }
+    if (allChanges & IconChange) {
+        broadcast_icon_changed(subscribed(IconChange));
+    }
+    if (allChanges & ParentWindowChange) {
+        // the parent is a different object for each client
+        for (auto it = resourceChanges.cbegin(); it != resourceChanges.cend(); ++it) {
+            if (it.value() & ParentWindowChange) {
+                send_parent_window(it.key()->handle, resourceForParent(parentWindow, it.key()));
+            }
+        }
+    }
+    if ((allChanges & GeometryChange) && geometry.isValid()) {
+        broadcast_geometry(subscribed(GeometryChange), geometry.x(), geometry.y(), geometry.width(), geometry.height());
+    }
+}
+
+void PlasmaWindowInterfacePrivate::sendVirtualDesktopEntered(const QString &id)
+{
+    if (updateDepth > 0) {
+        pendingChanges |= VirtualDesktopsChange;
         return;
     }
-    m_appServiceName = service;
-    m_appObjectPath = object;
     const auto clientResources = resourceMap();
     for (auto resource : clientResources) {
-        if (resource->version() < ORG_KDE_PLASMA_WINDOW_APPLICATION_MENU_SINCE_VERSION) {
-            continue;
+        if (subscribedProperties(resource) & PlasmaWindowManagementInterface::WindowProperty::VirtualDesktops) {
+            send_virtual_desktop_entered(resource->handle, id);
+        }
+    }
+}
+
+void PlasmaWindowInterfacePrivate::sendVirtualDesktopLeft(const QString &id)
+{
+    if (updateDepth > 0) {
+        pendingChanges |= VirtualDesktopsChange;
+        return;
+    }
+    const auto clientResources = resourceMap();
+    for (auto resource : clientResources) {
+        if (subscribedProperties(resource) & PlasmaWindowManagementInterface::WindowProperty::VirtualDesktops) {
+            send_virtual_desktop_left(resource->handle, id);
+        }
+    }
+}
+
+void PlasmaWindowInterfacePrivate::sendActivityEntered(const QString &id)
+{
+    if (updateDepth > 0) {
+        pendingChanges |= ActivitiesChange;
+        return;
+    }
+    const auto clientResources = resourceMap();
+    for (auto resource : clientResources) {
+        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ACTIVITY_ENTERED_SINCE_VERSION
+            && (subscribedProperties(resource) & PlasmaWindowManagementInterface::WindowProperty::Activities)) {
+            send_activity_entered(resource->handle, id);
+        }
+    }
+}
+
+void PlasmaWindowInterfacePrivate::sendActivityLeft(const QString &id)
+{
+    if (updateDepth > 0) {
+        pendingChanges |= ActivitiesChange;
+        return;
+    }
+    const auto clientResources = resourceMap();
+    for (auto resource : clientResources) {
+        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ACTIVITY_LEFT_SINCE_VERSION
+            && (subscribedProperties(resource) & PlasmaWindowManagementInterface::WindowProperty::Activities)) {
+            send_activity_left(resource->handle, id);
         }
-        send_application_menu(resource->handle, service, object);
     }
 }
 
@@ -765,6 +1232,16 @@ void PlasmaWindowInterface::unmap()
     d->unmap();
 }
 
+void PlasmaWindowInterface::beginUpdate()
+{
+    d->beginUpdate();
+}
+
+void PlasmaWindowInterface::endUpdate()
+{
+    d->endUpdate();
+}
+
 QHash<SurfaceInterface *, QRect> PlasmaWindowInterface::minimizedGeometries() const
 {
     return d->minimizedGeometries;
@@ -808,19 +1285,17 @@ void PlasmaWindowInterface::setOnAllDesktops(bool set)
     if (!d->wm->plasmaVirtualDesktopManagementInterface()) {
         return;
     }
-    const auto clientResources = d->resourceMap();
     // the current vd management
     if (set) {
         if (d->plasmaVirtualDesktops.isEmpty()) {
             return;
         }
         // leaving everything means on all desktops
-        for (auto desk : plasmaVirtualDesktops()) {
-            for (auto resource : clientResources) {
-                d->send_virtual_desktop_left(resource->handle, desk);
-            }
-        }
+        const QStringList desktops = d->plasmaVirtualDesktops;
         d->plasmaVirtualDesktops.clear();
+        for (const QString &desk : desktops) {
+            d->sendVirtualDesktopLeft(desk);
+        }
     } else {
         if (!d->plasmaVirtualDesktops.isEmpty()) {
             return;
@@ -829,9 +1304,7 @@ void PlasmaWindowInterface::setOnAllDesktops(bool set)
         for (auto desk : d->wm->plasmaVirtualDesktopManagementInterface()->desktops()) {
             if (desk->isActive() && !d->plasmaVirtualDesktops.contains(desk->id())) {
                 d->plasmaVirtualDesktops << desk->id();
-                for (auto resource : clientResources) {
-                    d->send_virtual_desktop_entered(resource->handle, desk->id());
-                }
+                d->sendVirtualDesktopEntered(desk->id());
             }
         }
     }
@@ -897,10 +1370,7 @@ void PlasmaWindowInterface::addPlasmaVirtualDesktop(const QString &id)
         removePlasmaVirtualDesktop(id);
     });
 
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        d->send_virtual_desktop_entered(resource->handle, id);
-    }
+    d->sendVirtualDesktopEntered(id);
 }
 
 void PlasmaWindowInterface::removePlasmaVirtualDesktop(const QString &id)
@@ -910,10 +1380,7 @@ void PlasmaWindowInterface::removePlasmaVirtualDesktop(const QString &id)
     }
 
     d->plasmaVirtualDesktops.removeAll(id);
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        d->send_virtual_desktop_left(resource->handle, id);
-    }
+    d->sendVirtualDesktopLeft(id);
 
     // we went on all desktops
     if (d->plasmaVirtualDesktops.isEmpty()) {
@@ -921,6 +1388,26 @@ void PlasmaWindowInterface::removePlasmaVirtualDesktop(const QString &id)
     }
 }
 
+void PlasmaWindowInterface::setPlasmaVirtualDesktops(const QStringList &ids)
+{
+    if (ids.isEmpty()) {
+        setOnAllDesktops(true);
+        return;
+    }
+    beginUpdate();
+    // entering first, so the window doesn't end up on all desktops in between
+    for (const QString &id : ids) {
+        addPlasmaVirtualDesktop(id);
+    }
+    const QStringList desktops = d->plasmaVirtualDesktops;
+    for (const QString &id : desktops) {
+        if (!ids.contains(id)) {
+            removePlasmaVirtualDesktop(id);
+        }
+    }
+    endUpdate();
+}
+
 QStringList PlasmaWindowInterface::plasmaVirtualDesktops() const
 {
     return d->plasmaVirtualDesktops;
@@ -933,13 +1420,7 @@ void PlasmaWindowInterface::addPlasmaActivity(const QString &id)
     }
 
     d->plasmaActivities << id;
-
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ACTIVITY_ENTERED_SINCE_VERSION) {
-            d->send_activity_entered(resource->handle, id);
-        }
-    }
+    d->sendActivityEntered(id);
 }
 
 void PlasmaWindowInterface::removePlasmaActivity(const QString &id)
@@ -947,13 +1428,7 @@ void PlasmaWindowInterface::removePlasmaActivity(const QString &id)
     if (!d->plasmaActivities.removeOne(id)) {
         return;
     }
-
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ACTIVITY_LEFT_SINCE_VERSION) {
-            d->send_activity_left(resource->handle, id);
-        }
-    }
+    d->sendActivityLeft(id);
 }
 
 QStringList PlasmaWindowInterface::plasmaActivities() const
@@ -7,12 +7,15 @@
 
 #include <QObject>
 
+#include <chrono>
+
 #include <DWayland/Server/kwaylandserver_export.h>
 
 class QSize;
 
 namespace KWaylandServer
 {
+class ClientConnection;
 class Display;
 class OutputInterface;
 class PlasmaWindowActivationFeedbackInterfacePrivate;
@@ -92,10 +95,61 @@ public:
 
     void setStackingOrderUuids(const QVector<QString> &stackingOrderUuids);
 
+    /**
+     * The properties of a PlasmaWindowInterface which get sent to a client.
+     * @see setSubscribedWindowProperties
+     */
+    enum class WindowProperty {
+        Title = 1 << 0,
+        AppId = 1 << 1,
+        Pid = 1 << 2,
+        Icon = 1 << 3,
+        State = 1 << 4,
+        ParentWindow = 1 << 5,
+        Geometry = 1 << 6,
+        ApplicationMenu = 1 << 7,
+        VirtualDesktops = 1 << 8,
+        Activities = 1 << 9,
+        All = (1 << 10) - 1,
+    };
+    Q_DECLARE_FLAGS(WindowProperties, WindowProperty)
+
+    /**
+     * Restricts the window properties sent to @p client to @p properties. Everything else is
+     * neither sent when the client gets a window nor when it changes, e.g. a pager might only
+     * need the geometry and the state of the windows. By default a client gets all properties.
+     *
+     * The subscription should be set before the client binds the windows, it does not send
+     * the properties a client subscribes to later on until they change.
+     */
+    void setSubscribedWindowProperties(ClientConnection *client, WindowProperties properties);
+    /**
+     * @returns The window properties sent to @p client.
+     */
+    WindowProperties subscribedWindowProperties(ClientConnection *client) const;
+
+    /**
+     * Limits the broadcasts of the changes of @p property of all windows to one per @p interval,
+     * e.g. for terminals updating their title with the progress of a command many times per
+     * second, or for the geometry during an interactive move. The first change is sent right
+     * away, later changes within the interval are merged and the latest value is sent once the
+     * interval passed, so the clients always end up with the final value.
+     *
+     * Only WindowProperty::Title and WindowProperty::Geometry can be limited. An interval of
+     * zero, the default, sends every change right away.
+     */
+    void setRateLimit(WindowProperty property, std::chrono::milliseconds interval);
+    /**
+     * @returns the minimum time between two broadcasts of changes of @p property
+     * @see setRateLimit
+     */
+    std::chrono::milliseconds rateLimit(WindowProperty property) const;
+
 Q_SIGNALS:
     void requestChangeShowingDesktop(ShowingDesktopState requestedState);
 
 private:
+    friend class PlasmaWindowManagementInterfacePrivate;
     QScopedPointer<PlasmaWindowManagementInterfacePrivate> d;
 };
 
@@ -143,6 +197,22 @@ public:
      */
     void unmap();
 
+    /**
+     * Starts an update of several properties at once, e.g. the geometry, state and virtual
+     * desktops of a window that gets maximized.
+     *
+     * Until the matching endUpdate() changed properties are not sent to the clients. Afterwards
+     * every property that changed is sent once with its final value, all of them in one burst.
+     * Updates can be nested, the changes are sent when the outermost update ends.
+     *
+     * @see endUpdate
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate() and sends the changed properties.
+     */
+    void endUpdate();
+
     /**
      * @returns Geometries of the taskbar entries, indicized by the
      *          surface of the panels
@@ -187,6 +257,14 @@ public:
      */
     void removePlasmaVirtualDesktop(const QString &id);
 
+    /**
+     * Replaces the virtual desktops of the window with @p ids, an empty list puts it on all
+     * desktops. Unlike several calls to addPlasmaVirtualDesktop and removePlasmaVirtualDesktop
+     * the clients only get the desktops the window actually entered or left, together in one
+     * burst.
+     */
+    void setPlasmaVirtualDesktops(const QStringList &ids);
+
     /**
      * The ids of all the desktops currently associated with this window.
      * When a desktop is deleted it will be automatically removed from this list
@@ -300,4 +378,5 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::PlasmaWindowManagementInterface::WindowProperties)
 Q_DECLARE_METATYPE(KWaylandServer::PlasmaWindowManagementInterface::ShowingDesktopState)
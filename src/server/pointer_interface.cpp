@@ -20,6 +20,12 @@
 
 namespace KWaylandServer
 {
+// the pointers getting the frame event get the other events added along with it, too
+static constexpr int s_framedVersion = PointerInterfacePrivate::since_frame;
+static_assert(PointerInterfacePrivate::since_axis_source == s_framedVersion && PointerInterfacePrivate::since_axis_stop == s_framedVersion
+                  && PointerInterfacePrivate::since_axis_discrete == s_framedVersion,
+              "the axis events have to be sent to the same pointers as the frame event");
+
 class CursorPrivate
 {
 public:
@@ -30,8 +36,9 @@ public:
     quint32 enteredSerial = 0;
     QPoint hotspot;
     QPointer<SurfaceInterface> surface;
+    QByteArray shape;
 
-    void update(SurfaceInterface *surface, quint32 serial, const QPoint &hotspot);
+    void update(SurfaceInterface *surface, quint32 serial, const QPoint &hotspot, const QByteArray &shape);
 };
 
 PointerInterfacePrivate *PointerInterfacePrivate::get(PointerInterface *pointer)
@@ -55,7 +62,17 @@ PointerInterfacePrivate::~PointerInterfacePrivate()
 
 QList<PointerInterfacePrivate::Resource *> PointerInterfacePrivate::pointersForClient(ClientConnection *client) const
 {
-    return resourceMap().values(client->client());
+    return clientResources.resources(client->client());
+}
+
+QList<PointerInterfacePrivate::Resource *> PointerInterfacePrivate::framedPointersForClient(ClientConnection *client) const
+{
+    return framedResources.resources(client->client());
+}
+
+QList<PointerInterfacePrivate::Resource *> PointerInterfacePrivate::legacyPointersForClient(ClientConnection *client) const
+{
+    return legacyResources.resources(client->client());
 }
 
 void PointerInterfacePrivate::pointer_set_cursor(Resource *resource, uint32_t serial, ::wl_resource *surface_resource, int32_t hotspot_x, int32_t hotspot_y)
@@ -84,13 +101,18 @@ void PointerInterfacePrivate::pointer_set_cursor(Resource *resource, uint32_t se
         }
     }
 
+    updateCursor(surface, serial, QPoint(hotspot_x, hotspot_y));
+}
+
+void PointerInterfacePrivate::updateCursor(SurfaceInterface *surface, quint32 serial, const QPoint &hotspot, const QByteArray &shape)
+{
     if (!cursor) { // TODO: Assign the cursor surface role.
         cursor = new Cursor(q);
-        cursor->d->update(surface, serial, QPoint(hotspot_x, hotspot_y));
+        cursor->d->update(surface, serial, hotspot, shape);
         QObject::connect(cursor, &Cursor::changed, q, &PointerInterface::cursorChanged);
         Q_EMIT q->cursorChanged();
     } else {
-        cursor->d->update(surface, serial, QPoint(hotspot_x, hotspot_y));
+        cursor->d->update(surface, serial, hotspot, shape);
     }
 }
 
@@ -101,17 +123,34 @@ void PointerInterfacePrivate::pointer_release(Resource *resource)
 
 void PointerInterfacePrivate::pointer_bind_resource(Resource *resource)
 {
+    clientResources.add(resource);
+    if (resource->version() >= s_framedVersion) {
+        framedResources.add(resource);
+    } else {
+        legacyResources.add(resource);
+    }
+
     const ClientConnection *focusedClient = focusedSurface ? focusedSurface->client() : nullptr;
 
     if (focusedClient && focusedClient->client() == resource->client()) {
         const quint32 serial = seat->display()->nextSerial();
         send_enter(resource->handle, serial, focusedSurface->resource(), wl_fixed_from_double(lastPosition.x()), wl_fixed_from_double(lastPosition.y()));
-        if (resource->version() >= WL_POINTER_FRAME_SINCE_VERSION) {
+        if (resource->version() >= s_framedVersion) {
             send_frame(resource->handle);
         }
     }
 }
 
+void PointerInterfacePrivate::pointer_destroy_resource(Resource *resource)
+{
+    clientResources.remove(resource);
+    if (resource->version() >= s_framedVersion) {
+        framedResources.remove(resource);
+    } else {
+        legacyResources.remove(resource);
+    }
+}
+
 void PointerInterfacePrivate::sendLeave(quint32 serial)
 {
     const QList<Resource *> pointerResources = pointersForClient(focusedSurface->client());
@@ -128,13 +167,58 @@ void PointerInterfacePrivate::sendEnter(const QPointF &position, quint32 serial)
     }
 }
 
+template<int version>
+void PointerInterfacePrivate::sendAxis(const QList<Resource *> &resources, uint32_t wlOrientation, qreal delta, qint32 discreteDelta, PointerAxisSource source)
+{
+    if (resources.isEmpty()) {
+        return;
+    }
+
+    const quint32 timestamp = seat->timestamp();
+    const wl_fixed_t wlDelta = wl_fixed_from_double(delta);
+
+    axis_source wlSource = axis_source_wheel;
+    switch (source) {
+    case PointerAxisSource::Unknown:
+        break;
+    case PointerAxisSource::Wheel:
+        wlSource = axis_source_wheel;
+        break;
+    case PointerAxisSource::Finger:
+        wlSource = axis_source_finger;
+        break;
+    case PointerAxisSource::Continuous:
+        wlSource = axis_source_continuous;
+        break;
+    case PointerAxisSource::WheelTilt:
+        wlSource = axis_source_wheel_tilt;
+        break;
+    default:
+        Q_UNREACHABLE();
+        break;
+    }
+
+    // the events older pointers lack are dropped at compile time
+    for (Resource *resource : resources) {
+        if (source != PointerAxisSource::Unknown) {
+            send_versioned_axis_source<version>(resource->handle, wlSource);
+        }
+        if (delta != 0.0) {
+            if (discreteDelta) {
+                send_versioned_axis_discrete<version>(resource->handle, wlOrientation, discreteDelta);
+            }
+            send_versioned_axis<version>(resource->handle, timestamp, wlOrientation, wlDelta);
+        } else {
+            send_versioned_axis_stop<version>(resource->handle, timestamp, wlOrientation);
+        }
+    }
+}
+
 void PointerInterfacePrivate::sendFrame()
 {
-    const QList<Resource *> pointerResources = pointersForClient(focusedSurface->client());
+    const QList<Resource *> pointerResources = framedPointersForClient(focusedSurface->client());
     for (Resource *resource : pointerResources) {
-        if (resource->version() >= WL_POINTER_FRAME_SINCE_VERSION) {
-            send_frame(resource->handle);
-        }
+        send_frame(resource->handle);
     }
 }
 
@@ -201,44 +285,12 @@ void PointerInterface::sendAxis(Qt::Orientation orientation, qreal delta, qint32
         return;
     }
 
-    const auto pointerResources = d->pointersForClient(d->focusedSurface->client());
-    for (PointerInterfacePrivate::Resource *resource : pointerResources) {
-        const quint32 version = resource->version();
-
-        const auto wlOrientation =
-            (orientation == Qt::Vertical) ? PointerInterfacePrivate::axis_vertical_scroll : PointerInterfacePrivate::axis_horizontal_scroll;
-
-        if (source != PointerAxisSource::Unknown && version >= WL_POINTER_AXIS_SOURCE_SINCE_VERSION) {
-            PointerInterfacePrivate::axis_source wlSource;
-            switch (source) {
-            case PointerAxisSource::Wheel:
-                wlSource = PointerInterfacePrivate::axis_source_wheel;
-                break;
-            case PointerAxisSource::Finger:
-                wlSource = PointerInterfacePrivate::axis_source_finger;
-                break;
-            case PointerAxisSource::Continuous:
-                wlSource = PointerInterfacePrivate::axis_source_continuous;
-                break;
-            case PointerAxisSource::WheelTilt:
-                wlSource = PointerInterfacePrivate::axis_source_wheel_tilt;
-                break;
-            default:
-                Q_UNREACHABLE();
-                break;
-            }
-            d->send_axis_source(resource->handle, wlSource);
-        }
+    const auto wlOrientation =
+        (orientation == Qt::Vertical) ? PointerInterfacePrivate::axis_vertical_scroll : PointerInterfacePrivate::axis_horizontal_scroll;
 
-        if (delta != 0.0) {
-            if (discreteDelta && version >= WL_POINTER_AXIS_DISCRETE_SINCE_VERSION) {
-                d->send_axis_discrete(resource->handle, wlOrientation, discreteDelta);
-            }
-            d->send_axis(resource->handle, d->seat->timestamp(), wlOrientation, wl_fixed_from_double(delta));
-        } else if (version >= WL_POINTER_AXIS_STOP_SINCE_VERSION) {
-            d->send_axis_stop(resource->handle, d->seat->timestamp(), wlOrientation);
-        }
-    }
+    ClientConnection *client = d->focusedSurface->client();
+    d->sendAxis<s_framedVersion>(d->framedPointersForClient(client), wlOrientation, delta, discreteDelta, source);
+    d->sendAxis<1>(d->legacyPointersForClient(client), wlOrientation, delta, discreteDelta, source);
 }
 
 void PointerInterface::sendMotion(const QPointF &position)
@@ -286,7 +338,7 @@ CursorPrivate::CursorPrivate(Cursor *q, PointerInterface *pointer)
 {
 }
 
-void CursorPrivate::update(SurfaceInterface *s, quint32 serial, const QPoint &p)
+void CursorPrivate::update(SurfaceInterface *s, quint32 serial, const QPoint &p, const QByteArray &name)
 {
     bool emitChanged = false;
     if (enteredSerial != serial) {
@@ -310,6 +362,11 @@ void CursorPrivate::update(SurfaceInterface *s, quint32 serial, const QPoint &p)
         emitChanged = true;
         Q_EMIT q->surfaceChanged();
     }
+    if (shape != name) {
+        shape = name;
+        emitChanged = true;
+        Q_EMIT q->shapeChanged();
+    }
     if (emitChanged) {
         Q_EMIT q->changed();
     }
@@ -345,4 +402,9 @@ SurfaceInterface *Cursor::surface() const
     return d->surface;
 }
 
+QByteArray Cursor::shape() const
+{
+    return d->shape;
+}
+
 } // namespace KWaylandServer
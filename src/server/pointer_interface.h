@@ -108,11 +108,18 @@ public:
      * The SurfaceInterface for the image content of the Cursor.
      */
     SurfaceInterface *surface() const;
+    /**
+     * The name of the cursor shape set with the cursor shape protocol, e.g. "default" or
+     * "text". The shape is empty if the cursor is a surface; the compositor renders
+     * shapes from its own cursor theme.
+     */
+    QByteArray shape() const;
 
 Q_SIGNALS:
     void hotspotChanged();
     void enteredSerialChanged();
     void surfaceChanged();
+    void shapeChanged();
     void changed();
 
 private:
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "pointer_interface.h"
+#include "utils_p.h"
 
 #include <QPointF>
 #include <QPointer>
@@ -32,6 +33,16 @@ public:
     ~PointerInterfacePrivate() override;
 
     QList<Resource *> pointersForClient(ClientConnection *client) const;
+    /**
+     * The pointers of the @p client of version 5 and newer, which get the frame and the axis
+     * source, stop and discrete events. The pointers are grouped by version when they are
+     * bound, so these events need no version check per resource and event, see sendAxis().
+     */
+    QList<Resource *> framedPointersForClient(ClientConnection *client) const;
+    /**
+     * The pointers of the @p client older than version 5.
+     */
+    QList<Resource *> legacyPointersForClient(ClientConnection *client) const;
 
     PointerInterface *q;
     SeatInterface *seat;
@@ -43,15 +54,26 @@ public:
     QScopedPointer<PointerPinchGestureV1Interface> pinchGesturesV1;
     QScopedPointer<PointerHoldGestureV1Interface> holdGesturesV1;
     QPointF lastPosition;
+    ClientResources<Resource> clientResources;
+    ClientResources<Resource> framedResources;
+    ClientResources<Resource> legacyResources;
 
+    void updateCursor(SurfaceInterface *surface, quint32 serial, const QPoint &hotspot, const QByteArray &shape = QByteArray());
     void sendLeave(quint32 serial);
     void sendEnter(const QPointF &parentSurfacePosition, quint32 serial);
     void sendFrame();
+    /**
+     * Sends an axis event to @p resources, which are at least of the given @c version. The
+     * events added after @c version are left out at compile time.
+     */
+    template<int version>
+    void sendAxis(const QList<Resource *> &resources, uint32_t wlOrientation, qreal delta, qint32 discreteDelta, PointerAxisSource source);
 
 protected:
     void pointer_set_cursor(Resource *resource, uint32_t serial, ::wl_resource *surface_resource, int32_t hotspot_x, int32_t hotspot_y) override;
     void pointer_release(Resource *resource) override;
     void pointer_bind_resource(Resource *resource) override;
+    void pointer_destroy_resource(Resource *resource) override;
 };
 
 }
@@ -7,17 +7,22 @@
 
 #include "pointerconstraints_v1_interface.h"
 #include "display.h"
+#include "lazyglobal.h"
 #include "pointer_interface.h"
 #include "pointerconstraints_v1_interface_p.h"
 #include "region_interface_p.h"
 #include "surface_interface_p.h"
 
+#include <QtMath>
+
+#include <algorithm>
+#include <limits>
+
 namespace KWaylandServer
 {
 static const int s_version = 1;
 
-PointerConstraintsV1InterfacePrivate::PointerConstraintsV1InterfacePrivate(Display *display)
-    : QtWaylandServer::zwp_pointer_constraints_v1(*display, s_version)
+PointerConstraintsV1InterfacePrivate::PointerConstraintsV1InterfacePrivate()
 {
 }
 
@@ -104,6 +109,7 @@ void PointerConstraintsV1InterfacePrivate::zwp_pointer_constraints_v1_confine_po
 
     auto confinedPointer =
         new ConfinedPointerV1Interface(ConfinedPointerV1Interface::LifeTime(lifetime), regionFromResource(region_resource), confinedPointerResource);
+    ConfinedPointerV1InterfacePrivate::get(confinedPointer)->surface = surface;
 
     SurfaceInterfacePrivate::get(surface)->installPointerConstraint(confinedPointer);
 }
@@ -115,8 +121,10 @@ void PointerConstraintsV1InterfacePrivate::zwp_pointer_constraints_v1_destroy(Re
 
 PointerConstraintsV1Interface::PointerConstraintsV1Interface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new PointerConstraintsV1InterfacePrivate(display))
 {
+    LazyGlobal::create(display, &zwp_pointer_constraints_v1_interface, s_version, this, d, [] {
+        return new PointerConstraintsV1InterfacePrivate();
+    });
 }
 
 PointerConstraintsV1Interface::~PointerConstraintsV1Interface()
@@ -246,10 +254,31 @@ void ConfinedPointerV1InterfacePrivate::commit()
     if (hasPendingRegion) {
         region = pendingRegion;
         hasPendingRegion = false;
+        invalidateEffectiveRegion();
         Q_EMIT q->regionChanged();
     }
 }
 
+void ConfinedPointerV1InterfacePrivate::invalidateEffectiveRegion()
+{
+    rectsValid = false;
+    rects.clear();
+    lastRect = 0;
+}
+
+const QVector<QRect> &ConfinedPointerV1InterfacePrivate::effectiveRects() const
+{
+    if (!rectsValid) {
+        const QRegion effective = q->effectiveRegion();
+        rects.reserve(effective.rectCount());
+        for (const QRect &rect : effective) {
+            rects.append(rect);
+        }
+        rectsValid = true;
+    }
+    return rects;
+}
+
 void ConfinedPointerV1InterfacePrivate::zwp_confined_pointer_v1_destroy_resource(Resource *resource)
 {
     Q_UNUSED(resource)
@@ -292,6 +321,57 @@ bool ConfinedPointerV1Interface::isConfined() const
     return d->isConfined;
 }
 
+QRegion ConfinedPointerV1Interface::effectiveRegion() const
+{
+    if (!d->surface) {
+        return d->region;
+    }
+    if (d->region.isEmpty()) {
+        return d->surface->input();
+    }
+    return d->region & d->surface->input();
+}
+
+static qreal clamp(qreal value, int min, int max)
+{
+    return std::clamp(value, qreal(min), qreal(max));
+}
+
+QPointF ConfinedPointerV1Interface::constrainPosition(const QPointF &position) const
+{
+    const QVector<QRect> &rects = d->effectiveRects();
+    if (rects.isEmpty()) {
+        return position;
+    }
+
+    // the pointer mostly stays in the same rectangle, check that one first
+    const QPoint pixel(qFloor(position.x()), qFloor(position.y()));
+    if (rects[d->lastRect].contains(pixel)) {
+        return position;
+    }
+    for (int i = 0; i < rects.count(); ++i) {
+        if (rects[i].contains(pixel)) {
+            d->lastRect = i;
+            return position;
+        }
+    }
+
+    QPointF closest;
+    qreal closestDistance = std::numeric_limits<qreal>::max();
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRect &rect = rects[i];
+        const QPointF candidate(clamp(position.x(), rect.left(), rect.right()), clamp(position.y(), rect.top(), rect.bottom()));
+        const QPointF offset = position - candidate;
+        const qreal distance = QPointF::dotProduct(offset, offset);
+        if (distance < closestDistance) {
+            closest = candidate;
+            closestDistance = distance;
+            d->lastRect = i;
+        }
+    }
+    return closest;
+}
+
 void ConfinedPointerV1Interface::setConfined(bool confined)
 {
     if (d->isConfined == confined) {
@@ -206,6 +206,27 @@ public:
      */
     bool isConfined() const;
 
+    /**
+     * The region the pointer is confined to, that is the intersection of the {@link region}
+     * and the input region of the SurfaceInterface, or just the latter if the region is empty.
+     *
+     * @see constrainPosition
+     */
+    QRegion effectiveRegion() const;
+    /**
+     * Clamps the surface-local @p position to the {@link effectiveRegion}.
+     *
+     * If @p position is outside of the effective region, the closest point inside of it is
+     * returned, otherwise @p position is returned unchanged. The position is also returned
+     * unchanged if the effective region is empty.
+     *
+     * The rectangles of the effective region are cached until the SurfaceInterface gets
+     * committed again, so this is cheap enough to be called for every pointer motion.
+     *
+     * @see effectiveRegion
+     */
+    QPointF constrainPosition(const QPointF &position) const;
+
     /**
      * Activates or deactivates the confinement.
      *
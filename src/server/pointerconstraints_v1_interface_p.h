@@ -8,6 +8,10 @@
 #pragma once
 
 #include "pointerconstraints_v1_interface.h"
+#include "surface_interface.h"
+
+#include <QPointer>
+#include <QVector>
 
 #include "qwayland-server-pointer-constraints-unstable-v1.h"
 
@@ -16,7 +20,7 @@ namespace KWaylandServer
 class PointerConstraintsV1InterfacePrivate : public QtWaylandServer::zwp_pointer_constraints_v1
 {
 public:
-    explicit PointerConstraintsV1InterfacePrivate(Display *display);
+    PointerConstraintsV1InterfacePrivate();
 
 protected:
     void zwp_pointer_constraints_v1_lock_pointer(Resource *resource,
@@ -71,14 +75,23 @@ public:
                                       ::wl_resource *resource);
 
     void commit();
+    void invalidateEffectiveRegion();
+    const QVector<QRect> &effectiveRects() const;
 
     ConfinedPointerV1Interface *q;
     ConfinedPointerV1Interface::LifeTime lifeTime;
+    QPointer<SurfaceInterface> surface;
     QRegion region;
     QRegion pendingRegion;
     bool hasPendingRegion = false;
     bool isConfined = false;
 
+    // the rectangles of the effective region, built on demand
+    mutable QVector<QRect> rects;
+    mutable bool rectsValid = false;
+    // the rectangle that contained the last constrained position
+    mutable int lastRect = 0;
+
 protected:
     void zwp_confined_pointer_v1_destroy_resource(Resource *resource) override;
     void zwp_confined_pointer_v1_destroy(Resource *resource) override;
@@ -8,6 +8,7 @@
 #include "pointergestures_v1_interface.h"
 #include "clientconnection.h"
 #include "display.h"
+#include "lazyglobal.h"
 #include "pointer_interface_p.h"
 #include "pointergestures_v1_interface_p.h"
 #include "seat_interface.h"
@@ -17,8 +18,7 @@ namespace KWaylandServer
 {
 static const int s_version = 3;
 
-PointerGesturesV1InterfacePrivate::PointerGesturesV1InterfacePrivate(Display *display)
-    : QtWaylandServer::zwp_pointer_gestures_v1(*display, s_version)
+PointerGesturesV1InterfacePrivate::PointerGesturesV1InterfacePrivate()
 {
 }
 
@@ -66,8 +66,10 @@ void PointerGesturesV1InterfacePrivate::zwp_pointer_gestures_v1_release(Resource
 
 PointerGesturesV1Interface::PointerGesturesV1Interface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new PointerGesturesV1InterfacePrivate(display))
 {
+    LazyGlobal::create(display, &zwp_pointer_gestures_v1_interface, s_version, this, d, [] {
+        return new PointerGesturesV1InterfacePrivate();
+    });
 }
 
 PointerGesturesV1Interface::~PointerGesturesV1Interface()
@@ -21,7 +21,7 @@ class SurfaceInterface;
 class PointerGesturesV1InterfacePrivate : public QtWaylandServer::zwp_pointer_gestures_v1
 {
 public:
-    explicit PointerGesturesV1InterfacePrivate(Display *display);
+    PointerGesturesV1InterfacePrivate();
 
 protected:
     void zwp_pointer_gestures_v1_get_swipe_gesture(Resource *resource, uint32_t id, struct ::wl_resource *pointer_resource) override;
@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class PresentationTimeInterfacePrivate;
+
+/**
+ * The PresentationTimeInterface allows clients to get feedback on when and how the content
+ * of their surfaces got presented.
+ *
+ * Clients request a feedback for a surface commit, once the content of that commit is shown
+ * the compositor reports the presentation time with SurfaceInterface::presented. If the content
+ * gets superseded by another commit before it was shown, the feedback is discarded automatically.
+ * Timestamps are in the CLOCK_MONOTONIC domain.
+ *
+ * PresentationTimeInterface corresponds to the Wayland interface @c wp_presentation.
+ */
+class KWAYLANDSERVER_EXPORT PresentationTimeInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PresentationTimeInterface(Display *display, QObject *parent = nullptr);
+    ~PresentationTimeInterface() override;
+
+    /**
+     * How the content got presented, corresponds to @c wp_presentation_feedback.kind.
+     */
+    enum class Kind {
+        Vsync = 0x1, ///< the presentation was synchronized to the vertical retrace
+        HwClock = 0x2, ///< the timestamp comes from the display hardware
+        HwCompletion = 0x4, ///< the display hardware signalled the completion of the presentation
+        ZeroCopy = 0x8, ///< the client buffer got scanned out directly
+    };
+    Q_DECLARE_FLAGS(Kinds, Kind)
+
+private:
+    QScopedPointer<PresentationTimeInterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::PresentationTimeInterface::Kinds)
@@ -30,11 +30,13 @@ public:
     void kde_primary_output_v1_bind_resource(Resource *resource) override
     {
         if (!m_outputName.isEmpty()) {
-            send_primary_output(resource->handle, m_outputName);
+            kde_primary_output_v1_send_primary_output(resource->handle, m_encodedOutputName.constData());
         }
     }
 
     QString m_outputName;
+    // encoded once for all the clients
+    QByteArray m_encodedOutputName;
 };
 
 PrimaryOutputV1Interface::PrimaryOutputV1Interface(KWaylandServer::Display *display, QObject *parent)
@@ -51,10 +53,11 @@ void PrimaryOutputV1Interface::setPrimaryOutput(const QString &outputName)
         return;
     }
     d->m_outputName = outputName;
+    d->m_encodedOutputName = outputName.toUtf8();
 
     const auto resources = d->resourceMap();
     for (auto *resource : resources) {
-        d->send_primary_output(resource->handle, outputName);
+        kde_primary_output_v1_send_primary_output(resource->handle, d->m_encodedOutputName.constData());
     }
 }
 
@@ -74,8 +74,9 @@ PrimarySelectionOfferV1Interface::~PrimarySelectionOfferV1Interface() = default;
 
 void PrimarySelectionOfferV1Interface::sendAllOffers()
 {
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    const QVector<QByteArray> mimeTypes = d->source->encodedMimeTypes();
+    for (const QByteArray &mimeType : mimeTypes) {
+        zwp_primary_selection_offer_v1_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
@@ -9,9 +9,18 @@
 
 namespace KWaylandServer
 {
+struct RegionResource : QtWaylandServer::wl_region::Resource, SlabAllocated<RegionResource> {
+};
+
 RegionInterface::RegionInterface(wl_resource *resource)
-    : QtWaylandServer::wl_region(resource)
 {
+    // not through the constructor of wl_region, it wouldn't call region_allocate()
+    init(resource);
+}
+
+RegionInterface::Resource *RegionInterface::region_allocate()
+{
+    return new RegionResource;
 }
 
 void RegionInterface::region_destroy_resource(Resource *)
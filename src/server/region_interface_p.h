@@ -9,10 +9,11 @@
 #include <QRegion>
 
 #include "qwayland-server-wayland.h"
+#include "slaballocator_p.h"
 
 namespace KWaylandServer
 {
-class RegionInterface : public QtWaylandServer::wl_region
+class RegionInterface : public QtWaylandServer::wl_region, public SlabAllocated<RegionInterface>
 {
 public:
     static RegionInterface *get(wl_resource *native);
@@ -21,6 +22,7 @@ public:
     QRegion region() const;
 
 protected:
+    Resource *region_allocate() override;
     void region_destroy_resource(Resource *resource) override;
     void region_destroy(Resource *resource) override;
     void region_add(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height) override;
@@ -8,6 +8,7 @@
 #include "relativepointer_v1_interface.h"
 #include "clientconnection.h"
 #include "display.h"
+#include "lazyglobal.h"
 #include "pointer_interface_p.h"
 #include "relativepointer_v1_interface_p.h"
 #include "seat_interface.h"
@@ -17,8 +18,7 @@ namespace KWaylandServer
 {
 static const int s_version = 1;
 
-RelativePointerManagerV1InterfacePrivate::RelativePointerManagerV1InterfacePrivate(Display *display)
-    : QtWaylandServer::zwp_relative_pointer_manager_v1(*display, s_version)
+RelativePointerManagerV1InterfacePrivate::RelativePointerManagerV1InterfacePrivate()
 {
 }
 
@@ -43,8 +43,10 @@ void RelativePointerManagerV1InterfacePrivate::zwp_relative_pointer_manager_v1_g
 
 RelativePointerManagerV1Interface::RelativePointerManagerV1Interface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new RelativePointerManagerV1InterfacePrivate(display))
 {
+    LazyGlobal::create(display, &zwp_relative_pointer_manager_v1_interface, s_version, this, d, [] {
+        return new RelativePointerManagerV1InterfacePrivate();
+    });
 }
 
 RelativePointerManagerV1Interface::~RelativePointerManagerV1Interface()
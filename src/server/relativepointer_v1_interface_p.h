@@ -18,7 +18,7 @@ class PointerInterface;
 class RelativePointerManagerV1InterfacePrivate : public QtWaylandServer::zwp_relative_pointer_manager_v1
 {
 public:
-    explicit RelativePointerManagerV1InterfacePrivate(Display *display);
+    RelativePointerManagerV1InterfacePrivate();
 
 protected:
     void zwp_relative_pointer_manager_v1_destroy(Resource *resource) override;
@@ -15,7 +15,7 @@
 #include "logging.h"
 
 #include <QHash>
-#include <QMutableHashIterator>
+#include <QVector>
 
 #include <functional>
 
@@ -101,7 +101,8 @@ quint32 BufferHandle::format() const
 struct BufferHolder
 {
     const BufferHandle *buf;
-    quint64 counter;
+    // the manager resources the buffer got announced to which did not return it yet
+    QVector<wl_resource *> consumers;
 };
 
 class RemoteAccessManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_remote_access_manager
@@ -133,12 +134,15 @@ private:
     virtual void org_kde_kwin_remote_access_manager_record(Resource *resource, int32_t frame) override;
     virtual void org_kde_kwin_remote_access_manager_get_rendersequence(Resource *resource) override;
 
+    virtual void org_kde_kwin_remote_access_manager_destroy_resource(Resource *resource) override;
+
     /**
-     * @brief Unreferences counter and frees buffer when it reaches zero
-     * @param buf holder to decrease reference counter on
+     * @brief Drops @p consumer from the buffer with @p fd and frees the buffer once no consumer is left
+     * @param fd the fd identifying the buffer
+     * @param consumer the manager resource returning the buffer
      * @return true if buffer was released, false otherwise
      */
-    bool unref(BufferHolder &buf);
+    bool unref(qint32 fd, wl_resource *consumer);
 
     static const quint32 s_version;
 
@@ -150,9 +154,17 @@ private:
      **/
     QHash<qint32, BufferHolder> sentBuffers;
     QHash<wl_resource *, qint32> requestFrames;
+    /**
+     * The number of buffers each manager resource holds. A client which doesn't keep up
+     * skips frames instead of holding on to more and more buffers of the compositor, which
+     * can then recycle a small set of buffers per output.
+     **/
+    QHash<wl_resource *, int> heldBuffers;
+    static const int s_maxHeldBuffers;
 };
 
 const quint32 RemoteAccessManagerInterfacePrivate::s_version = 2;
+const int RemoteAccessManagerInterfacePrivate::s_maxHeldBuffers = 2;
 
 RemoteAccessManagerInterfacePrivate::RemoteAccessManagerInterfacePrivate(RemoteAccessManagerInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_remote_access_manager(*display, s_version)
@@ -163,39 +175,52 @@ RemoteAccessManagerInterfacePrivate::RemoteAccessManagerInterfacePrivate(RemoteA
 
 void RemoteAccessManagerInterfacePrivate::sendBufferReady(const OutputInterface *output, const BufferHandle *buf)
 {
-    BufferHolder holder{buf, 0};
+    auto sent = sentBuffers.constFind(buf->fd());
+    if (Q_UNLIKELY(sent != sentBuffers.constEnd())) {
+        qCWarning(KWAYLAND_SERVER) << "Buffer sent again before it got released, fd" << buf->fd();
+        // the clients still hold the buffer with this fd, the new handle isn't announced to
+        // them and is handed back right away. The held handle gets released once, when the
+        // clients return it
+        if (sent->buf != buf) {
+            Q_EMIT q->bufferReleased(buf);
+        }
+        return;
+    }
+    BufferHolder holder{buf, {}};
     // notify clients
     qCDebug(KWAYLAND_SERVER) << "Server buffer sent: fd" << buf->fd();
-    for (auto res : resourceMap()) {
-        auto client = wl_resource_get_client(res->handle);
-        auto boundScreens = output->clientResources(display->getConnection(client));
-
-        // clients don't necessarily bind outputs
-        if (boundScreens.isEmpty()) {
+    const auto resources = resourceMap();
+    for (auto res : resources) {
+        int frame = requestFrames.value(res->handle, -1);
+        if (!frame) {
             continue;
         }
-
-        int frame = -1;
-        if (requestFrames.contains(res->handle)) {
-            frame = requestFrames[res->handle];
+        if (heldBuffers.value(res->handle) >= s_maxHeldBuffers) {
+            // the client is still busy with the previous frames, it skips this one
+            continue;
         }
 
-        if (frame) {
-            // no reason for client to bind wl_output multiple times, send only to first one
-            send_buffer_ready(res->handle, buf->fd(), boundScreens[0]);
-            holder.counter++;
+        // no reason for client to bind wl_output multiple times, send only to first one
+        wl_resource *boundScreen = output->clientResource(display->getConnection(res->client()));
+        // clients don't necessarily bind outputs
+        if (!boundScreen) {
+            continue;
         }
+
+        send_buffer_ready(res->handle, buf->fd(), boundScreen);
+        holder.consumers << res->handle;
+        heldBuffers[res->handle]++;
         if (frame > 0) {
             requestFrames[res->handle] = frame - 1;
         }
     }
-    if (holder.counter == 0) {
+    if (holder.consumers.isEmpty()) {
         // buffer was not requested by any client
         Q_EMIT q->bufferReleased(buf);
         return;
     }
     // store buffer locally, clients will ask it later
-    sentBuffers[buf->fd()] = holder;
+    sentBuffers.insert(buf->fd(), holder);
 }
 
 void RemoteAccessManagerInterfacePrivate::incrementRenderSequence()
@@ -203,28 +228,36 @@ void RemoteAccessManagerInterfacePrivate::incrementRenderSequence()
     renderSequence++;
 }
 
-bool RemoteAccessManagerInterfacePrivate::unref(BufferHolder &bh)
+bool RemoteAccessManagerInterfacePrivate::unref(qint32 fd, wl_resource *consumer)
 {
-    bh.counter--;
-    if (!bh.counter) {
-        // no more clients using this buffer
-        qCDebug(KWAYLAND_SERVER) << "[ut-gfx ]Buffer released, fd" << bh.buf->fd();
-        sentBuffers.remove(bh.buf->fd());
-        Q_EMIT q->bufferReleased(bh.buf);
-        return true;
+    auto it = sentBuffers.find(fd);
+    if (it == sentBuffers.end() || !it->consumers.removeOne(consumer)) {
+        return false;
+    }
+    auto held = heldBuffers.find(consumer);
+    if (held != heldBuffers.end() && --(*held) <= 0) {
+        heldBuffers.erase(held);
+    }
+    if (!it->consumers.isEmpty()) {
+        return false;
     }
-    return false;
+    // no more clients using this buffer
+    const BufferHandle *buf = it->buf;
+    qCDebug(KWAYLAND_SERVER) << "[ut-gfx ]Buffer released, fd" << fd;
+    sentBuffers.erase(it);
+    Q_EMIT q->bufferReleased(buf);
+    return true;
 }
 
 void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_get_buffer(Resource *resource, uint32_t buffer, int32_t internal_buffer_id)
 {
     // client asks for buffer we earlier announced, we must have it
-    if (Q_UNLIKELY(!this->sentBuffers.contains(internal_buffer_id))) { // no such buffer (?)
+    auto it = sentBuffers.constFind(internal_buffer_id);
+    if (Q_UNLIKELY(it == sentBuffers.constEnd() || !it->consumers.contains(resource->handle))) { // no such buffer (?)
         wl_resource_post_no_memory(resource->handle);
         return;
     }
-
-    BufferHolder &bh = sentBuffers[internal_buffer_id];
+    const BufferHandle *buf = it->buf;
     wl_resource *RbiResource = wl_resource_create(resource->client(), &org_kde_kwin_remote_buffer_interface, resource->version(), buffer);
 
     if (!RbiResource) {
@@ -233,16 +266,12 @@ void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_get
         return;
     }
 
-    auto rbuf = new RemoteBufferInterface(bh.buf, RbiResource);
+    auto rbuf = new RemoteBufferInterface(buf, RbiResource);
 
-    QObject::connect(rbuf, &QObject::destroyed, [resource, &bh, this] {
-       if (!resourceMap().contains(resource->client())) {
-            // remote buffer destroy confirmed after client is already gone
-            // all relevant buffers are already unreferenced
-            return;
-        }
-        qCDebug(KWAYLAND_SERVER) << "Remote buffer returned, client" << wl_resource_get_id(resource->handle) << ", fd" << bh.buf->fd();
-        unref(bh);
+    // the manager resource might be gone by then, in which case it already returned all its buffers
+    QObject::connect(rbuf, &QObject::destroyed, q, [consumer = resource->handle, fd = internal_buffer_id, this] {
+        qCDebug(KWAYLAND_SERVER) << "Remote buffer returned, fd" << fd;
+        unref(fd, consumer);
         gsScreenRecord.setObjectName(SCREEN_RECORDING_FINISHED);
     });
 
@@ -254,15 +283,23 @@ void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_get
 
 void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_release(Resource *resource)
 {
-    // all holders should decrement their counter as one client is gone
-    QMutableHashIterator<qint32, BufferHolder> itr(sentBuffers);
-    while (itr.hasNext()) {
-        BufferHolder &bh = itr.next().value();
-        if (unref(bh)) {
-            itr.remove();
+    wl_resource_destroy(resource->handle);
+}
+
+void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_destroy_resource(Resource *resource)
+{
+    // the buffers the client still holds are returned, whether it released the manager or disconnected
+    QVector<qint32> heldFds;
+    for (auto it = sentBuffers.constBegin(); it != sentBuffers.constEnd(); ++it) {
+        if (it->consumers.contains(resource->handle)) {
+            heldFds << it.key();
         }
     }
-    wl_resource_destroy(resource->handle);
+    for (qint32 fd : qAsConst(heldFds)) {
+        unref(fd, resource->handle);
+    }
+    heldBuffers.remove(resource->handle);
+    requestFrames.remove(resource->handle);
 }
 
 void RemoteAccessManagerInterfacePrivate::org_kde_kwin_remote_access_manager_record(Resource *resource, int32_t frame)
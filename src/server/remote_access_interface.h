@@ -65,6 +65,11 @@ public:
 
     /**
      * Store buffer in sent list and notify client that we have a buffer for it
+     *
+     * Each client holds at most two buffers at a time, a client which is still busy with
+     * those skips the frame. Thus a small set of buffers per output can be reused once
+     * bufferReleased got emitted for them. A buffer must not be sent again before that, a
+     * different handle with the fd of a held buffer is released right away without being sent.
      **/
     void sendBufferReady(const OutputInterface *output, const BufferHandle *buf);
     /**
@@ -0,0 +1,197 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "scanoutevaluator.h"
+#include "linuxdmabufv1clientbuffer.h"
+#include "output_interface.h"
+#include "surface_interface.h"
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+
+class ScanoutEvaluatorPrivate
+{
+public:
+    struct Entry {
+        // the epoch and the surface generations the results were computed for
+        quint64 epoch = 0;
+        quint64 geometryGeneration = 0;
+        quint64 regionsGeneration = 0;
+        quint64 effectsGeneration = 0;
+        quint64 childrenGeneration = 0;
+        quint64 bufferGeneration = 0;
+        bool valid = false;
+        // the result of the checks that don't depend on the buffer contents
+        ScanoutEvaluator::Result structureResult = ScanoutEvaluator::Result::Eligible;
+        bool opaqueRegionCovers = false;
+        ScanoutEvaluator::Result result = ScanoutEvaluator::Result::Eligible;
+        QMetaObject::Connection destroyConnection;
+    };
+
+    ScanoutEvaluator::Result evaluateStructure(SurfaceInterface *surface, bool *opaqueRegionCovers) const;
+    ScanoutEvaluator::Result evaluateBuffer(SurfaceInterface *surface, bool opaqueRegionCovers) const;
+    void invalidate();
+
+    QPointer<OutputInterface> output;
+    QHash<uint32_t, QSet<uint64_t>> formats;
+    QHash<SurfaceInterface *, Entry> entries;
+    // bumped whenever the output or the formats change, every entry is stale then
+    quint64 epoch = 1;
+};
+
+void ScanoutEvaluatorPrivate::invalidate()
+{
+    ++epoch;
+}
+
+ScanoutEvaluator::Result ScanoutEvaluatorPrivate::evaluateStructure(SurfaceInterface *surface, bool *opaqueRegionCovers) const
+{
+    *opaqueRegionCovers = false;
+    if (!surface->below().isEmpty() || !surface->above().isEmpty()) {
+        return ScanoutEvaluator::Result::SubSurfaces;
+    }
+    if (surface->shadow() || surface->blur() || surface->contrast()) {
+        return ScanoutEvaluator::Result::Effects;
+    }
+    if (!output || surface->bufferTransform() != output->transform()) {
+        return ScanoutEvaluator::Result::TransformMismatch;
+    }
+
+    // with the transform of the output the buffer is in the orientation of the mode, it has to
+    // have the size of the mode and the surface has to cover the output and map onto all of it
+    const QSize bufferSize = surface->bufferSize();
+    if (bufferSize != output->pixelSize()) {
+        return ScanoutEvaluator::Result::SizeMismatch;
+    }
+    QSize outputSize = output->pixelSize() / output->scale();
+    switch (output->transform()) {
+    case OutputInterface::Transform::Rotated90:
+    case OutputInterface::Transform::Rotated270:
+    case OutputInterface::Transform::Flipped90:
+    case OutputInterface::Transform::Flipped270:
+        outputSize.transpose();
+        break;
+    case OutputInterface::Transform::Normal:
+    case OutputInterface::Transform::Rotated180:
+    case OutputInterface::Transform::Flipped:
+    case OutputInterface::Transform::Flipped180:
+        break;
+    }
+    const QRect surfaceRect(QPoint(0, 0), surface->size());
+    if (surface->size() != outputSize || surface->mapToBuffer(QRegion(surfaceRect)) != QRegion(QRect(QPoint(0, 0), bufferSize))) {
+        return ScanoutEvaluator::Result::SizeMismatch;
+    }
+
+    *opaqueRegionCovers = (QRegion(surfaceRect) - surface->opaque()).isEmpty();
+    return ScanoutEvaluator::Result::Eligible;
+}
+
+ScanoutEvaluator::Result ScanoutEvaluatorPrivate::evaluateBuffer(SurfaceInterface *surface, bool opaqueRegionCovers) const
+{
+    ClientBuffer *buffer = surface->buffer();
+    if (!buffer) {
+        return ScanoutEvaluator::Result::NoBuffer;
+    }
+    auto dmabuf = qobject_cast<LinuxDmaBufV1ClientBuffer *>(buffer);
+    if (!dmabuf) {
+        return ScanoutEvaluator::Result::NotDmaBuf;
+    }
+    const QVector<LinuxDmaBufV1Plane> planes = dmabuf->planes();
+    const auto format = formats.constFind(dmabuf->format());
+    if (planes.isEmpty() || format == formats.constEnd() || !format->contains(planes.first().modifier)) {
+        return ScanoutEvaluator::Result::UnsupportedFormat;
+    }
+    if (dmabuf->hasAlphaChannel() && !opaqueRegionCovers) {
+        return ScanoutEvaluator::Result::Translucent;
+    }
+    return ScanoutEvaluator::Result::Eligible;
+}
+
+ScanoutEvaluator::ScanoutEvaluator(OutputInterface *output, QObject *parent)
+    : QObject(parent)
+    , d(new ScanoutEvaluatorPrivate)
+{
+    d->output = output;
+    connect(output, &OutputInterface::transformChanged, this, [this] {
+        d->invalidate();
+    });
+    connect(output, &OutputInterface::pixelSizeChanged, this, [this] {
+        d->invalidate();
+    });
+    connect(output, &OutputInterface::scaleChanged, this, [this] {
+        d->invalidate();
+    });
+}
+
+ScanoutEvaluator::~ScanoutEvaluator()
+{
+    for (const ScanoutEvaluatorPrivate::Entry &entry : qAsConst(d->entries)) {
+        disconnect(entry.destroyConnection);
+    }
+}
+
+OutputInterface *ScanoutEvaluator::output() const
+{
+    return d->output;
+}
+
+void ScanoutEvaluator::setScanoutFormats(const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    if (d->formats == formats) {
+        return;
+    }
+    d->formats = formats;
+    d->invalidate();
+}
+
+ScanoutEvaluator::Result ScanoutEvaluator::evaluate(SurfaceInterface *surface)
+{
+    auto it = d->entries.find(surface);
+    if (it == d->entries.end()) {
+        it = d->entries.insert(surface, ScanoutEvaluatorPrivate::Entry());
+        it->destroyConnection = connect(surface, &QObject::destroyed, this, [this, surface] {
+            d->entries.remove(surface);
+        });
+    }
+    ScanoutEvaluatorPrivate::Entry &entry = *it;
+
+    const quint64 geometryGeneration = surface->generation(SurfaceInterface::StateCategory::Geometry);
+    const quint64 regionsGeneration = surface->generation(SurfaceInterface::StateCategory::Regions);
+    const quint64 effectsGeneration = surface->generation(SurfaceInterface::StateCategory::Effects);
+    const quint64 childrenGeneration = surface->generation(SurfaceInterface::StateCategory::Children);
+    const quint64 bufferGeneration = surface->generation(SurfaceInterface::StateCategory::Buffer);
+
+    const bool structureStale = !entry.valid || entry.epoch != d->epoch || entry.geometryGeneration != geometryGeneration
+        || entry.regionsGeneration != regionsGeneration || entry.effectsGeneration != effectsGeneration
+        || entry.childrenGeneration != childrenGeneration;
+    if (structureStale) {
+        entry.structureResult = d->evaluateStructure(surface, &entry.opaqueRegionCovers);
+    }
+    // most commits only attach a new buffer, e.g. every frame of a video or a game
+    if (structureStale || entry.bufferGeneration != bufferGeneration) {
+        const Result bufferResult = d->evaluateBuffer(surface, entry.opaqueRegionCovers);
+        // a missing or unsuitable buffer is the more useful reason, whether the buffer is
+        // translucent is only known if the structure is fine
+        if (bufferResult != Result::Eligible && bufferResult != Result::Translucent) {
+            entry.result = bufferResult;
+        } else if (entry.structureResult != Result::Eligible) {
+            entry.result = entry.structureResult;
+        } else {
+            entry.result = bufferResult;
+        }
+    }
+
+    entry.valid = true;
+    entry.epoch = d->epoch;
+    entry.geometryGeneration = geometryGeneration;
+    entry.regionsGeneration = regionsGeneration;
+    entry.effectsGeneration = effectsGeneration;
+    entry.childrenGeneration = childrenGeneration;
+    entry.bufferGeneration = bufferGeneration;
+    return entry.result;
+}
+
+} // namespace KWaylandServer
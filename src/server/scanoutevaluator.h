@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+namespace KWaylandServer
+{
+class OutputInterface;
+class ScanoutEvaluatorPrivate;
+class SurfaceInterface;
+
+/**
+ * The ScanoutEvaluator class decides whether a surface covering an output, e.g. the surface of a
+ * fullscreen toplevel, can be put on the primary plane of the output directly.
+ *
+ * The compositor creates one for every output and sets the formats the primary plane can scan
+ * out. The result of evaluate() is cached per surface and only computed again if a commit
+ * changed the relevant state of the surface, see SurfaceInterface::generation(), or if the
+ * output or the scanout formats changed, so it is cheap to call once per frame.
+ *
+ * Surfaces with sub-surfaces are never eligible, even if the sub-surfaces are not mapped.
+ */
+class KWAYLANDSERVER_EXPORT ScanoutEvaluator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The result of an evaluation, i.e. the first reason that prevents the scanout of a surface.
+     * Use QMetaEnum to turn it into a string, e.g. for statistics.
+     */
+    enum class Result {
+        /**
+         * The surface can be scanned out.
+         */
+        Eligible,
+        /**
+         * The surface has no buffer attached.
+         */
+        NoBuffer,
+        /**
+         * The buffer is not a linux dma-buf buffer.
+         */
+        NotDmaBuf,
+        /**
+         * The format and modifier of the buffer can't be scanned out by the output.
+         */
+        UnsupportedFormat,
+        /**
+         * The buffer transform differs from the transform of the output.
+         */
+        TransformMismatch,
+        /**
+         * The buffer doesn't match the pixels of the output one to one, e.g. it is scaled or
+         * cropped with a viewport, or the surface doesn't cover the whole output.
+         */
+        SizeMismatch,
+        /**
+         * The surface has sub-surfaces.
+         */
+        SubSurfaces,
+        /**
+         * The buffer has an alpha channel and the opaque region doesn't cover the surface.
+         */
+        Translucent,
+        /**
+         * The surface has a shadow, a blur or a contrast effect.
+         */
+        Effects,
+    };
+    Q_ENUM(Result)
+
+    explicit ScanoutEvaluator(OutputInterface *output, QObject *parent = nullptr);
+    ~ScanoutEvaluator() override;
+
+    OutputInterface *output() const;
+
+    /**
+     * Sets the @p formats and modifiers the primary plane of the output can scan out.
+     */
+    void setScanoutFormats(const QHash<uint32_t, QSet<uint64_t>> &formats);
+
+    /**
+     * Returns whether @p surface can be scanned out on the output, or why it can't.
+     */
+    Result evaluate(SurfaceInterface *surface);
+
+private:
+    QScopedPointer<ScanoutEvaluatorPrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -9,6 +9,8 @@
 #include "output_interface.h"
 
 #include <QDebug>
+// std
+#include <algorithm>
 
 #include "qwayland-server-zkde-screencast-unstable-v1.h"
 
@@ -43,6 +45,14 @@ public:
     }
 
     bool stopped = false;
+    std::chrono::nanoseconds minimumFrameInterval = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds lastFrame = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds pendingFrame = std::chrono::nanoseconds::zero();
+    bool framePending = false;
+    bool hasFrame = false;
+    ScreencastStreamV1Interface::FrameStatistics statistics;
+    quint64 releasedFrames = 0;
+    std::chrono::nanoseconds totalLatency = std::chrono::nanoseconds::zero();
     ScreencastStreamV1Interface *const q;
 };
 
@@ -71,6 +81,78 @@ void ScreencastStreamV1Interface::sendClosed()
     }
 }
 
+void ScreencastStreamV1Interface::setMaximumFramerate(qreal fps)
+{
+    if (fps <= 0) {
+        d->minimumFrameInterval = std::chrono::nanoseconds::zero();
+    } else {
+        d->minimumFrameInterval = std::chrono::nanoseconds(qRound64(1000000000 / fps));
+    }
+}
+
+qreal ScreencastStreamV1Interface::maximumFramerate() const
+{
+    if (d->minimumFrameInterval <= std::chrono::nanoseconds::zero()) {
+        return 0;
+    }
+    return 1000000000.0 / d->minimumFrameInterval.count();
+}
+
+void ScreencastStreamV1Interface::setMinimumFrameInterval(std::chrono::nanoseconds interval)
+{
+    d->minimumFrameInterval = std::max(interval, std::chrono::nanoseconds::zero());
+}
+
+std::chrono::nanoseconds ScreencastStreamV1Interface::minimumFrameInterval() const
+{
+    return d->minimumFrameInterval;
+}
+
+bool ScreencastStreamV1Interface::startFrame(std::chrono::nanoseconds timestamp)
+{
+    if (d->framePending) {
+        d->statistics.droppedFrames++;
+        return false;
+    }
+    if (d->hasFrame && d->minimumFrameInterval > std::chrono::nanoseconds::zero()) {
+        // a little early is fine, the compositor's frames jitter around the refresh interval
+        const auto tolerance = std::min(d->minimumFrameInterval / 10, std::chrono::nanoseconds(std::chrono::milliseconds(2)));
+        if (timestamp - d->lastFrame < d->minimumFrameInterval - tolerance) {
+            d->statistics.droppedFrames++;
+            return false;
+        }
+    }
+    d->hasFrame = true;
+    d->lastFrame = timestamp;
+    d->pendingFrame = timestamp;
+    d->framePending = true;
+    d->statistics.producedFrames++;
+    return true;
+}
+
+void ScreencastStreamV1Interface::frameReleased(std::chrono::nanoseconds timestamp)
+{
+    if (!d->framePending) {
+        return;
+    }
+    d->framePending = false;
+    const auto latency = std::max(timestamp - d->pendingFrame, std::chrono::nanoseconds::zero());
+    d->releasedFrames++;
+    d->totalLatency += latency;
+    d->statistics.lastLatency = latency;
+    d->statistics.averageLatency = d->totalLatency / qint64(d->releasedFrames);
+}
+
+bool ScreencastStreamV1Interface::isFramePending() const
+{
+    return d->framePending;
+}
+
+ScreencastStreamV1Interface::FrameStatistics ScreencastStreamV1Interface::frameStatistics() const
+{
+    return d->statistics;
+}
+
 class ScreencastV1InterfacePrivate : public QtWaylandServer::zkde_screencast_unstable_v1
 {
 public:
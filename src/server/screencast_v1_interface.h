@@ -9,6 +9,8 @@
 #include <DWayland/Server/kwaylandserver_export.h>
 #include <QObject>
 #include <QScopedPointer>
+// std
+#include <chrono>
 
 struct wl_resource;
 
@@ -30,6 +32,52 @@ public:
     void sendFailed(const QString &error);
     void sendClosed();
 
+    /**
+     * Limits the stream to @p fps frames per second, e.g. for a screen share which doesn't
+     * need every frame of the compositor. A value of @c 0, the default, doesn't limit it.
+     * This is a shortcut for setMinimumFrameInterval.
+     */
+    void setMaximumFramerate(qreal fps);
+    qreal maximumFramerate() const;
+    /**
+     * Sets the minimum time between two frames of the stream, by default @c 0.
+     */
+    void setMinimumFrameInterval(std::chrono::nanoseconds interval);
+    std::chrono::nanoseconds minimumFrameInterval() const;
+
+    /**
+     * Asks whether a frame presented at @p timestamp should be recorded for this stream.
+     *
+     * The frame is skipped, and counted as dropped, if it comes too early for the minimum frame
+     * interval or the consumer didn't release the buffer of the previous frame yet. Otherwise it
+     * counts as produced and the compositor is supposed to record it and to call frameReleased
+     * once the consumer is done with its buffer.
+     *
+     * Doing this check before reading the frame back keeps slow or rate limited consumers
+     * from costing a readback per compositor frame.
+     */
+    bool startFrame(std::chrono::nanoseconds timestamp);
+    /**
+     * The consumer released the buffer of the last started frame at @p timestamp.
+     * The time since startFrame is the latency of the frame.
+     */
+    void frameReleased(std::chrono::nanoseconds timestamp);
+    /**
+     * @returns Whether a started frame was not released yet.
+     */
+    bool isFramePending() const;
+
+    struct FrameStatistics {
+        quint64 producedFrames = 0;
+        quint64 droppedFrames = 0;
+        std::chrono::nanoseconds lastLatency = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds averageLatency = std::chrono::nanoseconds::zero();
+    };
+    /**
+     * @returns The number of produced and dropped frames and the latencies of the released ones.
+     */
+    FrameStatistics frameStatistics() const;
+
 Q_SIGNALS:
     void finished();
 
@@ -0,0 +1,472 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "screencopy_v1_interface.h"
+#include "clientbuffer.h"
+#include "display.h"
+#include "linuxdmabufv1clientbuffer.h"
+#include "output_interface.h"
+
+#include <QHash>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <wayland-server-core.h>
+// std
+#include <algorithm>
+
+#include "qwayland-server-wlr-screencopy-unstable-v1.h"
+
+namespace KWaylandServer
+{
+static const quint32 s_version = 3;
+
+/**
+ * The damage of the outputs since the last copy through one manager instance. An output
+ * without an entry wasn't copied yet and counts as damaged entirely.
+ */
+struct ScreencopyDamageTracker {
+    QHash<OutputInterface *, QRegion> damage;
+};
+
+static QRect logicalOutputRect(OutputInterface *output)
+{
+    QSize size = output->pixelSize() / std::max(output->scale(), 1);
+    switch (output->transform()) {
+    case OutputInterface::Transform::Rotated90:
+    case OutputInterface::Transform::Rotated270:
+    case OutputInterface::Transform::Flipped90:
+    case OutputInterface::Transform::Flipped270:
+        size.transpose();
+        break;
+    default:
+        break;
+    }
+    return QRect(QPoint(0, 0), size);
+}
+
+class ScreencopyManagerV1InterfacePrivate : public QtWaylandServer::zwlr_screencopy_manager_v1
+{
+public:
+    ScreencopyManagerV1InterfacePrivate(ScreencopyManagerV1Interface *q, Display *display);
+    ~ScreencopyManagerV1InterfacePrivate() override;
+
+    void addDamage(OutputInterface *output, const QRegion &damage);
+    void captureOutput(Resource *resource, uint32_t id, int32_t overlayCursor, wl_resource *outputResource, const QRect *region);
+    void watchOutput(OutputInterface *output);
+
+    ScreencopyManagerV1Interface *q;
+    Display *display;
+    QVector<QWeakPointer<ScreencopyDamageTracker>> trackers;
+    QVector<ScreencopyFrameV1Interface *> frames;
+    QVector<OutputInterface *> watchedOutputs;
+
+protected:
+    struct TrackerResource : Resource {
+        QSharedPointer<ScreencopyDamageTracker> tracker;
+    };
+
+    Resource *zwlr_screencopy_manager_v1_allocate() override;
+    void zwlr_screencopy_manager_v1_bind_resource(Resource *resource) override;
+    void zwlr_screencopy_manager_v1_capture_output(Resource *resource, uint32_t frame, int32_t overlay_cursor, wl_resource *output) override;
+    void zwlr_screencopy_manager_v1_capture_output_region(Resource *resource,
+                                                          uint32_t frame,
+                                                          int32_t overlay_cursor,
+                                                          wl_resource *output,
+                                                          int32_t x,
+                                                          int32_t y,
+                                                          int32_t width,
+                                                          int32_t height) override;
+    void zwlr_screencopy_manager_v1_destroy(Resource *resource) override;
+};
+
+class ScreencopyFrameV1InterfacePrivate : public QtWaylandServer::zwlr_screencopy_frame_v1
+{
+public:
+    ScreencopyFrameV1InterfacePrivate(ScreencopyFrameV1Interface *q);
+
+    bool isBufferValid(wl_resource *bufferResource, ClientBuffer *clientBuffer) const;
+    QRegion logicalDamage() const;
+    void copy(Resource *resource, wl_resource *bufferResource, bool damage);
+    void maybeRequestCopy();
+    void finish();
+
+    ScreencopyFrameV1Interface *q;
+    ScreencopyManagerV1InterfacePrivate *manager = nullptr;
+    QSharedPointer<ScreencopyDamageTracker> tracker;
+    QPointer<OutputInterface> output;
+    QRect region;
+    bool overlayCursor = false;
+    bool withDamage = false;
+    ClientBuffer *buffer = nullptr;
+    bool used = false;
+    bool copyRequested = false;
+    bool finished = false;
+
+    quint32 shmFormat = 0;
+    QSize shmSize;
+    quint32 shmStride = 0;
+    quint32 dmaBufFormat = 0;
+    QSize dmaBufSize;
+
+protected:
+    void zwlr_screencopy_frame_v1_destroy_resource(Resource *resource) override;
+    void zwlr_screencopy_frame_v1_copy(Resource *resource, wl_resource *buffer) override;
+    void zwlr_screencopy_frame_v1_copy_with_damage(Resource *resource, wl_resource *buffer) override;
+    void zwlr_screencopy_frame_v1_destroy(Resource *resource) override;
+};
+
+ScreencopyFrameV1InterfacePrivate::ScreencopyFrameV1InterfacePrivate(ScreencopyFrameV1Interface *q)
+    : q(q)
+{
+}
+
+void ScreencopyFrameV1InterfacePrivate::zwlr_screencopy_frame_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete q;
+}
+
+void ScreencopyFrameV1InterfacePrivate::zwlr_screencopy_frame_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void ScreencopyFrameV1InterfacePrivate::zwlr_screencopy_frame_v1_copy(Resource *resource, wl_resource *buffer)
+{
+    copy(resource, buffer, false);
+}
+
+void ScreencopyFrameV1InterfacePrivate::zwlr_screencopy_frame_v1_copy_with_damage(Resource *resource, wl_resource *buffer)
+{
+    copy(resource, buffer, true);
+}
+
+bool ScreencopyFrameV1InterfacePrivate::isBufferValid(wl_resource *bufferResource, ClientBuffer *clientBuffer) const
+{
+    if (wl_shm_buffer *shmBuffer = wl_shm_buffer_get(bufferResource)) {
+        return shmSize.isValid() && wl_shm_buffer_get_format(shmBuffer) == shmFormat && wl_shm_buffer_get_width(shmBuffer) == shmSize.width()
+            && wl_shm_buffer_get_height(shmBuffer) == shmSize.height() && quint32(wl_shm_buffer_get_stride(shmBuffer)) == shmStride;
+    }
+    if (auto dmaBuf = qobject_cast<LinuxDmaBufV1ClientBuffer *>(clientBuffer)) {
+        return dmaBufSize.isValid() && dmaBuf->format() == dmaBufFormat && dmaBuf->size() == dmaBufSize;
+    }
+    return false;
+}
+
+void ScreencopyFrameV1InterfacePrivate::copy(Resource *resource, wl_resource *bufferResource, bool damage)
+{
+    if (used) {
+        wl_resource_post_error(resource->handle, error_already_used, "the frame was already used to copy a buffer");
+        return;
+    }
+    used = true;
+    // the frame failed already, e.g. because the output went away
+    if (finished) {
+        return;
+    }
+    if (!manager || !output) {
+        q->sendFailed();
+        return;
+    }
+
+    ClientBuffer *clientBuffer = manager->display->clientBufferForResource(bufferResource);
+    if (!clientBuffer || !isBufferValid(bufferResource, clientBuffer)) {
+        wl_resource_post_error(resource->handle, error_invalid_buffer, "the buffer doesn't match the announced buffer parameters");
+        return;
+    }
+
+    withDamage = damage;
+    buffer = clientBuffer;
+    buffer->ref();
+    maybeRequestCopy();
+}
+
+QRegion ScreencopyFrameV1InterfacePrivate::logicalDamage() const
+{
+    auto it = tracker->damage.constFind(output);
+    if (it == tracker->damage.constEnd()) {
+        return region;
+    }
+    return *it & region;
+}
+
+void ScreencopyFrameV1InterfacePrivate::maybeRequestCopy()
+{
+    if (!buffer || copyRequested || finished || !output) {
+        return;
+    }
+    // wait until there is something new to copy
+    if (withDamage && logicalDamage().isEmpty()) {
+        return;
+    }
+    copyRequested = true;
+    Q_EMIT q->copyRequested(buffer);
+}
+
+void ScreencopyFrameV1InterfacePrivate::finish()
+{
+    finished = true;
+    if (buffer) {
+        buffer->unref();
+        buffer = nullptr;
+    }
+}
+
+ScreencopyFrameV1Interface::ScreencopyFrameV1Interface(ScreencopyManagerV1InterfacePrivate *manager,
+                                                       OutputInterface *output,
+                                                       const QRect &region,
+                                                       bool overlayCursor)
+    : d(new ScreencopyFrameV1InterfacePrivate(this))
+{
+    d->manager = manager;
+    d->output = output;
+    d->region = region;
+    d->overlayCursor = overlayCursor;
+    manager->frames.append(this);
+
+    if (output) {
+        connect(output, &QObject::destroyed, this, &ScreencopyFrameV1Interface::sendFailed);
+    }
+}
+
+ScreencopyFrameV1Interface::~ScreencopyFrameV1Interface()
+{
+    if (d->manager) {
+        d->manager->frames.removeOne(this);
+    }
+    if (d->buffer) {
+        d->buffer->unref();
+    }
+}
+
+OutputInterface *ScreencopyFrameV1Interface::output() const
+{
+    return d->output;
+}
+
+QRect ScreencopyFrameV1Interface::region() const
+{
+    return d->region;
+}
+
+bool ScreencopyFrameV1Interface::overlayCursor() const
+{
+    return d->overlayCursor;
+}
+
+bool ScreencopyFrameV1Interface::withDamage() const
+{
+    return d->withDamage;
+}
+
+ClientBuffer *ScreencopyFrameV1Interface::buffer() const
+{
+    return d->buffer;
+}
+
+QRegion ScreencopyFrameV1Interface::damage() const
+{
+    if (!d->buffer || !d->output || d->region.isEmpty()) {
+        return QRegion();
+    }
+    const QSize bufferSize = d->buffer->size();
+    const qreal scaleX = qreal(bufferSize.width()) / d->region.width();
+    const qreal scaleY = qreal(bufferSize.height()) / d->region.height();
+
+    QRegion damage;
+    for (const QRect &rect : d->logicalDamage()) {
+        const QRect local = rect.translated(-d->region.topLeft());
+        damage += QRectF(local.x() * scaleX, local.y() * scaleY, local.width() * scaleX, local.height() * scaleY).toAlignedRect();
+    }
+    return damage & QRect(QPoint(0, 0), bufferSize);
+}
+
+void ScreencopyFrameV1Interface::sendShmBuffer(quint32 format, const QSize &size, quint32 stride)
+{
+    d->shmFormat = format;
+    d->shmSize = size;
+    d->shmStride = stride;
+    d->send_buffer(format, size.width(), size.height(), stride);
+}
+
+void ScreencopyFrameV1Interface::sendDmaBuf(quint32 format, const QSize &size)
+{
+    if (d->resource()->version() < ScreencopyFrameV1InterfacePrivate::send_linux_dmabuf_since_version) {
+        return;
+    }
+    d->dmaBufFormat = format;
+    d->dmaBufSize = size;
+    d->send_linux_dmabuf(format, size.width(), size.height());
+}
+
+void ScreencopyFrameV1Interface::sendBufferDone()
+{
+    if (d->resource()->version() >= ScreencopyFrameV1InterfacePrivate::send_buffer_done_since_version) {
+        d->send_buffer_done();
+    }
+}
+
+void ScreencopyFrameV1Interface::sendReady(std::chrono::nanoseconds timestamp, bool yInverted)
+{
+    if (d->finished || !d->buffer) {
+        return;
+    }
+    if (d->withDamage) {
+        for (const QRect &rect : damage()) {
+            d->send_damage(rect.x(), rect.y(), rect.width(), rect.height());
+        }
+    }
+    if (d->output) {
+        // the client is up to date with the copied region now
+        auto it = d->tracker->damage.find(d->output);
+        if (it == d->tracker->damage.end()) {
+            it = d->tracker->damage.insert(d->output, logicalOutputRect(d->output));
+        }
+        *it -= d->region;
+    }
+
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timestamp);
+    const auto nanoseconds = timestamp - seconds;
+    d->send_flags(yInverted ? ScreencopyFrameV1InterfacePrivate::flags_y_invert : 0);
+    d->send_ready(quint64(seconds.count()) >> 32, quint64(seconds.count()) & 0xffffffff, nanoseconds.count());
+    d->finish();
+}
+
+void ScreencopyFrameV1Interface::sendFailed()
+{
+    if (d->finished) {
+        return;
+    }
+    d->send_failed();
+    d->finish();
+}
+
+ScreencopyManagerV1InterfacePrivate::ScreencopyManagerV1InterfacePrivate(ScreencopyManagerV1Interface *q, Display *display)
+    : QtWaylandServer::zwlr_screencopy_manager_v1(*display, s_version)
+    , q(q)
+    , display(display)
+{
+}
+
+ScreencopyManagerV1InterfacePrivate::~ScreencopyManagerV1InterfacePrivate()
+{
+    for (ScreencopyFrameV1Interface *frame : qAsConst(frames)) {
+        frame->d->manager = nullptr;
+    }
+}
+
+void ScreencopyManagerV1InterfacePrivate::addDamage(OutputInterface *output, const QRegion &damage)
+{
+    if (damage.isEmpty()) {
+        return;
+    }
+    for (auto it = trackers.begin(); it != trackers.end();) {
+        if (auto tracker = it->toStrongRef()) {
+            auto damageIt = tracker->damage.find(output);
+            // outputs which weren't copied yet are damaged entirely anyway
+            if (damageIt != tracker->damage.end()) {
+                *damageIt += damage;
+            }
+            ++it;
+        } else {
+            it = trackers.erase(it);
+        }
+    }
+
+    for (ScreencopyFrameV1Interface *frame : qAsConst(frames)) {
+        if (frame->d->output == output) {
+            frame->d->maybeRequestCopy();
+        }
+    }
+}
+
+ScreencopyManagerV1InterfacePrivate::Resource *ScreencopyManagerV1InterfacePrivate::zwlr_screencopy_manager_v1_allocate()
+{
+    return new TrackerResource;
+}
+
+void ScreencopyManagerV1InterfacePrivate::zwlr_screencopy_manager_v1_bind_resource(Resource *resource)
+{
+    auto tracker = QSharedPointer<ScreencopyDamageTracker>::create();
+    static_cast<TrackerResource *>(resource)->tracker = tracker;
+    trackers.append(tracker);
+}
+
+void ScreencopyManagerV1InterfacePrivate::zwlr_screencopy_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void ScreencopyManagerV1InterfacePrivate::zwlr_screencopy_manager_v1_capture_output(Resource *resource,
+                                                                                    uint32_t frame,
+                                                                                    int32_t overlay_cursor,
+                                                                                    wl_resource *output)
+{
+    captureOutput(resource, frame, overlay_cursor, output, nullptr);
+}
+
+void ScreencopyManagerV1InterfacePrivate::zwlr_screencopy_manager_v1_capture_output_region(Resource *resource,
+                                                                                           uint32_t frame,
+                                                                                           int32_t overlay_cursor,
+                                                                                           wl_resource *output,
+                                                                                           int32_t x,
+                                                                                           int32_t y,
+                                                                                           int32_t width,
+                                                                                           int32_t height)
+{
+    const QRect region(x, y, width, height);
+    captureOutput(resource, frame, overlay_cursor, output, &region);
+}
+
+void ScreencopyManagerV1InterfacePrivate::captureOutput(Resource *resource, uint32_t id, int32_t overlayCursor, wl_resource *outputResource, const QRect *region)
+{
+    OutputInterface *output = OutputInterface::get(outputResource);
+    const QRect outputRect = output ? logicalOutputRect(output) : QRect();
+    const QRect captured = region ? region->normalized() & outputRect : outputRect;
+
+    auto frame = new ScreencopyFrameV1Interface(this, output, captured, overlayCursor);
+    frame->d->tracker = static_cast<TrackerResource *>(resource)->tracker;
+    frame->d->init(resource->client(), id, resource->version());
+
+    // there is nothing to copy from an inert output or outside of it
+    if (!output || captured.isEmpty()) {
+        frame->sendFailed();
+        return;
+    }
+    watchOutput(output);
+    Q_EMIT q->frameCreated(frame);
+}
+
+void ScreencopyManagerV1InterfacePrivate::watchOutput(OutputInterface *output)
+{
+    if (watchedOutputs.contains(output)) {
+        return;
+    }
+    watchedOutputs.append(output);
+    // don't let the damage of a destroyed output leak into one which happens to get its address
+    QObject::connect(output, &QObject::destroyed, q, [this, output] {
+        watchedOutputs.removeOne(output);
+        for (const QWeakPointer<ScreencopyDamageTracker> &weakTracker : qAsConst(trackers)) {
+            if (auto tracker = weakTracker.toStrongRef()) {
+                tracker->damage.remove(output);
+            }
+        }
+    });
+}
+
+ScreencopyManagerV1Interface::ScreencopyManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new ScreencopyManagerV1InterfacePrivate(this, display))
+{
+}
+
+ScreencopyManagerV1Interface::~ScreencopyManagerV1Interface() = default;
+
+void ScreencopyManagerV1Interface::addDamage(OutputInterface *output, const QRegion &damage)
+{
+    d->addDamage(output, damage);
+}
+
+}
@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+#include <QRect>
+#include <QRegion>
+#include <QScopedPointer>
+// std
+#include <chrono>
+
+namespace KWaylandServer
+{
+class ClientBuffer;
+class Display;
+class OutputInterface;
+class ScreencopyFrameV1InterfacePrivate;
+class ScreencopyManagerV1InterfacePrivate;
+
+/**
+ * The ScreencopyFrameV1Interface class represents a request of a client to copy a region of an
+ * output into one of its buffers, the zwlr_screencopy_frame_v1 object.
+ *
+ * The compositor first announces the buffer types it can copy into with sendShmBuffer,
+ * sendDmaBuf and sendBufferDone. Once the client hands over a matching buffer, copyRequested
+ * is emitted and the compositor renders the next frame of the output into it, followed by
+ * sendReady, or sendFailed if that isn't possible.
+ *
+ * The frame is destroyed when the client destroys it, which can happen at any time.
+ */
+class KWAYLANDSERVER_EXPORT ScreencopyFrameV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~ScreencopyFrameV1Interface() override;
+
+    /**
+     * @returns The captured output, or @c null if the output is gone.
+     */
+    OutputInterface *output() const;
+    /**
+     * @returns The captured region in logical coordinates relative to the output, clipped to it.
+     */
+    QRect region() const;
+    /**
+     * @returns Whether the cursor should be composited onto the frame.
+     */
+    bool overlayCursor() const;
+    /**
+     * @returns Whether the client asked to be told the damage of the frame, in which case
+     * copyRequested is only emitted once the region got damaged since the previous copy.
+     */
+    bool withDamage() const;
+    /**
+     * @returns The buffer to copy into, or @c null if the client didn't provide one yet.
+     */
+    ClientBuffer *buffer() const;
+    /**
+     * @returns The damage of the region since the previous copy in buffer coordinates.
+     */
+    QRegion damage() const;
+
+    /**
+     * Announces that wl_shm buffers with @p format, @p size and @p stride are supported. Clients
+     * which bound the manager with version 2 or lower can only copy into wl_shm buffers.
+     */
+    void sendShmBuffer(quint32 format, const QSize &size, quint32 stride);
+    /**
+     * Announces that linux dma-buf buffers with the fourcc @p format and @p size are supported.
+     */
+    void sendDmaBuf(quint32 format, const QSize &size);
+    /**
+     * Tells the client that all supported buffer types are announced.
+     */
+    void sendBufferDone();
+
+    /**
+     * The frame presented at @p timestamp was copied into the buffer. The buffer contents are
+     * upside down if @p yInverted is @c true.
+     */
+    void sendReady(std::chrono::nanoseconds timestamp, bool yInverted = false);
+    /**
+     * The frame couldn't be copied.
+     */
+    void sendFailed();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the compositor should copy the next frame into the buffer.
+     */
+    void copyRequested(ClientBuffer *buffer);
+
+private:
+    ScreencopyFrameV1Interface(ScreencopyManagerV1InterfacePrivate *manager, OutputInterface *output, const QRect &region, bool overlayCursor);
+    friend class ScreencopyFrameV1InterfacePrivate;
+    friend class ScreencopyManagerV1InterfacePrivate;
+    QScopedPointer<ScreencopyFrameV1InterfacePrivate> d;
+};
+
+/**
+ * The ScreencopyManagerV1Interface class provides a way for clients to capture the contents
+ * of outputs, the zwlr_screencopy_manager_v1 global.
+ *
+ * The compositor reports what it repaints with addDamage so that clients which only want to
+ * copy changed frames are served when there is something new to copy.
+ */
+class KWAYLANDSERVER_EXPORT ScreencopyManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScreencopyManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~ScreencopyManagerV1Interface() override;
+
+    /**
+     * Reports that @p damage, in logical coordinates relative to the @p output, was repainted.
+     */
+    void addDamage(OutputInterface *output, const QRegion &damage);
+
+Q_SIGNALS:
+    /**
+     * Emitted when a client wants to capture a region of an output. The compositor is expected
+     * to announce the supported buffer types of the @p frame right away.
+     */
+    void frameCreated(ScreencopyFrameV1Interface *frame);
+
+private:
+    QScopedPointer<ScreencopyManagerV1InterfacePrivate> d;
+};
+
+}
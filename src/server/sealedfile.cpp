@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "sealedfile.h"
+#include "logging.h"
+
+#include <QScopedPointer>
+#include <QTemporaryFile>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+static bool writeAll(int fd, const char *data, quint32 size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+SealedFile::SealedFile(const QByteArray &content, const char *name)
+    : m_name(name)
+    , m_size(content.size())
+{
+    if (!createMemfd(content) && !createTemporaryFile(content)) {
+        m_size = 0;
+    }
+}
+
+SealedFile::~SealedFile()
+{
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+bool SealedFile::isValid() const
+{
+    return m_fd != -1;
+}
+
+int SealedFile::fd() const
+{
+    return m_fd;
+}
+
+quint32 SealedFile::size() const
+{
+    return m_size;
+}
+
+int SealedFile::createPrivateCopy() const
+{
+    if (m_fd == -1) {
+        return -1;
+    }
+    void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to map" << m_name << "file:" << strerror(errno);
+        return -1;
+    }
+
+    int fd = -1;
+#ifdef MFD_CLOEXEC
+    fd = memfd_create(m_name, MFD_CLOEXEC);
+#endif
+    if (fd == -1) {
+        // the descriptor outlives the unlinked temporary file
+        QTemporaryFile tmp;
+        if (tmp.open()) {
+            fd = fcntl(tmp.handle(), F_DUPFD_CLOEXEC, 0);
+        }
+    }
+    if (fd != -1 && !writeAll(fd, static_cast<const char *>(data), m_size)) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to write" << m_name << "copy:" << strerror(errno);
+        close(fd);
+        fd = -1;
+    }
+    munmap(data, m_size);
+    return fd;
+}
+
+bool SealedFile::createMemfd(const QByteArray &content)
+{
+#if defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+    const int fd = memfd_create(m_name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1) {
+        return false;
+    }
+
+    if (!writeAll(fd, content.constData(), m_size)) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to write" << m_name << "memfd:" << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to seal" << m_name << "memfd:" << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    return true;
+#else
+    Q_UNUSED(content)
+    return false;
+#endif
+}
+
+bool SealedFile::createTemporaryFile(const QByteArray &content)
+{
+    QScopedPointer<QTemporaryFile> tmp(new QTemporaryFile());
+    if (!tmp->open()) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create" << m_name << "file:" << tmp->errorString();
+        return false;
+    }
+
+    if (!writeAll(tmp->handle(), content.constData(), m_size)) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to write" << m_name << "file:" << strerror(errno);
+        return false;
+    }
+
+    // The writable descriptor stays private, clients only get a read-only one.
+    const QByteArray fileName = QFile::encodeName(tmp->fileName());
+    const int fd = open(fileName.constData(), O_RDONLY | O_CLOEXEC);
+    unlink(fileName.constData());
+    if (fd == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to reopen" << m_name << "file:" << strerror(errno);
+        return false;
+    }
+
+    m_fd = fd;
+    return true;
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QByteArray>
+
+namespace KWaylandServer
+{
+/**
+ * A read-only file holding data which is passed to every client by its descriptor, e.g. a
+ * keymap or the dmabuf format table.
+ *
+ * The file is created once and its descriptor is shared with every resource. It is backed by a
+ * sealed memfd where available, so clients can't modify or resize the data seen by other
+ * clients. Otherwise an unlinked temporary file is reopened read-only.
+ */
+class SealedFile
+{
+public:
+    /**
+     * Creates the file with @p content, @p name shows up in /proc for the memfd and in warnings.
+     */
+    SealedFile(const QByteArray &content, const char *name);
+    ~SealedFile();
+
+    bool isValid() const;
+    int fd() const;
+    quint32 size() const;
+    /**
+     * Creates a writable, unsealed copy of the file, for protocols which allow clients to map
+     * it with MAP_SHARED and PROT_WRITE, which fails on a sealed file. The caller owns the
+     * returned descriptor, @c -1 on failure.
+     */
+    int createPrivateCopy() const;
+
+private:
+    bool createMemfd(const QByteArray &content);
+    bool createTemporaryFile(const QByteArray &content);
+
+    const char *m_name;
+    int m_fd = -1;
+    quint32 m_size = 0;
+
+    Q_DISABLE_COPY(SealedFile)
+};
+
+} // namespace KWaylandServer
@@ -7,15 +7,19 @@
 */
 #include "seat_interface.h"
 #include "abstract_data_source.h"
+#include "clientconnection.h"
+#include "clipboardcache.h"
 #include "datacontroldevice_v1_interface.h"
 #include "datacontrolsource_v1_interface.h"
 #include "datadevice_interface.h"
 #include "datadevice_interface_p.h"
 #include "datasource_interface.h"
+#include "ddeseat_interface_p.h"
 #include "display.h"
 #include "display_p.h"
 #include "keyboard_interface.h"
 #include "keyboard_interface_p.h"
+#include "keyboard_shortcuts_inhibit_v1_interface.h"
 #include "logging.h"
 #include "pointer_interface.h"
 #include "pointer_interface_p.h"
@@ -30,10 +34,12 @@
 #include "textinput_v3_interface_p.h"
 #include "touch_interface_p.h"
 #include "utils.h"
+#include "utils_p.h"
 
 #include <linux/input.h>
 
 #include <functional>
+#include <utility>
 
 namespace KWaylandServer
 {
@@ -51,6 +57,14 @@ SeatInterfacePrivate::SeatInterfacePrivate(SeatInterface *q, Display *display)
 {
     textInputV2 = new TextInputV2Interface(q);
     textInputV3 = new TextInputV3Interface(q);
+
+    primarySelectionTimer.setSingleShot(true);
+    primarySelectionTimer.setInterval(0);
+    QObject::connect(&primarySelectionTimer, &QTimer::timeout, q, [this]() {
+        if (primarySelectionPending) {
+            broadcastPrimarySelection();
+        }
+    });
 }
 
 void SeatInterfacePrivate::seat_bind_resource(Resource *resource)
@@ -119,47 +133,52 @@ SeatInterface::~SeatInterface()
     }
 }
 
+quint32 SeatInterfacePrivate::nextSerial(SerialHistory::Event event, qint32 id)
+{
+    SerialHistory::Entry entry;
+    entry.event = event;
+    entry.seat = q;
+    entry.surface = event == SerialHistory::Event::TouchDown ? globalTouch.focus.surface : globalPointer.focus.surface;
+    entry.id = id;
+    entry.timestamp = timestamp;
+    return DisplayPrivate::get(display)->nextSerial(entry);
+}
+
 void SeatInterfacePrivate::updatePointerButtonSerial(quint32 button, quint32 serial)
 {
-    auto it = globalPointer.buttonSerials.find(button);
-    if (it == globalPointer.buttonSerials.end()) {
-        globalPointer.buttonSerials.insert(button, serial);
-        return;
-    }
-    it.value() = serial;
+    globalPointer.buttonSerials.insert(button, serial);
 }
 
 void SeatInterfacePrivate::updatePointerButtonState(quint32 button, Pointer::State state)
 {
-    auto it = globalPointer.buttonStates.find(button);
-    if (it == globalPointer.buttonStates.end()) {
-        globalPointer.buttonStates.insert(button, state);
-        return;
-    }
-    it.value() = state;
+    globalPointer.buttonStates.insert(button, state);
 }
 
-QVector<DataDeviceInterface *> SeatInterfacePrivate::dataDevicesForSurface(SurfaceInterface *surface) const
+QList<DataDeviceInterface *> SeatInterfacePrivate::dataDevicesForSurface(SurfaceInterface *surface) const
 {
     if (!surface) {
         return {};
     }
-    QVector<DataDeviceInterface *> primarySelectionDevices;
-    for (auto it = dataDevices.constBegin(); it != dataDevices.constEnd(); ++it) {
-        if ((*it)->client() == *surface->client()) {
-            primarySelectionDevices << *it;
-        }
+    return dataDevices.resources(*surface->client());
+}
+
+QList<PrimarySelectionDeviceV1Interface *> SeatInterfacePrivate::primarySelectionDevicesForSurface(SurfaceInterface *surface) const
+{
+    if (!surface) {
+        return {};
     }
-    return primarySelectionDevices;
+    return primarySelectionDevices.resources(*surface->client());
 }
 
 void SeatInterfacePrivate::registerDataDevice(DataDeviceInterface *dataDevice)
 {
     Q_ASSERT(dataDevice->seat() == q);
-    dataDevices << dataDevice;
-    auto dataDeviceCleanup = [this, dataDevice] {
-        dataDevices.removeOne(dataDevice);
+    dataDevices.add(dataDevice);
+    drag.pointerFocus = nullptr;
+    auto dataDeviceCleanup = [this, dataDevice, client = dataDevice->client()] {
+        dataDevices.remove(client, dataDevice);
         globalKeyboard.focus.selections.removeOne(dataDevice);
+        drag.pointerFocus = nullptr;
     };
     QObject::connect(dataDevice, &QObject::destroyed, q, dataDeviceCleanup);
     QObject::connect(dataDevice, &DataDeviceInterface::selectionChanged, q, [this, dataDevice] {
@@ -186,13 +205,36 @@ void SeatInterfacePrivate::registerDataDevice(DataDeviceInterface *dataDevice)
     }
 }
 
-KWaylandServer::AbstractDropHandler *SeatInterface::dropHandlerForSurface(SurfaceInterface *surface) const
+DataDeviceInterface *SeatInterfacePrivate::dataDeviceForSurface(SurfaceInterface *surface) const
 {
-    auto list = d->dataDevicesForSurface(surface);
-    if (list.isEmpty()) {
+    if (!surface) {
         return nullptr;
-    };
-    return list.first();
+    }
+    const QList<DataDeviceInterface *> devices = dataDevices.resources(*surface->client());
+    return devices.isEmpty() ? nullptr : devices.first();
+}
+
+KWaylandServer::AbstractDropHandler *SeatInterface::dropHandlerForSurface(SurfaceInterface *surface) const
+{
+    return d->dataDeviceForSurface(surface);
+}
+
+void SeatInterfacePrivate::registerShortcutsInhibitor(KeyboardShortcutsInhibitorV1Interface *inhibitor)
+{
+    Q_ASSERT(inhibitor->seat() == q);
+    SurfaceInterface *surface = inhibitor->surface();
+    shortcutsInhibitors.insert(surface, inhibitor);
+    if (globalKeyboard.focus.surface == surface) {
+        globalKeyboard.focus.shortcutsInhibitor = inhibitor;
+    }
+    QObject::connect(inhibitor, &QObject::destroyed, q, [this, surface, inhibitor] {
+        if (shortcutsInhibitors.value(surface) == inhibitor) {
+            shortcutsInhibitors.remove(surface);
+        }
+        if (globalKeyboard.focus.shortcutsInhibitor == inhibitor) {
+            globalKeyboard.focus.shortcutsInhibitor = nullptr;
+        }
+    });
 }
 
 void SeatInterfacePrivate::registerDataControlDevice(DataControlDeviceV1Interface *dataDevice)
@@ -248,9 +290,9 @@ void SeatInterfacePrivate::registerPrimarySelectionDevice(PrimarySelectionDevice
 {
     Q_ASSERT(primarySelectionDevice->seat() == q);
 
-    primarySelectionDevices << primarySelectionDevice;
-    auto dataDeviceCleanup = [this, primarySelectionDevice] {
-        primarySelectionDevices.removeOne(primarySelectionDevice);
+    primarySelectionDevices.add(primarySelectionDevice);
+    auto dataDeviceCleanup = [this, primarySelectionDevice, client = primarySelectionDevice->client()] {
+        primarySelectionDevices.remove(client, primarySelectionDevice);
         globalKeyboard.focus.primarySelections.removeOne(primarySelectionDevice);
     };
     QObject::connect(primarySelectionDevice, &QObject::destroyed, q, dataDeviceCleanup);
@@ -444,6 +486,9 @@ QPointF SeatInterface::pointerPos() const
 
 void SeatInterface::notifyPointerMotion(const QPointF &pos)
 {
+    if (d->ddeSeat) {
+        d->ddeSeat->setPointerPos(pos);
+    }
     if (!d->pointer) {
         return;
     }
@@ -453,21 +498,36 @@ void SeatInterface::notifyPointerMotion(const QPointF &pos)
     d->globalPointer.pos = pos;
     Q_EMIT pointerPosChanged(pos);
 
-    SurfaceInterface *focusedSurface = focusedPointerSurface();
+    if (d->pointerMotionCoalescing || d->isPointerFocusCongested()) {
+        // the motion is sent out with the position at the time of the next flush
+        d->pendingPointerMotion.motion = true;
+        return;
+    }
+    d->sendPointerMotion();
+}
+
+void SeatInterfacePrivate::sendPointerMotion()
+{
+    SurfaceInterface *focusedSurface = globalPointer.focus.surface;
     if (!focusedSurface) {
         return;
     }
-    if (isDragPointer()) {
+    if (q->isDragPointer()) {
         // data device will handle it directly
         // for xwayland cases we still want to send pointer events
-        if (!d->dataDevicesForSurface(focusedSurface).isEmpty())
+        if (drag.pointerFocus != focusedSurface) {
+            drag.pointerFocus = focusedSurface;
+            drag.pointerFocusHasDataDevice = dataDeviceForSurface(focusedSurface);
+        }
+        if (drag.pointerFocusHasDataDevice) {
             return;
+        }
     }
     if (focusedSurface->lockedPointer() && focusedSurface->lockedPointer()->isLocked()) {
         return;
     }
 
-    QPointF localPosition = focusedPointerSurfaceTransformation().map(pos);
+    QPointF localPosition = globalPointer.focus.transformation.map(globalPointer.pos);
     SurfaceInterface *effectiveFocusedSurface = focusedSurface->inputSurfaceAt(localPosition);
     if (!effectiveFocusedSurface) {
         effectiveFocusedSurface = focusedSurface;
@@ -476,11 +536,111 @@ void SeatInterface::notifyPointerMotion(const QPointF &pos)
         localPosition = focusedSurface->mapToChild(effectiveFocusedSurface, localPosition);
     }
 
-    if (d->pointer->focusedSurface() != effectiveFocusedSurface) {
-        d->pointer->setFocusedSurface(effectiveFocusedSurface, localPosition, display()->nextSerial());
+    if (pointer->focusedSurface() != effectiveFocusedSurface) {
+        pointer->setFocusedSurface(effectiveFocusedSurface, localPosition, display->nextSerial());
+    }
+
+    pointer->sendMotion(localPosition);
+}
+
+bool SeatInterfacePrivate::isPointerFocusCongested() const
+{
+    SurfaceInterface *focusedSurface = globalPointer.focus.surface;
+    return focusedSurface && focusedSurface->client()->isCongested();
+}
+
+void SeatInterfacePrivate::flushPointerMotion()
+{
+    if (!pointer) {
+        pendingPointerMotion = PendingPointerMotion();
+        return;
     }
 
-    d->pointer->sendMotion(localPosition);
+    if (pendingPointerMotion.relativeMotion) {
+        pendingPointerMotion.relativeMotion = false;
+        if (auto relativePointer = RelativePointerV1Interface::get(pointer.data())) {
+            relativePointer->sendRelativeMotion(pendingPointerMotion.delta, pendingPointerMotion.deltaNonAccelerated, pendingPointerMotion.microseconds);
+        }
+        pendingPointerMotion.delta = QSizeF();
+        pendingPointerMotion.deltaNonAccelerated = QSizeF();
+    }
+    if (pendingPointerMotion.motion) {
+        pendingPointerMotion.motion = false;
+        sendPointerMotion();
+    }
+    if (pendingPointerMotion.frame) {
+        pendingPointerMotion.frame = false;
+        pointer->sendFrame();
+    }
+}
+
+void SeatInterfacePrivate::flushPointerGestures()
+{
+    const PendingPointerGesture gesture = std::exchange(pendingPointerGesture, PendingPointerGesture());
+    if (!pointer) {
+        return;
+    }
+
+    switch (gesture.type) {
+    case PendingPointerGesture::Type::None:
+        break;
+    case PendingPointerGesture::Type::Swipe:
+        if (auto swipeGesture = PointerSwipeGestureV1Interface::get(pointer.data())) {
+            swipeGesture->sendUpdate(gesture.delta);
+        }
+        break;
+    case PendingPointerGesture::Type::Pinch:
+        if (auto pinchGesture = PointerPinchGestureV1Interface::get(pointer.data())) {
+            pinchGesture->sendUpdate(gesture.delta, gesture.scale, gesture.rotation);
+        }
+        break;
+    }
+}
+
+void SeatInterface::setPointerMotionCoalescing(bool coalesce)
+{
+    if (d->pointerMotionCoalescing == coalesce) {
+        return;
+    }
+    if (!coalesce) {
+        d->flushPointerMotion();
+    }
+    d->pointerMotionCoalescing = coalesce;
+}
+
+bool SeatInterface::pointerMotionCoalescing() const
+{
+    return d->pointerMotionCoalescing;
+}
+
+void SeatInterface::flushPointerMotion()
+{
+    if (d->isPointerFocusCongested()) {
+        // keeps coalescing until the client reads its events again
+        return;
+    }
+    d->flushPointerMotion();
+}
+
+void SeatInterface::setPointerGestureCoalescing(bool coalesce)
+{
+    if (d->pointerGestureCoalescing == coalesce) {
+        return;
+    }
+    if (!coalesce) {
+        d->flushPointerGestures();
+    }
+    d->pointerGestureCoalescing = coalesce;
+}
+
+bool SeatInterface::pointerGestureCoalescing() const
+{
+    return d->pointerGestureCoalescing;
+}
+
+void SeatInterface::flushPointerGestures()
+{
+    d->flushPointerGestures();
 }
 
 quint32 SeatInterface::timestamp() const
@@ -494,9 +654,27 @@ void SeatInterface::setTimestamp(quint32 time)
         return;
     }
     d->timestamp = time;
+    if (d->ddeSeat) {
+        d->ddeSeat->setTimestamp(time);
+        d->ddeSeat->setTouchTimestamp(time);
+    }
     Q_EMIT timestampChanged(time);
 }
 
+void SeatInterface::setDDESeat(DDESeatInterface *ddeSeat)
+{
+    d->ddeSeat = ddeSeat;
+    if (ddeSeat) {
+        ddeSeat->setTimestamp(d->timestamp);
+        ddeSeat->setTouchTimestamp(d->timestamp);
+    }
+}
+
+DDESeatInterface *SeatInterface::ddeSeat() const
+{
+    return d->ddeSeat;
+}
+
 void SeatInterface::setDragTarget(AbstractDropHandler *dropTarget,
                                   SurfaceInterface *surface,
                                   const QPointF &globalPosition,
@@ -520,7 +698,7 @@ void SeatInterface::setDragTarget(AbstractDropHandler *dropTarget,
         notifyPointerMotion(globalPosition);
         notifyPointerFrame();
     } else if (d->drag.mode == SeatInterfacePrivate::Drag::Mode::Touch && d->globalTouch.focus.firstTouchPos != globalPosition) {
-        notifyTouchMotion(d->globalTouch.ids.first(), globalPosition);
+        notifyTouchMotion(d->globalTouch.ids.begin()->second, globalPosition);
     }
     if (d->drag.target) {
         d->drag.surface = surface;
@@ -563,6 +741,9 @@ void SeatInterface::setFocusedPointerSurface(SurfaceInterface *surface, const QM
     if (!d->pointer) {
         return;
     }
+    // pending motion belongs to the previously focused surface
+    d->flushPointerMotion();
+    d->flushPointerGestures();
     if (d->drag.mode == SeatInterfacePrivate::Drag::Mode::Pointer) {
         // ignore
         return;
@@ -661,18 +842,18 @@ bool SeatInterface::isPointerButtonPressed(Qt::MouseButton button) const
 
 bool SeatInterface::isPointerButtonPressed(quint32 button) const
 {
-    auto it = d->globalPointer.buttonStates.constFind(button);
-    if (it == d->globalPointer.buttonStates.constEnd()) {
-        return false;
-    }
-    return it.value() == SeatInterfacePrivate::Pointer::State::Pressed;
+    return d->globalPointer.buttonStates.value(button, SeatInterfacePrivate::Pointer::State::Released) == SeatInterfacePrivate::Pointer::State::Pressed;
 }
 
 void SeatInterface::notifyPointerAxis(Qt::Orientation orientation, qreal delta, qint32 discreteDelta, PointerAxisSource source)
 {
+    if (d->ddeSeat) {
+        d->ddeSeat->pointerAxis(orientation, qRound(delta));
+    }
     if (!d->pointer) {
         return;
     }
+    d->flushPointerMotion();
     if (d->drag.mode == SeatInterfacePrivate::Drag::Mode::Pointer) {
         // ignore
         return;
@@ -711,10 +892,19 @@ void SeatInterface::notifyPointerButton(Qt::MouseButton button, PointerButtonSta
 
 void SeatInterface::notifyPointerButton(quint32 button, PointerButtonState state)
 {
+    if (d->ddeSeat) {
+        if (state == PointerButtonState::Pressed) {
+            d->ddeSeat->pointerButtonPressed(button);
+        } else {
+            d->ddeSeat->pointerButtonReleased(button);
+        }
+    }
     if (!d->pointer) {
         return;
     }
-    const quint32 serial = d->display->nextSerial();
+    // the button event must not overtake the motion that preceded it
+    d->flushPointerMotion();
+    const quint32 serial = state == PointerButtonState::Pressed ? d->nextSerial(SerialHistory::Event::PointerButtonPress, button) : d->display->nextSerial();
 
     if (state == PointerButtonState::Pressed) {
         d->updatePointerButtonSerial(button, serial);
@@ -745,6 +935,11 @@ void SeatInterface::notifyPointerFrame()
     if (!d->pointer) {
         return;
     }
+    if (d->pendingPointerMotion.motion || d->pendingPointerMotion.relativeMotion) {
+        // a single frame is sent together with the coalesced motion
+        d->pendingPointerMotion.frame = true;
+        return;
+    }
     d->pointer->sendFrame();
 }
 
@@ -755,11 +950,7 @@ quint32 SeatInterface::pointerButtonSerial(Qt::MouseButton button) const
 
 quint32 SeatInterface::pointerButtonSerial(quint32 button) const
 {
-    auto it = d->globalPointer.buttonSerials.constFind(button);
-    if (it == d->globalPointer.buttonSerials.constEnd()) {
-        return 0;
-    }
-    return it.value();
+    return d->globalPointer.buttonSerials.value(button, 0);
 }
 
 void SeatInterface::relativePointerMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, quint64 microseconds)
@@ -768,6 +959,15 @@ void SeatInterface::relativePointerMotion(const QSizeF &delta, const QSizeF &del
         return;
     }
 
+    if (d->pointerMotionCoalescing || d->isPointerFocusCongested()) {
+        // relative motion is accumulated, no delta gets lost
+        d->pendingPointerMotion.relativeMotion = true;
+        d->pendingPointerMotion.delta += delta;
+        d->pendingPointerMotion.deltaNonAccelerated += deltaNonAccelerated;
+        d->pendingPointerMotion.microseconds = microseconds;
+        return;
+    }
+
     auto relativePointer = RelativePointerV1Interface::get(pointer());
     if (relativePointer) {
         relativePointer->sendRelativeMotion(delta, deltaNonAccelerated, microseconds);
@@ -779,6 +979,7 @@ void SeatInterface::startPointerSwipeGesture(quint32 fingerCount)
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto swipeGesture = PointerSwipeGestureV1Interface::get(pointer());
     if (swipeGesture) {
@@ -792,6 +993,15 @@ void SeatInterface::updatePointerSwipeGesture(const QSizeF &delta)
         return;
     }
 
+    if (d->pointerGestureCoalescing) {
+        if (d->pendingPointerGesture.type != SeatInterfacePrivate::PendingPointerGesture::Type::Swipe) {
+            d->flushPointerGestures();
+            d->pendingPointerGesture.type = SeatInterfacePrivate::PendingPointerGesture::Type::Swipe;
+        }
+        d->pendingPointerGesture.delta += delta;
+        return;
+    }
+
     auto swipeGesture = PointerSwipeGestureV1Interface::get(pointer());
     if (swipeGesture) {
         swipeGesture->sendUpdate(delta);
@@ -803,6 +1013,7 @@ void SeatInterface::endPointerSwipeGesture()
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto swipeGesture = PointerSwipeGestureV1Interface::get(pointer());
     if (swipeGesture) {
@@ -815,6 +1026,7 @@ void SeatInterface::cancelPointerSwipeGesture()
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto swipeGesture = PointerSwipeGestureV1Interface::get(pointer());
     if (swipeGesture) {
@@ -827,6 +1039,7 @@ void SeatInterface::startPointerPinchGesture(quint32 fingerCount)
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto pinchGesture = PointerPinchGestureV1Interface::get(pointer());
     if (pinchGesture) {
@@ -840,6 +1053,18 @@ void SeatInterface::updatePointerPinchGesture(const QSizeF &delta, qreal scale,
         return;
     }
 
+    if (d->pointerGestureCoalescing) {
+        if (d->pendingPointerGesture.type != SeatInterfacePrivate::PendingPointerGesture::Type::Pinch) {
+            d->flushPointerGestures();
+            d->pendingPointerGesture.type = SeatInterfacePrivate::PendingPointerGesture::Type::Pinch;
+        }
+        // the scale is absolute, the rotation relative to the previous update
+        d->pendingPointerGesture.delta += delta;
+        d->pendingPointerGesture.scale = scale;
+        d->pendingPointerGesture.rotation += rotation;
+        return;
+    }
+
     auto pinchGesture = PointerPinchGestureV1Interface::get(pointer());
     if (pinchGesture) {
         pinchGesture->sendUpdate(delta, scale, rotation);
@@ -851,6 +1076,7 @@ void SeatInterface::endPointerPinchGesture()
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto pinchGesture = PointerPinchGestureV1Interface::get(pointer());
     if (pinchGesture) {
@@ -863,6 +1089,7 @@ void SeatInterface::cancelPointerPinchGesture()
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto pinchGesture = PointerPinchGestureV1Interface::get(pointer());
     if (pinchGesture) {
@@ -875,6 +1102,7 @@ void SeatInterface::startPointerHoldGesture(quint32 fingerCount)
     if (!d->pointer) {
         return;
     }
+    d->flushPointerGestures();
 
     auto holdGesture = PointerHoldGestureV1Interface::get(pointer());
     if (holdGesture) {
@@ -924,6 +1152,7 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
     }
     d->globalKeyboard.focus = SeatInterfacePrivate::Keyboard::Focus();
     d->globalKeyboard.focus.surface = surface;
+    d->globalKeyboard.focus.shortcutsInhibitor = surface ? d->shortcutsInhibitors.value(surface) : nullptr;
 
     d->keyboard->setFocusedSurface(surface, serial);
 
@@ -933,7 +1162,7 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
         });
         d->globalKeyboard.focus.serial = serial;
         // selection?
-        const QVector<DataDeviceInterface *> dataDevices = d->dataDevicesForSurface(surface);
+        const QList<DataDeviceInterface *> dataDevices = d->dataDevicesForSurface(surface);
         d->globalKeyboard.focus.selections = dataDevices;
         for (auto dataDevice : dataDevices) {
             if (d->currentSelection) {
@@ -943,13 +1172,7 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
             }
         }
         // primary selection
-        QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices;
-        for (auto it = d->primarySelectionDevices.constBegin(); it != d->primarySelectionDevices.constEnd(); ++it) {
-            if ((*it)->client() == *surface->client()) {
-                primarySelectionDevices << *it;
-            }
-        }
-
+        const QList<PrimarySelectionDeviceV1Interface *> primarySelectionDevices = d->primarySelectionDevicesForSurface(surface);
         d->globalKeyboard.focus.primarySelections = primarySelectionDevices;
         for (auto primaryDataDevice : primarySelectionDevices) {
             if (d->currentPrimarySelection) {
@@ -966,6 +1189,11 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
     }
 }
 
+KeyboardShortcutsInhibitorV1Interface *SeatInterface::focusedKeyboardShortcutsInhibitor() const
+{
+    return d->globalKeyboard.focus.shortcutsInhibitor;
+}
+
 KeyboardInterface *SeatInterface::keyboard() const
 {
     return d->keyboard.data();
@@ -973,18 +1201,75 @@ KeyboardInterface *SeatInterface::keyboard() const
 
 void SeatInterface::notifyKeyboardKey(quint32 keyCode, KeyboardKeyState state)
 {
-    if (!d->keyboard) {
+    d->restoreSeatKeyboard();
+    d->notifyKeyboardKey(keyCode, state);
+}
+
+void SeatInterfacePrivate::notifyKeyboardKey(quint32 keyCode, KeyboardKeyState state)
+{
+    if (!keyboard) {
+        if (ddeSeat) {
+            // without a keyboard the dde seat has to track the key state on its own
+            if (state == KeyboardKeyState::Pressed) {
+                ddeSeat->keyPressed(keyCode);
+            } else {
+                ddeSeat->keyReleased(keyCode);
+            }
+        }
+        return;
+    }
+    if (!ddeSeat) {
+        keyboard->sendKey(keyCode, state);
         return;
     }
-    d->keyboard->sendKey(keyCode, state);
+
+    KeyboardInterfacePrivate *keyboardPrivate = KeyboardInterfacePrivate::get(keyboard.data());
+    if (!keyboardPrivate->updateKey(keyCode, state)) {
+        return;
+    }
+    DDESeatInterfacePrivate *ddeSeatPrivate = DDESeatInterfacePrivate::get(ddeSeat);
+    if (ddeSeatPrivate->ddekeyboard) {
+        ddeSeatPrivate->sendKey(keyCode,
+                                state == KeyboardKeyState::Pressed ? DDESeatInterfacePrivate::Keyboard::State::Pressed
+                                                                   : DDESeatInterfacePrivate::Keyboard::State::Released);
+    }
+    keyboardPrivate->processKey(keyCode, state);
 }
 
 void SeatInterface::notifyKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group)
 {
-    if (!d->keyboard) {
+    d->seatModifiers.depressed = depressed;
+    d->seatModifiers.latched = latched;
+    d->seatModifiers.locked = locked;
+    d->seatModifiers.group = group;
+    d->seatModifiers.replaced = false;
+    if (d->keyboard) {
+        KeyboardInterfacePrivate::get(d->keyboard.data())->restoreSeatKeymap();
+    }
+    d->notifyKeyboardModifiers(depressed, latched, locked, group);
+}
+
+void SeatInterfacePrivate::notifyKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group)
+{
+    if (ddeSeat) {
+        ddeSeat->updateKeyboardModifiers(depressed, latched, locked, group);
+    }
+    if (!keyboard) {
         return;
     }
-    d->keyboard->sendModifiers(depressed, latched, locked, group);
+    keyboard->sendModifiers(depressed, latched, locked, group);
+}
+
+void SeatInterfacePrivate::restoreSeatKeyboard()
+{
+    if (keyboard) {
+        // the modifiers are interpreted with the keymap, so it goes first
+        KeyboardInterfacePrivate::get(keyboard.data())->restoreSeatKeymap();
+    }
+    if (seatModifiers.replaced) {
+        seatModifiers.replaced = false;
+        notifyKeyboardModifiers(seatModifiers.depressed, seatModifiers.latched, seatModifiers.locked, seatModifiers.group);
+    }
 }
 
 void SeatInterface::notifyTouchCancel()
@@ -992,6 +1277,7 @@ void SeatInterface::notifyTouchCancel()
     if (!d->touch) {
         return;
     }
+    d->pendingTouchMotions.clear();
     d->touch->sendCancel();
 
     if (d->drag.mode == SeatInterfacePrivate::Drag::Mode::Touch) {
@@ -1066,10 +1352,14 @@ void SeatInterface::setFocusedTouchSurfacePosition(const QPointF &surfacePositio
 
 void SeatInterface::notifyTouchDown(qint32 id, const QPointF &globalPosition)
 {
+    if (d->ddeSeat) {
+        d->ddeSeat->touchDown(id, globalPosition);
+    }
     if (!d->touch) {
         return;
     }
-    const qint32 serial = display()->nextSerial();
+    d->flushTouchMotion();
+    const quint32 serial = d->nextSerial(SerialHistory::Event::TouchDown, id);
     const auto pos = globalPosition - d->globalTouch.focus.offset;
     d->touch->sendDown(id, serial, pos);
 
@@ -1079,7 +1369,7 @@ void SeatInterface::notifyTouchDown(qint32 id, const QPointF &globalPosition)
 
     if (id == 0 && hasPointer() && focusedTouchSurface()) {
         TouchInterfacePrivate *touchPrivate = TouchInterfacePrivate::get(d->touch.data());
-        if (touchPrivate->touchesForClient(focusedTouchSurface()->client()).isEmpty()) {
+        if (touchPrivate->focusedTouches.isEmpty()) {
             // If the client did not bind the touch interface fall back
             // to at least emulating touch through pointer events.
             d->pointer->setFocusedSurface(focusedTouchSurface(), pos, serial);
@@ -1088,55 +1378,107 @@ void SeatInterface::notifyTouchDown(qint32 id, const QPointF &globalPosition)
         }
     }
 
-    d->globalTouch.ids[id] = serial;
+    d->globalTouch.ids.insert(id, serial);
 }
 
 void SeatInterface::notifyTouchMotion(qint32 id, const QPointF &globalPosition)
 {
+    if (d->ddeSeat) {
+        d->ddeSeat->touchMotion(id, globalPosition);
+    }
     if (!d->touch) {
         return;
     }
-    auto itTouch = d->globalTouch.ids.constFind(id);
-    if (itTouch == d->globalTouch.ids.constEnd()) {
+    const quint32 *serial = d->globalTouch.ids.find(id);
+    if (!serial) {
         // This can happen in cases where the interaction started while the device was asleep
         qCWarning(KWAYLAND_SERVER) << "Detected a touch move that never has been down, discarding";
         return;
     }
 
-    const auto pos = globalPosition - d->globalTouch.focus.offset;
-    if (isDragTouch()) {
+    if (id == 0) {
+        d->globalTouch.focus.firstTouchPos = globalPosition;
+    }
+    if (d->touchMotionCoalescing) {
+        // only the last position of the touch point goes out with the frame
+        d->pendingTouchMotions.insert(id, globalPosition);
+        return;
+    }
+    d->sendTouchMotion(id, *serial, globalPosition);
+}
+
+void SeatInterfacePrivate::sendTouchMotion(qint32 id, quint32 serial, const QPointF &globalPosition)
+{
+    const auto pos = globalPosition - globalTouch.focus.offset;
+    if (q->isDragTouch()) {
         // handled by DataDevice
     } else {
-        d->touch->sendMotion(id, pos);
+        touch->sendMotion(id, pos);
     }
 
-    if (id == 0) {
-        d->globalTouch.focus.firstTouchPos = globalPosition;
+    if (id == 0 && pointer && globalTouch.focus.surface) {
+        TouchInterfacePrivate *touchPrivate = TouchInterfacePrivate::get(touch.data());
+        if (touchPrivate->focusedTouches.isEmpty()) {
+            // Client did not bind touch, fall back to emulating with pointer events.
+            pointer->sendMotion(pos);
+            pointer->sendFrame();
+        }
+    }
+    Q_EMIT q->touchMoved(id, serial, globalPosition);
+}
 
-        if (hasPointer() && focusedTouchSurface()) {
-            TouchInterfacePrivate *touchPrivate = TouchInterfacePrivate::get(d->touch.data());
-            if (touchPrivate->touchesForClient(focusedTouchSurface()->client()).isEmpty()) {
-                // Client did not bind touch, fall back to emulating with pointer events.
-                d->pointer->sendMotion(pos);
-                d->pointer->sendFrame();
-            }
+void SeatInterfacePrivate::flushTouchMotion()
+{
+    if (pendingTouchMotions.isEmpty()) {
+        return;
+    }
+    // the signal handlers might move the touch points again
+    const SmallFlatMap<qint32, QPointF, 10> motions = pendingTouchMotions;
+    pendingTouchMotions.clear();
+    for (const auto &motion : motions) {
+        const quint32 *serial = globalTouch.ids.find(motion.first);
+        if (touch && serial) {
+            sendTouchMotion(motion.first, *serial, motion.second);
         }
     }
-    Q_EMIT touchMoved(id, *itTouch, globalPosition);
+}
+
+void SeatInterface::setTouchMotionCoalescing(bool coalesce)
+{
+    if (d->touchMotionCoalescing == coalesce) {
+        return;
+    }
+    if (!coalesce) {
+        d->flushTouchMotion();
+    }
+    d->touchMotionCoalescing = coalesce;
+}
+
+bool SeatInterface::touchMotionCoalescing() const
+{
+    return d->touchMotionCoalescing;
+}
+
+void SeatInterface::flushTouchMotion()
+{
+    d->flushTouchMotion();
 }
 
 void SeatInterface::notifyTouchUp(qint32 id)
 {
+    if (d->ddeSeat) {
+        d->ddeSeat->touchUp(id);
+    }
     if (!d->touch) {
         return;
     }
 
-    auto itTouch = d->globalTouch.ids.find(id);
-    if (itTouch == d->globalTouch.ids.end()) {
+    if (!d->globalTouch.ids.contains(id)) {
         // This can happen in cases where the interaction started while the device was asleep
         qCWarning(KWAYLAND_SERVER) << "Detected a touch that never started, discarding";
         return;
     }
+    d->flushTouchMotion();
     const qint32 serial = d->display->nextSerial();
     if (d->drag.mode == SeatInterfacePrivate::Drag::Mode::Touch && d->drag.dragImplicitGrabSerial == d->globalTouch.ids.value(id)) {
         // the implicitly grabbing touch point has been upped
@@ -1146,7 +1488,7 @@ void SeatInterface::notifyTouchUp(qint32 id)
 
     if (id == 0 && hasPointer() && focusedTouchSurface()) {
         TouchInterfacePrivate *touchPrivate = TouchInterfacePrivate::get(d->touch.data());
-        if (touchPrivate->touchesForClient(focusedTouchSurface()->client()).isEmpty()) {
+        if (touchPrivate->focusedTouches.isEmpty()) {
             // Client did not bind touch, fall back to emulating with pointer events.
             const quint32 serial = display()->nextSerial();
             d->pointer->sendButton(BTN_LEFT, PointerButtonState::Released, serial);
@@ -1154,7 +1496,7 @@ void SeatInterface::notifyTouchUp(qint32 id)
         }
     }
 
-    d->globalTouch.ids.erase(itTouch);
+    d->globalTouch.ids.remove(id);
 }
 
 void SeatInterface::notifyTouchFrame()
@@ -1162,6 +1504,7 @@ void SeatInterface::notifyTouchFrame()
     if (!d->touch) {
         return;
     }
+    d->flushTouchMotion();
     d->touch->sendFrame();
 }
 
@@ -1171,6 +1514,15 @@ bool SeatInterface::hasImplicitTouchGrab(quint32 serial) const
         // origin surface has been destroyed
         return false;
     }
+    const SerialHistory::Entry *entry = DisplayPrivate::get(d->display)->serialHistory.find(serial);
+    if (entry) {
+        if (entry->seat != this || entry->event != SerialHistory::Event::TouchDown) {
+            return false;
+        }
+        const quint32 *touchSerial = d->globalTouch.ids.find(entry->id);
+        return touchSerial && *touchSerial == serial;
+    }
+    // the serial got evicted from the history, e.g. by a long press
     return d->globalTouch.ids.key(serial, -1) != -1;
 }
 
@@ -1191,10 +1543,17 @@ bool SeatInterface::isDragTouch() const
 
 bool SeatInterface::hasImplicitPointerGrab(quint32 serial) const
 {
-    const auto &serials = d->globalPointer.buttonSerials;
-    for (auto it = serials.constBegin(), end = serials.constEnd(); it != end; it++) {
-        if (it.value() == serial) {
-            return isPointerButtonPressed(it.key());
+    const SerialHistory::Entry *entry = DisplayPrivate::get(d->display)->serialHistory.find(serial);
+    if (entry) {
+        if (entry->seat != this || entry->event != SerialHistory::Event::PointerButtonPress) {
+            return false;
+        }
+        return pointerButtonSerial(quint32(entry->id)) == serial && isPointerButtonPressed(quint32(entry->id));
+    }
+    // the serial got evicted from the history, e.g. by a long press
+    for (const auto &buttonSerial : d->globalPointer.buttonSerials) {
+        if (buttonSerial.second == serial) {
+            return isPointerButtonPressed(buttonSerial.first);
         }
     }
     return false;
@@ -1286,6 +1645,14 @@ void SeatInterface::setSelection(AbstractDataSource *selection)
         return;
     }
 
+    if (d->clipboardCacheEnabled && selection && !qobject_cast<ClipboardCache *>(selection)) {
+        auto cache = qobject_cast<ClipboardCache *>(d->currentSelection);
+        if (cache && cache->source() == selection) {
+            return;
+        }
+        selection = new ClipboardCache(selection, d->clipboardCacheLimit, this);
+    }
+
     if (d->currentSelection) {
         d->currentSelection->cancel();
         disconnect(d->currentSelection, nullptr, this, nullptr);
@@ -1323,6 +1690,26 @@ void SeatInterface::setSelection(AbstractDataSource *selection)
     Q_EMIT selectionChanged(selection);
 }
 
+void SeatInterface::setClipboardCacheEnabled(bool enabled)
+{
+    d->clipboardCacheEnabled = enabled;
+}
+
+bool SeatInterface::isClipboardCacheEnabled() const
+{
+    return d->clipboardCacheEnabled;
+}
+
+void SeatInterface::setClipboardCacheLimit(qint64 bytes)
+{
+    d->clipboardCacheLimit = bytes;
+}
+
+qint64 SeatInterface::clipboardCacheLimit() const
+{
+    return d->clipboardCacheLimit;
+}
+
 AbstractDataSource *SeatInterface::primarySelection() const
 {
     return d->currentPrimarySelection;
@@ -1347,22 +1734,56 @@ void SeatInterface::setPrimarySelection(AbstractDataSource *selection)
 
     d->currentPrimarySelection = selection;
 
-    for (auto focussedSelection : qAsConst(d->globalKeyboard.focus.primarySelections)) {
+    // while a client keeps changing the selection, e.g. during a drag-select, only its last
+    // selection is sent once the changes settle
+    const bool sameClient = selection && d->primarySelectionClient && selection->client() == d->primarySelectionClient;
+    if (sameClient && d->primarySelectionTimer.isActive()) {
+        d->primarySelectionPending = true;
+        d->primarySelectionTimer.start();
+    } else {
+        d->broadcastPrimarySelection();
+        if (selection && d->primarySelectionTimer.interval() > 0) {
+            d->primarySelectionTimer.start();
+        }
+    }
+
+    Q_EMIT primarySelectionChanged(selection);
+}
+
+void SeatInterfacePrivate::broadcastPrimarySelection()
+{
+    primarySelectionTimer.stop();
+    primarySelectionPending = false;
+    AbstractDataSource *selection = currentPrimarySelection;
+    primarySelectionClient = selection ? selection->client() : nullptr;
+
+    for (auto focussedSelection : qAsConst(globalKeyboard.focus.primarySelections)) {
         if (selection) {
             focussedSelection->sendSelection(selection);
         } else {
             focussedSelection->sendClearSelection();
         }
     }
-    for (auto control : qAsConst(d->dataControlDevices)) {
+    for (auto control : qAsConst(dataControlDevices)) {
         if (selection) {
             control->sendPrimarySelection(selection);
         } else {
             control->sendClearPrimarySelection();
         }
     }
+}
 
-    Q_EMIT primarySelectionChanged(selection);
+void SeatInterface::setPrimarySelectionDebounceInterval(std::chrono::milliseconds interval)
+{
+    d->primarySelectionTimer.setInterval(interval);
+    if (interval.count() <= 0 && d->primarySelectionPending) {
+        d->broadcastPrimarySelection();
+    }
+}
+
+std::chrono::milliseconds SeatInterface::primarySelectionDebounceInterval() const
+{
+    return std::chrono::milliseconds(d->primarySelectionTimer.interval());
 }
 
 void SeatInterface::startDrag(AbstractDataSource *dragSource, SurfaceInterface *originSurface, int dragSerial, DragAndDropIcon *dragIcon)
@@ -1390,9 +1811,7 @@ void SeatInterface::startDrag(AbstractDataSource *dragSource, SurfaceInterface *
     }
     d->drag.dragIcon = dragIcon;
 
-    if (!d->dataDevicesForSurface(originSurface).isEmpty()) {
-        d->drag.target = d->dataDevicesForSurface(originSurface)[0];
-    }
+    d->drag.target = d->dataDeviceForSurface(originSurface);
     if (d->drag.target) {
         d->drag.target->updateDragTarget(originSurface, dragSerial);
     }
@@ -12,6 +12,8 @@
 #include <QObject>
 #include <QPoint>
 
+#include <chrono>
+
 struct wl_client;
 struct wl_resource;
 
@@ -21,8 +23,10 @@ class AbstractDataSource;
 class AbstractDropHandler;
 class DragAndDropIcon;
 class DataDeviceInterface;
+class DDESeatInterface;
 class Display;
 class KeyboardInterface;
+class KeyboardShortcutsInhibitorV1Interface;
 class PointerInterface;
 class SeatInterfacePrivate;
 class SurfaceInterface;
@@ -171,6 +175,24 @@ public:
     void setTimestamp(quint32 time);
     quint32 timestamp() const;
 
+    /**
+     * Mirrors the input of this seat to the listeners of @p ddeSeat.
+     *
+     * The timestamp and the notify methods for pointer, keyboard and touch events then also
+     * feed @p ddeSeat, so the compositor passes every input event once instead of calling
+     * both seats. State both seats depend on is updated once: the timestamp is used for the
+     * pointer and the touch events of @p ddeSeat, and the pressed keys are tracked by the
+     * keyboard of this seat. The input reaches @p ddeSeat even while this seat lacks the
+     * capability, the dde listeners follow the global input rather than a focused surface.
+     *
+     * While mirroring, the input must not be passed to @p ddeSeat directly as well.
+     * Pass @c nullptr to stop mirroring.
+     *
+     * @see DDESeatInterface::setMotionInterval
+     */
+    void setDDESeat(DDESeatInterface *ddeSeat);
+    DDESeatInterface *ddeSeat() const;
+
     /**
      * @name Drag'n'Drop related methods
      */
@@ -239,6 +261,62 @@ public:
      * Sends a pointer motion event to the focused pointer surface.
      */
     void notifyPointerMotion(const QPointF &pos);
+    /**
+     * Enables or disables pointer motion coalescing.
+     *
+     * If enabled, notifyPointerMotion and relativePointerMotion only record the new position
+     * and accumulate the relative motion deltas. The motion is sent to the focused client
+     * together with a single frame event when the Display is flushed, i.e. at most once per
+     * dispatch cycle. Any other pointer event flushes the pending motion first to keep the
+     * order of the events intact.
+     *
+     * The pointerPosChanged signal is still emitted for every position change.
+     *
+     * Coalescing is disabled by default.
+     *
+     * @see flushPointerMotion
+     */
+    void setPointerMotionCoalescing(bool coalesce);
+    /**
+     * @returns whether pointer motion coalescing is enabled
+     * @see setPointerMotionCoalescing
+     */
+    bool pointerMotionCoalescing() const;
+    /**
+     * Sends out the pointer motion that has been coalesced since the last flush.
+     *
+     * This is done implicitly by Display::flush. The motion is kept pending while the client
+     * of the focused surface is congested, other pointer events still flush it.
+     * @see setPointerMotionCoalescing
+     * @see ClientConnection::isCongested
+     */
+    void flushPointerMotion();
+    /**
+     * Enables or disables pointer gesture coalescing.
+     *
+     * If enabled, updatePointerSwipeGesture and updatePointerPinchGesture only accumulate the
+     * update. The deltas and the rotation are summed up, the scale is the latest one. The
+     * accumulated update is sent to the focused client when the Display is flushed, i.e. at
+     * most once per dispatch cycle. Starting, ending or cancelling a gesture sends the pending
+     * update first to keep the order of the events intact.
+     *
+     * Coalescing is disabled by default.
+     *
+     * @see flushPointerGestures
+     */
+    void setPointerGestureCoalescing(bool coalesce);
+    /**
+     * @returns whether pointer gesture coalescing is enabled
+     * @see setPointerGestureCoalescing
+     */
+    bool pointerGestureCoalescing() const;
+    /**
+     * Sends out the gesture update that has been coalesced since the last flush.
+     *
+     * This is done implicitly by Display::flush.
+     * @see setPointerGestureCoalescing
+     */
+    void flushPointerGestures();
     /**
      * @returns the global pointer position
      */
@@ -408,10 +486,14 @@ public:
      * Sending relative pointer events only makes sense if the RelativePointerManagerInterface
      * is created on the Display.
      *
+     * With pointer motion coalescing enabled the deltas are summed up and sent as one event
+     * carrying the last @p microseconds timestamp when the Display is flushed.
+     *
      * @param delta Motion vector
      * @param deltaNonAccelerated non-accelerated motion vector
      * @param microseconds timestamp with microseconds granularity
      * @see setPointerPos
+     * @see setPointerMotionCoalescing
      */
     void relativePointerMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, quint64 microseconds);
 
@@ -445,6 +527,7 @@ public:
      * @see startPointerSwipeGesture
      * @see endPointerSwipeGesture
      * @see cancelPointerSwipeGesture
+     * @see setPointerGestureCoalescing
      */
     void updatePointerSwipeGesture(const QSizeF &delta);
 
@@ -498,6 +581,7 @@ public:
      * @see startPointerPinchGesture
      * @see endPointerPinchGesture
      * @see cancelPointerPinchGesture
+     * @see setPointerGestureCoalescing
      */
     void updatePointerPinchGesture(const QSizeF &delta, qreal scale, qreal rotation);
 
@@ -565,6 +649,14 @@ public:
      */
     void setFocusedKeyboardSurface(SurfaceInterface *surface);
     SurfaceInterface *focusedKeyboardSurface() const;
+    /**
+     * @returns the keyboard shortcuts inhibitor of the focused keyboard surface for this seat,
+     * or @c nullptr if it doesn't inhibit shortcuts. Global shortcuts shouldn't be triggered
+     * while it is active. The inhibitor is looked up when the focus or the inhibitors change,
+     * so this is cheap enough to be called for every key press.
+     * @see KeyboardShortcutsInhibitorV1Interface::isActive
+     */
+    KeyboardShortcutsInhibitorV1Interface *focusedKeyboardShortcutsInhibitor() const;
     KeyboardInterface *keyboard() const;
     void notifyKeyboardKey(quint32 keyCode, KeyboardKeyState state);
     void notifyKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group);
@@ -584,6 +676,32 @@ public:
     void notifyTouchMotion(qint32 id, const QPointF &globalPosition);
     void notifyTouchFrame();
     void notifyTouchCancel();
+    /**
+     * Enables or disables touch motion coalescing.
+     *
+     * If enabled, notifyTouchMotion only records the new position of the touch point. The
+     * last position of every touch point that moved is sent to the focused client with the
+     * next notifyTouchFrame, so a multi-finger gesture costs one motion event per touch point
+     * and frame. The touchMoved signal is emitted at the same time. Any other touch event
+     * sends the pending motion first to keep the order of the events intact.
+     *
+     * Coalescing is disabled by default.
+     *
+     * @see flushTouchMotion
+     */
+    void setTouchMotionCoalescing(bool coalesce);
+    /**
+     * @returns whether touch motion coalescing is enabled
+     * @see setTouchMotionCoalescing
+     */
+    bool touchMotionCoalescing() const;
+    /**
+     * Sends out the touch motion that has been coalesced since the last frame.
+     *
+     * This is done implicitly by notifyTouchFrame and Display::flush.
+     * @see setTouchMotionCoalescing
+     */
+    void flushTouchMotion();
     bool isTouchSequence() const;
     QPointF firstTouchPointPosition() const;
     /**
@@ -660,9 +778,45 @@ public:
 
     void updateCachedSelection(AbstractDataSource *selection);
 
+    /**
+     * Enables the clipboard cache of this seat. The cache is disabled by default.
+     *
+     * While it is enabled, every new clipboard selection is wrapped in a server side data
+     * source that reads all offered mime types from the source client once and serves the
+     * receive requests of all clients, including data control clients, from memory. The
+     * selection stays available after the source client goes away. Consequently selection()
+     * and selectionChanged() refer to the wrapping data source.
+     *
+     * The compositor should ignore SIGPIPE, a paste into a client that closes its end of the
+     * pipe early can raise it.
+     *
+     * @see setClipboardCacheLimit
+     */
+    void setClipboardCacheEnabled(bool enabled);
+    bool isClipboardCacheEnabled() const;
+    /**
+     * Sets the maximum number of bytes the clipboard cache keeps for one selection, 64 MiB
+     * by default. Mime types that don't fit anymore are transferred from the source client
+     * directly, as long as it exists.
+     */
+    void setClipboardCacheLimit(qint64 bytes);
+    qint64 clipboardCacheLimit() const;
+
     KWaylandServer::AbstractDataSource *primarySelection() const;
     void setPrimarySelection(AbstractDataSource *selection);
 
+    /**
+     * Sets the time to wait for further primary selection changes of the same client before
+     * they are sent to the other clients, 0 by default.
+     *
+     * Selecting text by dragging changes the primary selection many times per second. With a
+     * debounce interval only the first change and the last one of such a series are sent to
+     * the primary selection and data control devices. primarySelection() and
+     * primarySelectionChanged() are not delayed.
+     */
+    void setPrimarySelectionDebounceInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds primarySelectionDebounceInterval() const;
+
     void startDrag(AbstractDataSource *source, SurfaceInterface *sourceSurface, int dragSerial = -1, DragAndDropIcon *dragIcon = nullptr);
 
     /**
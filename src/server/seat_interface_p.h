@@ -8,10 +8,13 @@
 
 // KWayland
 #include "seat_interface.h"
+#include "serialhistory.h"
+#include "utils_p.h"
 // Qt
 #include <QHash>
-#include <QMap>
 #include <QPointer>
+#include <QSizeF>
+#include <QTimer>
 #include <QVector>
 
 #include "qwayland-server-wayland.h"
@@ -26,6 +29,7 @@ class TextInputV2Interface;
 class TextInputV3Interface;
 class PrimarySelectionDeviceV1Interface;
 class DragAndDropIcon;
+class KeyboardShortcutsInhibitorV1Interface;
 
 class SeatInterfacePrivate : public QtWaylandServer::wl_seat
 {
@@ -35,12 +39,23 @@ public:
     SeatInterfacePrivate(SeatInterface *q, Display *display);
 
     void sendCapabilities();
-    QVector<DataDeviceInterface *> dataDevicesForSurface(SurfaceInterface *surface) const;
+    QList<DataDeviceInterface *> dataDevicesForSurface(SurfaceInterface *surface) const;
+    QList<PrimarySelectionDeviceV1Interface *> primarySelectionDevicesForSurface(SurfaceInterface *surface) const;
+    DataDeviceInterface *dataDeviceForSurface(SurfaceInterface *surface) const;
     void registerPrimarySelectionDevice(PrimarySelectionDeviceV1Interface *primarySelectionDevice);
     void registerDataDevice(DataDeviceInterface *dataDevice);
     void registerDataControlDevice(DataControlDeviceV1Interface *dataDevice);
+    void registerShortcutsInhibitor(KeyboardShortcutsInhibitorV1Interface *inhibitor);
     void endDrag(quint32 serial);
     void cancelDrag(quint32 serial);
+    // deliver the keys and modifiers of the seat as well as those of virtual keyboards
+    void notifyKeyboardKey(quint32 keyCode, KeyboardKeyState state);
+    void notifyKeyboardModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group);
+    /**
+     * Switches back to the keymap and the modifiers of the seat after a virtual keyboard has
+     * used its own, called before the next key or modifiers of the seat are delivered.
+     */
+    void restoreSeatKeyboard();
 
     SeatInterface *q;
     QPointer<Display> display;
@@ -49,15 +64,26 @@ public:
     quint32 accumulatedCapabilities = 0;
     quint32 capabilities = 0;
     QScopedPointer<KeyboardInterface> keyboard;
+    // the last modifiers of the seat, replaced once a virtual keyboard sends its own
+    struct {
+        quint32 depressed = 0;
+        quint32 latched = 0;
+        quint32 locked = 0;
+        quint32 group = 0;
+        bool replaced = false;
+    } seatModifiers;
     QScopedPointer<PointerInterface> pointer;
     QScopedPointer<TouchInterface> touch;
-    QVector<DataDeviceInterface *> dataDevices;
-    QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices;
+    // indexed by client, so a focus change only looks up the devices of the focused client
+    ClientResources<DataDeviceInterface> dataDevices;
+    ClientResources<PrimarySelectionDeviceV1Interface> primarySelectionDevices;
     QVector<DataControlDeviceV1Interface *> dataControlDevices;
+    QHash<SurfaceInterface *, KeyboardShortcutsInhibitorV1Interface *> shortcutsInhibitors;
 
     // TextInput v2
     QPointer<TextInputV2Interface> textInputV2;
     QPointer<TextInputV3Interface> textInputV3;
+    QPointer<DDESeatInterface> ddeSeat;
 
     SurfaceInterface *focusedTextInputSurface = nullptr;
     QMetaObject::Connection focusedSurfaceDestroyConnection;
@@ -66,6 +92,12 @@ public:
     AbstractDataSource *currentSelection = nullptr;
     AbstractDataSource *currentPrimarySelection = nullptr;
     AbstractDataSource *currentCachedSelection = nullptr;
+    bool clipboardCacheEnabled = false;
+    qint64 clipboardCacheLimit = 64 * 1024 * 1024;
+    // the client of the last broadcast primary selection, to debounce its follow-up changes
+    wl_client *primarySelectionClient = nullptr;
+    QTimer primarySelectionTimer;
+    bool primarySelectionPending = false;
 
     // Pointer related members
     struct Pointer {
@@ -73,8 +105,8 @@ public:
             Released,
             Pressed,
         };
-        QHash<quint32, quint32> buttonSerials;
-        QHash<quint32, State> buttonStates;
+        SmallFlatMap<quint32, quint32> buttonSerials;
+        SmallFlatMap<quint32, State> buttonStates;
         QPointF pos;
         struct Focus {
             SurfaceInterface *surface = nullptr;
@@ -86,8 +118,48 @@ public:
         Focus focus;
     };
     Pointer globalPointer;
+    /**
+     * Returns the next serial of the display and records it with @p event of the button or
+     * touch point @p id, so grabs can be validated with the SerialHistory.
+     */
+    quint32 nextSerial(SerialHistory::Event event, qint32 id);
     void updatePointerButtonSerial(quint32 button, quint32 serial);
     void updatePointerButtonState(quint32 button, Pointer::State state);
+    void sendPointerMotion();
+    void flushPointerMotion();
+    /**
+     * Whether the client of the focused pointer surface is congested, its motion is coalesced
+     * until the client is relieved.
+     */
+    bool isPointerFocusCongested() const;
+
+    // Motion that is pending to be sent out if pointer motion coalescing is enabled
+    struct PendingPointerMotion {
+        bool motion = false;
+        bool relativeMotion = false;
+        bool frame = false;
+        QSizeF delta;
+        QSizeF deltaNonAccelerated;
+        quint64 microseconds = 0;
+    };
+    bool pointerMotionCoalescing = false;
+    PendingPointerMotion pendingPointerMotion;
+
+    // Gesture update that is pending to be sent out if pointer gesture coalescing is enabled
+    struct PendingPointerGesture {
+        enum class Type {
+            None,
+            Swipe,
+            Pinch,
+        };
+        Type type = Type::None;
+        QSizeF delta;
+        qreal scale = 1.0;
+        qreal rotation = 0.0;
+    };
+    void flushPointerGestures();
+    bool pointerGestureCoalescing = false;
+    PendingPointerGesture pendingPointerGesture;
 
     // Keyboard related members
     struct Keyboard {
@@ -95,8 +167,10 @@ public:
             SurfaceInterface *surface = nullptr;
             QMetaObject::Connection destroyConnection;
             quint32 serial = 0;
-            QVector<DataDeviceInterface *> selections;
-            QVector<PrimarySelectionDeviceV1Interface *> primarySelections;
+            QList<DataDeviceInterface *> selections;
+            QList<PrimarySelectionDeviceV1Interface *> primarySelections;
+            // looked up on focus changes, the compositor checks it on every key press
+            KeyboardShortcutsInhibitorV1Interface *shortcutsInhibitor = nullptr;
         };
         Focus focus;
     };
@@ -112,9 +186,17 @@ public:
             QMatrix4x4 transformation;
         };
         Focus focus;
-        QMap<qint32, quint32> ids;
+        // the serial of the down event of each touch point
+        SmallFlatMap<qint32, quint32, 10> ids;
     };
     Touch globalTouch;
+    void sendTouchMotion(qint32 id, quint32 serial, const QPointF &globalPosition);
+    void flushTouchMotion();
+
+    // The global positions of the touch points that moved since the last frame if touch motion
+    // coalescing is enabled
+    bool touchMotionCoalescing = false;
+    SmallFlatMap<qint32, QPointF, 10> pendingTouchMotions;
 
     struct Drag {
         enum class Mode {
@@ -130,6 +212,9 @@ public:
         QMatrix4x4 transformation;
         quint32 dragImplicitGrabSerial = -1;
         QMetaObject::Connection dragSourceDestroyConnection;
+        // whether the pointer focus has a data device, looked up once per focus change
+        QPointer<SurfaceInterface> pointerFocus;
+        bool pointerFocusHasDataDevice = false;
     };
     Drag drag;
 
@@ -143,6 +228,7 @@ protected:
 private:
     void updateSelection(DataDeviceInterface *dataDevice);
     void updatePrimarySelection(PrimarySelectionDeviceV1Interface *primarySelectionDevice);
+    void broadcastPrimarySelection();
 };
 
 } // namespace KWaylandServer
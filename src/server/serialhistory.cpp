@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "serialhistory.h"
+
+namespace KWaylandServer
+{
+void SerialHistory::record(const Entry &entry)
+{
+    Q_ASSERT(entry.event != Event::None);
+    m_entries[entry.serial & (s_size - 1)] = entry;
+}
+
+const SerialHistory::Entry *SerialHistory::find(quint32 serial) const
+{
+    const Entry &entry = m_entries[serial & (s_size - 1)];
+    if (entry.event == Event::None || entry.serial != serial) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+} // namespace KWaylandServer
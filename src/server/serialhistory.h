@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+namespace KWaylandServer
+{
+class SeatInterface;
+class SurfaceInterface;
+
+/**
+ * Remembers which input event the recent serials of a Display were sent with, so a serial
+ * passed back by a client, e.g. with xdg_toplevel.move, xdg_popup.grab or
+ * wl_data_device.start_drag, can be validated without scanning the state of the seats.
+ *
+ * The history is a direct mapped ring indexed by the low bits of the serial. Recording and
+ * looking up a serial is O(1); an entry is overwritten by the next recorded serial that maps
+ * to the same slot, so a lookup can miss for a serial that is still in use, e.g. a button
+ * held during a long drag. Callers have to fall back to the state of the seat in that case.
+ *
+ * The history of a Display is available through DisplayPrivate::serialHistory.
+ */
+class SerialHistory
+{
+public:
+    enum class Event {
+        None,
+        PointerButtonPress,
+        TouchDown,
+    };
+
+    struct Entry {
+        quint32 serial = 0;
+        Event event = Event::None;
+        SeatInterface *seat = nullptr;
+        /**
+         * The focused surface when the event was sent, it is only compared and may be dangling.
+         */
+        SurfaceInterface *surface = nullptr;
+        /**
+         * The button of a pointer event or the id of a touch point.
+         */
+        qint32 id = 0;
+        quint32 timestamp = 0;
+    };
+
+    void record(const Entry &entry);
+    /**
+     * Returns the entry for @p serial, or @c nullptr if it was not recorded or got evicted.
+     */
+    const Entry *find(quint32 serial) const;
+
+private:
+    static constexpr quint32 s_size = 256;
+    static_assert((s_size & (s_size - 1)) == 0, "the size of the history has to be a power of two");
+
+    std::array<Entry, s_size> m_entries;
+};
+
+} // namespace KWaylandServer
@@ -7,8 +7,7 @@
 #include "display.h"
 #include "logging.h"
 #include "surface_interface.h"
-
-#include <QVector>
+#include "surface_interface_p.h"
 
 #include <optional>
 
@@ -24,6 +23,8 @@ public:
     ServerSideDecorationManagerInterfacePrivate(ServerSideDecorationManagerInterface *_q, Display *display);
     void setDefaultMode(ServerSideDecorationManagerInterface::Mode mode);
 
+    static wl_resource *resourceForDecoration(ServerSideDecorationInterface *decoration);
+
     ServerSideDecorationManagerInterface::Mode defaultMode = ServerSideDecorationManagerInterface::Mode::None;
     ServerSideDecorationManagerInterface *q;
 
@@ -60,6 +61,7 @@ void ServerSideDecorationManagerInterfacePrivate::org_kde_kwin_server_decoration
         return;
     }
     auto decoration = new ServerSideDecorationInterface(q, s, decorationResource);
+    SurfaceInterfacePrivate::get(s)->serverDecorationExtension = decoration;
     decoration->setMode(defaultMode);
     Q_EMIT q->decorationCreated(decoration);
 }
@@ -111,9 +113,7 @@ public:
                                          ServerSideDecorationInterface *_q,
                                          SurfaceInterface *surface,
                                          wl_resource *resource);
-    ~ServerSideDecorationInterfacePrivate();
 
-    static ServerSideDecorationInterface *get(SurfaceInterface *surface);
     void setMode(ServerSideDecorationManagerInterface::Mode mode);
 
     ServerSideDecorationManagerInterface *manager;
@@ -123,7 +123,6 @@ public:
 
 private:
     ServerSideDecorationInterface *q;
-    static QVector<ServerSideDecorationInterfacePrivate *> s_all;
 
 protected:
     void org_kde_kwin_server_decoration_destroy_resource(Resource *resource) override;
@@ -131,8 +130,6 @@ protected:
     void org_kde_kwin_server_decoration_request_mode(Resource *resource, uint32_t mode) override;
 };
 
-QVector<ServerSideDecorationInterfacePrivate *> ServerSideDecorationInterfacePrivate::s_all;
-
 void ServerSideDecorationInterfacePrivate::org_kde_kwin_server_decoration_request_mode(Resource *resource, uint32_t mode)
 {
     Q_UNUSED(resource)
@@ -167,16 +164,6 @@ void ServerSideDecorationInterfacePrivate::org_kde_kwin_server_decoration_destro
     delete q;
 }
 
-ServerSideDecorationInterface *ServerSideDecorationInterfacePrivate::get(SurfaceInterface *surface)
-{
-    for (ServerSideDecorationInterfacePrivate *decoration : qAsConst(s_all)) {
-        if (decoration->surface == surface) {
-            return decoration->q;
-        }
-    }
-    return nullptr;
-}
-
 ServerSideDecorationInterfacePrivate::ServerSideDecorationInterfacePrivate(ServerSideDecorationManagerInterface *manager,
                                                                            ServerSideDecorationInterface *_q,
                                                                            SurfaceInterface *surface,
@@ -186,12 +173,6 @@ ServerSideDecorationInterfacePrivate::ServerSideDecorationInterfacePrivate(Serve
     , surface(surface)
     , q(_q)
 {
-    s_all << this;
-}
-
-ServerSideDecorationInterfacePrivate::~ServerSideDecorationInterfacePrivate()
-{
-    s_all.removeAll(this);
 }
 
 void ServerSideDecorationInterfacePrivate::setMode(ServerSideDecorationManagerInterface::Mode mode)
@@ -200,6 +181,16 @@ void ServerSideDecorationInterfacePrivate::setMode(ServerSideDecorationManagerIn
     send_mode(modeWayland(mode));
 }
 
+wl_resource *ServerSideDecorationManagerInterfacePrivate::resourceForDecoration(ServerSideDecorationInterface *decoration)
+{
+    return decoration->d->resource()->handle;
+}
+
+void addWeakHandleListener(ServerSideDecorationInterface *decoration, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(ServerSideDecorationManagerInterfacePrivate::resourceForDecoration(decoration), listener);
+}
+
 ServerSideDecorationInterface::ServerSideDecorationInterface(ServerSideDecorationManagerInterface *manager, SurfaceInterface *surface, wl_resource *resource)
     : QObject()
     , d(new ServerSideDecorationInterfacePrivate(manager, this, surface, resource))
@@ -230,7 +221,10 @@ SurfaceInterface *ServerSideDecorationInterface::surface() const
 
 ServerSideDecorationInterface *ServerSideDecorationInterface::get(SurfaceInterface *surface)
 {
-    return ServerSideDecorationInterfacePrivate::get(surface);
+    if (!surface) {
+        return nullptr;
+    }
+    return SurfaceInterfacePrivate::get(surface)->serverDecorationExtension;
 }
 
 }
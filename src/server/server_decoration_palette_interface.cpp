@@ -7,6 +7,8 @@
 #include "display.h"
 #include "logging.h"
 #include "surface_interface.h"
+#include "surface_interface_p.h"
+#include "utils_p.h"
 
 #include <QtGlobal>
 
@@ -21,7 +23,8 @@ class ServerSideDecorationPaletteManagerInterfacePrivate : public QtWaylandServe
 public:
     ServerSideDecorationPaletteManagerInterfacePrivate(ServerSideDecorationPaletteManagerInterface *q, Display *display);
 
-    QVector<ServerSideDecorationPaletteInterface *> palettes;
+    static wl_resource *resourceForPalette(ServerSideDecorationPaletteInterface *palette);
+
     ServerSideDecorationPaletteManagerInterface *q;
 
 protected:
@@ -45,11 +48,7 @@ void ServerSideDecorationPaletteManagerInterfacePrivate::org_kde_kwin_server_dec
         return;
     }
     auto palette = new ServerSideDecorationPaletteInterface(s, palette_resource);
-
-    palettes.append(palette);
-    QObject::connect(palette, &QObject::destroyed, q, [=]() {
-        palettes.removeOne(palette);
-    });
+    SurfaceInterfacePrivate::get(s)->serverDecorationPaletteExtension = palette;
     Q_EMIT q->paletteCreated(palette);
 }
 
@@ -70,12 +69,10 @@ ServerSideDecorationPaletteManagerInterface::~ServerSideDecorationPaletteManager
 
 ServerSideDecorationPaletteInterface *ServerSideDecorationPaletteManagerInterface::paletteForSurface(SurfaceInterface *surface)
 {
-    for (ServerSideDecorationPaletteInterface *menu : qAsConst(d->palettes)) {
-        if (menu->surface() == surface) {
-            return menu;
-        }
+    if (!surface) {
+        return nullptr;
     }
-    return nullptr;
+    return SurfaceInterfacePrivate::get(surface)->serverDecorationPaletteExtension;
 }
 
 class ServerSideDecorationPaletteInterfacePrivate : public QtWaylandServer::org_kde_kwin_server_decoration_palette
@@ -105,7 +102,7 @@ void ServerSideDecorationPaletteInterfacePrivate::org_kde_kwin_server_decoration
     if (this->palette == palette) {
         return;
     }
-    this->palette = palette;
+    this->palette = StringPool::intern(palette);
     Q_EMIT q->paletteChanged(this->palette);
 }
 
@@ -124,6 +121,16 @@ ServerSideDecorationPaletteInterfacePrivate::ServerSideDecorationPaletteInterfac
 {
 }
 
+wl_resource *ServerSideDecorationPaletteManagerInterfacePrivate::resourceForPalette(ServerSideDecorationPaletteInterface *palette)
+{
+    return palette->d->resource()->handle;
+}
+
+void addWeakHandleListener(ServerSideDecorationPaletteInterface *palette, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(ServerSideDecorationPaletteManagerInterfacePrivate::resourceForPalette(palette), listener);
+}
+
 ServerSideDecorationPaletteInterface::ServerSideDecorationPaletteInterface(SurfaceInterface *surface, wl_resource *resource)
     : QObject()
     , d(new ServerSideDecorationPaletteInterfacePrivate(this, surface, resource))
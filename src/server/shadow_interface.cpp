@@ -6,8 +6,12 @@
 #include "shadow_interface.h"
 #include "clientbuffer.h"
 #include "display.h"
+#include "shmclientbuffer.h"
 #include "surface_interface_p.h"
 
+#include <QHash>
+#include <QVector>
+
 #include <qwayland-server-shadow.h>
 
 namespace KWaylandServer
@@ -19,9 +23,29 @@ class ShadowManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_shado
 public:
     ShadowManagerInterfacePrivate(ShadowManagerInterface *_q, Display *display);
 
+    /**
+     * Returns the resource of @p shadow, it is destroyed together with it.
+     */
+    static wl_resource *resourceForShadow(ShadowInterface *shadow);
+
+    static ShadowManagerInterfacePrivate *get(ShadowManagerInterface *manager)
+    {
+        return manager->d.data();
+    }
+
+    QImage acquireTile(ClientBuffer *buffer);
+    void releaseTile(const QImage &image);
+
     ShadowManagerInterface *q;
     Display *display;
 
+    struct Tile {
+        QImage image;
+        int refCount = 0;
+    };
+    // the unique tiles of all shadows, by the hash of their pixels
+    QHash<uint, QVector<Tile>> tiles;
+
 protected:
     void org_kde_kwin_shadow_manager_create(Resource *resource, uint32_t id, wl_resource *surface) override;
     void org_kde_kwin_shadow_manager_unset(Resource *resource, wl_resource *surface) override;
@@ -35,6 +59,66 @@ ShadowManagerInterfacePrivate::ShadowManagerInterfacePrivate(ShadowManagerInterf
 {
 }
 
+static uint tileHash(const QImage &image)
+{
+    // only the pixels count, not the padding at the end of the rows
+    const int rowBytes = image.width() * image.depth() / 8;
+    uint hash = qHash(image.width()) ^ qHash(image.height()) ^ qHash(int(image.format()));
+    for (int y = 0; y < image.height(); ++y) {
+        hash = qHashBits(image.constScanLine(y), rowBytes, hash);
+    }
+    return hash;
+}
+
+QImage ShadowManagerInterfacePrivate::acquireTile(ClientBuffer *buffer)
+{
+    auto shmBuffer = qobject_cast<ShmClientBuffer *>(buffer);
+    if (!shmBuffer) {
+        return QImage();
+    }
+    const QImage data = shmBuffer->data();
+    if (data.isNull()) {
+        return QImage();
+    }
+
+    QVector<Tile> &candidates = tiles[tileHash(data)];
+    for (Tile &tile : candidates) {
+        if (tile.image == data) {
+            tile.refCount++;
+            return tile.image;
+        }
+    }
+    Tile tile;
+    tile.image = data.copy();
+    tile.refCount = 1;
+    candidates.append(tile);
+    return tile.image;
+}
+
+void ShadowManagerInterfacePrivate::releaseTile(const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    auto it = tiles.find(tileHash(image));
+    if (it == tiles.end()) {
+        return;
+    }
+    for (int i = 0; i < it->count(); ++i) {
+        Tile &tile = (*it)[i];
+        if (tile.image.cacheKey() != image.cacheKey()) {
+            continue;
+        }
+        if (--tile.refCount == 0) {
+            it->remove(i);
+            if (it->isEmpty()) {
+                tiles.erase(it);
+            }
+        }
+        return;
+    }
+}
+
 void ShadowManagerInterfacePrivate::org_kde_kwin_shadow_manager_destroy(Resource *resource)
 {
     wl_resource_destroy(resource->handle);
@@ -57,7 +141,7 @@ void ShadowManagerInterfacePrivate::org_kde_kwin_shadow_manager_create(Resource
     auto shadow = new ShadowInterface(q, shadow_resource);
 
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->setShadow(QPointer<ShadowInterface>(shadow));
+    surfacePrivate->setShadow(shadow);
 }
 
 void ShadowManagerInterfacePrivate::org_kde_kwin_shadow_manager_unset(Resource *resource, wl_resource *surface)
@@ -69,7 +153,7 @@ void ShadowManagerInterfacePrivate::org_kde_kwin_shadow_manager_unset(Resource *
         return;
     }
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->setShadow(QPointer<ShadowInterface>());
+    surfacePrivate->setShadow(nullptr);
 }
 
 ShadowManagerInterface::ShadowManagerInterface(Display *display, QObject *parent)
@@ -118,10 +202,12 @@ public:
 
     void commit();
     void attach(State::Flags flag, wl_resource *buffer);
+    void updateTile(ShadowInterface::Tile tile, ClientBuffer *buffer);
 
-    ShadowManagerInterface *manager;
+    QPointer<ShadowManagerInterface> manager;
     State current;
     State pending;
+    QImage tiles[8];
     ShadowInterface *q;
 
 protected:
@@ -154,6 +240,7 @@ void ShadowInterfacePrivate::org_kde_kwin_shadow_commit(Resource *resource)
             pending.__PART__->ref();                                                                                                                           \
         }                                                                                                                                                      \
         current.__PART__ = pending.__PART__;                                                                                                                   \
+        updateTile(ShadowInterface::Tile::__FLAG__, current.__PART__);                                                                                         \
     }
     BUFFER(Left, left)
     BUFFER(TopLeft, topLeft)
@@ -171,6 +258,19 @@ void ShadowInterfacePrivate::org_kde_kwin_shadow_commit(Resource *resource)
     pending = State();
 }
 
+void ShadowInterfacePrivate::updateTile(ShadowInterface::Tile tile, ClientBuffer *buffer)
+{
+    if (!manager) {
+        return;
+    }
+    ShadowManagerInterfacePrivate *managerPrivate = ShadowManagerInterfacePrivate::get(manager);
+    QImage &image = tiles[int(tile)];
+    const QImage previous = image;
+    // acquired first, a tile that is attached again must not be dropped in between
+    image = managerPrivate->acquireTile(buffer);
+    managerPrivate->releaseTile(previous);
+}
+
 void ShadowInterfacePrivate::attach(ShadowInterfacePrivate::State::Flags flag, wl_resource *buffer)
 {
     ClientBuffer *b = manager->display()->clientBufferForResource(buffer);
@@ -299,6 +399,16 @@ ShadowInterfacePrivate::ShadowInterfacePrivate(ShadowInterface *_q, wl_resource
 {
 }
 
+wl_resource *ShadowManagerInterfacePrivate::resourceForShadow(ShadowInterface *shadow)
+{
+    return shadow->d->resource()->handle;
+}
+
+void addWeakHandleListener(ShadowInterface *shadow, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(ShadowManagerInterfacePrivate::resourceForShadow(shadow), listener);
+}
+
 ShadowInterfacePrivate::~ShadowInterfacePrivate()
 {
 #define CURRENT(__PART__)                                                                                                                                      \
@@ -314,6 +424,11 @@ ShadowInterfacePrivate::~ShadowInterfacePrivate()
     CURRENT(bottom)
     CURRENT(bottomLeft)
 #undef CURRENT
+    if (manager) {
+        for (const QImage &tile : tiles) {
+            ShadowManagerInterfacePrivate::get(manager)->releaseTile(tile);
+        }
+    }
 }
 
 ShadowInterface::ShadowInterface(ShadowManagerInterface *manager, wl_resource *resource)
@@ -330,6 +445,11 @@ QMarginsF ShadowInterface::offset() const
     return d->current.offset;
 }
 
+QImage ShadowInterface::tileImage(Tile tile) const
+{
+    return d->tiles[int(tile)];
+}
+
 #define BUFFER(__PART__)                                                                                                                                       \
     ClientBuffer *ShadowInterface::__PART__() const                                                                                                            \
     {                                                                                                                                                          \
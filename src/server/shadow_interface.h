@@ -5,6 +5,7 @@
 */
 #pragma once
 
+#include <QImage>
 #include <QMarginsF>
 #include <QObject>
 
@@ -31,12 +32,27 @@ public:
 
 private:
     QScopedPointer<ShadowManagerInterfacePrivate> d;
+    friend class ShadowManagerInterfacePrivate;
 };
 
 class KWAYLANDSERVER_EXPORT ShadowInterface : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * The parts of a shadow.
+     */
+    enum class Tile {
+        Left,
+        TopLeft,
+        Top,
+        TopRight,
+        Right,
+        BottomRight,
+        Bottom,
+        BottomLeft,
+    };
+
     ~ShadowInterface() override;
 
     ClientBuffer *left() const;
@@ -50,6 +66,16 @@ public:
 
     QMarginsF offset() const;
 
+    /**
+     * Returns a copy of the pixels of @p tile, or a null image if the tile is not set or not a
+     * shared memory buffer.
+     *
+     * Clients using the same theme send the same tiles for every window. Tiles with the same
+     * pixels share one image across all shadows of a ShadowManagerInterface, so they have the
+     * same QImage::cacheKey() and the compositor can keep one texture per unique tile.
+     */
+    QImage tileImage(Tile tile) const;
+
 private:
     explicit ShadowInterface(ShadowManagerInterface *manager, wl_resource *resource);
     friend class ShadowManagerInterfacePrivate;
@@ -7,19 +7,29 @@
 #include "shmclientbuffer.h"
 #include "clientbuffer_p.h"
 #include "display.h"
+#include "display_p.h"
+#include "logging.h"
+#include "shmconversion_p.h"
 
 #include <wayland-server-core.h>
 #include <wayland-server-protocol.h>
+// std
+#include <cstring>
 
 namespace KWaylandServer
 {
-static const ShmClientBuffer *s_accessedBuffer = nullptr;
-static int s_accessCounter = 0;
+// libwayland installs the SIGBUS protection for one shm pool per thread, so the accessed
+// buffer is tracked per thread as well. Different threads can access different buffers.
+static thread_local const ShmClientBuffer *s_accessedBuffer = nullptr;
+static thread_local int s_accessCounter = 0;
+// set if the accessed buffer got destroyed, its access has been ended already
+static thread_local bool s_accessEnded = false;
 
 class ShmClientBufferPrivate : public ClientBufferPrivate
 {
 public:
     ShmClientBufferPrivate(ShmClientBuffer *q);
+    ~ShmClientBufferPrivate() override;
 
     static void buffer_destroy_callback(wl_listener *listener, void *data);
 
@@ -29,12 +39,14 @@ public:
     uint32_t height = 0;
     bool hasAlphaChannel = false;
     QImage savedData;
+    // the bytes of savedData accounted in the retention budget of the display
+    qint64 retainedBytes = 0;
 
-    struct DestroyListener {
+    struct ShmDestroyListener {
         wl_listener listener;
         ShmClientBufferPrivate *receiver;
     };
-    DestroyListener destroyListener;
+    ShmDestroyListener shmDestroyListener;
 };
 
 ShmClientBufferPrivate::ShmClientBufferPrivate(ShmClientBuffer *q)
@@ -42,6 +54,13 @@ ShmClientBufferPrivate::ShmClientBufferPrivate(ShmClientBuffer *q)
 {
 }
 
+ShmClientBufferPrivate::~ShmClientBufferPrivate()
+{
+    if (retainedBytes && display) {
+        display->retainedShmBytes -= retainedBytes;
+    }
+}
+
 static void cleanupShmPool(void *poolHandle)
 {
     wl_shm_pool_unref(static_cast<wl_shm_pool *>(poolHandle));
@@ -51,17 +70,57 @@ void ShmClientBufferPrivate::buffer_destroy_callback(wl_listener *listener, void
 {
     Q_UNUSED(data)
 
-    auto bufferPrivate = reinterpret_cast<ShmClientBufferPrivate::DestroyListener *>(listener)->receiver;
+    auto bufferPrivate = reinterpret_cast<ShmClientBufferPrivate::ShmDestroyListener *>(listener)->receiver;
     wl_shm_buffer *buffer = wl_shm_buffer_get(bufferPrivate->q->resource());
-    wl_shm_pool *pool = wl_shm_buffer_ref_pool(buffer);
 
-    wl_list_remove(&bufferPrivate->destroyListener.listener.link);
-    wl_list_init(&bufferPrivate->destroyListener.listener.link);
+    wl_list_remove(&bufferPrivate->shmDestroyListener.listener.link);
+    wl_list_init(&bufferPrivate->shmDestroyListener.listener.link);
 
+    // an unreferenced buffer is deleted along with the wl_buffer, nobody gets to see the contents
+    if (!bufferPrivate->q->isReferenced()) {
+        return;
+    }
+
+    // The visible contents are copied, so the pool, which may be much larger than the buffer,
+    // is released right away. The copies of all buffers are bounded by the retention budget.
+    DisplayPrivate *display = bufferPrivate->display;
+    const uint32_t stride = wl_shm_buffer_get_stride(buffer);
+    if (!s_accessedBuffer) {
+        const qint64 bytes = qint64(bufferPrivate->height) * stride;
+        if (display && display->retainedShmBytes + bytes > display->shmRetentionBudget) {
+            qCDebug(KWAYLAND_SERVER) << "Dropping the contents of a destroyed shm buffer, the retention budget is exhausted";
+            return;
+        }
+        wl_shm_buffer_begin_access(buffer);
+        bufferPrivate->savedData = QImage(static_cast<const uchar *>(wl_shm_buffer_get_data(buffer)),
+                                          bufferPrivate->width,
+                                          bufferPrivate->height,
+                                          stride,
+                                          bufferPrivate->format)
+                                       .copy();
+        wl_shm_buffer_end_access(buffer);
+        if (display) {
+            bufferPrivate->retainedBytes = bufferPrivate->savedData.sizeInBytes();
+            display->retainedShmBytes += bufferPrivate->retainedBytes;
+        }
+        return;
+    }
+
+    // The thread is accessing a buffer, either another one which rules out accessing this one,
+    // or this one, whose mapping is still wrapped by images returned from data(). The pool is
+    // kept, so the mapping stays valid.
+    if (s_accessedBuffer == bufferPrivate->q) {
+        // the wl_shm_buffer is freed after this, the access ends now rather than with the images
+        for (int i = 0; i < s_accessCounter; ++i) {
+            wl_shm_buffer_end_access(buffer);
+        }
+        s_accessEnded = true;
+    }
+    wl_shm_pool *pool = wl_shm_buffer_ref_pool(buffer);
     bufferPrivate->savedData = QImage(static_cast<const uchar *>(wl_shm_buffer_get_data(buffer)),
                                       bufferPrivate->width,
                                       bufferPrivate->height,
-                                      wl_shm_buffer_get_stride(buffer),
+                                      stride,
                                       bufferPrivate->format,
                                       cleanupShmPool,
                                       pool);
@@ -73,10 +132,20 @@ static bool alphaChannelFromFormat(uint32_t format)
     case WL_SHM_FORMAT_ABGR2101010:
     case WL_SHM_FORMAT_ARGB2101010:
     case WL_SHM_FORMAT_ARGB8888:
+    case WL_SHM_FORMAT_ABGR8888:
+    case WL_SHM_FORMAT_ARGB4444:
+    case WL_SHM_FORMAT_ABGR16161616:
         return true;
     case WL_SHM_FORMAT_XBGR2101010:
     case WL_SHM_FORMAT_XRGB2101010:
     case WL_SHM_FORMAT_XRGB8888:
+    case WL_SHM_FORMAT_XBGR8888:
+    case WL_SHM_FORMAT_RGB565:
+    case WL_SHM_FORMAT_RGB888:
+    case WL_SHM_FORMAT_BGR888:
+    case WL_SHM_FORMAT_XRGB4444:
+    case WL_SHM_FORMAT_XRGB1555:
+    case WL_SHM_FORMAT_XBGR16161616:
     default:
         return false;
     }
@@ -94,6 +163,28 @@ static QImage::Format imageFormatForShmFormat(uint32_t format)
         return QImage::Format_A2BGR30_Premultiplied;
     case WL_SHM_FORMAT_XBGR2101010:
         return QImage::Format_BGR30;
+    // wl_shm formats are little endian, QImage formats with 16 or 32 bit pixels are native endian
+    // and those with 8 bit channels are in memory order
+    case WL_SHM_FORMAT_ABGR8888:
+        return QImage::Format_RGBA8888_Premultiplied;
+    case WL_SHM_FORMAT_XBGR8888:
+        return QImage::Format_RGBX8888;
+    case WL_SHM_FORMAT_RGB565:
+        return QImage::Format_RGB16;
+    case WL_SHM_FORMAT_RGB888:
+        return QImage::Format_BGR888;
+    case WL_SHM_FORMAT_BGR888:
+        return QImage::Format_RGB888;
+    case WL_SHM_FORMAT_ARGB4444:
+        return QImage::Format_ARGB4444_Premultiplied;
+    case WL_SHM_FORMAT_XRGB4444:
+        return QImage::Format_RGB444;
+    case WL_SHM_FORMAT_XRGB1555:
+        return QImage::Format_RGB555;
+    case WL_SHM_FORMAT_ABGR16161616:
+        return QImage::Format_RGBA64_Premultiplied;
+    case WL_SHM_FORMAT_XBGR16161616:
+        return QImage::Format_RGBX64;
 #endif
     case WL_SHM_FORMAT_ARGB8888:
         return QImage::Format_ARGB32_Premultiplied;
@@ -115,11 +206,11 @@ ShmClientBuffer::ShmClientBuffer(wl_resource *resource)
     d->hasAlphaChannel = alphaChannelFromFormat(wl_shm_buffer_get_format(buffer));
     d->format = imageFormatForShmFormat(wl_shm_buffer_get_format(buffer));
 
-    // The underlying shm pool will be referenced if the wl_shm_buffer is destroyed so the
-    // compositor can access buffer data even after the buffer is gone.
-    d->destroyListener.receiver = d;
-    d->destroyListener.listener.notify = ShmClientBufferPrivate::buffer_destroy_callback;
-    wl_resource_add_destroy_listener(resource, &d->destroyListener.listener);
+    // The buffer data will be saved if the wl_shm_buffer is destroyed so the compositor can
+    // access it even after the buffer is gone.
+    d->shmDestroyListener.receiver = d;
+    d->shmDestroyListener.listener.notify = ShmClientBufferPrivate::buffer_destroy_callback;
+    wl_resource_add_destroy_listener(resource, &d->shmDestroyListener.listener);
 }
 
 QSize ShmClientBuffer::size() const
@@ -142,11 +233,14 @@ ClientBuffer::Origin ShmClientBuffer::origin() const
 static void cleanupShmData(void *bufferHandle)
 {
     Q_ASSERT_X(s_accessCounter > 0, "cleanup", "access counter must be positive");
+    if (!s_accessEnded) {
+        wl_shm_buffer_end_access(static_cast<wl_shm_buffer *>(bufferHandle));
+    }
     s_accessCounter--;
     if (s_accessCounter == 0) {
         s_accessedBuffer = nullptr;
+        s_accessEnded = false;
     }
-    wl_shm_buffer_end_access(static_cast<wl_shm_buffer *>(bufferHandle));
 }
 
 QImage ShmClientBuffer::data() const
@@ -167,6 +261,55 @@ QImage ShmClientBuffer::data() const
     return d->savedData;
 }
 
+QVector<ShmClientBuffer::DamagedRect> ShmClientBuffer::damagedRects(const QImage &image, const QRegion &damage) const
+{
+    QVector<DamagedRect> rects;
+    if (image.isNull()) {
+        return rects;
+    }
+
+    const QRegion clipped = damage.intersected(image.rect());
+    rects.reserve(clipped.rectCount());
+    const int bytesPerPixel = image.depth() / 8;
+    for (const QRect &rect : clipped) {
+        const uchar *bits = image.constScanLine(rect.y()) + rect.x() * bytesPerPixel;
+        rects.append(DamagedRect{rect, bits, int(image.bytesPerLine())});
+    }
+    return rects;
+}
+
+bool ShmClientBuffer::convertDamage(const QImage &image, const QRegion &damage, QImage *target)
+{
+    if (image.isNull() || !target || target->size() != image.size()) {
+        return false;
+    }
+    if (target->format() != QImage::Format_ARGB32_Premultiplied && target->format() != QImage::Format_RGB32) {
+        return false;
+    }
+
+    const QRegion clipped = damage.intersected(image.rect());
+    if (const ShmRowConverter convert = shmRowConverter(image.format())) {
+        const int bytesPerPixel = image.depth() / 8;
+        for (const QRect &rect : clipped) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                const uchar *source = image.constScanLine(y) + rect.x() * bytesPerPixel;
+                quint32 *destination = reinterpret_cast<quint32 *>(target->scanLine(y)) + rect.x();
+                convert(source, destination, rect.width());
+            }
+        }
+        return true;
+    }
+
+    // formats without a fast path are converted by QImage, still only the damaged parts
+    for (const QRect &rect : clipped) {
+        const QImage converted = image.copy(rect).convertToFormat(target->format());
+        for (int y = 0; y < rect.height(); ++y) {
+            memcpy(target->scanLine(rect.y() + y) + rect.x() * 4, converted.constScanLine(y), rect.width() * 4);
+        }
+    }
+    return true;
+}
+
 ShmClientBufferIntegration::ShmClientBufferIntegration(Display *display)
     : ClientBufferIntegration(display)
 {
@@ -175,6 +318,16 @@ ShmClientBufferIntegration::ShmClientBufferIntegration(Display *display)
     wl_display_add_shm_format(*display, WL_SHM_FORMAT_XRGB2101010);
     wl_display_add_shm_format(*display, WL_SHM_FORMAT_ABGR2101010);
     wl_display_add_shm_format(*display, WL_SHM_FORMAT_XBGR2101010);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_ABGR8888);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_XBGR8888);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_RGB565);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_RGB888);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_BGR888);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_ARGB4444);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_XRGB4444);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_XRGB1555);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_ABGR16161616);
+    wl_display_add_shm_format(*display, WL_SHM_FORMAT_XBGR16161616);
 #endif
     wl_display_init_shm(*display);
 }
@@ -187,4 +340,9 @@ ClientBuffer *ShmClientBufferIntegration::createBuffer(::wl_resource *resource)
     return nullptr;
 }
 
+ClientBuffer::ReleasePolicy ShmClientBufferIntegration::releasePolicy() const
+{
+    return ClientBuffer::ReleasePolicy::ReleaseAfterUpload;
+}
+
 } // namespace KWaylandServer
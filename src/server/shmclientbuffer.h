@@ -9,6 +9,9 @@
 #include "clientbuffer.h"
 #include "clientbufferintegration.h"
 
+#include <QRegion>
+#include <QVector>
+
 namespace KWaylandServer
 {
 class ShmClientBufferPrivate;
@@ -16,8 +19,9 @@ class ShmClientBufferPrivate;
 /**
  * The ShmClientBuffer class represents a wl_shm_buffer client buffer.
  *
- * The buffer's data can be accessed using the data() function. Note that it is not allowed
- * to access data of several shared memory buffers simultaneously.
+ * The buffer's data can be accessed using the data() function. Note that a thread is not
+ * allowed to access data of several shared memory buffers simultaneously, but different
+ * threads can access different buffers at the same time, e.g. to upload them in parallel.
  */
 class KWAYLANDSERVER_EXPORT ShmClientBuffer : public ClientBuffer
 {
@@ -27,8 +31,56 @@ class KWAYLANDSERVER_EXPORT ShmClientBuffer : public ClientBuffer
 public:
     explicit ShmClientBuffer(wl_resource *resource);
 
+    /**
+     * Returns an image that wraps the buffer's shared memory. While the image is alive, the
+     * calling thread can't access any other shm buffer and a null image is returned instead.
+     *
+     * This function can be called from any thread, provided the buffer is referenced and the
+     * display doesn't dispatch client requests until the returned image is released. The image
+     * has to be released on the thread that called this function.
+     */
     QImage data() const;
 
+    /**
+     * A damaged rectangle of the buffer along with direct access to its pixels.
+     */
+    struct DamagedRect {
+        /**
+         * The rectangle in buffer coordinates.
+         */
+        QRect rect;
+        /**
+         * Points to the top left pixel of the rectangle.
+         */
+        const uchar *bits = nullptr;
+        /**
+         * The number of bytes between two rows of the rectangle.
+         */
+        int stride = 0;
+    };
+
+    /**
+     * Splits the @p damage in buffer coordinates into rectangles that point into the @p image,
+     * so that only the changed rows have to be uploaded. The @p image must be the one returned
+     * by data(), the pointers are valid as long as it is alive.
+     *
+     * @see SurfaceInterface::bufferDamage
+     */
+    QVector<DamagedRect> damagedRects(const QImage &image, const QRegion &damage) const;
+
+    /**
+     * Converts the @p damage in buffer coordinates of the @p image, usually the one returned
+     * by data(), into the @p target of the same size. The @p target has to be in
+     * QImage::Format_ARGB32_Premultiplied or QImage::Format_RGB32, pixels outside of the damage
+     * are left alone, so a renderer which keeps the target around only converts what changed.
+     *
+     * ARGB8888, XRGB8888, ABGR8888, XBGR8888, RGB565, RGB888 and BGR888 buffers are converted
+     * with SSE2 or NEON where available, other formats fall back to QImage.
+     *
+     * @returns @c false if the @p target doesn't fit.
+     */
+    static bool convertDamage(const QImage &image, const QRegion &damage, QImage *target);
+
     QSize size() const override;
     bool hasAlphaChannel() const override;
     Origin origin() const override;
@@ -45,6 +97,11 @@ public:
     explicit ShmClientBufferIntegration(Display *display);
 
     ClientBuffer *createBuffer(::wl_resource *resource) override;
+
+    /**
+     * Shared memory buffers are copied by the compositor, so they are released after upload.
+     */
+    ClientBuffer::ReleasePolicy releasePolicy() const override;
 };
 
 } // namespace KWaylandServer
@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "shmconversion_p.h"
+
+#include <cstring>
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN && defined(__SSE2__)
+#define SHM_CONVERSION_SSE2
+#include <emmintrin.h>
+#elif Q_BYTE_ORDER == Q_LITTLE_ENDIAN && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define SHM_CONVERSION_NEON
+#include <arm_neon.h>
+#endif
+
+namespace KWaylandServer
+{
+static void convertArgb32(const uchar *source, quint32 *destination, int count)
+{
+    memcpy(destination, source, count * sizeof(quint32));
+}
+
+static void convertRgb32(const uchar *source, quint32 *destination, int count)
+{
+    int i = 0;
+#if defined(SHM_CONVERSION_SSE2)
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_or_si128(pixels, alpha));
+    }
+#elif defined(SHM_CONVERSION_NEON)
+    const uint32x4_t alpha = vdupq_n_u32(0xff000000);
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t pixels = vreinterpretq_u32_u8(vld1q_u8(source + i * 4));
+        vst1q_u32(destination + i, vorrq_u32(pixels, alpha));
+    }
+#endif
+    for (; i < count; ++i) {
+        quint32 pixel;
+        memcpy(&pixel, source + i * 4, sizeof(pixel));
+        destination[i] = pixel | 0xff000000;
+    }
+}
+
+// QImage::Format_RGBA8888 and QImage::Format_RGBX8888, bytes in R, G, B, A order
+template<bool opaque>
+static void convertRgba8888(const uchar *source, quint32 *destination, int count)
+{
+    int i = 0;
+#if defined(SHM_CONVERSION_SSE2)
+    const __m128i alphaGreen = _mm_set1_epi32(int(0xff00ff00));
+    const __m128i redBlue = _mm_set1_epi32(0x00ff00ff);
+    const __m128i alpha = _mm_set1_epi32(opaque ? int(0xff000000) : 0);
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        const __m128i rb = _mm_and_si128(pixels, redBlue);
+        const __m128i swapped = _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16));
+        const __m128i result = _mm_or_si128(_mm_or_si128(_mm_and_si128(pixels, alphaGreen), swapped), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), result);
+    }
+#elif defined(SHM_CONVERSION_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t pixels = vld4q_u8(source + i * 4);
+        uint8x16x4_t result;
+        result.val[0] = pixels.val[2];
+        result.val[1] = pixels.val[1];
+        result.val[2] = pixels.val[0];
+        result.val[3] = opaque ? vdupq_n_u8(0xff) : pixels.val[3];
+        vst4q_u8(reinterpret_cast<uint8_t *>(destination + i), result);
+    }
+#endif
+    for (; i < count; ++i) {
+        const uchar *pixel = source + i * 4;
+        const quint32 alpha = opaque ? 0xff : pixel[3];
+        destination[i] = alpha << 24 | quint32(pixel[0]) << 16 | quint32(pixel[1]) << 8 | pixel[2];
+    }
+}
+
+// QImage::Format_RGB16, 5 bits of red, 6 of green and 5 of blue in a native 16 bit value
+static void convertRgb16(const uchar *source, quint32 *destination, int count)
+{
+    int i = 0;
+#if defined(SHM_CONVERSION_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask5 = _mm_set1_epi32(0x1f);
+    const __m128i mask6 = _mm_set1_epi32(0x3f);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    auto expand = [&](__m128i pixels) {
+        const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 11), mask5);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 5), mask6);
+        const __m128i b = _mm_and_si128(pixels, mask5);
+        const __m128i r8 = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+        const __m128i g8 = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4));
+        const __m128i b8 = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+        return _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r8, 16)), _mm_or_si128(_mm_slli_epi32(g8, 8), b8));
+    };
+    for (; i + 8 <= count; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), expand(_mm_unpacklo_epi16(pixels, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 4), expand(_mm_unpackhi_epi16(pixels, zero)));
+    }
+#elif defined(SHM_CONVERSION_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t pixels = vreinterpretq_u16_u8(vld1q_u8(source + i * 2));
+        const uint8x8_t r = vand_u8(vshrn_n_u16(pixels, 8), vdup_n_u8(0xf8));
+        const uint8x8_t g = vand_u8(vshrn_n_u16(pixels, 3), vdup_n_u8(0xfc));
+        const uint8x8_t b = vmovn_u16(vshlq_n_u16(pixels, 3));
+        uint8x8x4_t result;
+        result.val[0] = vorr_u8(b, vshr_n_u8(b, 5));
+        result.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+        result.val[2] = vorr_u8(r, vshr_n_u8(r, 5));
+        result.val[3] = vdup_n_u8(0xff);
+        vst4_u8(reinterpret_cast<uint8_t *>(destination + i), result);
+    }
+#endif
+    for (; i < count; ++i) {
+        quint16 pixel;
+        memcpy(&pixel, source + i * 2, sizeof(pixel));
+        const quint32 r = (pixel >> 11) & 0x1f;
+        const quint32 g = (pixel >> 5) & 0x3f;
+        const quint32 b = pixel & 0x1f;
+        destination[i] = 0xff000000 | ((r << 3) | (r >> 2)) << 16 | ((g << 2) | (g >> 4)) << 8 | ((b << 3) | (b >> 2));
+    }
+}
+
+// QImage::Format_RGB888 has the bytes in R, G, B order, QImage::Format_BGR888 in B, G, R order
+template<bool rgb>
+static void convertRgb888(const uchar *source, quint32 *destination, int count)
+{
+    int i = 0;
+#if defined(SHM_CONVERSION_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x3_t pixels = vld3q_u8(source + i * 3);
+        uint8x16x4_t result;
+        result.val[0] = rgb ? pixels.val[2] : pixels.val[0];
+        result.val[1] = pixels.val[1];
+        result.val[2] = rgb ? pixels.val[0] : pixels.val[2];
+        result.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(reinterpret_cast<uint8_t *>(destination + i), result);
+    }
+#endif
+    // SSE2 has no byte shuffle, the scalar loop is as fast there
+    for (; i < count; ++i) {
+        const uchar *pixel = source + i * 3;
+        const quint32 r = rgb ? pixel[0] : pixel[2];
+        const quint32 b = rgb ? pixel[2] : pixel[0];
+        destination[i] = 0xff000000 | r << 16 | quint32(pixel[1]) << 8 | b;
+    }
+}
+
+ShmRowConverter shmRowConverter(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_ARGB32_Premultiplied:
+        return convertArgb32;
+    case QImage::Format_RGB32:
+        return convertRgb32;
+    case QImage::Format_RGBA8888_Premultiplied:
+        return convertRgba8888<false>;
+    case QImage::Format_RGBX8888:
+        return convertRgba8888<true>;
+    case QImage::Format_RGB16:
+        return convertRgb16;
+    case QImage::Format_RGB888:
+        return convertRgb888<true>;
+    case QImage::Format_BGR888:
+        return convertRgb888<false>;
+    default:
+        return nullptr;
+    }
+}
+
+}
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QImage>
+
+namespace KWaylandServer
+{
+/**
+ * Converts @p count pixels of one row at @p source into 32 bit ARGB pixels, the layout of
+ * QImage::Format_ARGB32_Premultiplied, at @p destination. Formats without an alpha channel
+ * come out opaque.
+ */
+using ShmRowConverter = void (*)(const uchar *source, quint32 *destination, int count);
+
+/**
+ * Returns the row converter for images with @p format, or @c null if there is no fast path
+ * for it. The converters use SSE2 or NEON where available.
+ */
+ShmRowConverter shmRowConverter(QImage::Format format);
+
+}
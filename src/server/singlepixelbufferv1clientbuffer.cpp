@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "singlepixelbufferv1clientbuffer.h"
+#include "clientbuffer_p.h"
+#include "display.h"
+#include "display_p.h"
+
+#include "qwayland-server-single-pixel-buffer-v1.h"
+#include "qwayland-server-wayland.h"
+
+#include <limits>
+
+namespace KWaylandServer
+{
+static const quint32 s_version = 1;
+
+class SinglePixelBufferManagerV1 : public QtWaylandServer::wp_single_pixel_buffer_manager_v1
+{
+public:
+    SinglePixelBufferManagerV1(SinglePixelBufferV1ClientBufferIntegration *integration, Display *display);
+
+    SinglePixelBufferV1ClientBufferIntegration *integration;
+
+protected:
+    void wp_single_pixel_buffer_manager_v1_destroy(Resource *resource) override;
+    void wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer(Resource *resource, uint32_t id, uint32_t r, uint32_t g, uint32_t b, uint32_t a) override;
+};
+
+class SinglePixelBufferV1ClientBufferPrivate : public ClientBufferPrivate, public QtWaylandServer::wl_buffer
+{
+public:
+    quint32 r = 0;
+    quint32 g = 0;
+    quint32 b = 0;
+    quint32 a = 0;
+
+protected:
+    void buffer_destroy(Resource *resource) override;
+};
+
+SinglePixelBufferManagerV1::SinglePixelBufferManagerV1(SinglePixelBufferV1ClientBufferIntegration *integration, Display *display)
+    : QtWaylandServer::wp_single_pixel_buffer_manager_v1(*display, s_version)
+    , integration(integration)
+{
+}
+
+void SinglePixelBufferManagerV1::wp_single_pixel_buffer_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void SinglePixelBufferManagerV1::wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer(Resource *resource,
+                                                                                         uint32_t id,
+                                                                                         uint32_t r,
+                                                                                         uint32_t g,
+                                                                                         uint32_t b,
+                                                                                         uint32_t a)
+{
+    wl_resource *bufferResource = wl_resource_create(resource->client(), &wl_buffer_interface, 1, id);
+    if (!bufferResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+
+    auto clientBuffer = new SinglePixelBufferV1ClientBuffer(r, g, b, a);
+    clientBuffer->initialize(bufferResource);
+    DisplayPrivate::get(integration->display())->registerClientBuffer(clientBuffer, integration);
+}
+
+void SinglePixelBufferV1ClientBufferPrivate::buffer_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+SinglePixelBufferV1ClientBuffer::SinglePixelBufferV1ClientBuffer(quint32 r, quint32 g, quint32 b, quint32 a)
+    : ClientBuffer(*new SinglePixelBufferV1ClientBufferPrivate)
+{
+    Q_D(SinglePixelBufferV1ClientBuffer);
+    d->r = r;
+    d->g = g;
+    d->b = b;
+    d->a = a;
+}
+
+void SinglePixelBufferV1ClientBuffer::initialize(wl_resource *resource)
+{
+    Q_D(SinglePixelBufferV1ClientBuffer);
+    d->init(resource);
+    ClientBuffer::initialize(resource);
+}
+
+QColor SinglePixelBufferV1ClientBuffer::color() const
+{
+    Q_D(const SinglePixelBufferV1ClientBuffer);
+    // QColor keeps 16 bits per channel
+    return QColor::fromRgba64(d->r >> 16, d->g >> 16, d->b >> 16, d->a >> 16);
+}
+
+QSize SinglePixelBufferV1ClientBuffer::size() const
+{
+    return QSize(1, 1);
+}
+
+bool SinglePixelBufferV1ClientBuffer::hasAlphaChannel() const
+{
+    Q_D(const SinglePixelBufferV1ClientBuffer);
+    return d->a != std::numeric_limits<quint32>::max();
+}
+
+ClientBuffer::Origin SinglePixelBufferV1ClientBuffer::origin() const
+{
+    return Origin::TopLeft;
+}
+
+SinglePixelBufferV1ClientBufferIntegration::SinglePixelBufferV1ClientBufferIntegration(Display *display)
+    : ClientBufferIntegration(display)
+    , d(new SinglePixelBufferManagerV1(this, display))
+{
+}
+
+SinglePixelBufferV1ClientBufferIntegration::~SinglePixelBufferV1ClientBufferIntegration() = default;
+
+} // namespace KWaylandServer
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "clientbuffer.h"
+#include "clientbufferintegration.h"
+
+#include <QColor>
+
+namespace KWaylandServer
+{
+class SinglePixelBufferV1ClientBufferPrivate;
+class SinglePixelBufferManagerV1;
+
+/**
+ * The SinglePixelBufferV1ClientBufferIntegration class provides support for the
+ * wp_single_pixel_buffer_manager_v1 protocol.
+ *
+ * Clients use single-pixel buffers for areas of a solid color, e.g. backgrounds or the black
+ * bars of a video, and scale them to the size they need with a viewport. The compositor can
+ * draw them as a solid rectangle of SinglePixelBufferV1ClientBuffer::color() without uploading
+ * anything.
+ */
+class KWAYLANDSERVER_EXPORT SinglePixelBufferV1ClientBufferIntegration : public ClientBufferIntegration
+{
+    Q_OBJECT
+
+public:
+    explicit SinglePixelBufferV1ClientBufferIntegration(Display *display);
+    ~SinglePixelBufferV1ClientBufferIntegration() override;
+
+private:
+    QScopedPointer<SinglePixelBufferManagerV1> d;
+};
+
+/**
+ * The SinglePixelBufferV1ClientBuffer class represents a 1x1 client buffer of a single color.
+ */
+class KWAYLANDSERVER_EXPORT SinglePixelBufferV1ClientBuffer : public ClientBuffer
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(SinglePixelBufferV1ClientBuffer)
+
+public:
+    /**
+     * Returns the color of the buffer. The color channels are pre-multiplied with the alpha
+     * channel.
+     */
+    QColor color() const;
+
+    QSize size() const override;
+    bool hasAlphaChannel() const override;
+    Origin origin() const override;
+
+private:
+    SinglePixelBufferV1ClientBuffer(quint32 r, quint32 g, quint32 b, quint32 a);
+    void initialize(wl_resource *resource);
+
+    friend class SinglePixelBufferManagerV1;
+};
+
+} // namespace KWaylandServer
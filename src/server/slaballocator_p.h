@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QVector>
+
+#include <cstddef>
+#include <new>
+
+namespace KWaylandServer
+{
+/**
+ * A free list for objects of the type @p T, which are created and destroyed at high rates,
+ * e.g. regions and positioners. The memory is taken from blocks of @p BlockSize objects and
+ * reused once an object is destroyed, the blocks are returned when the thread exits.
+ *
+ * Every thread has its own allocator, and an object has to be destroyed on the thread that
+ * created it. The allocators don't synchronize with each other, a slot freed on another thread
+ * would end up in a foreign free list and outlive or lose its block. The wayland objects using
+ * it live on the thread of the Display. Use it through SlabAllocated.
+ */
+template<typename T, int BlockSize = 64>
+class SlabAllocator
+{
+public:
+    ~SlabAllocator()
+    {
+        // objects that are still alive, e.g. static ones destroyed after the thread exits, keep
+        // their blocks
+        if (m_liveCount != 0) {
+            return;
+        }
+        for (Slot *block : qAsConst(m_blocks)) {
+            ::operator delete(block);
+        }
+    }
+
+    static SlabAllocator &instance()
+    {
+        thread_local SlabAllocator allocator;
+        return allocator;
+    }
+
+    void *allocate()
+    {
+        if (!m_free) {
+            grow();
+        }
+        Slot *slot = m_free;
+        m_free = slot->next;
+        ++m_liveCount;
+        return slot;
+    }
+
+    void deallocate(void *pointer)
+    {
+        Slot *slot = static_cast<Slot *>(pointer);
+        Q_ASSERT_X(owns(slot), "SlabAllocator::deallocate", "object destroyed on another thread than it was created on");
+        slot->next = m_free;
+        m_free = slot;
+        --m_liveCount;
+    }
+
+    /**
+     * Returns the number of objects allocated and not yet deallocated in this thread.
+     */
+    int liveCount() const
+    {
+        return m_liveCount;
+    }
+
+    /**
+     * Returns the number of blocks requested from the system, i.e. the number of real
+     * allocations.
+     */
+    int blockCount() const
+    {
+        return m_blocks.count();
+    }
+
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    bool owns(const Slot *slot) const
+    {
+        for (const Slot *block : m_blocks) {
+            if (slot >= block && slot < block + BlockSize) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void grow()
+    {
+        Slot *block = static_cast<Slot *>(::operator new(sizeof(Slot) * BlockSize));
+        m_blocks.append(block);
+        for (int i = BlockSize - 1; i >= 0; --i) {
+            block[i].next = m_free;
+            m_free = &block[i];
+        }
+    }
+
+    Slot *m_free = nullptr;
+    QVector<Slot *> m_blocks;
+    int m_liveCount = 0;
+};
+
+/**
+ * Makes new and delete of @p T use a SlabAllocator. Subclasses of @p T with a different
+ * size fall back to the global operators, so @p T needs a virtual destructor if it's
+ * deleted through a pointer to a base class.
+ */
+template<typename T>
+struct SlabAllocated {
+    static void *operator new(std::size_t size)
+    {
+        if (size != sizeof(T)) {
+            return ::operator new(size);
+        }
+        return SlabAllocator<T>::instance().allocate();
+    }
+
+    static void operator delete(void *pointer, std::size_t size)
+    {
+        if (size != sizeof(T)) {
+            ::operator delete(pointer);
+            return;
+        }
+        SlabAllocator<T>::instance().deallocate(pointer);
+    }
+};
+
+} // namespace KWaylandServer
@@ -18,6 +18,11 @@ class SlideManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_slide_
 public:
     SlideManagerInterfacePrivate(SlideManagerInterface *_q, Display *display);
 
+    /**
+     * Returns the resource of @p slide, it is destroyed together with it.
+     */
+    static wl_resource *resourceForSlide(SlideInterface *slide);
+
     SlideManagerInterface *q;
 
 protected:
@@ -47,7 +52,7 @@ void SlideManagerInterfacePrivate::org_kde_kwin_slide_manager_create(Resource *r
 
     auto slide = new SlideInterface(slide_resource);
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->setSlide(QPointer<SlideInterface>(slide));
+    surfacePrivate->setSlide(slide);
 }
 
 void SlideManagerInterfacePrivate::org_kde_kwin_slide_manager_unset(Resource *resource, wl_resource *surface)
@@ -58,7 +63,7 @@ void SlideManagerInterfacePrivate::org_kde_kwin_slide_manager_unset(Resource *re
         return;
     }
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
-    surfacePrivate->setSlide(QPointer<SlideInterface>());
+    surfacePrivate->setSlide(nullptr);
 }
 
 SlideManagerInterfacePrivate::SlideManagerInterfacePrivate(SlideManagerInterface *_q, Display *display)
@@ -137,6 +142,16 @@ SlideInterfacePrivate::SlideInterfacePrivate(SlideInterface *_q, wl_resource *re
 {
 }
 
+wl_resource *SlideManagerInterfacePrivate::resourceForSlide(SlideInterface *slide)
+{
+    return slide->d->resource()->handle;
+}
+
+void addWeakHandleListener(SlideInterface *slide, wl_listener *listener)
+{
+    wl_resource_add_destroy_listener(SlideManagerInterfacePrivate::resourceForSlide(slide), listener);
+}
+
 SlideInterface::SlideInterface(wl_resource *resource)
     : d(new SlideInterfacePrivate(this, resource))
 {
@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QRect>
+#include <QRegion>
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+namespace KWaylandServer
+{
+/**
+ * A region made of a few rects that doesn't allocate as long as it has no more than four of
+ * them. The rects may overlap, the region is their union, which is all accumulating, mapping
+ * and clipping damage needs. Unlike QRegion it's cheap to build rect by rect, convert it with
+ * toRegion() once the final region is known.
+ */
+class SmallRegion
+{
+public:
+    SmallRegion() = default;
+    explicit SmallRegion(const QRect &rect)
+    {
+        unite(rect);
+    }
+
+    bool isEmpty() const
+    {
+        return m_rects.isEmpty();
+    }
+
+    int rectCount() const
+    {
+        return m_rects.count();
+    }
+
+    const QRect *begin() const
+    {
+        return m_rects.constData();
+    }
+
+    const QRect *end() const
+    {
+        return m_rects.constData() + m_rects.count();
+    }
+
+    void clear()
+    {
+        m_rects.clear();
+    }
+
+    void unite(const QRect &rect)
+    {
+        if (rect.isEmpty()) {
+            return;
+        }
+        for (const QRect &existing : qAsConst(m_rects)) {
+            if (existing.contains(rect)) {
+                return;
+            }
+        }
+        // clients tend to damage growing areas, e.g. while typing
+        QRect *last = std::remove_if(m_rects.begin(), m_rects.end(), [&rect](const QRect &existing) {
+            return rect.contains(existing);
+        });
+        m_rects.resize(last - m_rects.begin());
+        m_rects.append(rect);
+    }
+
+    void unite(const SmallRegion &other)
+    {
+        for (const QRect &rect : other) {
+            unite(rect);
+        }
+    }
+
+    /**
+     * Reduces the region to at most @p maxRects rects which cover at least the same area. The
+     * rects are merged into the bounding rects of horizontal bands of vertically overlapping
+     * rects, which keeps e.g. the damaged lines of a terminal apart. If there are still too many
+     * bands, the region becomes its bounding rect.
+     */
+    void simplify(int maxRects)
+    {
+        if (m_rects.count() <= maxRects) {
+            return;
+        }
+        std::sort(m_rects.begin(), m_rects.end(), [](const QRect &a, const QRect &b) {
+            return a.top() < b.top();
+        });
+        int bands = 0;
+        for (int i = 0; i < m_rects.count(); ++i) {
+            if (bands && m_rects[i].top() <= m_rects[bands - 1].bottom() + 1) {
+                m_rects[bands - 1] |= m_rects[i];
+            } else {
+                m_rects[bands++] = m_rects[i];
+            }
+        }
+        m_rects.resize(bands);
+        if (bands > maxRects) {
+            const QRect bounds = boundingRect();
+            m_rects.resize(1);
+            m_rects[0] = bounds;
+        }
+    }
+
+    SmallRegion intersected(const QRect &clip) const
+    {
+        SmallRegion result;
+        for (const QRect &rect : m_rects) {
+            result.unite(rect.intersected(clip));
+        }
+        return result;
+    }
+
+    /**
+     * Returns the region with every rect replaced by the result of @p function, which
+     * must map unions to unions, e.g. a transform.
+     */
+    template<typename Function>
+    SmallRegion mapped(Function function) const
+    {
+        SmallRegion result;
+        for (const QRect &rect : m_rects) {
+            result.unite(function(rect));
+        }
+        return result;
+    }
+
+    QRect boundingRect() const
+    {
+        QRect bounds;
+        for (const QRect &rect : m_rects) {
+            bounds |= rect;
+        }
+        return bounds;
+    }
+
+    QRegion toRegion() const
+    {
+        if (m_rects.count() == 1) {
+            return QRegion(m_rects.first());
+        }
+        QRegion region;
+        for (const QRect &rect : m_rects) {
+            region += rect;
+        }
+        return region;
+    }
+
+private:
+    QVarLengthArray<QRect, 4> m_rects;
+};
+
+} // namespace KWaylandServer
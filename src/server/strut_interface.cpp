@@ -6,6 +6,9 @@
 #include "strut_interface.h"
 #include "display.h"
 #include "surface_interface_p.h"
+
+#include <QHash>
+
 #include <qwayland-server-wayland.h>
 #include <qwayland-server-strut.h>
 
@@ -19,6 +22,7 @@ class StrutInterfacePrivate: public QtWaylandServer::com_deepin_kwin_strut
 public:
     StrutInterfacePrivate(StrutInterface *q, Display *d);
     StrutInterface *q;
+    QHash<SurfaceInterface *, deepinKwinStrut> struts;
 
 private:
    void com_deepin_kwin_strut_set_strut_partial(Resource *resource,
@@ -73,6 +77,20 @@ void StrutInterfacePrivate::com_deepin_kwin_strut_set_strut_partial(Resource *re
                                      bottom_start_x,
                                      bottom_end_x);
     SurfaceInterface *si = SurfaceInterface::get(surface);
+    if (!si) {
+        return;
+    }
+
+    auto it = struts.find(si);
+    if (it == struts.end()) {
+        it = struts.insert(si, deepinKwinStrut());
+        QObject::connect(si, &SurfaceInterface::aboutToBeDestroyed, q, [this, si]() {
+            struts.remove(si);
+        });
+    } else if (*it == kwinStrut) {
+        return;
+    }
+    *it = kwinStrut;
 
     Q_EMIT q->setStrut(si, kwinStrut);
 }
@@ -93,4 +111,9 @@ StrutInterface::StrutInterface(Display *display, QObject *parent)
 
 StrutInterface::~StrutInterface() = default;
 
+deepinKwinStrut StrutInterface::strut(SurfaceInterface *surface) const
+{
+    return d->struts.value(surface);
+}
+
 }
@@ -94,6 +94,18 @@ struct deepinKwinStrut
 
         return *this;
     };
+    bool operator==(const deepinKwinStrut &rhs) const
+    {
+        return left == rhs.left && right == rhs.right && top == rhs.top && bottom == rhs.bottom
+            && left_start_y == rhs.left_start_y && left_end_y == rhs.left_end_y
+            && right_start_y == rhs.right_start_y && right_end_y == rhs.right_end_y
+            && top_start_x == rhs.top_start_x && top_end_x == rhs.top_end_x
+            && bottom_start_x == rhs.bottom_start_x && bottom_end_x == rhs.bottom_end_x;
+    }
+    bool operator!=(const deepinKwinStrut &rhs) const
+    {
+        return !(*this == rhs);
+    }
 };
 
 /**
@@ -114,9 +126,15 @@ public:
 
     static StrutInterface *get(wl_resource *native);
 
+    /**
+     * Returns the strut last set on @p surface, or an empty strut if there is none.
+     **/
+    deepinKwinStrut strut(SurfaceInterface *surface) const;
+
 Q_SIGNALS:
     /**
-     * Emitted whenever a PlasmaShellSurfaceInterface got created.
+     * Emitted whenever the strut of a surface changed. Setting the strut a surface
+     * already has is not reported again.
      **/
     void setStrut(SurfaceInterface *, struct deepinKwinStrut &);
 
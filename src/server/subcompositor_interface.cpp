@@ -177,7 +177,15 @@ void SubSurfaceInterfacePrivate::parentCommit()
 {
     if (hasPendingPosition) {
         hasPendingPosition = false;
+        const QPoint oldPosition = position;
         position = pendingPosition;
+        if (surface->isMapped()) {
+            // both, the area the sub-surface tree left and the area it moved to, need a repaint
+            const QRect bounds = surface->boundingRect();
+            SurfaceInterfacePrivate::get(parent)->addTreeDamage(QRegion(bounds.translated(oldPosition)).united(bounds.translated(position)));
+        }
+        // moves the whole sub-surface tree in the render lists of the ancestors
+        SurfaceInterfacePrivate::get(parent)->invalidateRenderList();
         Q_EMIT q->positionChanged(position);
     }
 
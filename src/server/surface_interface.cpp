@@ -5,30 +5,62 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "surface_interface.h"
+#include "blur_interface.h"
 #include "clientbuffer.h"
+#include "clientbuffer_p.h"
 #include "clientconnection.h"
+#include "committrace_p.h"
 #include "compositor_interface.h"
+#include "contrast_interface.h"
 #include "display.h"
+#include "display_p.h"
+#include "drmclientbuffer.h"
+#include "fractionalscale_v1_interface_p.h"
+#include "frogcolormanagement_v1_interface_p.h"
 #include "idleinhibit_v1_interface_p.h"
 #include "linuxdmabufv1clientbuffer.h"
+#include "linuxdmabufv1clientbuffer_p.h"
+#include "linuxdrmsyncobj_v1_interface_p.h"
+#include "output_interface_p.h"
 #include "pointerconstraints_v1_interface_p.h"
 #include "region_interface_p.h"
+#include "shmclientbuffer.h"
+#include "singlepixelbufferv1clientbuffer.h"
 #include "subcompositor_interface.h"
 #include "subsurface_interface_p.h"
 #include "surface_interface_p.h"
 #include "surfacerole_p.h"
 #include "utils.h"
+// Wayland
+#include "wayland-presentation-time-server-protocol.h"
 // std
 #include <algorithm>
+#include <unistd.h>
+#include <utility>
 
 namespace KWaylandServer
 {
+static void discardPresentationFeedbacks(wl_list *feedbacks)
+{
+    wl_resource *resource;
+    wl_resource *tmp;
+
+    wl_resource_for_each_safe(resource, tmp, feedbacks)
+    {
+        wp_presentation_feedback_send_discarded(resource);
+        wl_resource_destroy(resource);
+    }
+}
+
 SurfaceInterfacePrivate::SurfaceInterfacePrivate(SurfaceInterface *q)
     : q(q)
 {
     wl_list_init(&current.frameCallbacks);
     wl_list_init(&pending.frameCallbacks);
     wl_list_init(&cached.frameCallbacks);
+    wl_list_init(&current.presentationFeedbacks);
+    wl_list_init(&pending.presentationFeedbacks);
+    wl_list_init(&cached.presentationFeedbacks);
 }
 
 SurfaceInterfacePrivate::~SurfaceInterfacePrivate()
@@ -48,6 +80,45 @@ SurfaceInterfacePrivate::~SurfaceInterfacePrivate()
     {
         wl_resource_destroy(resource);
     }
+    for (const auto &state : deferredStates) {
+        wl_resource_for_each_safe(resource, tmp, &state->frameCallbacks)
+        {
+            wl_resource_destroy(resource);
+        }
+        discardPresentationFeedbacks(&state->presentationFeedbacks);
+    }
+
+    discardPresentationFeedbacks(&current.presentationFeedbacks);
+    discardPresentationFeedbacks(&pending.presentationFeedbacks);
+    discardPresentationFeedbacks(&cached.presentationFeedbacks);
+
+    if (idleInhibitManager) {
+        idleInhibitManager->surfaces.removeOne(q);
+        if (countedAsInhibitingIdle) {
+            idleInhibitManager->adjustInhibition(-1);
+        }
+    }
+
+    for (OutputInterface *output : qAsConst(outputs)) {
+        OutputInterfacePrivate::get(output)->surfaces.remove(q);
+    }
+
+    // the surface tree loses the content of a destroyed sub-surface
+    if (mapped && subSurface && subSurface->parentSurface()) {
+        auto parentPrivate = SurfaceInterfacePrivate::get(subSurface->parentSurface());
+        parentPrivate->addTreeDamage(QRect(subSurface->position(), surfaceSize));
+    }
+
+    stopWaitingForBuffer();
+    // the client may reuse buffers that never made it to the screen
+    if (cached.buffer && !cached.buffer->isReferenced()) {
+        ClientBufferPrivate::get(cached.buffer)->signalReleasePoints();
+    }
+    for (const auto &state : deferredStates) {
+        if (state->buffer && !state->buffer->isReferenced()) {
+            ClientBufferPrivate::get(state->buffer)->signalReleasePoints();
+        }
+    }
 
     if (current.buffer) {
         current.buffer->unref();
@@ -59,8 +130,16 @@ void SurfaceInterfacePrivate::addChild(SubSurfaceInterface *child)
     // protocol is not precise on how to handle the addition of new sub surfaces
     pending.above.append(child);
     cached.above.append(child);
+    for (const auto &state : deferredStates) {
+        state->above.append(child);
+    }
     current.above.append(child);
     child->surface()->setOutputs(outputs);
+    child->surface()->setPreferredScale(preferredScale);
+    child->surface()->setPreferredColorDescription(preferredColorDescription);
+    invalidateHitTestIndex();
+    invalidateRenderList();
+    bumpGeneration(SurfaceInterface::StateCategory::Children);
     Q_EMIT q->childSubSurfaceAdded(child);
     Q_EMIT q->childSubSurfacesChanged();
 }
@@ -72,12 +151,41 @@ void SurfaceInterfacePrivate::removeChild(SubSurfaceInterface *child)
     pending.above.removeAll(child);
     cached.below.removeAll(child);
     cached.above.removeAll(child);
+    for (const auto &state : deferredStates) {
+        state->below.removeAll(child);
+        state->above.removeAll(child);
+    }
     current.below.removeAll(child);
     current.above.removeAll(child);
+    if (SurfaceInterface *surface = child->surface(); surface && surface->isMapped()) {
+        addTreeDamage(surface->boundingRect().translated(child->position()));
+    }
+    invalidateHitTestIndex();
+    invalidateRenderList();
+    bumpGeneration(SurfaceInterface::StateCategory::Children);
     Q_EMIT q->childSubSurfaceRemoved(child);
     Q_EMIT q->childSubSurfacesChanged();
 }
 
+bool SurfaceInterfacePrivate::moveChild(SubSurfaceInterface *subsurface, QList<SubSurfaceInterface *> *list, int position)
+{
+    const int index = list->indexOf(subsurface);
+    if (index == -1) {
+        (list == &pending.above ? pending.below : pending.above).removeOne(subsurface);
+        list->insert(position, subsurface);
+        return true;
+    }
+    // the position counts the sub-surface itself if it is before it
+    if (index < position) {
+        --position;
+    }
+    if (index == position) {
+        return false;
+    }
+    list->move(index, position);
+    return true;
+}
+
 bool SurfaceInterfacePrivate::raiseChild(SubSurfaceInterface *subsurface, SurfaceInterface *anchor)
 {
     Q_ASSERT(subsurface->parentSurface() == q);
@@ -85,13 +193,12 @@ bool SurfaceInterfacePrivate::raiseChild(SubSurfaceInterface *subsurface, Surfac
     QList<SubSurfaceInterface *> *anchorList;
     int anchorIndex;
 
-    pending.below.removeOne(subsurface);
-    pending.above.removeOne(subsurface);
-
     if (anchor == q) {
         // Pretend as if the parent surface were before the first child in the above list.
         anchorList = &pending.above;
         anchorIndex = -1;
+    } else if (anchor->subSurface() == subsurface) {
+        return false;
     } else if (anchorIndex = pending.above.indexOf(anchor->subSurface()); anchorIndex != -1) {
         anchorList = &pending.above;
     } else if (anchorIndex = pending.below.indexOf(anchor->subSurface()); anchorIndex != -1) {
@@ -100,8 +207,11 @@ bool SurfaceInterfacePrivate::raiseChild(SubSurfaceInterface *subsurface, Surfac
         return false; // The anchor belongs to other sub-surface tree.
     }
 
-    anchorList->insert(anchorIndex + 1, subsurface);
-    pending.childrenChanged = true;
+    // Clients tend to repeat the same request every frame, e.g. while scrolling, which must not
+    // restack and thereby repaint all children.
+    if (moveChild(subsurface, anchorList, anchorIndex + 1)) {
+        pending.markSet(SurfaceState::ChildrenField);
+    }
     return true;
 }
 
@@ -112,13 +222,12 @@ bool SurfaceInterfacePrivate::lowerChild(SubSurfaceInterface *subsurface, Surfac
     QList<SubSurfaceInterface *> *anchorList;
     int anchorIndex;
 
-    pending.below.removeOne(subsurface);
-    pending.above.removeOne(subsurface);
-
     if (anchor == q) {
         // Pretend as if the parent surface were after the last child in the below list.
         anchorList = &pending.below;
         anchorIndex = pending.below.count();
+    } else if (anchor->subSurface() == subsurface) {
+        return false;
     } else if (anchorIndex = pending.above.indexOf(anchor->subSurface()); anchorIndex != -1) {
         anchorList = &pending.above;
     } else if (anchorIndex = pending.below.indexOf(anchor->subSurface()); anchorIndex != -1) {
@@ -127,33 +236,34 @@ bool SurfaceInterfacePrivate::lowerChild(SubSurfaceInterface *subsurface, Surfac
         return false; // The anchor belongs to other sub-surface tree.
     }
 
-    anchorList->insert(anchorIndex, subsurface);
-    pending.childrenChanged = true;
+    if (moveChild(subsurface, anchorList, anchorIndex)) {
+        pending.markSet(SurfaceState::ChildrenField);
+    }
     return true;
 }
 
-void SurfaceInterfacePrivate::setShadow(const QPointer<ShadowInterface> &shadow)
+void SurfaceInterfacePrivate::setShadow(ShadowInterface *shadow)
 {
     pending.shadow = shadow;
-    pending.shadowIsSet = true;
+    pending.markSet(SurfaceState::ShadowField);
 }
 
-void SurfaceInterfacePrivate::setBlur(const QPointer<BlurInterface> &blur)
+void SurfaceInterfacePrivate::setBlur(BlurInterface *blur)
 {
     pending.blur = blur;
-    pending.blurIsSet = true;
+    pending.markSet(SurfaceState::BlurField);
 }
 
-void SurfaceInterfacePrivate::setSlide(const QPointer<SlideInterface> &slide)
+void SurfaceInterfacePrivate::setSlide(SlideInterface *slide)
 {
     pending.slide = slide;
-    pending.slideIsSet = true;
+    pending.markSet(SurfaceState::SlideField);
 }
 
-void SurfaceInterfacePrivate::setContrast(const QPointer<ContrastInterface> &contrast)
+void SurfaceInterfacePrivate::setContrast(ContrastInterface *contrast)
 {
     pending.contrast = contrast;
-    pending.contrastIsSet = true;
+    pending.markSet(SurfaceState::ContrastField);
 }
 
 void SurfaceInterfacePrivate::installPointerConstraint(LockedPointerV1Interface *lock)
@@ -212,20 +322,39 @@ void SurfaceInterfacePrivate::installPointerConstraint(ConfinedPointerV1Interfac
     Q_EMIT q->pointerConstraintsChanged();
 }
 
-void SurfaceInterfacePrivate::installIdleInhibitor(IdleInhibitorV1Interface *inhibitor)
+void SurfaceInterfacePrivate::installIdleInhibitor(IdleInhibitManagerV1InterfacePrivate *manager, IdleInhibitorV1Interface *inhibitor)
 {
+    if (!idleInhibitManager) {
+        idleInhibitManager = manager;
+        manager->surfaces.append(q);
+    }
     idleInhibitors << inhibitor;
     QObject::connect(inhibitor, &IdleInhibitorV1Interface::destroyed, q, [this, inhibitor] {
         idleInhibitors.removeOne(inhibitor);
         if (idleInhibitors.isEmpty()) {
+            updateIdleInhibition();
             Q_EMIT q->inhibitsIdleChanged();
         }
     });
     if (idleInhibitors.count() == 1) {
+        updateIdleInhibition();
         Q_EMIT q->inhibitsIdleChanged();
     }
 }
 
+void SurfaceInterfacePrivate::updateIdleInhibition()
+{
+    if (!idleInhibitManager) {
+        return;
+    }
+    const bool inhibiting = !idleInhibitors.isEmpty() && mapped && !(idleInhibitManager->visibilityRequired && occluded);
+    if (countedAsInhibitingIdle == inhibiting) {
+        return;
+    }
+    countedAsInhibitingIdle = inhibiting;
+    idleInhibitManager->adjustInhibition(inhibiting ? 1 : -1);
+}
+
 void SurfaceInterfacePrivate::surface_destroy_resource(Resource *)
 {
     Q_EMIT q->aboutToBeDestroyed();
@@ -240,25 +369,26 @@ void SurfaceInterfacePrivate::surface_destroy(Resource *resource)
 void SurfaceInterfacePrivate::surface_attach(Resource *resource, struct ::wl_resource *buffer, int32_t x, int32_t y)
 {
     Q_UNUSED(resource)
-    pending.bufferIsSet = true;
+    pending.markSet(SurfaceState::BufferField);
     pending.offset = QPoint(x, y);
     if (!buffer) {
         // got a null buffer, deletes content in next frame
         pending.buffer = nullptr;
-        pending.damage = QRegion();
-        pending.bufferDamage = QRegion();
+        pending.damage.clear();
+        pending.bufferDamage.clear();
         return;
     }
     pending.buffer = compositor->display()->clientBufferForResource(buffer);
 
     // set default damage to force initial rendering
     auto bufferSize = pending.buffer->size();
-    pending.damage = QRegion(0, 0, bufferSize.width(), bufferSize.height());
+    pending.damage = SmallRegion(QRect(0, 0, bufferSize.width(), bufferSize.height()));
 }
 
 void SurfaceInterfacePrivate::surface_damage(Resource *, int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    pending.damage |= QRect(x, y, width, height);
+    pending.damage.unite(QRect(x, y, width, height));
+    pending.damage.simplify(DisplayPrivate::get(compositor->display())->damageRectBudget);
 }
 
 void SurfaceInterfacePrivate::surface_frame(Resource *resource, uint32_t callback)
@@ -284,7 +414,7 @@ void SurfaceInterfacePrivate::surface_set_opaque_region(Resource *resource, stru
     Q_UNUSED(resource)
     RegionInterface *r = RegionInterface::get(region);
     pending.opaque = r ? r->region() : QRegion();
-    pending.opaqueIsSet = true;
+    pending.markSet(SurfaceState::OpaqueField);
 }
 
 void SurfaceInterfacePrivate::surface_set_input_region(Resource *resource, struct ::wl_resource *region)
@@ -292,19 +422,156 @@ void SurfaceInterfacePrivate::surface_set_input_region(Resource *resource, struc
     Q_UNUSED(resource)
     RegionInterface *r = RegionInterface::get(region);
     pending.input = r ? r->region() : infiniteRegion();
-    pending.inputIsSet = true;
+    pending.markSet(SurfaceState::InputField);
 }
 
 void SurfaceInterfacePrivate::surface_commit(Resource *resource)
 {
     Q_UNUSED(resource)
+    if (DisplayPrivate::get(compositor->display())->commitTracingEnabled) {
+        recordCommit();
+    }
+    if (syncObjSurface) {
+        if (!syncObjSurface->validatePendingState()) {
+            return;
+        }
+        if (pending.releasePoint.isValid()) {
+            ClientBufferPrivate::get(pending.buffer)->releasePoints.append(std::exchange(pending.releasePoint, LinuxDrmSyncObjPoint()));
+        }
+    }
+    const bool waitForFences = waitForBufferFences && pending.isSet(SurfaceState::BufferField) && qobject_cast<LinuxDmaBufV1ClientBuffer *>(pending.buffer.data());
+    if (!deferredStates.empty() || pending.acquirePoint.isValid() || waitForFences) {
+        deferPendingState();
+        return;
+    }
+    commit(&pending);
+}
+
+static qint64 regionArea(const SmallRegion &region)
+{
+    qint64 area = 0;
+    for (const QRect &rect : region) {
+        area += qint64(rect.width()) * rect.height();
+    }
+    return area;
+}
+
+void SurfaceInterfacePrivate::recordCommit()
+{
+    if (!commitTrace) {
+        commitTrace.reset(new CommitTrace(client->processId(), q->id()));
+        DisplayPrivate *display = DisplayPrivate::get(compositor->display());
+        auto expired = std::remove_if(display->commitTraces.begin(), display->commitTraces.end(), [](const QWeakPointer<CommitTrace> &trace) {
+            return trace.isNull();
+        });
+        display->commitTraces.erase(expired, display->commitTraces.end());
+        display->commitTraces.append(commitTrace);
+    }
+
+    SurfaceInterface::CommitRecord &record = commitTrace->append();
+    record.timestamp = std::chrono::steady_clock::now().time_since_epoch();
+    if (pending.isSet(SurfaceState::BufferField)) {
+        ClientBuffer *buffer = pending.buffer.data();
+        if (!buffer) {
+            record.bufferType = SurfaceInterface::CommitRecord::BufferType::Detached;
+        } else {
+            if (qobject_cast<ShmClientBuffer *>(buffer)) {
+                record.bufferType = SurfaceInterface::CommitRecord::BufferType::Shm;
+            } else if (qobject_cast<LinuxDmaBufV1ClientBuffer *>(buffer)) {
+                record.bufferType = SurfaceInterface::CommitRecord::BufferType::DmaBuf;
+            } else if (qobject_cast<DrmClientBuffer *>(buffer)) {
+                record.bufferType = SurfaceInterface::CommitRecord::BufferType::Drm;
+            } else if (qobject_cast<SinglePixelBufferV1ClientBuffer *>(buffer)) {
+                record.bufferType = SurfaceInterface::CommitRecord::BufferType::SinglePixel;
+            } else {
+                record.bufferType = SurfaceInterface::CommitRecord::BufferType::Other;
+            }
+            record.bufferSize = buffer->size();
+        }
+    }
+    record.damageArea = regionArea(pending.damage) + regionArea(pending.bufferDamage);
+    record.synchronized = subSurface && subSurface->isSynchronized();
+    record.frameCallbacks = !wl_list_empty(&pending.frameCallbacks);
+}
+
+void SurfaceInterfacePrivate::commit(SurfaceState *state)
+{
     if (subSurface) {
-        commitSubSurface();
+        commitSubSurface(state);
     } else {
-        applyState(&pending);
+        applyState(state);
+    }
+}
+
+void SurfaceInterfacePrivate::deferPendingState()
+{
+    auto state = std::make_unique<SurfaceState>();
+    wl_list_init(&state->frameCallbacks);
+    wl_list_init(&state->presentationFeedbacks);
+    // the pending state keeps track of the stacking order of the children, see mergeInto()
+    const QList<SubSurfaceInterface *> below = pending.below;
+    const QList<SubSurfaceInterface *> above = pending.above;
+    pending.mergeInto(state.get());
+    pending.below = below;
+    pending.above = above;
+
+    deferredStates.push_back(std::move(state));
+    if (deferredStates.size() == 1) {
+        waitForBuffer();
     }
 }
 
+void SurfaceInterfacePrivate::waitForBuffer()
+{
+    stopWaitingForBuffer();
+
+    // the commits without a buffer to wait for are applied right away, up to the next one with
+    while (!deferredStates.empty()) {
+        const SurfaceState *state = deferredStates.front().get();
+        int fd = -1;
+        if (state->isSet(SurfaceState::BufferField)) {
+            if (state->acquirePoint.isValid()) {
+                fd = state->acquirePoint.timeline->createEventFd(state->acquirePoint.point);
+            } else if (waitForBufferFences) {
+                if (auto dmabuf = qobject_cast<LinuxDmaBufV1ClientBuffer *>(state->buffer.data())) {
+                    fd = dmabuf->exportSyncFile();
+                }
+            }
+        }
+        if (fd != -1) {
+            // both eventfds and sync files become readable once they are signalled
+            bufferReadyNotifier.reset(new QSocketNotifier(fd, QSocketNotifier::Read));
+            QObject::connect(bufferReadyNotifier.data(), &QSocketNotifier::activated, q, [this] {
+                applyDeferredState();
+                waitForBuffer();
+            });
+            return;
+        }
+        applyDeferredState();
+    }
+}
+
+void SurfaceInterfacePrivate::stopWaitingForBuffer()
+{
+    if (!bufferReadyNotifier) {
+        return;
+    }
+    // this might be called from the activated signal of the notifier
+    QSocketNotifier *notifier = bufferReadyNotifier.take();
+    notifier->setEnabled(false);
+    close(notifier->socket());
+    notifier->deleteLater();
+}
+
+void SurfaceInterfacePrivate::applyDeferredState()
+{
+    stopWaitingForBuffer();
+    std::unique_ptr<SurfaceState> state = std::move(deferredStates.front());
+    deferredStates.pop_front();
+    state->acquirePoint = LinuxDrmSyncObjPoint();
+    commit(state.get());
+}
+
 void SurfaceInterfacePrivate::surface_set_buffer_transform(Resource *resource, int32_t transform)
 {
     if (transform < 0 || transform > WL_OUTPUT_TRANSFORM_FLIPPED_270) {
@@ -312,7 +579,7 @@ void SurfaceInterfacePrivate::surface_set_buffer_transform(Resource *resource, i
         return;
     }
     pending.bufferTransform = OutputInterface::Transform(transform);
-    pending.bufferTransformIsSet = true;
+    pending.markSet(SurfaceState::BufferTransformField);
 }
 
 void SurfaceInterfacePrivate::surface_set_buffer_scale(Resource *resource, int32_t scale)
@@ -322,13 +589,14 @@ void SurfaceInterfacePrivate::surface_set_buffer_scale(Resource *resource, int32
         return;
     }
     pending.bufferScale = scale;
-    pending.bufferScaleIsSet = true;
+    pending.markSet(SurfaceState::BufferScaleField);
 }
 
 void SurfaceInterfacePrivate::surface_damage_buffer(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
 {
     Q_UNUSED(resource)
-    pending.bufferDamage |= QRect(x, y, width, height);
+    pending.bufferDamage.unite(QRect(x, y, width, height));
+    pending.bufferDamage.simplify(DisplayPrivate::get(compositor->display())->damageRectBudget);
 }
 
 SurfaceInterface::SurfaceInterface(CompositorInterface *compositor, wl_resource *resource)
@@ -364,31 +632,203 @@ CompositorInterface *SurfaceInterface::compositor() const
     return d->compositor;
 }
 
+void SurfaceInterfacePrivate::updateFrameCallbackLatency()
+{
+    if (!wl_list_empty(&current.frameCallbacks)) {
+        frameCallbackLatency = std::chrono::steady_clock::now() - frameCallbacksAppliedTime;
+    }
+}
+
 void SurfaceInterface::frameRendered(quint32 msec)
 {
-    // notify all callbacks
-    wl_resource *resource;
-    wl_resource *tmp;
+    // nobody sees what the client renders for powered down outputs
+    if (!d->outputs.isEmpty() && !frameOutput()) {
+        return;
+    }
+    d->sendFrameCallbacks(msec, false);
+}
 
-    wl_resource_for_each_safe(resource, tmp, &d->current.frameCallbacks)
-    {
-        wl_callback_send_done(resource, msec);
-        wl_resource_destroy(resource);
+bool SurfaceInterfacePrivate::frameCallbacksDue(quint32 msec)
+{
+    switch (frameCallbackPolicy) {
+    case SurfaceInterface::FrameCallbackPolicy::FullRate:
+        return true;
+    case SurfaceInterface::FrameCallbackPolicy::ReducedRate:
+        // the unsigned difference survives the wrap around of the msec
+        if (lastReducedFrameCallback && msec - *lastReducedFrameCallback < quint32(reducedFrameCallbackInterval.count())) {
+            return false;
+        }
+        lastReducedFrameCallback = msec;
+        return true;
+    case SurfaceInterface::FrameCallbackPolicy::Paused:
+        return false;
     }
+    Q_UNREACHABLE();
+}
 
-    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
-        subsurface->surface()->frameRendered(msec);
+void SurfaceInterfacePrivate::sendFrameCallbacks(quint32 msec, bool skipOccluded)
+{
+    // the policy holds the callbacks of the whole tree
+    if (!frameCallbacksDue(msec)) {
+        return;
     }
-    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
-        subsurface->surface()->frameRendered(msec);
+
+    // an occluded sub-surface keeps its callbacks even if its parent is visible
+    if (!skipOccluded || !occluded) {
+        wl_resource *resource;
+        wl_resource *tmp;
+
+        updateFrameCallbackLatency();
+        if (commitTrace && !wl_list_empty(&current.frameCallbacks)) {
+            commitTrace->frameCallbacksSent(std::chrono::steady_clock::now().time_since_epoch());
+        }
+
+        wl_resource_for_each_safe(resource, tmp, &current.frameCallbacks)
+        {
+            wl_callback_send_done(resource, msec);
+            wl_resource_destroy(resource);
+        }
+    }
+
+    for (SubSurfaceInterface *subsurface : qAsConst(current.below)) {
+        SurfaceInterfacePrivate::get(subsurface->surface())->sendFrameCallbacks(msec, skipOccluded);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(current.above)) {
+        SurfaceInterfacePrivate::get(subsurface->surface())->sendFrameCallbacks(msec, skipOccluded);
     }
 }
 
+void SurfaceInterface::frameRendered(OutputInterface *output, std::chrono::nanoseconds timestamp)
+{
+    if (!output || output != frameOutput() || d->occluded) {
+        return;
+    }
+    d->sendFrameCallbacks(std::chrono::duration_cast<std::chrono::milliseconds>(timestamp).count(), true);
+}
+
 bool SurfaceInterface::hasFrameCallbacks() const
 {
     return !wl_list_empty(&d->current.frameCallbacks);
 }
 
+QVector<SurfaceInterface::CommitRecord> SurfaceInterface::commitTrace() const
+{
+    return d->commitTrace ? d->commitTrace->records() : QVector<CommitRecord>();
+}
+
+std::chrono::nanoseconds SurfaceInterface::frameCallbackLatency() const
+{
+    return d->frameCallbackLatency;
+}
+
+OutputInterface *SurfaceInterface::frameOutput() const
+{
+    for (OutputInterface *output : qAsConst(d->outputs)) {
+        if (output->dpmsMode() == OutputInterface::DpmsMode::On) {
+            return output;
+        }
+    }
+    return nullptr;
+}
+
+void SurfaceInterface::setOccluded(bool occluded)
+{
+    d->occluded = occluded;
+    d->updateIdleInhibition();
+}
+
+bool SurfaceInterface::isOccluded() const
+{
+    return d->occluded;
+}
+
+bool SurfaceInterface::isFrameThrottled() const
+{
+    return d->occluded || !frameOutput() || d->frameCallbackPolicy != FrameCallbackPolicy::FullRate;
+}
+
+void SurfaceInterface::setFrameCallbackPolicy(FrameCallbackPolicy policy)
+{
+    if (d->frameCallbackPolicy == policy) {
+        return;
+    }
+    d->frameCallbackPolicy = policy;
+    // a surface that gets reduced starts over with an immediate delivery
+    d->lastReducedFrameCallback.reset();
+}
+
+SurfaceInterface::FrameCallbackPolicy SurfaceInterface::frameCallbackPolicy() const
+{
+    return d->frameCallbackPolicy;
+}
+
+void SurfaceInterface::setReducedFrameCallbackInterval(std::chrono::milliseconds interval)
+{
+    d->reducedFrameCallbackInterval = interval;
+}
+
+std::chrono::milliseconds SurfaceInterface::reducedFrameCallbackInterval() const
+{
+    return d->reducedFrameCallbackInterval;
+}
+
+void SurfaceInterface::presented(OutputInterface *output,
+                                 std::chrono::nanoseconds timestamp,
+                                 std::chrono::nanoseconds refresh,
+                                 quint64 sequence,
+                                 PresentationTimeInterface::Kinds kinds)
+{
+    if (!wl_list_empty(&d->current.presentationFeedbacks)) {
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timestamp);
+        const quint64 secs = seconds.count();
+        const quint32 nsecs = (timestamp - seconds).count();
+        // the resources of the client are shared with the index of the output, nothing is copied
+        const QList<OutputInterfacePrivate::Resource *> outputResources = output ? OutputInterfacePrivate::get(output)->clientResources.resources(d->client->client()) : QList<OutputInterfacePrivate::Resource *>();
+
+        wl_resource *resource;
+        wl_resource *tmp;
+        wl_resource_for_each_safe(resource, tmp, &d->current.presentationFeedbacks)
+        {
+            for (OutputInterfacePrivate::Resource *outputResource : outputResources) {
+                wp_presentation_feedback_send_sync_output(resource, outputResource->handle);
+            }
+            wp_presentation_feedback_send_presented(resource,
+                                                    secs >> 32,
+                                                    secs & 0xffffffff,
+                                                    nsecs,
+                                                    refresh.count(),
+                                                    sequence >> 32,
+                                                    sequence & 0xffffffff,
+                                                    quint32(kinds));
+            wl_resource_destroy(resource);
+        }
+    }
+
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        subsurface->surface()->presented(output, timestamp, refresh, sequence, kinds);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        subsurface->surface()->presented(output, timestamp, refresh, sequence, kinds);
+    }
+}
+
+void SurfaceInterface::discardPresentation()
+{
+    discardPresentationFeedbacks(&d->current.presentationFeedbacks);
+
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        subsurface->surface()->discardPresentation();
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        subsurface->surface()->discardPresentation();
+    }
+}
+
+bool SurfaceInterface::hasPresentationFeedback() const
+{
+    return !wl_list_empty(&d->current.presentationFeedbacks);
+}
+
 QMatrix4x4 SurfaceInterfacePrivate::buildSurfaceToBufferMatrix()
 {
     // The order of transforms is reversed, i.e. the viewport transform is the first one.
@@ -457,85 +897,153 @@ QMatrix4x4 SurfaceInterfacePrivate::buildSurfaceToBufferMatrix()
 
 void SurfaceState::mergeInto(SurfaceState *target)
 {
-    if (bufferIsSet) {
-        target->buffer = buffer;
+    // Only the fields that have been set are handed over. They are swapped rather than
+    // copied, this state receives the previous values of the target which are either
+    // reset below or overwritten the next time the client sets the corresponding field.
+    if (isSet(BufferField)) {
+        if (target->buffer && target->buffer != buffer && !target->buffer->isReferenced()) {
+            // the buffer got superseded before the compositor could use it
+            ClientBufferPrivate::get(target->buffer)->signalReleasePoints();
+        }
+        target->buffer.swap(buffer);
+        target->acquirePoint = std::exchange(acquirePoint, LinuxDrmSyncObjPoint());
         target->offset = offset;
-        target->damage = damage;
-        target->bufferDamage = bufferDamage;
-        target->bufferIsSet = bufferIsSet;
+        std::swap(target->damage, damage);
+        std::swap(target->bufferDamage, bufferDamage);
     }
-    if (viewport.sourceGeometryIsSet) {
+    if (isSet(ViewportSourceField)) {
         target->viewport.sourceGeometry = viewport.sourceGeometry;
-        target->viewport.sourceGeometryIsSet = true;
     }
-    if (viewport.destinationSizeIsSet) {
+    if (isSet(ViewportDestinationField)) {
         target->viewport.destinationSize = viewport.destinationSize;
-        target->viewport.destinationSizeIsSet = true;
     }
-    if (childrenChanged) {
+    // Both states have the same children unless this one got restacked, addChild() and
+    // removeChild() update all states.
+    if (isSet(ChildrenField)) {
         target->below = below;
         target->above = above;
-        target->childrenChanged = true;
     }
     wl_list_insert_list(&target->frameCallbacks, &frameCallbacks);
+    // the content the feedbacks of the target belong to got superseded before it was presented
+    discardPresentationFeedbacks(&target->presentationFeedbacks);
+    wl_list_insert_list(&target->presentationFeedbacks, &presentationFeedbacks);
 
-    if (shadowIsSet) {
-        target->shadow = shadow;
-        target->shadowIsSet = true;
+    if (isSet(ShadowField)) {
+        target->shadow.swap(shadow);
     }
-    if (blurIsSet) {
-        target->blur = blur;
-        target->blurIsSet = true;
+    if (isSet(BlurField)) {
+        target->blur.swap(blur);
     }
-    if (contrastIsSet) {
-        target->contrast = contrast;
-        target->contrastIsSet = true;
+    if (isSet(ContrastField)) {
+        target->contrast.swap(contrast);
     }
-    if (slideIsSet) {
-        target->slide = slide;
-        target->slideIsSet = true;
+    if (isSet(SlideField)) {
+        target->slide.swap(slide);
     }
-    if (inputIsSet) {
-        target->input = input;
-        target->inputIsSet = true;
+    if (isSet(InputField)) {
+        target->input.swap(input);
     }
-    if (opaqueIsSet) {
-        target->opaque = opaque;
-        target->opaqueIsSet = true;
+    if (isSet(OpaqueField)) {
+        target->opaque.swap(opaque);
     }
-    if (bufferScaleIsSet) {
+    if (isSet(BufferScaleField)) {
         target->bufferScale = bufferScale;
-        target->bufferScaleIsSet = true;
     }
-    if (bufferTransformIsSet) {
+    if (isSet(BufferTransformField)) {
         target->bufferTransform = bufferTransform;
-        target->bufferTransformIsSet = true;
     }
+    if (isSet(ContentTypeField)) {
+        target->contentType = contentType;
+    }
+    if (isSet(PresentationHintField)) {
+        target->presentationHint = presentationHint;
+    }
+    if (isSet(ColorDescriptionField)) {
+        target->colorDescription = colorDescription;
+    }
+
+    target->changedFields |= changedFields;
+    changedFields = 0;
 
-    *this = SurfaceState{};
-    below = target->below;
-    above = target->above;
+    // Damage is accumulated, so it has to start out empty for the next cycle.
+    damage.clear();
+    bufferDamage.clear();
     wl_list_init(&frameCallbacks);
+    wl_list_init(&presentationFeedbacks);
+}
+
+SurfaceInterfacePrivate::EffectState SurfaceInterfacePrivate::effectState(BlurInterface *blur)
+{
+    EffectState state;
+    if (blur) {
+        state.set = true;
+        state.region = blur->region();
+    }
+    return state;
+}
+
+SurfaceInterfacePrivate::EffectState SurfaceInterfacePrivate::effectState(ContrastInterface *contrast)
+{
+    EffectState state;
+    if (contrast) {
+        state.set = true;
+        state.region = contrast->region();
+        state.contrast = contrast->contrast();
+        state.intensity = contrast->intensity();
+        state.saturation = contrast->saturation();
+        state.frost = contrast->frost();
+    }
+    return state;
+}
+
+QRegion SurfaceInterfacePrivate::effectDamage(const EffectState &previous, const EffectState &next) const
+{
+    // an empty region covers the whole surface
+    const QRect surfaceRect(QPoint(0, 0), surfaceSize);
+    auto area = [&surfaceRect](const EffectState &state) {
+        if (!state.set) {
+            return QRegion();
+        }
+        return state.region.isEmpty() ? QRegion(surfaceRect) : state.region;
+    };
+    const QRegion previousArea = area(previous);
+    const QRegion nextArea = area(next);
+    if (previous.set && next.set && previous.contrast == next.contrast && previous.intensity == next.intensity
+        && previous.saturation == next.saturation && previous.frost == next.frost) {
+        // only the parts that got added or removed look different
+        return previousArea.xored(nextArea);
+    }
+    return previousArea.united(nextArea);
 }
 
 void SurfaceInterfacePrivate::applyState(SurfaceState *next)
 {
-    const bool bufferChanged = next->bufferIsSet;
-    const bool opaqueRegionChanged = next->opaqueIsSet;
-    const bool scaleFactorChanged = next->bufferScaleIsSet && (current.bufferScale != next->bufferScale);
-    const bool transformChanged = next->bufferTransformIsSet && (current.bufferTransform != next->bufferTransform);
-    const bool shadowChanged = next->shadowIsSet;
-    const bool blurChanged = next->blurIsSet;
-    const bool contrastChanged = next->contrastIsSet;
-    const bool slideChanged = next->slideIsSet;
-    const bool childrenChanged = next->childrenChanged;
+    const bool bufferChanged = next->isSet(SurfaceState::BufferField);
+    const bool opaqueRegionChanged = next->isSet(SurfaceState::OpaqueField);
+    const bool scaleFactorChanged = next->isSet(SurfaceState::BufferScaleField) && (current.bufferScale != next->bufferScale);
+    const bool transformChanged = next->isSet(SurfaceState::BufferTransformField) && (current.bufferTransform != next->bufferTransform);
+    const bool shadowChanged = next->isSet(SurfaceState::ShadowField);
+    bool blurChanged = next->isSet(SurfaceState::BlurField);
+    bool contrastChanged = next->isSet(SurfaceState::ContrastField);
+    const bool slideChanged = next->isSet(SurfaceState::SlideField);
+    const bool childrenChanged = next->isSet(SurfaceState::ChildrenField);
+    const bool inputRegionChanged = next->isSet(SurfaceState::InputField);
     const bool visibilityChanged = bufferChanged && bool(current.buffer) != bool(next->buffer);
+    const bool contentTypeChanged = next->isSet(SurfaceState::ContentTypeField) && current.contentType != next->contentType;
+    const bool presentationHintChanged = next->isSet(SurfaceState::PresentationHintField) && current.presentationHint != next->presentationHint;
+    const bool colorDescriptionChanged = next->isSet(SurfaceState::ColorDescriptionField) && current.colorDescription != next->colorDescription;
+    const bool viewportChanged = (next->isSet(SurfaceState::ViewportSourceField) && current.viewport.sourceGeometry != next->viewport.sourceGeometry)
+        || (next->isSet(SurfaceState::ViewportDestinationField) && current.viewport.destinationSize != next->viewport.destinationSize);
 
     const QSize oldSurfaceSize = surfaceSize;
     const QSize oldBufferSize = bufferSize;
+    const QSize oldImplicitSurfaceSize = implicitSurfaceSize;
+    const QRectF oldSourceGeometry = current.viewport.sourceGeometry;
     const QMatrix4x4 oldSurfaceToBufferMatrix = surfaceToBufferMatrix;
-    const QRegion oldInputRegion = inputRegion;
 
+    if (wl_list_empty(&current.frameCallbacks) && !wl_list_empty(&next->frameCallbacks)) {
+        frameCallbacksAppliedTime = std::chrono::steady_clock::now();
+    }
     next->mergeInto(&current);
 
     if (lockedPointer) {
@@ -556,47 +1064,85 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
             bufferRef->ref();
         }
     }
+    // an attached buffer is busy again, even if something else kept referencing it since it has
+    // been released early, e.g. a pixmap of the compositor
+    if (bufferChanged && bufferRef) {
+        bufferRef->markAsAttached();
+    }
+
+    // Most commits only attach a new buffer of the same size, e.g. the frames of a video that is
+    // scaled with a viewport, the sizes and the matrices can't change then.
+    const bool geometryChanged = visibilityChanged || scaleFactorChanged || transformChanged || viewportChanged
+        || (current.buffer && current.buffer->size() != bufferSize);
 
     // TODO: Refactor the state management code because it gets more clumsy.
-    if (current.buffer) {
-        bufferSize = current.buffer->size();
-
-        implicitSurfaceSize = current.buffer->size() / current.bufferScale;
-        switch (current.bufferTransform) {
-        case OutputInterface::Transform::Rotated90:
-        case OutputInterface::Transform::Rotated270:
-        case OutputInterface::Transform::Flipped90:
-        case OutputInterface::Transform::Flipped270:
-            implicitSurfaceSize.transpose();
-            break;
-        case OutputInterface::Transform::Normal:
-        case OutputInterface::Transform::Rotated180:
-        case OutputInterface::Transform::Flipped:
-        case OutputInterface::Transform::Flipped180:
-            break;
-        }
+    if (geometryChanged) {
+        if (current.buffer) {
+            bufferSize = current.buffer->size();
+
+            implicitSurfaceSize = current.buffer->size() / current.bufferScale;
+            switch (current.bufferTransform) {
+            case OutputInterface::Transform::Rotated90:
+            case OutputInterface::Transform::Rotated270:
+            case OutputInterface::Transform::Flipped90:
+            case OutputInterface::Transform::Flipped270:
+                implicitSurfaceSize.transpose();
+                break;
+            case OutputInterface::Transform::Normal:
+            case OutputInterface::Transform::Rotated180:
+            case OutputInterface::Transform::Flipped:
+            case OutputInterface::Transform::Flipped180:
+                break;
+            }
 
-        if (current.viewport.destinationSize.isValid()) {
-            surfaceSize = current.viewport.destinationSize;
-        } else if (current.viewport.sourceGeometry.isValid()) {
-            surfaceSize = current.viewport.sourceGeometry.size().toSize();
+            if (current.viewport.destinationSize.isValid()) {
+                surfaceSize = current.viewport.destinationSize;
+            } else if (current.viewport.sourceGeometry.isValid()) {
+                surfaceSize = current.viewport.sourceGeometry.size().toSize();
+            } else {
+                surfaceSize = implicitSurfaceSize;
+            }
         } else {
-            surfaceSize = implicitSurfaceSize;
+            surfaceSize = QSize();
+            implicitSurfaceSize = QSize();
+            bufferSize = QSize();
         }
-    } else {
-        surfaceSize = QSize();
-        implicitSurfaceSize = QSize();
-        bufferSize = QSize();
     }
 
-    surfaceToBufferMatrix = buildSurfaceToBufferMatrix();
-    bufferToSurfaceMatrix = surfaceToBufferMatrix.inverted();
-    inputRegion = current.input & QRect(QPoint(0, 0), surfaceSize);
+    // The matrices only depend on the buffer size, scale, transform and viewport, rebuilding
+    // and inverting them on every commit is wasteful.
+    const bool mappingChanged = geometryChanged
+        && (visibilityChanged || scaleFactorChanged || transformChanged || bufferSize != oldBufferSize || surfaceSize != oldSurfaceSize
+            || implicitSurfaceSize != oldImplicitSurfaceSize || current.viewport.sourceGeometry != oldSourceGeometry);
+    if (mappingChanged) {
+        surfaceToBufferMatrix = buildSurfaceToBufferMatrix();
+        bufferToSurfaceMatrix = surfaceToBufferMatrix.inverted();
+        integerBufferMapping = current.buffer && !current.viewport.sourceGeometry.isValid() && surfaceSize == implicitSurfaceSize;
+    }
+    if (bufferChanged) {
+        bumpGeneration(SurfaceInterface::StateCategory::Buffer);
+    }
+    if (scaleFactorChanged || transformChanged || bufferSize != oldBufferSize || surfaceSize != oldSurfaceSize
+        || (mappingChanged && surfaceToBufferMatrix != oldSurfaceToBufferMatrix)) {
+        bumpGeneration(SurfaceInterface::StateCategory::Geometry);
+    }
     if (opaqueRegionChanged) {
+        bumpGeneration(SurfaceInterface::StateCategory::Regions);
         Q_EMIT q->opaqueChanged(current.opaque);
     }
-    if (oldInputRegion != inputRegion) {
-        Q_EMIT q->inputChanged(inputRegion);
+    // the effective input region only depends on these two, most commits only damage
+    if (inputRegionChanged || surfaceSize != oldSurfaceSize) {
+        const QRegion newInputRegion = current.input & QRect(QPoint(0, 0), surfaceSize);
+        if (newInputRegion != inputRegion) {
+            inputRegion = newInputRegion;
+            if (!opaqueRegionChanged) {
+                bumpGeneration(SurfaceInterface::StateCategory::Regions);
+            }
+            if (confinedPointer) {
+                ConfinedPointerV1InterfacePrivate::get(confinedPointer)->invalidateEffectiveRegion();
+            }
+            Q_EMIT q->inputChanged(inputRegion);
+        }
     }
     if (scaleFactorChanged) {
         Q_EMIT q->bufferScaleChanged(current.bufferScale);
@@ -609,21 +1155,51 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
     }
     if (bufferChanged) {
         if (current.buffer && (!current.damage.isEmpty() || !current.bufferDamage.isEmpty())) {
-            const QRegion windowRegion = QRegion(0, 0, q->size().width(), q->size().height());
-            const QRegion bufferDamage = q->mapFromBuffer(current.bufferDamage);
-            current.damage = windowRegion.intersected(current.damage.united(bufferDamage));
-            Q_EMIT q->damaged(current.damage);
+            // the damage is accumulated and clipped rect by rect, only the results become QRegions
+            SmallRegion bufferDamage = mapToBuffer(current.damage);
+            bufferDamage.unite(current.bufferDamage);
+            committedBufferDamage = bufferDamage.intersected(QRect(QPoint(0, 0), bufferSize)).toRegion();
+
+            SmallRegion surfaceDamage = current.damage;
+            surfaceDamage.unite(mapFromBuffer(current.bufferDamage));
+            committedDamage = surfaceDamage.intersected(QRect(QPoint(0, 0), q->size())).toRegion();
+            addTreeDamage(committedDamage);
+            Q_EMIT q->damaged(committedDamage);
+        } else {
+            committedDamage = QRegion();
+            committedBufferDamage = QRegion();
         }
     }
-    if (surfaceToBufferMatrix != oldSurfaceToBufferMatrix) {
+    if (mappingChanged && surfaceToBufferMatrix != oldSurfaceToBufferMatrix) {
         Q_EMIT q->surfaceToBufferMatrixChanged();
     }
     if (bufferSize != oldBufferSize) {
         Q_EMIT q->bufferSizeChanged();
     }
     if (surfaceSize != oldSurfaceSize) {
+        addTreeDamage(QRegion(QRect(QPoint(0, 0), oldSurfaceSize)).united(QRect(QPoint(0, 0), surfaceSize)));
         Q_EMIT q->sizeChanged();
     }
+    if (blurChanged) {
+        // clients tend to set an identical blur with every commit
+        const EffectState state = effectState(current.blur);
+        blurChanged = state != blurState;
+        if (blurChanged) {
+            blurDamage = effectDamage(blurState, state);
+            blurState = state;
+        }
+    }
+    if (contrastChanged) {
+        const EffectState state = effectState(current.contrast);
+        contrastChanged = state != contrastState;
+        if (contrastChanged) {
+            contrastDamage = effectDamage(contrastState, state);
+            contrastState = state;
+        }
+    }
+    if (shadowChanged || blurChanged || contrastChanged || slideChanged) {
+        bumpGeneration(SurfaceInterface::StateCategory::Effects);
+    }
     if (shadowChanged) {
         Q_EMIT q->shadowChanged();
     }
@@ -636,7 +1212,27 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
     if (slideChanged) {
         Q_EMIT q->slideOnShowHideChanged();
     }
+    if (contentTypeChanged) {
+        Q_EMIT q->contentTypeChanged();
+    }
+    if (presentationHintChanged) {
+        Q_EMIT q->presentationHintChanged();
+    }
+    if (colorDescriptionChanged) {
+        Q_EMIT q->colorDescriptionChanged();
+    }
     if (childrenChanged) {
+        bumpGeneration(SurfaceInterface::StateCategory::Children);
+        // the stacking order changed, which may expose or cover any of the children
+        QRegion childrenDamage;
+        for (const QList<SubSurfaceInterface *> *children : {&current.below, &current.above}) {
+            for (SubSurfaceInterface *subsurface : *children) {
+                if (subsurface->surface()->isMapped()) {
+                    childrenDamage += subsurface->surface()->boundingRect().translated(subsurface->position());
+                }
+            }
+        }
+        addTreeDamage(childrenDamage);
         Q_EMIT q->childSubSurfacesChanged();
     }
     // The position of a sub-surface is applied when its parent is committed.
@@ -648,29 +1244,102 @@ void SurfaceInterfacePrivate::applyState(SurfaceState *next)
         auto subsurfacePrivate = SubSurfaceInterfacePrivate::get(subsurface);
         subsurfacePrivate->parentCommit();
     }
+    // The geometry, input region or the position of a child may have changed.
+    invalidateHitTestIndex();
+    // Restacking reorders the render lists, other changes only touch the item of this surface.
+    if (childrenChanged) {
+        invalidateRenderList();
+    } else {
+        updateRenderList();
+    }
+    if (DisplayPrivate::get(compositor->display())->surfaceSnapshotsEnabled) {
+        publishSnapshot();
+    } else if (snapshot) {
+        std::atomic_store(&snapshot, std::shared_ptr<const SurfaceInterface::Snapshot>());
+    }
     if (role) {
         role->commit();
     }
     Q_EMIT q->committed();
 }
 
-void SurfaceInterfacePrivate::commitSubSurface()
+static void releaseSnapshot(const SurfaceInterface::Snapshot *snapshot)
+{
+    // The last reference may be dropped by a render thread, the buffer has to be released on its own.
+    if (ClientBuffer *buffer = snapshot->buffer) {
+        QMetaObject::invokeMethod(buffer, [buffer]() {
+            buffer->unref();
+        });
+    }
+    delete snapshot;
+}
+
+void SurfaceInterfacePrivate::publishSnapshot()
+{
+    auto next = new SurfaceInterface::Snapshot;
+    next->buffer = bufferRef;
+    if (next->buffer) {
+        next->buffer->ref();
+    }
+    next->bufferSize = bufferSize;
+    next->size = surfaceSize;
+    next->bufferScale = current.bufferScale;
+    next->bufferTransform = current.bufferTransform;
+    next->surfaceToBufferMatrix = surfaceToBufferMatrix;
+    next->damage = committedDamage;
+    next->opaque = current.opaque;
+    next->input = inputRegion;
+    if (BlurInterface *blur = current.blur.data()) {
+        next->blurred = true;
+        next->blurRegion = blur->region();
+    }
+    if (ContrastInterface *contrast = current.contrast.data()) {
+        next->contrasted = true;
+        next->contrastRegion = contrast->region();
+    }
+    next->shadowed = bool(current.shadow);
+    next->serial = ++snapshotSerial;
+    std::atomic_store(&snapshot, std::shared_ptr<const SurfaceInterface::Snapshot>(next, releaseSnapshot));
+}
+
+void SurfaceInterfacePrivate::addTreeDamage(const QRegion &region)
+{
+    if (region.isEmpty()) {
+        return;
+    }
+    SurfaceInterfacePrivate *surfacePrivate = this;
+    QPoint offset;
+    while (true) {
+        if (surfacePrivate->treeDamageTracking) {
+            surfacePrivate->treeDamage += region.translated(offset);
+            Q_EMIT surfacePrivate->q->treeDamaged();
+        }
+        SubSurfaceInterface *subsurface = surfacePrivate->subSurface;
+        if (!subsurface || !subsurface->parentSurface()) {
+            break;
+        }
+        offset += subsurface->position();
+        surfacePrivate = SurfaceInterfacePrivate::get(subsurface->parentSurface());
+    }
+}
+
+void SurfaceInterfacePrivate::commitSubSurface(SurfaceState *state)
 {
     if (subSurface->isSynchronized()) {
-        commitToCache();
+        commitToCache(state);
     } else {
         if (hasCacheState) {
-            commitToCache();
+            commitToCache(state);
             commitFromCache();
         } else {
-            applyState(&pending);
+            applyState(state);
         }
     }
 }
 
-void SurfaceInterfacePrivate::commitToCache()
+void SurfaceInterfacePrivate::commitToCache(SurfaceState *state)
 {
-    pending.mergeInto(&cached);
+    state->mergeInto(&cached);
     hasCacheState = true;
 }
 
@@ -693,6 +1362,10 @@ void SurfaceInterfacePrivate::updateEffectiveMapped()
     }
 
     mapped = effectiveMapped;
+    invalidateHitTestIndex();
+    invalidateRenderList();
+    updateIdleInhibition();
+    addTreeDamage(QRect(QPoint(0, 0), surfaceSize));
 
     if (mapped) {
         Q_EMIT q->mapped();
@@ -710,9 +1383,215 @@ void SurfaceInterfacePrivate::updateEffectiveMapped()
     }
 }
 
+void SurfaceInterfacePrivate::invalidateHitTestIndex()
+{
+    // The index of every ancestor covers this surface as well.
+    SurfaceInterfacePrivate *surfacePrivate = this;
+    while (surfacePrivate) {
+        surfacePrivate->hitTestIndexValid = false;
+        if (!surfacePrivate->subSurface || !surfacePrivate->subSurface->parentSurface()) {
+            break;
+        }
+        surfacePrivate = SurfaceInterfacePrivate::get(surfacePrivate->subSurface->parentSurface());
+    }
+}
+
+static QRect flattenSurfaceTree(SurfaceInterface *surface, const QPoint &offset, QVector<HitTestEntry> *entries)
+{
+    if (!surface->isMapped()) {
+        return QRect();
+    }
+
+    const SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    const int subtreeIndex = entries->count();
+    entries->append(HitTestEntry{HitTestEntry::Type::Subtree, surface, offset, QRectF(), 0});
+
+    QRect bounds;
+    for (auto it = surfacePrivate->current.above.crbegin(); it != surfacePrivate->current.above.crend(); ++it) {
+        const SubSurfaceInterface *child = *it;
+        bounds |= flattenSurfaceTree(child->surface(), offset + child->position(), entries);
+    }
+    if (!surface->size().isEmpty()) {
+        const QRect geometry(offset, surface->size());
+        entries->append(HitTestEntry{HitTestEntry::Type::Surface, surface, offset, QRectF(geometry), 0});
+        bounds |= geometry;
+    }
+    for (auto it = surfacePrivate->current.below.crbegin(); it != surfacePrivate->current.below.crend(); ++it) {
+        const SubSurfaceInterface *child = *it;
+        bounds |= flattenSurfaceTree(child->surface(), offset + child->position(), entries);
+    }
+
+    HitTestEntry &subtree = (*entries)[subtreeIndex];
+    subtree.rect = QRectF(bounds);
+    subtree.end = entries->count();
+    return bounds;
+}
+
+void SurfaceInterfacePrivate::rebuildHitTestIndex()
+{
+    // clear() keeps the capacity, so rebuilding the index usually doesn't allocate.
+    hitTestIndex.clear();
+    flattenSurfaceTree(q, QPoint(0, 0), &hitTestIndex);
+    hitTestIndexValid = true;
+}
+
+SurfaceInterface *SurfaceInterfacePrivate::hitTest(const QPointF &position, bool checkInputRegion)
+{
+    if (!hitTestIndexValid) {
+        rebuildHitTestIndex();
+    }
+
+    const HitTestEntry *entries = hitTestIndex.constData();
+    const int count = hitTestIndex.count();
+    for (int i = 0; i < count;) {
+        const HitTestEntry &entry = entries[i];
+        if (entry.type == HitTestEntry::Type::Subtree) {
+            i = entry.rect.contains(position) ? i + 1 : entry.end;
+            continue;
+        }
+        if (entry.rect.contains(position)) {
+            if (!checkInputRegion) {
+                return entry.surface;
+            }
+            const SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(entry.surface);
+            if (surfacePrivate->inputRegion.contains((position - entry.offset).toPoint())) {
+                return entry.surface;
+            }
+        }
+        ++i;
+    }
+
+    return nullptr;
+}
+
+void SurfaceInterfacePrivate::invalidateRenderList()
+{
+    // The render list of every ancestor contains this surface as well.
+    SurfaceInterfacePrivate *surfacePrivate = this;
+    while (surfacePrivate) {
+        surfacePrivate->renderListValid = false;
+        ++surfacePrivate->renderListVersion;
+        if (!surfacePrivate->subSurface || !surfacePrivate->subSurface->parentSurface()) {
+            break;
+        }
+        surfacePrivate = SurfaceInterfacePrivate::get(surfacePrivate->subSurface->parentSurface());
+    }
+}
+
+void SurfaceInterfacePrivate::updateRenderList()
+{
+    if (!mapped) {
+        return;
+    }
+
+    // Patch the item of this surface in the lists that are flattened already, the lists that
+    // are not get built with the new state anyway.
+    SurfaceInterfacePrivate *surfacePrivate = this;
+    QPoint offset;
+    while (surfacePrivate) {
+        if (surfacePrivate->renderListValid) {
+            for (SurfaceInterface::RenderItem &item : surfacePrivate->renderList) {
+                if (item.surface == q) {
+                    item = renderItem(offset);
+                    ++surfacePrivate->renderListVersion;
+                    break;
+                }
+            }
+        }
+        if (!surfacePrivate->subSurface || !surfacePrivate->subSurface->parentSurface()) {
+            break;
+        }
+        offset += surfacePrivate->subSurface->position();
+        surfacePrivate = SurfaceInterfacePrivate::get(surfacePrivate->subSurface->parentSurface());
+    }
+}
+
+SurfaceInterface::RenderItem SurfaceInterfacePrivate::renderItem(const QPoint &offset) const
+{
+    SurfaceInterface::RenderItem item;
+    item.surface = q;
+    item.buffer = bufferRef;
+    item.geometry = QRect(offset, surfaceSize);
+    item.surfaceToBufferMatrix = surfaceToBufferMatrix;
+    if (!current.opaque.isEmpty() && (QRegion(0, 0, surfaceSize.width(), surfaceSize.height()) - current.opaque).isEmpty()) {
+        item.flags |= SurfaceInterface::RenderItem::Opaque;
+    }
+    if (current.blur) {
+        item.flags |= SurfaceInterface::RenderItem::Blurred;
+    }
+    if (current.shadow) {
+        item.flags |= SurfaceInterface::RenderItem::Shadowed;
+    }
+    return item;
+}
+
+static void flattenRenderList(SurfaceInterface *surface, const QPoint &offset, QVector<SurfaceInterface::RenderItem> *items)
+{
+    if (!surface->isMapped()) {
+        return;
+    }
+
+    const SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    for (const SubSurfaceInterface *child : surfacePrivate->current.below) {
+        flattenRenderList(child->surface(), offset + child->position(), items);
+    }
+    items->append(surfacePrivate->renderItem(offset));
+    for (const SubSurfaceInterface *child : surfacePrivate->current.above) {
+        flattenRenderList(child->surface(), offset + child->position(), items);
+    }
+}
+
+void SurfaceInterfacePrivate::rebuildRenderList()
+{
+    renderList.clear();
+    flattenRenderList(q, QPoint(0, 0), &renderList);
+    renderListValid = true;
+}
+
+QVector<SurfaceInterface::RenderItem> SurfaceInterface::renderList() const
+{
+    if (!d->renderListValid) {
+        d->rebuildRenderList();
+    }
+    return d->renderList;
+}
+
+quint64 SurfaceInterface::renderListVersion() const
+{
+    return d->renderListVersion;
+}
+
 QRegion SurfaceInterface::damage() const
 {
-    return d->current.damage;
+    return d->committedDamage;
+}
+
+QRegion SurfaceInterface::bufferDamage() const
+{
+    return d->committedBufferDamage;
+}
+
+void SurfaceInterface::setTreeDamageTracking(bool enabled)
+{
+    d->treeDamageTracking = enabled;
+    if (!enabled) {
+        d->treeDamage = QRegion();
+    }
+}
+
+bool SurfaceInterface::treeDamageTracking() const
+{
+    return d->treeDamageTracking;
+}
+
+QRegion SurfaceInterface::treeDamage() const
+{
+    return d->treeDamage;
+}
+
+QRegion SurfaceInterface::takeTreeDamage()
+{
+    return std::exchange(d->treeDamage, QRegion());
 }
 
 QRegion SurfaceInterface::opaque() const
@@ -730,6 +1609,65 @@ qint32 SurfaceInterface::bufferScale() const
     return d->current.bufferScale;
 }
 
+void SurfaceInterface::setPreferredScale(qreal scale)
+{
+    if (qFuzzyCompare(d->preferredScale, scale)) {
+        return;
+    }
+    d->preferredScale = scale;
+    if (d->fractionalScaleExtension) {
+        d->fractionalScaleExtension->setPreferredScale(scale);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        subsurface->surface()->setPreferredScale(scale);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        subsurface->surface()->setPreferredScale(scale);
+    }
+}
+
+qreal SurfaceInterface::preferredScale() const
+{
+    return d->preferredScale;
+}
+
+SurfaceInterface::ContentType SurfaceInterface::contentType() const
+{
+    return d->current.contentType;
+}
+
+SurfaceInterface::PresentationHint SurfaceInterface::presentationHint() const
+{
+    return d->current.presentationHint;
+}
+
+ColorDescription SurfaceInterface::colorDescription() const
+{
+    return d->current.colorDescription;
+}
+
+void SurfaceInterface::setPreferredColorDescription(const ColorDescription &description)
+{
+    if (d->preferredColorDescription == description) {
+        return;
+    }
+    d->preferredColorDescription = description;
+    if (d->frogColorManagementExtension) {
+        d->frogColorManagementExtension->setPreferredColorDescription(description);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.below)) {
+        subsurface->surface()->setPreferredColorDescription(description);
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(d->current.above)) {
+        subsurface->surface()->setPreferredColorDescription(description);
+    }
+}
+
+ColorDescription SurfaceInterface::preferredColorDescription() const
+{
+    return d->preferredColorDescription;
+}
+
 OutputInterface::Transform SurfaceInterface::bufferTransform() const
 {
     return d->current.bufferTransform;
@@ -799,22 +1737,42 @@ QRect SurfaceInterface::boundingRect() const
 
 QPointer<ShadowInterface> SurfaceInterface::shadow() const
 {
-    return d->current.shadow;
+    return d->current.shadow.data();
 }
 
 QPointer<BlurInterface> SurfaceInterface::blur() const
 {
-    return d->current.blur;
+    return d->current.blur.data();
 }
 
 QPointer<ContrastInterface> SurfaceInterface::contrast() const
 {
-    return d->current.contrast;
+    return d->current.contrast.data();
+}
+
+quint64 SurfaceInterface::generation(StateCategory category) const
+{
+    return d->generations[int(category)];
+}
+
+std::shared_ptr<const SurfaceInterface::Snapshot> SurfaceInterface::snapshot() const
+{
+    return std::atomic_load(&d->snapshot);
+}
+
+QRegion SurfaceInterface::blurDamage() const
+{
+    return d->blurDamage;
+}
+
+QRegion SurfaceInterface::contrastDamage() const
+{
+    return d->contrastDamage;
 }
 
 QPointer<SlideInterface> SurfaceInterface::slideOnShowHide() const
 {
-    return d->current.slide;
+    return d->current.slide.data();
 }
 
 bool SurfaceInterface::isMapped() const
@@ -827,49 +1785,65 @@ QVector<OutputInterface *> SurfaceInterface::outputs() const
     return d->outputs;
 }
 
+static bool containsOutput(const QVector<OutputInterface *> &outputs, quint64 mask, OutputInterface *output)
+{
+    const int bit = OutputInterfacePrivate::get(output)->surfaceBit;
+    return bit != -1 ? mask & (quint64(1) << bit) : outputs.contains(output);
+}
+
 void SurfaceInterface::setOutputs(const QVector<OutputInterface *> &outputs)
 {
-    QVector<OutputInterface *> removedOutputs = d->outputs;
-    for (auto it = outputs.constBegin(), end = outputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        removedOutputs.removeOne(o);
-    }
-    for (auto it = removedOutputs.constBegin(), end = removedOutputs.constEnd(); it != end; ++it) {
-        const auto resources = (*it)->clientResources(client());
-        for (wl_resource *outputResource : resources) {
-            d->send_leave(outputResource);
-        }
-        disconnect(d->outputDestroyedConnections.take(*it));
-        disconnect(d->outputBoundConnections.take(*it));
-    }
-    QVector<OutputInterface *> addedOutputsOutputs = outputs;
-    for (auto it = d->outputs.constBegin(), end = d->outputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        addedOutputsOutputs.removeOne(o);
-    }
-    for (auto it = addedOutputsOutputs.constBegin(), end = addedOutputsOutputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        const auto resources = o->clientResources(client());
-        for (wl_resource *outputResource : resources) {
-            d->send_enter(outputResource);
-        }
-        d->outputDestroyedConnections[o] = connect(o, &OutputInterface::removed, this, [this, o] {
-            auto outputs = d->outputs;
-            if (outputs.removeAll(o)) {
-                setOutputs(outputs);
-            }
-        });
+    quint64 mask = 0;
+    bool maskExact = true;
+    for (OutputInterface *output : outputs) {
+        const int bit = OutputInterfacePrivate::get(output)->surfaceBit;
+        if (bit != -1) {
+            mask |= quint64(1) << bit;
+        } else {
+            maskExact = false;
+        }
+    }
 
-        Q_ASSERT(!d->outputBoundConnections.contains(o));
-        d->outputBoundConnections[o] = connect(o, &OutputInterface::bound, this, [this](ClientConnection *c, wl_resource *outputResource) {
-            if (c != client()) {
-                return;
+    // moving a window within an output doesn't change anything
+    if (!maskExact || !d->outputMaskExact || mask != d->outputMask) {
+        wl_client *client = d->resource()->client();
+        for (OutputInterface *output : qAsConst(d->outputs)) {
+            if (containsOutput(outputs, mask, output)) {
+                continue;
             }
-            d->send_enter(outputResource);
-        });
+            OutputInterfacePrivate *outputPrivate = OutputInterfacePrivate::get(output);
+            const auto resources = outputPrivate->resourceMap();
+            for (auto it = resources.constFind(client); it != resources.constEnd() && it.key() == client; ++it) {
+                d->send_leave((*it)->handle);
+            }
+            outputPrivate->surfaces.remove(this);
+        }
+        for (OutputInterface *output : outputs) {
+            if (containsOutput(d->outputs, d->outputMask, output)) {
+                continue;
+            }
+            OutputInterfacePrivate *outputPrivate = OutputInterfacePrivate::get(output);
+            if (outputPrivate->surfaces.contains(this)) {
+                continue; // listed twice
+            }
+            const auto resources = outputPrivate->resourceMap();
+            for (auto it = resources.constFind(client); it != resources.constEnd() && it.key() == client; ++it) {
+                d->send_enter((*it)->handle);
+            }
+            outputPrivate->surfaces.insert(this);
+        }
     }
 
     d->outputs = outputs;
+    d->outputMask = mask;
+    d->outputMaskExact = maskExact;
+    if (d->dmabufFeedbackV1) {
+        // the tranche of the device driving the output goes along with the surface
+        LinuxDmaBufV1FeedbackPrivate *feedback = LinuxDmaBufV1FeedbackPrivate::get(d->dmabufFeedbackV1.data());
+        if (feedback->m_bufferintegration) {
+            feedback->m_bufferintegration->updateDeviceOutput(feedback);
+        }
+    }
     for (auto child : qAsConst(d->current.below)) {
         child->surface()->setOutputs(outputs);
     }
@@ -884,58 +1858,32 @@ SurfaceInterface *SurfaceInterface::surfaceAt(const QPointF &position)
         return nullptr;
     }
 
-    for (auto it = d->current.above.crbegin(); it != d->current.above.crend(); ++it) {
-        const SubSurfaceInterface *current = *it;
-        SurfaceInterface *surface = current->surface();
-        if (auto s = surface->surfaceAt(position - current->position())) {
-            return s;
-        }
+    // Surface trees are hit tested with the flattened index, it avoids walking the tree.
+    if (!d->current.above.isEmpty() || !d->current.below.isEmpty()) {
+        return d->hitTest(position, false);
     }
 
     // check whether the geometry contains the pos
     if (!size().isEmpty() && QRectF(QPoint(0, 0), size()).contains(position)) {
         return this;
     }
-
-    for (auto it = d->current.below.crbegin(); it != d->current.below.crend(); ++it) {
-        const SubSurfaceInterface *current = *it;
-        SurfaceInterface *surface = current->surface();
-        if (auto s = surface->surfaceAt(position - current->position())) {
-            return s;
-        }
-    }
     return nullptr;
 }
 
 SurfaceInterface *SurfaceInterface::inputSurfaceAt(const QPointF &position)
 {
-    // TODO: Most of this is very similar to SurfaceInterface::surfaceAt
-    //       Is there a way to reduce the code duplication?
     if (!isMapped()) {
         return nullptr;
     }
 
-    for (auto it = d->current.above.crbegin(); it != d->current.above.crend(); ++it) {
-        const SubSurfaceInterface *current = *it;
-        auto surface = current->surface();
-        if (auto s = surface->inputSurfaceAt(position - current->position())) {
-            return s;
-        }
+    if (!d->current.above.isEmpty() || !d->current.below.isEmpty()) {
+        return d->hitTest(position, true);
     }
 
     // check whether the geometry and input region contain the pos
     if (!size().isEmpty() && QRectF(QPoint(0, 0), size()).contains(position) && input().contains(position.toPoint())) {
         return this;
     }
-
-    for (auto it = d->current.below.crbegin(); it != d->current.below.crend(); ++it) {
-        const SubSurfaceInterface *current = *it;
-        auto surface = current->surface();
-        if (auto s = surface->inputSurfaceAt(position - current->position())) {
-            return s;
-        }
-    }
-
     return nullptr;
 }
 
@@ -959,6 +1907,16 @@ LinuxDmaBufV1Feedback *SurfaceInterface::dmabufFeedbackV1() const
     return d->dmabufFeedbackV1.data();
 }
 
+void SurfaceInterface::setWaitForBufferFences(bool wait)
+{
+    d->waitForBufferFences = wait;
+}
+
+bool SurfaceInterface::waitsForBufferFences() const
+{
+    return d->waitForBufferFences;
+}
+
 QPointF SurfaceInterface::mapToBuffer(const QPointF &point) const
 {
     return d->surfaceToBufferMatrix.map(point);
@@ -978,6 +1936,102 @@ static QRegion map_helper(const QMatrix4x4 &matrix, const QRegion &region)
     return result;
 }
 
+static int floorDiv(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static int ceilDiv(int value, int divisor)
+{
+    return value >= 0 ? (value + divisor - 1) / divisor : -(-value / divisor);
+}
+
+/**
+ * Maps a rectangle in the buffer coordinate space to the surface coordinate space
+ * without going through the floating point transformation matrix. It's only valid if
+ * the surface has no viewport applied, i.e. the mapping is fully described by the
+ * buffer transform and an integer buffer scale.
+ *
+ * The rectangle is rounded outwards if the buffer scale doesn't divide its edges.
+ **/
+static QRect mapFromBufferRect(const QRect &rect, OutputInterface::Transform transform, int scale, const QSize &bufferSize)
+{
+    const int w = bufferSize.width() / scale;
+    const int h = bufferSize.height() / scale;
+    const int x0 = floorDiv(rect.x(), scale);
+    const int y0 = floorDiv(rect.y(), scale);
+    const int x1 = ceilDiv(rect.x() + rect.width(), scale);
+    const int y1 = ceilDiv(rect.y() + rect.height(), scale);
+
+    switch (transform) {
+    case OutputInterface::Transform::Normal:
+        return QRect(QPoint(x0, y0), QPoint(x1 - 1, y1 - 1));
+    case OutputInterface::Transform::Rotated90:
+        return QRect(QPoint(h - y1, x0), QPoint(h - y0 - 1, x1 - 1));
+    case OutputInterface::Transform::Rotated180:
+        return QRect(QPoint(w - x1, h - y1), QPoint(w - x0 - 1, h - y0 - 1));
+    case OutputInterface::Transform::Rotated270:
+        return QRect(QPoint(y0, w - x1), QPoint(y1 - 1, w - x0 - 1));
+    case OutputInterface::Transform::Flipped:
+        return QRect(QPoint(w - x1, y0), QPoint(w - x0 - 1, y1 - 1));
+    case OutputInterface::Transform::Flipped90:
+        return QRect(QPoint(y0, x0), QPoint(y1 - 1, x1 - 1));
+    case OutputInterface::Transform::Flipped180:
+        return QRect(QPoint(x0, h - y1), QPoint(x1 - 1, h - y0 - 1));
+    case OutputInterface::Transform::Flipped270:
+        return QRect(QPoint(h - y1, w - x1), QPoint(h - y0 - 1, w - x0 - 1));
+    }
+
+    Q_UNREACHABLE();
+}
+
+QRect SurfaceInterfacePrivate::mapRectFromBuffer(const QRect &rect) const
+{
+    if (!integerBufferMapping) {
+        return bufferToSurfaceMatrix.mapRect(rect);
+    }
+    if (current.bufferScale == 1 && current.bufferTransform == OutputInterface::Transform::Normal) {
+        return rect;
+    }
+    return mapFromBufferRect(rect, current.bufferTransform, current.bufferScale, bufferSize);
+}
+
+QRect SurfaceInterfacePrivate::mapRectToBuffer(const QRect &rect) const
+{
+    if (current.bufferScale == 1 && current.bufferTransform == OutputInterface::Transform::Normal && integerBufferMapping) {
+        return rect;
+    }
+    // Round outwards, a partially covered buffer pixel has to be considered as damaged.
+    return surfaceToBufferMatrix.mapRect(QRectF(rect)).toAlignedRect();
+}
+
+QRegion SurfaceInterfacePrivate::mapFromBuffer(const QRegion &region) const
+{
+    if (integerBufferMapping && current.bufferScale == 1 && current.bufferTransform == OutputInterface::Transform::Normal) {
+        return region;
+    }
+
+    QRegion result;
+    for (const QRect &rect : region) {
+        result += mapRectFromBuffer(rect);
+    }
+    return result;
+}
+
+SmallRegion SurfaceInterfacePrivate::mapFromBuffer(const SmallRegion &region) const
+{
+    return region.mapped([this](const QRect &rect) {
+        return mapRectFromBuffer(rect);
+    });
+}
+
+SmallRegion SurfaceInterfacePrivate::mapToBuffer(const SmallRegion &region) const
+{
+    return region.mapped([this](const QRect &rect) {
+        return mapRectToBuffer(rect);
+    });
+}
+
 QRegion SurfaceInterface::mapToBuffer(const QRegion &region) const
 {
     return map_helper(d->surfaceToBufferMatrix, region);
@@ -985,7 +2039,7 @@ QRegion SurfaceInterface::mapToBuffer(const QRegion &region) const
 
 QRegion SurfaceInterface::mapFromBuffer(const QRegion &region) const
 {
-    return map_helper(d->bufferToSurfaceMatrix, region);
+    return d->mapFromBuffer(region);
 }
 
 QMatrix4x4 SurfaceInterface::surfaceToBufferMatrix() const
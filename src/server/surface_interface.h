@@ -6,12 +6,17 @@
 */
 #pragma once
 
+#include "colordescription.h"
 #include "output_interface.h"
+#include "presentationtime_interface.h"
 
 #include <QMatrix4x4>
 #include <QObject>
 #include <QPointer>
 #include <QRegion>
+// std
+#include <chrono>
+#include <memory>
 
 #include <DWayland/Server/kwaylandserver_export.h>
 
@@ -74,6 +79,197 @@ class KWAYLANDSERVER_EXPORT SurfaceInterface : public QObject
     Q_PROPERTY(KWaylandServer::OutputInterface::Transform bufferTransform READ bufferTransform NOTIFY bufferTransformChanged)
     Q_PROPERTY(QSize size READ size NOTIFY sizeChanged)
 public:
+    /**
+     * How often the frame callbacks of a surface are sent.
+     *
+     * @see setFrameCallbackPolicy
+     */
+    enum class FrameCallbackPolicy {
+        /**
+         * The frame callbacks are sent every time frameRendered() is called.
+         */
+        FullRate,
+        /**
+         * The frame callbacks are sent at most once per reducedFrameCallbackInterval(),
+         * e.g. for minimized windows that should still update their thumbnails.
+         */
+        ReducedRate,
+        /**
+         * The frame callbacks are held until the policy changes, e.g. for hidden windows.
+         */
+        Paused,
+    };
+    Q_ENUM(FrameCallbackPolicy)
+
+    /**
+     * The parts of the committed state that have their own generation counter.
+     *
+     * @see generation
+     */
+    enum class StateCategory {
+        /**
+         * A buffer has been attached, along with its damage.
+         */
+        Buffer,
+        /**
+         * The surface size, the buffer size, the buffer scale, the buffer transform or the
+         * mapping between surface and buffer coordinates has changed.
+         */
+        Geometry,
+        /**
+         * The opaque region or the effective input region has changed.
+         */
+        Regions,
+        /**
+         * The shadow, blur, contrast or slide has changed, i.e. shadowChanged(), blurChanged(),
+         * contrastChanged() or slideOnShowHideChanged() got emitted.
+         */
+        Effects,
+        /**
+         * The stacking order of the sub-surfaces or the set of sub-surfaces has changed.
+         */
+        Children,
+    };
+    Q_ENUM(StateCategory)
+
+    /**
+     * The kind of content the client says the surface shows.
+     *
+     * @see contentType
+     */
+    enum class ContentType {
+        None,
+        Photo,
+        Video,
+        Game,
+    };
+    Q_ENUM(ContentType)
+
+    /**
+     * Whether the client accepts tearing for the surface.
+     *
+     * @see presentationHint
+     */
+    enum class PresentationHint {
+        /**
+         * The content is synchronized to the vertical blank, this is the default.
+         */
+        VSync,
+        /**
+         * The content should be presented with the lowest latency, tearing is acceptable.
+         */
+        Async,
+    };
+    Q_ENUM(PresentationHint)
+
+    /**
+     * A commit of the surface, as recorded while the commit tracing of the Display is enabled.
+     *
+     * @see commitTrace
+     * @see Display::setCommitTracingEnabled
+     */
+    struct CommitRecord {
+        enum class BufferType {
+            /**
+             * The commit didn't attach a buffer.
+             */
+            Unchanged,
+            /**
+             * The commit attached a null buffer, the surface got unmapped.
+             */
+            Detached,
+            Shm,
+            DmaBuf,
+            Drm,
+            SinglePixel,
+            Other,
+        };
+        /**
+         * The time of the commit on the monotonic clock.
+         */
+        std::chrono::nanoseconds timestamp = std::chrono::nanoseconds::zero();
+        BufferType bufferType = BufferType::Unchanged;
+        QSize bufferSize;
+        /**
+         * The damaged area in surface and buffer coordinates, overlaps are counted twice.
+         */
+        qint64 damageArea = 0;
+        /**
+         * Whether the surface was a synchronized sub-surface, its state is cached until the
+         * parent commits.
+         */
+        bool synchronized = false;
+        /**
+         * Whether the commit requested frame callbacks.
+         */
+        bool frameCallbacks = false;
+        /**
+         * When the frame callbacks got sent, zero if they are not sent yet.
+         */
+        std::chrono::nanoseconds frameCallbacksSent = std::chrono::nanoseconds::zero();
+    };
+
+    /**
+     * A mapped surface of a surface tree, as listed by renderList().
+     */
+    struct RenderItem {
+        enum Flag {
+            /**
+             * The opaque region covers the whole surface.
+             */
+            Opaque = 0x1,
+            /**
+             * The surface has a blur, see blur().
+             */
+            Blurred = 0x2,
+            /**
+             * The surface has a shadow, see shadow().
+             */
+            Shadowed = 0x4,
+        };
+        Q_DECLARE_FLAGS(Flags, Flag)
+
+        SurfaceInterface *surface = nullptr;
+        ClientBuffer *buffer = nullptr;
+        /**
+         * The geometry of the surface relative to the surface the list belongs to.
+         */
+        QRect geometry;
+        QMatrix4x4 surfaceToBufferMatrix;
+        Flags flags;
+    };
+
+    /**
+     * The committed state of the surface, as published for render threads, see snapshot().
+     * A Snapshot is never modified, later commits publish a new one.
+     */
+    struct Snapshot {
+        /**
+         * The buffer stays referenced until the last reference to the Snapshot is dropped.
+         */
+        ClientBuffer *buffer = nullptr;
+        QSize bufferSize;
+        QSize size;
+        qint32 bufferScale = 1;
+        OutputInterface::Transform bufferTransform = OutputInterface::Transform::Normal;
+        QMatrix4x4 surfaceToBufferMatrix;
+        QRegion damage;
+        QRegion opaque;
+        QRegion input;
+        bool blurred = false;
+        /**
+         * The blurred region, a null region blurs the whole surface.
+         */
+        QRegion blurRegion;
+        bool contrasted = false;
+        QRegion contrastRegion;
+        bool shadowed = false;
+        /**
+         * Incremented with every published Snapshot of the surface.
+         */
+        quint64 serial = 0;
+    };
+
     explicit SurfaceInterface(CompositorInterface *compositor, wl_resource *resource);
     ~SurfaceInterface() override;
 
@@ -157,13 +353,180 @@ public:
      */
     QPointF mapToChild(SurfaceInterface *child, const QPointF &point) const;
 
+    /**
+     * Delivers the frame callbacks of this surface and its sub-surfaces.
+     *
+     * The callbacks stay queued while all outputs() of the surface are powered down, they
+     * are sent by the first call after one of them is turned on again.
+     */
     void frameRendered(quint32 msec);
+    /**
+     * Delivers the frame callbacks of this surface and its sub-surfaces for a vblank of @p output.
+     *
+     * A surface that spans several outputs is paced by its frameOutput(), vblanks of any other
+     * output are ignored, so the callbacks are sent once per refresh cycle. Nothing is sent while
+     * the surface is throttled, the callbacks stay queued until the next vblank of an output
+     * the surface is visible on. Unlike frameRendered(quint32) this makes hidden clients stop
+     * rendering instead of drawing at the full refresh rate.
+     *
+     * @param output The output whose vblank happened
+     * @param timestamp The time of the vblank in the CLOCK_MONOTONIC domain
+     * @see isFrameThrottled
+     */
+    void frameRendered(OutputInterface *output, std::chrono::nanoseconds timestamp);
     bool hasFrameCallbacks() const;
+    /**
+     * @returns the time between applying the last committed frame callbacks of this surface
+     * and sending them out, or zero if no frame callbacks have been sent yet
+     *
+     * If several commits requested frame callbacks before they were sent, the time is
+     * measured from the first of them.
+     */
+    std::chrono::nanoseconds frameCallbackLatency() const;
+    /**
+     * Returns the output whose vblanks drive the frame callbacks of this surface, that is the
+     * first of outputs() which is powered on, or @c null if there is no such output.
+     */
+    OutputInterface *frameOutput() const;
+    /**
+     * Sets whether the surface is completely covered by other surfaces. Occluded surfaces don't
+     * get frame callbacks from frameRendered(OutputInterface *, std::chrono::nanoseconds).
+     */
+    void setOccluded(bool occluded);
+    /**
+     * Returns @c true if the compositor marked the surface as occluded.
+     * @see setOccluded
+     */
+    bool isOccluded() const;
+    /**
+     * Returns @c true if the surface doesn't get frame callbacks on every vblank because it is
+     * occluded, not shown on any powered on output or its frame callback policy is not
+     * FrameCallbackPolicy::FullRate.
+     */
+    bool isFrameThrottled() const;
+    /**
+     * Sets how often both variants of frameRendered() send the frame callbacks of this surface
+     * and its sub-surfaces. Held callbacks stay queued, the next frameRendered() call after the
+     * policy allows it again sends them. The default is FrameCallbackPolicy::FullRate.
+     *
+     * Unlike setOccluded() the policy holds the callbacks of the whole sub-surface tree, e.g.
+     * of a video player in a minimized window.
+     */
+    void setFrameCallbackPolicy(FrameCallbackPolicy policy);
+    FrameCallbackPolicy frameCallbackPolicy() const;
+    /**
+     * Sets the minimum time between two deliveries of frame callbacks with the
+     * FrameCallbackPolicy::ReducedRate policy. The default is one second.
+     */
+    void setReducedFrameCallbackInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds reducedFrameCallbackInterval() const;
+    /**
+     * Returns the recent commits of this surface, the oldest first. Only commits made while
+     * the commit tracing of the Display was enabled are recorded, at most the last 256.
+     *
+     * @see Display::setCommitTracingEnabled
+     * @see Display::exportCommitTrace
+     */
+    QVector<CommitRecord> commitTrace() const;
+    /**
+     * Reports to the presentation feedbacks of the current content of this surface and its
+     * sub-surfaces that the content got presented on @p output.
+     *
+     * @param output The output the content got shown on
+     * @param timestamp The time of the presentation in the CLOCK_MONOTONIC domain
+     * @param refresh The duration of the refresh cycle of @p output, zero if unknown
+     * @param sequence The vertical retrace counter of @p output, zero if unknown
+     * @param kinds How the content got presented
+     * @see PresentationTimeInterface
+     */
+    void presented(OutputInterface *output, std::chrono::nanoseconds timestamp, std::chrono::nanoseconds refresh, quint64 sequence, PresentationTimeInterface::Kinds kinds);
+    /**
+     * Reports to the presentation feedbacks of the current content of this surface and its
+     * sub-surfaces that the content will not be presented, e.g. because the surface is hidden.
+     */
+    void discardPresentation();
+    /**
+     * Returns @c true if a presentation feedback is waiting for the current content.
+     */
+    bool hasPresentationFeedback() const;
 
     QRegion damage() const;
+    /**
+     * Returns the damage of the last commit that attached a buffer, in buffer coordinates.
+     *
+     * This is the surface damage mapped through the buffer scale, transform and viewport,
+     * united with the buffer damage and clipped to the buffer. Pixels that are partially
+     * covered by the surface damage are included.
+     *
+     * @see damage
+     * @see ShmClientBuffer::damagedRects
+     */
+    QRegion bufferDamage() const;
+    /**
+     * Enables accumulating the damage of this surface and its sub-surface tree, in the
+     * coordinates of this surface. Besides the damage of every commit in the tree, it covers
+     * the areas exposed or covered when a sub-surface is mapped, unmapped, resized, moved,
+     * restacked or removed. The tracking is disabled by default.
+     *
+     * A compositor can use it for toplevels instead of walking all sub-surfaces every frame.
+     *
+     * @see takeTreeDamage
+     * @see treeDamaged
+     */
+    void setTreeDamageTracking(bool enabled);
+    bool treeDamageTracking() const;
+    /**
+     * Returns the damage of the sub-surface tree accumulated since the tracking got enabled
+     * or takeTreeDamage() got called the last time.
+     */
+    QRegion treeDamage() const;
+    /**
+     * Returns the accumulated damage of the sub-surface tree and resets it, e.g. after the
+     * surface tree got repainted.
+     */
+    QRegion takeTreeDamage();
     QRegion opaque() const;
     QRegion input() const;
     qint32 bufferScale() const;
+    /**
+     * Sets the scale the client should render this surface and its sub-surfaces at, e.g. the
+     * scale of the output the surface is shown on. It is announced through the fractional
+     * scale extension of the surface.
+     *
+     * @see FractionalScaleManagerV1Interface
+     */
+    void setPreferredScale(qreal scale);
+    qreal preferredScale() const;
+    /**
+     * Returns the content type of the surface, set through the content type extension.
+     * The compositor can take it into account for direct scanout, the content type property
+     * of the connector or an automatic variable refresh rate policy.
+     *
+     * @see ContentTypeManagerV1Interface
+     */
+    ContentType contentType() const;
+    /**
+     * Returns whether the surface may be presented with tearing, set through the tearing
+     * control extension.
+     *
+     * @see TearingControlManagerV1Interface
+     */
+    PresentationHint presentationHint() const;
+    /**
+     * Returns the color space and the HDR metadata of the contents of the surface, set through
+     * the color management extension. If it matches the one of the output, the contents can be
+     * shown without converting them.
+     *
+     * @see FrogColorManagementV1Interface
+     */
+    ColorDescription colorDescription() const;
+    /**
+     * Sets the color space the client should render this surface and its sub-surfaces in,
+     * usually the one of the output the surface is shown on, by default sRGB. It is announced
+     * through the color management extension of the surface.
+     */
+    void setPreferredColorDescription(const ColorDescription &description);
+    ColorDescription preferredColorDescription() const;
     /**
      * Returns the buffer transform that had been applied to the buffer to compensate for
      * output rotation.
@@ -221,6 +584,12 @@ public:
      * @returns The Blur for this Surface.
      */
     QPointer<BlurInterface> blur() const;
+    /**
+     * Returns the part of the surface that the last blurChanged() affected, in surface-local
+     * coordinates, i.e. the area that got added to or removed from the blur region. The whole
+     * old and new blur region is returned if the blur was set or unset.
+     */
+    QRegion blurDamage() const;
 
     /**
      * @returns The Slide for this Surface.
@@ -231,6 +600,31 @@ public:
      * @returns The Contrast for this Surface.
      */
     QPointer<ContrastInterface> contrast() const;
+    /**
+     * Returns the part of the surface that the last contrastChanged() affected, in surface-local
+     * coordinates. If only the region changed, it's the area that got added to or removed from
+     * it, otherwise the whole old and new contrast region.
+     */
+    QRegion contrastDamage() const;
+
+    /**
+     * Returns a counter that is incremented by every commit that changes the state of the
+     * given @p category. It's monotonic and starts at zero, so render code can poll the state
+     * of many surfaces once per frame instead of connecting to the change signals of each.
+     */
+    quint64 generation(StateCategory category) const;
+
+    /**
+     * Returns the state of the surface as of its last commit. The Snapshot is published with
+     * an atomic pointer swap, so unlike the other methods this one may be called from any
+     * thread, e.g. by a render thread that takes the latest state of the surface without locking
+     * or copying it. Returns @c nullptr unless Display::surfaceSnapshotsEnabled was enabled when
+     * the surface committed.
+     *
+     * The render thread must still not use the surface or the buffer as QObjects, they live on
+     * the thread of the Display.
+     */
+    std::shared_ptr<const Snapshot> snapshot() const;
 
     /**
      * Whether the SurfaceInterface is currently considered to be mapped.
@@ -269,6 +663,23 @@ public:
      */
     SurfaceInterface *inputSurfaceAt(const QPointF &position);
 
+    /**
+     * Returns the mapped surfaces of the tree rooted at this surface, including this surface,
+     * ordered from the bottommost to the topmost one. Render code can draw the tree by iterating
+     * the list instead of walking the sub-surfaces.
+     *
+     * The list is updated in place when a surface of the tree commits new contents, it is only
+     * flattened again when a sub-surface is added, removed, restacked, moved, mapped or unmapped.
+     *
+     * @see renderListVersion
+     */
+    QVector<RenderItem> renderList() const;
+    /**
+     * Returns a counter that is incremented whenever the renderList() changes, so render code
+     * can keep its own copy of the list until the version changes.
+     */
+    quint64 renderListVersion() const;
+
     /**
      * Sets the @p outputs this SurfaceInterface overlaps with, may be empty.
      *
@@ -308,6 +719,19 @@ public:
      */
     LinuxDmaBufV1Feedback *dmabufFeedbackV1() const;
 
+    /**
+     * Sets whether commits attaching a dmabuf wait for the implicit fences of the buffer before
+     * they are applied, so the compositor never picks up a buffer the GPU is still rendering
+     * into. The commits are held back without blocking, later commits of the surface are applied
+     * together with them. A synchronized sub-surface keeps showing its previous state when its
+     * parent gets committed in the meantime.
+     *
+     * Buffers with an explicit sync acquire point always wait for it. By default implicit fences
+     * are not waited for.
+     */
+    void setWaitForBufferFences(bool wait);
+    bool waitsForBufferFences() const;
+
     /**
      * @returns The SurfaceInterface for the @p native resource.
      */
@@ -345,6 +769,12 @@ Q_SIGNALS:
      * @see damage
      */
     void damaged(const QRegion &);
+    /**
+     * Emitted when damage got added to the tree damage of this surface.
+     *
+     * @see setTreeDamageTracking
+     */
+    void treeDamaged();
     void opaqueChanged(const QRegion &);
     void inputChanged(const QRegion &);
     /**
@@ -372,9 +802,33 @@ Q_SIGNALS:
      */
     void sizeChanged();
     void shadowChanged();
+    /**
+     * This signal is emitted when the blur of the surface has changed. Setting a blur that is
+     * identical to the current one doesn't emit it.
+     *
+     * @see blurDamage
+     */
     void blurChanged();
     void slideOnShowHideChanged();
+    /**
+     * This signal is emitted when the contrast of the surface has changed. Setting a contrast
+     * that is identical to the current one doesn't emit it.
+     *
+     * @see contrastDamage
+     */
     void contrastChanged();
+    /**
+     * This signal is emitted when a commit changed the content type of the surface.
+     */
+    void contentTypeChanged();
+    /**
+     * This signal is emitted when a commit changed the presentation hint of the surface.
+     */
+    void presentationHintChanged();
+    /**
+     * This signal is emitted when a commit changed the color description of the surface.
+     */
+    void colorDescriptionChanged();
     /**
      * Emitted whenever a new child sub-surface @p subSurface is added.
      */
@@ -420,4 +874,5 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::SurfaceInterface::RenderItem::Flags)
 Q_DECLARE_METATYPE(KWaylandServer::SurfaceInterface *)
@@ -6,46 +6,96 @@
 */
 #pragma once
 
+#include "colordescription.h"
+#include "linuxdrmsyncobj_v1_interface_p.h"
+#include "smallregion_p.h"
 #include "surface_interface.h"
 #include "utils.h"
+#include "weakhandle.h"
 // Qt
+#include <QColor>
 #include <QHash>
+#include <QSharedPointer>
+#include <QSocketNotifier>
 #include <QVector>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
 // Wayland
 #include "qwayland-server-wayland.h"
 
 namespace KWaylandServer
 {
+class CommitTrace;
+class AppMenuInterface;
+class ContentTypeV1Interface;
+class FractionalScaleV1Interface;
+class FrogColorManagedSurfaceV1Interface;
 class IdleInhibitorV1Interface;
+class IdleInhibitManagerV1InterfacePrivate;
+class LinuxDrmSyncObjSurfaceV1Interface;
+class ServerSideDecorationInterface;
+class ServerSideDecorationPaletteInterface;
 class SurfaceRole;
+class TearingControlV1Interface;
 class ViewportInterface;
 
 struct SurfaceState {
+    /**
+     * Each bit marks a field that has been set by the client since the state was last merged.
+     * Only fields whose bit is set are moved into the target state, everything else is left
+     * untouched in both states.
+     **/
+    enum Field : quint32 {
+        BufferField = 1 << 0,
+        OpaqueField = 1 << 1,
+        InputField = 1 << 2,
+        BufferScaleField = 1 << 3,
+        BufferTransformField = 1 << 4,
+        ShadowField = 1 << 5,
+        BlurField = 1 << 6,
+        ContrastField = 1 << 7,
+        SlideField = 1 << 8,
+        ChildrenField = 1 << 9,
+        ViewportSourceField = 1 << 10,
+        ViewportDestinationField = 1 << 11,
+        ContentTypeField = 1 << 12,
+        PresentationHintField = 1 << 13,
+        ColorDescriptionField = 1 << 14,
+    };
+
     void mergeInto(SurfaceState *target);
 
-    QRegion damage = QRegion();
-    QRegion bufferDamage = QRegion();
+    bool isSet(Field field) const
+    {
+        return changedFields & field;
+    }
+    void markSet(Field field)
+    {
+        changedFields |= field;
+    }
+
+    quint32 changedFields = 0;
+    SmallRegion damage;
+    SmallRegion bufferDamage;
     QRegion opaque = QRegion();
     QRegion input = infiniteRegion();
-    bool inputIsSet = false;
-    bool opaqueIsSet = false;
-    bool bufferIsSet = false;
-    bool shadowIsSet = false;
-    bool blurIsSet = false;
-    bool contrastIsSet = false;
-    bool slideIsSet = false;
-    bool childrenChanged = false;
-    bool bufferScaleIsSet = false;
-    bool bufferTransformIsSet = false;
     qint32 bufferScale = 1;
     OutputInterface::Transform bufferTransform = OutputInterface::Transform::Normal;
     wl_list frameCallbacks;
+    wl_list presentationFeedbacks;
     QPoint offset = QPoint();
-    QPointer<ClientBuffer> buffer;
-    QPointer<ShadowInterface> shadow;
-    QPointer<BlurInterface> blur;
-    QPointer<ContrastInterface> contrast;
-    QPointer<SlideInterface> slide;
+    WeakHandle<ClientBuffer> buffer;
+    // The explicit sync points of the buffer. The acquire point moves along with the buffer,
+    // the release point is handed to the buffer when the state gets committed.
+    LinuxDrmSyncObjPoint acquirePoint;
+    LinuxDrmSyncObjPoint releasePoint;
+    WeakHandle<ShadowInterface> shadow;
+    WeakHandle<BlurInterface> blur;
+    WeakHandle<ContrastInterface> contrast;
+    WeakHandle<SlideInterface> slide;
 
     // Subsurfaces are stored in two lists. The below list contains subsurfaces that
     // are below their parent surface; the above list contains subsurfaces that are
@@ -56,9 +106,32 @@ struct SurfaceState {
     struct {
         QRectF sourceGeometry = QRectF();
         QSize destinationSize = QSize();
-        bool sourceGeometryIsSet = false;
-        bool destinationSizeIsSet = false;
     } viewport;
+
+    SurfaceInterface::ContentType contentType = SurfaceInterface::ContentType::None;
+    SurfaceInterface::PresentationHint presentationHint = SurfaceInterface::PresentationHint::VSync;
+    ColorDescription colorDescription;
+};
+
+/**
+ * An entry in the flattened hit-test index of a surface tree. The entries are stored in the
+ * order in which the surfaces have to be tested, i.e. from the topmost surface to the bottommost
+ * one. Every surface contributes a Subtree entry followed by the entries of its subtree, the
+ * subtree can be skipped altogether if its bounding rect doesn't contain the tested position.
+ **/
+struct HitTestEntry {
+    enum class Type {
+        Subtree,
+        Surface,
+    };
+    Type type;
+    SurfaceInterface *surface;
+    // Position of the surface relative to the surface that owns the index.
+    QPoint offset;
+    // The bounding rect of the subtree or the geometry of the surface, relative to the owner.
+    QRectF rect;
+    // The index of the first entry past the subtree, only valid for Subtree entries.
+    int end;
 };
 
 class SurfaceInterfacePrivate : public QtWaylandServer::wl_surface
@@ -74,52 +147,165 @@ public:
 
     void addChild(SubSurfaceInterface *subsurface);
     void removeChild(SubSurfaceInterface *subsurface);
+    bool moveChild(SubSurfaceInterface *subsurface, QList<SubSurfaceInterface *> *list, int position);
     bool raiseChild(SubSurfaceInterface *subsurface, SurfaceInterface *anchor);
     bool lowerChild(SubSurfaceInterface *subsurface, SurfaceInterface *anchor);
-    void setShadow(const QPointer<ShadowInterface> &shadow);
-    void setBlur(const QPointer<BlurInterface> &blur);
-    void setContrast(const QPointer<ContrastInterface> &contrast);
-    void setSlide(const QPointer<SlideInterface> &slide);
+    void setShadow(ShadowInterface *shadow);
+    void setBlur(BlurInterface *blur);
+    void setContrast(ContrastInterface *contrast);
+    void setSlide(SlideInterface *slide);
     void installPointerConstraint(LockedPointerV1Interface *lock);
     void installPointerConstraint(ConfinedPointerV1Interface *confinement);
-    void installIdleInhibitor(IdleInhibitorV1Interface *inhibitor);
+    void installIdleInhibitor(IdleInhibitManagerV1InterfacePrivate *manager, IdleInhibitorV1Interface *inhibitor);
+    void updateIdleInhibition();
 
-    void commitToCache();
+    void commit(SurfaceState *state);
+    void commitToCache(SurfaceState *state);
     void commitFromCache();
 
-    void commitSubSurface();
+    void commitSubSurface(SurfaceState *state);
+    void deferPendingState();
+    void waitForBuffer();
+    void stopWaitingForBuffer();
+    void applyDeferredState();
     QMatrix4x4 buildSurfaceToBufferMatrix();
+    QRect mapRectFromBuffer(const QRect &rect) const;
+    QRect mapRectToBuffer(const QRect &rect) const;
+    QRegion mapFromBuffer(const QRegion &region) const;
+    SmallRegion mapFromBuffer(const SmallRegion &region) const;
+    SmallRegion mapToBuffer(const SmallRegion &region) const;
     void applyState(SurfaceState *next);
 
     bool computeEffectiveMapped() const;
     void updateEffectiveMapped();
 
+    void sendFrameCallbacks(quint32 msec, bool skipOccluded);
+    bool frameCallbacksDue(quint32 msec);
+
+    void addTreeDamage(const QRegion &region);
+
+    void invalidateHitTestIndex();
+    void rebuildHitTestIndex();
+    SurfaceInterface *hitTest(const QPointF &position, bool checkInputRegion);
+
+    void invalidateRenderList();
+    void updateRenderList();
+    void rebuildRenderList();
+    SurfaceInterface::RenderItem renderItem(const QPoint &offset) const;
+
     CompositorInterface *compositor;
     SurfaceInterface *q;
     SurfaceRole *role = nullptr;
     SurfaceState current;
     SurfaceState pending;
     SurfaceState cached;
+    // The commits waiting for their buffer to be ready, i.e. for its acquire point or its
+    // implicit fences, in commit order. Every commit keeps its own state, a commit is applied
+    // once its buffer and those of all commits before it are ready.
+    std::deque<std::unique_ptr<SurfaceState>> deferredStates;
+    bool waitForBufferFences = false;
+    QScopedPointer<QSocketNotifier> bufferReadyNotifier;
     SubSurfaceInterface *subSurface = nullptr;
     QMatrix4x4 surfaceToBufferMatrix;
     QMatrix4x4 bufferToSurfaceMatrix;
+    // Whether buffer coordinates map to surface coordinates by the buffer transform and
+    // the integer buffer scale alone, i.e. no viewport is involved.
+    bool integerBufferMapping = false;
     QSize bufferSize;
     QSize implicitSurfaceSize;
     QSize surfaceSize;
     QRegion inputRegion;
+    QRegion committedDamage;
+    QRegion committedBufferDamage;
+    bool treeDamageTracking = false;
+    QRegion treeDamage;
     ClientBuffer *bufferRef = nullptr;
     bool mapped = false;
     bool hasCacheState = false;
+    bool occluded = false;
+    bool hitTestIndexValid = false;
+    QVector<HitTestEntry> hitTestIndex;
+    bool renderListValid = false;
+    quint64 renderListVersion = 0;
+    QVector<SurfaceInterface::RenderItem> renderList;
+
+    // What the blur or the contrast of the surface looked like at the last change, clients
+    // tend to set an identical one with every commit.
+    struct EffectState {
+        bool set = false;
+        QRegion region;
+        qreal contrast = 0;
+        qreal intensity = 0;
+        qreal saturation = 0;
+        QColor frost;
+
+        bool operator==(const EffectState &other) const
+        {
+            return set == other.set && region == other.region && contrast == other.contrast && intensity == other.intensity
+                && saturation == other.saturation && frost == other.frost;
+        }
+        bool operator!=(const EffectState &other) const
+        {
+            return !(*this == other);
+        }
+    };
+    static EffectState effectState(BlurInterface *blur);
+    static EffectState effectState(ContrastInterface *contrast);
+    QRegion effectDamage(const EffectState &previous, const EffectState &next) const;
+    EffectState blurState;
+    EffectState contrastState;
+    QRegion blurDamage;
+    QRegion contrastDamage;
+    // indexed by SurfaceInterface::StateCategory
+    quint64 generations[5] = {};
+    void bumpGeneration(SurfaceInterface::StateCategory category)
+    {
+        ++generations[int(category)];
+    }
+
+    void updateFrameCallbackLatency();
+    // when the oldest of the current frame callbacks got applied
+    std::chrono::steady_clock::time_point frameCallbacksAppliedTime;
+    std::chrono::nanoseconds frameCallbackLatency = std::chrono::nanoseconds::zero();
+    SurfaceInterface::FrameCallbackPolicy frameCallbackPolicy = SurfaceInterface::FrameCallbackPolicy::FullRate;
+    std::chrono::milliseconds reducedFrameCallbackInterval = std::chrono::seconds(1);
+    // the msec of the last delivery with the reduced rate
+    std::optional<quint32> lastReducedFrameCallback;
+
+    void publishSnapshot();
+    // only accessed with std::atomic_load and std::atomic_store, it is read by render threads
+    std::shared_ptr<const SurfaceInterface::Snapshot> snapshot;
+    quint64 snapshotSerial = 0;
+
+    void recordCommit();
+    // only allocated once the surface commits while the commit tracing is enabled
+    QSharedPointer<CommitTrace> commitTrace;
 
     QVector<OutputInterface *> outputs;
+    // a bit for each of the outputs, unless one of them has no bit
+    quint64 outputMask = 0;
+    bool outputMaskExact = true;
 
     LockedPointerV1Interface *lockedPointer = nullptr;
     ConfinedPointerV1Interface *confinedPointer = nullptr;
-    QHash<OutputInterface *, QMetaObject::Connection> outputDestroyedConnections;
-    QHash<OutputInterface *, QMetaObject::Connection> outputBoundConnections;
 
     QVector<IdleInhibitorV1Interface *> idleInhibitors;
+    IdleInhibitManagerV1InterfacePrivate *idleInhibitManager = nullptr;
+    // whether the surface is part of the inhibition count of the idleInhibitManager
+    bool countedAsInhibitingIdle = false;
     ViewportInterface *viewportExtension = nullptr;
+    FractionalScaleV1Interface *fractionalScaleExtension = nullptr;
+    qreal preferredScale = 1;
+    ContentTypeV1Interface *contentTypeExtension = nullptr;
+    TearingControlV1Interface *tearingControlExtension = nullptr;
+    FrogColorManagedSurfaceV1Interface *frogColorManagementExtension = nullptr;
+    ColorDescription preferredColorDescription{ColorDescription::TransferFunction::Srgb, ColorDescription::Primaries::Rec709, std::nullopt};
+    LinuxDrmSyncObjSurfaceV1Interface *syncObjSurface = nullptr;
+    // extensions which outlive neither their resource nor the surface, the handles get reset
+    // by the destroy listener of the resource without a connection to the QObject
+    WeakHandle<AppMenuInterface> appMenuExtension;
+    WeakHandle<ServerSideDecorationInterface> serverDecorationExtension;
+    WeakHandle<ServerSideDecorationPaletteInterface> serverDecorationPaletteExtension;
     QScopedPointer<LinuxDmaBufV1Feedback> dmabufFeedbackV1;
     ClientConnection *client = nullptr;
 
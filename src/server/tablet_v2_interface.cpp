@@ -8,10 +8,13 @@
 #include "display.h"
 #include "seat_interface.h"
 #include "surface_interface.h"
+#include "utils.h"
 
 #include "qwayland-server-tablet-unstable-v2.h"
 #include <QHash>
 
+#include <optional>
+
 namespace KWaylandServer
 {
 static int s_version = 1;
@@ -76,13 +79,14 @@ public:
     {
     }
 
-    void update(quint32 serial, SurfaceInterface *surface, const QPoint &hotspot)
+    void update(quint32 serial, SurfaceInterface *surface, const QPoint &hotspot, const QByteArray &shape = QByteArray())
     {
-        const bool diff = m_serial != serial || m_surface != surface || m_hotspot != hotspot;
+        const bool diff = m_serial != serial || m_surface != surface || m_hotspot != hotspot || m_shape != shape;
         if (diff) {
             m_serial = serial;
             m_surface = surface;
             m_hotspot = hotspot;
+            m_shape = shape;
 
             Q_EMIT q->changed();
         }
@@ -93,6 +97,7 @@ public:
     quint32 m_serial = 0;
     QPointer<SurfaceInterface> m_surface;
     QPoint m_hotspot;
+    QByteArray m_shape;
 };
 
 TabletCursorV2::TabletCursorV2()
@@ -118,6 +123,11 @@ SurfaceInterface *TabletCursorV2::surface() const
     return d->m_surface;
 }
 
+QByteArray TabletCursorV2::shape() const
+{
+    return d->m_shape;
+}
+
 class TabletToolV2InterfacePrivate : public QtWaylandServer::zwp_tablet_tool_v2
 {
 public:
@@ -145,10 +155,18 @@ public:
     {
         if (!m_surface)
             return nullptr;
+        return m_targetResource;
+    }
 
-        ClientConnection *client = m_surface->client();
-        const Resource *r = resourceMap().value(*client);
-        return r ? r->handle : nullptr;
+    // Resolves the resource of the client of the current surface, only done when the surface
+    // or the resources change, so sending the events of a sample needs no lookup
+    void updateTargetResource()
+    {
+        m_targetResource = nullptr;
+        if (m_surface) {
+            const Resource *r = resourceMap().value(*m_surface->client());
+            m_targetResource = r ? r->handle : nullptr;
+        }
     }
 
     quint64 hardwareId() const
@@ -165,6 +183,9 @@ public:
         TabletCursorV2 *&c = m_cursors[resource->handle];
         if (!c)
             c = new TabletCursorV2;
+        if (!m_targetResource) {
+            updateTargetResource();
+        }
     }
 
     void zwp_tablet_tool_v2_set_cursor(Resource *resource, uint32_t serial, struct ::wl_resource *_surface, int32_t hotspot_x, int32_t hotspot_y) override
@@ -178,6 +199,9 @@ public:
     void zwp_tablet_tool_v2_destroy_resource(Resource *resource) override
     {
         delete m_cursors.take(resource->handle);
+        if (resource->handle == m_targetResource) {
+            updateTargetResource();
+        }
         if (m_removed && resourceMap().isEmpty()) {
             delete q;
         }
@@ -188,16 +212,91 @@ public:
         wl_resource_destroy(resource->handle);
     }
 
+    // The axes of a frame, only the values that changed since the previous frame are sent
+    struct Axes {
+        std::optional<QPointF> position;
+        std::optional<quint32> pressure;
+        std::optional<quint32> distance;
+        std::optional<QPointF> tilt;
+        std::optional<qreal> rotation;
+        std::optional<qint32> slider;
+    };
+
+    template<typename T>
+    static bool takeChanged(std::optional<T> &pending, std::optional<T> &sent)
+    {
+        if (!pending) {
+            return false;
+        }
+        const bool changed = pending != sent;
+        sent = pending;
+        pending.reset();
+        return changed;
+    }
+
+    void flushAxes()
+    {
+        if (!m_axesPending) {
+            return;
+        }
+        m_axesPending = false;
+        wl_resource *target = targetResource();
+        if (!target) {
+            m_pendingAxes = Axes();
+            m_wheelDegrees = 0;
+            m_wheelClicks = 0;
+            return;
+        }
+        if (takeChanged(m_pendingAxes.position, m_sentAxes.position)) {
+            send_motion(target, wl_fixed_from_double(m_sentAxes.position->x()), wl_fixed_from_double(m_sentAxes.position->y()));
+            m_frameHasEvents = true;
+        }
+        if (takeChanged(m_pendingAxes.pressure, m_sentAxes.pressure)) {
+            send_pressure(target, *m_sentAxes.pressure);
+            m_frameHasEvents = true;
+        }
+        if (takeChanged(m_pendingAxes.distance, m_sentAxes.distance)) {
+            send_distance(target, *m_sentAxes.distance);
+            m_frameHasEvents = true;
+        }
+        if (takeChanged(m_pendingAxes.tilt, m_sentAxes.tilt)) {
+            send_tilt(target, wl_fixed_from_double(m_sentAxes.tilt->x()), wl_fixed_from_double(m_sentAxes.tilt->y()));
+            m_frameHasEvents = true;
+        }
+        if (takeChanged(m_pendingAxes.rotation, m_sentAxes.rotation)) {
+            send_rotation(target, wl_fixed_from_double(*m_sentAxes.rotation));
+            m_frameHasEvents = true;
+        }
+        if (takeChanged(m_pendingAxes.slider, m_sentAxes.slider)) {
+            send_slider(target, *m_sentAxes.slider);
+            m_frameHasEvents = true;
+        }
+        // the wheel is relative, the steps of the frame add up
+        if (m_wheelDegrees || m_wheelClicks) {
+            send_wheel(target, m_wheelDegrees, m_wheelClicks);
+            m_wheelDegrees = 0;
+            m_wheelClicks = 0;
+            m_frameHasEvents = true;
+        }
+    }
+
     Display *const m_display;
     bool m_cleanup = false;
     bool m_removed = false;
     QPointer<SurfaceInterface> m_surface;
+    wl_resource *m_targetResource = nullptr;
     QPointer<TabletV2Interface> m_lastTablet;
     const uint32_t m_type;
     const uint32_t m_hardwareSerialHigh, m_hardwareSerialLow;
     const uint32_t m_hardwareIdHigh, m_hardwareIdLow;
     const QVector<TabletToolV2Interface::Capability> m_capabilities;
     QHash<wl_resource *, TabletCursorV2 *> m_cursors;
+    Axes m_pendingAxes;
+    Axes m_sentAxes;
+    qint32 m_wheelDegrees = 0;
+    qint32 m_wheelClicks = 0;
+    bool m_axesPending = false;
+    bool m_frameHasEvents = false;
     TabletToolV2Interface *const q;
 };
 
@@ -234,6 +333,7 @@ void TabletToolV2Interface::setCurrentSurface(SurfaceInterface *surface)
     }
 
     d->m_surface = surface;
+    d->updateTargetResource();
 
     if (lastTablet && lastTablet->d->resourceForSurface(surface)) {
         sendProximityIn(lastTablet);
@@ -244,6 +344,27 @@ void TabletToolV2Interface::setCurrentSurface(SurfaceInterface *surface)
     Q_EMIT cursorChanged(d->m_cursors.value(d->targetResource()));
 }
 
+TabletToolV2Interface *TabletToolV2Interface::get(wl_resource *native)
+{
+    if (TabletToolV2InterfacePrivate *toolPrivate = resource_cast<TabletToolV2InterfacePrivate *>(native)) {
+        return toolPrivate->q;
+    }
+    return nullptr;
+}
+
+void TabletToolV2Interface::setCursorShape(wl_client *client, quint32 serial, const QByteArray &shape)
+{
+    const TabletToolV2InterfacePrivate::Resource *resource = d->resourceMap().value(client);
+    TabletCursorV2 *c = resource ? d->m_cursors.value(resource->handle) : nullptr;
+    if (!c) {
+        return;
+    }
+    c->d->update(serial, nullptr, QPoint(), shape);
+    if (resource->handle == d->targetResource()) {
+        Q_EMIT cursorChanged(c);
+    }
+}
+
 bool TabletToolV2Interface::isClientSupported() const
 {
     return d->m_surface && d->targetResource();
@@ -251,28 +372,39 @@ bool TabletToolV2Interface::isClientSupported() const
 
 void TabletToolV2Interface::sendButton(uint32_t button, bool pressed)
 {
+    // the button must not overtake the axes that preceded it
+    d->flushAxes();
     d->send_button(d->targetResource(),
                    d->m_display->nextSerial(),
                    button,
                    pressed ? QtWaylandServer::zwp_tablet_tool_v2::button_state_pressed : QtWaylandServer::zwp_tablet_tool_v2::button_state_released);
+    d->m_frameHasEvents = true;
 }
 
 void TabletToolV2Interface::sendMotion(const QPointF &pos)
 {
-    d->send_motion(d->targetResource(), wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
+    d->m_pendingAxes.position = pos;
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendDistance(uint32_t distance)
 {
-    d->send_distance(d->targetResource(), distance);
+    d->m_pendingAxes.distance = distance;
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendFrame(uint32_t time)
 {
-    d->send_frame(d->targetResource(), time);
+    d->flushAxes();
+    // a frame without events, e.g. when no axis changed, is of no use to the client
+    if (d->m_frameHasEvents) {
+        d->send_frame(d->targetResource(), time);
+        d->m_frameHasEvents = false;
+    }
 
     if (d->m_cleanup) {
         d->m_surface = nullptr;
+        d->m_targetResource = nullptr;
         d->m_lastTablet = nullptr;
         d->m_cleanup = false;
     }
@@ -280,27 +412,33 @@ void TabletToolV2Interface::sendFrame(uint32_t time)
 
 void TabletToolV2Interface::sendPressure(uint32_t pressure)
 {
-    d->send_pressure(d->targetResource(), pressure);
+    d->m_pendingAxes.pressure = pressure;
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendRotation(qreal rotation)
 {
-    d->send_rotation(d->targetResource(), wl_fixed_from_double(rotation));
+    d->m_pendingAxes.rotation = rotation;
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendSlider(int32_t position)
 {
-    d->send_slider(d->targetResource(), position);
+    d->m_pendingAxes.slider = position;
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendTilt(qreal degreesX, qreal degreesY)
 {
-    d->send_tilt(d->targetResource(), wl_fixed_from_double(degreesX), wl_fixed_from_double(degreesY));
+    d->m_pendingAxes.tilt = QPointF(degreesX, degreesY);
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendWheel(int32_t degrees, int32_t clicks)
 {
-    d->send_wheel(d->targetResource(), degrees, clicks);
+    d->m_wheelDegrees += degrees;
+    d->m_wheelClicks += clicks;
+    d->m_axesPending = true;
 }
 
 void TabletToolV2Interface::sendProximityIn(TabletV2Interface *tablet)
@@ -308,22 +446,32 @@ void TabletToolV2Interface::sendProximityIn(TabletV2Interface *tablet)
     wl_resource *tabletResource = tablet->d->resourceForSurface(d->m_surface);
     d->send_proximity_in(d->targetResource(), d->m_display->nextSerial(), tabletResource, d->m_surface->resource());
     d->m_lastTablet = tablet;
+    d->m_frameHasEvents = true;
+    // the entered surface knows nothing about the state of the tool yet, the axes of the frame
+    // follow the proximity in event
+    d->m_sentAxes = TabletToolV2InterfacePrivate::Axes();
 }
 
 void TabletToolV2Interface::sendProximityOut()
 {
+    d->flushAxes();
     d->send_proximity_out(d->targetResource());
     d->m_cleanup = true;
+    d->m_frameHasEvents = true;
 }
 
 void TabletToolV2Interface::sendDown()
 {
+    d->flushAxes();
     d->send_down(d->targetResource(), d->m_display->nextSerial());
+    d->m_frameHasEvents = true;
 }
 
 void TabletToolV2Interface::sendUp()
 {
+    d->flushAxes();
     d->send_up(d->targetResource());
+    d->m_frameHasEvents = true;
 }
 
 class TabletPadRingV2InterfacePrivate : public QtWaylandServer::zwp_tablet_pad_ring_v2
@@ -688,8 +836,35 @@ public:
         pad->d->send_done(tabletResource);
     }
 
+    using ToolSerial = QPair<quint64, quint32>;
+
+    void indexTool(TabletToolV2Interface *tool)
+    {
+        // the first tool added wins, as with a scan of the tools in the order they were added
+        if (!m_toolsByHardwareId.contains(tool->d->hardwareId())) {
+            m_toolsByHardwareId.insert(tool->d->hardwareId(), tool);
+        }
+        const ToolSerial serial{tool->d->hardwareSerial(), tool->d->m_type};
+        if (!m_toolsByHardwareSerial.contains(serial)) {
+            m_toolsByHardwareSerial.insert(serial, tool);
+        }
+    }
+
+    void removeTool(TabletToolV2Interface *tool)
+    {
+        m_tools.removeAll(tool);
+        // tools are rarely removed, a tool sharing the ids of the removed one takes its place
+        m_toolsByHardwareId.clear();
+        m_toolsByHardwareSerial.clear();
+        for (TabletToolV2Interface *t : qAsConst(m_tools)) {
+            indexTool(t);
+        }
+    }
+
     TabletSeatV2Interface *const q;
     QVector<TabletToolV2Interface *> m_tools;
+    QHash<quint64, TabletToolV2Interface *> m_toolsByHardwareId;
+    QHash<ToolSerial, TabletToolV2Interface *> m_toolsByHardwareSerial;
     QHash<QString, TabletV2Interface *> m_tablets;
     QHash<QString, TabletPadV2Interface *> m_pads;
     Display *const m_display;
@@ -722,9 +897,10 @@ TabletToolV2Interface *TabletSeatV2Interface::addTool(TabletToolV2Interface::Typ
     }
 
     d->m_tools.append(tool);
+    d->indexTool(tool);
     QObject::connect(tool, &QObject::destroyed, this, [this](QObject *object) {
         auto tti = static_cast<TabletToolV2Interface *>(object);
-        d->m_tools.removeAll(tti);
+        d->removeTool(tti);
     });
     return tool;
 }
@@ -775,21 +951,12 @@ void TabletSeatV2Interface::removeDevice(const QString &sysname)
 
 TabletToolV2Interface *TabletSeatV2Interface::toolByHardwareId(quint64 hardwareId) const
 {
-    for (TabletToolV2Interface *tool : qAsConst(d->m_tools)) {
-        if (tool->d->hardwareId() == hardwareId) {
-            return tool;
-        }
-    }
-    return nullptr;
+    return d->m_toolsByHardwareId.value(hardwareId);
 }
 
 TabletToolV2Interface *TabletSeatV2Interface::toolByHardwareSerial(quint64 hardwareSerial, TabletToolV2Interface::Type type) const
 {
-    for (TabletToolV2Interface *tool : qAsConst(d->m_tools)) {
-        if (tool->d->hardwareSerial() == hardwareSerial && tool->d->m_type == type)
-            return tool;
-    }
-    return nullptr;
+    return d->m_toolsByHardwareSerial.value({hardwareSerial, quint32(type)});
 }
 
 TabletPadV2Interface *TabletSeatV2Interface::padByName(const QString &name) const
@@ -10,6 +10,9 @@
 #include <QObject>
 #include <QVector>
 
+struct wl_client;
+struct wl_resource;
+
 namespace KWaylandServer
 {
 class ClientConnection;
@@ -53,6 +56,12 @@ private:
     QScopedPointer<TabletManagerV2InterfacePrivate> d;
 };
 
+/**
+ * The axis events, i.e. motion, pressure, distance, tilt, rotation, slider and wheel, are
+ * gathered until sendFrame. Only the last value of an axis is sent per frame, and only if it
+ * differs from the value of the previous frame; the wheel steps of a frame add up. The other
+ * events send the gathered axes first, and a frame without any event is not sent at all.
+ */
 class KWAYLANDSERVER_EXPORT TabletToolV2Interface : public QObject
 {
     Q_OBJECT
@@ -121,6 +130,10 @@ private:
                                    const QVector<Capability> &capability,
                                    QObject *parent);
     QScopedPointer<TabletToolV2InterfacePrivate> d;
+
+    static TabletToolV2Interface *get(wl_resource *native);
+    void setCursorShape(wl_client *client, quint32 serial, const QByteArray &shape);
+    friend class CursorShapeDeviceV1Interface;
 };
 
 class KWAYLANDSERVER_EXPORT TabletCursorV2 : public QObject
@@ -131,6 +144,12 @@ public:
     QPoint hotspot() const;
     quint32 enteredSerial() const;
     SurfaceInterface *surface() const;
+    /**
+     * The name of the cursor shape set with the cursor shape protocol, e.g. "default" or
+     * "text". The shape is empty if the cursor is a surface; the compositor renders
+     * shapes from its own cursor theme.
+     */
+    QByteArray shape() const;
 
 Q_SIGNALS:
     void changed();
@@ -138,6 +157,7 @@ Q_SIGNALS:
 private:
     TabletCursorV2();
     const QScopedPointer<TabletCursorV2Private> d;
+    friend class TabletToolV2Interface;
     friend class TabletToolV2InterfacePrivate;
 };
 
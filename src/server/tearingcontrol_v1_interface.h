@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+class Display;
+class TearingControlManagerV1InterfacePrivate;
+
+/**
+ * The TearingControlManagerV1Interface lets clients tell whether their surfaces may be presented
+ * with tearing, e.g. games that prefer asynchronous page flips for the lowest latency. The hint
+ * is double-buffered surface state and can be queried with SurfaceInterface::presentationHint().
+ *
+ * TearingControlManagerV1Interface corresponds to the Wayland interface
+ * @c wp_tearing_control_manager_v1.
+ */
+class KWAYLANDSERVER_EXPORT TearingControlManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TearingControlManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~TearingControlManagerV1Interface() override;
+
+private:
+    QScopedPointer<TearingControlManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
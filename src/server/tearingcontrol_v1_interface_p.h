@@ -0,0 +1,31 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include "qwayland-server-tearing-control-v1.h"
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+
+class TearingControlV1Interface : public QtWaylandServer::wp_tearing_control_v1
+{
+public:
+    TearingControlV1Interface(SurfaceInterface *surface, wl_resource *resource);
+    ~TearingControlV1Interface() override;
+
+    static TearingControlV1Interface *get(SurfaceInterface *surface);
+
+    QPointer<SurfaceInterface> surface;
+
+protected:
+    void wp_tearing_control_v1_destroy_resource(Resource *resource) override;
+    void wp_tearing_control_v1_destroy(Resource *resource) override;
+    void wp_tearing_control_v1_set_presentation_hint(Resource *resource, uint32_t hint) override;
+};
+
+} // namespace KWaylandServer
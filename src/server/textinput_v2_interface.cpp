@@ -4,6 +4,7 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "display.h"
+#include "lazyglobal.h"
 #include "seat_interface_p.h"
 #include "surface_interface_p.h"
 #include "textinput_v2_interface_p.h"
@@ -112,9 +113,8 @@ private:
 
 }
 
-TextInputManagerV2InterfacePrivate::TextInputManagerV2InterfacePrivate(TextInputManagerV2Interface *_q, Display *display)
-    : QtWaylandServer::zwp_text_input_manager_v2(*display, s_version)
-    , q(_q)
+TextInputManagerV2InterfacePrivate::TextInputManagerV2InterfacePrivate(TextInputManagerV2Interface *_q)
+    : q(_q)
 {
 }
 
@@ -142,8 +142,10 @@ void TextInputManagerV2InterfacePrivate::zwp_text_input_manager_v2_get_text_inpu
 
 TextInputManagerV2Interface::TextInputManagerV2Interface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new TextInputManagerV2InterfacePrivate(this, display))
 {
+    LazyGlobal::create(display, &zwp_text_input_manager_v2_interface, s_version, this, d, [this] {
+        return new TextInputManagerV2InterfacePrivate(this);
+    });
 }
 
 TextInputManagerV2Interface::~TextInputManagerV2Interface() = default;
@@ -173,6 +175,15 @@ void TextInputV2InterfacePrivate::sendLeave(quint32 serial, SurfaceInterface *le
 }
 
 void TextInputV2InterfacePrivate::preEdit(const QString &text, const QString &commit)
+{
+    if (!surface) {
+        return;
+    }
+    // encoded once for all text inputs of the client
+    preEdit(text.toUtf8(), commit.toUtf8());
+}
+
+void TextInputV2InterfacePrivate::preEdit(const QByteArray &text, const QByteArray &commit)
 {
     if (!surface) {
         return;
@@ -180,7 +191,7 @@ void TextInputV2InterfacePrivate::preEdit(const QString &text, const QString &co
 
     const auto clientResources = textInputsForClient(surface->client());
     for (auto resource : clientResources) {
-        send_preedit_string(resource->handle, text, commit);
+        zwp_text_input_v2_send_preedit_string(resource->handle, text.constData(), commit.constData());
     }
 }
 
@@ -197,13 +208,21 @@ void TextInputV2InterfacePrivate::preEditStyling(uint32_t index, uint32_t length
 }
 
 void TextInputV2InterfacePrivate::commitString(const QString &text)
+{
+    if (!surface) {
+        return;
+    }
+    commitString(text.toUtf8());
+}
+
+void TextInputV2InterfacePrivate::commitString(const QByteArray &text)
 {
     if (!surface) {
         return;
     }
     const QList<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
-        send_commit_string(resource->handle, text);
+        zwp_text_input_v2_send_commit_string(resource->handle, text.constData());
     }
 }
 
@@ -373,10 +392,15 @@ void TextInputV2InterfacePrivate::zwp_text_input_v2_hide_input_panel(Resource *r
     Q_EMIT q->requestHideInputPanel();
 }
 
-void TextInputV2InterfacePrivate::zwp_text_input_v2_set_surrounding_text(Resource *resource, const QString &text, int32_t cursor, int32_t anchor)
+void TextInputV2InterfacePrivate::zwp_text_input_v2_set_surrounding_text_utf8(Resource *resource, const char *text, int32_t cursor, int32_t anchor)
 {
     Q_UNUSED(resource)
-    surroundingText = text;
+    // clients send the whole surrounding text with every state update
+    if (surroundingTextCursorPosition == cursor && surroundingTextSelectionAnchor == anchor && encodedSurroundingText == text) {
+        return;
+    }
+    encodedSurroundingText = text;
+    surroundingText = QString::fromUtf8(encodedSurroundingText);
     surroundingTextCursorPosition = cursor;
     surroundingTextSelectionAnchor = anchor;
     Q_EMIT q->surroundingTextChanged();
@@ -20,7 +20,7 @@ namespace KWaylandServer
 class TextInputManagerV2InterfacePrivate : public QtWaylandServer::zwp_text_input_manager_v2
 {
 public:
-    TextInputManagerV2InterfacePrivate(TextInputManagerV2Interface *_q, Display *display);
+    TextInputManagerV2InterfacePrivate(TextInputManagerV2Interface *_q);
 
     TextInputManagerV2Interface *q;
 
@@ -37,8 +37,10 @@ public:
     void sendEnter(SurfaceInterface *surface, quint32 serial);
     void sendLeave(quint32 serial, SurfaceInterface *surface);
     void preEdit(const QString &text, const QString &commit);
+    void preEdit(const QByteArray &text, const QByteArray &commit);
     void preEditStyling(uint32_t index, uint32_t length, uint32_t style);
     void commitString(const QString &text);
+    void commitString(const QByteArray &text);
     void deleteSurroundingText(quint32 beforeLength, quint32 afterLength);
     void setTextDirection(Qt::LayoutDirection direction);
     void setPreEditCursor(qint32 index);
@@ -62,6 +64,8 @@ public:
     SeatInterface *seat = nullptr;
     QPointer<SurfaceInterface> surface;
     QString surroundingText;
+    // as sent by the client, to detect an unchanged surrounding text before converting it
+    QByteArray encodedSurroundingText;
     qint32 surroundingTextCursorPosition = 0;
     qint32 surroundingTextSelectionAnchor = 0;
     bool inputPanelVisible = false;
@@ -76,7 +80,7 @@ protected:
     void zwp_text_input_v2_disable(Resource *resource, wl_resource *surface) override;
     void zwp_text_input_v2_show_input_panel(Resource *resource) override;
     void zwp_text_input_v2_hide_input_panel(Resource *resource) override;
-    void zwp_text_input_v2_set_surrounding_text(Resource *resource, const QString &text, int32_t cursor, int32_t anchor) override;
+    void zwp_text_input_v2_set_surrounding_text_utf8(Resource *resource, const char *text, int32_t cursor, int32_t anchor) override;
     void zwp_text_input_v2_set_content_type(Resource *resource, uint32_t hint, uint32_t purpose) override;
     void zwp_text_input_v2_set_cursor_rectangle(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height) override;
     void zwp_text_input_v2_set_preferred_language(Resource *resource, const QString &language) override;
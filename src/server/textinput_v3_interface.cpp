@@ -6,6 +6,7 @@
 */
 
 #include "display.h"
+#include "lazyglobal.h"
 #include "seat_interface.h"
 #include "surface_interface_p.h"
 #include "textinput_v3_interface_p.h"
@@ -126,9 +127,8 @@ private:
 
 }
 
-TextInputManagerV3InterfacePrivate::TextInputManagerV3InterfacePrivate(TextInputManagerV3Interface *_q, Display *display)
-    : QtWaylandServer::zwp_text_input_manager_v3(*display, s_version)
-    , q(_q)
+TextInputManagerV3InterfacePrivate::TextInputManagerV3InterfacePrivate(TextInputManagerV3Interface *_q)
+    : q(_q)
 {
 }
 
@@ -154,8 +154,10 @@ void TextInputManagerV3InterfacePrivate::zwp_text_input_manager_v3_get_text_inpu
 
 TextInputManagerV3Interface::TextInputManagerV3Interface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new TextInputManagerV3InterfacePrivate(this, display))
 {
+    LazyGlobal::create(display, &zwp_text_input_manager_v3_interface, s_version, this, d, [this] {
+        return new TextInputManagerV3InterfacePrivate(this);
+    });
 }
 
 TextInputManagerV3Interface::~TextInputManagerV3Interface() = default;
@@ -185,6 +187,8 @@ void TextInputV3InterfacePrivate::sendEnter(SurfaceInterface *newSurface)
     EnabledEmitter emitter(q);
     // It should be always synchronized with SeatInterface::focusedTextInputSurface.
     Q_ASSERT(!surface && newSurface);
+    // events requested for the previous surface must not leak into the new one
+    clearOutgoing();
     surface = newSurface;
     const auto clientResources = textInputsForClient(newSurface->client());
     for (auto resource : clientResources) {
@@ -197,6 +201,7 @@ void TextInputV3InterfacePrivate::sendLeave(SurfaceInterface *leavingSurface)
     EnabledEmitter emitter(q);
     // It should be always synchronized with SeatInterface::focusedTextInputSurface.
     Q_ASSERT(leavingSurface && surface == leavingSurface);
+    clearOutgoing();
     surface.clear();
     const auto clientResources = textInputsForClient(leavingSurface->client());
     for (auto resource : clientResources) {
@@ -205,25 +210,35 @@ void TextInputV3InterfacePrivate::sendLeave(SurfaceInterface *leavingSurface)
 }
 
 void TextInputV3InterfacePrivate::sendPreEdit(const QString &text, const quint32 cursorBegin, const quint32 cursorEnd)
+{
+    sendPreEdit(text.toUtf8(), cursorBegin, cursorEnd);
+}
+
+void TextInputV3InterfacePrivate::sendPreEdit(const QByteArray &text, const quint32 cursorBegin, const quint32 cursorEnd)
 {
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = enabledTextInputsForClient(surface->client());
-    for (auto resource : textInputs) {
-        send_preedit_string(resource->handle, text, cursorBegin, cursorEnd);
-    }
+    // only the last pre-edit string before done matters to the client
+    outgoing.preEditSet = true;
+    outgoing.preEdit = text;
+    outgoing.preEditCursorBegin = cursorBegin;
+    outgoing.preEditCursorEnd = cursorEnd;
 }
 
 void TextInputV3InterfacePrivate::commitString(const QString &text)
+{
+    commitString(text.toUtf8());
+}
+
+void TextInputV3InterfacePrivate::commitString(const QByteArray &text)
 {
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = enabledTextInputsForClient(surface->client());
-    for (auto resource : textInputs) {
-        send_commit_string(resource->handle, text);
-    }
+    // the client inserts all the text committed before done
+    outgoing.commitSet = true;
+    outgoing.commit += text;
 }
 
 void TextInputV3InterfacePrivate::deleteSurroundingText(quint32 before, quint32 after)
@@ -231,10 +246,9 @@ void TextInputV3InterfacePrivate::deleteSurroundingText(quint32 before, quint32
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = enabledTextInputsForClient(surface->client());
-    for (auto resource : textInputs) {
-        send_delete_surrounding_text(resource->handle, before, after);
-    }
+    outgoing.deleteSurroundingSet = true;
+    outgoing.deleteSurroundingBefore = before;
+    outgoing.deleteSurroundingAfter = after;
 }
 
 void TextInputV3InterfacePrivate::done()
@@ -242,14 +256,52 @@ void TextInputV3InterfacePrivate::done()
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = enabledTextInputsForClient(surface->client());
+    // the client applies every batch on its own, e.g. a batch without a pre-edit string
+    // clears the one of the batch before, so batches are never merged
+    outgoing.serials = serialHash;
+    doneBatches.append(std::move(outgoing));
+    outgoing = Batch();
+    if (!doneCoalescing) {
+        flushDone();
+    }
+}
 
-    for (auto resource : textInputs) {
-        // zwp_text_input_v3.done takes the serial argument which is equal to number of commit requests issued
-        send_done(resource->handle, serialHash[resource]);
+void TextInputV3InterfacePrivate::flushDone()
+{
+    if (doneBatches.isEmpty()) {
+        return;
+    }
+    const QVector<Batch> batches = std::move(doneBatches);
+    doneBatches.clear();
+    if (!surface) {
+        return;
+    }
+
+    const QList<Resource *> textInputs = enabledTextInputsForClient(surface->client());
+    for (const Batch &batch : batches) {
+        for (auto resource : textInputs) {
+            // the strings have been encoded once, not for every text input of the client
+            if (batch.preEditSet) {
+                zwp_text_input_v3_send_preedit_string(resource->handle, batch.preEdit.constData(), batch.preEditCursorBegin, batch.preEditCursorEnd);
+            }
+            if (batch.commitSet) {
+                zwp_text_input_v3_send_commit_string(resource->handle, batch.commit.constData());
+            }
+            if (batch.deleteSurroundingSet) {
+                zwp_text_input_v3_send_delete_surrounding_text(resource->handle, batch.deleteSurroundingBefore, batch.deleteSurroundingAfter);
+            }
+            // zwp_text_input_v3.done takes the serial argument which is equal to number of commit requests issued
+            send_done(resource->handle, batch.serials.value(resource, serialHash.value(resource)));
+        }
     }
 }
 
+void TextInputV3InterfacePrivate::clearOutgoing()
+{
+    outgoing = Batch();
+    doneBatches.clear();
+}
+
 QList<TextInputV3InterfacePrivate::Resource *> TextInputV3InterfacePrivate::textInputsForClient(ClientConnection *client) const
 {
     return resourceMap().values(client->client());
@@ -293,14 +345,14 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_disable(Resource *resource)
     defaultPending();
 }
 
-void TextInputV3InterfacePrivate::zwp_text_input_v3_set_surrounding_text(Resource *resource, const QString &text, int32_t cursor, int32_t anchor)
+void TextInputV3InterfacePrivate::zwp_text_input_v3_set_surrounding_text_utf8(Resource *resource, const char *text, int32_t cursor, int32_t anchor)
 {
     Q_UNUSED(resource)
     // zwp_text_input_v3_set_surrounding_text is no-op if enabled request is not pending
     if (!pending.enabled) {
         return;
     }
-    pending.surroundingText = text;
+    pending.encodedSurroundingText = text;
     pending.surroundingTextCursorPosition = cursor;
     pending.surroundingTextSelectionAnchor = anchor;
 }
@@ -366,9 +418,11 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_commit(Resource *resource)
         }
     }
 
-    if (surroundingText != pending.surroundingText || surroundingTextCursorPosition != pending.surroundingTextCursorPosition
+    if (encodedSurroundingText != pending.encodedSurroundingText || surroundingTextCursorPosition != pending.surroundingTextCursorPosition
         || surroundingTextSelectionAnchor != pending.surroundingTextSelectionAnchor) {
-        surroundingText = pending.surroundingText;
+        // only converted if it changed, the text is resent with every commit
+        encodedSurroundingText = pending.encodedSurroundingText;
+        surroundingText = QString::fromUtf8(encodedSurroundingText);
         surroundingTextCursorPosition = pending.surroundingTextCursorPosition;
         surroundingTextSelectionAnchor = pending.surroundingTextSelectionAnchor;
         if (resourceEnabled) {
@@ -386,7 +440,7 @@ void TextInputV3InterfacePrivate::defaultPending()
     pending.contentHints = TextInputContentHints(TextInputContentHint::None);
     pending.contentPurpose = TextInputContentPurpose::Normal;
     pending.enabled = false;
-    pending.surroundingText = QString();
+    pending.encodedSurroundingText.clear();
     pending.surroundingTextCursorPosition = 0;
     pending.surroundingTextSelectionAnchor = 0;
 }
@@ -444,6 +498,27 @@ void TextInputV3Interface::done()
     d->done();
 }
 
+void TextInputV3Interface::setDoneCoalescing(bool coalesce)
+{
+    if (d->doneCoalescing == coalesce) {
+        return;
+    }
+    if (!coalesce) {
+        d->flushDone();
+    }
+    d->doneCoalescing = coalesce;
+}
+
+bool TextInputV3Interface::doneCoalescing() const
+{
+    return d->doneCoalescing;
+}
+
+void TextInputV3Interface::flushDone()
+{
+    d->flushDone();
+}
+
 QPointer<SurfaceInterface> TextInputV3Interface::surface() const
 {
     if (!d->surface) {
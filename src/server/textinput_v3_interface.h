@@ -149,6 +149,32 @@ public:
      */
     void done();
 
+    /**
+     * Enables or disables the coalescing of done events.
+     *
+     * While enabled, done() only queues the events requested since the previous done() and
+     * flushDone() sends all queued batches at once, each one with its own done event and in the
+     * order they were requested. Within a batch the last pre-edit string wins and committed text
+     * is appended, so an input method updating the text input many times per frame doesn't wake
+     * up the client for each update. Disabling the coalescing flushes the queued batches.
+     *
+     * Disabled by default.
+     * @see flushDone
+     */
+    void setDoneCoalescing(bool coalesce);
+    /**
+     * @returns whether done events are coalesced
+     * @see setDoneCoalescing
+     */
+    bool doneCoalescing() const;
+    /**
+     * Sends out the batches of events queued by done() since the last flush.
+     *
+     * This is done implicitly by Display::flush.
+     * @see setDoneCoalescing
+     */
+    void flushDone();
+
 Q_SIGNALS:
 
     /**
@@ -20,7 +20,7 @@ namespace KWaylandServer
 class TextInputManagerV3InterfacePrivate : public QtWaylandServer::zwp_text_input_manager_v3
 {
 public:
-    TextInputManagerV3InterfacePrivate(TextInputManagerV3Interface *_q, Display *display);
+    TextInputManagerV3InterfacePrivate(TextInputManagerV3Interface *_q);
 
     TextInputManagerV3Interface *q;
 
@@ -38,9 +38,13 @@ public:
     void sendEnter(SurfaceInterface *surface);
     void sendLeave(SurfaceInterface *surface);
     void sendPreEdit(const QString &text, const quint32 cursorBegin, const quint32 cursorEnd);
+    void sendPreEdit(const QByteArray &text, const quint32 cursorBegin, const quint32 cursorEnd);
     void commitString(const QString &text);
+    void commitString(const QByteArray &text);
     void deleteSurroundingText(quint32 beforeLength, quint32 afterLength);
     void done();
+    void flushDone();
+    void clearOutgoing();
 
     bool isEnabled() const;
     QList<TextInputV3InterfacePrivate::Resource *> textInputsForClient(ClientConnection *client) const;
@@ -59,6 +63,8 @@ public:
     QPointer<SurfaceInterface> surface;
 
     QString surroundingText;
+    // as sent by the client, to detect an unchanged surrounding text before converting it
+    QByteArray encodedSurroundingText;
     qint32 surroundingTextCursorPosition = 0;
     qint32 surroundingTextSelectionAnchor = 0;
     TextInputChangeCause surroundingTextChangeCause = TextInputChangeCause::InputMethod;
@@ -69,11 +75,30 @@ public:
         TextInputContentHints contentHints = TextInputContentHint::None;
         TextInputContentPurpose contentPurpose = TextInputContentPurpose::Normal;
         bool enabled = false;
-        QString surroundingText;
+        QByteArray encodedSurroundingText;
         qint32 surroundingTextCursorPosition = 0;
         qint32 surroundingTextSelectionAnchor = 0;
     } pending;
 
+    // the events of the input method up to a done event
+    struct Batch {
+        bool preEditSet = false;
+        QByteArray preEdit;
+        quint32 preEditCursorBegin = 0;
+        quint32 preEditCursorEnd = 0;
+        bool commitSet = false;
+        QByteArray commit;
+        bool deleteSurroundingSet = false;
+        quint32 deleteSurroundingBefore = 0;
+        quint32 deleteSurroundingAfter = 0;
+        // the commit serials of the text inputs when done was requested
+        QHash<Resource *, quint32> serials;
+    };
+    Batch outgoing;
+    // the batches waiting for flushDone, each one goes out with its own done event
+    QVector<Batch> doneBatches;
+    bool doneCoalescing = false;
+
     QHash<Resource *, quint32> serialHash;
     QHash<Resource *, bool> enabled;
 
@@ -87,7 +112,7 @@ protected:
     // requests
     void zwp_text_input_v3_enable(Resource *resource) override;
     void zwp_text_input_v3_disable(Resource *resource) override;
-    void zwp_text_input_v3_set_surrounding_text(Resource *resource, const QString &text, int32_t cursor, int32_t anchor) override;
+    void zwp_text_input_v3_set_surrounding_text_utf8(Resource *resource, const char *text, int32_t cursor, int32_t anchor) override;
     void zwp_text_input_v3_set_content_type(Resource *resource, uint32_t hint, uint32_t purpose) override;
     void zwp_text_input_v3_set_text_change_cause(Resource *resource, uint32_t cause) override;
     void zwp_text_input_v3_set_cursor_rectangle(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height) override;
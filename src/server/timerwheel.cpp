@@ -0,0 +1,200 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "timerwheel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace KWaylandServer
+{
+
+TimerWheel::Timer::~Timer()
+{
+    stop();
+}
+
+void TimerWheel::Timer::setCallback(std::function<void()> callback)
+{
+    m_callback = std::move(callback);
+}
+
+void TimerWheel::Timer::start(TimerWheel *wheel, std::chrono::milliseconds interval)
+{
+    stop();
+    m_wheel = wheel;
+    if (wheel->m_count == 0) {
+        // nothing is pending, skip the ticks that passed since the wheel was last used
+        wheel->m_processedTick = wheel->currentTick();
+    }
+
+    const qint64 ticks = (std::max<qint64>(interval.count(), 0) + TimerWheel::tick.count() - 1) / TimerWheel::tick.count();
+    m_expiry = wheel->currentTick() + std::max<qint64>(ticks, 1);
+    wheel->insert(this);
+    ++wheel->m_count;
+
+    if (!wheel->m_timer.isActive() || m_expiry < wheel->m_wakeUpTick) {
+        wheel->scheduleWakeUp();
+    }
+}
+
+void TimerWheel::Timer::stop()
+{
+    if (m_wheel && m_slot) {
+        m_wheel->unlink(this);
+        --m_wheel->m_count;
+    }
+}
+
+bool TimerWheel::Timer::isActive() const
+{
+    return m_slot;
+}
+
+TimerWheel::TimerWheel()
+    : m_epoch(std::chrono::steady_clock::now())
+{
+    m_timer.setSingleShot(true);
+    QObject::connect(&m_timer, &QTimer::timeout, [this]() {
+        advance();
+        scheduleWakeUp();
+    });
+}
+
+TimerWheel::~TimerWheel()
+{
+    for (auto &level : m_slots) {
+        for (Timer *&head : level) {
+            while (Timer *timer = head) {
+                unlink(timer);
+                timer->m_wheel = nullptr;
+            }
+        }
+    }
+}
+
+qint64 TimerWheel::currentTick() const
+{
+    return (std::chrono::steady_clock::now() - m_epoch) / tick;
+}
+
+void TimerWheel::insert(Timer *timer)
+{
+    const qint64 delta = timer->m_expiry - m_processedTick;
+    int level = 0;
+    while (level < s_levelCount - 1 && delta >= (qint64(1) << (s_levelBits * (level + 1)))) {
+        ++level;
+    }
+
+    // timers beyond the last level wait in its farthest slot and get cascaded again
+    qint64 slotTick = timer->m_expiry;
+    const qint64 range = qint64(1) << (s_levelBits * s_levelCount);
+    if (delta >= range) {
+        slotTick = m_processedTick + range - 1;
+    }
+
+    Timer *&head = m_slots[level][(slotTick >> (s_levelBits * level)) & s_slotMask];
+    timer->m_previous = nullptr;
+    timer->m_next = head;
+    if (head) {
+        head->m_previous = timer;
+    }
+    head = timer;
+    timer->m_slot = &head;
+}
+
+void TimerWheel::unlink(Timer *timer)
+{
+    if (timer->m_previous) {
+        timer->m_previous->m_next = timer->m_next;
+    } else {
+        *timer->m_slot = timer->m_next;
+    }
+    if (timer->m_next) {
+        timer->m_next->m_previous = timer->m_previous;
+    }
+    timer->m_previous = nullptr;
+    timer->m_next = nullptr;
+    timer->m_slot = nullptr;
+}
+
+void TimerWheel::cascade(int level)
+{
+    Timer *&head = m_slots[level][(m_processedTick >> (s_levelBits * level)) & s_slotMask];
+    while (Timer *timer = head) {
+        unlink(timer);
+        insert(timer);
+    }
+}
+
+void TimerWheel::advance()
+{
+    const qint64 target = currentTick();
+    if (m_count == 0) {
+        m_processedTick = std::max(m_processedTick, target);
+        return;
+    }
+
+    while (m_processedTick < target) {
+        ++m_processedTick;
+        for (int level = 1; level < s_levelCount; ++level) {
+            if (m_processedTick & ((qint64(1) << (s_levelBits * level)) - 1)) {
+                break;
+            }
+            cascade(level);
+        }
+
+        Timer *&head = m_slots[0][m_processedTick & s_slotMask];
+        while (Timer *timer = head) {
+            unlink(timer);
+            --m_count;
+            // the callback is allowed to destroy the timer
+            const std::function<void()> callback = timer->m_callback;
+            if (callback) {
+                callback();
+            }
+        }
+    }
+}
+
+void TimerWheel::scheduleWakeUp()
+{
+    if (m_count == 0) {
+        m_timer.stop();
+        return;
+    }
+
+    // The next slot of the lowest level with a timer. The higher levels only need to be looked
+    // at when their timers get cascaded, a slot is cascaded on the first tick after the
+    // processed one that is a multiple of the range of its level and maps to it.
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (qint64 slotTick = m_processedTick + 1; slotTick <= m_processedTick + s_slotCount; ++slotTick) {
+        if (m_slots[0][slotTick & s_slotMask]) {
+            next = slotTick;
+            break;
+        }
+    }
+    for (int level = 1; level < s_levelCount; ++level) {
+        const int shift = s_levelBits * level;
+        const qint64 first = (m_processedTick >> shift) + 1;
+        for (int slot = 0; slot < s_slotCount; ++slot) {
+            if (m_slots[level][slot]) {
+                const qint64 cascadeTick = (first + ((slot - first) & s_slotMask)) << shift;
+                next = std::min(next, cascadeTick);
+            }
+        }
+    }
+    m_wakeUpTick = next;
+
+    const auto remaining = m_epoch + next * tick - std::chrono::steady_clock::now();
+    const auto msecs = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+    m_timer.start(int(std::max<qint64>(msecs, 0)));
+}
+
+int TimerWheel::remainingTime() const
+{
+    return m_timer.remainingTime();
+}
+
+} // namespace KWaylandServer
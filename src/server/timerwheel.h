@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QTimer>
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+namespace KWaylandServer
+{
+/**
+ * A hierarchical timer wheel for the many coarse deadlines of the server, e.g. xdg_wm_base
+ * pings and idle timeouts.
+ *
+ * Starting and stopping a timer is O(1) and does not create any QObject. All timers of a
+ * wheel share a single QTimer, which is only armed for the next slot that holds a timer, or
+ * for the next cascade of a higher level slot that holds one. A timer wakes the compositor up
+ * once per level at most, e.g. an idle timeout of minutes only a few times, otherwise the
+ * wheel leaves an idle compositor alone. Deadlines are rounded up to the tick of the wheel.
+ *
+ * The wheel of a Display is available through DisplayPrivate::timerWheel.
+ */
+class TimerWheel
+{
+public:
+    class Timer
+    {
+    public:
+        Timer() = default;
+        ~Timer();
+
+        /**
+         * Sets the function to invoke when the timer expires. The callback may restart, stop
+         * or change the callback of the timer, and it may destroy it.
+         */
+        void setCallback(std::function<void()> callback);
+
+        /**
+         * Starts or restarts the timer on @p wheel so it expires after @p interval.
+         */
+        void start(TimerWheel *wheel, std::chrono::milliseconds interval);
+        void stop();
+        bool isActive() const;
+
+    private:
+        friend class TimerWheel;
+
+        std::function<void()> m_callback;
+        TimerWheel *m_wheel = nullptr;
+        Timer *m_previous = nullptr;
+        Timer *m_next = nullptr;
+        Timer **m_slot = nullptr;
+        qint64 m_expiry = 0;
+
+        Q_DISABLE_COPY(Timer)
+    };
+
+    TimerWheel();
+    ~TimerWheel();
+
+    static constexpr std::chrono::milliseconds tick{10};
+
+    /**
+     * Returns the milliseconds until the wheel wakes up next, or @c -1 if no timer is pending.
+     */
+    int remainingTime() const;
+
+private:
+    static constexpr int s_levelBits = 6;
+    static constexpr int s_slotCount = 1 << s_levelBits;
+    static constexpr int s_slotMask = s_slotCount - 1;
+    static constexpr int s_levelCount = 4;
+
+    qint64 currentTick() const;
+    void insert(Timer *timer);
+    void unlink(Timer *timer);
+    void cascade(int level);
+    void advance();
+    void scheduleWakeUp();
+
+    // slot heads, the lists are doubly linked through the timers themselves
+    std::array<std::array<Timer *, s_slotCount>, s_levelCount> m_slots = {};
+    std::chrono::steady_clock::time_point m_epoch;
+    qint64 m_processedTick = 0;
+    qint64 m_wakeUpTick = 0;
+    int m_count = 0;
+    QTimer m_timer;
+
+    Q_DISABLE_COPY(TimerWheel)
+};
+
+} // namespace KWaylandServer
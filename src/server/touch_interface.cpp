@@ -30,9 +30,23 @@ void TouchInterfacePrivate::touch_release(Resource *resource)
     wl_resource_destroy(resource->handle);
 }
 
+void TouchInterfacePrivate::touch_bind_resource(Resource *resource)
+{
+    clientResources.add(resource);
+    if (focusedSurface && focusedSurface->client()->client() == resource->client()) {
+        focusedTouches.append(resource);
+    }
+}
+
+void TouchInterfacePrivate::touch_destroy_resource(Resource *resource)
+{
+    clientResources.remove(resource);
+    focusedTouches.removeOne(resource);
+}
+
 QList<TouchInterfacePrivate::Resource *> TouchInterfacePrivate::touchesForClient(ClientConnection *client) const
 {
-    return resourceMap().values(client->client());
+    return clientResources.resources(client->client());
 }
 
 TouchInterface::TouchInterface(SeatInterface *seat)
@@ -52,6 +66,7 @@ SurfaceInterface *TouchInterface::focusedSurface() const
 void TouchInterface::setFocusedSurface(SurfaceInterface *surface)
 {
     d->focusedSurface = surface;
+    d->focusedTouches = surface ? d->touchesForClient(surface->client()) : QList<TouchInterfacePrivate::Resource *>();
 }
 
 void TouchInterface::sendCancel()
@@ -60,8 +75,7 @@ void TouchInterface::sendCancel()
         return;
     }
 
-    const auto touchResources = d->touchesForClient(d->focusedSurface->client());
-    for (TouchInterfacePrivate::Resource *resource : touchResources) {
+    for (TouchInterfacePrivate::Resource *resource : qAsConst(d->focusedTouches)) {
         d->send_cancel(resource->handle);
     }
 }
@@ -72,8 +86,7 @@ void TouchInterface::sendFrame()
         return;
     }
 
-    const auto touchResources = d->touchesForClient(d->focusedSurface->client());
-    for (TouchInterfacePrivate::Resource *resource : touchResources) {
+    for (TouchInterfacePrivate::Resource *resource : qAsConst(d->focusedTouches)) {
         d->send_frame(resource->handle);
     }
 }
@@ -84,8 +97,7 @@ void TouchInterface::sendMotion(qint32 id, const QPointF &localPos)
         return;
     }
 
-    const auto touchResources = d->touchesForClient(d->focusedSurface->client());
-    for (TouchInterfacePrivate::Resource *resource : touchResources) {
+    for (TouchInterfacePrivate::Resource *resource : qAsConst(d->focusedTouches)) {
         d->send_motion(resource->handle, d->seat->timestamp(), id, wl_fixed_from_double(localPos.x()), wl_fixed_from_double(localPos.y()));
     }
 }
@@ -96,8 +108,7 @@ void TouchInterface::sendUp(qint32 id, quint32 serial)
         return;
     }
 
-    const auto touchResources = d->touchesForClient(d->focusedSurface->client());
-    for (TouchInterfacePrivate::Resource *resource : touchResources) {
+    for (TouchInterfacePrivate::Resource *resource : qAsConst(d->focusedTouches)) {
         d->send_up(resource->handle, serial, d->seat->timestamp(), id);
     }
 }
@@ -108,8 +119,7 @@ void TouchInterface::sendDown(qint32 id, quint32 serial, const QPointF &localPos
         return;
     }
 
-    const auto touchResources = d->touchesForClient(d->focusedSurface->client());
-    for (TouchInterfacePrivate::Resource *resource : touchResources) {
+    for (TouchInterfacePrivate::Resource *resource : qAsConst(d->focusedTouches)) {
         d->send_down(resource->handle,
                      serial,
                      d->seat->timestamp(),
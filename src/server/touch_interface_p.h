@@ -7,6 +7,7 @@
 #pragma once
 
 #include "touch_interface.h"
+#include "utils_p.h"
 
 #include "qwayland-server-wayland.h"
 
@@ -25,9 +26,14 @@ public:
     TouchInterface *q;
     QPointer<SurfaceInterface> focusedSurface;
     SeatInterface *seat;
+    ClientResources<Resource> clientResources;
+    // the resources of the client of the focused surface, so pointer emulation needs no lookup
+    QList<Resource *> focusedTouches;
 
 protected:
     void touch_release(Resource *resource) override;
+    void touch_bind_resource(Resource *resource) override;
+    void touch_destroy_resource(Resource *resource) override;
 };
 
 } // namespace KWaylandServer
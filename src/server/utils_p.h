@@ -0,0 +1,305 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <utility>
+
+struct wl_client;
+
+namespace KWaylandServer
+{
+/**
+ * Keeps the resources of a server-managed multicasting object grouped by client, so the
+ * resources of a single client can be looked up without filtering the resource map.
+ *
+ * Resources have to be added in the _bind_resource() hook and removed in the
+ * _destroy_resource() hook of the generated class. Any other type with a client() returning
+ * the wl_client, e.g. the per-client interfaces of a seat, can be grouped as well.
+ */
+template<typename Resource>
+class ClientResources
+{
+public:
+    void add(Resource *resource)
+    {
+        m_resources[resource->client()].append(resource);
+    }
+
+    void remove(Resource *resource)
+    {
+        remove(resource->client(), resource);
+    }
+
+    /**
+     * Removes the @p resource of the @p client, for objects which can't tell their client
+     * anymore, e.g. when they are being destroyed.
+     */
+    void remove(wl_client *client, Resource *resource)
+    {
+        auto it = m_resources.find(client);
+        if (it == m_resources.end()) {
+            return;
+        }
+        it->removeOne(resource);
+        if (it->isEmpty()) {
+            m_resources.erase(it);
+        }
+    }
+
+    /**
+     * Returns the resources bound by the @p client. The list is implicitly shared with the
+     * cache, so no allocation happens unless the caller modifies it.
+     */
+    QList<Resource *> resources(wl_client *client) const
+    {
+        return m_resources.value(client);
+    }
+
+private:
+    QHash<wl_client *, QList<Resource *>> m_resources;
+};
+
+/**
+ * Interns the strings which many objects of the server hold with the same content, e.g. the
+ * palette or the application menu service of all windows of an application, so they share
+ * a single copy instead of one per request.
+ *
+ * Strings which only the pool still references are dropped whenever the pool doubled in size.
+ *
+ * The pool is shared by all Displays of the process, which may run on different threads, so
+ * it is guarded by a mutex.
+ */
+class StringPool
+{
+public:
+    static QString intern(const QString &string)
+    {
+        if (string.isEmpty()) {
+            return string;
+        }
+        StringPool &pool = instance();
+        QMutexLocker locker(&pool.m_mutex);
+        const auto it = pool.m_strings.constFind(string);
+        if (it != pool.m_strings.constEnd()) {
+            return *it;
+        }
+        if (pool.m_strings.size() >= pool.m_purgeThreshold) {
+            pool.purge();
+        }
+        pool.m_strings.insert(string);
+        return string;
+    }
+
+private:
+    static StringPool &instance()
+    {
+        static StringPool pool;
+        return pool;
+    }
+
+    void purge()
+    {
+        for (auto it = m_strings.begin(); it != m_strings.end();) {
+            if (it->isDetached()) {
+                it = m_strings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_purgeThreshold = std::max(s_minimumPurgeThreshold, m_strings.size() * 2);
+    }
+
+    static constexpr int s_minimumPurgeThreshold = 64;
+    QMutex m_mutex;
+    QSet<QString> m_strings;
+    int m_purgeThreshold = s_minimumPurgeThreshold;
+};
+
+/**
+ * A map for the handful of entries of an input state, e.g. the pressed buttons or the touch
+ * points, kept sorted in a single inline array. Lookups are a binary search over contiguous
+ * memory and nothing is allocated as long as there are at most @p Prealloc entries.
+ *
+ * The entries are visited in ascending order of their keys, like with a QMap.
+ */
+template<typename Key, typename Value, int Prealloc = 8>
+class SmallFlatMap
+{
+public:
+    using Entry = std::pair<Key, Value>;
+    using const_iterator = const Entry *;
+
+    const_iterator begin() const
+    {
+        return m_entries.constData();
+    }
+    const_iterator end() const
+    {
+        return m_entries.constData() + m_entries.size();
+    }
+    int count() const
+    {
+        return m_entries.size();
+    }
+    bool isEmpty() const
+    {
+        return m_entries.isEmpty();
+    }
+    bool contains(const Key &key) const
+    {
+        return find(key);
+    }
+
+    /**
+     * Returns the value of @p key, or @c nullptr if there is none. The pointer is valid until
+     * the next insert() or remove().
+     */
+    Value *find(const Key &key)
+    {
+        Entry *entry = lowerBound(m_entries.data(), m_entries.data() + m_entries.size(), key);
+        return entry != m_entries.data() + m_entries.size() && entry->first == key ? &entry->second : nullptr;
+    }
+    const Value *find(const Key &key) const
+    {
+        const Entry *entry = lowerBound(begin(), end(), key);
+        return entry != end() && entry->first == key ? &entry->second : nullptr;
+    }
+    Value value(const Key &key, const Value &defaultValue = Value()) const
+    {
+        const Value *value = find(key);
+        return value ? *value : defaultValue;
+    }
+    /**
+     * Returns the first key with @p value, or @p defaultKey if there is none.
+     */
+    Key key(const Value &value, const Key &defaultKey = Key()) const
+    {
+        for (const Entry &entry : *this) {
+            if (entry.second == value) {
+                return entry.first;
+            }
+        }
+        return defaultKey;
+    }
+
+    void insert(const Key &key, const Value &value)
+    {
+        Entry *entry = lowerBound(m_entries.data(), m_entries.data() + m_entries.size(), key);
+        if (entry != m_entries.data() + m_entries.size() && entry->first == key) {
+            entry->second = value;
+            return;
+        }
+        m_entries.insert(entry, Entry(key, value));
+    }
+    /**
+     * Returns whether there was an entry for @p key.
+     */
+    bool remove(const Key &key)
+    {
+        const Entry *entry = lowerBound(begin(), end(), key);
+        if (entry == end() || entry->first != key) {
+            return false;
+        }
+        m_entries.erase(entry);
+        return true;
+    }
+    /**
+     * Removes all entries, the memory is kept for the next ones.
+     */
+    void clear()
+    {
+        m_entries.clear();
+    }
+
+private:
+    template<typename Iterator>
+    static Iterator lowerBound(Iterator begin, Iterator end, const Key &key)
+    {
+        return std::lower_bound(begin, end, key, [](const Entry &entry, const Key &key) {
+            return entry.first < key;
+        });
+    }
+
+    QVarLengthArray<Entry, Prealloc> m_entries;
+};
+
+/**
+ * The set counterpart of SmallFlatMap, e.g. for the pressed keys of a keyboard. The values are
+ * contiguous and sorted, so they can be put on the wire as they are.
+ */
+template<typename T, int Prealloc = 8>
+class SmallFlatSet
+{
+public:
+    using const_iterator = const T *;
+
+    const_iterator begin() const
+    {
+        return m_values.constData();
+    }
+    const_iterator end() const
+    {
+        return m_values.constData() + m_values.size();
+    }
+    const T *constData() const
+    {
+        return m_values.constData();
+    }
+    int count() const
+    {
+        return m_values.size();
+    }
+    bool isEmpty() const
+    {
+        return m_values.isEmpty();
+    }
+    bool contains(const T &value) const
+    {
+        const T *it = std::lower_bound(begin(), end(), value);
+        return it != end() && *it == value;
+    }
+
+    /**
+     * Returns whether @p value has been added, i.e. it wasn't in the set yet.
+     */
+    bool insert(const T &value)
+    {
+        const T *it = std::lower_bound(begin(), end(), value);
+        if (it != end() && *it == value) {
+            return false;
+        }
+        m_values.insert(it, value);
+        return true;
+    }
+    /**
+     * Returns whether @p value was in the set.
+     */
+    bool remove(const T &value)
+    {
+        const T *it = std::lower_bound(begin(), end(), value);
+        if (it == end() || *it != value) {
+            return false;
+        }
+        m_values.erase(it);
+        return true;
+    }
+    void clear()
+    {
+        m_values.clear();
+    }
+
+private:
+    QVarLengthArray<T, Prealloc> m_values;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,215 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include "virtualkeyboard_v1_interface.h"
+#include "display.h"
+#include "keyboard_interface.h"
+#include "keyboard_interface_p.h"
+#include "keymapfile.h"
+#include "logging.h"
+#include "seat_interface.h"
+#include "seat_interface_p.h"
+#include "utils_p.h"
+
+#include <QPointer>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "qwayland-server-virtual-keyboard-unstable-v1.h"
+
+namespace KWaylandServer
+{
+static const quint32 s_version = 1;
+
+class VirtualKeyboardV1InterfacePrivate : public QtWaylandServer::zwp_virtual_keyboard_v1
+{
+public:
+    VirtualKeyboardV1InterfacePrivate(VirtualKeyboardV1Interface *q, SeatInterface *seat, wl_resource *resource);
+
+    bool ensureKeymap(Resource *resource);
+
+    VirtualKeyboardV1Interface *q;
+    QPointer<SeatInterface> seat;
+    ClientConnection *client;
+    QByteArray keymap;
+    QSharedPointer<KeymapFile> keymapFile;
+    SmallFlatSet<quint32, 16> pressedKeys;
+
+protected:
+    void zwp_virtual_keyboard_v1_destroy_resource(Resource *resource) override;
+    void zwp_virtual_keyboard_v1_keymap(Resource *resource, uint32_t format, int32_t fd, uint32_t size) override;
+    void zwp_virtual_keyboard_v1_key(Resource *resource, uint32_t time, uint32_t key, uint32_t state) override;
+    void zwp_virtual_keyboard_v1_modifiers(Resource *resource, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group) override;
+    void zwp_virtual_keyboard_v1_destroy(Resource *resource) override;
+};
+
+VirtualKeyboardV1InterfacePrivate::VirtualKeyboardV1InterfacePrivate(VirtualKeyboardV1Interface *q, SeatInterface *seat, wl_resource *resource)
+    : QtWaylandServer::zwp_virtual_keyboard_v1(resource)
+    , q(q)
+    , seat(seat)
+    , client(seat->display()->getConnection(wl_resource_get_client(resource)))
+{
+}
+
+bool VirtualKeyboardV1InterfacePrivate::ensureKeymap(Resource *resource)
+{
+    if (!keymapFile) {
+        wl_resource_post_error(resource->handle, error_no_keymap, "the keymap must be set first");
+        return false;
+    }
+    if (!seat || !seat->keyboard()) {
+        return false;
+    }
+    // the keys can only be interpreted by the clients with the keymap they were typed with, the
+    // seat switches back to its own keymap before its next key
+    KeyboardInterfacePrivate *keyboardPrivate = KeyboardInterfacePrivate::get(seat->keyboard());
+    if (keyboardPrivate->keymap != keymapFile) {
+        keyboardPrivate->setKeymap(keymap, keymapFile);
+    }
+    return true;
+}
+
+void VirtualKeyboardV1InterfacePrivate::zwp_virtual_keyboard_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    // the keys the client still holds would be stuck otherwise
+    if (seat && seat->keyboard()) {
+        for (quint32 key : pressedKeys) {
+            SeatInterfacePrivate::get(seat)->notifyKeyboardKey(key, KeyboardKeyState::Released);
+        }
+    }
+    delete q;
+}
+
+void VirtualKeyboardV1InterfacePrivate::zwp_virtual_keyboard_v1_keymap(Resource *resource, uint32_t format, int32_t fd, uint32_t size)
+{
+    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1 || size == 0) {
+        close(fd);
+        return;
+    }
+    // mapping beyond the end of the file would crash the compositor on the first access
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < off_t(size)) {
+        close(fd);
+        wl_resource_post_error(resource->handle, error_no_keymap, "the keymap file is smaller than the given size");
+        return;
+    }
+    void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to map the keymap of a virtual keyboard";
+        return;
+    }
+    // the size includes the terminating null byte
+    const QByteArray content(static_cast<const char *>(address), qstrnlen(static_cast<const char *>(address), size));
+    munmap(address, size);
+
+    QSharedPointer<KeymapFile> file = KeymapFile::shared(content);
+    if (!file) {
+        return;
+    }
+    keymap = content;
+    keymapFile = file;
+    Q_EMIT q->keymapChanged();
+}
+
+void VirtualKeyboardV1InterfacePrivate::zwp_virtual_keyboard_v1_key(Resource *resource, uint32_t time, uint32_t key, uint32_t state)
+{
+    Q_UNUSED(time)
+    if (!ensureKeymap(resource)) {
+        return;
+    }
+    const KeyboardKeyState keyState = state == WL_KEYBOARD_KEY_STATE_PRESSED ? KeyboardKeyState::Pressed : KeyboardKeyState::Released;
+    if (keyState == KeyboardKeyState::Pressed) {
+        pressedKeys.insert(key);
+    } else {
+        pressedKeys.remove(key);
+    }
+    SeatInterfacePrivate::get(seat)->notifyKeyboardKey(key, keyState);
+}
+
+void VirtualKeyboardV1InterfacePrivate::zwp_virtual_keyboard_v1_modifiers(Resource *resource,
+                                                                         uint32_t mods_depressed,
+                                                                         uint32_t mods_latched,
+                                                                         uint32_t mods_locked,
+                                                                         uint32_t group)
+{
+    if (!ensureKeymap(resource)) {
+        return;
+    }
+    SeatInterfacePrivate *seatPrivate = SeatInterfacePrivate::get(seat);
+    seatPrivate->seatModifiers.replaced = true;
+    seatPrivate->notifyKeyboardModifiers(mods_depressed, mods_latched, mods_locked, group);
+}
+
+void VirtualKeyboardV1InterfacePrivate::zwp_virtual_keyboard_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+VirtualKeyboardV1Interface::VirtualKeyboardV1Interface(SeatInterface *seat, wl_resource *resource)
+    : d(new VirtualKeyboardV1InterfacePrivate(this, seat, resource))
+{
+}
+
+VirtualKeyboardV1Interface::~VirtualKeyboardV1Interface() = default;
+
+SeatInterface *VirtualKeyboardV1Interface::seat() const
+{
+    return d->seat;
+}
+
+ClientConnection *VirtualKeyboardV1Interface::client() const
+{
+    return d->client;
+}
+
+QByteArray VirtualKeyboardV1Interface::keymap() const
+{
+    return d->keymap;
+}
+
+class VirtualKeyboardManagerV1InterfacePrivate : public QtWaylandServer::zwp_virtual_keyboard_manager_v1
+{
+public:
+    VirtualKeyboardManagerV1InterfacePrivate(VirtualKeyboardManagerV1Interface *q, Display *display);
+
+    VirtualKeyboardManagerV1Interface *q;
+
+protected:
+    void zwp_virtual_keyboard_manager_v1_create_virtual_keyboard(Resource *resource, wl_resource *seat, uint32_t id) override;
+};
+
+VirtualKeyboardManagerV1InterfacePrivate::VirtualKeyboardManagerV1InterfacePrivate(VirtualKeyboardManagerV1Interface *q, Display *display)
+    : QtWaylandServer::zwp_virtual_keyboard_manager_v1(*display, s_version)
+    , q(q)
+{
+}
+
+void VirtualKeyboardManagerV1InterfacePrivate::zwp_virtual_keyboard_manager_v1_create_virtual_keyboard(Resource *resource, wl_resource *seat, uint32_t id)
+{
+    SeatInterface *seatInterface = SeatInterface::get(seat);
+    if (!seatInterface) {
+        wl_resource_post_error(resource->handle, WL_DISPLAY_ERROR_INVALID_OBJECT, "the seat is gone");
+        return;
+    }
+    wl_resource *keyboardResource = wl_resource_create(resource->client(), &zwp_virtual_keyboard_v1_interface, resource->version(), id);
+    if (!keyboardResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    Q_EMIT q->virtualKeyboardCreated(new VirtualKeyboardV1Interface(seatInterface, keyboardResource));
+}
+
+VirtualKeyboardManagerV1Interface::VirtualKeyboardManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new VirtualKeyboardManagerV1InterfacePrivate(this, display))
+{
+}
+
+VirtualKeyboardManagerV1Interface::~VirtualKeyboardManagerV1Interface() = default;
+
+} // namespace KWaylandServer
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <DWayland/Server/kwaylandserver_export.h>
+
+#include <QObject>
+
+struct wl_resource;
+
+namespace KWaylandServer
+{
+class ClientConnection;
+class Display;
+class SeatInterface;
+class VirtualKeyboardManagerV1InterfacePrivate;
+class VirtualKeyboardV1InterfacePrivate;
+
+/**
+ * The VirtualKeyboardV1Interface represents a keyboard emulated by a client, e.g. an on-screen
+ * keyboard or a remote input service.
+ *
+ * The keys and modifiers of the virtual keyboard are delivered through the seat right away. They
+ * are interpreted with the keymap of the virtual keyboard, so before the first key after another
+ * keymap was in use the keymap of the virtual keyboard is sent to the seat's keyboards. Before
+ * the next key or modifiers passed to SeatInterface::notifyKeyboardKey or
+ * SeatInterface::notifyKeyboardModifiers the seat switches back to the keymap set with
+ * KeyboardInterface::setKeymap and to its own modifiers. Keymaps with the same content share a
+ * single sealed file, switching between them doesn't create a new one.
+ *
+ * VirtualKeyboardV1Interface corresponds to the Wayland interface @c zwp_virtual_keyboard_v1.
+ */
+class KWAYLANDSERVER_EXPORT VirtualKeyboardV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~VirtualKeyboardV1Interface() override;
+
+    SeatInterface *seat() const;
+    ClientConnection *client() const;
+    /**
+     * Returns the keymap the client has set, a null QByteArray until it has set one.
+     */
+    QByteArray keymap() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the client has set a new keymap.
+     */
+    void keymapChanged();
+
+private:
+    VirtualKeyboardV1Interface(SeatInterface *seat, wl_resource *resource);
+    friend class VirtualKeyboardManagerV1InterfacePrivate;
+    QScopedPointer<VirtualKeyboardV1InterfacePrivate> d;
+};
+
+/**
+ * The VirtualKeyboardManagerV1Interface lets clients create virtual keyboards. Unlike the keys of
+ * FakeInputInterface, which the compositor has to translate itself, the keys of a virtual
+ * keyboard come with its keymap and are delivered to the seat without a round trip through the
+ * compositor.
+ *
+ * VirtualKeyboardManagerV1Interface corresponds to the Wayland interface
+ * @c zwp_virtual_keyboard_manager_v1.
+ */
+class KWAYLANDSERVER_EXPORT VirtualKeyboardManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VirtualKeyboardManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~VirtualKeyboardManagerV1Interface() override;
+
+Q_SIGNALS:
+    void virtualKeyboardCreated(KWaylandServer::VirtualKeyboardV1Interface *keyboard);
+
+private:
+    QScopedPointer<VirtualKeyboardManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <utility>
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+class AppMenuInterface;
+class BlurInterface;
+class ClientBuffer;
+class ContrastInterface;
+class ServerSideDecorationInterface;
+class ServerSideDecorationPaletteInterface;
+class ShadowInterface;
+class SlideInterface;
+
+/**
+ * Installs @p listener to be notified when @p object gets destroyed. An overload has to exist
+ * for every type a WeakHandle is used with.
+ */
+void addWeakHandleListener(AppMenuInterface *appMenu, wl_listener *listener);
+void addWeakHandleListener(BlurInterface *blur, wl_listener *listener);
+void addWeakHandleListener(ClientBuffer *buffer, wl_listener *listener);
+void addWeakHandleListener(ContrastInterface *contrast, wl_listener *listener);
+void addWeakHandleListener(ServerSideDecorationInterface *decoration, wl_listener *listener);
+void addWeakHandleListener(ServerSideDecorationPaletteInterface *palette, wl_listener *listener);
+void addWeakHandleListener(ShadowInterface *shadow, wl_listener *listener);
+void addWeakHandleListener(SlideInterface *slide, wl_listener *listener);
+
+/**
+ * A guarded pointer that is reset to @c null when the object it points to gets destroyed,
+ * like a QPointer, but without the reference counted weak reference data of QObject.
+ *
+ * The handle is a listener in the destroy signal of the object, e.g. of its wl_resource, so
+ * setting, copying and swapping a handle only links and unlinks a list node and involves no
+ * atomic operation. This keeps the states of a surface cheap to merge on every commit.
+ *
+ * A handle must only be used in the thread of the Display.
+ */
+template<typename T>
+class WeakHandle
+{
+public:
+    WeakHandle()
+    {
+        m_destroyListener.listener.notify = destroyCallback;
+        m_destroyListener.handle = this;
+        wl_list_init(&m_destroyListener.listener.link);
+    }
+    WeakHandle(T *object)
+        : WeakHandle()
+    {
+        reset(object);
+    }
+    WeakHandle(const WeakHandle &other)
+        : WeakHandle(other.m_object)
+    {
+    }
+    ~WeakHandle()
+    {
+        wl_list_remove(&m_destroyListener.listener.link);
+    }
+
+    WeakHandle &operator=(T *object)
+    {
+        reset(object);
+        return *this;
+    }
+    WeakHandle &operator=(const WeakHandle &other)
+    {
+        reset(other.m_object);
+        return *this;
+    }
+
+    void reset(T *object = nullptr)
+    {
+        if (m_object == object) {
+            return;
+        }
+        wl_list_remove(&m_destroyListener.listener.link);
+        wl_list_init(&m_destroyListener.listener.link);
+        m_object = object;
+        if (object) {
+            addWeakHandleListener(object, &m_destroyListener.listener);
+        }
+    }
+    void swap(WeakHandle &other)
+    {
+        T *object = other.m_object;
+        other.reset(m_object);
+        reset(object);
+    }
+
+    T *data() const
+    {
+        return m_object;
+    }
+    operator T *() const
+    {
+        return m_object;
+    }
+    T *operator->() const
+    {
+        return m_object;
+    }
+
+private:
+    static void destroyCallback(wl_listener *listener, void *data)
+    {
+        Q_UNUSED(data)
+        DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+        wl_list_remove(&listener->link);
+        wl_list_init(&listener->link);
+        destroyListener->handle->m_object = nullptr;
+    }
+
+    T *m_object = nullptr;
+    // Kept in a standard layout struct, so wl_container_of can be used on the listener.
+    struct DestroyListener {
+        wl_listener listener;
+        WeakHandle *handle;
+    } m_destroyListener;
+};
+
+} // namespace KWaylandServer
@@ -5,10 +5,15 @@
 */
 
 #include "xdgactivation_v1_interface.h"
+#include "clientconnection.h"
 #include "display.h"
+#include "display_p.h"
 #include "logging.h"
 #include "seat_interface.h"
 #include "surface_interface.h"
+#include "timerwheel.h"
+
+#include <QHash>
 
 #include "qwayland-server-xdg-activation-v1.h"
 
@@ -19,9 +24,9 @@ static const int s_version = 1;
 class XdgActivationTokenV1Interface : public QtWaylandServer::xdg_activation_token_v1
 {
 public:
-    XdgActivationTokenV1Interface(XdgActivationV1Interface::CreatorFunction creator, ClientConnection *client, uint32_t newId)
+    XdgActivationTokenV1Interface(XdgActivationV1Interface *manager, ClientConnection *client, uint32_t newId)
         : QtWaylandServer::xdg_activation_token_v1(*client, newId, s_version)
-        , m_creator(creator)
+        , m_manager(manager)
         , m_client(client)
     {
     }
@@ -34,7 +39,7 @@ protected:
     void xdg_activation_token_v1_destroy(Resource *resource) override;
     void xdg_activation_token_v1_destroy_resource(Resource *resource) override;
 
-    const XdgActivationV1Interface::CreatorFunction m_creator;
+    const QPointer<XdgActivationV1Interface> m_manager;
     QPointer<SurfaceInterface> m_surface;
     uint m_serial = 0;
     struct ::wl_resource *m_seat = nullptr;
@@ -62,11 +67,115 @@ void XdgActivationTokenV1Interface::xdg_activation_token_v1_set_surface(Resource
     m_surface = SurfaceInterface::get(surface);
 }
 
+class XdgActivationV1InterfacePrivate : public QtWaylandServer::xdg_activation_v1
+{
+public:
+    XdgActivationV1InterfacePrivate(Display *display, XdgActivationV1Interface *q)
+        : QtWaylandServer::xdg_activation_v1(*display, s_version)
+        , q(q)
+        , m_display(display)
+    {
+    }
+    ~XdgActivationV1InterfacePrivate() override
+    {
+        qDeleteAll(m_tokens);
+    }
+
+    static XdgActivationV1InterfacePrivate *get(XdgActivationV1Interface *q)
+    {
+        return q->d.data();
+    }
+
+    QString createToken(ClientConnection *client, const XdgActivationV1Interface::Token &data);
+    void removeToken(const QString &token);
+
+protected:
+    void xdg_activation_v1_get_activation_token(Resource *resource, uint32_t id) override;
+    void xdg_activation_v1_activate(Resource *resource, const QString &token, struct ::wl_resource *surface) override;
+    void xdg_activation_v1_destroy(Resource *resource) override;
+
+public:
+    struct StoredToken {
+        XdgActivationV1Interface::Token data;
+        // the requesting client, reset once it disconnects while the token stays valid
+        ClientConnection *client = nullptr;
+        TimerWheel::Timer expiry;
+    };
+
+    XdgActivationV1Interface::CreatorFunction m_creator;
+    XdgActivationV1Interface *const q;
+    Display *const m_display;
+    QHash<QString, StoredToken *> m_tokens;
+    // the tokens of each client, oldest first
+    QHash<ClientConnection *, QStringList> m_clientTokens;
+    std::chrono::milliseconds m_tokenLifetime = std::chrono::minutes(1);
+    int m_maximumTokensPerClient = 32;
+};
+
+QString XdgActivationV1InterfacePrivate::createToken(ClientConnection *client, const XdgActivationV1Interface::Token &data)
+{
+    if (!m_creator) {
+        return QString();
+    }
+    const QString token = m_creator(client, data.surface, data.serial, data.seat, data.appId);
+    if (token.isEmpty()) {
+        return token;
+    }
+    removeToken(token);
+
+    auto stored = new StoredToken;
+    stored->data = data;
+    stored->client = client;
+    m_tokens.insert(token, stored);
+    if (m_tokenLifetime > std::chrono::milliseconds::zero()) {
+        stored->expiry.setCallback([this, token]() {
+            removeToken(token);
+        });
+        stored->expiry.start(&DisplayPrivate::get(m_display)->timerWheel, m_tokenLifetime);
+    }
+
+    auto it = m_clientTokens.find(client);
+    if (it == m_clientTokens.end()) {
+        it = m_clientTokens.insert(client, QStringList());
+        QObject::connect(client, &ClientConnection::aboutToBeDestroyed, q, [this, client]() {
+            // tokens of a launcher outlive it
+            const QStringList tokens = m_clientTokens.take(client);
+            for (const QString &token : tokens) {
+                m_tokens.value(token)->client = nullptr;
+            }
+        });
+    }
+    it->append(token);
+    if (m_maximumTokensPerClient > 0 && it->count() > m_maximumTokensPerClient) {
+        const QString oldest = it->first();
+        removeToken(oldest);
+    }
+    return token;
+}
+
+void XdgActivationV1InterfacePrivate::removeToken(const QString &token)
+{
+    StoredToken *stored = m_tokens.take(token);
+    if (!stored) {
+        return;
+    }
+    if (stored->client) {
+        auto it = m_clientTokens.find(stored->client);
+        it->removeOne(token);
+    }
+    delete stored;
+}
+
 void XdgActivationTokenV1Interface::xdg_activation_token_v1_commit(Resource *resource)
 {
     QString token;
-    if (m_creator) {
-        token = m_creator(m_client, m_surface, m_serial, SeatInterface::get(m_seat), m_appId);
+    if (m_manager) {
+        XdgActivationV1Interface::Token data;
+        data.surface = m_surface;
+        data.serial = m_serial;
+        data.seat = SeatInterface::get(m_seat);
+        data.appId = m_appId;
+        token = XdgActivationV1InterfacePrivate::get(m_manager)->createToken(m_client, data);
     }
 
     m_committed = true;
@@ -87,30 +196,9 @@ void XdgActivationTokenV1Interface::xdg_activation_token_v1_destroy_resource(Res
     delete this;
 }
 
-class XdgActivationV1InterfacePrivate : public QtWaylandServer::xdg_activation_v1
-{
-public:
-    XdgActivationV1InterfacePrivate(Display *display, XdgActivationV1Interface *q)
-        : QtWaylandServer::xdg_activation_v1(*display, s_version)
-        , q(q)
-        , m_display(display)
-    {
-    }
-
-protected:
-    void xdg_activation_v1_get_activation_token(Resource *resource, uint32_t id) override;
-    void xdg_activation_v1_activate(Resource *resource, const QString &token, struct ::wl_resource *surface) override;
-    void xdg_activation_v1_destroy(Resource *resource) override;
-
-public:
-    XdgActivationV1Interface::CreatorFunction m_creator;
-    XdgActivationV1Interface *const q;
-    Display *const m_display;
-};
-
 void XdgActivationV1InterfacePrivate::xdg_activation_v1_get_activation_token(Resource *resource, uint32_t id)
 {
-    new XdgActivationTokenV1Interface(m_creator, m_display->getConnection(resource->client()), id);
+    new XdgActivationTokenV1Interface(q, m_display->getConnection(resource->client()), id);
 }
 
 void XdgActivationV1InterfacePrivate::xdg_activation_v1_activate(Resource *resource, const QString &token, struct ::wl_resource *surface)
@@ -139,4 +227,35 @@ void XdgActivationV1Interface::setActivationTokenCreator(const CreatorFunction &
     d->m_creator = creator;
 }
 
+std::optional<XdgActivationV1Interface::Token> XdgActivationV1Interface::takeToken(const QString &token)
+{
+    const auto it = d->m_tokens.constFind(token);
+    if (it == d->m_tokens.constEnd()) {
+        return std::nullopt;
+    }
+    const Token data = (*it)->data;
+    d->removeToken(token);
+    return data;
+}
+
+void XdgActivationV1Interface::setTokenLifetime(std::chrono::milliseconds lifetime)
+{
+    d->m_tokenLifetime = lifetime;
+}
+
+std::chrono::milliseconds XdgActivationV1Interface::tokenLifetime() const
+{
+    return d->m_tokenLifetime;
+}
+
+void XdgActivationV1Interface::setMaximumTokensPerClient(int count)
+{
+    d->m_maximumTokensPerClient = count;
+}
+
+int XdgActivationV1Interface::maximumTokensPerClient() const
+{
+    return d->m_maximumTokensPerClient;
+}
+
 }
@@ -9,7 +9,9 @@
 #include <DWayland/Server/kwaylandserver_export.h>
 
 #include <QObject>
+#include <QPointer>
 #include <QVector>
+#include <chrono>
 #include <functional>
 #include <optional>
 
@@ -37,6 +39,33 @@ public:
     /// Provide the @p creator function that will be used to create a token given its parameters
     void setActivationTokenCreator(const CreatorFunction &creator);
 
+    /// The parameters a token returned by the creator function was requested with
+    struct Token {
+        QPointer<SurfaceInterface> surface;
+        uint serial = 0;
+        QPointer<SeatInterface> seat;
+        QString appId;
+    };
+
+    /**
+     * Returns the parameters of @p token and forgets it, or @c std::nullopt if the token was not
+     * handed out, expired or was taken already.
+     *
+     * All tokens returned by the creator function are kept until they are taken, expire or the
+     * client that requested them holds too many of them, so the compositor doesn't need to keep
+     * track of the tokens on its own.
+     */
+    std::optional<Token> takeToken(const QString &token);
+
+    /// Sets how long the tokens are kept, the default is one minute. Zero keeps them forever
+    void setTokenLifetime(std::chrono::milliseconds lifetime);
+    std::chrono::milliseconds tokenLifetime() const;
+
+    /// Sets how many tokens are kept for each client, further tokens replace its oldest one.
+    /// The default is 32, zero disables the limit
+    void setMaximumTokensPerClient(int count);
+    int maximumTokensPerClient() const;
+
 Q_SIGNALS:
     /// Notifies about the @p surface being activated using @p token.
     void activateRequested(SurfaceInterface *surface, const QString &token);
@@ -37,6 +37,11 @@ SurfaceInterface *XdgForeignV2Interface::transientFor(SurfaceInterface *surface)
     return d->importer->transientFor(surface);
 }
 
+QVector<SurfaceInterface *> XdgForeignV2Interface::transientChildren(SurfaceInterface *surface) const
+{
+    return d->importer->transientChildren(surface);
+}
+
 XdgExporterV2Interface::XdgExporterV2Interface(Display *display, XdgForeignV2Interface *foreign)
     : QObject(foreign)
     , QtWaylandServer::zxdg_exporter_v2(*display, s_exporterVersion)
@@ -96,6 +101,15 @@ SurfaceInterface *XdgImporterV2Interface::transientFor(SurfaceInterface *surface
     return (*it)->surface();
 }
 
+QVector<SurfaceInterface *> XdgImporterV2Interface::transientChildren(SurfaceInterface *surface) const
+{
+    QVector<SurfaceInterface *> children;
+    for (auto it = m_transients.constFind(surface); it != m_transients.constEnd() && it.key() == surface; ++it) {
+        children.append(*it);
+    }
+    return children;
+}
+
 void XdgImporterV2Interface::zxdg_importer_v2_destroy(Resource *resource)
 {
     wl_resource_destroy(resource->handle);
@@ -122,11 +136,6 @@ void XdgImporterV2Interface::zxdg_importer_v2_import_toplevel(Resource *resource
 
     connect(imported, &XdgImportedV2Interface::childChanged, this, [this, imported](SurfaceInterface *child) {
         link(imported, child);
-
-        // child surface destroyed
-        connect(child, &QObject::destroyed, this, [this, child]() {
-            unlink(nullptr, child);
-        });
     });
 
     // surface no longer imported
@@ -135,17 +144,34 @@ void XdgImporterV2Interface::zxdg_importer_v2_import_toplevel(Resource *resource
     });
 }
 
+void XdgImporterV2Interface::removeLink(XdgImportedV2Interface *parent, SurfaceInterface *child)
+{
+    m_parents.remove(child);
+    m_children.remove(parent);
+    m_transients.remove(parent->surface(), child);
+    QObject::disconnect(m_childDestroyedConnections.take(child));
+}
+
 void XdgImporterV2Interface::link(XdgImportedV2Interface *parent, SurfaceInterface *child)
 {
-    // remove any previous association
-    auto it = m_children.find(parent);
-    if (it != m_children.end()) {
-        m_parents.remove(*it);
-        m_children.erase(it);
+    // remove any previous association of either endpoint
+    auto it = m_children.constFind(parent);
+    if (it != m_children.constEnd()) {
+        removeLink(parent, *it);
+    }
+    auto parentIt = m_parents.constFind(child);
+    if (parentIt != m_parents.constEnd()) {
+        removeLink(*parentIt, child);
     }
 
     m_parents[child] = parent;
     m_children[parent] = child;
+    m_transients.insert(parent->surface(), child);
+
+    // child surface destroyed
+    m_childDestroyedConnections[child] = connect(child, &QObject::destroyed, this, [this, child]() {
+        unlink(nullptr, child);
+    });
 
     Q_EMIT m_foreign->transientChanged(child, parent->surface());
 }
@@ -155,21 +181,19 @@ void XdgImporterV2Interface::unlink(XdgImportedV2Interface *parent, SurfaceInter
     if (parent) {
         // If the parent endpoint is unlinked, the transientChanged() signal will indicate
         // the orphaned child.
-        auto it = m_children.find(parent);
-        if (it != m_children.end()) {
+        auto it = m_children.constFind(parent);
+        if (it != m_children.constEnd()) {
             SurfaceInterface *child = *it;
-            m_parents.remove(*it);
-            m_children.erase(it);
+            removeLink(parent, child);
             Q_EMIT m_foreign->transientChanged(child, nullptr);
         }
     } else if (child) {
         // If the child endpoint is unlinked, the transientChanged() signal will indicate
         // what parent has lost a child.
-        auto it = m_parents.find(child);
-        if (it != m_parents.end()) {
+        auto it = m_parents.constFind(child);
+        if (it != m_parents.constEnd()) {
             XdgImportedV2Interface *parent = *it;
-            m_children.remove(*it);
-            m_parents.erase(it);
+            removeLink(parent, child);
             Q_EMIT m_foreign->transientChanged(nullptr, parent->surface());
         }
     }
@@ -222,6 +246,7 @@ void XdgDummyImportedV2Interface::zxdg_imported_v2_destroy_resource(Resource *re
 XdgImportedV2Interface::XdgImportedV2Interface(XdgExportedV2Interface *exported, wl_resource *resource)
     : QtWaylandServer::zxdg_imported_v2(resource)
     , m_exported(exported)
+    , m_surface(exported->surface())
 {
     connect(exported, &QObject::destroyed, this, &XdgImportedV2Interface::handleExportedDestroyed);
 }
@@ -233,7 +258,7 @@ SurfaceInterface *XdgImportedV2Interface::child() const
 
 SurfaceInterface *XdgImportedV2Interface::surface() const
 {
-    return m_exported->surface();
+    return m_surface;
 }
 
 void XdgImportedV2Interface::zxdg_imported_v2_set_parent_of(Resource *resource, wl_resource *surface)
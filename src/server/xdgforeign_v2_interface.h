@@ -39,6 +39,13 @@ public:
      */
     SurfaceInterface *transientFor(SurfaceInterface *surface);
 
+    /**
+     * Returns the surfaces which other clients did set as children of @p surface through
+     * an imported handle, e.g. to re-parent all of them at once when @p surface gets mapped again.
+     * @see transientFor
+     */
+    QVector<SurfaceInterface *> transientChildren(SurfaceInterface *surface) const;
+
 Q_SIGNALS:
     /**
      * A surface got a new imported transient parent
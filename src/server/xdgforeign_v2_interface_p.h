@@ -57,6 +57,7 @@ public:
     void unlink(XdgImportedV2Interface *parent, SurfaceInterface *child);
 
     SurfaceInterface *transientFor(SurfaceInterface *surface);
+    QVector<SurfaceInterface *> transientChildren(SurfaceInterface *surface) const;
 
 protected:
     void zxdg_importer_v2_destroy(Resource *resource) override;
@@ -66,6 +67,10 @@ private:
     XdgForeignV2Interface *m_foreign;
     QHash<SurfaceInterface *, XdgImportedV2Interface *> m_parents; // child->parent hash
     QHash<XdgImportedV2Interface *, SurfaceInterface *> m_children; // parent->child hash
+    QMultiHash<SurfaceInterface *, SurfaceInterface *> m_transients; // exported surface->child hash
+    QHash<SurfaceInterface *, QMetaObject::Connection> m_childDestroyedConnections;
+
+    void removeLink(XdgImportedV2Interface *parent, SurfaceInterface *child);
 };
 
 class XdgExportedV2Interface : public QObject, public QtWaylandServer::zxdg_exported_v2
@@ -115,6 +120,8 @@ private Q_SLOTS:
 
 private:
     XdgExportedV2Interface *m_exported;
+    // the exported surface, still known while the exported object is being destroyed
+    SurfaceInterface *m_surface;
     QPointer<SurfaceInterface> m_child;
 
 protected:
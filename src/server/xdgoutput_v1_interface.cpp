@@ -14,6 +14,8 @@
 #include <QHash>
 #include <QPointer>
 
+#include <algorithm>
+
 namespace KWaylandServer
 {
 static const quint32 s_version = 3;
@@ -43,8 +45,13 @@ public:
     QSize size;
     QString name;
     QString description;
+    // the strings are encoded once for all the clients getting the xdg output
+    QByteArray encodedName;
+    QByteArray encodedDescription;
     bool dirty = false;
     bool doneOnce = false;
+    int updateDepth = 0;
+    bool donePending = false;
     QPointer<OutputInterface> output;
 
 protected:
@@ -123,10 +130,7 @@ void XdgOutputV1Interface::setLogicalSize(const QSize &size)
     d->size = size;
     d->dirty = true;
 
-    const auto outputResources = d->resourceMap();
-    for (auto resource : outputResources) {
-        d->send_logical_size(resource->handle, size.width(), size.height());
-    }
+    d->broadcast_logical_size(size.width(), size.height());
 }
 
 QSize XdgOutputV1Interface::logicalSize() const
@@ -142,10 +146,7 @@ void XdgOutputV1Interface::setLogicalPosition(const QPoint &pos)
     d->pos = pos;
     d->dirty = true;
 
-    const auto outputResources = d->resourceMap();
-    for (auto resource : outputResources) {
-        d->send_logical_position(resource->handle, pos.x(), pos.y());
-    }
+    d->broadcast_logical_position(pos.x(), pos.y());
 }
 
 QPoint XdgOutputV1Interface::logicalPosition() const
@@ -156,28 +157,58 @@ QPoint XdgOutputV1Interface::logicalPosition() const
 void XdgOutputV1Interface::setName(const QString &name)
 {
     d->name = name;
+    d->encodedName = name.toUtf8();
     // this can only be set once before the client connects
 }
 
 void XdgOutputV1Interface::setDescription(const QString &description)
 {
     d->description = description;
+    d->encodedDescription = description.toUtf8();
     // this can only be set once before the client connects
 }
 
 void XdgOutputV1Interface::done()
 {
+    if (d->updateDepth > 0) {
+        d->donePending = true;
+        return;
+    }
     d->doneOnce = true;
     if (!d->dirty) {
         return;
     }
     d->dirty = false;
 
+    // deprecated since version 3, the done event of the wl_output is used instead
+    d->broadcast_done([](XdgOutputV1InterfacePrivate::Resource *resource) {
+        return resource->version() < 3;
+    });
+}
+
+void XdgOutputV1Interface::beginUpdate()
+{
+    ++d->updateDepth;
+}
+
+void XdgOutputV1Interface::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0 || !d->donePending) {
+        return;
+    }
+    d->donePending = false;
+    const bool dirty = d->dirty;
+    done();
+    if (!dirty || !d->output) {
+        return;
+    }
     const auto outputResources = d->resourceMap();
-    for (auto resource : outputResources) {
-        if (wl_resource_get_version(resource->handle) < 3) {
-            d->send_done(resource->handle);
-        }
+    const bool hasVersion3 = std::any_of(outputResources.cbegin(), outputResources.cend(), [](XdgOutputV1InterfacePrivate::Resource *resource) {
+        return resource->version() >= 3;
+    });
+    if (hasVersion3) {
+        d->output->done();
     }
 }
 
@@ -191,10 +222,10 @@ void XdgOutputV1InterfacePrivate::zxdg_output_v1_bind_resource(Resource *resourc
     send_logical_position(resource->handle, pos.x(), pos.y());
     send_logical_size(resource->handle, size.width(), size.height());
     if (resource->version() >= ZXDG_OUTPUT_V1_NAME_SINCE_VERSION) {
-        send_name(resource->handle, name);
+        zxdg_output_v1_send_name(resource->handle, encodedName.constData());
     }
     if (resource->version() >= ZXDG_OUTPUT_V1_DESCRIPTION_SINCE_VERSION) {
-        send_description(resource->handle, description);
+        zxdg_output_v1_send_description(resource->handle, encodedDescription.constData());
     }
 
     if (doneOnce) {
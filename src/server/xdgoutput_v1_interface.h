@@ -110,6 +110,20 @@ public:
      */
     void done();
 
+    /**
+     * Starts changing several properties at once. Calls to done() are held back until the
+     * matching endUpdate(), which sends a single done event. Clients binding version 3 or
+     * later apply xdg-output changes on wl_output.done instead, for them endUpdate() calls
+     * OutputInterface::done(). Updates can be nested.
+     *
+     * @see OutputTransaction
+     */
+    void beginUpdate();
+    /**
+     * Ends an update started with beginUpdate().
+     */
+    void endUpdate();
+
 private:
     explicit XdgOutputV1Interface(OutputInterface *output, QObject *parent);
     friend class XdgOutputManagerV1Interface;
@@ -8,11 +8,12 @@
 #include "xdgshell_interface_p.h"
 
 #include "display.h"
+#include "display_p.h"
 #include "output_interface.h"
 #include "seat_interface.h"
 #include "utils.h"
 
-#include <QTimer>
+#include <algorithm>
 
 namespace KWaylandServer
 {
@@ -49,19 +50,20 @@ void XdgShellInterfacePrivate::unregisterXdgSurface(XdgSurfaceInterface *surface
  */
 void XdgShellInterfacePrivate::registerPing(quint32 serial)
 {
-    QTimer *timer = new QTimer(q);
-    timer->setInterval(1000);
-    QObject::connect(timer, &QTimer::timeout, q, [this, serial, attempt = 0]() mutable {
-        ++attempt;
-        if (attempt == 1) {
-            Q_EMIT q->pingDelayed(serial);
-            return;
-        }
-        Q_EMIT q->pingTimeout(serial);
-        delete pings.take(serial);
+    static constexpr std::chrono::milliseconds interval(1000);
+    TimerWheel *wheel = &DisplayPrivate::get(display)->timerWheel;
+
+    auto timer = new TimerWheel::Timer;
+    timer->setCallback([this, serial, timer, wheel]() {
+        Q_EMIT q->pingDelayed(serial);
+        timer->setCallback([this, serial]() {
+            Q_EMIT q->pingTimeout(serial);
+            delete pings.take(serial);
+        });
+        timer->start(wheel, interval);
     });
     pings.insert(serial, timer);
-    timer->start();
+    timer->start(wheel, interval);
 }
 
 XdgShellInterfacePrivate *XdgShellInterfacePrivate::get(XdgShellInterface *shell)
@@ -102,9 +104,7 @@ void XdgShellInterfacePrivate::xdg_wm_base_get_xdg_surface(Resource *resource, u
 void XdgShellInterfacePrivate::xdg_wm_base_pong(Resource *resource, uint32_t serial)
 {
     Q_UNUSED(resource)
-    if (QTimer *timer = pings.take(serial)) {
-        delete timer;
-    }
+    delete pings.take(serial);
     Q_EMIT q->pongReceived(serial);
 }
 
@@ -118,6 +118,7 @@ XdgShellInterface::XdgShellInterface(Display *display, QObject *parent)
 
 XdgShellInterface::~XdgShellInterface()
 {
+    qDeleteAll(d->pings);
 }
 
 Display *XdgShellInterface::display() const
@@ -323,7 +324,11 @@ void XdgToplevelInterfacePrivate::commit()
         return;
     }
 
+    const bool acknowledged = xdgSurfacePrivate->next.acknowledgedConfigureIsSet;
     xdgSurfacePrivate->commit();
+    if (acknowledged) {
+        handleConfigureAcknowledged(xdgSurfacePrivate->current.acknowledgedConfigure);
+    }
 
     if (current.minimumSize != next.minimumSize) {
         current.minimumSize = next.minimumSize;
@@ -346,9 +351,51 @@ void XdgToplevelInterfacePrivate::reset()
 
     windowTitle = QString();
     windowClass = QString();
+    encodedWindowTitle.clear();
+    encodedWindowClass.clear();
     current = next = State();
+    sentConfigures.clear();
+    pendingConfigure.reset();
+    const bool wasResizing = q->isResizing();
+    acknowledgedConfigure.reset();
 
     Q_EMIT q->resetOccurred();
+    if (wasResizing) {
+        Q_EMIT q->resizingChanged(false);
+    }
+}
+
+static bool isSerialAtLeast(quint32 serial, quint32 reference)
+{
+    // serials wrap around
+    return qint32(serial - reference) >= 0;
+}
+
+void XdgToplevelInterfacePrivate::handleConfigureAcknowledged(quint32 serial)
+{
+    auto it = sentConfigures.begin();
+    while (it != sentConfigures.end() && isSerialAtLeast(serial, it->serial)) {
+        ++it;
+    }
+    if (it == sentConfigures.begin()) {
+        return;
+    }
+    const SentConfigure acknowledged = *(it - 1);
+    sentConfigures.erase(sentConfigures.begin(), it);
+    const bool wasResizing = q->isResizing();
+    acknowledgedConfigure = acknowledged;
+
+    configureLatency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - acknowledged.timestamp);
+    Q_EMIT q->configureLatencyReported(acknowledged.serial, configureLatency);
+    if (wasResizing != q->isResizing()) {
+        Q_EMIT q->resizingChanged(!wasResizing);
+    }
+
+    if (pendingConfigure && sentConfigures.isEmpty()) {
+        const PendingConfigure configure = *pendingConfigure;
+        pendingConfigure.reset();
+        sendConfigure(configure.size, configure.states, configure.serial);
+    }
 }
 
 void XdgToplevelInterfacePrivate::xdg_toplevel_destroy_resource(Resource *resource)
@@ -374,24 +421,27 @@ void XdgToplevelInterfacePrivate::xdg_toplevel_set_parent(Resource *resource, ::
     Q_EMIT q->parentXdgToplevelChanged();
 }
 
-void XdgToplevelInterfacePrivate::xdg_toplevel_set_title(Resource *resource, const QString &title)
+void XdgToplevelInterfacePrivate::xdg_toplevel_set_title_utf8(Resource *resource, const char *title)
 {
     Q_UNUSED(resource)
-    if (windowTitle == title) {
+    // compare the raw bytes, an unchanged title is not converted to a QString
+    if (encodedWindowTitle == title) {
         return;
     }
-    windowTitle = title;
-    Q_EMIT q->windowTitleChanged(title);
+    encodedWindowTitle = title;
+    windowTitle = QString::fromUtf8(encodedWindowTitle);
+    Q_EMIT q->windowTitleChanged(windowTitle);
 }
 
-void XdgToplevelInterfacePrivate::xdg_toplevel_set_app_id(Resource *resource, const QString &app_id)
+void XdgToplevelInterfacePrivate::xdg_toplevel_set_app_id_utf8(Resource *resource, const char *app_id)
 {
     Q_UNUSED(resource)
-    if (windowClass == app_id) {
+    if (encodedWindowClass == app_id) {
         return;
     }
-    windowClass = app_id;
-    Q_EMIT q->windowClassChanged(app_id);
+    encodedWindowClass = app_id;
+    windowClass = QString::fromUtf8(encodedWindowClass);
+    Q_EMIT q->windowClassChanged(windowClass);
 }
 
 void XdgToplevelInterfacePrivate::xdg_toplevel_show_window_menu(Resource *resource, ::wl_resource *seatResource, uint32_t serial, int32_t x, int32_t y)
@@ -549,6 +599,78 @@ QSize XdgToplevelInterface::maximumSize() const
 
 quint32 XdgToplevelInterface::sendConfigure(const QSize &size, const States &states)
 {
+    const quint32 serial = xdgSurface()->shell()->display()->nextSerial();
+    if (d->coalesceConfigures && !d->sentConfigures.isEmpty()) {
+        d->pendingConfigure = XdgToplevelInterfacePrivate::PendingConfigure{size, states, serial};
+        return serial;
+    }
+    d->sendConfigure(size, states, serial);
+    return serial;
+}
+
+void XdgToplevelInterface::setConfigureCoalescing(bool coalesce)
+{
+    if (d->coalesceConfigures == coalesce) {
+        return;
+    }
+    d->coalesceConfigures = coalesce;
+    if (!coalesce && d->pendingConfigure) {
+        const XdgToplevelInterfacePrivate::PendingConfigure configure = *d->pendingConfigure;
+        d->pendingConfigure.reset();
+        d->sendConfigure(configure.size, configure.states, configure.serial);
+    }
+}
+
+bool XdgToplevelInterface::coalescesConfigures() const
+{
+    return d->coalesceConfigures;
+}
+
+std::chrono::microseconds XdgToplevelInterface::lastConfigureLatency() const
+{
+    return d->configureLatency;
+}
+
+quint32 XdgToplevelInterface::acknowledgedConfigure() const
+{
+    return d->acknowledgedConfigure ? d->acknowledgedConfigure->serial : 0;
+}
+
+QSize XdgToplevelInterface::acknowledgedSize() const
+{
+    return d->acknowledgedConfigure ? d->acknowledgedConfigure->size : QSize();
+}
+
+XdgToplevelInterface::States XdgToplevelInterface::acknowledgedStates() const
+{
+    return d->acknowledgedConfigure ? d->acknowledgedConfigure->states : States();
+}
+
+bool XdgToplevelInterface::isResizing() const
+{
+    return acknowledgedStates() & State::Resizing;
+}
+
+bool XdgToplevelInterface::isConfigurePending() const
+{
+    return d->pendingConfigure || !d->sentConfigures.isEmpty();
+}
+
+QSize XdgToplevelInterface::pendingSize() const
+{
+    if (d->pendingConfigure) {
+        return d->pendingConfigure->size;
+    }
+    if (!d->sentConfigures.isEmpty()) {
+        return d->sentConfigures.last().size;
+    }
+    return acknowledgedSize();
+}
+
+void XdgToplevelInterfacePrivate::sendConfigure(const QSize &size, XdgToplevelInterface::States states, quint32 serial)
+{
+    using State = XdgToplevelInterface::State;
+
     // Note that the states listed in the configure event must be an array of uint32_t.
 
     uint32_t statesData[8] = {0};
@@ -567,7 +689,7 @@ quint32 XdgToplevelInterface::sendConfigure(const QSize &size, const States &sta
         statesData[i++] = QtWaylandServer::xdg_toplevel::state_activated;
     }
 
-    if (d->resource()->version() >= XDG_TOPLEVEL_STATE_TILED_LEFT_SINCE_VERSION) {
+    if (resource()->version() >= XDG_TOPLEVEL_STATE_TILED_LEFT_SINCE_VERSION) {
         if (states & State::TiledLeft) {
             statesData[i++] = QtWaylandServer::xdg_toplevel::state_tiled_left;
         }
@@ -583,15 +705,18 @@ quint32 XdgToplevelInterface::sendConfigure(const QSize &size, const States &sta
     }
 
     const QByteArray xdgStates = QByteArray::fromRawData(reinterpret_cast<char *>(statesData), sizeof(uint32_t) * i);
-    const quint32 serial = xdgSurface()->shell()->display()->nextSerial();
 
-    d->send_configure(size.width(), size.height(), xdgStates);
+    send_configure(size.width(), size.height(), xdgStates);
 
-    auto xdgSurfacePrivate = XdgSurfaceInterfacePrivate::get(xdgSurface());
+    auto xdgSurfacePrivate = XdgSurfaceInterfacePrivate::get(xdgSurface);
     xdgSurfacePrivate->send_configure(serial);
     xdgSurfacePrivate->isConfigured = true;
 
-    return serial;
+    // a client that never acknowledges anything must not make the list grow forever
+    if (sentConfigures.count() >= 64) {
+        sentConfigures.removeFirst();
+    }
+    sentConfigures.append(SentConfigure{serial, size, states, std::chrono::steady_clock::now()});
 }
 
 void XdgToplevelInterface::sendClose()
@@ -755,6 +880,14 @@ XdgPositionerPrivate::XdgPositionerPrivate(::wl_resource *resource)
     init(resource);
 }
 
+struct XdgPositionerResource : QtWaylandServer::xdg_positioner::Resource, SlabAllocated<XdgPositionerResource> {
+};
+
+XdgPositionerPrivate::Resource *XdgPositionerPrivate::xdg_positioner_allocate()
+{
+    return new XdgPositionerResource;
+}
+
 XdgPositionerPrivate *XdgPositionerPrivate::get(wl_resource *resource)
 {
     return resource_cast<XdgPositionerPrivate *>(resource);
@@ -1010,6 +1143,176 @@ quint32 XdgPositioner::parentConfigure() const
     return d->parentConfigure;
 }
 
+// The position of the anchor point on the anchor rect, or of the popup relative to it
+static QPoint anchorPoint(const QRect &rect, Qt::Edges edges)
+{
+    const int x = edges & Qt::LeftEdge ? rect.left() : (edges & Qt::RightEdge ? rect.x() + rect.width() : rect.center().x());
+    const int y = edges & Qt::TopEdge ? rect.top() : (edges & Qt::BottomEdge ? rect.y() + rect.height() : rect.center().y());
+    return QPoint(x, y);
+}
+
+static QRect unconstrainedPlacement(const XdgPositionerData &data, Qt::Edges anchorEdges, Qt::Edges gravityEdges)
+{
+    const QPoint anchor = anchorPoint(data.anchorRect, anchorEdges);
+    QRect rect(QPoint(), data.size);
+    if (gravityEdges & Qt::LeftEdge) {
+        rect.moveRight(anchor.x() - 1);
+    } else if (gravityEdges & Qt::RightEdge) {
+        rect.moveLeft(anchor.x());
+    } else {
+        rect.moveLeft(anchor.x() - rect.width() / 2);
+    }
+    if (gravityEdges & Qt::TopEdge) {
+        rect.moveBottom(anchor.y() - 1);
+    } else if (gravityEdges & Qt::BottomEdge) {
+        rect.moveTop(anchor.y());
+    } else {
+        rect.moveTop(anchor.y() - rect.height() / 2);
+    }
+    return rect.translated(data.offset);
+}
+
+static Qt::Edges flipped(Qt::Edges edges, Qt::Orientation orientation)
+{
+    const Qt::Edges first = orientation == Qt::Horizontal ? Qt::LeftEdge : Qt::TopEdge;
+    const Qt::Edges second = orientation == Qt::Horizontal ? Qt::RightEdge : Qt::BottomEdge;
+    Qt::Edges result = edges & ~(first | second);
+    if (edges & first) {
+        result |= second;
+    }
+    if (edges & second) {
+        result |= first;
+    }
+    return result;
+}
+
+static bool isConstrained(const QRect &rect, const QRect &bounds, Qt::Orientation orientation)
+{
+    if (orientation == Qt::Horizontal) {
+        return rect.left() < bounds.left() || rect.right() > bounds.right();
+    }
+    return rect.top() < bounds.top() || rect.bottom() > bounds.bottom();
+}
+
+static QRect solvePlacement(const XdgPositionerData &data, const QRect &bounds)
+{
+    Qt::Edges anchorEdges = data.anchorEdges;
+    Qt::Edges gravityEdges = data.gravityEdges;
+    QRect rect = unconstrainedPlacement(data, anchorEdges, gravityEdges);
+    if (!bounds.isValid()) {
+        return rect;
+    }
+
+    for (const Qt::Orientation orientation : {Qt::Horizontal, Qt::Vertical}) {
+        if (!isConstrained(rect, bounds, orientation)) {
+            continue;
+        }
+        // the flip is only kept if the flipped popup fits, the other orientation stays as is
+        if (data.flipConstraintAdjustments & orientation) {
+            const Qt::Edges flippedAnchorEdges = flipped(anchorEdges, orientation);
+            const Qt::Edges flippedGravityEdges = flipped(gravityEdges, orientation);
+            const QRect flippedRect = unconstrainedPlacement(data, flippedAnchorEdges, flippedGravityEdges);
+            if (!isConstrained(flippedRect, bounds, orientation)) {
+                anchorEdges = flippedAnchorEdges;
+                gravityEdges = flippedGravityEdges;
+                if (orientation == Qt::Horizontal) {
+                    rect.moveLeft(flippedRect.left());
+                } else {
+                    rect.moveTop(flippedRect.top());
+                }
+                continue;
+            }
+        }
+        if (data.slideConstraintAdjustments & orientation) {
+            // if the popup is larger than the bounds, its top left corner is kept visible
+            if (orientation == Qt::Horizontal) {
+                if (rect.right() > bounds.right()) {
+                    rect.moveRight(bounds.right());
+                }
+                if (rect.left() < bounds.left()) {
+                    rect.moveLeft(bounds.left());
+                }
+            } else {
+                if (rect.bottom() > bounds.bottom()) {
+                    rect.moveBottom(bounds.bottom());
+                }
+                if (rect.top() < bounds.top()) {
+                    rect.moveTop(bounds.top());
+                }
+            }
+            if (!isConstrained(rect, bounds, orientation)) {
+                continue;
+            }
+        }
+        if (data.resizeConstraintAdjustments & orientation) {
+            if (orientation == Qt::Horizontal) {
+                rect.setLeft(std::max(rect.left(), bounds.left()));
+                rect.setRight(std::min(rect.right(), bounds.right()));
+            } else {
+                rect.setTop(std::max(rect.top(), bounds.top()));
+                rect.setBottom(std::min(rect.bottom(), bounds.bottom()));
+            }
+        }
+    }
+    return rect;
+}
+
+namespace
+{
+// The inputs and the result of a placement, the placements are kept in a small ring
+struct PlacementEntry {
+    bool matches(const XdgPositionerData &data, const QRect &bounds) const
+    {
+        return valid && this->bounds == bounds && size == data.size && anchorRect == data.anchorRect && offset == data.offset
+            && anchorEdges == data.anchorEdges && gravityEdges == data.gravityEdges && slide == data.slideConstraintAdjustments
+            && flip == data.flipConstraintAdjustments && resize == data.resizeConstraintAdjustments;
+    }
+
+    bool valid = false;
+    QRect bounds;
+    QSize size;
+    QRect anchorRect;
+    QPoint offset;
+    Qt::Edges anchorEdges;
+    Qt::Edges gravityEdges;
+    Qt::Orientations slide;
+    Qt::Orientations flip;
+    Qt::Orientations resize;
+    QRect placement;
+};
+
+struct PlacementCache {
+    static constexpr int s_size = 16;
+    PlacementEntry entries[s_size];
+    int next = 0;
+};
+}
+
+QRect XdgPositioner::placement(const QRect &bounds) const
+{
+    thread_local PlacementCache cache;
+    for (const PlacementEntry &entry : cache.entries) {
+        if (entry.matches(*d, bounds)) {
+            return entry.placement;
+        }
+    }
+
+    PlacementEntry &entry = cache.entries[cache.next];
+    cache.next = (cache.next + 1) % PlacementCache::s_size;
+    entry.valid = true;
+    entry.bounds = bounds;
+    entry.size = d->size;
+    entry.anchorRect = d->anchorRect;
+    entry.offset = d->offset;
+    entry.anchorEdges = d->anchorEdges;
+    entry.gravityEdges = d->gravityEdges;
+    entry.slide = d->slideConstraintAdjustments;
+    entry.flip = d->flipConstraintAdjustments;
+    entry.resize = d->resizeConstraintAdjustments;
+    entry.placement = solvePlacement(*d, bounds);
+    return entry.placement;
+}
+
 XdgPositioner XdgPositioner::get(::wl_resource *resource)
 {
     XdgPositionerPrivate *xdgPositionerPrivate = XdgPositionerPrivate::get(resource);
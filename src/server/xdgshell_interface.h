@@ -11,6 +11,8 @@
 #include <QObject>
 #include <QSharedDataPointer>
 
+#include <chrono>
+
 struct wl_resource;
 
 namespace KWaylandServer
@@ -285,6 +287,63 @@ public:
      */
     quint32 sendConfigure(const QSize &size, const States &states);
 
+    /**
+     * Sets whether configure events are coalesced. If enabled, at most one configure event is
+     * waiting for the client to acknowledge it. While it is outstanding, sendConfigure() only
+     * records the new size and states and returns the serial they will be sent with, the latest
+     * of them is sent once the client commits the acknowledgement of the outstanding configure.
+     *
+     * Serials of configure events that got replaced by a later one are never acknowledged on
+     * their own; acknowledging a later serial supersedes them. This is useful during interactive
+     * resizing, where a configure event is requested for every pointer motion.
+     *
+     * Configure events are not coalesced by default.
+     */
+    void setConfigureCoalescing(bool coalesce);
+    bool coalescesConfigures() const;
+
+    /**
+     * Returns the time between sending the most recently acknowledged configure event and the
+     * commit that acknowledged it, or zero if no configure event has been acknowledged yet.
+     *
+     * @see configureLatencyReported
+     */
+    std::chrono::microseconds lastConfigureLatency() const;
+
+    /**
+     * Returns the serial of the configure event the client has most recently committed the
+     * acknowledgement of, or zero if it hasn't acknowledged any configure event yet.
+     */
+    quint32 acknowledgedConfigure() const;
+    /**
+     * Returns the size of the configure event with the serial acknowledgedConfigure(), i.e.
+     * the size the committed buffers are meant for. A size of zero means the client decides.
+     */
+    QSize acknowledgedSize() const;
+    /**
+     * Returns the states of the configure event with the serial acknowledgedConfigure().
+     */
+    States acknowledgedStates() const;
+    /**
+     * Returns \c true if the acknowledged configure event has the Resizing state, i.e. the
+     * client is in an interactive resize and the window size changes continuously. Decoration
+     * renderers can use a cheap way to stretch the decoration until the resize ends and redraw
+     * it afterwards.
+     *
+     * @see resizingChanged
+     */
+    bool isResizing() const;
+    /**
+     * Returns \c true if a configure event has been sent or coalesced and the client hasn't
+     * committed its acknowledgement yet.
+     */
+    bool isConfigurePending() const;
+    /**
+     * Returns the size of the most recent configure event, whether it has been sent or is
+     * coalesced, or acknowledgedSize() if no configure event is pending.
+     */
+    QSize pendingSize() const;
+
     /**
      * Sends a close event to the client. The client may choose to ignore this request.
      */
@@ -312,6 +371,20 @@ Q_SIGNALS:
      */
     void resetOccurred();
 
+    /**
+     * This signal is emitted when the client has committed the acknowledgement of the configure
+     * event with serial \a serial. \a latency is the time since the configure event was sent.
+     */
+    void configureLatencyReported(quint32 serial, std::chrono::microseconds latency);
+
+    /**
+     * This signal is emitted when the client has committed the acknowledgement of a configure
+     * event that starts or ends an interactive resize, or the toplevel got reset during one.
+     *
+     * @see isResizing
+     */
+    void resizingChanged(bool resizing);
+
     /**
      * This signal is emitted when the toplevel's title has been changed.
      */
@@ -481,6 +554,17 @@ public:
      */
     quint32 parentConfigure() const;
 
+    /**
+     * Returns the geometry of the popup relative to the window geometry of the parent surface,
+     * with the flip, slide and resize constraint adjustments applied to keep it inside
+     * \a bounds, e.g. the work area of the output in the coordinates of the parent surface.
+     *
+     * The placement only depends on the state of the positioner and \a bounds. The results
+     * of the latest placements are cached, so solving the same positioner again, e.g. on
+     * every reposition of a menu, is cheap.
+     */
+    QRect placement(const QRect &bounds) const;
+
     /**
      * Returns the current state of the xdg positioner object identified by \a resource.
      */
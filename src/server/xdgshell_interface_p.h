@@ -9,8 +9,15 @@
 #include "qwayland-server-xdg-shell.h"
 #include "xdgshell_interface.h"
 
+#include "slaballocator_p.h"
 #include "surface_interface.h"
 #include "surfacerole_p.h"
+#include "timerwheel.h"
+
+#include <QVector>
+
+#include <chrono>
+#include <optional>
 
 namespace KWaylandServer
 {
@@ -32,7 +39,7 @@ public:
 
     XdgShellInterface *q;
     Display *display;
-    QMap<quint32, QTimer *> pings;
+    QMap<quint32, TimerWheel::Timer *> pings;
 
 protected:
     void xdg_wm_base_destroy(Resource *resource) override;
@@ -60,7 +67,7 @@ public:
     quint32 parentConfigure;
 };
 
-class XdgPositionerPrivate : public QtWaylandServer::xdg_positioner
+class XdgPositionerPrivate : public QtWaylandServer::xdg_positioner, public SlabAllocated<XdgPositionerPrivate>
 {
 public:
     XdgPositionerPrivate(::wl_resource *resource);
@@ -70,6 +77,7 @@ public:
     static XdgPositionerPrivate *get(::wl_resource *resource);
 
 protected:
+    Resource *xdg_positioner_allocate() override;
     void xdg_positioner_destroy_resource(Resource *resource) override;
     void xdg_positioner_destroy(Resource *resource) override;
     void xdg_positioner_set_size(Resource *resource, int32_t width, int32_t height) override;
@@ -128,6 +136,9 @@ public:
     void commit() override;
     void reset();
 
+    void sendConfigure(const QSize &size, XdgToplevelInterface::States states, quint32 serial);
+    void handleConfigureAcknowledged(quint32 serial);
+
     static XdgToplevelInterfacePrivate *get(XdgToplevelInterface *toplevel);
     static XdgToplevelInterfacePrivate *get(::wl_resource *resource);
 
@@ -138,6 +149,9 @@ public:
 
     QString windowTitle;
     QString windowClass;
+    // as sent by the client, clients tend to set the same title over and over again
+    QByteArray encodedWindowTitle;
+    QByteArray encodedWindowClass;
 
     struct State {
         QSize minimumSize;
@@ -147,12 +161,32 @@ public:
     State next;
     State current;
 
+    struct SentConfigure {
+        quint32 serial;
+        QSize size;
+        XdgToplevelInterface::States states;
+        std::chrono::steady_clock::time_point timestamp;
+    };
+    struct PendingConfigure {
+        QSize size;
+        XdgToplevelInterface::States states;
+        quint32 serial;
+    };
+
+    // configure events that have been sent but not acknowledged yet, oldest first
+    QVector<SentConfigure> sentConfigures;
+    std::optional<PendingConfigure> pendingConfigure;
+    // the configure event the client has committed the acknowledgement of last
+    std::optional<SentConfigure> acknowledgedConfigure;
+    std::chrono::microseconds configureLatency = std::chrono::microseconds::zero();
+    bool coalesceConfigures = false;
+
 protected:
     void xdg_toplevel_destroy_resource(Resource *resource) override;
     void xdg_toplevel_destroy(Resource *resource) override;
     void xdg_toplevel_set_parent(Resource *resource, ::wl_resource *parent) override;
-    void xdg_toplevel_set_title(Resource *resource, const QString &title) override;
-    void xdg_toplevel_set_app_id(Resource *resource, const QString &app_id) override;
+    void xdg_toplevel_set_title_utf8(Resource *resource, const char *title) override;
+    void xdg_toplevel_set_app_id_utf8(Resource *resource, const char *app_id) override;
     void xdg_toplevel_show_window_menu(Resource *resource, ::wl_resource *seat, uint32_t serial, int32_t x, int32_t y) override;
     void xdg_toplevel_move(Resource *resource, ::wl_resource *seat, uint32_t serial) override;
     void xdg_toplevel_resize(Resource *resource, ::wl_resource *seat, uint32_t serial, uint32_t edges) override;
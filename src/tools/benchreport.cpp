@@ -0,0 +1,298 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cmath>
+
+// Converts the XML written by QtTest benchmarks (-o file.xml,xml) into a JSON document
+// with the environment the benchmarks ran in, and compares two such documents:
+//
+// {
+//     "schema": "dwayland-benchmark-results",
+//     "version": 1,
+//     "environment": { "cpu": ..., "cpuCount": ..., "kernel": ..., "qt": ...,
+//                      "libwayland": ..., "buildType": ..., "dwayland": ..., "date": ... },
+//     "results": [ { "benchmark": "BenchGlobals::benchStartup", "tag": "",
+//                    "metric": "WalltimeMilliseconds", "value": 0.42, "iterations": 256 } ]
+// }
+//
+// The value is the result of a single iteration. Every QtTest metric is better when lower.
+
+static const QString s_schema = QStringLiteral("dwayland-benchmark-results");
+static const int s_schemaVersion = 1;
+
+struct Result {
+    QString benchmark;
+    QString tag;
+    QString metric;
+    double value = 0;
+    int iterations = 0;
+
+    QString key() const
+    {
+        QString key = benchmark;
+        if (!tag.isEmpty()) {
+            key += QLatin1Char('(') + tag + QLatin1Char(')');
+        }
+        return key + QLatin1Char(' ') + metric;
+    }
+};
+
+static QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static QTextStream &err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+static QString cpuModel()
+{
+    QFile cpuInfo(QStringLiteral("/proc/cpuinfo"));
+    if (!cpuInfo.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QSysInfo::currentCpuArchitecture();
+    }
+    while (!cpuInfo.atEnd()) {
+        const QByteArray line = cpuInfo.readLine();
+        if (line.startsWith("model name")) {
+            return QString::fromUtf8(line.mid(line.indexOf(':') + 1).trimmed());
+        }
+    }
+    return QSysInfo::currentCpuArchitecture();
+}
+
+static bool readQtTestXml(const QString &fileName, QVector<Result> &results)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        err() << "Cannot open " << fileName << ": " << file.errorString() << Qt::endl;
+        return false;
+    }
+    QXmlStreamReader xml(&file);
+    QString testCase;
+    QString testFunction;
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QLatin1String("TestCase")) {
+            testCase = attributes.value(QLatin1String("name")).toString();
+        } else if (xml.name() == QLatin1String("TestFunction")) {
+            testFunction = attributes.value(QLatin1String("name")).toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            Result result;
+            result.benchmark = testCase + QLatin1String("::") + testFunction;
+            result.tag = attributes.value(QLatin1String("tag")).toString();
+            result.metric = attributes.value(QLatin1String("metric")).toString();
+            result.iterations = qMax(1, attributes.value(QLatin1String("iterations")).toInt());
+            // QtTest writes the total over all iterations
+            result.value = attributes.value(QLatin1String("value")).toDouble() / result.iterations;
+            results.append(result);
+        }
+    }
+    if (xml.hasError()) {
+        err() << "Cannot parse " << fileName << ": " << xml.errorString() << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool readResults(const QString &fileName, QJsonObject &environment, QMap<QString, Result> &results)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        err() << "Cannot open " << fileName << ": " << file.errorString() << Qt::endl;
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonObject document = QJsonDocument::fromJson(file.readAll(), &error).object();
+    if (error.error != QJsonParseError::NoError) {
+        err() << "Cannot parse " << fileName << ": " << error.errorString() << Qt::endl;
+        return false;
+    }
+    if (document.value(QLatin1String("schema")).toString() != s_schema || document.value(QLatin1String("version")).toInt() != s_schemaVersion) {
+        err() << fileName << " is not a version " << s_schemaVersion << " benchmark result file" << Qt::endl;
+        return false;
+    }
+    environment = document.value(QLatin1String("environment")).toObject();
+    const QJsonArray entries = document.value(QLatin1String("results")).toArray();
+    for (const QJsonValue &entry : entries) {
+        const QJsonObject object = entry.toObject();
+        Result result;
+        result.benchmark = object.value(QLatin1String("benchmark")).toString();
+        result.tag = object.value(QLatin1String("tag")).toString();
+        result.metric = object.value(QLatin1String("metric")).toString();
+        result.value = object.value(QLatin1String("value")).toDouble();
+        result.iterations = object.value(QLatin1String("iterations")).toInt();
+        results.insert(result.key(), result);
+    }
+    return true;
+}
+
+static int convert(const QCommandLineParser &parser)
+{
+    const QStringList inputs = parser.positionalArguments().mid(1);
+    if (inputs.isEmpty()) {
+        err() << "No QtTest XML files given" << Qt::endl;
+        return 2;
+    }
+    QVector<Result> results;
+    for (const QString &input : inputs) {
+        if (!readQtTestXml(input, results)) {
+            return 2;
+        }
+    }
+    // sorted, so that two result files can be diffed as text as well
+    std::sort(results.begin(), results.end(), [](const Result &a, const Result &b) {
+        return a.key() < b.key();
+    });
+
+    QJsonObject environment;
+    environment.insert(QStringLiteral("cpu"), cpuModel());
+    environment.insert(QStringLiteral("cpuCount"), QThread::idealThreadCount());
+    environment.insert(QStringLiteral("kernel"), QSysInfo::kernelVersion());
+    environment.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+    environment.insert(QStringLiteral("libwayland"), parser.value(QStringLiteral("libwayland-version")));
+    environment.insert(QStringLiteral("buildType"), parser.value(QStringLiteral("build-type")));
+    environment.insert(QStringLiteral("dwayland"), parser.value(QStringLiteral("dwayland-version")));
+    environment.insert(QStringLiteral("date"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+
+    QJsonArray entries;
+    for (const Result &result : qAsConst(results)) {
+        entries.append(QJsonObject{
+            {QStringLiteral("benchmark"), result.benchmark},
+            {QStringLiteral("tag"), result.tag},
+            {QStringLiteral("metric"), result.metric},
+            {QStringLiteral("value"), result.value},
+            {QStringLiteral("iterations"), result.iterations},
+        });
+    }
+    const QJsonObject document{
+        {QStringLiteral("schema"), s_schema},
+        {QStringLiteral("version"), s_schemaVersion},
+        {QStringLiteral("environment"), environment},
+        {QStringLiteral("results"), entries},
+    };
+
+    const QString output = parser.value(QStringLiteral("output"));
+    QFile file;
+    if (output.isEmpty()) {
+        file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err() << "Cannot write " << output << ": " << file.errorString() << Qt::endl;
+            return 2;
+        }
+    }
+    file.write(QJsonDocument(document).toJson());
+    return 0;
+}
+
+static int compare(const QCommandLineParser &parser)
+{
+    const QStringList files = parser.positionalArguments().mid(1);
+    if (files.count() != 2) {
+        err() << "compare needs a baseline and a result file" << Qt::endl;
+        return 2;
+    }
+    bool ok = false;
+    const double threshold = parser.value(QStringLiteral("threshold")).toDouble(&ok);
+    if (!ok || threshold < 0) {
+        err() << "Invalid threshold: " << parser.value(QStringLiteral("threshold")) << Qt::endl;
+        return 2;
+    }
+
+    QJsonObject baselineEnvironment;
+    QJsonObject currentEnvironment;
+    QMap<QString, Result> baseline;
+    QMap<QString, Result> current;
+    if (!readResults(files[0], baselineEnvironment, baseline) || !readResults(files[1], currentEnvironment, current)) {
+        return 2;
+    }
+
+    // results of different machines or builds are not comparable, but still get compared
+    for (const char *field : {"cpu", "buildType", "libwayland", "qt"}) {
+        const QString key = QString::fromLatin1(field);
+        if (baselineEnvironment.value(key) != currentEnvironment.value(key)) {
+            out() << "note: " << key << " differs: " << baselineEnvironment.value(key).toVariant().toString() << " -> "
+                  << currentEnvironment.value(key).toVariant().toString() << Qt::endl;
+        }
+    }
+
+    int regressions = 0;
+    for (auto it = baseline.constBegin(); it != baseline.constEnd(); ++it) {
+        const auto currentIt = current.constFind(it.key());
+        if (currentIt == current.constEnd()) {
+            out() << "missing     " << it.key() << Qt::endl;
+            continue;
+        }
+        const double before = it->value;
+        const double after = currentIt->value;
+        const double change = before == 0 ? (after == 0 ? 0 : INFINITY) : (after - before) / before * 100;
+        const char *verdict = "            ";
+        if (change > threshold) {
+            verdict = "REGRESSION  ";
+            ++regressions;
+        } else if (change < -threshold) {
+            verdict = "improved    ";
+        }
+        out() << verdict << it.key() << ": " << before << " -> " << after << " (" << (change >= 0 ? "+" : "") << QString::number(change, 'f', 1)
+              << "%)" << Qt::endl;
+    }
+    for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+        if (!baseline.contains(it.key())) {
+            out() << "new         " << it.key() << ": " << it->value << Qt::endl;
+        }
+    }
+    out() << regressions << " regression(s) beyond " << threshold << "%" << Qt::endl;
+    return regressions > 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Converts and compares the results of the DWayland benchmarks"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("command"),
+                                 QStringLiteral("convert <qtest.xml>... : writes the results of the benchmarks as JSON\n"
+                                                "compare <baseline.json> <results.json> : exits with 1 on regressions"));
+    parser.addOptions({
+        {{QStringLiteral("o"), QStringLiteral("output")}, QStringLiteral("The JSON file to write, stdout by default."), QStringLiteral("file")},
+        {QStringLiteral("build-type"), QStringLiteral("The build type of the benchmarks."), QStringLiteral("type")},
+        {QStringLiteral("libwayland-version"), QStringLiteral("The version of libwayland the benchmarks use."), QStringLiteral("version")},
+        {QStringLiteral("dwayland-version"), QStringLiteral("The version of DWayland the benchmarks use."), QStringLiteral("version")},
+        {QStringLiteral("threshold"), QStringLiteral("The slowdown in percent reported as a regression."), QStringLiteral("percent"), QStringLiteral("5")},
+    });
+    parser.process(app);
+
+    const QString command = parser.positionalArguments().value(0);
+    if (command == QLatin1String("convert")) {
+        return convert(parser);
+    }
+    if (command == QLatin1String("compare")) {
+        return compare(parser);
+    }
+    parser.showHelp(2);
+}
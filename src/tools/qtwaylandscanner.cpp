@@ -44,6 +44,7 @@ private:
         bool request;
         QByteArray name;
         QByteArray type;
+        int since;
         std::vector<WaylandArgument> arguments;
     };
 
@@ -68,8 +69,15 @@ private:
     QByteArray waylandToCType(const QByteArray &waylandType, const QByteArray &interface);
     QByteArray waylandToQtType(const QByteArray &waylandType, const QByteArray &interface, bool cStyleArray);
     const Scanner::WaylandArgument *newIdArgument(const std::vector<WaylandArgument> &arguments);
-
-    void printEvent(const WaylandEvent &e, bool omitNames = false, bool withResource = false);
+    bool hasUtf8Overload(const WaylandEvent &e);
+    bool hasStaticDispatch(const WaylandInterface &interface);
+    bool hasBroadcast(const WaylandEvent &e);
+    void printBroadcast(const WaylandEvent &e, const char *interfaceName);
+    void printSinceTable(const std::vector<WaylandEvent> &events);
+    void printVersionedEvent(const WaylandEvent &e);
+    WaylandEvent utf8Request(const WaylandEvent &e);
+
+    void printEvent(const WaylandEvent &e, bool omitNames = false, bool withResource = false, bool utf8Strings = false);
     void printEventHandlerSignature(const WaylandEvent &e, const char *interfaceName, bool deepIndent = true);
     void printEnums(const std::vector<WaylandEnum> &enums);
 
@@ -89,6 +97,10 @@ private:
     QByteArray m_headerPath;
     QByteArray m_prefix;
     QVector <QByteArray> m_includes;
+    bool m_utf8Strings = false;
+    bool m_staticDispatch = false;
+    bool m_broadcast = false;
+    bool m_versionedEvents = false;
     QXmlStreamReader *m_xml = nullptr;
 };
 
@@ -115,16 +127,28 @@ bool Scanner::parseArguments(int argc, char **argv)
         // --header-path=<path> (14 characters)
         // --prefix=<prefix> (9 characters)
         // --add-include=<include> (14 characters)
+        // --utf8-strings
+        // --static-dispatch
+        // --broadcast
+        // --versioned-events
         for (int pos = 3; pos < argc; pos++) {
             const QByteArray &option = args[pos];
             if (option.startsWith("--header-path=")) {
                 m_headerPath = option.mid(14);
             } else if (option.startsWith("--prefix=")) {
-                m_prefix = option.mid(10);
+                m_prefix = option.mid(9);
             } else if (option.startsWith("--add-include=")) {
                 auto include = option.mid(14);
                 if (!include.isEmpty())
                     m_includes << include;
+            } else if (option == "--utf8-strings") {
+                m_utf8Strings = true;
+            } else if (option == "--static-dispatch") {
+                m_staticDispatch = true;
+            } else if (option == "--broadcast") {
+                m_broadcast = true;
+            } else if (option == "--versioned-events") {
+                m_versionedEvents = true;
             } else {
                 return false;
             }
@@ -136,7 +160,11 @@ bool Scanner::parseArguments(int argc, char **argv)
 
 void Scanner::printUsage()
 {
-    fprintf(stderr, "Usage: %s [client-header|server-header|client-code|server-code] specfile [--header-path=<path>] [--prefix=<prefix>] [--add-include=<include>]\n", m_scannerName.constData());
+    fprintf(stderr, "Usage: %s [client-header|server-header|client-code|server-code] specfile [--header-path=<path>] [--prefix=<prefix>] [--add-include=<include>] [--utf8-strings] [--static-dispatch] [--broadcast] [--versioned-events]\n", m_scannerName.constData());
+    fprintf(stderr, "    --utf8-strings: also generate server side requests and events passing strings as UTF-8 encoded const char *\n");
+    fprintf(stderr, "    --static-dispatch: dispatch server side requests with a generated switch instead of libffi\n");
+    fprintf(stderr, "    --broadcast: also generate server side events sent to all resources, the arguments are encoded once\n");
+    fprintf(stderr, "    --versioned-events: also generate the versions of the server side events and send functions dropping the events a version lacks at compile time\n");
 }
 
 bool Scanner::isServerSide()
@@ -185,6 +213,7 @@ Scanner::WaylandEvent Scanner::readEvent(QXmlStreamReader &xml, bool request)
         .request = request,
         .name = byteArrayValue(xml, "name"),
         .type = byteArrayValue(xml, "type"),
+        .since = intValue(xml, "since", 1),
         .arguments = {},
     };
     while (xml.readNextStartElement()) {
@@ -294,7 +323,128 @@ const Scanner::WaylandArgument *Scanner::newIdArgument(const std::vector<Wayland
     return nullptr;
 }
 
-void Scanner::printEvent(const WaylandEvent &e, bool omitNames, bool withResource)
+bool Scanner::hasUtf8Overload(const WaylandEvent &e)
+{
+    if (!m_utf8Strings || !isServerSide())
+        return false;
+    for (const WaylandArgument &a : e.arguments) {
+        if (a.type == "string")
+            return true;
+    }
+    return false;
+}
+
+bool Scanner::hasStaticDispatch(const WaylandInterface &interface)
+{
+    if (!m_staticDispatch || !isServerSide() || interface.requests.empty())
+        return false;
+    // a new_id without interface is sent as interface name, version and id, like in wl_registry.bind
+    for (const WaylandEvent &e : interface.requests) {
+        for (const WaylandArgument &a : e.arguments) {
+            if (a.type == "new_id" && a.interface.isEmpty())
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Scanner::hasBroadcast(const WaylandEvent &e)
+{
+    if (!m_broadcast || !isServerSide())
+        return false;
+    // every resource would need an object of its own
+    for (const WaylandArgument &a : e.arguments) {
+        if (a.type == "new_id")
+            return false;
+    }
+    return true;
+}
+
+void Scanner::printBroadcast(const WaylandEvent &e, const char *interfaceName)
+{
+    QByteArray arguments;
+    QByteArray names;
+    for (const WaylandArgument &a : e.arguments) {
+        const QByteArray qtType = waylandToQtType(a.type, a.interface, false);
+        arguments += ", " + qtType + (qtType.endsWith("&") || qtType.endsWith("*") ? "" : " ") + a.name;
+        names += ", " + a.name;
+    }
+
+    // sends the event to the resources accepted by the filter, with a version supporting it
+    printf("        template<typename Filter>\n");
+    printf("        void broadcast_%s(Filter broadcast_filter%s)\n", e.name.constData(), arguments.constData());
+    printf("        {\n");
+    for (const WaylandArgument &a : e.arguments) {
+        const char *name = a.name.constData();
+        if (a.type == "string") {
+            printf("            const QByteArray %s_utf8 = %s.toUtf8();\n", name, name);
+        } else if (a.type == "array") {
+            printf("            struct wl_array %s_data;\n", name);
+            printf("            %s_data.size = %s.size();\n", name, name);
+            printf("            %s_data.data = static_cast<void *>(const_cast<char *>(%s.constData()));\n", name, name);
+            printf("            %s_data.alloc = 0;\n", name);
+        }
+    }
+    printf("            for (Resource *broadcast_resource : qAsConst(m_resource_map)) {\n");
+    printf("                if (broadcast_resource->version() < %s_%s_SINCE_VERSION || !broadcast_filter(broadcast_resource))\n", QByteArray(interfaceName).toUpper().constData(), e.name.toUpper().constData());
+    printf("                    continue;\n");
+    printf("                %s_send_%s(\n", interfaceName, e.name.constData());
+    printf("                    broadcast_resource->handle");
+    for (const WaylandArgument &a : e.arguments) {
+        printf(",\n");
+        if (a.type == "string")
+            printf("                    %s_utf8.constData()", a.name.constData());
+        else if (a.type == "array")
+            printf("                    &%s_data", a.name.constData());
+        else
+            printf("                    %s", a.name.constData());
+    }
+    printf(");\n");
+    printf("            }\n");
+    printf("        }\n");
+
+    printf("        void broadcast_%s(%s)\n", e.name.constData(), arguments.mid(2).constData());
+    printf("        {\n");
+    printf("            broadcast_%s([](Resource *) { return true; }%s);\n", e.name.constData(), names.constData());
+    printf("        }\n");
+}
+
+void Scanner::printSinceTable(const std::vector<WaylandEvent> &events)
+{
+    // the protocol versions the events were added in
+    printf("\n");
+    for (const WaylandEvent &e : events)
+        printf("        static constexpr int since_%s = %d;\n", e.name.constData(), e.since);
+}
+
+void Scanner::printVersionedEvent(const WaylandEvent &e)
+{
+    // sends the event to a resource of the given version, the call is dropped at compile time
+    // if the version lacks the event, so resources grouped by version need no check per event
+    WaylandEvent versioned = e;
+    versioned.name = "send_versioned_" + e.name;
+    printf("        template<int version>\n");
+    printf("        void ");
+    printEvent(versioned, false, true);
+    printf("\n");
+    printf("        {\n");
+    printf("            if constexpr (version >= since_%s)\n", e.name.constData());
+    printf("                send_%s(resource", e.name.constData());
+    for (const WaylandArgument &a : e.arguments)
+        printf(", %s", a.name.constData());
+    printf(");\n");
+    printf("        }\n");
+}
+
+Scanner::WaylandEvent Scanner::utf8Request(const WaylandEvent &e)
+{
+    // a separate name, an overload of a virtual function would be hidden by overriding the other one
+    WaylandEvent request = e;
+    request.name += "_utf8";
+    return request;
+}
+
+void Scanner::printEvent(const WaylandEvent &e, bool omitNames, bool withResource, bool utf8Strings)
 {
     printf("%s(", e.name.constData());
     bool needsComma = false;
@@ -330,7 +480,7 @@ void Scanner::printEvent(const WaylandEvent &e, bool omitNames, bool withResourc
             }
         }
 
-        QByteArray qtType = waylandToQtType(a.type, a.interface, e.request == isServerSide());
+        QByteArray qtType = utf8Strings && a.type == "string" ? waylandToCType(a.type, a.interface) : waylandToQtType(a.type, a.interface, e.request == isServerSide());
         printf("%s%s%s", qtType.constData(), qtType.endsWith("&") || qtType.endsWith("*") ? "" : " ", omitNames ? "" : a.name.constData());
     }
     printf(")");
@@ -552,6 +702,9 @@ bool Scanner::process()
 
             bool hasEvents = !interface.events.empty();
 
+            if (hasEvents && m_versionedEvents)
+                printSinceTable(interface.events);
+
             if (hasEvents) {
                 printf("\n");
                 for (const WaylandEvent &e : interface.events) {
@@ -561,6 +714,18 @@ bool Scanner::process()
                     printf("        void send_");
                     printEvent(e, false, true);
                     printf(";\n");
+                    if (hasUtf8Overload(e)) {
+                        printf("        void send_");
+                        printEvent(e, false, false, true);
+                        printf(";\n");
+                        printf("        void send_");
+                        printEvent(e, false, true, true);
+                        printf(";\n");
+                    }
+                    if (hasBroadcast(e))
+                        printBroadcast(e, interfaceName);
+                    if (m_versionedEvents)
+                        printVersionedEvent(e);
                 }
             }
 
@@ -581,6 +746,11 @@ bool Scanner::process()
                     printf("        virtual void %s_", interfaceNameStripped);
                     printEvent(e);
                     printf(";\n");
+                    if (hasUtf8Overload(e)) {
+                        printf("        virtual void %s_", interfaceNameStripped);
+                        printEvent(utf8Request(e), false, false, true);
+                        printf(";\n");
+                    }
                 }
             }
 
@@ -605,6 +775,11 @@ bool Scanner::process()
                     printEventHandlerSignature(e, interfaceName);
                     printf(";\n");
                 }
+
+                if (hasStaticDispatch(interface)) {
+                    printf("\n");
+                    printf("        static int dispatch_func(const void *implementation, void *target, uint32_t opcode, const struct ::wl_message *message, union ::wl_argument *arguments);\n");
+                }
             }
 
             printf("\n");
@@ -863,7 +1038,10 @@ bool Scanner::process()
             printf("        Resource *resource = %s_allocate();\n", interfaceNameStripped);
             printf("        resource->%s_object = this;\n", interfaceNameStripped);
             printf("\n");
-            printf("        wl_resource_set_implementation(handle, %s, resource, destroy_func);", interfaceMember.constData());
+            if (hasStaticDispatch(interface))
+                printf("        wl_resource_set_dispatcher(handle, dispatch_func, %s, resource, destroy_func);", interfaceMember.constData());
+            else
+                printf("        wl_resource_set_implementation(handle, %s, resource, destroy_func);", interfaceMember.constData());
             printf("\n");
             printf("        resource->handle = handle;\n");
             printf("        %s_bind_resource(resource);\n", interfaceNameStripped);
@@ -900,6 +1078,25 @@ bool Scanner::process()
                     printf("\n");
                     printf("    {\n");
                     printf("    }\n");
+
+                    if (hasUtf8Overload(e)) {
+                        printf("\n");
+                        printf("    void %s::%s_", interfaceName, interfaceNameStripped);
+                        printEvent(utf8Request(e), false, false, true);
+                        printf("\n");
+                        printf("    {\n");
+                        printf("        %s_%s(\n", interfaceNameStripped, e.name.constData());
+                        printf("            resource");
+                        for (const WaylandArgument &a : e.arguments) {
+                            printf(",\n");
+                            if (a.type == "string")
+                                printf("            QString::fromUtf8(%s)", a.name.constData());
+                            else
+                                printf("            %s", a.name.constData());
+                        }
+                        printf(");\n");
+                        printf("    }\n");
+                    }
                 }
                 printf("\n");
 
@@ -922,14 +1119,15 @@ bool Scanner::process()
                         printf("            wl_resource_destroy(resource);\n");
                     printf("            return;\n");
                     printf("        }\n");
-                    printf("        static_cast<%s *>(r->%s_object)->%s_%s(\n", interfaceName, interfaceNameStripped, interfaceNameStripped, e.name.constData());
+                    const bool utf8 = hasUtf8Overload(e);
+                    printf("        static_cast<%s *>(r->%s_object)->%s_%s%s(\n", interfaceName, interfaceNameStripped, interfaceNameStripped, e.name.constData(), utf8 ? "_utf8" : "");
                     printf("            r");
                     for (const WaylandArgument &a : e.arguments) {
                         printf(",\n");
                         QByteArray cType = waylandToCType(a.type, a.interface);
                         QByteArray qtType = waylandToQtType(a.type, a.interface, e.request);
                         const char *argumentName = a.name.constData();
-                        if (cType == qtType)
+                        if (cType == qtType || (utf8 && a.type == "string"))
                             printf("            %s", argumentName);
                         else if (a.type == "string")
                             printf("            QString::fromUtf8(%s)", argumentName);
@@ -937,6 +1135,55 @@ bool Scanner::process()
                     printf(");\n");
                     printf("    }\n");
                 }
+
+                if (hasStaticDispatch(interface)) {
+                    // libwayland hands the demarshalled arguments to the dispatcher, the handlers
+                    // are called directly instead of building a libffi call for every request
+                    printf("\n");
+                    printf("    int %s::dispatch_func(const void *implementation, void *target, uint32_t opcode, const struct ::wl_message *message, union ::wl_argument *arguments)\n", interfaceName);
+                    printf("    {\n");
+                    printf("        Q_UNUSED(implementation);\n");
+                    printf("        Q_UNUSED(message);\n");
+                    printf("        Q_UNUSED(arguments);\n");
+                    printf("        // the target of a request is the wl_object at the start of the wl_resource\n");
+                    printf("        struct ::wl_resource *resource = reinterpret_cast<struct ::wl_resource *>(target);\n");
+                    printf("        struct ::wl_client *client = wl_resource_get_client(resource);\n");
+                    printf("        switch (opcode) {\n");
+                    int opcode = 0;
+                    for (const WaylandEvent &e : interface.requests) {
+                        printf("        case %d:\n", opcode++);
+                        printf("            handle_%s(\n", e.name.constData());
+                        printf("                client,\n");
+                        printf("                resource");
+                        int index = 0;
+                        for (const WaylandArgument &a : e.arguments) {
+                            printf(",\n");
+                            if (a.type == "int")
+                                printf("                arguments[%d].i", index);
+                            else if (a.type == "uint")
+                                printf("                arguments[%d].u", index);
+                            else if (a.type == "fixed")
+                                printf("                arguments[%d].f", index);
+                            else if (a.type == "string")
+                                printf("                arguments[%d].s", index);
+                            else if (a.type == "object")
+                                printf("                reinterpret_cast<struct ::wl_resource *>(arguments[%d].o)", index);
+                            else if (a.type == "new_id")
+                                printf("                arguments[%d].n", index);
+                            else if (a.type == "array")
+                                printf("                arguments[%d].a", index);
+                            else if (a.type == "fd")
+                                printf("                arguments[%d].h", index);
+                            ++index;
+                        }
+                        printf(");\n");
+                        printf("            return 0;\n");
+                    }
+                    printf("        default:\n");
+                    printf("            return -1;\n");
+                    printf("        }\n");
+                    printf("    }\n");
+                }
             }
 
             for (const WaylandEvent &e : interface.events) {
@@ -996,6 +1243,58 @@ bool Scanner::process()
                 printf(");\n");
                 printf("    }\n");
                 printf("\n");
+
+                if (hasUtf8Overload(e)) {
+                    printf("    void %s::send_", interfaceName);
+                    printEvent(e, false, false, true);
+                    printf("\n");
+                    printf("    {\n");
+                    printf("        Q_ASSERT_X(m_resource, \"%s::%s\", \"Uninitialised resource\");\n", interfaceName, e.name.constData());
+                    printf("        if (Q_UNLIKELY(!m_resource)) {\n");
+                    printf("            qWarning(\"could not call %s::%s as it's not initialised\");\n", interfaceName, e.name.constData());
+                    printf("            return;\n");
+                    printf("        }\n");
+                    printf("        send_%s(\n", e.name.constData());
+                    printf("            m_resource->handle");
+                    for (const WaylandArgument &a : e.arguments) {
+                        printf(",\n");
+                        printf("            %s", a.name.constData());
+                    }
+                    printf(");\n");
+                    printf("    }\n");
+                    printf("\n");
+
+                    printf("    void %s::send_", interfaceName);
+                    printEvent(e, false, true, true);
+                    printf("\n");
+                    printf("    {\n");
+
+                    for (const WaylandArgument &a : e.arguments) {
+                        if (a.type != "array")
+                            continue;
+                        QByteArray array = a.name + "_data";
+                        const char *arrayName = array.constData();
+                        const char *variableName = a.name.constData();
+                        printf("        struct wl_array %s;\n", arrayName);
+                        printf("        %s.size = %s.size();\n", arrayName, variableName);
+                        printf("        %s.data = static_cast<void *>(const_cast<char *>(%s.constData()));\n", arrayName, variableName);
+                        printf("        %s.alloc = 0;\n", arrayName);
+                        printf("\n");
+                    }
+
+                    printf("        %s_send_%s(\n", interfaceName, e.name.constData());
+                    printf("            resource");
+                    for (const WaylandArgument &a : e.arguments) {
+                        printf(",\n");
+                        if (a.type == "array")
+                            printf("            &%s_data", a.name.constData());
+                        else
+                            printf("            %s", a.name.constData());
+                    }
+                    printf(");\n");
+                    printf("    }\n");
+                    printf("\n");
+                }
             }
         }
         printf("}\n");
@@ -0,0 +1,707 @@
+// SPDX-FileCopyrightText: 2018 - 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+
+/*
+ * Records the global input of a running compositor through the dde_seat interface and
+ * replays recordings into an in-process Display to measure the latency from
+ * SeatInterface::notify* to the reception of the event by a client.
+ *
+ *   inputReplay record session.dwir --duration 30
+ *   inputReplay replay session.dwir [--fast]
+ */
+
+#include "../src/client/connection_thread.h"
+#include "../src/client/ddekeyboard.h"
+#include "../src/client/ddeseat.h"
+#include "../src/client/event_queue.h"
+#include "../src/client/registry.h"
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QTimer>
+// Wayland
+#include <wayland-client.h>
+// system
+#include <sys/socket.h>
+#include <unistd.h>
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace KWaylandServer;
+
+static const quint32 s_magic = 0x52495744; // "DWIR"
+static const quint32 s_formatVersion = 1;
+// how far ahead of the last match a received event is searched among the sent ones
+static const int s_matchWindow = 256;
+
+struct InputEvent {
+    enum class Type : quint8 {
+        PointerMotion,
+        PointerButton,
+        PointerAxis,
+        KeyboardKey,
+        TouchDown,
+        TouchMotion,
+        TouchUp,
+        TouchFrame,
+    };
+    // milliseconds since the start of the recording
+    quint32 time = 0;
+    Type type = Type::PointerMotion;
+    // the button, key, axis or touch point
+    quint32 code = 0;
+    // whether a button or key got pressed
+    bool pressed = false;
+    QPointF position;
+    qreal delta = 0;
+};
+
+static QDataStream &operator<<(QDataStream &stream, const InputEvent &event)
+{
+    return stream << event.time << quint8(event.type) << event.code << event.pressed << event.position << event.delta;
+}
+
+static QDataStream &operator>>(QDataStream &stream, InputEvent &event)
+{
+    quint8 type;
+    stream >> event.time >> type >> event.code >> event.pressed >> event.position >> event.delta;
+    event.type = InputEvent::Type(type);
+    return stream;
+}
+
+static bool writeRecording(const QString &fileName, const QVector<InputEvent> &events)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        fprintf(stderr, "Failed to open %s: %s\n", qPrintable(fileName), qPrintable(file.errorString()));
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << s_magic << s_formatVersion << events;
+    return stream.status() == QDataStream::Ok;
+}
+
+static bool readRecording(const QString &fileName, QVector<InputEvent> &events)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Failed to open %s: %s\n", qPrintable(fileName), qPrintable(file.errorString()));
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if (magic != s_magic || version != s_formatVersion) {
+        fprintf(stderr, "%s is not an input recording\n", qPrintable(fileName));
+        return false;
+    }
+    stream >> events;
+    return stream.status() == QDataStream::Ok;
+}
+
+/**
+ * Records the global input which the compositor mirrors to dde_seat clients.
+ */
+class Recorder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Recorder(QObject *parent = nullptr);
+
+    bool start();
+    QVector<InputEvent> events() const
+    {
+        return m_events;
+    }
+
+private:
+    void setupSeat(quint32 name, quint32 version);
+    void record(InputEvent event);
+
+    KWayland::Client::ConnectionThread m_connection;
+    KWayland::Client::EventQueue m_queue;
+    KWayland::Client::Registry m_registry;
+    QElapsedTimer m_clock;
+    QVector<InputEvent> m_events;
+};
+
+Recorder::Recorder(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool Recorder::start()
+{
+    QEventLoop loop;
+    bool connected = false;
+    connect(&m_connection, &KWayland::Client::ConnectionThread::connected, &loop, [&connected, &loop]() {
+        connected = true;
+        loop.quit();
+    });
+    connect(&m_connection, &KWayland::Client::ConnectionThread::failed, &loop, &QEventLoop::quit);
+    m_connection.initConnection();
+    loop.exec();
+    if (!connected) {
+        fprintf(stderr, "Failed to connect to the compositor\n");
+        return false;
+    }
+
+    m_queue.setup(&m_connection);
+    m_registry.setEventQueue(&m_queue);
+    connect(&m_registry, &KWayland::Client::Registry::ddeSeatAnnounced, this, &Recorder::setupSeat);
+    m_registry.create(&m_connection);
+    m_registry.setup();
+    m_clock.start();
+    return true;
+}
+
+void Recorder::setupSeat(quint32 name, quint32 version)
+{
+    using namespace KWayland::Client;
+    DDESeat *seat = m_registry.createDDESeat(name, version, this);
+
+    DDEPointer *pointer = seat->createDDePointer(this);
+    connect(pointer, &DDEPointer::motion, this, [this](const QPointF &globalPos) {
+        InputEvent event;
+        event.type = InputEvent::Type::PointerMotion;
+        event.position = globalPos;
+        record(event);
+    });
+    connect(pointer, &DDEPointer::buttonStateChanged, this, [this](const QPointF &globalPos, quint32 button, DDEPointer::ButtonState state) {
+        InputEvent event;
+        event.type = InputEvent::Type::PointerButton;
+        event.code = button;
+        event.pressed = state == DDEPointer::ButtonState::Pressed;
+        event.position = globalPos;
+        record(event);
+    });
+    connect(pointer, &DDEPointer::axisChanged, this, [this](quint32 time, DDEPointer::Axis axis, qreal delta) {
+        Q_UNUSED(time)
+        InputEvent event;
+        event.type = InputEvent::Type::PointerAxis;
+        event.code = axis == DDEPointer::Axis::Vertical ? Qt::Vertical : Qt::Horizontal;
+        event.delta = delta;
+        record(event);
+    });
+
+    DDEKeyboard *keyboard = seat->createDDEKeyboard(this);
+    connect(keyboard, &DDEKeyboard::keyChanged, this, [this](quint32 key, DDEKeyboard::KeyState state, quint32 time) {
+        Q_UNUSED(time)
+        InputEvent event;
+        event.type = InputEvent::Type::KeyboardKey;
+        event.code = key;
+        event.pressed = state == DDEKeyboard::KeyState::Pressed;
+        record(event);
+    });
+
+    DDETouch *touch = seat->createDDETouch(this);
+    connect(touch, &DDETouch::touchDown, this, [this](int32_t id, const QPointF &pos) {
+        InputEvent event;
+        event.type = InputEvent::Type::TouchDown;
+        event.code = id;
+        event.position = pos;
+        record(event);
+    });
+    connect(touch, &DDETouch::touchMotion, this, [this](int32_t id, const QPointF &pos) {
+        InputEvent event;
+        event.type = InputEvent::Type::TouchMotion;
+        event.code = id;
+        event.position = pos;
+        record(event);
+    });
+    connect(touch, &DDETouch::touchUp, this, [this](int32_t id) {
+        InputEvent event;
+        event.type = InputEvent::Type::TouchUp;
+        event.code = id;
+        record(event);
+    });
+}
+
+void Recorder::record(InputEvent event)
+{
+    event.time = m_clock.elapsed();
+    m_events.append(event);
+    if (event.type == InputEvent::Type::TouchDown || event.type == InputEvent::Type::TouchMotion || event.type == InputEvent::Type::TouchUp) {
+        // dde_touch has no frame event, every contact change ends a frame
+        event.type = InputEvent::Type::TouchFrame;
+        event.code = 0;
+        event.position = QPointF();
+        m_events.append(event);
+    }
+}
+
+/**
+ * A sent or received event, reduced to what both ends can compare.
+ */
+struct Sample {
+    InputEvent::Type type;
+    quint32 code;
+    wl_fixed_t x;
+    wl_fixed_t y;
+    qint64 nsecs;
+
+    bool matches(const Sample &other) const
+    {
+        return type == other.type && code == other.code && x == other.x && y == other.y;
+    }
+};
+
+static qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * A libwayland client running in its own thread, it records when the input events arrive.
+ */
+class LatencyClient
+{
+public:
+    explicit LatencyClient(int fd);
+    ~LatencyClient();
+
+    bool isReady() const
+    {
+        return m_ready;
+    }
+    // only valid after the thread finished
+    const std::vector<Sample> &samples() const
+    {
+        return m_samples;
+    }
+    void join();
+
+private:
+    void run();
+    void record(InputEvent::Type type, quint32 code, wl_fixed_t x, wl_fixed_t y)
+    {
+        m_samples.push_back(Sample{type, code, x, y, now()});
+    }
+
+    static void handleGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void handleGlobalRemove(void *data, wl_registry *registry, uint32_t name);
+
+    static void handlePointerEnter(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface, wl_fixed_t x, wl_fixed_t y);
+    static void handlePointerLeave(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface);
+    static void handlePointerMotion(void *data, wl_pointer *pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y);
+    static void handlePointerButton(void *data, wl_pointer *pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
+    static void handlePointerAxis(void *data, wl_pointer *pointer, uint32_t time, uint32_t axis, wl_fixed_t value);
+
+    static void handleKeymap(void *data, wl_keyboard *keyboard, uint32_t format, int32_t fd, uint32_t size);
+    static void handleKeyboardEnter(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface, wl_array *keys);
+    static void handleKeyboardLeave(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface);
+    static void handleKey(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state);
+    static void handleModifiers(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group);
+
+    static void handleTouchDown(void *data, wl_touch *touch, uint32_t serial, uint32_t time, wl_surface *surface, int32_t id, wl_fixed_t x, wl_fixed_t y);
+    static void handleTouchUp(void *data, wl_touch *touch, uint32_t serial, uint32_t time, int32_t id);
+    static void handleTouchMotion(void *data, wl_touch *touch, uint32_t time, int32_t id, wl_fixed_t x, wl_fixed_t y);
+    static void handleTouchFrame(void *data, wl_touch *touch);
+    static void handleTouchCancel(void *data, wl_touch *touch);
+
+    wl_display *m_display;
+    wl_compositor *m_compositor = nullptr;
+    wl_seat *m_seat = nullptr;
+    std::atomic<bool> m_ready{false};
+    std::vector<Sample> m_samples;
+    std::thread m_thread;
+};
+
+LatencyClient::LatencyClient(int fd)
+    : m_display(wl_display_connect_to_fd(fd))
+{
+    m_samples.reserve(1 << 16);
+    m_thread = std::thread([this]() {
+        run();
+    });
+}
+
+LatencyClient::~LatencyClient()
+{
+    join();
+    if (m_display) {
+        wl_display_disconnect(m_display);
+    }
+}
+
+void LatencyClient::join()
+{
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void LatencyClient::handleGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    auto client = static_cast<LatencyClient *>(data);
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        client->m_compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, std::min(version, 4u)));
+    } else if (strcmp(interface, wl_seat_interface.name) == 0) {
+        // version 3 has neither pointer frames nor key repeat info, the listeners below cover every event
+        client->m_seat = static_cast<wl_seat *>(wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, 3u)));
+    }
+}
+
+void LatencyClient::handleGlobalRemove(void *, wl_registry *, uint32_t)
+{
+}
+
+void LatencyClient::handlePointerEnter(void *, wl_pointer *, uint32_t, wl_surface *, wl_fixed_t, wl_fixed_t)
+{
+}
+
+void LatencyClient::handlePointerLeave(void *, wl_pointer *, uint32_t, wl_surface *)
+{
+}
+
+void LatencyClient::handlePointerMotion(void *data, wl_pointer *, uint32_t, wl_fixed_t x, wl_fixed_t y)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::PointerMotion, 0, x, y);
+}
+
+void LatencyClient::handlePointerButton(void *data, wl_pointer *, uint32_t, uint32_t, uint32_t button, uint32_t state)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::PointerButton, button, state == WL_POINTER_BUTTON_STATE_PRESSED, 0);
+}
+
+void LatencyClient::handlePointerAxis(void *data, wl_pointer *, uint32_t, uint32_t axis, wl_fixed_t value)
+{
+    const quint32 orientation = axis == WL_POINTER_AXIS_VERTICAL_SCROLL ? Qt::Vertical : Qt::Horizontal;
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::PointerAxis, orientation, value, 0);
+}
+
+void LatencyClient::handleKeymap(void *, wl_keyboard *, uint32_t, int32_t fd, uint32_t)
+{
+    close(fd);
+}
+
+void LatencyClient::handleKeyboardEnter(void *, wl_keyboard *, uint32_t, wl_surface *, wl_array *)
+{
+}
+
+void LatencyClient::handleKeyboardLeave(void *, wl_keyboard *, uint32_t, wl_surface *)
+{
+}
+
+void LatencyClient::handleKey(void *data, wl_keyboard *, uint32_t, uint32_t, uint32_t key, uint32_t state)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::KeyboardKey, key, state == WL_KEYBOARD_KEY_STATE_PRESSED, 0);
+}
+
+void LatencyClient::handleModifiers(void *, wl_keyboard *, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
+{
+}
+
+void LatencyClient::handleTouchDown(void *data, wl_touch *, uint32_t, uint32_t, wl_surface *, int32_t id, wl_fixed_t x, wl_fixed_t y)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::TouchDown, id, x, y);
+}
+
+void LatencyClient::handleTouchUp(void *data, wl_touch *, uint32_t, uint32_t, int32_t id)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::TouchUp, id, 0, 0);
+}
+
+void LatencyClient::handleTouchMotion(void *data, wl_touch *, uint32_t, int32_t id, wl_fixed_t x, wl_fixed_t y)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::TouchMotion, id, x, y);
+}
+
+void LatencyClient::handleTouchFrame(void *data, wl_touch *)
+{
+    static_cast<LatencyClient *>(data)->record(InputEvent::Type::TouchFrame, 0, 0, 0);
+}
+
+void LatencyClient::handleTouchCancel(void *, wl_touch *)
+{
+}
+
+void LatencyClient::run()
+{
+    static const wl_registry_listener registryListener = {
+        handleGlobal,
+        handleGlobalRemove,
+    };
+    static const wl_pointer_listener pointerListener = {
+        handlePointerEnter,
+        handlePointerLeave,
+        handlePointerMotion,
+        handlePointerButton,
+        handlePointerAxis,
+    };
+    static const wl_keyboard_listener keyboardListener = {
+        handleKeymap,
+        handleKeyboardEnter,
+        handleKeyboardLeave,
+        handleKey,
+        handleModifiers,
+    };
+    static const wl_touch_listener touchListener = {
+        handleTouchDown,
+        handleTouchUp,
+        handleTouchMotion,
+        handleTouchFrame,
+        handleTouchCancel,
+    };
+
+    if (!m_display) {
+        return;
+    }
+    wl_registry *registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(registry, &registryListener, this);
+    wl_display_roundtrip(m_display);
+    if (!m_compositor || !m_seat) {
+        fprintf(stderr, "The server lacks the compositor or the seat\n");
+        return;
+    }
+
+    wl_surface *surface = wl_compositor_create_surface(m_compositor);
+    wl_pointer_add_listener(wl_seat_get_pointer(m_seat), &pointerListener, this);
+    wl_keyboard_add_listener(wl_seat_get_keyboard(m_seat), &keyboardListener, this);
+    wl_touch_add_listener(wl_seat_get_touch(m_seat), &touchListener, this);
+    wl_display_roundtrip(m_display);
+    m_ready = true;
+
+    // ends when the server disconnects the client
+    while (wl_display_dispatch(m_display) != -1) {
+    }
+    Q_UNUSED(surface)
+}
+
+static void printStatistics(const char *name, std::vector<qint64> latencies)
+{
+    if (latencies.empty()) {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[std::min<size_t>(latencies.size() - 1, latencies.size() * p)] / 1000.0;
+    };
+    printf("%-16s %8zu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+           name,
+           latencies.size(),
+           latencies.front() / 1000.0,
+           percentile(0.5),
+           percentile(0.95),
+           percentile(0.99),
+           latencies.back() / 1000.0);
+}
+
+static int replay(const QVector<InputEvent> &events, bool fast)
+{
+    Display display;
+    display.start();
+    CompositorInterface compositor(&display);
+    SeatInterface seat(&display);
+    seat.setHasPointer(true);
+    seat.setHasKeyboard(true);
+    seat.setHasTouch(true);
+
+    SurfaceInterface *surface = nullptr;
+    QObject::connect(&compositor, &CompositorInterface::surfaceCreated, [&surface](SurfaceInterface *created) {
+        surface = created;
+    });
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    ClientConnection *connection = display.createClient(fds[0]);
+    LatencyClient client(fds[1]);
+
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&client, &loop]() {
+        if (client.isReady()) {
+            loop.quit();
+        }
+    });
+    poll.start(1);
+    loop.exec();
+    poll.stop();
+    if (!surface) {
+        fprintf(stderr, "The client failed to set up\n");
+        return 1;
+    }
+
+    // the surface sits at the origin, the local positions match the global ones
+    seat.setFocusedPointerSurface(surface, QPointF());
+    seat.setFocusedKeyboardSurface(surface);
+    seat.setFocusedTouchSurface(surface, QPointF());
+    display.flush();
+
+    std::vector<Sample> sent;
+    sent.reserve(events.size());
+    const auto send = [&](const InputEvent &event) {
+        const wl_fixed_t x = wl_fixed_from_double(event.position.x());
+        const wl_fixed_t y = wl_fixed_from_double(event.position.y());
+        seat.setTimestamp(event.time);
+        switch (event.type) {
+        case InputEvent::Type::PointerMotion:
+            sent.push_back(Sample{event.type, 0, x, y, now()});
+            seat.notifyPointerMotion(event.position);
+            seat.notifyPointerFrame();
+            break;
+        case InputEvent::Type::PointerButton:
+            sent.push_back(Sample{event.type, event.code, event.pressed, 0, now()});
+            seat.notifyPointerButton(event.code, event.pressed ? PointerButtonState::Pressed : PointerButtonState::Released);
+            seat.notifyPointerFrame();
+            break;
+        case InputEvent::Type::PointerAxis:
+            sent.push_back(Sample{event.type, event.code, wl_fixed_from_double(event.delta), 0, now()});
+            seat.notifyPointerAxis(Qt::Orientation(event.code), event.delta, 0, PointerAxisSource::Wheel);
+            seat.notifyPointerFrame();
+            break;
+        case InputEvent::Type::KeyboardKey:
+            sent.push_back(Sample{event.type, event.code, event.pressed, 0, now()});
+            seat.notifyKeyboardKey(event.code, event.pressed ? KeyboardKeyState::Pressed : KeyboardKeyState::Released);
+            break;
+        case InputEvent::Type::TouchDown:
+            sent.push_back(Sample{event.type, event.code, x, y, now()});
+            seat.notifyTouchDown(event.code, event.position);
+            break;
+        case InputEvent::Type::TouchMotion:
+            sent.push_back(Sample{event.type, event.code, x, y, now()});
+            seat.notifyTouchMotion(event.code, event.position);
+            break;
+        case InputEvent::Type::TouchUp:
+            sent.push_back(Sample{event.type, event.code, 0, 0, now()});
+            seat.notifyTouchUp(event.code);
+            break;
+        case InputEvent::Type::TouchFrame:
+            sent.push_back(Sample{event.type, 0, 0, 0, now()});
+            seat.notifyTouchFrame();
+            break;
+        }
+        display.flush();
+    };
+
+    QElapsedTimer clock;
+    clock.start();
+    int next = 0;
+    QTimer timer;
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, &loop, [&]() {
+        // everything that is due goes out, the timer might fire late
+        while (next < events.size() && (fast || events[next].time <= clock.elapsed())) {
+            send(events[next++]);
+            if (fast && next % 64 == 0) {
+                // let the server dispatch the client in between
+                break;
+            }
+        }
+        if (next < events.size()) {
+            timer.start(fast ? 0 : std::max<qint64>(0, events[next].time - clock.elapsed()));
+        } else {
+            // the last events need a moment to arrive
+            QTimer::singleShot(100, &loop, &QEventLoop::quit);
+        }
+    });
+    timer.start(0);
+    loop.exec();
+
+    connection->destroy();
+    display.flush();
+    client.join();
+
+    // the received events are matched in order with the sent ones
+    std::vector<qint64> latencies[8];
+    const std::vector<Sample> &received = client.samples();
+    size_t cursor = 0;
+    size_t unmatched = 0;
+    for (const Sample &sample : received) {
+        const size_t end = std::min(sent.size(), cursor + s_matchWindow);
+        size_t i = cursor;
+        while (i < end && !sent[i].matches(sample)) {
+            ++i;
+        }
+        if (i == end) {
+            ++unmatched;
+            continue;
+        }
+        latencies[int(sample.type)].push_back(sample.nsecs - sent[i].nsecs);
+        cursor = i + 1;
+    }
+
+    printf("%zu events sent, %zu received, %zu not matched\n", sent.size(), received.size(), unmatched);
+    printf("%-16s %8s %10s %10s %10s %10s %10s\n", "latency (us)", "count", "min", "median", "p95", "p99", "max");
+    static const char *const names[] = {
+        "pointer motion",
+        "pointer button",
+        "pointer axis",
+        "keyboard key",
+        "touch down",
+        "touch motion",
+        "touch up",
+        "touch frame",
+    };
+    for (int type = 0; type < 8; ++type) {
+        printStatistics(names[type], latencies[type]);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Records the global input of the compositor and replays it to measure the input latency"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("mode"), QStringLiteral("record or replay"));
+    parser.addPositionalArgument(QStringLiteral("file"), QStringLiteral("The recording"));
+    QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Seconds to record"), QStringLiteral("seconds"), QStringLiteral("10"));
+    parser.addOption(durationOption);
+    QCommandLineOption fastOption(QStringLiteral("fast"), QStringLiteral("Replay as fast as possible instead of with the recorded timing"));
+    parser.addOption(fastOption);
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.count() != 2) {
+        parser.showHelp(1);
+    }
+    const QString mode = arguments.at(0);
+    const QString fileName = arguments.at(1);
+
+    if (mode == QLatin1String("record")) {
+        Recorder recorder;
+        if (!recorder.start()) {
+            return 1;
+        }
+        QTimer::singleShot(parser.value(durationOption).toInt() * 1000, &app, &QCoreApplication::quit);
+        app.exec();
+        const QVector<InputEvent> events = recorder.events();
+        printf("%d events recorded\n", events.count());
+        return writeRecording(fileName, events) ? 0 : 1;
+    }
+    if (mode == QLatin1String("replay")) {
+        QVector<InputEvent> events;
+        if (!readRecording(fileName, events)) {
+            return 1;
+        }
+        return replay(events, parser.isSet(fastOption));
+    }
+    parser.showHelp(1);
+}
+
+#include "inputreplay.moc"